@@ -0,0 +1,47 @@
+#ifndef EDGE_APP_STARTUP_H
+#define EDGE_APP_STARTUP_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+// Process start-up moved off the main thread: nativeInit, called from a
+// background thread in Application.onCreate right after that thread's
+// System.loadLibrary, runs OpenCV's lazy one-off setup (the optimized code
+// paths, a loop across every pool worker, the first calls of the kernels a
+// frame uses) and then the pipeline's own step. The camera path awaits the
+// result like a future before its first frames flow, so they never pay for
+// any of it; a process that never calls nativeInit has nothing to wait for.
+class AppStartup {
+public:
+    // Runs the start-up on the calling thread once per process, the pipeline
+    // step last; a call while one runs waits for it. Returns the milliseconds
+    // the run took.
+    double run(const std::function<void()>& pipelineStep);
+
+    // Waits up to timeoutMs for a run in progress; true once ready or when
+    // no run was started
+    bool await(int64_t timeoutMs);
+
+    bool ready() const { return state.load(std::memory_order_acquire) == READY; }
+    double runMillis() const { return millis.load(std::memory_order_relaxed); }
+    // Time callers spent in await, and how many gave up at their timeout
+    int64_t awaitedMicros() const { return waited.load(std::memory_order_relaxed); }
+    uint64_t timeoutCount() const { return timeouts.load(std::memory_order_relaxed); }
+
+private:
+    enum State { IDLE, RUNNING, READY };
+
+    std::mutex mutex;
+    std::condition_variable finished;
+    std::atomic<int> state{IDLE};
+    std::atomic<double> millis{0.0};
+    std::atomic<int64_t> waited{0};
+    std::atomic<uint64_t> timeouts{0};
+};
+
+AppStartup& appStartup();
+
+#endif // EDGE_APP_STARTUP_H
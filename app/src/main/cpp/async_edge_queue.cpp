@@ -0,0 +1,153 @@
+#include "async_edge_queue.h"
+
+#define LOG_TAG "AsyncEdgeQueue"
+#include "logging.h"
+
+AsyncEdgeQueue::~AsyncEdgeQueue() {
+    stop();
+}
+
+void AsyncEdgeQueue::start(const BatchParams& batchParams, Callbacks queueCallbacks) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (running) {
+        return;
+    }
+    params = batchParams;
+    callbacks = std::move(queueCallbacks);
+    stopping = false;
+    running = true;
+    thread = std::thread(&AsyncEdgeQueue::run, this);
+    LOGI("✅ Async edge queue started (1/%d scale, Canny %d/%d)", params.downscale, params.lowThreshold,
+         params.highThreshold);
+}
+
+void AsyncEdgeQueue::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running || stopping) {
+            return;
+        }
+        stopping = true;
+    }
+    wakeup.notify_one();
+    thread.join();
+    std::lock_guard<std::mutex> lock(mutex);
+    running = false;
+    spare.clear();
+    LOGI("✅ Async edge queue stopped");
+}
+
+bool AsyncEdgeQueue::isRunning() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return running && !stopping;
+}
+
+uint64_t AsyncEdgeQueue::submit(const uint8_t* y, int yRowStride, int width, int height, int64_t timestampNs,
+                                uint8_t* output, size_t outputCapacity, void* tag) {
+    AsyncEdgeRequest request;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running || stopping) {
+            return 0;
+        }
+        // A spare of the right size, if a previous request left one
+        for (size_t i = 0; i < spare.size(); i++) {
+            if (spare[i].cols == width && spare[i].rows == height) {
+                request.luma = spare[i];
+                spare.erase(spare.begin() + static_cast<long>(i));
+                break;
+            }
+        }
+        request.id = nextId++;
+    }
+    const uint64_t id = request.id;
+    // The copy runs outside the lock, so the queue thread is never held up by it
+    const cv::Mat plane(height, width, CV_8UC1, const_cast<uint8_t*>(y), static_cast<size_t>(yRowStride));
+    plane.copyTo(request.luma);
+    request.timestampNs = timestampNs;
+    request.output = output;
+    request.outputCapacity = outputCapacity;
+    request.tag = tag;
+    if (!queue.tryPush(request)) {
+        // kMaxQueued requests already waiting; the copy goes back to the spares
+        std::lock_guard<std::mutex> lock(mutex);
+        if (spare.size() < kMaxQueued) {
+            spare.push_back(request.luma);
+        }
+        return 0;
+    }
+    {
+        // The consumer is either before its empty() check or asleep, never
+        // between the two, so this notify cannot be lost
+        std::lock_guard<std::mutex> lock(mutex);
+    }
+    wakeup.notify_one();
+    return id;
+}
+
+AsyncEdgeResult AsyncEdgeQueue::process(AsyncEdgeRequest& request) {
+    AsyncEdgeResult result;
+    result.id = request.id;
+    result.timestampNs = request.timestampNs;
+    result.tag = request.tag;
+    BatchParams frameParams = params;
+    frameParams.width = request.luma.cols;
+    frameParams.height = request.luma.rows;
+    const size_t bytes = batchOutputFrameBytes(frameParams);
+    if (bytes == 0 || bytes > request.outputCapacity) {
+        LOGE_RATELIMITED("❌ Request %llu: output holds %zu bytes, the edge map needs %zu",
+                         static_cast<unsigned long long>(request.id), request.outputCapacity, bytes);
+        return result;
+    }
+    const int64_t offset = 0;
+    if (processEdgeBatch(request.luma.data, &offset, 1, frameParams, request.output) == 1) {
+        result.ok = true;
+        batchOutputSize(frameParams, result.width, result.height);
+    }
+    return result;
+}
+
+void AsyncEdgeQueue::run() {
+    if (callbacks.threadStart) {
+        callbacks.threadStart();
+    }
+    for (;;) {
+        AsyncEdgeRequest request;
+        bool cancelled;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeup.wait(lock, [this] { return !queue.empty() || stopping; });
+            if (!queue.tryPop(request)) {
+                break;  // stopping with nothing left to answer
+            }
+            cancelled = stopping;
+        }
+
+        AsyncEdgeResult result;
+        if (cancelled) {
+            result.id = request.id;
+            result.timestampNs = request.timestampNs;
+            result.tag = request.tag;
+        } else {
+            result = process(request);
+        }
+        try {
+            callbacks.complete(result);
+        } catch (const std::exception& e) {
+            LOGE_RATELIMITED("❌ Completion callback threw: %s", e.what());
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (spare.size() < kMaxQueued) {
+            spare.push_back(request.luma);
+        }
+    }
+    if (callbacks.threadExit) {
+        callbacks.threadExit();
+    }
+}
+
+AsyncEdgeQueue& asyncEdgeQueue() {
+    static AsyncEdgeQueue instance;
+    return instance;
+}
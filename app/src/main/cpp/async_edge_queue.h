@@ -0,0 +1,82 @@
+#ifndef EDGE_ASYNC_EDGE_QUEUE_H
+#define EDGE_ASYNC_EDGE_QUEUE_H
+
+#include "batch_processor.h"
+#include "mpsc_queue.h"
+#include <opencv2/core.hpp>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// One submitted frame after submit() returned: the luma is already copied, so
+// the caller's image can go back to its producer immediately
+struct AsyncEdgeRequest {
+    uint64_t id = 0;
+    cv::Mat luma;               // owned compact copy of the Y plane
+    int64_t timestampNs = 0;
+    uint8_t* output = nullptr;  // caller's memory for the edge map
+    size_t outputCapacity = 0;
+    void* tag = nullptr;        // opaque to the queue (the JNI side keeps the buffer's global ref here)
+};
+
+struct AsyncEdgeResult {
+    uint64_t id = 0;
+    bool ok = false;            // false: output too small, processing failed or the queue stopped
+    int width = 0;              // of the edge map written to output
+    int height = 0;
+    int64_t timestampNs = 0;
+    void* tag = nullptr;
+};
+
+// Edge detection requests completed out of band: submit() copies the frame
+// and returns an id without waiting, a dedicated thread runs them in FIFO
+// order with the batch kernel (no preview state involved), and every
+// accepted request is answered exactly once through complete(), on that
+// thread, including those still queued at stop(). Requests travel through a
+// lock-free MPSC queue; the mutex only guards start/stop, the spare copies
+// and the consumer's sleep.
+class AsyncEdgeQueue {
+public:
+    struct Callbacks {
+        std::function<void()> threadStart;  // once, on the queue thread (e.g. attach it to the VM)
+        std::function<void(const AsyncEdgeResult&)> complete;
+        std::function<void()> threadExit;   // once, after the last completion
+    };
+
+    static const size_t kMaxQueued = 4;
+
+    ~AsyncEdgeQueue();
+
+    void start(const BatchParams& params, Callbacks callbacks);
+    void stop();
+    bool isRunning();
+
+    // Copies width x height of the Y plane (row stride yRowStride) and queues
+    // it; returns the request id, or 0 when not running or kMaxQueued
+    // requests are already waiting (nothing is retained then)
+    uint64_t submit(const uint8_t* y, int yRowStride, int width, int height, int64_t timestampNs,
+                    uint8_t* output, size_t outputCapacity, void* tag);
+
+private:
+    void run();
+    AsyncEdgeResult process(AsyncEdgeRequest& request);
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    MpscQueue<AsyncEdgeRequest, kMaxQueued> queue;
+    std::vector<cv::Mat> spare;  // luma copies of completed requests, reused by submit
+    BatchParams params;
+    Callbacks callbacks;
+    uint64_t nextId = 1;
+    bool running = false;
+    bool stopping = false;
+};
+
+// The queue behind the asynchronous JNI calls
+AsyncEdgeQueue& asyncEdgeQueue();
+
+#endif // EDGE_ASYNC_EDGE_QUEUE_H
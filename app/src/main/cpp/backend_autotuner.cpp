@@ -0,0 +1,178 @@
+#include "backend_autotuner.h"
+#include "synthetic_source.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#ifdef __ANDROID__
+#include <sys/system_properties.h>
+#endif
+
+#define LOG_TAG "BackendAutotuner"
+#include "logging.h"
+
+namespace {
+
+// Runs per candidate even when its share of the budget is spent
+const int kMinRuns = 3;
+// Distinct synthetic frames cycled through, so no run finds the last one's output in cache
+const int kFrames = 2;
+
+// Key fields are separated by '|' and entries by tabs and newlines
+std::string sanitized(const std::string& text) {
+    std::string clean = text.empty() ? "-" : text;
+    std::replace_if(clean.begin(), clean.end(), [](char c) {
+        return c == '|' || c == '\t' || c == '\n' || c == '\r' || c == ' ';
+    }, '_');
+    return clean;
+}
+
+// Third field of a key
+std::string buildOf(const std::string& key) {
+    size_t first = key.find('|');
+    size_t second = first == std::string::npos ? first : key.find('|', first + 1);
+    size_t third = second == std::string::npos ? second : key.find('|', second + 1);
+    if (second == std::string::npos) {
+        return std::string();
+    }
+    return key.substr(second + 1, third == std::string::npos ? std::string::npos : third - second - 1);
+}
+
+#ifdef __ANDROID__
+std::string property(const char* name) {
+    char value[PROP_VALUE_MAX] = {};
+    return __system_property_get(name, value) > 0 ? std::string(value) : std::string();
+}
+#endif
+
+} // namespace
+
+std::string BackendAutotuner::socName() {
+#ifdef __ANDROID__
+    for (const char* name : {"ro.soc.model", "ro.board.platform", "ro.hardware"}) {
+        std::string value = property(name);
+        if (!value.empty()) {
+            return value;
+        }
+    }
+    return "unknown";
+#else
+    return "host";
+#endif
+}
+
+std::string BackendAutotuner::key(const cv::Size& size, const std::string& build, const std::string& variant) {
+    return sanitized(socName()) + "|" + std::to_string(size.width) + "x" + std::to_string(size.height) + "|" +
+           sanitized(build) + "|" + sanitized(variant);
+}
+
+void BackendAutotuner::loadLocked(const std::string& path) {
+    if (loadedPath == path) {
+        return;
+    }
+    loadedPath = path;
+    entries.clear();
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        Entry entry;
+        if (std::getline(fields, entry.key, '\t') && std::getline(fields, entry.winner, '\t') &&
+            (fields >> entry.micros) && !entry.key.empty() && !entry.winner.empty()) {
+            entries.push_back(entry);
+        }
+    }
+    LOGI("Loaded %zu tuned backends from %s", entries.size(), path.c_str());
+}
+
+bool BackendAutotuner::saveLocked(const std::string& path, const std::string& build) {
+    // Entries of other builds would only be tuned again; drop them
+    entries.erase(std::remove_if(entries.begin(), entries.end(), [&](const Entry& entry) {
+        return buildOf(entry.key) != build;
+    }), entries.end());
+    const std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::trunc);
+        for (const Entry& entry : entries) {
+            file << entry.key << '\t' << entry.winner << '\t' << entry.micros << '\n';
+        }
+        if (!file.good()) {
+            return false;
+        }
+    }
+    // A crash mid-write leaves the previous file intact
+    return std::rename(temporary.c_str(), path.c_str()) == 0;
+}
+
+BackendAutotuner::Result BackendAutotuner::resolve(const std::string& path, const std::string& key,
+                                                   const std::vector<TuneCandidate>& candidates,
+                                                   const cv::Size& size, int budgetMs) {
+    std::lock_guard<std::mutex> lock(mutex);
+    loadLocked(path);
+    Result result;
+    for (const Entry& entry : entries) {
+        const bool known = std::any_of(candidates.begin(), candidates.end(), [&](const TuneCandidate& candidate) {
+            return candidate.name == entry.winner;
+        });
+        if (entry.key == key && known) {
+            result.winner = entry.winner;
+            result.fromCache = true;
+            return result;
+        }
+    }
+    if (candidates.empty()) {
+        return result;
+    }
+
+    SyntheticConfig config;
+    config.width = size.width & ~1;
+    config.height = size.height & ~1;
+    cv::Mat frames[kFrames];
+    for (int i = 0; i < kFrames; i++) {
+        SyntheticFrameSource::renderFrame(config, static_cast<uint64_t>(i) * 15, frames[i]);
+    }
+    cv::Mat edges;
+    const auto share = std::chrono::milliseconds(std::max(budgetMs, 1)) / static_cast<int>(candidates.size());
+    std::string report;
+    for (const TuneCandidate& candidate : candidates) {
+        double best = 0.0;
+        try {
+            const auto deadline = std::chrono::steady_clock::now() + share;
+            for (int run = 0; run < kMinRuns || std::chrono::steady_clock::now() < deadline; run++) {
+                const cv::Mat luma = frames[run % kFrames].rowRange(0, config.height);
+                const auto start = std::chrono::steady_clock::now();
+                candidate.run(luma, edges);
+                const double micros = std::chrono::duration<double, std::micro>(
+                        std::chrono::steady_clock::now() - start).count();
+                best = run == 0 ? micros : std::min(best, micros);
+            }
+        } catch (const cv::Exception& e) {
+            LOGW("⚠️ Tuning candidate %s failed: %s", candidate.name.c_str(), e.what());
+            continue;
+        }
+        report += " " + candidate.name + " " + std::to_string(static_cast<long long>(best)) + "us";
+        if (result.winner.empty() || best < result.micros) {
+            result.winner = candidate.name;
+            result.micros = best;
+        }
+    }
+    if (result.winner.empty()) {
+        return result;
+    }
+    LOGI("Tuned %s:%s -> %s", key.c_str(), report.c_str(), result.winner.c_str());
+    entries.erase(std::remove_if(entries.begin(), entries.end(), [&](const Entry& entry) {
+        return entry.key == key;
+    }), entries.end());
+    entries.push_back({key, result.winner, result.micros});
+    if (!saveLocked(path, buildOf(key))) {
+        LOGW("⚠️ Could not store tuned backends in %s", path.c_str());
+    }
+    return result;
+}
+
+BackendAutotuner& backendAutotuner() {
+    static BackendAutotuner tuner;
+    return tuner;
+}
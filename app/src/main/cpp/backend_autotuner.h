@@ -0,0 +1,63 @@
+#ifndef EDGE_BACKEND_AUTOTUNER_H
+#define EDGE_BACKEND_AUTOTUNER_H
+
+#include <opencv2/core.hpp>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// One way of producing the edge map, timed by the autotuner on a luma frame
+struct TuneCandidate {
+    std::string name;   // what the winner is stored as, no whitespace
+    std::function<void(const cv::Mat& gray, cv::Mat& edges)> run;
+};
+
+// Picks the fastest edge implementation for this device once and remembers
+// it. A tuning run times every candidate on synthetic frames
+// (synthetic_source.h) of the preview size for its share of a budget of a
+// few hundred milliseconds, keeping each one's fastest run (which ignores
+// warm-up, like CannyBackend::AUTO). The winner is stored under a key made
+// of the SoC, the frame size, the app build and the caller's variant (for
+// settings that change the work, such as pre-blur) in a small text file in
+// app storage, so later starts load the choice instead of tuning again. A
+// new build misses every key, which retunes it once after an app update;
+// saving drops the entries of other builds.
+class BackendAutotuner {
+public:
+    struct Result {
+        std::string winner;
+        double micros = 0.0;       // the winner's fastest run; 0 when loaded
+        bool fromCache = false;
+    };
+
+    // The SoC name (ro.soc.model, else ro.board.platform, else ro.hardware;
+    // "host" off Android)
+    static std::string socName();
+    static std::string key(const cv::Size& size, const std::string& build, const std::string& variant);
+
+    // The stored winner of key among candidates when path has one, else a
+    // tuning run over budgetMs whose winner is stored in path (a failed
+    // write is logged; the result is still returned). Candidates that throw
+    // are skipped. Empty winner when none could run.
+    Result resolve(const std::string& path, const std::string& key, const std::vector<TuneCandidate>& candidates,
+                   const cv::Size& size, int budgetMs);
+
+private:
+    struct Entry {
+        std::string key;
+        std::string winner;
+        double micros;
+    };
+
+    void loadLocked(const std::string& path);
+    bool saveLocked(const std::string& path, const std::string& build);
+
+    std::mutex mutex;
+    std::string loadedPath;
+    std::vector<Entry> entries;
+};
+
+BackendAutotuner& backendAutotuner();
+
+#endif // EDGE_BACKEND_AUTOTUNER_H
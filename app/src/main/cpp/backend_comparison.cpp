@@ -0,0 +1,153 @@
+#include "backend_comparison.h"
+#include "frame_arena.h"
+#include "image_processor.h"
+#include "ocl_processing.h"
+#include <opencv2/core.hpp>
+#include <algorithm>
+
+#define LOG_TAG "BackendComparison"
+#include "logging.h"
+
+namespace {
+
+const uint64_t kLogEveryFrames = 600;   // a logcat summary about every 20 s at 30 fps
+
+}  // namespace
+
+const char* BackendComparison::backendName(int backend) {
+    switch (backend) {
+        case OPENCV: return "cv::Canny";
+        case KERNEL: return "kernel";
+        case TILED: return "tiled";
+        case GRADIENT: return "gradient";
+        case OPENCL: return "OpenCL";
+        default: return "none";
+    }
+}
+
+bool BackendComparison::start(int a, int b, int sampleEvery) {
+    if (a < OPENCV || a > OPENCL || b < OPENCV || b > OPENCL || a == b) {
+        LOGE("❌ Cannot compare backends %d and %d", a, b);
+        return false;
+    }
+    if ((a == OPENCL || b == OPENCL) && !initOpenCLProcessing()) {
+        LOGE("❌ No OpenCL device to compare against");
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    // A frame already in detect() may still land in the cleared counters;
+    // one frame in hundreds does not move the figures
+    running.store(false, std::memory_order_release);
+    backends[0].store(a, std::memory_order_relaxed);
+    backends[1].store(b, std::memory_order_relaxed);
+    sampleInterval.store(std::max(0, sampleEvery), std::memory_order_relaxed);
+    frameCounter.store(0, std::memory_order_relaxed);
+    for (int side = 0; side < 2; side++) {
+        histograms[side].reset();
+        frames[side].store(0, std::memory_order_relaxed);
+        totalMicros[side].store(0, std::memory_order_relaxed);
+    }
+    samples.store(0, std::memory_order_relaxed);
+    differingPixels.store(0, std::memory_order_relaxed);
+    edgePixels.store(0, std::memory_order_relaxed);
+    running.store(true, std::memory_order_release);
+    LOGI("✅ Comparing %s (A) with %s (B), disagreement every %d frames", backendName(a), backendName(b),
+         sampleEvery);
+    return true;
+}
+
+void BackendComparison::stop() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (active()) {
+        logSummary();
+    }
+    running.store(false, std::memory_order_release);
+}
+
+bool BackendComparison::run(int backend, const cv::Mat& gray, cv::Mat& edges) {
+    if (backend == OPENCL) {
+        edges.create(gray.size(), CV_8UC1);
+        return detectEdgesOcl(gray, edges);
+    }
+    cannyWithBackend(static_cast<CannyBackend>(backend), gray, edges);
+    return true;
+}
+
+bool BackendComparison::detect(const cv::Mat& gray, cv::Mat& edges) {
+    if (!active()) {
+        return false;
+    }
+    const uint64_t frame = frameCounter.fetch_add(1, std::memory_order_relaxed);
+    const int side = static_cast<int>(frame & 1);
+    const int backend = backends[side].load(std::memory_order_relaxed);
+
+    const int64_t start = monotonicMicros();
+    if (!run(backend, gray, edges)) {
+        LOGE_RATELIMITED("❌ %s failed on a %dx%d frame", backendName(backend), gray.cols, gray.rows);
+        return false;
+    }
+    const int64_t micros = monotonicMicros() - start;
+    histograms[side].record(micros);
+    frames[side].fetch_add(1, std::memory_order_relaxed);
+    totalMicros[side].fetch_add(static_cast<uint64_t>(micros), std::memory_order_relaxed);
+
+    const int interval = sampleInterval.load(std::memory_order_relaxed);
+    if (interval > 0 && frame % static_cast<uint64_t>(interval) == 0) {
+        static thread_local cv::Mat other = persistentMat();
+        static thread_local cv::Mat difference = persistentMat();
+        if (run(backends[side ^ 1].load(std::memory_order_relaxed), gray, other)) {
+            cv::bitwise_xor(edges, other, difference);
+            differingPixels.fetch_add(static_cast<uint64_t>(cv::countNonZero(difference)),
+                                      std::memory_order_relaxed);
+            cv::bitwise_or(edges, other, difference);
+            edgePixels.fetch_add(static_cast<uint64_t>(cv::countNonZero(difference)), std::memory_order_relaxed);
+            samples.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    if (frame > 0 && frame % kLogEveryFrames == 0) {
+        logSummary();
+    }
+    return true;
+}
+
+BackendComparison::Stats BackendComparison::stats() const {
+    Stats result;
+    if (!active()) {
+        return result;
+    }
+    result.backendA = backends[0].load(std::memory_order_relaxed);
+    result.backendB = backends[1].load(std::memory_order_relaxed);
+    for (int side = 0; side < 2; side++) {
+        result.frames[side] = frames[side].load(std::memory_order_relaxed);
+        if (result.frames[side] > 0) {
+            result.meanMicros[side] =
+                    static_cast<double>(totalMicros[side].load(std::memory_order_relaxed)) / result.frames[side];
+            result.medianMicros[side] = histograms[side].percentileMicros(0.5);
+        }
+    }
+    if (result.meanMicros[1] > 0.0) {
+        result.speedup = result.meanMicros[0] / result.meanMicros[1];
+    }
+    result.samples = samples.load(std::memory_order_relaxed);
+    const uint64_t union_ = edgePixels.load(std::memory_order_relaxed);
+    if (union_ > 0) {
+        result.disagreement = static_cast<double>(differingPixels.load(std::memory_order_relaxed)) / union_;
+    }
+    return result;
+}
+
+void BackendComparison::logSummary() {
+    const Stats current = stats();
+    if (current.frames[0] == 0 || current.frames[1] == 0) {
+        return;
+    }
+    LOGI("🔄 %s %.0f us vs %s %.0f us (means over %llu / %llu frames): B %.2fx, %.2f%% of edge pixels disagree",
+         backendName(current.backendA), current.meanMicros[0], backendName(current.backendB), current.meanMicros[1],
+         static_cast<unsigned long long>(current.frames[0]), static_cast<unsigned long long>(current.frames[1]),
+         current.speedup, current.disagreement * 100.0);
+}
+
+BackendComparison& backendComparison() {
+    static BackendComparison comparison;
+    return comparison;
+}
@@ -0,0 +1,75 @@
+#ifndef EDGE_BACKEND_COMPARISON_H
+#define EDGE_BACKEND_COMPARISON_H
+
+#include "metrics.h"
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+// Field check of two edge backends on the device at hand: while started,
+// the CPU edge stage alternates frames between backend A and backend B, each
+// frame's edges coming from one of them, and times every run into that
+// backend's own histogram. Both see the same scenes, thermal state and
+// cache pressure, which a benchmark run before or after cannot promise.
+// Every sampleEvery-th frame the other backend also runs on the same luma
+// (untimed) and the two edge maps are compared: the disagreement is the
+// share of edge pixels (in either map) that only one of them found.
+class BackendComparison {
+public:
+    // 1..4 are the CannyBackend values (image_processor.h)
+    enum Backend {
+        OPENCV = 1,     // cv::Canny
+        KERNEL = 2,     // cannyU8
+        TILED = 3,      // cannyU8Tiled
+        GRADIENT = 4,   // thresholded Sobel magnitude (FAST_EDGES)
+        OPENCL = 5,     // Canny on cv::UMat, on the GPU where OpenCL runs there
+    };
+
+    struct Stats {
+        int backendA = 0;           // 0 when stopped
+        int backendB = 0;
+        uint64_t frames[2] = {};
+        double meanMicros[2] = {};
+        double medianMicros[2] = {};  // bucket bound (LatencyHistogram)
+        double speedup = 0.0;       // A's mean over B's: above 1 when B is faster
+        double disagreement = 0.0;  // 0..1 over every sampled frame
+        uint64_t samples = 0;       // frames compared
+    };
+
+    // Starts alternating, discarding any earlier measurement; false for an
+    // unknown backend, a == b, or OPENCL without an OpenCL device
+    bool start(int a, int b, int sampleEvery);
+    void stop();
+    bool active() const { return running.load(std::memory_order_acquire); }
+
+    // Processing thread: edges (gray-sized CV_8UC1) of gray by this frame's
+    // backend, with the current thresholds; false when stopped or the
+    // backend failed, leaving the frame to the usual path
+    bool detect(const cv::Mat& gray, cv::Mat& edges);
+
+    Stats stats() const;
+
+    static const char* backendName(int backend);
+
+private:
+    bool run(int backend, const cv::Mat& gray, cv::Mat& edges);
+    void logSummary();
+
+    std::mutex mutex;   // start / stop
+    std::atomic<bool> running{false};
+    std::atomic<int> backends[2] = {};
+    std::atomic<int> sampleInterval{0};
+    std::atomic<uint64_t> frameCounter{0};
+
+    LatencyHistogram histograms[2];
+    std::atomic<uint64_t> frames[2] = {};
+    std::atomic<uint64_t> totalMicros[2] = {};
+    std::atomic<uint64_t> samples{0};
+    std::atomic<uint64_t> differingPixels{0};
+    std::atomic<uint64_t> edgePixels{0};     // union of both maps
+};
+
+BackendComparison& backendComparison();
+
+#endif // EDGE_BACKEND_COMPARISON_H
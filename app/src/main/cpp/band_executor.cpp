@@ -0,0 +1,176 @@
+#include "band_executor.h"
+#include "kernel_dispatch.h"
+#include <opencv2/core/utility.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+
+namespace {
+
+// Per-thread stripe buffers, one per stage; they only grow, so after the
+// first frame at a geometry a stripe allocates nothing
+std::vector<uint8_t>& stripeStorage(size_t stage, size_t bytes) {
+    static thread_local std::vector<std::vector<uint8_t>> storage;
+    if (storage.size() <= stage) {
+        storage.resize(stage + 1);
+    }
+    if (storage[stage].size() < bytes) {
+        storage[stage].resize(bytes);
+    }
+    return storage[stage];
+}
+
+class StripeBody : public cv::ParallelLoopBody {
+public:
+    StripeBody(const std::vector<std::unique_ptr<BandStage>>& stages, const std::vector<int>& types,
+               const std::vector<int>& reach, const cv::Mat& input, const std::vector<cv::Mat*>& outputs,
+               int bandRows)
+            : stages(stages), types(types), reach(reach), input(input), outputs(outputs), bandRows(bandRows) {}
+
+    void operator()(const cv::Range& range) const override {
+        for (int band = range.start; band < range.end; band++) {
+            runBand(band * bandRows, std::min((band + 1) * bandRows, input.rows));
+        }
+    }
+
+private:
+    // Rows [y0 - extra, y1 + extra) clamped to the frame, widened to even
+    // bounds so chroma-subsampled stages always start on a pair of rows
+    void extent(int y0, int y1, int extra, int& from, int& to) const {
+        from = std::max(y0 - extra, 0) & ~1;
+        to = std::min((y1 + extra + 1) & ~1, input.rows);
+    }
+
+    void runBand(int y0, int y1) const {
+        const int last = static_cast<int>(stages.size()) - 1;
+        int inFrom = 0;
+        int inTo = 0;
+        extent(y0, y1, reach[0] + stages[0]->halo(), inFrom, inTo);
+        cv::Mat in = input.rowRange(inFrom, inTo);
+        for (int i = 0; i <= last; i++) {
+            if (i == last) {
+                cv::Mat out = outputs[i]->rowRange(y0, y1);
+                stages[i]->run(in, inFrom, y0, y1, out);
+                return;
+            }
+            int from = 0;
+            int to = 0;
+            extent(y0, y1, reach[i], from, to);
+            const size_t step = static_cast<size_t>(input.cols) * CV_ELEM_SIZE(types[i + 1]);
+            std::vector<uint8_t>& storage = stripeStorage(static_cast<size_t>(i), step * (to - from));
+            // A header of exactly these rows: no parent for filters to read past
+            cv::Mat out(to - from, input.cols, types[i + 1], storage.data(), step);
+            stages[i]->run(in, inFrom, from, to, out);
+            if (outputs[i]) {
+                out.rowRange(y0 - from, y1 - from).copyTo(outputs[i]->rowRange(y0, y1));
+            }
+            in = out;
+            inFrom = from;
+        }
+    }
+
+    const std::vector<std::unique_ptr<BandStage>>& stages;
+    const std::vector<int>& types;  // the chain's input type, then each stage's output
+    const std::vector<int>& reach;  // rows past the stripe each stage's output must cover
+    const cv::Mat& input;
+    const std::vector<cv::Mat*>& outputs;
+    int bandRows;
+};
+
+}  // namespace
+
+void BandExecutor::addStage(std::unique_ptr<BandStage> stage) {
+    stages.push_back(std::move(stage));
+}
+
+int BandExecutor::bandRows(const cv::Size& size, int inputType) const {
+    const int width = size.width;
+    const int height = size.height;
+    long bytesPerRow = static_cast<long>(width) * CV_ELEM_SIZE(inputType);
+    int type = inputType;
+    for (const auto& stage : stages) {
+        type = stage->outputType(type);
+        bytesPerRow += static_cast<long>(width) * CV_ELEM_SIZE(std::max(type, 0));
+    }
+    int rows = static_cast<int>(l2CacheBytes() / 2 / std::max(bytesPerRow, 1L));
+    // Never fewer stripes than threads, so small frames still use every core
+    const int threads = std::max(1, cv::getNumThreads());
+    rows = std::min(rows, (height + threads - 1) / threads);
+    rows = std::max(rows, kMinBandRows);
+    return (rows + 1) & ~1;  // stripes start on even rows
+}
+
+void BandExecutor::run(const cv::Mat& input, const std::vector<cv::Mat*>& outputs) {
+    CV_Assert(!stages.empty() && outputs.size() == stages.size() && outputs.back());
+    std::vector<int> types(stages.size() + 1);
+    types[0] = input.type();
+    for (size_t i = 0; i < stages.size(); i++) {
+        types[i + 1] = stages[i]->outputType(types[i]);
+        if (types[i + 1] < 0) {
+            CV_Error(cv::Error::StsUnsupportedFormat, std::string("band stage ") + stages[i]->name() +
+                     " cannot take its input");
+        }
+        CV_Assert(!outputs[i] || (outputs[i]->size() == input.size() && outputs[i]->type() == types[i + 1]));
+    }
+    // Stage i must produce the rows every later stage's halo reaches
+    std::vector<int> reach(stages.size(), 0);
+    for (size_t i = stages.size() - 1; i > 0; i--) {
+        reach[i - 1] = reach[i] + stages[i]->halo();
+    }
+    const int rows = bandRows(input.size(), input.type());
+    const int bands = (input.rows + rows - 1) / rows;
+    StripeBody body(stages, types, reach, input, outputs, rows);
+    if (bands > 1) {
+        cv::parallel_for_(cv::Range(0, bands), body, bands);
+    } else {
+        body(cv::Range(0, 1));
+    }
+}
+
+BandExecutor::Traffic BandExecutor::traffic(const cv::Size& size, int inputType, const std::vector<bool>& kept) const {
+    const uint64_t pixels = static_cast<uint64_t>(size.area());
+    Traffic traffic;
+    traffic.fused = pixels * CV_ELEM_SIZE(inputType);
+    int type = inputType;
+    for (size_t i = 0; i < stages.size(); i++) {
+        const uint64_t in = pixels * CV_ELEM_SIZE(type) + stages[i]->sideInputBytes(size);
+        type = stages[i]->outputType(type);
+        const uint64_t out = pixels * CV_ELEM_SIZE(std::max(type, 0));
+        traffic.staged += in + out;
+        traffic.fused += stages[i]->sideInputBytes(size);
+        if (i + 1 == stages.size() || (i < kept.size() && kept[i])) {
+            traffic.fused += out;
+        }
+    }
+    return traffic;
+}
+
+void Nv21ToBgrStage::run(const cv::Mat& in, int inY0, int y0, int y1, cv::Mat& out) {
+    CV_Assert(y0 % 2 == 0 && (y1 - y0) % 2 == 0 && chroma.rows * 2 >= y1);
+    cv::cvtColorTwoPlane(in.rowRange(y0 - inY0, y1 - inY0), chroma.rowRange(y0 / 2, y1 / 2), out,
+                         cv::COLOR_YUV2BGR_NV21);
+}
+
+void BgrToGrayStage::run(const cv::Mat& in, int inY0, int y0, int y1, cv::Mat& out) {
+    cv::cvtColor(in.rowRange(y0 - inY0, y1 - inY0), out, cv::COLOR_BGR2GRAY);
+}
+
+void GaussianBandStage::run(const cv::Mat& in, int inY0, int y0, int y1, cv::Mat& out) {
+    // A view of in: the rows around it are the halo, replicated only where in ends
+    cv::GaussianBlur(in.rowRange(y0 - inY0, y1 - inY0), out, cv::Size(5, 5), 0, 0, cv::BORDER_REPLICATE);
+}
+
+void GradientBandStage::run(const cv::Mat& in, int inY0, int y0, int y1, cv::Mat& out) {
+    const int width = in.cols;
+    static thread_local std::vector<int16_t> derivatives;
+    if (derivatives.size() < static_cast<size_t>(width) * 2) {
+        derivatives.resize(static_cast<size_t>(width) * 2);
+    }
+    const GradientRowFn gradientRow = edgeKernels().gradientRow;
+    const int inLast = inY0 + in.rows - 1;  // rows in holds every neighbour that exists
+    for (int y = y0; y < y1; y++) {
+        const uint8_t* r0 = in.ptr<uint8_t>(std::max(y - 1, inY0) - inY0);
+        const uint8_t* r1 = in.ptr<uint8_t>(y - inY0);
+        const uint8_t* r2 = in.ptr<uint8_t>(std::min(y + 1, inLast) - inY0);
+        gradientRow(r0, r1, r2, width, derivatives.data(), derivatives.data() + width, out.ptr<int16_t>(y - y0));
+    }
+}
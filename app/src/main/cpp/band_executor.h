@@ -0,0 +1,117 @@
+#ifndef EDGE_BAND_EXECUTOR_H
+#define EDGE_BAND_EXECUTOR_H
+
+#include <opencv2/core.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// One row-local stage of a fused chain: output row y depends only on input
+// rows y - halo() .. y + halo(), with replicated borders at the frame edges
+class BandStage {
+public:
+    virtual ~BandStage() = default;
+
+    virtual const char* name() const = 0;
+
+    // Input rows above and below each output row the stage reads
+    virtual int halo() const { return 0; }
+
+    // Output type for an input type (same size), -1 when it cannot take it
+    virtual int outputType(int inputType) const = 0;
+
+    // Bytes of planes other than its input the stage reads per frame
+    virtual size_t sideInputBytes(const cv::Size& size) const { return 0; }
+
+    // Rows [y0, y1) of the output into out (y1 - y0 rows, full width). in
+    // holds the input rows [inY0, inY0 + in.rows), at least every row within
+    // halo() of the output that exists in the frame, and is either a view of
+    // the frame or a whole matrix (no parent), so an OpenCV filter on the
+    // output's rows of it with BORDER_REPLICATE sees the halo rows as
+    // neighbours and replicates only at frame edges.
+    // y0 is even, and so is y1 unless it is the frame's last row.
+    virtual void run(const cv::Mat& in, int inY0, int y0, int y1, cv::Mat& out) = 0;
+};
+
+// Runs a chain of row-local stages one horizontal stripe at a time instead
+// of each stage sweeping the whole frame before the next starts. A stripe's
+// intermediates (each stage's rows, plus the halo rows the stages after it
+// read) live in per-thread buffers sized to stay in L2, so the input is read
+// from DRAM once and only the outputs the caller keeps are written back.
+// Stripes are independent (halo rows are recomputed by each) and run in
+// parallel. Halo recomputation is the price: per stripe, 2 x the sum of the
+// later stages' halos extra rows of each stage.
+class BandExecutor {
+public:
+    void addStage(std::unique_ptr<BandStage> stage);
+    int stageCount() const { return static_cast<int>(stages.size()); }
+
+    // Runs the chain over input. outputs[i], when not null, receives stage
+    // i's full-frame output and must already be allocated at the input's
+    // size and the stage's output type (pooled frame buffers); the last
+    // stage's output is required. Throws cv::Exception like the stages.
+    void run(const cv::Mat& input, const std::vector<cv::Mat*>& outputs);
+
+    // Rows per stripe for this chain at size: half the L2 over the chain's
+    // bytes per row, never fewer stripes than threads, at least kMinBandRows,
+    // even
+    int bandRows(const cv::Size& size, int inputType) const;
+
+    // DRAM bytes one frame costs run stage by stage (each pass reads its
+    // input and writes its output, both larger than the cache) and fused
+    // (the input once, the kept outputs once); kept has one flag per stage
+    struct Traffic {
+        uint64_t staged = 0;
+        uint64_t fused = 0;
+    };
+    Traffic traffic(const cv::Size& size, int inputType, const std::vector<bool>& kept) const;
+
+    static const int kMinBandRows = 16;
+
+private:
+    std::vector<std::unique_ptr<BandStage>> stages;
+};
+
+// Stages of the live chain: NV21 -> BGR -> gray -> 5x5 Gaussian -> gradient
+
+// Y plane rows to BGR with the interleaved VU plane set per frame; the same
+// pixels as cv::cvtColorTwoPlane(luma, chroma, bgr, COLOR_YUV2BGR_NV21)
+class Nv21ToBgrStage : public BandStage {
+public:
+    void setChroma(const cv::Mat& vu) { chroma = vu; }
+    const char* name() const override { return "nv21_bgr"; }
+    int outputType(int inputType) const override { return inputType == CV_8UC1 ? CV_8UC3 : -1; }
+    size_t sideInputBytes(const cv::Size& size) const override { return static_cast<size_t>(size.area()) / 2; }
+    void run(const cv::Mat& in, int inY0, int y0, int y1, cv::Mat& out) override;
+
+private:
+    cv::Mat chroma;
+};
+
+class BgrToGrayStage : public BandStage {
+public:
+    const char* name() const override { return "gray"; }
+    int outputType(int inputType) const override { return inputType == CV_8UC3 ? CV_8UC1 : -1; }
+    void run(const cv::Mat& in, int inY0, int y0, int y1, cv::Mat& out) override;
+};
+
+// cv::GaussianBlur(ksize 5, sigma 0), the pre-blur of canny_kernel.h
+class GaussianBandStage : public BandStage {
+public:
+    const char* name() const override { return "blur5"; }
+    int halo() const override { return 2; }
+    int outputType(int inputType) const override { return inputType == CV_8UC1 ? CV_8UC1 : -1; }
+    void run(const cv::Mat& in, int inY0, int y0, int y1, cv::Mat& out) override;
+};
+
+// 3x3 Sobel L1 magnitude |dx| + |dy| (CV_16SC1) through the dispatched
+// gradient row kernel, the Canny kernel's gradient pass
+class GradientBandStage : public BandStage {
+public:
+    const char* name() const override { return "gradient"; }
+    int halo() const override { return 1; }
+    int outputType(int inputType) const override { return inputType == CV_8UC1 ? CV_16SC1 : -1; }
+    void run(const cv::Mat& in, int inY0, int y0, int y1, cv::Mat& out) override;
+};
+
+#endif // EDGE_BAND_EXECUTOR_H
@@ -0,0 +1,87 @@
+#include "batch_processor.h"
+#include "canny_kernel.h"
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <atomic>
+
+#define LOG_TAG "BatchProcessor"
+#include "logging.h"
+
+namespace {
+
+cv::Size outputSize(const BatchParams& params) {
+    const int divisor = std::max(1, params.downscale);
+    return cv::Size(std::max(1, params.width / divisor), std::max(1, params.height / divisor));
+}
+
+// One frame per iteration; cv::parallel_for_ hands contiguous ranges of the
+// burst to the pool's threads
+class EdgeBatchBody : public cv::ParallelLoopBody {
+public:
+    EdgeBatchBody(const uint8_t* input, const int64_t* offsets, const BatchParams& params, uint8_t* output,
+                  std::atomic<bool>& failed)
+            : input(input), offsets(offsets), params(params), output(output), size(outputSize(params)),
+              failed(failed) {}
+
+    void operator()(const cv::Range& range) const override {
+        // Per worker thread, reused across the frames (and bursts) it gets
+        static thread_local cv::Mat scaled;
+        const size_t frameBytes = static_cast<size_t>(size.area());
+        for (int i = range.start; i < range.end; i++) {
+            // The Y plane is the grayscale frame; edges land straight in the
+            // caller's buffer, so Canny's create() is a no-op
+            const cv::Mat luma(params.height, params.width, CV_8UC1, const_cast<uint8_t*>(input + offsets[i]));
+            cv::Mat edges(size, CV_8UC1, output + frameBytes * i);
+            try {
+                const cv::Mat* source = &luma;
+                if (size != luma.size()) {
+                    cv::resize(luma, scaled, size, 0, 0, cv::INTER_AREA);
+                    source = &scaled;
+                }
+                cannyU8(*source, edges, params.lowThreshold, params.highThreshold, params.preBlur);
+            } catch (const cv::Exception& e) {
+                LOGE_RATELIMITED("❌ Batch frame %d failed: %s", i, e.what());
+                failed.store(true, std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    const uint8_t* input;
+    const int64_t* offsets;
+    const BatchParams& params;
+    uint8_t* output;
+    const cv::Size size;
+    std::atomic<bool>& failed;
+};
+
+}  // namespace
+
+size_t batchOutputFrameBytes(const BatchParams& params) {
+    if (params.width <= 0 || params.height <= 0 || params.downscale < 1) {
+        return 0;
+    }
+    return static_cast<size_t>(outputSize(params).area());
+}
+
+void batchOutputSize(const BatchParams& params, int& width, int& height) {
+    const cv::Size size = outputSize(params);
+    width = size.width;
+    height = size.height;
+}
+
+int processEdgeBatch(const uint8_t* input, const int64_t* inputOffsets, int count,
+                     const BatchParams& params, uint8_t* output) {
+    if (!input || !inputOffsets || !output || count <= 0 || batchOutputFrameBytes(params) == 0) {
+        return 0;
+    }
+    std::atomic<bool> failed{false};
+    cv::parallel_for_(cv::Range(0, count), EdgeBatchBody(input, inputOffsets, params, output, failed), count);
+    if (failed.load()) {
+        return 0;
+    }
+    LOGD("✅ Batch of %d frames processed (%dx%d -> %zu bytes each)", count, params.width, params.height,
+         batchOutputFrameBytes(params));
+    return count;
+}
@@ -0,0 +1,34 @@
+#ifndef EDGE_BATCH_PROCESSOR_H
+#define EDGE_BATCH_PROCESSOR_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Offline edge detection over a recorded burst. Shares nothing with the live
+// preview (no published frames, pool, ROI, governor or adaptive thresholds):
+// every call carries its own parameters, frames are spread across OpenCV's
+// thread pool, and each worker runs on its own thread-local scratch.
+struct BatchParams {
+    int width = 0;            // of every input frame (NV21, row stride = width)
+    int height = 0;
+    int downscale = 1;        // 1/N per axis before Canny
+    int lowThreshold = 100;
+    int highThreshold = 200;
+    bool preBlur = false;     // fused 5x5 Gaussian (canny_kernel.h)
+};
+
+// Bytes of one edge map in the output: the downscaled width x height, CV_8UC1
+// packed without padding; 0 when the parameters are invalid
+size_t batchOutputFrameBytes(const BatchParams& params);
+
+// Width and height of that edge map
+void batchOutputSize(const BatchParams& params, int& width, int& height);
+
+// Edge maps of count NV21 frames, frame i read at input + inputOffsets[i] and
+// written at output + i * batchOutputFrameBytes(params). Only the Y plane is
+// read. The caller guarantees both ranges are in bounds. Returns the number
+// of frames processed (count, or 0 after an OpenCV error).
+int processEdgeBatch(const uint8_t* input, const int64_t* inputOffsets, int count,
+                     const BatchParams& params, uint8_t* output);
+
+#endif // EDGE_BATCH_PROCESSOR_H
@@ -0,0 +1,23 @@
+#ifndef EDGE_ALLOC_COUNTER_H
+#define EDGE_ALLOC_COUNTER_H
+
+#include <cstdint>
+
+// Heap allocations made by the process since start, on every thread. Counts
+// two hooks, both installed by linking alloc_counter.cpp into an executable:
+// the replaced global operator new (STL containers, UMatData headers, the
+// std::function and std::thread state of the pipeline) and a cv::Mat default
+// allocator that counts the pixel buffers cv::fastMalloc hands out, which
+// never pass through operator new.
+struct AllocationCounts {
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+};
+
+AllocationCounts allocationCounts();
+
+// Routes cv::Mat::create through the counting allocator; Mats created before
+// keep the standard one and are not counted. Idempotent.
+void installCountingMatAllocator();
+
+#endif // EDGE_ALLOC_COUNTER_H
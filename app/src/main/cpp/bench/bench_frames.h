@@ -0,0 +1,46 @@
+#ifndef EDGE_BENCH_FRAMES_H
+#define EDGE_BENCH_FRAMES_H
+
+#include "frame_ingest.h"
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+// Deterministic synthetic inputs for edge_bench and edge_regress
+
+// A blurred noise field: dense, stable edges, the same on every run
+inline cv::Mat syntheticGray(int width, int height) {
+    cv::RNG rng(0x5eed);
+    cv::Mat noise(height, width, CV_8UC1);
+    rng.fill(noise, cv::RNG::UNIFORM, 0, 256);
+    cv::Mat gray;
+    cv::GaussianBlur(noise, gray, cv::Size(9, 9), 0);
+    cv::normalize(gray, gray, 0, 255, cv::NORM_MINMAX);
+    return gray;
+}
+
+inline cv::Mat syntheticBgr(int width, int height) {
+    cv::Mat bgr;
+    cv::cvtColor(syntheticGray(width, height), bgr, cv::COLOR_GRAY2BGR);
+    return bgr;
+}
+
+inline cv::Mat syntheticNv21(int width, int height) {
+    cv::Mat nv21(height + height / 2, width, CV_8UC1, cv::Scalar(128));
+    syntheticGray(width, height).copyTo(nv21.rowRange(0, height));
+    return nv21;
+}
+
+inline YuvPlanes nv21Planes(const cv::Mat& nv21, int width, int height) {
+    YuvPlanes planes;
+    planes.width = width;
+    planes.height = height;
+    planes.y = nv21.data;
+    planes.v = nv21.ptr(height);
+    planes.u = planes.v + 1;
+    planes.yRowStride = width;
+    planes.uvRowStride = width;
+    planes.uvPixelStride = 2;
+    return planes;
+}
+
+#endif // EDGE_BENCH_FRAMES_H
@@ -0,0 +1,19 @@
+#ifndef EDGE_BENCH_REPORT_H
+#define EDGE_BENCH_REPORT_H
+
+#include <benchmark/benchmark.h>
+#include <cstdint>
+
+// Counters and frame sizes shared by the edge_bench suites
+
+inline void setFrameCounters(benchmark::State& state, int width, int height) {
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(width) * height);
+    state.counters["fps"] = benchmark::Counter(static_cast<double>(state.iterations()), benchmark::Counter::kIsRate);
+}
+
+inline void frameSizes(benchmark::internal::Benchmark* bench) {
+    bench->Args({640, 480})->Args({1280, 720})->Args({1920, 1080})->Unit(benchmark::kMicrosecond);
+}
+
+#endif // EDGE_BENCH_REPORT_H
@@ -0,0 +1,757 @@
+// Device-lab benchmark driver: runs every processing mode (and every edge
+// backend) of the processing core for a fixed number of frames on synthetic
+// or replayed NV21 input and writes one JSON document with the device, CPU
+// frequency governors, temperatures, thermal status, exact per-stage
+// percentiles and the battery energy per frame of each run. Headless, so it
+// runs straight from adb:
+//
+//   adb push edge_devbench libopencv_java4.so libc++_shared.so /data/local/tmp/
+//   adb shell 'cd /data/local/tmp && LD_LIBRARY_PATH=. ./edge_devbench --out run.json'
+//   adb pull /data/local/tmp/run.json
+//
+// DEFAULT, INSET and BORDER_FIX compose RAW_CAMERA and EDGE_DETECTION output in
+// the renderer, so they have no processing of their own to measure here.
+//
+// Energy comes from the battery's power_supply sysfs node (current_now in uA,
+// voltage_now in uV), sampled on a thread of its own during each run and
+// integrated over time; an idle stretch before the runs gives the baseline
+// the per-frame figure is also reported above. Unplug USB first (adb over
+// Wi-Fi): on external power the battery current says nothing about the SoC.
+// Fuel gauges refresh every few to few hundred milliseconds, so use enough
+// frames for a run to span many refreshes (see "distinct" in the output).
+
+#include "canny_kernel.h"
+#include "contour_extractor.h"
+#include "document_detector.h"
+#include "feature_detector.h"
+#include "frame_replay.h"
+#include "image_processor.h"
+#include "kernel_dispatch.h"
+#include "line_detector.h"
+#include "metrics.h"
+#include "motion_detector.h"
+#include "optical_flow.h"
+#include "quality_governor.h"
+#include "yuv_convert.h"
+#include <opencv2/core.hpp>
+#include <opencv2/core/utility.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <dirent.h>
+#include <fcntl.h>
+#include <functional>
+#include <memory>
+#include <cmath>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/utsname.h>
+#include <unistd.h>
+#ifdef __ANDROID__
+#include <sys/system_properties.h>
+#endif
+
+namespace {
+
+const int kFormatVersion = 2;  // 2: "power" per run, "power_idle"
+
+struct Options {
+    int frames = 300;
+    int warmup = 30;
+    int width = 1280;
+    int height = 720;
+    int threads = -1;       // OpenCV default
+    int cooldownMs = 0;
+    int powerIntervalUs = 2000;  // battery sampling period, 0 = no energy measurement
+    int idleMs = 2000;           // baseline before the runs
+    std::string powerSupply;     // power_supply node, empty = the first of type Battery
+    std::string replayPath;
+    std::string modes;      // comma-separated filter, empty = all
+    std::string outPath;    // empty = stdout
+};
+
+struct Frame {
+    cv::Mat nv21;
+    cv::Mat luma;
+    YuvPlanes planes;
+};
+
+// Scratch outputs, reused across frames like the live pipeline does
+struct Scratch {
+    cv::Mat bgr;
+    cv::Mat gray;
+    cv::Mat edges;
+    cv::Mat points;
+    cv::Mat vectors;
+    cv::Mat offsets;
+    cv::Mat lines;
+    cv::Mat mask;
+};
+
+struct Mode {
+    const char* mode;
+    const char* backend;
+    std::function<void()> prepare;   // settings and detector state before the run
+    std::function<void(const Frame&, Scratch&)> process;
+};
+
+Frame frameOf(uint8_t* nv21, int width, int height) {
+    Frame frame;
+    frame.nv21 = cv::Mat(height + height / 2, width, CV_8UC1, nv21);
+    frame.luma = frame.nv21.rowRange(0, height);
+    frame.planes.width = width;
+    frame.planes.height = height;
+    frame.planes.y = nv21;
+    frame.planes.v = nv21 + static_cast<size_t>(width) * height;
+    frame.planes.u = frame.planes.v + 1;
+    frame.planes.yRowStride = width;
+    frame.planes.uvRowStride = width;
+    frame.planes.uvPixelStride = 2;
+    return frame;
+}
+
+// A drifting window over a fixed scene of shapes and texture, so tracking and
+// motion see movement; identical on every device
+std::vector<cv::Mat> syntheticSequence(int width, int height, int count) {
+    const int margin = 2 * count;
+    cv::Mat scene(height + margin, width + margin, CV_8UC1);
+    cv::RNG rng(0x5eed);
+    rng.fill(scene, cv::RNG::UNIFORM, 0, 256);
+    cv::GaussianBlur(scene, scene, cv::Size(15, 15), 0);
+    cv::normalize(scene, scene, 40, 200, cv::NORM_MINMAX);
+    for (int i = 0; i < 40; i++) {
+        const cv::Point corner(rng.uniform(0, scene.cols), rng.uniform(0, scene.rows));
+        const cv::Size size(rng.uniform(20, width / 4), rng.uniform(20, height / 4));
+        cv::rectangle(scene, cv::Rect(corner, size), cv::Scalar(rng.uniform(0, 256)), cv::FILLED);
+    }
+    cv::Mat document(height / 2, width / 3, CV_8UC1, cv::Scalar(235));
+    document.copyTo(scene(cv::Rect(width / 3, height / 4, document.cols, document.rows)));
+
+    std::vector<cv::Mat> sequence;
+    for (int i = 0; i < count; i++) {
+        cv::Mat nv21(height + height / 2, width, CV_8UC1, cv::Scalar(128));
+        cv::Mat luma = nv21.rowRange(0, height);
+        scene(cv::Rect(2 * i, i, width, height)).copyTo(luma);
+        cv::Mat noise(height, width, CV_16SC1);
+        rng.fill(noise, cv::RNG::NORMAL, 0, 3);
+        cv::add(luma, noise, luma, cv::noArray(), CV_8U);
+        sequence.push_back(nv21);
+    }
+    return sequence;
+}
+
+std::vector<Mode> allModes() {
+    auto pinnedCanny = [](CannyBackend backend, bool preBlur) {
+        return [backend, preBlur] {
+            setCannyBackend(backend);
+            setEdgePreBlur(preBlur);
+        };
+    };
+    auto edges = [](const Frame& frame, Scratch& scratch) {
+        ScopedStageTimer timer(Stage::CANNY);
+        detectEdges(frame.luma, scratch.edges);
+    };
+    auto noPrepare = [] {};
+    return {
+        {"raw_camera", "cpu", noPrepare,
+         [](const Frame& frame, Scratch& scratch) {
+             ScopedStageTimer timer(Stage::YUV_TO_BGR);
+             convertYuvPlanesToBgr(frame.planes, scratch.bgr);
+         }},
+        {"grayscale", "luma", noPrepare,
+         [](const Frame& frame, Scratch& scratch) {
+             ScopedStageTimer timer(Stage::GRAYSCALE);
+             frame.luma.copyTo(scratch.gray);
+         }},
+        {"edge_detection", "opencv", pinnedCanny(CannyBackend::OPENCV, false), edges},
+        {"edge_detection", "kernel", pinnedCanny(CannyBackend::KERNEL, false), edges},
+        {"edge_detection", "tiled", pinnedCanny(CannyBackend::TILED, false), edges},
+        {"edge_detection", "kernel_preblur", pinnedCanny(CannyBackend::KERNEL, true), edges},
+        {"edge_detection", "gradient", noPrepare,
+         [](const Frame& frame, Scratch& scratch) {
+             ScopedStageTimer timer(Stage::CANNY);
+             detectGradientEdges(frame.luma, scratch.edges);
+         }},
+        {"features", "fast_grid", noPrepare,
+         [](const Frame& frame, Scratch& scratch) {
+             scratch.points.create(featureDetector().capacity(), 1, CV_32FC2);
+             ScopedStageTimer timer(Stage::FEATURES);
+             featureDetector().detect(frame.luma, scratch.points);
+         }},
+        {"tracking", "lucas_kanade", [] { pointTracker().reset(); },
+         [](const Frame& frame, Scratch& scratch) {
+             scratch.vectors.create(2 * pointTracker().capacity(), 1, CV_32FC2);
+             ScopedStageTimer timer(Stage::TRACKING);
+             pointTracker().track(frame.luma, scratch.vectors);
+         }},
+        {"contours", "approx_poly", pinnedCanny(CannyBackend::AUTO, false),
+         [edges](const Frame& frame, Scratch& scratch) {
+             edges(frame, scratch);
+             scratch.points.create(ContourExtractor::kMaxPoints, 1, CV_32FC2);
+             scratch.offsets.create(ContourExtractor::kMaxStrips + 1, 1, CV_32SC1);
+             ScopedStageTimer timer(Stage::CONTOURS);
+             contourExtractor().extract(scratch.edges, scratch.points, scratch.offsets);
+         }},
+        {"lines", "hough_p", pinnedCanny(CannyBackend::AUTO, false),
+         [edges](const Frame& frame, Scratch& scratch) {
+             edges(frame, scratch);
+             scratch.lines.create(2 * LineDetector::kMaxLines, 1, CV_32FC2);
+             lineDetector().detect(scratch.edges, scratch.lines);  // times Stage::HOUGH itself
+         }},
+        {"motion", "mog2", [] { motionDetector().reset(); },
+         [](const Frame& frame, Scratch& scratch) {
+             scratch.mask.create(motionDetector().maskSize(frame.luma.size()), CV_8UC1);
+             ScopedStageTimer timer(Stage::MOTION);
+             motionDetector().detect(frame.luma, scratch.mask);
+         }},
+        {"document", "quad_search", [] { documentDetector().reset(); },
+         [edges](const Frame& frame, Scratch& scratch) {
+             edges(frame, scratch);
+             cv::Point2f corners[4];
+             ScopedStageTimer timer(Stage::DOCUMENT);
+             documentDetector().detect(scratch.edges, corners);
+         }},
+    };
+}
+
+// --- JSON output ---------------------------------------------------------
+
+std::string quoted(const std::string& text) {
+    std::string out = "\"";
+    for (char c : text) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) >= 0x20) {
+                    out += c;
+                }
+        }
+    }
+    return out + "\"";
+}
+
+std::string readLine(const std::string& path) {
+    std::string value;
+    FILE* file = std::fopen(path.c_str(), "re");
+    if (file) {
+        char buffer[256];
+        if (std::fgets(buffer, sizeof(buffer), file)) {
+            value = buffer;
+            while (!value.empty() && (value.back() == '\n' || value.back() == ' ')) {
+                value.pop_back();
+            }
+        }
+        std::fclose(file);
+    }
+    return value;
+}
+
+std::vector<std::string> listDir(const std::string& dir, const std::string& prefix) {
+    std::vector<std::string> names;
+    DIR* handle = opendir(dir.c_str());
+    if (!handle) {
+        return names;
+    }
+    while (dirent* entry = readdir(handle)) {
+        const std::string name = entry->d_name;
+        if (name.compare(0, prefix.size(), prefix) == 0) {
+            names.push_back(name);
+        }
+    }
+    closedir(handle);
+    std::sort(names.begin(), names.end(), [&prefix](const std::string& a, const std::string& b) {
+        return std::atoi(a.c_str() + prefix.size()) < std::atoi(b.c_str() + prefix.size());
+    });
+    return names;
+}
+
+std::string property(const char* name) {
+#ifdef __ANDROID__
+    char value[PROP_VALUE_MAX] = {};
+    __system_property_get(name, value);
+    return value;
+#else
+    (void)name;
+    return std::string();
+#endif
+}
+
+std::string deviceJson() {
+    utsname host = {};
+    uname(&host);
+    std::string json = "{";
+    json += "\"manufacturer\": " + quoted(property("ro.product.manufacturer"));
+    json += ", \"model\": " + quoted(property("ro.product.model"));
+    json += ", \"device\": " + quoted(property("ro.product.device"));
+    json += ", \"soc_manufacturer\": " + quoted(property("ro.soc.manufacturer"));
+    json += ", \"soc_model\": " + quoted(property("ro.soc.model"));
+    json += ", \"board_platform\": " + quoted(property("ro.board.platform"));
+    json += ", \"sdk\": " + quoted(property("ro.build.version.sdk"));
+    json += ", \"fingerprint\": " + quoted(property("ro.build.fingerprint"));
+    json += ", \"kernel\": " + quoted(std::string(host.sysname) + " " + host.release);
+    json += ", \"machine\": " + quoted(host.machine);
+    json += ", \"cpus\": " + std::to_string(std::thread::hardware_concurrency());
+    json += ", \"opencv_threads\": " + std::to_string(cv::getNumThreads());
+    json += ", \"canny_neon\": " + std::string(cannyKernelUsesNeon() ? "true" : "false");
+    json += ", \"kernel_isa\": \"" + std::string(isaLevelName(edgeKernels().level)) + "\"";
+    return json + "}";
+}
+
+// One entry per cpufreq policy (cluster): governor and clocks right now
+std::string cpufreqJson() {
+    const std::string root = "/sys/devices/system/cpu/cpufreq/";
+    std::string json = "[";
+    bool first = true;
+    for (const std::string& policy : listDir(root, "policy")) {
+        const std::string dir = root + policy + "/";
+        json += first ? "" : ", ";
+        first = false;
+        json += "{\"policy\": " + quoted(policy);
+        json += ", \"cpus\": " + quoted(readLine(dir + "related_cpus"));
+        json += ", \"governor\": " + quoted(readLine(dir + "scaling_governor"));
+        json += ", \"cur_khz\": " + std::to_string(std::atol(readLine(dir + "scaling_cur_freq").c_str()));
+        json += ", \"min_khz\": " + std::to_string(std::atol(readLine(dir + "scaling_min_freq").c_str()));
+        json += ", \"max_khz\": " + std::to_string(std::atol(readLine(dir + "scaling_max_freq").c_str()));
+        json += ", \"hw_max_khz\": " + std::to_string(std::atol(readLine(dir + "cpuinfo_max_freq").c_str())) + "}";
+    }
+    return json + "]";
+}
+
+// Thermal zones readable without root, in degrees Celsius (millidegree
+// sysfs values are scaled down)
+std::string temperaturesJson() {
+    const std::string root = "/sys/class/thermal/";
+    std::string json = "{";
+    bool first = true;
+    for (const std::string& zone : listDir(root, "thermal_zone")) {
+        const std::string raw = readLine(root + zone + "/temp");
+        if (raw.empty()) {
+            continue;
+        }
+        std::string type = readLine(root + zone + "/type");
+        if (type.empty()) {
+            type = zone;
+        }
+        double celsius = std::atof(raw.c_str());
+        if (std::abs(celsius) >= 1000) {
+            celsius /= 1000;
+        }
+        char value[32];
+        std::snprintf(value, sizeof(value), "%.1f", celsius);
+        json += std::string(first ? "" : ", ") + quoted(zone + ":" + type) + ": " + value;
+        first = false;
+    }
+    return json + "}";
+}
+
+std::string thermalJson() {
+    return "{\"status\": " + std::to_string(deviceThermalStatus()) + ", \"temperatures_c\": " +
+           temperaturesJson() + "}";
+}
+
+double percentile(std::vector<double>& samples, double quantile) {
+    const size_t rank = std::min(samples.size() - 1, static_cast<size_t>(quantile * samples.size()));
+    std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+    return samples[rank];
+}
+
+std::string statsJson(std::vector<double> samples) {
+    if (samples.empty()) {
+        return "{}";
+    }
+    double sum = 0;
+    for (double sample : samples) {
+        sum += sample;
+    }
+    char json[256];
+    const double mean = sum / samples.size();
+    const double p50 = percentile(samples, 0.50);
+    const double p90 = percentile(samples, 0.90);
+    const double p95 = percentile(samples, 0.95);
+    const double p99 = percentile(samples, 0.99);
+    const double max = *std::max_element(samples.begin(), samples.end());
+    std::snprintf(json, sizeof(json),
+                  "{\"mean_us\": %.1f, \"p50_us\": %.1f, \"p90_us\": %.1f, \"p95_us\": %.1f, \"p99_us\": %.1f, "
+                  "\"max_us\": %.1f}",
+                  mean, p50, p90, p95, p99, max);
+    return json;
+}
+
+// --- Battery power ---------------------------------------------------------
+
+// Reads one integer sysfs attribute kept open, re-read from offset 0 (each
+// pread is a fresh kernel read); cheaper than reopening at kHz rates
+class SysfsValue {
+public:
+    explicit SysfsValue(const std::string& path) : fd(open(path.c_str(), O_RDONLY | O_CLOEXEC)) {}
+    ~SysfsValue() {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+    SysfsValue(const SysfsValue&) = delete;
+    SysfsValue& operator=(const SysfsValue&) = delete;
+
+    bool ok() const { return fd >= 0; }
+    bool read(long long& value) {
+        char text[32];
+        const ssize_t length = fd >= 0 ? pread(fd, text, sizeof(text) - 1, 0) : -1;
+        if (length <= 0) {
+            return false;
+        }
+        text[length] = '\0';
+        char* end = nullptr;
+        value = std::strtoll(text, &end, 10);
+        return end != text;
+    }
+
+private:
+    int fd;
+};
+
+// Battery power integrated over a run on a sampling thread
+class PowerSampler {
+public:
+    struct Result {
+        int samples = 0;
+        int distinct = 0;          // readings that differed from the previous one
+        double seconds = 0;
+        double energyMillijoules = 0;
+    };
+
+    // The power_supply node: name, else the first one of type Battery
+    static std::string findSupply(const std::string& name) {
+        const std::string root = "/sys/class/power_supply/";
+        if (!name.empty()) {
+            return root + name;
+        }
+        for (const std::string& supply : listDir(root, "")) {
+            if (supply[0] != '.' && readLine(root + supply + "/type") == "Battery") {
+                return root + supply;
+            }
+        }
+        return std::string();
+    }
+
+    PowerSampler(const std::string& supply, int intervalUs)
+            : current(supply + "/current_now"), voltage(supply + "/voltage_now"), intervalUs(intervalUs) {}
+
+    bool available() const { return current.ok() && voltage.ok(); }
+
+    void start() {
+        stopping.store(false);
+        result = Result();
+        thread = std::thread(&PowerSampler::run, this);
+    }
+
+    Result stop() {
+        stopping.store(true);
+        thread.join();
+        return result;
+    }
+
+private:
+    // |current| x voltage in mW; the sign of current_now differs between
+    // vendors (discharge is negative on some)
+    bool sample(double& milliwatts, long long& rawCurrent) {
+        long long microamps = 0;
+        long long microvolts = 0;
+        if (!current.read(microamps) || !voltage.read(microvolts)) {
+            return false;
+        }
+        rawCurrent = microamps;
+        milliwatts = std::fabs(static_cast<double>(microamps)) * static_cast<double>(microvolts) * 1e-9;
+        return true;
+    }
+
+    void run() {
+        double previousPower = 0;
+        long long previousCurrent = 0;
+        auto previousTime = std::chrono::steady_clock::now();
+        const auto begin = previousTime;
+        bool first = true;
+        while (!stopping.load()) {
+            double power = 0;
+            long long raw = 0;
+            const auto now = std::chrono::steady_clock::now();
+            if (sample(power, raw)) {
+                if (!first) {
+                    // Trapezoid between consecutive samples
+                    const double seconds = std::chrono::duration<double>(now - previousTime).count();
+                    result.energyMillijoules += 0.5 * (power + previousPower) * seconds;
+                    result.distinct += raw != previousCurrent;
+                }
+                first = false;
+                previousPower = power;
+                previousCurrent = raw;
+                previousTime = now;
+                result.samples++;
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(intervalUs));
+        }
+        result.seconds = std::chrono::duration<double>(previousTime - begin).count();
+    }
+
+    SysfsValue current;
+    SysfsValue voltage;
+    const int intervalUs;
+    std::thread thread;
+    std::atomic<bool> stopping{false};
+    Result result;
+};
+
+// Mean power of a run, its energy per frame, and per frame above the idle
+// baseline (when one was measured)
+std::string powerJson(const PowerSampler::Result& power, int frames, double idleMilliwatts) {
+    if (power.samples < 2 || power.seconds <= 0) {
+        return "null";
+    }
+    const double milliwatts = power.energyMillijoules / power.seconds;
+    char json[320];
+    std::snprintf(json, sizeof(json),
+                  "{\"samples\": %d, \"distinct\": %d, \"mean_mw\": %.1f, \"energy_mj\": %.2f, "
+                  "\"mj_per_frame\": %.4f, \"mj_per_frame_above_idle\": %.4f}",
+                  power.samples, power.distinct, milliwatts, power.energyMillijoules,
+                  power.energyMillijoules / frames,
+                  idleMilliwatts > 0 ? std::max(0.0, milliwatts - idleMilliwatts) * power.seconds / frames : 0.0);
+    return json;
+}
+
+// --- Runs ------------------------------------------------------------------
+
+bool selected(const Options& options, const Mode& mode) {
+    if (options.modes.empty()) {
+        return true;
+    }
+    const std::string name = mode.mode;
+    const std::string qualified = name + "/" + mode.backend;
+    size_t start = 0;
+    while (start <= options.modes.size()) {
+        size_t end = options.modes.find(',', start);
+        if (end == std::string::npos) {
+            end = options.modes.size();
+        }
+        const std::string item = options.modes.substr(start, end - start);
+        if (item == name || item == qualified) {
+            return true;
+        }
+        start = end + 1;
+    }
+    return false;
+}
+
+std::string runMode(const Options& options, const Mode& mode, const std::vector<Frame>& input,
+                    PowerSampler* sampler, double idleMilliwatts) {
+    const std::string thermalBefore = thermalJson();
+    mode.prepare();
+    Scratch scratch;
+    for (int i = 0; i < options.warmup; i++) {
+        mode.process(input[i % input.size()], scratch);
+    }
+
+    const int stageCount = static_cast<int>(Stage::COUNT);
+    std::vector<std::vector<double>> stageSamples(stageCount);
+    std::vector<double> totals;
+    totals.reserve(options.frames);
+    if (sampler) {
+        sampler->start();
+    }
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < options.frames; i++) {
+        threadFrameStages().clear();
+        const auto frameStart = std::chrono::steady_clock::now();
+        mode.process(input[i % input.size()], scratch);
+        const auto frameEnd = std::chrono::steady_clock::now();
+        totals.push_back(std::chrono::duration<double, std::micro>(frameEnd - frameStart).count());
+        const FrameStageTimes& stages = threadFrameStages();
+        for (int s = 0; s < stageCount; s++) {
+            stageSamples[s].push_back(stages.micros[s]);
+        }
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const std::string power = sampler ? powerJson(sampler->stop(), options.frames, idleMilliwatts) : "null";
+
+    std::string json = "{\"mode\": " + quoted(mode.mode) + ", \"backend\": " + quoted(mode.backend);
+    char rate[96];
+    std::snprintf(rate, sizeof(rate), ", \"frames\": %d, \"seconds\": %.3f, \"fps\": %.2f", options.frames, seconds,
+                  seconds > 0 ? options.frames / seconds : 0.0);
+    json += rate;
+    json += ", \"thermal_before\": " + thermalBefore + ", \"thermal_after\": " + thermalJson();
+    json += ", \"cpufreq_after\": " + cpufreqJson();
+    json += ", \"power\": " + power;
+    json += ", \"frame_total\": " + statsJson(totals);
+    json += ", \"stages\": {";
+    bool first = true;
+    for (int s = 0; s < stageCount; s++) {
+        const std::vector<double>& samples = stageSamples[s];
+        if (std::all_of(samples.begin(), samples.end(), [](double v) { return v == 0; })) {
+            continue;  // not part of this mode
+        }
+        json += std::string(first ? "" : ", ") + quoted(stageName(static_cast<Stage>(s))) + ": " + statsJson(samples);
+        first = false;
+    }
+    return json + "}}";
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--frames" && hasValue) {
+            options.frames = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--warmup" && hasValue) {
+            options.warmup = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--size" && hasValue) {
+            if (std::sscanf(argv[++i], "%dx%d", &options.width, &options.height) != 2 || options.width <= 0 ||
+                options.height <= 0 || options.height % 2) {
+                return false;
+            }
+        } else if (arg == "--threads" && hasValue) {
+            options.threads = std::atoi(argv[++i]);
+        } else if (arg == "--cooldown-ms" && hasValue) {
+            options.cooldownMs = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--power-interval-us" && hasValue) {
+            options.powerIntervalUs = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--idle-ms" && hasValue) {
+            options.idleMs = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--power-supply" && hasValue) {
+            options.powerSupply = argv[++i];
+        } else if (arg == "--replay" && hasValue) {
+            options.replayPath = argv[++i];
+        } else if (arg == "--modes" && hasValue) {
+            options.modes = argv[++i];
+        } else if (arg == "--out" && hasValue) {
+            options.outPath = argv[++i];
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::fprintf(stderr,
+                     "usage: %s [--frames 300] [--warmup 30] [--size 1280x720] [--threads N]\n"
+                     "          [--cooldown-ms 0] [--replay FILE] [--modes edge_detection,lines/hough_p,...]\n"
+                     "          [--power-interval-us 2000] [--idle-ms 2000] [--power-supply battery]\n"
+                     "          [--out FILE]\n"
+                     "--replay takes a frame capture or a raw NV21 file of --size frames\n"
+                     "--power-interval-us 0 turns the battery energy measurement off\n",
+                     argv[0]);
+        return 2;
+    }
+    if (options.threads >= 0) {
+        cv::setNumThreads(options.threads);
+    }
+    setAdaptiveThresholds(false);
+
+    // Input frames: cycled for as many frames as each run needs
+    std::vector<cv::Mat> synthetic;
+    FrameReplay replay;
+    std::vector<Frame> input;
+    std::string source = "synthetic";
+    if (!options.replayPath.empty()) {
+        if (!replay.load(options.replayPath.c_str(), options.width, options.height, 0)) {
+            std::fprintf(stderr, "%s: no frames to replay\n", options.replayPath.c_str());
+            return 1;
+        }
+        replay.run([&input](const ReplayFrame& frame) {
+            // The mapping is copy-on-write and outlives the runs
+            input.push_back(frameOf(const_cast<uint8_t*>(frame.nv21), frame.width, frame.height));
+        }, ReplayPacing::MAX_SPEED, 1);
+        source = options.replayPath;
+    } else {
+        synthetic = syntheticSequence(options.width, options.height, 60);
+        for (cv::Mat& nv21 : synthetic) {
+            input.push_back(frameOf(nv21.data, options.width, options.height));
+        }
+    }
+
+    // Battery sampling, and the idle power the runs are compared against
+    std::unique_ptr<PowerSampler> sampler;
+    std::string supply;
+    std::string powerIdle = "null";
+    double idleMilliwatts = 0;
+    if (options.powerIntervalUs > 0) {
+        supply = PowerSampler::findSupply(options.powerSupply);
+        if (!supply.empty()) {
+            sampler.reset(new PowerSampler(supply, options.powerIntervalUs));
+        }
+        if (!sampler || !sampler->available()) {
+            std::fprintf(stderr, "no readable battery current/voltage%s%s, energy not measured\n",
+                         supply.empty() ? "" : " in ", supply.c_str());
+            sampler.reset();
+        } else {
+            if (readLine(supply + "/status") == "Charging" || readLine(supply + "/status") == "Full") {
+                std::fprintf(stderr, "warning: %s is on external power, energy figures are meaningless\n",
+                             supply.c_str());
+            }
+            if (options.idleMs > 0) {
+                std::fprintf(stderr, "idle baseline...\n");
+                sampler->start();
+                std::this_thread::sleep_for(std::chrono::milliseconds(options.idleMs));
+                const PowerSampler::Result idle = sampler->stop();
+                if (idle.samples >= 2 && idle.seconds > 0) {
+                    idleMilliwatts = idle.energyMillijoules / idle.seconds;
+                    char json[96];
+                    std::snprintf(json, sizeof(json), "{\"mean_mw\": %.1f, \"seconds\": %.2f}", idleMilliwatts,
+                                  idle.seconds);
+                    powerIdle = json;
+                }
+            }
+        }
+    }
+
+    std::string json = "{\"tool\": \"edge_devbench\", \"format\": " + std::to_string(kFormatVersion);
+    json += ", \"timestamp\": " + std::to_string(static_cast<long long>(std::time(nullptr)));
+    json += ", \"device\": " + deviceJson();
+    json += ", \"cpufreq\": " + cpufreqJson();
+    json += ", \"thermal\": " + thermalJson();
+    json += ", \"power_supply\": " + (sampler ? quoted(supply) : std::string("null"));
+    json += ", \"power_idle\": " + powerIdle;
+    json += ", \"config\": {\"input\": " + quoted(source) + ", \"input_frames\": " + std::to_string(input.size()) +
+            ", \"width\": " + std::to_string(input.front().luma.cols) +
+            ", \"height\": " + std::to_string(input.front().luma.rows) +
+            ", \"frames\": " + std::to_string(options.frames) + ", \"warmup\": " + std::to_string(options.warmup) +
+            ", \"cooldown_ms\": " + std::to_string(options.cooldownMs) +
+            ", \"power_interval_us\": " + std::to_string(options.powerIntervalUs) + "}";
+    json += ", \"runs\": [";
+    bool first = true;
+    for (const Mode& mode : allModes()) {
+        if (!selected(options, mode)) {
+            continue;
+        }
+        if (!first && options.cooldownMs > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(options.cooldownMs));
+        }
+        std::fprintf(stderr, "%s/%s...\n", mode.mode, mode.backend);
+        json += std::string(first ? "\n  " : ",\n  ") + runMode(options, mode, input, sampler.get(), idleMilliwatts);
+        first = false;
+    }
+    json += "\n]}\n";
+    setCannyBackend(CannyBackend::AUTO);
+    setEdgePreBlur(false);
+
+    FILE* out = options.outPath.empty() ? stdout : std::fopen(options.outPath.c_str(), "we");
+    if (!out) {
+        std::perror(options.outPath.c_str());
+        return 1;
+    }
+    const bool written = std::fwrite(json.data(), json.size(), 1, out) == 1;
+    if (out != stdout) {
+        std::fclose(out);
+    }
+    return written ? 0 : 1;
+}
@@ -0,0 +1,147 @@
+// End-to-end benchmarks of the processing core (edge_core) on synthetic
+// frames at 480p, 720p and 1080p; stage_bench.cpp times each stage alone.
+// Builds on the desktop and as an NDK executable; see the EDGE_BUILD_BENCH
+// notes in ../CMakeLists.txt.
+//
+//   adb push edge_bench /data/local/tmp && adb shell /data/local/tmp/edge_bench
+
+#include "bench_frames.h"
+#include "bench_report.h"
+#include "image_processor.h"
+#include "image_rotate.h"
+#include "kernel_dispatch.h"
+#include <vector>
+
+namespace {
+
+// processFrame: BGR -> gray -> Canny -> BGR (no filter graph configured)
+void BM_ProcessFrame(benchmark::State& state) {
+    const int width = static_cast<int>(state.range(0));
+    const int height = static_cast<int>(state.range(1));
+    const cv::Mat bgr = syntheticBgr(width, height);
+    cv::Mat output;
+    for (auto _ : state) {
+        processFrame(bgr, output);
+        benchmark::DoNotOptimize(output.data);
+    }
+    setFrameCounters(state, width, height);
+}
+
+// Quarter turn of a BGR frame, the CPU rotation the renderer now replaces
+void BM_Rotate90(benchmark::State& state) {
+    const int width = static_cast<int>(state.range(0));
+    const int height = static_cast<int>(state.range(1));
+    const cv::Mat bgr = syntheticBgr(width, height);
+    cv::Mat rotated;
+    for (auto _ : state) {
+        cv::rotate(bgr, rotated, cv::ROTATE_90_CLOCKWISE);
+        benchmark::DoNotOptimize(rotated.data);
+    }
+    setFrameCounters(state, width, height);
+}
+
+// The same turn through the tiled register-block transpose (image_rotate.h)
+void BM_RotateImage90(benchmark::State& state) {
+    const int width = static_cast<int>(state.range(0));
+    const int height = static_cast<int>(state.range(1));
+    const cv::Mat bgr = syntheticBgr(width, height);
+    cv::Mat rotated;
+    for (auto _ : state) {
+        rotateImage(bgr, 90, rotated);
+        benchmark::DoNotOptimize(rotated.data);
+    }
+    setFrameCounters(state, width, height);
+}
+
+// Luma only, cv::rotate against the tiled transpose
+void BM_RotateLuma90(benchmark::State& state) {
+    const int width = static_cast<int>(state.range(0));
+    const int height = static_cast<int>(state.range(1));
+    const bool tiled = state.range(2) != 0;
+    cv::Mat gray;
+    cv::cvtColor(syntheticBgr(width, height), gray, cv::COLOR_BGR2GRAY);
+    cv::Mat rotated;
+    for (auto _ : state) {
+        if (tiled) {
+            rotateImage(gray, 90, rotated);
+        } else {
+            cv::rotate(gray, rotated, cv::ROTATE_90_CLOCKWISE);
+        }
+        benchmark::DoNotOptimize(rotated.data);
+    }
+    setFrameCounters(state, width, height);
+}
+
+// One dispatched kernel over a 1080p frame at one ISA level (kernelsFor), so
+// the levels of one build compare side by side on any CPU, x86_64 CI
+// included: 0 gradient, 1 gradient threshold, 2 bit-pack, 3 planar YUV ->
+// BGR, 4 8x8 transposes
+void BM_KernelLevel(benchmark::State& state) {
+    const EdgeKernels& kernels = *kernelsFor(static_cast<IsaLevel>(state.range(0)));
+    const int kernel = static_cast<int>(state.range(1));
+    const int width = 1920;
+    const int height = 1080;
+    const cv::Mat gray = syntheticGray(width, height);
+    cv::Mat binary;
+    cv::threshold(gray, binary, 160, 255, cv::THRESH_BINARY);
+    std::vector<int16_t> dx(width);
+    std::vector<int16_t> dy(width);
+    std::vector<int16_t> mag(width);
+    std::vector<uint8_t> row(width * 3);
+    const std::vector<uint8_t> chroma(width / 2, 128);
+    cv::Mat transposed(width, height, CV_8UC1);
+    for (auto _ : state) {
+        for (int y = 1; y + 1 < height; y++) {
+            switch (kernel) {
+                case 0:
+                    kernels.gradientRow(gray.ptr(y - 1), gray.ptr(y), gray.ptr(y + 1), width, dx.data(), dy.data(),
+                                        mag.data());
+                    break;
+                case 1:
+                    kernels.gradientThresholdRow(gray.ptr(y - 1), gray.ptr(y), gray.ptr(y + 1), width, 200,
+                                                 row.data());
+                    break;
+                case 2:
+                    kernels.packRow(binary.ptr(y), width, row.data(), (width + 7) / 8);
+                    break;
+                case 3:
+                    kernels.planarToBgrRow(gray.ptr(y), chroma.data(), chroma.data(), width, row.data());
+                    break;
+                default:
+                    if (y % 8 == 0 && y + 8 <= height) {
+                        for (int x = 0; x + 8 <= width; x += 8) {
+                            kernels.transposeBlockC1(gray.ptr(y) + x, gray.step, transposed.ptr(x) + y,
+                                                     transposed.step);
+                        }
+                    }
+                    break;
+            }
+        }
+        benchmark::DoNotOptimize(row.data());
+        benchmark::DoNotOptimize(mag.data());
+        benchmark::DoNotOptimize(transposed.data);
+    }
+    state.SetLabel(isaLevelName(kernels.level));
+    setFrameCounters(state, width, height);
+}
+
+// Every level this build carries and this CPU runs
+void kernelLevels(benchmark::internal::Benchmark* benchmark) {
+    for (int level = static_cast<int>(IsaLevel::SCALAR); level <= static_cast<int>(IsaLevel::AVX2); level++) {
+        if (kernelsFor(static_cast<IsaLevel>(level))) {
+            for (int kernel = 0; kernel < 5; kernel++) {
+                benchmark->Args({level, kernel});
+            }
+        }
+    }
+}
+
+} // namespace
+
+BENCHMARK(BM_ProcessFrame)->Apply(frameSizes);
+BENCHMARK(BM_Rotate90)->Apply(frameSizes);
+BENCHMARK(BM_RotateImage90)->Apply(frameSizes);
+BENCHMARK(BM_RotateLuma90)->Args({1920, 1080, 0})->Args({1920, 1080, 1});
+BENCHMARK(BM_KernelLevel)->Apply(kernelLevels);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,587 @@
+// Correctness and performance regression check of the edge backends. Every
+// backend runs on a fixed corpus of NV21 frames; its edge maps are scored
+// against golden maps with a 1-pixel tolerant F-score and its p95 time is
+// compared with a stored baseline. Exit status 0 on pass, 1 on any failure.
+//
+//   edge_regress --write-baseline edge_baseline.txt    # on the reference build
+//   edge_regress --baseline edge_baseline.txt          # on the change
+//
+// The golden maps are the reference Canny of each backend's contract, computed
+// with cv::Canny on the run; --golden DIR reads them from DIR instead (PGMs
+// written by --golden DIR --update-golden), which pins them across OpenCV
+// updates. --corpus DIR adds raw frames named <name>_<W>x<H>.nv21 (e.g. from
+// the frame capture) to the synthetic ones. GPU backends need a device and are
+// not covered here. Before the backends, every dispatched ISA level this
+// build carries and the CPU runs (kernel_dispatch.h) must reproduce the
+// scalar kernels byte for byte on the corpus, so an x86_64 CI host checks
+// the SSE4.1/AVX2 kernels and an arm64 device the NEON ones.
+
+#include "bench_frames.h"
+#include "canny_kernel.h"
+#include "image_processor.h"
+#include "kernel_dispatch.h"
+#include <opencv2/imgcodecs.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct CorpusFrame {
+    std::string name;
+    cv::Mat nv21;   // (height * 3 / 2) x width
+    cv::Mat luma;   // Y plane, a view of nv21
+};
+
+// What a backend's output must match
+enum class Reference {
+    CANNY,          // cv::Canny of the Y plane
+    BLUR_CANNY,     // cv::Canny of the 5x5 Gaussian-blurred Y plane
+    BGR_GRAY_CANNY, // cv::Canny of the gray of the full NV21 -> BGR conversion
+};
+
+const char* referenceName(Reference reference) {
+    switch (reference) {
+        case Reference::CANNY: return "canny";
+        case Reference::BLUR_CANNY: return "blur_canny";
+        case Reference::BGR_GRAY_CANNY: return "bgr_gray_canny";
+    }
+    return "?";
+}
+
+struct Backend {
+    const char* name;
+    Reference reference;
+    double minFScore;   // on every frame
+    std::function<void(const CorpusFrame&, cv::Mat&)> run;
+};
+
+struct Options {
+    std::string baselinePath;
+    std::string writeBaselinePath;
+    std::string goldenDir;
+    std::string corpusDir;
+    bool updateGolden = false;
+    double maxRegression = 0.10;
+    int runs = 20;
+};
+
+void addSyntheticFrame(std::vector<CorpusFrame>& corpus, const std::string& name, const cv::Mat& luma,
+                       int chromaSeed) {
+    const int width = luma.cols;
+    const int height = luma.rows;
+    CorpusFrame frame;
+    frame.name = name + "_" + std::to_string(width) + "x" + std::to_string(height);
+    frame.nv21.create(height + height / 2, width, CV_8UC1);
+    luma.copyTo(frame.nv21.rowRange(0, height));
+    // Slowly varying chroma, so the BGR round trip is not a plain copy of Y
+    cv::Mat chroma(height / 2, width, CV_8UC1);
+    cv::RNG rng(static_cast<uint64_t>(chromaSeed));
+    rng.fill(chroma, cv::RNG::UNIFORM, 96, 160);
+    cv::GaussianBlur(chroma, chroma, cv::Size(31, 31), 0);
+    chroma.copyTo(frame.nv21.rowRange(height, height + height / 2));
+    frame.luma = frame.nv21.rowRange(0, height);
+    corpus.push_back(frame);
+}
+
+// Deterministic scenes covering what the camera sees: hard shapes, texture,
+// fine line structure and a dim, noisy frame
+void buildSyntheticCorpus(std::vector<CorpusFrame>& corpus) {
+    const cv::Size sizes[] = {cv::Size(640, 480), cv::Size(1280, 720)};
+    int seed = 1;
+    for (const cv::Size& size : sizes) {
+        cv::RNG rng(static_cast<uint64_t>(seed));
+
+        cv::Mat shapes(size, CV_8UC1);
+        for (int y = 0; y < size.height; y++) {
+            shapes.row(y).setTo(cv::Scalar(40 + 120 * y / size.height));
+        }
+        for (int i = 0; i < 24; i++) {
+            const cv::Point center(rng.uniform(0, size.width), rng.uniform(0, size.height));
+            const int radius = rng.uniform(size.height / 40, size.height / 6);
+            const cv::Scalar shade(rng.uniform(0, 256));
+            if (i % 2) {
+                cv::circle(shapes, center, radius, shade, cv::FILLED, cv::LINE_AA);
+            } else {
+                cv::rectangle(shapes, center, center + cv::Point(radius * 2, radius), shade, cv::FILLED);
+            }
+        }
+        cv::Mat noise(size, CV_16SC1);
+        rng.fill(noise, cv::RNG::NORMAL, 0, 4);
+        cv::add(shapes, noise, shapes, cv::noArray(), CV_8U);
+        addSyntheticFrame(corpus, "shapes", shapes, seed++);
+
+        addSyntheticFrame(corpus, "texture", syntheticGray(size.width, size.height), seed++);
+
+        cv::Mat lines(size, CV_8UC1, cv::Scalar(200));
+        for (int i = 0; i < 80; i++) {
+            const cv::Point from(rng.uniform(0, size.width), rng.uniform(0, size.height));
+            const cv::Point to(rng.uniform(0, size.width), rng.uniform(0, size.height));
+            cv::line(lines, from, to, cv::Scalar(rng.uniform(0, 120)), rng.uniform(1, 4), cv::LINE_AA);
+        }
+        addSyntheticFrame(corpus, "lines", lines, seed++);
+
+        cv::Mat dim;
+        shapes.convertTo(dim, CV_8U, 0.25, 8);
+        rng.fill(noise, cv::RNG::NORMAL, 0, 10);
+        cv::add(dim, noise, dim, cv::noArray(), CV_8U);
+        addSyntheticFrame(corpus, "lowlight", dim, seed++);
+    }
+}
+
+bool loadCorpusDir(const std::string& dir, std::vector<CorpusFrame>& corpus) {
+    DIR* handle = opendir(dir.c_str());
+    if (!handle) {
+        std::perror(dir.c_str());
+        return false;
+    }
+    std::vector<std::string> names;
+    while (dirent* entry = readdir(handle)) {
+        const std::string name = entry->d_name;
+        if (name.size() > 5 && name.compare(name.size() - 5, 5, ".nv21") == 0) {
+            names.push_back(name);
+        }
+    }
+    closedir(handle);
+    std::sort(names.begin(), names.end());
+    bool ok = true;
+    for (const std::string& name : names) {
+        int width = 0;
+        int height = 0;
+        const size_t sizeAt = name.rfind('_');
+        if (sizeAt == std::string::npos ||
+            std::sscanf(name.c_str() + sizeAt + 1, "%dx%d", &width, &height) != 2 ||
+            width <= 0 || height <= 0 || height % 2) {
+            std::fprintf(stderr, "%s: expected <name>_<W>x<H>.nv21\n", name.c_str());
+            ok = false;
+            continue;
+        }
+        CorpusFrame frame;
+        frame.name = name.substr(0, name.size() - 5);
+        frame.nv21.create(height + height / 2, width, CV_8UC1);
+        FILE* file = std::fopen((dir + "/" + name).c_str(), "rb");
+        if (!file || std::fread(frame.nv21.data, frame.nv21.total(), 1, file) != 1) {
+            std::fprintf(stderr, "%s: short or unreadable frame\n", name.c_str());
+            ok = false;
+        } else {
+            frame.luma = frame.nv21.rowRange(0, height);
+            corpus.push_back(frame);
+        }
+        if (file) {
+            std::fclose(file);
+        }
+    }
+    return ok;
+}
+
+void computeReference(const CorpusFrame& frame, Reference reference, cv::Mat& edges) {
+    int low = 0;
+    int high = 0;
+    currentCannyThresholds(low, high);
+    switch (reference) {
+        case Reference::CANNY:
+            cv::Canny(frame.luma, edges, low, high);
+            break;
+        case Reference::BLUR_CANNY: {
+            cv::Mat blurred;
+            cv::GaussianBlur(frame.luma, blurred, cv::Size(5, 5), 0);
+            cv::Canny(blurred, edges, low, high);
+            break;
+        }
+        case Reference::BGR_GRAY_CANNY: {
+            cv::Mat bgr;
+            cv::Mat gray;
+            cv::cvtColor(frame.nv21, bgr, cv::COLOR_YUV2BGR_NV21);
+            cv::cvtColor(bgr, gray, cv::COLOR_BGR2GRAY);
+            cv::Canny(gray, edges, low, high);
+            break;
+        }
+    }
+}
+
+bool goldenEdges(const Options& options, const CorpusFrame& frame, Reference reference, cv::Mat& edges) {
+    if (options.goldenDir.empty()) {
+        computeReference(frame, reference, edges);
+        return true;
+    }
+    const std::string path = options.goldenDir + "/" + frame.name + "." + referenceName(reference) + ".pgm";
+    if (options.updateGolden) {
+        computeReference(frame, reference, edges);
+        return cv::imwrite(path, edges);
+    }
+    edges = cv::imread(path, cv::IMREAD_GRAYSCALE);
+    if (edges.size() != frame.luma.size()) {
+        std::fprintf(stderr, "%s: missing or wrong size (run with --update-golden)\n", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+// F-score of edges against golden, where an edge pixel counts as matched
+// when the other map has one within one pixel (8-neighbourhood). Both maps
+// empty scores 1.
+double toleranceFScore(const cv::Mat& edges, const cv::Mat& golden) {
+    const cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(3, 3));
+    cv::Mat grownEdges;
+    cv::Mat grownGolden;
+    cv::dilate(edges, grownEdges, kernel);
+    cv::dilate(golden, grownGolden, kernel);
+    const double detected = cv::countNonZero(edges);
+    const double expected = cv::countNonZero(golden);
+    if (detected == 0 && expected == 0) {
+        return 1.0;
+    }
+    if (detected == 0 || expected == 0) {
+        return 0.0;
+    }
+    cv::Mat matched;
+    cv::bitwise_and(edges, grownGolden, matched);
+    const double precision = cv::countNonZero(matched) / detected;
+    cv::bitwise_and(golden, grownEdges, matched);
+    const double recall = cv::countNonZero(matched) / expected;
+    return precision + recall > 0 ? 2 * precision * recall / (precision + recall) : 0.0;
+}
+
+double percentile(std::vector<double> samples, double quantile) {
+    if (samples.empty()) {
+        return 0;
+    }
+    const size_t rank = std::min(samples.size() - 1, static_cast<size_t>(quantile * samples.size()));
+    std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+    return samples[rank];
+}
+
+// "<backend> <p95 micros>" per line; '#' starts a comment
+std::map<std::string, double> readBaseline(const std::string& path, bool& ok) {
+    std::map<std::string, double> baseline;
+    FILE* file = std::fopen(path.c_str(), "r");
+    ok = file != nullptr;
+    if (!file) {
+        std::perror(path.c_str());
+        return baseline;
+    }
+    char line[256];
+    while (std::fgets(line, sizeof(line), file)) {
+        char name[128];
+        double micros = 0;
+        if (line[0] != '#' && std::sscanf(line, "%127s %lf", name, &micros) == 2) {
+            baseline[name] = micros;
+        }
+    }
+    std::fclose(file);
+    return baseline;
+}
+
+std::vector<Backend> backends() {
+    int low = 0;
+    int high = 0;
+    currentCannyThresholds(low, high);
+    auto pinned = [](CannyBackend backend) {
+        return [backend](const CorpusFrame& frame, cv::Mat& edges) {
+            setCannyBackend(backend);
+            detectEdges(frame.luma, edges);
+        };
+    };
+    // cannyU8 and cannyU8Tiled promise cv::Canny's map, so they get almost no
+    // slack; the approximations get what their documentation admits
+    return {
+        {"opencv", Reference::CANNY, 0.999, pinned(CannyBackend::OPENCV)},
+        {"kernel", Reference::CANNY, 0.995, pinned(CannyBackend::KERNEL)},
+        {"tiled", Reference::CANNY, 0.995, pinned(CannyBackend::TILED)},
+        {"bounded", Reference::CANNY, 0.98, pinned(CannyBackend::BOUNDED)},
+        {"maxima", Reference::CANNY, 0.995,
+         [low, high](const CorpusFrame& frame, cv::Mat& edges) {
+             cv::Mat maxima;
+             cannyU8Maxima(frame.luma, maxima);
+             cannyU8FromMaxima(maxima, edges, low, high);
+         }},
+        {"kernel_preblur", Reference::BLUR_CANNY, 0.97,
+         [low, high](const CorpusFrame& frame, cv::Mat& edges) { cannyU8(frame.luma, edges, low, high, true); }},
+        {"luma_fast_path", Reference::BGR_GRAY_CANNY, 0.80, pinned(CannyBackend::KERNEL)},
+        {"gradient", Reference::CANNY, 0.35,
+         [](const CorpusFrame& frame, cv::Mat& edges) { detectGradientEdges(frame.luma, edges); }},
+    };
+}
+
+// Name of the first kernel of kernels whose output differs from scalar's on
+// frame, or null. Rows are also run 3 pixels short of the frame, so the
+// vector loops' remainders are covered.
+const char* kernelMismatch(const EdgeKernels& kernels, const EdgeKernels& scalar, const CorpusFrame& frame) {
+    const cv::Mat& luma = frame.luma;
+    const int height = luma.rows;
+    std::vector<int16_t> expected(luma.cols * 3);
+    std::vector<int16_t> actual(luma.cols * 3);
+    std::vector<uint8_t> expectedBytes(luma.cols * 3);
+    std::vector<uint8_t> actualBytes(luma.cols * 3);
+    std::vector<uint8_t> u(luma.cols / 2 + 1);
+    std::vector<uint8_t> v(luma.cols / 2 + 1);
+    std::vector<uint16_t> words(luma.cols);
+    cv::Mat binary;
+    cv::threshold(luma, binary, 128, 255, cv::THRESH_BINARY);
+    for (int width : {luma.cols, luma.cols - 3}) {
+        const int rowBytes = (width + 7) / 8;
+        for (int y = 1; y + 1 < height; y++) {
+            const uint8_t* r0 = luma.ptr(y - 1);
+            const uint8_t* r1 = luma.ptr(y);
+            const uint8_t* r2 = luma.ptr(y + 1);
+            scalar.gradientRow(r0, r1, r2, width, expected.data(), expected.data() + width,
+                               expected.data() + 2 * width);
+            kernels.gradientRow(r0, r1, r2, width, actual.data(), actual.data() + width, actual.data() + 2 * width);
+            if (std::memcmp(expected.data(), actual.data(), 3 * width * sizeof(int16_t)) != 0) {
+                return "gradient";
+            }
+            scalar.gradientThresholdRow(r0, r1, r2, width, 150, expectedBytes.data());
+            kernels.gradientThresholdRow(r0, r1, r2, width, 150, actualBytes.data());
+            if (std::memcmp(expectedBytes.data(), actualBytes.data(), width) != 0) {
+                return "gradient_threshold";
+            }
+            scalar.packRow(binary.ptr(y), width, expectedBytes.data(), rowBytes);
+            kernels.packRow(binary.ptr(y), width, actualBytes.data(), rowBytes);
+            if (std::memcmp(expectedBytes.data(), actualBytes.data(), rowBytes) != 0) {
+                return "pack";
+            }
+            // NV21's interleaved VU row as the planes the converter takes
+            const uint8_t* vu = frame.nv21.ptr(height + y / 2);
+            for (int x = 0; x < luma.cols / 2; x++) {
+                v[x] = vu[2 * x];
+                u[x] = vu[2 * x + 1];
+            }
+            scalar.planarToBgrRow(r1, u.data(), v.data(), width, expectedBytes.data());
+            kernels.planarToBgrRow(r1, u.data(), v.data(), width, actualBytes.data());
+            if (std::memcmp(expectedBytes.data(), actualBytes.data(), 3 * width) != 0) {
+                return "planar_bgr";
+            }
+            // The same rows widened to P010 words, low bits set as a sensor's
+            // 10-bit samples would set them
+            for (int x = 0; x < width; x++) {
+                words[x] = static_cast<uint16_t>(r1[x] << 8 | (x * 37 & 0xc0));
+            }
+            scalar.p010LumaRow(words.data(), width, expectedBytes.data(), expected.data());
+            kernels.p010LumaRow(words.data(), width, actualBytes.data(), actual.data());
+            if (std::memcmp(expectedBytes.data(), actualBytes.data(), width) != 0 ||
+                std::memcmp(expected.data(), actual.data(), width * sizeof(int16_t)) != 0) {
+                return "p010_luma";
+            }
+            for (int x = 0; x < width / 2; x++) {
+                words[2 * x] = static_cast<uint16_t>(u[x] << 8 | (x * 53 & 0xc0));
+                words[2 * x + 1] = static_cast<uint16_t>(v[x] << 8);
+            }
+            scalar.p010ChromaRow(words.data(), width / 2, expectedBytes.data());
+            kernels.p010ChromaRow(words.data(), width / 2, actualBytes.data());
+            if (std::memcmp(expectedBytes.data(), actualBytes.data(), 2 * (width / 2)) != 0) {
+                return "p010_chroma";
+            }
+            // r1 as both rows of a RAW16 mosaic; each output bins a 2x2 quad
+            for (int x = 0; x < width; x++) {
+                words[x] = static_cast<uint16_t>(r1[x] << 2 | (x & 3));
+            }
+            const uint16_t* rawRow = words.data();
+            scalar.bayerBinRow16(rawRow, rawRow, width / 2, 4, expectedBytes.data());
+            kernels.bayerBinRow16(rawRow, rawRow, width / 2, 4, actualBytes.data());
+            if (std::memcmp(expectedBytes.data(), actualBytes.data(), width / 2) != 0) {
+                return "bayer_bin_raw16";
+            }
+            // Their bytes as packed RAW10 rows, which take 5 bytes per 4 samples
+            const uint8_t* packed = reinterpret_cast<const uint8_t*>(rawRow);
+            const int packedWidth = width & ~3;
+            scalar.bayerBinRowRaw10(packed, packed + 3, packedWidth / 2, expectedBytes.data());
+            kernels.bayerBinRowRaw10(packed, packed + 3, packedWidth / 2, actualBytes.data());
+            if (std::memcmp(expectedBytes.data(), actualBytes.data(), packedWidth / 2) != 0) {
+                return "bayer_bin_raw10";
+            }
+        }
+    }
+    // A quarter turn's worth of 8x8 blocks, 1- and 3-byte pixels
+    cv::Mat bgr;
+    cv::cvtColor(luma, bgr, cv::COLOR_GRAY2BGR);
+    cv::Mat expectedBlocks(luma.cols, luma.rows, CV_8UC3);
+    cv::Mat actualBlocks(luma.cols, luma.rows, CV_8UC3);
+    for (int channels : {1, 3}) {
+        const cv::Mat& source = channels == 1 ? luma : bgr;
+        for (int y = 0; y + 8 <= source.rows; y += 8) {
+            for (int x = 0; x + 8 <= source.cols; x += 8) {
+                const uint8_t* block = source.ptr(y) + x * channels;
+                uint8_t* expectedBlock = expectedBlocks.ptr(x) + y * channels;
+                uint8_t* actualBlock = actualBlocks.ptr(x) + y * channels;
+                if (channels == 1) {
+                    scalar.transposeBlockC1(block, source.step, expectedBlock, expectedBlocks.step);
+                    kernels.transposeBlockC1(block, source.step, actualBlock, actualBlocks.step);
+                } else {
+                    scalar.transposeBlockC3(block, source.step, expectedBlock, expectedBlocks.step);
+                    kernels.transposeBlockC3(block, source.step, actualBlock, actualBlocks.step);
+                }
+                for (int i = 0; i < 8; i++) {
+                    if (std::memcmp(expectedBlock + i * expectedBlocks.step, actualBlock + i * actualBlocks.step,
+                                    8 * channels) != 0) {
+                        return channels == 1 ? "transpose_c1" : "transpose_c3";
+                    }
+                }
+            }
+        }
+    }
+    // Each row's first 32 bytes as a descriptor against every other row's
+    if (luma.cols >= 32) {
+        std::vector<int32_t> rows(height);
+        for (int y = 0; y < height; y++) {
+            rows[y] = y;
+        }
+        std::vector<uint16_t> expectedDistances(height);
+        std::vector<uint16_t> actualDistances(height);
+        for (int y = 0; y < height; y += 7) {
+            scalar.hammingDistances(luma.ptr(y), luma.data, luma.step, rows.data(), height, expectedDistances.data());
+            kernels.hammingDistances(luma.ptr(y), luma.data, luma.step, rows.data(), height, actualDistances.data());
+            if (expectedDistances != actualDistances) {
+                return "hamming";
+            }
+        }
+    }
+    return nullptr;
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--baseline" && hasValue) {
+            options.baselinePath = argv[++i];
+        } else if (arg == "--write-baseline" && hasValue) {
+            options.writeBaselinePath = argv[++i];
+        } else if (arg == "--golden" && hasValue) {
+            options.goldenDir = argv[++i];
+        } else if (arg == "--corpus" && hasValue) {
+            options.corpusDir = argv[++i];
+        } else if (arg == "--max-regression" && hasValue) {
+            options.maxRegression = std::atof(argv[++i]);
+        } else if (arg == "--runs" && hasValue) {
+            options.runs = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--update-golden") {
+            options.updateGolden = true;
+        } else {
+            return false;
+        }
+    }
+    return !options.updateGolden || !options.goldenDir.empty();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::fprintf(stderr,
+                     "usage: %s [--baseline FILE] [--write-baseline FILE] [--max-regression 0.10]\n"
+                     "          [--runs 20] [--golden DIR [--update-golden]] [--corpus DIR]\n",
+                     argv[0]);
+        return 2;
+    }
+    setAdaptiveThresholds(false);
+    setEdgePreBlur(false);
+
+    std::vector<CorpusFrame> corpus;
+    buildSyntheticCorpus(corpus);
+    bool passed = options.corpusDir.empty() || loadCorpusDir(options.corpusDir, corpus);
+
+    bool baselineOk = true;
+    const std::map<std::string, double> baseline =
+        options.baselinePath.empty() ? std::map<std::string, double>() : readBaseline(options.baselinePath, baselineOk);
+    passed = passed && baselineOk;
+
+    FILE* baselineOut = nullptr;
+    if (!options.writeBaselinePath.empty()) {
+        baselineOut = std::fopen(options.writeBaselinePath.c_str(), "w");
+        if (!baselineOut) {
+            std::perror(options.writeBaselinePath.c_str());
+            return 1;
+        }
+        std::fprintf(baselineOut, "# edge_regress p95 micros per backend over %zu frames\n", corpus.size());
+    }
+
+    const EdgeKernels& scalarKernels = *kernelsFor(IsaLevel::SCALAR);
+    for (int level = static_cast<int>(IsaLevel::SCALAR) + 1; level <= static_cast<int>(IsaLevel::AVX2); level++) {
+        const EdgeKernels* kernels = kernelsFor(static_cast<IsaLevel>(level));
+        if (!kernels) {
+            continue;
+        }
+        std::string verdict = "ok";
+        for (const CorpusFrame& frame : corpus) {
+            if (const char* kernel = kernelMismatch(*kernels, scalarKernels, frame)) {
+                verdict = std::string(kernel) + " differs from scalar on " + frame.name;
+                passed = false;
+                break;
+            }
+        }
+        std::printf("kernels %-16s %s\n", isaLevelName(kernels->level), verdict.c_str());
+    }
+
+    std::printf("%-16s %-15s %8s %8s %10s %10s %10s  %s\n", "backend", "golden", "min F", "mean F", "p50 us",
+                "p95 us", "base us", "result");
+    const int kWarmupRuns = 3;
+    for (const Backend& backend : backends()) {
+        double minF = 1.0;
+        double sumF = 0;
+        std::string worstFrame;
+        std::vector<double> samples;
+        cv::Mat edges;
+        cv::Mat golden;
+        for (const CorpusFrame& frame : corpus) {
+            if (!goldenEdges(options, frame, backend.reference, golden)) {
+                passed = false;
+                continue;
+            }
+            for (int run = 0; run < kWarmupRuns; run++) {
+                backend.run(frame, edges);
+            }
+            for (int run = 0; run < options.runs; run++) {
+                const auto start = std::chrono::steady_clock::now();
+                backend.run(frame, edges);
+                const auto end = std::chrono::steady_clock::now();
+                samples.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+            }
+            const double f = toleranceFScore(edges, golden);
+            sumF += f;
+            if (f < minF) {
+                minF = f;
+                worstFrame = frame.name;
+            }
+        }
+        const double p50 = percentile(samples, 0.50);
+        const double p95 = percentile(samples, 0.95);
+        const bool accurate = minF >= backend.minFScore;
+        const auto base = baseline.find(backend.name);
+        const bool hasBase = base != baseline.end();
+        const bool fast = !hasBase || p95 <= base->second * (1.0 + options.maxRegression);
+        passed = passed && accurate && fast;
+
+        char baseText[16] = "-";
+        if (hasBase) {
+            std::snprintf(baseText, sizeof(baseText), "%.0f", base->second);
+        }
+        std::string verdict = accurate && fast ? "ok" : "";
+        if (!accurate) {
+            verdict += "F below " + std::to_string(backend.minFScore).substr(0, 5) + " on " + worstFrame;
+        }
+        if (!fast) {
+            verdict += std::string(verdict.empty() ? "" : "; ") + "p95 regressed";
+        }
+        std::printf("%-16s %-15s %8.4f %8.4f %10.0f %10.0f %10s  %s\n", backend.name,
+                    referenceName(backend.reference), minF, corpus.empty() ? 0.0 : sumF / corpus.size(), p50, p95,
+                    baseText, verdict.c_str());
+        if (baselineOut) {
+            std::fprintf(baselineOut, "%s %.1f\n", backend.name, p95);
+        }
+    }
+    setCannyBackend(CannyBackend::AUTO);
+    if (baselineOut) {
+        std::fclose(baselineOut);
+    }
+    std::printf("%s (%zu frames, %d timed runs each, p95 budget +%.0f%%)\n", passed ? "PASS" : "FAIL",
+                corpus.size(), options.runs, options.maxRegression * 100);
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,323 @@
+// Per-stage benchmarks of the live path, each reporting the heap allocations
+// and bytes it makes per frame (alloc_counter.h) next to its time. After the
+// first frame has sized the outputs every stage should report 0 allocs/iter;
+// with EDGE_BENCH_REQUIRE_ZERO_ALLOCS=1 in the environment a stage that does
+// not is reported as an error, e.g. for
+//
+//   edge_bench --benchmark_filter=Stage --benchmark_format=json | grep error_occurred
+
+#include "alloc_counter.h"
+#include "band_executor.h"
+#include "bench_frames.h"
+#include "bench_report.h"
+#include "edge_points.h"
+#include "gradient_edges.h"
+#include "image_processor.h"
+#include "yuv_convert.h"
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+bool requireZeroAllocations() {
+    const char* value = std::getenv("EDGE_BENCH_REQUIRE_ZERO_ALLOCS");
+    return value && std::strcmp(value, "0") != 0;
+}
+
+// stage runs once untimed so outputs, kernels and worker threads exist, then
+// every timed iteration's allocations are counted around the call alone
+template <typename Stage>
+void runStage(benchmark::State& state, int width, int height, Stage&& stage) {
+    installCountingMatAllocator();
+    stage();
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+    for (auto _ : state) {
+        const AllocationCounts before = allocationCounts();
+        stage();
+        const AllocationCounts after = allocationCounts();
+        allocations += after.allocations - before.allocations;
+        bytes += after.bytes - before.bytes;
+    }
+    setFrameCounters(state, width, height);
+    state.counters["allocs/iter"] = benchmark::Counter(static_cast<double>(allocations), benchmark::Counter::kAvgIterations);
+    state.counters["bytes/iter"] = benchmark::Counter(static_cast<double>(bytes), benchmark::Counter::kAvgIterations);
+    if (allocations > 0 && requireZeroAllocations()) {
+        state.SkipWithError("stage allocates per frame");
+    }
+}
+
+void BM_StageNv21ToBgr(benchmark::State& state) {
+    const int width = static_cast<int>(state.range(0));
+    const int height = static_cast<int>(state.range(1));
+    const cv::Mat nv21 = syntheticNv21(width, height);
+    const YuvPlanes planes = nv21Planes(nv21, width, height);
+    cv::Mat bgr;
+    runStage(state, width, height, [&] {
+        convertYuvPlanesToBgr(planes, bgr);
+        benchmark::DoNotOptimize(bgr.data);
+    });
+}
+
+// 270 degrees (portrait capture): conversion, then cv::rotate of the full frame
+void BM_StageNv21ToBgrRotate(benchmark::State& state) {
+    const int width = static_cast<int>(state.range(0));
+    const int height = static_cast<int>(state.range(1));
+    const cv::Mat nv21 = syntheticNv21(width, height);
+    const cv::Mat luma = nv21.rowRange(0, height);
+    const cv::Mat chroma(height / 2, width / 2, CV_8UC2, const_cast<uint8_t*>(nv21.ptr<uint8_t>(height)));
+    cv::Mat bgr;
+    cv::Mat upright;
+    runStage(state, width, height, [&] {
+        cv::cvtColorTwoPlane(luma, chroma, bgr, cv::COLOR_YUV2BGR_NV21);
+        cv::rotate(bgr, upright, cv::ROTATE_90_COUNTERCLOCKWISE);
+        benchmark::DoNotOptimize(upright.data);
+    });
+}
+
+// The same in one tiled pass (convertNv21ToBgrRotated)
+void BM_StageNv21ToBgrRotated(benchmark::State& state) {
+    const int width = static_cast<int>(state.range(0));
+    const int height = static_cast<int>(state.range(1));
+    const cv::Mat nv21 = syntheticNv21(width, height);
+    const cv::Mat luma = nv21.rowRange(0, height);
+    const cv::Mat chroma(height / 2, width / 2, CV_8UC2, const_cast<uint8_t*>(nv21.ptr<uint8_t>(height)));
+    cv::Mat upright;
+    runStage(state, width, height, [&] {
+        convertNv21ToBgrRotated(luma, chroma, 270, upright);
+        benchmark::DoNotOptimize(upright.data);
+    });
+}
+
+void BM_StageBgrToGray(benchmark::State& state) {
+    const int width = static_cast<int>(state.range(0));
+    const int height = static_cast<int>(state.range(1));
+    const cv::Mat bgr = syntheticBgr(width, height);
+    cv::Mat gray;
+    runStage(state, width, height, [&] {
+        cv::cvtColor(bgr, gray, cv::COLOR_BGR2GRAY);
+        benchmark::DoNotOptimize(gray.data);
+    });
+}
+
+// detectEdges with the backend it calibrates to on this machine
+void BM_StageCanny(benchmark::State& state) {
+    const int width = static_cast<int>(state.range(0));
+    const int height = static_cast<int>(state.range(1));
+    const cv::Mat gray = syntheticGray(width, height);
+    cv::Mat edges;
+    runStage(state, width, height, [&] {
+        detectEdges(gray, edges);
+        benchmark::DoNotOptimize(edges.data);
+    });
+}
+
+// FAST_EDGES at Canny's default high threshold, 8-bit (arg 2 = 0) or straight
+// to the 1-bpp bitmap (1); compare with BM_StageCanny
+void BM_StageFastEdges(benchmark::State& state) {
+    const int width = static_cast<int>(state.range(0));
+    const int height = static_cast<int>(state.range(1));
+    const bool packed = state.range(2) != 0;
+    const cv::Mat gray = syntheticGray(width, height);
+    cv::Mat edges;
+    runStage(state, width, height, [&] {
+        if (packed) {
+            gradientEdgesPacked(gray, edges, 200);
+        } else {
+            gradientEdgesU8(gray, edges, 200);
+        }
+        benchmark::DoNotOptimize(edges.data);
+    });
+}
+
+// The Canny map of the synthetic frame compacted to (x, y) pairs
+void BM_StageEdgePoints(benchmark::State& state) {
+    const int width = static_cast<int>(state.range(0));
+    const int height = static_cast<int>(state.range(1));
+    cv::Mat edges;
+    detectEdges(syntheticGray(width, height), edges);
+    std::vector<uint16_t> storage(static_cast<size_t>(width) * height * 2);
+    EdgePointSink sink;
+    sink.points = storage.data();
+    sink.capacity = width * height;
+    runStage(state, width, height, [&] {
+        compactEdgePoints(edges, sink);
+        benchmark::DoNotOptimize(sink.count);
+    });
+    state.counters["points"] = sink.count;
+}
+
+void BM_StageGrayToBgr(benchmark::State& state) {
+    const int width = static_cast<int>(state.range(0));
+    const int height = static_cast<int>(state.range(1));
+    const cv::Mat gray = syntheticGray(width, height);
+    cv::Mat bgr;
+    runStage(state, width, height, [&] {
+        cv::cvtColor(gray, bgr, cv::COLOR_GRAY2BGR);
+        benchmark::DoNotOptimize(bgr.data);
+    });
+}
+
+void BM_StageBgrToRgba(benchmark::State& state) {
+    const int width = static_cast<int>(state.range(0));
+    const int height = static_cast<int>(state.range(1));
+    const cv::Mat bgr = syntheticBgr(width, height);
+    cv::Mat rgba;
+    runStage(state, width, height, [&] {
+        cv::cvtColor(bgr, rgba, cv::COLOR_BGR2RGBA);
+        benchmark::DoNotOptimize(rgba.data);
+    });
+}
+
+// Half-size luma with INTER_AREA, as the downscaled edge path does
+void BM_StageResize(benchmark::State& state) {
+    const int width = static_cast<int>(state.range(0));
+    const int height = static_cast<int>(state.range(1));
+    const cv::Mat gray = syntheticGray(width, height);
+    cv::Mat scaled;
+    runStage(state, width, height, [&] {
+        cv::resize(gray, scaled, cv::Size(width / 2, height / 2), 0, 0, cv::INTER_AREA);
+        benchmark::DoNotOptimize(scaled.data);
+    });
+}
+
+// Last-level cache misses of this thread and the threads it starts, the
+// closest proxy for DRAM traffic a process can read; invalid where the
+// kernel refuses perf events (perf_event_paranoid, SELinux on most phones)
+class CacheMissCounter {
+public:
+    CacheMissCounter() {
+#ifdef __linux__
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+    }
+    ~CacheMissCounter() {
+#ifdef __linux__
+        if (fd >= 0) {
+            close(fd);
+        }
+#endif
+    }
+    bool valid() const { return fd >= 0; }
+    void start() {
+#ifdef __linux__
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+    uint64_t stop() {
+        uint64_t count = 0;
+#ifdef __linux__
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(fd, &count, sizeof(count)) != sizeof(count)) {
+                count = 0;
+            }
+        }
+#endif
+        return count;
+    }
+
+private:
+    int fd = -1;
+};
+
+// The convert -> gray -> blur -> gradient chain stage by stage (staged) or
+// through the band executor (fused), keeping BGR and gray as the legacy path
+// does (arg 2 = 1) or only the gradient (0). Reports the DRAM bytes per frame
+// BandExecutor::traffic estimates for the way it ran, and the measured
+// last-level cache misses per frame where perf events are readable; the
+// fused rows (arg 3 = 1) should show both falling against the staged ones.
+void runChain(benchmark::State& state, bool fused) {
+    const int width = static_cast<int>(state.range(0));
+    const int height = static_cast<int>(state.range(1));
+    const bool keep = state.range(2) != 0;
+    const cv::Mat nv21 = syntheticNv21(width, height);
+    const cv::Mat luma = nv21.rowRange(0, height);
+    const cv::Mat chroma(height / 2, width / 2, CV_8UC2, const_cast<uint8_t*>(nv21.ptr<uint8_t>(height)));
+
+    BandExecutor chain;
+    auto* nv21Stage = new Nv21ToBgrStage;
+    nv21Stage->setChroma(chroma);
+    chain.addStage(std::unique_ptr<BandStage>(nv21Stage));
+    chain.addStage(std::unique_ptr<BandStage>(new BgrToGrayStage));
+    chain.addStage(std::unique_ptr<BandStage>(new GaussianBandStage));
+    chain.addStage(std::unique_ptr<BandStage>(new GradientBandStage));
+    BandExecutor gradientOnly;  // one stage: a plain parallel sweep
+    gradientOnly.addStage(std::unique_ptr<BandStage>(new GradientBandStage));
+
+    cv::Mat bgr(height, width, CV_8UC3);
+    cv::Mat gray(height, width, CV_8UC1);
+    cv::Mat blurred(height, width, CV_8UC1);
+    cv::Mat gradient(height, width, CV_16SC1);
+    const std::vector<cv::Mat*> outputs = {keep ? &bgr : nullptr, keep ? &gray : nullptr, nullptr, &gradient};
+    auto frame = [&] {
+        if (fused) {
+            chain.run(luma, outputs);
+        } else {
+            cv::cvtColorTwoPlane(luma, chroma, bgr, cv::COLOR_YUV2BGR_NV21);
+            cv::cvtColor(bgr, gray, cv::COLOR_BGR2GRAY);
+            cv::GaussianBlur(gray, blurred, cv::Size(5, 5), 0, 0, cv::BORDER_REPLICATE);
+            gradientOnly.run(blurred, {&gradient});
+        }
+        benchmark::DoNotOptimize(gradient.data);
+    };
+    frame();
+
+    CacheMissCounter misses;
+    uint64_t missCount = 0;
+    for (auto _ : state) {
+        misses.start();
+        frame();
+        missCount += misses.stop();
+    }
+    setFrameCounters(state, width, height);
+    const BandExecutor::Traffic traffic = chain.traffic(cv::Size(width, height), CV_8UC1, {keep, keep, false, true});
+    state.counters["dram_est_bytes"] = static_cast<double>(fused ? traffic.fused : traffic.staged);
+    state.counters["band_rows"] = chain.bandRows(cv::Size(width, height), CV_8UC1);
+    if (misses.valid()) {
+        state.counters["llc_misses/iter"] =
+                benchmark::Counter(static_cast<double>(missCount), benchmark::Counter::kAvgIterations);
+    }
+}
+
+void BM_StageChain(benchmark::State& state) {
+    runChain(state, state.range(3) != 0);
+}
+
+} // namespace
+
+BENCHMARK(BM_StageNv21ToBgr)->Apply(frameSizes);
+BENCHMARK(BM_StageNv21ToBgrRotate)->Apply(frameSizes);
+BENCHMARK(BM_StageNv21ToBgrRotated)->Apply(frameSizes);
+BENCHMARK(BM_StageBgrToGray)->Apply(frameSizes);
+BENCHMARK(BM_StageCanny)->Apply(frameSizes);
+BENCHMARK(BM_StageFastEdges)->Args({640, 480, 0})->Args({1280, 720, 0})->Args({1920, 1080, 0})
+        ->Args({1920, 1080, 1});
+BENCHMARK(BM_StageEdgePoints)->Apply(frameSizes);
+BENCHMARK(BM_StageGrayToBgr)->Apply(frameSizes);
+BENCHMARK(BM_StageBgrToRgba)->Apply(frameSizes);
+BENCHMARK(BM_StageResize)->Apply(frameSizes);
+// width, height, keep BGR and gray, fused
+BENCHMARK(BM_StageChain)->Args({1280, 720, 1, 0})->Args({1280, 720, 1, 1})->Args({1920, 1080, 1, 0})
+        ->Args({1920, 1080, 1, 1})->Args({1920, 1080, 0, 0})->Args({1920, 1080, 0, 1})
+        ->Unit(benchmark::kMicrosecond);
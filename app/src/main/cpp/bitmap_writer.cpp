@@ -0,0 +1,205 @@
+#include "bitmap_writer.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#define LOG_TAG "BitmapWriter"
+#include "logging.h"
+
+namespace {
+
+struct Rgb {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+};
+
+inline uint8_t clampByte(int value) {
+    return static_cast<uint8_t>(std::min(255, std::max(0, value)));
+}
+
+// Samplers: the source pixel at (x, y) as RGB
+
+struct GraySampler {
+    const uchar* data;
+    size_t step;
+    Rgb operator()(int x, int y) const {
+        const uint8_t v = data[y * step + x];
+        return Rgb{v, v, v};
+    }
+};
+
+struct PackedSampler {
+    const uchar* data;
+    size_t step;
+    Rgb operator()(int x, int y) const {
+        const uint8_t v = (data[y * step + (x >> 3)] >> (x & 7)) & 1 ? 255 : 0;
+        return Rgb{v, v, v};
+    }
+};
+
+struct BgrSampler {
+    const uchar* data;
+    size_t step;
+    Rgb operator()(int x, int y) const {
+        const uchar* p = data + y * step + x * 3;
+        return Rgb{p[2], p[1], p[0]};
+    }
+};
+
+struct RgbaSampler {
+    const uchar* data;
+    size_t step;
+    Rgb operator()(int x, int y) const {
+        const uchar* p = data + y * step + x * 4;
+        return Rgb{p[0], p[1], p[2]};
+    }
+};
+
+// BT.601 limited range, as cv::COLOR_YUV2RGB_NV21
+struct Nv21Sampler {
+    const uchar* luma;
+    size_t lumaStep;
+    const uchar* chroma;
+    size_t chromaStep;
+    Rgb operator()(int x, int y) const {
+        const int c = std::max(0, luma[y * lumaStep + x] - 16) * 298;
+        const uchar* vu = chroma + (y >> 1) * chromaStep + (x >> 1) * 2;
+        const int e = vu[0] - 128;
+        const int d = vu[1] - 128;
+        return Rgb{clampByte((c + 409 * e + 128) >> 8), clampByte((c - 100 * d - 208 * e + 128) >> 8),
+                   clampByte((c + 516 * d + 128) >> 8)};
+    }
+};
+
+// Stores: one destination pixel
+
+struct StoreRgba {
+    static const int kBytes = 4;
+    static void put(uchar* p, const Rgb& c) {
+        p[0] = c.r;
+        p[1] = c.g;
+        p[2] = c.b;
+        p[3] = 255;
+    }
+};
+
+struct StoreRgb565 {
+    static const int kBytes = 2;
+    static void put(uchar* p, const Rgb& c) {
+        const uint16_t v = static_cast<uint16_t>((c.r >> 3) << 11 | (c.g >> 2) << 5 | c.b >> 3);
+        std::memcpy(p, &v, sizeof(v));
+    }
+};
+
+struct StoreAlpha {
+    static const int kBytes = 1;
+    static void put(uchar* p, const Rgb& c) {
+        *p = static_cast<uchar>((77 * c.r + 150 * c.g + 29 * c.b) >> 8);
+    }
+};
+
+// Source coordinates split into a part that depends on the destination
+// column and one that depends on the row: under any quarter-turn each source
+// axis follows exactly one destination axis, so the per-pixel work is two
+// additions and the sample
+struct SampleGrid {
+    std::vector<int> colX, colY;  // per destination column
+    std::vector<int> rowX, rowY;  // per destination row
+};
+
+SampleGrid sampleGrid(int sourceWidth, int sourceHeight, int rotation, int width, int height) {
+    const bool quarter = rotation == 90 || rotation == 270;
+    const int uprightWidth = quarter ? sourceHeight : sourceWidth;
+    const int uprightHeight = quarter ? sourceWidth : sourceHeight;
+    SampleGrid grid;
+    grid.colX.assign(width, 0);
+    grid.colY.assign(width, 0);
+    grid.rowX.assign(height, 0);
+    grid.rowY.assign(height, 0);
+    for (int x = 0; x < width; x++) {
+        const int u = static_cast<int>((2LL * x + 1) * uprightWidth / (2LL * width));
+        switch (rotation) {
+            case 90:  grid.colY[x] = sourceHeight - 1 - u; break;
+            case 180: grid.colX[x] = sourceWidth - 1 - u; break;
+            case 270: grid.colY[x] = u; break;
+            default:  grid.colX[x] = u; break;
+        }
+    }
+    for (int y = 0; y < height; y++) {
+        const int v = static_cast<int>((2LL * y + 1) * uprightHeight / (2LL * height));
+        switch (rotation) {
+            case 90:  grid.rowX[y] = v; break;
+            case 180: grid.rowY[y] = sourceHeight - 1 - v; break;
+            case 270: grid.rowX[y] = sourceWidth - 1 - v; break;
+            default:  grid.rowY[y] = v; break;
+        }
+    }
+    return grid;
+}
+
+template <typename Store, typename Sampler>
+void writePixels(const Sampler& sample, const SampleGrid& grid, uchar* pixels, int width, int height, int stride) {
+    for (int y = 0; y < height; y++) {
+        uchar* out = pixels + static_cast<size_t>(y) * stride;
+        const int rowX = grid.rowX[y];
+        const int rowY = grid.rowY[y];
+        for (int x = 0; x < width; x++, out += Store::kBytes) {
+            Store::put(out, sample(rowX + grid.colX[x], rowY + grid.colY[x]));
+        }
+    }
+}
+
+template <typename Sampler>
+bool writeFormat(const Sampler& sample, const SampleGrid& grid, BitmapFormat format, uchar* pixels, int width,
+                 int height, int stride) {
+    switch (format) {
+        case BitmapFormat::RGBA_8888:
+            writePixels<StoreRgba>(sample, grid, pixels, width, height, stride);
+            return true;
+        case BitmapFormat::RGB_565:
+            writePixels<StoreRgb565>(sample, grid, pixels, width, height, stride);
+            return true;
+        case BitmapFormat::A_8:
+            writePixels<StoreAlpha>(sample, grid, pixels, width, height, stride);
+            return true;
+    }
+    LOGE("❌ Unsupported bitmap format %d", static_cast<int>(format));
+    return false;
+}
+
+}  // namespace
+
+bool writeBitmap(const BitmapSource& source, BitmapFormat format, void* pixels, int width, int height, int stride) {
+    const cv::Mat& image = source.image;
+    const int sourceWidth = source.packedWidth > 0 ? source.packedWidth : image.cols;
+    if (image.empty() || image.depth() != CV_8U || !pixels || width <= 0 || height <= 0 || sourceWidth <= 0 ||
+        source.rotation % 90 != 0) {
+        return false;
+    }
+    const int rotation = (source.rotation % 360 + 360) % 360;
+    const SampleGrid grid = sampleGrid(sourceWidth, image.rows, rotation, width, height);
+    auto* out = static_cast<uchar*>(pixels);
+    if (source.packedWidth > 0) {
+        return writeFormat(PackedSampler{image.data, image.step}, grid, format, out, width, height, stride);
+    }
+    switch (image.channels()) {
+        case 1:
+            if (!source.chroma.empty()) {
+                if (source.chroma.type() != CV_8UC2 || source.chroma.rows * 2 < image.rows ||
+                    source.chroma.cols * 2 < image.cols) {
+                    return false;
+                }
+                return writeFormat(Nv21Sampler{image.data, image.step, source.chroma.data, source.chroma.step}, grid,
+                                   format, out, width, height, stride);
+            }
+            return writeFormat(GraySampler{image.data, image.step}, grid, format, out, width, height, stride);
+        case 3:
+            return writeFormat(BgrSampler{image.data, image.step}, grid, format, out, width, height, stride);
+        case 4:
+            return writeFormat(RgbaSampler{image.data, image.step}, grid, format, out, width, height, stride);
+        default:
+            return false;
+    }
+}
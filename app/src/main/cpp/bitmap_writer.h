@@ -0,0 +1,30 @@
+#ifndef EDGE_BITMAP_WRITER_H
+#define EDGE_BITMAP_WRITER_H
+
+#include <opencv2/core.hpp>
+
+// Pixel formats writeBitmap produces; the values are AndroidBitmapFormat's,
+// so the core stays free of <android/bitmap.h>
+enum class BitmapFormat : int {
+    RGBA_8888 = 1,
+    RGB_565 = 4,
+    A_8 = 8,      // luminance into the alpha channel (gray, edges as masks)
+};
+
+// A published layer as the writer reads it
+struct BitmapSource {
+    cv::Mat image;         // CV_8UC1 (gray, edges, or NV21 luma with chroma), CV_8UC3 BGR, CV_8UC4 RGBA,
+                           // or a 1-bpp edge bitmap (packed_edges.h) when packedWidth > 0
+    int packedWidth = 0;
+    cv::Mat chroma;        // CV_8UC2 interleaved VU plane of a luma image (NV21), half size; else empty
+    int rotation = 0;      // clockwise degrees to upright, applied on the way (0, 90, 180, 270)
+};
+
+// Writes source, rotated upright and scaled to width x height (stretched;
+// nearest sample at each destination pixel centre), into caller-owned pixels
+// with stride bytes per row. Colour conversion (NV21, BGR, packed bits),
+// rotation, scaling and the format's packing happen in that one pass: no
+// intermediate Mat. False when the source or format is unsupported.
+bool writeBitmap(const BitmapSource& source, BitmapFormat format, void* pixels, int width, int height, int stride);
+
+#endif // EDGE_BITMAP_WRITER_H
@@ -0,0 +1,156 @@
+#include "burst_selector.h"
+#include "frame_pool.h"
+#include <algorithm>
+#include <cstdlib>
+
+#define LOG_TAG "BurstSelector"
+#include "logging.h"
+
+namespace {
+
+// Coarsest box downscale; frames wider than 16 * kBurstScoreWidth are scored
+// at more columns
+const int kMaxBlock = 16;
+
+} // namespace
+
+float burstScore(const cv::Mat& luma, BurstMetric metric) {
+    CV_Assert(luma.type() == CV_8UC1);
+    const int block = std::min(kMaxBlock, std::max(1, (luma.cols + kBurstScoreWidth - 1) / kBurstScoreWidth));
+    const int width = luma.cols / block;
+    const int height = luma.rows / block;
+    if (width < 2 || height < 2) {
+        return 0.0f;
+    }
+    static thread_local std::vector<uint16_t> columns;
+    static thread_local std::vector<int32_t> rows;
+    columns.resize(static_cast<size_t>(width) * block);
+    rows.resize(static_cast<size_t>(width) * 2);
+    const int area = block * block;
+    const int edgeStep = kBurstEdgeStep * area;  // in box-sum units
+
+    uint64_t energy = 0;
+    uint64_t edgePixels = 0;
+    for (int y = 0; y < height; y++) {
+        uint16_t* sum = columns.data();
+        std::fill(columns.begin(), columns.end(), 0);
+        for (int r = 0; r < block; r++) {
+            const uchar* src = luma.ptr<uchar>(y * block + r);
+            for (int x = 0; x < width * block; x++) {
+                sum[x] = static_cast<uint16_t>(sum[x] + src[x]);
+            }
+        }
+        int32_t* current = rows.data() + (y & 1) * width;
+        const int32_t* previous = rows.data() + ((y + 1) & 1) * width;
+        for (int x = 0; x < width; x++) {
+            int32_t box = 0;
+            for (int i = 0; i < block; i++) {
+                box += sum[x * block + i];
+            }
+            current[x] = box;
+        }
+        if (y == 0) {
+            continue;
+        }
+        // Forward differences against the row above; the last column has no dx
+        for (int x = 0; x + 1 < width; x++) {
+            const int32_t dx = current[x + 1] - current[x];
+            const int32_t dy = current[x] - previous[x];
+            if (metric == BurstMetric::GRADIENT_ENERGY) {
+                energy += static_cast<uint64_t>(static_cast<int64_t>(dx) * dx + static_cast<int64_t>(dy) * dy);
+            } else {
+                edgePixels += std::abs(dx) + std::abs(dy) >= edgeStep ? 1 : 0;
+            }
+        }
+    }
+    const double pixels = static_cast<double>(width - 1) * (height - 1);
+    if (metric == BurstMetric::EDGE_DENSITY) {
+        return static_cast<float>(edgePixels / pixels);
+    }
+    return static_cast<float>(energy / (pixels * area * area));
+}
+
+bool BurstSelector::start(int keepFrames, BurstMetric scoreMetric) {
+    if (keepFrames < 1 || keepFrames > kMaxKeep) {
+        LOGE("❌ Burst keeps 1..%d frames, not %d", kMaxKeep, keepFrames);
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    candidates.clear();
+    candidates.reserve(static_cast<size_t>(keepFrames));
+    keep = keepFrames;
+    metric.store(static_cast<int>(scoreMetric), std::memory_order_relaxed);
+    offered = 0;
+    running.store(true, std::memory_order_relaxed);
+    LOGI("🔄 Burst started: best %d by %s", keep,
+         scoreMetric == BurstMetric::EDGE_DENSITY ? "edge density" : "gradient energy");
+    return true;
+}
+
+void BurstSelector::offer(const cv::Mat& nv21, int width, int height, int rotation, int64_t timestampNs) {
+    if (!running.load(std::memory_order_relaxed) || nv21.rows < height + height / 2 || nv21.cols < width) {
+        return;
+    }
+    // Scored before the lock: frames of other threads wait only for copies
+    const float score = burstScore(nv21(cv::Rect(0, 0, width, height)),
+                                   static_cast<BurstMetric>(metric.load(std::memory_order_relaxed)));
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!running.load(std::memory_order_relaxed)) {
+        return;
+    }
+    const uint32_t index = offered++;
+    BurstFrame* slot = nullptr;
+    if (static_cast<int>(candidates.size()) < keep) {
+        candidates.emplace_back();
+        slot = &candidates.back();
+    } else {
+        auto worst = std::min_element(candidates.begin(), candidates.end(),
+                                      [](const BurstFrame& a, const BurstFrame& b) { return a.score < b.score; });
+        if (score <= worst->score) {
+            return;
+        }
+        slot = &*worst;
+        slot->nv21.release();  // idle again, so the pool hands the same buffer back
+    }
+    slot->nv21 = framePool().acquire(height + height / 2, width, CV_8UC1);
+    nv21(cv::Rect(0, 0, width, height + height / 2)).copyTo(slot->nv21);
+    slot->width = width;
+    slot->height = height;
+    slot->rotation = rotation;
+    slot->timestampNs = timestampNs;
+    slot->index = index;
+    slot->score = score;
+}
+
+int BurstSelector::finish() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!running.exchange(false, std::memory_order_relaxed)) {
+        LOGW("⚠️ No burst to finish");
+        return static_cast<int>(candidates.size());
+    }
+    std::sort(candidates.begin(), candidates.end(),
+              [](const BurstFrame& a, const BurstFrame& b) { return a.score > b.score; });
+    LOGI("✅ Burst finished: %u frames, best %d kept (top score %.2f)", offered,
+         static_cast<int>(candidates.size()), candidates.empty() ? 0.0 : candidates.front().score);
+    return static_cast<int>(candidates.size());
+}
+
+bool BurstSelector::winner(int rank, BurstFrame& frame) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (running.load(std::memory_order_relaxed) || rank < 0 || rank >= static_cast<int>(candidates.size())) {
+        return false;
+    }
+    frame = candidates[rank];
+    return true;
+}
+
+void BurstSelector::release() {
+    std::lock_guard<std::mutex> lock(mutex);
+    running.store(false, std::memory_order_relaxed);
+    candidates.clear();
+}
+
+BurstSelector& burstSelector() {
+    static BurstSelector selector;
+    return selector;
+}
@@ -0,0 +1,73 @@
+#ifndef EDGE_BURST_SELECTOR_H
+#define EDGE_BURST_SELECTOR_H
+
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// How a burst frame's sharpness is scored, both on luma box-downscaled to
+// about kBurstScoreWidth columns
+enum class BurstMetric : int {
+    GRADIENT_ENERGY = 0,  // mean squared forward difference (x and y), in luma units
+    EDGE_DENSITY = 1,     // share of pixels whose |dx| + |dy| reaches kBurstEdgeStep
+};
+
+const int kBurstScoreWidth = 480;
+const int kBurstEdgeStep = 24;
+
+// Sharpness of one luma plane in a single pass: each output row is summed
+// from its block of source rows and differenced against the previous one
+// while still in the cache, so the downscaled image is never stored and a
+// frame costs one read of its luma.
+float burstScore(const cv::Mat& luma, BurstMetric metric);
+
+// One kept frame: a packed NV21 copy (height * 3 / 2 rows of width bytes)
+struct BurstFrame {
+    cv::Mat nv21;
+    int width = 0;
+    int height = 0;
+    int rotation = 0;
+    int64_t timestampNs = 0;
+    uint32_t index = 0;  // arrival order within the burst, from 0
+    float score = 0.0f;
+};
+
+// Best-frame selection over a capture burst. Every offered frame is scored
+// as it arrives and copied into a pooled buffer (frame_pool.h) only while it
+// ranks among the best keep so far; the frame it displaces gives its buffer
+// back first, so a burst of any length holds at most keep frames. finish()
+// hands the winners over, best first.
+class BurstSelector {
+public:
+    static const int kMaxKeep = 8;
+
+    // Starts a burst keeping the best keep (1..kMaxKeep) frames; the winners
+    // of the previous burst are released. False for an invalid keep.
+    bool start(int keep, BurstMetric metric);
+    bool active() const { return running.load(std::memory_order_relaxed); }
+
+    // Scores one packed NV21 frame and keeps a copy when it qualifies; a
+    // no-op outside a burst. Any thread.
+    void offer(const cv::Mat& nv21, int width, int height, int rotation, int64_t timestampNs);
+
+    // Ends the burst; the winners, best first, stay held for winner() until
+    // the next start or release(). Returns how many there are.
+    int finish();
+    // False past the last winner
+    bool winner(int rank, BurstFrame& frame);
+    void release();
+
+private:
+    std::atomic<bool> running{false};
+    std::atomic<int> metric{static_cast<int>(BurstMetric::GRADIENT_ENERGY)};
+    std::mutex mutex;
+    int keep = 1;
+    uint32_t offered = 0;
+    std::vector<BurstFrame> candidates;  // unordered while running, best first after finish
+};
+
+BurstSelector& burstSelector();
+
+#endif // EDGE_BURST_SELECTOR_H
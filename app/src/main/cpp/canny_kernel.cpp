@@ -0,0 +1,1130 @@
+#include "canny_kernel.h"
+#include "kernel_dispatch.h"
+#include "frame_deadline.h"
+#include <opencv2/core/utility.hpp>
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define EDGE_CANNY_NEON 1
+#endif
+
+namespace {
+
+// tan(22.5 deg) in Q15, the same sector boundaries cv::Canny uses
+const int kTg22 = 13573;
+
+// Edge map values, as in cv::Canny: candidates below the high threshold stay
+// weak until hysteresis connects them to a strong pixel
+const uchar kWeak = 0;
+const uchar kNone = 1;
+const uchar kStrong = 2;
+
+// Minimum rows per parallel band; bands share nothing but the edge map
+const int kMinBandRows = 16;
+
+std::atomic<int> pinnedBandRows{0};  // setCannyTiledBandRows, 0 = from the L2 size
+
+bool detectNeon() {
+#ifdef EDGE_CANNY_NEON
+    return cpuFeatures().neon;  // optional on ARMv7 silicon
+#else
+    return false;
+#endif
+}
+
+const bool kUseNeon = detectNeon();
+
+// Per-thread gradient rows: a ring of three dx/dy/magnitude rows plus a zero
+// row for the top and bottom borders. Magnitude rows carry one zero column on
+// each side so the suppression pass never needs a bounds check.
+struct GradientRows {
+    std::vector<short> storage;
+    int width = 0;
+    short* dx[3];
+    short* dy[3];
+    short* mag[3];
+    short* zero;
+
+    void prepare(int w) {
+        const int padded = w + 2;
+        if (w != width) {
+            storage.assign(static_cast<size_t>(6 * w + 4 * padded), 0);
+            width = w;
+        }
+        short* p = storage.data();
+        for (int i = 0; i < 3; i++) {
+            dx[i] = p; p += w;
+            dy[i] = p; p += w;
+        }
+        for (int i = 0; i < 3; i++) {
+            mag[i] = p + 1; p += padded;
+        }
+        zero = p + 1;
+    }
+};
+
+inline int slotOf(int row) {
+    return (row + 3) % 3;
+}
+
+// Per-thread ring of Gaussian-blurred source rows for the fused pre-blur. The
+// gradient of row r reads blurred rows r-1..r+1 (clamped), which always fall
+// in distinct slots, and each new gradient row needs one new blurred row.
+struct BlurRows {
+    std::vector<uchar> storage;
+    std::vector<ushort> vertical;   // vertical pass of one row, 2 replicated columns each side
+    int width = 0;
+    uchar* rows[3];
+    int rowOf[3];
+
+    // Also forgets the ring contents: the source changes between bands and frames
+    void prepare(int w) {
+        if (w != width) {
+            storage.assign(static_cast<size_t>(3 * w), 0);
+            vertical.assign(static_cast<size_t>(w + 4), 0);
+            width = w;
+        }
+        for (int i = 0; i < 3; i++) {
+            rows[i] = storage.data() + i * w;
+            rowOf[i] = -1;
+        }
+    }
+
+    const uchar* row(const cv::Mat& gray, int r) {
+        int slot = r % 3;
+        if (rowOf[slot] != r) {
+            blurRow(gray, r, rows[slot]);
+            rowOf[slot] = r;
+        }
+        return rows[slot];
+    }
+
+    // 1-4-6-4-1 vertically (sums up to 16 * 255, so ushort holds them), then
+    // horizontally (up to 65280, still ushort) with a rounding shift by 8
+    void blurRow(const cv::Mat& gray, int r, uchar* out) {
+        const int last = gray.rows - 1;
+        const uchar* s0 = gray.ptr<uchar>(std::max(r - 2, 0));
+        const uchar* s1 = gray.ptr<uchar>(std::max(r - 1, 0));
+        const uchar* s2 = gray.ptr<uchar>(r);
+        const uchar* s3 = gray.ptr<uchar>(std::min(r + 1, last));
+        const uchar* s4 = gray.ptr<uchar>(std::min(r + 2, last));
+        ushort* t = vertical.data() + 2;
+        const int w = width;
+        int x = 0;
+#ifdef EDGE_CANNY_NEON
+        if (kUseNeon) {
+            for (; x + 8 <= w; x += 8) {
+                uint16x8_t outer = vaddl_u8(vld1_u8(s0 + x), vld1_u8(s4 + x));
+                uint16x8_t inner = vaddl_u8(vld1_u8(s1 + x), vld1_u8(s3 + x));
+                uint16x8_t center = vmovl_u8(vld1_u8(s2 + x));
+                uint16x8_t sum = vaddq_u16(outer, vshlq_n_u16(inner, 2));
+                sum = vaddq_u16(sum, vaddq_u16(vshlq_n_u16(center, 2), vshlq_n_u16(center, 1)));
+                vst1q_u16(t + x, sum);
+            }
+        }
+#endif
+        for (; x < w; x++) {
+            t[x] = static_cast<ushort>(s0[x] + s4[x] + 4 * (s1[x] + s3[x]) + 6 * s2[x]);
+        }
+        t[-2] = t[-1] = t[0];
+        t[w] = t[w + 1] = t[w - 1];
+
+        x = 0;
+#ifdef EDGE_CANNY_NEON
+        if (kUseNeon) {
+            for (; x + 8 <= w; x += 8) {
+                uint16x8_t outer = vaddq_u16(vld1q_u16(t + x - 2), vld1q_u16(t + x + 2));
+                uint16x8_t inner = vaddq_u16(vld1q_u16(t + x - 1), vld1q_u16(t + x + 1));
+                uint16x8_t center = vld1q_u16(t + x);
+                uint16x8_t sum = vaddq_u16(outer, vshlq_n_u16(inner, 2));
+                sum = vaddq_u16(sum, vaddq_u16(vshlq_n_u16(center, 2), vshlq_n_u16(center, 1)));
+                vst1_u8(out + x, vrshrn_n_u16(sum, 8));
+            }
+        }
+#endif
+        for (; x < w; x++) {
+            unsigned sum = t[x - 2] + t[x + 2] + 4u * (t[x - 1] + t[x + 1]) + 6u * t[x];
+            out[x] = static_cast<uchar>((sum + 128) >> 8);
+        }
+    }
+};
+
+// Chroma gradients are per half-resolution pixel, half as much per full one,
+// and the tensor sums squares: a quarter
+const float kChromaTensorScale = 0.25f;
+
+// Per-thread Sobel gradients of one row of the VU plane, computed once for
+// the two luma rows that share it (replicated borders, as the luma's)
+struct ChromaRows {
+    std::vector<short> storage;
+    int width = 0;   // chroma columns
+    short* vx = nullptr;
+    short* vy = nullptr;
+    short* ux = nullptr;
+    short* uy = nullptr;
+    int rowOf = -1;
+
+    // Also forgets the row: the plane changes between bands and frames
+    void prepare(int w) {
+        if (w != width) {
+            storage.assign(static_cast<size_t>(4 * w), 0);
+            width = w;
+        }
+        short* p = storage.data();
+        vx = p;
+        vy = p + w;
+        ux = p + 2 * w;
+        uy = p + 3 * w;
+        rowOf = -1;
+    }
+
+    void compute(const cv::Mat& vu, int r) {
+        if (rowOf == r) {
+            return;
+        }
+        rowOf = r;
+        const uchar* c0 = vu.ptr<uchar>(std::max(r - 1, 0));
+        const uchar* c1 = vu.ptr<uchar>(r);
+        const uchar* c2 = vu.ptr<uchar>(std::min(r + 1, vu.rows - 1));
+        const int w = width;
+        auto sobelAt = [&](int x) {
+            const int l = 2 * std::max(x - 1, 0);
+            const int c = 2 * x;
+            const int rt = 2 * std::min(x + 1, w - 1);
+            for (int ch = 0; ch < 2; ch++) {
+                const int gx = (c0[rt + ch] - c0[l + ch]) + 2 * (c1[rt + ch] - c1[l + ch]) + (c2[rt + ch] - c2[l + ch]);
+                const int gy = (c2[l + ch] + 2 * c2[c + ch] + c2[rt + ch]) - (c0[l + ch] + 2 * c0[c + ch] + c0[rt + ch]);
+                (ch == 0 ? vx : ux)[x] = static_cast<short>(gx);
+                (ch == 0 ? vy : uy)[x] = static_cast<short>(gy);
+            }
+        };
+        sobelAt(0);
+        int x = 1;
+#ifdef EDGE_CANNY_NEON
+        if (kUseNeon) {
+            // vld2 splits V and U; the last load ends at byte 2 * x + 17
+            for (; x + 9 <= w; x += 8) {
+                const uint8x8x2_t l0 = vld2_u8(c0 + 2 * (x - 1)), m0 = vld2_u8(c0 + 2 * x), r0 = vld2_u8(c0 + 2 * (x + 1));
+                const uint8x8x2_t l1 = vld2_u8(c1 + 2 * (x - 1)), r1 = vld2_u8(c1 + 2 * (x + 1));
+                const uint8x8x2_t l2 = vld2_u8(c2 + 2 * (x - 1)), m2 = vld2_u8(c2 + 2 * x), r2 = vld2_u8(c2 + 2 * (x + 1));
+                for (int ch = 0; ch < 2; ch++) {
+                    int16x8_t gx, gy;
+                    sobel8(l0.val[ch], m0.val[ch], r0.val[ch], l1.val[ch], r1.val[ch], l2.val[ch], m2.val[ch],
+                           r2.val[ch], gx, gy);
+                    vst1q_s16((ch == 0 ? vx : ux) + x, gx);
+                    vst1q_s16((ch == 0 ? vy : uy) + x, gy);
+                }
+            }
+        }
+#endif
+        for (; x < w; x++) {
+            sobelAt(x);
+        }
+    }
+
+#ifdef EDGE_CANNY_NEON
+    // 3x3 Sobel of 8 pixels from their left (l), centre (m) and right (r)
+    // neighbours in the rows above (0), at (1) and below (2)
+    static void sobel8(uint8x8_t l0, uint8x8_t m0, uint8x8_t r0, uint8x8_t l1, uint8x8_t r1, uint8x8_t l2,
+                       uint8x8_t m2, uint8x8_t r2, int16x8_t& gx, int16x8_t& gy) {
+        int16x8_t x0 = vreinterpretq_s16_u16(vsubl_u8(r0, l0));
+        int16x8_t x1 = vreinterpretq_s16_u16(vsubl_u8(r1, l1));
+        int16x8_t x2 = vreinterpretq_s16_u16(vsubl_u8(r2, l2));
+        gx = vaddq_s16(vaddq_s16(x0, x2), vshlq_n_s16(x1, 1));
+        uint16x8_t below = vaddq_u16(vaddl_u8(l2, r2), vshll_n_u8(m2, 1));
+        uint16x8_t above = vaddq_u16(vaddl_u8(l0, r0), vshll_n_u8(m0, 1));
+        gy = vsubq_s16(vreinterpretq_s16_u16(below), vreinterpretq_s16_u16(above));
+    }
+#endif
+};
+
+// One pixel of the color tensor: the luma gradient (yx, yy) plus the chroma
+// ones, into the largest eigenvalue's square root (mag) and its eigenvector
+// at that length (dx, dy; the sign is arbitrary, which suppression ignores).
+// The eigenvector is taken from whichever tensor row keeps it away from
+// cancellation.
+inline void colorTensorPixel(int yx, int yy, int vx, int vy, int ux, int uy, short& dx, short& dy, short& mag) {
+    const float a = static_cast<float>(yx * yx) + kChromaTensorScale * static_cast<float>(vx * vx + ux * ux);
+    const float b = static_cast<float>(yx * yy) + kChromaTensorScale * static_cast<float>(vx * vy + ux * uy);
+    const float c = static_cast<float>(yy * yy) + kChromaTensorScale * static_cast<float>(vy * vy + uy * uy);
+    const float lambda = 0.5f * (a + c + std::sqrt((a - c) * (a - c) + 4.0f * b * b));
+    const float m = std::min(std::sqrt(lambda), 32767.0f);
+    const float ex = a >= c ? lambda - c : b;
+    const float ey = a >= c ? b : lambda - a;
+    const float norm = ex * ex + ey * ey;
+    const float scale = norm > 0.0f ? m / std::sqrt(norm) : 0.0f;
+    dx = static_cast<short>(ex * scale);
+    dy = static_cast<short>(ey * scale);
+    mag = static_cast<short>(m);
+}
+
+#ifdef EDGE_CANNY_NEON
+// sqrt and 1/sqrt of non-negative lanes; 0 stays 0 in both (ARMv7 has
+// only the estimates, refined by two Newton steps)
+inline float32x4_t sqrtNonNegative(float32x4_t v) {
+#if defined(__aarch64__)
+    return vsqrtq_f32(v);
+#else
+    float32x4_t e = vrsqrteq_f32(v);
+    e = vmulq_f32(e, vrsqrtsq_f32(vmulq_f32(v, e), e));
+    e = vmulq_f32(e, vrsqrtsq_f32(vmulq_f32(v, e), e));
+    return vbslq_f32(vcgtq_f32(v, vdupq_n_f32(0.0f)), vmulq_f32(v, e), vdupq_n_f32(0.0f));
+#endif
+}
+
+inline float32x4_t inverseSqrtOrZero(float32x4_t v) {
+    const uint32x4_t positive = vcgtq_f32(v, vdupq_n_f32(0.0f));
+#if defined(__aarch64__)
+    float32x4_t e = vdivq_f32(vdupq_n_f32(1.0f), vsqrtq_f32(v));
+#else
+    float32x4_t e = vrsqrteq_f32(v);
+    e = vmulq_f32(e, vrsqrtsq_f32(vmulq_f32(v, e), e));
+    e = vmulq_f32(e, vrsqrtsq_f32(vmulq_f32(v, e), e));
+#endif
+    return vbslq_f32(positive, e, vdupq_n_f32(0.0f));
+}
+
+inline float32x4_t toFloat(int16x4_t v) {
+    return vcvtq_f32_s32(vmovl_s16(v));
+}
+
+// colorTensorPixel for 4 lanes
+inline void colorTensor4(int16x4_t yx, int16x4_t yy, int16x4_t vx, int16x4_t vy, int16x4_t ux, int16x4_t uy,
+                         int16x4_t& dx, int16x4_t& dy, int16x4_t& mag) {
+    const float32x4_t fyx = toFloat(yx), fyy = toFloat(yy);
+    const float32x4_t fvx = toFloat(vx), fvy = toFloat(vy), fux = toFloat(ux), fuy = toFloat(uy);
+    const float32x4_t a = vmlaq_n_f32(vmulq_f32(fyx, fyx), vmlaq_f32(vmulq_f32(fvx, fvx), fux, fux), kChromaTensorScale);
+    const float32x4_t b = vmlaq_n_f32(vmulq_f32(fyx, fyy), vmlaq_f32(vmulq_f32(fvx, fvy), fux, fuy), kChromaTensorScale);
+    const float32x4_t c = vmlaq_n_f32(vmulq_f32(fyy, fyy), vmlaq_f32(vmulq_f32(fvy, fvy), fuy, fuy), kChromaTensorScale);
+    const float32x4_t diff = vsubq_f32(a, c);
+    const float32x4_t root = sqrtNonNegative(vmlaq_n_f32(vmulq_f32(diff, diff), vmulq_f32(b, b), 4.0f));
+    const float32x4_t lambda = vmulq_n_f32(vaddq_f32(vaddq_f32(a, c), root), 0.5f);
+    const float32x4_t m = vminq_f32(sqrtNonNegative(lambda), vdupq_n_f32(32767.0f));
+    const uint32x4_t rowA = vcgeq_f32(a, c);
+    const float32x4_t ex = vbslq_f32(rowA, vsubq_f32(lambda, c), b);
+    const float32x4_t ey = vbslq_f32(rowA, b, vsubq_f32(lambda, a));
+    const float32x4_t scale = vmulq_f32(m, inverseSqrtOrZero(vmlaq_f32(vmulq_f32(ex, ex), ey, ey)));
+    dx = vmovn_s32(vcvtq_s32_f32(vmulq_f32(ex, scale)));
+    dy = vmovn_s32(vcvtq_s32_f32(vmulq_f32(ey, scale)));
+    mag = vmovn_s32(vcvtq_s32_f32(m));
+}
+
+// Each of 4 chroma values for the 2 luma columns it covers
+inline int16x8_t widenChroma(const short* row) {
+    const int16x4x2_t pairs = vzip_s16(vld1_s16(row), vld1_s16(row));
+    return vcombine_s16(pairs.val[0], pairs.val[1]);
+}
+#endif
+
+// Color-tensor counterpart of GradientRowFn: luma rows r0..r2 (above, at,
+// below) and the chroma gradients of the row at half resolution
+void colorGradientRow(const uchar* r0, const uchar* r1, const uchar* r2, const ChromaRows& chroma, int width,
+                      short* dx, short* dy, short* mag) {
+    auto pixel = [&](int x) {
+        const int l = std::max(x - 1, 0);
+        const int rt = std::min(x + 1, width - 1);
+        const int yx = (r0[rt] - r0[l]) + 2 * (r1[rt] - r1[l]) + (r2[rt] - r2[l]);
+        const int yy = (r2[l] + 2 * r2[x] + r2[rt]) - (r0[l] + 2 * r0[x] + r0[rt]);
+        const int c = x >> 1;
+        colorTensorPixel(yx, yy, chroma.vx[c], chroma.vy[c], chroma.ux[c], chroma.uy[c], dx[x], dy[x], mag[x]);
+    };
+    int x = 0;
+    for (; x < std::min(2, width); x++) {
+        pixel(x);
+    }
+#ifdef EDGE_CANNY_NEON
+    if (kUseNeon) {
+        // Even x, so lanes 2k and 2k + 1 share chroma column x / 2 + k
+        for (; x + 9 <= width; x += 8) {
+            int16x8_t yx, yy;
+            ChromaRows::sobel8(vld1_u8(r0 + x - 1), vld1_u8(r0 + x), vld1_u8(r0 + x + 1), vld1_u8(r1 + x - 1),
+                               vld1_u8(r1 + x + 1), vld1_u8(r2 + x - 1), vld1_u8(r2 + x), vld1_u8(r2 + x + 1), yx, yy);
+            const int c = x >> 1;
+            const int16x8_t vx = widenChroma(chroma.vx + c), vy = widenChroma(chroma.vy + c);
+            const int16x8_t ux = widenChroma(chroma.ux + c), uy = widenChroma(chroma.uy + c);
+            int16x4_t dxLo, dyLo, magLo, dxHi, dyHi, magHi;
+            colorTensor4(vget_low_s16(yx), vget_low_s16(yy), vget_low_s16(vx), vget_low_s16(vy), vget_low_s16(ux),
+                         vget_low_s16(uy), dxLo, dyLo, magLo);
+            colorTensor4(vget_high_s16(yx), vget_high_s16(yy), vget_high_s16(vx), vget_high_s16(vy),
+                         vget_high_s16(ux), vget_high_s16(uy), dxHi, dyHi, magHi);
+            vst1q_s16(dx + x, vcombine_s16(dxLo, dxHi));
+            vst1q_s16(dy + x, vcombine_s16(dyLo, dyHi));
+            vst1q_s16(mag + x, vcombine_s16(magLo, magHi));
+        }
+    }
+#endif
+    for (; x < width; x++) {
+        pixel(x);
+    }
+}
+
+// Scalar reference of the suppression rule for one pixel
+inline uchar suppressPixel(const short* dx, const short* dy, const short* prev,
+                           const short* cur, const short* next, int x, int low, int high) {
+    int m = cur[x];
+    if (m <= low) {
+        return kNone;
+    }
+    int xs = dx[x];
+    int ys = dy[x];
+    int ax = std::abs(xs);
+    int ay = std::abs(ys) << 15;
+    int tg22x = ax * kTg22;
+    bool maximum;
+    if (ay < tg22x) {
+        maximum = m > cur[x - 1] && m >= cur[x + 1];
+    } else if (ay > tg22x + (ax << 16)) {
+        maximum = m > prev[x] && m >= next[x];
+    } else {
+        int s = (xs ^ ys) < 0 ? -1 : 1;
+        maximum = m > prev[x - s] && m > next[x + s];
+    }
+    if (!maximum) {
+        return kNone;
+    }
+    return m > high ? kStrong : kWeak;
+}
+
+void suppressRow(const short* dx, const short* dy, const short* prev, const short* cur,
+                 const short* next, int width, int low, int high, uchar* map) {
+    int x = 0;
+#ifdef EDGE_CANNY_NEON
+    if (kUseNeon) {
+        const int16x8_t vLow = vdupq_n_s16(static_cast<short>(low));
+        const int16x8_t vHigh = vdupq_n_s16(static_cast<short>(high));
+        const int16x8_t vZero = vdupq_n_s16(0);
+        const uint8x8_t vNone = vdup_n_u8(kNone);
+        const uint8x8_t vStrong = vdup_n_u8(kStrong);
+        for (; x + 8 <= width; x += 8) {
+            int16x8_t m = vld1q_s16(cur + x);
+            int16x8_t gx = vld1q_s16(dx + x);
+            int16x8_t gy = vld1q_s16(dy + x);
+
+            // Sector of the gradient direction, in 32 bits like the scalar rule
+            int16x8_t ax = vabsq_s16(gx);
+            int16x8_t ay = vabsq_s16(gy);
+            int32x4_t tg22Lo = vmull_n_s16(vget_low_s16(ax), kTg22);
+            int32x4_t tg22Hi = vmull_n_s16(vget_high_s16(ax), kTg22);
+            int32x4_t ayLo = vshlq_n_s32(vmovl_s16(vget_low_s16(ay)), 15);
+            int32x4_t ayHi = vshlq_n_s32(vmovl_s16(vget_high_s16(ay)), 15);
+            int32x4_t tg67Lo = vaddq_s32(tg22Lo, vshlq_n_s32(vmovl_s16(vget_low_s16(ax)), 16));
+            int32x4_t tg67Hi = vaddq_s32(tg22Hi, vshlq_n_s32(vmovl_s16(vget_high_s16(ax)), 16));
+            uint16x8_t horizontal = vcombine_u16(vmovn_u32(vcltq_s32(ayLo, tg22Lo)),
+                                                 vmovn_u32(vcltq_s32(ayHi, tg22Hi)));
+            uint16x8_t vertical = vcombine_u16(vmovn_u32(vcgtq_s32(ayLo, tg67Lo)),
+                                               vmovn_u32(vcgtq_s32(ayHi, tg67Hi)));
+
+            uint16x8_t hOk = vandq_u16(vcgtq_s16(m, vld1q_s16(cur + x - 1)),
+                                       vcgeq_s16(m, vld1q_s16(cur + x + 1)));
+            uint16x8_t vOk = vandq_u16(vcgtq_s16(m, vld1q_s16(prev + x)),
+                                       vcgeq_s16(m, vld1q_s16(next + x)));
+            // Same signs: top-left/bottom-right diagonal, else top-right/bottom-left
+            uint16x8_t dSame = vandq_u16(vcgtq_s16(m, vld1q_s16(prev + x - 1)),
+                                         vcgtq_s16(m, vld1q_s16(next + x + 1)));
+            uint16x8_t dOpposite = vandq_u16(vcgtq_s16(m, vld1q_s16(prev + x + 1)),
+                                             vcgtq_s16(m, vld1q_s16(next + x - 1)));
+            uint16x8_t opposite = vcltq_s16(veorq_s16(gx, gy), vZero);
+            uint16x8_t dOk = vbslq_u16(opposite, dOpposite, dSame);
+
+            uint16x8_t maximum = vbslq_u16(horizontal, hOk, vbslq_u16(vertical, vOk, dOk));
+            uint16x8_t candidate = vandq_u16(maximum, vcgtq_s16(m, vLow));
+            uint16x8_t strong = vandq_u16(candidate, vcgtq_s16(m, vHigh));
+
+            uint8x8_t value = vbsl_u8(vmovn_u16(candidate),
+                                      vand_u8(vmovn_u16(strong), vStrong), vNone);
+            vst1_u8(map + x, value);
+        }
+    }
+#endif
+    for (; x < width; x++) {
+        map[x] = suppressPixel(dx, dy, prev, cur, next, x, low, high);
+    }
+}
+
+// Notes a record for every suppression candidate of one row (map: the row
+// suppressRow just wrote), with the axis and neighbours its rule compared
+void recordRow(const short* dx, const short* dy, const short* prev, const short* cur, const short* next,
+               int width, int y, const uchar* map, std::vector<EdgeRecord>& out) {
+    for (int x = 0; x < width; x++) {
+        if (map[x] == kNone) {
+            continue;
+        }
+        const int xs = dx[x];
+        const int ys = dy[x];
+        const int ax = std::abs(xs);
+        const int ay = std::abs(ys) << 15;
+        const int tg22x = ax * kTg22;
+        EdgeRecord record;
+        int before;
+        int after;
+        if (ay < tg22x) {
+            record.axis = EDGE_AXIS_X;
+            before = cur[x - 1];
+            after = cur[x + 1];
+        } else if (ay > tg22x + (ax << 16)) {
+            record.axis = EDGE_AXIS_Y;
+            before = prev[x];
+            after = next[x];
+        } else if ((xs ^ ys) < 0) {
+            record.axis = EDGE_AXIS_ANTI;
+            before = prev[x + 1];
+            after = next[x - 1];
+        } else {
+            record.axis = EDGE_AXIS_DIAGONAL;
+            before = prev[x - 1];
+            after = next[x + 1];
+        }
+        const int m = cur[x];
+        // Vertex of the parabola through (-1, before), (0, m), (1, after)
+        const int curvature = before - 2 * m + after;
+        int offset = curvature < 0 ? static_cast<int>(std::lround(64.0f * (before - after) / curvature)) : 0;
+        offset = std::min(std::max(offset, -64), 64);
+        const float radians = std::atan2(static_cast<float>(ys), static_cast<float>(xs));
+        const long angle = std::lround(radians * (128.0f / 3.14159265f));
+        record.x = static_cast<uint16_t>(x);
+        record.y = static_cast<uint16_t>(y);
+        record.direction = static_cast<uint8_t>(angle & 0xff);
+        record.offset = static_cast<int8_t>(offset);
+        record.strength = static_cast<uint8_t>(std::min(m >> 3, 255));
+        out.push_back(record);
+    }
+}
+
+// Magnitudes of the pixels suppressRow kept (any value but kNone), 0 for
+// the rest: the threshold-free result cannyU8Maxima stores
+void keepMaximaRow(const uchar* map, const short* mag, int width, short* maxima) {
+    int x = 0;
+#ifdef EDGE_CANNY_NEON
+    if (kUseNeon) {
+        const uint8x8_t vNone = vdup_n_u8(kNone);
+        for (; x + 8 <= width; x += 8) {
+            // Sign extension widens the 0xFF lanes to a full 16-bit mask
+            int16x8_t none = vmovl_s8(vreinterpret_s8_u8(vceq_u8(vld1_u8(map + x), vNone)));
+            vst1q_s16(maxima + x, vbicq_s16(vld1q_s16(mag + x), none));
+        }
+    }
+#endif
+    for (; x < width; x++) {
+        maxima[x] = map[x] != kNone ? mag[x] : 0;
+    }
+}
+
+// The thresholds suppressRow applies, on a row of stored maxima
+void classifyRow(const short* maxima, int width, int low, int high, uchar* map) {
+    int x = 0;
+#ifdef EDGE_CANNY_NEON
+    if (kUseNeon) {
+        const int16x8_t vLow = vdupq_n_s16(static_cast<short>(low));
+        const int16x8_t vHigh = vdupq_n_s16(static_cast<short>(high));
+        const uint8x8_t vNone = vdup_n_u8(kNone);
+        const uint8x8_t vStrong = vdup_n_u8(kStrong);
+        for (; x + 8 <= width; x += 8) {
+            int16x8_t m = vld1q_s16(maxima + x);
+            uint16x8_t candidate = vcgtq_s16(m, vLow);
+            uint16x8_t strong = vcgtq_s16(m, vHigh);
+            vst1_u8(map + x, vbsl_u8(vmovn_u16(candidate), vand_u8(vmovn_u16(strong), vStrong), vNone));
+        }
+    }
+#endif
+    for (; x < width; x++) {
+        const int m = maxima[x];
+        map[x] = m > high ? kStrong : (m > low ? kWeak : kNone);
+    }
+}
+
+// Gradient + non-max suppression over bands of bandRows rows. Each band
+// recomputes the gradient of the rows just outside it (a 2-row source halo:
+// suppression needs gradients one row out, which need pixels one row further;
+// 4 rows with the pre-blur), so bands are independent.
+class SuppressBody : public cv::ParallelLoopBody {
+public:
+    // candidates: one list per band for recordRow, or null; vu: the VU plane
+    // for the color tensor (cannyU8Color), or null for the luma gradient;
+    // maxima: rows of width for keepMaximaRow (cannyU8Maxima), or null;
+    // deadline: checked before each band, which is skipped once it passed
+    SuppressBody(const cv::Mat& gray, uchar* map, int mapStep, int low, int high, int bandRows, bool preBlur,
+                 std::vector<EdgeRecord>* candidates, const cv::Mat* vu, short* maxima = nullptr,
+                 const FrameDeadline* deadline = nullptr)
+            : gray(gray), map(map), mapStep(mapStep), low(low), high(high), bandRows(bandRows),
+              preBlur(preBlur), candidates(candidates), vu(vu), maxima(maxima), deadline(deadline) {}
+
+    void operator()(const cv::Range& range) const override {
+        const int rows = gray.rows;
+        const int width = gray.cols;
+        const int y0 = std::min(range.start * bandRows, rows);
+        const int y1 = std::min(range.end * bandRows, rows);
+        if (y0 >= y1 || (deadline && deadline->expired())) {
+            return;
+        }
+        if (candidates) {
+            for (int band = range.start; band < range.end; band++) {
+                candidates[band].clear();
+            }
+        }
+
+        static thread_local GradientRows grad;
+        grad.prepare(width);
+        static thread_local BlurRows blur;
+        if (preBlur) {
+            blur.prepare(width);
+        }
+        static thread_local ChromaRows chroma;
+        if (vu) {
+            chroma.prepare(vu->cols);
+        }
+
+        const GradientRowFn gradientRow = edgeKernels().gradientRow;  // kernel_dispatch.h
+        auto computeRow = [&](int r) {
+            const int above = std::max(r - 1, 0);
+            const int below = std::min(r + 1, rows - 1);
+            const uchar* r0 = preBlur ? blur.row(gray, above) : gray.ptr<uchar>(above);
+            const uchar* r1 = preBlur ? blur.row(gray, r) : gray.ptr<uchar>(r);
+            const uchar* r2 = preBlur ? blur.row(gray, below) : gray.ptr<uchar>(below);
+            int s = slotOf(r);
+            if (vu) {
+                chroma.compute(*vu, std::min(r / 2, vu->rows - 1));
+                colorGradientRow(r0, r1, r2, chroma, width, grad.dx[s], grad.dy[s], grad.mag[s]);
+            } else {
+                gradientRow(r0, r1, r2, width, grad.dx[s], grad.dy[s], grad.mag[s]);
+            }
+        };
+
+        if (y0 > 0) {
+            computeRow(y0 - 1);
+        }
+        computeRow(y0);
+        for (int y = y0; y < y1; y++) {
+            if (y + 1 < rows) {
+                computeRow(y + 1);
+            }
+            const short* prev = y > 0 ? grad.mag[slotOf(y - 1)] : grad.zero;
+            const short* next = y + 1 < rows ? grad.mag[slotOf(y + 1)] : grad.zero;
+            int s = slotOf(y);
+            uchar* row = map + (y + 1) * mapStep + 1;
+            suppressRow(grad.dx[s], grad.dy[s], prev, grad.mag[s], next, width, low, high, row);
+            if (candidates) {
+                recordRow(grad.dx[s], grad.dy[s], prev, grad.mag[s], next, width, y, row, candidates[y / bandRows]);
+            }
+            if (maxima) {
+                keepMaximaRow(row, grad.mag[s], width, maxima + static_cast<size_t>(y) * width);
+            }
+        }
+    }
+
+private:
+    const cv::Mat& gray;
+    uchar* map;
+    int mapStep;
+    int low;
+    int high;
+    int bandRows;
+    bool preBlur;
+    std::vector<EdgeRecord>* candidates;
+    const cv::Mat* vu;
+    short* maxima;
+    const FrameDeadline* deadline;
+};
+
+// Pushes every strong pixel of rows [y0, y1)
+void collectStrong(uchar* map, int mapStep, int width, int y0, int y1, std::vector<uchar*>& stack) {
+    for (int y = y0; y < y1; y++) {
+        uchar* row = map + (y + 1) * mapStep + 1;
+        int x = 0;
+#ifdef EDGE_CANNY_NEON
+        if (kUseNeon) {
+            const uint8x16_t vStrong = vdupq_n_u8(kStrong);
+            for (; x + 16 <= width; x += 16) {
+                uint64x2_t hits = vreinterpretq_u64_u8(vceqq_u8(vld1q_u8(row + x), vStrong));
+                if ((vgetq_lane_u64(hits, 0) | vgetq_lane_u64(hits, 1)) == 0) {
+                    continue;
+                }
+                for (int i = 0; i < 16; i++) {
+                    if (row[x + i] == kStrong) {
+                        stack.push_back(row + x + i);
+                    }
+                }
+            }
+        }
+#endif
+        for (; x < width; x++) {
+            if (row[x] == kStrong) {
+                stack.push_back(row + x);
+            }
+        }
+    }
+}
+
+// Grows the stacked strong pixels through 8-connected weak ones, never
+// writing outside [begin, end) of the map
+void grow(std::vector<uchar*>& stack, int mapStep, const uchar* begin, const uchar* end) {
+    const int offsets[8] = {-mapStep - 1, -mapStep, -mapStep + 1, -1, 1,
+                            mapStep - 1, mapStep, mapStep + 1};
+    while (!stack.empty()) {
+        uchar* p = stack.back();
+        stack.pop_back();
+        for (int offset : offsets) {
+            uchar* q = p + offset;
+            if (q >= begin && q < end && *q == kWeak) {
+                *q = kStrong;
+                stack.push_back(q);
+            }
+        }
+    }
+}
+
+// Whole-map hysteresis; the kNone border keeps it inside the image
+void hysteresis(uchar* map, int mapStep, int width, int height) {
+    static thread_local std::vector<uchar*> stack;
+    stack.clear();
+    collectStrong(map, mapStep, width, 0, height, stack);
+    grow(stack, mapStep, map, map + static_cast<size_t>(mapStep) * (height + 2));
+}
+
+// First hysteresis phase of the tiled path: each band grows its own strong
+// pixels without crossing into its neighbours
+class BandHysteresisBody : public cv::ParallelLoopBody {
+public:
+    BandHysteresisBody(uchar* map, int mapStep, int width, int height, int bandRows,
+                       const FrameDeadline* deadline)
+            : map(map), mapStep(mapStep), width(width), height(height), bandRows(bandRows), deadline(deadline) {}
+
+    void operator()(const cv::Range& range) const override {
+        static thread_local std::vector<uchar*> stack;
+        for (int band = range.start; band < range.end; band++) {
+            if (deadline && deadline->expired()) {
+                return;
+            }
+            const int y0 = std::min(band * bandRows, height);
+            const int y1 = std::min(y0 + bandRows, height);
+            stack.clear();
+            collectStrong(map, mapStep, width, y0, y1, stack);
+            grow(stack, mapStep, map + (y0 + 1) * mapStep, map + (y1 + 1) * mapStep);
+        }
+    }
+
+private:
+    uchar* map;
+    int mapStep;
+    int width;
+    int height;
+    int bandRows;
+    const FrameDeadline* deadline;
+};
+
+// Second phase: a weak pixel still unconnected can only be reached through a
+// strong pixel on the other side of a band boundary, so seeding the rows on
+// both sides of every boundary and growing without bounds finishes the job
+void stitchBands(uchar* map, int mapStep, int width, int height, int bandRows) {
+    static thread_local std::vector<uchar*> stack;
+    stack.clear();
+    for (int boundary = bandRows; boundary < height; boundary += bandRows) {
+        collectStrong(map, mapStep, width, boundary - 1, boundary + 1, stack);
+    }
+    grow(stack, mapStep, map, map + static_cast<size_t>(mapStep) * (height + 2));
+}
+
+// Candidate (weak or strong) and strong bits of a map row, 64 pixels per
+// word; the bits past width are 0
+void packRow(const uchar* row, int width, uint64_t* candidates, uint64_t* edges) {
+    const int words = (width + 63) / 64;
+    for (int w = 0; w < words; w++) {
+        const int x0 = w * 64;
+        const int count = std::min(64, width - x0);
+        uint64_t candidate = 0;
+        uint64_t strong = 0;
+        int i = 0;
+#ifdef EDGE_CANNY_NEON
+        if (kUseNeon) {
+            // Lane i of a byte compare keeps bit i, and three pairwise adds
+            // gather the eight lanes into one byte
+            static const uint8_t kLaneBits[8] = {1, 2, 4, 8, 16, 32, 64, 128};
+            const uint8x8_t bitsOf = vld1_u8(kLaneBits);
+            const uint8x8_t vNone = vdup_n_u8(kNone);
+            const uint8x8_t vStrong = vdup_n_u8(kStrong);
+            for (; i + 8 <= count; i += 8) {
+                const uint8x8_t bytes = vld1_u8(row + x0 + i);
+                uint8x8_t c = vbic_u8(bitsOf, vceq_u8(bytes, vNone));
+                uint8x8_t s = vand_u8(bitsOf, vceq_u8(bytes, vStrong));
+                c = vpadd_u8(c, s);
+                c = vpadd_u8(c, c);
+                c = vpadd_u8(c, c);
+                candidate |= static_cast<uint64_t>(vget_lane_u8(c, 0)) << i;
+                strong |= static_cast<uint64_t>(vget_lane_u8(c, 1)) << i;
+            }
+        }
+#endif
+        for (; i < count; i++) {
+            candidate |= static_cast<uint64_t>(row[x0 + i] != kNone) << i;
+            strong |= static_cast<uint64_t>(row[x0 + i] == kStrong) << i;
+        }
+        candidates[w] = candidate;
+        edges[w] = strong;
+    }
+}
+
+// Occluded fill (Kogge-Stone): grows seed through the set bits of pass
+// towards higher bits (up) or lower bits, across a whole word in six steps
+inline uint64_t fillUp(uint64_t seed, uint64_t pass) {
+    seed |= pass & (seed << 1);
+    pass &= pass << 1;
+    seed |= pass & (seed << 2);
+    pass &= pass << 2;
+    seed |= pass & (seed << 4);
+    pass &= pass << 4;
+    seed |= pass & (seed << 8);
+    pass &= pass << 8;
+    seed |= pass & (seed << 16);
+    pass &= pass << 16;
+    return seed | (pass & (seed << 32));
+}
+
+inline uint64_t fillDown(uint64_t seed, uint64_t pass) {
+    seed |= pass & (seed >> 1);
+    pass &= pass >> 1;
+    seed |= pass & (seed >> 2);
+    pass &= pass >> 2;
+    seed |= pass & (seed >> 4);
+    pass &= pass >> 4;
+    seed |= pass & (seed >> 8);
+    pass &= pass >> 8;
+    seed |= pass & (seed >> 16);
+    pass &= pass >> 16;
+    return seed | (pass & (seed >> 32));
+}
+
+// Word w of row's 3-wide horizontal dilation
+inline uint64_t dilated(const uint64_t* row, int w, int words) {
+    uint64_t bits = row[w] | row[w] << 1 | row[w] >> 1;
+    if (w > 0) {
+        bits |= row[w - 1] >> 63;
+    }
+    if (w + 1 < words) {
+        bits |= row[w + 1] << 63;
+    }
+    return bits;
+}
+
+// One row of a sweep: candidates of row touching an edge pixel of the rows
+// above and below (8-connected) become edges, and so do the candidate runs
+// of the row through them, in both directions. True when a bit changed.
+bool sweepRow(const uint64_t* candidates, uint64_t* row, const uint64_t* above, const uint64_t* below,
+              int words) {
+    uint64_t changed = 0;
+    uint64_t carry = 0;
+    for (int w = 0; w < words; w++) {
+        uint64_t seed = row[w] | carry;
+        if (above) {
+            seed |= dilated(above, w, words);
+        }
+        if (below) {
+            seed |= dilated(below, w, words);
+        }
+        const uint64_t grown = fillUp(seed & candidates[w], candidates[w]);
+        carry = grown >> 63;
+        changed |= grown ^ row[w];
+        row[w] = grown;
+    }
+    carry = 0;
+    for (int w = words - 1; w >= 0; w--) {
+        const uint64_t grown = fillDown(row[w] | (carry & candidates[w]), candidates[w]);
+        carry = grown << 63;
+        changed |= grown ^ row[w];
+        row[w] = grown;
+    }
+    return changed != 0;
+}
+
+// Hysteresis in at most passes down-and-up sweeps over bit-packed rows,
+// instead of a stack walk whose length depends on the scene: each row takes
+// edges from its neighbours and floods its own runs, so a sweep follows any
+// path that goes only down (or only up) in y. Paths turning back more often
+// than the passes allow lose their far end; a sweep that changes nothing
+// ends early. Marks the edges kStrong in the map, like hysteresis().
+void boundedHysteresis(uchar* map, int mapStep, int width, int height, int passes, int bandRows) {
+    static thread_local std::vector<uint64_t> candidateBits;
+    static thread_local std::vector<uint64_t> edgeBits;
+    const int words = (width + 63) / 64;
+    candidateBits.resize(static_cast<size_t>(words) * height);
+    edgeBits.resize(candidateBits.size());
+    uint64_t* const candidates = candidateBits.data();
+    uint64_t* const edges = edgeBits.data();
+
+    const int bands = (height + bandRows - 1) / bandRows;
+    cv::parallel_for_(cv::Range(0, bands), [&](const cv::Range& range) {
+        const int y1 = std::min(range.end * bandRows, height);
+        for (int y = range.start * bandRows; y < y1; y++) {
+            packRow(map + (y + 1) * mapStep + 1, width, candidates + static_cast<size_t>(y) * words,
+                    edges + static_cast<size_t>(y) * words);
+        }
+    }, bands);
+
+    auto rowOf = [&](uint64_t* base, int y) { return base + static_cast<size_t>(y) * words; };
+    for (int pass = 0; pass < passes; pass++) {
+        bool changed = false;
+        for (int y = 0; y < height; y++) {
+            changed |= sweepRow(rowOf(candidates, y), rowOf(edges, y), y > 0 ? rowOf(edges, y - 1) : nullptr,
+                                y + 1 < height ? rowOf(edges, y + 1) : nullptr, words);
+        }
+        if (!changed) {
+            break;
+        }
+        changed = false;
+        for (int y = height - 1; y >= 0; y--) {
+            changed |= sweepRow(rowOf(candidates, y), rowOf(edges, y), y > 0 ? rowOf(edges, y - 1) : nullptr,
+                                y + 1 < height ? rowOf(edges, y + 1) : nullptr, words);
+        }
+        if (!changed) {
+            break;
+        }
+    }
+
+    // Only edge pixels are visited; the rest of the map keeps its value
+    for (int y = 0; y < height; y++) {
+        uchar* row = map + (y + 1) * mapStep + 1;
+        const uint64_t* packed = rowOf(edges, y);
+        for (int w = 0; w < words; w++) {
+            for (uint64_t word = packed[w]; word; word &= word - 1) {
+                row[w * 64 + __builtin_ctzll(word)] = kStrong;
+            }
+        }
+    }
+}
+
+void writeEdges(const uchar* map, int mapStep, cv::Mat& edges) {
+    const int width = edges.cols;
+    for (int y = 0; y < edges.rows; y++) {
+        const uchar* row = map + (y + 1) * mapStep + 1;
+        uchar* out = edges.ptr<uchar>(y);
+        int x = 0;
+#ifdef EDGE_CANNY_NEON
+        if (kUseNeon) {
+            const uint8x16_t vStrong = vdupq_n_u8(kStrong);
+            for (; x + 16 <= width; x += 16) {
+                vst1q_u8(out + x, vceqq_u8(vld1q_u8(row + x), vStrong));
+            }
+        }
+#endif
+        for (; x < width; x++) {
+            out[x] = row[x] == kStrong ? 255 : 0;
+        }
+    }
+}
+
+int cannyBandRows(int width, int height) {
+    const int pinned = pinnedBandRows.load(std::memory_order_relaxed);
+    if (pinned > 0) {
+        return std::min(pinned, std::max(height, 1));
+    }
+    // Band working set per row: source pixels, edge map and output, one byte
+    // each; half the L2 leaves room for the gradient ring and the other stages
+    int rows = static_cast<int>(l2CacheBytes() / 2 / (3 * static_cast<long>(std::max(width, 1))));
+    // Never fewer bands than threads, so small frames still use every core
+    int threads = std::max(1, cv::getNumThreads());
+    rows = std::min(rows, (height + threads - 1) / threads);
+    return std::max(rows, kMinBandRows);
+}
+
+// Rows per band: L2-sized when tiled, otherwise one band per thread
+int bandRowsFor(int width, int height, bool tiled) {
+    if (tiled) {
+        return cannyBandRows(width, height);
+    }
+    int stripes = std::max(1, std::min(cv::getNumThreads(), height / kMinBandRows));
+    return (height + stripes - 1) / stripes;
+}
+
+// Hysteresis over a suppressed (or classified) map, then the edges; false
+// when deadline passed between the tiled path's bands, edges left unwritten.
+// boundedPasses > 0 runs boundedHysteresis instead.
+bool finishCanny(uchar* map, int mapStep, int width, int height, int bandRows, bool tiled, cv::Mat& edges,
+                 const FrameDeadline* deadline = nullptr, int boundedPasses = 0) {
+    const int bands = (height + bandRows - 1) / bandRows;
+    if (boundedPasses > 0) {
+        boundedHysteresis(map, mapStep, width, height, boundedPasses, bandRows);
+    } else if (tiled && bands > 1) {
+        BandHysteresisBody bandBody(map, mapStep, width, height, bandRows, deadline);
+        cv::parallel_for_(cv::Range(0, bands), bandBody, bands);
+        if (deadlineAborts(deadline)) {
+            return false;
+        }
+        stitchBands(map, mapStep, width, height, bandRows);
+    } else {
+        hysteresis(map, mapStep, width, height);
+    }
+    writeEdges(map, mapStep, edges);
+    return true;
+}
+
+// Hands the candidates hysteresis turned into edges to sink, in band order
+void keepEdgeRecords(const std::vector<EdgeRecord>* candidates, int bands, const uchar* map, int mapStep,
+                     EdgeRecordSink& sink) {
+    for (int band = 0; band < bands; band++) {
+        for (const EdgeRecord& record : candidates[band]) {
+            if (map[(record.y + 1) * mapStep + record.x + 1] != kStrong) {
+                continue;
+            }
+            if (sink.count < sink.capacity) {
+                sink.records[sink.count++] = record;
+            } else {
+                sink.dropped++;
+            }
+        }
+    }
+}
+
+// Shared driver; tiled selects L2-sized bands and band-parallel hysteresis
+// instead of one band per thread and a single-threaded hysteresis pass.
+// False when deadline passed between bands (see finishCanny).
+bool runCanny(const cv::Mat& gray, cv::Mat& edges, int low, int high, bool tiled, bool preBlur,
+              EdgeRecordSink* sink = nullptr, const cv::Mat* vu = nullptr, const FrameDeadline* deadline = nullptr,
+              int boundedPasses = 0) {
+    CV_Assert(gray.type() == CV_8UC1);
+    if (low > high) {
+        std::swap(low, high);
+    }
+    edges.create(gray.size(), CV_8UC1);
+    if (gray.empty()) {
+        return true;
+    }
+
+    // Edge map with a one-pixel kNone border: hysteresis never leaves the image
+    const int width = gray.cols;
+    const int height = gray.rows;
+    const int mapStep = width + 2;
+    static thread_local std::vector<uchar> map;
+    map.assign(static_cast<size_t>(mapStep) * (height + 2), kNone);
+
+    const int bandRows = bandRowsFor(width, height, tiled);
+    const int bands = (height + bandRows - 1) / bandRows;
+
+    // Per band, so bands on different threads never share a list; capacity
+    // survives from frame to frame
+    static thread_local std::vector<std::vector<EdgeRecord>> candidates;
+    if (sink && candidates.size() < static_cast<size_t>(bands)) {
+        candidates.resize(static_cast<size_t>(bands));
+    }
+    SuppressBody body(gray, map.data(), mapStep, low, high, bandRows, preBlur, sink ? candidates.data() : nullptr,
+                      vu, nullptr, deadline);
+    if (bands > 1) {
+        cv::parallel_for_(cv::Range(0, bands), body, bands);
+    } else {
+        body(cv::Range(0, 1));
+    }
+    if (deadlineAborts(deadline)) {
+        return false;
+    }
+
+    if (!finishCanny(map.data(), mapStep, width, height, bandRows, tiled, edges, deadline, boundedPasses)) {
+        return false;
+    }
+    if (sink) {
+        keepEdgeRecords(candidates.data(), bands, map.data(), mapStep, *sink);
+    }
+    return true;
+}
+
+} // namespace
+
+bool cannyKernelUsesNeon() {
+    return kUseNeon;
+}
+
+void setCannyTiledBandRows(int rows) {
+    pinnedBandRows.store(rows > 0 ? std::max(rows, kMinBandRows) : 0, std::memory_order_relaxed);
+}
+
+int cannyTiledBandRows() {
+    return pinnedBandRows.load(std::memory_order_relaxed);
+}
+
+void cannyU8(const cv::Mat& gray, cv::Mat& edges, int lowThreshold, int highThreshold, bool preBlur) {
+    runCanny(gray, edges, lowThreshold, highThreshold, false, preBlur);
+}
+
+bool cannyU8Tiled(const cv::Mat& gray, cv::Mat& edges, int lowThreshold, int highThreshold, bool preBlur,
+                  const FrameDeadline* deadline) {
+    return runCanny(gray, edges, lowThreshold, highThreshold, true, preBlur, nullptr, nullptr, deadline);
+}
+
+bool cannyU8Bounded(const cv::Mat& gray, cv::Mat& edges, int lowThreshold, int highThreshold, bool preBlur,
+                    int passes, const FrameDeadline* deadline) {
+    return runCanny(gray, edges, lowThreshold, highThreshold, true, preBlur, nullptr, nullptr, deadline,
+                    std::max(passes, 1));
+}
+
+void cannyU8Records(const cv::Mat& gray, cv::Mat& edges, int lowThreshold, int highThreshold, bool preBlur,
+                    bool tiled, EdgeRecordSink& sink) {
+    CV_Assert(gray.cols <= 65536 && gray.rows <= 65536);
+    sink.count = 0;
+    sink.dropped = 0;
+    runCanny(gray, edges, lowThreshold, highThreshold, tiled, preBlur, &sink);
+}
+
+void cannyU8Color(const cv::Mat& luma, const cv::Mat& vu, cv::Mat& edges, int lowThreshold, int highThreshold,
+                  bool preBlur, bool tiled) {
+    CV_Assert(vu.type() == CV_8UC2 && vu.cols == (luma.cols + 1) / 2 && vu.rows == (luma.rows + 1) / 2);
+    runCanny(luma, edges, lowThreshold, highThreshold, tiled, preBlur, nullptr, &vu);
+}
+
+void cannyU8Maxima(const cv::Mat& gray, cv::Mat& maxima, bool preBlur, bool tiled) {
+    CV_Assert(gray.type() == CV_8UC1);
+    maxima.create(gray.size(), CV_16SC1);
+    if (gray.empty()) {
+        return;
+    }
+    CV_Assert(maxima.isContinuous());
+    const int width = gray.cols;
+    const int height = gray.rows;
+    const int mapStep = width + 2;
+    static thread_local std::vector<uchar> map;
+    map.assign(static_cast<size_t>(mapStep) * (height + 2), kNone);
+
+    // No threshold below any magnitude and none above: every maximum is a
+    // weak candidate and keepMaximaRow stores it
+    const int bandRows = bandRowsFor(width, height, tiled);
+    const int bands = (height + bandRows - 1) / bandRows;
+    SuppressBody body(gray, map.data(), mapStep, -1, SHRT_MAX, bandRows, preBlur, nullptr, nullptr,
+                      maxima.ptr<short>());
+    if (bands > 1) {
+        cv::parallel_for_(cv::Range(0, bands), body, bands);
+    } else {
+        body(cv::Range(0, 1));
+    }
+}
+
+void cannyU8FromMaxima(const cv::Mat& maxima, cv::Mat& edges, int lowThreshold, int highThreshold, bool tiled) {
+    CV_Assert(maxima.type() == CV_16SC1);
+    if (lowThreshold > highThreshold) {
+        std::swap(lowThreshold, highThreshold);
+    }
+    // A maximum is never 0 (suppression compares strictly), so a negative
+    // low keeps the same pixels as 0 does
+    lowThreshold = std::min(std::max(lowThreshold, 0), SHRT_MAX);
+    highThreshold = std::min(std::max(highThreshold, 0), SHRT_MAX);
+    edges.create(maxima.size(), CV_8UC1);
+    if (maxima.empty()) {
+        return;
+    }
+    const int width = maxima.cols;
+    const int height = maxima.rows;
+    const int mapStep = width + 2;
+    static thread_local std::vector<uchar> map;
+    map.assign(static_cast<size_t>(mapStep) * (height + 2), kNone);
+
+    const int bandRows = bandRowsFor(width, height, tiled);
+    const int bands = (height + bandRows - 1) / bandRows;
+    uchar* const base = map.data();
+    cv::parallel_for_(cv::Range(0, bands), [&](const cv::Range& range) {
+        const int y1 = std::min(range.end * bandRows, height);
+        for (int y = range.start * bandRows; y < y1; y++) {
+            classifyRow(maxima.ptr<short>(y), width, lowThreshold, highThreshold, base + (y + 1) * mapStep + 1);
+        }
+    }, bands);
+    finishCanny(base, mapStep, width, height, bandRows, tiled, edges);
+}
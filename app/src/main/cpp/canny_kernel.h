@@ -0,0 +1,116 @@
+#ifndef EDGE_CANNY_KERNEL_H
+#define EDGE_CANNY_KERNEL_H
+
+#include <opencv2/core.hpp>
+#include <cstdint>
+
+class FrameDeadline;
+
+// Canny specialized for the one configuration the pipeline uses: CV_8UC1
+// input, 3x3 Sobel, L1 gradient, replicated borders. Produces the same edge
+// map as cv::Canny(gray, edges, low, high). The gradient and non-max
+// suppression passes use NEON where the CPU has it and a scalar reference
+// otherwise; hysteresis is scalar on both.
+//
+// preBlur adds a 5x5 Gaussian (binomial 1-4-6-4-1, what cv::GaussianBlur uses
+// for ksize 5 and sigma 0) fused into the gradient pass: each blurred row is
+// produced from the source rows just before Sobel reads it and lives in a
+// three-row ring, so denoising costs arithmetic but no extra sweep over the
+// frame. Equivalent to GaussianBlur + Canny up to one LSB of blur rounding.
+void cannyU8(const cv::Mat& gray, cv::Mat& edges, int lowThreshold, int highThreshold, bool preBlur = false);
+
+// Same result as cannyU8, run as L2-sized horizontal bands: gradient and
+// suppression per band (with a 2-row halo, 4 with preBlur), hysteresis per band and then
+// stitched across band boundaries in a short serial pass. With a deadline
+// (frame_deadline.h) every band checks it first; once it passed the rest
+// are skipped and false leaves edges unwritten.
+bool cannyU8Tiled(const cv::Mat& gray, cv::Mat& edges, int lowThreshold, int highThreshold, bool preBlur = false,
+                  const FrameDeadline* deadline = nullptr);
+
+// cannyU8Tiled with hysteresis of bounded cost: at most passes sweeps down
+// and back up over bit-packed rows (64 pixels per word operation), each
+// flooding every row's weak runs from the edges of its neighbours. Its time
+// depends on the frame size only, never on how textured the scene is, where
+// the exact walk's does. A weak pixel reached only along a path that turns
+// back in y more often than the sweeps allow stays off, so the result is
+// cannyU8's minus a few pixels of such paths (with 2 passes, a few in a
+// thousand even on dense texture). The quality governor's choice when the
+// worst frame matters more than the exact map.
+bool cannyU8Bounded(const cv::Mat& gray, cv::Mat& edges, int lowThreshold, int highThreshold, bool preBlur = false,
+                    int passes = 2, const FrameDeadline* deadline = nullptr);
+
+// Canny on the color structure tensor (Di Zenzo) of an NV21 frame, so
+// boundaries between colors of equal luma are found too. vu is the
+// interleaved VU plane at half resolution ((cols + 1) / 2 x (rows + 1) / 2
+// of luma, CV_8UC2). One pass per row takes the 3x3 Sobel of the luma and of
+// both chroma planes (each chroma row once per two luma rows, its gradient
+// halved to full-resolution pixel units and shared by the two columns it
+// covers), sums the three channels' tensors and writes the square root of the
+// largest eigenvalue as the magnitude and its eigenvector as the direction.
+// Suppression and hysteresis are cannyU8's (tiled as cannyU8Tiled). On gray
+// content the magnitude is the L2 norm of the luma gradient, as in
+// cv::Canny(..., L2gradient = true), so the thresholds keep their meaning.
+void cannyU8Color(const cv::Mat& luma, const cv::Mat& vu, cv::Mat& edges, int lowThreshold, int highThreshold,
+                  bool preBlur = false, bool tiled = false);
+
+// cannyU8's gradient and non-max suppression without thresholds: maxima
+// (CV_16SC1, gray's size) receives the L1 magnitude of every pixel that is a
+// maximum along its gradient and 0 for the rest. cannyU8FromMaxima then
+// gives the edges for any pair of thresholds at the cost of classifying the
+// maxima and hysteresis, so a held image is swept by the gradient once.
+// tiled only picks the band sizes; the maxima do not depend on it.
+void cannyU8Maxima(const cv::Mat& gray, cv::Mat& maxima, bool preBlur = false, bool tiled = false);
+
+// Thresholds and hysteresis over cannyU8Maxima's output: the same edges as
+// cannyU8 (tiled: cannyU8Tiled, same result) on the image it came from
+void cannyU8FromMaxima(const cv::Mat& maxima, cv::Mat& edges, int lowThreshold, int highThreshold,
+                       bool tiled = false);
+
+// Rows per band of cannyU8Tiled: 0 (the default) derives them from the L2
+// size, anything else pins them (at least 16), e.g. to an autotuned value.
+// The edges do not depend on it, so it may change under running frames.
+void setCannyTiledBandRows(int rows);
+int cannyTiledBandRows();
+
+// Axis non-max suppression compared the pixel along, i.e. the step from the
+// pixel to the neighbour EdgeRecord::offset counts towards
+enum EdgeAxis : uint8_t {
+    EDGE_AXIS_X = 0,         // (1, 0)
+    EDGE_AXIS_Y = 1,         // (0, 1)
+    EDGE_AXIS_DIAGONAL = 2,  // (1, 1)
+    EDGE_AXIS_ANTI = 3,      // (-1, 1)
+};
+
+// One final edge pixel with what the gradient pass knew about it
+struct EdgeRecord {
+    uint16_t x;
+    uint16_t y;
+    uint8_t direction;  // gradient angle atan2(dy, dx), 256 steps per turn, y down
+    uint8_t axis;       // EdgeAxis
+    int8_t offset;      // subpixel edge position along axis, 1/128 of its step (-64..64)
+    uint8_t strength;   // L1 gradient magnitude / 8, saturated
+};
+static_assert(sizeof(EdgeRecord) == 8, "EdgeRecord is a packed 8-byte record");
+
+// Preallocated output of cannyU8Records: the caller's storage for capacity
+// records, filled in raster order; edge pixels past capacity are only counted
+struct EdgeRecordSink {
+    EdgeRecord* records = nullptr;
+    int capacity = 0;
+    int count = 0;
+    int dropped = 0;
+};
+
+// cannyU8 (tiled: cannyU8Tiled) that also emits a record per edge pixel. The
+// offset is the vertex of the parabola through the magnitudes suppression
+// compared (the pixel's and its two neighbours along axis), so it comes from
+// rows already in the gradient ring. Candidates are noted per band while the
+// ring holds their gradients and kept after hysteresis only if they became
+// edges; nothing rescans the raster.
+void cannyU8Records(const cv::Mat& gray, cv::Mat& edges, int lowThreshold, int highThreshold, bool preBlur,
+                    bool tiled, EdgeRecordSink& sink);
+
+// True when cannyU8 runs its NEON passes on this device
+bool cannyKernelUsesNeon();
+
+#endif // EDGE_CANNY_KERNEL_H
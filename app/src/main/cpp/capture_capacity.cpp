@@ -0,0 +1,161 @@
+#include "capture_capacity.h"
+#include <algorithm>
+#include <cmath>
+
+#define LOG_TAG "CaptureCapacity"
+#include "logging.h"
+
+namespace {
+
+const double kSmoothing = 0.1;     // weight of the newest frame in the EMAs
+const int kMinSamples = 30;        // before the first decision at a size
+const int kRaiseFps = 3;           // smaller raises wait, so the range does not hover
+const double kStepUpMargin = 1.25; // of maxFps the larger size must still sustain
+const double kStepUpArea = 2.0;    // area ratio of one step up
+
+// Multiples of 16, so the camera's size list has a near match
+int roundSide(double side) {
+    return std::max(16, static_cast<int>(side) / 16 * 16);
+}
+
+}  // namespace
+
+void CaptureCapacity::setEnabled(bool enabled) {
+    std::lock_guard<std::mutex> lock(mutex);
+    active = enabled;
+    samples = 0;
+    ceilingWidth = width;
+    ceilingHeight = height;
+    LOGI("🔄 Capture capacity feedback %s", enabled ? "enabled" : "disabled");
+}
+
+bool CaptureCapacity::enabled() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return active;
+}
+
+void CaptureCapacity::setParams(const Params& params) {
+    std::lock_guard<std::mutex> lock(mutex);
+    settings = params;
+    settings.minFps = std::max(1, params.minFps);
+    settings.maxFps = std::max(settings.minFps, params.maxFps);
+    settings.headroom = std::min(1.0f, std::max(0.1f, params.headroom));
+    settings.settleSeconds = std::max(0.5f, params.settleSeconds);
+    settings.minWidth = std::max(16, params.minWidth);
+}
+
+CaptureCapacity::Params CaptureCapacity::params() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return settings;
+}
+
+void CaptureCapacity::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    meanMicros = 0.0;
+    deviationMicros = 0.0;
+    samples = 0;
+    width = height = ceilingWidth = ceilingHeight = 0;
+    nextDecisionNs = 0;
+    const uint32_t generation = current.generation;
+    current = CaptureRecommendation();
+    current.generation = generation;
+}
+
+void CaptureCapacity::onFrame(int64_t captureTimestampNs, int64_t processingMicros, int frameWidth,
+                              int frameHeight) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!active || processingMicros <= 0 || frameWidth <= 0 || frameHeight <= 0) {
+        return;
+    }
+    const int64_t settleNs = static_cast<int64_t>(settings.settleSeconds * 1e9);
+    if (frameWidth != width || frameHeight != height) {
+        // New stream: the old cost says little about this one
+        width = frameWidth;
+        height = frameHeight;
+        if (static_cast<int64_t>(width) * height > static_cast<int64_t>(ceilingWidth) * ceilingHeight) {
+            ceilingWidth = width;
+            ceilingHeight = height;
+        }
+        samples = 0;
+        nextDecisionNs = captureTimestampNs + settleNs;
+    }
+    const double micros = static_cast<double>(processingMicros);
+    if (samples == 0) {
+        meanMicros = micros;
+        deviationMicros = 0.0;
+    } else {
+        deviationMicros += kSmoothing * (std::fabs(micros - meanMicros) - deviationMicros);
+        meanMicros += kSmoothing * (micros - meanMicros);
+    }
+    samples++;
+    if (samples >= kMinSamples && captureTimestampNs >= nextDecisionNs) {
+        decideLocked();
+        nextDecisionNs = captureTimestampNs + settleNs;
+    }
+}
+
+void CaptureCapacity::decideLocked() {
+    const double cost = meanMicros + 2.0 * deviationMicros;
+    const double sustainable = settings.headroom * 1e6 / cost;
+    CaptureRecommendation next = current;
+    next.minFps = settings.minFps;
+    next.maxFps = std::min(settings.maxFps, std::max(settings.minFps, static_cast<int>(sustainable)));
+    if (current.maxFps > 0 && next.maxFps > current.maxFps && next.maxFps < current.maxFps + kRaiseFps &&
+        next.maxFps < settings.maxFps) {
+        next.maxFps = current.maxFps;
+    }
+    next.width = width;
+    next.height = height;
+    if (sustainable < settings.minFps && width > settings.minWidth) {
+        // Down to the area that fits minFps
+        const double side = std::sqrt(sustainable / settings.minFps);
+        next.width = std::max(settings.minWidth, roundSide(width * side));
+        next.height = roundSide(static_cast<double>(height) * next.width / width);
+    } else if (static_cast<int64_t>(width) * height < static_cast<int64_t>(ceilingWidth) * ceilingHeight) {
+        // One step back towards the largest stream, if it would still fit
+        const double side = std::min(std::sqrt(kStepUpArea), static_cast<double>(ceilingWidth) / width);
+        const int upWidth = std::min(ceilingWidth, roundSide(width * side));
+        const int upHeight = std::min(ceilingHeight, roundSide(static_cast<double>(height) * upWidth / width));
+        const double upCost = cost * upWidth * upHeight / (static_cast<double>(width) * height);
+        if (settings.headroom * 1e6 / upCost >= settings.maxFps * kStepUpMargin) {
+            next.width = upWidth;
+            next.height = upHeight;
+        }
+    }
+    if (next.minFps != current.minFps || next.maxFps != current.maxFps || next.width != current.width ||
+        next.height != current.height) {
+        LOGI("🔄 Capture recommendation: %d-%d fps at %dx%d (processing %.1f ms, sustains %.1f fps at %dx%d)",
+             next.minFps, next.maxFps, next.width, next.height, cost / 1000.0, sustainable, width, height);
+        publishLocked(next);
+    }
+}
+
+void CaptureCapacity::publishLocked(const CaptureRecommendation& next) {
+    current = next;
+    current.generation++;
+    changed.notify_all();
+}
+
+CaptureRecommendation CaptureCapacity::recommendation() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return current;
+}
+
+double CaptureCapacity::sustainableFps() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return samples > 0 ? settings.headroom * 1e6 / (meanMicros + 2.0 * deviationMicros) : 0.0;
+}
+
+bool CaptureCapacity::waitForChange(uint32_t seen, std::chrono::milliseconds timeout, CaptureRecommendation& next) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!changed.wait_for(lock, timeout, [this, seen] { return current.generation != seen; })) {
+        return false;
+    }
+    next = current;
+    return true;
+}
+
+CaptureCapacity& captureCapacity() {
+    static CaptureCapacity capacity;
+    return capacity;
+}
@@ -0,0 +1,80 @@
+#ifndef EDGE_CAPTURE_CAPACITY_H
+#define EDGE_CAPTURE_CAPACITY_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+// Capture settings processing can keep up with
+struct CaptureRecommendation {
+    int minFps = 0;          // AE target fps range; 0 = no recommendation yet
+    int maxFps = 0;
+    int width = 0;           // stream size, aspect of the current stream; 0 = keep
+    int height = 0;
+    uint32_t generation = 0; // bumped on every change
+};
+
+// Closes the loop from processing back to the camera. Where the quality
+// governor cheapens processing to fit the frame rate, this lowers the frame
+// rate and stream size to fit processing: frames the pipeline would drop or
+// skip are then never captured, which saves ISP, memory bandwidth and power.
+//
+// Fed the processing time of every frame of the default pipeline. The
+// smoothed cost (mean plus two mean deviations, so jitter counts) gives the
+// rate processing sustains within headroom of the frame interval; every
+// settle window it becomes the recommended AE range, clamped to the
+// configured one. When even minFps does not fit, the stream size steps down
+// (cost taken as proportional to area); when the largest size seen since
+// enabling would fit at maxFps with room to spare, it steps back up. The
+// camera controller applies the recommendation (NativeCamera follows it on
+// its own; a Java controller polls nativeGetCaptureRecommendation).
+class CaptureCapacity {
+public:
+    struct Params {
+        int minFps = 15;
+        int maxFps = 30;
+        float headroom = 0.85f;      // share of the frame interval processing may use
+        float settleSeconds = 2.0f;  // between decisions, and after a stream size change
+        int minWidth = 320;          // smallest stream width recommended
+    };
+
+    void setEnabled(bool enabled);
+    bool enabled() const;
+    void setParams(const Params& params);
+    Params params();
+    void reset();
+
+    // One processed frame: its capture time (CLOCK_BOOTTIME), processing time
+    // and camera size. A new size restarts the estimate.
+    void onFrame(int64_t captureTimestampNs, int64_t processingMicros, int width, int height);
+
+    CaptureRecommendation recommendation();
+    double sustainableFps();  // current estimate at the current size; 0 before any
+
+    // Blocks until the recommendation's generation differs from seen or the
+    // timeout passes; true with next filled on a change
+    bool waitForChange(uint32_t seen, std::chrono::milliseconds timeout, CaptureRecommendation& next);
+
+private:
+    void decideLocked();
+    void publishLocked(const CaptureRecommendation& next);
+
+    mutable std::mutex mutex;
+    std::condition_variable changed;
+    Params settings;
+    bool active = false;
+    double meanMicros = 0.0;        // EMA of processing time
+    double deviationMicros = 0.0;   // EMA of its absolute deviation
+    int samples = 0;
+    int width = 0;                  // current stream
+    int height = 0;
+    int ceilingWidth = 0;           // largest stream seen since enabled
+    int ceilingHeight = 0;
+    int64_t nextDecisionNs = 0;
+    CaptureRecommendation current;
+};
+
+CaptureCapacity& captureCapacity();
+
+#endif // EDGE_CAPTURE_CAPACITY_H
@@ -0,0 +1,102 @@
+#include "capture_metadata.h"
+#include "metrics.h"
+#include <algorithm>
+
+#define LOG_TAG "CaptureMetadata"
+#include "logging.h"
+
+namespace {
+
+// camera2 CONTROL_AF_STATE / CONTROL_AE_STATE values
+const int kAfPassiveScan = 1;
+const int kAfActiveScan = 3;
+const int kAeSearching = 1;
+const int kAePrecapture = 5;
+
+// A result this much older than the frame belongs to another capture
+// (two frames at 30 fps)
+const int64_t kMatchWindowNs = 70000000;
+
+} // namespace
+
+bool captureUnsettled(const CaptureMetadata& metadata) {
+    return metadata.afState == kAfPassiveScan || metadata.afState == kAfActiveScan ||
+           metadata.aeState == kAeSearching || metadata.aeState == kAePrecapture || metadata.lensMoving;
+}
+
+void CaptureMetadataGate::setParams(const Params& params) {
+    std::lock_guard<std::mutex> lock(mutex);
+    current = params;
+    current.settleFrames = std::max(params.settleFrames, 0);
+    settleLeft = 0;
+    activePolicy.store(params.policy, std::memory_order_relaxed);
+    LOGI("🔄 Capture metadata policy %d, settle %d frames", params.policy, current.settleFrames);
+}
+
+CaptureMetadataGate::Params CaptureMetadataGate::params() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return current;
+}
+
+void CaptureMetadataGate::note(const CaptureMetadata& metadata) {
+    if (metadata.timestampNs <= 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    history[next] = metadata;
+    next = (next + 1) % kHistory;
+}
+
+bool CaptureMetadataGate::lookupLocked(int64_t timestampNs, CaptureMetadata& metadata) const {
+    const CaptureMetadata* best = nullptr;
+    for (const CaptureMetadata& entry : history) {
+        if (entry.timestampNs <= 0 || entry.timestampNs > timestampNs ||
+            timestampNs - entry.timestampNs > kMatchWindowNs) {
+            continue;
+        }
+        if (!best || entry.timestampNs > best->timestampNs) {
+            best = &entry;
+        }
+    }
+    if (!best) {
+        return false;
+    }
+    metadata = *best;
+    return true;
+}
+
+bool CaptureMetadataGate::lookup(int64_t timestampNs, CaptureMetadata& metadata) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return lookupLocked(timestampNs, metadata);
+}
+
+CaptureMetadataGate::Decision CaptureMetadataGate::decide(int64_t timestampNs) {
+    if (!enabled()) {
+        return PROCESS;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    CaptureMetadata metadata;
+    if (!lookupLocked(timestampNs, metadata)) {
+        unmatched.fetch_add(1, std::memory_order_relaxed);
+        return PROCESS;
+    }
+    if (captureUnsettled(metadata)) {
+        settleLeft = current.settleFrames;
+    } else if (settleLeft > 0) {
+        settleLeft--;  // exposure and focus land a frame or two behind the state
+    } else {
+        return PROCESS;
+    }
+    if (current.policy == DROP) {
+        skipped.fetch_add(1, std::memory_order_relaxed);
+        metrics().increment(Counter::FRAMES_UNSETTLED_SKIPPED);
+        return SKIP;
+    }
+    cheapened.fetch_add(1, std::memory_order_relaxed);
+    return CHEAP;
+}
+
+CaptureMetadataGate& captureMetadataGate() {
+    static CaptureMetadataGate gate;
+    return gate;
+}
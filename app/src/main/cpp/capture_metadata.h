@@ -0,0 +1,83 @@
+#ifndef EDGE_CAPTURE_METADATA_H
+#define EDGE_CAPTURE_METADATA_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+// What the camera reported about one capture (its CaptureResult). The states
+// are the camera2 values, identical in the NDK and in Java.
+struct CaptureMetadata {
+    int64_t timestampNs = 0;  // SENSOR_TIMESTAMP, the same clock as the frame's
+    int afState = -1;         // CONTROL_AF_STATE, -1 = not reported
+    int aeState = -1;         // CONTROL_AE_STATE, -1 = not reported
+    bool lensMoving = false;  // LENS_STATE == MOVING
+};
+
+// Edges of a frame taken while autofocus sweeps or auto-exposure converges
+// are thrown away a frame later, so they are not worth full price. Capture
+// results are noted as they arrive (before or after their image) and each
+// processed frame asks for a decision by its timestamp: a frame is
+// unsettled when its capture was scanning focus, searching exposure or
+// moving the lens, and for settleFrames frames after. Unsettled frames are
+// dropped (the last published edges stay on screen) or processed the cheap
+// way, by policy. Frames without a matching result are always processed.
+class CaptureMetadataGate {
+public:
+    enum Policy : int {
+        OFF = 0,
+        DROP = 1,     // not processed at all
+        CHEAPEN = 2,  // FAST_EDGES instead of Canny
+    };
+
+    enum Decision : int {
+        PROCESS = 0,
+        SKIP = 1,
+        CHEAP = 2,
+    };
+
+    struct Params {
+        Policy policy = OFF;
+        int settleFrames = 2;
+    };
+
+    void setParams(const Params& params);
+    Params params();
+    bool enabled() const { return activePolicy.load(std::memory_order_relaxed) != OFF; }
+
+    // From the camera's capture callback; any thread
+    void note(const CaptureMetadata& metadata);
+    // The result of the capture at timestampNs, or the newest one before it
+    // within a frame or two; false when none is known
+    bool lookup(int64_t timestampNs, CaptureMetadata& metadata);
+    // Once per processed frame, in capture order; PROCESS while OFF
+    Decision decide(int64_t timestampNs);
+
+    uint64_t skippedCount() const { return skipped.load(std::memory_order_relaxed); }
+    uint64_t cheapenedCount() const { return cheapened.load(std::memory_order_relaxed); }
+    uint64_t unmatchedCount() const { return unmatched.load(std::memory_order_relaxed); }
+
+private:
+    static const int kHistory = 16;
+
+    bool lookupLocked(int64_t timestampNs, CaptureMetadata& metadata) const;
+
+    std::mutex mutex;
+    Params current;
+    CaptureMetadata history[kHistory];
+    int next = 0;
+    int settleLeft = 0;
+
+    std::atomic<int> activePolicy{OFF};
+    std::atomic<uint64_t> skipped{0};
+    std::atomic<uint64_t> cheapened{0};
+    std::atomic<uint64_t> unmatched{0};
+};
+
+// True while the capture was still adjusting (see CaptureMetadataGate)
+bool captureUnsettled(const CaptureMetadata& metadata);
+
+// Fed by the native camera and nativeSetCaptureMetadata
+CaptureMetadataGate& captureMetadataGate();
+
+#endif // EDGE_CAPTURE_METADATA_H
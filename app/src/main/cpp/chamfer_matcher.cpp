@@ -0,0 +1,210 @@
+#include "chamfer_matcher.h"
+#include <opencv2/core/utility.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+const int kMaxDownscale = 8;       // INTER_AREA keeps a lone edge pixel nonzero up to 8x8 blocks
+const float kDistanceUnits = 4.0f; // distance map values per reduced pixel
+const int kMinEdgeFraction = 4;    // a window needs 1/4 of the template's edge count
+
+// Best placement per window row: every row is independent, so rows are
+// split across threads and reduced afterwards
+class PlacementBody : public cv::ParallelLoopBody {
+public:
+    PlacementBody(const cv::Mat& distance, const cv::Mat& integral, const cv::Size& size,
+                  const std::vector<int>& offsets, int minEdges, std::vector<int64_t>& rowSums,
+                  std::vector<int>& rowColumns)
+        : distance(distance), integral(integral), size(size), offsets(offsets), minEdges(minEdges),
+          rowSums(rowSums), rowColumns(rowColumns) {}
+
+    void operator()(const cv::Range& range) const override {
+        const int columns = distance.cols - size.width + 1;
+        const int* offset = offsets.data();
+        const size_t count = offsets.size();
+        for (int y = range.start; y < range.end; y++) {
+            const int* top = integral.ptr<int>(y);
+            const int* bottom = integral.ptr<int>(y + size.height);
+            const uint8_t* row = distance.ptr<uint8_t>(y);
+            int64_t best = std::numeric_limits<int64_t>::max();
+            int bestX = -1;
+            for (int x = 0; x < columns; x++) {
+                const int edges = bottom[x + size.width] - bottom[x] - top[x + size.width] + top[x];
+                if (edges < minEdges) {
+                    continue;
+                }
+                const uint8_t* base = row + x;
+                int64_t sum = 0;
+                size_t i = 0;
+                // Gathered in runs of 16 between early-out tests
+                while (i < count && sum < best) {
+                    const size_t end = std::min(count, i + 16);
+                    for (; i < end; i++) {
+                        sum += base[offset[i]];
+                    }
+                }
+                if (i == count && sum < best) {
+                    best = sum;
+                    bestX = x;
+                }
+            }
+            rowSums[static_cast<size_t>(y)] = best;
+            rowColumns[static_cast<size_t>(y)] = bestX;
+        }
+    }
+
+private:
+    const cv::Mat& distance;
+    const cv::Mat& integral;
+    const cv::Size size;
+    const std::vector<int>& offsets;
+    const int minEdges;
+    std::vector<int64_t>& rowSums;
+    std::vector<int>& rowColumns;
+};
+
+} // namespace
+
+void ChamferMatcher::setParams(const Params& params) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const int downscale = std::min(std::max(params.downscale, 1), kMaxDownscale);
+    if (downscale != current.downscale) {
+        for (Template& entry : templates) {
+            entry.points.clear();  // rebuilt at the new resolution on the next match
+        }
+    }
+    current = params;
+    current.downscale = downscale;
+}
+
+bool ChamferMatcher::addTemplate(int id, const cv::Mat& edges) {
+    if (edges.empty() || edges.type() != CV_8UC1 || edges.cols > kMaxTemplateSide ||
+        edges.rows > kMaxTemplateSide || cv::countNonZero(edges) == 0) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    auto existing = std::find_if(templates.begin(), templates.end(),
+                                 [id](const Template& entry) { return entry.id == id; });
+    if (existing == templates.end()) {
+        if (templates.size() >= static_cast<size_t>(kMaxTemplates)) {
+            return false;
+        }
+        existing = templates.insert(templates.end(), Template());
+    }
+    *existing = Template();
+    existing->id = id;
+    existing->source = edges.clone();
+    return true;
+}
+
+void ChamferMatcher::clearTemplates() {
+    std::lock_guard<std::mutex> lock(mutex);
+    templates.clear();
+}
+
+cv::Size ChamferMatcher::distanceSize(const cv::Size& edgeSize) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return cv::Size(std::max(1, edgeSize.width / current.downscale),
+                    std::max(1, edgeSize.height / current.downscale));
+}
+
+// Block OR at the current downscale: 255 where any pixel of the block is an edge
+void ChamferMatcher::reduce(const cv::Mat& edges, cv::Mat& reduced) const {
+    const int downscale = current.downscale;
+    const cv::Size size(std::max(1, edges.cols / downscale), std::max(1, edges.rows / downscale));
+    if (downscale == 1) {
+        cv::compare(edges, 0, reduced, cv::CMP_NE);
+        return;
+    }
+    cv::resize(edges, reduced, size, 0, 0, cv::INTER_AREA);
+    cv::compare(reduced, 0, reduced, cv::CMP_NE);
+}
+
+void ChamferMatcher::prepare(Template& entry) const {
+    cv::Mat reduced;
+    reduce(entry.source, reduced);
+    entry.size = reduced.size();
+    cv::findNonZero(reduced, entry.points);
+    entry.offsets.clear();
+    entry.offsetStep = 0;
+    entry.minEdges = std::max<int>(1, static_cast<int>(entry.points.size()) / kMinEdgeFraction);
+}
+
+ChamferMatcher::Match ChamferMatcher::search(Template& entry, const cv::Mat& distance) {
+    Match result;
+    result.id = entry.id;
+    result.score = 255 / kDistanceUnits * current.downscale;
+    if (entry.points.empty()) {
+        prepare(entry);
+    }
+    if (entry.points.empty() || entry.size.width > distance.cols || entry.size.height > distance.rows) {
+        return result;
+    }
+    if (entry.offsetStep != distance.step1()) {
+        entry.offsetStep = distance.step1();
+        entry.offsets.resize(entry.points.size());
+        for (size_t i = 0; i < entry.points.size(); i++) {
+            entry.offsets[i] = entry.points[i].y * static_cast<int>(entry.offsetStep) + entry.points[i].x;
+        }
+    }
+
+    const int rows = distance.rows - entry.size.height + 1;
+    std::vector<int64_t> rowSums(static_cast<size_t>(rows));
+    std::vector<int> rowColumns(static_cast<size_t>(rows));
+    cv::parallel_for_(cv::Range(0, rows), PlacementBody(distance, edgeIntegral, entry.size, entry.offsets,
+                                                        entry.minEdges, rowSums, rowColumns));
+    int bestY = -1;
+    for (int y = 0; y < rows; y++) {
+        if (rowColumns[static_cast<size_t>(y)] >= 0 &&
+            (bestY < 0 || rowSums[static_cast<size_t>(y)] < rowSums[static_cast<size_t>(bestY)])) {
+            bestY = y;
+        }
+    }
+    if (bestY < 0) {
+        return result;  // no window with enough edges
+    }
+    const int downscale = current.downscale;
+    const int bestX = rowColumns[static_cast<size_t>(bestY)];
+    result.score = static_cast<float>(rowSums[static_cast<size_t>(bestY)]) /
+                   (kDistanceUnits * static_cast<float>(entry.points.size())) * downscale;
+    result.box = cv::Rect(bestX * downscale, bestY * downscale, entry.source.cols, entry.source.rows);
+    result.accepted = result.score <= current.acceptDistance;
+    return result;
+}
+
+int ChamferMatcher::match(const cv::Mat& edges, cv::Mat& distance, Match* matches, int maxMatches) {
+    std::lock_guard<std::mutex> lock(mutex);
+    CV_Assert(edges.type() == CV_8UC1 && distance.type() == CV_8UC1);
+    reduce(edges, reducedEdges);
+    CV_Assert(distance.size() == reducedEdges.size());
+
+    // Distance to the nearest edge of every reduced pixel; DIST_L2 with the
+    // 3x3 mask is the two-weight chamfer metric, not the exact Euclidean one
+    cv::compare(reducedEdges, 0, nonEdges, cv::CMP_EQ);
+    cv::distanceTransform(nonEdges, distanceF, current.metric == Metric::L1 ? cv::DIST_L1 : cv::DIST_L2,
+                          cv::DIST_MASK_3, CV_32F);
+    distanceF.convertTo(distance, CV_8U, kDistanceUnits);  // saturating: far misses cost the same
+
+    int count = 0;
+    if (!templates.empty() && maxMatches > 0) {
+        reducedEdges.convertTo(edgeFlags, CV_8U, 1.0 / 255);  // counts, so the sums cannot overflow
+        cv::integral(edgeFlags, edgeIntegral, CV_32S);
+        for (Template& entry : templates) {
+            if (count == maxMatches) {
+                break;
+            }
+            Match found = search(entry, distance);
+            if (!found.box.empty()) {
+                matches[count++] = found;
+            }
+        }
+    }
+    return count;
+}
+
+ChamferMatcher& chamferMatcher() {
+    static ChamferMatcher matcher;
+    return matcher;
+}
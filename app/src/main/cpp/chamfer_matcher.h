@@ -0,0 +1,85 @@
+#ifndef EDGE_CHAMFER_MATCHER_H
+#define EDGE_CHAMFER_MATCHER_H
+
+#include <opencv2/core.hpp>
+#include <mutex>
+#include <vector>
+
+// Part-presence checks against preloaded edge templates. The edge map is
+// reduced to 1/downscale per axis (a reduced pixel is an edge when any pixel
+// of its block is), its distance transform is taken, and every template is
+// slid over it: a placement scores the mean distance from the template's
+// edge pixels to the nearest image edge, so a present part scores near 0.
+// Templates are kept as flat offsets into the distance map, which makes a
+// placement a gather and a sum; an integral image of the reduced edges skips
+// windows with too few edges to match before any distance is read.
+class ChamferMatcher {
+public:
+    enum class Metric : int {
+        L1 = 0,          // city-block distance, exact
+        CHAMFER_3X3 = 1  // 3x3 chamfer approximation of the Euclidean distance
+    };
+
+    struct Params {
+        int downscale = 2;           // matching runs at 1/downscale of the edge map per axis
+        Metric metric = Metric::CHAMFER_3X3;
+        float acceptDistance = 1.5f; // mean edge distance (edge-map pixels) a present part stays under
+    };
+
+    // Best placement of one template, in edge-map pixels
+    struct Match {
+        int id = 0;
+        float score = 0;   // mean edge distance in edge-map pixels
+        cv::Rect box;
+        bool accepted = false;
+    };
+
+    static const int kMaxTemplates = 32;
+    static const int kMaxTemplateSide = 512;
+
+    void setParams(const Params& params);
+
+    // Stores a binary edge template (CV_8UC1, nonzero = edge) at edge-map
+    // resolution under id, replacing one with the same id. False when it has
+    // no edges, is too large or the table is full.
+    bool addTemplate(int id, const cv::Mat& edges);
+    void clearTemplates();
+
+    // Size of the distance map match() writes for an edge map of edgeSize
+    cv::Size distanceSize(const cv::Size& edgeSize);
+
+    // Distance transform of edges (CV_8UC1) into distance, which must already
+    // be distanceSize(edges.size()) and CV_8UC1, in quarter reduced pixels
+    // saturating at 255; then the best placement of each template that fits
+    // into matches. Returns the number of matches written (at most maxMatches).
+    int match(const cv::Mat& edges, cv::Mat& distance, Match* matches, int maxMatches);
+
+private:
+    struct Template {
+        int id = 0;
+        cv::Mat source;             // as added, for rebuilding at another downscale
+        cv::Size size;              // at the reduced resolution
+        std::vector<cv::Point> points;  // reduced edge pixels, raster order
+        std::vector<int> offsets;   // points as offsets into the distance map at offsetStep
+        size_t offsetStep = 0;
+        int minEdges = 0;           // reduced image edges a window needs to be scored
+    };
+
+    void reduce(const cv::Mat& edges, cv::Mat& reduced) const;
+    void prepare(Template& entry) const;
+    Match search(Template& entry, const cv::Mat& distance);
+
+    std::mutex mutex;
+    Params current;
+    std::vector<Template> templates;
+    cv::Mat reducedEdges;
+    cv::Mat nonEdges;
+    cv::Mat distanceF;
+    cv::Mat edgeFlags;
+    cv::Mat edgeIntegral;
+};
+
+// Matcher used by the CHAMFER_MATCH render mode
+ChamferMatcher& chamferMatcher();
+
+#endif // EDGE_CHAMFER_MATCHER_H
@@ -0,0 +1,375 @@
+#include "cl_gl_interop.h"
+#include "tracing.h"
+
+#define LOG_TAG "ClGlInterop"
+#include "logging.h"
+
+#ifdef EDGE_CL_GL_INTEROP
+
+#include <CL/cl.h>
+#include <CL/cl_gl.h>
+#include <EGL/egl.h>
+#include <GLES2/gl2.h>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Same arithmetic as the GLSL passes in opengl_renderer.cpp; every
+// intermediate is an RGBA8 image like the GL render targets
+const char kEdgeProgram[] = R"(
+__constant sampler_t kSampler = CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_NEAREST;
+
+float px(__read_only image2d_t image, int2 pos, int dx, int dy) {
+    return read_imagef(image, kSampler, pos + (int2)(dx, dy)).x;
+}
+
+// BT.601 luma of the camera frame, 3x3 Gaussian [1 2 1] x [1 2 1] / 16
+__kernel void blurLuma(__read_only image2d_t input, __write_only image2d_t output) {
+    const int2 pos = (int2)(get_global_id(0), get_global_id(1));
+    const float4 weights = (float4)(0.299f, 0.587f, 0.114f, 0.0f);
+    float sum = 0.0f;
+    for (int dy = -1; dy <= 1; dy++) {
+        for (int dx = -1; dx <= 1; dx++) {
+            float w = (dx == 0 ? 2.0f : 1.0f) * (dy == 0 ? 2.0f : 1.0f);
+            sum += w * dot(read_imagef(input, kSampler, pos + (int2)(dx, dy)), weights);
+        }
+    }
+    float c = sum / 16.0f;
+    write_imagef(output, pos, (float4)(c, c, c, 1.0f));
+}
+
+// x = L1 magnitude / 4, y = direction sector / 3, quantized like cv::Canny
+__kernel void sobel(__read_only image2d_t input, __write_only image2d_t output) {
+    const int2 pos = (int2)(get_global_id(0), get_global_id(1));
+    float tl = px(input, pos, -1, -1), t = px(input, pos, 0, -1), tr = px(input, pos, 1, -1);
+    float l = px(input, pos, -1, 0), r = px(input, pos, 1, 0);
+    float bl = px(input, pos, -1, 1), b = px(input, pos, 0, 1), br = px(input, pos, 1, 1);
+    float gx = (tr + 2.0f * r + br) - (tl + 2.0f * l + bl);
+    float gy = (bl + 2.0f * b + br) - (tl + 2.0f * t + tr);
+    float ax = fabs(gx);
+    float ay = fabs(gy);
+    float sector;
+    if (ay < ax * 0.4142f) {
+        sector = 0.0f;
+    } else if (ay > ax * 2.4142f) {
+        sector = 2.0f;
+    } else {
+        sector = gx * gy > 0.0f ? 1.0f : 3.0f;
+    }
+    write_imagef(output, pos, (float4)(fmin((ax + ay) / 4.0f, 1.0f), sector / 3.0f, 0.0f, 1.0f));
+}
+
+// Local maxima along the gradient; 1 strong, 0.5 weak, 0 none
+__kernel void suppress(__read_only image2d_t input, __write_only image2d_t output, float low, float high) {
+    const int2 pos = (int2)(get_global_id(0), get_global_id(1));
+    float4 g = read_imagef(input, kSampler, pos);
+    int sector = (int)(g.y * 3.0f + 0.5f);
+    int2 step = (int2)(1, 0);
+    if (sector == 1) {
+        step = (int2)(1, 1);
+    } else if (sector == 2) {
+        step = (int2)(0, 1);
+    } else if (sector == 3) {
+        step = (int2)(1, -1);
+    }
+    float a = read_imagef(input, kSampler, pos + step).x;
+    float b = read_imagef(input, kSampler, pos - step).x;
+    float m = g.x * 4.0f;
+    float e = 0.0f;
+    if (g.x > a && g.x >= b) {
+        e = m > high ? 1.0f : (m > low ? 0.5f : 0.0f);
+    }
+    write_imagef(output, pos, (float4)(e, e, e, 1.0f));
+}
+
+// Single-step hysteresis: weak pixels survive next to a strong one
+__kernel void hysteresis(__read_only image2d_t input, __write_only image2d_t output) {
+    const int2 pos = (int2)(get_global_id(0), get_global_id(1));
+    float c = px(input, pos, 0, 0);
+    float e = 0.0f;
+    if (c > 0.75f) {
+        e = 1.0f;
+    } else if (c > 0.25f) {
+        float n = 0.0f;
+        for (int dy = -1; dy <= 1; dy++) {
+            for (int dx = -1; dx <= 1; dx++) {
+                n = fmax(n, px(input, pos, dx, dy));
+            }
+        }
+        e = n > 0.75f ? 1.0f : 0.0f;
+    }
+    write_imagef(output, pos, (float4)(e, e, e, 1.0f));
+}
+)";
+
+enum Kernel { BLUR, SOBEL, SUPPRESS, HYSTERESIS, KERNEL_COUNT };
+const char* const kKernelNames[KERNEL_COUNT] = {"blurLuma", "sobel", "suppress", "hysteresis"};
+
+// A GL texture wrapped as a CL image; rebuilt when the texture or its size changes
+struct SharedImage {
+    GLuint texture = 0;
+    int width = 0;
+    int height = 0;
+    cl_mem image = nullptr;
+};
+
+// Bound to the GL context current on the rendering thread, so per thread
+thread_local bool initialized = false;   // init attempted since the last release
+thread_local bool available = false;
+thread_local cl_context context = nullptr;
+thread_local cl_command_queue queue = nullptr;
+thread_local cl_program program = nullptr;
+thread_local cl_kernel kernels[KERNEL_COUNT] = {};
+thread_local SharedImage sharedInput;
+thread_local SharedImage sharedOutput;
+thread_local cl_mem blurred = nullptr;    // frame-sized intermediates
+thread_local cl_mem gradient = nullptr;
+thread_local cl_mem classes = nullptr;
+thread_local int intermediateWidth = 0;
+thread_local int intermediateHeight = 0;
+
+void releaseMem(cl_mem& mem) {
+    if (mem) {
+        clReleaseMemObject(mem);
+        mem = nullptr;
+    }
+}
+
+bool hasExtension(const std::string& extensions, const char* name) {
+    return extensions.find(name) != std::string::npos;
+}
+
+std::string deviceString(cl_device_id device, cl_device_info param) {
+    size_t size = 0;
+    if (clGetDeviceInfo(device, param, 0, nullptr, &size) != CL_SUCCESS || size == 0) {
+        return std::string();
+    }
+    std::vector<char> value(size);
+    clGetDeviceInfo(device, param, size, value.data(), nullptr);
+    return std::string(value.data());
+}
+
+bool createContext() {
+    EGLDisplay display = eglGetCurrentDisplay();
+    EGLContext glContext = eglGetCurrentContext();
+    if (display == EGL_NO_DISPLAY || glContext == EGL_NO_CONTEXT) {
+        LOGE("No current EGL context for CL-GL sharing");
+        return false;
+    }
+    cl_platform_id platform = nullptr;
+    cl_uint platformCount = 0;
+    if (clGetPlatformIDs(1, &platform, &platformCount) != CL_SUCCESS || platformCount == 0) {
+        LOGW("No OpenCL platform, CL-GL interop unavailable");
+        return false;
+    }
+    cl_context_properties properties[] = {
+            CL_GL_CONTEXT_KHR, reinterpret_cast<cl_context_properties>(glContext),
+            CL_EGL_DISPLAY_KHR, reinterpret_cast<cl_context_properties>(display),
+            CL_CONTEXT_PLATFORM, reinterpret_cast<cl_context_properties>(platform),
+            0};
+    cl_int error = CL_SUCCESS;
+    context = clCreateContextFromType(properties, CL_DEVICE_TYPE_GPU, nullptr, nullptr, &error);
+    if (error != CL_SUCCESS) {
+        LOGW("GL-sharing CL context failed: %d", error);
+        return false;
+    }
+    cl_device_id device = nullptr;
+    if (clGetContextInfo(context, CL_CONTEXT_DEVICES, sizeof(device), &device, nullptr) != CL_SUCCESS) {
+        return false;
+    }
+    if (!hasExtension(deviceString(device, CL_DEVICE_EXTENSIONS), "cl_khr_gl_sharing")) {
+        LOGW("OpenCL device has no cl_khr_gl_sharing");
+        return false;
+    }
+    queue = clCreateCommandQueue(context, device, 0, &error);
+    if (error != CL_SUCCESS) {
+        LOGE("clCreateCommandQueue failed: %d", error);
+        return false;
+    }
+
+    const char* source = kEdgeProgram;
+    program = clCreateProgramWithSource(context, 1, &source, nullptr, &error);
+    if (error != CL_SUCCESS) {
+        return false;
+    }
+    if (clBuildProgram(program, 1, &device, nullptr, nullptr, nullptr) != CL_SUCCESS) {
+        char log[2048] = {};
+        clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_LOG, sizeof(log) - 1, log, nullptr);
+        LOGE("CL edge program build failed:\n%s", log);
+        return false;
+    }
+    // Built once; the sample's per-frame cl::Kernel construction is what its TODO is about
+    for (int i = 0; i < KERNEL_COUNT; i++) {
+        kernels[i] = clCreateKernel(program, kKernelNames[i], &error);
+        if (error != CL_SUCCESS) {
+            LOGE("clCreateKernel(%s) failed: %d", kKernelNames[i], error);
+            return false;
+        }
+    }
+    LOGI("CL-GL interop ready on %s (%s)", deviceString(device, CL_DEVICE_NAME).c_str(),
+         deviceString(device, CL_DEVICE_VERSION).c_str());
+    return true;
+}
+
+bool ensureShared(SharedImage& shared, GLuint texture, int width, int height, cl_mem_flags flags) {
+    if (shared.image && shared.texture == texture && shared.width == width && shared.height == height) {
+        return true;
+    }
+    releaseMem(shared.image);
+    cl_int error = CL_SUCCESS;
+    shared.image = clCreateFromGLTexture(context, flags, GL_TEXTURE_2D, 0, texture, &error);
+    if (error != CL_SUCCESS) {
+        LOGE_RATELIMITED("clCreateFromGLTexture(%u) failed: %d", texture, error);
+        shared.image = nullptr;
+        return false;
+    }
+    shared.texture = texture;
+    shared.width = width;
+    shared.height = height;
+    return true;
+}
+
+bool ensureIntermediates(int width, int height) {
+    if (blurred && intermediateWidth == width && intermediateHeight == height) {
+        return true;
+    }
+    releaseMem(blurred);
+    releaseMem(gradient);
+    releaseMem(classes);
+    cl_image_format format = {CL_RGBA, CL_UNORM_INT8};
+    cl_image_desc desc;
+    std::memset(&desc, 0, sizeof(desc));
+    desc.image_type = CL_MEM_OBJECT_IMAGE2D;
+    desc.image_width = static_cast<size_t>(width);
+    desc.image_height = static_cast<size_t>(height);
+    cl_mem* targets[] = {&blurred, &gradient, &classes};
+    for (cl_mem* target : targets) {
+        cl_int error = CL_SUCCESS;
+        *target = clCreateImage(context, CL_MEM_READ_WRITE, &format, &desc, nullptr, &error);
+        if (error != CL_SUCCESS) {
+            LOGE("clCreateImage %dx%d failed: %d", width, height, error);
+            *target = nullptr;
+            return false;
+        }
+    }
+    intermediateWidth = width;
+    intermediateHeight = height;
+    return true;
+}
+
+cl_int enqueuePass(Kernel kernel, cl_mem input, cl_mem output, int width, int height) {
+    cl_int error = clSetKernelArg(kernels[kernel], 0, sizeof(cl_mem), &input);
+    error |= clSetKernelArg(kernels[kernel], 1, sizeof(cl_mem), &output);
+    if (error != CL_SUCCESS) {
+        return error;
+    }
+    size_t global[2] = {static_cast<size_t>(width), static_cast<size_t>(height)};
+    return clEnqueueNDRangeKernel(queue, kernels[kernel], 2, nullptr, global, nullptr, 0, nullptr, nullptr);
+}
+
+} // namespace
+
+bool clGlInteropInit() {
+    if (!initialized) {
+        initialized = true;
+        available = createContext();
+        if (!available) {
+            clGlInteropRelease();
+            initialized = true;   // keep the answer until the next GL context
+        }
+    }
+    return available;
+}
+
+bool clGlDetectEdges(GLuint input, GLuint output, int width, int height, float low, float high) {
+    if (!clGlInteropInit() ||
+        !ensureShared(sharedInput, input, width, height, CL_MEM_READ_ONLY) ||
+        !ensureShared(sharedOutput, output, width, height, CL_MEM_WRITE_ONLY) ||
+        !ensureIntermediates(width, height)) {
+        return false;
+    }
+
+    // Without cl_khr_gl_event, GL work on the input must be complete first
+    {
+        ScopedTrace trace("cl_gl_finish");
+        glFinish();
+    }
+    cl_mem shared[2] = {sharedInput.image, sharedOutput.image};
+    cl_int error = clEnqueueAcquireGLObjects(queue, 2, shared, 0, nullptr, nullptr);
+    if (error == CL_SUCCESS) {
+        error = enqueuePass(BLUR, sharedInput.image, blurred, width, height);
+    }
+    if (error == CL_SUCCESS) {
+        error = enqueuePass(SOBEL, blurred, gradient, width, height);
+    }
+    if (error == CL_SUCCESS) {
+        error = clSetKernelArg(kernels[SUPPRESS], 2, sizeof(float), &low);
+        error |= clSetKernelArg(kernels[SUPPRESS], 3, sizeof(float), &high);
+    }
+    if (error == CL_SUCCESS) {
+        error = enqueuePass(SUPPRESS, gradient, classes, width, height);
+    }
+    if (error == CL_SUCCESS) {
+        error = enqueuePass(HYSTERESIS, classes, sharedOutput.image, width, height);
+    }
+    cl_int releaseError = clEnqueueReleaseGLObjects(queue, 2, shared, 0, nullptr, nullptr);
+    clFinish(queue);
+    if (error != CL_SUCCESS || releaseError != CL_SUCCESS) {
+        LOGE_RATELIMITED("CL edge passes failed: %d / %d", error, releaseError);
+        return false;
+    }
+    return true;
+}
+
+void clGlInteropRelease() {
+    releaseMem(sharedInput.image);
+    releaseMem(sharedOutput.image);
+    sharedInput = SharedImage();
+    sharedOutput = SharedImage();
+    releaseMem(blurred);
+    releaseMem(gradient);
+    releaseMem(classes);
+    intermediateWidth = 0;
+    intermediateHeight = 0;
+    for (cl_kernel& kernel : kernels) {
+        if (kernel) {
+            clReleaseKernel(kernel);
+            kernel = nullptr;
+        }
+    }
+    if (program) {
+        clReleaseProgram(program);
+        program = nullptr;
+    }
+    if (queue) {
+        clReleaseCommandQueue(queue);
+        queue = nullptr;
+    }
+    if (context) {
+        clReleaseContext(context);
+        context = nullptr;
+    }
+    initialized = false;
+    available = false;
+}
+
+#else  // !EDGE_CL_GL_INTEROP
+
+bool clGlInteropInit() {
+    static bool logged = false;
+    if (!logged) {
+        logged = true;
+        LOGI("CL-GL interop not built (configure with -DANDROID_OPENCL_SDK=...)");
+    }
+    return false;
+}
+
+bool clGlDetectEdges(GLuint, GLuint, int, int, float, float) {
+    return clGlInteropInit();
+}
+
+void clGlInteropRelease() {}
+
+#endif // EDGE_CL_GL_INTEROP
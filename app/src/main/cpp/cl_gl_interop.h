@@ -0,0 +1,28 @@
+#ifndef EDGE_CL_GL_INTEROP_H
+#define EDGE_CL_GL_INTEROP_H
+
+#include <GLES2/gl2.h>
+
+// OpenCL edge kernels that read and write GL textures directly through
+// cl_khr_gl_sharing, along the lines of procOCL_I2I in the SDK's
+// tutorial-4-opencl sample: blur, Sobel, non-max suppression and single-step
+// hysteresis (the same passes as the GLSL detector) from an RGBA texture into
+// another, with no readback or upload. The CL context shares the current EGL
+// context; it, the program and the kernels are created once per GL context.
+//
+// Only built when CMake gets ANDROID_OPENCL_SDK (OpenCL headers and library),
+// which defines EDGE_CL_GL_INTEROP; otherwise every call reports failure.
+// All functions must be called on the GL thread with the context current.
+
+// Creates the shared context and kernels on first use; false when the
+// device cannot share GL objects (the result is remembered until release)
+bool clGlInteropInit();
+
+// Edges of input into output (both RGBA GL_TEXTURE_2D, width x height);
+// thresholds are in units of the normalized 0..1 luma gradient
+bool clGlDetectEdges(GLuint input, GLuint output, int width, int height, float low, float high);
+
+// Drops every CL object; call before the GL context goes away
+void clGlInteropRelease();
+
+#endif // EDGE_CL_GL_INTEROP_H
@@ -0,0 +1,176 @@
+#include "code_scanner.h"
+#include "gradient_edges.h"
+#include "metrics.h"
+#include "pyramid_cache.h"
+#include "thread_policy.h"
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+
+#define LOG_TAG "CodeScanner"
+#include "logging.h"
+
+namespace {
+
+const int kCellSide = 32;         // density cells, reduced-luma pixels
+const int kEdgeThreshold = 160;   // L1 Sobel magnitude: module borders of a printed code clear it easily
+
+}  // namespace
+
+CodeScanner::~CodeScanner() {
+    stopThread();
+}
+
+void CodeScanner::setParams(const Params& params) {
+    std::lock_guard<std::mutex> lock(mutex);
+    current = params;
+    current.everyFrames = std::max(1, params.everyFrames);
+    current.downscale = params.downscale >= 4 ? 4 : params.downscale >= 2 ? 2 : 1;
+    current.minEdgeDensity = std::min(std::max(params.minEdgeDensity, 0.0f), 1.0f);
+}
+
+void CodeScanner::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    result.reset();
+    hasPending = false;
+    generation++;
+}
+
+bool CodeScanner::preempted(const Job& job) const {
+    return job.generation != generation.load(std::memory_order_relaxed) ||
+           frames.load(std::memory_order_relaxed) - job.frame > static_cast<uint64_t>(kStaleFrames);
+}
+
+void CodeScanner::offer(const cv::Mat& luma) {
+    const uint64_t frame = frames.fetch_add(1, std::memory_order_relaxed) + 1;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (busy || hasPending || frame - lastHandOff < static_cast<uint64_t>(current.everyFrames)) {
+        return;
+    }
+    lastHandOff = frame;  // a sparse frame also waits K frames for the next look
+
+    const int downscale = current.downscale;
+    PyramidCache& pyramids = pyramidCache();
+    cv::Mat level = pyramids.covers(luma) ? pyramids.level(downscale == 4 ? 2 : downscale == 2 ? 1 : 0) : cv::Mat();
+    if (level.empty()) {
+        if (downscale == 1) {
+            level = luma;
+        } else {
+            cv::resize(luma, reduced, cv::Size(std::max(1, luma.cols / downscale), std::max(1, luma.rows / downscale)),
+                       0, 0, cv::INTER_AREA);
+            level = reduced;
+        }
+    }
+
+    // Candidate region: the cells dense with edges, grown by one cell so the
+    // quiet zone and finder patterns of a code on the boundary stay inside
+    gradientEdgesU8(level, edges, kEdgeThreshold);
+    cv::resize(edges, cells, cv::Size((level.cols + kCellSide - 1) / kCellSide, (level.rows + kCellSide - 1) / kCellSide),
+               0, 0, cv::INTER_AREA);
+    cv::threshold(cells, cells, current.minEdgeDensity * 255.0, 255, cv::THRESH_BINARY);
+    const cv::Rect dense = cv::boundingRect(cells);
+    if (dense.empty()) {
+        metrics().increment(Counter::CODE_SCANS_SKIPPED);
+        return;
+    }
+    const cv::Rect region = cv::Rect((dense.x - 1) * kCellSide, (dense.y - 1) * kCellSide,
+                                     (dense.width + 2) * kCellSide, (dense.height + 2) * kCellSide) &
+                            cv::Rect(0, 0, level.cols, level.rows);
+
+    level(region).copyTo(pending.image);
+    pending.offset = cv::Point2f(static_cast<float>(region.x), static_cast<float>(region.y));
+    pending.scale = static_cast<float>(luma.cols) / level.cols;
+    pending.lumaSize = luma.size();
+    pending.frame = frame;
+    pending.generation = generation.load(std::memory_order_relaxed);
+    hasPending = true;
+    if (!thread.joinable()) {
+        stopping = false;
+        thread = std::thread(&CodeScanner::run, this);
+    }
+    wakeup.notify_one();
+}
+
+std::shared_ptr<const CodeScanResult> CodeScanner::latest() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return result;
+}
+
+void CodeScanner::stopThread() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeup.notify_one();
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void CodeScanner::run() {
+    // Only cores the camera, GL and processing threads leave idle
+    setThreadTier(ThreadTier::ANALYTICS);
+
+    Job job;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wakeup.wait(lock, [this] { return stopping || hasPending; });
+        if (stopping) {
+            return;
+        }
+        std::swap(job, pending);
+        hasPending = false;
+        busy = true;
+        lock.unlock();
+
+        auto found = std::make_shared<CodeScanResult>();
+        bool finished = false;
+        bool dropped = false;
+        try {
+            ScopedStageTimer timer(Stage::CODE_SCAN);
+            points.clear();
+            if (detector.detectMulti(job.image, points)) {
+                finished = true;
+                const size_t codes = std::min(points.size() / 4, static_cast<size_t>(kMaxCodes));
+                for (size_t i = 0; i < codes; i++) {
+                    yieldToForeground();  // one decode per chunk
+                    if (preempted(job)) {
+                        finished = false;
+                        dropped = true;
+                        break;
+                    }
+                    const std::vector<cv::Point2f> quad(points.begin() + 4 * i, points.begin() + 4 * i + 4);
+                    std::string text = detector.decode(job.image, quad);
+                    if (text.empty()) {
+                        continue;  // found but unreadable, e.g. blurred
+                    }
+                    cv::Vec<float, 8> corners;
+                    for (int j = 0; j < 4; j++) {
+                        corners[2 * j] = (quad[static_cast<size_t>(j)].x + job.offset.x) * job.scale / job.lumaSize.width;
+                        corners[2 * j + 1] = (quad[static_cast<size_t>(j)].y + job.offset.y) * job.scale / job.lumaSize.height;
+                    }
+                    found->texts.push_back(std::move(text));
+                    found->corners.push_back(corners);
+                }
+            } else {
+                finished = true;  // nothing there: an empty result clears the old codes
+            }
+        } catch (const cv::Exception& e) {
+            LOGE_RATELIMITED("❌ Code scan failed: %s", e.what());
+        }
+        if (dropped) {
+            metrics().increment(Counter::CODE_SCANS_PREEMPTED);
+        }
+
+        lock.lock();
+        busy = false;
+        if (finished && job.generation == generation.load(std::memory_order_relaxed)) {
+            found->scan = ++scans;
+            result = std::move(found);
+        }
+    }
+}
+
+CodeScanner& codeScanner() {
+    static CodeScanner scanner;
+    return scanner;
+}
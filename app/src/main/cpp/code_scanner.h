@@ -0,0 +1,98 @@
+#ifndef EDGE_CODE_SCANNER_H
+#define EDGE_CODE_SCANNER_H
+
+#include <opencv2/core.hpp>
+#include <opencv2/objdetect.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Codes decoded by one finished scan. Corners are the four of each code, as
+// x, y pairs in 0..1 units of the luma the scan was offered.
+struct CodeScanResult {
+    uint64_t scan = 0;  // 1 for the first finished scan, then counting up
+    std::vector<std::string> texts;
+    std::vector<cv::Vec<float, 8>> corners;
+};
+
+// QR codes (cv::QRCodeDetector) beside the edge pipeline, never in its way:
+// the processing thread only offers frames, and a frame is handed to a
+// background-priority thread at most every K frames, while that thread is
+// idle, and only when some region of the reduced luma has the edge density
+// of a code; just that region is copied. Codes are decoded one by one with
+// decode() instead of decodeMulti's parallel loop, so a scan never takes
+// OpenCV's pool from the preview, and a scan still running when its frame
+// is kStaleFrames old is preempted between codes. Results arrive
+// asynchronously through latest().
+class CodeScanner {
+public:
+    struct Params {
+        int everyFrames = 6;          // K: frames between hand-offs at most
+        int downscale = 2;            // 1, 2 or 4: the scan sees 1/downscale of the luma per axis
+        float minEdgeDensity = 0.12f; // share of edge pixels a 32x32 candidate cell needs
+    };
+
+    static const int kMaxCodes = 16;
+    static const int kStaleFrames = 30;
+
+    ~CodeScanner();
+
+    void setParams(const Params& params);
+
+    // Processing thread, once per frame of the mode: counts the frame and
+    // hands a candidate region of luma (CV_8UC1) over when one is due. Starts
+    // the thread on first use.
+    void offer(const cv::Mat& luma);
+
+    // Newest finished scan; null before the first
+    std::shared_ptr<const CodeScanResult> latest();
+
+    // Drops the results and preempts a running scan, e.g. when the mode is
+    // entered again
+    void reset();
+
+private:
+    struct Job {
+        cv::Mat image;        // owned copy of the candidate region
+        cv::Point2f offset;   // of the region in the reduced luma
+        float scale = 1.0f;   // reduced -> luma pixels
+        cv::Size lumaSize;
+        uint64_t frame = 0;   // frames offered when it was taken
+        uint64_t generation = 0;
+    };
+
+    void run();
+    void stopThread();
+    bool preempted(const Job& job) const;
+
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    std::thread thread;
+    bool stopping = false;
+    bool hasPending = false;
+    bool busy = false;
+    Params current;
+    Job pending;
+    uint64_t lastHandOff = 0;
+    cv::Mat reduced;              // processing-thread scratch
+    cv::Mat edges;
+    cv::Mat cells;
+    std::atomic<uint64_t> frames{0};
+    std::atomic<uint64_t> generation{0};
+
+    cv::QRCodeDetector detector;  // thread only
+    std::vector<cv::Point2f> points;
+
+    std::shared_ptr<const CodeScanResult> result;
+    uint64_t scans = 0;
+};
+
+// Scanner used by the CODES render mode
+CodeScanner& codeScanner();
+
+#endif // EDGE_CODE_SCANNER_H
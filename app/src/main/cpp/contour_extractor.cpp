@@ -0,0 +1,54 @@
+#include "contour_extractor.h"
+#include "frame_deadline.h"
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+
+void ContourExtractor::setParams(const Params& params) {
+    std::lock_guard<std::mutex> lock(mutex);
+    current = params;
+}
+
+int ContourExtractor::extract(const cv::Mat& edges, cv::Mat& points, cv::Mat& offsets,
+                              const FrameDeadline* deadline) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (deadlineAborts(deadline)) {
+        return -1;
+    }
+    // OpenCV 4 leaves the source untouched, so published edge buffers are safe
+    cv::findContours(edges, contours, cv::RETR_LIST, cv::CHAIN_APPROX_SIMPLE);
+
+    const int pointLimit = std::min(points.rows, kMaxPoints);
+    const int stripLimit = std::min(offsets.rows - 1, kMaxStrips);
+    int strips = 0;
+    int written = 0;
+    int traced = 0;
+    for (const std::vector<cv::Point>& contour : contours) {
+        if (strips >= stripLimit) {
+            break;
+        }
+        if (++traced % kDeadlineStride == 0 && deadlineAborts(deadline)) {
+            return -1;
+        }
+        if (cv::arcLength(contour, true) < current.minLength) {
+            continue;
+        }
+        cv::approxPolyDP(contour, approx, current.epsilon, true);
+        // The first vertex is repeated to close the strip
+        const int needed = static_cast<int>(approx.size()) + 1;
+        if (approx.size() < 2 || written + needed > pointLimit) {
+            continue;
+        }
+        offsets.at<int>(strips++) = written;
+        for (const cv::Point& p : approx) {
+            points.at<cv::Vec2f>(written++) = cv::Vec2f(static_cast<float>(p.x), static_cast<float>(p.y));
+        }
+        points.at<cv::Vec2f>(written++) = cv::Vec2f(static_cast<float>(approx[0].x), static_cast<float>(approx[0].y));
+    }
+    offsets.at<int>(strips) = written;
+    return strips;
+}
+
+ContourExtractor& contourExtractor() {
+    static ContourExtractor extractor;
+    return extractor;
+}
@@ -0,0 +1,50 @@
+#ifndef EDGE_CONTOUR_EXTRACTOR_H
+#define EDGE_CONTOUR_EXTRACTOR_H
+
+#include <opencv2/core.hpp>
+#include <mutex>
+#include <vector>
+
+class FrameDeadline;
+
+// Edge maps as vector geometry: findContours on the binary Canny output, each
+// contour simplified with approxPolyDP and packed into one vertex array. For a
+// sparse scene that is a few kilobytes where the raster is megabytes, and it
+// is structured data consumers can work with directly.
+class ContourExtractor {
+public:
+    struct Params {
+        double epsilon = 1.5;  // approxPolyDP tolerance, px
+        int minLength = 12;    // contours with a shorter perimeter (px) are dropped
+    };
+
+    // Output capacity; contours past either limit are dropped
+    static const int kMaxPoints = 16384;
+    static const int kMaxStrips = 2048;
+
+    void setParams(const Params& params);
+
+    // Writes the simplified contours of edges (CV_8UC1, non-zero = edge) as
+    // closed line strips: (x, y) pixel positions into points (CV_32FC2, at
+    // least kMaxPoints rows) and the first vertex of every strip followed by
+    // the end of the last one into offsets (CV_32SC1, at least kMaxStrips + 1
+    // rows). Returns the number of strips; offsets[strips] is the point count.
+    // With a deadline (frame_deadline.h), checked before the contours are
+    // traced and every kDeadlineStride contours after: -1 once it passed,
+    // points and offsets then hold nothing usable.
+    int extract(const cv::Mat& edges, cv::Mat& points, cv::Mat& offsets, const FrameDeadline* deadline = nullptr);
+
+    static const int kDeadlineStride = 64;
+
+private:
+    std::mutex mutex;
+    Params current;
+    // Scratch reused across frames
+    std::vector<std::vector<cv::Point>> contours;
+    std::vector<cv::Point> approx;
+};
+
+// Extractor used by the CONTOURS render mode
+ContourExtractor& contourExtractor();
+
+#endif // EDGE_CONTOUR_EXTRACTOR_H
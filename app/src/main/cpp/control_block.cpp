@@ -0,0 +1,111 @@
+#include "control_block.h"
+#include <algorithm>
+#include <mutex>
+
+namespace {
+
+ControlBlock control{};
+StatsBlock stats{};
+
+std::mutex applyMutex;
+bool initialised = false;                  // applyMutex
+ControlValues applied;                     // applyMutex
+std::atomic<uint32_t> appliedVersion{0};
+
+std::mutex statsMutex;  // one writer at a time
+
+ControlValues readControl() {
+    // Acquire loads: none moves after the version check that follows them
+    ControlValues values;
+    values.renderMode = control.renderMode.load(std::memory_order_acquire);
+    values.flags = control.flags.load(std::memory_order_acquire);
+    values.cannyLow = control.cannyLow.load(std::memory_order_acquire);
+    values.cannyHigh = control.cannyHigh.load(std::memory_order_acquire);
+    values.roiX = control.roiX.load(std::memory_order_acquire);
+    values.roiY = control.roiY.load(std::memory_order_acquire);
+    values.roiWidth = control.roiWidth.load(std::memory_order_acquire);
+    values.roiHeight = control.roiHeight.load(std::memory_order_acquire);
+    values.scaleDivisor = control.scaleDivisor.load(std::memory_order_acquire);
+    values.roiBackgroundDim = control.roiBackgroundDim.load(std::memory_order_acquire);
+    values.orientation = control.orientation.load(std::memory_order_acquire);
+    return values;
+}
+
+}  // namespace
+
+ControlBlock& controlBlock() {
+    return control;
+}
+
+StatsBlock& statsBlock() {
+    return stats;
+}
+
+void initControlBlock(const ControlValues& current) {
+    std::lock_guard<std::mutex> lock(applyMutex);
+    if (initialised) {
+        return;
+    }
+    initialised = true;
+    control.renderMode.store(current.renderMode, std::memory_order_relaxed);
+    control.flags.store(current.flags, std::memory_order_relaxed);
+    control.cannyLow.store(current.cannyLow, std::memory_order_relaxed);
+    control.cannyHigh.store(current.cannyHigh, std::memory_order_relaxed);
+    control.roiX.store(current.roiX, std::memory_order_relaxed);
+    control.roiY.store(current.roiY, std::memory_order_relaxed);
+    control.roiWidth.store(current.roiWidth, std::memory_order_relaxed);
+    control.roiHeight.store(current.roiHeight, std::memory_order_relaxed);
+    control.scaleDivisor.store(current.scaleDivisor, std::memory_order_relaxed);
+    control.roiBackgroundDim.store(current.roiBackgroundDim, std::memory_order_relaxed);
+    control.orientation.store(current.orientation, std::memory_order_relaxed);
+    const uint32_t version = control.version.load(std::memory_order_relaxed) + 2;
+    control.version.store(version, std::memory_order_release);
+    applied = current;
+    appliedVersion.store(version, std::memory_order_relaxed);
+}
+
+void pollControlBlock(const std::function<void(const ControlValues& previous, const ControlValues& next)>& apply) {
+    const uint32_t version = control.version.load(std::memory_order_acquire);
+    if ((version & 1) != 0 || version == appliedVersion.load(std::memory_order_relaxed)) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(applyMutex, std::try_to_lock);
+    if (!lock.owns_lock() || !initialised || version == appliedVersion.load(std::memory_order_relaxed)) {
+        return;
+    }
+    const ControlValues next = readControl();
+    if (control.version.load(std::memory_order_acquire) != version) {
+        return;  // Java started another change meanwhile: torn, next frame
+    }
+    const ControlValues previous = applied;
+    applied = next;
+    appliedVersion.store(version, std::memory_order_relaxed);
+    apply(previous, next);
+}
+
+bool readEffectParams(float params[4]) {
+    const uint32_t version = control.version.load(std::memory_order_acquire);
+    if ((version & 1) != 0) {
+        return false;
+    }
+    float values[4];
+    for (int i = 0; i < 4; i++) {
+        values[i] = control.effectParams[i].load(std::memory_order_acquire);
+    }
+    if (control.version.load(std::memory_order_acquire) != version) {
+        return false;
+    }
+    std::copy(values, values + 4, params);
+    return true;
+}
+
+StatsBlockWrite::StatsBlockWrite() {
+    statsMutex.lock();
+    stats.version.store(stats.version.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+StatsBlockWrite::~StatsBlockWrite() {
+    stats.version.store(stats.version.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    statsMutex.unlock();
+}
@@ -0,0 +1,116 @@
+#ifndef EDGE_CONTROL_BLOCK_H
+#define EDGE_CONTROL_BLOCK_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+// Settings and per-frame stats shared with Java through two direct
+// ByteBuffers over native memory (nativeGetControlBlock, nativeGetStatsBlock), so a settings
+// change or an overlay refresh costs no JNI call. Both blocks are static and
+// never freed: the buffers cannot outlive them. Fields sit at the fixed
+// little-endian offsets the static_asserts below pin; Java addresses them
+// with ByteBuffer.order(ByteOrder.nativeOrder()).
+//
+// Control (Java writes, native reads at frame boundaries): Java makes version
+// odd, stores the fields it changes, then makes version even again with a
+// release store (VarHandle.setRelease through byteBufferViewVarHandle, or
+// any fence after the field stores). Native applies a version once, only the
+// fields that differ from the last one applied, and skips a version read
+// while odd or torn until the next frame.
+//
+// Stats (native writes at every publish of the default pipeline, Java reads):
+// the same seqlock the other way round: read version, the fields, version
+// again, and retry when they differ or the first one was odd.
+struct ControlBlock {
+    std::atomic<uint32_t> version;
+    std::atomic<int32_t> renderMode;        // RenderMode of the default pipeline
+    std::atomic<int32_t> flags;             // kControlAdaptiveThresholds | kControlEdgePreBlur
+    std::atomic<int32_t> cannyLow;          // fixed thresholds, when not adaptive
+    std::atomic<int32_t> cannyHigh;
+    std::atomic<int32_t> roiX;              // processing ROI, sensor pixels; 0 width = whole frame
+    std::atomic<int32_t> roiY;
+    std::atomic<int32_t> roiWidth;
+    std::atomic<int32_t> roiHeight;
+    std::atomic<int32_t> scaleDivisor;      // 1..8 (processing scale)
+    std::atomic<float> roiBackgroundDim;    // 0..1
+    std::atomic<int32_t> orientation;       // renderer quad orientation (setOrientationNative); -1 = unset
+    std::atomic<float> effectParams[4];     // u_Params of the render effects (render_effects.h)
+};
+
+const int32_t kControlAdaptiveThresholds = 1 << 0;
+const int32_t kControlEdgePreBlur = 1 << 1;
+
+struct StatsBlock {
+    std::atomic<uint32_t> version;          // odd while native writes
+    std::atomic<int32_t> renderMode;        // of the frame
+    std::atomic<int64_t> sequence;          // publish sequence
+    std::atomic<int64_t> captureTimestampNs;
+    std::atomic<int64_t> publishTimestampNs;
+    std::atomic<int64_t> framesProcessed;   // process-wide counters (metrics.h)
+    std::atomic<int64_t> framesDropped;
+    std::atomic<int64_t> framesStale;
+    std::atomic<int32_t> frameMicros;       // FRAME_TOTAL of the frame
+    std::atomic<int32_t> captureToPublishMicros;
+    std::atomic<int32_t> cannyLow;          // thresholds after the frame
+    std::atomic<int32_t> cannyHigh;
+    std::atomic<int32_t> cannyBackend;      // CannyBackend detectEdges ran
+    std::atomic<int32_t> width;             // camera frame
+    std::atomic<int32_t> height;
+    std::atomic<int32_t> lumaMedian;        // -1 without luma statistics
+    int32_t reserved[10];
+};
+
+static_assert(offsetof(ControlBlock, renderMode) == 4 && offsetof(ControlBlock, cannyLow) == 12 &&
+              offsetof(ControlBlock, roiX) == 20 && offsetof(ControlBlock, scaleDivisor) == 36 &&
+              offsetof(ControlBlock, roiBackgroundDim) == 40 && offsetof(ControlBlock, orientation) == 44 &&
+              offsetof(ControlBlock, effectParams) == 48 && sizeof(ControlBlock) == 64, "ControlBlock offsets are shared with Java");
+static_assert(offsetof(StatsBlock, sequence) == 8 && offsetof(StatsBlock, framesStale) == 48 &&
+              offsetof(StatsBlock, frameMicros) == 56 && offsetof(StatsBlock, cannyBackend) == 72 &&
+              offsetof(StatsBlock, lumaMedian) == 84 && sizeof(StatsBlock) == 128,
+              "StatsBlock offsets are shared with Java");
+
+// The control values as last applied, or as read from a new version
+struct ControlValues {
+    int renderMode = 0;
+    int flags = 0;
+    int cannyLow = 0;
+    int cannyHigh = 0;
+    int roiX = 0;
+    int roiY = 0;
+    int roiWidth = 0;
+    int roiHeight = 0;
+    int scaleDivisor = 1;
+    float roiBackgroundDim = 0.0f;
+    int orientation = 0;
+};
+
+ControlBlock& controlBlock();
+StatsBlock& statsBlock();
+
+// Puts the current settings into the control block and marks them applied;
+// the first call only, before Java first sees the block
+void initControlBlock(const ControlValues& current);
+
+// Frame boundary: when Java finished a version not applied yet, calls apply
+// with the values applied before it and the new ones, versions in order. One
+// acquire load when nothing changed; while another thread applies, returns
+// at once and the version waits for the next frame.
+void pollControlBlock(const std::function<void(const ControlValues& previous, const ControlValues& next)>& apply);
+
+// The render effect parameters of the newest finished version, for the GL
+// threads, which read them every frame without applying anything; false
+// while Java writes (params untouched: keep the previous ones)
+bool readEffectParams(float params[4]);
+
+// Writer side of the stats block; fields are stored in between
+class StatsBlockWrite {
+public:
+    StatsBlockWrite();
+    ~StatsBlockWrite();
+    StatsBlockWrite(const StatsBlockWrite&) = delete;
+    StatsBlockWrite& operator=(const StatsBlockWrite&) = delete;
+};
+
+#endif // EDGE_CONTROL_BLOCK_H
@@ -0,0 +1,270 @@
+#include "cpu_profiler.h"
+#include "metrics.h"
+#include <opencv2/core.hpp>
+#include <opencv2/core/utility.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <pthread.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#define LOG_TAG "CpuProfiler"
+#include "logging.h"
+
+namespace {
+
+const int kMaxSeconds = 600;
+const auto kPoolRendezvous = std::chrono::milliseconds(50);
+
+struct ProfiledThread {
+    pid_t tid = 0;
+    ProfileRole role = ProfileRole::PROCESSING;
+    clockid_t clock = 0;
+    int64_t startCpuNs = 0;
+};
+
+std::mutex sessionMutex;
+std::condition_variable sessionChanged;
+std::atomic<uint32_t> activeSession{0};   // 0 = none
+uint32_t sessionCounter = 0;
+thread_local uint32_t threadSession = 0;
+
+// Guarded by sessionMutex
+std::vector<ProfiledThread> threads;
+bool poolRegistered = false;
+bool stopRequested = false;
+std::chrono::steady_clock::time_point startTime;
+std::chrono::steady_clock::time_point deadline;
+int64_t startProcessCpuNs = 0;
+uint64_t startCalls[static_cast<int>(Stage::COUNT)] = {};
+std::string lastReport;
+std::thread timer;
+
+const char* roleName(ProfileRole role) {
+    switch (role) {
+        case ProfileRole::PROCESSING: return "processing";
+        case ProfileRole::RENDER: return "render";
+        case ProfileRole::OPENCV_POOL: return "opencv_pool";
+        default: return "other";
+    }
+}
+
+int64_t clockNanos(clockid_t clock) {
+    timespec now;
+    if (clock_gettime(clock, &now) != 0) {
+        return -1;  // the thread has exited
+    }
+    return static_cast<int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+std::string threadName(pid_t tid) {
+    char path[64];
+    std::snprintf(path, sizeof(path), "/proc/self/task/%d/comm", static_cast<int>(tid));
+    char name[32] = {};
+    FILE* file = std::fopen(path, "re");
+    if (file) {
+        if (std::fgets(name, sizeof(name), file)) {
+            name[std::strcspn(name, "\n")] = '\0';
+        }
+        std::fclose(file);
+    }
+    return name;
+}
+
+// Caller holds sessionMutex
+void registerLocked(ProfileRole role) {
+    ProfiledThread thread;
+    if (pthread_getcpuclockid(pthread_self(), &thread.clock) != 0) {
+        return;
+    }
+    thread.tid = gettid();
+    thread.role = role;
+    thread.startCpuNs = clockNanos(CLOCK_THREAD_CPUTIME_ID);
+    threads.push_back(thread);
+}
+
+// Each stripe registers the pool thread running it and waits until all
+// stripes run, so every pool thread takes exactly one (as PinPoolThreads in
+// thread_policy.cpp)
+class RegisterPoolThreads : public cv::ParallelLoopBody {
+public:
+    RegisterPoolThreads(uint32_t session, int stripes, std::atomic<int>& arrived)
+        : session(session), stripes(stripes), arrived(arrived) {}
+
+    void operator()(const cv::Range& range) const override {
+        if (threadSession != session) {
+            threadSession = session;
+            std::lock_guard<std::mutex> lock(sessionMutex);
+            registerLocked(ProfileRole::OPENCV_POOL);
+        }
+        arrived.fetch_add(range.end - range.start, std::memory_order_acq_rel);
+        const auto until = std::chrono::steady_clock::now() + kPoolRendezvous;
+        while (arrived.load(std::memory_order_acquire) < stripes && std::chrono::steady_clock::now() < until) {
+            std::this_thread::yield();
+        }
+    }
+
+private:
+    const uint32_t session;
+    const int stripes;
+    std::atomic<int>& arrived;
+};
+
+// Caller holds sessionMutex; the session is over
+std::string buildReport() {
+    const double wallSeconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    const double processMs = (clockNanos(CLOCK_PROCESS_CPUTIME_ID) - startProcessCpuNs) / 1e6;
+    char line[256];
+    std::string report;
+    std::snprintf(line, sizeof(line), "CPU profile: %.1f s wall, process %.0f ms CPU (%.0f%% of one core)\n",
+                  wallSeconds, processMs, wallSeconds > 0 ? processMs / (wallSeconds * 10) : 0.0);
+    report += line;
+
+    double roleMs[static_cast<int>(ProfileRole::COUNT)] = {};
+    std::vector<std::pair<double, std::string>> rows;
+    for (const ProfiledThread& thread : threads) {
+        const int64_t now = clockNanos(thread.clock);
+        if (now < 0) {
+            std::snprintf(line, sizeof(line), "  %-11s tid %-6d exited during the session\n", roleName(thread.role),
+                          static_cast<int>(thread.tid));
+            rows.emplace_back(-1.0, line);
+            continue;
+        }
+        const double ms = (now - thread.startCpuNs) / 1e6;
+        roleMs[static_cast<int>(thread.role)] += ms;
+        std::snprintf(line, sizeof(line), "  %-11s tid %-6d %-16s %8.0f ms %5.1f%%\n", roleName(thread.role),
+                      static_cast<int>(thread.tid), threadName(thread.tid).c_str(), ms,
+                      wallSeconds > 0 ? ms / (wallSeconds * 10) : 0.0);
+        rows.emplace_back(ms, line);
+    }
+    std::sort(rows.begin(), rows.end(), [](const std::pair<double, std::string>& a,
+                                           const std::pair<double, std::string>& b) { return a.first > b.first; });
+    for (const auto& row : rows) {
+        report += row.second;
+    }
+
+    double attributedMs = 0.0;
+    report += "by role:";
+    for (int i = 0; i < static_cast<int>(ProfileRole::COUNT); i++) {
+        std::snprintf(line, sizeof(line), " %s %.0f ms,", roleName(static_cast<ProfileRole>(i)), roleMs[i]);
+        report += line;
+        attributedMs += roleMs[i];
+    }
+    std::snprintf(line, sizeof(line), " unattributed %.0f ms\n", std::max(0.0, processMs - attributedMs));
+    report += line;
+
+    report += "stage calls:";
+    for (int i = 0; i < static_cast<int>(Stage::COUNT); i++) {
+        const uint64_t count = metrics().histogram(static_cast<Stage>(i)).count();
+        const uint64_t calls = count >= startCalls[i] ? count - startCalls[i] : count;  // metrics reset meanwhile
+        if (calls == 0) {
+            continue;
+        }
+        std::snprintf(line, sizeof(line), " %s %llu (%.1f/s)", stageName(static_cast<Stage>(i)),
+                      static_cast<unsigned long long>(calls), wallSeconds > 0 ? calls / wallSeconds : 0.0);
+        report += line;
+    }
+    report += "\n";
+    return report;
+}
+
+void runTimer() {
+    std::unique_lock<std::mutex> lock(sessionMutex);
+    sessionChanged.wait_until(lock, deadline, [] { return stopRequested; });
+    activeSession.store(0, std::memory_order_release);
+    lastReport = buildReport();
+    threads.clear();
+    // One log line per report line: logcat truncates long messages
+    size_t start = 0;
+    while (start < lastReport.size()) {
+        const size_t end = lastReport.find('\n', start);
+        LOGI("📊 %s", lastReport.substr(start, end - start).c_str());
+        start = end == std::string::npos ? lastReport.size() : end + 1;
+    }
+}
+
+} // namespace
+
+bool startProfiling(int seconds) {
+    if (seconds <= 0 || seconds > kMaxSeconds) {
+        LOGE("❌ Profiling window must be 1-%d s, got %d", kMaxSeconds, seconds);
+        return false;
+    }
+    std::unique_lock<std::mutex> lock(sessionMutex);
+    if (activeSession.load(std::memory_order_acquire) != 0) {
+        LOGW("⚠️ A profiling session is already running");
+        return false;
+    }
+    if (timer.joinable()) {
+        lock.unlock();
+        timer.join();  // the previous session's timer, already past its report
+        lock.lock();
+    }
+    threads.clear();
+    poolRegistered = false;
+    stopRequested = false;
+    startTime = std::chrono::steady_clock::now();
+    deadline = startTime + std::chrono::seconds(seconds);
+    startProcessCpuNs = clockNanos(CLOCK_PROCESS_CPUTIME_ID);
+    for (int i = 0; i < static_cast<int>(Stage::COUNT); i++) {
+        startCalls[i] = metrics().histogram(static_cast<Stage>(i)).count();
+    }
+    const uint32_t session = ++sessionCounter == 0 ? ++sessionCounter : sessionCounter;
+    activeSession.store(session, std::memory_order_release);
+    timer = std::thread(runTimer);
+    LOGI("✅ Profiling for %d s", seconds);
+    return true;
+}
+
+void stopProfiling() {
+    {
+        std::lock_guard<std::mutex> lock(sessionMutex);
+        stopRequested = true;
+    }
+    sessionChanged.notify_all();
+    if (timer.joinable()) {
+        timer.join();
+    }
+}
+
+bool profilingActive() {
+    return activeSession.load(std::memory_order_acquire) != 0;
+}
+
+void profileThread(ProfileRole role) {
+    const uint32_t session = activeSession.load(std::memory_order_acquire);
+    if (session == 0 || session == threadSession) {
+        return;
+    }
+    threadSession = session;
+    bool registerPool = false;
+    {
+        std::lock_guard<std::mutex> lock(sessionMutex);
+        if (activeSession.load(std::memory_order_relaxed) != session) {
+            return;  // ended meanwhile
+        }
+        registerLocked(role);
+        if (role == ProfileRole::PROCESSING && !poolRegistered) {
+            poolRegistered = true;
+            registerPool = true;
+        }
+    }
+    const int stripes = cv::getNumThreads();
+    if (registerPool && stripes > 1) {
+        std::atomic<int> arrived{0};
+        cv::parallel_for_(cv::Range(0, stripes), RegisterPoolThreads(session, stripes, arrived), stripes);
+    }
+}
+
+std::string profileReport() {
+    std::lock_guard<std::mutex> lock(sessionMutex);
+    return lastReport;
+}
@@ -0,0 +1,32 @@
+#ifndef EDGE_CPU_PROFILER_H
+#define EDGE_CPU_PROFILER_H
+
+#include <string>
+
+enum class ProfileRole : int {
+    PROCESSING = 0,   // worker, synchronous callers and stage-pipeline threads
+    RENDER,           // the GL thread (renderGL)
+    OPENCV_POOL,      // parallel_for_ workers
+    COUNT
+};
+
+// Field profiling without simpleperf: a session of N seconds records the CPU
+// time (CLOCK_THREAD_CPUTIME_ID, read through pthread_getcpuclockid so any
+// thread can sample another) of every thread that reported in, and the call
+// count of every stage. Threads report through profileThread() on their
+// per-frame path; the first processing thread of a session also reaches the
+// OpenCV pool threads with one parallel_for_. When the window ends a timer
+// thread writes the summary to the log and keeps it for profileReport().
+bool startProfiling(int seconds);
+// Ends the running session early (its summary is kept as for a full window)
+void stopProfiling();
+bool profilingActive();
+
+// Registers the calling thread with the running session; a relaxed load and
+// a compare when it already did or no session runs
+void profileThread(ProfileRole role);
+
+// Summary of the last finished session, empty while none has finished
+std::string profileReport();
+
+#endif // EDGE_CPU_PROFILER_H
@@ -0,0 +1,123 @@
+#include "display_mirror.h"
+#include "video_recorder.h"
+#include "tracing.h"
+#include <android/native_window.h>
+#include <algorithm>
+
+#define LOG_TAG "DisplayMirror"
+#include "logging.h"
+
+DisplayMirrors::~DisplayMirrors() {
+    release();
+}
+
+int DisplayMirrors::attach(ANativeWindow* window, int orientation) {
+    const EGLDisplay currentDisplay = eglGetCurrentDisplay();
+    const EGLContext currentContext = eglGetCurrentContext();
+    EGLConfig config = currentContext != EGL_NO_CONTEXT ? currentConfig(currentDisplay, currentContext) : nullptr;
+    if (!window || !config) {
+        LOGE("❌ Mirroring needs a window and the GL thread with its context current");
+        return 0;
+    }
+    if (!mirrors.empty() && currentContext != context) {
+        LOGW("⚠️ New GL context; mirrors of the old one are dropped");
+        release();
+    }
+    const EGLint attributes[] = {EGL_NONE};
+    EGLSurface surface = eglCreateWindowSurface(currentDisplay, config, window, attributes);
+    if (surface == EGL_NO_SURFACE) {
+        LOGE("❌ eglCreateWindowSurface failed for a mirror: 0x%x", eglGetError());
+        return 0;
+    }
+    display = currentDisplay;
+    context = currentContext;
+    ANativeWindow_acquire(window);
+    Mirror mirror;
+    mirror.id = nextId++;
+    mirror.window = window;
+    mirror.surface = surface;
+    mirror.orientation = orientation;
+    mirrors.push_back(mirror);
+    LOGI("✅ Mirror %d attached (%dx%d), %zu in all", mirror.id, ANativeWindow_getWidth(window),
+         ANativeWindow_getHeight(window), mirrors.size());
+    return mirror.id;
+}
+
+void DisplayMirrors::setOrientation(int id, int orientation) {
+    for (Mirror& mirror : mirrors) {
+        if (mirror.id == id) {
+            mirror.orientation = orientation;
+        }
+    }
+}
+
+void DisplayMirrors::destroy(Mirror& mirror) {
+    if (mirror.surface != EGL_NO_SURFACE) {
+        eglDestroySurface(display, mirror.surface);
+        mirror.surface = EGL_NO_SURFACE;
+    }
+    if (mirror.window) {
+        ANativeWindow_release(mirror.window);
+        mirror.window = nullptr;
+    }
+}
+
+void DisplayMirrors::detach(int id) {
+    auto found = std::find_if(mirrors.begin(), mirrors.end(), [id](const Mirror& mirror) { return mirror.id == id; });
+    if (found == mirrors.end()) {
+        return;
+    }
+    destroy(*found);
+    mirrors.erase(found);
+    LOGI("🔄 Mirror %d detached", id);
+}
+
+void DisplayMirrors::release() {
+    for (Mirror& mirror : mirrors) {
+        destroy(mirror);
+    }
+    mirrors.clear();
+}
+
+void DisplayMirrors::present(const std::function<void(int, int, int)>& draw) {
+    if (mirrors.empty()) {
+        return;
+    }
+    const EGLSurface savedDraw = eglGetCurrentSurface(EGL_DRAW);
+    const EGLSurface savedRead = eglGetCurrentSurface(EGL_READ);
+    for (size_t i = 0; i < mirrors.size();) {
+        Mirror& mirror = mirrors[i];
+        EGLint width = 0;
+        EGLint height = 0;
+        bool alive = eglMakeCurrent(display, mirror.surface, mirror.surface, context) &&
+                     eglQuerySurface(display, mirror.surface, EGL_WIDTH, &width) &&
+                     eglQuerySurface(display, mirror.surface, EGL_HEIGHT, &height);
+        if (alive) {
+            if (!mirror.intervalSet) {
+                // A slower external display must not hold back the main one
+                eglSwapInterval(display, 0);
+                mirror.intervalSet = true;
+            }
+            draw(width, height, mirror.orientation);
+            ScopedTrace trace("mirror_swap");
+            alive = eglSwapBuffers(display, mirror.surface);
+        }
+        if (!alive) {
+            // EGL_BAD_NATIVE_WINDOW and friends: the display or its Presentation is gone
+            LOGW("⚠️ Mirror %d lost (0x%x), detached", mirror.id, eglGetError());
+            eglMakeCurrent(display, savedDraw, savedRead, context);
+            destroy(mirror);
+            mirrors.erase(mirrors.begin() + static_cast<long>(i));
+            continue;
+        }
+        i++;
+    }
+    if (!eglMakeCurrent(display, savedDraw, savedRead, context)) {
+        LOGE_RATELIMITED("eglMakeCurrent(window) failed: 0x%x", eglGetError());
+    }
+}
+
+DisplayMirrors& displayMirrors() {
+    static thread_local DisplayMirrors mirrors;
+    return mirrors;
+}
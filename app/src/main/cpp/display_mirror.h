@@ -0,0 +1,61 @@
+#ifndef EDGE_DISPLAY_MIRROR_H
+#define EDGE_DISPLAY_MIRROR_H
+
+#include <EGL/egl.h>
+#include <functional>
+#include <vector>
+
+struct ANativeWindow;
+
+// Extra screens showing what the renderer draws, e.g. a Presentation on an
+// HDMI display. Each mirror's window becomes an EGL window surface of the GL
+// thread's own context (the recorder's approach, video_recorder.h), so every
+// surface draws from the same textures: a frame is converted and uploaded
+// once, and each further screen costs its draw calls only, at its own size
+// and orientation. Mirrors swap without waiting for their display's vsync;
+// the main surface paces the frames.
+//
+// GL thread only, with the context current.
+class DisplayMirrors {
+public:
+    ~DisplayMirrors();
+
+    // Takes a reference to window and mirrors onto it with orientation (an
+    // Orientation of opengl_renderer.cpp, -1 = the main surface's). Returns
+    // the mirror's id, or 0 when the window cannot become a surface of the
+    // current context.
+    int attach(ANativeWindow* window, int orientation);
+    void setOrientation(int id, int orientation);
+    // Ends a mirror; its surface and window reference are released
+    void detach(int id);
+    // Every mirror (the context is going away)
+    void release();
+
+    bool empty() const { return mirrors.empty(); }
+
+    // draw(width, height, orientation) once per mirror, with its surface
+    // current, then swaps it; the main surface is current again afterwards.
+    // A mirror whose window went away is detached.
+    void present(const std::function<void(int, int, int)>& draw);
+
+private:
+    struct Mirror {
+        int id = 0;
+        ANativeWindow* window = nullptr;
+        EGLSurface surface = EGL_NO_SURFACE;
+        int orientation = -1;
+        bool intervalSet = false;  // swap interval 0 applied (it belongs to the surface)
+    };
+
+    void destroy(Mirror& mirror);
+
+    std::vector<Mirror> mirrors;
+    EGLDisplay display = EGL_NO_DISPLAY;
+    EGLContext context = EGL_NO_CONTEXT;
+    int nextId = 1;
+};
+
+// The calling GL thread's mirrors (renderer state is per GL thread)
+DisplayMirrors& displayMirrors();
+
+#endif // EDGE_DISPLAY_MIRROR_H
@@ -0,0 +1,187 @@
+#include "dnn_blob.h"
+#include <opencv2/core/utility.hpp>
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+// Source sample of one output coordinate, as INTER_LINEAR places it
+struct Tap {
+    int i0;
+    int i1;
+    float f;  // weight of i1
+};
+
+void buildTaps(int dst, int src, std::vector<Tap>& taps) {
+    taps.resize(static_cast<size_t>(dst));
+    const float scale = static_cast<float>(src) / dst;
+    for (int i = 0; i < dst; i++) {
+        float at = std::min(std::max((i + 0.5f) * scale - 0.5f, 0.0f), static_cast<float>(src - 1));
+        const int i0 = static_cast<int>(at);
+        taps[static_cast<size_t>(i)] = {i0, std::min(i0 + 1, src - 1), at - i0};
+    }
+}
+
+// The chroma tap of a luma position: VU sample k is centred on luma 2k + 0.5
+void buildChromaTaps(int dst, int lumaSize, int chromaSize, std::vector<Tap>& taps) {
+    taps.resize(static_cast<size_t>(dst));
+    const float scale = static_cast<float>(lumaSize) / dst;
+    for (int i = 0; i < dst; i++) {
+        const float luma = std::min(std::max((i + 0.5f) * scale - 0.5f, 0.0f), static_cast<float>(lumaSize - 1));
+        float at = std::min(std::max((luma - 0.5f) * 0.5f, 0.0f), static_cast<float>(chromaSize - 1));
+        const int i0 = static_cast<int>(at);
+        taps[static_cast<size_t>(i)] = {i0, std::min(i0 + 1, chromaSize - 1), at - i0};
+    }
+}
+
+inline float lerp(float a, float b, float f) {
+    return a + (b - a) * f;
+}
+
+inline float clamp255(float value) {
+    return std::min(std::max(value, 0.0f), 255.0f);
+}
+
+// Normalized value to an element of the tensor
+template <typename T>
+struct Store {
+    explicit Store(const BlobSpec&) {}
+    T operator()(float value) const { return T(value); }
+};
+
+template <>
+struct Store<uchar> {
+    explicit Store(const BlobSpec& spec) : inverse(1.0f / spec.quantScale), zeroPoint(spec.zeroPoint) {}
+    uchar operator()(float value) const { return cv::saturate_cast<uchar>(cvRound(value * inverse) + zeroPoint); }
+    float inverse;
+    int zeroPoint;
+};
+
+template <>
+struct Store<schar> {
+    explicit Store(const BlobSpec& spec) : inverse(1.0f / spec.quantScale), zeroPoint(spec.zeroPoint) {}
+    schar operator()(float value) const { return cv::saturate_cast<schar>(cvRound(value * inverse) + zeroPoint); }
+    float inverse;
+    int zeroPoint;
+};
+
+template <typename T>
+class Nv21BlobBody : public cv::ParallelLoopBody {
+public:
+    Nv21BlobBody(const cv::Mat& luma, const cv::Mat& chroma, const BlobSpec& spec, T* data)
+        : luma(luma), chroma(chroma), spec(spec), data(data), store(spec) {
+        buildTaps(spec.size.width, luma.cols, xTaps);
+        buildTaps(spec.size.height, luma.rows, yTaps);
+        if (!chroma.empty()) {
+            buildChromaTaps(spec.size.width, luma.cols, chroma.cols, cxTaps);
+            buildChromaTaps(spec.size.height, luma.rows, chroma.rows, cyTaps);
+        }
+        // BGR order in, the spec's order out; mean and scale per output channel
+        for (int c = 0; c < 3; c++) {
+            order[c] = spec.swapRB ? 2 - c : c;
+            mean[c] = static_cast<float>(spec.mean[c]);
+            scale[c] = static_cast<float>(spec.scale[c]);
+        }
+    }
+
+    void operator()(const cv::Range& range) const override {
+        const int width = spec.size.width;
+        const int planes = spec.channels;
+        for (int y = range.start; y < range.end; y++) {
+            const Tap& ty = yTaps[static_cast<size_t>(y)];
+            const uchar* y0 = luma.ptr<uchar>(ty.i0);
+            const uchar* y1 = luma.ptr<uchar>(ty.i1);
+            const uchar* c0 = nullptr;
+            const uchar* c1 = nullptr;
+            float cfy = 0.0f;
+            if (!chroma.empty()) {
+                const Tap& cy = cyTaps[static_cast<size_t>(y)];
+                c0 = chroma.ptr<uchar>(cy.i0);
+                c1 = chroma.ptr<uchar>(cy.i1);
+                cfy = cy.f;
+            }
+            // Planes: channel c of row y at c * H * W + y * W, step 1;
+            // interleaved: at (y * W) * C + c, step C
+            const size_t area = static_cast<size_t>(spec.size.area());
+            const int step = spec.nhwc ? planes : 1;
+            T* out[3];
+            for (int c = 0; c < planes; c++) {
+                out[c] = spec.nhwc ? data + static_cast<size_t>(y) * width * planes + c
+                                   : data + c * area + static_cast<size_t>(y) * width;
+            }
+            for (int x = 0; x < width; x++) {
+                const Tap& tx = xTaps[static_cast<size_t>(x)];
+                const float Y = lerp(lerp(y0[tx.i0], y0[tx.i1], tx.f), lerp(y1[tx.i0], y1[tx.i1], tx.f), ty.f);
+                float bgr[3] = {Y, Y, Y};
+                if (c0) {
+                    const Tap& cx = cxTaps[static_cast<size_t>(x)];
+                    const int a = 2 * cx.i0;
+                    const int b = 2 * cx.i1;
+                    const float V = lerp(lerp(c0[a], c0[b], cx.f), lerp(c1[a], c1[b], cx.f), cfy) - 128.0f;
+                    const float U = lerp(lerp(c0[a + 1], c0[b + 1], cx.f), lerp(c1[a + 1], c1[b + 1], cx.f), cfy) - 128.0f;
+                    const float luminance = 1.164f * (Y - 16.0f);
+                    bgr[0] = clamp255(luminance + 2.018f * U);
+                    bgr[1] = clamp255(luminance - 0.813f * V - 0.391f * U);
+                    bgr[2] = clamp255(luminance + 1.596f * V);
+                }
+                if (planes == 1) {
+                    out[0][x * step] = store((Y - mean[0]) * scale[0]);
+                    continue;
+                }
+                for (int c = 0; c < 3; c++) {
+                    out[c][x * step] = store((bgr[order[c]] - mean[c]) * scale[c]);
+                }
+            }
+        }
+    }
+
+private:
+    const cv::Mat& luma;
+    const cv::Mat& chroma;
+    const BlobSpec& spec;
+    T* data;
+    Store<T> store;
+    std::vector<Tap> xTaps, yTaps, cxTaps, cyTaps;
+    int order[3];
+    float mean[3];
+    float scale[3];
+};
+
+} // namespace
+
+bool nv21ToTensor(const cv::Mat& luma, const cv::Mat& chroma, const BlobSpec& spec, void* data) {
+    if (!data || luma.empty() || luma.type() != CV_8UC1 || spec.size.width <= 0 || spec.size.height <= 0 ||
+        (spec.channels != 1 && spec.channels != 3) || spec.quantScale <= 0.0f) {
+        return false;
+    }
+    if (!chroma.empty() && (chroma.type() != CV_8UC2 || chroma.cols != luma.cols / 2 || chroma.rows != luma.rows / 2)) {
+        return false;
+    }
+    const cv::Range rows(0, spec.size.height);
+    switch (spec.depth) {
+        case CV_32F:
+            cv::parallel_for_(rows, Nv21BlobBody<float>(luma, chroma, spec, static_cast<float*>(data)));
+            return true;
+        case CV_16F:
+            cv::parallel_for_(rows, Nv21BlobBody<cv::hfloat>(luma, chroma, spec, static_cast<cv::hfloat*>(data)));
+            return true;
+        case CV_8U:
+            cv::parallel_for_(rows, Nv21BlobBody<uchar>(luma, chroma, spec, static_cast<uchar*>(data)));
+            return true;
+        case CV_8S:
+            cv::parallel_for_(rows, Nv21BlobBody<schar>(luma, chroma, spec, static_cast<schar*>(data)));
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool nv21ToBlob(const cv::Mat& luma, const cv::Mat& chroma, const BlobSpec& spec, cv::Mat& blob) {
+    if (spec.size.width <= 0 || spec.size.height <= 0 || (spec.channels != 1 && spec.channels != 3)) {
+        return false;
+    }
+    const int shape[4] = {1, spec.nhwc ? spec.size.height : spec.channels, spec.nhwc ? spec.size.width : spec.size.height,
+                          spec.nhwc ? spec.channels : spec.size.width};
+    blob.create(4, shape, spec.depth);  // a no-op while the shape and depth are unchanged
+    return nv21ToTensor(luma, chroma, spec, blob.data);
+}
@@ -0,0 +1,35 @@
+#ifndef EDGE_DNN_BLOB_H
+#define EDGE_DNN_BLOB_H
+
+#include <opencv2/core.hpp>
+
+// Network input layout for nv21ToBlob; mean and scale as blobFromImage takes
+// them, applied per output channel (after swapRB)
+struct BlobSpec {
+    cv::Size size{320, 240};       // network input, width x height
+    int channels = 3;              // 3: color, 1: the luma alone
+    bool swapRB = false;           // RGB order instead of BGR
+    cv::Scalar mean;               // subtracted, in 0..255 units
+    cv::Scalar scale{1.0, 1.0, 1.0, 1.0};  // multiplied after the mean
+    int depth = CV_32F;            // CV_32F, CV_16F, or quantized CV_8U / CV_8S
+    bool nhwc = false;             // interleaved channels (TFLite) instead of planes
+    float quantScale = 1.0f;       // CV_8U / CV_8S: value = (q - zeroPoint) * quantScale
+    int zeroPoint = 0;
+};
+
+// The whole NV21 -> BGR -> resize -> blobFromImage chain in one pass: every
+// output pixel samples Y (and VU, when chroma is given) bilinearly at its
+// place in the source, converts to BGR with the BT.601 coefficients of
+// cvtColor's NV21 path, normalizes (and quantizes) and is written straight
+// into its NCHW plane or NHWC slot, so no full-size BGR, resized or float
+// image is ever made. An empty chroma takes the luma as gray (GRAY2BGR).
+// blob (1 x channels x H x W, or 1 x H x W x channels) is reallocated only
+// when the spec's shape or depth changes. False for mismatched planes or an
+// unsupported spec.
+bool nv21ToBlob(const cv::Mat& luma, const cv::Mat& chroma, const BlobSpec& spec, cv::Mat& blob);
+
+// The same pass into memory the caller owns, e.g. an interpreter's input
+// tensor: spec.size.area() * spec.channels elements of spec.depth
+bool nv21ToTensor(const cv::Mat& luma, const cv::Mat& chroma, const BlobSpec& spec, void* data);
+
+#endif // EDGE_DNN_BLOB_H
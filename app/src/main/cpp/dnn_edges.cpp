@@ -0,0 +1,194 @@
+#include "dnn_edges.h"
+#include "memory_budget.h"
+#include "metrics.h"
+#include "thread_policy.h"
+#include <opencv2/imgproc.hpp>
+#include <sys/stat.h>
+
+#define LOG_TAG "DnnEdges"
+#include "logging.h"
+
+namespace {
+
+// Caffe HED's BGR training mean; harmless for nets normalizing internally
+const cv::Scalar kMean(104.00698793, 116.66876762, 122.67891434);
+
+// Probabilities below this (0..255) are dropped, so the soft halo the nets
+// leave around edges does not turn the blend into a wash
+const double kProbabilityFloor = 40.0;
+
+// Threads of a TFLite CPU interpreter: the inference thread and one more
+const int kTfLiteThreads = 2;
+
+// Memory budget of a loaded model beyond its files' size, per input pixel:
+// the float input blob (3 channels) and output, the 8-bit result, and the
+// pending luma, which may be a pyramid level up to twice the input per axis
+const int64_t kBytesPerInputPixel = 3 * 4 + 4 + 1 + 4;
+
+int64_t fileBytes(const std::string& path) {
+    struct stat info {};
+    return !path.empty() && stat(path.c_str(), &info) == 0 ? static_cast<int64_t>(info.st_size) : 0;
+}
+
+}  // namespace
+
+DnnEdgeDetector::~DnnEdgeDetector() {
+    stopThread();
+}
+
+bool DnnEdgeDetector::load(const std::string& model, const std::string& config, const Options& options) {
+    release();
+    // Weights and buffers reserved up front: over the budget, Canny carries on alone
+    const int64_t bytes = fileBytes(options.tfliteModel) + fileBytes(model) + fileBytes(config) +
+                          static_cast<int64_t>(options.inputSize.area()) * kBytesPerInputPixel;
+    if (!memoryBudget().reserve(MemoryClient::DNN, bytes)) {
+        LOGE("❌ Edge model needs %lld bytes, over the memory budget", static_cast<long long>(bytes));
+        return false;
+    }
+    std::unique_ptr<InferenceEngine> created;
+    if (!options.tfliteModel.empty()) {
+        // TFLite edge nets take RGB in 0..1; quantized inputs fold the scale
+        // into their own
+        BlobSpec normalization;
+        normalization.swapRB = true;
+        normalization.scale = cv::Scalar::all(1.0 / 255.0);
+        created = createTfLiteEngine(options.tfliteModel, normalization, options.tfliteGpu, kTfLiteThreads);
+        if (!created && !model.empty()) {
+            LOGW("⚠️ TFLite cannot run %s, falling back to cv::dnn", options.tfliteModel.c_str());
+        }
+    }
+    if (!created && !model.empty()) {
+        // GRAY2BGR, resize and blobFromImage's mean in one pass (dnn_blob.h)
+        BlobSpec spec;
+        spec.size = options.inputSize;
+        spec.mean = kMean;
+        created = createOpenCvDnnEngine(model, config, spec, options.preferOpenClFp16);
+    }
+    if (!created) {
+        LOGE("❌ No engine can run the edge model");
+        memoryBudget().release(MemoryClient::DNN, bytes);
+        return false;
+    }
+    LOGI("✅ Edge model on %s (%dx%d)", inferenceEngineName(created->kind()), created->inputSize().width,
+         created->inputSize().height);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    engine = std::move(created);
+    inputSize = engine->inputSize();
+    reservedBytes = bytes;
+    stopping = false;
+    loaded = true;
+    thread = std::thread(&DnnEdgeDetector::run, this);
+    return true;
+}
+
+bool DnnEdgeDetector::ready() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return loaded;
+}
+
+int DnnEdgeDetector::engineKind() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return loaded ? engine->kind() : -1;
+}
+
+cv::Size DnnEdgeDetector::idleInputSize() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return (loaded && !busy && !hasPending) ? inputSize : cv::Size();
+}
+
+void DnnEdgeDetector::submit(const cv::Mat& luma) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!loaded || busy || hasPending) {
+        return;
+    }
+    luma.copyTo(pending);
+    hasPending = true;
+    wakeup.notify_one();
+}
+
+bool DnnEdgeDetector::blendLatest(cv::Mat& edges) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (result.empty()) {
+        return false;
+    }
+    if (resizedSequence != resultSequence || resized.size() != edges.size()) {
+        cv::resize(result, resized, edges.size(), 0, 0, cv::INTER_LINEAR);
+        resizedSequence = resultSequence;
+    }
+    edges.convertTo(edges, -1, 0.5);
+    cv::max(edges, resized, edges);
+    return true;
+}
+
+void DnnEdgeDetector::release() {
+    stopThread();
+    std::lock_guard<std::mutex> lock(mutex);
+    loaded = false;
+    hasPending = false;
+    pending.release();
+    result.release();
+    resized.release();
+    engine.reset();
+    memoryBudget().release(MemoryClient::DNN, reservedBytes);
+    reservedBytes = 0;
+}
+
+void DnnEdgeDetector::stopThread() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeup.notify_one();
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+cv::Mat DnnEdgeDetector::infer(const cv::Mat& luma) {
+    // H x W probabilities
+    engine->run(luma, cv::Mat(), probability);
+    cv::Mat pixels;
+    probability.convertTo(pixels, CV_8U, 255.0);
+    cv::threshold(pixels, pixels, kProbabilityFloor, 0, cv::THRESH_TOZERO);
+    return pixels;
+}
+
+void DnnEdgeDetector::run() {
+    // Leftover capacity only; its parallel_for_ loops stay on this thread
+    // (WorkStealingPool) rather than borrowing the processing pool
+    setThreadTier(ThreadTier::ANALYTICS);
+    cv::Mat frame;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wakeup.wait(lock, [this] { return stopping || hasPending; });
+        if (stopping) {
+            return;
+        }
+        std::swap(frame, pending);
+        hasPending = false;
+        busy = true;
+        lock.unlock();
+
+        cv::Mat pixels;
+        yieldToForeground();
+        try {
+            ScopedStageTimer timer(Stage::DNN_INFERENCE);
+            pixels = infer(frame);
+        } catch (const cv::Exception& e) {
+            LOGE_RATELIMITED("❌ Edge model inference failed: %s", e.what());
+        }
+
+        lock.lock();
+        busy = false;
+        if (!pixels.empty()) {
+            result = pixels;
+            resultSequence++;
+        }
+    }
+}
+
+DnnEdgeDetector& dnnEdgeDetector() {
+    static DnnEdgeDetector detector;
+    return detector;
+}
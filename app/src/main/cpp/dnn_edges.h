@@ -0,0 +1,91 @@
+#ifndef EDGE_DNN_EDGES_H
+#define EDGE_DNN_EDGES_H
+
+#include "inference_engine.h"
+#include <opencv2/core.hpp>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Learned edges (HED, PiDiNet or any net with one 1xHxW edge probability
+// output) through an InferenceEngine: a TFLite model on the GPU delegate or
+// the CPU when one is given and the runtime is packaged, cv::dnn otherwise.
+// Inference is far slower than the frame rate, so it runs on a thread of its
+// own: the pipeline hands it a luma frame whenever it
+// is idle and never waits for it. Every frame in between is Canny blended with
+// the most recent network output.
+class DnnEdgeDetector {
+public:
+    struct Options {
+        cv::Size inputSize{320, 240};  // network input; results are resized to the frame
+        bool preferOpenClFp16 = true;  // DNN_TARGET_OPENCL_FP16 when the device lists it
+        std::string tfliteModel;       // tried first when set; its input size is its own
+        bool tfliteGpu = true;         // GPU delegate, falling back to the TFLite CPU
+    };
+
+    ~DnnEdgeDetector();
+
+    // Creates the engine: options.tfliteModel on TFLite when set, else (or
+    // when TFLite cannot run it) model through cv::dnn (config may be empty
+    // for single-file formats such as ONNX; model may be empty to require
+    // TFLite). The engine's warm-up inference means the first real frame does
+    // not pay for lazy initialization. Starts the inference thread and
+    // replaces a model loaded earlier. Blocks for the whole load; call it
+    // once at startup, off the UI thread. False without loading when the
+    // model files and buffers do not fit the memory budget (memory_budget.h).
+    bool load(const std::string& model, const std::string& config, const Options& options);
+
+    bool ready();
+
+    // InferenceEngine::Kind of the loaded model; -1 when none is
+    int engineKind();
+
+    // Network input size while a model is loaded and the inference thread is
+    // idle, i.e. when submit() would take a frame; empty otherwise
+    cv::Size idleInputSize();
+
+    // Copies luma (CV_8UC1) to the inference thread if it is idle; a no-op
+    // while it is busy
+    void submit(const cv::Mat& luma);
+
+    // Merges the latest network output into edges (CV_8UC1 Canny of the
+    // current frame, modified in place): Canny at half strength under the
+    // learned edges, so motion since the last inference still shows. False
+    // (edges untouched) before the first result.
+    bool blendLatest(cv::Mat& edges);
+
+    // Stops the thread and drops the network
+    void release();
+
+private:
+    void run();
+    cv::Mat infer(const cv::Mat& luma);
+    void stopThread();
+
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    std::thread thread;
+    bool stopping = false;
+    bool hasPending = false;
+    bool busy = false;
+    cv::Mat pending;             // owned copy of the submitted luma
+
+    std::unique_ptr<InferenceEngine> engine;  // inference thread only (after load)
+    cv::Size inputSize;
+    cv::Mat probability;         // engine output scratch
+
+    cv::Mat result;              // last output, CV_8UC1 at network resolution
+    uint64_t resultSequence = 0;
+    cv::Mat resized;             // result at the size blendLatest was last asked for
+    uint64_t resizedSequence = 0;
+    bool loaded = false;
+    int64_t reservedBytes = 0;   // against the memory budget (memory_budget.h) while loaded
+};
+
+// Detector used by EDGE_BACKEND_DNN
+DnnEdgeDetector& dnnEdgeDetector();
+
+#endif // EDGE_DNN_EDGES_H
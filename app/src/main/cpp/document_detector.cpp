@@ -0,0 +1,88 @@
+#include "document_detector.h"
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const double kApproxFraction = 0.02;   // approxPolyDP tolerance relative to the perimeter
+const double kMinAreaFraction = 0.1;   // of the edge map; smaller quads are not documents
+const float kSmoothing = 0.35f;        // weight of the newest detection
+const float kSnapFraction = 0.15f;     // a corner jump above this share of the diagonal resets
+const int kMaxMissed = 5;              // frames a tracked quad survives without a detection
+
+// Orders four corners clockwise from the top-left: smallest x + y first,
+// largest last, and the other two by y - x
+void orderCorners(const std::vector<cv::Point>& points, cv::Point2f out[4]) {
+    int tl = 0, br = 0, tr = 0, bl = 0;
+    for (int i = 1; i < 4; i++) {
+        if (points[i].x + points[i].y < points[tl].x + points[tl].y) tl = i;
+        if (points[i].x + points[i].y > points[br].x + points[br].y) br = i;
+        if (points[i].y - points[i].x < points[tr].y - points[tr].x) tr = i;
+        if (points[i].y - points[i].x > points[bl].y - points[bl].x) bl = i;
+    }
+    out[0] = points[tl];
+    out[1] = points[tr];
+    out[2] = points[br];
+    out[3] = points[bl];
+}
+
+}  // namespace
+
+bool DocumentDetector::findQuad(const cv::Mat& edges, cv::Point2f quad[4]) {
+    cv::findContours(edges, contours, cv::RETR_LIST, cv::CHAIN_APPROX_SIMPLE);
+    const double minArea = kMinAreaFraction * edges.total();
+    double bestArea = 0.0;
+    for (const std::vector<cv::Point>& contour : contours) {
+        // The bounding box bounds the area, so most contours stop here
+        cv::Rect box = cv::boundingRect(contour);
+        if (static_cast<double>(box.area()) < std::max(minArea, bestArea)) {
+            continue;
+        }
+        cv::approxPolyDP(contour, approx, kApproxFraction * cv::arcLength(contour, true), true);
+        if (approx.size() != 4 || !cv::isContourConvex(approx)) {
+            continue;
+        }
+        double area = std::fabs(cv::contourArea(approx));
+        if (area >= minArea && area > bestArea) {
+            bestArea = area;
+            orderCorners(approx, quad);
+        }
+    }
+    return bestArea > 0.0;
+}
+
+bool DocumentDetector::detect(const cv::Mat& edges, cv::Point2f corners[4]) {
+    std::lock_guard<std::mutex> lock(mutex);
+    cv::Point2f quad[4];
+    if (findQuad(edges, quad)) {
+        const float diagonal = std::hypot(static_cast<float>(edges.cols), static_cast<float>(edges.rows));
+        bool snap = !tracking;
+        for (int i = 0; i < 4 && !snap; i++) {
+            cv::Point2f delta = quad[i] - smoothed[i];
+            snap = std::hypot(delta.x, delta.y) > kSnapFraction * diagonal;
+        }
+        for (int i = 0; i < 4; i++) {
+            smoothed[i] = snap ? quad[i] : smoothed[i] + kSmoothing * (quad[i] - smoothed[i]);
+        }
+        tracking = true;
+        missed = 0;
+    } else if (tracking && ++missed > kMaxMissed) {
+        tracking = false;
+    }
+    if (tracking) {
+        std::copy(smoothed, smoothed + 4, corners);
+    }
+    return tracking;
+}
+
+void DocumentDetector::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    tracking = false;
+    missed = 0;
+}
+
+DocumentDetector& documentDetector() {
+    static DocumentDetector detector;
+    return detector;
+}
@@ -0,0 +1,36 @@
+#ifndef EDGE_DOCUMENT_DETECTOR_H
+#define EDGE_DOCUMENT_DETECTOR_H
+
+#include <opencv2/core.hpp>
+#include <mutex>
+#include <vector>
+
+// Largest convex quadrilateral of an edge map (a document, screen or sign).
+// It works on the Canny output the pipeline already has, so it adds only the
+// contour analysis, and the corners are smoothed over time so the outline
+// does not shimmer between frames.
+class DocumentDetector {
+public:
+    // Writes the smoothed corners (top-left, top-right, bottom-right,
+    // bottom-left in edge map pixels) and returns true while a quadrilateral
+    // is tracked; a short dropout keeps the last one
+    bool detect(const cv::Mat& edges, cv::Point2f corners[4]);
+
+    // Forgets the tracked quadrilateral, e.g. when the ROI moved
+    void reset();
+
+private:
+    bool findQuad(const cv::Mat& edges, cv::Point2f quad[4]);
+
+    std::mutex mutex;
+    std::vector<std::vector<cv::Point>> contours;
+    std::vector<cv::Point> approx;
+    cv::Point2f smoothed[4];
+    bool tracking = false;
+    int missed = 0;
+};
+
+// Detector used by the DOCUMENT render mode
+DocumentDetector& documentDetector();
+
+#endif // EDGE_DOCUMENT_DETECTOR_H
@@ -0,0 +1,276 @@
+#include "edge_archive.h"
+#include "packed_edges.h"
+#include "thread_policy.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#define LOG_TAG "EdgeArchive"
+#include "logging.h"
+
+namespace {
+
+static_assert(sizeof(EdgeArchiveRecord) == 24, "EdgeArchiveRecord is the file layout");
+static_assert(sizeof(EdgeArchiveIndexEntry) == 24, "EdgeArchiveIndexEntry is the file layout");
+
+const uint32_t kArchiveVersion = 1;
+const size_t kDataBufferBytes = 1 << 20;    // flushed per keyframe or when full
+const size_t kIndexBufferBytes = 4096;
+
+std::string indexPath(const std::string& path) {
+    return path + ".idx";
+}
+
+} // namespace
+
+EdgeArchiver::~EdgeArchiver() {
+    stop();
+}
+
+bool EdgeArchiver::start(const std::string& path, int interval, int minIntervalMs) {
+    stop();
+    if (path.empty()) {
+        return false;
+    }
+    data = std::fopen(path.c_str(), "wbe");
+    index = data ? std::fopen(indexPath(path).c_str(), "wbe") : nullptr;
+    if (!data || !index) {
+        LOGE("❌ Cannot create edge archive %s: %s", path.c_str(), strerror(errno));
+        if (data) {
+            std::fclose(data);
+            data = nullptr;
+        }
+        return false;
+    }
+    std::setvbuf(data, nullptr, _IOFBF, kDataBufferBytes);
+    std::setvbuf(index, nullptr, _IOFBF, kIndexBufferBytes);
+
+    EdgeArchiveHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, "EDGEARC", 8);
+    header.version = kArchiveVersion;
+    header.keyframeInterval = static_cast<uint32_t>(std::max(1, interval));
+    std::fwrite(&header, sizeof(header), 1, data);
+    offset = sizeof(header);
+    keyframeInterval = std::max(1, interval);
+    sinceKeyframe = 0;
+    frameCounter = 0;
+    previous = cv::Mat();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = false;
+        queue.clear();
+        minIntervalNs = static_cast<int64_t>(std::max(0, minIntervalMs)) * 1000000;
+        lastOfferNs = 0;
+    }
+    running.store(true, std::memory_order_release);
+    thread = std::thread(&EdgeArchiver::run, this);
+    LOGI("✅ Archiving edges to %s (keyframe every %d frames)", path.c_str(), keyframeInterval);
+    return true;
+}
+
+void EdgeArchiver::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeup.notify_one();
+    if (thread.joinable()) {
+        thread.join();
+    }
+    running.store(false, std::memory_order_release);
+    if (data) {
+        std::fclose(data);
+        data = nullptr;
+    }
+    if (index) {
+        std::fclose(index);
+        index = nullptr;
+    }
+    previous = cv::Mat();
+}
+
+void EdgeArchiver::offer(const cv::Mat& edges, int bitmapWidth, int64_t timestampNs) {
+    if (!running.load(std::memory_order_acquire) || edges.empty() || edges.type() != CV_8UC1) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (minIntervalNs > 0 && lastOfferNs != 0 && timestampNs - lastOfferNs < minIntervalNs) {
+            skipped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (queue.size() >= kMaxQueued) {
+            // Holding more would pin pooled buffers the live path needs
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        lastOfferNs = timestampNs;
+        Pending pending;
+        pending.edges = edges;  // header only; the published buffer is immutable
+        pending.bitmapWidth = bitmapWidth;
+        pending.timestampNs = timestampNs;
+        queue.push_back(std::move(pending));
+    }
+    wakeup.notify_one();
+}
+
+EdgeArchiveStats EdgeArchiver::stats() const {
+    EdgeArchiveStats result;
+    result.framesArchived = archived.load(std::memory_order_relaxed);
+    result.keyframes = keyframes.load(std::memory_order_relaxed);
+    result.framesSkipped = skipped.load(std::memory_order_relaxed);
+    result.framesDropped = dropped.load(std::memory_order_relaxed);
+    result.rawBytes = rawBytes.load(std::memory_order_relaxed);
+    result.storedBytes = storedBytes.load(std::memory_order_relaxed);
+    return result;
+}
+
+void EdgeArchiver::run() {
+    setThreadTier(ThreadTier::ANALYTICS);
+    while (true) {
+        Pending frame;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeup.wait(lock, [this] { return !queue.empty() || stopping; });
+            if (queue.empty()) {
+                break;  // stopping with everything queued written
+            }
+            frame = std::move(queue.front());
+            queue.pop_front();
+        }
+        yieldToForeground();  // one frame per chunk; the queue absorbs the delay
+        if (!append(frame)) {
+            LOGE("❌ Edge archive write failed: %s; archiving stopped", strerror(errno));
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.clear();
+            running.store(false, std::memory_order_release);
+            break;
+        }
+    }
+    if (data) {
+        std::fflush(data);
+    }
+    if (index) {
+        std::fflush(index);
+    }
+}
+
+bool EdgeArchiver::append(const Pending& frame) {
+    const bool alreadyPacked = frame.bitmapWidth > 0;
+    const int width = alreadyPacked ? frame.bitmapWidth : frame.edges.cols;
+    if (width > 0xffff || frame.edges.rows > 0xffff) {
+        return true;  // not representable; skip rather than stop
+    }
+    const cv::Mat* bits = &frame.edges;
+    if (!alreadyPacked) {
+        packEdges(frame.edges, packed);
+        bits = &packed;
+    } else if (!frame.edges.isContinuous()) {
+        frame.edges.copyTo(packed);
+        bits = &packed;
+    }
+    const bool keyframe = previous.size() != bits->size() || previousWidth != width ||
+                          ++sinceKeyframe >= keyframeInterval;
+    if (keyframe) {
+        sinceKeyframe = 0;
+        encodeZeroRuns(bits->data, bits->total(), encoded);
+    } else {
+        cv::bitwise_xor(*bits, previous, delta);
+        encodeZeroRuns(delta.data, delta.total(), encoded);
+    }
+
+    EdgeArchiveRecord record;
+    std::memset(&record, 0, sizeof(record));
+    record.payloadBytes = static_cast<uint32_t>(encoded.size());
+    record.frame = frameCounter;
+    record.width = static_cast<uint16_t>(width);
+    record.height = static_cast<uint16_t>(bits->rows);
+    record.flags = keyframe ? kEdgeArchiveKeyframe : 0;
+    record.timestampNs = frame.timestampNs;
+    if (keyframe) {
+        // Everything before this keyframe reaches the file before it is indexed
+        EdgeArchiveIndexEntry entry;
+        std::memset(&entry, 0, sizeof(entry));
+        entry.frame = frameCounter;
+        entry.timestampNs = frame.timestampNs;
+        entry.offset = offset;
+        if (std::fflush(data) != 0 || std::fwrite(&entry, sizeof(entry), 1, index) != 1 ||
+            std::fflush(index) != 0) {
+            return false;
+        }
+        keyframes.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (std::fwrite(&record, sizeof(record), 1, data) != 1 ||
+        (!encoded.empty() && std::fwrite(encoded.data(), encoded.size(), 1, data) != 1)) {
+        return false;
+    }
+    const size_t written = sizeof(record) + encoded.size();
+    offset += written;
+    frameCounter++;
+    bits->copyTo(previous);
+    previousWidth = width;
+    archived.fetch_add(1, std::memory_order_relaxed);
+    rawBytes.fetch_add(static_cast<uint64_t>(width) * bits->rows, std::memory_order_relaxed);
+    storedBytes.fetch_add(written, std::memory_order_relaxed);
+    return true;
+}
+
+EdgeArchiver& edgeArchiver() {
+    static EdgeArchiver archiver;
+    return archiver;
+}
+
+bool readArchivedEdges(const std::string& path, uint32_t frame, cv::Mat& bits, int& width, int64_t& timestampNs) {
+    FILE* indexFile = std::fopen(indexPath(path).c_str(), "rbe");
+    if (!indexFile) {
+        return false;
+    }
+    // Last keyframe at or before frame; entries are in frame order
+    EdgeArchiveIndexEntry entry;
+    EdgeArchiveIndexEntry start;
+    bool found = false;
+    while (std::fread(&entry, sizeof(entry), 1, indexFile) == 1 && entry.frame <= frame) {
+        start = entry;
+        found = true;
+    }
+    std::fclose(indexFile);
+    FILE* dataFile = found ? std::fopen(path.c_str(), "rbe") : nullptr;
+    if (!dataFile) {
+        return false;
+    }
+
+    bool ok = false;
+    EdgeArchiveRecord record;
+    std::vector<uint8_t> payload;
+    cv::Mat delta;
+    if (fseeko(dataFile, static_cast<off_t>(start.offset), SEEK_SET) == 0) {
+        while (std::fread(&record, sizeof(record), 1, dataFile) == 1 && record.frame <= frame) {
+            payload.resize(record.payloadBytes);
+            if (!payload.empty() && std::fread(payload.data(), payload.size(), 1, dataFile) != 1) {
+                break;  // truncated tail
+            }
+            const int rowBytes = packedEdgeRowBytes(record.width);
+            const bool keyframe = (record.flags & kEdgeArchiveKeyframe) != 0;
+            if (!keyframe && (bits.rows != record.height || bits.cols != rowBytes)) {
+                break;  // a delta must follow a frame of its geometry
+            }
+            cv::Mat& target = keyframe ? bits : delta;
+            target.create(record.height, rowBytes, CV_8UC1);
+            if (!decodeZeroRuns(payload.data(), payload.size(), target.data, target.total())) {
+                break;
+            }
+            if (!keyframe) {
+                cv::bitwise_xor(bits, delta, bits);
+            }
+            if (record.frame == frame) {
+                width = record.width;
+                timestampNs = record.timestampNs;
+                ok = true;
+                break;
+            }
+        }
+    }
+    std::fclose(dataFile);
+    return ok;
+}
@@ -0,0 +1,125 @@
+#ifndef EDGE_EDGE_ARCHIVE_H
+#define EDGE_EDGE_ARCHIVE_H
+
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Archive file (little-endian): an EdgeArchiveHeader, then per archived frame
+// an EdgeArchiveRecord and payloadBytes of encodeZeroRuns (packed_edges.h)
+// over the 1-bpp bitmap, XORed with the previous frame's unless the record is
+// a keyframe. A static scene makes the deltas almost all zero bytes, which
+// the coder stores as a count. The index file (path + ".idx") lists every
+// keyframe as an EdgeArchiveIndexEntry, so a reader seeks to the keyframe at
+// or before a frame and applies the deltas after it. Both files are only
+// appended to: a crash loses the unflushed tail, never what precedes it.
+struct EdgeArchiveHeader {
+    char magic[8];           // "EDGEARC\0"
+    uint32_t version;        // 1
+    uint32_t keyframeInterval;
+};
+
+struct EdgeArchiveRecord {
+    uint32_t payloadBytes;
+    uint32_t frame;          // 0-based, consecutive
+    uint16_t width;
+    uint16_t height;
+    uint16_t flags;          // kEdgeArchiveKeyframe
+    uint16_t reserved;
+    int64_t timestampNs;     // capture time on CLOCK_BOOTTIME
+};
+
+struct EdgeArchiveIndexEntry {
+    uint32_t frame;
+    uint32_t reserved;
+    int64_t timestampNs;
+    uint64_t offset;         // of the keyframe's record in the archive
+};
+
+const uint16_t kEdgeArchiveKeyframe = 1;
+
+struct EdgeArchiveStats {
+    uint64_t framesArchived = 0;
+    uint64_t keyframes = 0;
+    uint64_t framesSkipped = 0;   // closer than the minimum interval to the last archived one
+    uint64_t framesDropped = 0;   // the writer thread was kMaxQueued frames behind
+    uint64_t rawBytes = 0;        // of the archived maps at one byte per pixel
+    uint64_t storedBytes = 0;     // records and payloads written
+};
+
+// Long-term edge recording. offer() only queues a Mat header of the
+// (immutable) published map; a low-priority thread packs, deltas, codes and
+// appends it through large stdio buffers, so the storage sees a few big
+// writes per keyframe interval instead of one per frame.
+class EdgeArchiver {
+public:
+    static const size_t kMaxQueued = 4;
+
+    ~EdgeArchiver();
+
+    // keyframeInterval: frames per keyframe (>= 1); minIntervalMs: archive
+    // at most one frame per interval (0 = every frame)
+    bool start(const std::string& path, int keyframeInterval, int minIntervalMs);
+    void stop();
+    bool isRunning() const { return running.load(std::memory_order_acquire); }
+
+    // edges: 8-bit binary map, or a 1-bpp bitmap when bitmapWidth > 0
+    void offer(const cv::Mat& edges, int bitmapWidth, int64_t timestampNs);
+
+    EdgeArchiveStats stats() const;
+
+private:
+    struct Pending {
+        cv::Mat edges;
+        int bitmapWidth = 0;
+        int64_t timestampNs = 0;
+    };
+
+    void run();
+    bool append(const Pending& frame);
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    std::deque<Pending> queue;
+    bool stopping = false;
+    int64_t minIntervalNs = 0;
+    int64_t lastOfferNs = 0;
+
+    // Writer thread only
+    FILE* data = nullptr;
+    FILE* index = nullptr;
+    uint64_t offset = 0;
+    int keyframeInterval = 300;
+    int sinceKeyframe = 0;
+    uint32_t frameCounter = 0;
+    int previousWidth = 0;
+    cv::Mat previous;
+    cv::Mat packed;
+    cv::Mat delta;
+    std::vector<uint8_t> encoded;
+
+    std::atomic<bool> running{false};
+    std::atomic<uint64_t> archived{0};
+    std::atomic<uint64_t> keyframes{0};
+    std::atomic<uint64_t> skipped{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> rawBytes{0};
+    std::atomic<uint64_t> storedBytes{0};
+};
+
+EdgeArchiver& edgeArchiver();
+
+// Frame `frame` of an archive as a 1-bpp bitmap (packed_edges.h) of the
+// returned width; false when the files cannot be read or the frame was never
+// archived (or is in the unflushed tail)
+bool readArchivedEdges(const std::string& path, uint32_t frame, cv::Mat& bits, int& width, int64_t& timestampNs);
+
+#endif // EDGE_EDGE_ARCHIVE_H
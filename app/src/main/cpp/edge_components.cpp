@@ -0,0 +1,85 @@
+#include "edge_components.h"
+#include <opencv2/core/utility.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+
+namespace {
+
+const int kBandRows = 32;
+
+// Each pixel's label through the keep table, bands of kBandRows rows
+class KeepBody : public cv::ParallelLoopBody {
+public:
+    KeepBody(const cv::Mat& labels, const uchar* keep, cv::Mat& kept) : labels(labels), keep(keep), kept(kept) {}
+
+    void operator()(const cv::Range& range) const override {
+        const int width = labels.cols;
+        const int y1 = std::min(labels.rows, range.end * kBandRows);
+        for (int y = range.start * kBandRows; y < y1; y++) {
+            const int* in = labels.ptr<int>(y);
+            uchar* out = kept.ptr<uchar>(y);
+            for (int x = 0; x < width; x++) {
+                out[x] = keep[in[x]];
+            }
+        }
+    }
+
+private:
+    const cv::Mat& labels;
+    const uchar* keep;
+    cv::Mat& kept;
+};
+
+} // namespace
+
+void EdgeComponents::setParams(const Params& params) {
+    std::lock_guard<std::mutex> lock(mutex);
+    current = params;
+}
+
+EdgeComponents::Params EdgeComponents::params() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return current;
+}
+
+bool EdgeComponents::active() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return current.minPixels > 1 || current.minLength > 1 || current.report;
+}
+
+int EdgeComponents::filter(const cv::Mat& edges, cv::Mat& kept, Component* components, int maxComponents,
+                           int& total) {
+    CV_Assert(edges.type() == CV_8UC1 && !edges.empty() && kept.data != edges.data);
+    std::lock_guard<std::mutex> lock(mutex);
+    // Non-zero is foreground, so the map needs no thresholding first
+    const int count = cv::connectedComponentsWithStats(edges, labels, stats, centroids, 8, CV_32S,
+                                                       cv::CCL_SPAGHETTI);
+    keep.assign(static_cast<size_t>(count), 0);
+    int passed = 0;
+    for (int label = 1; label < count; label++) {
+        const int* s = stats.ptr<int>(label);
+        const int pixels = s[cv::CC_STAT_AREA];
+        const int length = std::max(s[cv::CC_STAT_WIDTH], s[cv::CC_STAT_HEIGHT]);
+        if (pixels < current.minPixels || length < current.minLength) {
+            continue;
+        }
+        keep[static_cast<size_t>(label)] = 255;
+        if (passed < maxComponents) {
+            components[passed].box = cv::Rect(s[cv::CC_STAT_LEFT], s[cv::CC_STAT_TOP], s[cv::CC_STAT_WIDTH],
+                                              s[cv::CC_STAT_HEIGHT]);
+            components[passed].pixels = pixels;
+        }
+        passed++;
+    }
+    total = count - 1;
+
+    kept.create(edges.size(), CV_8UC1);
+    const int bands = (edges.rows + kBandRows - 1) / kBandRows;
+    cv::parallel_for_(cv::Range(0, bands), KeepBody(labels, keep.data(), kept));
+    return passed;
+}
+
+EdgeComponents& edgeComponents() {
+    static EdgeComponents filter;
+    return filter;
+}
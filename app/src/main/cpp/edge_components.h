@@ -0,0 +1,59 @@
+#ifndef EDGE_EDGE_COMPONENTS_H
+#define EDGE_EDGE_COMPONENTS_H
+
+#include <opencv2/core.hpp>
+#include <mutex>
+#include <vector>
+
+// 8-connected components of a binary edge map with their bounding boxes and
+// pixel counts, from cv::connectedComponentsWithStats with the Spaghetti
+// labeling, which OpenCV runs in parallel: horizontal stripes are labeled
+// independently and their equivalences merged along the seams, stats
+// included. Components with fewer pixels than minPixels, or whose bounding
+// box's longer side is shorter than minLength, are dropped from the output
+// map: speckle goes for one labeling pass where pre-blurring would filter
+// the whole luma, and the kept components' boxes come out of the same pass.
+class EdgeComponents {
+public:
+    struct Params {
+        int minPixels = 0;   // 0/1 = keep any size
+        int minLength = 0;   // px, longer bounding box side; 0/1 = keep any
+        bool report = false; // publish the kept components' boxes
+    };
+
+    struct Component {
+        cv::Rect box;   // edge map pixels
+        int pixels;
+    };
+
+    // Components reported per frame; the map keeps every one that passes
+    static const int kMaxComponents = 1024;
+
+    void setParams(const Params& params);
+    Params params();
+
+    // Something to do: a threshold above 1 or boxes to report
+    bool active();
+
+    // Labels edges (CV_8UC1, non-zero = edge) and writes the pixels of the
+    // components that pass to kept (CV_8UC1 of the same size, 255 / 0; must
+    // not alias edges). Up to maxComponents of them, in raster order of their
+    // first pixel, go to components. Returns how many passed (which may be
+    // more than were written); total gets how many there were.
+    int filter(const cv::Mat& edges, cv::Mat& kept, Component* components, int maxComponents, int& total);
+
+private:
+    std::mutex mutex;
+    Params current;
+    // Scratch reused across frames
+    cv::Mat labels;     // CV_32SC1
+    cv::Mat stats;      // CV_32SC1, cv::CC_STAT_* per label
+    cv::Mat centroids;  // unused, but the stats overload wants it
+    std::vector<uchar> keep;  // per label: 255 kept, 0 dropped (label 0 is the background)
+};
+
+// Filter applied to the CPU edge map before display, export and the edge
+// consumers
+EdgeComponents& edgeComponents();
+
+#endif // EDGE_EDGE_COMPONENTS_H
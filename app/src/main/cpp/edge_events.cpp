@@ -0,0 +1,96 @@
+#include "edge_events.h"
+#include "packed_edges.h"
+#include <cstring>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define EDGE_EVENTS_NEON 1
+#endif
+
+namespace {
+
+// current ^ previous into delta; false when the row did not change at all
+bool xorRow(const uint8_t* current, const uint8_t* previous, uint8_t* delta, int bytes) {
+    int i = 0;
+    uint64_t changed = 0;
+#ifdef EDGE_EVENTS_NEON
+    uint8x16_t any = vdupq_n_u8(0);
+    for (; i + 16 <= bytes; i += 16) {
+        const uint8x16_t d = veorq_u8(vld1q_u8(current + i), vld1q_u8(previous + i));
+        vst1q_u8(delta + i, d);
+        any = vorrq_u8(any, d);
+    }
+    const uint64x2_t lanes = vreinterpretq_u64_u8(any);
+    changed = vgetq_lane_u64(lanes, 0) | vgetq_lane_u64(lanes, 1);
+#else
+    for (; i + 8 <= bytes; i += 8) {
+        uint64_t a;
+        uint64_t b;
+        std::memcpy(&a, current + i, sizeof(a));
+        std::memcpy(&b, previous + i, sizeof(b));
+        const uint64_t d = a ^ b;
+        std::memcpy(delta + i, &d, sizeof(d));
+        changed |= d;
+    }
+#endif
+    for (; i < bytes; i++) {
+        delta[i] = current[i] ^ previous[i];
+        changed |= delta[i];
+    }
+    return changed != 0;
+}
+
+// An event per set bit of delta, its polarity the bit of current; zero
+// words are skipped 32 pixels at a time
+void compactRow(const uint8_t* delta, const uint8_t* current, int width, int y, std::vector<uint32_t>& events) {
+    const int words = (width + 31) / 32;  // packedEdgeRowBytes: whole 32-bit words
+    for (int w = 0; w < words; w++) {
+        uint32_t mask;
+        std::memcpy(&mask, delta + 4 * w, sizeof(mask));
+        if (mask == 0) {
+            continue;
+        }
+        if (w == words - 1 && (width & 31) != 0) {
+            mask &= (1u << (width & 31)) - 1;  // padding bits
+        }
+        uint32_t on;
+        std::memcpy(&on, current + 4 * w, sizeof(on));
+        for (; mask != 0; mask &= mask - 1) {
+            const int bit = __builtin_ctz(mask);
+            events.push_back(edgeEvent(32 * w + bit, y, (on >> bit) & 1u));
+        }
+    }
+}
+
+} // namespace
+
+void EdgeEventEncoder::reset() {
+    previous = cv::Mat();
+    previousWidth = 0;
+    sinceKeyframe = 0;
+}
+
+bool EdgeEventEncoder::encode(const cv::Mat& bits, int width, std::vector<uint32_t>& events) {
+    const int rowBytes = packedEdgeRowBytes(width);
+    CV_Assert(bits.type() == CV_8UC1 && width > 0 && width <= kMaxEdgeEventWidth && bits.rows <= 65536 &&
+              bits.cols >= rowBytes);
+    events.clear();
+    const bool keyframe = previous.empty() || previous.rows != bits.rows || previousWidth != width ||
+                          ++sinceKeyframe >= keyframeInterval;
+    if (keyframe) {
+        sinceKeyframe = 0;
+    }
+    static thread_local std::vector<uint8_t> delta;
+    delta.resize(static_cast<size_t>(rowBytes));
+    for (int y = 0; y < bits.rows; y++) {
+        const uint8_t* row = bits.ptr<uint8_t>(y);
+        if (keyframe) {
+            compactRow(row, row, width, y, events);
+        } else if (xorRow(row, previous.ptr<uint8_t>(y), delta.data(), rowBytes)) {
+            compactRow(delta.data(), row, width, y, events);
+        }
+    }
+    previous = bits;
+    previousWidth = width;
+    return keyframe;
+}
@@ -0,0 +1,48 @@
+#ifndef EDGE_EDGE_EVENTS_H
+#define EDGE_EDGE_EVENTS_H
+
+#include <opencv2/core.hpp>
+#include <cstdint>
+#include <vector>
+
+// One edge change, in the layout of a CV_16UC2 (x, y) point: x in the low 15
+// bits of the first uint16 with kEdgeEventOn above it (set = the pixel
+// became an edge, clear = it stopped being one), then y. Events of a frame
+// are in raster order.
+const uint16_t kEdgeEventOn = 0x8000;
+const int kMaxEdgeEventWidth = 0x8000;
+
+inline uint32_t edgeEvent(int x, int y, bool on) {
+    return static_cast<uint32_t>(x | (on ? kEdgeEventOn : 0)) | static_cast<uint32_t>(y) << 16;
+}
+
+// Diff-only edge output, like an event camera's: each frame becomes the
+// list of edge pixels that appeared or disappeared since the previous one.
+// Both are 1-bpp bitmaps (packed_edges.h), so a row is XORed and tested for
+// change 128 pixels at a time and only the words that differ are compacted;
+// a static scene costs one XOR pass and yields no events. Every
+// keyframeInterval-th frame, and any frame whose grid differs from the
+// last, is a keyframe instead: all of its edge pixels as ON events, from
+// which a consumer that lost track rebuilds the map.
+class EdgeEventEncoder {
+public:
+    // keyframeInterval <= 1: keyframes only
+    explicit EdgeEventEncoder(int keyframeInterval) : keyframeInterval(keyframeInterval) {}
+
+    // The next frame is a keyframe (e.g. the consumer missed the last one)
+    void reset();
+
+    // Events of bits (width pixels per row) into events, replacing its
+    // contents. Returns true for a keyframe. bits is only referenced, not
+    // copied, until the next call: it must not be written meanwhile, as
+    // published frames never are (frame_fanout.h).
+    bool encode(const cv::Mat& bits, int width, std::vector<uint32_t>& events);
+
+private:
+    const int keyframeInterval;
+    cv::Mat previous;  // the last frame's bitmap, the diff reference
+    int previousWidth = 0;
+    int sinceKeyframe = 0;
+};
+
+#endif // EDGE_EDGE_EVENTS_H
@@ -0,0 +1,140 @@
+#include "edge_morphology.h"
+#include <algorithm>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define EDGE_MORPHOLOGY_NEON 1
+#endif
+
+namespace {
+
+struct Max {
+    static uchar identity() { return 0; }
+    static uchar apply(uchar a, uchar b) { return a > b ? a : b; }
+#ifdef EDGE_MORPHOLOGY_NEON
+    static uint8x16_t apply(uint8x16_t a, uint8x16_t b) { return vmaxq_u8(a, b); }
+#endif
+};
+
+struct Min {
+    static uchar identity() { return 255; }
+    static uchar apply(uchar a, uchar b) { return a < b ? a : b; }
+#ifdef EDGE_MORPHOLOGY_NEON
+    static uint8x16_t apply(uint8x16_t a, uint8x16_t b) { return vminq_u8(a, b); }
+#endif
+};
+
+// out[x] = extremum(a[x], b[x]) over one row
+template <typename Extremum>
+void combineRows(const uchar* a, const uchar* b, uchar* out, int width) {
+    int x = 0;
+#ifdef EDGE_MORPHOLOGY_NEON
+    for (; x + 16 <= width; x += 16) {
+        vst1q_u8(out + x, Extremum::apply(vld1q_u8(a + x), vld1q_u8(b + x)));
+    }
+#endif
+    for (; x < width; x++) {
+        out[x] = Extremum::apply(a[x], b[x]);
+    }
+}
+
+// Padded length for n samples and a window of k: the window may hang k / 2
+// samples over the start and the rest over the end, rounded to whole blocks
+int paddedLength(int n, int k) {
+    return (n + k - 1 + k - 1) / k * k;
+}
+
+}  // namespace
+
+template <typename Extremum>
+void RectMorphology::filter(const cv::Mat& src, cv::Mat& dst, int size) {
+    const int width = src.cols;
+    const int height = src.rows;
+    const int before = size / 2;
+
+    // Horizontal: per row, window [x - before, x - before + size) of the
+    // source is [x, x + size) of the padded row, whose extremum is
+    // suffix[x] (to the end of x's block) combined with prefix[x + size - 1]
+    horizontal.create(height, width, CV_8UC1);
+    const int rowLength = paddedLength(width, size);
+    padded.assign(rowLength, Extremum::identity());
+    prefix.resize(rowLength);
+    suffix.resize(rowLength);
+    for (int y = 0; y < height; y++) {
+        const uchar* in = src.ptr<uchar>(y);
+        std::copy(in, in + width, padded.begin() + before);
+        for (int i = 0; i < rowLength; i++) {
+            prefix[i] = (i % size == 0) ? padded[i] : Extremum::apply(prefix[i - 1], padded[i]);
+        }
+        for (int i = rowLength - 1; i >= 0; i--) {
+            suffix[i] = (i % size == size - 1) ? padded[i] : Extremum::apply(suffix[i + 1], padded[i]);
+        }
+        uchar* out = horizontal.ptr<uchar>(y);
+        for (int x = 0; x < width; x++) {
+            out[x] = Extremum::apply(suffix[x], prefix[x + size - 1]);
+        }
+    }
+
+    // Vertical: the same recurrence with whole rows as samples, so every step
+    // is a vector combine of two rows
+    const int columnLength = paddedLength(height, size);
+    rowPrefix.create(columnLength, width, CV_8UC1);
+    rowSuffix.create(columnLength, width, CV_8UC1);
+    auto paddedRow = [&](int i) -> const uchar* {
+        return (i >= before && i - before < height) ? horizontal.ptr<uchar>(i - before) : nullptr;
+    };
+    for (int i = 0; i < columnLength; i++) {
+        const uchar* row = paddedRow(i);
+        uchar* out = rowPrefix.ptr<uchar>(i);
+        if (i % size == 0) {
+            if (row) {
+                std::copy(row, row + width, out);
+            } else {
+                std::fill(out, out + width, Extremum::identity());
+            }
+        } else if (row) {
+            combineRows<Extremum>(rowPrefix.ptr<uchar>(i - 1), row, out, width);
+        } else {
+            std::copy(rowPrefix.ptr<uchar>(i - 1), rowPrefix.ptr<uchar>(i - 1) + width, out);  // identity row
+        }
+    }
+    for (int i = columnLength - 1; i >= 0; i--) {
+        const uchar* row = paddedRow(i);
+        uchar* out = rowSuffix.ptr<uchar>(i);
+        if (i % size == size - 1) {
+            if (row) {
+                std::copy(row, row + width, out);
+            } else {
+                std::fill(out, out + width, Extremum::identity());
+            }
+        } else if (row) {
+            combineRows<Extremum>(rowSuffix.ptr<uchar>(i + 1), row, out, width);
+        } else {
+            std::copy(rowSuffix.ptr<uchar>(i + 1), rowSuffix.ptr<uchar>(i + 1) + width, out);
+        }
+    }
+    dst.create(height, width, CV_8UC1);
+    for (int y = 0; y < height; y++) {
+        combineRows<Extremum>(rowSuffix.ptr<uchar>(y), rowPrefix.ptr<uchar>(y + size - 1), dst.ptr<uchar>(y), width);
+    }
+}
+
+void RectMorphology::apply(const cv::Mat& src, cv::Mat& dst, Op op, int size) {
+    CV_Assert(src.type() == CV_8UC1 && size >= 1 && src.data != dst.data);
+    std::lock_guard<std::mutex> lock(mutex);
+    if (size == 1) {
+        src.copyTo(dst);
+        return;
+    }
+    if (op == Op::CLOSE) {
+        filter<Max>(src, dilated, size);
+        filter<Min>(dilated, dst, size);
+    } else {
+        filter<Max>(src, dst, size);
+    }
+}
+
+RectMorphology& rectMorphology() {
+    static RectMorphology morphology;
+    return morphology;
+}
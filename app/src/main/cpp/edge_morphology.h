@@ -0,0 +1,42 @@
+#ifndef EDGE_EDGE_MORPHOLOGY_H
+#define EDGE_EDGE_MORPHOLOGY_H
+
+#include <opencv2/core.hpp>
+#include <mutex>
+#include <vector>
+
+// Dilation and closing of CV_8UC1 maps with a size x size rectangle, for
+// thickening 1-pixel edges that GL minification would otherwise alias away.
+// Both separable passes use the van Herk/Gil-Werman recurrence (block prefix
+// and suffix extrema, then one combine per pixel), so the cost is about three
+// min/max operations per pixel and pass whatever the kernel size; the
+// vertical pass combines whole rows with NEON. Pixels beyond the border do
+// not contribute, the way cv::dilate and cv::erode treat them by default.
+class RectMorphology {
+public:
+    enum class Op {
+        DILATE = 0,  // thicker edges
+        CLOSE = 1    // dilate then erode: bridges gaps of up to size - 1 pixels, width unchanged
+    };
+
+    // dst must not alias src; size 1 copies
+    void apply(const cv::Mat& src, cv::Mat& dst, Op op, int size);
+
+private:
+    template <typename Extremum>
+    void filter(const cv::Mat& src, cv::Mat& dst, int size);
+
+    std::mutex mutex;
+    std::vector<uchar> padded;   // one row with the border identity on both sides
+    std::vector<uchar> prefix;
+    std::vector<uchar> suffix;
+    cv::Mat rowPrefix;           // vertical pass: padded rows of block prefix/suffix extrema
+    cv::Mat rowSuffix;
+    cv::Mat horizontal;          // between the two passes
+    cv::Mat dilated;             // CLOSE between dilation and erosion
+};
+
+// Instance used for the displayed edge map
+RectMorphology& rectMorphology();
+
+#endif // EDGE_EDGE_MORPHOLOGY_H
@@ -0,0 +1,54 @@
+#include "edge_points.h"
+#include "kernel_dispatch.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// Accounts a row that had total edge pixels, of which the room left was written
+void addRow(EdgePointSink& sink, int total) {
+    const int written = std::min(total, sink.capacity - sink.count);
+    sink.count += written;
+    sink.dropped += total - written;
+}
+
+} // namespace
+
+void compactEdgePoints(const cv::Mat& edges, EdgePointSink& sink) {
+    CV_Assert(edges.type() == CV_8UC1 && edges.cols <= 65536 && edges.rows <= 65536);
+    sink.count = 0;
+    sink.dropped = 0;
+    const CompactRowFn compactRow = edgeKernels().compactRow;  // kernel_dispatch.h
+    for (int y = 0; y < edges.rows; y++) {
+        const int total = compactRow(edges.ptr<uint8_t>(y), edges.cols, y, sink.points + 2 * sink.count,
+                                     sink.capacity - sink.count);
+        addRow(sink, total);
+    }
+}
+
+void compactPackedEdgePoints(const cv::Mat& bits, int width, EdgePointSink& sink) {
+    CV_Assert(bits.type() == CV_8UC1 && width <= 65536 && bits.rows <= 65536);
+    sink.count = 0;
+    sink.dropped = 0;
+    const int words = (width + 31) / 32;  // packedEdgeRowBytes: whole 32-bit words
+    for (int y = 0; y < bits.rows; y++) {
+        const uint8_t* row = bits.ptr<uint8_t>(y);
+        int total = 0;
+        for (int w = 0; w < words; w++) {
+            uint32_t mask;
+            std::memcpy(&mask, row + 4 * w, sizeof(mask));
+            if (w == words - 1 && (width & 31) != 0) {
+                mask &= (1u << (width & 31)) - 1;  // padding bits
+            }
+            for (; mask != 0; mask &= mask - 1) {
+                const int n = sink.count + total;
+                if (n < sink.capacity) {
+                    sink.points[2 * n] = static_cast<uint16_t>(32 * w + __builtin_ctz(mask));
+                    sink.points[2 * n + 1] = static_cast<uint16_t>(y);
+                }
+                total++;
+            }
+        }
+        addRow(sink, total);
+    }
+}
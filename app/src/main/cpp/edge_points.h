@@ -0,0 +1,26 @@
+#ifndef EDGE_EDGE_POINTS_H
+#define EDGE_EDGE_POINTS_H
+
+#include <opencv2/core.hpp>
+#include <cstdint>
+
+// Preallocated output of the compactions below: (x, y) uint16 pairs in the
+// caller's storage for capacity points, in raster order; edge pixels past
+// capacity are only counted
+struct EdgePointSink {
+    uint16_t* points = nullptr;
+    int capacity = 0;
+    int count = 0;
+    int dropped = 0;
+};
+
+// Coordinates of every nonzero pixel of an 8-bit edge map. Rows go through
+// kernel_dispatch.h compactRow, which skips all-zero 16-pixel blocks with
+// one test, so the cost follows the edge density more than the frame size.
+void compactEdgePoints(const cv::Mat& edges, EdgePointSink& sink);
+
+// Same for a 1-bpp bitmap of the given width (packed_edges.h): zero words
+// are skipped 32 pixels at a time
+void compactPackedEdgePoints(const cv::Mat& bits, int width, EdgePointSink& sink);
+
+#endif // EDGE_EDGE_POINTS_H
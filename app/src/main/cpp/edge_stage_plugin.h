@@ -0,0 +1,91 @@
+#ifndef EDGE_STAGE_PLUGIN_H
+#define EDGE_STAGE_PLUGIN_H
+
+/* C ABI of filter graph stage plugins (filter_graph.h), the only header a
+ * plugin includes. A plugin is a shared library exporting
+ * EDGE_STAGE_PLUGIN_ENTRY; loadStagePlugins (stage_plugins.h) dlopens it at
+ * startup and registers each stage it describes under its name, so config
+ * strings use it like a built-in one: "gray|blur:5|acme_ridges:12,3".
+ *
+ * Lifecycle of one stage in a graph: create() with the config arguments,
+ * then for every new input geometry outputType() and scratchBytes(), then
+ * process() per frame, and destroy() when the graph is reconfigured. Calls
+ * on one instance never overlap; instances may live on different threads.
+ *
+ * Buffers are borrowed: input, output and scratch belong to the pipeline
+ * (pooled frame buffers, buffers the graph planned once per geometry, and
+ * scratch allocated when the geometry changed) and are only valid during
+ * the call. process() must not allocate per frame or keep the pointers.
+ * With EDGE_STAGE_IN_PLACE, input and output may be the same pixels.
+ *
+ * Compatibility: the host refuses a plugin whose abiVersion differs from
+ * its own. Later versions of this header only append members to
+ * EdgeStageApi; structSize tells the host which ones a plugin filled.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EDGE_STAGE_PLUGIN_ABI_VERSION 1u
+
+/* Pixel types, numerically OpenCV's CV_8UC1 / CV_8UC3 (BGR) / CV_8UC4 (RGBA) */
+#define EDGE_PIXEL_U8C1 0
+#define EDGE_PIXEL_U8C3 16
+#define EDGE_PIXEL_U8C4 24
+
+/* EdgeStageApi.flags */
+#define EDGE_STAGE_IN_PLACE (1u << 0) /* process() may be given output == input */
+
+/* A borrowed image: rows of stride bytes, tightly packed pixels */
+typedef struct EdgeImage {
+    uint8_t* data;
+    int32_t width;
+    int32_t height;
+    int32_t stride;
+    int32_t type; /* EDGE_PIXEL_* */
+} EdgeImage;
+
+typedef struct EdgeStageApi {
+    uint32_t abiVersion;      /* EDGE_STAGE_PLUGIN_ABI_VERSION the plugin was built with */
+    uint32_t structSize;      /* sizeof(EdgeStageApi) the plugin was built with */
+    const char* name;         /* config string name; must not clash with a registered stage */
+    const char* description;  /* one line for logs, may be NULL */
+    uint32_t flags;           /* EDGE_STAGE_* */
+
+    /* Configures an instance from the config arguments (the comma-separated
+     * list after ':', trimmed); NULL when they are invalid */
+    void* (*create)(const char* const* args, int32_t argCount);
+    void (*destroy)(void* instance);
+
+    /* Output pixel type for an input type (same size), or -1 when the stage
+     * cannot take it */
+    int32_t (*outputType)(void* instance, int32_t inputType);
+
+    /* Scratch memory process() needs at this geometry, requested once when
+     * the geometry changes and allocated by the host (64-byte aligned,
+     * contents undefined); 0 for none. NULL = never needs any. */
+    size_t (*scratchBytes)(void* instance, int32_t width, int32_t height, int32_t inputType);
+
+    /* One frame; 0 on success. On failure the graph's output for the frame
+     * is discarded. */
+    int32_t (*process)(void* instance, const EdgeImage* input, EdgeImage* output, void* scratch,
+                       size_t scratchSize);
+} EdgeStageApi;
+
+/* The exported entry point: the plugin's stages, count of them in *count.
+ * hostAbiVersion lets a plugin built for several versions pick its tables.
+ * The returned tables and their strings must stay valid until unload,
+ * which never happens: plugins stay loaded for the life of the process. */
+typedef const EdgeStageApi* const* (*EdgeStagePluginEntry)(uint32_t hostAbiVersion, int32_t* count);
+
+#define EDGE_STAGE_PLUGIN_ENTRY "edge_stage_plugin_stages"
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* EDGE_STAGE_PLUGIN_H */
@@ -0,0 +1,198 @@
+#include "edge_stream.h"
+#include "packed_edges.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define LOG_TAG "EdgeStream"
+#include "logging.h"
+
+namespace {
+
+static_assert(sizeof(EdgeStreamHeader) == 16, "EdgeStreamHeader is the wire layout");
+
+const uint16_t kMagic = 'E' | ('S' << 8);
+const uint8_t kVersion = 1;
+// Enough for a few frames in flight; more would only add latency
+const int kSendBufferBytes = 256 * 1024;
+
+int openSocket(const std::string& host, int port) {
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* addresses = nullptr;
+    const std::string service = std::to_string(port);
+    int status = getaddrinfo(host.c_str(), service.c_str(), &hints, &addresses);
+    if (status != 0) {
+        LOGE("❌ Cannot resolve %s: %s", host.c_str(), gai_strerror(status));
+        return -1;
+    }
+    int fd = -1;
+    for (addrinfo* address = addresses; address && fd < 0; address = address->ai_next) {
+        fd = socket(address->ai_family, address->ai_socktype | SOCK_CLOEXEC, address->ai_protocol);
+        if (fd >= 0 && connect(fd, address->ai_addr, address->ai_addrlen) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(addresses);
+    if (fd < 0) {
+        LOGE("❌ Cannot open a UDP socket to %s:%d: %s", host.c_str(), port, strerror(errno));
+        return -1;
+    }
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &kSendBufferBytes, sizeof(kSendBufferBytes));
+    return fd;
+}
+
+} // namespace
+
+EdgeStreamer::~EdgeStreamer() {
+    stop();
+}
+
+bool EdgeStreamer::start(const std::string& host, int port, int interval) {
+    stop();
+    if (host.empty() || port <= 0 || port > 65535) {
+        return false;
+    }
+    keyframeInterval = std::max(1, interval);
+    std::shared_ptr<FrameQueue> frames = frameFanout().subscribe("edge_stream");
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        queue = frames;
+    }
+    running.store(true, std::memory_order_release);
+    thread = std::thread(&EdgeStreamer::run, this, host, port, frames);
+    return true;
+}
+
+void EdgeStreamer::stop() {
+    std::shared_ptr<FrameQueue> frames;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        frames = queue;
+    }
+    if (frames) {
+        frameFanout().unsubscribe(frames);  // closes it, which wakes the I/O thread
+    }
+    if (thread.joinable()) {
+        thread.join();
+    }
+    if (frames) {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        replacedEarlier += frames->stats().replaced;
+        queue.reset();
+    }
+    running.store(false, std::memory_order_release);
+}
+
+EdgeStreamStats EdgeStreamer::stats() const {
+    EdgeStreamStats result;
+    result.framesSent = sent.load(std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        result.framesReplaced = replacedEarlier + (queue ? queue->stats().replaced : 0);
+    }
+    result.framesCongested = congested.load(std::memory_order_relaxed);
+    result.bytesSent = bytes.load(std::memory_order_relaxed);
+    return result;
+}
+
+void EdgeStreamer::run(std::string host, int port, std::shared_ptr<FrameQueue> frames) {
+    int socketFd = openSocket(host, port);
+    if (socketFd < 0) {
+        running.store(false, std::memory_order_release);
+        return;
+    }
+    LOGI("✅ Streaming edges to %s:%d", host.c_str(), port);
+    previous = cv::Mat();
+    frameCounter = 0;
+    sinceKeyframe = 0;
+    cv::Mat packed;
+    cv::Mat delta;
+    while (true) {
+        const FrameHandle frame = frames->take();
+        if (!frame) {
+            break;  // stopped
+        }
+        const cv::Mat& edges = frame->edges;
+        if (edges.empty() || edges.type() != CV_8UC1) {
+            continue;
+        }
+        const bool alreadyPacked = frame->bitmapWidth > 0;
+        const int width = alreadyPacked ? frame->bitmapWidth : edges.cols;
+
+        // Already packed when the pipeline stores 1-bpp edges
+        const cv::Mat* bits = &edges;
+        if (!alreadyPacked) {
+            packEdges(edges, packed);
+            bits = &packed;
+        }
+        const bool keyframe = previous.size() != bits->size() || ++sinceKeyframe >= keyframeInterval;
+        if (keyframe) {
+            sinceKeyframe = 0;
+        } else {
+            cv::bitwise_xor(*bits, previous, delta);
+        }
+        bool delivered = sendFrame(socketFd, keyframe ? *bits : delta, width, keyframe);
+        frameCounter++;
+        if (delivered) {
+            bits->copyTo(previous);
+            sent.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            previous = cv::Mat();  // the receiver lost the reference: next one is a keyframe
+            congested.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    close(socketFd);
+    previous = cv::Mat();
+    LOGI("✅ Edge stream stopped");
+}
+
+bool EdgeStreamer::sendFrame(int socketFd, const cv::Mat& bits, int width, bool keyframe) {
+    CV_Assert(bits.isContinuous());
+    encodeZeroRuns(bits.data, bits.total(), encoded);
+
+    const size_t payloadBytes = kMaxDatagramBytes - sizeof(EdgeStreamHeader);
+    const size_t fragments = std::max<size_t>(1, (encoded.size() + payloadBytes - 1) / payloadBytes);
+    if (fragments > 0xffff || width > 0xffff || bits.rows > 0xffff) {
+        return false;
+    }
+    uint8_t datagram[kMaxDatagramBytes];
+    EdgeStreamHeader header;
+    header.magic = kMagic;
+    header.version = kVersion;
+    header.flags = keyframe ? kEdgeStreamKeyframe : 0;
+    header.frame = frameCounter;
+    header.fragmentCount = static_cast<uint16_t>(fragments);
+    header.width = static_cast<uint16_t>(width);
+    header.height = static_cast<uint16_t>(bits.rows);
+    for (size_t i = 0; i < fragments; i++) {
+        const size_t offset = i * payloadBytes;
+        const size_t length = std::min(payloadBytes, encoded.size() - std::min(offset, encoded.size()));
+        header.fragment = static_cast<uint16_t>(i);
+        std::memcpy(datagram, &header, sizeof(header));
+        if (length > 0) {
+            std::memcpy(datagram + sizeof(header), encoded.data() + offset, length);
+        }
+        // Never block: a full socket buffer means the network is behind
+        ssize_t written = send(socketFd, datagram, sizeof(header) + length, MSG_DONTWAIT);
+        if (written < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != ENOBUFS) {
+                LOGW_RATELIMITED("⚠️ Edge stream send failed: %s", strerror(errno));
+            }
+            return false;
+        }
+        bytes.fetch_add(static_cast<uint64_t>(written), std::memory_order_relaxed);
+    }
+    return true;
+}
+
+EdgeStreamer& edgeStreamer() {
+    static EdgeStreamer streamer;
+    return streamer;
+}
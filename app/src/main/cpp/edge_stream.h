@@ -0,0 +1,84 @@
+#ifndef EDGE_EDGE_STREAM_H
+#define EDGE_EDGE_STREAM_H
+
+#include "frame_fanout.h"
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Datagram layout (little-endian), at most kMaxDatagramBytes each. A frame is
+// the 1-bpp bitmap of packed_edges.h, XORed with the previous frame unless it
+// is a keyframe, then run-length coded by encodeZeroRuns (repeated zero
+// count, literal count, literal bytes with LEB128 counts); the receiver concatenates the
+// fragments of one frame in order. A lost fragment loses the frame, and
+// every delta until the next keyframe.
+struct EdgeStreamHeader {
+    uint16_t magic;          // 'E' | 'S' << 8
+    uint8_t version;         // 1
+    uint8_t flags;           // kEdgeStreamKeyframe
+    uint32_t frame;          // increments per sent frame
+    uint16_t fragment;
+    uint16_t fragmentCount;
+    uint16_t width;
+    uint16_t height;
+};
+
+const uint8_t kEdgeStreamKeyframe = 1;
+const size_t kMaxDatagramBytes = 1200;  // under common path MTUs, no IP fragmentation
+
+struct EdgeStreamStats {
+    uint64_t framesSent = 0;
+    uint64_t framesReplaced = 0;   // superseded before the I/O thread got to them
+    uint64_t framesCongested = 0;  // abandoned because the socket buffer was full
+    uint64_t bytesSent = 0;
+};
+
+// Remote viewing of the published edge maps over UDP. The streamer is a
+// frame_fanout.h consumer: publishing only swaps a shared frame handle into
+// its latest-only queue, so the processing thread never waits on the I/O
+// thread, which compresses and sends on its own. The newest frame always
+// wins (older ones are dropped), and a send that would block drops the rest
+// of that frame and forces a keyframe instead of queueing: a network stall
+// costs frames, never pipeline latency.
+class EdgeStreamer {
+public:
+    ~EdgeStreamer();
+
+    // host is resolved on the I/O thread; keyframeInterval <= 1 sends
+    // keyframes only
+    bool start(const std::string& host, int port, int keyframeInterval);
+    void stop();
+    bool isRunning() const { return running.load(std::memory_order_acquire); }
+
+    EdgeStreamStats stats() const;
+
+private:
+    void run(std::string host, int port, std::shared_ptr<FrameQueue> frames);
+    bool sendFrame(int socketFd, const cv::Mat& bits, int width, bool keyframe);
+
+    std::thread thread;
+    mutable std::mutex queueMutex;
+    std::shared_ptr<FrameQueue> queue;  // set while running
+    uint64_t replacedEarlier = 0;       // by the queues of earlier sessions
+    int keyframeInterval = 30;
+
+    // I/O thread only
+    cv::Mat previous;   // last sent bitmap, the delta reference
+    std::vector<uint8_t> encoded;
+    uint32_t frameCounter = 0;   // id of the next frame, sent or not
+    int sinceKeyframe = 0;
+
+    std::atomic<bool> running{false};
+    std::atomic<uint64_t> sent{0};
+    std::atomic<uint64_t> congested{0};
+    std::atomic<uint64_t> bytes{0};
+};
+
+EdgeStreamer& edgeStreamer();
+
+#endif // EDGE_EDGE_STREAM_H
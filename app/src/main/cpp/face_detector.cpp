@@ -0,0 +1,223 @@
+#include "face_detector.h"
+#include "mapped_asset.h"
+#include "metrics.h"
+#include "thread_policy.h"
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+
+#define LOG_TAG "FaceDetector"
+#include "logging.h"
+
+namespace {
+
+const float kSearchMargin = 0.5f;  // of the box size, on each side
+const int kMinFaceSide = 8;        // reduced-luma pixels; smaller boxes cannot be matched
+
+}  // namespace
+
+FaceDetector::~FaceDetector() {
+    stopThread();
+}
+
+bool FaceDetector::load(const std::string& model) {
+    std::shared_ptr<MappedAsset> mapped = MappedAsset::open(model);
+    if (!mapped) {
+        return false;
+    }
+    cv::Ptr<cv::FaceDetectorYN> created;
+    try {
+        // The buffer overload takes a vector; the copy lives only while the
+        // ONNX graph is parsed, the mapping's pages are never all resident
+        const std::vector<uchar> buffer(mapped->data(), mapped->data() + mapped->size());
+        created = cv::FaceDetectorYN::create("onnx", buffer, std::vector<uchar>(), cv::Size(320, 240));
+    } catch (const cv::Exception& e) {
+        LOGE("❌ Face model %s failed to load: %s", model.c_str(), e.what());
+        return false;
+    }
+    if (!created) {
+        LOGE("❌ Face model %s failed to load", model.c_str());
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    detector = created;
+    LOGI("✅ Face model loaded from %s", model.c_str());
+    return true;
+}
+
+bool FaceDetector::loaded() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return !detector.empty();
+}
+
+void FaceDetector::setParams(const Params& params) {
+    std::lock_guard<std::mutex> lock(mutex);
+    current = params;
+    current.everyFrames = std::max(1, params.everyFrames);
+    current.inputWidth = std::min(std::max(params.inputWidth, 64), 1280);
+    current.scoreThreshold = std::min(std::max(params.scoreThreshold, 0.0f), 1.0f);
+    current.minMatch = std::min(std::max(params.minMatch, -1.0f), 1.0f);
+}
+
+void FaceDetector::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    tracks.clear();
+    result.clear();
+    hasResult = false;
+    hasPending = false;
+    generation++;
+}
+
+// Moves every track to its best match in a window around its box
+void FaceDetector::trackLocked(const cv::Mat& image) {
+    const cv::Rect bounds(0, 0, image.cols, image.rows);
+    size_t kept = 0;
+    for (size_t i = 0; i < tracks.size(); i++) {
+        Track& track = tracks[i];
+        const int marginX = std::max(2, static_cast<int>(track.box.width * kSearchMargin));
+        const int marginY = std::max(2, static_cast<int>(track.box.height * kSearchMargin));
+        const cv::Rect window = cv::Rect(track.box.x - marginX, track.box.y - marginY,
+                                         track.box.width + 2 * marginX, track.box.height + 2 * marginY) & bounds;
+        if (window.width < track.patch.cols || window.height < track.patch.rows) {
+            lost.fetch_add(1, std::memory_order_relaxed);
+            continue;  // left the frame
+        }
+        cv::matchTemplate(image(window), track.patch, match, cv::TM_CCOEFF_NORMED);
+        double best = 0.0;
+        cv::Point at;
+        cv::minMaxLoc(match, nullptr, &best, nullptr, &at);
+        if (best < current.minMatch) {
+            lost.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        track.box.x = window.x + at.x;
+        track.box.y = window.y + at.y;
+        // Follow slow changes of pose and light; the new patch is the same size
+        image(track.box).copyTo(track.patch);
+        tracks[kept++] = std::move(track);
+    }
+    tracks.resize(kept);
+}
+
+void FaceDetector::update(const cv::Mat& luma, std::vector<Face>& faces) {
+    faces.clear();
+    std::lock_guard<std::mutex> lock(mutex);
+    frame++;
+    if (detector.empty() || luma.empty()) {
+        return;
+    }
+    const int width = std::min(current.inputWidth, luma.cols);
+    const int height = std::max(1, luma.rows * width / luma.cols);
+    {
+        ScopedStageTimer timer(Stage::FACE_TRACK);
+        const cv::Size before = reduced.size();
+        cv::resize(luma, reduced, cv::Size(width, height), 0, 0, cv::INTER_AREA);
+        if (reduced.size() != before) {
+            // The boxes are in units of the old reduction
+            tracks.clear();
+            hasResult = false;
+            generation++;
+        }
+        if (hasResult) {
+            tracks.swap(result);  // patches from the detected frame, searched for in this one
+            result.clear();
+            hasResult = false;
+        }
+        if (!tracks.empty()) {
+            trackLocked(reduced);
+            tracked.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    if (!busy && !hasPending && frame - lastHandOff >= static_cast<uint64_t>(current.everyFrames)) {
+        lastHandOff = frame;
+        reduced.copyTo(pending.image);
+        pending.generation = generation;
+        hasPending = true;
+        if (!thread.joinable()) {
+            stopping = false;
+            thread = std::thread(&FaceDetector::run, this);
+        }
+        wakeup.notify_one();
+    }
+
+    for (const Track& track : tracks) {
+        Face face;
+        face.box = cv::Rect2f(static_cast<float>(track.box.x) / reduced.cols,
+                              static_cast<float>(track.box.y) / reduced.rows,
+                              static_cast<float>(track.box.width) / reduced.cols,
+                              static_cast<float>(track.box.height) / reduced.rows);
+        face.score = track.score;
+        faces.push_back(face);
+    }
+}
+
+void FaceDetector::stopThread() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeup.notify_one();
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void FaceDetector::run() {
+    // Only cores the camera, GL and processing threads leave idle
+    setThreadTier(ThreadTier::ANALYTICS);
+
+    Job job;
+    cv::Mat bgr;
+    cv::Mat found;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wakeup.wait(lock, [this] { return stopping || hasPending; });
+        if (stopping) {
+            return;
+        }
+        std::swap(job, pending);
+        hasPending = false;
+        busy = true;
+        cv::Ptr<cv::FaceDetectorYN> net = detector;  // a reload swaps it under the lock
+        const float scoreThreshold = current.scoreThreshold;
+        lock.unlock();
+
+        std::vector<Track> detected;
+        bool finished = false;
+        try {
+            ScopedStageTimer timer(Stage::FACE_DETECT);
+            cv::cvtColor(job.image, bgr, cv::COLOR_GRAY2BGR);  // YuNet takes 3 channels
+            net->setInputSize(bgr.size());
+            net->setScoreThreshold(scoreThreshold);
+            net->detect(bgr, found);
+            finished = true;
+            const cv::Rect bounds(0, 0, job.image.cols, job.image.rows);
+            for (int i = 0; i < found.rows && static_cast<int>(detected.size()) < kMaxFaces; i++) {
+                const float* row = found.ptr<float>(i);
+                Track track;
+                track.box = cv::Rect(cvRound(row[0]), cvRound(row[1]), cvRound(row[2]), cvRound(row[3])) & bounds;
+                if (track.box.width < kMinFaceSide || track.box.height < kMinFaceSide) {
+                    continue;
+                }
+                job.image(track.box).copyTo(track.patch);
+                track.score = row[14];
+                detected.push_back(std::move(track));
+            }
+        } catch (const cv::Exception& e) {
+            LOGE_RATELIMITED("❌ Face detection failed: %s", e.what());
+        }
+
+        lock.lock();
+        busy = false;
+        if (finished && job.generation == generation) {
+            result = std::move(detected);
+            hasResult = true;  // also when empty: faces that left are dropped
+            detections.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+FaceDetector& faceDetector() {
+    static FaceDetector detector;
+    return detector;
+}
@@ -0,0 +1,108 @@
+#ifndef EDGE_FACE_DETECTOR_H
+#define EDGE_FACE_DETECTOR_H
+
+#include <opencv2/core.hpp>
+#include <opencv2/objdetect.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Faces (cv::FaceDetectorYN, the YuNet model) with boxes that move every
+// frame although the network only runs every few. The processing thread
+// reduces the luma to the detector's input width once per frame; every K
+// frames, while the detector thread is idle, it hands a copy of that
+// reduction over, and YuNet runs there at background priority (tens of
+// milliseconds on mid-range devices). In between, each face is followed by
+// normalized cross-correlation of its patch in a window around its last
+// box, at a fraction of a millisecond per face. A finished detection
+// replaces the tracked faces: their patches come from the detected frame,
+// so the next frame's search carries them over the frames the detection
+// took. A face whose best match falls below minMatch is dropped until the
+// next detection finds it again.
+class FaceDetector {
+public:
+    struct Params {
+        int everyFrames = 10;          // K: frames between detections at most
+        int inputWidth = 320;          // reduced luma width YuNet and the tracking see
+        float scoreThreshold = 0.8f;   // YuNet confidence
+        float minMatch = 0.55f;        // TM_CCOEFF_NORMED a tracked face needs to stay
+    };
+
+    struct Face {
+        cv::Rect2f box;     // 0..1 units of the luma
+        float score = 0.0f; // YuNet's, at the last detection
+    };
+
+    static const int kMaxFaces = 16;
+
+    ~FaceDetector();
+
+    // Loads the YuNet ONNX model from a file or an APK asset
+    // (mapped_asset.h); false (and FACES shows no boxes) when it cannot be
+    // read
+    bool load(const std::string& model);
+    bool loaded();
+
+    void setParams(const Params& params);
+
+    // Processing thread, once per frame of the mode: tracks the faces into
+    // luma (CV_8UC1), takes a finished detection over and hands the next one
+    // off when due. Starts the thread on first use.
+    void update(const cv::Mat& luma, std::vector<Face>& faces);
+
+    // Drops the faces and any detection in flight, e.g. when the mode is
+    // entered again
+    void reset();
+
+    uint64_t detectionCount() const { return detections.load(std::memory_order_relaxed); }
+    uint64_t trackedCount() const { return tracked.load(std::memory_order_relaxed); }
+    uint64_t lostCount() const { return lost.load(std::memory_order_relaxed); }
+
+private:
+    struct Track {
+        cv::Rect box;     // reduced-luma pixels
+        cv::Mat patch;    // the face in the frame it was last matched in
+        float score = 0.0f;
+    };
+
+    struct Job {
+        cv::Mat image;    // owned copy of the reduced luma
+        uint64_t generation = 0;
+    };
+
+    void run();
+    void stopThread();
+    void trackLocked(const cv::Mat& reduced);
+
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    std::thread thread;
+    bool stopping = false;
+    bool hasPending = false;
+    bool busy = false;
+    bool hasResult = false;
+    Params current;
+    Job pending;
+    std::vector<Track> result;    // the finished detection, with its patches
+    std::vector<Track> tracks;    // processing thread
+    uint64_t frame = 0;
+    uint64_t lastHandOff = 0;
+    uint64_t generation = 0;
+    cv::Mat reduced;              // processing-thread scratch
+    cv::Mat match;
+
+    cv::Ptr<cv::FaceDetectorYN> detector;  // replaced by load(); the thread keeps its own reference
+
+    std::atomic<uint64_t> detections{0};
+    std::atomic<uint64_t> tracked{0};
+    std::atomic<uint64_t> lost{0};
+};
+
+// Detector used by the FACES render mode
+FaceDetector& faceDetector();
+
+#endif // EDGE_FACE_DETECTOR_H
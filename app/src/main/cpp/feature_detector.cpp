@@ -0,0 +1,53 @@
+#include "feature_detector.h"
+#include <algorithm>
+
+void GridFeatureDetector::setParams(const Params& params) {
+    std::lock_guard<std::mutex> lock(mutex);
+    current = params;
+    if (detector) {
+        detector->setThreshold(params.threshold);
+    }
+}
+
+int GridFeatureDetector::capacity() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return current.gridCols * current.gridRows * current.perCell;
+}
+
+int GridFeatureDetector::detect(const cv::Mat& luma, cv::Mat& points) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!detector) {
+        detector = cv::FastFeatureDetector::create(current.threshold, true);
+    }
+    detector->detect(luma, keypoints);
+
+    // Strongest first, then fill each cell up to its cap
+    order.resize(keypoints.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = static_cast<int>(i);
+    }
+    std::sort(order.begin(), order.end(), [this](int a, int b) {
+        return keypoints[a].response > keypoints[b].response;
+    });
+    cellCounts.assign(static_cast<size_t>(current.gridCols * current.gridRows), 0);
+    const float cellWidth = static_cast<float>(luma.cols) / current.gridCols;
+    const float cellHeight = static_cast<float>(luma.rows) / current.gridRows;
+    const int limit = std::min(points.rows, current.gridCols * current.gridRows * current.perCell);
+    int count = 0;
+    for (size_t i = 0; i < order.size() && count < limit; i++) {
+        const cv::Point2f& pt = keypoints[order[i]].pt;
+        int cx = std::min(current.gridCols - 1, static_cast<int>(pt.x / cellWidth));
+        int cy = std::min(current.gridRows - 1, static_cast<int>(pt.y / cellHeight));
+        int& cell = cellCounts[cy * current.gridCols + cx];
+        if (cell < current.perCell) {
+            cell++;
+            points.at<cv::Vec2f>(count++) = cv::Vec2f(pt.x, pt.y);
+        }
+    }
+    return count;
+}
+
+GridFeatureDetector& featureDetector() {
+    static GridFeatureDetector detector;
+    return detector;
+}
@@ -0,0 +1,45 @@
+#ifndef EDGE_FEATURE_DETECTOR_H
+#define EDGE_FEATURE_DETECTOR_H
+
+#include <opencv2/core.hpp>
+#include <opencv2/features2d.hpp>
+#include <mutex>
+#include <vector>
+
+// FAST corners spread over the frame. One detector lives for the whole
+// session (the SDK sample builds a FastFeatureDetector per frame), and its
+// keypoints are bucketed into a grid keeping only the strongest perCell per
+// cell, so a few texture-rich areas cannot take the whole budget.
+class GridFeatureDetector {
+public:
+    struct Params {
+        int threshold = 20;   // FAST intensity threshold
+        int gridCols = 8;
+        int gridRows = 6;
+        int perCell = 8;      // cap per grid cell
+    };
+
+    void setParams(const Params& params);
+
+    // Most points detect() can return with the current params
+    int capacity();
+
+    // Writes (x, y) pixel positions of the kept corners, strongest first,
+    // into the first rows of points (CV_32FC2, at least capacity() rows)
+    // and returns how many were written
+    int detect(const cv::Mat& luma, cv::Mat& points);
+
+private:
+    std::mutex mutex;
+    Params current;
+    cv::Ptr<cv::FastFeatureDetector> detector;
+    // Scratch reused across frames
+    std::vector<cv::KeyPoint> keypoints;
+    std::vector<int> order;
+    std::vector<int> cellCounts;
+};
+
+// Detector used by the FEATURES render mode
+GridFeatureDetector& featureDetector();
+
+#endif // EDGE_FEATURE_DETECTOR_H
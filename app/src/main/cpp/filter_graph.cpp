@@ -0,0 +1,441 @@
+#include "filter_graph.h"
+#include "image_processor.h"
+#include <opencv2/imgproc.hpp>
+#include <cstdlib>
+#include <map>
+
+#define LOG_TAG "FilterGraph"
+#include "logging.h"
+
+namespace {
+
+const int kMaxKernelSize = 31;
+
+std::string trim(const std::string& text) {
+    size_t begin = text.find_first_not_of(" \t");
+    if (begin == std::string::npos) {
+        return std::string();
+    }
+    size_t end = text.find_last_not_of(" \t");
+    return text.substr(begin, end - begin + 1);
+}
+
+std::vector<std::string> split(const std::string& text, char separator) {
+    std::vector<std::string> parts;
+    size_t start = 0;
+    while (true) {
+        size_t end = text.find(separator, start);
+        parts.push_back(trim(text.substr(start, end == std::string::npos ? std::string::npos : end - start)));
+        if (end == std::string::npos) {
+            return parts;
+        }
+        start = end + 1;
+    }
+}
+
+// Whole-string integer in [minValue, maxValue]
+bool parseInt(const std::string& text, int minValue, int maxValue, int& value) {
+    if (text.empty()) {
+        return false;
+    }
+    char* end = nullptr;
+    long parsed = std::strtol(text.c_str(), &end, 10);
+    if (*end != '\0' || parsed < minValue || parsed > maxValue) {
+        return false;
+    }
+    value = static_cast<int>(parsed);
+    return true;
+}
+
+bool parseKernelSize(const std::string& text, int& size) {
+    return parseInt(text, 1, kMaxKernelSize, size) && (size & 1);
+}
+
+bool is8Bit(int type) {
+    return CV_MAT_DEPTH(type) == CV_8U && CV_MAT_CN(type) != 2;
+}
+
+class GrayStage : public FilterStage {
+public:
+    int outputType(int inputType) const override { return is8Bit(inputType) ? CV_8UC1 : -1; }
+
+    void run(const cv::Mat& input, cv::Mat& output) override {
+        if (input.channels() == 1) {
+            input.copyTo(output);   // the pipeline already feeds luma
+        } else {
+            cv::cvtColor(input, output, input.channels() == 4 ? cv::COLOR_BGRA2GRAY : cv::COLOR_BGR2GRAY);
+        }
+    }
+};
+
+class BgrStage : public FilterStage {
+public:
+    int outputType(int inputType) const override { return is8Bit(inputType) ? CV_8UC3 : -1; }
+
+    void run(const cv::Mat& input, cv::Mat& output) override {
+        switch (input.channels()) {
+            case 1: cv::cvtColor(input, output, cv::COLOR_GRAY2BGR); break;
+            case 4: cv::cvtColor(input, output, cv::COLOR_BGRA2BGR); break;
+            default: input.copyTo(output); break;
+        }
+    }
+};
+
+// blur:k (odd kernel size, default 5)
+class BlurStage : public FilterStage {
+public:
+    explicit BlurStage(int size) : size(size) {}
+
+    int outputType(int inputType) const override { return is8Bit(inputType) ? inputType : -1; }
+    bool inPlace() const override { return true; }
+
+    void run(const cv::Mat& input, cv::Mat& output) override {
+        cv::GaussianBlur(input, output, cv::Size(size, size), 0);
+    }
+
+private:
+    int size;
+};
+
+// canny (pipeline backend and thresholds) or canny:low,high
+class CannyStage : public FilterStage {
+public:
+    CannyStage(int low, int high) : low(low), high(high) {}
+
+    int outputType(int inputType) const override { return inputType == CV_8UC1 ? CV_8UC1 : -1; }
+
+    void run(const cv::Mat& input, cv::Mat& output) override {
+        if (low < 0) {
+            detectEdges(input, output);
+        } else {
+            cv::Canny(input, output, low, high);
+        }
+    }
+
+private:
+    int low;
+    int high;
+};
+
+// sobel:k (default 3): |d/dx| + |d/dy|, saturated to 8 bits
+class SobelStage : public FilterStage {
+public:
+    explicit SobelStage(int size) : size(size) {}
+
+    int outputType(int inputType) const override { return inputType == CV_8UC1 ? CV_8UC1 : -1; }
+
+    void prepare(const cv::Size& frameSize, int inputType) override {
+        derivative.create(frameSize, CV_16SC1);
+        magnitude.create(frameSize, CV_8UC1);
+    }
+
+    void run(const cv::Mat& input, cv::Mat& output) override {
+        cv::Sobel(input, derivative, CV_16S, 1, 0, size);
+        cv::convertScaleAbs(derivative, output);
+        cv::Sobel(input, derivative, CV_16S, 0, 1, size);
+        cv::convertScaleAbs(derivative, magnitude);
+        cv::add(output, magnitude, output);
+    }
+
+private:
+    int size;
+    cv::Mat derivative;
+    cv::Mat magnitude;
+};
+
+// dilate / erode / open / close:k[,iterations] with a k x k rectangle
+class MorphologyStage : public FilterStage {
+public:
+    MorphologyStage(int operation, int size, int iterations)
+            : operation(operation), iterations(iterations),
+              kernel(cv::getStructuringElement(cv::MORPH_RECT, cv::Size(size, size))) {}
+
+    int outputType(int inputType) const override { return is8Bit(inputType) ? inputType : -1; }
+    bool inPlace() const override { return true; }
+
+    void run(const cv::Mat& input, cv::Mat& output) override {
+        cv::morphologyEx(input, output, operation, kernel, cv::Point(-1, -1), iterations);
+    }
+
+private:
+    int operation;
+    int iterations;
+    cv::Mat kernel;
+};
+
+// threshold:t or threshold:otsu, optionally followed by ",inv"
+class ThresholdStage : public FilterStage {
+public:
+    ThresholdStage(int level, bool otsu, bool invert)
+            : level(level), flags((invert ? cv::THRESH_BINARY_INV : cv::THRESH_BINARY) | (otsu ? cv::THRESH_OTSU : 0)) {}
+
+    int outputType(int inputType) const override { return inputType == CV_8UC1 ? CV_8UC1 : -1; }
+    bool inPlace() const override { return true; }
+
+    void run(const cv::Mat& input, cv::Mat& output) override {
+        cv::threshold(input, output, level, 255, flags);
+    }
+
+private:
+    int level;
+    int flags;
+};
+
+// colormap:name (jet, turbo, ...): single channel to BGR through a 256-entry
+// table built once, a plain lookup per pixel
+class ColorMapStage : public FilterStage {
+public:
+    explicit ColorMapStage(int map) {
+        cv::Mat ramp(1, 256, CV_8UC1);
+        for (int i = 0; i < 256; i++) {
+            ramp.at<uchar>(0, i) = static_cast<uchar>(i);
+        }
+        cv::applyColorMap(ramp, table, map);
+    }
+
+    int outputType(int inputType) const override { return inputType == CV_8UC1 ? CV_8UC3 : -1; }
+
+    void run(const cv::Mat& input, cv::Mat& output) override {
+        const cv::Vec3b* colors = table.ptr<cv::Vec3b>(0);
+        for (int y = 0; y < input.rows; y++) {
+            const uchar* in = input.ptr<uchar>(y);
+            cv::Vec3b* out = output.ptr<cv::Vec3b>(y);
+            for (int x = 0; x < input.cols; x++) {
+                out[x] = colors[in[x]];
+            }
+        }
+    }
+
+private:
+    cv::Mat table;
+};
+
+bool colorMapByName(const std::string& name, int& map) {
+    static const struct { const char* name; int map; } kMaps[] = {
+        {"autumn", cv::COLORMAP_AUTUMN}, {"bone", cv::COLORMAP_BONE}, {"jet", cv::COLORMAP_JET},
+        {"winter", cv::COLORMAP_WINTER}, {"rainbow", cv::COLORMAP_RAINBOW}, {"ocean", cv::COLORMAP_OCEAN},
+        {"summer", cv::COLORMAP_SUMMER}, {"spring", cv::COLORMAP_SPRING}, {"cool", cv::COLORMAP_COOL},
+        {"hsv", cv::COLORMAP_HSV}, {"pink", cv::COLORMAP_PINK}, {"hot", cv::COLORMAP_HOT},
+        {"parula", cv::COLORMAP_PARULA}, {"magma", cv::COLORMAP_MAGMA}, {"inferno", cv::COLORMAP_INFERNO},
+        {"plasma", cv::COLORMAP_PLASMA}, {"viridis", cv::COLORMAP_VIRIDIS}, {"cividis", cv::COLORMAP_CIVIDIS},
+        {"twilight", cv::COLORMAP_TWILIGHT}, {"turbo", cv::COLORMAP_TURBO},
+    };
+    for (const auto& entry : kMaps) {
+        if (name == entry.name) {
+            map = entry.map;
+            return true;
+        }
+    }
+    return false;
+}
+
+using Args = std::vector<std::string>;
+
+std::unique_ptr<FilterStage> makeMorphology(int operation, const Args& args) {
+    int size = 3;
+    int iterations = 1;
+    if (args.size() > 2 || (args.size() > 0 && !parseKernelSize(args[0], size)) ||
+        (args.size() > 1 && !parseInt(args[1], 1, 16, iterations))) {
+        return nullptr;
+    }
+    return std::unique_ptr<FilterStage>(new MorphologyStage(operation, size, iterations));
+}
+
+void registerBuiltinStages(std::map<std::string, FilterStageFactory>& stages) {
+    stages["gray"] = [](const Args& args) -> std::unique_ptr<FilterStage> {
+        return args.empty() ? std::unique_ptr<FilterStage>(new GrayStage()) : nullptr;
+    };
+    stages["bgr"] = [](const Args& args) -> std::unique_ptr<FilterStage> {
+        return args.empty() ? std::unique_ptr<FilterStage>(new BgrStage()) : nullptr;
+    };
+    stages["blur"] = [](const Args& args) -> std::unique_ptr<FilterStage> {
+        int size = 5;
+        if (args.size() > 1 || (args.size() == 1 && !parseKernelSize(args[0], size))) {
+            return nullptr;
+        }
+        return std::unique_ptr<FilterStage>(new BlurStage(size));
+    };
+    stages["canny"] = [](const Args& args) -> std::unique_ptr<FilterStage> {
+        int low = -1;
+        int high = -1;
+        if (!args.empty() && (args.size() != 2 || !parseInt(args[0], 0, 1024, low) ||
+                              !parseInt(args[1], 0, 1024, high) || low > high)) {
+            return nullptr;
+        }
+        return std::unique_ptr<FilterStage>(new CannyStage(low, high));
+    };
+    stages["sobel"] = [](const Args& args) -> std::unique_ptr<FilterStage> {
+        int size = 3;
+        if (args.size() > 1 || (args.size() == 1 && (!parseKernelSize(args[0], size) || size > 7))) {
+            return nullptr;
+        }
+        return std::unique_ptr<FilterStage>(new SobelStage(size));
+    };
+    stages["dilate"] = [](const Args& args) { return makeMorphology(cv::MORPH_DILATE, args); };
+    stages["erode"] = [](const Args& args) { return makeMorphology(cv::MORPH_ERODE, args); };
+    stages["open"] = [](const Args& args) { return makeMorphology(cv::MORPH_OPEN, args); };
+    stages["close"] = [](const Args& args) { return makeMorphology(cv::MORPH_CLOSE, args); };
+    stages["threshold"] = [](const Args& args) -> std::unique_ptr<FilterStage> {
+        int level = 0;
+        bool otsu = !args.empty() && args[0] == "otsu";
+        if (args.empty() || args.size() > 2 || (!otsu && !parseInt(args[0], 0, 255, level)) ||
+            (args.size() == 2 && args[1] != "inv")) {
+            return nullptr;
+        }
+        return std::unique_ptr<FilterStage>(new ThresholdStage(level, otsu, args.size() == 2));
+    };
+    stages["colormap"] = [](const Args& args) -> std::unique_ptr<FilterStage> {
+        int map = cv::COLORMAP_JET;
+        if (args.size() > 1 || (args.size() == 1 && !colorMapByName(args[0], map))) {
+            return nullptr;
+        }
+        return std::unique_ptr<FilterStage>(new ColorMapStage(map));
+    };
+}
+
+std::mutex registryMutex;
+
+std::map<std::string, FilterStageFactory>& stageRegistry() {
+    static std::map<std::string, FilterStageFactory> stages;
+    static bool initialized = false;
+    if (!initialized) {
+        registerBuiltinStages(stages);
+        initialized = true;
+    }
+    return stages;
+}
+
+} // namespace
+
+void registerFilterStage(const std::string& name, FilterStageFactory factory) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    stageRegistry()[name] = std::move(factory);
+}
+
+bool filterStageRegistered(const std::string& name) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    return stageRegistry().count(name) > 0;
+}
+
+bool FilterGraph::configure(const std::string& config, std::string& error) {
+    std::vector<Step> parsed;
+    const std::string trimmed = trim(config);
+    if (!trimmed.empty()) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (const std::string& entry : split(trimmed, '|')) {
+            size_t colon = entry.find(':');
+            const std::string name = trim(entry.substr(0, colon));
+            Args args;
+            if (colon != std::string::npos) {
+                args = split(entry.substr(colon + 1), ',');
+            }
+            auto factory = stageRegistry().find(name);
+            if (factory == stageRegistry().end()) {
+                error = "unknown stage '" + name + "'";
+                return false;
+            }
+            Step step;
+            step.stage = factory->second(args);
+            if (!step.stage) {
+                error = "invalid arguments for '" + entry + "'";
+                return false;
+            }
+            parsed.push_back(std::move(step));
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    steps = std::move(parsed);
+    configString = trimmed;
+    buffers.clear();
+    plannedType = -1;
+    return true;
+}
+
+bool FilterGraph::empty() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return steps.empty();
+}
+
+std::string FilterGraph::config() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return configString;
+}
+
+int FilterGraph::outputType(int inputType) {
+    std::lock_guard<std::mutex> lock(mutex);
+    int type = steps.empty() ? -1 : inputType;
+    for (size_t i = 0; i < steps.size() && type >= 0; i++) {
+        type = steps[i].stage->outputType(type);
+    }
+    return type;
+}
+
+// Assigns every step its output buffer. Only the previous step's buffer is
+// live at any point of a linear chain, so a buffer of the right type that is
+// not the current input can always be reused.
+bool FilterGraph::plan(const cv::Size& size, int inputType) {
+    if (size == plannedSize && inputType == plannedType) {
+        return plannedOutputType >= 0;
+    }
+    plannedSize = size;
+    plannedType = inputType;
+    plannedOutputType = -1;
+    buffers.clear();
+
+    int type = inputType;
+    int current = kOutputBuffer;   // the caller's input while planning
+    for (size_t i = 0; i < steps.size(); i++) {
+        FilterStage& stage = *steps[i].stage;
+        int next = stage.outputType(type);
+        if (next < 0) {
+            LOGE("❌ Stage %zu of '%s' cannot take type %d", i, configString.c_str(), type);
+            return false;
+        }
+        stage.prepare(size, type);
+        int buffer = kOutputBuffer;
+        if (i + 1 < steps.size()) {
+            if (stage.inPlace() && current != kOutputBuffer && buffers[current].type() == next) {
+                buffer = current;
+            } else {
+                for (size_t b = 0; b < buffers.size(); b++) {
+                    if (static_cast<int>(b) != current && buffers[b].type() == next) {
+                        buffer = static_cast<int>(b);
+                        break;
+                    }
+                }
+                if (buffer == kOutputBuffer) {
+                    buffers.push_back(cv::Mat(size, next));
+                    buffer = static_cast<int>(buffers.size()) - 1;
+                }
+            }
+        }
+        steps[i].buffer = buffer;
+        current = buffer;
+        type = next;
+    }
+    plannedOutputType = type;
+    LOGI("Filter graph '%s' planned at %dx%d: %zu stages, %zu buffers",
+         configString.c_str(), size.width, size.height, steps.size(), buffers.size());
+    return true;
+}
+
+bool FilterGraph::run(const cv::Mat& input, cv::Mat& output) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (steps.empty() || input.empty() || !plan(input.size(), input.type())) {
+        return false;
+    }
+    output.create(input.size(), plannedOutputType);
+    const cv::Mat* current = &input;
+    for (Step& step : steps) {
+        cv::Mat& target = step.buffer == kOutputBuffer ? output : buffers[step.buffer];
+        step.stage->run(*current, target);
+        current = &target;
+    }
+    return true;
+}
+
+FilterGraph& filterGraph() {
+    static FilterGraph graph;
+    return graph;
+}
@@ -0,0 +1,87 @@
+#ifndef EDGE_FILTER_GRAPH_H
+#define EDGE_FILTER_GRAPH_H
+
+#include <opencv2/core.hpp>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// One step of a FilterGraph. Stages keep the frame size; anything they need
+// besides input and output (kernels, intermediate buffers) is set up in
+// prepare(), so run() does not allocate in steady state.
+class FilterStage {
+public:
+    virtual ~FilterStage() = default;
+
+    // Output type for an input type, or -1 when the stage cannot take it
+    virtual int outputType(int inputType) const = 0;
+
+    // True when run(buffer, buffer) is valid, i.e. the stage may overwrite its input
+    virtual bool inPlace() const { return false; }
+
+    // Called whenever the input geometry changes, before the next run()
+    virtual void prepare(const cv::Size& size, int inputType) {}
+
+    virtual void run(const cv::Mat& input, cv::Mat& output) = 0;
+};
+
+// Creates a stage from its arguments (the comma-separated list after ':');
+// returns nullptr when they are invalid
+using FilterStageFactory = std::function<std::unique_ptr<FilterStage>(const std::vector<std::string>& args)>;
+
+// Makes a stage available to config strings under name. The built-in stages
+// (gray, bgr, blur, canny, sobel, dilate, erode, open, close, threshold,
+// colormap) are registered on first use; plugin stages (edge_stage_plugin.h)
+// through stage_plugins.h.
+void registerFilterStage(const std::string& name, FilterStageFactory factory);
+
+// Whether config strings can use name (built-in, registered, or a plugin's)
+bool filterStageRegistered(const std::string& name);
+
+// Linear chain of stages built from a config string such as
+//   "gray|blur:5|canny:80,160|dilate:3|colormap:jet"
+// Buffers are planned once per input geometry: stages that allow it work in
+// place on the previous stage's buffer, the others alternate between buffers
+// owned by the graph, and the last stage writes straight into the caller's
+// output. Safe to reconfigure while another thread runs it.
+class FilterGraph {
+public:
+    // Replaces the chain ("" clears it). On an unknown stage or bad arguments
+    // the current chain is kept and error describes the problem.
+    bool configure(const std::string& config, std::string& error);
+
+    bool empty();
+    std::string config();
+
+    // Type run() produces for an input type; -1 when some stage cannot take it
+    int outputType(int inputType);
+
+    // Runs the chain; false (output untouched) when it is empty or cannot
+    // take the input type
+    bool run(const cv::Mat& input, cv::Mat& output);
+
+private:
+    static const int kOutputBuffer = -1;
+
+    struct Step {
+        std::unique_ptr<FilterStage> stage;
+        int buffer = kOutputBuffer;   // index into buffers
+    };
+
+    bool plan(const cv::Size& size, int inputType);
+
+    std::mutex mutex;
+    std::string configString;
+    std::vector<Step> steps;
+    std::vector<cv::Mat> buffers;
+    cv::Size plannedSize;
+    int plannedType = -1;
+    int plannedOutputType = -1;
+};
+
+// Graph configured through nativeSetFilterGraph
+FilterGraph& filterGraph();
+
+#endif // EDGE_FILTER_GRAPH_H
@@ -0,0 +1,347 @@
+#include "frame_arena.h"
+#include "memory_accounting.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#define LOG_TAG "FrameArena"
+#include "logging.h"
+
+namespace {
+
+const size_t kAlignment = 64;                 // cache line, and the widest SIMD load
+const size_t kMinChunkBytes = 4 << 20;
+const size_t kMaxBlockBytes = 64 << 20;       // larger blocks go to the heap
+const size_t kMaxSpareChunks = 2;
+
+inline size_t alignUp(size_t bytes) {
+    return (bytes + kAlignment - 1) & ~(kAlignment - 1);
+}
+
+// The block header lives in the arena too; the pixels start on the next line
+const size_t kHeaderBytes = alignUp(sizeof(cv::UMatData));
+
+std::atomic<bool> arenasEnabled{false};
+std::atomic<size_t> chunkCount{0};
+std::atomic<size_t> reservedBytes{0};
+std::atomic<size_t> retiredCount{0};
+std::atomic<size_t> fallbackCount{0};
+
+struct ArenaChunk;
+
+// An arena's chunks between frames: rewound spares, and retired chunks
+// whose last block has been released (from any thread). Shared with the
+// chunks, so a chunk retired by a thread that has since exited is simply
+// freed, and with trimFrameArenas, which can empty it from any thread.
+struct ArenaHome {
+    std::mutex mutex;
+    bool open = true;
+    std::vector<ArenaChunk*> spare;     // rewound, largest first
+    std::vector<ArenaChunk*> returned;
+};
+
+struct ArenaChunk {
+    uint8_t* base = nullptr;
+    size_t capacity = 0;
+    size_t used = 0;              // owner thread only
+    // Live blocks, plus one while the arena itself holds the chunk
+    std::atomic<int> refs{1};
+    std::shared_ptr<ArenaHome> home;
+};
+
+std::mutex registryMutex;
+std::vector<std::weak_ptr<ArenaHome>> registry;  // every thread's arena
+
+ArenaChunk* newChunk(size_t capacity, const std::shared_ptr<ArenaHome>& home) {
+    void* base = nullptr;
+    if (posix_memalign(&base, kAlignment, capacity) != 0) {
+        return nullptr;
+    }
+    ArenaChunk* chunk = new ArenaChunk();
+    chunk->base = static_cast<uint8_t*>(base);
+    chunk->capacity = capacity;
+    chunk->home = home;
+    chunkCount.fetch_add(1, std::memory_order_relaxed);
+    reservedBytes.fetch_add(capacity, std::memory_order_relaxed);
+    return chunk;
+}
+
+void freeChunk(ArenaChunk* chunk) {
+    chunkCount.fetch_sub(1, std::memory_order_relaxed);
+    reservedBytes.fetch_sub(chunk->capacity, std::memory_order_relaxed);
+    free(chunk->base);
+    delete chunk;
+}
+
+void freeChunks(std::vector<ArenaChunk*>& chunks) {
+    for (ArenaChunk* chunk : chunks) {
+        freeChunk(chunk);
+    }
+    chunks.clear();
+}
+
+// A retired chunk whose last block was just released
+void returnChunk(ArenaChunk* chunk) {
+    std::shared_ptr<ArenaHome> home = chunk->home;
+    {
+        std::lock_guard<std::mutex> lock(home->mutex);
+        if (home->open) {
+            home->returned.push_back(chunk);
+            return;
+        }
+    }
+    freeChunk(chunk);
+}
+
+class FrameArena {
+public:
+    FrameArena() : home(std::make_shared<ArenaHome>()) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        registry.erase(std::remove_if(registry.begin(), registry.end(),
+                                      [](const std::weak_ptr<ArenaHome>& entry) { return entry.expired(); }),
+                       registry.end());
+        registry.push_back(home);
+    }
+
+    ~FrameArena() {
+        rewind();
+        std::vector<ArenaChunk*> released;
+        {
+            std::lock_guard<std::mutex> lock(home->mutex);
+            home->open = false;
+            released.swap(home->spare);
+            released.insert(released.end(), home->returned.begin(), home->returned.end());
+            home->returned.clear();
+        }
+        freeChunks(released);
+    }
+
+    // bytes from the current chunk, or a spare or new one; null when the
+    // block belongs on the heap
+    uint8_t* allocate(size_t bytes, ArenaChunk*& owner) {
+        bytes = alignUp(bytes);
+        if (bytes > kMaxBlockBytes) {
+            return nullptr;
+        }
+        frameBytes += bytes;
+        if (!current || current->used + bytes > current->capacity) {
+            if (current) {
+                filled.push_back(current);
+            }
+            current = takeChunk(bytes);
+            if (!current) {
+                return nullptr;
+            }
+        }
+        uint8_t* block = current->base + current->used;
+        current->used += bytes;
+        current->refs.fetch_add(1, std::memory_order_relaxed);
+        owner = current;
+        return block;
+    }
+
+    // End of frame: chunks without live blocks are rewound, the others are
+    // retired until their blocks come back
+    void rewind() {
+        if (current) {
+            filled.push_back(current);
+            current = nullptr;
+        }
+        const bool split = filled.size() > 1;
+        std::vector<ArenaChunk*> rewound;
+        for (ArenaChunk* chunk : filled) {
+            if (chunk->refs.load(std::memory_order_acquire) == 1 ||
+                chunk->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                rewound.push_back(chunk);
+            } else {
+                retiredCount.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        filled.clear();
+        // A frame that needed several chunks gets one of its whole size next
+        // time; smaller spares then only cost memory
+        if (split) {
+            nextChunkBytes = std::max(nextChunkBytes, std::min(alignUp(frameBytes), kMaxBlockBytes));
+        }
+        frameBytes = 0;
+
+        std::vector<ArenaChunk*> dropped;
+        {
+            std::lock_guard<std::mutex> lock(home->mutex);
+            rewound.insert(rewound.end(), home->returned.begin(), home->returned.end());
+            home->returned.clear();
+            for (ArenaChunk* chunk : rewound) {
+                chunk->used = 0;
+                chunk->refs.store(1, std::memory_order_relaxed);
+                home->spare.push_back(chunk);
+            }
+            std::vector<ArenaChunk*>& spare = home->spare;
+            std::sort(spare.begin(), spare.end(),
+                      [](const ArenaChunk* a, const ArenaChunk* b) { return a->capacity > b->capacity; });
+            while (!spare.empty() && (spare.size() > kMaxSpareChunks || spare.back()->capacity < nextChunkBytes)) {
+                dropped.push_back(spare.back());
+                spare.pop_back();
+            }
+        }
+        freeChunks(dropped);
+    }
+
+private:
+    ArenaChunk* takeChunk(size_t bytes) {
+        {
+            // Largest spare first (kept sorted by rewind)
+            std::lock_guard<std::mutex> lock(home->mutex);
+            std::vector<ArenaChunk*>& spare = home->spare;
+            if (!spare.empty() && spare.front()->capacity >= bytes) {
+                ArenaChunk* chunk = spare.front();
+                spare.erase(spare.begin());
+                return chunk;
+            }
+        }
+        return newChunk(std::max(std::max(bytes, kMinChunkBytes), nextChunkBytes), home);
+    }
+
+    std::shared_ptr<ArenaHome> home;
+    ArenaChunk* current = nullptr;
+    std::vector<ArenaChunk*> filled;  // used up this frame
+    size_t frameBytes = 0;
+    size_t nextChunkBytes = kMinChunkBytes;
+};
+
+thread_local FrameArena* activeArena = nullptr;
+thread_local int scopeDepth = 0;
+
+FrameArena& threadArena() {
+    static thread_local FrameArena arena;
+    return arena;
+}
+
+// Blocks of the active arena, header included; everything else is delegated
+// to the heap allocator, which then owns (and frees) what it made
+class ArenaMatAllocator : public cv::MatAllocator {
+public:
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data0, size_t* step,
+                           cv::AccessFlag flags, cv::UMatUsageFlags usage) const override {
+        FrameArena* arena = activeArena;
+        if (!arena || data0) {
+            return heapMatAllocator()->allocate(dims, sizes, type, data0, step, flags, usage);
+        }
+        size_t total = CV_ELEM_SIZE(type);
+        for (int i = dims - 1; i >= 0; i--) {
+            if (step) {
+                step[i] = total;
+            }
+            total *= static_cast<size_t>(sizes[i]);
+        }
+        ArenaChunk* chunk = nullptr;
+        uint8_t* block = arena->allocate(kHeaderBytes + total, chunk);
+        if (!block) {
+            fallbackCount.fetch_add(1, std::memory_order_relaxed);
+            return heapMatAllocator()->allocate(dims, sizes, type, data0, step, flags, usage);
+        }
+        cv::UMatData* u = new (block) cv::UMatData(this);
+        u->data = u->origdata = block + kHeaderBytes;
+        u->size = total;
+        u->userdata = chunk;
+        return u;
+    }
+
+    bool allocate(cv::UMatData* u, cv::AccessFlag, cv::UMatUsageFlags) const override {
+        return u != nullptr;
+    }
+
+    void deallocate(cv::UMatData* u) const override {
+        if (!u) {
+            return;
+        }
+        CV_Assert(u->urefcount == 0);
+        CV_Assert(u->refcount == 0);
+        ArenaChunk* chunk = static_cast<ArenaChunk*>(u->userdata);
+        u->~UMatData();
+        if (chunk->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            returnChunk(chunk);  // retired, and this was its last block
+        }
+    }
+};
+
+ArenaMatAllocator& arenaAllocator() {
+    static ArenaMatAllocator allocator;  // never destroyed before its blocks
+    return allocator;
+}
+
+} // namespace
+
+void setFrameArenas(bool enabled) {
+    arenasEnabled.store(enabled, std::memory_order_relaxed);
+    refreshDefaultMatAllocator();
+}
+
+bool frameArenasEnabled() {
+    return arenasEnabled.load(std::memory_order_relaxed);
+}
+
+void refreshDefaultMatAllocator() {
+    cv::Mat::setDefaultAllocator(frameArenasEnabled() ? static_cast<cv::MatAllocator*>(&arenaAllocator())
+                                                      : heapMatAllocator());
+}
+
+cv::Mat persistentMat() {
+    cv::Mat mat;
+    mat.allocator = heapMatAllocator();
+    return mat;
+}
+
+ScopedFrameArena::ScopedFrameArena() {
+    if (scopeDepth++ == 0 && frameArenasEnabled()) {
+        activeArena = &threadArena();
+        outermost = true;
+    }
+}
+
+ScopedFrameArena::~ScopedFrameArena() {
+    scopeDepth--;
+    if (outermost) {
+        activeArena = nullptr;
+        threadArena().rewind();
+    }
+}
+
+size_t trimFrameArenas() {
+    std::vector<std::shared_ptr<ArenaHome>> homes;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (const std::weak_ptr<ArenaHome>& entry : registry) {
+            if (std::shared_ptr<ArenaHome> home = entry.lock()) {
+                homes.push_back(home);
+            }
+        }
+    }
+    size_t bytes = 0;
+    for (const std::shared_ptr<ArenaHome>& home : homes) {
+        std::vector<ArenaChunk*> released;
+        {
+            std::lock_guard<std::mutex> lock(home->mutex);
+            released.swap(home->spare);
+            released.insert(released.end(), home->returned.begin(), home->returned.end());
+            home->returned.clear();
+        }
+        for (const ArenaChunk* chunk : released) {
+            bytes += chunk->capacity;
+        }
+        freeChunks(released);
+    }
+    return bytes;
+}
+
+FrameArenaStats frameArenaStats() {
+    FrameArenaStats stats;
+    stats.chunks = chunkCount.load(std::memory_order_relaxed);
+    stats.bytesReserved = reservedBytes.load(std::memory_order_relaxed);
+    stats.retiredChunks = retiredCount.load(std::memory_order_relaxed);
+    stats.heapFallbacks = fallbackCount.load(std::memory_order_relaxed);
+    return stats;
+}
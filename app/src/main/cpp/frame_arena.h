@@ -0,0 +1,58 @@
+#ifndef EDGE_FRAME_ARENA_H
+#define EDGE_FRAME_ARENA_H
+
+#include <opencv2/core.hpp>
+
+// Per-thread bump arenas for the cv::Mat temporaries of one frame (cvtColor
+// and Canny outputs, resize targets, masks). While enabled, the default
+// cv::Mat allocator hands a thread inside a ScopedFrameArena a 64-byte
+// aligned block of its arena, header included, instead of calling malloc;
+// the scope's end rewinds the arena, so in steady state one or two large
+// chunks per processing thread serve every frame. Other threads, and blocks
+// larger than an arena would hold, get ordinary heap buffers
+// (heapMatAllocator()).
+//
+// A block may outlive its frame (a published Mat, a module's cached state):
+// its chunk is then retired instead of rewound, and comes back to the arena
+// for reuse once its last block is released, from whichever thread. The
+// frame pool never allocates from an arena (frame_pool.h).
+void setFrameArenas(bool enabled);
+bool frameArenasEnabled();
+
+// The default cv::Mat allocator for the current settings: the arena
+// allocator when frame arenas are on, heapMatAllocator() otherwise
+void refreshDefaultMatAllocator();
+
+// An empty Mat whose buffer, when created, comes from the heap: for scratch
+// a module keeps across frames, which would otherwise hold on to the arena
+// chunk it was first made in
+cv::Mat persistentMat();
+
+// Allocations of the calling thread come from its arena while in scope.
+// Scopes nest; only the outermost rewinds.
+class ScopedFrameArena {
+public:
+    ScopedFrameArena();
+    ~ScopedFrameArena();
+    ScopedFrameArena(const ScopedFrameArena&) = delete;
+    ScopedFrameArena& operator=(const ScopedFrameArena&) = delete;
+
+private:
+    bool outermost = false;
+};
+
+// Frees every arena's spare chunks, from any thread (memory trimming); the
+// arenas grow back on their next frames. Returns the bytes released.
+size_t trimFrameArenas();
+
+// All threads' arenas
+struct FrameArenaStats {
+    size_t chunks = 0;          // allocated, spare and retired ones included
+    size_t bytesReserved = 0;
+    size_t retiredChunks = 0;   // cumulative: frames that ended with a block still live
+    size_t heapFallbacks = 0;   // cumulative: in-scope blocks too large for an arena
+};
+
+FrameArenaStats frameArenaStats();
+
+#endif // EDGE_FRAME_ARENA_H
@@ -0,0 +1,130 @@
+#include "frame_capture.h"
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define LOG_TAG "FrameCapture"
+#include "logging.h"
+
+namespace {
+
+const uint32_t kCaptureVersion = 1;
+const size_t kSlotAlignment = 4096;  // slots start on a page
+
+std::mutex captureMutex;          // capture vs start/stop; uncontended per frame
+std::atomic<bool> active{false};  // cheap check before taking the mutex
+uint8_t* mapping = nullptr;
+size_t mappingBytes = 0;
+uint32_t slotCount = 0;
+uint32_t slotBytes = 0;
+uint32_t maxFrameBytes = 0;
+uint64_t nextSequence = 1;
+
+// captureMutex held
+void unmap() {
+    if (mapping) {
+        msync(mapping, mappingBytes, MS_ASYNC);
+        munmap(mapping, mappingBytes);
+        mapping = nullptr;
+    }
+    mappingBytes = 0;
+}
+
+} // namespace
+
+bool startFrameCapture(const char* path, int slots, int maxWidth, int maxHeight) {
+    std::lock_guard<std::mutex> lock(captureMutex);
+    active.store(false);
+    unmap();
+    if (!path || slots <= 0 || maxWidth <= 0 || maxHeight <= 0) {
+        return false;
+    }
+
+    const size_t frameBytes = static_cast<size_t>(maxWidth) * (maxHeight + maxHeight / 2);
+    const size_t slot = (sizeof(CaptureSlotHeader) + frameBytes + kSlotAlignment - 1) / kSlotAlignment *
+                        kSlotAlignment;
+    const size_t total = kCaptureHeaderBytes + slot * static_cast<size_t>(slots);
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        LOGE("❌ Cannot open capture file %s: %s", path, strerror(errno));
+        return false;
+    }
+    // Allocated up front: a sparse file could SIGBUS on a full disk mid-memcpy
+    int error = posix_fallocate(fd, 0, static_cast<off_t>(total));
+    if (error != 0) {
+        LOGE("❌ Cannot allocate %zu bytes for %s: %s", total, path, strerror(error));
+        close(fd);
+        return false;
+    }
+    void* mapped = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);  // the mapping keeps the file
+    if (mapped == MAP_FAILED) {
+        LOGE("❌ mmap of %s failed: %s", path, strerror(errno));
+        return false;
+    }
+
+    mapping = static_cast<uint8_t*>(mapped);
+    mappingBytes = total;
+    slotCount = static_cast<uint32_t>(slots);
+    slotBytes = static_cast<uint32_t>(slot);
+    maxFrameBytes = static_cast<uint32_t>(frameBytes);
+    nextSequence = 1;
+
+    CaptureFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, "EDGECAP", 8);
+    header.version = kCaptureVersion;
+    header.slotCount = slotCount;
+    header.slotBytes = slotBytes;
+    header.maxFrameBytes = maxFrameBytes;
+    std::memcpy(mapping, &header, sizeof(header));
+    active.store(true);
+    LOGI("✅ Frame capture: %d slots of %dx%d in %s (%zu MB)", slots, maxWidth, maxHeight, path,
+         total >> 20);
+    return true;
+}
+
+void stopFrameCapture() {
+    std::lock_guard<std::mutex> lock(captureMutex);
+    active.store(false);
+    unmap();
+}
+
+bool frameCaptureActive() {
+    return active.load(std::memory_order_relaxed);
+}
+
+void captureFrame(const uint8_t* nv21, int width, int height, int rotation, int renderMode,
+                  int64_t timestampNs) {
+    if (!active.load(std::memory_order_relaxed) || !nv21) {
+        return;
+    }
+    const size_t frameBytes = static_cast<size_t>(width) * (height + height / 2);
+    std::lock_guard<std::mutex> lock(captureMutex);
+    if (!mapping || frameBytes > maxFrameBytes) {
+        LOGW_RATELIMITED("⚠️ %dx%d frame exceeds the capture slot, not captured", width, height);
+        return;
+    }
+    const uint64_t sequence = nextSequence++;
+    uint8_t* slot = mapping + kCaptureHeaderBytes + (sequence - 1) % slotCount * slotBytes;
+    CaptureSlotHeader* header = reinterpret_cast<CaptureSlotHeader*>(slot);
+
+    // Invalidate first, so a crash mid-copy leaves an empty slot rather than
+    // a new header over half of the old frame
+    header->sequence = 0;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    std::memcpy(slot + sizeof(CaptureSlotHeader), nv21, frameBytes);
+    header->timestampNs = timestampNs;
+    header->width = width;
+    header->height = height;
+    header->rotation = rotation;
+    header->renderMode = renderMode;
+    header->frameBytes = static_cast<uint32_t>(frameBytes);
+    header->reserved = 0;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    header->sequence = sequence;
+}
@@ -0,0 +1,53 @@
+#ifndef EDGE_FRAME_CAPTURE_H
+#define EDGE_FRAME_CAPTURE_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Post-mortem capture: the last frames that went into processing, kept in a
+// fixed-size ring file that is mmap'ed MAP_SHARED. Recording a frame is one
+// memcpy into the mapping (no write() per frame, no msync); the kernel writes
+// the pages back, so the file survives even a crash of the process. Pull it
+// with e.g. `adb exec-out run-as com.example.edge cat files/frames.ring`.
+//
+// Layout (little-endian): a kCaptureHeaderBytes header (CaptureFileHeader),
+// then slotCount slots of slotBytes each, a CaptureSlotHeader followed by the
+// packed NV21 frame. Slots are reused round-robin; order them by sequence.
+// A slot whose sequence is 0 is empty or was being written when the process
+// died.
+struct CaptureFileHeader {
+    char magic[8];           // "EDGECAP\0"
+    uint32_t version;        // 1
+    uint32_t slotCount;
+    uint32_t slotBytes;      // CaptureSlotHeader plus the largest frame
+    uint32_t maxFrameBytes;
+};
+
+struct CaptureSlotHeader {
+    uint64_t sequence;       // 1-based; written last
+    int64_t timestampNs;     // capture time on CLOCK_BOOTTIME
+    int32_t width;
+    int32_t height;
+    int32_t rotation;
+    int32_t renderMode;
+    uint32_t frameBytes;     // NV21 bytes following this header
+    uint32_t reserved;
+};
+
+const size_t kCaptureHeaderBytes = 4096;
+
+// Creates (or replaces) the ring file for slotCount frames of up to
+// maxWidth x maxHeight; larger frames are skipped. False if it cannot be
+// sized or mapped.
+bool startFrameCapture(const char* path, int slotCount, int maxWidth, int maxHeight);
+
+// Unmaps and closes the file; what was captured so far stays in it
+void stopFrameCapture();
+
+bool frameCaptureActive();
+
+// Copies one packed NV21 frame into the next slot; a no-op unless started
+void captureFrame(const uint8_t* nv21, int width, int height, int rotation, int renderMode,
+                  int64_t timestampNs);
+
+#endif // EDGE_FRAME_CAPTURE_H
@@ -0,0 +1,42 @@
+#include "frame_deadline.h"
+#include "metrics.h"
+
+namespace {
+
+thread_local const FrameDeadline* currentDeadline = nullptr;
+
+}  // namespace
+
+bool FrameDeadline::expired() const {
+    if (passed.load(std::memory_order_relaxed)) {
+        return true;
+    }
+    if (bootTimeNanos() < deadlineNs) {
+        return false;
+    }
+    passed.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+ScopedFrameDeadline::ScopedFrameDeadline(int64_t deadlineNs)
+        : deadline(deadlineNs), previous(currentDeadline) {
+    if (deadlineNs > 0) {
+        currentDeadline = &deadline;
+    }
+}
+
+ScopedFrameDeadline::~ScopedFrameDeadline() {
+    currentDeadline = previous;
+}
+
+const FrameDeadline* frameDeadline() {
+    return currentDeadline;
+}
+
+bool deadlineAborts(const FrameDeadline* deadline) {
+    if (!deadline || !deadline->expired()) {
+        return false;
+    }
+    metrics().increment(Counter::STAGES_DEADLINE_ABORTED);
+    return true;
+}
@@ -0,0 +1,50 @@
+#ifndef EDGE_FRAME_DEADLINE_H
+#define EDGE_FRAME_DEADLINE_H
+
+#include <atomic>
+#include <cstdint>
+
+// Cooperative cancellation of a frame that overruns the latency budget once
+// it is already in a stage. The thread processing a frame opens a
+// ScopedFrameDeadline (capture time plus nativeSetLatencyBudget's budget);
+// long stages take frameDeadline() on that thread, hand it to their parallel
+// bodies and call expired() at band, tile or item boundaries. A stage that
+// sees it stops, leaves its output of the frame unset and reports so: the
+// frame then publishes without that variant, and publishFrame keeps the last
+// good one on screen. Each check reads the clock; once expired, the token
+// stays expired without reading it again.
+class FrameDeadline {
+public:
+    explicit FrameDeadline(int64_t deadlineNs) : deadlineNs(deadlineNs) {}
+
+    // Safe from any thread
+    bool expired() const;
+
+private:
+    int64_t deadlineNs;  // CLOCK_BOOTTIME (bootTimeNanos)
+    mutable std::atomic<bool> passed{false};
+};
+
+// The deadline of the frame the calling thread processes for its lifetime;
+// deadlineNs 0 installs none
+class ScopedFrameDeadline {
+public:
+    explicit ScopedFrameDeadline(int64_t deadlineNs);
+    ~ScopedFrameDeadline();
+    ScopedFrameDeadline(const ScopedFrameDeadline&) = delete;
+    ScopedFrameDeadline& operator=(const ScopedFrameDeadline&) = delete;
+
+private:
+    FrameDeadline deadline;
+    const FrameDeadline* previous;
+};
+
+// The calling thread's frame deadline, or null when it has none
+const FrameDeadline* frameDeadline();
+
+// True when deadline is set and has passed, counted as an aborted stage
+// (Counter::STAGES_DEADLINE_ABORTED): a stage asks once, after its bodies
+// returned, whether its output stands
+bool deadlineAborts(const FrameDeadline* deadline);
+
+#endif // EDGE_FRAME_DEADLINE_H
@@ -0,0 +1,92 @@
+#include "frame_fanout.h"
+#include <algorithm>
+
+#define LOG_TAG "FrameFanout"
+#include "logging.h"
+
+void FrameQueue::offer(const FrameHandle& frame) {
+    FrameHandle superseded;  // released outside the lock
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (closed) {
+            return;
+        }
+        if (pending) {
+            replaced.fetch_add(1, std::memory_order_relaxed);
+        }
+        superseded = std::move(pending);
+        pending = frame;
+    }
+    wakeup.notify_one();
+}
+
+FrameHandle FrameQueue::take() {
+    std::unique_lock<std::mutex> lock(mutex);
+    wakeup.wait(lock, [this] { return pending || closed; });
+    if (closed) {
+        return nullptr;
+    }
+    delivered.fetch_add(1, std::memory_order_relaxed);
+    return std::move(pending);
+}
+
+FrameHandle FrameQueue::poll() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!pending) {
+        return nullptr;
+    }
+    delivered.fetch_add(1, std::memory_order_relaxed);
+    return std::move(pending);
+}
+
+void FrameQueue::close() {
+    FrameHandle dropped;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        dropped = std::move(pending);
+    }
+    wakeup.notify_all();
+}
+
+FrameQueueStats FrameQueue::stats() const {
+    FrameQueueStats result;
+    result.delivered = delivered.load(std::memory_order_relaxed);
+    result.replaced = replaced.load(std::memory_order_relaxed);
+    return result;
+}
+
+std::shared_ptr<FrameQueue> FrameFanout::subscribe(const std::string& name) {
+    auto queue = std::make_shared<FrameQueue>(name);
+    std::lock_guard<std::mutex> lock(mutex);
+    queues.push_back(queue);
+    consumerCount.store(static_cast<int>(queues.size()), std::memory_order_release);
+    LOGI("Frame consumer %s subscribed (%zu)", name.c_str(), queues.size());
+    return queue;
+}
+
+void FrameFanout::unsubscribe(const std::shared_ptr<FrameQueue>& queue) {
+    if (!queue) {
+        return;
+    }
+    queue->close();
+    std::lock_guard<std::mutex> lock(mutex);
+    queues.erase(std::remove(queues.begin(), queues.end(), queue), queues.end());
+    consumerCount.store(static_cast<int>(queues.size()), std::memory_order_release);
+    LOGI("Frame consumer %s unsubscribed (%zu left)", queue->consumerName().c_str(), queues.size());
+}
+
+void FrameFanout::publish(const FrameHandle& frame) {
+    if (!frame) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const std::shared_ptr<FrameQueue>& queue : queues) {
+        queue->offer(frame);  // a short lock each; never waits on the consumer
+    }
+}
+
+FrameFanout& frameFanout() {
+    static FrameFanout fanout;
+    return fanout;
+}
@@ -0,0 +1,97 @@
+#ifndef EDGE_FRAME_FANOUT_H
+#define EDGE_FRAME_FANOUT_H
+
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// The frame's whole luma area-downscaled to one configured output size
+// (scaled_outputs.h), sensor orientation, in a pooled buffer of its own
+struct ScaledLuma {
+    cv::Size size;
+    cv::Mat luma;             // CV_8UC1 of size
+};
+
+// What a published frame offers consumers besides the renderer. Immutable
+// once handed out: the Mats are headers over published (pooled) buffers,
+// never written again, so consumers share them without copying. Each buffer
+// goes back to the frame pool when the last handle referencing it is dropped.
+struct FanoutFrame {
+    cv::Mat edges;            // CV_8UC1 edge map, or a 1-bpp bitmap when bitmapWidth > 0; may be empty
+    int bitmapWidth = 0;
+    cv::Mat luma;             // processed grayscale, or empty
+    cv::Rect roi;             // part of the frame edges/luma cover (empty = all of it)
+    std::vector<ScaledLuma> scaled;  // one per configured output size the frame reached
+    cv::Size frameSize;
+    int rotation = 0;         // clockwise degrees to upright
+    int64_t captureTimestampNs = 0;
+    // Publish sequence; GPU edges read back a few frames late carry the one
+    // of the frame they were computed from, so sequences may repeat
+    uint64_t sequence = 0;
+};
+
+using FrameHandle = std::shared_ptr<const FanoutFrame>;
+
+struct FrameQueueStats {
+    uint64_t delivered = 0;  // taken by the consumer
+    uint64_t replaced = 0;   // superseded before the consumer took them
+};
+
+// One consumer's latest-only mailbox: offer() replaces a frame not taken
+// yet, so a slow consumer holds at most the frame it works on plus the
+// newest one, and the producer never waits for it.
+class FrameQueue {
+public:
+    explicit FrameQueue(std::string name) : name(std::move(name)) {}
+
+    void offer(const FrameHandle& frame);
+
+    // Newest frame since the last take, waiting for one; null once closed
+    FrameHandle take();
+    // Newest frame since the last take, or null without waiting
+    FrameHandle poll();
+
+    // Wakes take() for good and drops the pending frame
+    void close();
+
+    FrameQueueStats stats() const;
+    const std::string& consumerName() const { return name; }
+
+private:
+    const std::string name;
+    mutable std::mutex mutex;
+    std::condition_variable wakeup;
+    FrameHandle pending;
+    bool closed = false;
+    std::atomic<uint64_t> delivered{0};
+    std::atomic<uint64_t> replaced{0};
+};
+
+// Hands every published frame to the subscribed consumers (edge stream,
+// analytics) as one shared handle
+class FrameFanout {
+public:
+    std::shared_ptr<FrameQueue> subscribe(const std::string& name);
+    void unsubscribe(const std::shared_ptr<FrameQueue>& queue);
+
+    // Whether publish() has anyone to deliver to; the producer skips
+    // building the handle otherwise
+    bool hasConsumers() const { return consumerCount.load(std::memory_order_acquire) > 0; }
+
+    void publish(const FrameHandle& frame);
+
+private:
+    std::mutex mutex;
+    std::vector<std::shared_ptr<FrameQueue>> queues;
+    std::atomic<int> consumerCount{0};
+};
+
+// Fan-out of the default pipeline's published frames
+FrameFanout& frameFanout();
+
+#endif // EDGE_FRAME_FANOUT_H
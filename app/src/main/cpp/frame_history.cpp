@@ -0,0 +1,49 @@
+#include "frame_history.h"
+#include <algorithm>
+
+void FrameHistory::push(const HistoryFrame& frame, int depth, bool keepEdges) {
+    depth = std::min(std::max(depth, 0), kMaxDepth);
+    std::lock_guard<std::mutex> lock(mutex);
+    if (depth == 0) {
+        if (count > 0) {
+            slots.fill(HistoryFrame());
+            newest = -1;
+            count = 0;
+        }
+        return;
+    }
+    newest = (newest + 1) % kMaxDepth;
+    HistoryFrame& slot = slots[newest];
+    slot = frame;
+    if (!keepEdges) {
+        slot.edges = cv::Mat();
+        slot.edgeBitmapWidth = 0;
+    }
+    count = std::min(count + 1, kMaxDepth);
+    // A smaller depth releases the frames beyond it right away
+    while (count > depth) {
+        slots[(newest - count + 1 + kMaxDepth) % kMaxDepth] = HistoryFrame();
+        count--;
+    }
+}
+
+bool FrameHistory::at(int ago, HistoryFrame& frame) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (ago < 0 || ago >= count) {
+        return false;
+    }
+    frame = slots[(newest - ago + kMaxDepth) % kMaxDepth];
+    return true;
+}
+
+int FrameHistory::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return count;
+}
+
+void FrameHistory::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    slots.fill(HistoryFrame());
+    newest = -1;
+    count = 0;
+}
@@ -0,0 +1,47 @@
+#ifndef EDGE_FRAME_HISTORY_H
+#define EDGE_FRAME_HISTORY_H
+
+#include <opencv2/core.hpp>
+#include <array>
+#include <cstdint>
+#include <mutex>
+
+// One published frame as the history keeps it: headers over the published
+// (pooled, immutable) buffers, never copies
+struct HistoryFrame {
+    cv::Mat luma;             // processed grayscale
+    cv::Mat edges;            // published edge map (1-bpp when edgeBitmapWidth > 0), if kept
+    int edgeBitmapWidth = 0;
+    cv::Rect roi;             // part of the frame luma/edges cover (empty = all of it)
+    cv::Size frameSize;
+    int rotation = 0;
+    int64_t captureTimestampNs = 0;
+    uint64_t sequence = 0;
+};
+
+// The last N published frames of a pipeline, shared by every temporal
+// consumer (change detection, flow, stabilization, denoise) instead of each
+// keeping its own copies. push() stores headers only, so a frame costs no
+// copy and its buffers simply stay out of the frame pool until it falls off
+// the end of the ring. Readers get headers too and may keep them.
+class FrameHistory {
+public:
+    static const int kMaxDepth = 8;
+
+    // Adds the newest frame, keeping at most depth (0..kMaxDepth); depth 0
+    // empties the ring. Edges are dropped unless keepEdges.
+    void push(const HistoryFrame& frame, int depth, bool keepEdges);
+
+    // Frame `ago` publishes back (0 = the newest); false past the oldest kept
+    bool at(int ago, HistoryFrame& frame) const;
+    int size() const;
+    void clear();
+
+private:
+    mutable std::mutex mutex;
+    std::array<HistoryFrame, kMaxDepth> slots;
+    int newest = -1;  // slot of the newest frame
+    int count = 0;
+};
+
+#endif // EDGE_FRAME_HISTORY_H
@@ -0,0 +1,83 @@
+#ifndef EDGE_FRAME_INGEST_H
+#define EDGE_FRAME_INGEST_H
+
+#include <cstdint>
+
+struct AHardwareBuffer;
+
+// Borrowed view of a YUV_420_888 image as delivered by AImage / android.media.Image.
+// Plane pointers stay owned by the producer and are only valid for the duration of
+// the ingest call.
+struct YuvPlanes {
+    const uint8_t* y = nullptr;
+    const uint8_t* u = nullptr;
+    const uint8_t* v = nullptr;
+    int yRowStride = 0;
+    int uvRowStride = 0;
+    int uvPixelStride = 0;
+    int width = 0;
+    int height = 0;
+    int64_t timestampNs = 0;  // sensor timestamp (CLOCK_BOOTTIME), 0 = stamp on arrival
+    // The image's buffer when the reader was created for GPU sampling
+    // (ingestWantsHardwareBuffers), null otherwise; same lifetime as the planes
+    AHardwareBuffer* hardwareBuffer = nullptr;
+};
+
+// Borrowed view of a YCBCR_P010 image (10-bit HDR streams): 16-bit
+// little-endian words with each 10-bit sample in their high bits, a Y plane
+// and an interleaved UV plane at half resolution. Strides are in bytes; same
+// lifetime as YuvPlanes'.
+struct P010Planes {
+    const uint16_t* y = nullptr;
+    const uint16_t* uv = nullptr;
+    int yRowStride = 0;
+    int uvRowStride = 0;
+    int width = 0;
+    int height = 0;
+    int64_t timestampNs = 0;  // sensor timestamp (CLOCK_BOOTTIME), 0 = stamp on arrival
+};
+
+// Borrowed view of a RAW_SENSOR (RAW16) or RAW10 image: one Bayer mosaic
+// plane, its row stride in bytes. RAW16 holds one sample per 16-bit word,
+// whiteLevel at most; RAW10 is MIPI packed, 5 bytes per 4 samples. Same
+// lifetime as YuvPlanes'.
+struct RawPlanes {
+    enum Format { RAW16, RAW10 };
+    const uint8_t* data = nullptr;
+    Format format = RAW16;
+    int rowStride = 0;
+    int width = 0;
+    int height = 0;
+    int whiteLevel = 1023;  // RAW16: largest sample value (SENSOR_INFO_WHITE_LEVEL)
+    int64_t timestampNs = 0;  // sensor timestamp (CLOCK_BOOTTIME), 0 = stamp on arrival
+};
+
+struct PipelineContext;
+
+// Feeds a planar/semi-planar frame into the same pipeline as packed NV21 ingest
+// (implemented in native-lib.cpp); null = the default pipeline.
+void processYuvPlanes(const YuvPlanes& planes, int rotation, PipelineContext* pipeline = nullptr);
+
+// The same for a P010 frame: the 8-bit planes go the NV21 way, and Canny on
+// the CPU backend runs on the 10-bit luma (detectEdges10 in image_processor.h)
+// where the processed gray is the Y plane only cropped or scaled
+void processP010Planes(const P010Planes& planes, int rotation, PipelineContext* pipeline = nullptr);
+
+// A Bayer frame, skipping demosaicing and the ISP's YUV processing: every
+// 2x2 quad is binned into one luma pixel in a single pass over the camera's
+// buffer, and the half-width, half-height gray frame (neutral chroma) goes
+// through the pipeline like any NV21 frame. The luma is linear sensor light,
+// before black level, white balance and gamma.
+void processRawPlanes(const RawPlanes& planes, int rotation, PipelineContext* pipeline = nullptr);
+
+// A camera is about to deliver width x height frames to pipeline (null = the
+// default one): allocates their pooled buffers and GL textures now, so the
+// first frame of the new size switches over without allocating (implemented
+// in native-lib.cpp). Call off the frame path, before the resize.
+void prepareIngestSize(PipelineContext* pipeline, int width, int height);
+
+// Whether the edge backend works on camera AHardwareBuffers (Vulkan with
+// Y'CbCr import); a camera asks when it creates its reader
+bool ingestWantsHardwareBuffers();
+
+#endif // EDGE_FRAME_INGEST_H
@@ -0,0 +1,42 @@
+#ifndef EDGE_FRAME_ORIENTATION_H
+#define EDGE_FRAME_ORIENTATION_H
+
+#include <opencv2/core.hpp>
+
+// Frames stay in sensor-native orientation through the whole pipeline; the
+// rotation (clockwise degrees that make a frame upright, as reported by the
+// camera) travels with them and is applied only by the renderer's texture
+// coordinates. Algorithms that need upright coordinates map them here.
+
+// Size of the frame once rotated upright
+inline cv::Size uprightSize(const cv::Size& sensorSize, int rotation) {
+    return (rotation == 90 || rotation == 270)
+           ? cv::Size(sensorSize.height, sensorSize.width) : sensorSize;
+}
+
+// Maps a pixel position in the sensor-native buffer to the upright frame
+// (same convention as cv::rotate with the matching ROTATE_* code)
+inline cv::Point2f sensorToUpright(const cv::Point2f& p, const cv::Size& sensorSize, int rotation) {
+    const float w = static_cast<float>(sensorSize.width - 1);
+    const float h = static_cast<float>(sensorSize.height - 1);
+    switch (rotation) {
+        case 90:  return cv::Point2f(h - p.y, p.x);
+        case 180: return cv::Point2f(w - p.x, h - p.y);
+        case 270: return cv::Point2f(p.y, w - p.x);
+        default:  return p;
+    }
+}
+
+// Inverse of sensorToUpright
+inline cv::Point2f uprightToSensor(const cv::Point2f& p, const cv::Size& sensorSize, int rotation) {
+    const float w = static_cast<float>(sensorSize.width - 1);
+    const float h = static_cast<float>(sensorSize.height - 1);
+    switch (rotation) {
+        case 90:  return cv::Point2f(p.y, h - p.x);
+        case 180: return cv::Point2f(w - p.x, h - p.y);
+        case 270: return cv::Point2f(w - p.y, p.x);
+        default:  return p;
+    }
+}
+
+#endif //EDGE_FRAME_ORIENTATION_H
@@ -0,0 +1,225 @@
+#include "frame_pacing.h"
+#include "thread_policy.h"
+#include <algorithm>
+#include <cmath>
+#include <dlfcn.h>
+
+#define LOG_TAG "FramePacing"
+#include "logging.h"
+
+namespace {
+
+const int kMinWindow = 4;              // intervals before janks are judged
+const double kJankFactor = 1.5;
+const int64_t kMaxVsyncGapNs = 50000000;  // longer gaps are pauses, not the period
+
+template <typename T>
+T median(const T* values, uint64_t count) {
+    const int n = static_cast<int>(std::min<uint64_t>(count, FramePacing::kWindow));
+    T sorted[FramePacing::kWindow];
+    std::copy(values, values + n, sorted);
+    std::nth_element(sorted, sorted + n / 2, sorted + n);
+    return sorted[n / 2];
+}
+
+} // namespace
+
+const ChoreographerApi& choreographerApi() {
+    static const ChoreographerApi api = [] {
+        ChoreographerApi loaded;
+        void* library = dlopen("libandroid.so", RTLD_NOW);
+        if (!library) {
+            return loaded;
+        }
+        loaded.getInstance = reinterpret_cast<decltype(loaded.getInstance)>(
+                dlsym(library, "AChoreographer_getInstance"));
+        loaded.postFrameCallback = reinterpret_cast<decltype(loaded.postFrameCallback)>(
+                dlsym(library, "AChoreographer_postFrameCallback"));
+        loaded.postFrameCallback64 = reinterpret_cast<decltype(loaded.postFrameCallback64)>(
+                dlsym(library, "AChoreographer_postFrameCallback64"));
+        return loaded;
+    }();
+    return api;
+}
+
+FramePacing::~FramePacing() {
+    stop();
+}
+
+void FramePacing::start() {
+    if (enabled.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+    reset();
+    stopping.store(false, std::memory_order_release);
+    if (choreographerApi().available()) {
+        vsyncThread = std::thread(&FramePacing::vsyncLoop, this);
+    } else {
+        LOGW("⚠️ AChoreographer unavailable; frame pacing without vsync counts");
+    }
+    LOGI("✅ Frame pacing analysis started");
+}
+
+void FramePacing::stop() {
+    if (!enabled.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
+    stopping.store(true, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (looper) {
+            ALooper_wake(looper);
+        }
+    }
+    if (vsyncThread.joinable()) {
+        vsyncThread.join();
+    }
+}
+
+void FramePacing::vsyncLoop() {
+    setThreadTier(ThreadTier::RENDER);
+    ALooper* threadLooper = ALooper_prepare(ALOOPER_PREPARE_ALLOW_NON_CALLBACKS);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        looper = threadLooper;
+    }
+    if (postVsyncCallback()) {
+        while (!stopping.load(std::memory_order_acquire)) {
+            ALooper_pollOnce(-1, nullptr, nullptr, nullptr);
+        }
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    looper = nullptr;
+}
+
+bool FramePacing::postVsyncCallback() {
+    const ChoreographerApi& api = choreographerApi();
+    AChoreographer* choreographer = api.getInstance();  // of this thread's looper
+    if (!choreographer) {
+        LOGW("⚠️ No AChoreographer for the pacing thread");
+        return false;
+    }
+    if (api.postFrameCallback64) {
+        api.postFrameCallback64(choreographer, &FramePacing::onVsync, this);
+    } else {
+        api.postFrameCallback(choreographer, &FramePacing::onVsync32, this);
+    }
+    return true;
+}
+
+void FramePacing::onVsync(int64_t frameTimeNanos, void* data) {
+    auto* self = static_cast<FramePacing*>(data);
+    self->recordVsync(frameTimeNanos);
+    if (!self->stopping.load(std::memory_order_acquire)) {
+        self->postVsyncCallback();
+    }
+}
+
+void FramePacing::onVsync32(long frameTimeNanos, void* data) {
+    onVsync(static_cast<int64_t>(frameTimeNanos), data);
+}
+
+void FramePacing::recordVsync(int64_t frameTimeNanos) {
+    const int64_t previous = lastVsyncNs.exchange(frameTimeNanos, std::memory_order_relaxed);
+    const int64_t gap = frameTimeNanos - previous;
+    if (previous > 0 && gap > 0 && gap < kMaxVsyncGapNs) {
+        // Exponential average over ~16 vsyncs; follows refresh-rate switches
+        const int64_t period = vsyncPeriodNs.load(std::memory_order_relaxed);
+        vsyncPeriodNs.store(period > 0 ? period + (gap - period) / 16 : gap, std::memory_order_relaxed);
+    }
+    vsyncs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void FramePacing::onIngest(int64_t timestampNs) {
+    if (!isRunning()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    record(trackers[static_cast<int>(PacingStream::INGEST)], timestampNs, true);
+}
+
+void FramePacing::onPublish(int64_t timestampNs) {
+    if (!isRunning()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    record(trackers[static_cast<int>(PacingStream::PUBLISH)], timestampNs, true);
+}
+
+void FramePacing::onPresent(int64_t timestampNs, uint64_t sequence) {
+    if (!isRunning() || sequence == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    Tracker& tracker = trackers[static_cast<int>(PacingStream::PRESENT)];
+    if (sequence == tracker.lastSequence) {
+        tracker.repeats++;
+        return;
+    }
+    tracker.lastSequence = sequence;
+
+    const uint64_t vsync = vsyncs.load(std::memory_order_relaxed);
+    const bool counted = vsync > 0 && tracker.lastVsync > 0;
+    if (counted && vsync > tracker.lastVsync) {
+        const uint32_t elapsed = static_cast<uint32_t>(std::min<uint64_t>(vsync - tracker.lastVsync, UINT32_MAX));
+        if (tracker.vsyncIntervals >= kMinWindow) {
+            const uint32_t typical = median(tracker.vsyncWindow, tracker.vsyncIntervals);
+            if (elapsed > typical) {
+                tracker.janks++;
+                tracker.missedVsyncs += elapsed - typical;
+            }
+        }
+        tracker.vsyncWindow[tracker.vsyncIntervals % kWindow] = elapsed;
+        tracker.vsyncIntervals++;
+    }
+    tracker.lastVsync = vsync;
+    record(tracker, timestampNs, !counted);
+}
+
+void FramePacing::record(Tracker& tracker, int64_t timestampNs, bool judgeByTime) {
+    const int64_t previous = tracker.lastNs;
+    tracker.lastNs = timestampNs;
+    if (previous <= 0 || timestampNs <= previous) {
+        return;
+    }
+    const double interval = (timestampNs - previous) / 1e6;
+    if (judgeByTime && tracker.count >= kMinWindow && interval > kJankFactor * median(tracker.window, tracker.count)) {
+        tracker.janks++;
+    }
+    tracker.window[tracker.count % kWindow] = interval;
+    tracker.count++;
+    const double delta = interval - tracker.mean;
+    tracker.mean += delta / tracker.count;
+    tracker.m2 += delta * (interval - tracker.mean);
+    tracker.max = std::max(tracker.max, interval);
+}
+
+PacingStats FramePacing::stats(PacingStream stream) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    const Tracker& tracker = trackers[static_cast<int>(stream)];
+    PacingStats result;
+    result.intervals = tracker.count;
+    result.meanMs = tracker.mean;
+    result.stddevMs = tracker.count > 1 ? std::sqrt(tracker.m2 / (tracker.count - 1)) : 0.0;
+    result.maxMs = tracker.max;
+    result.janks = tracker.janks;
+    result.repeats = tracker.repeats;
+    result.missedVsyncs = tracker.missedVsyncs;
+    return result;
+}
+
+double FramePacing::vsyncPeriodMs() const {
+    return vsyncPeriodNs.load(std::memory_order_relaxed) / 1e6;
+}
+
+void FramePacing::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (Tracker& tracker : trackers) {
+        tracker = Tracker();
+    }
+}
+
+FramePacing& framePacing() {
+    static FramePacing pacing;
+    return pacing;
+}
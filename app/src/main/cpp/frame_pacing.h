@@ -0,0 +1,109 @@
+#ifndef EDGE_FRAME_PACING_H
+#define EDGE_FRAME_PACING_H
+
+#include <android/choreographer.h>
+#include <android/looper.h>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+// minSdk is 24: the callback takes a long frame time (32-bit on 32-bit ABIs)
+// until postFrameCallback64 in API 29; both are looked up so neither is
+// linked against its deprecation
+struct ChoreographerApi {
+    AChoreographer* (*getInstance)() = nullptr;
+    void (*postFrameCallback)(AChoreographer*, AChoreographer_frameCallback, void*) = nullptr;
+    void (*postFrameCallback64)(AChoreographer*, AChoreographer_frameCallback64, void*) = nullptr;
+
+    bool available() const { return getInstance && (postFrameCallback64 || postFrameCallback); }
+};
+
+const ChoreographerApi& choreographerApi();
+
+// Points of the default pipeline whose frame cadence is tracked
+enum class PacingStream : int {
+    INGEST = 0,   // capture timestamps of frames reaching processing (dropped ones excluded)
+    PUBLISH,      // frames published to the renderer
+    PRESENT,      // renderGL draws of a new frame of the bound pipeline (before the swap)
+    COUNT
+};
+
+struct PacingStats {
+    uint64_t intervals = 0;
+    double meanMs = 0.0;
+    double stddevMs = 0.0;       // frame-interval jitter
+    double maxMs = 0.0;
+    uint64_t janks = 0;          // intervals well over the recent typical one
+    uint64_t repeats = 0;        // PRESENT: redraws of the frame already shown
+    uint64_t missedVsyncs = 0;   // PRESENT: vsyncs beyond the typical count between new frames
+};
+
+// Continuous frame-pacing analysis. Each stream keeps Welford mean/variance
+// of its intervals and the median of the last kWindow as the typical
+// interval; an interval over 1.5x that is a jank. While running, a looper
+// thread follows AChoreographer vsync callbacks, so PRESENT intervals are
+// also counted in vsyncs: more vsyncs between two new frames than the recent
+// median is a jank on the display's own clock, whatever the camera rate.
+// Hooks are no-ops unless started.
+class FramePacing {
+public:
+    static const int kWindow = 16;
+
+    ~FramePacing();
+
+    void start();
+    void stop();
+    bool isRunning() const { return enabled.load(std::memory_order_acquire); }
+
+    void onIngest(int64_t timestampNs);
+    void onPublish(int64_t timestampNs);
+    // sequence: published sequence of the frame drawn (0 = none)
+    void onPresent(int64_t timestampNs, uint64_t sequence);
+
+    PacingStats stats(PacingStream stream) const;
+    double vsyncPeriodMs() const;   // 0 until vsyncs arrive
+    uint64_t vsyncCount() const { return vsyncs.load(std::memory_order_relaxed); }
+    void reset();
+
+private:
+    struct Tracker {
+        int64_t lastNs = 0;
+        uint64_t count = 0;
+        double mean = 0.0;       // ms
+        double m2 = 0.0;
+        double max = 0.0;
+        double window[kWindow] = {};
+        uint64_t janks = 0;
+        // PRESENT only
+        uint64_t lastSequence = 0;
+        uint64_t lastVsync = 0;
+        uint32_t vsyncWindow[kWindow] = {};
+        uint64_t vsyncIntervals = 0;
+        uint64_t repeats = 0;
+        uint64_t missedVsyncs = 0;
+    };
+
+    static void onVsync(int64_t frameTimeNanos, void* data);
+    static void onVsync32(long frameTimeNanos, void* data);
+    // judgeByTime: janks from the interval (PRESENT without vsync counts)
+    void record(Tracker& tracker, int64_t timestampNs, bool judgeByTime);
+    void recordVsync(int64_t frameTimeNanos);
+    bool postVsyncCallback();
+    void vsyncLoop();
+
+    mutable std::mutex mutex;
+    Tracker trackers[static_cast<int>(PacingStream::COUNT)];
+
+    std::atomic<bool> enabled{false};
+    std::atomic<bool> stopping{false};
+    std::thread vsyncThread;
+    ALooper* looper = nullptr;             // the vsync thread's, while running
+    std::atomic<uint64_t> vsyncs{0};
+    std::atomic<int64_t> lastVsyncNs{0};
+    std::atomic<int64_t> vsyncPeriodNs{0}; // smoothed
+};
+
+FramePacing& framePacing();
+
+#endif // EDGE_FRAME_PACING_H
@@ -0,0 +1,142 @@
+#include "frame_pool.h"
+#include "memory_accounting.h"
+#include <algorithm>
+
+#define LOG_TAG "FramePool"
+#include "logging.h"
+
+// Enough for the three triple-buffer slots (raw, gray, edges each) plus the
+// intermediates of the frame currently being processed, its pyramid levels
+// (pyramid_cache.h), the tracker's previous pyramid and a full frame history
+// (frame_history.h: luma and edges of FrameHistory::kMaxDepth frames)
+static const size_t kDefaultPoolCapacity = 48;
+
+FramePool::FramePool(size_t capacity) : capacity(capacity) {
+    buffers.reserve(capacity);
+}
+
+bool FramePool::isIdle(const cv::Mat& buffer) {
+    // Atomic read of the shared refcount: 1 means only the pool references it
+    return buffer.u && CV_XADD(&buffer.u->refcount, 0) == 1;
+}
+
+bool FramePool::isRetired(const cv::Mat& buffer) const {
+    return std::find(retired.begin(), retired.end(), cv::Vec3i(buffer.rows, buffer.cols, buffer.type())) !=
+           retired.end();
+}
+
+template <typename Pred>
+void FramePool::dropLocked(Pred pred) {
+    MemoryBudget& budget = memoryBudget();
+    buffers.erase(std::remove_if(buffers.begin(), buffers.end(), [&](const Pooled& pooled) {
+        if (!pred(pooled.buffer)) {
+            return false;
+        }
+        budget.release(pooled.client, bytesOf(pooled.buffer));
+        return true;
+    }), buffers.end());
+}
+
+void FramePool::dropRetiredLocked() {
+    dropLocked([this](const cv::Mat& buffer) { return isIdle(buffer) && isRetired(buffer); });
+    // Once none is left, the geometries need no checking any more
+    if (std::none_of(buffers.begin(), buffers.end(),
+                     [this](const Pooled& pooled) { return isRetired(pooled.buffer); })) {
+        retired.clear();
+    }
+}
+
+cv::Mat FramePool::acquire(int rows, int cols, int type, MemoryClient client) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!retired.empty()) {
+        retired.erase(std::remove(retired.begin(), retired.end(), cv::Vec3i(rows, cols, type)), retired.end());
+        dropRetiredLocked();
+    }
+
+    int idleOtherSize = -1;
+    for (size_t i = 0; i < buffers.size(); i++) {
+        cv::Mat& buffer = buffers[i].buffer;
+        if (!isIdle(buffer)) {
+            continue;
+        }
+        if (buffer.rows == rows && buffer.cols == cols && buffer.type() == type) {
+            return buffer;
+        }
+        idleOtherSize = static_cast<int>(i);
+    }
+
+    misses++;
+    MemoryBudget& budget = memoryBudget();
+    const int64_t bytes = static_cast<int64_t>(rows) * cols * CV_ELEM_SIZE(type);
+    bool reserved = budget.reserve(client, bytes);
+    if (!reserved && idleOtherSize >= 0) {
+        // Over the budget: the idle buffers go before anything new is kept
+        dropLocked(isIdle);
+        idleOtherSize = -1;
+        reserved = budget.reserve(client, bytes);
+    }
+    // Pooled buffers outlive any frame: never from a frame arena
+    cv::Mat fresh;
+    fresh.allocator = heapMatAllocator();
+    fresh.create(rows, cols, type);
+    if (!reserved) {
+        LOGW_RATELIMITED("Memory budget exhausted, handing out unpooled %dx%d buffer", cols, rows);
+    } else if (buffers.size() < capacity) {
+        buffers.push_back({fresh, client});
+    } else if (idleOtherSize >= 0) {
+        // Resolution change: recycle the slot of a buffer nobody uses anymore
+        Pooled& slot = buffers[static_cast<size_t>(idleOtherSize)];
+        budget.release(slot.client, bytesOf(slot.buffer));
+        slot = {fresh, client};
+    } else {
+        budget.release(client, bytes);
+        LOGW_RATELIMITED("Pool exhausted (%zu buffers), handing out untracked %dx%d buffer",
+             buffers.size(), cols, rows);
+    }
+    return fresh;
+}
+
+cv::Mat FramePool::copyOf(const cv::Mat& src) {
+    cv::Mat dst = acquire(src.rows, src.cols, src.type());
+    src.copyTo(dst);
+    return dst;
+}
+
+void FramePool::retire(int rows, int cols, int type) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const cv::Vec3i geometry(rows, cols, type);
+    if (std::find(retired.begin(), retired.end(), geometry) == retired.end()) {
+        retired.push_back(geometry);
+    }
+    dropRetiredLocked();
+}
+
+void FramePool::trim() {
+    std::lock_guard<std::mutex> lock(mutex);
+    dropLocked(isIdle);
+}
+
+void FramePool::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    dropLocked([](const cv::Mat&) { return true; });
+    retired.clear();
+}
+
+size_t FramePool::bufferCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return buffers.size();
+}
+
+size_t FramePool::bytesHeld() {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t total = 0;
+    for (const Pooled& pooled : buffers) {
+        total += static_cast<size_t>(bytesOf(pooled.buffer));
+    }
+    return total;
+}
+
+FramePool& framePool() {
+    static FramePool pool(kDefaultPoolCapacity);
+    return pool;
+}
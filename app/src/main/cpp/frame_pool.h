@@ -0,0 +1,67 @@
+#ifndef EDGE_FRAME_POOL_H
+#define EDGE_FRAME_POOL_H
+
+#include "memory_budget.h"
+#include <opencv2/core.hpp>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+// Fixed-capacity pool of recycled frame buffers keyed by geometry (rows, cols, type).
+// The pool keeps one reference to every buffer it owns; a buffer is free again as
+// soon as every Mat handed out for it has been released (refcount back to 1), so
+// published frames can be shared by header instead of cloned. In steady state
+// acquire() performs no heap allocation. Every pooled buffer is reserved
+// against the memory budget (memory_budget.h) while the pool holds it.
+class FramePool {
+public:
+    explicit FramePool(size_t capacity);
+
+    // Returns a Mat backed by a free pooled buffer of the requested geometry,
+    // allocating (or replacing an idle buffer of another size) only on a miss.
+    // Contents are undefined. A miss the memory budget refuses drops the idle
+    // buffers first; still refused, the buffer is handed out unpooled and
+    // freed with its last reference. client is whom the budget charges.
+    cv::Mat acquire(int rows, int cols, int type, MemoryClient client = MemoryClient::FRAME_POOL);
+
+    // Copies src into a pooled buffer (replacement for src.clone())
+    cv::Mat copyOf(const cv::Mat& src);
+
+    // Buffers of this geometry are freed as they go idle instead of being
+    // reused (a resolution switch retiring the old size); acquiring the
+    // geometry again lifts it
+    void retire(int rows, int cols, int type);
+
+    // Drops every buffer not currently referenced outside the pool
+    void trim();
+    void clear();
+
+    size_t bufferCount();
+    size_t bytesHeld();
+    size_t missCount() const { return misses; }
+
+private:
+    struct Pooled {
+        cv::Mat buffer;
+        MemoryClient client;
+    };
+
+    static bool isIdle(const cv::Mat& buffer);
+    static int64_t bytesOf(const cv::Mat& buffer) { return static_cast<int64_t>(buffer.total() * buffer.elemSize()); }
+    bool isRetired(const cv::Mat& buffer) const;
+    void dropRetiredLocked();
+    // Removes the buffers pred selects, releasing their reservations
+    template <typename Pred>
+    void dropLocked(Pred pred);
+
+    std::mutex mutex;
+    std::vector<Pooled> buffers;
+    std::vector<cv::Vec3i> retired;  // (rows, cols, type)
+    size_t capacity;
+    size_t misses = 0;
+};
+
+// Process-wide pool used by the preview pipeline
+FramePool& framePool();
+
+#endif // EDGE_FRAME_POOL_H
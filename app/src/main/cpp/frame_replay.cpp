@@ -0,0 +1,140 @@
+#include "frame_replay.h"
+#include "frame_capture.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+
+#define LOG_TAG "FrameReplay"
+#include "logging.h"
+
+FrameReplay::~FrameReplay() {
+    unload();
+}
+
+bool FrameReplay::load(const char* path, int width, int height, int rotation) {
+    unload();
+    int fd = path ? open(path, O_RDONLY | O_CLOEXEC) : -1;
+    if (fd < 0) {
+        LOGE("❌ Cannot open replay file %s: %s", path ? path : "(null)", strerror(errno));
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        close(fd);
+        return false;
+    }
+    void* mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        LOGE("❌ mmap of %s failed: %s", path, strerror(errno));
+        return false;
+    }
+    mapping = static_cast<uint8_t*>(mapped);
+    mappingBytes = static_cast<size_t>(info.st_size);
+
+    bool indexed = mappingBytes >= kCaptureHeaderBytes && std::memcmp(mapping, "EDGECAP", 8) == 0
+                   ? indexCapture()
+                   : indexRaw(width, height, rotation);
+    if (!indexed || frames.empty()) {
+        LOGE("❌ No frames in replay file %s", path);
+        unload();
+        return false;
+    }
+    LOGI("✅ Replay: %zu frames of %dx%d from %s", frames.size(), frames[0].width, frames[0].height, path);
+    return true;
+}
+
+void FrameReplay::unload() {
+    frames.clear();
+    if (mapping) {
+        munmap(mapping, mappingBytes);
+        mapping = nullptr;
+    }
+    mappingBytes = 0;
+}
+
+bool FrameReplay::indexCapture() {
+    CaptureFileHeader header;
+    std::memcpy(&header, mapping, sizeof(header));
+    if (header.slotBytes < sizeof(CaptureSlotHeader) ||
+        kCaptureHeaderBytes + static_cast<size_t>(header.slotCount) * header.slotBytes > mappingBytes) {
+        LOGE("❌ Truncated or unknown capture file (version %u)", header.version);
+        return false;
+    }
+    std::vector<std::pair<uint64_t, ReplayFrame>> ordered;
+    for (uint32_t i = 0; i < header.slotCount; i++) {
+        const uint8_t* slot = mapping + kCaptureHeaderBytes + static_cast<size_t>(i) * header.slotBytes;
+        CaptureSlotHeader slotHeader;
+        std::memcpy(&slotHeader, slot, sizeof(slotHeader));
+        const size_t expected = static_cast<size_t>(slotHeader.width) * (slotHeader.height + slotHeader.height / 2);
+        if (slotHeader.sequence == 0 || slotHeader.width <= 0 || slotHeader.height <= 0 ||
+            slotHeader.frameBytes != expected || expected > header.slotBytes - sizeof(CaptureSlotHeader)) {
+            continue;  // empty, or torn by a crash mid-write
+        }
+        ReplayFrame frame;
+        frame.nv21 = slot + sizeof(CaptureSlotHeader);
+        frame.width = slotHeader.width;
+        frame.height = slotHeader.height;
+        frame.rotation = slotHeader.rotation;
+        frame.timestampNs = slotHeader.timestampNs;
+        ordered.emplace_back(slotHeader.sequence, frame);
+    }
+    std::sort(ordered.begin(), ordered.end(),
+              [](const std::pair<uint64_t, ReplayFrame>& a, const std::pair<uint64_t, ReplayFrame>& b) {
+                  return a.first < b.first;
+              });
+    for (const auto& entry : ordered) {
+        frames.push_back(entry.second);
+    }
+    return true;
+}
+
+bool FrameReplay::indexRaw(int width, int height, int rotation) {
+    if (width <= 0 || height <= 0) {
+        return false;
+    }
+    const size_t frameBytes = static_cast<size_t>(width) * (height + height / 2);
+    for (size_t offset = 0; offset + frameBytes <= mappingBytes; offset += frameBytes) {
+        ReplayFrame frame;
+        frame.nv21 = mapping + offset;
+        frame.width = width;
+        frame.height = height;
+        frame.rotation = rotation;
+        frames.push_back(frame);
+    }
+    return true;
+}
+
+ReplayReport FrameReplay::run(const Sink& sink, ReplayPacing pacing, int loops) const {
+    ReplayReport report;
+    const auto start = std::chrono::steady_clock::now();
+    auto due = start;
+    for (int loop = 0; loop < loops; loop++) {
+        for (size_t i = 0; i < frames.size(); i++) {
+            if (pacing == ReplayPacing::ORIGINAL) {
+                if (i > 0 || loop > 0) {
+                    int64_t gap = kRawFrameIntervalNs;
+                    if (i > 0 && frames[i].timestampNs > 0 && frames[i - 1].timestampNs > 0) {
+                        // Captures may skip frames; a gap over a second is a pause, not timing
+                        gap = std::min<int64_t>(frames[i].timestampNs - frames[i - 1].timestampNs, 1000000000);
+                        gap = std::max<int64_t>(gap, 0);
+                    }
+                    due += std::chrono::nanoseconds(gap);
+                }
+                std::this_thread::sleep_until(due);
+            }
+            sink(frames[i]);
+            report.frames++;
+        }
+    }
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    report.framesPerSecond = report.seconds > 0.0 ? report.frames / report.seconds : 0.0;
+    return report;
+}
@@ -0,0 +1,62 @@
+#ifndef EDGE_FRAME_REPLAY_H
+#define EDGE_FRAME_REPLAY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// One recorded frame, pointing into the replay mapping
+struct ReplayFrame {
+    const uint8_t* nv21 = nullptr;
+    int width = 0;
+    int height = 0;
+    int rotation = 0;
+    int64_t timestampNs = 0;   // as recorded; 0 when the file has no timing
+};
+
+enum class ReplayPacing : int {
+    MAX_SPEED = 0,   // next frame as soon as the previous one returned
+    ORIGINAL = 1,    // the recorded inter-frame gaps (kRawFrameIntervalNs for raw files)
+};
+
+struct ReplayReport {
+    int frames = 0;          // frames handed to the sink
+    double seconds = 0.0;    // wall time of the run
+    double framesPerSecond = 0.0;
+};
+
+// Deterministic input for benchmarks: frames recorded by the capture ring
+// (frame_capture.h) or a raw file of back-to-back NV21 frames, replayed on
+// the calling thread into the same sink as live frames. The file is mapped
+// copy-on-write, so loading costs no read and the sink may treat the frames
+// as writable.
+class FrameReplay {
+public:
+    using Sink = std::function<void(const ReplayFrame&)>;
+
+    static const int64_t kRawFrameIntervalNs = 33333333;  // 30 fps
+
+    ~FrameReplay();
+
+    // Ring captures are recognised by their header and replayed oldest first;
+    // anything else is cut into width x height NV21 frames with the given
+    // rotation. False if the file cannot be mapped or holds no frame.
+    bool load(const char* path, int width, int height, int rotation);
+    void unload();
+
+    size_t frameCount() const { return frames.size(); }
+
+    // Feeds every frame `loops` times
+    ReplayReport run(const Sink& sink, ReplayPacing pacing, int loops) const;
+
+private:
+    bool indexCapture();
+    bool indexRaw(int width, int height, int rotation);
+
+    uint8_t* mapping = nullptr;
+    size_t mappingBytes = 0;
+    std::vector<ReplayFrame> frames;
+};
+
+#endif // EDGE_FRAME_REPLAY_H
@@ -0,0 +1,118 @@
+#include "frame_telemetry.h"
+#include "metrics.h"
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <mutex>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define LOG_TAG "FrameTelemetry"
+#include "logging.h"
+
+namespace {
+
+static_assert(sizeof(TelemetryRecord) == 320, "TelemetryRecord is the file layout");
+static_assert(sizeof(TelemetryFileHeader) <= kTelemetryHeaderBytes, "header fits its page");
+static_assert(static_cast<int>(Stage::COUNT) <= kTelemetryMaxStages, "every stage has a record slot");
+
+std::mutex telemetryMutex;        // append vs start/stop; uncontended per frame
+std::atomic<bool> active{false};  // cheap check before taking the mutex
+uint8_t* mapping = nullptr;
+size_t mappingBytes = 0;
+uint32_t recordCount = 0;
+uint64_t nextSequence = 1;
+
+// telemetryMutex held
+void unmap() {
+    if (mapping) {
+        msync(mapping, mappingBytes, MS_ASYNC);
+        munmap(mapping, mappingBytes);
+        mapping = nullptr;
+    }
+    mappingBytes = 0;
+}
+
+} // namespace
+
+bool startFrameTelemetry(const char* path, int records) {
+    std::lock_guard<std::mutex> lock(telemetryMutex);
+    active.store(false);
+    unmap();
+    if (!path || records <= 0) {
+        return false;
+    }
+
+    const size_t total = kTelemetryHeaderBytes + sizeof(TelemetryRecord) * static_cast<size_t>(records);
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        LOGE("❌ Cannot open telemetry file %s: %s", path, strerror(errno));
+        return false;
+    }
+    // Allocated up front: a sparse file could SIGBUS on a full disk mid-copy
+    int error = posix_fallocate(fd, 0, static_cast<off_t>(total));
+    if (error != 0) {
+        LOGE("❌ Cannot allocate %zu bytes for %s: %s", total, path, strerror(error));
+        close(fd);
+        return false;
+    }
+    void* mapped = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);  // the mapping keeps the file
+    if (mapped == MAP_FAILED) {
+        LOGE("❌ mmap of %s failed: %s", path, strerror(errno));
+        return false;
+    }
+
+    mapping = static_cast<uint8_t*>(mapped);
+    mappingBytes = total;
+    recordCount = static_cast<uint32_t>(records);
+    nextSequence = 1;
+
+    TelemetryFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, "EDGETLM", 8);
+    header.version = kTelemetryVersion;
+    header.recordCount = recordCount;
+    header.recordBytes = sizeof(TelemetryRecord);
+    header.stageCount = static_cast<uint32_t>(Stage::COUNT);
+    for (int i = 0; i < static_cast<int>(Stage::COUNT); i++) {
+        std::strncpy(header.stageNames[i], stageName(static_cast<Stage>(i)), kTelemetryStageNameBytes - 1);
+    }
+    std::memcpy(mapping, &header, sizeof(header));
+    active.store(true);
+    LOGI("✅ Frame telemetry: %d records in %s (%zu KB)", records, path, total >> 10);
+    return true;
+}
+
+void stopFrameTelemetry() {
+    std::lock_guard<std::mutex> lock(telemetryMutex);
+    active.store(false);
+    unmap();
+}
+
+bool frameTelemetryActive() {
+    return active.load(std::memory_order_relaxed);
+}
+
+void appendTelemetry(TelemetryRecord& record) {
+    if (!active.load(std::memory_order_relaxed)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(telemetryMutex);
+    if (!mapping) {
+        return;
+    }
+    const uint64_t sequence = nextSequence++;
+    auto* slot = reinterpret_cast<TelemetryRecord*>(
+            mapping + kTelemetryHeaderBytes + (sequence - 1) % recordCount * sizeof(TelemetryRecord));
+
+    // Same ordering as captureFrame: invalidate, copy, then publish the sequence
+    slot->sequence = 0;
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    record.sequence = 0;
+    std::memcpy(slot, &record, sizeof(record));
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+    slot->sequence = sequence;
+    record.sequence = sequence;
+}
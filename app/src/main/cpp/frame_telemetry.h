@@ -0,0 +1,69 @@
+#ifndef EDGE_FRAME_TELEMETRY_H
+#define EDGE_FRAME_TELEMETRY_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Per-frame telemetry as fixed-layout binary records in a ring file that is
+// mmap'ed MAP_SHARED, the layout of frame_capture.h without the pixels.
+// Appending is one small struct copy, with no string formatting, so it runs
+// at full frame rate where a LOGI per frame would not; decode the file on the
+// host with tools/telemetry_dump.cpp (CSV on stdout).
+//
+// Layout (little-endian): a kTelemetryHeaderBytes header (TelemetryFileHeader),
+// then recordCount records of recordBytes each. Records are reused
+// round-robin; order them by sequence, 0 = empty or interrupted mid-write.
+// Version 2 widened stageMicros from 32 to 64 entries
+const uint32_t kTelemetryVersion = 2;
+const int kTelemetryMaxStages = 64;
+const int kTelemetryStageNameBytes = 24;
+
+struct TelemetryFileHeader {
+    char magic[8];           // "EDGETLM\0"
+    uint32_t version;        // kTelemetryVersion
+    uint32_t recordCount;
+    uint32_t recordBytes;    // sizeof(TelemetryRecord)
+    uint32_t stageCount;     // stageMicros entries in use
+    // Name of each stageMicros entry (metrics.h stageName), NUL-padded, so the
+    // decoder needs no rebuild when stages are added
+    char stageNames[kTelemetryMaxStages][kTelemetryStageNameBytes];
+};
+
+struct TelemetryRecord {
+    uint64_t sequence;            // 1-based; written last
+    int64_t captureTimestampNs;   // CLOCK_BOOTTIME
+    int64_t publishTimestampNs;   // CLOCK_BOOTTIME
+    int32_t renderMode;
+    uint16_t width;               // camera frame
+    uint16_t height;
+    int16_t cannyLow;             // thresholds after this frame (adaptive:
+    int16_t cannyHigh;            // derived from it)
+    int16_t lumaMedian;           // -1 without luma statistics
+    uint16_t reserved;
+    float lumaMean;
+    float lumaSharpness;
+    // Process-wide counters (metrics.h) when the frame was published
+    uint32_t framesProcessed;
+    uint32_t framesDropped;
+    uint32_t framesStale;
+    uint32_t framesGovernorSkipped;
+    // Microseconds this frame spent in each stage, indexed like Stage
+    uint32_t stageMicros[kTelemetryMaxStages];
+};
+
+const size_t kTelemetryHeaderBytes = 4096;
+
+// Creates (or replaces) the ring file with room for recordCount frames.
+// False if it cannot be sized or mapped.
+bool startFrameTelemetry(const char* path, int recordCount);
+
+// Unmaps and closes the file; the records stay in it
+void stopFrameTelemetry();
+
+bool frameTelemetryActive();
+
+// Copies record into the next slot, assigning its sequence; a no-op unless
+// started
+void appendTelemetry(TelemetryRecord& record);
+
+#endif // EDGE_FRAME_TELEMETRY_H
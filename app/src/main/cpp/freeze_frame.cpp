@@ -0,0 +1,135 @@
+#include "freeze_frame.h"
+#include "canny_kernel.h"
+#include "image_processor.h"
+#include <algorithm>
+#include <cstring>
+
+#define LOG_TAG "FreezeFrame"
+#include "logging.h"
+
+namespace {
+
+const uint64_t kHashMultiplier = 0x9e3779b97f4a7c15ULL;
+
+// Key of the MAXIMA stage: every pixel of gray, eight at a time, its size
+// and the pre-blur. Much cheaper than the gradient pass it stands for.
+uint64_t maximaKeyOf(const cv::Mat& gray, bool preBlur) {
+    uint64_t hash = (static_cast<uint64_t>(gray.cols) << 32 | static_cast<uint32_t>(gray.rows)) * 2 + preBlur;
+    for (int y = 0; y < gray.rows; y++) {
+        const uchar* row = gray.ptr<uchar>(y);
+        int x = 0;
+        for (; x + 8 <= gray.cols; x += 8) {
+            uint64_t word;
+            std::memcpy(&word, row + x, sizeof(word));
+            hash = (hash ^ word) * kHashMultiplier;
+            hash ^= hash >> 29;
+        }
+        for (; x < gray.cols; x++) {
+            hash = (hash ^ row[x]) * kHashMultiplier;
+        }
+    }
+    return hash;
+}
+
+}  // namespace
+
+void FreezeFrame::setFrozen(bool frozen) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (active.load(std::memory_order_relaxed) == frozen) {
+        return;
+    }
+    releaseLocked();
+    active.store(frozen, std::memory_order_relaxed);
+    LOGI("🔄 Freeze frame %s", frozen ? "armed" : "released");
+}
+
+void FreezeFrame::releaseLocked() {
+    // The pipeline may still reference the held frame: drop ours, never
+    // write into it
+    held.release();
+    published = false;
+    maxima.release();
+    maximaKey = 0;
+    cachedEdges.release();
+    edgesGeneration = 0;
+}
+
+FreezeFrame::Admission FreezeFrame::admit(const cv::Mat& luma, const cv::Mat& vu, uint64_t settings, cv::Mat& nv21,
+                                          cv::Size& size, int& rotation) {
+    if (!active.load(std::memory_order_relaxed)) {
+        return CAMERA;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!active.load(std::memory_order_relaxed)) {
+        return CAMERA;
+    }
+    if (held.empty()) {
+        if (luma.empty() || luma.type() != CV_8UC1) {
+            return CAMERA;
+        }
+        // Packed NV21 as nv21IngestFrame reads it; a frame without an
+        // interleaved VU plane is held as gray
+        heldSize = luma.size();
+        const int chromaRows = heldSize.height / 2;
+        held = cv::Mat(heldSize.height + chromaRows, heldSize.width, CV_8UC1);
+        luma.copyTo(held.rowRange(0, heldSize.height));
+        cv::Mat heldVu(chromaRows, heldSize.width / 2, CV_8UC2, held.ptr(heldSize.height), heldSize.width);
+        if (vu.type() == CV_8UC2 && vu.rows >= heldVu.rows && vu.cols >= heldVu.cols) {
+            vu(cv::Rect(0, 0, heldVu.cols, heldVu.rows)).copyTo(heldVu);
+        } else {
+            held.rowRange(heldSize.height, held.rows).setTo(128);
+        }
+        heldRotation = rotation;
+        published = false;
+        LOGI("🔄 Freeze frame holds a %dx%d frame", heldSize.width, heldSize.height);
+    }
+    if (published && settings == publishedSettings) {
+        drops.fetch_add(1, std::memory_order_relaxed);
+        return DROP;
+    }
+    published = true;
+    publishedSettings = settings;
+    publishes.fetch_add(1, std::memory_order_relaxed);
+    nv21 = held;
+    size = heldSize;
+    rotation = heldRotation;
+    return HELD;
+}
+
+bool FreezeFrame::edges(const cv::Mat& gray, cv::Mat& edges) {
+    if (!active.load(std::memory_order_relaxed) || gray.type() != CV_8UC1 || gray.empty()) {
+        return false;
+    }
+    int low = 0;
+    int high = 0;
+    currentCannyThresholds(low, high);
+    const bool preBlur = edgePreBlurEnabled();
+    const bool tiled = activeCannyBackend() == CannyBackend::TILED;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const uint64_t key = maximaKeyOf(gray, preBlur);
+        if (maxima.empty() || key != maximaKey) {
+            cannyU8Maxima(gray, maxima, preBlur, tiled);
+            maximaKey = key;
+            maximaGeneration++;
+            maximaRuns.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (edgesGeneration == maximaGeneration && edgesLow == low && edgesHigh == high) {
+            reuses.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            cannyU8FromMaxima(maxima, cachedEdges, low, high, tiled);
+            edgesGeneration = maximaGeneration;
+            edgesLow = low;
+            edgesHigh = high;
+            hysteresisRuns.fetch_add(1, std::memory_order_relaxed);
+        }
+        cachedEdges.copyTo(edges);  // the caller's pooled buffer, which the frame publishes
+    }
+    updateEdgeThresholds(gray);
+    return true;
+}
+
+FreezeFrame& freezeFrame() {
+    static FreezeFrame freeze;
+    return freeze;
+}
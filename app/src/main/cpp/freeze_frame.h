@@ -0,0 +1,86 @@
+#ifndef EDGE_FREEZE_FRAME_H
+#define EDGE_FREEZE_FRAME_H
+
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+// Freeze-frame tuning for the default pipeline. While frozen, one camera
+// frame is held and processed in place of the camera's, and only when a
+// setting changed since it was last published; camera frames in between are
+// dropped. Canny on the held frame is split into stages, each cached with
+// the inputs it depends on:
+//   MAXIMA  gradient and non-max suppression (cannyU8Maxima): the gray
+//           content and the pre-blur
+//   EDGES   thresholds and hysteresis (cannyU8FromMaxima): the maxima and
+//           the two thresholds
+// so a threshold slider reruns hysteresis alone, at any frame size, and
+// toggling back to seen thresholds reruns nothing. The gray is keyed by a
+// hash of its pixels rather than by the held frame, since ROI, scale and
+// the filters before Canny change it as well.
+class FreezeFrame {
+public:
+    enum Admission {
+        CAMERA,  // not frozen: process the camera frame
+        HELD,    // process the held frame instead
+        DROP,    // the held frame is published with these settings already
+    };
+
+    // true: the next camera frame offered is held; false: back to the camera
+    void setFrozen(bool frozen);
+    bool frozen() const { return active.load(std::memory_order_relaxed); }
+
+    // Ingest side, once per camera frame, after the control values are
+    // applied. luma and vu are the camera frame (vu empty: held as gray);
+    // settings is any value that changes with the settings a republish
+    // should follow; rotation comes in as the camera frame's. On HELD, nv21
+    // is the packed held frame (size.height + size.height / 2 rows, never
+    // written afterwards) and rotation the one it was held with.
+    Admission admit(const cv::Mat& luma, const cv::Mat& vu, uint64_t settings, cv::Mat& nv21, cv::Size& size,
+                    int& rotation);
+
+    // Processing thread: edges of gray with the current thresholds and
+    // pre-blur from the stage caches, feeding the adaptive thresholds like
+    // detectEdges; false when not frozen
+    bool edges(const cv::Mat& gray, cv::Mat& edges);
+
+    uint64_t publishCount() const { return publishes.load(std::memory_order_relaxed); }
+    uint64_t dropCount() const { return drops.load(std::memory_order_relaxed); }
+    uint64_t maximaRunCount() const { return maximaRuns.load(std::memory_order_relaxed); }
+    uint64_t hysteresisRunCount() const { return hysteresisRuns.load(std::memory_order_relaxed); }
+    uint64_t reuseCount() const { return reuses.load(std::memory_order_relaxed); }
+
+private:
+    void releaseLocked();
+
+    std::atomic<bool> active{false};
+
+    std::mutex mutex;
+    cv::Mat held;                  // packed NV21, empty until a frame is offered
+    cv::Size heldSize;
+    int heldRotation = 0;
+    bool published = false;
+    uint64_t publishedSettings = 0;
+
+    // MAXIMA stage: key of the gray it came from, bumped generation per run
+    cv::Mat maxima;
+    uint64_t maximaKey = 0;
+    uint64_t maximaGeneration = 0;
+
+    // EDGES stage
+    cv::Mat cachedEdges;
+    uint64_t edgesGeneration = 0;  // maximaGeneration it came from; 0 = none
+    int edgesLow = -1;
+    int edgesHigh = -1;
+
+    std::atomic<uint64_t> publishes{0};
+    std::atomic<uint64_t> drops{0};
+    std::atomic<uint64_t> maximaRuns{0};
+    std::atomic<uint64_t> hysteresisRuns{0};
+    std::atomic<uint64_t> reuses{0};
+};
+
+FreezeFrame& freezeFrame();
+
+#endif // EDGE_FREEZE_FRAME_H
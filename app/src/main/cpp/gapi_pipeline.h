@@ -0,0 +1,50 @@
+#ifndef EDGE_GAPI_PIPELINE_H
+#define EDGE_GAPI_PIPELINE_H
+
+#include <opencv2/core.hpp>
+#include <opencv2/gapi/gcompiled.hpp>
+#include <mutex>
+
+// Luma -> 5x5 Gaussian blur -> Canny as a G-API graph. Blur and the Sobel
+// pair run as one Fluid island, line by line, so the blurred frame never
+// round-trips through memory; non-max suppression and hysteresis (no Fluid
+// kernel) are cv::Canny on the resulting derivatives, with the thresholds of
+// detectEdges. The graph is compiled once per input size and type.
+class GapiEdgePipeline {
+public:
+    // edges becomes CV_8UC1; false (logged) when G-API could not compile or
+    // run. Does not feed the adaptive thresholds (see updateEdgeThresholds).
+    // gradX / gradY, when given, receive the CV_16SC1 Sobel derivatives Canny
+    // ran on (of the blurred luma) in the caller's buffers, which the next
+    // run does not overwrite.
+    bool run(const cv::Mat& luma, cv::Mat& edges, cv::Mat* gradX = nullptr, cv::Mat* gradY = nullptr);
+    // Drops the compiled graph and scratch; the next run compiles afresh
+    void reset();
+
+private:
+    void compile(const cv::Mat& luma);
+
+    std::mutex mutex;
+    cv::GCompiled compiled;
+    cv::Size compiledSize;
+    int compiledType = -1;
+    cv::Mat dx;   // CV_16SC1 derivatives, reused across frames
+    cv::Mat dy;
+};
+
+// Pipeline used when nativeSetGapiPipeline is on
+GapiEdgePipeline& gapiEdgePipeline();
+
+// The same blur -> Canny with eager cv:: calls (full-frame intermediates)
+void eagerBlurCanny(const cv::Mat& luma, cv::Mat& edges);
+
+struct GapiBenchmarkResult {
+    double eagerMillis = 0;    // median over the iterations
+    double gapiMillis = 0;
+    double differingFraction = 0;  // share of edge pixels the two disagree on
+};
+
+// Times both paths on the same synthetic width x height scene
+GapiBenchmarkResult benchmarkGapiPipeline(int width, int height, int iterations);
+
+#endif // EDGE_GAPI_PIPELINE_H
@@ -0,0 +1,256 @@
+#include "gapi_streaming.h"
+#include "frame_pool.h"
+#include "image_processor.h"
+#include "metrics.h"
+#include "thread_policy.h"
+#include <opencv2/imgproc.hpp>
+#include <opencv2/gapi/core.hpp>
+#include <opencv2/gapi/imgproc.hpp>
+#include <opencv2/gapi/fluid/core.hpp>
+#include <opencv2/gapi/fluid/imgproc.hpp>
+#include <opencv2/gapi/streaming/format.hpp>
+#include <opencv2/gapi/streaming/meta.hpp>
+#include <opencv2/gapi/streaming/source.hpp>
+#include <condition_variable>
+#include <deque>
+
+#define LOG_TAG "GapiStreaming"
+#include "logging.h"
+
+namespace {
+
+const int kBlurSize = 5;  // as gapi_pipeline.cpp
+// Per-frame values G-API carries from the source to the outputs
+const char* const kRotationTag = "com.example.edge.rotation";
+const char* const kOfferedTag = "com.example.edge.offered";
+
+} // namespace
+
+// Frames waiting for G-API. pull() blocks until one is offered or the
+// stream is halted, which ends the stream.
+class GapiStreamingPipeline::Source : public cv::gapi::wip::IStreamSource {
+public:
+    explicit Source(const cv::Size& size) : size(size) {}
+
+    // False when nothing was replaced
+    bool push(const cv::Mat& luma, int64_t timestampNs, int rotation) {
+        bool replaced = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (queue.size() >= kQueueDepth) {
+                queue.pop_front();
+                replaced = true;
+            }
+            queue.push_back({luma, timestampNs, rotation, monotonicMicros()});
+        }
+        ready.notify_one();
+        return replaced;
+    }
+
+    bool pull(cv::gapi::wip::Data& data) override {
+        Frame frame;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            ready.wait(lock, [this] { return halted || !queue.empty(); });
+            if (halted) {
+                return false;
+            }
+            frame = std::move(queue.front());
+            queue.pop_front();
+        }
+        data = frame.luma;
+        data.meta[cv::gapi::streaming::meta_tag::timestamp] = cv::util::any(frame.timestampNs);
+        data.meta[cv::gapi::streaming::meta_tag::seq_id] = cv::util::any(sequence++);
+        data.meta[kRotationTag] = cv::util::any(frame.rotation);
+        data.meta[kOfferedTag] = cv::util::any(frame.offeredMicros);
+        return true;
+    }
+
+    cv::GMetaArg descr_of() const override {
+        return cv::GMetaArg(cv::GMatDesc(CV_8U, 1, size));
+    }
+
+    void halt() override {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            halted = true;
+            queue.clear();
+        }
+        ready.notify_all();
+    }
+
+private:
+    struct Frame {
+        cv::Mat luma;
+        int64_t timestampNs = 0;
+        int rotation = 0;
+        int64_t offeredMicros = 0;
+    };
+
+    const cv::Size size;
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<Frame> queue;
+    bool halted = false;
+    int64_t sequence = 0;  // G-API's pulling thread only
+};
+
+GapiStreamingPipeline::~GapiStreamingPipeline() {
+    stop();
+}
+
+void GapiStreamingPipeline::start(Sink next) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (isRunning()) {
+        return;
+    }
+    sink = std::move(next);
+    offered.store(0, std::memory_order_relaxed);
+    dropped.store(0, std::memory_order_relaxed);
+    produced.store(0, std::memory_order_relaxed);
+    compiles.store(0, std::memory_order_relaxed);
+    latencySum.store(0, std::memory_order_relaxed);
+    startedMicros = monotonicMicros();
+    enabled.store(true, std::memory_order_release);
+    LOGI("✅ G-API streaming enabled; the graph compiles at the first frame");
+}
+
+void GapiStreamingPipeline::stop() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!isRunning()) {
+        return;
+    }
+    enabled.store(false, std::memory_order_release);
+    stopStreamLocked();
+    sink = nullptr;
+    LOGI("✅ G-API streaming stopped (offered=%llu, dropped=%llu, produced=%llu)",
+         static_cast<unsigned long long>(offered.load(std::memory_order_relaxed)),
+         static_cast<unsigned long long>(dropped.load(std::memory_order_relaxed)),
+         static_cast<unsigned long long>(produced.load(std::memory_order_relaxed)));
+}
+
+bool GapiStreamingPipeline::startStreamLocked(const cv::Size& size) {
+    cv::GMat in;
+    cv::GMat blurred = cv::gapi::gaussianBlur(in, cv::Size(kBlurSize, kBlurSize), 0, 0, cv::BORDER_REPLICATE);
+    cv::GMat gradX, gradY;
+    std::tie(gradX, gradY) = cv::gapi::SobelXY(blurred, CV_16S, 1, 3, 1, 0, cv::BORDER_REPLICATE);
+    cv::GComputation computation(cv::GIn(in), cv::GOut(gradX, gradY, cv::gapi::copy(in),
+                                                       cv::gapi::streaming::timestamp(in),
+                                                       cv::gapi::streaming::seq_id(in),
+                                                       cv::gapi::streaming::meta<int>(in, kRotationTag),
+                                                       cv::gapi::streaming::meta<int64_t>(in, kOfferedTag)));
+    auto kernels = cv::gapi::combine(cv::gapi::imgproc::fluid::kernels(), cv::gapi::core::fluid::kernels(),
+                                     cv::gapi::streaming::kernels());
+    try {
+        const int64_t compileStart = monotonicMicros();
+        stream = computation.compileStreaming(cv::GMetaArgs{cv::GMetaArg(cv::GMatDesc(CV_8U, 1, size))},
+                                              cv::compile_args(kernels,
+                                                               cv::gapi::streaming::queue_capacity{kQueueDepth}));
+        source = std::make_shared<Source>(size);
+        stream.setSource(cv::gin(std::static_pointer_cast<cv::gapi::wip::IStreamSource>(source)));
+        stream.start();
+        compiles.fetch_add(1, std::memory_order_relaxed);
+        LOGI("G-API stream compiled and started for %dx%d in %.1fms", size.width, size.height,
+             (monotonicMicros() - compileStart) / 1000.0);
+    } catch (const cv::Exception& e) {
+        LOGE("❌ G-API streaming compile failed: %s", e.what());
+        stream = cv::GStreamingCompiled();
+        source.reset();
+        return false;
+    }
+    streamSize = size;
+    puller = std::thread(&GapiStreamingPipeline::pullLoop, this, stream);
+    return true;
+}
+
+void GapiStreamingPipeline::stopStreamLocked() {
+    if (source) {
+        source->halt();  // ends the stream, which ends pullLoop
+    }
+    if (puller.joinable()) {
+        puller.join();
+    }
+    if (stream && stream.running()) {
+        stream.stop();
+    }
+    stream = cv::GStreamingCompiled();
+    source.reset();
+    streamSize = cv::Size();
+}
+
+bool GapiStreamingPipeline::offer(const cv::Mat& luma, int64_t timestampNs, int rotation) {
+    if (!isRunning() || luma.empty() || luma.type() != CV_8UC1) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!isRunning()) {
+        return false;
+    }
+    if (luma.size() != streamSize) {
+        stopStreamLocked();
+        if (!startStreamLocked(luma.size())) {
+            enabled.store(false, std::memory_order_release);  // the caller falls back to its own path
+            return false;
+        }
+    }
+    offered.fetch_add(1, std::memory_order_relaxed);
+    if (source->push(luma, timestampNs, rotation)) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        metrics().increment(Counter::FRAMES_DROPPED);
+    }
+    return true;
+}
+
+void GapiStreamingPipeline::pullLoop(cv::GStreamingCompiled compiled) {
+    setThreadTier(ThreadTier::PROCESSING);
+    cv::Mat dx;
+    cv::Mat dy;
+    try {
+        for (;;) {
+            Result result;
+            int64_t offeredMicros = 0;
+            // A fresh luma header per frame: the sink may keep the last one
+            if (!compiled.pull(cv::gout(dx, dy, result.luma, result.timestampNs, result.sequence, result.rotation,
+                                        offeredMicros))) {
+                break;  // the source was halted
+            }
+            {
+                ScopedStageTimer timer(Stage::CANNY);
+                result.edges = framePool().acquire(dx.rows, dx.cols, CV_8UC1);
+                int low, high;
+                currentCannyThresholds(low, high);
+                cv::Canny(dx, dy, result.edges, low, high);
+            }
+            result.latencyMicros = monotonicMicros() - offeredMicros;
+            latencySum.fetch_add(result.latencyMicros, std::memory_order_relaxed);
+            produced.fetch_add(1, std::memory_order_relaxed);
+            if (sink) {
+                sink(result);
+            }
+        }
+    } catch (const cv::Exception& e) {
+        LOGE("❌ G-API stream failed: %s", e.what());
+    }
+}
+
+GapiStreamingPipeline::Stats GapiStreamingPipeline::stats() const {
+    Stats stats;
+    stats.offered = offered.load(std::memory_order_relaxed);
+    stats.dropped = dropped.load(std::memory_order_relaxed);
+    stats.produced = produced.load(std::memory_order_relaxed);
+    stats.compiles = compiles.load(std::memory_order_relaxed);
+    if (stats.produced > 0) {
+        stats.meanLatencyMicros = latencySum.load(std::memory_order_relaxed) / static_cast<int64_t>(stats.produced);
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    const int64_t elapsed = monotonicMicros() - startedMicros;
+    if (isRunning() && elapsed > 0) {
+        stats.framesPerSecond = stats.produced * 1e6 / static_cast<double>(elapsed);
+    }
+    return stats;
+}
+
+GapiStreamingPipeline& gapiStreamingPipeline() {
+    static GapiStreamingPipeline pipeline;
+    return pipeline;
+}
@@ -0,0 +1,84 @@
+#ifndef EDGE_GAPI_STREAMING_H
+#define EDGE_GAPI_STREAMING_H
+
+#include <opencv2/core.hpp>
+#include <opencv2/gapi/gstreaming.hpp>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// The blur -> Sobel graph of gapi_pipeline.h run by G-API's own streaming
+// executor (GStreamingCompiled) instead of one synchronous call per frame.
+// Ingest offers lumas to an in-process IStreamSource, G-API pulls them and
+// overlaps frames across its islands, and a thread of ours pulls the
+// derivatives, finishes Canny with the current thresholds and hands the
+// edges to the sink. The graph is compiled for the first frame's size and
+// again when the size changes. The source holds kQueueDepth frames; offering
+// to a full one replaces the oldest, so G-API's pace sets the frame rate.
+class GapiStreamingPipeline {
+public:
+    static const size_t kQueueDepth = 2;
+
+    struct Result {
+        cv::Mat luma;    // the frame as offered (a header over the caller's buffer)
+        cv::Mat edges;   // CV_8UC1 from the frame pool
+        int64_t timestampNs = 0;
+        int rotation = 0;
+        int64_t sequence = 0;       // G-API's seq_id, from 0 per compiled stream
+        int64_t latencyMicros = 0;  // offer to edges
+    };
+    using Sink = std::function<void(const Result&)>;
+
+    struct Stats {
+        uint64_t offered = 0;
+        uint64_t dropped = 0;   // replaced in the source before G-API took them
+        uint64_t produced = 0;
+        uint64_t compiles = 0;
+        int64_t meanLatencyMicros = 0;
+        double framesPerSecond = 0.0;  // produced since start
+    };
+
+    ~GapiStreamingPipeline();
+
+    // Takes frames from now on; the sink runs on the pulling thread
+    void start(Sink sink);
+    // Halts the source, drains the stream and joins the pulling thread
+    void stop();
+    bool isRunning() const { return enabled.load(std::memory_order_acquire); }
+
+    // Ingest: queues a CV_8UC1 luma (referenced, not copied; the buffer must
+    // not be rewritten while referenced). False while stopped.
+    bool offer(const cv::Mat& luma, int64_t timestampNs, int rotation);
+
+    Stats stats() const;
+
+private:
+    class Source;
+
+    bool startStreamLocked(const cv::Size& size);
+    void stopStreamLocked();
+    void pullLoop(cv::GStreamingCompiled stream);
+
+    mutable std::mutex mutex;  // start, stop and stream (re)creation
+    Sink sink;
+    std::shared_ptr<Source> source;
+    cv::GStreamingCompiled stream;
+    cv::Size streamSize;
+    std::thread puller;
+    int64_t startedMicros = 0;
+
+    std::atomic<bool> enabled{false};
+    std::atomic<uint64_t> offered{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> produced{0};
+    std::atomic<uint64_t> compiles{0};
+    std::atomic<int64_t> latencySum{0};
+};
+
+// Used when nativeSetGapiStreaming is on
+GapiStreamingPipeline& gapiStreamingPipeline();
+
+#endif // EDGE_GAPI_STREAMING_H
@@ -0,0 +1,172 @@
+#include "gpu_readback.h"
+#include "pbo_uploader.h"
+#include "frame_pool.h"
+#include "memory_accounting.h"
+#include "metrics.h"
+#include "tracing.h"
+#include <opencv2/core.hpp>
+#include <atomic>
+
+#define LOG_TAG "GpuReadback"
+#include "logging.h"
+
+namespace {
+
+// Upper bound for waiting on the read a slot still holds before dropping it
+const GLuint64 kFenceTimeoutNs = 2 * 1000 * 1000;
+
+std::atomic<EdgeReadbackConsumer> readbackConsumer{nullptr};
+std::atomic<EdgeReadbackConsumer> rectifiedConsumer{nullptr};
+
+} // namespace
+
+void setEdgeReadbackConsumer(EdgeReadbackConsumer consumer) {
+    const EdgeReadbackConsumer previous = readbackConsumer.exchange(consumer, std::memory_order_acq_rel);
+    if ((previous != nullptr) != (consumer != nullptr)) {
+        LOGI("🔄 GPU edge readback %s", consumer ? "enabled" : "disabled");
+    }
+}
+
+bool edgeReadbackWanted() {
+    return readbackConsumer.load(std::memory_order_acquire) != nullptr;
+}
+
+void setRectifiedReadbackConsumer(EdgeReadbackConsumer consumer) {
+    const EdgeReadbackConsumer previous = rectifiedConsumer.exchange(consumer, std::memory_order_acq_rel);
+    if ((previous != nullptr) != (consumer != nullptr)) {
+        LOGI("🔄 Rectified region readback %s", consumer ? "enabled" : "disabled");
+    }
+}
+
+bool rectifiedReadbackWanted() {
+    return rectifiedConsumer.load(std::memory_order_acquire) != nullptr;
+}
+
+bool GpuReadback::init() {
+    // Called on surface creation: any previous ring died with the old context
+    active = false;
+    if (!PboUploader::contextSupportsGles3()) {
+        return false;
+    }
+    GLuint buffers[kRingSize];
+    glGenBuffers(kRingSize, buffers);
+    if (glGetError() != GL_NO_ERROR) {
+        LOGE("❌ glGenBuffers failed, no GPU edge readback");
+        return false;
+    }
+    for (int i = 0; i < kRingSize; i++) {
+        slots[i] = Slot();
+        slots[i].buffer = buffers[i];
+    }
+    next = 0;
+    active = true;
+    return true;
+}
+
+void GpuReadback::release() {
+    for (Slot& slot : slots) {
+        if (slot.fence) {
+            glDeleteSync(slot.fence);
+        }
+        if (slot.buffer) {
+            glDeleteBuffers(1, &slot.buffer);
+        }
+        accountGlMemory(-static_cast<int64_t>(slot.capacity));
+        slot = Slot();
+    }
+    next = 0;
+    active = false;
+}
+
+void GpuReadback::queue(GLuint fbo, int width, int height, const ReadbackFrame& frame) {
+    if (!active || width <= 0 || height <= 0) {
+        return;
+    }
+    Slot& slot = slots[next];
+    if (slot.fence && !deliver(slot, kFenceTimeoutNs)) {
+        LOGW_RATELIMITED("⚠️ GPU edge readback still in flight, dropping frame %llu",
+                         static_cast<unsigned long long>(slot.frame.sequence));
+        metrics().increment(Counter::READBACKS_DROPPED);
+        discard(slot);
+    }
+    next = (next + 1) % kRingSize;
+
+    const size_t bytes = static_cast<size_t>(width) * height * 4;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    if (slot.capacity < bytes) {
+        glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+        accountGlMemory(static_cast<int64_t>(bytes) - static_cast<int64_t>(slot.capacity));
+        slot.capacity = bytes;
+    }
+    // Into the bound PBO: the data pointer is an offset, and the call returns
+    // without waiting for the passes that produce the pixels
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.width = width;
+    slot.height = height;
+    slot.frame = frame;
+}
+
+void GpuReadback::poll() {
+    if (!active) {
+        return;
+    }
+    // next is the oldest slot; stop at the first read still in flight so
+    // frames reach the consumer in order
+    for (int i = 0; i < kRingSize; i++) {
+        Slot& slot = slots[(next + i) % kRingSize];
+        if (slot.fence && !deliver(slot, 0)) {
+            break;
+        }
+    }
+}
+
+bool GpuReadback::deliver(Slot& slot, GLuint64 timeoutNs) {
+    const GLenum status = glClientWaitSync(slot.fence, timeoutNs > 0 ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, timeoutNs);
+    if (status == GL_TIMEOUT_EXPIRED) {
+        return false;
+    }
+    if (status == GL_WAIT_FAILED) {
+        LOGE_RATELIMITED("❌ Readback fence wait failed (0x%x)", glGetError());
+        discard(slot);
+        return true;  // nothing left to wait for
+    }
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+
+    const EdgeReadbackConsumer consumer =
+            (channel == Channel::RECTIFIED ? rectifiedConsumer : readbackConsumer).load(std::memory_order_acquire);
+    if (!consumer) {
+        return true;  // unregistered while the read was in flight
+    }
+    ScopedTrace trace("gpu_readback_map");
+    const size_t bytes = static_cast<size_t>(slot.width) * slot.height * 4;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT);
+    if (!mapped) {
+        LOGE_RATELIMITED("❌ glMapBufferRange failed for readback (0x%x)", glGetError());
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        return true;
+    }
+    // The hysteresis and rectify passes write one value to every color channel
+    cv::Mat edges = framePool().acquire(slot.height, slot.width, CV_8UC1);
+    cv::extractChannel(cv::Mat(slot.height, slot.width, CV_8UC4, mapped), edges, 0);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    metrics().increment(Counter::FRAMES_READ_BACK);
+    consumer(edges, slot.frame);
+    return true;
+}
+
+void GpuReadback::discard(Slot& slot) {
+    if (slot.fence) {
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+    }
+}
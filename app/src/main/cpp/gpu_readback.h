@@ -0,0 +1,77 @@
+#ifndef EDGE_GPU_READBACK_H
+#define EDGE_GPU_READBACK_H
+
+#include <GLES3/gl3.h>
+#include <opencv2/core.hpp>
+#include <cstddef>
+#include <cstdint>
+
+// What a read-back edge map was computed from
+struct ReadbackFrame {
+    int rotation = 0;
+    uint64_t sequence = 0;
+    int64_t captureTimestampNs = 0;
+};
+
+// Receives each read-back edge map (CV_8UC1, 0 or 255, frame layout) on the
+// GL thread; the Mat is pooled and the consumer's to keep, so it must only
+// hand it on without blocking
+using EdgeReadbackConsumer = void (*)(const cv::Mat& edges, const ReadbackFrame& frame);
+
+// Any thread; nullptr stops the readback. The renderer only reads back while
+// a consumer is set.
+void setEdgeReadbackConsumer(EdgeReadbackConsumer consumer);
+bool edgeReadbackWanted();
+
+// The same for the DOCUMENT mode's rectified region: the Mat is its luma at
+// the requested output size, upright
+void setRectifiedReadbackConsumer(EdgeReadbackConsumer consumer);
+bool rectifiedReadbackWanted();
+
+// GLES3 asynchronous readback of renderer-computed edges through a ring of
+// pixel pack buffers: queue() issues glReadPixels into a PBO with a fence
+// behind it and returns at once; poll() hands completed reads to the
+// consumer, normally the frame queued two renders earlier, so the GL thread
+// never waits for the GPU. GL thread only.
+class GpuReadback {
+public:
+    // Which consumer the reads go to; both read the red channel
+    enum class Channel { EDGES, RECTIFIED };
+
+    explicit GpuReadback(Channel channel = Channel::EDGES) : channel(channel) {}
+
+    // Allocates the ring; returns false (and stays inactive) on failure or ES2
+    bool init();
+    void release();
+    bool isActive() const { return active; }
+
+    // Reads the RGBA8 color attachment of fbo (width x height) into the next
+    // slot. A slot whose read is still in flight is waited on briefly and
+    // dropped when that is not enough.
+    void queue(GLuint fbo, int width, int height, const ReadbackFrame& frame);
+    // Delivers the reads whose fences have signaled, oldest first
+    void poll();
+
+private:
+    static const int kRingSize = 3;  // frame N-2 is mapped while N-1 and N are in flight
+
+    struct Slot {
+        GLuint buffer = 0;
+        size_t capacity = 0;
+        GLsync fence = nullptr;
+        int width = 0;
+        int height = 0;
+        ReadbackFrame frame;
+    };
+
+    // False while the read is in flight after timeoutNs
+    bool deliver(Slot& slot, GLuint64 timeoutNs);
+    void discard(Slot& slot);
+
+    Channel channel;
+    Slot slots[kRingSize];
+    int next = 0;
+    bool active = false;
+};
+
+#endif //EDGE_GPU_READBACK_H
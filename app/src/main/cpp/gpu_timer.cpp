@@ -0,0 +1,140 @@
+#include "gpu_timer.h"
+#include <EGL/egl.h>
+#include <cstring>
+
+#define LOG_TAG "GpuTimer"
+#include "logging.h"
+
+bool GpuTimer::init() {
+    release();
+    const char* extensions = reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+    if (!extensions || !strstr(extensions, "GL_EXT_disjoint_timer_query")) {
+        LOGI("GL_EXT_disjoint_timer_query unavailable; no GPU timings");
+        return false;
+    }
+    genQueries = reinterpret_cast<PFNGLGENQUERIESEXTPROC>(eglGetProcAddress("glGenQueriesEXT"));
+    deleteQueries = reinterpret_cast<PFNGLDELETEQUERIESEXTPROC>(eglGetProcAddress("glDeleteQueriesEXT"));
+    beginQuery = reinterpret_cast<PFNGLBEGINQUERYEXTPROC>(eglGetProcAddress("glBeginQueryEXT"));
+    endQuery = reinterpret_cast<PFNGLENDQUERYEXTPROC>(eglGetProcAddress("glEndQueryEXT"));
+    getQueryObjectuiv = reinterpret_cast<PFNGLGETQUERYOBJECTUIVEXTPROC>(eglGetProcAddress("glGetQueryObjectuivEXT"));
+    getQueryObjectui64v = reinterpret_cast<PFNGLGETQUERYOBJECTUI64VEXTPROC>(
+            eglGetProcAddress("glGetQueryObjectui64vEXT"));
+    if (!genQueries || !deleteQueries || !beginQuery || !endQuery || !getQueryObjectuiv || !getQueryObjectui64v) {
+        LOGW("⚠️ GL_EXT_disjoint_timer_query advertised without its entry points");
+        return false;
+    }
+    for (FrameQueries& frame : frames) {
+        genQueries(kQueriesPerFrame, frame.ids);
+    }
+    GLint disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);  // clears the flag
+    active = true;
+    LOGI("✅ GPU timer queries enabled (%d frames in flight)", kFramesInFlight);
+    return true;
+}
+
+void GpuTimer::release() {
+    if (active) {
+        for (FrameQueries& frame : frames) {
+            deleteQueries(kQueriesPerFrame, frame.ids);
+        }
+    }
+    for (FrameQueries& frame : frames) {
+        frame = FrameQueries();
+    }
+    current = 0;
+    inFrame = false;
+    queryOpen = false;
+    active = false;
+}
+
+void GpuTimer::beginFrame() {
+    if (!active || inFrame) {
+        return;
+    }
+    collect();
+    FrameQueries& frame = frames[current];
+    frame.pending = false;  // still unread after kFramesInFlight frames: dropped
+    frame.used = 0;
+    inFrame = true;
+}
+
+void GpuTimer::endFrame() {
+    if (!active || !inFrame) {
+        return;
+    }
+    if (queryOpen) {
+        endQuery(GL_TIME_ELAPSED_EXT);
+        queryOpen = false;
+    }
+    FrameQueries& frame = frames[current];
+    frame.pending = frame.used > 0;
+    current = (current + 1) % kFramesInFlight;
+    inFrame = false;
+}
+
+bool GpuTimer::begin(Stage stage, int64_t tag) {
+    FrameQueries& frame = frames[current];
+    if (!inFrame || queryOpen || frame.used == kQueriesPerFrame) {
+        return false;
+    }
+    frame.stages[frame.used] = stage;
+    frame.tags[frame.used] = tag;
+    beginQuery(GL_TIME_ELAPSED_EXT, frame.ids[frame.used++]);
+    queryOpen = true;
+    return true;
+}
+
+void GpuTimer::end() {
+    if (queryOpen) {
+        endQuery(GL_TIME_ELAPSED_EXT);
+        queryOpen = false;
+    }
+}
+
+void GpuTimer::collect() {
+    GLint disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    // Oldest first; a frame's queries complete in order, so its last one
+    // being available means all of them are
+    for (int age = 0; age < kFramesInFlight; age++) {
+        FrameQueries& frame = frames[(current + age) % kFramesInFlight];
+        if (!frame.pending) {
+            continue;
+        }
+        if (disjoint) {
+            frame.pending = false;  // the counter was reset or rescaled under these
+            continue;
+        }
+        GLuint available = GL_FALSE;
+        getQueryObjectuiv(frame.ids[frame.used - 1], GL_QUERY_RESULT_AVAILABLE_EXT, &available);
+        if (!available) {
+            break;  // newer frames are not done either
+        }
+        GLuint64 uploadNs = 0;
+        GLuint64 drawNs = 0;
+        bool uploaded = false;
+        bool drew = false;
+        for (int i = 0; i < frame.used; i++) {
+            GLuint64 elapsed = 0;
+            getQueryObjectui64v(frame.ids[i], GL_QUERY_RESULT_EXT, &elapsed);
+            if (listener && frame.tags[i] != 0) {
+                listener(frame.stages[i], frame.tags[i], elapsed);
+            }
+            if (frame.stages[i] == Stage::GPU_UPLOAD) {
+                uploadNs += elapsed;
+                uploaded = true;
+            } else {
+                drawNs += elapsed;
+                drew = true;
+            }
+        }
+        if (uploaded) {
+            metrics().recordStage(Stage::GPU_UPLOAD, static_cast<int64_t>(uploadNs / 1000));
+        }
+        if (drew) {
+            metrics().recordStage(Stage::GPU_DRAW, static_cast<int64_t>(drawNs / 1000));
+        }
+        frame.pending = false;
+    }
+}
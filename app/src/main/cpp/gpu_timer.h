@@ -0,0 +1,85 @@
+#ifndef EDGE_GPU_TIMER_H
+#define EDGE_GPU_TIMER_H
+
+#include "metrics.h"
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+
+// GPU time of the render work through GL_EXT_disjoint_timer_query. Each
+// frame's TIME_ELAPSED queries are summed per stage (Stage::GPU_UPLOAD,
+// Stage::GPU_DRAW) into the metrics registry, read back kFramesInFlight
+// frames later once the GPU has reported them, so the GL thread never waits
+// on a result. Frames whose results are not in by then, or were disjoint
+// (frequency change, context loss), are dropped. GL thread only; inactive
+// without the extension.
+class GpuTimer {
+public:
+    bool init();
+    void release();
+    bool isActive() const { return active; }
+
+    // Bracket one rendered frame; beginFrame also collects finished frames
+    void beginFrame();
+    void endFrame();
+
+    // TIME_ELAPSED queries cannot nest: begin returns false (and times
+    // nothing) while another one is open or the frame is out of queries.
+    // A nonzero tag is handed to the listener with the query's result.
+    bool begin(Stage stage, int64_t tag = 0);
+    void end();
+
+    // Called on the GL thread for every collected query with a nonzero tag,
+    // with its GPU time; results arrive a few frames after the draw
+    using Listener = void (*)(Stage stage, int64_t tag, uint64_t elapsedNs);
+    void setListener(Listener callback) { listener = callback; }
+
+private:
+    static const int kFramesInFlight = 4;
+    static const int kQueriesPerFrame = 16;
+
+    struct FrameQueries {
+        GLuint ids[kQueriesPerFrame] = {};
+        Stage stages[kQueriesPerFrame] = {};
+        int64_t tags[kQueriesPerFrame] = {};
+        int used = 0;
+        bool pending = false;  // ended, results not read yet
+    };
+
+    void collect();
+
+    PFNGLGENQUERIESEXTPROC genQueries = nullptr;
+    PFNGLDELETEQUERIESEXTPROC deleteQueries = nullptr;
+    PFNGLBEGINQUERYEXTPROC beginQuery = nullptr;
+    PFNGLENDQUERYEXTPROC endQuery = nullptr;
+    PFNGLGETQUERYOBJECTUIVEXTPROC getQueryObjectuiv = nullptr;
+    PFNGLGETQUERYOBJECTUI64VEXTPROC getQueryObjectui64v = nullptr;
+
+    Listener listener = nullptr;
+    FrameQueries frames[kFramesInFlight];
+    int current = 0;
+    bool inFrame = false;
+    bool queryOpen = false;
+    bool active = false;
+};
+
+// Times the enclosing scope on timer when it is active and nothing else is
+// being timed
+class ScopedGpuTimer {
+public:
+    ScopedGpuTimer(GpuTimer& timer, Stage stage, int64_t tag = 0)
+            : timer(timer), started(timer.isActive() && timer.begin(stage, tag)) {}
+    ~ScopedGpuTimer() {
+        if (started) {
+            timer.end();
+        }
+    }
+
+    ScopedGpuTimer(const ScopedGpuTimer&) = delete;
+    ScopedGpuTimer& operator=(const ScopedGpuTimer&) = delete;
+
+private:
+    GpuTimer& timer;
+    bool started;
+};
+
+#endif // EDGE_GPU_TIMER_H
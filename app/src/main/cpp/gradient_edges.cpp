@@ -0,0 +1,69 @@
+#include "gradient_edges.h"
+#include "kernel_dispatch.h"
+#include "packed_edges.h"
+#include <opencv2/core/utility.hpp>
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+const int kBandRows = 32;
+const int kMaxThreshold = 2041;  // above any 8-bit L1 magnitude: no edges
+
+// Bands of kBandRows output rows; bits set: packed output
+class GradientEdgesBody : public cv::ParallelLoopBody {
+public:
+    GradientEdgesBody(const cv::Mat& gray, int threshold, cv::Mat& out, bool packed)
+        : gray(gray), threshold(threshold), out(out), packed(packed) {}
+
+    void operator()(const cv::Range& range) const override {
+        const EdgeKernels& kernels = edgeKernels();
+        const int width = gray.cols;
+        const int height = gray.rows;
+        static thread_local std::vector<uint8_t> scratch;
+        if (packed) {
+            scratch.resize(static_cast<size_t>(width));
+        }
+        const int rowBytes = out.cols;
+        for (int band = range.start; band < range.end; band++) {
+            const int y1 = std::min(height, (band + 1) * kBandRows);
+            for (int y = band * kBandRows; y < y1; y++) {
+                const uint8_t* r0 = gray.ptr<uint8_t>(std::max(y - 1, 0));
+                const uint8_t* r1 = gray.ptr<uint8_t>(y);
+                const uint8_t* r2 = gray.ptr<uint8_t>(std::min(y + 1, height - 1));
+                if (packed) {
+                    kernels.gradientThresholdRow(r0, r1, r2, width, threshold, scratch.data());
+                    kernels.packRow(scratch.data(), width, out.ptr<uint8_t>(y), rowBytes);
+                } else {
+                    kernels.gradientThresholdRow(r0, r1, r2, width, threshold, out.ptr<uint8_t>(y));
+                }
+            }
+        }
+    }
+
+private:
+    const cv::Mat& gray;
+    const int threshold;
+    cv::Mat& out;
+    const bool packed;
+};
+
+void run(const cv::Mat& gray, int threshold, cv::Mat& out, bool packed) {
+    const int bands = (gray.rows + kBandRows - 1) / kBandRows;
+    cv::parallel_for_(cv::Range(0, bands),
+                      GradientEdgesBody(gray, std::min(std::max(threshold, 0), kMaxThreshold), out, packed));
+}
+
+} // namespace
+
+void gradientEdgesU8(const cv::Mat& gray, cv::Mat& edges, int threshold) {
+    CV_Assert(gray.type() == CV_8UC1 && !gray.empty());
+    edges.create(gray.size(), CV_8UC1);
+    run(gray, threshold, edges, false);
+}
+
+void gradientEdgesPacked(const cv::Mat& gray, cv::Mat& bits, int threshold) {
+    CV_Assert(gray.type() == CV_8UC1 && !gray.empty());
+    bits.create(gray.rows, packedEdgeRowBytes(gray.cols), CV_8UC1);
+    run(gray, threshold, bits, true);
+}
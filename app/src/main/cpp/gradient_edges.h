@@ -0,0 +1,20 @@
+#ifndef EDGE_GRADIENT_EDGES_H
+#define EDGE_GRADIENT_EDGES_H
+
+#include <opencv2/core.hpp>
+
+// FAST_EDGES: 255 where the L1 magnitude of the 3x3 Sobel gradient reaches
+// threshold, 0 elsewhere, with replicated borders. One fused pass per output
+// row (kernel_dispatch.h gradientThresholdRow) reads the three source rows
+// and writes the bytes, so neither dx/dy nor the magnitude is ever stored;
+// no suppression or hysteresis, hence thicker and noisier edges than Canny
+// at a fraction of its cost. Rows run in bands on OpenCV's pool.
+void gradientEdgesU8(const cv::Mat& gray, cv::Mat& edges, int threshold);
+
+// Same edges straight into a 1-bpp bitmap (packed_edges.h): each row is
+// thresholded into a per-thread scratch row and packed while it is in L1, so
+// no 8-bit map of the frame exists. bits: allocated here unless it already
+// has the packed geometry.
+void gradientEdgesPacked(const cv::Mat& gray, cv::Mat& bits, int threshold);
+
+#endif // EDGE_GRADIENT_EDGES_H
@@ -0,0 +1,191 @@
+#include "hardware_frames.h"
+#include "render_frame.h"
+#include "tracing.h"
+#include <android/hardware_buffer.h>
+#include <opencv2/imgproc.hpp>
+#include <dlfcn.h>
+#include <mutex>
+#include <unistd.h>
+#include <vector>
+
+#define LOG_TAG "HardwareFrames"
+#include "logging.h"
+
+namespace {
+
+// published slots, the renderer's current and recent frames, and a second pipeline
+const size_t kMaxRingBuffers = 8;
+// AHARDWAREBUFFER_FORMAT_R8_UNORM; older NDK headers lack it
+const uint32_t kFormatR8Unorm = 0x38;
+const uint64_t kUsage = AHARDWAREBUFFER_USAGE_CPU_WRITE_OFTEN | AHARDWAREBUFFER_USAGE_GPU_SAMPLED_IMAGE;
+
+std::mutex ringMutex;
+std::vector<std::shared_ptr<HardwareFrame>> ring;  // in use while referenced outside the ring
+uint64_t framesWritten = 0;
+
+AHardwareBuffer_Desc describeFrame(int width, int height, bool singleChannel) {
+    AHardwareBuffer_Desc desc{};
+    desc.width = static_cast<uint32_t>(width);
+    desc.height = static_cast<uint32_t>(height);
+    desc.layers = 1;
+    desc.format = singleChannel ? kFormatR8Unorm : static_cast<uint32_t>(AHARDWAREBUFFER_FORMAT_R8G8B8A8_UNORM);
+    desc.usage = kUsage;
+    return desc;
+}
+
+// R8 buffers the GPU can sample; without isSupported (API < 29) none are
+bool r8Supported() {
+    static const bool supported = [] {
+        const HardwareBufferApi& api = hardwareBufferApi();
+        const AHardwareBuffer_Desc desc = describeFrame(64, 64, true);
+        const bool result = api.isSupported && api.isSupported(&desc) != 0;
+        LOGI("%s R8 hardware frames %s", result ? "✅" : "⚠️", result ? "supported" : "unsupported, using RGBA");
+        return result;
+    }();
+    return supported;
+}
+
+std::shared_ptr<HardwareFrame> allocateFrame(int width, int height, bool singleChannel) {
+    const HardwareBufferApi& api = hardwareBufferApi();
+    const AHardwareBuffer_Desc desc = describeFrame(width, height, singleChannel);
+    AHardwareBuffer* buffer = nullptr;
+    if (api.allocate(&desc, &buffer) != 0 || !buffer) {
+        LOGE_RATELIMITED("❌ AHardwareBuffer_allocate failed for a %dx%d frame", width, height);
+        return nullptr;
+    }
+    AHardwareBuffer_Desc allocated{};
+    api.describe(buffer, &allocated);
+    // The renderer's EGLImage holds its own buffer reference
+    std::shared_ptr<HardwareFrame> frame(new HardwareFrame(), [](HardwareFrame* released) {
+        const int fence = released->readFence.exchange(-1);
+        if (fence >= 0) {
+            close(fence);
+        }
+        hardwareBufferApi().release(released->buffer);
+        delete released;
+    });
+    frame->buffer = buffer;
+    frame->width = width;
+    frame->height = height;
+    frame->stride = static_cast<int>(allocated.stride);
+    frame->singleChannel = singleChannel;
+    return frame;
+}
+
+// A ring buffer of that geometry nobody references, allocated while the ring
+// has room; free buffers of another geometry are dropped first. Caller holds
+// ringMutex and keeps the returned reference while writing, so no other
+// writer takes the same buffer.
+std::shared_ptr<HardwareFrame> acquireFrame(int width, int height, bool singleChannel) {
+    for (size_t i = 0; i < ring.size();) {
+        const HardwareFrame& frame = *ring[i];
+        if (ring[i].use_count() == 1 &&
+            (frame.width != width || frame.height != height || frame.singleChannel != singleChannel)) {
+            ring.erase(ring.begin() + static_cast<std::ptrdiff_t>(i));
+        } else {
+            i++;
+        }
+    }
+    for (const auto& frame : ring) {
+        if (frame.use_count() == 1) {
+            return frame;
+        }
+    }
+    if (ring.size() >= kMaxRingBuffers) {
+        return nullptr;
+    }
+    std::shared_ptr<HardwareFrame> frame = allocateFrame(width, height, singleChannel);
+    if (frame) {
+        ring.push_back(frame);
+    }
+    return frame;
+}
+
+} // namespace
+
+const HardwareBufferApi& hardwareBufferApi() {
+    static const HardwareBufferApi api = [] {
+        HardwareBufferApi loaded;
+        void* lib = dlopen("libnativewindow.so", RTLD_NOW);
+        if (lib) {
+            loaded.allocate = reinterpret_cast<int (*)(const AHardwareBuffer_Desc*, AHardwareBuffer**)>(
+                    dlsym(lib, "AHardwareBuffer_allocate"));
+            loaded.release = reinterpret_cast<void (*)(AHardwareBuffer*)>(dlsym(lib, "AHardwareBuffer_release"));
+            loaded.describe = reinterpret_cast<void (*)(const AHardwareBuffer*, AHardwareBuffer_Desc*)>(
+                    dlsym(lib, "AHardwareBuffer_describe"));
+            loaded.lock = reinterpret_cast<int (*)(AHardwareBuffer*, uint64_t, int32_t, const ARect*, void**)>(
+                    dlsym(lib, "AHardwareBuffer_lock"));
+            loaded.unlock = reinterpret_cast<int (*)(AHardwareBuffer*, int32_t*)>(
+                    dlsym(lib, "AHardwareBuffer_unlock"));
+            loaded.isSupported = reinterpret_cast<int (*)(const AHardwareBuffer_Desc*)>(
+                    dlsym(lib, "AHardwareBuffer_isSupported"));
+        }
+        return loaded;
+    }();
+    return api;
+}
+
+bool hardwareFramesAvailable() {
+    return hardwareBufferApi().lockable();
+}
+
+std::shared_ptr<const HardwareFrame> writeHardwareFrame(const cv::Mat& frame) {
+    const int channels = frame.channels();
+    if (frame.empty() || frame.depth() != CV_8U || (channels != 1 && channels != 3 && channels != 4) ||
+        !hardwareFramesAvailable()) {
+        return nullptr;
+    }
+    ScopedTrace trace("hardware_frame_write");
+    const bool singleChannel = channels == 1 && r8Supported();
+    std::shared_ptr<HardwareFrame> target;
+    {
+        std::lock_guard<std::mutex> lock(ringMutex);
+        target = acquireFrame(frame.cols, frame.rows, singleChannel);
+    }
+    if (!target) {
+        return nullptr;  // every buffer still on its way to (or on) the screen
+    }
+
+    // The lock takes over the fence and waits on it: GL is done sampling
+    const HardwareBufferApi& api = hardwareBufferApi();
+    void* pixels = nullptr;
+    const int fence = target->readFence.exchange(-1);
+    if (api.lock(target->buffer, AHARDWAREBUFFER_USAGE_CPU_WRITE_OFTEN, fence, nullptr, &pixels) != 0 || !pixels) {
+        LOGE_RATELIMITED("❌ AHardwareBuffer_lock failed for a %dx%d frame", frame.cols, frame.rows);
+        return nullptr;
+    }
+    const size_t pixelBytes = singleChannel ? 1 : 4;
+    cv::Mat mapped(frame.rows, frame.cols, singleChannel ? CV_8UC1 : CV_8UC4, pixels,
+                   static_cast<size_t>(target->stride) * pixelBytes);
+    bool written = true;
+    try {
+        // The mapping already has the destination's size and type, so these
+        // write into it rather than reallocate
+        if (channels == 3) {
+            cv::cvtColor(frame, mapped, cv::COLOR_BGR2RGBA);
+        } else if (channels == 1 && !singleChannel) {
+            cv::cvtColor(frame, mapped, cv::COLOR_GRAY2RGBA);
+        } else {
+            frame.copyTo(mapped);
+        }
+        written = mapped.data == pixels;
+    } catch (const cv::Exception& e) {
+        LOGE_RATELIMITED("❌ Writing a hardware frame failed: %s", e.what());
+        written = false;
+    }
+    // No fence out: returns once the CPU writes are visible to the GPU
+    api.unlock(target->buffer, nullptr);
+    if (!written) {
+        return nullptr;
+    }
+    {
+        std::lock_guard<std::mutex> lock(ringMutex);
+        target->id = ++framesWritten;
+    }
+    return target;
+}
+
+void releaseHardwareFrames() {
+    std::lock_guard<std::mutex> lock(ringMutex);
+    ring.clear();
+}
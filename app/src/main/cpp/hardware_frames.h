@@ -0,0 +1,47 @@
+#ifndef EDGE_HARDWARE_FRAMES_H
+#define EDGE_HARDWARE_FRAMES_H
+
+#include <opencv2/core.hpp>
+#include <cstdint>
+#include <memory>
+
+struct AHardwareBuffer;
+struct AHardwareBuffer_Desc;
+struct ARect;
+struct HardwareFrame;
+
+// libnativewindow's AHardwareBuffer calls, resolved once (they are API 26,
+// isSupported API 29, and minSdk is 24); null where the device lacks them
+struct HardwareBufferApi {
+    int (*allocate)(const AHardwareBuffer_Desc*, AHardwareBuffer**) = nullptr;
+    void (*release)(AHardwareBuffer*) = nullptr;
+    void (*describe)(const AHardwareBuffer*, AHardwareBuffer_Desc*) = nullptr;
+    int (*lock)(AHardwareBuffer*, uint64_t, int32_t, const ARect*, void**) = nullptr;
+    int (*unlock)(AHardwareBuffer*, int32_t*) = nullptr;
+    int (*isSupported)(const AHardwareBuffer_Desc*) = nullptr;
+
+    bool available() const { return allocate && release && describe; }
+    bool lockable() const { return available() && lock && unlock; }
+};
+
+const HardwareBufferApi& hardwareBufferApi();
+
+// CPU -> GPU handoff without glTexSubImage2D: the processing thread writes the
+// frame the renderer will show into a locked AHardwareBuffer of a small ring,
+// and the renderer samples that buffer as an EGLImage. A buffer is rewritten
+// only once nothing references it, and its lock waits on the fence of the last
+// draw that sampled it. Any thread.
+
+// Whether AHardwareBuffers can be allocated and locked on this device
+bool hardwareFramesAvailable();
+
+// frame (8-bit, 1, 3 or 4 channels; BGR for 3) written as the renderer would
+// upload it: 1 channel as R8 where the device supports it (else expanded to
+// RGBA), 3 converted to RGBA. Null when unavailable or while every buffer of
+// the ring is still referenced.
+std::shared_ptr<const HardwareFrame> writeHardwareFrame(const cv::Mat& frame);
+
+// Empties the ring: free buffers go now, the rest as their last user drops them
+void releaseHardwareFrames();
+
+#endif // EDGE_HARDWARE_FRAMES_H
@@ -1,35 +1,423 @@
 #include "image_processor.h"
+#include "canny_kernel.h"
+#include "gradient_edges.h"
+#include "filter_graph.h"
+#include "frame_arena.h"
+#include "pyramid_cache.h"
+#include "quality_governor.h"
+#include "tracing.h"
 #include <opencv2/imgproc.hpp>
 #include <opencv2/core.hpp>
-#include <android/log.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
 
 #define LOG_TAG "ImageProcessor"
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#include "logging.h"
+
+namespace {
+
+// processFrame's chain while no graph has been configured
+const char* const kDefaultFilterGraph = "gray|canny|bgr";
+
+const int kCannyLow = 100;
+const int kCannyHigh = 200;
+
+// 8-bit thresholds in 10-bit gradient units (1023 / 255)
+const double k10BitScale = 1023.0 / 255.0;
+
+// Adaptive thresholds: (1 -/+ sigma) * median luma, the usual auto-Canny rule
+// (a median of 150 reproduces the fixed 100/200). The median comes from every
+// kHistogramStep-th pixel of every kHistogramStep-th row (1/16 of the frame)
+// and is smoothed with kThresholdSmoothing as the weight of the newest frame.
+const float kThresholdSigma = 0.33f;
+const int kHistogramStep = 4;
+const float kThresholdSmoothing = 0.2f;
+
+std::atomic<bool> adaptiveThresholds{false};
+std::atomic<bool> preBlur{false};
+std::atomic<bool> fedMedian{false};   // medians come from feedLumaMedian
+std::atomic<int> cannyLow{kCannyLow};
+std::atomic<int> cannyHigh{kCannyHigh};
+std::atomic<int> fixedLow{kCannyLow};     // what fixed thresholds come back to
+std::atomic<int> fixedHigh{kCannyHigh};
+
+std::mutex thresholdMutex;
+float smoothedMedian = -1.0f;   // < 0 until the first sample
+
+// Sweeps of CannyBackend::BOUNDED's hysteresis (cannyU8Bounded)
+const int kBoundedHysteresisPasses = 2;
+
+// Timed runs per implementation before AUTO settles; the fastest run of each
+// is compared, which ignores the first-frame warm-up of either one
+const int kCalibrationRuns = 8;
+
+std::atomic<int> requestedBackend{static_cast<int>(CannyBackend::AUTO)};
+std::atomic<int> calibratedBackend{static_cast<int>(CannyBackend::AUTO)};
+
+// Implementations AUTO chooses between
+const CannyBackend kCandidates[] = {CannyBackend::OPENCV, CannyBackend::KERNEL, CannyBackend::TILED};
+const int kCandidateCount = sizeof(kCandidates) / sizeof(kCandidates[0]);
+
+std::mutex calibrationMutex;
+int calibrationCount[kCandidateCount] = {};
+int64_t calibrationBestMicros[kCandidateCount] = {};
+
+// False only when the tiled kernel gave up at deadline (canny_kernel.h)
+bool runCanny(CannyBackend backend, const cv::Mat& gray, cv::Mat& edges, const FrameDeadline* deadline = nullptr) {
+    const int low = cannyLow.load(std::memory_order_relaxed);
+    const int high = cannyHigh.load(std::memory_order_relaxed);
+    const bool blur = preBlur.load(std::memory_order_relaxed);
+    switch (backend) {
+        case CannyBackend::KERNEL:
+            cannyU8(gray, edges, low, high, blur);
+            break;
+        case CannyBackend::TILED:
+            return cannyU8Tiled(gray, edges, low, high, blur, deadline);
+        case CannyBackend::BOUNDED:
+            return cannyU8Bounded(gray, edges, low, high, blur, kBoundedHysteresisPasses, deadline);
+        case CannyBackend::GRADIENT:
+            gradientEdgesU8(gray, edges, high);  // no pre-blur: the point is the single pass
+            break;
+        default:
+            if (blur) {
+                // Unfused: a full blurred copy; the kernels do this in their gradient pass
+                static thread_local cv::Mat blurred = persistentMat();
+                cv::GaussianBlur(gray, blurred, cv::Size(5, 5), 0, 0, cv::BORDER_REPLICATE);
+                cv::Canny(blurred, edges, low, high);
+            } else {
+                cv::Canny(gray, edges, low, high);
+            }
+            break;
+    }
+    return true;
+}
+
+// Median of a sparse sample of the frame; -1 for an empty frame
+int sampledMedian(const cv::Mat& gray) {
+    uint32_t histogram[256] = {};
+    uint32_t samples = 0;
+    for (int y = kHistogramStep / 2; y < gray.rows; y += kHistogramStep) {
+        const uchar* row = gray.ptr<uchar>(y);
+        for (int x = kHistogramStep / 2; x < gray.cols; x += kHistogramStep) {
+            histogram[row[x]]++;
+            samples++;
+        }
+    }
+    if (samples == 0) {
+        return -1;
+    }
+    uint32_t half = (samples + 1) / 2;
+    uint32_t seen = 0;
+    for (int value = 0; value < 256; value++) {
+        seen += histogram[value];
+        if (seen >= half) {
+            return value;
+        }
+    }
+    return 255;
+}
+
+// Smooths a frame's median luma into the thresholds
+void applyMedian(int median) {
+    if (median < 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(thresholdMutex);
+    if (smoothedMedian < 0.0f) {
+        smoothedMedian = static_cast<float>(median);
+    } else {
+        smoothedMedian += kThresholdSmoothing * (median - smoothedMedian);
+    }
+    int low = std::max(0, static_cast<int>((1.0f - kThresholdSigma) * smoothedMedian));
+    int high = std::min(255, static_cast<int>((1.0f + kThresholdSigma) * smoothedMedian));
+    cannyLow.store(low, std::memory_order_relaxed);
+    cannyHigh.store(std::max(high, low + 1), std::memory_order_relaxed);
+}
+
+// Derives the thresholds the next frame will use from this one's luma, which
+// Canny has just pulled into the cache (unless the statistics pass feeds them)
+void updateAdaptiveThresholds(const cv::Mat& gray) {
+    if (!fedMedian.load(std::memory_order_relaxed)) {
+        applyMedian(sampledMedian(gray));
+    }
+}
+
+// AUTO before a winner is known: rotate through the implementations on real
+// frames (all produce the same edges) until each has kCalibrationRuns timings
+void calibrateCanny(const cv::Mat& gray, cv::Mat& edges) {
+    int slot = 0;
+    {
+        std::lock_guard<std::mutex> lock(calibrationMutex);
+        for (int i = 1; i < kCandidateCount; i++) {
+            if (calibrationCount[i] < calibrationCount[slot]) {
+                slot = i;
+            }
+        }
+    }
+    CannyBackend backend = kCandidates[slot];
+
+    auto start = std::chrono::steady_clock::now();
+    runCanny(backend, gray, edges);
+    int64_t micros = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+
+    std::lock_guard<std::mutex> lock(calibrationMutex);
+    if (calibrationCount[slot] == 0 || micros < calibrationBestMicros[slot]) {
+        calibrationBestMicros[slot] = micros;
+    }
+    calibrationCount[slot]++;
+    if (calibratedBackend.load() != static_cast<int>(CannyBackend::AUTO)) {
+        return;
+    }
+    int winner = 0;
+    for (int i = 0; i < kCandidateCount; i++) {
+        if (calibrationCount[i] < kCalibrationRuns) {
+            return;
+        }
+        if (calibrationBestMicros[i] < calibrationBestMicros[winner]) {
+            winner = i;
+        }
+    }
+    calibratedBackend.store(static_cast<int>(kCandidates[winner]));
+    LOGI("Canny calibrated at %dx%d (kernel %s): cv::Canny %lldus, kernel %lldus, tiled %lldus -> %s",
+         gray.cols, gray.rows, cannyKernelUsesNeon() ? "NEON" : "scalar",
+         static_cast<long long>(calibrationBestMicros[0]),
+         static_cast<long long>(calibrationBestMicros[1]),
+         static_cast<long long>(calibrationBestMicros[2]),
+         cannyBackendName(kCandidates[winner]));
+}
+
+} // namespace
+
+const char* cannyBackendName(CannyBackend backend) {
+    switch (backend) {
+        case CannyBackend::OPENCV: return "cv::Canny";
+        case CannyBackend::KERNEL: return "kernel";
+        case CannyBackend::TILED: return "tiled kernel";
+        case CannyBackend::GRADIENT: return "fast edges";
+        case CannyBackend::BOUNDED: return "bounded kernel";
+        default: return "auto";
+    }
+}
+
+void setCannyBackend(CannyBackend backend) {
+    if (backend == CannyBackend::AUTO) {
+        // Re-run the benchmark, e.g. after the preview resolution changed
+        std::lock_guard<std::mutex> lock(calibrationMutex);
+        for (int i = 0; i < kCandidateCount; i++) {
+            calibrationCount[i] = 0;
+            calibrationBestMicros[i] = 0;
+        }
+        calibratedBackend.store(static_cast<int>(CannyBackend::AUTO));
+    }
+    requestedBackend.store(static_cast<int>(backend));
+}
+
+CannyBackend activeCannyBackend() {
+    CannyBackend backend = static_cast<CannyBackend>(requestedBackend.load());
+    if (backend != CannyBackend::GRADIENT && qualityGovernor().current().boundedHysteresis) {
+        return CannyBackend::BOUNDED;  // also holds AUTO's calibration until the level is left
+    }
+    if (backend == CannyBackend::AUTO) {
+        backend = static_cast<CannyBackend>(calibratedBackend.load());
+    }
+    return backend;
+}
+
+void setAdaptiveThresholds(bool enabled) {
+    std::lock_guard<std::mutex> lock(thresholdMutex);
+    adaptiveThresholds.store(enabled);
+    smoothedMedian = -1.0f;
+    cannyLow.store(fixedLow.load());
+    cannyHigh.store(fixedHigh.load());
+}
+
+void setFixedCannyThresholds(int low, int high) {
+    low = std::max(0, std::min(low, 254));
+    high = std::max(low + 1, std::min(high, 255));
+    std::lock_guard<std::mutex> lock(thresholdMutex);
+    fixedLow.store(low);
+    fixedHigh.store(high);
+    if (!adaptiveThresholds.load()) {
+        cannyLow.store(low);
+        cannyHigh.store(high);
+    }
+}
+
+bool adaptiveThresholdsEnabled() {
+    return adaptiveThresholds.load(std::memory_order_relaxed);
+}
+
+void setEdgePreBlur(bool enabled) {
+    preBlur.store(enabled);
+}
+
+bool edgePreBlurEnabled() {
+    return preBlur.load(std::memory_order_relaxed);
+}
+
+void useFedLumaMedian(bool fed) {
+    fedMedian.store(fed);
+}
+
+void feedLumaMedian(int median) {
+    if (adaptiveThresholds.load(std::memory_order_relaxed)) {
+        applyMedian(median);
+    }
+}
+
+void currentCannyThresholds(int& low, int& high) {
+    low = cannyLow.load(std::memory_order_relaxed);
+    high = cannyHigh.load(std::memory_order_relaxed);
+}
+
+void detectEdges(const cv::Mat& gray, cv::Mat& edges) {
+    detectEdgesWithin(gray, edges, nullptr);
+}
+
+bool detectEdgesWithin(const cv::Mat& gray, cv::Mat& edges, const FrameDeadline* deadline) {
+    CannyBackend backend = activeCannyBackend();
+    if (backend == CannyBackend::AUTO) {
+        calibrateCanny(gray, edges);  // timed runs: never cut short
+    } else if (!runCanny(backend, gray, edges, deadline)) {
+        return false;
+    }
+    if (adaptiveThresholds.load(std::memory_order_relaxed)) {
+        updateAdaptiveThresholds(gray);
+    }
+    return true;
+}
+
+void cannyWithBackend(CannyBackend backend, const cv::Mat& gray, cv::Mat& edges) {
+    runCanny(backend == CannyBackend::AUTO ? CannyBackend::OPENCV : backend, gray, edges);
+}
+
+void detectEdgesPartial(const cv::Mat& gray, cv::Mat& edges) {
+    CannyBackend backend = activeCannyBackend();
+    runCanny(backend == CannyBackend::AUTO ? CannyBackend::OPENCV : backend, gray, edges);
+}
+
+void detectEdgesWithRecords(const cv::Mat& gray, cv::Mat& edges, EdgeRecordSink& sink) {
+    cannyU8Records(gray, edges, cannyLow.load(std::memory_order_relaxed), cannyHigh.load(std::memory_order_relaxed),
+                   preBlur.load(std::memory_order_relaxed), activeCannyBackend() == CannyBackend::TILED, sink);
+    if (adaptiveThresholds.load(std::memory_order_relaxed)) {
+        updateAdaptiveThresholds(gray);
+    }
+}
+
+void detectGradientEdges(const cv::Mat& gray, cv::Mat& edges) {
+    gradientEdgesU8(gray, edges, cannyHigh.load(std::memory_order_relaxed));
+    if (adaptiveThresholds.load(std::memory_order_relaxed)) {
+        updateAdaptiveThresholds(gray);
+    }
+}
+
+void detectGradientEdgesPacked(const cv::Mat& gray, cv::Mat& bits) {
+    gradientEdgesPacked(gray, bits, cannyHigh.load(std::memory_order_relaxed));
+    if (adaptiveThresholds.load(std::memory_order_relaxed)) {
+        updateAdaptiveThresholds(gray);
+    }
+}
+
+void detectMultiscaleEdges(const cv::Mat& gray, cv::Mat& edges, int levels) {
+    detectEdges(gray, edges);
+    PyramidCache& pyramids = pyramidCache();
+    if (levels < 2 || !pyramids.covers(gray)) {
+        return;
+    }
+    ScopedTrace trace("multiscale_edges");
+    static thread_local cv::Mat coarse = persistentMat();
+    static thread_local cv::Mat upsampled = persistentMat();
+    static thread_local cv::Mat support = persistentMat();
+    bool supported = false;
+    for (int index = 1; index < std::min(levels, PyramidCache::kMaxLevels); index++) {
+        const cv::Mat level = pyramids.level(index);
+        if (level.empty()) {
+            break;
+        }
+        // Same thresholds; the coarse levels neither calibrate nor adapt them
+        detectEdgesPartial(level, coarse);
+        cv::dilate(coarse, coarse, cv::Mat());  // one coarse pixel of slack
+        cv::resize(coarse, upsampled, gray.size(), 0, 0, cv::INTER_NEAREST);
+        if (supported) {
+            cv::bitwise_or(support, upsampled, support);
+        } else {
+            upsampled.copyTo(support);
+            supported = true;
+        }
+    }
+    if (supported) {
+        cv::bitwise_and(edges, support, edges);
+    }
+}
+
+void detectColorEdges(const cv::Mat& luma, const cv::Mat& vu, cv::Mat& edges) {
+    ScopedTrace trace("color_edges");
+    cannyU8Color(luma, vu, edges, cannyLow.load(std::memory_order_relaxed), cannyHigh.load(std::memory_order_relaxed),
+                 preBlur.load(std::memory_order_relaxed), activeCannyBackend() == CannyBackend::TILED);
+    if (adaptiveThresholds.load(std::memory_order_relaxed)) {
+        updateAdaptiveThresholds(luma);
+    }
+}
+
+void detectEdges10(const cv::Mat& luma10, const cv::Mat& gray, cv::Mat& edges) {
+    ScopedTrace trace("canny_10bit");
+    CV_Assert(luma10.type() == CV_16SC1);
+    static thread_local cv::Mat blurred = persistentMat();
+    static thread_local cv::Mat dx = persistentMat();
+    static thread_local cv::Mat dy = persistentMat();
+    const cv::Mat* source = &luma10;
+    if (preBlur.load(std::memory_order_relaxed)) {
+        cv::GaussianBlur(luma10, blurred, cv::Size(5, 5), 0, 0, cv::BORDER_REPLICATE);
+        source = &blurred;
+    }
+    // |dx|, |dy| <= 4 * 1023: the 3x3 Sobel fits int16 at 10 bits
+    cv::Sobel(*source, dx, CV_16S, 1, 0, 3, 1, 0, cv::BORDER_REPLICATE);
+    cv::Sobel(*source, dy, CV_16S, 0, 1, 3, 1, 0, cv::BORDER_REPLICATE);
+    cv::Canny(dx, dy, edges, cannyLow.load(std::memory_order_relaxed) * k10BitScale,
+              cannyHigh.load(std::memory_order_relaxed) * k10BitScale);
+    if (adaptiveThresholds.load(std::memory_order_relaxed)) {
+        updateAdaptiveThresholds(gray);
+    }
+}
+
+void updateEdgeThresholds(const cv::Mat& gray) {
+    if (adaptiveThresholds.load(std::memory_order_relaxed)) {
+        updateAdaptiveThresholds(gray);
+    }
+}
 
 void processFrame(const cv::Mat& input, cv::Mat& output) {
+    ScopedTrace trace("processFrame");
     if (input.empty()) {
-        LOGE("Input frame is empty!");
+        LOGE_RATELIMITED("Input frame is empty!");
         return;
     }
 
-    LOGI("Processing frame: %dx%d, type=%d", input.cols, input.rows, input.type());
+    LOGD("Processing frame: %dx%d, type=%d", input.cols, input.rows, input.type());
 
     try {
-        // ✅ Convert to grayscale
-        cv::Mat gray;
-        cv::cvtColor(input, gray, cv::COLOR_BGR2GRAY);
-
-        // ✅ Apply Canny edge detection
-        cv::Mat edges;
-        cv::Canny(gray, edges, 100, 200);
-
-        // ✅ Convert back to 3-channel for OpenGL rendering
-        cv::cvtColor(edges, output, cv::COLOR_GRAY2BGR);
+        // ✅ The configured filter graph, or the original gray -> Canny -> BGR chain
+        static FilterGraph defaultGraph;
+        static std::once_flag defaultGraphOnce;
+        std::call_once(defaultGraphOnce, [] {
+            std::string error;
+            defaultGraph.configure(kDefaultFilterGraph, error);
+        });
+        FilterGraph& graph = filterGraph().empty() ? defaultGraph : filterGraph();
+        if (!graph.run(input, output)) {
+            LOGE_RATELIMITED("Filter graph cannot process type %d", input.type());
+            input.copyTo(output);
+            return;
+        }
 
-        LOGI("Frame processed successfully. Output size: %dx%d", output.cols, output.rows);
+        LOGD("Frame processed successfully. Output size: %dx%d", output.cols, output.rows);
     } catch (const cv::Exception& e) {
-        LOGE("OpenCV error in processFrame: %s", e.what());
-        output = input.clone(); // fallback to original
+        LOGE_RATELIMITED("OpenCV error in processFrame: %s", e.what());
+        input.copyTo(output); // fallback to original
     }
 }
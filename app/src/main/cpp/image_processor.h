@@ -2,7 +2,108 @@
 #define IMAGE_PROCESSOR_H
 
 #include <opencv2/core.hpp>
+#include "canny_kernel.h"
 
+// Runs a frame through filterGraph() (filter_graph.h), or gray -> Canny -> BGR
+// while none is configured; the input is copied through on failure
 void processFrame(const cv::Mat& input, cv::Mat& output);
 
+// Canny on an 8-bit single-channel image (e.g. the NV21 Y plane); output is CV_8UC1
+void detectEdges(const cv::Mat& gray, cv::Mat& edges);
+
+// detectEdges for a frame with a deadline (frame_deadline.h): the tiled
+// kernel checks it between bands, and false means it passed there and
+// edges hold nothing usable. The other backends run to the end.
+bool detectEdgesWithin(const cv::Mat& gray, cv::Mat& edges, const FrameDeadline* deadline);
+
+// detectEdges on part of a frame: same backend and thresholds, but it neither
+// times runs for AUTO (cv::Canny stands in until calibrated) nor feeds the
+// adaptive thresholds
+void detectEdgesPartial(const cv::Mat& gray, cv::Mat& edges);
+
+// Cheapest edge map (FAST_EDGES, gradient_edges.h): 255 where the L1
+// magnitude of the 3x3 Sobel gradient reaches the current high Canny
+// threshold, no suppression or hysteresis, so edges are thicker and noisier.
+// The quality governor's fallback for Canny, and CannyBackend::GRADIENT.
+void detectGradientEdges(const cv::Mat& gray, cv::Mat& edges);
+
+// detectGradientEdges straight into a 1-bpp bitmap (packed_edges.h)
+void detectGradientEdgesPacked(const cv::Mat& gray, cv::Mat& bits);
+
+// detectEdges through the in-house kernel (the tiled one while TILED is
+// selected) with a record per edge pixel into sink (canny_kernel.h); the
+// edge map matches detectEdges' up to the backend's tolerance
+void detectEdgesWithRecords(const cv::Mat& gray, cv::Mat& edges, EdgeRecordSink& sink);
+
+// MULTISCALE_EDGES: detectEdges on gray, kept only where Canny on a coarser
+// level of the frame's pyramid (pyramid_cache.h; levels 1..levels-1) sees an
+// edge within one coarse pixel. Fine localization, with the texture and
+// sensor noise no coarser level confirms removed. Outside a
+// ScopedPyramidFrame for gray this is detectEdges.
+void detectMultiscaleEdges(const cv::Mat& gray, cv::Mat& edges, int levels);
+
+// COLOR_EDGES: cannyU8Color (canny_kernel.h) of an NV21 frame's luma and
+// half-resolution VU plane with the current thresholds and pre-blur, tiled
+// while TILED is selected; feeds the adaptive thresholds like detectEdges
+void detectColorEdges(const cv::Mat& luma, const cv::Mat& vu, cv::Mat& edges);
+
+// Canny on 10-bit luma (CV_16SC1, 0..1023; P010 ingest, frame_ingest.h): the
+// Sobel gradients are taken in 16 bits and cv::Canny runs on them with the
+// current thresholds scaled to the 10-bit range, so gradients the 8-bit
+// samples round away still count. gray is the same frame in 8 bits, which
+// feeds the adaptive thresholds like detectEdges.
+void detectEdges10(const cv::Mat& luma10, const cv::Mat& gray, cv::Mat& edges);
+
+// Feeds a frame's luma to the adaptive thresholds, for frames that skip
+// detectEdges; no-op with fixed thresholds
+void updateEdgeThresholds(const cv::Mat& gray);
+
+// Fixed Canny thresholds (100/200 by default) or thresholds derived from the
+// median luma of the previous frames, smoothed over time
+void setAdaptiveThresholds(bool enabled);
+bool adaptiveThresholdsEnabled();
+
+// The fixed thresholds, clamped to 0..255 with high above low; take effect at
+// once unless adaptive thresholds are on
+void setFixedCannyThresholds(int low, int high);
+
+// 5x5 Gaussian before Canny against sensor speckle. The in-house kernels fuse
+// it into their gradient pass (canny_kernel.h); cv::Canny gets a separate
+// GaussianBlur. Off by default.
+void setEdgePreBlur(bool enabled);
+bool edgePreBlurEnabled();
+
+// With fed=true the adaptive thresholds stop sampling frames themselves and
+// follow feedLumaMedian instead (the one-pass statistics in luma_stats.h)
+void useFedLumaMedian(bool fed);
+void feedLumaMedian(int median);
+
+// Thresholds the next detectEdges call will use
+void currentCannyThresholds(int& low, int& high);
+
+// Implementation behind detectEdges. AUTO times each one on the first frames
+// and keeps the fastest; the others pin a choice.
+enum class CannyBackend : int {
+    AUTO = 0,
+    OPENCV = 1,   // cv::Canny
+    KERNEL = 2,   // cannyU8 (canny_kernel.h)
+    TILED = 3,    // cannyU8Tiled: L2-sized bands, band-parallel hysteresis
+    GRADIENT = 4, // FAST_EDGES: thresholded Sobel magnitude, never chosen by AUTO
+    BOUNDED = 5,  // cannyU8Bounded: tiled, hysteresis of fixed worst-case cost; never chosen by AUTO
+};
+
+void setCannyBackend(CannyBackend backend);
+
+// One run of backend with the current thresholds and pre-blur, leaving the
+// thresholds alone (the backend autotuner's timed call)
+void cannyWithBackend(CannyBackend backend, const cv::Mat& gray, cv::Mat& edges);
+
+// The implementation detectEdges currently runs (AUTO while still
+// calibrating); BOUNDED in place of any Canny while the quality governor's
+// level asks for bounded hysteresis
+CannyBackend activeCannyBackend();
+
+// For logs and reports
+const char* cannyBackendName(CannyBackend backend);
+
 #endif // IMAGE_PROCESSOR_H
@@ -0,0 +1,85 @@
+#include "image_rotate.h"
+#include "kernel_dispatch.h"
+#include <opencv2/core/utility.hpp>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const int kBlock = 8;
+const int kTileSize = 64;  // a multiple of kBlock
+
+// Each range covers bands of kTileSize source rows
+class QuarterTurnBody : public cv::ParallelLoopBody {
+public:
+    QuarterTurnBody(const cv::Mat& src, bool clockwise, cv::Mat& dst) : src(src), clockwise(clockwise), dst(dst) {}
+
+    void operator()(const cv::Range& range) const override {
+        const EdgeKernels& kernels = edgeKernels();
+        const int channels = src.channels();
+        const TransposeBlockFn transpose = channels == 1 ? kernels.transposeBlockC1 : kernels.transposeBlockC3;
+        const int width = src.cols;
+        const int height = src.rows;
+        const ptrdiff_t srcStep = static_cast<ptrdiff_t>(src.step);
+        const ptrdiff_t dstStep = static_cast<ptrdiff_t>(dst.step);
+        for (int band = range.start; band < range.end; band++) {
+            const int tileY = band * kTileSize;
+            const int tileRows = std::min(kTileSize, height - tileY);
+            for (int tileX = 0; tileX < width; tileX += kTileSize) {
+                const int tileCols = std::min(kTileSize, width - tileX);
+                for (int y0 = tileY; y0 < tileY + tileRows; y0 += kBlock) {
+                    for (int x0 = tileX; x0 < tileX + tileCols; x0 += kBlock) {
+                        if (y0 + kBlock > height || x0 + kBlock > width) {
+                            copyPartialBlock(x0, y0, channels);
+                        } else if (clockwise) {
+                            // src rows bottom-up: dst(x, height - 1 - y)
+                            transpose(src.ptr<uint8_t>(y0 + kBlock - 1) + x0 * channels, -srcStep,
+                                      dst.ptr<uint8_t>(x0) + (height - kBlock - y0) * channels, dstStep);
+                        } else {
+                            // dst rows bottom-up: dst(width - 1 - x, y)
+                            transpose(src.ptr<uint8_t>(y0) + x0 * channels, srcStep,
+                                      dst.ptr<uint8_t>(width - 1 - x0) + y0 * channels, -dstStep);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    // Blocks cut by the right or bottom edge, pixel by pixel
+    void copyPartialBlock(int x0, int y0, int channels) const {
+        const int rows = std::min(kBlock, src.rows - y0);
+        const int cols = std::min(kBlock, src.cols - x0);
+        for (int y = y0; y < y0 + rows; y++) {
+            const uint8_t* in = src.ptr<uint8_t>(y);
+            for (int x = x0; x < x0 + cols; x++) {
+                uint8_t* out = clockwise ? dst.ptr<uint8_t>(x) + (src.rows - 1 - y) * channels
+                                         : dst.ptr<uint8_t>(src.cols - 1 - x) + y * channels;
+                std::memcpy(out, in + x * channels, static_cast<size_t>(channels));
+            }
+        }
+    }
+
+    const cv::Mat& src;
+    bool clockwise;
+    cv::Mat& dst;
+};
+
+} // namespace
+
+void rotateImage(const cv::Mat& src, int rotation, cv::Mat& dst) {
+    const bool quarterTurn = rotation == 90 || rotation == 270;
+    if (!quarterTurn || src.empty() || (src.type() != CV_8UC1 && src.type() != CV_8UC3)) {
+        switch (rotation) {
+            case 90: cv::rotate(src, dst, cv::ROTATE_90_CLOCKWISE); break;
+            case 180: cv::rotate(src, dst, cv::ROTATE_180); break;
+            case 270: cv::rotate(src, dst, cv::ROTATE_90_COUNTERCLOCKWISE); break;
+            default: src.copyTo(dst); break;
+        }
+        return;
+    }
+    dst.create(src.cols, src.rows, src.type());
+    cv::parallel_for_(cv::Range(0, (src.rows + kTileSize - 1) / kTileSize),
+                      QuarterTurnBody(src, rotation == 90, dst));
+}
@@ -0,0 +1,15 @@
+#ifndef EDGE_IMAGE_ROTATE_H
+#define EDGE_IMAGE_ROTATE_H
+
+#include <opencv2/core.hpp>
+
+// Clockwise rotation by 0, 90, 180 or 270 degrees of 8-bit 1-channel (luma,
+// edges) or 3-channel (BGR) images, for the CPU consumers that still need
+// upright pixels. Quarter turns walk the image in 64x64 tiles of 8x8 blocks
+// transposed in registers (EdgeKernels::transposeBlockC1 / C3): every tile's
+// source rows and destination rows stay cache-resident, where a pixel-wise
+// transpose touches a new destination line per pixel. Same pixels as
+// cv::rotate; other types and rotations go through it. dst must not alias src.
+void rotateImage(const cv::Mat& src, int rotation, cv::Mat& dst);
+
+#endif // EDGE_IMAGE_ROTATE_H
@@ -0,0 +1,234 @@
+#include "incremental_edges.h"
+#include "canny_kernel.h"
+#include "image_processor.h"
+#include "metrics.h"
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define EDGE_SAD_NEON 1
+#endif
+
+namespace {
+
+const int kBlockSize = 32;
+
+// A block counts as changed once its mean absolute difference exceeds this;
+// camera noise on a static scene stays around 1-2 levels
+const int kChangedMeanDifference = 3;
+
+// Extra pixels around a recomputed run: Sobel and non-max suppression reach
+// two pixels, the rest keeps short hysteresis chains intact
+const int kHalo = 8;
+
+// Beyond this share of changed blocks a full pass is cheaper than the windows
+const float kFullPassFraction = 0.5f;
+
+// Uploads the changed blocks may take per frame: beyond it the two rects whose
+// bounding box wastes the fewest blocks are merged, and so are rects it costs
+// at most one block to merge, whatever the count. Above kMaxCoverRects the
+// cover is first cut down to that many horizontal bands.
+const size_t kMaxChangedRects = 8;
+const size_t kMaxCoverRects = 64;
+
+// Covers the changed blocks with rectangles: a run of a block row grows
+// downwards while the rows below change over the same span. Clears changed.
+void coverChangedBlocks(std::vector<uchar>& changed, int blocksX, int blocksY, std::vector<cv::Rect>& rects) {
+    rects.clear();
+    for (int by = 0; by < blocksY; by++) {
+        for (int bx = 0; bx < blocksX; bx++) {
+            if (!changed[by * blocksX + bx]) {
+                continue;
+            }
+            int runEnd = bx;
+            while (runEnd < blocksX && changed[by * blocksX + runEnd]) {
+                runEnd++;
+            }
+            int rowEnd = by + 1;
+            for (; rowEnd < blocksY; rowEnd++) {
+                const uchar* row = &changed[rowEnd * blocksX];
+                if (std::find(row + bx, row + runEnd, 0) != row + runEnd) {
+                    break;
+                }
+            }
+            for (int y = by; y < rowEnd; y++) {
+                std::fill(&changed[y * blocksX + bx], &changed[y * blocksX + runEnd], 0);
+            }
+            rects.emplace_back(bx, by, runEnd - bx, rowEnd - by);
+            bx = runEnd - 1;
+        }
+    }
+}
+
+void coalesceRects(std::vector<cv::Rect>& rects, int blocksY) {
+    if (rects.size() > kMaxCoverRects) {
+        std::vector<cv::Rect> bands(kMaxCoverRects);
+        for (const cv::Rect& rect : rects) {
+            cv::Rect& band = bands[static_cast<size_t>(rect.y) * kMaxCoverRects / blocksY];
+            band = band.empty() ? rect : band | rect;
+        }
+        rects.clear();
+        for (const cv::Rect& band : bands) {
+            if (!band.empty()) {
+                rects.push_back(band);
+            }
+        }
+    }
+    while (rects.size() > 1) {
+        size_t first = 0;
+        size_t second = 1;
+        int bestWaste = INT_MAX;
+        for (size_t i = 0; i < rects.size(); i++) {
+            for (size_t j = i + 1; j < rects.size(); j++) {
+                const int waste = (rects[i] | rects[j]).area() - rects[i].area() - rects[j].area();
+                if (waste < bestWaste) {
+                    bestWaste = waste;
+                    first = i;
+                    second = j;
+                }
+            }
+        }
+        if (rects.size() <= kMaxChangedRects && bestWaste > 1) {
+            break;
+        }
+        rects[first] |= rects[second];
+        rects.erase(rects.begin() + static_cast<std::ptrdiff_t>(second));
+    }
+}
+
+// True once the sum of absolute differences over rect exceeds limit
+bool blockChanged(const cv::Mat& a, const cv::Mat& b, const cv::Rect& rect, uint32_t limit) {
+#ifdef EDGE_SAD_NEON
+    static const bool useNeon = cannyKernelUsesNeon();
+#endif
+    uint32_t sad = 0;
+    for (int y = rect.y; y < rect.y + rect.height; y++) {
+        const uchar* pa = a.ptr<uchar>(y) + rect.x;
+        const uchar* pb = b.ptr<uchar>(y) + rect.x;
+        int x = 0;
+#ifdef EDGE_SAD_NEON
+        if (useNeon) {
+            uint16x8_t acc = vdupq_n_u16(0);
+            for (; x + 16 <= rect.width; x += 16) {
+                acc = vpadalq_u8(acc, vabdq_u8(vld1q_u8(pa + x), vld1q_u8(pb + x)));
+            }
+            uint64x2_t total = vpaddlq_u32(vpaddlq_u16(acc));
+            sad += static_cast<uint32_t>(vgetq_lane_u64(total, 0) + vgetq_lane_u64(total, 1));
+        }
+#endif
+        for (; x < rect.width; x++) {
+            sad += static_cast<uint32_t>(std::abs(pa[x] - pb[x]));
+        }
+        if (sad > limit) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+void IncrementalEdgeDetector::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    reference.release();
+    cached.release();
+    cachedResult = 0;
+}
+
+void IncrementalEdgeDetector::detectFull(const cv::Mat& gray, cv::Mat& edges, int low, int high) {
+    detectEdges(gray, edges);
+    gray.copyTo(reference);
+    cached = edges;
+    cachedLow = low;
+    cachedHigh = high;
+}
+
+void IncrementalEdgeDetector::detect(const cv::Mat& gray, cv::Mat& edges, Changes* changes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    edges.create(gray.size(), CV_8UC1);
+    const int blocksX = (gray.cols + kBlockSize - 1) / kBlockSize;
+    const int blocksY = (gray.rows + kBlockSize - 1) / kBlockSize;
+    const int blockCount = blocksX * blocksY;
+
+    int low, high;
+    currentCannyThresholds(low, high);
+    const uint64_t base = cachedResult;
+    cachedResult = nextResult++;
+    if (changes) {
+        changes->result = cachedResult;
+        changes->base = 0;
+        changes->rects.clear();
+    }
+    if (cached.empty() || cached.size() != gray.size() || low != cachedLow || high != cachedHigh) {
+        detectFull(gray, edges, low, high);
+        metrics().increment(Counter::EDGE_BLOCKS_RECOMPUTED, blockCount);
+        return;
+    }
+    // Adaptive thresholds still follow the scene when detectEdges is skipped
+    updateEdgeThresholds(gray);
+
+    changed.assign(static_cast<size_t>(blockCount), 0);
+    int changedCount = 0;
+    for (int by = 0; by < blocksY; by++) {
+        for (int bx = 0; bx < blocksX; bx++) {
+            cv::Rect block(bx * kBlockSize, by * kBlockSize, kBlockSize, kBlockSize);
+            block &= cv::Rect(0, 0, gray.cols, gray.rows);
+            uint32_t limit = static_cast<uint32_t>(block.area() * kChangedMeanDifference);
+            if (blockChanged(gray, reference, block, limit)) {
+                changed[by * blocksX + bx] = 1;
+                changedCount++;
+            }
+        }
+    }
+
+    if (changedCount > kFullPassFraction * blockCount) {
+        detectFull(gray, edges, low, high);
+        metrics().increment(Counter::EDGE_BLOCKS_RECOMPUTED, blockCount);
+        return;
+    }
+
+    cached.copyTo(edges);
+    for (int by = 0; by < blocksY; by++) {
+        for (int bx = 0; bx < blocksX;) {
+            if (!changed[by * blocksX + bx]) {
+                bx++;
+                continue;
+            }
+            // One Canny window per horizontal run of changed blocks
+            int runEnd = bx;
+            while (runEnd < blocksX && changed[by * blocksX + runEnd]) {
+                runEnd++;
+            }
+            const cv::Rect frame(0, 0, gray.cols, gray.rows);
+            cv::Rect inner = cv::Rect(bx * kBlockSize, by * kBlockSize,
+                                      (runEnd - bx) * kBlockSize, kBlockSize) & frame;
+            cv::Rect outer = cv::Rect(inner.x - kHalo, inner.y - kHalo,
+                                      inner.width + 2 * kHalo, inner.height + 2 * kHalo) & frame;
+            detectEdgesPartial(gray(outer), scratch);
+            scratch(inner - outer.tl()).copyTo(edges(inner));
+            gray(inner).copyTo(reference(inner));
+            bx = runEnd;
+        }
+    }
+    cached = edges;
+    if (changes) {
+        // Only the inner windows were written; everything else is the cache
+        coverChangedBlocks(changed, blocksX, blocksY, cover);
+        coalesceRects(cover, blocksY);
+        const cv::Rect frame(0, 0, gray.cols, gray.rows);
+        for (const cv::Rect& blocks : cover) {
+            changes->rects.push_back(cv::Rect(blocks.x * kBlockSize, blocks.y * kBlockSize,
+                                              blocks.width * kBlockSize, blocks.height * kBlockSize) & frame);
+        }
+        changes->base = base;
+    }
+    metrics().increment(Counter::EDGE_BLOCKS_RECOMPUTED, changedCount);
+    metrics().increment(Counter::EDGE_BLOCKS_REUSED, blockCount - changedCount);
+}
+
+IncrementalEdgeDetector& incrementalEdgeDetector() {
+    static IncrementalEdgeDetector detector;
+    return detector;
+}
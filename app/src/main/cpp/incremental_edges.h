@@ -0,0 +1,54 @@
+#ifndef EDGE_INCREMENTAL_EDGES_H
+#define EDGE_INCREMENTAL_EDGES_H
+
+#include <opencv2/core.hpp>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Canny for mostly static scenes. Each 32x32 luma block is compared with the
+// luma its cached edges were computed from (SAD with a per-row early exit,
+// NEON where available); only runs of changed blocks, widened by a halo, go
+// through Canny again and everything else is copied from the last result.
+// Hysteresis chains leaving a recomputed window are cut at its border, so
+// edges next to changed blocks may differ slightly from a full-frame pass. A
+// full pass runs on the first frame, when the size or thresholds change, and
+// when most blocks changed anyway.
+class IncrementalEdgeDetector {
+public:
+    // What one result changed against the one before it, for consumers that
+    // keep a copy (the renderer's texture): every pixel of result that
+    // differs from base lies in rects, the changed blocks coalesced into a
+    // few larger rectangles. base is 0 after a full pass (all of it changed).
+    struct Changes {
+        uint64_t result = 0;  // unique per detect call
+        uint64_t base = 0;
+        std::vector<cv::Rect> rects;
+    };
+
+    // edges receives a fresh result and becomes the cache; the caller must not
+    // modify it afterwards (published buffers are immutable anyway)
+    void detect(const cv::Mat& gray, cv::Mat& edges, Changes* changes = nullptr);
+
+    // Forgets the cache, e.g. when the ROI moved within a same-sized frame
+    void reset();
+
+private:
+    void detectFull(const cv::Mat& gray, cv::Mat& edges, int low, int high);
+
+    std::mutex mutex;
+    cv::Mat reference;           // luma the cached edges were computed from (own copy)
+    cv::Mat cached;              // last output, read only
+    cv::Mat scratch;             // Canny output for one recomputed window
+    std::vector<uchar> changed;  // per block, row-major
+    int cachedLow = -1;
+    int cachedHigh = -1;
+    uint64_t cachedResult = 0;   // Changes::result of cached; 0 = none
+    uint64_t nextResult = 1;
+    std::vector<cv::Rect> cover; // changed blocks as rectangles, in block units
+};
+
+// Detector used by the preview pipeline
+IncrementalEdgeDetector& incrementalEdgeDetector();
+
+#endif // EDGE_INCREMENTAL_EDGES_H
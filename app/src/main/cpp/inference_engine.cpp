@@ -0,0 +1,408 @@
+#include "inference_engine.h"
+#include "mapped_asset.h"
+#include <opencv2/dnn.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <dlfcn.h>
+#include <initializer_list>
+#include <vector>
+
+#define LOG_TAG "InferenceEngine"
+#include "logging.h"
+
+namespace {
+
+// The TensorFlow Lite C API (tensorflow/lite/c/c_api.h), declared here so
+// the build needs neither its headers nor a link against a runtime the app
+// may not package
+struct TfLiteModel;
+struct TfLiteInterpreterOptions;
+struct TfLiteInterpreter;
+struct TfLiteTensor;
+struct TfLiteDelegate;
+
+struct TfLiteQuantizationParams {
+    float scale;
+    int32_t zero_point;
+};
+
+const int kTfLiteOk = 0;
+
+// TfLiteType values
+const int kTfLiteFloat32 = 1;
+const int kTfLiteUInt8 = 3;
+const int kTfLiteInt8 = 9;
+const int kTfLiteFloat16 = 10;
+
+struct TfLiteApi {
+    TfLiteModel* (*modelCreate)(const void*, size_t) = nullptr;
+    void (*modelDelete)(TfLiteModel*) = nullptr;
+    TfLiteInterpreterOptions* (*optionsCreate)() = nullptr;
+    void (*optionsDelete)(TfLiteInterpreterOptions*) = nullptr;
+    void (*optionsSetNumThreads)(TfLiteInterpreterOptions*, int32_t) = nullptr;
+    void (*optionsAddDelegate)(TfLiteInterpreterOptions*, TfLiteDelegate*) = nullptr;
+    TfLiteInterpreter* (*interpreterCreate)(const TfLiteModel*, const TfLiteInterpreterOptions*) = nullptr;
+    void (*interpreterDelete)(TfLiteInterpreter*) = nullptr;
+    int (*allocateTensors)(TfLiteInterpreter*) = nullptr;
+    TfLiteTensor* (*inputTensor)(const TfLiteInterpreter*, int32_t) = nullptr;
+    const TfLiteTensor* (*outputTensor)(const TfLiteInterpreter*, int32_t) = nullptr;
+    int (*invoke)(TfLiteInterpreter*) = nullptr;
+    int (*tensorType)(const TfLiteTensor*) = nullptr;
+    int32_t (*tensorNumDims)(const TfLiteTensor*) = nullptr;
+    int32_t (*tensorDim)(const TfLiteTensor*, int32_t) = nullptr;
+    void* (*tensorData)(const TfLiteTensor*) = nullptr;
+    TfLiteQuantizationParams (*tensorQuantization)(const TfLiteTensor*) = nullptr;
+
+    // GPU delegate (tensorflow/lite/delegates/gpu/delegate.h); null options
+    // take its defaults
+    TfLiteDelegate* (*gpuDelegateCreate)(const void*) = nullptr;
+    void (*gpuDelegateDelete)(TfLiteDelegate*) = nullptr;
+
+    bool available() const {
+        return modelCreate && modelDelete && optionsCreate && optionsDelete && optionsSetNumThreads &&
+               optionsAddDelegate && interpreterCreate && interpreterDelete && allocateTensors && inputTensor &&
+               outputTensor && invoke && tensorType && tensorNumDims && tensorDim && tensorData && tensorQuantization;
+    }
+    bool gpuAvailable() const { return available() && gpuDelegateCreate && gpuDelegateDelete; }
+};
+
+void* openFirst(std::initializer_list<const char*> names) {
+    for (const char* name : names) {
+        if (void* library = dlopen(name, RTLD_NOW)) {
+            return library;
+        }
+    }
+    return nullptr;
+}
+
+template <typename F>
+void bind(void* library, const char* name, F& function) {
+    function = reinterpret_cast<F>(dlsym(library, name));
+}
+
+const TfLiteApi& tfLiteApi() {
+    static const TfLiteApi api = [] {
+        TfLiteApi loaded;
+        void* library = openFirst({"libtensorflowlite_c.so", "libtensorflowlite_jni.so"});
+        if (!library) {
+            return loaded;
+        }
+        bind(library, "TfLiteModelCreate", loaded.modelCreate);
+        bind(library, "TfLiteModelDelete", loaded.modelDelete);
+        bind(library, "TfLiteInterpreterOptionsCreate", loaded.optionsCreate);
+        bind(library, "TfLiteInterpreterOptionsDelete", loaded.optionsDelete);
+        bind(library, "TfLiteInterpreterOptionsSetNumThreads", loaded.optionsSetNumThreads);
+        bind(library, "TfLiteInterpreterOptionsAddDelegate", loaded.optionsAddDelegate);
+        bind(library, "TfLiteInterpreterCreate", loaded.interpreterCreate);
+        bind(library, "TfLiteInterpreterDelete", loaded.interpreterDelete);
+        bind(library, "TfLiteInterpreterAllocateTensors", loaded.allocateTensors);
+        bind(library, "TfLiteInterpreterGetInputTensor", loaded.inputTensor);
+        bind(library, "TfLiteInterpreterGetOutputTensor", loaded.outputTensor);
+        bind(library, "TfLiteInterpreterInvoke", loaded.invoke);
+        bind(library, "TfLiteTensorType", loaded.tensorType);
+        bind(library, "TfLiteTensorNumDims", loaded.tensorNumDims);
+        bind(library, "TfLiteTensorDim", loaded.tensorDim);
+        bind(library, "TfLiteTensorData", loaded.tensorData);
+        bind(library, "TfLiteTensorQuantizationParams", loaded.tensorQuantization);
+
+        // The delegate ships in its own library (the tensorflow-lite-gpu AAR)
+        // or inside a custom runtime build
+        void* gpu = openFirst({"libtensorflowlite_gpu_delegate.so", "libtensorflowlite_gpu_jni.so"});
+        bind(gpu ? gpu : library, "TfLiteGpuDelegateV2Create", loaded.gpuDelegateCreate);
+        bind(gpu ? gpu : library, "TfLiteGpuDelegateV2Delete", loaded.gpuDelegateDelete);
+        return loaded;
+    }();
+    return api;
+}
+
+// Warm-up: layer allocation, kernel compilation and weight conversion all
+// happen on the first inference
+bool warmUp(InferenceEngine& engine) {
+    const cv::Size size = engine.inputSize();
+    const cv::Mat luma = cv::Mat::zeros(size, CV_8UC1);
+    cv::Mat output;
+    const int64 start = cv::getTickCount();
+    try {
+        engine.run(luma, cv::Mat(), output);
+    } catch (const cv::Exception& e) {
+        LOGW("⚠️ %s warm-up failed: %s", inferenceEngineName(engine.kind()), e.what());
+        return false;
+    }
+    LOGI("✅ %s ready (%dx%d), warm-up %.1f ms", inferenceEngineName(engine.kind()), size.width, size.height,
+         (cv::getTickCount() - start) * 1000.0 / cv::getTickFrequency());
+    return true;
+}
+
+class OpenCvDnnEngine : public InferenceEngine {
+public:
+    OpenCvDnnEngine(cv::dnn::Net net, const BlobSpec& spec) : net(std::move(net)), spec(spec) {
+        this->spec.nhwc = false;
+    }
+
+    Kind kind() const override { return OPENCV_DNN; }
+    cv::Size inputSize() const override { return spec.size; }
+
+    void run(const cv::Mat& luma, const cv::Mat& chroma, cv::Mat& output) override {
+        if (!nv21ToBlob(luma, chroma, spec, blob)) {
+            CV_Error(cv::Error::StsBadArg, "network input is not an NV21 frame");
+        }
+        net.setInput(blob);
+        cv::Mat result = net.forward();
+        // 1 x C x H x W; the first channel
+        cv::Mat(result.size[2], result.size[3], CV_32F, result.ptr<float>()).copyTo(output);
+    }
+
+    cv::dnn::Net net;
+
+private:
+    BlobSpec spec;
+    cv::Mat blob;  // reused network input
+};
+
+std::string extension(const std::string& path) {
+    const size_t dot = path.rfind('.');
+    std::string result = dot == std::string::npos ? std::string() : path.substr(dot + 1);
+    std::transform(result.begin(), result.end(), result.begin(), ::tolower);
+    return result;
+}
+
+// The formats the app ships are parsed from the mapping (mapped_asset.h), so
+// neither the file nor an asset is read into a heap copy first; the rest
+// go through readNet's own file reading and cannot come from assets
+cv::dnn::Net readMappedNet(const std::string& model, const std::string& config) {
+    const std::string format = extension(model);
+    if (format != "onnx" && format != "tflite" && format != "caffemodel" && format != "pb") {
+        if (isAssetPath(model) || isAssetPath(config)) {
+            CV_Error(cv::Error::StsNotImplemented, "only ONNX, TFLite, Caffe and TensorFlow models load from assets");
+        }
+        return cv::dnn::readNet(model, config);
+    }
+    std::shared_ptr<MappedAsset> weights = MappedAsset::open(model);
+    std::shared_ptr<MappedAsset> text = config.empty() ? nullptr : MappedAsset::open(config);
+    if (!weights || (!config.empty() && !text)) {
+        CV_Error(cv::Error::StsObjectNotFound, "model or config cannot be mapped");
+    }
+    const char* textData = text ? text->data() : nullptr;
+    const size_t textSize = text ? text->size() : 0;
+    if (format == "onnx") {
+        return cv::dnn::readNetFromONNX(weights->data(), weights->size());
+    }
+    if (format == "tflite") {
+        return cv::dnn::readNetFromTFLite(weights->data(), weights->size());
+    }
+    if (format == "caffemodel") {
+        return cv::dnn::readNetFromCaffe(textData, textSize, weights->data(), weights->size());
+    }
+    return cv::dnn::readNetFromTensorflow(weights->data(), weights->size(), textData, textSize);
+}
+
+bool targetAvailable(cv::dnn::Target target) {
+    std::vector<cv::dnn::Target> targets = cv::dnn::getAvailableTargets(cv::dnn::DNN_BACKEND_OPENCV);
+    return std::find(targets.begin(), targets.end(), target) != targets.end();
+}
+
+class TfLiteEngine : public InferenceEngine {
+public:
+    ~TfLiteEngine() override {
+        // The interpreter uses the delegate and the model until it is gone
+        const TfLiteApi& api = tfLiteApi();
+        if (interpreter) {
+            api.interpreterDelete(interpreter);
+        }
+        if (delegate) {
+            api.gpuDelegateDelete(delegate);
+        }
+        if (options) {
+            api.optionsDelete(options);
+        }
+        if (model) {
+            api.modelDelete(model);
+        }
+    }
+
+    Kind kind() const override { return delegate ? TFLITE_GPU : TFLITE_CPU; }
+    cv::Size inputSize() const override { return spec.size; }
+
+    bool open(const std::string& path, const BlobSpec& normalization, bool gpu, int threads) {
+        const TfLiteApi& api = tfLiteApi();
+        // The flatbuffer is used in place: weights stay in the mapping, which
+        // lives as long as the model
+        weights = MappedAsset::open(path);
+        model = weights ? api.modelCreate(weights->data(), weights->size()) : nullptr;
+        if (!model) {
+            LOGE("❌ Cannot read TFLite model %s", path.c_str());
+            return false;
+        }
+        options = api.optionsCreate();
+        api.optionsSetNumThreads(options, threads);
+        if (gpu) {
+            delegate = api.gpuDelegateCreate(nullptr);
+            if (delegate) {
+                api.optionsAddDelegate(options, delegate);
+            }
+        }
+        // Delegation happens here; a graph the delegate rejects fails the create
+        interpreter = api.interpreterCreate(model, options);
+        if (!interpreter || api.allocateTensors(interpreter) != kTfLiteOk) {
+            return false;
+        }
+
+        // NHWC input of the model's type
+        const TfLiteTensor* input = api.inputTensor(interpreter, 0);
+        const TfLiteTensor* result = api.outputTensor(interpreter, 0);
+        if (!input || !result || api.tensorNumDims(input) != 4) {
+            LOGE("❌ TFLite model %s has no 1 x H x W x C input", path.c_str());
+            return false;
+        }
+        spec = normalization;
+        spec.nhwc = true;
+        spec.size = cv::Size(api.tensorDim(input, 2), api.tensorDim(input, 1));
+        spec.channels = api.tensorDim(input, 3);
+        switch (api.tensorType(input)) {
+            case kTfLiteFloat32: spec.depth = CV_32F; break;
+            case kTfLiteFloat16: spec.depth = CV_16F; break;
+            case kTfLiteUInt8: spec.depth = CV_8U; break;
+            case kTfLiteInt8: spec.depth = CV_8S; break;
+            default:
+                LOGE("❌ TFLite model %s input type %d is not supported", path.c_str(), api.tensorType(input));
+                return false;
+        }
+        if (spec.depth == CV_8U || spec.depth == CV_8S) {
+            const TfLiteQuantizationParams quantization = api.tensorQuantization(input);
+            spec.quantScale = quantization.scale;
+            spec.zeroPoint = quantization.zero_point;
+        }
+        if (spec.channels != 1 && spec.channels != 3) {
+            LOGE("❌ TFLite model %s takes %d channels", path.c_str(), spec.channels);
+            return false;
+        }
+        return true;
+    }
+
+    void run(const cv::Mat& luma, const cv::Mat& chroma, cv::Mat& output) override {
+        const TfLiteApi& api = tfLiteApi();
+        // Written in place: the tensor is the only copy of the input
+        if (!nv21ToTensor(luma, chroma, spec, api.tensorData(api.inputTensor(interpreter, 0)))) {
+            CV_Error(cv::Error::StsBadArg, "network input is not an NV21 frame");
+        }
+        if (api.invoke(interpreter) != kTfLiteOk) {
+            CV_Error(cv::Error::StsError, "TfLiteInterpreterInvoke failed");
+        }
+        // 1 x H x W (x C); the first channel
+        const TfLiteTensor* result = api.outputTensor(interpreter, 0);
+        const int dims = api.tensorNumDims(result);
+        if (dims < 3) {
+            CV_Error(cv::Error::StsUnmatchedSizes, "TFLite output is not a map");
+        }
+        const int rows = api.tensorDim(result, 1);
+        const int cols = api.tensorDim(result, 2);
+        const int channels = dims > 3 ? api.tensorDim(result, 3) : 1;
+        const void* data = api.tensorData(result);
+        switch (api.tensorType(result)) {
+            case kTfLiteFloat32:
+                cv::Mat(rows, cols, CV_32FC(channels), const_cast<void*>(data)).copyTo(plane);
+                break;
+            case kTfLiteFloat16:
+                cv::Mat(rows, cols, CV_16FC(channels), const_cast<void*>(data)).copyTo(plane);
+                break;
+            case kTfLiteUInt8:
+            case kTfLiteInt8: {
+                const TfLiteQuantizationParams quantization = api.tensorQuantization(result);
+                const int type = api.tensorType(result) == kTfLiteUInt8 ? CV_8UC(channels) : CV_8SC(channels);
+                cv::Mat(rows, cols, type, const_cast<void*>(data))
+                        .convertTo(plane, CV_32F, quantization.scale, -quantization.zero_point * quantization.scale);
+                break;
+            }
+            default:
+                CV_Error(cv::Error::StsUnsupportedFormat, "TFLite output type is not supported");
+        }
+        if (plane.depth() != CV_32F) {
+            plane.convertTo(plane, CV_32F);
+        }
+        if (channels > 1) {
+            cv::extractChannel(plane, output, 0);
+        } else {
+            plane.copyTo(output);
+        }
+    }
+
+private:
+    TfLiteModel* model = nullptr;
+    TfLiteInterpreterOptions* options = nullptr;
+    TfLiteDelegate* delegate = nullptr;
+    TfLiteInterpreter* interpreter = nullptr;
+    std::shared_ptr<MappedAsset> weights;  // released after the model
+    BlobSpec spec;
+    cv::Mat plane;  // output scratch
+};
+
+} // namespace
+
+const char* inferenceEngineName(InferenceEngine::Kind kind) {
+    switch (kind) {
+        case InferenceEngine::OPENCV_DNN: return "cv::dnn";
+        case InferenceEngine::TFLITE_CPU: return "TFLite CPU";
+        case InferenceEngine::TFLITE_GPU: return "TFLite GPU";
+    }
+    return "unknown";
+}
+
+bool tfLiteAvailable() {
+    return tfLiteApi().available();
+}
+
+bool tfLiteGpuAvailable() {
+    return tfLiteApi().gpuAvailable();
+}
+
+std::unique_ptr<InferenceEngine> createOpenCvDnnEngine(const std::string& model, const std::string& config,
+                                                       const BlobSpec& spec, bool preferOpenClFp16) {
+    cv::dnn::Net net;
+    try {
+        net = readMappedNet(model, config);
+    } catch (const cv::Exception& e) {
+        LOGE("❌ Cannot read model %s: %s", model.c_str(), e.what());
+        return nullptr;
+    }
+    if (net.empty()) {
+        LOGE("❌ Model %s is empty", model.c_str());
+        return nullptr;
+    }
+    std::unique_ptr<OpenCvDnnEngine> engine(new OpenCvDnnEngine(net, spec));
+    engine->net.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
+    if (preferOpenClFp16 && targetAvailable(cv::dnn::DNN_TARGET_OPENCL_FP16)) {
+        engine->net.setPreferableTarget(cv::dnn::DNN_TARGET_OPENCL_FP16);
+        if (warmUp(*engine)) {
+            LOGI("✅ Model %s on OpenCL FP16", model.c_str());
+            return engine;
+        }
+    }
+    engine->net.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+    if (!warmUp(*engine)) {
+        return nullptr;
+    }
+    LOGI("✅ Model %s on the CPU", model.c_str());
+    return engine;
+}
+
+std::unique_ptr<InferenceEngine> createTfLiteEngine(const std::string& model, const BlobSpec& spec, bool gpu,
+                                                    int threads) {
+    const TfLiteApi& api = tfLiteApi();
+    if (!api.available()) {
+        LOGW("⚠️ TensorFlow Lite runtime not packaged");
+        return nullptr;
+    }
+    if (gpu && api.gpuAvailable()) {
+        std::unique_ptr<TfLiteEngine> engine(new TfLiteEngine());
+        if (engine->open(model, spec, true, threads) && warmUp(*engine)) {
+            return engine;
+        }
+        LOGW("⚠️ GPU delegate cannot run %s, trying the CPU", model.c_str());
+    }
+    std::unique_ptr<TfLiteEngine> engine(new TfLiteEngine());
+    if (engine->open(model, spec, false, threads) && warmUp(*engine)) {
+        return engine;
+    }
+    return nullptr;
+}
@@ -0,0 +1,62 @@
+#ifndef EDGE_INFERENCE_ENGINE_H
+#define EDGE_INFERENCE_ENGINE_H
+
+#include "dnn_blob.h"
+#include <opencv2/core.hpp>
+#include <memory>
+#include <string>
+
+// One learned stage's network behind whichever runtime the device can
+// accelerate it on. An engine owns its preprocessing: run() takes the frame
+// as NV21 planes and writes the input straight into the runtime's tensor
+// (dnn_blob.h), so no caller builds a blob. Engines are created and run on
+// one thread; create() performs the warm-up inference, so a returned engine
+// has already proven it runs on its accelerator.
+class InferenceEngine {
+public:
+    enum Kind {
+        OPENCV_DNN = 0,     // cv::dnn, OpenCL FP16 or CPU
+        TFLITE_CPU = 1,     // TensorFlow Lite, XNNPACK
+        TFLITE_GPU = 2,     // TensorFlow Lite, GPU delegate (OpenCL / GLES)
+    };
+
+    virtual ~InferenceEngine() = default;
+
+    virtual Kind kind() const = 0;
+
+    // Network input, width x height
+    virtual cv::Size inputSize() const = 0;
+
+    // One inference on luma (CV_8UC1) and chroma (CV_8UC2 VU, or empty for
+    // gray). output receives the first output channel as an H x W CV_32F map,
+    // dequantized for int8 / uint8 models. Throws cv::Exception on failure.
+    virtual void run(const cv::Mat& luma, const cv::Mat& chroma, cv::Mat& output) = 0;
+};
+
+const char* inferenceEngineName(InferenceEngine::Kind kind);
+
+// Model paths may name APK assets ("asset:...", mapped_asset.h); both
+// runtimes parse the model from a read-only mapping rather than a heap copy.
+
+// cv::dnn on the model (config may be empty for single-file formats) with
+// the given NCHW input; DNN_TARGET_OPENCL_FP16 when preferred and working,
+// the CPU otherwise. Null when the model cannot be read or run.
+std::unique_ptr<InferenceEngine> createOpenCvDnnEngine(const std::string& model, const std::string& config,
+                                                       const BlobSpec& spec, bool preferOpenClFp16);
+
+// TensorFlow Lite on a .tflite model, through the C API of the runtime the
+// app packages (libtensorflowlite_c.so or the AAR's libtensorflowlite_jni.so),
+// loaded on first use. The input shape and type come from the model: NHWC,
+// float32 or float16, or int8 / uint8 quantized, written with its scale and
+// zero point. With gpu, the GPU delegate is tried first and the CPU taken
+// when the delegate is missing or rejects the graph. spec supplies only the
+// normalization (mean, scale, swapRB). Null when the runtime is not
+// packaged or the model cannot be run.
+std::unique_ptr<InferenceEngine> createTfLiteEngine(const std::string& model, const BlobSpec& spec, bool gpu,
+                                                    int threads);
+
+// Whether the TensorFlow Lite runtime (and its GPU delegate) could be loaded
+bool tfLiteAvailable();
+bool tfLiteGpuAvailable();
+
+#endif // EDGE_INFERENCE_ENGINE_H
@@ -0,0 +1,79 @@
+#include "jni_registry.h"
+#include "work_stealing_pool.h"
+#include <chrono>
+
+#define LOG_TAG "JniRegistry"
+#include "logging.h"
+
+namespace {
+
+JniCache cache;
+
+jclass globalClass(JNIEnv* env, const char* name) {
+    jclass local = env->FindClass(name);
+    if (!local) {
+        env->ExceptionClear();
+        LOGE("❌ Class %s not found", name);
+        return nullptr;
+    }
+    jclass global = static_cast<jclass>(env->NewGlobalRef(local));
+    env->DeleteLocalRef(local);
+    return global;
+}
+
+} // namespace
+
+const JniCache& jniCache() {
+    return cache;
+}
+
+int registerNativeMethods(JNIEnv* env, const char* className, const JNINativeMethod* methods, size_t count) {
+    jclass clazz = env->FindClass(className);
+    if (!clazz) {
+        env->ExceptionClear();
+        LOGW("⚠️ %s not found; its %zu native methods stay unbound", className, count);
+        return 0;
+    }
+    int bound = static_cast<int>(count);
+    if (env->RegisterNatives(clazz, methods, static_cast<jint>(count)) != JNI_OK) {
+        env->ExceptionClear();
+        bound = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (env->RegisterNatives(clazz, &methods[i], 1) == JNI_OK) {
+                bound++;
+            } else {
+                env->ExceptionClear();
+                LOGE("❌ Could not register %s.%s%s", className, methods[i].name, methods[i].signature);
+            }
+        }
+    }
+    env->DeleteLocalRef(clazz);
+    return bound;
+}
+
+// Every native method is bound here, so libedge.so exports nothing but this
+// function (libedge.map.txt) and no call pays for a symbol lookup
+extern "C"
+JNIEXPORT jint JNICALL
+JNI_OnLoad(JavaVM* vm, void* reserved) {
+    (void) reserved;
+    const auto start = std::chrono::steady_clock::now();
+    JNIEnv* env = nullptr;
+    if (vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) != JNI_OK) {
+        return JNI_ERR;
+    }
+    cache.vm = vm;
+    // Before anything runs a parallel_for_: OpenCV's pool is never started
+    installWorkStealingPool();
+    cache.byteBufferClass = globalClass(env, "java/nio/ByteBuffer");
+    cache.stringClass = globalClass(env, "java/lang/String");
+    cache.runnableClass = globalClass(env, "java/lang/Runnable");
+    if (cache.runnableClass) {
+        cache.runnableRun = env->GetMethodID(cache.runnableClass, "run", "()V");
+    }
+
+    const int bound = registerNativeLibMethods(env) + registerNativeCameraMethods(env) + registerRendererMethods(env);
+    const double millis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    LOGI("✅ JNI_OnLoad: %d native methods registered in %.2f ms", bound, millis);
+    return JNI_VERSION_1_6;
+}
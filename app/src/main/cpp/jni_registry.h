@@ -0,0 +1,46 @@
+#ifndef EDGE_JNI_REGISTRY_H
+#define EDGE_JNI_REGISTRY_H
+
+#include <jni.h>
+#include <cstddef>
+
+// Process-wide JNI handles resolved once in JNI_OnLoad. Global class refs
+// stay valid on any thread, including native ones whose FindClass would only
+// see the system class loader. Read-only after JNI_OnLoad.
+struct JniCache {
+    JavaVM* vm = nullptr;
+    jclass byteBufferClass = nullptr;   // java/nio/ByteBuffer
+    jclass stringClass = nullptr;       // java/lang/String
+    jclass runnableClass = nullptr;     // java/lang/Runnable
+    jmethodID runnableRun = nullptr;    // Runnable.run()
+};
+
+const JniCache& jniCache();
+
+// Binds a table of native methods to className with RegisterNatives. A
+// missing class is logged and skipped (a host app may leave GLRenderer out);
+// when the table as a whole is rejected every entry is retried alone, so one
+// stale signature only loses its own method. Returns the methods bound.
+int registerNativeMethods(JNIEnv* env, const char* className, const JNINativeMethod* methods, size_t count);
+
+template <size_t N>
+int registerNativeMethods(JNIEnv* env, const char* className, const JNINativeMethod (&methods)[N]) {
+    return registerNativeMethods(env, className, methods, N);
+}
+
+// Entries of the tables below, one per JNI function; the signature must match
+// the Java declaration exactly
+#define EDGE_NATIVE_BRIDGE_METHOD(name, signature) \
+    {#name, signature, reinterpret_cast<void*>(Java_com_example_edge_nativebridge_NativeBridge_##name)}
+#define EDGE_GL_RENDERER_METHOD(name, signature) \
+    {#name, signature, reinterpret_cast<void*>(Java_com_example_edge_renderer_GLRenderer_##name)}
+
+static const char* const kNativeBridgeClass = "com/example/edge/nativebridge/NativeBridge";
+static const char* const kGlRendererClass = "com/example/edge/renderer/GLRenderer";
+
+// Per-file tables, kept next to the functions they bind
+int registerNativeLibMethods(JNIEnv* env);        // native-lib.cpp
+int registerNativeCameraMethods(JNIEnv* env);     // native_camera.cpp
+int registerRendererMethods(JNIEnv* env);         // opengl_renderer.cpp
+
+#endif // EDGE_JNI_REGISTRY_H
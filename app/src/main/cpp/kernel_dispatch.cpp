@@ -0,0 +1,203 @@
+#include "kernel_dispatch.h"
+#include <atomic>
+#include <cstdio>
+#include <unistd.h>
+
+#if defined(__arm__) || defined(__aarch64__)
+#include <sys/auxv.h>
+#endif
+
+#define LOG_TAG "KernelDispatch"
+#include "logging.h"
+
+// Per-ISA tables (kernels_*.cpp); false when built for a target without the level
+bool fillScalarKernels(EdgeKernels& kernels);
+bool fillNeonKernels(EdgeKernels& kernels);
+bool fillArmv82Kernels(EdgeKernels& kernels);
+bool fillSse41Kernels(EdgeKernels& kernels);
+bool fillAvx2Kernels(EdgeKernels& kernels);
+
+namespace {
+
+// Older NDK headers lack the newer bits
+#if defined(__aarch64__)
+const unsigned long kHwcapAsimd = 1ul << 1;
+const unsigned long kHwcapFphp = 1ul << 9;
+const unsigned long kHwcapAsimdhp = 1ul << 10;
+const unsigned long kHwcapAsimddp = 1ul << 20;
+const unsigned long kHwcap2I8mm = 1ul << 13;
+#elif defined(__arm__)
+const unsigned long kHwcapNeon = 1ul << 12;
+#endif
+
+const long kDefaultL2Bytes = 256 * 1024;
+
+CpuIsaFeatures detectFeatures() {
+    CpuIsaFeatures features;
+#if defined(__aarch64__)
+    const unsigned long hwcap = getauxval(AT_HWCAP);
+    const unsigned long hwcap2 = getauxval(AT_HWCAP2);
+    features.aarch64 = true;
+    features.neon = (hwcap & kHwcapAsimd) != 0;
+    features.dotprod = (hwcap & kHwcapAsimddp) != 0;
+    features.fp16 = (hwcap & kHwcapFphp) != 0 && (hwcap & kHwcapAsimdhp) != 0;
+    features.i8mm = (hwcap2 & kHwcap2I8mm) != 0;
+#elif defined(__arm__)
+    // armeabi-v7a: NEON is optional on ARMv7 silicon
+    features.neon = (getauxval(AT_HWCAP) & kHwcapNeon) != 0;
+#elif defined(__x86_64__) || defined(__i386__)
+    // CPUID through the compiler runtime, which also checks XGETBV: AVX2
+    // silicon under an OS (or emulator) that does not save YMM reports none
+    __builtin_cpu_init();
+    features.sse41 = __builtin_cpu_supports("sse4.1");
+    features.avx2 = __builtin_cpu_supports("avx2");
+#endif
+    return features;
+}
+
+long detectL2Bytes() {
+    long size = 0;
+#ifdef _SC_LEVEL2_CACHE_SIZE
+    size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+#endif
+    if (size <= 0) {
+        // e.g. "256K"; cpu0 is enough since bands are sized for the smallest core
+        FILE* file = fopen("/sys/devices/system/cpu/cpu0/cache/index2/size", "r");
+        if (file) {
+            char unit = 0;
+            if (fscanf(file, "%ld%c", &size, &unit) >= 1) {
+                if (unit == 'K' || unit == 'k') size *= 1024;
+                if (unit == 'M' || unit == 'm') size *= 1024 * 1024;
+            }
+            fclose(file);
+        }
+    }
+    return size > 0 ? size : kDefaultL2Bytes;
+}
+
+bool supported(IsaLevel level) {
+    const CpuIsaFeatures& features = cpuFeatures();
+    switch (level) {
+        case IsaLevel::SCALAR: return true;
+        case IsaLevel::NEON: return features.neon && !features.aarch64;
+        case IsaLevel::ARMV8: return features.neon && features.aarch64;
+        // The whole translation unit is built with +dotprod+fp16, so both are needed
+        case IsaLevel::ARMV8_2: return features.aarch64 && features.dotprod && features.fp16;
+        case IsaLevel::SSE4_1: return features.sse41;
+        case IsaLevel::AVX2: return features.sse41 && features.avx2;
+    }
+    return false;
+}
+
+struct KernelTables {
+    EdgeKernels scalar;
+    EdgeKernels neon;
+    EdgeKernels armv82;
+    EdgeKernels sse41;
+    EdgeKernels avx2;
+    bool hasNeon = false;
+    bool hasArmv82 = false;
+    bool hasSse41 = false;
+    bool hasAvx2 = false;
+};
+
+const KernelTables& tables() {
+    static const KernelTables loaded = [] {
+        KernelTables result;
+        fillScalarKernels(result.scalar);
+        result.hasNeon = fillNeonKernels(result.neon) && supported(result.neon.level);
+        result.hasArmv82 = fillArmv82Kernels(result.armv82) && supported(result.armv82.level);
+        result.hasSse41 = fillSse41Kernels(result.sse41) && supported(result.sse41.level);
+        result.hasAvx2 = fillAvx2Kernels(result.avx2) && supported(result.avx2.level);
+        return result;
+    }();
+    return loaded;
+}
+
+const EdgeKernels* bestUpTo(IsaLevel limit) {
+    const KernelTables& loaded = tables();
+    if (loaded.hasAvx2 && loaded.avx2.level <= limit) {
+        return &loaded.avx2;
+    }
+    if (loaded.hasSse41 && loaded.sse41.level <= limit) {
+        return &loaded.sse41;
+    }
+    if (loaded.hasArmv82 && loaded.armv82.level <= limit) {
+        return &loaded.armv82;
+    }
+    if (loaded.hasNeon && loaded.neon.level <= limit) {
+        return &loaded.neon;
+    }
+    return &loaded.scalar;
+}
+
+std::atomic<const EdgeKernels*> active{nullptr};
+
+} // namespace
+
+const CpuIsaFeatures& cpuFeatures() {
+    static const CpuIsaFeatures features = detectFeatures();
+    return features;
+}
+
+long l2CacheBytes() {
+    static const long bytes = detectL2Bytes();
+    return bytes;
+}
+
+const char* isaLevelName(IsaLevel level) {
+    switch (level) {
+        case IsaLevel::SCALAR: return "scalar";
+        case IsaLevel::NEON: return "armv7_neon";
+        case IsaLevel::ARMV8: return "armv8";
+        case IsaLevel::ARMV8_2: return "armv8.2_dotprod";
+        case IsaLevel::SSE4_1: return "x86_sse4.1";
+        case IsaLevel::AVX2: return "x86_avx2";
+    }
+    return "unknown";
+}
+
+const EdgeKernels& edgeKernels() {
+    const EdgeKernels* kernels = active.load(std::memory_order_acquire);
+    if (!kernels) {
+        static const EdgeKernels* initial = [] {
+            const EdgeKernels* best = bestUpTo(IsaLevel::AVX2);
+            const CpuIsaFeatures& features = cpuFeatures();
+            LOGI("✅ Kernels: %s (neon %d, dotprod %d, fp16 %d, i8mm %d, sse4.1 %d, avx2 %d)",
+                 isaLevelName(best->level), features.neon, features.dotprod, features.fp16, features.i8mm,
+                 features.sse41, features.avx2);
+            return best;
+        }();
+        const EdgeKernels* expected = nullptr;
+        active.compare_exchange_strong(expected, initial, std::memory_order_acq_rel);
+        kernels = active.load(std::memory_order_acquire);
+    }
+    return *kernels;
+}
+
+const EdgeKernels* kernelsFor(IsaLevel level) {
+    const KernelTables& loaded = tables();
+    if (level == IsaLevel::SCALAR) {
+        return &loaded.scalar;
+    }
+    if (loaded.hasNeon && loaded.neon.level == level) {
+        return &loaded.neon;
+    }
+    if (loaded.hasArmv82 && loaded.armv82.level == level) {
+        return &loaded.armv82;
+    }
+    if (loaded.hasSse41 && loaded.sse41.level == level) {
+        return &loaded.sse41;
+    }
+    if (loaded.hasAvx2 && loaded.avx2.level == level) {
+        return &loaded.avx2;
+    }
+    return nullptr;
+}
+
+IsaLevel setKernelIsaLimit(IsaLevel limit) {
+    const EdgeKernels* kernels = bestUpTo(limit);
+    active.store(kernels, std::memory_order_release);
+    LOGI("🔄 Kernels limited to %s: using %s", isaLevelName(limit), isaLevelName(kernels->level));
+    return kernels->level;
+}
@@ -0,0 +1,114 @@
+#ifndef EDGE_KERNEL_DISPATCH_H
+#define EDGE_KERNEL_DISPATCH_H
+
+#include <cstddef>
+#include <cstdint>
+
+// What the CPU reports through getauxval(AT_HWCAP / AT_HWCAP2), or CPUID on x86
+struct CpuIsaFeatures {
+    bool neon = false;      // ARMv7 NEON, or AArch64 Advanced SIMD
+    bool aarch64 = false;
+    bool dotprod = false;   // ARMv8.2 UDOT/SDOT (asimddp)
+    bool fp16 = false;      // ARMv8.2 half-precision arithmetic (fphp + asimdhp)
+    bool i8mm = false;      // ARMv8.6 int8 matrix multiply (reported only)
+    bool sse41 = false;     // x86 SSE4.1 (x86_64 emulators, Chromebooks)
+    bool avx2 = false;      // x86 AVX2, with OS support for the YMM state
+};
+
+const CpuIsaFeatures& cpuFeatures();
+
+// L2 size of cpu0 in bytes (the smallest core's on big.LITTLE parts), 256 KiB
+// when the kernel does not report it (common on Android); what banded passes
+// size their stripes for
+long l2CacheBytes();
+
+// Instruction-set levels the kernels are built for, in increasing order
+// within each architecture. NEON is the armeabi-v7a build, ARMV8 the
+// arm64-v8a baseline and ARMV8_2 the arm64 build with dotprod and fp16;
+// SSE4_1 is the x86_64 baseline and AVX2 its wider build. A build only
+// carries its own architecture's levels, so a limit below SSE4_1 on x86_64
+// means scalar.
+enum class IsaLevel : int {
+    SCALAR = 0,
+    NEON,
+    ARMV8,
+    ARMV8_2,
+    SSE4_1,
+    AVX2,
+};
+
+const char* isaLevelName(IsaLevel level);
+
+// Three Sobel rows -> dx, dy and |dx| + |dy| (the Canny kernel's gradient pass)
+using GradientRowFn = void (*)(const uint8_t* r0, const uint8_t* r1, const uint8_t* r2, int width, int16_t* dx,
+                               int16_t* dy, int16_t* mag);
+// Three Sobel rows -> 255 where |dx| + |dy| >= threshold (0..2041), else 0;
+// the gradient itself is never stored (gradient_edges.h)
+using GradientThresholdRowFn = void (*)(const uint8_t* r0, const uint8_t* r1, const uint8_t* r2, int width,
+                                        int threshold, uint8_t* out);
+// One binary 8-bit row -> 1 bpp, bit x & 7 of byte x >> 3 (packed_edges.h)
+using PackRowFn = void (*)(const uint8_t* in, int width, uint8_t* out, int rowBytes);
+// One 8-bit row -> (x, y) uint16 pairs of its nonzero pixels, in order, at
+// most capacity of them; returns how many there are, written or not
+using CompactRowFn = int (*)(const uint8_t* row, int width, int y, uint16_t* points, int capacity);
+// One row of planar I420/YV12 (chroma pixel stride 1) -> BGR, BT.601 video
+// range, the same pixels as OpenCV's YUV420 converters
+using PlanarBgrRowFn = void (*)(const uint8_t* y, const uint8_t* u, const uint8_t* v, int width, uint8_t* bgr);
+// One row of P010 luma (10-bit samples in the high bits of 16-bit words) ->
+// its 8-bit samples and, unless luma10 is null, the 10-bit ones (0..1023)
+using P010LumaRowFn = void (*)(const uint16_t* in, int width, uint8_t* luma8, int16_t* luma10);
+// One row of P010 chroma, pairs interleaved UV samples -> 8-bit VU pairs (NV21 order)
+using P010ChromaRowFn = void (*)(const uint16_t* uv, int pairs, uint8_t* vu);
+// Two rows of a Bayer mosaic -> outWidth 8-bit lumas, each the sum of one
+// 2x2 quad: RAW16 sums shifted down by shift (saturated), RAW10 (MIPI
+// packed, 5 bytes per 4 samples) sums of the samples' high 8 bits, rounded
+using BayerBinRow16Fn = void (*)(const uint16_t* r0, const uint16_t* r1, int outWidth, int shift, uint8_t* out);
+using BayerBinRowRaw10Fn = void (*)(const uint8_t* r0, const uint8_t* r1, int outWidth, uint8_t* out);
+// One 8x8 block of 1-byte (C1) or 3-byte (C3) pixels transposed: dst row i
+// is src column i. Either stride may be negative, which makes the transpose
+// a quarter turn (image_rotate.h).
+using TransposeBlockFn = void (*)(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst, ptrdiff_t dstStride);
+
+// One 8-bit row blended towards the previous filtered row (temporal_denoise.h):
+// history weight strength / 128 (0..128) where |current - history| <= threshold
+// (0..239), fading to 0 over the next 16 levels; out may alias history
+using TemporalBlendRowFn = void (*)(const uint8_t* current, const uint8_t* history, int width, int strength,
+                                    int threshold, uint8_t* out);
+
+// One 32-byte (256-bit, ORB) descriptor against the rows of descriptors
+// (stride bytes apart) named by candidates -> their Hamming distances,
+// 0..256, into distances (visual_odometry.h's windowed matcher)
+using HammingDistancesFn = void (*)(const uint8_t* query, const uint8_t* descriptors, size_t stride,
+                                    const int32_t* candidates, int count, uint16_t* distances);
+
+struct EdgeKernels {
+    IsaLevel level = IsaLevel::SCALAR;
+    GradientRowFn gradientRow = nullptr;
+    GradientThresholdRowFn gradientThresholdRow = nullptr;
+    PackRowFn packRow = nullptr;
+    CompactRowFn compactRow = nullptr;
+    PlanarBgrRowFn planarToBgrRow = nullptr;
+    P010LumaRowFn p010LumaRow = nullptr;
+    P010ChromaRowFn p010ChromaRow = nullptr;
+    BayerBinRow16Fn bayerBinRow16 = nullptr;
+    BayerBinRowRaw10Fn bayerBinRowRaw10 = nullptr;
+    TransposeBlockFn transposeBlockC1 = nullptr;
+    TransposeBlockFn transposeBlockC3 = nullptr;
+    TemporalBlendRowFn temporalBlendRow = nullptr;
+    HammingDistancesFn hammingDistances = nullptr;
+};
+
+// The kernels of the highest level this build carries and the CPU runs
+// (capped by setKernelIsaLimit), bound on first use. Callers on a per-row
+// path should hold on to the reference for the frame rather than ask per row.
+const EdgeKernels& edgeKernels();
+
+// Table of one level; null when this build has no kernels for it or the CPU
+// lacks its features. For benchmarks and golden-output checks per level.
+const EdgeKernels* kernelsFor(IsaLevel level);
+
+// Highest level edgeKernels() may use from now on (A/B comparisons on one
+// device); returns the level bound
+IsaLevel setKernelIsaLimit(IsaLevel limit);
+
+#endif // EDGE_KERNEL_DISPATCH_H
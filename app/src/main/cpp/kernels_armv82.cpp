@@ -0,0 +1,5 @@
+// ARMv8.2 kernels (dotprod, fp16), built with -march=armv8.2-a+dotprod+fp16
+// on arm64-v8a and only bound when the CPU reports both; empty elsewhere
+#define EDGE_KERNEL_REQUIRE_DOTPROD 1
+#define EDGE_KERNEL_FILL fillArmv82Kernels
+#include "kernels_impl.h"
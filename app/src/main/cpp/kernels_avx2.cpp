@@ -0,0 +1,5 @@
+// AVX2 kernels, built with -mavx2 on x86_64 and only bound when the CPU
+// (and OS) report it; empty elsewhere
+#define EDGE_KERNEL_REQUIRE_AVX2 1
+#define EDGE_KERNEL_FILL fillAvx2Kernels
+#include "kernels_impl.h"
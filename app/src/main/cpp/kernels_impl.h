@@ -0,0 +1,971 @@
+// Kernel bodies shared by the per-ISA translation units (kernels_scalar.cpp,
+// kernels_neon.cpp, kernels_armv82.cpp, kernels_sse41.cpp, kernels_avx2.cpp).
+// Each includes this file once, compiled with its own -march/-mfpu/-m flags
+// (CMakeLists.txt), after defining
+//   EDGE_KERNEL_FILL            name of its table-filling function
+//   EDGE_KERNEL_SCALAR          portable code only, or
+//   EDGE_KERNEL_REQUIRE_NEON /  its table is empty unless the compiler
+//   EDGE_KERNEL_REQUIRE_DOTPROD / targets that level
+//   EDGE_KERNEL_REQUIRE_SSE41 /
+//   EDGE_KERNEL_REQUIRE_AVX2
+// Everything here has internal linkage and calls no inline library template:
+// a shared inline function instantiated under wider flags could otherwise be
+// the copy the linker keeps for every caller, and fault on older CPUs.
+// No include guard: included once per variant by design.
+
+#include "kernel_dispatch.h"
+#include <cstddef>
+#include <cstring>
+
+#if !defined(EDGE_KERNEL_FILL)
+#error "define EDGE_KERNEL_FILL before including kernels_impl.h"
+#endif
+
+#if !defined(EDGE_KERNEL_SCALAR) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#include <arm_neon.h>
+#define EDGE_KERNEL_NEON 1
+#if defined(__aarch64__) && defined(__ARM_FEATURE_DOTPROD)
+#define EDGE_KERNEL_DOTPROD 1
+#endif
+#endif
+
+// x86: the AVX2 unit also carries the SSE4.1 paths, VEX-encoded, for the
+// kernels and remainders that stay 128 bits wide
+#if !defined(EDGE_KERNEL_SCALAR) && defined(__SSE4_1__)
+#include <immintrin.h>
+#define EDGE_KERNEL_SSE41 1
+#if defined(__AVX2__)
+#define EDGE_KERNEL_AVX2 1
+#endif
+#endif
+
+namespace {
+
+#if defined(EDGE_KERNEL_AVX2)
+const IsaLevel kLevel = IsaLevel::AVX2;
+#elif defined(EDGE_KERNEL_SSE41)
+const IsaLevel kLevel = IsaLevel::SSE4_1;
+#elif defined(EDGE_KERNEL_DOTPROD)
+const IsaLevel kLevel = IsaLevel::ARMV8_2;
+#elif defined(EDGE_KERNEL_NEON) && defined(__aarch64__)
+const IsaLevel kLevel = IsaLevel::ARMV8;
+#elif defined(EDGE_KERNEL_NEON)
+const IsaLevel kLevel = IsaLevel::NEON;
+#else
+const IsaLevel kLevel = IsaLevel::SCALAR;
+#endif
+
+inline int absInt(int value) {
+    return value < 0 ? -value : value;
+}
+
+// --- Gradient ------------------------------------------------------------
+
+// One pixel of the 3x3 Sobel with replicated columns xl/xr
+inline void gradientPixel(const uint8_t* r0, const uint8_t* r1, const uint8_t* r2, int xl, int x, int xr,
+                          int16_t* dx, int16_t* dy, int16_t* mag) {
+    const int gx = (r0[xr] - r0[xl]) + 2 * (r1[xr] - r1[xl]) + (r2[xr] - r2[xl]);
+    const int gy = (r2[xl] + 2 * r2[x] + r2[xr]) - (r0[xl] + 2 * r0[x] + r0[xr]);
+    dx[x] = static_cast<int16_t>(gx);
+    dy[x] = static_cast<int16_t>(gy);
+    mag[x] = static_cast<int16_t>(absInt(gx) + absInt(gy));
+}
+
+#ifdef EDGE_KERNEL_SSE41
+// 8 pixels of the 3x3 Sobel at x .. x + 7 (reading x - 1 .. x + 8), as int16
+inline void sobel8(const uint8_t* r0, const uint8_t* r1, const uint8_t* r2, int x, __m128i& gx, __m128i& gy) {
+    auto load = [](const uint8_t* p) { return _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p))); };
+    const __m128i l0 = load(r0 + x - 1);
+    const __m128i m0 = load(r0 + x);
+    const __m128i c0 = load(r0 + x + 1);
+    const __m128i l1 = load(r1 + x - 1);
+    const __m128i c1 = load(r1 + x + 1);
+    const __m128i l2 = load(r2 + x - 1);
+    const __m128i m2 = load(r2 + x);
+    const __m128i c2 = load(r2 + x + 1);
+
+    gx = _mm_add_epi16(_mm_sub_epi16(c0, l0), _mm_sub_epi16(c2, l2));
+    gx = _mm_add_epi16(gx, _mm_slli_epi16(_mm_sub_epi16(c1, l1), 1));
+    const __m128i bottom = _mm_add_epi16(_mm_add_epi16(l2, c2), _mm_slli_epi16(m2, 1));
+    const __m128i top = _mm_add_epi16(_mm_add_epi16(l0, c0), _mm_slli_epi16(m0, 1));
+    gy = _mm_sub_epi16(bottom, top);
+}
+#endif
+
+#ifdef EDGE_KERNEL_AVX2
+// sobel8 over 16 pixels
+inline void sobel16(const uint8_t* r0, const uint8_t* r1, const uint8_t* r2, int x, __m256i& gx, __m256i& gy) {
+    auto load = [](const uint8_t* p) {
+        return _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+    };
+    const __m256i l0 = load(r0 + x - 1);
+    const __m256i m0 = load(r0 + x);
+    const __m256i c0 = load(r0 + x + 1);
+    const __m256i l1 = load(r1 + x - 1);
+    const __m256i c1 = load(r1 + x + 1);
+    const __m256i l2 = load(r2 + x - 1);
+    const __m256i m2 = load(r2 + x);
+    const __m256i c2 = load(r2 + x + 1);
+
+    gx = _mm256_add_epi16(_mm256_sub_epi16(c0, l0), _mm256_sub_epi16(c2, l2));
+    gx = _mm256_add_epi16(gx, _mm256_slli_epi16(_mm256_sub_epi16(c1, l1), 1));
+    const __m256i bottom = _mm256_add_epi16(_mm256_add_epi16(l2, c2), _mm256_slli_epi16(m2, 1));
+    const __m256i top = _mm256_add_epi16(_mm256_add_epi16(l0, c0), _mm256_slli_epi16(m0, 1));
+    gy = _mm256_sub_epi16(bottom, top);
+}
+#endif
+
+void gradientRow(const uint8_t* r0, const uint8_t* r1, const uint8_t* r2, int width, int16_t* dx, int16_t* dy,
+                 int16_t* mag) {
+    if (width == 1) {
+        gradientPixel(r0, r1, r2, 0, 0, 0, dx, dy, mag);
+        return;
+    }
+    gradientPixel(r0, r1, r2, 0, 0, 1, dx, dy, mag);
+    int x = 1;
+#ifdef EDGE_KERNEL_NEON
+    // 8 pixels per step; |dx| + |dy| <= 2040 fits int16
+    for (; x + 9 <= width; x += 8) {
+        const int16x8_t l0 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(r0 + x - 1)));
+        const int16x8_t m0 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(r0 + x)));
+        const int16x8_t c0 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(r0 + x + 1)));
+        const int16x8_t l1 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(r1 + x - 1)));
+        const int16x8_t c1 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(r1 + x + 1)));
+        const int16x8_t l2 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(r2 + x - 1)));
+        const int16x8_t m2 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(r2 + x)));
+        const int16x8_t c2 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(r2 + x + 1)));
+
+        int16x8_t gx = vaddq_s16(vsubq_s16(c0, l0), vsubq_s16(c2, l2));
+        gx = vaddq_s16(gx, vshlq_n_s16(vsubq_s16(c1, l1), 1));
+        const int16x8_t bottom = vaddq_s16(vaddq_s16(l2, c2), vshlq_n_s16(m2, 1));
+        const int16x8_t top = vaddq_s16(vaddq_s16(l0, c0), vshlq_n_s16(m0, 1));
+        const int16x8_t gy = vsubq_s16(bottom, top);
+
+        vst1q_s16(dx + x, gx);
+        vst1q_s16(dy + x, gy);
+        vst1q_s16(mag + x, vaddq_s16(vabsq_s16(gx), vabsq_s16(gy)));
+    }
+#endif
+#ifdef EDGE_KERNEL_AVX2
+    for (; x + 17 <= width; x += 16) {
+        __m256i gx;
+        __m256i gy;
+        sobel16(r0, r1, r2, x, gx, gy);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dx + x), gx);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dy + x), gy);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(mag + x),
+                            _mm256_add_epi16(_mm256_abs_epi16(gx), _mm256_abs_epi16(gy)));
+    }
+#endif
+#ifdef EDGE_KERNEL_SSE41
+    for (; x + 9 <= width; x += 8) {
+        __m128i gx;
+        __m128i gy;
+        sobel8(r0, r1, r2, x, gx, gy);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dx + x), gx);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dy + x), gy);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(mag + x), _mm_add_epi16(_mm_abs_epi16(gx), _mm_abs_epi16(gy)));
+    }
+#endif
+    for (; x < width - 1; x++) {
+        gradientPixel(r0, r1, r2, x - 1, x, x + 1, dx, dy, mag);
+    }
+    gradientPixel(r0, r1, r2, width - 2, width - 1, width - 1, dx, dy, mag);
+}
+
+// One pixel of the thresholded L1 magnitude, columns as in gradientPixel
+inline uint8_t thresholdPixel(const uint8_t* r0, const uint8_t* r1, const uint8_t* r2, int xl, int x, int xr,
+                              int threshold) {
+    const int gx = (r0[xr] - r0[xl]) + 2 * (r1[xr] - r1[xl]) + (r2[xr] - r2[xl]);
+    const int gy = (r2[xl] + 2 * r2[x] + r2[xr]) - (r0[xl] + 2 * r0[x] + r0[xr]);
+    return absInt(gx) + absInt(gy) >= threshold ? 255 : 0;
+}
+
+void gradientThresholdRow(const uint8_t* r0, const uint8_t* r1, const uint8_t* r2, int width, int threshold,
+                          uint8_t* out) {
+    if (width == 1) {
+        out[0] = thresholdPixel(r0, r1, r2, 0, 0, 0, threshold);
+        return;
+    }
+    out[0] = thresholdPixel(r0, r1, r2, 0, 0, 1, threshold);
+    int x = 1;
+#ifdef EDGE_KERNEL_NEON
+    // gradientRow's arithmetic; the compare mask narrows straight to 0/255
+    const int16x8_t limit = vdupq_n_s16(static_cast<int16_t>(threshold));
+    for (; x + 9 <= width; x += 8) {
+        const int16x8_t l0 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(r0 + x - 1)));
+        const int16x8_t m0 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(r0 + x)));
+        const int16x8_t c0 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(r0 + x + 1)));
+        const int16x8_t l1 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(r1 + x - 1)));
+        const int16x8_t c1 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(r1 + x + 1)));
+        const int16x8_t l2 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(r2 + x - 1)));
+        const int16x8_t m2 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(r2 + x)));
+        const int16x8_t c2 = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(r2 + x + 1)));
+
+        int16x8_t gx = vaddq_s16(vsubq_s16(c0, l0), vsubq_s16(c2, l2));
+        gx = vaddq_s16(gx, vshlq_n_s16(vsubq_s16(c1, l1), 1));
+        const int16x8_t bottom = vaddq_s16(vaddq_s16(l2, c2), vshlq_n_s16(m2, 1));
+        const int16x8_t top = vaddq_s16(vaddq_s16(l0, c0), vshlq_n_s16(m0, 1));
+        const int16x8_t gy = vsubq_s16(bottom, top);
+
+        const uint16x8_t edge = vcgeq_s16(vaddq_s16(vabsq_s16(gx), vabsq_s16(gy)), limit);
+        vst1_u8(out + x, vmovn_u16(edge));
+    }
+#endif
+#ifdef EDGE_KERNEL_SSE41
+    // >= threshold as > threshold - 1; the all-ones masks pack to 255
+    const __m128i below = _mm_set1_epi16(static_cast<int16_t>(threshold - 1));
+#ifdef EDGE_KERNEL_AVX2
+    const __m256i below256 = _mm256_set1_epi16(static_cast<int16_t>(threshold - 1));
+    for (; x + 17 <= width; x += 16) {
+        __m256i gx;
+        __m256i gy;
+        sobel16(r0, r1, r2, x, gx, gy);
+        const __m256i edge =
+            _mm256_cmpgt_epi16(_mm256_add_epi16(_mm256_abs_epi16(gx), _mm256_abs_epi16(gy)), below256);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x),
+                         _mm_packs_epi16(_mm256_castsi256_si128(edge), _mm256_extracti128_si256(edge, 1)));
+    }
+#endif
+    for (; x + 9 <= width; x += 8) {
+        __m128i gx;
+        __m128i gy;
+        sobel8(r0, r1, r2, x, gx, gy);
+        const __m128i edge = _mm_cmpgt_epi16(_mm_add_epi16(_mm_abs_epi16(gx), _mm_abs_epi16(gy)), below);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + x), _mm_packs_epi16(edge, edge));
+    }
+#endif
+    for (; x < width - 1; x++) {
+        out[x] = thresholdPixel(r0, r1, r2, x - 1, x, x + 1, threshold);
+    }
+    out[width - 1] = thresholdPixel(r0, r1, r2, width - 2, width - 1, width - 1, threshold);
+}
+
+// --- Compaction ----------------------------------------------------------
+
+// Appends pixel x + bit of every set bit of mask (bit order = pixel order)
+inline int emitPoints(uint32_t mask, int x, int y, uint16_t* points, int capacity, int count) {
+    while (mask != 0) {
+        if (count < capacity) {
+            points[2 * count] = static_cast<uint16_t>(x + __builtin_ctz(mask));
+            points[2 * count + 1] = static_cast<uint16_t>(y);
+        }
+        count++;
+        mask &= mask - 1;
+    }
+    return count;
+}
+
+int compactRow(const uint8_t* row, int width, int y, uint16_t* points, int capacity) {
+    int count = 0;
+    int x = 0;
+#ifdef EDGE_KERNEL_NEON
+    // 16 pixels per step: an all-zero block costs one load and one test; any
+    // other folds to a 16-bit mask whose set bits are walked with ctz
+    static const uint8_t kWeights[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    const uint8x16_t weights = vld1q_u8(kWeights);
+    for (; x + 16 <= width; x += 16) {
+        const uint8x16_t pixels = vld1q_u8(row + x);
+        const uint64x2_t any = vreinterpretq_u64_u8(pixels);
+        if ((vgetq_lane_u64(any, 0) | vgetq_lane_u64(any, 1)) == 0) {
+            continue;
+        }
+        const uint8x16_t bits = vandq_u8(vtstq_u8(pixels, pixels), weights);
+        uint8x8_t folded = vpadd_u8(vget_low_u8(bits), vget_high_u8(bits));
+        folded = vpadd_u8(folded, folded);
+        folded = vpadd_u8(folded, folded);  // lane 0: pixels 0-7, lane 1: pixels 8-15
+        const uint32_t mask = vget_lane_u16(vreinterpret_u16_u8(folded), 0);
+        count = emitPoints(mask, x, y, points, capacity, count);
+    }
+#elif defined(EDGE_KERNEL_SSE41)
+    // The byte sign mask of the zero test, inverted, is the pixel mask itself
+    const __m128i zero = _mm_setzero_si128();
+#ifdef EDGE_KERNEL_AVX2
+    const __m256i zero256 = _mm256_setzero_si256();
+    for (; x + 32 <= width; x += 32) {
+        const __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + x));
+        const uint32_t mask = ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(pixels, zero256)));
+        if (mask != 0) {
+            count = emitPoints(mask, x, y, points, capacity, count);
+        }
+    }
+#endif
+    for (; x + 16 <= width; x += 16) {
+        const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+        const uint32_t mask = ~static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(pixels, zero))) & 0xffffu;
+        if (mask != 0) {
+            count = emitPoints(mask, x, y, points, capacity, count);
+        }
+    }
+#else
+    // 8 pixels per step, skipped as one word while they are all zero
+    for (; x + 8 <= width; x += 8) {
+        uint64_t word;
+        std::memcpy(&word, row + x, sizeof(word));
+        if (word == 0) {
+            continue;
+        }
+        uint32_t mask = 0;
+        for (int i = 0; i < 8; i++) {
+            mask |= (row[x + i] != 0 ? 1u : 0u) << i;
+        }
+        count = emitPoints(mask, x, y, points, capacity, count);
+    }
+#endif
+    for (; x < width; x++) {
+        if (row[x] != 0) {
+            count = emitPoints(1u, x, y, points, capacity, count);
+        }
+    }
+    return count;
+}
+
+// --- Packing -------------------------------------------------------------
+
+void packRow(const uint8_t* in, int width, uint8_t* out, int rowBytes) {
+    int x = 0;
+#if defined(EDGE_KERNEL_DOTPROD)
+    // 32 pixels -> 4 bytes: UDOT folds each 4 weighted lanes into a nibble
+    // of a byte (1-8 or 16-128), one pairwise add joins the nibbles
+    static const uint8_t kWeights[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+    const uint8x16_t weights = vld1q_u8(kWeights);
+    const uint32x4_t zero = vdupq_n_u32(0);
+    for (; x + 32 <= width; x += 32) {
+        const uint8x16_t lo = vld1q_u8(in + x);
+        const uint8x16_t hi = vld1q_u8(in + x + 16);
+        const uint8x16_t lowBits = vandq_u8(vtstq_u8(lo, lo), vdupq_n_u8(1));
+        const uint8x16_t highBits = vandq_u8(vtstq_u8(hi, hi), vdupq_n_u8(1));
+        const uint32x4_t bytes = vpaddq_u32(vdotq_u32(zero, lowBits, weights), vdotq_u32(zero, highBits, weights));
+        const uint8x8_t narrowed = vmovn_u16(vcombine_u16(vmovn_u32(bytes), vdup_n_u16(0)));
+        const uint32_t word = vget_lane_u32(vreinterpret_u32_u8(narrowed), 0);
+        std::memcpy(out + (x >> 3), &word, sizeof(word));
+    }
+#elif defined(EDGE_KERNEL_NEON)
+    // 32 pixels -> 4 bytes: each lane keeps its bit weight where the pixel is
+    // set, and three rounds of pairwise adds fold every 8 lanes into a byte
+    static const uint8_t kWeights[8] = {1, 2, 4, 8, 16, 32, 64, 128};
+    const uint8x8_t weights = vld1_u8(kWeights);
+    for (; x + 32 <= width; x += 32) {
+        const uint8x16_t lo = vld1q_u8(in + x);
+        const uint8x16_t hi = vld1q_u8(in + x + 16);
+        const uint8x8_t a = vand_u8(vtst_u8(vget_low_u8(lo), vget_low_u8(lo)), weights);
+        const uint8x8_t b = vand_u8(vtst_u8(vget_high_u8(lo), vget_high_u8(lo)), weights);
+        const uint8x8_t c = vand_u8(vtst_u8(vget_low_u8(hi), vget_low_u8(hi)), weights);
+        const uint8x8_t d = vand_u8(vtst_u8(vget_high_u8(hi), vget_high_u8(hi)), weights);
+        uint8x8_t folded = vpadd_u8(vpadd_u8(a, b), vpadd_u8(c, d));
+        folded = vpadd_u8(folded, folded);  // lanes 0-3: the bytes of a, b, c, d
+        const uint32_t word = vget_lane_u32(vreinterpret_u32_u8(folded), 0);
+        std::memcpy(out + (x >> 3), &word, sizeof(word));
+    }
+#elif defined(EDGE_KERNEL_SSE41)
+    // The inverted byte sign mask of the zero test is already the packed
+    // bits, pixel 0 in bit 0; x86 stores it little-endian, byte by byte
+    const __m128i zero = _mm_setzero_si128();
+#ifdef EDGE_KERNEL_AVX2
+    const __m256i zero256 = _mm256_setzero_si256();
+    for (; x + 32 <= width; x += 32) {
+        const __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + x));
+        const uint32_t word = ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(pixels, zero256)));
+        std::memcpy(out + (x >> 3), &word, sizeof(word));
+    }
+#endif
+    for (; x + 16 <= width; x += 16) {
+        const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + x));
+        const uint16_t bits = static_cast<uint16_t>(~_mm_movemask_epi8(_mm_cmpeq_epi8(pixels, zero)));
+        std::memcpy(out + (x >> 3), &bits, sizeof(bits));
+    }
+#endif
+    std::memset(out + (x >> 3), 0, rowBytes - (x >> 3));
+    for (; x < width; x++) {
+        if (in[x]) {
+            out[x >> 3] |= static_cast<uint8_t>(1u << (x & 7));
+        }
+    }
+}
+
+// --- YUV conversion ------------------------------------------------------
+
+// BT.601 video-range coefficients in 20-bit fixed point, identical to the ones
+// OpenCV's YUV420 converters use so both paths produce the same pixels
+const int kShift = 20;
+const int kCY = 1220542;   // 1.164
+const int kCUB = 2116026;  // 2.018
+const int kCUG = -409993;  // -0.391
+const int kCVG = -852492;  // -0.813
+const int kCVR = 1673527;  // 1.596
+const int kRound = 1 << (kShift - 1);
+
+inline uint8_t clampToByte(int value) {
+    return static_cast<uint8_t>(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+#ifdef EDGE_KERNEL_NEON
+// Four pixels of one channel: luma + cu * u + cv * v, rounded, shifted and
+// saturated exactly like the scalar clampToByte((...) >> kShift)
+inline uint16x4_t channel4(int32x4_t luma, int32x4_t u, int32x4_t v, int cu, int cv) {
+    int32x4_t sum = vmlaq_n_s32(vmlaq_n_s32(luma, u, cu), v, cv);
+    sum = vshrq_n_s32(vaddq_s32(sum, vdupq_n_s32(kRound)), kShift);
+    return vqmovun_s32(sum);  // negatives to 0; the 255 cap is the u16 -> u8 narrowing
+}
+
+// Eight pixels: y as bytes, u/v already centred and one per pixel
+inline void bgr8(uint8x8_t y, int16x8_t u, int16x8_t v, uint8_t* out) {
+    const int16x8_t luma16 = vreinterpretq_s16_u16(vmovl_u8(vqsub_u8(y, vdup_n_u8(16))));
+    const int32x4_t lumaLo = vmulq_n_s32(vmovl_s16(vget_low_s16(luma16)), kCY);
+    const int32x4_t lumaHi = vmulq_n_s32(vmovl_s16(vget_high_s16(luma16)), kCY);
+    const int32x4_t uLo = vmovl_s16(vget_low_s16(u));
+    const int32x4_t uHi = vmovl_s16(vget_high_s16(u));
+    const int32x4_t vLo = vmovl_s16(vget_low_s16(v));
+    const int32x4_t vHi = vmovl_s16(vget_high_s16(v));
+    uint8x8x3_t pixels;
+    pixels.val[0] = vqmovn_u16(vcombine_u16(channel4(lumaLo, uLo, vLo, kCUB, 0), channel4(lumaHi, uHi, vHi, kCUB, 0)));
+    pixels.val[1] = vqmovn_u16(vcombine_u16(channel4(lumaLo, uLo, vLo, kCUG, kCVG),
+                                            channel4(lumaHi, uHi, vHi, kCUG, kCVG)));
+    pixels.val[2] = vqmovn_u16(vcombine_u16(channel4(lumaLo, uLo, vLo, 0, kCVR), channel4(lumaHi, uHi, vHi, 0, kCVR)));
+    vst3_u8(out, pixels);
+}
+#endif
+
+#ifdef EDGE_KERNEL_SSE41
+// Four pixels of one channel in int32, rounded and shifted like the scalar
+// code; saturation is left to the packs
+inline __m128i channel4(__m128i luma, __m128i u, __m128i v, int cu, int cv) {
+    __m128i sum = _mm_add_epi32(luma, _mm_mullo_epi32(u, _mm_set1_epi32(cu)));
+    sum = _mm_add_epi32(sum, _mm_mullo_epi32(v, _mm_set1_epi32(cv)));
+    return _mm_srai_epi32(_mm_add_epi32(sum, _mm_set1_epi32(kRound)), kShift);
+}
+
+// Eight pixels: y in the low 8 bytes, u/v centred int16 and one per pixel;
+// B, G and R come out as u16 (negatives to 0, at most ~540, so the u8 pack
+// that follows caps at 255 exactly like clampToByte)
+inline void bgr8(__m128i y, __m128i u, __m128i v, __m128i& b, __m128i& g, __m128i& r) {
+    const __m128i luma16 = _mm_cvtepu8_epi16(_mm_subs_epu8(y, _mm_set1_epi8(16)));
+    const __m128i cy = _mm_set1_epi32(kCY);
+    const __m128i lumaLo = _mm_mullo_epi32(_mm_cvtepi16_epi32(luma16), cy);
+    const __m128i lumaHi = _mm_mullo_epi32(_mm_cvtepi16_epi32(_mm_srli_si128(luma16, 8)), cy);
+    const __m128i uLo = _mm_cvtepi16_epi32(u);
+    const __m128i uHi = _mm_cvtepi16_epi32(_mm_srli_si128(u, 8));
+    const __m128i vLo = _mm_cvtepi16_epi32(v);
+    const __m128i vHi = _mm_cvtepi16_epi32(_mm_srli_si128(v, 8));
+    b = _mm_packus_epi32(channel4(lumaLo, uLo, vLo, kCUB, 0), channel4(lumaHi, uHi, vHi, kCUB, 0));
+    g = _mm_packus_epi32(channel4(lumaLo, uLo, vLo, kCUG, kCVG), channel4(lumaHi, uHi, vHi, kCUG, kCVG));
+    r = _mm_packus_epi32(channel4(lumaLo, uLo, vLo, 0, kCVR), channel4(lumaHi, uHi, vHi, 0, kCVR));
+}
+#endif
+
+void planarToBgrRow(const uint8_t* yRow, const uint8_t* uRow, const uint8_t* vRow, int width, uint8_t* out) {
+    int x = 0;
+#ifdef EDGE_KERNEL_NEON
+    // 16 pixels share 8 chroma samples; each sample is duplicated for its pair
+    const int16x8_t bias = vdupq_n_s16(128);
+    for (; x + 16 <= width; x += 16) {
+        const uint8x16_t y = vld1q_u8(yRow + x);
+        const int16x8_t u = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(uRow + (x >> 1)))), bias);
+        const int16x8_t v = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(vRow + (x >> 1)))), bias);
+        const int16x8x2_t uPairs = vzipq_s16(u, u);
+        const int16x8x2_t vPairs = vzipq_s16(v, v);
+        bgr8(vget_low_u8(y), uPairs.val[0], vPairs.val[0], out + 3 * x);
+        bgr8(vget_high_u8(y), uPairs.val[1], vPairs.val[1], out + 3 * x + 24);
+    }
+#endif
+#ifdef EDGE_KERNEL_SSE41
+    // 16 pixels share 8 chroma samples, duplicated per pair; each 16-byte
+    // output is three byte shuffles of the B, G and R planes, ORed
+    const __m128i bias = _mm_set1_epi16(128);
+    const __m128i interleave[3][3] = {
+        {_mm_setr_epi8(0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1, 5),
+         _mm_setr_epi8(-1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1),
+         _mm_setr_epi8(-1, -1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1)},
+        {_mm_setr_epi8(-1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10, -1),
+         _mm_setr_epi8(5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10),
+         _mm_setr_epi8(-1, 5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1)},
+        {_mm_setr_epi8(-1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1, -1),
+         _mm_setr_epi8(-1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1),
+         _mm_setr_epi8(10, -1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15)},
+    };
+    for (; x + 16 <= width; x += 16) {
+        const __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(yRow + x));
+        const __m128i u = _mm_sub_epi16(
+            _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(uRow + (x >> 1)))), bias);
+        const __m128i v = _mm_sub_epi16(
+            _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(vRow + (x >> 1)))), bias);
+        __m128i b0, g0, r0, b1, g1, r1;
+        bgr8(y, _mm_unpacklo_epi16(u, u), _mm_unpacklo_epi16(v, v), b0, g0, r0);
+        bgr8(_mm_srli_si128(y, 8), _mm_unpackhi_epi16(u, u), _mm_unpackhi_epi16(v, v), b1, g1, r1);
+        const __m128i planes[3] = {_mm_packus_epi16(b0, b1), _mm_packus_epi16(g0, g1), _mm_packus_epi16(r0, r1)};
+        for (int k = 0; k < 3; k++) {
+            const __m128i bytes = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(planes[0], interleave[k][0]),
+                                                            _mm_shuffle_epi8(planes[1], interleave[k][1])),
+                                               _mm_shuffle_epi8(planes[2], interleave[k][2]));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 3 * x + 16 * k), bytes);
+        }
+    }
+#endif
+    for (; x < width; x++) {
+        const int u = uRow[x >> 1] - 128;
+        const int v = vRow[x >> 1] - 128;
+        const int luma = (yRow[x] > 16 ? yRow[x] - 16 : 0) * kCY;
+        out[3 * x + 0] = clampToByte((luma + kCUB * u + kRound) >> kShift);
+        out[3 * x + 1] = clampToByte((luma + kCUG * u + kCVG * v + kRound) >> kShift);
+        out[3 * x + 2] = clampToByte((luma + kCVR * v + kRound) >> kShift);
+    }
+}
+
+// --- P010 unpacking ------------------------------------------------------
+
+// P010 keeps each 10-bit sample in the high bits of a 16-bit word: the top 8
+// bits are the 8-bit sample, a 6-bit shift the 10-bit one
+void p010LumaRow(const uint16_t* in, int width, uint8_t* luma8, int16_t* luma10) {
+    int x = 0;
+#ifdef EDGE_KERNEL_NEON
+    for (; x + 16 <= width; x += 16) {
+        const uint16x8_t lo = vld1q_u16(in + x);
+        const uint16x8_t hi = vld1q_u16(in + x + 8);
+        vst1q_u8(luma8 + x, vcombine_u8(vshrn_n_u16(lo, 8), vshrn_n_u16(hi, 8)));
+        if (luma10) {
+            vst1q_s16(luma10 + x, vreinterpretq_s16_u16(vshrq_n_u16(lo, 6)));
+            vst1q_s16(luma10 + x + 8, vreinterpretq_s16_u16(vshrq_n_u16(hi, 6)));
+        }
+    }
+#endif
+#ifdef EDGE_KERNEL_SSE41
+    for (; x + 16 <= width; x += 16) {
+        const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + x));
+        const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + x + 8));
+        const __m128i bytes = _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(luma8 + x), bytes);
+        if (luma10) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(luma10 + x), _mm_srli_epi16(lo, 6));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(luma10 + x + 8), _mm_srli_epi16(hi, 6));
+        }
+    }
+#endif
+    for (; x < width; x++) {
+        luma8[x] = static_cast<uint8_t>(in[x] >> 8);
+        if (luma10) {
+            luma10[x] = static_cast<int16_t>(in[x] >> 6);
+        }
+    }
+}
+
+void p010ChromaRow(const uint16_t* uv, int pairs, uint8_t* vu) {
+    int x = 0;
+#ifdef EDGE_KERNEL_NEON
+    for (; x + 8 <= pairs; x += 8) {
+        const uint16x8x2_t samples = vld2q_u16(uv + 2 * x);  // val[0] U, val[1] V
+        uint8x8x2_t bytes;
+        bytes.val[0] = vshrn_n_u16(samples.val[1], 8);
+        bytes.val[1] = vshrn_n_u16(samples.val[0], 8);
+        vst2_u8(vu + 2 * x, bytes);
+    }
+#endif
+#ifdef EDGE_KERNEL_SSE41
+    // Each 16-bit UV pair swapped within its 32 bits, then narrowed
+    for (; x + 8 <= pairs; x += 8) {
+        __m128i lo = _mm_srli_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(uv + 2 * x)), 8);
+        __m128i hi = _mm_srli_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(uv + 2 * x + 8)), 8);
+        lo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+        hi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(vu + 2 * x), _mm_packus_epi16(lo, hi));
+    }
+#endif
+    for (; x < pairs; x++) {
+        vu[2 * x] = static_cast<uint8_t>(uv[2 * x + 1] >> 8);
+        vu[2 * x + 1] = static_cast<uint8_t>(uv[2 * x] >> 8);
+    }
+}
+
+// --- Bayer binning -------------------------------------------------------
+
+// Each 2x2 quad of a Bayer mosaic holds one R, two G and one B sample,
+// whatever the CFA order, so their sum is a luma of the quad. RAW16 sums
+// are shifted down by shift and saturated to 8 bits.
+void bayerBinRow16(const uint16_t* r0, const uint16_t* r1, int outWidth, int shift, uint8_t* out) {
+    int x = 0;
+#ifdef EDGE_KERNEL_NEON
+    const int32x4_t down = vdupq_n_s32(-shift);
+    for (; x + 8 <= outWidth; x += 8) {
+        const uint32x4_t lo = vaddq_u32(vpaddlq_u16(vld1q_u16(r0 + 2 * x)), vpaddlq_u16(vld1q_u16(r1 + 2 * x)));
+        const uint32x4_t hi =
+                vaddq_u32(vpaddlq_u16(vld1q_u16(r0 + 2 * x + 8)), vpaddlq_u16(vld1q_u16(r1 + 2 * x + 8)));
+        const uint16x8_t sums = vcombine_u16(vqmovn_u32(vshlq_u32(lo, down)), vqmovn_u32(vshlq_u32(hi, down)));
+        vst1_u8(out + x, vqmovn_u16(sums));
+    }
+#endif
+#ifdef EDGE_KERNEL_SSE41
+    // Even and odd 16-bit samples as int32 lanes, so 16-bit sums never wrap
+    const __m128i low16 = _mm_set1_epi32(0xffff);
+    const __m128i down = _mm_cvtsi32_si128(shift);
+    auto pairSums = [&low16](const uint16_t* p) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        return _mm_add_epi32(_mm_and_si128(v, low16), _mm_srli_epi32(v, 16));
+    };
+    for (; x + 8 <= outWidth; x += 8) {
+        const __m128i lo = _mm_srl_epi32(_mm_add_epi32(pairSums(r0 + 2 * x), pairSums(r1 + 2 * x)), down);
+        const __m128i hi = _mm_srl_epi32(_mm_add_epi32(pairSums(r0 + 2 * x + 8), pairSums(r1 + 2 * x + 8)), down);
+        const __m128i sums = _mm_packus_epi32(lo, hi);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + x), _mm_packus_epi16(sums, sums));
+    }
+#endif
+    for (; x < outWidth; x++) {
+        const uint32_t sum = static_cast<uint32_t>(r0[2 * x]) + r0[2 * x + 1] + r1[2 * x] + r1[2 * x + 1];
+        const uint32_t value = sum >> shift;
+        out[x] = static_cast<uint8_t>(value > 255 ? 255 : value);
+    }
+}
+
+// MIPI RAW10: every 5 bytes hold 4 samples, their high 8 bits in bytes 0..3
+// and the low 2 bits of all four in byte 4. The quad sum of the high bytes,
+// rounded to 8 bits, leaves the low bits out (within 1 of the full sum's).
+void bayerBinRowRaw10(const uint8_t* r0, const uint8_t* r1, int outWidth, uint8_t* out) {
+    int x = 0;
+#ifdef EDGE_KERNEL_NEON
+    // 8 outputs are 16 samples, 20 bytes: the high bytes of the first two
+    // groups from p, of the last two from p + 4
+    const uint8x8_t first = vcreate_u8(0x0807060503020100ULL);  // 0 1 2 3 5 6 7 8
+    const uint8x8_t second = vcreate_u8(0x0e0d0c0b09080706ULL);  // 6 7 8 9 11 12 13 14
+    auto highBytes = [&first, &second](const uint8_t* p) {
+        const uint8x16_t a = vld1q_u8(p);
+        const uint8x16_t b = vld1q_u8(p + 4);
+        uint8x8x2_t tableA;
+        tableA.val[0] = vget_low_u8(a);
+        tableA.val[1] = vget_high_u8(a);
+        uint8x8x2_t tableB;
+        tableB.val[0] = vget_low_u8(b);
+        tableB.val[1] = vget_high_u8(b);
+        return vcombine_u8(vtbl2_u8(tableA, first), vtbl2_u8(tableB, second));
+    };
+    for (; x + 8 <= outWidth; x += 8) {
+        const int offset = x / 2 * 5;
+        const uint16x8_t sums = vaddq_u16(vpaddlq_u8(highBytes(r0 + offset)), vpaddlq_u8(highBytes(r1 + offset)));
+        vst1_u8(out + x, vrshrn_n_u16(sums, 2));
+    }
+#endif
+#ifdef EDGE_KERNEL_SSE41
+    const __m128i first = _mm_setr_epi8(0, 1, 2, 3, 5, 6, 7, 8, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i second = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, 6, 7, 8, 9, 11, 12, 13, 14);
+    const __m128i ones = _mm_set1_epi8(1);
+    auto pairSums = [&](const uint8_t* p) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 4));
+        return _mm_maddubs_epi16(_mm_or_si128(_mm_shuffle_epi8(a, first), _mm_shuffle_epi8(b, second)), ones);
+    };
+    for (; x + 8 <= outWidth; x += 8) {
+        const int offset = x / 2 * 5;
+        const __m128i sums = _mm_add_epi16(_mm_add_epi16(pairSums(r0 + offset), pairSums(r1 + offset)),
+                                           _mm_set1_epi16(2));
+        const __m128i bytes = _mm_srli_epi16(sums, 2);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + x), _mm_packus_epi16(bytes, bytes));
+    }
+#endif
+    for (; x < outWidth; x++) {
+        // Output x covers samples 2x and 2x + 1, in the group 2x / 4
+        const int offset = x / 2 * 5 + (x & 1) * 2;
+        const int sum = r0[offset] + r0[offset + 1] + r1[offset] + r1[offset + 1];
+        out[x] = static_cast<uint8_t>((sum + 2) >> 2);
+    }
+}
+
+// --- Transpose -----------------------------------------------------------
+
+#ifdef EDGE_KERNEL_NEON
+// In-register 8x8 byte transpose: three rounds of vtrn at 8, 16 and 32 bits
+// swap ever larger sub-blocks across the diagonal
+inline void transpose8x8(uint8x8_t (&rows)[8]) {
+    const uint8x8x2_t t01 = vtrn_u8(rows[0], rows[1]);
+    const uint8x8x2_t t23 = vtrn_u8(rows[2], rows[3]);
+    const uint8x8x2_t t45 = vtrn_u8(rows[4], rows[5]);
+    const uint8x8x2_t t67 = vtrn_u8(rows[6], rows[7]);
+    const uint16x4x2_t u02 = vtrn_u16(vreinterpret_u16_u8(t01.val[0]), vreinterpret_u16_u8(t23.val[0]));
+    const uint16x4x2_t u13 = vtrn_u16(vreinterpret_u16_u8(t01.val[1]), vreinterpret_u16_u8(t23.val[1]));
+    const uint16x4x2_t u46 = vtrn_u16(vreinterpret_u16_u8(t45.val[0]), vreinterpret_u16_u8(t67.val[0]));
+    const uint16x4x2_t u57 = vtrn_u16(vreinterpret_u16_u8(t45.val[1]), vreinterpret_u16_u8(t67.val[1]));
+    const uint32x2x2_t w04 = vtrn_u32(vreinterpret_u32_u16(u02.val[0]), vreinterpret_u32_u16(u46.val[0]));
+    const uint32x2x2_t w26 = vtrn_u32(vreinterpret_u32_u16(u02.val[1]), vreinterpret_u32_u16(u46.val[1]));
+    const uint32x2x2_t w15 = vtrn_u32(vreinterpret_u32_u16(u13.val[0]), vreinterpret_u32_u16(u57.val[0]));
+    const uint32x2x2_t w37 = vtrn_u32(vreinterpret_u32_u16(u13.val[1]), vreinterpret_u32_u16(u57.val[1]));
+    rows[0] = vreinterpret_u8_u32(w04.val[0]);
+    rows[1] = vreinterpret_u8_u32(w15.val[0]);
+    rows[2] = vreinterpret_u8_u32(w26.val[0]);
+    rows[3] = vreinterpret_u8_u32(w37.val[0]);
+    rows[4] = vreinterpret_u8_u32(w04.val[1]);
+    rows[5] = vreinterpret_u8_u32(w15.val[1]);
+    rows[6] = vreinterpret_u8_u32(w26.val[1]);
+    rows[7] = vreinterpret_u8_u32(w37.val[1]);
+}
+#endif
+
+#ifdef EDGE_KERNEL_SSE41
+// In-register 8x8 byte transpose: rows (low 8 bytes each) interleaved at 8,
+// 16 and 32 bits. columns[k] holds result rows 2k (low half) and 2k + 1.
+inline void transpose8x8(const __m128i (&rows)[8], __m128i (&columns)[4]) {
+    const __m128i p01 = _mm_unpacklo_epi8(rows[0], rows[1]);
+    const __m128i p23 = _mm_unpacklo_epi8(rows[2], rows[3]);
+    const __m128i p45 = _mm_unpacklo_epi8(rows[4], rows[5]);
+    const __m128i p67 = _mm_unpacklo_epi8(rows[6], rows[7]);
+    const __m128i q0 = _mm_unpacklo_epi16(p01, p23);  // columns 0-3 of rows 0-3
+    const __m128i q1 = _mm_unpackhi_epi16(p01, p23);  // columns 4-7 of rows 0-3
+    const __m128i q2 = _mm_unpacklo_epi16(p45, p67);
+    const __m128i q3 = _mm_unpackhi_epi16(p45, p67);
+    columns[0] = _mm_unpacklo_epi32(q0, q2);
+    columns[1] = _mm_unpackhi_epi32(q0, q2);
+    columns[2] = _mm_unpacklo_epi32(q1, q3);
+    columns[3] = _mm_unpackhi_epi32(q1, q3);
+}
+
+// Result row i of transpose8x8 in the low 8 bytes
+inline __m128i transposedRow(const __m128i (&columns)[4], int i) {
+    return (i & 1) ? _mm_srli_si128(columns[i >> 1], 8) : columns[i >> 1];
+}
+#endif
+
+void transposeBlockC1(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst, ptrdiff_t dstStride) {
+#ifdef EDGE_KERNEL_NEON
+    uint8x8_t rows[8];
+    for (int i = 0; i < 8; i++) {
+        rows[i] = vld1_u8(src + i * srcStride);
+    }
+    transpose8x8(rows);
+    for (int i = 0; i < 8; i++) {
+        vst1_u8(dst + i * dstStride, rows[i]);
+    }
+#elif defined(EDGE_KERNEL_SSE41)
+    __m128i rows[8];
+    for (int i = 0; i < 8; i++) {
+        rows[i] = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i * srcStride));
+    }
+    __m128i columns[4];
+    transpose8x8(rows, columns);
+    for (int i = 0; i < 8; i++) {
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i * dstStride), transposedRow(columns, i));
+    }
+#else
+    for (int i = 0; i < 8; i++) {
+        for (int j = 0; j < 8; j++) {
+            dst[i * dstStride + j] = src[j * srcStride + i];
+        }
+    }
+#endif
+}
+
+void transposeBlockC3(const uint8_t* src, ptrdiff_t srcStride, uint8_t* dst, ptrdiff_t dstStride) {
+#ifdef EDGE_KERNEL_NEON
+    // vld3 splits each row into its three channel planes, which transpose
+    // like 1-byte blocks; vst3 interleaves them again
+    uint8x8_t planes[3][8];
+    for (int i = 0; i < 8; i++) {
+        const uint8x8x3_t row = vld3_u8(src + i * srcStride);
+        planes[0][i] = row.val[0];
+        planes[1][i] = row.val[1];
+        planes[2][i] = row.val[2];
+    }
+    transpose8x8(planes[0]);
+    transpose8x8(planes[1]);
+    transpose8x8(planes[2]);
+    for (int i = 0; i < 8; i++) {
+        uint8x8x3_t row;
+        row.val[0] = planes[0][i];
+        row.val[1] = planes[1][i];
+        row.val[2] = planes[2][i];
+        vst3_u8(dst + i * dstStride, row);
+    }
+#elif defined(EDGE_KERNEL_SSE41)
+    // No vld3/vst3: byte shuffles split each 24-byte row into its channel
+    // planes (16 + 8 bytes loaded, nothing past the block), which transpose
+    // like 1-byte blocks, and interleave them again on the way out
+    const __m128i splitLow[3] = {_mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1),
+                                 _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1),
+                                 _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1)};
+    const __m128i splitHigh[3] = {_mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, -1, -1, -1, -1, -1, -1, -1, -1),
+                                  _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, -1, -1, -1, -1, -1, -1, -1, -1),
+                                  _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, -1, -1, -1, -1, -1, -1, -1, -1)};
+    __m128i planes[3][8];
+    for (int i = 0; i < 8; i++) {
+        const uint8_t* row = src + i * srcStride;
+        const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row));
+        const __m128i high = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + 16));
+        for (int c = 0; c < 3; c++) {
+            planes[c][i] = _mm_or_si128(_mm_shuffle_epi8(low, splitLow[c]), _mm_shuffle_epi8(high, splitHigh[c]));
+        }
+    }
+    __m128i columns[3][4];
+    for (int c = 0; c < 3; c++) {
+        transpose8x8(planes[c], columns[c]);
+    }
+    // From b0..b7 g0..g7 and r0..r7: bytes 0-15 and 16-23 of a BGR row
+    const __m128i joinLowBg = _mm_setr_epi8(0, 8, -1, 1, 9, -1, 2, 10, -1, 3, 11, -1, 4, 12, -1, 5);
+    const __m128i joinLowR = _mm_setr_epi8(-1, -1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1);
+    const __m128i joinHighBg = _mm_setr_epi8(13, -1, 6, 14, -1, 7, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i joinHighR = _mm_setr_epi8(-1, 5, -1, -1, 6, -1, -1, 7, -1, -1, -1, -1, -1, -1, -1, -1);
+    for (int i = 0; i < 8; i++) {
+        const __m128i bg = _mm_unpacklo_epi64(transposedRow(columns[0], i), transposedRow(columns[1], i));
+        const __m128i r = transposedRow(columns[2], i);
+        uint8_t* row = dst + i * dstStride;
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(row),
+                         _mm_or_si128(_mm_shuffle_epi8(bg, joinLowBg), _mm_shuffle_epi8(r, joinLowR)));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(row + 16),
+                         _mm_or_si128(_mm_shuffle_epi8(bg, joinHighBg), _mm_shuffle_epi8(r, joinHighR)));
+    }
+#else
+    for (int i = 0; i < 8; i++) {
+        for (int j = 0; j < 8; j++) {
+            std::memcpy(dst + i * dstStride + 3 * j, src + j * srcStride + 3 * i, 3);
+        }
+    }
+#endif
+}
+
+// --- Temporal denoise ----------------------------------------------------
+
+// Pixels whose change from the history is at most threshold keep the full
+// history weight; it then fades to 0 over kTemporalRamp luma levels, so
+// moving edges are never smeared
+const int kTemporalRampShift = 4;
+const int kTemporalRamp = 1 << kTemporalRampShift;
+
+void temporalBlendRow(const uint8_t* current, const uint8_t* history, int width, int strength, int threshold,
+                      uint8_t* out) {
+    int x = 0;
+#ifdef EDGE_KERNEL_NEON
+    const uint8x16_t knee = vdupq_n_u8(static_cast<uint8_t>(threshold + kTemporalRamp));
+    const uint8x16_t ramp = vdupq_n_u8(kTemporalRamp);
+    const uint8x8_t weight = vdup_n_u8(static_cast<uint8_t>(strength));
+    for (; x + 16 <= width; x += 16) {
+        const uint8x16_t c = vld1q_u8(current + x);
+        const uint8x16_t h = vld1q_u8(history + x);
+        // Motion-adaptive history weight in 1/128 units, at most strength
+        const uint8x16_t still = vminq_u8(vqsubq_u8(knee, vabdq_u8(c, h)), ramp);
+        const int16x8_t wLo =
+            vreinterpretq_s16_u16(vshrq_n_u16(vmull_u8(vget_low_u8(still), weight), kTemporalRampShift));
+        const int16x8_t wHi =
+            vreinterpretq_s16_u16(vshrq_n_u16(vmull_u8(vget_high_u8(still), weight), kTemporalRampShift));
+        // current + (history - current) * w / 128; |product| <= 255 * 128 fits 16 bits
+        const int16x8_t dLo = vreinterpretq_s16_u16(vsubl_u8(vget_low_u8(h), vget_low_u8(c)));
+        const int16x8_t dHi = vreinterpretq_s16_u16(vsubl_u8(vget_high_u8(h), vget_high_u8(c)));
+        const int16x8_t lo = vaddq_s16(vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(c))),
+                                       vrshrq_n_s16(vmulq_s16(dLo, wLo), 7));
+        const int16x8_t hi = vaddq_s16(vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(c))),
+                                       vrshrq_n_s16(vmulq_s16(dHi, wHi), 7));
+        vst1q_u8(out + x, vcombine_u8(vqmovun_s16(lo), vqmovun_s16(hi)));
+    }
+#endif
+    for (; x < width; x++) {
+        const int c = current[x];
+        const int h = history[x];
+        int still = threshold + kTemporalRamp - absInt(c - h);
+        still = still < 0 ? 0 : (still > kTemporalRamp ? kTemporalRamp : still);
+        const int w = (strength * still) >> kTemporalRampShift;
+        out[x] = static_cast<uint8_t>(c + (((h - c) * w + 64) >> 7));
+    }
+}
+
+// --- Hamming distances ---------------------------------------------------
+
+#if defined(EDGE_KERNEL_SSE41)
+// Per-byte bit counts of v by a nibble lookup: SSE4.1 implies SSSE3's
+// pshufb but not POPCNT
+inline __m128i popcountBytes(__m128i v) {
+    const __m128i lut = _mm_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    return _mm_add_epi8(_mm_shuffle_epi8(lut, _mm_and_si128(v, nibble)),
+                        _mm_shuffle_epi8(lut, _mm_and_si128(_mm_srli_epi16(v, 4), nibble)));
+}
+#endif
+
+#if !defined(EDGE_KERNEL_NEON) && !defined(EDGE_KERNEL_SSE41)
+const int kDescriptorBytes = 32;
+
+inline int popcount64(uint64_t v) {
+    v = v - ((v >> 1) & 0x5555555555555555ull);
+    v = (v & 0x3333333333333333ull) + ((v >> 2) & 0x3333333333333333ull);
+    v = (v + (v >> 4)) & 0x0f0f0f0f0f0f0f0full;
+    return static_cast<int>((v * 0x0101010101010101ull) >> 56);
+}
+#endif
+
+void hammingDistances(const uint8_t* query, const uint8_t* descriptors, size_t stride, const int32_t* candidates,
+                      int count, uint16_t* distances) {
+#if defined(EDGE_KERNEL_AVX2)
+    // The whole descriptor in one register; the lookup repeats per 128-bit lane
+    const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                         0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    const __m256i q = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(query));
+    for (int i = 0; i < count; i++) {
+        const uint8_t* d = descriptors + static_cast<size_t>(candidates[i]) * stride;
+        const __m256i x = _mm256_xor_si256(q, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(d)));
+        const __m256i bits = _mm256_add_epi8(_mm256_shuffle_epi8(lut, _mm256_and_si256(x, nibble)),
+                                             _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(x, 4),
+                                                                                       nibble)));
+        const __m256i sums = _mm256_sad_epu8(bits, _mm256_setzero_si256());
+        const __m128i half = _mm_add_epi64(_mm256_castsi256_si128(sums), _mm256_extracti128_si256(sums, 1));
+        distances[i] = static_cast<uint16_t>(_mm_cvtsi128_si32(half) + _mm_extract_epi16(half, 4));
+    }
+#elif defined(EDGE_KERNEL_SSE41)
+    const __m128i q0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(query));
+    const __m128i q1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(query + 16));
+    for (int i = 0; i < count; i++) {
+        const uint8_t* d = descriptors + static_cast<size_t>(candidates[i]) * stride;
+        const __m128i d0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(d));
+        const __m128i d1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(d + 16));
+        const __m128i bits = _mm_add_epi8(popcountBytes(_mm_xor_si128(q0, d0)), popcountBytes(_mm_xor_si128(q1, d1)));
+        const __m128i sums = _mm_sad_epu8(bits, _mm_setzero_si128());
+        distances[i] = static_cast<uint16_t>(_mm_cvtsi128_si32(sums) + _mm_extract_epi16(sums, 4));
+    }
+#elif defined(EDGE_KERNEL_NEON)
+    // VCNT per byte; the two halves' counts (at most 16 per lane) add in bytes
+    const uint8x16_t q0 = vld1q_u8(query);
+    const uint8x16_t q1 = vld1q_u8(query + 16);
+    for (int i = 0; i < count; i++) {
+        const uint8_t* d = descriptors + static_cast<size_t>(candidates[i]) * stride;
+        const uint8x16_t bits =
+                vaddq_u8(vcntq_u8(veorq_u8(q0, vld1q_u8(d))), vcntq_u8(veorq_u8(q1, vld1q_u8(d + 16))));
+#if defined(__aarch64__)
+        distances[i] = vaddlvq_u8(bits);
+#else
+        const uint64x2_t sums = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(bits)));
+        distances[i] = static_cast<uint16_t>(vgetq_lane_u64(sums, 0) + vgetq_lane_u64(sums, 1));
+#endif
+    }
+#else
+    for (int i = 0; i < count; i++) {
+        const uint8_t* d = descriptors + static_cast<size_t>(candidates[i]) * stride;
+        int distance = 0;
+        for (int k = 0; k < kDescriptorBytes; k += 8) {
+            uint64_t a;
+            uint64_t b;
+            std::memcpy(&a, query + k, sizeof(a));
+            std::memcpy(&b, d + k, sizeof(b));
+            distance += popcount64(a ^ b);
+        }
+        distances[i] = static_cast<uint16_t>(distance);
+    }
+#endif
+}
+
+} // namespace
+
+bool EDGE_KERNEL_FILL(EdgeKernels& kernels) {
+    kernels.level = kLevel;
+    kernels.gradientRow = &gradientRow;
+    kernels.gradientThresholdRow = &gradientThresholdRow;
+    kernels.packRow = &packRow;
+    kernels.compactRow = &compactRow;
+    kernels.planarToBgrRow = &planarToBgrRow;
+    kernels.p010LumaRow = &p010LumaRow;
+    kernels.p010ChromaRow = &p010ChromaRow;
+    kernels.bayerBinRow16 = &bayerBinRow16;
+    kernels.bayerBinRowRaw10 = &bayerBinRowRaw10;
+    kernels.transposeBlockC1 = &transposeBlockC1;
+    kernels.transposeBlockC3 = &transposeBlockC3;
+    kernels.temporalBlendRow = &temporalBlendRow;
+    kernels.hammingDistances = &hammingDistances;
+#if (defined(EDGE_KERNEL_REQUIRE_NEON) && !defined(EDGE_KERNEL_NEON)) || \
+    (defined(EDGE_KERNEL_REQUIRE_DOTPROD) && !defined(EDGE_KERNEL_DOTPROD)) || \
+    (defined(EDGE_KERNEL_REQUIRE_SSE41) && !defined(EDGE_KERNEL_SSE41)) || \
+    (defined(EDGE_KERNEL_REQUIRE_AVX2) && !defined(EDGE_KERNEL_AVX2))
+    return false;  // built for a target without this level: the table is the scalar code
+#else
+    return true;
+#endif
+}
@@ -0,0 +1,5 @@
+// NEON kernels: ARMv7 NEON on armeabi-v7a (built with -mfpu=neon), the
+// AArch64 baseline on arm64-v8a; empty on other targets
+#define EDGE_KERNEL_REQUIRE_NEON 1
+#define EDGE_KERNEL_FILL fillNeonKernels
+#include "kernels_impl.h"
@@ -0,0 +1,5 @@
+// Portable reference kernels, the fallback on every ABI. Built without NEON
+// on armeabi-v7a, so NEON-less ARMv7 silicon can run them (CMakeLists.txt).
+#define EDGE_KERNEL_SCALAR 1
+#define EDGE_KERNEL_FILL fillScalarKernels
+#include "kernels_impl.h"
@@ -0,0 +1,5 @@
+// SSE4.1 kernels, the x86_64 baseline (Android's x86_64 ABI guarantees
+// SSE4.2), built with -msse4.1 for desktop hosts too; empty elsewhere
+#define EDGE_KERNEL_REQUIRE_SSE41 1
+#define EDGE_KERNEL_FILL fillSse41Kernels
+#include "kernels_impl.h"
@@ -0,0 +1,148 @@
+#include "lens_undistortion.h"
+#include "mapped_asset.h"
+#include <opencv2/calib3d.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+
+#define LOG_TAG "LensUndistortion"
+#include "logging.h"
+
+namespace {
+
+const size_t kMaxCachedSizes = 3;
+
+}  // namespace
+
+cv::Matx33d scaledCameraMatrix(const LensCalibration& calibration, const cv::Size& size) {
+    const double sx = static_cast<double>(size.width) / calibration.size.width;
+    const double sy = static_cast<double>(size.height) / calibration.size.height;
+    const cv::Matx33d& k = calibration.cameraMatrix;
+    return cv::Matx33d(k(0, 0) * sx, k(0, 1) * sx, (k(0, 2) + 0.5) * sx - 0.5,
+                       0.0, k(1, 1) * sy, (k(1, 2) + 0.5) * sy - 0.5,
+                       0.0, 0.0, 1.0);
+}
+
+void LensUndistortion::setCalibration(const LensCalibration& next) {
+    std::lock_guard<std::mutex> lock(mutex);
+    calibration = next;
+    generation++;
+    cache.clear();
+    LOGI("Lens calibration set: %dx%d, fx %.1f fy %.1f, %zu distortion coefficients", next.size.width,
+         next.size.height, next.cameraMatrix(0, 0), next.cameraMatrix(1, 1), next.distortion.size());
+}
+
+bool LensUndistortion::loadCalibration(const std::string& path) {
+    LensCalibration loaded;
+    try {
+        cv::FileStorage file;
+        if (!openMappedStorage(path, file)) {
+            LOGE("❌ Cannot open calibration %s", path.c_str());
+            return false;
+        }
+        cv::Mat cameraMatrix;
+        cv::Mat distortion;
+        file["camera_matrix"] >> cameraMatrix;
+        file["distortion_coefficients"] >> distortion;
+        file["image_width"] >> loaded.size.width;
+        file["image_height"] >> loaded.size.height;
+        if (cameraMatrix.total() != 9 || distortion.total() < 4 || distortion.total() > 8 ||
+            loaded.size.width <= 0 || loaded.size.height <= 0) {
+            LOGE("❌ Calibration %s lacks camera_matrix, distortion_coefficients or the image size", path.c_str());
+            return false;
+        }
+        cv::Mat intrinsics;
+        cameraMatrix.reshape(1, 3).convertTo(intrinsics, CV_64F);
+        loaded.cameraMatrix = cv::Matx33d(intrinsics);
+        distortion.reshape(1, 1).convertTo(loaded.distortion, CV_64F);
+    } catch (const cv::Exception& e) {
+        LOGE("❌ Reading calibration %s failed: %s", path.c_str(), e.what());
+        return false;
+    }
+    setCalibration(loaded);
+    return true;
+}
+
+bool LensUndistortion::calibrated() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return generation != 0;
+}
+
+bool LensUndistortion::currentCalibration(LensCalibration& out) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (generation == 0) {
+        return false;
+    }
+    out = calibration;
+    return true;
+}
+
+void LensUndistortion::setMode(Mode mode) {
+    currentMode.store(static_cast<int>(mode), std::memory_order_relaxed);
+}
+
+LensUndistortion::Mode LensUndistortion::mode() const {
+    return static_cast<Mode>(currentMode.load(std::memory_order_relaxed));
+}
+
+std::shared_ptr<const LensUndistortion::Maps> LensUndistortion::maps(const cv::Size& size, bool gpu) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (generation == 0 || size.width <= 0 || size.height <= 0) {
+        return nullptr;
+    }
+    auto cached = std::find_if(cache.begin(), cache.end(), [&](const std::shared_ptr<const Maps>& entry) {
+        return entry->size == size;
+    });
+    if (cached != cache.end() && !(gpu ? (*cached)->gpu.empty() : (*cached)->xy.empty())) {
+        return *cached;
+    }
+
+    // The other kind of map, if it was built, is kept alongside
+    auto built = cached != cache.end() ? std::make_shared<Maps>(**cached) : std::make_shared<Maps>();
+    built->size = size;
+    built->generation = generation;
+    const cv::Matx33d k = scaledCameraMatrix(calibration, size);
+    if (gpu) {
+        cv::initUndistortRectifyMap(k, calibration.distortion, cv::noArray(), k, size, CV_32FC2, built->gpu,
+                                    cv::noArray());
+        // Source pixel centres as texture coordinates
+        cv::add(built->gpu, cv::Scalar(0.5, 0.5), built->gpu);
+        cv::multiply(built->gpu, cv::Scalar(1.0 / size.width, 1.0 / size.height), built->gpu);
+    } else {
+        cv::initUndistortRectifyMap(k, calibration.distortion, cv::noArray(), k, size, CV_16SC2, built->xy,
+                                    built->fraction);
+    }
+    LOGI("Undistortion %s map built for %dx%d", gpu ? "GPU" : "CPU", size.width, size.height);
+
+    if (cached != cache.end()) {
+        *cached = built;
+    } else {
+        if (cache.size() >= kMaxCachedSizes) {
+            cache.erase(cache.begin());
+        }
+        cache.push_back(built);
+    }
+    return built;
+}
+
+std::shared_ptr<const LensUndistortion::Maps> LensUndistortion::gpuMaps(const cv::Size& size) {
+    return maps(size, true);
+}
+
+bool LensUndistortion::remap(const cv::Mat& luma, cv::Mat& dst) {
+    std::shared_ptr<const Maps> fixed = maps(luma.size(), false);
+    if (!fixed) {
+        return false;
+    }
+    cv::remap(luma, dst, fixed->xy, fixed->fraction, cv::INTER_LINEAR, cv::BORDER_CONSTANT);
+    return true;
+}
+
+void LensUndistortion::releaseMaps() {
+    std::lock_guard<std::mutex> lock(mutex);
+    cache.clear();
+}
+
+LensUndistortion& lensUndistortion() {
+    static LensUndistortion undistortion;
+    return undistortion;
+}
@@ -0,0 +1,89 @@
+#ifndef EDGE_LENS_UNDISTORTION_H
+#define EDGE_LENS_UNDISTORTION_H
+
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Camera intrinsics and distortion coefficients (OpenCV's model: k1 k2 p1 p2
+// [k3 [k4 k5 k6]]), in pixels of the frame size they were calibrated at
+struct LensCalibration {
+    cv::Matx33d cameraMatrix;
+    std::vector<double> distortion;
+    cv::Size size;
+};
+
+// Intrinsics of a calibration for another frame size (same field of view),
+// scaled about pixel centres
+cv::Matx33d scaledCameraMatrix(const LensCalibration& calibration, const cv::Size& size);
+
+// Lens undistortion with every map precomputed: cv::initUndistortRectifyMap
+// runs once per frame size (the intrinsics are scaled to it), never per
+// frame. The renderer samples a float map (GPU) so only displayed pixels are
+// moved; the CPU pipeline can instead remap the luma before processing with
+// the fixed-point maps cv::remap is fastest with, which puts every result
+// (edges, contours, lines, markers) in undistorted coordinates.
+class LensUndistortion {
+public:
+    enum class Mode {
+        OFF = 0,
+        GPU = 1,  // displayed frame layers are remapped by the renderer
+        CPU = 2   // the processed luma is remapped before the pipeline runs
+    };
+
+    // Maps of one frame size. gpu is CV_32FC2: per undistorted pixel, where
+    // it lies in the captured frame as a 0..1 texture coordinate (outside
+    // 0..1 = not covered). xy and fraction are cv::convertMaps' CV_16SC2 and
+    // CV_16UC1 pair. Each is only built when first asked for.
+    struct Maps {
+        cv::Size size;
+        cv::Mat gpu;
+        cv::Mat xy;
+        cv::Mat fraction;
+        uint64_t generation = 0;  // calibration they were built from
+    };
+
+    // Replaces the calibration; maps of the previous one are dropped
+    void setCalibration(const LensCalibration& calibration);
+    // Reads camera_matrix, distortion_coefficients, image_width and
+    // image_height from an OpenCV calibration file (YAML, XML or JSON; a
+    // path or an APK asset, mapped_asset.h); false, keeping the current
+    // calibration, if any is missing
+    bool loadCalibration(const std::string& path);
+    bool calibrated();
+
+    // Copies the calibration into out; false (out untouched) without one
+    bool currentCalibration(LensCalibration& out);
+
+    void setMode(Mode mode);
+    Mode mode() const;
+
+    // Renderer maps for a size x size texture; null without a calibration
+    std::shared_ptr<const Maps> gpuMaps(const cv::Size& size);
+
+    // Mode::CPU: luma (CV_8UC1) undistorted into dst; false (dst untouched)
+    // without a calibration
+    bool remap(const cv::Mat& luma, cv::Mat& dst);
+
+    // Drops the cached maps (memory trimming); rebuilt when next asked for
+    void releaseMaps();
+
+private:
+    std::shared_ptr<const Maps> maps(const cv::Size& size, bool gpu);
+
+    std::mutex mutex;
+    std::atomic<int> currentMode{static_cast<int>(Mode::OFF)};
+    LensCalibration calibration;
+    uint64_t generation = 0;  // 0 = not calibrated
+    // Few sizes are ever live at once (processing scale, full frame)
+    std::vector<std::shared_ptr<const Maps>> cache;
+};
+
+// Undistortion shared by the pipeline and the renderer
+LensUndistortion& lensUndistortion();
+
+#endif // EDGE_LENS_UNDISTORTION_H
@@ -0,0 +1,72 @@
+#include "line_detector.h"
+#include "metrics.h"
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+
+namespace {
+
+// The scene counts as stable while fewer reduced-map pixels than this
+// fraction differ from the map the cached segments were voted on
+const double kStableFraction = 0.01;
+
+}  // namespace
+
+LineDetector::Settings LineDetector::settingsFor(Preset preset) {
+    switch (preset) {
+        case Preset::FAST: return {4, 2.0, 30, 10.0, 3.0, 4};
+        case Preset::ACCURATE: return {1, 0.5, 80, 40.0, 8.0, 0};
+        case Preset::BALANCED:
+        default: return {2, 1.0, 50, 20.0, 5.0, 2};
+    }
+}
+
+void LineDetector::setPreset(Preset preset) {
+    std::lock_guard<std::mutex> lock(mutex);
+    current = preset;
+    valid = false;
+}
+
+int LineDetector::detect(const cv::Mat& edges, cv::Mat& lines) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const Settings settings = settingsFor(current);
+
+    // Area averaging keeps one-pixel edges as faint values; any of them votes
+    if (settings.downscale > 1) {
+        cv::resize(edges, reduced, cv::Size(std::max(1, edges.cols / settings.downscale),
+                                            std::max(1, edges.rows / settings.downscale)),
+                   0, 0, cv::INTER_AREA);
+        cv::threshold(reduced, reduced, 0, 255, cv::THRESH_BINARY);
+    } else {
+        edges.copyTo(reduced);
+    }
+
+    bool reuse = false;
+    if (valid && skipped < settings.maxSkip && reduced.size() == previousReduced.size()) {
+        cv::bitwise_xor(reduced, previousReduced, difference);
+        reuse = cv::countNonZero(difference) < kStableFraction * reduced.total();
+    }
+    if (reuse) {
+        skipped++;
+        metrics().increment(Counter::HOUGH_FRAMES_SKIPPED);
+    } else {
+        cv::HoughLinesP(reduced, segments, 1.0, settings.thetaDegrees * CV_PI / 180.0, settings.votes,
+                        settings.minLength, settings.maxGap);
+        std::swap(reduced, previousReduced);
+        segmentScale = static_cast<float>(edges.cols) / previousReduced.cols;
+        skipped = 0;
+        valid = true;
+    }
+
+    const int count = std::min({static_cast<int>(segments.size()), lines.rows / 2, kMaxLines});
+    for (int i = 0; i < count; i++) {
+        const cv::Vec4i& s = segments[i];
+        lines.at<cv::Vec2f>(2 * i) = cv::Vec2f(s[0] * segmentScale, s[1] * segmentScale);
+        lines.at<cv::Vec2f>(2 * i + 1) = cv::Vec2f(s[2] * segmentScale, s[3] * segmentScale);
+    }
+    return count;
+}
+
+LineDetector& lineDetector() {
+    static LineDetector detector;
+    return detector;
+}
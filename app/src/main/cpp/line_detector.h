@@ -0,0 +1,54 @@
+#ifndef EDGE_LINE_DETECTOR_H
+#define EDGE_LINE_DETECTOR_H
+
+#include <opencv2/core.hpp>
+#include <mutex>
+#include <vector>
+
+// Straight segments of an edge map with cv::HoughLinesP. The voting runs on a
+// reduced copy of the edges (area-downsampled, so thin lines survive), and
+// while the reduced map barely changes between frames the previous segments
+// are reused for up to maxSkip frames instead of voting again.
+class LineDetector {
+public:
+    enum class Preset {
+        FAST = 0,      // quarter resolution, coarse angles, skips most often
+        BALANCED = 1,  // half resolution
+        ACCURATE = 2   // full resolution, fine angles, votes every frame
+    };
+
+    static const int kMaxLines = 512;
+
+    void setPreset(Preset preset);
+
+    // Writes each segment as a pair of (x, y) pixel positions of edges: rows
+    // 2i and 2i + 1 of lines (CV_32FC2, at least 2 * kMaxLines rows). Returns
+    // the number of segments.
+    int detect(const cv::Mat& edges, cv::Mat& lines);
+
+private:
+    struct Settings {
+        int downscale;        // reduced map is 1/downscale of the edge map per axis
+        double thetaDegrees;  // angle resolution
+        int votes;            // accumulator threshold
+        double minLength;     // in reduced-map pixels
+        double maxGap;
+        int maxSkip;          // consecutive frames that may reuse the last result
+    };
+    static Settings settingsFor(Preset preset);
+
+    std::mutex mutex;
+    Preset current = Preset::BALANCED;
+    cv::Mat reduced;
+    cv::Mat previousReduced;
+    cv::Mat difference;
+    std::vector<cv::Vec4i> segments;   // last result, in reduced-map pixels
+    float segmentScale = 1.0f;         // reduced -> edge map pixels
+    int skipped = 0;
+    bool valid = false;
+};
+
+// Detector used by the LINES render mode
+LineDetector& lineDetector();
+
+#endif // EDGE_LINE_DETECTOR_H
@@ -0,0 +1,84 @@
+#ifndef EDGE_LOGGING_H
+#define EDGE_LOGGING_H
+
+// Leveled logging shared by all native sources. Each .cpp defines LOG_TAG before
+// including this header. Calls below EDGE_LOG_LEVEL compile to nothing (their
+// arguments are not evaluated), so per-frame LOGD/LOGV calls cost nothing in
+// release builds.
+//
+//   LOGV / LOGD  per-frame pipeline tracing (debug builds only)
+//   LOGI         lifecycle and configuration changes
+//   LOGW / LOGE  problems; use the *_RATELIMITED forms on per-frame paths
+//
+// Off Android (the edge_core library in host builds, e.g. edge_bench) the
+// same calls print to stderr.
+
+#ifdef __ANDROID__
+#include <android/log.h>
+#define EDGE_LOG_WRITE(prio, ...) __android_log_print((prio), LOG_TAG, __VA_ARGS__)
+#else
+#include <cstdio>
+enum {
+    ANDROID_LOG_VERBOSE = 2,
+    ANDROID_LOG_DEBUG = 3,
+    ANDROID_LOG_INFO = 4,
+    ANDROID_LOG_WARN = 5,
+    ANDROID_LOG_ERROR = 6,
+};
+#define EDGE_LOG_WRITE(prio, ...) \
+    (std::fprintf(stderr, "%s: ", LOG_TAG), std::fprintf(stderr, __VA_ARGS__), std::fputc('\n', stderr))
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#ifndef EDGE_LOG_LEVEL
+#ifdef NDEBUG
+#define EDGE_LOG_LEVEL ANDROID_LOG_WARN
+#else
+#define EDGE_LOG_LEVEL ANDROID_LOG_DEBUG
+#endif
+#endif
+
+#define EDGE_LOG(prio, ...)                                         \
+    do {                                                            \
+        if ((prio) >= EDGE_LOG_LEVEL) {                             \
+            EDGE_LOG_WRITE((prio), __VA_ARGS__);                    \
+        }                                                           \
+    } while (0)
+
+#define LOGV(...) EDGE_LOG(ANDROID_LOG_VERBOSE, __VA_ARGS__)
+#define LOGD(...) EDGE_LOG(ANDROID_LOG_DEBUG, __VA_ARGS__)
+#define LOGI(...) EDGE_LOG(ANDROID_LOG_INFO, __VA_ARGS__)
+#define LOGW(...) EDGE_LOG(ANDROID_LOG_WARN, __VA_ARGS__)
+#define LOGE(...) EDGE_LOG(ANDROID_LOG_ERROR, __VA_ARGS__)
+
+namespace edge_log {
+
+// True at most once per interval for a given call site
+inline bool shouldLog(std::atomic<int64_t>& lastLogMs, int64_t intervalMs) {
+    int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    int64_t last = lastLogMs.load(std::memory_order_relaxed);
+    return now - last >= intervalMs &&
+           lastLogMs.compare_exchange_strong(last, now, std::memory_order_relaxed);
+}
+
+} // namespace edge_log
+
+// Logs at most once per second per call site (e.g. fallback-frame paths)
+#define EDGE_LOG_RATELIMITED(prio, ...)                                          \
+    do {                                                                         \
+        if ((prio) >= EDGE_LOG_LEVEL) {                                          \
+            static std::atomic<int64_t> edgeLastLogMs{INT64_MIN / 2};            \
+            if (edge_log::shouldLog(edgeLastLogMs, 1000)) {                      \
+                EDGE_LOG_WRITE((prio), __VA_ARGS__);                             \
+            }                                                                    \
+        }                                                                        \
+    } while (0)
+
+#define LOGW_RATELIMITED(...) EDGE_LOG_RATELIMITED(ANDROID_LOG_WARN, __VA_ARGS__)
+#define LOGE_RATELIMITED(...) EDGE_LOG_RATELIMITED(ANDROID_LOG_ERROR, __VA_ARGS__)
+
+#endif // EDGE_LOGGING_H
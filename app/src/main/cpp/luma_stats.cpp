@@ -0,0 +1,184 @@
+#include "luma_stats.h"
+#include <atomic>
+#include <cstring>
+#include <mutex>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define EDGE_STATS_NEON 1
+#endif
+
+namespace {
+
+static_assert(sizeof(LumaStats) % sizeof(uint32_t) == 0, "LumaStats is copied as 32-bit words");
+const size_t kWords = sizeof(LumaStats) / sizeof(uint32_t);
+
+// Sequence lock: odd while a publish is in progress
+std::atomic<uint32_t> version{0};
+std::atomic<uint32_t> words[kWords];
+std::mutex publishMutex;   // writers only; readers never take it
+uint32_t publishCount = 0;
+
+// Sum and sum of squares of one row
+void rowMoments(const uchar* row, int width, uint64_t& sum, uint64_t& sumSq) {
+    int x = 0;
+#ifdef EDGE_STATS_NEON
+    uint32x4_t vSum = vdupq_n_u32(0);
+    uint32x4_t vSq = vdupq_n_u32(0);
+    for (; x + 16 <= width; x += 16) {
+        uint8x16_t v = vld1q_u8(row + x);
+        vSum = vpadalq_u16(vSum, vpaddlq_u8(v));
+        uint8x8_t lo = vget_low_u8(v);
+        uint8x8_t hi = vget_high_u8(v);
+        vSq = vpadalq_u16(vSq, vmull_u8(lo, lo));
+        vSq = vpadalq_u16(vSq, vmull_u8(hi, hi));
+    }
+    uint32_t lanes[4];
+    vst1q_u32(lanes, vSum);
+    sum += static_cast<uint64_t>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+    vst1q_u32(lanes, vSq);
+    sumSq += static_cast<uint64_t>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+#endif
+    for (; x < width; x++) {
+        sum += row[x];
+        sumSq += static_cast<uint32_t>(row[x]) * row[x];
+    }
+}
+
+// Sum and sum of squares of the 4-neighbour Laplacian over the interior of one
+// row; |lap| <= 1020, so 8 products per step fit int32 lanes for any row up to
+// several thousand pixels before the per-row flush
+void rowLaplacian(const uchar* up, const uchar* row, const uchar* down, int width,
+                  int64_t& sum, uint64_t& sumSq) {
+    int x = 1;
+#ifdef EDGE_STATS_NEON
+    int32x4_t vSum = vdupq_n_s32(0);
+    uint32x4_t vSq = vdupq_n_u32(0);
+    for (; x + 8 <= width - 1; x += 8) {
+        int16x8_t c = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(row + x)));
+        int16x8_t l = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(row + x - 1)));
+        int16x8_t r = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(row + x + 1)));
+        int16x8_t u = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(up + x)));
+        int16x8_t d = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(down + x)));
+        int16x8_t lap = vsubq_s16(vshlq_n_s16(c, 2), vaddq_s16(vaddq_s16(l, r), vaddq_s16(u, d)));
+        vSum = vpadalq_s16(vSum, lap);
+        int16x4_t lo = vget_low_s16(lap);
+        int16x4_t hi = vget_high_s16(lap);
+        vSq = vaddq_u32(vSq, vreinterpretq_u32_s32(vmull_s16(lo, lo)));
+        vSq = vaddq_u32(vSq, vreinterpretq_u32_s32(vmull_s16(hi, hi)));
+    }
+    int32_t sumLanes[4];
+    vst1q_s32(sumLanes, vSum);
+    sum += static_cast<int64_t>(sumLanes[0]) + sumLanes[1] + sumLanes[2] + sumLanes[3];
+    uint32_t sqLanes[4];
+    vst1q_u32(sqLanes, vSq);
+    sumSq += static_cast<uint64_t>(sqLanes[0]) + sqLanes[1] + sqLanes[2] + sqLanes[3];
+#endif
+    for (; x < width - 1; x++) {
+        int lap = 4 * row[x] - row[x - 1] - row[x + 1] - up[x] - down[x];
+        sum += lap;
+        sumSq += static_cast<uint64_t>(lap * lap);
+    }
+}
+
+}  // namespace
+
+void computeLumaStats(const cv::Mat& luma, LumaStats& stats) {
+    CV_Assert(luma.empty() || luma.type() == CV_8UC1);
+    std::memset(&stats, 0, sizeof(stats));
+    stats.median = -1;
+    stats.afState = -1;
+    stats.aeState = -1;
+    if (luma.empty()) {
+        return;
+    }
+
+    const int width = luma.cols;
+    const int height = luma.rows;
+    uint32_t partial[4][256] = {};
+    uint64_t sum = 0, sumSq = 0;
+    int64_t lapSum = 0;
+    uint64_t lapSq = 0;
+
+    for (int y = 0; y < height; y++) {
+        const uchar* row = luma.ptr<uchar>(y);
+        int x = 0;
+        for (; x + 4 <= width; x += 4) {
+            partial[0][row[x]]++;
+            partial[1][row[x + 1]]++;
+            partial[2][row[x + 2]]++;
+            partial[3][row[x + 3]]++;
+        }
+        for (; x < width; x++) {
+            partial[0][row[x]]++;
+        }
+        rowMoments(row, width, sum, sumSq);
+        // The row is still in L1, so the Laplacian of the row above is
+        // computed now, reading this one as its lower neighbour
+        if (y >= 2 && width >= 3) {
+            rowLaplacian(luma.ptr<uchar>(y - 2), luma.ptr<uchar>(y - 1), row, width, lapSum, lapSq);
+        }
+    }
+
+    const uint32_t pixels = static_cast<uint32_t>(width) * height;
+    uint32_t half = (pixels + 1) / 2;
+    uint32_t seen = 0;
+    uint32_t dark = 0, bright = 0;
+    for (int value = 0; value < 256; value++) {
+        uint32_t count = partial[0][value] + partial[1][value] + partial[2][value] + partial[3][value];
+        stats.histogram[value] = count;
+        seen += count;
+        if (stats.median < 0 && seen >= half) {
+            stats.median = value;
+        }
+        if (value <= kDarkLuma) dark += count;
+        if (value >= kBrightLuma) bright += count;
+    }
+    stats.pixels = pixels;
+    const double mean = static_cast<double>(sum) / pixels;
+    stats.mean = static_cast<float>(mean);
+    stats.variance = static_cast<float>(static_cast<double>(sumSq) / pixels - mean * mean);
+    stats.darkFraction = static_cast<float>(dark) / pixels;
+    stats.brightFraction = static_cast<float>(bright) / pixels;
+    if (height >= 3 && width >= 3) {
+        const double interior = static_cast<double>(width - 2) * (height - 2);
+        const double lapMean = lapSum / interior;
+        stats.sharpness = static_cast<float>(lapSq / interior - lapMean * lapMean);
+    }
+}
+
+void publishLumaStats(LumaStats& stats) {
+    std::lock_guard<std::mutex> lock(publishMutex);
+    stats.sequence = ++publishCount;
+    uint32_t raw[kWords];
+    std::memcpy(raw, &stats, sizeof(stats));
+    uint32_t v = version.load(std::memory_order_relaxed);
+    version.store(v + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < kWords; i++) {
+        words[i].store(raw[i], std::memory_order_relaxed);
+    }
+    version.store(v + 2, std::memory_order_release);
+}
+
+bool latestLumaStats(LumaStats& stats) {
+    uint32_t raw[kWords];
+    while (true) {
+        uint32_t before = version.load(std::memory_order_acquire);
+        if (before == 0) {
+            return false;
+        }
+        if (before & 1) {
+            continue;  // a publish is in progress; it only takes a few hundred stores
+        }
+        for (size_t i = 0; i < kWords; i++) {
+            raw[i] = words[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (version.load(std::memory_order_relaxed) == before) {
+            break;
+        }
+    }
+    std::memcpy(&stats, raw, sizeof(stats));
+    return true;
+}
@@ -0,0 +1,41 @@
+#ifndef EDGE_LUMA_STATS_H
+#define EDGE_LUMA_STATS_H
+
+#include <opencv2/core.hpp>
+#include <cstdint>
+
+// Exposure and focus telemetry of one luma frame, all from a single walk over
+// the plane: the histogram, mean and variance, and the variance of the
+// 4-neighbour Laplacian (a standard sharpness score: it drops as the image
+// blurs). Consumers read the published snapshot instead of sampling the frame
+// again themselves.
+struct LumaStats {
+    uint32_t histogram[256];
+    uint32_t pixels;
+    float mean;
+    float variance;
+    float sharpness;         // variance of the Laplacian over interior pixels
+    float darkFraction;      // share of pixels at or below kDarkLuma (underexposure)
+    float brightFraction;    // share at or above kBrightLuma (clipped highlights)
+    int32_t median;          // -1 for an empty frame
+    int32_t afState;         // capture_metadata.h, of the frame's capture; -1 = no result matched
+    int32_t aeState;
+    uint32_t lensMoving;
+    uint32_t sequence;       // increments with every publish; 0 = never published
+};
+
+const int kDarkLuma = 16;
+const int kBrightLuma = 235;
+
+// The one pass; NEON for the sums and the Laplacian, four interleaved scalar
+// histograms (no NEON scatter) so consecutive equal pixels do not serialize
+void computeLumaStats(const cv::Mat& luma, LumaStats& stats);
+
+// Lock-free: a sequence lock over relaxed atomic words, so any number of
+// threads (JNI, pipeline) read while the processing thread publishes
+void publishLumaStats(LumaStats& stats);
+
+// False until the first publish
+bool latestLumaStats(LumaStats& stats);
+
+#endif // EDGE_LUMA_STATS_H
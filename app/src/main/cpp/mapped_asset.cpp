@@ -0,0 +1,131 @@
+#include "mapped_asset.h"
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __ANDROID__
+#include <android/asset_manager.h>
+#endif
+
+#define LOG_TAG "MappedAsset"
+#include "logging.h"
+
+namespace {
+
+std::atomic<AAssetManager*> assetManager{nullptr};
+
+// mmap offsets must be page aligned; an asset starts anywhere in the APK
+void* mapRange(int fd, off_t offset, size_t length, size_t& mappedBytes, size_t& lead) {
+    const off_t page = static_cast<off_t>(sysconf(_SC_PAGESIZE));
+    const off_t aligned = offset - offset % page;
+    lead = static_cast<size_t>(offset - aligned);
+    mappedBytes = length + lead;
+    void* mapped = mmap(nullptr, mappedBytes, PROT_READ, MAP_PRIVATE, fd, aligned);
+    return mapped == MAP_FAILED ? nullptr : mapped;
+}
+
+} // namespace
+
+bool isAssetPath(const std::string& path) {
+    return path.compare(0, std::strlen(MappedAsset::kAssetPrefix), MappedAsset::kAssetPrefix) == 0;
+}
+
+void setAssetManager(AAssetManager* manager) {
+    assetManager.store(manager, std::memory_order_release);
+}
+
+std::shared_ptr<MappedAsset> MappedAsset::open(const std::string& path) {
+    std::shared_ptr<MappedAsset> result(new MappedAsset());
+    size_t lead = 0;
+    if (isAssetPath(path)) {
+#ifdef __ANDROID__
+        AAssetManager* manager = assetManager.load(std::memory_order_acquire);
+        if (!manager) {
+            LOGE("❌ No asset manager for %s", path.c_str());
+            return nullptr;
+        }
+        const std::string name = path.substr(std::strlen(kAssetPrefix));
+        AAsset* asset = AAssetManager_open(manager, name.c_str(), AASSET_MODE_RANDOM);
+        if (!asset) {
+            LOGE("❌ No asset %s", name.c_str());
+            return nullptr;
+        }
+        off64_t start = 0;
+        off64_t length = 0;
+        const int fd = AAsset_openFileDescriptor64(asset, &start, &length);
+        if (fd >= 0) {
+            result->length = static_cast<size_t>(length);
+            result->mapping = mapRange(fd, static_cast<off_t>(start), result->length, result->mappingBytes, lead);
+            close(fd);
+            AAsset_close(asset);
+            if (!result->mapping) {
+                LOGE("❌ mmap of asset %s failed: %s", name.c_str(), strerror(errno));
+                return nullptr;
+            }
+            result->bytes = static_cast<const char*>(result->mapping) + lead;
+            LOGI("✅ Mapped asset %s (%zu bytes)", name.c_str(), result->length);
+            return result;
+        }
+        // Compressed in the APK: only the inflated copy exists
+        const void* buffer = AAsset_getBuffer(asset);
+        if (!buffer) {
+            LOGE("❌ Cannot read asset %s", name.c_str());
+            AAsset_close(asset);
+            return nullptr;
+        }
+        LOGW("⚠️ Asset %s is compressed; store it uncompressed to map it", name.c_str());
+        result->asset = asset;
+        result->bytes = static_cast<const char*>(buffer);
+        result->length = static_cast<size_t>(AAsset_getLength64(asset));
+        return result;
+#else
+        LOGE("❌ Asset paths need Android: %s", path.c_str());
+        return nullptr;
+#endif
+    }
+
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOGE("❌ Cannot open %s: %s", path.c_str(), strerror(errno));
+        return nullptr;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        LOGE("❌ %s is empty", path.c_str());
+        close(fd);
+        return nullptr;
+    }
+    result->length = static_cast<size_t>(info.st_size);
+    result->mapping = mapRange(fd, 0, result->length, result->mappingBytes, lead);
+    close(fd);
+    if (!result->mapping) {
+        LOGE("❌ mmap of %s failed: %s", path.c_str(), strerror(errno));
+        return nullptr;
+    }
+    result->bytes = static_cast<const char*>(result->mapping);
+    return result;
+}
+
+MappedAsset::~MappedAsset() {
+    if (mapping) {
+        munmap(mapping, mappingBytes);
+    }
+#ifdef __ANDROID__
+    if (asset) {
+        AAsset_close(static_cast<AAsset*>(asset));
+    }
+#endif
+}
+
+bool openMappedStorage(const std::string& path, cv::FileStorage& storage) {
+    if (!isAssetPath(path)) {
+        return storage.open(path, cv::FileStorage::READ);
+    }
+    std::shared_ptr<MappedAsset> asset = MappedAsset::open(path);
+    // FileStorage parses from a string in MEMORY mode; calibrations are a few KB
+    return asset && storage.open(std::string(asset->data(), asset->size()),
+                                 cv::FileStorage::READ | cv::FileStorage::MEMORY);
+}
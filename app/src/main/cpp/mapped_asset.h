@@ -0,0 +1,60 @@
+#ifndef EDGE_MAPPED_ASSET_H
+#define EDGE_MAPPED_ASSET_H
+
+#include <opencv2/core.hpp>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+struct AAssetManager;
+
+// Read-only bytes of a model, template or calibration file, mapped instead
+// of read into the heap: pages are faulted in only as the parser touches
+// them and are shared with the page cache (and, for APK assets, with every
+// process that maps the APK), so loading costs neither a full read nor its
+// resident copy.
+//
+// A path with the kAssetPrefix ("asset:models/hed.onnx") names an APK
+// asset. Assets stored uncompressed (aaptOptions / androidResources
+// noCompress) are mapped straight from the APK through
+// AAsset_openFileDescriptor64; compressed ones still work but are inflated
+// into the heap by the asset manager, with a warning. Any other path is a
+// regular file, mapped the same way.
+class MappedAsset {
+public:
+    static constexpr const char* kAssetPrefix = "asset:";
+
+    // Null (after logging why) when the file cannot be opened or mapped
+    static std::shared_ptr<MappedAsset> open(const std::string& path);
+
+    ~MappedAsset();
+    MappedAsset(const MappedAsset&) = delete;
+    MappedAsset& operator=(const MappedAsset&) = delete;
+
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+
+    // False for an asset the asset manager had to inflate
+    bool mapped() const { return mapping != nullptr; }
+
+private:
+    MappedAsset() = default;
+
+    const char* bytes = nullptr;
+    size_t length = 0;
+    void* mapping = nullptr;     // page-aligned start handed to munmap
+    size_t mappingBytes = 0;
+    void* asset = nullptr;       // AAsset kept open for an inflated buffer
+};
+
+bool isAssetPath(const std::string& path);
+
+// The APK's asset manager for asset: paths; set once from Java. Until then
+// asset paths fail to open.
+void setAssetManager(AAssetManager* manager);
+
+// A calibration or other FileStorage document at path (asset or file);
+// false when it cannot be opened
+bool openMappedStorage(const std::string& path, cv::FileStorage& storage);
+
+#endif // EDGE_MAPPED_ASSET_H
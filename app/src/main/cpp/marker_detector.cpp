@@ -0,0 +1,99 @@
+#include "marker_detector.h"
+#include "metrics.h"
+#include <algorithm>
+
+namespace {
+
+// A tracked marker is looked for in its bounding box grown by half its size
+// (at least kMinMargin px) on every side: room for a quick hand movement
+const int kMinMargin = 16;
+const int kMinWindow = 24;  // smaller windows cannot hold a decodable marker
+
+cv::Rect searchWindow(const MarkerRecord& marker, const cv::Size& bounds) {
+    float minX = marker.corners[0];
+    float maxX = minX;
+    float minY = marker.corners[1];
+    float maxY = minY;
+    for (int i = 1; i < 4; i++) {
+        minX = std::min(minX, marker.corners[2 * i]);
+        maxX = std::max(maxX, marker.corners[2 * i]);
+        minY = std::min(minY, marker.corners[2 * i + 1]);
+        maxY = std::max(maxY, marker.corners[2 * i + 1]);
+    }
+    const int marginX = std::max(kMinMargin, static_cast<int>((maxX - minX) / 2));
+    const int marginY = std::max(kMinMargin, static_cast<int>((maxY - minY) / 2));
+    const cv::Rect window(cv::Point(static_cast<int>(minX) - marginX, static_cast<int>(minY) - marginY),
+                          cv::Point(static_cast<int>(maxX) + marginX + 1, static_cast<int>(maxY) + marginY + 1));
+    return window & cv::Rect(cv::Point(), bounds);
+}
+
+}  // namespace
+
+void MarkerDetector::setParams(const Params& params) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (params.dictionary != current.dictionary) {
+        detector.release();  // rebuilt for the new dictionary on the next frame
+        tracked.clear();
+    }
+    current = params;
+    current.fullSearchEvery = std::max(1, params.fullSearchEvery);
+}
+
+void MarkerDetector::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    tracked.clear();
+}
+
+void MarkerDetector::search(const cv::Mat& image, const cv::Point& offset) {
+    detector->detectMarkers(image, corners, ids);
+    for (size_t i = 0; i < ids.size(); i++) {
+        const bool known = std::any_of(found.begin(), found.end(),
+                                       [&](const MarkerRecord& marker) { return marker.id == ids[i]; });
+        if (known || found.size() >= static_cast<size_t>(kMaxMarkers)) {
+            continue;  // seen through an overlapping window already
+        }
+        MarkerRecord marker;
+        marker.id = ids[i];
+        for (int j = 0; j < 4; j++) {
+            marker.corners[2 * j] = corners[i][static_cast<size_t>(j)].x + offset.x;
+            marker.corners[2 * j + 1] = corners[i][static_cast<size_t>(j)].y + offset.y;
+        }
+        found.push_back(marker);
+    }
+}
+
+int MarkerDetector::detect(const cv::Mat& luma, MarkerRecord* records, int capacity) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!detector) {
+        detector = cv::makePtr<cv::aruco::ArucoDetector>(cv::aruco::getPredefinedDictionary(
+                static_cast<cv::aruco::PredefinedDictionaryType>(current.dictionary)));
+    }
+    found.clear();
+    const bool full = tracked.empty() || luma.size() != trackedSize || ++sinceFullSearch >= current.fullSearchEvery;
+    if (full) {
+        search(luma, cv::Point());
+        sinceFullSearch = 0;
+        metrics().increment(Counter::MARKER_FULL_SEARCHES);
+    } else {
+        for (const MarkerRecord& marker : tracked) {
+            const cv::Rect window = searchWindow(marker, luma.size());
+            if (window.width >= kMinWindow && window.height >= kMinWindow) {
+                search(luma(window), window.tl());
+            }
+        }
+        if (found.size() < tracked.size()) {
+            sinceFullSearch = current.fullSearchEvery;  // one was lost: search everywhere next frame
+        }
+    }
+    tracked = found;
+    trackedSize = luma.size();
+
+    const int count = std::min(static_cast<int>(found.size()), capacity);
+    std::copy(found.begin(), found.begin() + count, records);
+    return count;
+}
+
+MarkerDetector& markerDetector() {
+    static MarkerDetector detector;
+    return detector;
+}
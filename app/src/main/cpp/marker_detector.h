@@ -0,0 +1,61 @@
+#ifndef EDGE_MARKER_DETECTOR_H
+#define EDGE_MARKER_DETECTOR_H
+
+#include <opencv2/core.hpp>
+#include <opencv2/objdetect/aruco_detector.hpp>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// One detected marker: its dictionary id and four corners, clockwise from
+// the marker's own top-left, as x, y pairs. MarkerDetector writes luma
+// pixels; the published copies (nativeGetMarkers) are in 0..1 frame units.
+struct MarkerRecord {
+    int32_t id;
+    float corners[8];
+};
+static_assert(sizeof(MarkerRecord) == 36, "MarkerRecord is a packed 36-byte record");
+
+// ArUco / AprilTag markers (cv::aruco::ArucoDetector from objdetect) on the
+// luma plane itself; ArucoDetector thresholds a single channel, so no BGR is
+// ever built for it. A full-frame search only runs every fullSearchEvery
+// frames, or once a marker was lost; in between each known marker is looked
+// for in a window around where it was, which costs a fraction of the frame.
+// Markers entering the view are therefore picked up at the next full search.
+class MarkerDetector {
+public:
+    struct Params {
+        int dictionary = cv::aruco::DICT_4X4_50;  // cv::aruco::PredefinedDictionaryType
+        int fullSearchEvery = 10;                 // frames between full-frame searches
+    };
+
+    static const int kMaxMarkers = 64;
+
+    void setParams(const Params& params);
+
+    // Markers of luma (CV_8UC1) into records (room for capacity); returns
+    // how many were written
+    int detect(const cv::Mat& luma, MarkerRecord* records, int capacity);
+
+    // Forgets the tracked markers; the next frame searches the whole frame
+    void reset();
+
+private:
+    void search(const cv::Mat& image, const cv::Point& offset);
+
+    std::mutex mutex;
+    Params current;
+    cv::Ptr<cv::aruco::ArucoDetector> detector;
+    std::vector<MarkerRecord> tracked;
+    std::vector<MarkerRecord> found;
+    cv::Size trackedSize;
+    int sinceFullSearch = 0;
+    // Scratch reused across frames
+    std::vector<std::vector<cv::Point2f>> corners;
+    std::vector<int> ids;
+};
+
+// Detector used by the MARKERS render mode
+MarkerDetector& markerDetector();
+
+#endif // EDGE_MARKER_DETECTOR_H
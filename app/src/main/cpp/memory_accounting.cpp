@@ -0,0 +1,148 @@
+#include "memory_accounting.h"
+#include "frame_arena.h"
+#include "memory_budget.h"
+#include <opencv2/core.hpp>
+#include <atomic>
+
+namespace {
+
+const int kAccountSlots = static_cast<int>(Stage::COUNT) + 1;
+
+struct UsageCounters {
+    std::atomic<int64_t> liveBytes{0};
+    std::atomic<int64_t> peakBytes{0};
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> allocatedBytes{0};
+
+    void allocated(int64_t bytes) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        allocatedBytes.fetch_add(static_cast<uint64_t>(bytes), std::memory_order_relaxed);
+        raisePeak(liveBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+    }
+
+    void released(int64_t bytes) { liveBytes.fetch_sub(bytes, std::memory_order_relaxed); }
+
+    void raisePeak(int64_t live) {
+        int64_t peak = peakBytes.load(std::memory_order_relaxed);
+        while (live > peak && !peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+        }
+    }
+
+    void resetPeak() { peakBytes.store(liveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed); }
+
+    MemoryUsage read() const {
+        MemoryUsage usage;
+        usage.liveBytes = liveBytes.load(std::memory_order_relaxed);
+        usage.peakBytes = peakBytes.load(std::memory_order_relaxed);
+        usage.allocations = allocations.load(std::memory_order_relaxed);
+        usage.allocatedBytes = allocatedBytes.load(std::memory_order_relaxed);
+        return usage;
+    }
+};
+
+UsageCounters matUsage;
+UsageCounters stageUsage[kAccountSlots];
+UsageCounters glUsage;
+std::atomic<bool> enabled{false};
+
+// OpenCV's StdMatAllocator plus bookkeeping; the charged stage rides along in
+// UMatData::allocatorFlags_, which only the allocator that made it reads
+class AccountingMatAllocator : public cv::MatAllocator {
+public:
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data0, size_t* step,
+                           cv::AccessFlag, cv::UMatUsageFlags) const override {
+        size_t total = CV_ELEM_SIZE(type);
+        for (int i = dims - 1; i >= 0; i--) {
+            if (step) {
+                if (data0 && step[i] != cv::Mat::AUTO_STEP) {
+                    CV_Assert(total <= step[i]);
+                    total = step[i];
+                } else {
+                    step[i] = total;
+                }
+            }
+            total *= static_cast<size_t>(sizes[i]);
+        }
+        uchar* data = data0 ? static_cast<uchar*>(data0) : static_cast<uchar*>(cv::fastMalloc(total));
+        cv::UMatData* u = new cv::UMatData(this);
+        u->data = u->origdata = data;
+        u->size = total;
+        if (data0) {
+            u->flags |= cv::UMatData::USER_ALLOCATED;
+        } else {
+            const int slot = static_cast<int>(threadActiveStage());
+            u->allocatorFlags_ = slot;
+            matUsage.allocated(static_cast<int64_t>(total));
+            stageUsage[slot].allocated(static_cast<int64_t>(total));
+        }
+        return u;
+    }
+
+    bool allocate(cv::UMatData* u, cv::AccessFlag, cv::UMatUsageFlags) const override {
+        return u != nullptr;
+    }
+
+    void deallocate(cv::UMatData* u) const override {
+        if (!u) {
+            return;
+        }
+        CV_Assert(u->urefcount == 0);
+        CV_Assert(u->refcount == 0);
+        if (!(u->flags & cv::UMatData::USER_ALLOCATED)) {
+            const int64_t bytes = static_cast<int64_t>(u->size);
+            matUsage.released(bytes);
+            stageUsage[u->allocatorFlags_].released(bytes);
+            cv::fastFree(u->origdata);
+            u->origdata = nullptr;
+        }
+        delete u;
+    }
+};
+
+AccountingMatAllocator& accountingAllocator() {
+    static AccountingMatAllocator allocator;  // never destroyed before its buffers
+    return allocator;
+}
+
+} // namespace
+
+void setMemoryAccounting(bool on) {
+    enabled.store(on, std::memory_order_relaxed);
+    refreshDefaultMatAllocator();
+}
+
+cv::MatAllocator* heapMatAllocator() {
+    return memoryAccountingEnabled() ? static_cast<cv::MatAllocator*>(&accountingAllocator())
+                                     : cv::Mat::getStdAllocator();
+}
+
+bool memoryAccountingEnabled() {
+    return enabled.load(std::memory_order_relaxed);
+}
+
+void accountGlMemory(int64_t bytes) {
+    if (bytes > 0) {
+        glUsage.allocated(bytes);
+    } else if (bytes < 0) {
+        glUsage.released(-bytes);
+    }
+    memoryBudget().charge(MemoryClient::TEXTURES, bytes);
+}
+
+MemorySnapshot memorySnapshot() {
+    MemorySnapshot snapshot;
+    snapshot.mats = matUsage.read();
+    for (int i = 0; i < kAccountSlots; i++) {
+        snapshot.stages[i] = stageUsage[i].read();
+    }
+    snapshot.gl = glUsage.read();
+    return snapshot;
+}
+
+void resetMemoryPeaks() {
+    matUsage.resetPeak();
+    for (UsageCounters& usage : stageUsage) {
+        usage.resetPeak();
+    }
+    glUsage.resetPeak();
+}
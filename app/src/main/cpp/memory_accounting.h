@@ -0,0 +1,49 @@
+#ifndef EDGE_MEMORY_ACCOUNTING_H
+#define EDGE_MEMORY_ACCOUNTING_H
+
+#include "metrics.h"
+#include <opencv2/core.hpp>
+#include <cstdint>
+
+// Live bytes, high-water marks and allocation counts of native memory. While
+// enabled, every cv::Mat buffer comes from an accounting cv::MatAllocator
+// that charges it to the stage whose ScopedStageTimer was innermost on the
+// allocating thread (threadActiveStage, Stage::COUNT outside any) until it is
+// freed, wherever that happens. GL texture and buffer storage is reported by
+// the renderer through accountGlMemory, separately, as driver memory the
+// process is charged for but never sees as heap. Blocks of a frame arena
+// (frame_arena.h) are not counted, only its chunks (frameArenaStats).
+struct MemoryUsage {
+    int64_t liveBytes = 0;
+    int64_t peakBytes = 0;        // since start or the last resetMemoryPeaks
+    uint64_t allocations = 0;     // cumulative, for rates
+    uint64_t allocatedBytes = 0;
+};
+
+struct MemorySnapshot {
+    MemoryUsage mats;                                     // all cv::Mat buffers
+    MemoryUsage stages[static_cast<int>(Stage::COUNT) + 1];  // by allocating stage; last = none
+    MemoryUsage gl;                                       // textures, render targets, PBOs
+};
+
+// Routes new cv::Mat allocations through the accounting allocator, or back to
+// OpenCV's own. Buffers allocated before enabling are never counted; buffers
+// allocated while enabled are uncounted when freed, even after disabling.
+void setMemoryAccounting(bool enabled);
+bool memoryAccountingEnabled();
+
+// Allocator for cv::Mat buffers that outlive a frame (the frame pool's,
+// persistentMat()): the accounting allocator while enabled, OpenCV's own
+// otherwise. The default allocator is this or a frame arena's (frame_arena.h).
+cv::MatAllocator* heapMatAllocator();
+
+// bytes > 0 when GL storage is (re)allocated, < 0 when it is released; also
+// charged to the memory budget (memory_budget.h, MemoryClient::TEXTURES)
+void accountGlMemory(int64_t bytes);
+
+MemorySnapshot memorySnapshot();
+
+// Peaks restart from the current live bytes
+void resetMemoryPeaks();
+
+#endif // EDGE_MEMORY_ACCOUNTING_H
@@ -0,0 +1,63 @@
+#include "memory_budget.h"
+
+#define LOG_TAG "MemoryBudget"
+#include "logging.h"
+
+void MemoryBudget::setBudget(int64_t bytes) {
+    limit.store(bytes > 0 ? bytes : 0, std::memory_order_relaxed);
+    LOGI("🔄 Memory budget: %lld bytes (%lld in use)", static_cast<long long>(bytes > 0 ? bytes : 0),
+         static_cast<long long>(used()));
+}
+
+bool MemoryBudget::reserve(MemoryClient client, int64_t bytes) {
+    const int64_t budget = limit.load(std::memory_order_relaxed);
+    int64_t current = total.load(std::memory_order_relaxed);
+    do {
+        if (budget > 0 && current + bytes > budget) {
+            refuse();
+            return false;
+        }
+    } while (!total.compare_exchange_weak(current, current + bytes, std::memory_order_relaxed));
+    clients[static_cast<int>(client)].fetch_add(bytes, std::memory_order_relaxed);
+    notePeak(current + bytes);
+    return true;
+}
+
+void MemoryBudget::charge(MemoryClient client, int64_t bytes) {
+    if (bytes < 0) {
+        release(client, -bytes);
+        return;
+    }
+    const int64_t now = total.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    clients[static_cast<int>(client)].fetch_add(bytes, std::memory_order_relaxed);
+    notePeak(now);
+    const int64_t budget = limit.load(std::memory_order_relaxed);
+    if (budget > 0 && now > budget) {
+        refuse();
+    }
+}
+
+void MemoryBudget::release(MemoryClient client, int64_t bytes) {
+    total.fetch_sub(bytes, std::memory_order_relaxed);
+    clients[static_cast<int>(client)].fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+int64_t MemoryBudget::used(MemoryClient client) const {
+    return clients[static_cast<int>(client)].load(std::memory_order_relaxed);
+}
+
+void MemoryBudget::refuse() {
+    refusals.fetch_add(1, std::memory_order_relaxed);
+    pressure.store(true, std::memory_order_relaxed);
+}
+
+void MemoryBudget::notePeak(int64_t value) {
+    int64_t previous = high.load(std::memory_order_relaxed);
+    while (value > previous && !high.compare_exchange_weak(previous, value, std::memory_order_relaxed)) {
+    }
+}
+
+MemoryBudget& memoryBudget() {
+    static MemoryBudget budget;
+    return budget;
+}
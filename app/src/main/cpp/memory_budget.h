@@ -0,0 +1,61 @@
+#ifndef EDGE_MEMORY_BUDGET_H
+#define EDGE_MEMORY_BUDGET_H
+
+#include <atomic>
+#include <cstdint>
+
+// Hard budget over the native memory the pipeline keeps between frames, for
+// devices where the low memory killer takes the process long before an
+// allocation fails. Consumers go through one ledger:
+//   reserve  memory they can do without (a pooled buffer, a DNN model):
+//            refused when it would exceed the budget, and the consumer
+//            manages without it
+//   charge   memory the current frame or mode cannot do without (GL storage
+//            of the active mode): always recorded, over the budget it counts
+//            as a refusal
+// Every refusal raises the pressure the pipeline polls at its frame boundary
+// (takePressure) to degrade one step: fewer history frames, no resident
+// mode textures, a lower processing scale. Budget 0 (the default) records
+// usage and refuses nothing.
+enum class MemoryClient : int {
+    FRAME_POOL = 0,  // pooled frame buffers, including those the history ring keeps
+    PYRAMIDS,        // pooled pyramid level buffers (pyramid_cache.h)
+    TEXTURES,        // GL textures, render targets and PBOs (accountGlMemory)
+    DNN,             // edge model weights and buffers (dnn_edges.h)
+    COUNT
+};
+
+class MemoryBudget {
+public:
+    // bytes <= 0: unlimited
+    void setBudget(int64_t bytes);
+    int64_t budget() const { return limit.load(std::memory_order_relaxed); }
+
+    // False, and nothing reserved, when bytes do not fit the budget
+    bool reserve(MemoryClient client, int64_t bytes);
+    void charge(MemoryClient client, int64_t bytes);
+    void release(MemoryClient client, int64_t bytes);
+
+    int64_t used() const { return total.load(std::memory_order_relaxed); }
+    int64_t used(MemoryClient client) const;
+    int64_t peak() const { return high.load(std::memory_order_relaxed); }
+    uint64_t refusalCount() const { return refusals.load(std::memory_order_relaxed); }
+
+    // True once after any refusal since the previous call
+    bool takePressure() { return pressure.exchange(false, std::memory_order_relaxed); }
+
+private:
+    void refuse();
+    void notePeak(int64_t value);
+
+    std::atomic<int64_t> limit{0};
+    std::atomic<int64_t> total{0};
+    std::atomic<int64_t> high{0};
+    std::atomic<int64_t> clients[static_cast<int>(MemoryClient::COUNT)] = {};
+    std::atomic<uint64_t> refusals{0};
+    std::atomic<bool> pressure{false};
+};
+
+MemoryBudget& memoryBudget();
+
+#endif // EDGE_MEMORY_BUDGET_H
@@ -0,0 +1,158 @@
+#include "metrics.h"
+#include <cmath>
+
+static const double kFirstBucketMicros = 10.0;
+static const double kBucketGrowth = 1.25;
+
+const char* stageName(Stage stage) {
+    switch (stage) {
+        case Stage::INGEST_COPY: return "ingest_copy";
+        case Stage::YUV_TO_BGR: return "yuv_to_bgr";
+        case Stage::ROTATE: return "rotate";
+        case Stage::GRAYSCALE: return "grayscale";
+        case Stage::CANNY: return "canny";
+        case Stage::PUBLISH: return "publish";
+        case Stage::FRAME_TOTAL: return "frame_total";
+        case Stage::RENDER_FETCH: return "render_fetch";
+        case Stage::RENDER_CONVERT: return "render_convert";
+        case Stage::RENDER_RESIZE: return "render_resize";
+        case Stage::RENDER_UPLOAD: return "render_upload";
+        case Stage::RENDER_DRAW: return "render_draw";
+        case Stage::RENDER_TOTAL: return "render_total";
+        case Stage::DOWNSCALE: return "downscale";
+        case Stage::FEATURES: return "features";
+        case Stage::TRACKING: return "tracking";
+        case Stage::CONTOURS: return "contours";
+        case Stage::HOUGH: return "hough";
+        case Stage::DNN_INFERENCE: return "dnn_inference";
+        case Stage::MOTION: return "motion";
+        case Stage::LUMA_STATS: return "luma_stats";
+        case Stage::DOCUMENT: return "document";
+        case Stage::EDGE_MORPHOLOGY: return "edge_morphology";
+        case Stage::CAPTURE_TO_PUBLISH: return "capture_to_publish";
+        case Stage::CAPTURE_TO_DISPLAY: return "capture_to_display";
+        case Stage::GPU_UPLOAD: return "gpu_upload";
+        case Stage::GPU_DRAW: return "gpu_draw";
+        case Stage::CHAMFER: return "chamfer";
+        case Stage::SEGMENTS: return "segments";
+        case Stage::MARKERS: return "markers";
+        case Stage::CODE_SCAN: return "code_scan";
+        case Stage::STABILIZE: return "stabilize";
+        case Stage::UNDISTORT: return "undistort";
+        case Stage::DENOISE: return "denoise";
+        case Stage::CLAHE: return "clahe";
+        case Stage::EDGE_COMPONENTS: return "edge_components";
+        case Stage::STEREO_DEPTH: return "stereo_depth";
+        case Stage::GL_RESUME: return "gl_resume";
+        case Stage::FACE_DETECT: return "face_detect";
+        case Stage::FACE_TRACK: return "face_track";
+        case Stage::MOSAIC: return "mosaic";
+        case Stage::OBJECT_TRACK: return "object_track";
+        case Stage::PEOPLE: return "people";
+        case Stage::TEXT_REGIONS: return "text_regions";
+        case Stage::ODOMETRY: return "odometry";
+        case Stage::MOTION_ESTIMATE: return "motion_estimate";
+        default: return "unknown";
+    }
+}
+
+const char* counterName(Counter counter) {
+    switch (counter) {
+        case Counter::FRAMES_PROCESSED: return "frames_processed";
+        case Counter::FRAMES_DROPPED: return "frames_dropped";
+        case Counter::FRAMES_RENDERED: return "frames_rendered";
+        case Counter::FALLBACK_FRAMES: return "fallback_frames";
+        case Counter::FRAMES_REUSED: return "frames_reused";
+        case Counter::EDGE_BLOCKS_REUSED: return "edge_blocks_reused";
+        case Counter::EDGE_BLOCKS_RECOMPUTED: return "edge_blocks_recomputed";
+        case Counter::TRACKING_RESEEDS: return "tracking_reseeds";
+        case Counter::HOUGH_FRAMES_SKIPPED: return "hough_frames_skipped";
+        case Counter::FRAMES_STALE: return "frames_stale";
+        case Counter::FRAMES_GOVERNOR_SKIPPED: return "frames_governor_skipped";
+        case Counter::FRAMES_ZERO_COPY: return "frames_zero_copy";
+        case Counter::FRAMES_READ_BACK: return "frames_read_back";
+        case Counter::READBACKS_DROPPED: return "readbacks_dropped";
+        case Counter::SEGMENT_RUNS_REUSED: return "segment_runs_reused";
+        case Counter::MARKER_FULL_SEARCHES: return "marker_full_searches";
+        case Counter::CODE_SCANS_SKIPPED: return "code_scans_skipped";
+        case Counter::CODE_SCANS_PREEMPTED: return "code_scans_preempted";
+        case Counter::PIPELINE_STALLS: return "pipeline_stalls";
+        case Counter::PIPELINE_RECOVERIES: return "pipeline_recoveries";
+        case Counter::FRAMES_UNSETTLED_SKIPPED: return "frames_unsettled_skipped";
+        case Counter::STAGES_DEADLINE_ABORTED: return "stages_deadline_aborted";
+        case Counter::PARTIAL_UPLOADS: return "partial_uploads";
+        case Counter::FRAMES_MOTION_COMPENSATED: return "frames_motion_compensated";
+        default: return "unknown";
+    }
+}
+
+int LatencyHistogram::bucketFor(int64_t micros) {
+    if (micros <= kFirstBucketMicros) {
+        return 0;
+    }
+    int bucket = static_cast<int>(std::ceil(std::log(micros / kFirstBucketMicros) / std::log(kBucketGrowth)));
+    return bucket > kBucketCount ? kBucketCount : bucket;
+}
+
+double LatencyHistogram::bucketUpperMicros(int bucket) {
+    return kFirstBucketMicros * std::pow(kBucketGrowth, bucket);
+}
+
+void LatencyHistogram::record(int64_t micros) {
+    buckets[bucketFor(micros)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::reset() {
+    for (auto& bucket : buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+uint64_t LatencyHistogram::count() const {
+    uint64_t total = 0;
+    for (const auto& bucket : buckets) {
+        total += bucket.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+double LatencyHistogram::percentileMicros(double quantile) const {
+    uint64_t total = count();
+    if (total == 0) {
+        return 0.0;
+    }
+
+    uint64_t rank = static_cast<uint64_t>(std::ceil(quantile * total));
+    uint64_t seen = 0;
+    for (int i = 0; i <= kBucketCount; i++) {
+        seen += buckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            return bucketUpperMicros(i);
+        }
+    }
+    return bucketUpperMicros(kBucketCount);
+}
+
+void MetricsRegistry::reset() {
+    for (auto& histogram : histograms) {
+        histogram.reset();
+    }
+    for (auto& counter : counters) {
+        counter.store(0, std::memory_order_relaxed);
+    }
+}
+
+MetricsRegistry& metrics() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+FrameStageTimes& threadFrameStages() {
+    static thread_local FrameStageTimes stages;
+    return stages;
+}
+
+Stage& threadActiveStage() {
+    static thread_local Stage active = Stage::COUNT;
+    return active;
+}
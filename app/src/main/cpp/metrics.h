@@ -0,0 +1,211 @@
+#ifndef EDGE_METRICS_H
+#define EDGE_METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include "tracing.h"
+
+// Named pipeline stages (processing steps follow the STEP 1-4 split in
+// native-lib.cpp, render steps follow renderGL)
+enum class Stage : int {
+    INGEST_COPY = 0,   // JNI/plane data copied into a pipeline-owned buffer
+    YUV_TO_BGR,        // STEP 2
+    ROTATE,            // unused since rotation moved to the renderer; kept for index stability
+    GRAYSCALE,         // STEP 3B
+    CANNY,             // STEP 3C
+    PUBLISH,           // STEP 3/4
+    FRAME_TOTAL,       // whole processFrameInternal / processYuvPlanes call
+    RENDER_FETCH,      // getLatestFrameForRender
+    RENDER_CONVERT,    // RGBA conversion
+    RENDER_RESIZE,     // unused since textures follow the frame size; kept for index stability
+    RENDER_UPLOAD,     // glTexImage2D / glTexSubImage2D
+    RENDER_DRAW,
+    RENDER_TOTAL,
+    DOWNSCALE,         // luma resized to the processing resolution (and to the scaled outputs)
+    FEATURES,          // grid-bucketed FAST keypoints (FEATURES mode)
+    TRACKING,          // pyramid + Lucas-Kanade flow (TRACKING mode)
+    CONTOURS,          // findContours + approxPolyDP on the edge map (CONTOURS mode)
+    HOUGH,             // HoughLinesP on the reduced edge map (LINES mode)
+    DNN_INFERENCE,     // one forward pass of the learned edge model (its own thread)
+    MOTION,            // MOG2 on the reduced luma (MOTION mode)
+    LUMA_STATS,        // one-pass histogram / moments / sharpness
+    DOCUMENT,          // quadrilateral search on the edge map (DOCUMENT mode)
+    EDGE_MORPHOLOGY,   // van Herk/Gil-Werman thickening of the displayed edge map
+    CAPTURE_TO_PUBLISH, // sensor timestamp to the frame's publish
+    CAPTURE_TO_DISPLAY, // sensor timestamp to the first draw of the frame (before the swap)
+    GPU_UPLOAD,        // GPU time of a rendered frame's texture uploads (gpu_timer.h)
+    GPU_DRAW,          // GPU time of its draw calls
+    CHAMFER,           // edge distance transform + template search (CHAMFER_MATCH mode)
+    SEGMENTS,          // one LSD run on the reduced luma (SEGMENTS mode, its own thread)
+    MARKERS,           // ArUco search, windowed or full-frame (MARKERS mode)
+    CODE_SCAN,         // QR detect + decode on the scanner thread (CODES mode)
+    STABILIZE,         // point tracking and similarity fit (STABILIZE mode)
+    UNDISTORT,         // cv::remap of the processed luma with precomputed maps (CPU undistortion)
+    DENOISE,           // temporal IIR blend of the processed luma with the previous filtered frame
+    CLAHE,             // tiled contrast-limited equalization of the processed luma
+    EDGE_COMPONENTS,   // connected-component labeling and size filtering of the edge map
+    STEREO_DEPTH,      // reduce, rectify and StereoBM of a stereo pair (DEPTH mode)
+    GL_RESUME,         // initGL in a new context to its first pipeline frame drawn
+    FACE_DETECT,       // YuNet on the detector thread (FACES mode)
+    FACE_TRACK,        // reduction and patch matching of the faces on the processing thread
+    MOSAIC,            // ORB registration and new-tile writes of the mosaic (MOSAIC mode)
+    OBJECT_TRACK,      // reduction and video-module tracker update of the selected object (TRACK_OBJECT)
+    PEOPLE,            // HOG people search across scales, on the frames it runs (PEOPLE mode)
+    TEXT_REGIONS,      // edge gate, MSER and line chaining, on the frames it runs (TEXT_REGIONS mode)
+    ODOMETRY,          // ORB, windowed matching and the throttled pose estimate (ODOMETRY mode)
+    MOTION_ESTIMATE,   // half-rate processing: downscale and phase correlation of a frame (motion_compensation.h)
+    COUNT
+};
+
+enum class Counter : int {
+    FRAMES_PROCESSED = 0,
+    FRAMES_DROPPED,
+    FRAMES_RENDERED,
+    FALLBACK_FRAMES,
+    FRAMES_REUSED,     // renderGL redraws whose frame was already uploaded
+    EDGE_BLOCKS_REUSED,      // 32x32 blocks whose cached edges were kept (incremental_edges.h)
+    EDGE_BLOCKS_RECOMPUTED,  // blocks that went through Canny again
+    TRACKING_RESEEDS,        // times the tracked points were detected afresh
+    HOUGH_FRAMES_SKIPPED,    // LINES frames that reused the last segments (stable scene)
+    FRAMES_STALE,            // dropped before processing: older than the latency budget
+    FRAMES_GOVERNOR_SKIPPED, // skipped by the quality governor's frame-skip levels
+    FRAMES_ZERO_COPY,        // draws sampling a CPU-written AHardwareBuffer (hardware_frames.h), no upload
+    FRAMES_READ_BACK,        // renderer edge maps handed to CPU consumers (gpu_readback.h)
+    READBACKS_DROPPED,       // reads still in flight when their slot was needed again
+    SEGMENT_RUNS_REUSED,     // due LSD runs skipped because the scene was static
+    MARKER_FULL_SEARCHES,    // MARKERS frames searched whole rather than around known markers
+    CODE_SCANS_SKIPPED,      // due code scans not started: no region had the edge density of a code
+    CODE_SCANS_PREEMPTED,    // code scans abandoned between decodes, superseded or too old
+    PIPELINE_STALLS,         // hung or failing processing the stall watchdog stepped down for
+    PIPELINE_RECOVERIES,     // watchdog steps back up after a healthy stretch
+    FRAMES_UNSETTLED_SKIPPED, // dropped while autofocus or exposure was still adjusting (capture_metadata.h)
+    STAGES_DEADLINE_ABORTED, // stages that stopped early at their frame's deadline (frame_deadline.h)
+    PARTIAL_UPLOADS,         // edge frames uploaded as their changed rects only (incremental_edges.h)
+    FRAMES_MOTION_COMPENSATED, // skipped by half-rate processing, the last edges moved instead (motion_compensation.h)
+    COUNT
+};
+
+const char* stageName(Stage stage);
+const char* counterName(Counter counter);
+
+// Fixed-bucket latency histogram. Bucket upper bounds grow geometrically from
+// 10us by 25% per bucket (~2.5% worst-case quantile error up to ~350ms), and
+// recording is a single relaxed atomic increment, safe from any thread.
+class LatencyHistogram {
+public:
+    static const int kBucketCount = 48;
+
+    void record(int64_t micros);
+    void reset();
+
+    uint64_t count() const;
+    // Upper bound (in microseconds) of the bucket holding the given quantile
+    double percentileMicros(double quantile) const;
+
+    // Samples in one bucket (kBucketCount = overflow), and its upper bound
+    uint64_t bucketCount(int bucket) const { return buckets[bucket].load(std::memory_order_relaxed); }
+    static double bucketUpperMicros(int bucket);
+
+private:
+    static int bucketFor(int64_t micros);
+
+    std::atomic<uint32_t> buckets[kBucketCount + 1] = {}; // last bucket = overflow
+};
+
+// Process-wide registry of stage histograms and event counters
+class MetricsRegistry {
+public:
+    void recordStage(Stage stage, int64_t micros) { histograms[static_cast<int>(stage)].record(micros); }
+    void increment(Counter counter, uint64_t amount = 1) {
+        counters[static_cast<int>(counter)].fetch_add(amount, std::memory_order_relaxed);
+    }
+
+    const LatencyHistogram& histogram(Stage stage) const { return histograms[static_cast<int>(stage)]; }
+    uint64_t counter(Counter counter) const { return counters[static_cast<int>(counter)].load(std::memory_order_relaxed); }
+
+    void reset();
+
+private:
+    LatencyHistogram histograms[static_cast<int>(Stage::COUNT)];
+    std::atomic<uint64_t> counters[static_cast<int>(Counter::COUNT)] = {};
+};
+
+MetricsRegistry& metrics();
+
+// Stage durations one thread recorded for the frame it is working on, beside
+// the histograms, for per-frame telemetry (frame_telemetry.h). Plain adds:
+// each thread only touches its own.
+struct FrameStageTimes {
+    uint32_t micros[static_cast<int>(Stage::COUNT)] = {};
+
+    void clear() { *this = FrameStageTimes(); }
+    void add(Stage stage, int64_t elapsed) { micros[static_cast<int>(stage)] += static_cast<uint32_t>(elapsed); }
+    void add(const FrameStageTimes& other) {
+        for (int i = 0; i < static_cast<int>(Stage::COUNT); i++) {
+            micros[i] += other.micros[i];
+        }
+    }
+};
+
+FrameStageTimes& threadFrameStages();
+
+// Innermost ScopedStageTimer open on this thread, Stage::COUNT outside any
+// (allocations are charged to it, memory_accounting.h)
+Stage& threadActiveStage();
+
+inline int64_t monotonicMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// CLOCK_BOOTTIME, the clock of Camera2/NDK sensor timestamps (SENSOR_INFO_
+// TIMESTAMP_SOURCE_REALTIME, i.e. SystemClock.elapsedRealtimeNanos())
+inline int64_t bootTimeNanos() {
+    timespec now;
+    clock_gettime(CLOCK_BOOTTIME, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+// CLOCK_MONOTONIC, the clock of AChoreographer frame times
+inline int64_t monotonicNanos() {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+// Records the lifetime of the enclosing scope into a stage histogram (and the
+// thread's FrameStageTimes), and as an ATrace section named after the stage
+// while a trace is being captured (tracing.h). The stage is the thread's
+// active one meanwhile.
+class ScopedStageTimer {
+public:
+    explicit ScopedStageTimer(Stage stage)
+            : stage(stage), outer(threadActiveStage()), traced(traceEnabled()), start(monotonicMicros()) {
+        threadActiveStage() = stage;
+        if (traced) {
+            traceBegin(stageName(stage));
+        }
+    }
+    ~ScopedStageTimer() {
+        const int64_t elapsed = monotonicMicros() - start;
+        if (traced) {
+            traceEnd();
+        }
+        threadActiveStage() = outer;
+        metrics().recordStage(stage, elapsed);
+        threadFrameStages().add(stage, elapsed);
+    }
+
+    ScopedStageTimer(const ScopedStageTimer&) = delete;
+    ScopedStageTimer& operator=(const ScopedStageTimer&) = delete;
+
+private:
+    Stage stage;
+    Stage outer;
+    bool traced;
+    int64_t start;
+};
+
+#endif // EDGE_METRICS_H
@@ -0,0 +1,351 @@
+#include "metrics_server.h"
+#include "backend_comparison.h"
+#include "control_block.h"
+#include "memory_accounting.h"
+#include "metrics.h"
+#include "quality_governor.h"
+#include "thread_policy.h"
+#include <arpa/inet.h>
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define LOG_TAG "MetricsServer"
+#include "logging.h"
+
+namespace {
+
+const int kBucketStride = 4;             // bounds 2.4x apart: 12 of them, 50 us to ~0.5 s
+const int kRequestBytes = 2048;          // request line and headers; a body is never read
+const int kClientTimeoutMillis = 1000;   // a stalled client is dropped, not waited for
+const int kSeqlockRetries = 8;
+const int kListenBacklog = 4;
+
+// One consistent write of the stats block
+struct StatsValues {
+    int32_t renderMode = 0;
+    int64_t sequence = 0;
+    int32_t frameMicros = 0;
+    int32_t captureToPublishMicros = 0;
+    int32_t cannyLow = 0;
+    int32_t cannyHigh = 0;
+    int32_t cannyBackend = 0;
+    int32_t width = 0;
+    int32_t height = 0;
+    int32_t lumaMedian = -1;
+};
+
+// The seqlock reader of StatsBlockWrite: retried while a frame is being
+// written, and given up on (the gauges left out) rather than waited for
+bool readStats(StatsValues& values) {
+    const StatsBlock& stats = statsBlock();
+    for (int attempt = 0; attempt < kSeqlockRetries; attempt++) {
+        const uint32_t before = stats.version.load(std::memory_order_acquire);
+        if (before & 1u) {
+            continue;
+        }
+        values.renderMode = stats.renderMode.load(std::memory_order_relaxed);
+        values.sequence = stats.sequence.load(std::memory_order_relaxed);
+        values.frameMicros = stats.frameMicros.load(std::memory_order_relaxed);
+        values.captureToPublishMicros = stats.captureToPublishMicros.load(std::memory_order_relaxed);
+        values.cannyLow = stats.cannyLow.load(std::memory_order_relaxed);
+        values.cannyHigh = stats.cannyHigh.load(std::memory_order_relaxed);
+        values.cannyBackend = stats.cannyBackend.load(std::memory_order_relaxed);
+        values.width = stats.width.load(std::memory_order_relaxed);
+        values.height = stats.height.load(std::memory_order_relaxed);
+        values.lumaMedian = stats.lumaMedian.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (stats.version.load(std::memory_order_relaxed) == before) {
+            return before != 0;  // 0: nothing published yet
+        }
+    }
+    return false;
+}
+
+void appendf(std::string& out, const char* format, ...) {
+    char line[256];
+    va_list args;
+    va_start(args, format);
+    const int length = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if (length > 0) {
+        out.append(line, static_cast<size_t>(std::min<int>(length, sizeof(line) - 1)));
+    }
+}
+
+void gauge(std::string& out, const char* name, const char* help, double value) {
+    appendf(out, "# HELP %s %s\n# TYPE %s gauge\n%s %.9g\n", name, help, name, name, value);
+}
+
+bool sendAll(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        const ssize_t written = send(fd, data, length, MSG_NOSIGNAL);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        data += written;
+        length -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+int openListener(int port) {
+    const int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        LOGE("❌ Cannot open a TCP socket: %s", strerror(errno));
+        return -1;
+    }
+    const int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);  // adb forward reaches loopback; nothing else should
+    if (bind(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(fd, kListenBacklog) != 0) {
+        LOGE("❌ Cannot listen on 127.0.0.1:%d: %s", port, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+}  // namespace
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+bool MetricsServer::start(int port) {
+    stop();
+    if (port <= 0 || port > 65535) {
+        return false;
+    }
+    const int listenFd = openListener(port);
+    if (listenFd < 0) {
+        return false;
+    }
+    wakeFd = eventfd(0, EFD_CLOEXEC);
+    if (wakeFd < 0) {
+        LOGE("❌ eventfd failed: %s", strerror(errno));
+        close(listenFd);
+        return false;
+    }
+    lastScrapeMicros = 0;
+    running.store(true, std::memory_order_release);
+    thread = std::thread(&MetricsServer::run, this, listenFd);
+    LOGI("✅ Serving metrics on 127.0.0.1:%d/metrics", port);
+    return true;
+}
+
+void MetricsServer::stop() {
+    if (wakeFd >= 0) {
+        const uint64_t one = 1;
+        ssize_t ignored = write(wakeFd, &one, sizeof(one));
+        (void) ignored;
+    }
+    if (thread.joinable()) {
+        thread.join();
+    }
+    if (wakeFd >= 0) {
+        close(wakeFd);
+        wakeFd = -1;
+    }
+    running.store(false, std::memory_order_release);
+}
+
+void MetricsServer::run(int listenFd) {
+    setThreadTier(ThreadTier::ANALYTICS);
+    pollfd fds[2] = {{listenFd, POLLIN, 0}, {wakeFd, POLLIN, 0}};
+    while (true) {
+        fds[0].revents = 0;
+        fds[1].revents = 0;
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOGE("❌ poll failed: %s", strerror(errno));
+            break;
+        }
+        if (fds[1].revents) {
+            break;  // stopped
+        }
+        if (!(fds[0].revents & POLLIN)) {
+            continue;
+        }
+        const int clientFd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (clientFd < 0) {
+            continue;
+        }
+        const timeval timeout = {kClientTimeoutMillis / 1000, (kClientTimeoutMillis % 1000) * 1000};
+        setsockopt(clientFd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(clientFd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        serve(clientFd);
+        close(clientFd);
+    }
+    close(listenFd);
+    LOGI("✅ Metrics server stopped");
+}
+
+void MetricsServer::serve(int clientFd) {
+    // Only the request line matters; read up to the end of the headers
+    char request[kRequestBytes];
+    size_t received = 0;
+    while (received < sizeof(request) - 1) {
+        const ssize_t length = recv(clientFd, request + received, sizeof(request) - 1 - received, 0);
+        if (length <= 0) {
+            if (length < 0 && errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        received += static_cast<size_t>(length);
+        request[received] = '\0';
+        if (strstr(request, "\r\n\r\n") || strstr(request, "\n\n")) {
+            break;
+        }
+    }
+    request[received] = '\0';
+
+    const bool head = strncmp(request, "HEAD ", 5) == 0;
+    const char* path = head ? request + 5 : strncmp(request, "GET ", 4) == 0 ? request + 4 : nullptr;
+    const size_t pathLength = path ? strcspn(path, " ?\r\n") : 0;
+    const bool found = path && ((pathLength == 8 && strncmp(path, "/metrics", 8) == 0) ||
+                                (pathLength == 1 && path[0] == '/'));
+
+    std::string body;
+    if (found) {
+        scrapes.fetch_add(1, std::memory_order_relaxed);
+        body = render();
+    } else {
+        body = "not found; scrape /metrics\n";
+    }
+    std::string response;
+    appendf(response, "HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n",
+            found ? "200 OK" : "404 Not Found",
+            found ? "text/plain; version=0.0.4; charset=utf-8" : "text/plain; charset=utf-8", body.size());
+    if (!head) {
+        response += body;
+    }
+    sendAll(clientFd, response.data(), response.size());
+}
+
+std::string MetricsServer::render() {
+    const MetricsRegistry& registry = metrics();
+    std::string out;
+    out.reserve(16384);
+
+    // Cumulative buckets; the overflow bucket only counts toward +Inf. Each
+    // bucket is read once, so _count always equals the +Inf bucket.
+    out += "# HELP edge_stage_latency_seconds Time spent in each pipeline stage.\n"
+           "# TYPE edge_stage_latency_seconds histogram\n";
+    for (int i = 0; i < static_cast<int>(Stage::COUNT); i++) {
+        const LatencyHistogram& histogram = registry.histogram(static_cast<Stage>(i));
+        if (histogram.count() == 0) {
+            continue;
+        }
+        const char* stage = stageName(static_cast<Stage>(i));
+        uint64_t cumulative = 0;
+        for (int bucket = 0; bucket < LatencyHistogram::kBucketCount; bucket++) {
+            cumulative += histogram.bucketCount(bucket);
+            if ((bucket + 1) % kBucketStride == 0) {
+                appendf(out, "edge_stage_latency_seconds_bucket{stage=\"%s\",le=\"%.6g\"} %" PRIu64 "\n", stage,
+                        LatencyHistogram::bucketUpperMicros(bucket) / 1e6, cumulative);
+            }
+        }
+        cumulative += histogram.bucketCount(LatencyHistogram::kBucketCount);
+        appendf(out, "edge_stage_latency_seconds_bucket{stage=\"%s\",le=\"+Inf\"} %" PRIu64 "\n", stage, cumulative);
+        appendf(out, "edge_stage_latency_seconds_count{stage=\"%s\"} %" PRIu64 "\n", stage, cumulative);
+    }
+
+    out += "# HELP edge_events_total Pipeline events since the process started.\n"
+           "# TYPE edge_events_total counter\n";
+    for (int i = 0; i < static_cast<int>(Counter::COUNT); i++) {
+        appendf(out, "edge_events_total{event=\"%s\"} %" PRIu64 "\n", counterName(static_cast<Counter>(i)),
+                registry.counter(static_cast<Counter>(i)));
+    }
+
+    // Rates over the interval since the previous scrape; the first scrape
+    // has no interval and leaves them out
+    const int64_t now = monotonicMicros();
+    const uint64_t processed = registry.counter(Counter::FRAMES_PROCESSED);
+    const uint64_t rendered = registry.counter(Counter::FRAMES_RENDERED);
+    if (lastScrapeMicros > 0 && now > lastScrapeMicros) {
+        const double seconds = (now - lastScrapeMicros) / 1e6;
+        gauge(out, "edge_processing_fps", "Frames processed per second since the previous scrape.",
+              (processed - lastProcessed) / seconds);
+        gauge(out, "edge_render_fps", "Frames rendered per second since the previous scrape.",
+              (rendered - lastRendered) / seconds);
+    }
+    lastScrapeMicros = now;
+    lastProcessed = processed;
+    lastRendered = rendered;
+
+    StatsValues stats;
+    if (readStats(stats)) {
+        gauge(out, "edge_frame_render_mode", "Render mode of the newest published frame.", stats.renderMode);
+        gauge(out, "edge_frame_sequence", "Publish sequence of the newest frame.",
+              static_cast<double>(stats.sequence));
+        gauge(out, "edge_frame_processing_seconds", "Processing time of the newest frame.",
+              stats.frameMicros / 1e6);
+        gauge(out, "edge_frame_capture_to_publish_seconds", "Capture to publish latency of the newest frame.",
+              stats.captureToPublishMicros / 1e6);
+        out += "# HELP edge_frame_canny_threshold Canny thresholds after the newest frame.\n"
+               "# TYPE edge_frame_canny_threshold gauge\n";
+        appendf(out, "edge_frame_canny_threshold{bound=\"low\"} %d\n", stats.cannyLow);
+        appendf(out, "edge_frame_canny_threshold{bound=\"high\"} %d\n", stats.cannyHigh);
+        gauge(out, "edge_frame_canny_backend", "Canny backend that ran on the newest frame.", stats.cannyBackend);
+        gauge(out, "edge_frame_width", "Camera frame width.", stats.width);
+        gauge(out, "edge_frame_height", "Camera frame height.", stats.height);
+        if (stats.lumaMedian >= 0) {
+            gauge(out, "edge_frame_luma_median", "Median luma of the newest frame.", stats.lumaMedian);
+        }
+    }
+
+    const MemorySnapshot memory = memorySnapshot();
+    out += "# HELP edge_memory_live_bytes Bytes held now.\n# TYPE edge_memory_live_bytes gauge\n";
+    appendf(out, "edge_memory_live_bytes{kind=\"mat\"} %" PRId64 "\n", memory.mats.liveBytes);
+    appendf(out, "edge_memory_live_bytes{kind=\"gl\"} %" PRId64 "\n", memory.gl.liveBytes);
+    out += "# HELP edge_memory_peak_bytes Most bytes held since start or the last peak reset.\n"
+           "# TYPE edge_memory_peak_bytes gauge\n";
+    appendf(out, "edge_memory_peak_bytes{kind=\"mat\"} %" PRId64 "\n", memory.mats.peakBytes);
+    appendf(out, "edge_memory_peak_bytes{kind=\"gl\"} %" PRId64 "\n", memory.gl.peakBytes);
+    gauge(out, "edge_memory_accounting_enabled", "1 when cv::Mat buffers are counted.",
+          memoryAccountingEnabled() ? 1.0 : 0.0);
+
+    const BackendComparison::Stats comparison = backendComparison().stats();
+    if (comparison.backendA != 0) {
+        out += "# HELP edge_backend_compare_mean_seconds Mean edge time per compared backend.\n"
+               "# TYPE edge_backend_compare_mean_seconds gauge\n";
+        for (int side = 0; side < 2; side++) {
+            appendf(out, "edge_backend_compare_mean_seconds{side=\"%c\",backend=\"%s\"} %.9g\n", side ? 'b' : 'a',
+                    BackendComparison::backendName(side ? comparison.backendB : comparison.backendA),
+                    comparison.meanMicros[side] / 1e6);
+        }
+        gauge(out, "edge_backend_compare_speedup", "Mean time of backend A over backend B.", comparison.speedup);
+        gauge(out, "edge_backend_compare_disagreement", "Share of edge pixels only one backend found.",
+              comparison.disagreement);
+    }
+
+    gauge(out, "edge_thermal_status", "PowerManager thermal status (0 none .. 6 shutdown).", deviceThermalStatus());
+    gauge(out, "edge_governor_level", "Quality governor level (0 = full quality).", qualityGovernor().levelIndex());
+    gauge(out, "edge_governor_smoothed_seconds", "Frame time the quality governor steers by.",
+          qualityGovernor().smoothedMicros() / 1e6);
+    return out;
+}
+
+MetricsServer& metricsServer() {
+    static MetricsServer server;
+    return server;
+}
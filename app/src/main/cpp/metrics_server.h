@@ -0,0 +1,54 @@
+#ifndef EDGE_METRICS_SERVER_H
+#define EDGE_METRICS_SERVER_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+// Prometheus text exposition (format 0.0.4) of the metrics registry over
+// HTTP on 127.0.0.1, for a device lab that reaches each device through
+// `adb forward tcp:<host port> tcp:<port>` and scrapes GET /metrics. One
+// thread at analytics priority serves one connection at a time and builds
+// the page per scrape from relaxed atomic loads: the stage histograms and
+// counters, the stats block (read with its seqlock, retried, never locked),
+// memory accounting and the thermal status. Nothing on the frame path waits
+// on a scrape. The page carries:
+//   edge_stage_latency_seconds   histogram per stage (every 4th bucket bound)
+//   edge_events_total            counter per metrics.h Counter
+//   edge_processing_fps, edge_render_fps   rates since the previous scrape
+//   edge_frame_*                 gauges of the newest published frame
+//   edge_memory_*_bytes          live and peak, cv::Mat and GL storage
+//   edge_backend_compare_*       while an A/B backend comparison runs
+//   edge_thermal_status, edge_governor_level
+class MetricsServer {
+public:
+    ~MetricsServer();
+
+    // Listens on 127.0.0.1:port; false when the port cannot be bound
+    bool start(int port);
+    void stop();
+    bool isRunning() const { return running.load(std::memory_order_acquire); }
+
+    uint64_t scrapeCount() const { return scrapes.load(std::memory_order_relaxed); }
+
+private:
+    std::string render();
+    void run(int listenFd);
+    void serve(int clientFd);
+
+    std::thread thread;
+    int wakeFd = -1;    // eventfd: written by stop() to end the poll
+
+    // Server thread only: the previous scrape, for the fps gauges
+    int64_t lastScrapeMicros = 0;
+    uint64_t lastProcessed = 0;
+    uint64_t lastRendered = 0;
+
+    std::atomic<bool> running{false};
+    std::atomic<uint64_t> scrapes{0};
+};
+
+MetricsServer& metricsServer();
+
+#endif // EDGE_METRICS_SERVER_H
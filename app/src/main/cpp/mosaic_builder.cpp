@@ -0,0 +1,228 @@
+#include "mosaic_builder.h"
+#include "metrics.h"
+#include <opencv2/calib3d.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+
+#define LOG_TAG "MosaicBuilder"
+#include "logging.h"
+
+namespace {
+
+const float kRatioTest = 0.75f;           // Lowe's ratio for the two nearest descriptors
+const double kRansacThreshold = 3.0;      // reduced-frame pixels
+// Frame to keyframe of a handheld sweep: no mirroring, no 2x zoom, no
+// strong tilt; anything else is a wrong registration
+const double kMinScale = 0.5;
+const double kMaxScale = 2.0;
+const double kMaxPerspective = 0.001;
+const int kSubpixelBits = 4;              // fillConvexPoly precision of the footprint
+
+std::atomic<uint64_t> nextRevision{1};
+
+cv::Matx33d translation(double x, double y) {
+    return cv::Matx33d(1.0, 0.0, x, 0.0, 1.0, y, 0.0, 0.0, 1.0);
+}
+
+std::vector<cv::Point2f> corners(const cv::Size& size) {
+    const float right = static_cast<float>(size.width - 1);
+    const float bottom = static_cast<float>(size.height - 1);
+    return {cv::Point2f(0.0f, 0.0f), cv::Point2f(right, 0.0f), cv::Point2f(right, bottom),
+            cv::Point2f(0.0f, bottom)};
+}
+
+}  // namespace
+
+MosaicBuilder::MosaicBuilder() {
+    orb = cv::ORB::create(current.maxFeatures);
+    resetLocked();
+}
+
+void MosaicBuilder::setParams(const Params& params) {
+    std::lock_guard<std::mutex> lock(mutex);
+    current = params;
+    current.tileSize = std::min(std::max(params.tileSize, 32), 512);
+    // Whole tiles, at most what a texture can hold everywhere
+    auto tiled = [this](int size) {
+        const int tiles = std::max(1, (std::min(std::max(size, current.tileSize), 4096) + current.tileSize - 1) /
+                                      current.tileSize);
+        return tiles * current.tileSize;
+    };
+    current.canvasSize = cv::Size(tiled(params.canvasSize.width), tiled(params.canvasSize.height));
+    current.frameWidth = std::min(std::max(params.frameWidth, 64), current.canvasSize.width);
+    current.maxFeatures = std::max(params.maxFeatures, 50);
+    current.minInliers = std::max(params.minInliers, 8);
+    current.keyframeOverlap = std::min(std::max(params.keyframeOverlap, 0.1f), 0.95f);
+    orb->setMaxFeatures(current.maxFeatures);
+    resetLocked();
+    LOGI("🔄 Mosaic %dx%d in %d px tiles, frames %d px wide", current.canvasSize.width, current.canvasSize.height,
+         current.tileSize, current.frameWidth);
+}
+
+void MosaicBuilder::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    resetLocked();
+}
+
+void MosaicBuilder::resetLocked() {
+    std::shared_ptr<MosaicView> empty = std::make_shared<MosaicView>();
+    empty->canvasSize = current.canvasSize;
+    empty->tileSize = current.tileSize;
+    empty->columns = current.canvasSize.width / current.tileSize;
+    empty->rows = current.canvasSize.height / current.tileSize;
+    empty->generation = ++generation;
+    const size_t count = static_cast<size_t>(empty->columns) * static_cast<size_t>(empty->rows);
+    empty->tiles.resize(count);
+    view = empty;
+    coverage.assign(count, cv::Mat());
+    full.assign(count, false);
+    keyframe = Keyframe();
+    hasKeyframe = false;
+}
+
+// Frame -> keyframe homography, chained onto the keyframe's into the canvas
+bool MosaicBuilder::registerLocked(const cv::Mat& frame, cv::Matx33d& toCanvas, bool& promote) {
+    if (descriptors.empty() || static_cast<int>(keypoints.size()) < current.minInliers) {
+        return false;
+    }
+    matcher.knnMatch(descriptors, keyframe.descriptors, matches, 2);
+    std::vector<cv::Point2f> from;
+    std::vector<cv::Point2f> to;
+    for (const std::vector<cv::DMatch>& pair : matches) {
+        if (pair.size() == 2 && pair[0].distance < kRatioTest * pair[1].distance) {
+            from.push_back(keypoints[static_cast<size_t>(pair[0].queryIdx)].pt);
+            to.push_back(keyframe.keypoints[static_cast<size_t>(pair[0].trainIdx)].pt);
+        }
+    }
+    if (static_cast<int>(from.size()) < current.minInliers) {
+        return false;
+    }
+    cv::Mat inliers;
+    const cv::Mat homography = cv::findHomography(from, to, cv::RANSAC, kRansacThreshold, inliers);
+    if (homography.empty() || cv::countNonZero(inliers) < current.minInliers) {
+        return false;
+    }
+    const cv::Matx33d toKeyframe(homography);
+    const double scale = toKeyframe(0, 0) * toKeyframe(1, 1) - toKeyframe(0, 1) * toKeyframe(1, 0);
+    if (scale < kMinScale || scale > kMaxScale || std::abs(toKeyframe(2, 0)) > kMaxPerspective ||
+        std::abs(toKeyframe(2, 1)) > kMaxPerspective) {
+        return false;
+    }
+    toCanvas = keyframe.toCanvas * toKeyframe;
+
+    // The keyframe moves on once too little of the frame still overlaps it
+    std::vector<cv::Point2f> outline;
+    cv::perspectiveTransform(corners(frame.size()), outline, toKeyframe);
+    std::vector<cv::Point2f> shared;
+    const float overlap = cv::intersectConvexConvex(outline, corners(keyframe.size), shared);
+    promote = overlap < current.keyframeOverlap * static_cast<float>(frame.size().area());
+    return true;
+}
+
+// Writes the pixels of frame no earlier frame covered, tile by tile, and
+// publishes a new view when any tile changed; returns the tiles written
+int MosaicBuilder::writeLocked(const cv::Mat& frame, const cv::Matx33d& toCanvas,
+                               const std::vector<cv::Point2f>& footprint) {
+    const int tileSize = current.tileSize;
+    const cv::Rect bounds = cv::boundingRect(footprint) & cv::Rect(cv::Point(), current.canvasSize);
+    if (bounds.empty()) {
+        return 0;  // swept off the canvas
+    }
+    std::shared_ptr<MosaicView> next;
+    int written = 0;
+    const float subpixel = static_cast<float>(1 << kSubpixelBits);
+    for (int row = bounds.y / tileSize; row <= (bounds.y + bounds.height - 1) / tileSize; row++) {
+        for (int column = bounds.x / tileSize; column <= (bounds.x + bounds.width - 1) / tileSize; column++) {
+            const size_t index = static_cast<size_t>(row * view->columns + column);
+            if (full[index]) {
+                continue;
+            }
+            const cv::Point origin(column * tileSize, row * tileSize);
+            // The footprint in tile pixels, minus what is already there
+            cv::Point points[4];
+            for (int i = 0; i < 4; i++) {
+                points[i] = cv::Point(cvRound((footprint[static_cast<size_t>(i)].x - origin.x) * subpixel),
+                                      cvRound((footprint[static_cast<size_t>(i)].y - origin.y) * subpixel));
+            }
+            footprintMask.create(tileSize, tileSize, CV_8UC1);
+            footprintMask.setTo(0);
+            cv::fillConvexPoly(footprintMask, points, 4, cv::Scalar(255), cv::LINE_8, kSubpixelBits);
+            cv::Mat& covered = coverage[index];
+            if (covered.empty()) {
+                covered = cv::Mat::zeros(tileSize, tileSize, CV_8UC1);
+            }
+            cv::subtract(footprintMask, covered, footprintMask);  // saturates: covered pixels drop out
+            if (cv::countNonZero(footprintMask) == 0) {
+                continue;
+            }
+            cv::warpPerspective(frame, warped, translation(-origin.x, -origin.y) * toCanvas,
+                                cv::Size(tileSize, tileSize), cv::INTER_LINEAR, cv::BORDER_REPLICATE);
+            // The published tile is immutable: the update goes into a copy
+            std::shared_ptr<MosaicTile> tile = std::make_shared<MosaicTile>();
+            const std::shared_ptr<const MosaicTile>& before = view->tiles[index];
+            tile->pixels = before ? before->pixels.clone() : cv::Mat::zeros(tileSize, tileSize, CV_8UC1);
+            warped.copyTo(tile->pixels, footprintMask);
+            tile->revision = nextRevision.fetch_add(1, std::memory_order_relaxed);
+            cv::bitwise_or(covered, footprintMask, covered);
+            full[index] = cv::countNonZero(covered) == tileSize * tileSize;
+            if (!next) {
+                next = std::make_shared<MosaicView>(*view);
+            }
+            next->tiles[index] = tile;
+            written++;
+        }
+    }
+    if (next) {
+        view = next;
+    }
+    return written;
+}
+
+bool MosaicBuilder::update(const cv::Mat& luma, std::shared_ptr<const MosaicView>& published,
+                           std::vector<cv::Point2f>& outline) {
+    outline.clear();
+    std::lock_guard<std::mutex> lock(mutex);
+    published = view;
+    if (luma.empty()) {
+        return false;
+    }
+    ScopedStageTimer timer(Stage::MOSAIC);
+    const int width = std::min(current.frameWidth, luma.cols);
+    const cv::Size size(width, std::max(1, luma.rows * width / luma.cols));
+    cv::resize(luma, reduced, size, 0, 0, cv::INTER_AREA);
+    orb->detectAndCompute(reduced, cv::noArray(), keypoints, descriptors);
+
+    cv::Matx33d toCanvas;
+    bool promote = true;
+    if (!hasKeyframe) {
+        // The first frame goes to the middle of the canvas
+        toCanvas = translation((current.canvasSize.width - size.width) / 2,
+                               (current.canvasSize.height - size.height) / 2);
+    } else if (!registerLocked(reduced, toCanvas, promote)) {
+        failed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    std::vector<cv::Point2f> footprint;
+    cv::perspectiveTransform(corners(size), footprint, toCanvas);
+    const int written = writeLocked(reduced, toCanvas, footprint);
+    tilesWritten.fetch_add(static_cast<uint64_t>(written), std::memory_order_relaxed);
+    if (promote && static_cast<int>(keypoints.size()) >= current.minInliers) {
+        keyframe.keypoints = keypoints;
+        descriptors.copyTo(keyframe.descriptors);
+        keyframe.toCanvas = toCanvas;
+        keyframe.size = size;
+        hasKeyframe = true;
+        keyframes.fetch_add(1, std::memory_order_relaxed);
+    }
+    registered.fetch_add(1, std::memory_order_relaxed);
+    outline = footprint;
+    outline.push_back(footprint[0]);
+    published = view;
+    return true;
+}
+
+MosaicBuilder& mosaicBuilder() {
+    static MosaicBuilder builder;
+    return builder;
+}
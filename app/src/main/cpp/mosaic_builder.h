@@ -0,0 +1,110 @@
+#ifndef EDGE_MOSAIC_BUILDER_H
+#define EDGE_MOSAIC_BUILDER_H
+
+#include <opencv2/core.hpp>
+#include <opencv2/features2d.hpp>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// One tile of the mosaic as it was when published; immutable, so views of
+// several frames share the tiles neither of them changed
+struct MosaicTile {
+    cv::Mat pixels;         // CV_8UC1, tileSize x tileSize
+    uint64_t revision = 0;  // unique per written tile content, process-wide
+};
+
+// The mosaic at one frame: a fixed grid of tiles over the canvas. Copying a
+// view copies tile references, never pixels.
+struct MosaicView {
+    cv::Size canvasSize;
+    int tileSize = 0;
+    int columns = 0;
+    int rows = 0;
+    uint64_t generation = 0;  // bumped by every reset: a new, empty canvas
+    std::vector<std::shared_ptr<const MosaicTile>> tiles;  // row-major; null = nothing covered yet
+};
+
+// Incremental panorama of the luma at preview resolution. Each frame is
+// reduced to frameWidth and registered by ORB features against the current
+// keyframe; the keyframe's own homography into the canvas is cached, so the
+// frame's is one product (the homography chain), and the keyframe only
+// moves on when the overlap with it runs low. Only pixels no earlier frame
+// covered are written, tile by tile, and only for the tiles the frame's
+// footprint touches that are not yet full: the work per frame depends on
+// the frame, not on how large the mosaic has grown, unlike the stitching
+// module's batch composition. A changed tile is copied once into a new
+// MosaicTile, so the renderer re-uploads exactly the tiles that changed.
+class MosaicBuilder {
+public:
+    struct Params {
+        cv::Size canvasSize{2048, 1024};  // mosaic pixels, a multiple of tileSize
+        int tileSize = 128;
+        int frameWidth = 320;     // reduced luma width registered and written
+        int maxFeatures = 500;    // ORB keypoints per frame
+        int minInliers = 25;      // RANSAC inliers a registration needs
+        float keyframeOverlap = 0.6f;  // frame area still over the keyframe before it moves on
+    };
+
+    MosaicBuilder();
+
+    void setParams(const Params& params);
+
+    // Processing thread, once per frame of the mode: registers luma (CV_8UC1)
+    // and writes its newly covered pixels. view receives the mosaic after the
+    // frame, outline the frame's footprint as a closed strip (5 CV_32FC2
+    // points in canvas pixels; empty when the frame could not be registered).
+    // False when registration failed and the mosaic is unchanged.
+    bool update(const cv::Mat& luma, std::shared_ptr<const MosaicView>& view, std::vector<cv::Point2f>& outline);
+
+    // Starts an empty canvas with the next frame at its centre
+    void reset();
+
+    uint64_t registeredCount() const { return registered.load(std::memory_order_relaxed); }
+    uint64_t failedCount() const { return failed.load(std::memory_order_relaxed); }
+    uint64_t tilesWrittenCount() const { return tilesWritten.load(std::memory_order_relaxed); }
+    uint64_t keyframeCount() const { return keyframes.load(std::memory_order_relaxed); }
+
+private:
+    struct Keyframe {
+        std::vector<cv::KeyPoint> keypoints;
+        cv::Mat descriptors;
+        cv::Matx33d toCanvas;   // keyframe pixels -> canvas pixels
+        cv::Size size;
+    };
+
+    void resetLocked();
+    bool registerLocked(const cv::Mat& frame, cv::Matx33d& toCanvas, bool& promote);
+    int writeLocked(const cv::Mat& frame, const cv::Matx33d& toCanvas, const std::vector<cv::Point2f>& footprint);
+
+    std::mutex mutex;
+    Params current;
+    cv::Ptr<cv::ORB> orb;
+    cv::BFMatcher matcher{cv::NORM_HAMMING};
+    std::shared_ptr<MosaicView> view;       // the newest published view; replaced, never modified
+    std::vector<cv::Mat> coverage;          // per tile: CV_8UC1 255 where written
+    std::vector<bool> full;                 // per tile: every pixel written
+    Keyframe keyframe;
+    bool hasKeyframe = false;
+    uint64_t generation = 0;
+
+    // Processing-thread scratch
+    cv::Mat reduced;
+    std::vector<cv::KeyPoint> keypoints;
+    cv::Mat descriptors;
+    std::vector<std::vector<cv::DMatch>> matches;
+    cv::Mat warped;
+    cv::Mat footprintMask;
+
+    std::atomic<uint64_t> registered{0};
+    std::atomic<uint64_t> failed{0};
+    std::atomic<uint64_t> tilesWritten{0};
+    std::atomic<uint64_t> keyframes{0};
+};
+
+// Builder used by the MOSAIC render mode
+MosaicBuilder& mosaicBuilder();
+
+#endif // EDGE_MOSAIC_BUILDER_H
@@ -0,0 +1,94 @@
+#include "motion_compensation.h"
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+
+#define LOG_TAG "MotionCompensation"
+#include "logging.h"
+
+void MotionCompensator::setEnabled(bool enable) {
+    if (on.exchange(enable, std::memory_order_relaxed) != enable) {
+        reset();
+        LOGI("🔄 Half-rate edge processing %s", enable ? "on" : "off");
+    }
+}
+
+cv::Mat MotionCompensator::downscaled(const cv::Mat& luma) const {
+    const int width = std::min(kMotionEstimateWidth, luma.cols);
+    const int height = std::max(1, luma.rows * width / std::max(1, luma.cols));
+    cv::Mat small;
+    cv::resize(luma, small, cv::Size(width, height), 0.0, 0.0, cv::INTER_AREA);
+    cv::Mat result;
+    small.convertTo(result, CV_32F);
+    return result;
+}
+
+bool MotionCompensator::admit(const cv::Mat& luma, int64_t timestampNs) {
+    const bool between = (arrivals.fetch_add(1, std::memory_order_relaxed) & 1u) != 0;
+    cv::Mat current = downscaled(luma);
+    cv::Mat target;
+    cv::Mat hanning;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!between || reference.empty() || reference.size() != current.size()) {
+            candidate = current;
+            candidateTimestampNs = timestampNs;
+            return true;
+        }
+        // Headers only: a new reference gets a new buffer, so these stay valid
+        target = reference;
+        hanning = window;
+    }
+    double response = 0.0;
+    cv::Point2d offset;
+    try {
+        offset = cv::phaseCorrelate(target, current, hanning, &response);
+    } catch (const cv::Exception& e) {
+        LOGE_RATELIMITED("❌ Phase correlation failed: %s", e.what());
+        response = 0.0;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (reference.data != target.data) {
+        return false;  // a newer reference arrived meanwhile; the frame is still skipped
+    }
+    hasShift = response >= kMotionMinResponse;
+    shift = cv::Point2f(static_cast<float>(offset.x / current.cols), static_cast<float>(offset.y / current.rows));
+    return false;
+}
+
+void MotionCompensator::commitReference(int64_t timestampNs) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (candidate.empty() || timestampNs != candidateTimestampNs) {
+        return;
+    }
+    if (window.size() != candidate.size()) {
+        cv::createHanningWindow(window, candidate.size(), CV_32F);
+    }
+    reference = candidate;
+    referenceTimestampNs = timestampNs;
+    candidate.release();
+    hasShift = false;
+}
+
+bool MotionCompensator::warpFor(int64_t timestampNs, cv::Matx23f& warp) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!hasShift || timestampNs != referenceTimestampNs) {
+        return false;
+    }
+    warp = cv::Matx23f(1.0f, 0.0f, shift.x, 0.0f, 1.0f, shift.y);
+    return true;
+}
+
+void MotionCompensator::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    reference.release();
+    referenceTimestampNs = 0;
+    candidate.release();
+    candidateTimestampNs = 0;
+    hasShift = false;
+    arrivals.store(0, std::memory_order_relaxed);
+}
+
+MotionCompensator& motionCompensator() {
+    static MotionCompensator compensator;
+    return compensator;
+}
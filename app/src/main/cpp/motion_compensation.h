@@ -0,0 +1,62 @@
+#ifndef EDGE_MOTION_COMPENSATION_H
+#define EDGE_MOTION_COMPENSATION_H
+
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+// Width the luma is box-downscaled to for phase correlation
+const int kMotionEstimateWidth = 160;
+// Phase correlation peaks weaker than this (a featureless or changing
+// scene) give no warp: the edges are shown unmoved
+const double kMotionMinResponse = 0.08;
+
+// Half-rate edge processing. Only every other arriving frame is processed in
+// full; once its edges are on their way to publish, its luma, downscaled,
+// becomes the reference. Each frame in between is only phase-correlated
+// against that reference, and the global translation found moves the
+// reference's edges on screen (RenderFrame::warp), so the display follows
+// the camera at the full rate for the cost of one small FFT per skipped
+// frame.
+class MotionCompensator {
+public:
+    void setEnabled(bool on);
+    bool enabled() const { return on.load(std::memory_order_relaxed); }
+
+    // For every frame arriving while enabled: true = process it in full,
+    // false = skip it, its motion against the reference measured instead.
+    // A frame to process is only a candidate reference until
+    // commitReference: a later gate may still drop it, and then the frames
+    // after it go on measuring against the edges still shown.
+    bool admit(const cv::Mat& luma, int64_t timestampNs);
+
+    // The candidate admitted at timestampNs is being processed and will be
+    // published: it becomes the reference. A no-op for any other frame.
+    void commitReference(int64_t timestampNs);
+
+    // The latest translation measured against the reference captured at
+    // referenceTimestampNs, as an affine map of 0..1 frame units; false when
+    // there is none, or it belongs to another reference.
+    bool warpFor(int64_t referenceTimestampNs, cv::Matx23f& warp) const;
+
+    void reset();
+
+private:
+    cv::Mat downscaled(const cv::Mat& luma) const;
+
+    std::atomic<bool> on{false};
+    std::atomic<uint32_t> arrivals{0};
+    mutable std::mutex mutex;
+    cv::Mat reference;  // CV_32FC1 at kMotionEstimateWidth, a fresh buffer per reference
+    cv::Mat window;     // Hanning window of the reference's size
+    int64_t referenceTimestampNs = 0;
+    cv::Mat candidate;  // the last frame admitted for processing, not committed yet
+    int64_t candidateTimestampNs = 0;
+    cv::Point2f shift;  // of the latest frame against the reference, in 0..1 frame units
+    bool hasShift = false;
+};
+
+MotionCompensator& motionCompensator();
+
+#endif // EDGE_MOTION_COMPENSATION_H
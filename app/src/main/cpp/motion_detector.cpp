@@ -0,0 +1,54 @@
+#include "motion_detector.h"
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+
+namespace {
+
+const int kHistory = 300;           // frames the automatic learning rate averages over
+const double kVarThreshold = 16.0;  // squared Mahalanobis distance that counts as foreground
+
+}  // namespace
+
+void MotionDetector::setParams(const Params& params) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (params.downscale != current.downscale) {
+        model.release();  // rebuilt at the new size on the next frame
+    }
+    current = params;
+}
+
+cv::Size MotionDetector::maskSize(const cv::Size& lumaSize) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return cv::Size(std::max(1, lumaSize.width / current.downscale),
+                    std::max(1, lumaSize.height / current.downscale));
+}
+
+void MotionDetector::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    model.release();
+}
+
+void MotionDetector::detect(const cv::Mat& luma, cv::Mat& mask) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const cv::Size size = mask.size();
+    if (!model || modelSize != size) {
+        // Shadow detection is off: it costs extra per pixel and only matters for color input
+        model = cv::createBackgroundSubtractorMOG2(kHistory, kVarThreshold, false);
+        modelSize = size;
+        frameIndex = 0;
+    }
+    if (size == luma.size()) {
+        reduced = luma;
+    } else {
+        cv::resize(luma, reduced, size, 0, 0, cv::INTER_AREA);
+    }
+    // The first frame always learns, so the model never starts out empty
+    const bool learn = frameIndex == 0 || frameIndex % std::max(1, current.learnEvery) == 0;
+    model->apply(reduced, mask, learn ? current.learningRate : 0.0);
+    frameIndex++;
+}
+
+MotionDetector& motionDetector() {
+    static MotionDetector detector;
+    return detector;
+}
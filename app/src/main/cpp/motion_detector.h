@@ -0,0 +1,45 @@
+#ifndef EDGE_MOTION_DETECTOR_H
+#define EDGE_MOTION_DETECTOR_H
+
+#include <opencv2/core.hpp>
+#include <opencv2/video/background_segm.hpp>
+#include <mutex>
+
+// Moving-pixel mask from a MOG2 background model. The model runs on an
+// area-downsampled copy of the luma (per-pixel Gaussian mixtures at full
+// resolution are far too slow on a phone) and the renderer upsamples the
+// small mask with texture filtering. Learning can also be limited to every
+// Nth frame; the frames in between only classify against the model.
+class MotionDetector {
+public:
+    struct Params {
+        int downscale = 4;            // model runs at 1/downscale of the luma per axis
+        double learningRate = 0.005;  // per learning frame; < 0 lets MOG2 pick from its history
+        int learnEvery = 1;           // update the model on every Nth frame only
+    };
+
+    void setParams(const Params& params);
+
+    // Size of the mask detect() writes for a luma of lumaSize
+    cv::Size maskSize(const cv::Size& lumaSize);
+
+    // Foreground mask of luma (CV_8UC1, 255 = moving) into mask, which must
+    // already be maskSize(luma.size()) and CV_8UC1
+    void detect(const cv::Mat& luma, cv::Mat& mask);
+
+    // Forgets the background, e.g. when the ROI moved
+    void reset();
+
+private:
+    std::mutex mutex;
+    Params current;
+    cv::Ptr<cv::BackgroundSubtractorMOG2> model;
+    cv::Size modelSize;
+    cv::Mat reduced;
+    int frameIndex = 0;
+};
+
+// Detector used by the MOTION render mode
+MotionDetector& motionDetector();
+
+#endif // EDGE_MOTION_DETECTOR_H
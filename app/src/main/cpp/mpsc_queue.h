@@ -0,0 +1,86 @@
+#ifndef EDGE_MPSC_QUEUE_H
+#define EDGE_MPSC_QUEUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+// Bounded multi-producer / single-consumer queue, FIFO. Every cell carries a
+// sequence number telling whose turn it is (Vyukov's bounded queue): a
+// producer claims a cell with one compare-exchange on the tail and publishes
+// it with a release store, the consumer takes it with an acquire load and
+// hands it back the same way. No lock on either side; head and tail sit a
+// cache line apart. N is a power of two.
+template <typename T, size_t N>
+class MpscQueue {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "MpscQueue capacity is a power of two");
+
+public:
+    MpscQueue() {
+        for (size_t i = 0; i < N; i++) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // Any thread; false (value untouched) when full
+    bool tryPush(T& value) {
+        size_t tail = tailIndex.load(std::memory_order_relaxed);
+        Cell* cell;
+        while (true) {
+            cell = &cells[tail & (N - 1)];
+            const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const intptr_t lag = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(tail);
+            if (lag == 0) {
+                if (tailIndex.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (lag < 0) {
+                return false;  // the consumer has not freed this cell yet
+            } else {
+                tail = tailIndex.load(std::memory_order_relaxed);  // another producer took it
+            }
+        }
+        cell->value = std::move(value);
+        cell->sequence.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side; false when empty, or when the oldest claimed cell is
+    // still being written (its producer's push has not returned yet)
+    bool tryPop(T& value) {
+        const size_t head = headIndex.load(std::memory_order_relaxed);
+        Cell& cell = cells[head & (N - 1)];
+        if (cell.sequence.load(std::memory_order_acquire) != head + 1) {
+            return false;
+        }
+        value = std::move(cell.value);
+        cell.value = T();  // drop whatever the moved-from value may still reference
+        cell.sequence.store(head + N, std::memory_order_release);
+        headIndex.store(head + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Consumer side: whether tryPop() would find nothing
+    bool empty() const {
+        const size_t head = headIndex.load(std::memory_order_relaxed);
+        return cells[head & (N - 1)].sequence.load(std::memory_order_acquire) != head + 1;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence{0};
+        T value;
+    };
+
+    // Padding rather than alignas, as in SpscRing: queues live on the heap
+    std::array<Cell, N> cells;
+    char padHead[64];
+    std::atomic<size_t> headIndex{0};  // next cell to pop (consumer owned)
+    char padTail[64];
+    std::atomic<size_t> tailIndex{0};  // next cell to claim (shared by producers)
+    char padEnd[64];
+};
+
+#endif // EDGE_MPSC_QUEUE_H
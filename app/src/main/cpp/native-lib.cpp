@@ -1,14 +1,113 @@
 #include <jni.h>
+#include <android/asset_manager_jni.h>
+#include <android/bitmap.h>
 #include <string>
-#include <android/log.h>
 #include <opencv2/opencv.hpp>
 #include "image_processor.h"
+#include "jni_registry.h"
 #include "opengl_renderer.h"
+#include "frame_ingest.h"
+#include "yuv_convert.h"
+#include "band_executor.h"
+#include "canny_kernel.h"
+#include "backend_autotuner.h"
+#include "split_balancer.h"
+#include "stall_watchdog.h"
+#include "stereo_depth.h"
+#include "frame_arena.h"
+#include "frame_fanout.h"
+#include "frame_history.h"
+#include "frame_pool.h"
+#include "triple_buffer.h"
+#include "processing_worker.h"
+#include "stage_pipeline.h"
+#include "quality_governor.h"
+#include "capture_capacity.h"
+#include "performance_hint.h"
+#include "batch_processor.h"
+#include "async_edge_queue.h"
+#include "frame_capture.h"
+#include "burst_selector.h"
+#include "motion_compensation.h"
+#include "frame_telemetry.h"
+#include "session_report.h"
+#include "frame_pacing.h"
+#include "render_scheduler.h"
+#include "frame_replay.h"
+#include "synthetic_source.h"
+#include "video_file_source.h"
+#include "packed_edges.h"
+#include "bitmap_writer.h"
+#include "scaled_outputs.h"
+#include "stage_plugins.h"
+#include "render_effects.h"
+#include "edge_points.h"
+#include "edge_events.h"
+#include "edge_stream.h"
+#include "edge_archive.h"
+#include "snapshot_exporter.h"
+#include "shared_edge_output.h"
+#include "gpu_readback.h"
+#include "metrics.h"
+#include "memory_accounting.h"
+#include "metrics_server.h"
+#include "backend_comparison.h"
+#include "tracing.h"
+#include "render_frame.h"
+#include "incremental_edges.h"
+#include "filter_graph.h"
+#include "gapi_pipeline.h"
+#include "gapi_streaming.h"
+#include "ocl_processing.h"
+#include "feature_detector.h"
+#include "optical_flow.h"
+#include "contour_extractor.h"
+#include "line_detector.h"
+#include "dnn_edges.h"
+#include "motion_detector.h"
+#include "luma_stats.h"
+#include "capture_metadata.h"
+#include "document_detector.h"
+#include "chamfer_matcher.h"
+#include "pyramid_cache.h"
+#include "segment_detector.h"
+#include "marker_detector.h"
+#include "code_scanner.h"
+#include "face_detector.h"
+#include "mosaic_builder.h"
+#include "object_tracker.h"
+#include "people_detector.h"
+#include "text_region_detector.h"
+#include "visual_odometry.h"
+#include "freeze_frame.h"
+#include "frame_deadline.h"
+#include "memory_budget.h"
+#include "app_startup.h"
+#include "mapped_asset.h"
+#include "video_stabilizer.h"
+#include "lens_undistortion.h"
+#include "temporal_denoise.h"
+#include "tiled_clahe.h"
+#include "edge_components.h"
+#include "edge_morphology.h"
+#include "thread_policy.h"
+#include "control_block.h"
+#include "work_stealing_pool.h"
+#include "cpu_profiler.h"
+#include "kernel_dispatch.h"
+#include "vulkan_edges.h"
+#include "hardware_frames.h"
 #include <mutex>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <vector>
 
 #define LOG_TAG "NativeBridge"
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#include "logging.h"
 
 // Render mode constants (must match Java enum order)
 enum RenderMode {
@@ -17,209 +116,8480 @@ enum RenderMode {
     GRAYSCALE = 2,
     DEFAULT = 3,
     INSET = 4,
-    BORDER_FIX = 5
+    BORDER_FIX = 5,
+    FEATURES = 6,       // raw feed with FAST keypoints drawn as point sprites
+    TRACKING = 7,       // raw feed with Lucas-Kanade flow vectors drawn as lines
+    CONTOURS = 8,       // simplified edge contours drawn as line strips, no edge raster
+    LINES = 9,          // raw feed with HoughLinesP segments drawn as lines
+    MOTION = 10,        // raw feed with the MOG2 foreground mask as an overlay
+    DOCUMENT = 11,      // raw feed with the outline of the largest quadrilateral
+    CHAMFER_MATCH = 12, // raw feed with the boxes of edge templates found present
+    MULTISCALE_EDGES = 13, // CPU Canny confirmed by coarser pyramid levels, shown like EDGE_DETECTION
+    SEGMENTS = 14,      // raw feed with LSD line segments drawn as lines
+    MARKERS = 15,       // raw feed with the outlines of detected ArUco markers
+    CODES = 16,         // raw feed with the outlines of decoded QR codes (asynchronous)
+    STABILIZE = 17,     // EDGE_DETECTION output held steady by a smoothed camera path
+    DEPTH = 18,         // colormapped StereoBM disparity against a second camera's pipeline
+    FACES = 19,         // raw feed with YuNet face boxes, tracked between detections (asynchronous)
+    MOSAIC = 20,        // incremental luma panorama of the sweep so far, the current frame outlined
+    TRACK_OBJECT = 21,  // raw feed with the box of one selected object, followed by a video-module tracker
+    PEOPLE = 22,        // EDGE_DETECTION output with HOG pedestrian boxes, detected every few frames
+    COLOR_EDGES = 23,   // CPU Canny on the NV21 color structure tensor, shown like EDGE_DETECTION
+    TEXT_REGIONS = 24,  // raw feed with MSER text line boxes in edge-dense areas, detected every few frames
+    ODOMETRY = 25,      // raw feed with ORB matches to the previous frame; the pose is read through JNI
+    HEATMAP = 26,       // edge maps accumulated with decay on the GPU, shown through a colormap
+    FOCUS_PEAK = 27     // raw feed with in-focus luma gradients painted by the shader; sharpness in the luma stats
 };
+static const int kRenderModeCount = FOCUS_PEAK + 1;
 
-// Global frames storage
-static cv::Mat rawFrame;        // Original camera data (BGR)
-static cv::Mat processedFrame;  // OpenCV processed data
-static cv::Mat grayscaleFrame;  // Grayscale version
-static std::mutex frameMutex;
-static RenderMode currentRenderMode = EDGE_DETECTION; // Default to edge detection
+// One published set of render variants. Every Mat references an immutable
+// pooled buffer, so slots are passed around by header only.
+struct PublishedFrame {
+    cv::Mat raw;        // Camera image: BGR on the legacy path, RGBA (the upload format) on the luma path
+    cv::Mat processed;  // OpenCV processed data
+    uint64_t processedResult = 0;  // incremental Canny result processed is unchanged from (0 = untracked)
+    uint64_t processedBase = 0;    // result processed differs from only inside processedChanges (0 = none)
+    cv::Mat processedChanges;      // CV_32SC4 (x, y, width, height) rects of processed; may have 0 rows
+    int processedBitmapWidth = 0;  // processed is a 1-bpp edge bitmap this wide (packed_edges.h); 0 = 8-bit
+    cv::Mat grayscale;  // Grayscale version
+    cv::Mat splitEdges; // EDGE_BACKEND_SPLIT: CPU edges of grayscale's top rows (RenderFrame::splitEdges)
+    cv::Mat yuvLuma;    // Camera Y plane for GPU YUV conversion
+    cv::Mat yuvChroma;  // Matching interleaved VU plane (CV_8UC2, half size)
+    int rotation = 0;   // Clockwise degrees to upright; applied by the renderer only
+    uint64_t sequence = 0; // Bumped on every publish; 0 = nothing published yet
+    int64_t captureTimestampNs = 0; // Sensor (or arrival) time on CLOCK_BOOTTIME
+    cv::Rect processedRoi;      // Part of the frame grayscale/processed cover (empty = all)
+    cv::Size processedFrameSize; // Full frame size processedRoi refers to
+    cv::Mat features;   // CV_32FC2 keypoints as (u, v) in 0..1 full-frame units; may have 0 rows
+    bool hasFeatures = false;    // features was computed (lastPublished: at least once)
+    cv::Mat flow;       // CV_32FC2 (from, to) pairs in the same units as features
+    bool hasFlow = false;
+    cv::Mat contourPoints;   // CV_32FC2 closed contour strips in the same units as features
+    cv::Mat contourOffsets;  // CV_32SC1 first point of each strip, then the point count
+    bool hasContours = false;
+    cv::Mat lines;      // CV_32FC2 segment end point pairs in the same units as features
+    bool hasLines = false;
+    cv::Mat segments;   // CV_32FC2 LSD segment end point pairs in the same units as features
+    bool hasSegments = false;
+    cv::Mat markers;    // CV_32SC1, one MarkerRecord (marker_detector.h) per row, corners in features' units
+    cv::Mat markerStrips;        // CV_32FC2 marker outlines as closed strips, same units
+    cv::Mat markerStripOffsets;  // CV_32SC1 as contourOffsets, for markerStrips
+    bool hasMarkers = false;
+    std::shared_ptr<const CodeScanResult> codes;  // newest finished scan, corners in the scanned luma's units
+    cv::Mat codeStrips;          // CV_32FC2 outlines of the decoded codes as closed strips, same units as features
+    cv::Mat codeStripOffsets;    // CV_32SC1 as contourOffsets, for codeStrips
+    bool hasCodes = false;
+    cv::Mat faces;       // CV_32FC1, per face: u0, v0, u1, v1, score in features' units; may have 0 rows
+    cv::Mat faceStrips;  // CV_32FC2 face boxes as closed strips, same units
+    cv::Mat faceStripOffsets;  // CV_32SC1 as contourOffsets, for faceStrips
+    bool hasFaces = false;
+    std::shared_ptr<const MosaicView> mosaic;  // the canvas after this frame; tiles are shared, never modified
+    cv::Mat mosaicOutline;         // CV_32FC2 closed strip of the frame in 0..1 canvas units; 0 rows = unregistered
+    cv::Mat mosaicOutlineOffsets;  // CV_32SC1 as contourOffsets, for mosaicOutline
+    bool hasMosaic = false;
+    cv::Mat trackedObject;         // CV_32FC2 box of the selected object as a closed strip, 0..1 frame units; 0 rows = none
+    cv::Mat trackedObjectOffsets;  // CV_32SC1 as contourOffsets, for trackedObject
+    bool hasTrackedObject = false;
+    cv::Mat people;        // CV_32FC1, per person: u0, v0, u1, v1, SVM weight in features' units; may have 0 rows
+    cv::Mat peopleStrips;  // CV_32FC2 person boxes as closed strips, same units
+    cv::Mat peopleStripOffsets;  // CV_32SC1 as contourOffsets, for peopleStrips
+    bool hasPeople = false;
+    cv::Mat textRegions;   // CV_32FC1, per line: u0, v0, u1, v1 in features' units; may have 0 rows
+    cv::Mat textRegionStrips;  // CV_32FC2 line boxes as closed strips, same units
+    cv::Mat textRegionStripOffsets;  // CV_32SC1 as contourOffsets, for textRegionStrips
+    bool hasTextRegions = false;
+    cv::Mat odometryMatches;   // CV_32FC2 (previous, current) ORB match pairs in the same units as features
+    bool hasOdometry = false;
+    cv::Matx23f stabilization;   // correction of the frame in 0..1 frame units (video_stabilizer.h)
+    bool hasStabilization = false;
+    cv::Mat motion;     // CV_8UC1 foreground mask of the processed area at model resolution
+    cv::Mat document;   // CV_32FC2 tracked quadrilateral, closed (5 points, TL TR BR BL TL); 0 rows = none
+    cv::Matx33f documentHomography;  // 0..1 rectified coordinates -> 0..1 frame units, while document is set
+    cv::Size documentSize;           // rectified extent in frame pixels (mean opposite side lengths)
+    bool hasDocument = false;
+    cv::Mat edgeDistance;     // CV_8UC1 distance to the nearest edge at matcher resolution (chamfer_matcher.h)
+    cv::Mat chamferMatches;   // CV_32FC1, per template: id, score, accepted, u0, v0, u1, v1; may have 0 rows
+    cv::Mat chamferOutlines;  // CV_32FC2 accepted template boxes as closed strips, same units as features
+    cv::Mat chamferOffsets;   // CV_32SC1 as contourOffsets, for chamferOutlines
+    bool hasChamfer = false;
+    cv::Mat edgeComponents;   // CV_32FC1, per kept edge component: u0, v0, u1, v1, pixels; may have 0 rows
+    int edgeComponentsTotal = 0;  // components labeled, kept or not
+    bool hasEdgeComponents = false;
+    cv::Mat depth;        // CV_8UC4 colormapped disparity of the whole frame at StereoDepth's reduced size
+    bool hasDepth = false;
+    cv::Mat edgeRecords;  // CV_16UC4, one EdgeRecord (canny_kernel.h) per row; may have 0 rows
+    bool hasEdgeRecords = false;
+    int edgeRecordsDropped = 0;  // edge pixels past the record capacity
+    cv::Size edgeRecordGrid;     // pixel grid of the records: the processed luma
+    cv::Rect edgeRecordRoi;      // what that grid covers, in full-frame pixels
+    cv::Mat edgePoints;   // CV_16UC2 (x, y) of every edge pixel in raster order; may have 0 rows
+    bool hasEdgePoints = false;
+    int edgePointsDropped = 0;   // edge pixels past the point capacity
+    cv::Size edgePointGrid;      // as edgeRecordGrid, for the points
+    cv::Rect edgePointRoi;
+    std::shared_ptr<const SharedEdgeImage> sharedEdges;  // Vulkan edges of the full frame, GPU-side
+    std::shared_ptr<const HardwareFrame> hardwareFrame;  // copy of hardwareFrameSource the renderer samples
+    cv::Mat hardwareFrameSource;  // the variant copied (held, so its buffer cannot be reused meanwhile)
+    std::vector<ScaledLuma> scaledLuma;  // scaled_outputs.h; for the fan-out only, never kept in the slots
+    int renderMode = -1;  // mode the variants were chosen for (-1 = nothing processed yet)
+    uint32_t modesBuilt = 0;  // bit per RenderMode this frame's variants were built for (not kept in lastPublished)
+};
+
+// One pipeline: its processing thread, the frames it publishes and the mode
+// they are built for. The handle-less JNI calls, the native camera and every
+// GL surface not bound elsewhere use defaultPipeline; nativeCreatePipeline
+// adds more (a second camera stream, an offline job beside the preview), fed
+// by their callers or their own camera and worker. Processing settings
+// (backends, ROI, scale, governor) and the stateful analysis detectors stay
+// process-wide.
+struct PipelineContext {
+    // Processing publishes, the GL thread takes the newest slot without
+    // locking or copying
+    TripleBuffer<PublishedFrame> publishedFrames;
+    std::mutex publishMutex;       // serializes producers only, never taken by the renderer
+    PublishedFrame lastPublished;  // producer-side: variants not rebuilt this frame keep their last value
+    std::atomic<uint64_t> publishedSequence{0};
+    FrameHistory history;          // the last published frames, for temporal consumers (nativeSetFrameHistory)
+
+    // Active render mode in the low byte, a version bumped by every switch
+    // above it, so one load yields a consistent pair. The UI thread swaps it;
+    // the GL thread reads it once per drawn frame and processing once per
+    // frame, so a frame is built (and displayed) for a single mode.
+    std::atomic<uint32_t> renderModeState{EDGE_DETECTION}; // Default to edge detection
+    std::atomic<uint32_t> frameModeState{EDGE_DETECTION};  // the last state a frame was built for
+
+    // Newest ingested frame (width << 16 | height, 0 = none yet), so a mode
+    // switch can warm buffers before that mode's first frame arrives
+    std::atomic<uint32_t> ingestGeometry{0};
+
+    // Optional asynchronous processing thread (see nativeStartProcessingWorker)
+    ProcessingWorker worker;
+};
+
+static PipelineContext defaultPipeline;
+
+// A handle from nativeCreatePipeline; 0 is the default pipeline
+static PipelineContext& pipelineFor(jlong handle) {
+    return handle ? *reinterpret_cast<PipelineContext*>(handle) : defaultPipeline;
+}
+
+static RenderMode modeOf(uint32_t state) {
+    return static_cast<RenderMode>(state & 0xff);
+}
+
+static RenderMode activeRenderMode(const PipelineContext& pipeline) {
+    return modeOf(pipeline.renderModeState.load(std::memory_order_acquire));
+}
+
+// The mode the default pipeline's frames are built and drawn for:
+// GRAYSCALE while the stall watchdog passes frames through
+static RenderMode watchdogMode(const PipelineContext& pipeline, RenderMode mode) {
+    return &pipeline == &defaultPipeline && stallWatchdog().level() == StallWatchdog::PASSTHROUGH ? GRAYSCALE : mode;
+}
+static std::atomic<bool> lumaFastPath{true}; // Derive gray/edges from the Y plane
+static std::atomic<bool> bandFusion{true};   // legacy path: NV21 -> BGR -> gray in L2-sized stripes
+static std::atomic<bool> gpuYuvRaw{true};    // RAW_CAMERA converts YUV in the fragment shader
+static std::atomic<bool> externalPreview{false}; // RAW_CAMERA samples the camera's OES texture directly
+static std::atomic<bool> hardwareFrames{false};  // single-layer frames written into AHardwareBuffers
+
+// Where EDGE_DETECTION runs (must match the Java constants)
+enum EdgeBackend {
+    EDGE_BACKEND_CPU = 0,    // cv::Canny in the processing pipeline
+    EDGE_BACKEND_GPU = 1,    // multi-pass fragment shaders in the renderer
+    EDGE_BACKEND_OPENCL = 2, // grayscale and Canny on cv::UMat (CPU without OpenCL)
+    EDGE_BACKEND_CL_GL = 3,  // OpenCL kernels on the camera's GL texture (external preview;
+                             // the shader passes on uploaded luma otherwise)
+    EDGE_BACKEND_DNN = 4,    // Canny blended with an asynchronous learned edge model
+    EDGE_BACKEND_VULKAN = 5, // compute shaders on the luma (or camera buffer), result shared with GL
+    EDGE_BACKEND_SPLIT = 6   // top rows tiled Canny on the CPU, the rest the renderer's passes (split_balancer.h)
+};
+static const char* const kEdgeBackendNames[] = {"CPU", "GPU", "OpenCL", "CL-GL", "DNN", "Vulkan", "Split"};
+static std::atomic<int> edgeBackend{EDGE_BACKEND_CPU};
+static std::atomic<bool> lumaStats{false};   // one-pass statistics on every processed luma
+
+// Both GPU backends run in the renderer on the luma plane (or camera
+// texture), and so does the GPU part of the split backend
+static bool edgesInRenderer() {
+    int backend = edgeBackend.load(std::memory_order_relaxed);
+    return backend == EDGE_BACKEND_GPU || backend == EDGE_BACKEND_CL_GL || backend == EDGE_BACKEND_SPLIT;
+}
+
+// Processing resolution for grayscale and Canny: a divisor of the camera size
+// or, when set, a box the frame is fitted into (sensor orientation). The raw
+// layer always stays at camera resolution; the GPU upscales the rest.
+static std::atomic<int> processingDivisor{1};
+
+// Memory budget degradation (memory_budget.h), raised one step per frame
+// boundary that finds the budget refused something:
+//   1: the frame history keeps at most kMemoryHistoryDepth frames
+//   2: no resident mode textures (as under a memory trim)
+//   3, 4: processing at a half, then a quarter of the requested size
+// Stays until the budget is set again.
+static std::atomic<int> memoryDegradation{0};
+static const int kMaxMemoryDegradation = 4;
+static const int kMemoryHistoryDepth = 2;
+static std::atomic<int> processingTargetWidth{0};
+static std::atomic<int> processingTargetHeight{0};
+
+// Processing region of interest in sensor pixels; grayscale and Canny only see
+// this part of the frame and the renderer puts the result back in place
+static std::mutex roiMutex;
+static cv::Rect processingRoi;           // empty = whole frame
+static std::atomic<bool> hasProcessingRoi{false};
+static std::atomic<float> roiBackgroundDim{0.0f}; // 0 = raw background as-is, 1 = black
+// TRACK_OBJECT with edges in the box: the tracked object's box, with a margin,
+// stands in for the processing ROI while the object is followed
+static std::atomic<bool> trackedRoiEdges{false};
+static cv::Rect trackedRoi;              // under roiMutex
+static std::atomic<bool> hasTrackedRoi{false};
+
+// Re-run Canny only on blocks that changed since the last frame
+static std::atomic<bool> incrementalEdges{false};
+
+// Blur + Canny through the compiled G-API/Fluid graph (gapi_pipeline.h)
+static std::atomic<bool> gapiPipeline{false};
+
+// The ROI clipped to a frame and aligned to even pixels so the half-size
+// chroma plane maps onto it; empty when it covers the whole frame
+static cv::Rect activeRoi(const cv::Size& frame) {
+    const bool tracked = hasTrackedRoi.load(std::memory_order_relaxed);
+    if (!tracked && !hasProcessingRoi.load(std::memory_order_relaxed)) {
+        return cv::Rect();
+    }
+    cv::Rect roi;
+    {
+        std::lock_guard<std::mutex> lock(roiMutex);
+        roi = (tracked ? trackedRoi : processingRoi) & cv::Rect(cv::Point(), frame);
+    }
+    int x = roi.x & ~1;
+    int y = roi.y & ~1;
+    roi = cv::Rect(x, y, (roi.width + roi.x - x) & ~1, (roi.height + roi.y - y) & ~1);
+    if (roi.empty() || roi.size() == frame) {
+        return cv::Rect();
+    }
+    return roi;
+}
+
+static cv::Size requestedProcessingSize(const cv::Size& full) {
+    int targetWidth = processingTargetWidth.load(std::memory_order_relaxed);
+    int targetHeight = processingTargetHeight.load(std::memory_order_relaxed);
+    if (targetWidth > 0 && targetHeight > 0) {
+        if (full.width <= targetWidth && full.height <= targetHeight) {
+            return full;
+        }
+        // Aspect ratio is kept so processed layers line up with the raw one
+        double scale = std::min(static_cast<double>(targetWidth) / full.width,
+                                static_cast<double>(targetHeight) / full.height);
+        return cv::Size(std::max(1, cvRound(full.width * scale)),
+                        std::max(1, cvRound(full.height * scale)));
+    }
+    int divisor = processingDivisor.load(std::memory_order_relaxed);
+    if (divisor <= 1) {
+        return full;
+    }
+    return cv::Size(std::max(1, full.width / divisor), std::max(1, full.height / divisor));
+}
+
+// The requested processing size, reduced further by the quality governor and
+// the memory budget
+static cv::Size processingSize(const cv::Size& full) {
+    cv::Size size = requestedProcessingSize(full);
+    const int degradation = memoryDegradation.load(std::memory_order_relaxed);
+    const int divisor = qualityGovernor().current().scaleDivisor * (degradation >= 4 ? 4 : degradation >= 3 ? 2 : 1);
+    if (divisor > 1) {
+        size = cv::Size(std::max(1, size.width / divisor), std::max(1, size.height / divisor));
+    }
+    return size;
+}
+
+// Variants a frame can produce; the pipeline only runs the stages feeding the
+// active mode (plus an optional pre-warmed mode for instant switching)
+enum FrameVariant : unsigned {
+    VARIANT_RAW = 1u << 0,
+    VARIANT_GRAY = 1u << 1,
+    VARIANT_EDGES = 1u << 2,
+    VARIANT_YUV = 1u << 3,  // Y + VU planes, converted to RGB by the renderer
+    VARIANT_FEATURES = 1u << 4, // FAST keypoints of the luma
+    VARIANT_FLOW = 1u << 5,     // optical flow from the previous processed luma
+    VARIANT_CONTOURS = 1u << 6, // vector contours of the edge map (the raster stays private)
+    VARIANT_LINES = 1u << 7,    // Hough segments of the edge map
+    VARIANT_MOTION = 1u << 8,   // background subtraction mask
+    VARIANT_DOCUMENT = 1u << 9, // largest quadrilateral of the edge map
+    VARIANT_SHARED_EDGES = 1u << 10, // Vulkan edge image in an AHardwareBuffer
+    VARIANT_CHAMFER = 1u << 11, // edge distance transform and template matches
+    VARIANT_SEGMENTS = 1u << 12, // LSD segments of the luma (asynchronous)
+    VARIANT_MARKERS = 1u << 13, // ArUco markers of the luma
+    VARIANT_CODES = 1u << 14,   // QR codes of the luma (asynchronous)
+    VARIANT_STABILIZE = 1u << 15, // stabilizing warp of the luma's motion
+    VARIANT_SPLIT_EDGES = 1u << 16, // CPU edges of the gray's top rows (EDGE_BACKEND_SPLIT)
+    VARIANT_DEPTH = 1u << 17,   // stereo disparity against the right camera's newest frame
+    VARIANT_FACES = 1u << 18,   // YuNet faces of the luma (asynchronous), tracked every frame
+    VARIANT_MOSAIC = 1u << 19,  // the luma registered into the mosaic canvas
+    VARIANT_TRACK_OBJECT = 1u << 20, // the selected object followed through the whole frame
+    VARIANT_PEOPLE = 1u << 21,  // HOG pedestrians of the luma, every few frames
+    VARIANT_TEXT_REGIONS = 1u << 22, // MSER text lines of the luma, every few frames
+    VARIANT_ODOMETRY = 1u << 23 // ORB matches of the luma to the previous frame's, and the pose
+};
+
+// Per-mode thickening of the displayed edge map: kernel size (0/1 = off) in
+// the low byte, RectMorphology::Op above it
+static std::atomic<int> edgeMorphology[kRenderModeCount];
+
+// Variants that need the CPU edge map, and those that need the processed luma
+static const unsigned kEdgeMapVariants = VARIANT_EDGES | VARIANT_CONTOURS | VARIANT_LINES | VARIANT_DOCUMENT |
+                                         VARIANT_CHAMFER;
+static const unsigned kLumaVariants = VARIANT_GRAY | VARIANT_FEATURES | VARIANT_FLOW | VARIANT_MOTION |
+                                      VARIANT_SEGMENTS | VARIANT_MARKERS | VARIANT_CODES | VARIANT_STABILIZE |
+                                      VARIANT_FACES | VARIANT_MOSAIC | VARIANT_PEOPLE | VARIANT_TEXT_REGIONS |
+                                      VARIANT_ODOMETRY | kEdgeMapVariants;
+
+// What the raw camera layer needs from the CPU pipeline
+static unsigned rawLayerVariants() {
+    if (externalPreview.load(std::memory_order_relaxed)) {
+        return 0;  // the renderer samples the camera's OES texture, no CPU pixels
+    }
+    return gpuYuvRaw.load(std::memory_order_relaxed) ? VARIANT_YUV : VARIANT_RAW;
+}
+
+static unsigned variantsForMode(int mode) {
+    // With a processing ROI the single-layer modes are drawn over the raw feed
+    unsigned background = hasProcessingRoi.load(std::memory_order_relaxed) ? rawLayerVariants() : 0;
+    switch (mode) {
+        case RAW_CAMERA: return rawLayerVariants();
+        case GRAYSCALE: return background | VARIANT_GRAY;
+        case EDGE_DETECTION:
+            // The renderer backends only need the luma plane uploaded
+            if (edgeBackend.load(std::memory_order_relaxed) == EDGE_BACKEND_CL_GL &&
+                externalPreview.load(std::memory_order_relaxed)) {
+                return 0;  // the renderer works on the camera texture itself
+            }
+            if (edgeBackend.load(std::memory_order_relaxed) == EDGE_BACKEND_VULKAN) {
+                return VARIANT_SHARED_EDGES;
+            }
+            if (edgeBackend.load(std::memory_order_relaxed) == EDGE_BACKEND_SPLIT) {
+                return VARIANT_GRAY | VARIANT_SPLIT_EDGES;
+            }
+            return edgesInRenderer() ? VARIANT_GRAY : background | VARIANT_EDGES;
+        case DEFAULT:
+        case INSET: return rawLayerVariants() | VARIANT_EDGES;  // composed by the renderer
+        case BORDER_FIX:
+        case MULTISCALE_EDGES:
+        case COLOR_EDGES: return background | VARIANT_EDGES;
+        case FEATURES: return rawLayerVariants() | VARIANT_FEATURES;
+        case TRACKING: return rawLayerVariants() | VARIANT_FLOW;
+        case CONTOURS: return background | VARIANT_CONTOURS;
+        case LINES: return rawLayerVariants() | VARIANT_LINES;
+        case MOTION: return rawLayerVariants() | VARIANT_MOTION;
+        case DOCUMENT: return rawLayerVariants() | VARIANT_DOCUMENT;
+        case CHAMFER_MATCH: return rawLayerVariants() | VARIANT_CHAMFER;
+        case SEGMENTS: return rawLayerVariants() | VARIANT_SEGMENTS;
+        case MARKERS: return rawLayerVariants() | VARIANT_MARKERS;
+        case CODES: return rawLayerVariants() | VARIANT_CODES;
+        case STABILIZE: return background | VARIANT_EDGES | VARIANT_STABILIZE;
+        case DEPTH: return VARIANT_DEPTH;
+        case FACES: return rawLayerVariants() | VARIANT_FACES;
+        case MOSAIC: return VARIANT_MOSAIC;
+        case TRACK_OBJECT:
+            return rawLayerVariants() | VARIANT_TRACK_OBJECT |
+                   (hasTrackedRoi.load(std::memory_order_relaxed) ? VARIANT_EDGES : 0);
+        case PEOPLE: return background | VARIANT_EDGES | VARIANT_PEOPLE;
+        case TEXT_REGIONS: return rawLayerVariants() | VARIANT_TEXT_REGIONS;
+        case ODOMETRY: return rawLayerVariants() | VARIANT_ODOMETRY;
+        case HEATMAP: return VARIANT_EDGES;  // accumulated by the renderer
+        case FOCUS_PEAK: return VARIANT_YUV;  // the shader peaks the planes it draws
+        default: return 0;
+    }
+}
+
+static std::atomic<int> prewarmMode{-1}; // -1 = no second mode kept warm
+// Frames each pipeline's history keeps (0 = none), and whether with edges
+static std::atomic<int> frameHistoryDepth{0};
+static std::atomic<bool> frameHistoryEdges{false};
+
+static unsigned requiredVariants(RenderMode mode) {
+    return variantsForMode(mode) | variantsForMode(prewarmMode.load(std::memory_order_relaxed));
+}
+
+// Mode residency (nativeSetModeResidency): the renderer keeps a snapshot of
+// the view per resident mode, and every residentRefreshFrames frames the
+// default pipeline also builds one inactive resident mode, in turn, so its
+// snapshot stays recent. Memory pressure drops the budget to zero until
+// kResidencyPressureMicros pass without another trim.
+static std::atomic<uint32_t> residentModes{0};
+static std::atomic<int64_t> residencyBudgetBytes{0};
+static std::atomic<int> residentRefreshFrames{0};  // 0 = inactive modes are not refreshed
+static std::atomic<int64_t> residencyPressureMicros{0};  // last trim while resident, 0 = none
+static const int64_t kResidencyPressureMicros = 60 * 1000000LL;
+
+static bool residencyUnderPressure() {
+    int64_t since = residencyPressureMicros.load(std::memory_order_relaxed);
+    if (since == 0) {
+        return false;
+    }
+    if (monotonicMicros() - since < kResidencyPressureMicros) {
+        return true;
+    }
+    if (residencyPressureMicros.compare_exchange_strong(since, 0, std::memory_order_relaxed)) {
+        setModeResidencyGL(residentModes.load(std::memory_order_relaxed),
+                           residencyBudgetBytes.load(std::memory_order_relaxed));
+        LOGI("🔄 Mode residency budget restored");
+    }
+    return false;
+}
+
+// Render modes a frame is built for: the active one, the pre-warmed one and,
+// on the default pipeline's refresh frames, the next inactive resident mode
+static uint32_t modesToBuild(const PipelineContext& pipeline, RenderMode mode) {
+    uint32_t modes = 1u << mode;
+    const int prewarm = prewarmMode.load(std::memory_order_relaxed);
+    if (prewarm >= 0 && prewarm < kRenderModeCount) {
+        modes |= 1u << prewarm;
+    }
+    const int refresh = residentRefreshFrames.load(std::memory_order_relaxed);
+    const uint32_t inactive = residentModes.load(std::memory_order_relaxed) & ~modes;
+    if (&pipeline != &defaultPipeline || refresh <= 0 || inactive == 0 || residencyUnderPressure() ||
+        stallWatchdog().level() != StallWatchdog::NORMAL) {
+        return modes;
+    }
+    static std::atomic<uint32_t> frames{0};
+    static std::atomic<int> nextResident{0};
+    if (frames.fetch_add(1, std::memory_order_relaxed) % static_cast<uint32_t>(refresh) != 0) {
+        return modes;
+    }
+    const int first = nextResident.load(std::memory_order_relaxed);
+    for (int i = 0; i < kRenderModeCount; i++) {
+        const int resident = (first + i) % kRenderModeCount;
+        if (inactive >> resident & 1) {
+            nextResident.store(resident + 1, std::memory_order_relaxed);
+            return modes | 1u << resident;
+        }
+    }
+    return modes;
+}
+
+static unsigned variantsForModes(uint32_t modes) {
+    unsigned variants = 0;
+    for (int mode = 0; mode < kRenderModeCount; mode++) {
+        if (modes >> mode & 1) {
+            variants |= variantsForMode(mode);
+        }
+    }
+    return variants;
+}
+
+// Geometries (rows, cols, type) of the pooled buffers a frame of the given
+// camera size acquires in the mode, one entry per buffer held at once
+static std::vector<cv::Vec3i> frameBufferGeometries(RenderMode mode, const cv::Size& full) {
+    const unsigned variants = requiredVariants(mode);
+    const cv::Rect roi = activeRoi(full);
+    const cv::Size area = roi.empty() ? full : roi.size();
+    const cv::Size processing = processingSize(area);
+    std::vector<cv::Vec3i> geometries;
+    if (variants & VARIANT_RAW) {
+        const int rawType = lumaFastPath.load(std::memory_order_relaxed) ? CV_8UC4 : CV_8UC3;
+        geometries.emplace_back(full.height, full.width, rawType);
+    }
+    if (variants & VARIANT_YUV) {
+        geometries.emplace_back(full.height, full.width, CV_8UC1);
+        geometries.emplace_back(full.height / 2, full.width / 2, CV_8UC2);
+    }
+    if (variants & kLumaVariants) {
+        geometries.emplace_back(processing.height, processing.width, CV_8UC1);
+    }
+    if (variants & kEdgeMapVariants) {
+        geometries.emplace_back(processing.height, processing.width, CV_8UC1);
+        if ((variants & VARIANT_EDGES) && (edgeMorphology[mode].load(std::memory_order_relaxed) & 0xff) > 1) {
+            geometries.emplace_back(processing.height, processing.width, CV_8UC1);
+        }
+        if (edgeComponents().active()) {
+            geometries.emplace_back(processing.height, processing.width, CV_8UC1);
+        }
+        if (variants & VARIANT_CHAMFER) {
+            const cv::Size distance = chamferMatcher().distanceSize(processing);
+            geometries.emplace_back(distance.height, distance.width, CV_8UC1);
+        }
+    }
+    return geometries;
+}
+
+// Acquires sets of the given geometries at once, so each lands on a distinct
+// buffer; they are idle and ready in the pool again on return
+static size_t warmFrameBuffers(const std::vector<cv::Vec3i>& geometries, int sets) {
+    FramePool& pool = framePool();
+    std::vector<cv::Mat> held;
+    for (int set = 0; set < sets; set++) {
+        for (const cv::Vec3i& geometry : geometries) {
+            held.push_back(pool.acquire(geometry[0], geometry[1], geometry[2]));
+        }
+    }
+    return held.size();
+}
+
+// Allocates the pooled buffers the mode's first frame will acquire, so the
+// switch pays for them on the calling thread instead of in that frame
+static void warmRenderMode(const PipelineContext& pipeline, RenderMode mode) {
+    const uint32_t geometry = pipeline.ingestGeometry.load(std::memory_order_relaxed);
+    if (geometry == 0) {
+        return;  // nothing ingested yet; the first frame allocates either way
+    }
+    const cv::Size full(static_cast<int>(geometry >> 16), static_cast<int>(geometry & 0xffff));
+    const size_t warmed = warmFrameBuffers(frameBufferGeometries(mode, full), 1);
+    LOGI("🔄 Warmed %zu buffers for render mode %d (%dx%d)", warmed, mode, full.width, full.height);
+}
+
+// Sets of a frame's buffers allocated ahead of a resolution switch: the
+// published triple buffer plus the frame in progress
+static const int kSwitchWarmSets = 3;
+
+static cv::Size geometrySize(uint32_t geometry) {
+    return cv::Size(static_cast<int>(geometry >> 16), static_cast<int>(geometry & 0xffff));
+}
+
+// Live resolution switch, step 1 (before frames of the new size arrive, off
+// the frame path): the new size's pooled buffers, and every GL thread's
+// textures and edge targets beside the current ones (prepareFrameSizeGL)
+void prepareIngestSize(PipelineContext* destination, int width, int height) {
+    PipelineContext& pipeline = destination ? *destination : defaultPipeline;
+    const cv::Size next(width, height);
+    const cv::Size current = geometrySize(pipeline.ingestGeometry.load(std::memory_order_relaxed));
+    if (width <= 0 || height <= 0 || next == current) {
+        return;
+    }
+    const size_t warmed = warmFrameBuffers(frameBufferGeometries(activeRenderMode(pipeline), next), kSwitchWarmSets);
+    if (current.area() > 0) {
+        prepareFrameSizeGL(current.width, current.height, width, height);
+    }
+    LOGI("🔄 Prepared frame size %dx%d (from %dx%d): %zu buffers", width, height, current.width, current.height,
+         warmed);
+}
+
+// Frame boundary. Step 2 of a switch is simply the first frame of the new
+// size, which finds its buffers ready; step 3 retires the old size's buffers,
+// freed as the frames still holding them are replaced.
+static void noteIngestGeometry(PipelineContext& pipeline, const cv::Size& size) {
+    const uint32_t geometry = static_cast<uint32_t>(size.width) << 16 | static_cast<uint32_t>(size.height & 0xffff);
+    if (pipeline.ingestGeometry.load(std::memory_order_relaxed) == geometry) {
+        return;
+    }
+    const uint32_t previous = pipeline.ingestGeometry.exchange(geometry, std::memory_order_relaxed);
+    if (previous == 0 || previous == geometry) {
+        return;
+    }
+    const RenderMode mode = activeRenderMode(pipeline);
+    const std::vector<cv::Vec3i> kept = frameBufferGeometries(mode, size);
+    for (const cv::Vec3i& old : frameBufferGeometries(mode, geometrySize(previous))) {
+        if (std::find(kept.begin(), kept.end(), old) == kept.end()) {
+            framePool().retire(old[0], old[1], old[2]);
+        }
+    }
+    LOGI("🔄 Frame size switched %dx%d -> %dx%d", geometrySize(previous).width, geometrySize(previous).height,
+         size.width, size.height);
+}
+
+// HEATMAP (nativeSetHeatmap): the share of its heat a pixel keeps per new
+// edge frame and the gain of the colormap. Entering the mode bumps the
+// generation, which the renderer answers with a cleared heat texture.
+static std::atomic<float> heatmapDecay{0.9f};
+static std::atomic<float> heatmapGain{3.0f};
+static std::atomic<uint32_t> heatmapGeneration{0};
+
+// FOCUS_PEAK (nativeSetFocusPeaking): peaks start at sensitivity times the
+// frame's typical Sobel response, 4 * sqrt(variance of the Laplacian) from
+// the luma stats, so the threshold follows the scene's contrast; the color
+// is ARGB
+static std::atomic<float> focusPeakSensitivity{2.0f};
+static std::atomic<uint32_t> focusPeakColor{0xffff1a1a};
+
+// Stateful analysis restarts when its mode is entered: the last tracked
+// frame, the learned background and the held quadrilateral may be long gone
+static void enterRenderMode(RenderMode mode) {
+    hasTrackedRoi.store(false);
+    if (mode == TRACKING) {
+        pointTracker().reset();
+    } else if (mode == MOTION) {
+        motionDetector().reset();
+    } else if (mode == DOCUMENT) {
+        documentDetector().reset();
+    } else if (mode == SEGMENTS) {
+        segmentDetector().reset();
+    } else if (mode == MARKERS) {
+        markerDetector().reset();
+    } else if (mode == CODES) {
+        codeScanner().reset();
+    } else if (mode == FACES) {
+        faceDetector().reset();
+    } else if (mode == MOSAIC) {
+        mosaicBuilder().reset();
+    } else if (mode == TRACK_OBJECT) {
+        objectTracker().stop();
+    } else if (mode == PEOPLE) {
+        peopleDetector().reset();
+    } else if (mode == TEXT_REGIONS) {
+        textRegionDetector().reset();
+    } else if (mode == ODOMETRY) {
+        visualOdometry().reset();
+    } else if (mode == HEATMAP) {
+        heatmapGeneration.fetch_add(1, std::memory_order_relaxed);
+    } else if (mode == STABILIZE) {
+        videoStabilizer().reset();
+    }
+}
+
+// Frame boundary: the mode this frame is built for, read once. The first
+// frame to observe a newer version resets the entered mode's detectors on the
+// processing thread, between frames, instead of racing the one in flight.
+static RenderMode beginFrameRenderMode(PipelineContext& pipeline) {
+    const uint32_t state = pipeline.renderModeState.load(std::memory_order_acquire);
+    uint32_t seen = pipeline.frameModeState.load(std::memory_order_relaxed);
+    // The version dominates the difference, so a thread holding an older
+    // snapshot than the one already applied never rolls it back
+    while (seen != state && static_cast<int32_t>(state - seen) > 0) {
+        if (pipeline.frameModeState.compare_exchange_weak(seen, state, std::memory_order_acq_rel)) {
+            enterRenderMode(modeOf(state));
+            break;
+        }
+    }
+    return modeOf(state);
+}
+
+// Buffers first, so frames already built for the new mode find them; the
+// detectors restart at the processing thread's next frame boundary
+static void switchRenderMode(PipelineContext& pipeline, RenderMode mode) {
+    warmRenderMode(pipeline, mode);
+    uint32_t state = pipeline.renderModeState.load(std::memory_order_relaxed);
+    while (!pipeline.renderModeState.compare_exchange_weak(state, ((state >> 8) + 1) << 8 | static_cast<uint32_t>(mode),
+                                                           std::memory_order_acq_rel)) {
+    }
+}
+
+// Optional Java Runnable run after every publish, so GLRenderer can use
+// RENDERMODE_WHEN_DIRTY (typically a runnable calling requestRender())
+static std::mutex frameListenerMutex;
+static jobject frameListener = nullptr;   // global ref
+static std::atomic<bool> hasFrameListener{false};
+
+static void setFrameListener(JNIEnv* env, jobject listener) {
+    std::lock_guard<std::mutex> lock(frameListenerMutex);
+    if (frameListener) {
+        env->DeleteGlobalRef(frameListener);
+        frameListener = nullptr;
+    }
+    if (listener) {
+        if (!jniCache().runnableRun) {
+            LOGE("❌ Runnable.run() was not resolved at load; frame listener ignored");
+        } else {
+            frameListener = env->NewGlobalRef(listener);
+        }
+    }
+    hasFrameListener.store(frameListener != nullptr, std::memory_order_release);
+    LOGI("🔄 Frame listener %s", frameListener ? "set" : "cleared");
+}
+
+static void notifyFrameListener() {
+    if (!hasFrameListener.load(std::memory_order_acquire)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(frameListenerMutex);
+    JavaVM* javaVm = jniCache().vm;
+    if (!frameListener || !javaVm) {
+        return;
+    }
+    JNIEnv* env = nullptr;
+    if (javaVm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) != JNI_OK) {
+        // Camera and worker threads are attached once and stay attached
+        if (javaVm->AttachCurrentThreadAsDaemon(&env, nullptr) != JNI_OK) {
+            LOGE_RATELIMITED("❌ Could not attach thread for frame listener");
+            return;
+        }
+    }
+    env->CallVoidMethod(frameListener, jniCache().runnableRun);
+    if (env->ExceptionCheck()) {
+        env->ExceptionDescribe();
+        env->ExceptionClear();
+    }
+}
+
+// Publishes a completed frame set; empty Mats mean "not computed this frame"
+static void publishFrame(PipelineContext& pipeline, const PublishedFrame& update) {
+    {
+        ScopedStageTimer timer(Stage::PUBLISH);
+        std::lock_guard<std::mutex> lock(pipeline.publishMutex);
+        PublishedFrame& lastPublished = pipeline.lastPublished;
+        if (!update.raw.empty()) {
+            lastPublished.raw = update.raw;
+        }
+        if (!update.grayscale.empty()) {
+            lastPublished.grayscale = update.grayscale;
+            lastPublished.splitEdges = update.splitEdges;  // only ever for its own gray
+        }
+        if (!update.processed.empty()) {
+            lastPublished.processed = update.processed;
+            lastPublished.processedBitmapWidth = update.processedBitmapWidth;
+            lastPublished.processedResult = update.processedResult;
+            lastPublished.processedBase = update.processedBase;
+            lastPublished.processedChanges = update.processedChanges;
+        }
+        if (!update.yuvLuma.empty() && !update.yuvChroma.empty()) {
+            lastPublished.yuvLuma = update.yuvLuma;
+            lastPublished.yuvChroma = update.yuvChroma;
+        }
+        if (update.hasFeatures) {
+            lastPublished.features = update.features;
+            lastPublished.hasFeatures = true;
+        }
+        if (update.hasFlow) {
+            lastPublished.flow = update.flow;
+            lastPublished.hasFlow = true;
+        }
+        if (!update.motion.empty()) {
+            lastPublished.motion = update.motion;
+        }
+        if (update.hasLines) {
+            lastPublished.lines = update.lines;
+            lastPublished.hasLines = true;
+        }
+        if (update.hasSegments) {
+            lastPublished.segments = update.segments;
+            lastPublished.hasSegments = true;
+        }
+        if (update.hasMarkers) {
+            lastPublished.markers = update.markers;
+            lastPublished.markerStrips = update.markerStrips;
+            lastPublished.markerStripOffsets = update.markerStripOffsets;
+            lastPublished.hasMarkers = true;
+        }
+        if (update.hasCodes) {
+            lastPublished.codes = update.codes;
+            lastPublished.codeStrips = update.codeStrips;
+            lastPublished.codeStripOffsets = update.codeStripOffsets;
+            lastPublished.hasCodes = true;
+        }
+        if (update.hasFaces) {
+            lastPublished.faces = update.faces;
+            lastPublished.faceStrips = update.faceStrips;
+            lastPublished.faceStripOffsets = update.faceStripOffsets;
+            lastPublished.hasFaces = true;
+        }
+        if (update.hasMosaic) {
+            lastPublished.mosaic = update.mosaic;
+            lastPublished.mosaicOutline = update.mosaicOutline;
+            lastPublished.mosaicOutlineOffsets = update.mosaicOutlineOffsets;
+            lastPublished.hasMosaic = true;
+        }
+        if (update.hasTrackedObject) {
+            lastPublished.trackedObject = update.trackedObject;
+            lastPublished.trackedObjectOffsets = update.trackedObjectOffsets;
+            lastPublished.hasTrackedObject = true;
+        }
+        if (update.hasPeople) {
+            lastPublished.people = update.people;
+            lastPublished.peopleStrips = update.peopleStrips;
+            lastPublished.peopleStripOffsets = update.peopleStripOffsets;
+            lastPublished.hasPeople = true;
+        }
+        if (update.hasTextRegions) {
+            lastPublished.textRegions = update.textRegions;
+            lastPublished.textRegionStrips = update.textRegionStrips;
+            lastPublished.textRegionStripOffsets = update.textRegionStripOffsets;
+            lastPublished.hasTextRegions = true;
+        }
+        if (update.hasOdometry) {
+            lastPublished.odometryMatches = update.odometryMatches;
+            lastPublished.hasOdometry = true;
+        }
+        if (update.hasStabilization) {
+            lastPublished.stabilization = update.stabilization;
+            lastPublished.hasStabilization = true;
+        }
+        if (update.hasDocument) {
+            lastPublished.document = update.document;
+            lastPublished.documentHomography = update.documentHomography;
+            lastPublished.documentSize = update.documentSize;
+            lastPublished.hasDocument = true;
+        }
+        if (update.hasChamfer) {
+            lastPublished.edgeDistance = update.edgeDistance;
+            lastPublished.chamferMatches = update.chamferMatches;
+            lastPublished.chamferOutlines = update.chamferOutlines;
+            lastPublished.chamferOffsets = update.chamferOffsets;
+            lastPublished.hasChamfer = true;
+        }
+        if (update.hasEdgeComponents) {
+            lastPublished.edgeComponents = update.edgeComponents;
+            lastPublished.edgeComponentsTotal = update.edgeComponentsTotal;
+            lastPublished.hasEdgeComponents = true;
+        }
+        if (update.hasDepth) {
+            lastPublished.depth = update.depth;
+            lastPublished.hasDepth = true;
+        }
+        if (update.hasEdgeRecords) {
+            lastPublished.edgeRecords = update.edgeRecords;
+            lastPublished.edgeRecordsDropped = update.edgeRecordsDropped;
+            lastPublished.edgeRecordGrid = update.edgeRecordGrid;
+            lastPublished.edgeRecordRoi = update.processedRoi.empty() ? cv::Rect(cv::Point(), update.processedFrameSize)
+                                                                      : update.processedRoi;
+            lastPublished.hasEdgeRecords = true;
+        }
+        if (update.hasEdgePoints) {
+            lastPublished.edgePoints = update.edgePoints;
+            lastPublished.edgePointsDropped = update.edgePointsDropped;
+            lastPublished.edgePointGrid = update.edgePointGrid;
+            lastPublished.edgePointRoi = update.processedRoi.empty() ? cv::Rect(cv::Point(), update.processedFrameSize)
+                                                                     : update.processedRoi;
+            lastPublished.hasEdgePoints = true;
+        }
+        if (update.sharedEdges) {
+            lastPublished.sharedEdges = update.sharedEdges;
+        }
+        // Only ever for this update's own variant: an older one is uploaded instead
+        lastPublished.hardwareFrame = update.hardwareFrame;
+        lastPublished.hardwareFrameSource = update.hardwareFrameSource;
+        if (update.hasContours) {
+            lastPublished.contourPoints = update.contourPoints;
+            lastPublished.contourOffsets = update.contourOffsets;
+            lastPublished.hasContours = true;
+        }
+        if (!update.grayscale.empty() || !update.processed.empty()) {
+            lastPublished.processedRoi = update.processedRoi;
+            lastPublished.processedFrameSize = update.processedFrameSize;
+        }
+        lastPublished.rotation = update.rotation;
+        lastPublished.renderMode = update.renderMode;
+        lastPublished.modesBuilt = update.modesBuilt != 0 ? update.modesBuilt
+                                   : update.renderMode >= 0 ? 1u << update.renderMode : 0;
+        lastPublished.captureTimestampNs = update.captureTimestampNs;
+        if (update.captureTimestampNs > 0) {
+            metrics().recordStage(Stage::CAPTURE_TO_PUBLISH, (bootTimeNanos() - update.captureTimestampNs) / 1000);
+        }
+        lastPublished.sequence = pipeline.publishedSequence.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (&pipeline == &defaultPipeline) {
+            // Ends at the frame's first draw (drawPipelineFrame)
+            traceAsyncBegin("frame", static_cast<int32_t>(lastPublished.sequence));
+            traceCounter("frame_sequence", static_cast<int64_t>(lastPublished.sequence));
+            framePacing().onPublish(bootTimeNanos());
+        }
+        pipeline.publishedFrames.writeSlot() = lastPublished;
+        pipeline.publishedFrames.publish();
+
+        int historyDepth = frameHistoryDepth.load(std::memory_order_relaxed);
+        if (memoryDegradation.load(std::memory_order_relaxed) >= 1) {
+            historyDepth = std::min(historyDepth, kMemoryHistoryDepth);
+        }
+        if (!update.grayscale.empty() || historyDepth == 0) {
+            HistoryFrame past;
+            past.luma = update.grayscale;
+            past.edges = update.processed;
+            past.edgeBitmapWidth = update.processedBitmapWidth;
+            past.roi = update.processedRoi;
+            past.frameSize = update.processedFrameSize;
+            past.rotation = update.rotation;
+            past.captureTimestampNs = update.captureTimestampNs;
+            past.sequence = lastPublished.sequence;
+            pipeline.history.push(past, historyDepth, frameHistoryEdges.load(std::memory_order_relaxed));
+        }
+    }
+    if (&pipeline == &defaultPipeline) {
+        if (frameFanout().hasConsumers()) {
+            // One shared handle for every consumer, headers only; never blocks
+            auto frame = std::make_shared<FanoutFrame>();
+            frame->edges = update.processed;
+            frame->bitmapWidth = update.processedBitmapWidth;
+            frame->luma = update.grayscale;
+            frame->scaled = update.scaledLuma;
+            frame->roi = update.processedRoi;
+            frame->frameSize = update.processedFrameSize;
+            frame->rotation = update.rotation;
+            frame->captureTimestampNs = update.captureTimestampNs;
+            frame->sequence = pipeline.publishedSequence.load(std::memory_order_relaxed);
+            frameFanout().publish(frame);
+        }
+        if (!update.processed.empty()) {
+            sharedEdgeOutput().publish(update.processed, update.processedBitmapWidth, update.rotation,
+                                       update.captureTimestampNs);
+            edgeArchiver().offer(update.processed, update.processedBitmapWidth, update.captureTimestampNs);
+        }
+        if (renderScheduler().isRunning()) {
+            renderScheduler().onPublish(pipeline.publishedSequence.load(std::memory_order_relaxed));
+        } else {
+            notifyFrameListener();  // the listener belongs to the preview
+        }
+    }
+}
+
+// Edge maps the GPU backend computed, read back by the renderer a couple of
+// frames late, go to the sinks CPU edges reach through publishFrame (GL
+// thread; every sink only takes the Mat header)
+static void offerReadBackEdges(const cv::Mat& edges, const ReadbackFrame& frame) {
+    if (frameFanout().hasConsumers()) {
+        auto fanned = std::make_shared<FanoutFrame>();
+        fanned->edges = edges;
+        fanned->frameSize = edges.size();
+        fanned->rotation = frame.rotation;
+        fanned->captureTimestampNs = frame.captureTimestampNs;
+        fanned->sequence = frame.sequence;
+        frameFanout().publish(fanned);
+    }
+    sharedEdgeOutput().publish(edges, 0, frame.rotation, frame.captureTimestampNs);
+    edgeArchiver().offer(edges, 0, frame.captureTimestampNs);
+}
+
+// The renderer reads its edges back only while one of those sinks runs
+static void updateEdgeReadback() {
+    const bool wanted = edgeStreamer().isRunning() || edgeArchiver().isRunning() || sharedEdgeOutput().isRunning();
+    setEdgeReadbackConsumer(wanted ? &offerReadBackEdges : nullptr);
+}
+
+// Native-owned direct buffers handed to Java for zero-copy ingest
+static std::vector<cv::Mat> ingestBuffers;
+static std::mutex ingestBufferMutex;
+
+// Whether a frame in one of the ingest buffers is still being processed
+// (its Mat is referenced beyond ingestBuffers). Called with ingestBufferMutex held.
+static bool ingestBuffersInFlight() {
+    for (const cv::Mat& buffer : ingestBuffers) {
+        if (CV_XADD(&buffer.u->refcount, 0) > 1) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// What an ingest path hands to the pipeline before any color conversion: a view
+// of the Y plane (which already is the grayscale image) plus converters that
+// produce color only when a stage actually needs it.
+struct IngestFrame {
+    cv::Mat luma;
+    cv::Mat chroma;  // interleaved VU view (NV21 order), empty for other layouts
+    AHardwareBuffer* hardwareBuffer = nullptr;  // the camera image itself, see YuvPlanes
+    std::function<bool(cv::Mat&)> convertToBgr;
+    // Display-only raw layer: straight to RGBA; false = no one-pass path, use convertToBgr
+    std::function<bool(cv::Mat&)> convertToRgba;
+    int64_t timestampNs = 0;  // capture time, see captureTimestamp()
+    // P010 ingest: the 10-bit samples behind luma (CV_16SC1, 0..1023), or empty
+    cv::Mat luma10;
+};
+
+// Frames older than this when processing would start are dropped (0 = never)
+static std::atomic<int64_t> latencyBudgetNs{0};
+
+// A sensor timestamp further than this from now comes from a non-REALTIME
+// timestamp source and cannot be compared with CLOCK_BOOTTIME
+static const int64_t kMaxClockSkewNs = 10LL * 1000000000;
+
+// Capture time of a frame arriving now: the sensor timestamp when it is on
+// CLOCK_BOOTTIME, otherwise the arrival time
+static int64_t captureTimestamp(int64_t sensorNs) {
+    const int64_t now = bootTimeNanos();
+    if (sensorNs <= 0 || sensorNs > now || now - sensorNs > kMaxClockSkewNs) {
+        return now;
+    }
+    return sensorNs;
+}
+
+// True (and counted) when a frame is already over the latency budget: a
+// fresh frame matters more than working through a backlog
+static bool isStale(int64_t timestampNs) {
+    const int64_t budget = latencyBudgetNs.load(std::memory_order_relaxed);
+    if (budget <= 0 || timestampNs <= 0 || bootTimeNanos() - timestampNs <= budget) {
+        return false;
+    }
+    metrics().increment(Counter::FRAMES_STALE);
+    return true;
+}
+
+// Deadline of a frame for the stages that check one (frame_deadline.h):
+// capture time plus the latency budget, 0 (none) without a budget
+static int64_t frameDeadlineNs(int64_t timestampNs) {
+    const int64_t budget = latencyBudgetNs.load(std::memory_order_relaxed);
+    return budget > 0 && timestampNs > 0 ? timestampNs + budget : 0;
+}
+
+// Set on the thread running nativeWarmup: its synthetic frames are never
+// skipped by, nor reported to, the quality governor
+static thread_local bool warmingUp = false;
+
+// Frames the quality governor's current level skips (counted)
+static bool governorSkips() {
+    if (warmingUp || !qualityGovernor().shouldSkip()) {
+        return false;
+    }
+    metrics().increment(Counter::FRAMES_GOVERNOR_SKIPPED);
+    return true;
+}
+
+// Between frames of half-rate processing (motion_compensation.h), counted:
+// only their motion against the last processed frame is measured
+static bool halfRateSkips(const PipelineContext& pipeline, const cv::Mat& luma, int64_t timestampNs) {
+    if (warmingUp || &pipeline != &defaultPipeline || !motionCompensator().enabled()) {
+        return false;
+    }
+    ScopedStageTimer timer(Stage::MOTION_ESTIMATE);
+    if (motionCompensator().admit(luma, timestampNs)) {
+        return false;
+    }
+    metrics().increment(Counter::FRAMES_MOTION_COMPENSATED);
+    // No publish: the same edges are drawn again under the new warp
+    if (renderScheduler().isRunning()) {
+        renderScheduler().onRedraw();
+    } else {
+        notifyFrameListener();
+    }
+    return true;
+}
+
+// A frame halfRateSkips let through passed every later gate and is processed
+// as captured (not a held freeze frame): the frames between measure against it
+static void commitHalfRateReference(const PipelineContext& pipeline, bool held, int64_t timestampNs) {
+    if (!warmingUp && &pipeline == &defaultPipeline && !held && motionCompensator().enabled()) {
+        motionCompensator().commitReference(timestampNs);
+    }
+}
+
+// Set while this thread processes a frame captured mid focus or exposure
+// change under the CHEAPEN policy: its edges take FAST_EDGES
+static thread_local bool unsettledCapture = false;
+
+class UnsettledCaptureScope {
+public:
+    explicit UnsettledCaptureScope(bool unsettled) : previous(unsettledCapture) { unsettledCapture = unsettled; }
+    ~UnsettledCaptureScope() { unsettledCapture = previous; }
+
+    UnsettledCaptureScope(const UnsettledCaptureScope&) = delete;
+    UnsettledCaptureScope& operator=(const UnsettledCaptureScope&) = delete;
+
+private:
+    bool previous;
+};
+
+// Capture metadata policy for one arriving frame of the default pipeline
+// (capture_metadata.h); frames that compute no edges are always processed,
+// so the raw feed never freezes
+static CaptureMetadataGate::Decision captureDecision(const PipelineContext& pipeline, int64_t timestampNs,
+                                                     unsigned variants) {
+    if (warmingUp || &pipeline != &defaultPipeline || !(variants & (kEdgeMapVariants | VARIANT_SHARED_EDGES))) {
+        return CaptureMetadataGate::PROCESS;
+    }
+    return captureMetadataGate().decide(timestampNs);
+}
+
+// Reports the processing time of the enclosing scope to the quality governor,
+// and the governor's and thermal state to the session report
+class GovernorSample {
+public:
+    GovernorSample() : start(monotonicMicros()) {}
+    ~GovernorSample() {
+        if (!warmingUp) {
+            qualityGovernor().onFrame(monotonicMicros() - start);
+            sessionRecorder().onFrame();
+        }
+    }
+
+    GovernorSample(const GovernorSample&) = delete;
+    GovernorSample& operator=(const GovernorSample&) = delete;
+
+private:
+    int64_t start;
+};
+
+// Resizes a single-channel frame to the processing resolution into a pooled
+// buffer; returns an empty Mat when it already is at that size. INTER_AREA
+// averages each source block once (OpenCV has a dedicated path for integer
+// factors), so 1/2 and 1/4 cost a single pass over the input.
+static cv::Mat downscaleForProcessing(const cv::Mat& luma) {
+    cv::Size size = processingSize(luma.size());
+    if (size == luma.size()) {
+        return cv::Mat();
+    }
+    ScopedStageTimer timer(Stage::DOWNSCALE);
+    cv::Mat scaled = framePool().acquire(size.height, size.width, CV_8UC1);
+    cv::resize(luma, scaled, size, 0, 0, cv::INTER_AREA);
+    return scaled;
+}
+
+// Lens undistortion of the processed luma (LensUndistortion::Mode::CPU) into a
+// pooled buffer, with the maps precomputed for its size; empty when off, not
+// calibrated, or for an ROI, which the whole-frame maps do not describe
+static cv::Mat undistortForProcessing(const cv::Mat& luma, const cv::Rect& roi) {
+    LensUndistortion& undistortion = lensUndistortion();
+    if (undistortion.mode() != LensUndistortion::Mode::CPU || !roi.empty()) {
+        return cv::Mat();
+    }
+    ScopedStageTimer timer(Stage::UNDISTORT);
+    cv::Mat undistorted = framePool().acquire(luma.rows, luma.cols, CV_8UC1);
+    try {
+        if (undistortion.remap(luma, undistorted)) {
+            return undistorted;
+        }
+    } catch (const cv::Exception& e) {
+        LOGE_RATELIMITED("❌ Undistortion failed: %s", e.what());
+    }
+    return cv::Mat();
+}
+
+// Temporal denoise of the processed luma (nativeSetTemporalDenoise) into a
+// pooled buffer that is also the next frame's history; empty when off
+static cv::Mat denoiseForProcessing(const cv::Mat& luma, const cv::Rect& roi) {
+    TemporalDenoiser& denoiser = temporalDenoiser();
+    if (!denoiser.params().enabled) {
+        return cv::Mat();
+    }
+    ScopedStageTimer timer(Stage::DENOISE);
+    return denoiser.filter(luma, roi);
+}
+
+// Contrast normalization of the processed luma before edges (nativeSetClahe)
+static std::atomic<bool> claheEnabled{false};
+static std::atomic<float> claheClipLimit{2.0f};
+static std::atomic<int> claheTiles{8};
+
+// Tiled CLAHE of the processed luma into a pooled buffer; empty when off
+static cv::Mat equalizeForProcessing(const cv::Mat& luma) {
+    if (!claheEnabled.load(std::memory_order_relaxed) || luma.empty()) {
+        return cv::Mat();
+    }
+    ScopedStageTimer timer(Stage::CLAHE);
+    cv::Mat equalized = framePool().acquire(luma.rows, luma.cols, CV_8UC1);
+    try {
+        tiledClahe(luma, equalized, claheClipLimit.load(std::memory_order_relaxed),
+                   claheTiles.load(std::memory_order_relaxed));
+        return equalized;
+    } catch (const cv::Exception& e) {
+        LOGE_RATELIMITED("❌ CLAHE failed: %s", e.what());
+    }
+    return cv::Mat();
+}
+
+// The published edges variant: the configured filter graph, otherwise the
+// G-API blur + Canny or plain Canny (incremental when enabled), blended with
+// the latest learned edges on the DNN backend. Graph output may be single- or
+// 3-channel.
+// Records per edge pixel next to the CPU Canny map (nativeSetEdgeRecords); 0 = off
+static std::atomic<int> edgeRecordCapacity{0};
+static const int kMaxEdgeRecords = 1 << 20;
+
+// Canny with edge records into a pooled list of the configured capacity
+static void detectRecordedEdges(const cv::Mat& gray, cv::Mat& edges, PublishedFrame& update) {
+    const int capacity = edgeRecordCapacity.load(std::memory_order_relaxed);
+    cv::Mat records = framePool().acquire(capacity, 1, CV_16UC4);
+    EdgeRecordSink sink;
+    sink.records = reinterpret_cast<EdgeRecord*>(records.data);
+    sink.capacity = capacity;
+    detectEdgesWithRecords(gray, edges, sink);
+    if (sink.dropped > 0) {
+        LOGW_RATELIMITED("⚠️ %d edge pixels past the %d edge record capacity", sink.dropped, capacity);
+    }
+    update.edgeRecords = records.rowRange(0, sink.count);
+    update.edgeRecordsDropped = sink.dropped;
+    update.edgeRecordGrid = gray.size();
+    update.hasEdgeRecords = true;
+}
+
+// How many published frames every pipeline's history keeps (0..8, 0 = off)
+// and whether their edge maps too; the grayscale variant is then built for
+// every frame. The frames are the published buffers themselves, kept out of
+// the frame pool until they leave the history.
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetFrameHistory(JNIEnv *env, jclass clazz, jint depth,
+                                                                     jboolean keepEdges) {
+    if (depth < 0 || depth > FrameHistory::kMaxDepth) {
+        LOGE("❌ Invalid frame history depth: %d", depth);
+        return JNI_FALSE;
+    }
+    frameHistoryEdges.store(keepEdges == JNI_TRUE, std::memory_order_relaxed);
+    frameHistoryDepth.store(depth, std::memory_order_relaxed);
+    if (depth == 0) {
+        defaultPipeline.history.clear();  // other pipelines drop theirs at their next publish
+    }
+    LOGI("🔄 Frame history: %d frames%s", depth, keepEdges == JNI_TRUE ? " with edges" : "");
+    return JNI_TRUE;
+}
+
+// A pipeline's history, newest first, 6 longs per frame: [sequence, capture
+// timestamp (ns), luma width << 16 | height, rotation, edges kept (0/1),
+// frame width << 16 | height]
+extern "C"
+JNIEXPORT jlongArray JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetFrameHistory(JNIEnv *env, jclass clazz, jlong handle) {
+    const FrameHistory& history = pipelineFor(handle).history;
+    const int kValuesPerFrame = 6;
+    jlong values[FrameHistory::kMaxDepth * kValuesPerFrame];
+    int frames = 0;
+    HistoryFrame past;
+    while (frames < FrameHistory::kMaxDepth && history.at(frames, past)) {
+        jlong* entry = values + frames * kValuesPerFrame;
+        entry[0] = static_cast<jlong>(past.sequence);
+        entry[1] = past.captureTimestampNs;
+        entry[2] = static_cast<jlong>(past.luma.cols) << 16 | past.luma.rows;
+        entry[3] = past.rotation;
+        entry[4] = past.edges.empty() ? 0 : 1;
+        entry[5] = static_cast<jlong>(past.frameSize.width) << 16 | past.frameSize.height;
+        frames++;
+    }
+    jlongArray result = env->NewLongArray(frames * kValuesPerFrame);
+    if (result && frames > 0) {
+        env->SetLongArrayRegion(result, 0, frames * kValuesPerFrame, values);
+    }
+    return result;
+}
+
+// Copies the luma of the frame `ago` publishes back (0 = newest) from a
+// pipeline's history into a direct buffer, rows packed; returns its sequence,
+// 0 when the history is not that deep, -1 when the buffer is too small
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeCopyHistoryLuma(JNIEnv *env, jclass clazz, jlong handle, jint ago,
+                                                                     jobject buffer) {
+    HistoryFrame past;
+    if (!pipelineFor(handle).history.at(ago, past) || past.luma.empty()) {
+        return 0;
+    }
+    auto* out = static_cast<uint8_t*>(buffer ? env->GetDirectBufferAddress(buffer) : nullptr);
+    if (!out || env->GetDirectBufferCapacity(buffer) < static_cast<jlong>(past.luma.total())) {
+        return -1;
+    }
+    cv::Mat packed(past.luma.size(), CV_8UC1, out);
+    past.luma.copyTo(packed);
+    return static_cast<jlong>(past.sequence);
+}
+
+// Pyramid levels MULTISCALE_EDGES fuses (2 or 3, nativeSetMultiscaleEdges)
+static std::atomic<int> multiscaleLevels{2};
+
+// FAST_EDGES instead of Canny: picked with nativeSetCannyBackend, or by the
+// quality governor's gradient-only levels, the stall watchdog and frames of
+// an unsettled capture
+static bool fastEdgesActive() {
+    return activeCannyBackend() == CannyBackend::GRADIENT || qualityGovernor().current().gradientOnly ||
+           stallWatchdog().level() != StallWatchdog::NORMAL || unsettledCapture;
+}
+
+// Sobel derivatives of the luma this thread's last Canny ran on, when the
+// backend exposed them (the G-API graph) and PEOPLE is built: HOG takes them
+// instead of differentiating the luma again. Empty otherwise.
+static thread_local cv::Mat frameGradX;
+static thread_local cv::Mat frameGradY;
+
+// The G-API graph's derivatives land in pooled buffers of their own when
+// PEOPLE will read them this frame
+static bool runGapiEdges(const cv::Mat& gray, cv::Mat& edges, const PublishedFrame* update) {
+    if (!update || !(update->modesBuilt >> PEOPLE & 1)) {
+        return gapiEdgePipeline().run(gray, edges);
+    }
+    FramePool& pool = framePool();
+    cv::Mat gradX = pool.acquire(gray.rows, gray.cols, CV_16SC1);
+    cv::Mat gradY = pool.acquire(gray.rows, gray.cols, CV_16SC1);
+    if (!gapiEdgePipeline().run(gray, edges, &gradX, &gradY)) {
+        return false;
+    }
+    frameGradX = gradX;
+    frameGradY = gradY;
+    return true;
+}
+
+// COLOR_EDGES: the VU plane matching the luma the next pipelineEdges call
+// gets, at half its resolution (cannyU8Color); set by the frame's producer,
+// taken by that call. Empty when the frame has no chroma (other YUV
+// layouts), and the mode falls back to luma Canny.
+static thread_local cv::Mat frameChroma;
+
+// P010 ingest: the 10-bit luma (CV_16SC1) the gray of the next pipelineEdges
+// call was narrowed from, cropped and scaled the same way; set and taken
+// like frameChroma. Empty when the gray went through a filter the 10-bit
+// samples did not.
+static thread_local cv::Mat frameLuma10;
+
+// What the incremental detector changed in the edges the last pipelineEdges
+// call returned (result 0: it did not run); taken by storeEdgeChanges
+static thread_local IncrementalEdgeDetector::Changes frameEdgeChanges;
+
+// NV21's VU plane cut to the processing ROI and, at a reduced processing
+// resolution, resized along with the luma
+static cv::Mat chromaForLuma(const cv::Mat& chroma, const cv::Rect& roi, const cv::Size& lumaSize) {
+    if (chroma.empty() || chroma.type() != CV_8UC2) {
+        return cv::Mat();
+    }
+    cv::Rect half(0, 0, chroma.cols, chroma.rows);
+    if (!roi.empty()) {
+        half &= cv::Rect(roi.x / 2, roi.y / 2, (roi.width + 1) / 2, (roi.height + 1) / 2);
+    }
+    const cv::Mat view = chroma(half);
+    const cv::Size target((lumaSize.width + 1) / 2, (lumaSize.height + 1) / 2);
+    if (view.size() == target) {
+        return view;
+    }
+    cv::Mat resized = framePool().acquire(target.height, target.width, CV_8UC2);
+    cv::resize(view, resized, target, 0, 0, cv::INTER_AREA);
+    return resized;
+}
+
+// The 10-bit luma cut to the processing ROI and, at a reduced processing
+// resolution, resized the way downscaleForProcessing resizes the gray
+static cv::Mat luma10ForGray(const cv::Mat& luma10, const cv::Rect& roi, const cv::Size& graySize) {
+    const cv::Mat view = roi.empty() ? luma10 : luma10(roi);
+    if (view.size() == graySize) {
+        return view;
+    }
+    cv::Mat resized = framePool().acquire(graySize.height, graySize.width, CV_16SC1);
+    cv::resize(view, resized, graySize, 0, 0, cv::INTER_AREA);
+    return resized;
+}
+
+// The same from a BGR frame: its Cr and Cb (V and U) at half the luma's size
+static cv::Mat chromaFromBgr(const cv::Mat& bgr, const cv::Size& lumaSize) {
+    static thread_local cv::Mat ycrcb = persistentMat();
+    static thread_local cv::Mat reduced = persistentMat();
+    const cv::Size target((lumaSize.width + 1) / 2, (lumaSize.height + 1) / 2);
+    cv::resize(bgr, reduced, target, 0, 0, cv::INTER_AREA);
+    cv::cvtColor(reduced, ycrcb, cv::COLOR_BGR2YCrCb);
+    cv::Mat vu = framePool().acquire(target.height, target.width, CV_8UC2);
+    const int fromTo[] = {1, 0, 2, 1};
+    cv::mixChannels(&ycrcb, 1, &vu, 1, fromTo, 2);
+    return vu;
+}
+
+// update: where edge records go when they are on (null: never recorded)
+static cv::Mat pipelineEdges(const cv::Mat& gray, PublishedFrame* update = nullptr) {
+    FramePool& pool = framePool();
+    frameGradX.release();
+    frameGradY.release();
+    cv::Mat chroma;
+    std::swap(chroma, frameChroma);  // this frame's only
+    cv::Mat luma10;
+    std::swap(luma10, frameLuma10);
+    frameEdgeChanges.result = 0;
+    FilterGraph& graph = filterGraph();
+    stallWatchdog().stageEntered(Stage::CANNY);
+    if (!graph.empty() && stallWatchdog().level() == StallWatchdog::NORMAL) {
+        int type = graph.outputType(gray.type());
+        if (type >= 0) {
+            cv::Mat output = pool.acquire(gray.rows, gray.cols, type);
+            if (graph.run(gray, output)) {
+                return output;
+            }
+        }
+        LOGE_RATELIMITED("❌ Filter graph '%s' cannot run on luma, using Canny", graph.config().c_str());
+    }
+    cv::Mat edges = pool.acquire(gray.rows, gray.cols, CV_8UC1);
+    if (fastEdgesActive()) {
+        detectGradientEdges(gray, edges);
+        return edges;
+    }
+    if (update && update->renderMode == MULTISCALE_EDGES) {
+        detectMultiscaleEdges(gray, edges, multiscaleLevels.load(std::memory_order_relaxed));
+        return edges;
+    }
+    if (update && update->renderMode == COLOR_EDGES &&
+        chroma.size() == cv::Size((gray.cols + 1) / 2, (gray.rows + 1) / 2)) {
+        detectColorEdges(gray, chroma, edges);
+        return edges;
+    }
+    // A held frame reruns only the Canny stages a setting invalidated
+    if (update && freezeFrame().edges(gray, edges)) {
+        return edges;
+    }
+    // A/B comparison replaces the edge backend while it runs
+    if (backendComparison().detect(gray, edges)) {
+        updateEdgeThresholds(gray);
+        return edges;
+    }
+    // P010 ingest on the CPU backend: Canny on the 10-bit samples. Edge
+    // records come from the in-house kernel's 8-bit gradients, so a frame
+    // that records them stays on its path.
+    if (!luma10.empty() && luma10.size() == gray.size() &&
+        edgeBackend.load(std::memory_order_relaxed) == EDGE_BACKEND_CPU &&
+        !(update && edgeRecordCapacity.load(std::memory_order_relaxed) > 0)) {
+        detectEdges10(luma10, gray, edges);
+        return edges;
+    }
+    if (edgeBackend.load(std::memory_order_relaxed) == EDGE_BACKEND_OPENCL && detectEdgesOcl(gray, edges)) {
+        return edges;
+    }
+    // The blend modifies edges, which the incremental detector keeps as its cache
+    const bool dnn = edgeBackend.load(std::memory_order_relaxed) == EDGE_BACKEND_DNN && dnnEdgeDetector().ready();
+    if (update && edgeRecordCapacity.load(std::memory_order_relaxed) > 0) {
+        detectRecordedEdges(gray, edges, *update);  // whole frame: records need every gradient
+    } else if (gapiPipeline.load(std::memory_order_relaxed) && runGapiEdges(gray, edges, update)) {
+        updateEdgeThresholds(gray);
+    } else if (incrementalEdges.load(std::memory_order_relaxed) && !dnn) {
+        incrementalEdgeDetector().detect(gray, edges, update ? &frameEdgeChanges : nullptr);
+    } else if (!detectEdgesWithin(gray, edges, frameDeadline())) {
+        return cv::Mat();  // past the frame's deadline: the last published edges stay
+    }
+    if (dnn) {
+        // The smallest shared pyramid level covering the network input: less
+        // to copy, and blobFromImage's resize starts from a filtered image.
+        // A frame past its deadline leaves the network its previous input.
+        const cv::Size input = dnnEdgeDetector().idleInputSize();
+        if (!input.empty() && !deadlineAborts(frameDeadline())) {
+            PyramidCache& pyramids = pyramidCache();
+            dnnEdgeDetector().submit(pyramids.covers(gray) ? pyramids.level(pyramids.levelAtLeast(input)) : gray);
+        }
+        dnnEdgeDetector().blendLatest(edges);
+    }
+    return edges;
+}
+
+// Maps the first count pixel positions of points, taken on the (ROI, possibly
+// downscaled) luma, to normalized coordinates of the whole frame so the
+// renderer can place them over any raw layer
+static void toFrameCoordinates(cv::Mat& points, int count, const cv::Size& lumaSize, const cv::Rect& roi,
+                               const cv::Size& frameSize) {
+    const cv::Rect area = roi.empty() ? cv::Rect(0, 0, frameSize.width, frameSize.height) : roi;
+    const float scaleX = static_cast<float>(area.width) / lumaSize.width;
+    const float scaleY = static_cast<float>(area.height) / lumaSize.height;
+    for (int i = 0; i < count; i++) {
+        cv::Vec2f& p = points.at<cv::Vec2f>(i);
+        p[0] = (area.x + (p[0] + 0.5f) * scaleX) / frameSize.width;
+        p[1] = (area.y + (p[1] + 0.5f) * scaleY) / frameSize.height;
+    }
+}
+
+// Keypoints of the processed luma into update. The pooled buffer has the
+// detector's full capacity, so its geometry stays fixed and only a row range
+// is published.
+static void storeFeatures(const cv::Mat& luma, const cv::Rect& roi, const cv::Size& frameSize,
+                          PublishedFrame& update) {
+    ScopedStageTimer timer(Stage::FEATURES);
+    GridFeatureDetector& detector = featureDetector();
+    cv::Mat points = framePool().acquire(std::max(1, detector.capacity()), 1, CV_32FC2);
+    int count = 0;
+    try {
+        count = detector.detect(luma, points);
+    } catch (const cv::Exception& e) {
+        LOGE_RATELIMITED("❌ FAST detection failed: %s", e.what());
+    }
+    toFrameCoordinates(points, count, luma.size(), roi, frameSize);
+    update.features = points.rowRange(0, count);
+    update.hasFeatures = true;
+}
+
+// Flow vectors from the previous processed luma into update, as line pairs
+static void storeFlow(const cv::Mat& luma, const cv::Rect& roi, const cv::Size& frameSize,
+                      PublishedFrame& update) {
+    ScopedStageTimer timer(Stage::TRACKING);
+    PointTracker& tracker = pointTracker();
+    cv::Mat vectors = framePool().acquire(std::max(1, 2 * tracker.capacity()), 1, CV_32FC2);
+    int pairs = 0;
+    try {
+        pairs = tracker.track(luma, vectors);
+    } catch (const cv::Exception& e) {
+        LOGE_RATELIMITED("❌ Optical flow failed: %s", e.what());
+        tracker.reset();
+    }
+    toFrameCoordinates(vectors, 2 * pairs, luma.size(), roi, frameSize);
+    update.flow = vectors.rowRange(0, 2 * pairs);
+    update.hasFlow = true;
+}
+
+// Contours of a binary edge map into update: only the packed strips are
+// published, a few kilobytes instead of the raster
+static void storeContours(const cv::Mat& edges, const cv::Rect& roi, const cv::Size& frameSize,
+                          PublishedFrame& update) {
+    ScopedStageTimer timer(Stage::CONTOURS);
+    FramePool& pool = framePool();
+    cv::Mat points = pool.acquire(ContourExtractor::kMaxPoints, 1, CV_32FC2);
+    cv::Mat offsets = pool.acquire(ContourExtractor::kMaxStrips + 1, 1, CV_32SC1);
+    int strips = 0;
+    try {
+        strips = contourExtractor().extract(edges, points, offsets, frameDeadline());
+    } catch (const cv::Exception& e) {
+        LOGE_RATELIMITED("❌ Contour extraction failed: %s", e.what());
+        offsets.at<int>(0) = 0;
+    }
+    if (strips < 0) {
+        return;  // past the frame's deadline: the last published contours stay
+    }
+    const int count = offsets.at<int>(strips);
+    toFrameCoordinates(points, count, edges.size(), roi, frameSize);
+    update.contourPoints = points.rowRange(0, count);
+    update.contourOffsets = offsets.rowRange(0, strips + 1);
+    update.hasContours = true;
+}
+
+// Hough segments of a binary edge map into update, as line pairs
+static void storeLines(const cv::Mat& edges, const cv::Rect& roi, const cv::Size& frameSize,
+                       PublishedFrame& update) {
+    ScopedStageTimer timer(Stage::HOUGH);
+    cv::Mat lines = framePool().acquire(2 * LineDetector::kMaxLines, 1, CV_32FC2);
+    int count = 0;
+    try {
+        count = lineDetector().detect(edges, lines);
+    } catch (const cv::Exception& e) {
+        LOGE_RATELIMITED("❌ Hough line detection failed: %s", e.what());
+    }
+    toFrameCoordinates(lines, 2 * count, edges.size(), roi, frameSize);
+    update.lines = lines.rowRange(0, 2 * count);
+    update.hasLines = true;
+}
+
+// Offers the processed luma to the LSD thread and puts its newest segments
+// into update, as line pairs; they lag the frame by however long LSD takes
+static void storeSegments(const cv::Mat& luma, const cv::Rect& roi, const cv::Size& frameSize,
+                          PublishedFrame& update) {
+    SegmentDetector& detector = segmentDetector();
+    cv::Mat segments = framePool().acquire(2 * SegmentDetector::kMaxSegments, 1, CV_32FC2);
+    int count = 0;
+    try {
+        detector.submit(luma);
+        count = detector.latest(luma.size(), segments);
+    } catch (const cv::Exception& e) {
+        LOGE_RATELIMITED("❌ Segment hand-off failed: %s", e.what());
+    }
+    toFrameCoordinates(segments, 2 * count, luma.size(), roi, frameSize);
+    update.segments = segments.rowRange(0, 2 * count);
+    update.hasSegments = true;
+}
+
+// Markers of the processed luma into update: the records with their corners
+// in frame units, and the outlines as closed strips for the renderer
+static void storeMarkers(const cv::Mat& luma, const cv::Rect& roi, const cv::Size& frameSize,
+                         PublishedFrame& update) {
+    ScopedStageTimer timer(Stage::MARKERS);
+    const int kMax = MarkerDetector::kMaxMarkers;
+    MarkerRecord records[MarkerDetector::kMaxMarkers];
+    int count = 0;
+    try {
+        count = markerDetector().detect(luma, records, kMax);
+    } catch (const cv::Exception& e) {
+        LOGE_RATELIMITED("❌ Marker detection failed: %s", e.what());
+        markerDetector().reset();
+    }
+    FramePool& pool = framePool();
+    cv::Mat strips = pool.acquire(5 * kMax, 1, CV_32FC2);
+    cv::Mat offsets = pool.acquire(kMax + 1, 1, CV_32SC1);
+    cv::Mat table = pool.acquire(kMax, sizeof(MarkerRecord) / sizeof(int32_t), CV_32SC1);
+    for (int i = 0; i < count; i++) {
+        for (int j = 0; j < 5; j++) {
+            const float* corner = records[i].corners + 2 * (j % 4);
+            strips.at<cv::Point2f>(5 * i + j) = cv::Point2f(corner[0], corner[1]);
+        }
+    }
+    toFrameCoordinates(strips, 5 * count, luma.size(), roi, frameSize);
+    for (int i = 0; i <= count; i++) {
+        offsets.at<int>(i) = 5 * i;
+    }
+    for (int i = 0; i < count; i++) {
+        MarkerRecord& record = records[i];
+        for (int j = 0; j < 4; j++) {
+            const cv::Point2f& corner = strips.at<cv::Point2f>(5 * i + j);
+            record.corners[2 * j] = corner.x;
+            record.corners[2 * j + 1] = corner.y;
+        }
+        std::memcpy(table.ptr(i), &record, sizeof(MarkerRecord));
+    }
+    update.markers = table.rowRange(0, count);
+    update.markerStrips = strips.rowRange(0, 5 * count);
+    update.markerStripOffsets = offsets.rowRange(0, count + 1);
+    update.hasMarkers = true;
+}
+
+// Offers the processed luma to the code scanner and puts the newest decoded
+// codes into update, their outlines as closed strips; like the segments they
+// lag the frame by however long the scan took
+static void storeCodes(const cv::Mat& luma, const cv::Rect& roi, const cv::Size& frameSize,
+                       PublishedFrame& update) {
+    CodeScanner& scanner = codeScanner();
+    std::shared_ptr<const CodeScanResult> codes;
+    try {
+        scanner.offer(luma);
+        codes = scanner.latest();
+    } catch (const cv::Exception& e) {
+        LOGE_RATELIMITED("❌ Code scan hand-off failed: %s", e.what());
+    }
+    const int kMax = CodeScanner::kMaxCodes;
+    FramePool& pool = framePool();
+    cv::Mat strips = pool.acquire(5 * kMax, 1, CV_32FC2);
+    cv::Mat offsets = pool.acquire(kMax + 1, 1, CV_32SC1);
+    const int count = codes ? std::min(static_cast<int>(codes->corners.size()), kMax) : 0;
+    for (int i = 0; i < count; i++) {
+        const cv::Vec<float, 8>& corners = codes->corners[static_cast<size_t>(i)];
+        for (int j = 0; j < 5; j++) {
+            // Back to pixel centres of this luma, which toFrameCoordinates expects
+            strips.at<cv::Point2f>(5 * i + j) = cv::Point2f(corners[2 * (j % 4)] * luma.cols - 0.5f,
+                                                            corners[2 * (j % 4) + 1] * luma.rows - 0.5f);
+        }
+    }
+    toFrameCoordinates(strips, 5 * count, luma.size(), roi, frameSize);
+    for (int i = 0; i <= count; i++) {
+        offsets.at<int>(i) = 5 * i;
+    }
+    update.codes = codes;
+    update.codeStrips = strips.rowRange(0, 5 * count);
+    update.codeStripOffsets = offsets.rowRange(0, count + 1);
+    update.hasCodes = true;
+}
+
+// Tracks the faces into the processed luma (handing a detection off when one
+// is due) and puts their boxes into update, also as closed strips; the boxes
+// move every frame, new and lost faces appear with the next detection
+static void storeFaces(const cv::Mat& luma, const cv::Rect& roi, const cv::Size& frameSize, PublishedFrame& update) {
+    std::vector<FaceDetector::Face> found;
+    try {
+        faceDetector().update(luma, found);
+    } catch (const cv::Exception& e) {
+        LOGE_RATELIMITED("❌ Face tracking failed: %s", e.what());
+        found.clear();
+    }
+    const int kMax = FaceDetector::kMaxFaces;
+    FramePool& pool = framePool();
+    cv::Mat faces = pool.acquire(kMax, 5, CV_32FC1);
+    cv::Mat strips = pool.acquire(5 * kMax, 1, CV_32FC2);
+    cv::Mat offsets = pool.acquire(kMax + 1, 1, CV_32SC1);
+    const int count = std::min(static_cast<int>(found.size()), kMax);
+    for (int i = 0; i < count; i++) {
+        const cv::Rect2f& box = found[static_cast<size_t>(i)].box;
+        const cv::Point2f corners[4] = {box.tl(), cv::Point2f(box.x + box.width, box.y), box.br(),
+                                        cv::Point2f(box.x, box.y + box.height)};
+        for (int j = 0; j < 5; j++) {
+            // Back to pixel centres of this luma, which toFrameCoordinates expects
+            strips.at<cv::Point2f>(5 * i + j) = cv::Point2f(corners[j % 4].x * luma.cols - 0.5f,
+                                                            corners[j % 4].y * luma.rows - 0.5f);
+        }
+    }
+    toFrameCoordinates(strips, 5 * count, luma.size(), roi, frameSize);
+    for (int i = 0; i < count; i++) {
+        float* row = faces.ptr<float>(i);
+        row[0] = strips.at<cv::Point2f>(5 * i).x;
+        row[1] = strips.at<cv::Point2f>(5 * i).y;
+        row[2] = strips.at<cv::Point2f>(5 * i + 2).x;
+        row[3] = strips.at<cv::Point2f>(5 * i + 2).y;
+        row[4] = found[static_cast<size_t>(i)].score;
+    }
+    for (int i = 0; i <= count; i++) {
+        offsets.at<int>(i) = 5 * i;
+    }
+    update.faces = faces.rowRange(0, count);
+    update.faceStrips = strips.rowRange(0, 5 * count);
+    update.faceStripOffsets = offsets.rowRange(0, count + 1);
+    update.hasFaces = true;
+}
+
+// Registers the processed luma into the mosaic and puts the canvas after it
+// into update, with the frame's outline in 0..1 canvas units (none when the
+// frame could not be registered and the canvas stayed as it was)
+static void storeMosaic(const cv::Mat& luma, PublishedFrame& update) {
+    std::shared_ptr<const MosaicView> view;
+    std::vector<cv::Point2f> outline;
+    try {
+        mosaicBuilder().update(luma, view, outline);
+    } catch (const cv::Exception& e) {
+        LOGE_RATELIMITED("❌ Mosaic registration failed: %s", e.what());
+        outline.clear();
+    }
+    if (!view) {
+        return;
+    }
+    FramePool& pool = framePool();
+    cv::Mat strip = pool.acquire(5, 1, CV_32FC2);
+    cv::Mat offsets = pool.acquire(2, 1, CV_32SC1);
+    const int count = outline.size() == 5 ? 5 : 0;
+    for (int i = 0; i < count; i++) {
+        strip.at<cv::Point2f>(i) = cv::Point2f((outline[static_cast<size_t>(i)].x + 0.5f) / view->canvasSize.width,
+                                               (outline[static_cast<size_t>(i)].y + 0.5f) / view->canvasSize.height);
+    }
+    offsets.at<int>(0) = 0;
+    offsets.at<int>(1) = count;
+    update.mosaic = view;
+    update.mosaicOutline = strip.rowRange(0, count);
+    update.mosaicOutlineOffsets = offsets.rowRange(0, count ? 2 : 1);
+    update.hasMosaic = true;
+}
+
+// Follows the selected object through the whole frame (never the processing
+// ROI, which may itself follow the object) and puts its box into update as a
+// closed strip in 0..1 frame units. With edges in the box, the box plus a
+// margin becomes the next frame's processing ROI.
+static void storeTrackedObject(const cv::Mat& frame, PublishedFrame& update) {
+    const float kMargin = 0.25f;  // of the box size, on each side
+    cv::Rect2f box;
+    const bool tracking = objectTracker().update(frame, box);
+    if (tracking && trackedRoiEdges.load(std::memory_order_relaxed)) {
+        const float marginX = box.width * kMargin;
+        const float marginY = box.height * kMargin;
+        const cv::Rect region(cvFloor((box.x - marginX) * frame.cols), cvFloor((box.y - marginY) * frame.rows),
+                              cvCeil((box.width + 2 * marginX) * frame.cols),
+                              cvCeil((box.height + 2 * marginY) * frame.rows));
+        {
+            std::lock_guard<std::mutex> lock(roiMutex);
+            trackedRoi = region & cv::Rect(cv::Point(), frame.size());
+        }
+        hasTrackedRoi.store(true);
+    } else {
+        hasTrackedRoi.store(false);
+    }
+    FramePool& pool = framePool();
+    cv::Mat strip = pool.acquire(5, 1, CV_32FC2);
+    cv::Mat offsets = pool.acquire(2, 1, CV_32SC1);
+    const int count = tracking ? 5 : 0;
+    if (tracking) {
+        const cv::Point2f corners[4] = {box.tl(), cv::Point2f(box.x + box.width, box.y), box.br(),
+                                        cv::Point2f(box.x, box.y + box.height)};
+        for (int i = 0; i < 5; i++) {
+            strip.at<cv::Point2f>(i) = corners[i % 4];
+        }
+    }
+    offsets.at<int>(0) = 0;
+    offsets.at<int>(1) = count;
+    update.trackedObject = strip.rowRange(0, count);
+    update.trackedObjectOffsets = offsets.rowRange(0, count ? 2 : 1);
+    update.hasTrackedObject = true;
+}
+
+// People of the processed luma into update, with their boxes as closed
+// strips; between detections the held boxes are published again
+static void storePeople(const cv::Mat& luma, const cv::Rect& roi, const cv::Size& frameSize, PublishedFrame& update) {
+    std::vector<PeopleDetector::Person> found;
+    // The edge stage's derivatives, if it kept them for this very luma
+    const bool shared = frameGradX.size() == luma.size();
+    peopleDetector().update(luma, shared ? frameGradX : cv::Mat(), shared ? frameGradY : cv::Mat(), found);
+    frameGradX.release();
+    frameGradY.release();
+    const int kMax = PeopleDetector::kMaxPeople;
+    FramePool& pool = framePool();
+    cv::Mat people = pool.acquire(kMax, 5, CV_32FC1);
+    cv::Mat strips = pool.acquire(5 * kMax, 1, CV_32FC2);
+    cv::Mat offsets = pool.acquire(kMax + 1, 1, CV_32SC1);
+    const int count = std::min(static_cast<int>(found.size()), kMax);
+    for (int i = 0; i < count; i++) {
+        const cv::Rect2f& box = found[static_cast<size_t>(i)].box;
+        const cv::Point2f corners[4] = {box.tl(), cv::Point2f(box.x + box.width, box.y), box.br(),
+                                        cv::Point2f(box.x, box.y + box.height)};
+        for (int j = 0; j < 5; j++) {
+            // Back to pixel centres of this luma, which toFrameCoordinates expects
+            strips.at<cv::Point2f>(5 * i + j) = cv::Point2f(corners[j % 4].x * luma.cols - 0.5f,
+                                                            corners[j % 4].y * luma.rows - 0.5f);
+        }
+    }
+    toFrameCoordinates(strips, 5 * count, luma.size(), roi, frameSize);
+    for (int i = 0; i < count; i++) {
+        float* row = people.ptr<float>(i);
+        row[0] = strips.at<cv::Point2f>(5 * i).x;
+        row[1] = strips.at<cv::Point2f>(5 * i).y;
+        row[2] = strips.at<cv::Point2f>(5 * i + 2).x;
+        row[3] = strips.at<cv::Point2f>(5 * i + 2).y;
+        row[4] = found[static_cast<size_t>(i)].weight;
+    }
+    for (int i = 0; i <= count; i++) {
+        offsets.at<int>(i) = 5 * i;
+    }
+    update.people = people.rowRange(0, count);
+    update.peopleStrips = strips.rowRange(0, 5 * count);
+    update.peopleStripOffsets = offsets.rowRange(0, count + 1);
+    update.hasPeople = true;
+}
+
+// Text lines of the processed luma into update, with their boxes as closed
+// strips; between detections the held lines are published again
+static void storeTextRegions(const cv::Mat& luma, const cv::Rect& roi, const cv::Size& frameSize,
+                             PublishedFrame& update) {
+    std::vector<TextRegionDetector::TextRegion> found;
+    textRegionDetector().update(luma, found);
+    const int kMax = TextRegionDetector::kMaxRegions;
+    FramePool& pool = framePool();
+    cv::Mat regions = pool.acquire(kMax, 4, CV_32FC1);
+    cv::Mat strips = pool.acquire(5 * kMax, 1, CV_32FC2);
+    cv::Mat offsets = pool.acquire(kMax + 1, 1, CV_32SC1);
+    const int count = std::min(static_cast<int>(found.size()), kMax);
+    for (int i = 0; i < count; i++) {
+        const cv::Rect2f& box = found[static_cast<size_t>(i)].box;
+        const cv::Point2f corners[4] = {box.tl(), cv::Point2f(box.x + box.width, box.y), box.br(),
+                                        cv::Point2f(box.x, box.y + box.height)};
+        for (int j = 0; j < 5; j++) {
+            strips.at<cv::Point2f>(5 * i + j) = cv::Point2f(corners[j % 4].x * luma.cols - 0.5f,
+                                                            corners[j % 4].y * luma.rows - 0.5f);
+        }
+    }
+    toFrameCoordinates(strips, 5 * count, luma.size(), roi, frameSize);
+    for (int i = 0; i < count; i++) {
+        float* row = regions.ptr<float>(i);
+        row[0] = strips.at<cv::Point2f>(5 * i).x;
+        row[1] = strips.at<cv::Point2f>(5 * i).y;
+        row[2] = strips.at<cv::Point2f>(5 * i + 2).x;
+        row[3] = strips.at<cv::Point2f>(5 * i + 2).y;
+    }
+    for (int i = 0; i <= count; i++) {
+        offsets.at<int>(i) = 5 * i;
+    }
+    update.textRegions = regions.rowRange(0, count);
+    update.textRegionStrips = strips.rowRange(0, 5 * count);
+    update.textRegionStripOffsets = offsets.rowRange(0, count + 1);
+    update.hasTextRegions = true;
+}
+
+// ORB matches of the processed luma to the previous frame's into update, as
+// line pairs; the odometry also advances its pose estimate when due
+static void storeOdometry(const cv::Mat& luma, const cv::Rect& roi, const cv::Size& frameSize,
+                          PublishedFrame& update) {
+    cv::Mat matches = framePool().acquire(2 * VisualOdometry::kMaxFeatures, 1, CV_32FC2);
+    const int pairs = visualOdometry().update(luma, matches);
+    toFrameCoordinates(matches, 2 * pairs, luma.size(), roi, frameSize);
+    update.odometryMatches = matches.rowRange(0, 2 * pairs);
+    update.hasOdometry = true;
+}
+
+// Stabilizing correction of the processed luma into update, carried from its
+// pixels over to the renderer's 0..1 full-frame units
+static void storeStabilization(const cv::Mat& luma, const cv::Rect& roi, const cv::Size& frameSize,
+                               PublishedFrame& update) {
+    ScopedStageTimer timer(Stage::STABILIZE);
+    cv::Matx23f correction(1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f);
+    try {
+        correction = videoStabilizer().update(luma);
+    } catch (const cv::Exception& e) {
+        LOGE_RATELIMITED("❌ Stabilization failed: %s", e.what());
+        videoStabilizer().reset();
+    }
+    // Luma pixel centres to frame units, as toFrameCoordinates maps points
+    const cv::Rect area = roi.empty() ? cv::Rect(0, 0, frameSize.width, frameSize.height) : roi;
+    const double sx = static_cast<double>(area.width) / luma.cols;
+    const double sy = static_cast<double>(area.height) / luma.rows;
+    const cv::Matx33d toFrame(sx / frameSize.width, 0.0, (area.x + 0.5 * sx) / frameSize.width,
+                              0.0, sy / frameSize.height, (area.y + 0.5 * sy) / frameSize.height,
+                              0.0, 0.0, 1.0);
+    const cv::Matx33d pixels(correction(0, 0), correction(0, 1), correction(0, 2),
+                             correction(1, 0), correction(1, 1), correction(1, 2),
+                             0.0, 0.0, 1.0);
+    const cv::Matx33d m = toFrame * pixels * toFrame.inv();
+    update.stabilization = cv::Matx23f(static_cast<float>(m(0, 0)), static_cast<float>(m(0, 1)),
+                                       static_cast<float>(m(0, 2)), static_cast<float>(m(1, 0)),
+                                       static_cast<float>(m(1, 1)), static_cast<float>(m(1, 2)));
+    update.hasStabilization = true;
+}
+
+// Tracked quadrilateral of a binary edge map into update, as a closed strip
+static void storeDocument(const cv::Mat& edges, const cv::Rect& roi, const cv::Size& frameSize,
+                          PublishedFrame& update) {
+    ScopedStageTimer timer(Stage::DOCUMENT);
+    cv::Mat outline = framePool().acquire(5, 1, CV_32FC2);
+    cv::Point2f corners[4];
+    bool found = false;
+    try {
+        found = documentDetector().detect(edges, corners);
+    } catch (const cv::Exception& e) {
+        LOGE_RATELIMITED("❌ Document detection failed: %s", e.what());
+    }
+    int count = 0;
+    if (found) {
+        for (int i = 0; i < 5; i++) {
+            outline.at<cv::Point2f>(i) = corners[i % 4];
+        }
+        count = 5;
+    }
+    toFrameCoordinates(outline, count, edges.size(), roi, frameSize);
+    update.document = outline.rowRange(0, count);
+    update.hasDocument = true;
+    if (count == 0) {
+        return;
+    }
+    // The renderer straightens the quad with this map; four points, so the
+    // solve is trivial next to the contour search
+    const cv::Point2f square[4] = {{0.0f, 0.0f}, {1.0f, 0.0f}, {1.0f, 1.0f}, {0.0f, 1.0f}};
+    const cv::Point2f quad[4] = {outline.at<cv::Point2f>(0), outline.at<cv::Point2f>(1),
+                                 outline.at<cv::Point2f>(2), outline.at<cv::Point2f>(3)};
+    update.documentHomography = cv::Matx33f(cv::getPerspectiveTransform(square, quad));
+    auto side = [&](const cv::Point2f& a, const cv::Point2f& b) {
+        return std::hypot((b.x - a.x) * frameSize.width, (b.y - a.y) * frameSize.height);
+    };
+    update.documentSize = cv::Size(cvRound(0.5 * (side(quad[0], quad[1]) + side(quad[3], quad[2]))),
+                                   cvRound(0.5 * (side(quad[0], quad[3]) + side(quad[1], quad[2]))));
+}
+
+// DOCUMENT rectification (nativeSetDocumentRectification): the straightened
+// quad as an inset, and the size it is read back at (empty = no readback)
+static std::atomic<bool> documentInset{false};
+static std::mutex rectifiedMutex;
+static cv::Size rectifiedReadbackSize;
+// Newest read-back rectified luma and the frame it came from
+static cv::Mat rectifiedDocument;
+static uint64_t rectifiedSequence = 0;
+
+// Rectified regions the renderer read back (GL thread; only the header is kept)
+static void storeRectifiedDocument(const cv::Mat& luma, const ReadbackFrame& frame) {
+    std::lock_guard<std::mutex> lock(rectifiedMutex);
+    if (luma.size() != rectifiedReadbackSize) {
+        return;  // queued before the size changed
+    }
+    rectifiedDocument = luma;
+    rectifiedSequence = frame.sequence;
+}
+
+// Values per row of PublishedFrame::chamferMatches
+static const int kChamferMatchValues = 7;
+
+// Edge distance map and the best placement of every template into update.
+// Accepted boxes come first in the strip list, so it holds only those; the
+// match rows cover every template that fit.
+static void storeChamfer(const cv::Mat& edges, const cv::Rect& roi, const cv::Size& frameSize,
+                         PublishedFrame& update) {
+    ScopedStageTimer timer(Stage::CHAMFER);
+    const int kMax = ChamferMatcher::kMaxTemplates;
+    ChamferMatcher& matcher = chamferMatcher();
+    FramePool& pool = framePool();
+    const cv::Size size = matcher.distanceSize(edges.size());
+    cv::Mat distance = pool.acquire(size.height, size.width, CV_8UC1);
+    ChamferMatcher::Match matches[ChamferMatcher::kMaxTemplates];
+    int count = 0;
+    try {
+        count = matcher.match(edges, distance, matches, kMax);
+    } catch (const cv::Exception& e) {
+        LOGE_RATELIMITED("❌ Chamfer matching failed: %s", e.what());
+        distance = cv::Mat();
+    }
+    std::stable_partition(matches, matches + count,
+                          [](const ChamferMatcher::Match& match) { return match.accepted; });
+
+    cv::Mat outlines = pool.acquire(5 * kMax, 1, CV_32FC2);
+    cv::Mat offsets = pool.acquire(kMax + 1, 1, CV_32SC1);
+    cv::Mat results = pool.acquire(kMax, kChamferMatchValues, CV_32FC1);
+    int accepted = 0;
+    for (int i = 0; i < count; i++) {
+        // Pixel edges rather than centers, which toFrameCoordinates adds back
+        const cv::Rect& box = matches[i].box;
+        const float x0 = box.x - 0.5f;
+        const float y0 = box.y - 0.5f;
+        const float x1 = x0 + box.width;
+        const float y1 = y0 + box.height;
+        const cv::Point2f corners[5] = {{x0, y0}, {x1, y0}, {x1, y1}, {x0, y1}, {x0, y0}};
+        for (int j = 0; j < 5; j++) {
+            outlines.at<cv::Point2f>(5 * i + j) = corners[j];
+        }
+        accepted += matches[i].accepted ? 1 : 0;
+    }
+    toFrameCoordinates(outlines, 5 * count, edges.size(), roi, frameSize);
+    for (int i = 0; i < count; i++) {
+        const cv::Point2f& topLeft = outlines.at<cv::Point2f>(5 * i);
+        const cv::Point2f& bottomRight = outlines.at<cv::Point2f>(5 * i + 2);
+        float* row = results.ptr<float>(i);
+        row[0] = static_cast<float>(matches[i].id);
+        row[1] = matches[i].score;
+        row[2] = matches[i].accepted ? 1.0f : 0.0f;
+        row[3] = topLeft.x;
+        row[4] = topLeft.y;
+        row[5] = bottomRight.x;
+        row[6] = bottomRight.y;
+    }
+    for (int i = 0; i <= accepted; i++) {
+        offsets.at<int>(i) = 5 * i;
+    }
+    update.edgeDistance = distance;
+    update.chamferMatches = results.rowRange(0, count);
+    update.chamferOutlines = outlines.rowRange(0, 5 * accepted);
+    update.chamferOffsets = offsets.rowRange(0, accepted + 1);
+    update.hasChamfer = true;
+}
+
+// Foreground mask of the processed luma into update; it stays at model
+// resolution and the renderer's texture filtering scales it up
+static void storeMotion(const cv::Mat& luma, PublishedFrame& update) {
+    ScopedStageTimer timer(Stage::MOTION);
+    MotionDetector& detector = motionDetector();
+    const cv::Size size = detector.maskSize(luma.size());
+    cv::Mat mask = framePool().acquire(size.height, size.width, CV_8UC1);
+    try {
+        detector.detect(luma, mask);
+        update.motion = mask;
+    } catch (const cv::Exception& e) {
+        LOGE_RATELIMITED("❌ Background subtraction failed: %s", e.what());
+        detector.reset();
+    }
+}
+
+// Statistics of the luma about to be processed, with the focus and exposure
+// state of its capture, published for Java and fed to the adaptive Canny
+// thresholds ahead of this frame's edges
+// FOCUS_PEAK reads its sharpness from the statistics, on or not
+static bool lumaStatsWanted(int mode) {
+    return lumaStats.load(std::memory_order_relaxed) || mode == FOCUS_PEAK;
+}
+
+static void storeLumaStats(const cv::Mat& luma, int64_t timestampNs, int mode) {
+    if (!lumaStatsWanted(mode) || luma.empty()) {
+        return;
+    }
+    ScopedStageTimer timer(Stage::LUMA_STATS);
+    LumaStats stats;
+    computeLumaStats(luma, stats);
+    CaptureMetadata capture;
+    if (captureMetadataGate().lookup(timestampNs, capture)) {
+        stats.afState = capture.afState;
+        stats.aeState = capture.aeState;
+        stats.lensMoving = capture.lensMoving ? 1 : 0;
+    }
+    publishLumaStats(stats);
+    feedLumaMedian(stats.median);
+}
+
+// Edge map as displayed: thickened per the active mode's setting so 1-pixel
+// edges survive texture minification. Contours, lines and the document search
+// keep reading the thin map.
+static cv::Mat displayEdges(const cv::Mat& edges, bool edgesValid, int mode) {
+    const int setting = (mode >= 0 && mode < kRenderModeCount) ? edgeMorphology[mode].load(std::memory_order_relaxed) : 0;
+    const int size = setting & 0xff;
+    if (!edgesValid || edges.type() != CV_8UC1 || size <= 1) {
+        return edges;
+    }
+    ScopedStageTimer timer(Stage::EDGE_MORPHOLOGY);
+    cv::Mat thick = framePool().acquire(edges.rows, edges.cols, CV_8UC1);
+    try {
+        rectMorphology().apply(edges, thick, static_cast<RectMorphology::Op>(setting >> 8), size);
+    } catch (const cv::Exception& e) {
+        LOGE_RATELIMITED("❌ Edge thickening failed: %s", e.what());
+        return edges;
+    }
+    return thick;
+}
+
+// Canny and fast edges are 0/255 maps; filter graph and learned edges may be soft
+static bool binaryEdgeMap(const cv::Mat& edges) {
+    return edges.type() == CV_8UC1 && filterGraph().empty() &&
+           edgeBackend.load(std::memory_order_relaxed) != EDGE_BACKEND_DNN;
+}
+
+// Values per row of PublishedFrame::edgeComponents
+static const int kEdgeComponentValues = 5;
+
+// The edge map without the components edgeComponents() drops, which is what
+// gets displayed, exported and read by contours, lines and the rest; with
+// reporting on, the kept components' boxes go into update. Edge records keep
+// every edge pixel. Returns the map as it was when there is nothing to do,
+// it is not binary, or labeling fails.
+static cv::Mat filterEdgeComponents(const cv::Mat& edges, const cv::Rect& roi, const cv::Size& frameSize,
+                                    PublishedFrame& update) {
+    EdgeComponents& filter = edgeComponents();
+    if (!filter.active() || edges.empty() || !binaryEdgeMap(edges)) {
+        return edges;
+    }
+    ScopedStageTimer timer(Stage::EDGE_COMPONENTS);
+    const int kMax = EdgeComponents::kMaxComponents;
+    static thread_local EdgeComponents::Component components[EdgeComponents::kMaxComponents];
+    FramePool& pool = framePool();
+    cv::Mat kept = pool.acquire(edges.rows, edges.cols, CV_8UC1);
+    int passed = 0;
+    int total = 0;
+    try {
+        passed = filter.filter(edges, kept, components, kMax, total);
+    } catch (const cv::Exception& e) {
+        LOGE_RATELIMITED("❌ Edge component labeling failed: %s", e.what());
+        return edges;
+    }
+    if (!filter.params().report) {
+        return kept;
+    }
+    const int count = std::min(passed, kMax);
+    cv::Mat corners = pool.acquire(2 * kMax, 1, CV_32FC2);
+    for (int i = 0; i < count; i++) {
+        // Pixel edges rather than centers, which toFrameCoordinates adds back
+        const cv::Rect& box = components[i].box;
+        corners.at<cv::Point2f>(2 * i) = cv::Point2f(box.x - 0.5f, box.y - 0.5f);
+        corners.at<cv::Point2f>(2 * i + 1) = cv::Point2f(box.x + box.width - 0.5f, box.y + box.height - 0.5f);
+    }
+    toFrameCoordinates(corners, 2 * count, edges.size(), roi, frameSize);
+    cv::Mat results = pool.acquire(kMax, kEdgeComponentValues, CV_32FC1);
+    for (int i = 0; i < count; i++) {
+        const cv::Point2f& topLeft = corners.at<cv::Point2f>(2 * i);
+        const cv::Point2f& bottomRight = corners.at<cv::Point2f>(2 * i + 1);
+        float* row = results.ptr<float>(i);
+        row[0] = topLeft.x;
+        row[1] = topLeft.y;
+        row[2] = bottomRight.x;
+        row[3] = bottomRight.y;
+        row[4] = static_cast<float>(components[i].pixels);
+    }
+    update.edgeComponents = results.rowRange(0, count);
+    update.edgeComponentsTotal = total;
+    update.hasEdgeComponents = true;
+    return kept;
+}
+
+// Binary edge maps stored at 1 bpp (nativeSetPackedEdges)
+static std::atomic<bool> packedEdgeStorage{false};
+
+// The displayed edge map as published: packed to one bit per pixel when
+// enabled and the map is binary (Canny and its thickening; not filter graph
+// or learned edges, which may be soft), as-is otherwise
+static cv::Mat storedEdges(const cv::Mat& edges, bool edgesValid, int mode, int& bitmapWidth) {
+    cv::Mat display = displayEdges(edges, edgesValid, mode);
+    bitmapWidth = 0;
+    if (!packedEdgeStorage.load(std::memory_order_relaxed) || !edgesValid || !binaryEdgeMap(display)) {
+        return display;
+    }
+    cv::Mat bits = framePool().acquire(display.rows, packedEdgeRowBytes(display.cols), CV_8UC1);
+    packEdges(display, bits);
+    bitmapWidth = display.cols;
+    return bits;
+}
+
+// Dirty rects for the renderer: what the incremental detector changed in
+// edges, when processed is that very map (thickening, component filtering
+// and packing each publish a new buffer, which is uploaded whole)
+static void storeEdgeChanges(const cv::Mat& edges, PublishedFrame& update) {
+    IncrementalEdgeDetector::Changes& changes = frameEdgeChanges;
+    if (changes.result == 0 || edges.empty() || update.processed.data != edges.data) {
+        changes.result = 0;
+        return;
+    }
+    const int count = static_cast<int>(changes.rects.size());
+    cv::Mat rects = framePool().acquire(std::max(1, count), 1, CV_32SC4);
+    for (int i = 0; i < count; i++) {
+        const cv::Rect& rect = changes.rects[i];
+        rects.at<cv::Vec4i>(i) = cv::Vec4i(rect.x, rect.y, rect.width, rect.height);
+    }
+    update.processedResult = changes.result;
+    update.processedBase = changes.base;
+    update.processedChanges = rects.rowRange(0, count);
+    changes.result = 0;
+}
+
+// FAST_EDGES written straight to the published 1-bpp bitmap when the displayed
+// edge map is all the frame needs from them and storedEdges would pack it
+// unchanged; bits stays empty otherwise and pipelineEdges runs as usual
+static void fastPackedEdges(const cv::Mat& gray, unsigned variants, int mode, cv::Mat& bits, int& bitmapWidth) {
+    const int thicken =
+            (mode >= 0 && mode < kRenderModeCount) ? edgeMorphology[mode].load(std::memory_order_relaxed) & 0xff : 0;
+    if ((variants & kEdgeMapVariants) != VARIANT_EDGES || !packedEdgeStorage.load(std::memory_order_relaxed) ||
+        thicken > 1 || !filterGraph().empty() || edgeBackend.load(std::memory_order_relaxed) == EDGE_BACKEND_DNN ||
+        !fastEdgesActive() || edgeComponents().active()) {
+        return;
+    }
+    bits = framePool().acquire(gray.rows, packedEdgeRowBytes(gray.cols), CV_8UC1);
+    detectGradientEdgesPacked(gray, bits);
+    bitmapWidth = gray.cols;
+}
+
+// Edge pixel coordinates per frame (nativeSetEdgePoints); 0 = off
+static std::atomic<int> edgePointCapacity{0};
+static const int kMaxEdgePoints = 1 << 20;
+
+// Compacts the thin edge map (or the bitmap fastPackedEdges wrote instead)
+// into a pooled point list of the configured capacity
+static void storeEdgePoints(const cv::Mat& edges, const cv::Mat& packed, int bitmapWidth, PublishedFrame& update) {
+    const int capacity = edgePointCapacity.load(std::memory_order_relaxed);
+    const cv::Mat& source = packed.empty() ? edges : packed;
+    if (capacity <= 0 || source.empty() || source.type() != CV_8UC1) {
+        return;
+    }
+    cv::Mat points = framePool().acquire(capacity, 1, CV_16UC2);
+    EdgePointSink sink;
+    sink.points = points.ptr<uint16_t>();
+    sink.capacity = capacity;
+    if (packed.empty()) {
+        compactEdgePoints(edges, sink);
+    } else {
+        compactPackedEdgePoints(packed, bitmapWidth, sink);
+    }
+    update.edgePoints = points.rowRange(0, sink.count);
+    update.edgePointsDropped = sink.dropped;
+    update.edgePointGrid = cv::Size(packed.empty() ? edges.cols : bitmapWidth, source.rows);
+    update.hasEdgePoints = true;
+}
+
+// The CPU part of a split frame: tiled Canny on the gray's top rows, as many
+// as the split balancer gives the CPU, plus a halo so the kept rows' gradient
+// and suppression see real neighbours. Hysteresis is not continued across
+// the split. Whole frames only: with a processing ROI the GPU does it all.
+static void storeSplitEdges(const cv::Mat& gray, const cv::Rect& roi, PublishedFrame& update) {
+    const int rows = splitBalancer().cpuRows(gray.rows);
+    if (!roi.empty() || gray.empty() || rows <= 0) {
+        return;
+    }
+    ScopedStageTimer timer(Stage::CANNY);
+    const int64_t start = bootTimeNanos();
+    try {
+        const int to = std::min(rows + SplitBalancer::kHaloRows, gray.rows);
+        cv::Mat edges = framePool().acquire(to, gray.cols, CV_8UC1);
+        int low = 0;
+        int high = 0;
+        currentCannyThresholds(low, high);
+        cannyU8Tiled(gray.rowRange(0, to), edges, low, high, true);  // blurred like the GPU passes
+        update.splitEdges = edges.rowRange(0, rows);
+    } catch (const cv::Exception& e) {
+        LOGE_RATELIMITED("❌ Split edges failed, the GPU does the whole frame: %s", e.what());
+        return;
+    }
+    splitBalancer().reportCpu(rows, bootTimeNanos() - start);
+}
+
+// Builds the requested render variants from the BGR frame (original full-color
+// path) into update. Every variant is written into its own pooled buffer and
+// never modified after being published, so fallbacks and readers can share it
+// without cloning.
+static void storeVariantsFromBgr(const cv::Mat& bgr, const cv::Mat& fusedGray, int rotation, unsigned variants,
+                                 int64_t timestampNs, PublishedFrame& update) {
+    FramePool& pool = framePool();
+    // Grayscale and Canny only see the ROI (a header into the full BGR frame)
+    const cv::Rect roi = activeRoi(bgr.size());
+    const cv::Mat source = roi.empty() ? bgr : bgr(roi);
+
+    // Frames stay sensor-native (rotation is applied by the renderer), and the
+    // conversion output already lives in a pooled buffer, so it is published as-is
+
+    // Create grayscale version (single channel; the renderer expands it on the GPU)
+    cv::Mat gray;
+    if ((variants & kLumaVariants) || lumaStatsWanted(update.renderMode)) {
+        ScopedStageTimer timer(Stage::GRAYSCALE);
+        try {
+            if (!fusedGray.empty()) {
+                gray = roi.empty() ? fusedGray : fusedGray(roi);  // per pixel, so the ROI's gray is a view
+            } else {
+                gray = pool.acquire(source.rows, source.cols, CV_8UC1);
+                if (edgeBackend.load(std::memory_order_relaxed) != EDGE_BACKEND_OPENCL || !grayscaleOcl(source, gray)) {
+                    cv::cvtColor(source, gray, cv::COLOR_BGR2GRAY);
+                }
+            }
+            cv::Mat scaled = downscaleForProcessing(gray);
+            if (!scaled.empty()) {
+                gray = scaled;
+            }
+            cv::Mat denoised = denoiseForProcessing(gray, roi);
+            if (!denoised.empty()) {
+                gray = denoised;
+            }
+            cv::Mat equalized = equalizeForProcessing(gray);
+            if (!equalized.empty()) {
+                gray = equalized;
+            }
+            cv::Mat undistorted = undistortForProcessing(gray, roi);
+            if (!undistorted.empty()) {
+                gray = undistorted;
+            }
+            LOGD("✅ [STEP 3B] Grayscale frame created: %dx%d", gray.cols, gray.rows);
+        } catch (const cv::Exception& e) {
+            LOGE_RATELIMITED("❌ [STEP 3B] Grayscale conversion failed: %s", e.what());
+            gray = cv::Mat();
+        }
+    }
+
+    // Shared by the consumers below that want a pyramid of the processed luma
+    ScopedPyramidFrame pyramid(gray);
+    storeLumaStats(gray, timestampNs, update.renderMode);
+    if (variants & VARIANT_SPLIT_EDGES) {
+        storeSplitEdges(gray, roi, update);
+    }
+
+    // Create edge detection version from the grayscale frame computed above
+    cv::Mat edges;
+    bool edgesValid = false;  // edges is an edge map, not a fallback picture
+    if ((variants & kEdgeMapVariants) && !gray.empty()) {
+        ScopedStageTimer timer(Stage::CANNY);
+        try {
+            if (update.renderMode == COLOR_EDGES) {
+                frameChroma = chromaFromBgr(source, gray.size());
+            }
+            edges = pipelineEdges(gray, &update);
+            edgesValid = !edges.empty();  // empty: cut short at the frame's deadline
+            LOGD("✅ [STEP 3C] Edge detection completed: %dx%d", edges.cols, edges.rows);
+        } catch (const cv::Exception& e) {
+            LOGE_RATELIMITED("❌ [STEP 3C] Edge detection failed: %s", e.what());
+            edges = source; // Fallback to raw
+        }
+    } else if (variants & VARIANT_EDGES) {
+        edges = source; // Fallback to raw
+    }
+    if (edgesValid) {
+        edges = filterEdgeComponents(edges, roi, bgr.size(), update);
+    }
+
+    if ((variants & VARIANT_GRAY) && gray.empty()) {
+        gray = source; // Fallback to raw
+    }
+
+    // Step 3: Raw frame and the computed variants
+    update.raw = (variants & VARIANT_RAW) ? bgr : cv::Mat();
+    update.grayscale = (variants & VARIANT_GRAY) ? gray : cv::Mat();
+    update.processed = (variants & VARIANT_EDGES)
+                       ? storedEdges(edges, edgesValid, update.renderMode, update.processedBitmapWidth)
+                       : cv::Mat();
+    if (variants & VARIANT_EDGES) {
+        storeEdgeChanges(edges, update);
+    }
+    update.processedRoi = roi;
+    update.processedFrameSize = bgr.size();
+    if (edgesValid) {
+        storeEdgePoints(edges, cv::Mat(), 0, update);
+    }
+    if ((variants & VARIANT_CONTOURS) && edgesValid && edges.type() == CV_8UC1) {
+        storeContours(edges, roi, bgr.size(), update);
+    }
+    if ((variants & VARIANT_LINES) && edgesValid && edges.type() == CV_8UC1) {
+        storeLines(edges, roi, bgr.size(), update);
+    }
+    if ((variants & VARIANT_DOCUMENT) && edgesValid && edges.type() == CV_8UC1) {
+        storeDocument(edges, roi, bgr.size(), update);
+    }
+    if ((variants & VARIANT_CHAMFER) && edgesValid && edges.type() == CV_8UC1) {
+        storeChamfer(edges, roi, bgr.size(), update);
+    }
+    if ((variants & VARIANT_FEATURES) && !gray.empty() && gray.type() == CV_8UC1) {
+        storeFeatures(gray, roi, bgr.size(), update);
+    }
+    if ((variants & VARIANT_FLOW) && !gray.empty() && gray.type() == CV_8UC1) {
+        storeFlow(gray, roi, bgr.size(), update);
+    }
+    if ((variants & VARIANT_MOTION) && !gray.empty() && gray.type() == CV_8UC1) {
+        storeMotion(gray, update);
+    }
+    if ((variants & VARIANT_SEGMENTS) && !gray.empty() && gray.type() == CV_8UC1) {
+        storeSegments(gray, roi, bgr.size(), update);
+    }
+    if ((variants & VARIANT_MARKERS) && !gray.empty() && gray.type() == CV_8UC1) {
+        storeMarkers(gray, roi, bgr.size(), update);
+    }
+    if ((variants & VARIANT_CODES) && !gray.empty() && gray.type() == CV_8UC1) {
+        storeCodes(gray, roi, bgr.size(), update);
+    }
+    if ((variants & VARIANT_FACES) && !gray.empty() && gray.type() == CV_8UC1) {
+        storeFaces(gray, roi, bgr.size(), update);
+    }
+    if ((variants & VARIANT_MOSAIC) && !gray.empty() && gray.type() == CV_8UC1) {
+        storeMosaic(gray, update);
+    }
+    if (variants & VARIANT_TRACK_OBJECT) {
+        storeTrackedObject(bgr, update);
+    }
+    if ((variants & VARIANT_PEOPLE) && !gray.empty() && gray.type() == CV_8UC1) {
+        storePeople(gray, roi, bgr.size(), update);
+    }
+    if ((variants & VARIANT_TEXT_REGIONS) && !gray.empty() && gray.type() == CV_8UC1) {
+        storeTextRegions(gray, roi, bgr.size(), update);
+    }
+    if ((variants & VARIANT_ODOMETRY) && !gray.empty() && gray.type() == CV_8UC1) {
+        storeOdometry(gray, roi, bgr.size(), update);
+    }
+    if ((variants & VARIANT_STABILIZE) && !gray.empty() && gray.type() == CV_8UC1) {
+        storeStabilization(gray, roi, bgr.size(), update);
+    }
+    update.rotation = rotation;
+    LOGD("✅ [STEP 3] Frame variants 0x%x built", variants);
+}
+
+// Luma fast path: grayscale and Canny read the Y plane directly; bgr is only
+// set (by convertForVariants, usually as RGBA) when the raw variant is requested
+static void storeVariantsFromLuma(const IngestFrame& frame, const cv::Mat& bgr, int rotation, unsigned variants,
+                                  PublishedFrame& update) {
+    FramePool& pool = framePool();
+
+    // Step 2: published planes must be detached from the caller's buffer;
+    // Canny alone can read the caller's Y plane in place. At a reduced
+    // processing resolution the downscale doubles as that copy. Grayscale and
+    // Canny only see the processing ROI; the YUV layer keeps the whole frame.
+    const cv::Rect roi = activeRoi(frame.luma.size());
+    const cv::Mat input = roi.empty() ? frame.luma : frame.luma(roi);
+    cv::Mat scaled;
+    bool filtered = false;  // the gray is more than the Y plane cropped and scaled
+    if (variants & kLumaVariants) {
+        try {
+            scaled = downscaleForProcessing(input);
+        } catch (const cv::Exception& e) {
+            LOGE_RATELIMITED("❌ [STEP 3A] Downscale failed: %s", e.what());
+        }
+        // Everything below reads the denoised, equalized, undistorted luma,
+        // the YUV layer excepted
+        cv::Mat denoised = denoiseForProcessing(scaled.empty() ? input : scaled, roi);
+        if (!denoised.empty()) {
+            scaled = denoised;
+            filtered = true;
+        }
+        cv::Mat equalized = equalizeForProcessing(scaled.empty() ? input : scaled);
+        if (!equalized.empty()) {
+            scaled = equalized;
+            filtered = true;
+        }
+        cv::Mat undistorted = undistortForProcessing(scaled.empty() ? input : scaled, roi);
+        if (!undistorted.empty()) {
+            scaled = undistorted;
+            filtered = true;
+        }
+    }
+    cv::Mat luma;
+    if (variants & VARIANT_YUV) {
+        luma = pool.copyOf(frame.luma);
+    }
+    cv::Mat gray = scaled;
+    if (gray.empty() && (variants & VARIANT_GRAY)) {
+        gray = (roi.empty() && !luma.empty()) ? luma : pool.copyOf(input);
+    }
+
+    // Shared by the consumers below that want a pyramid of the processed luma
+    ScopedPyramidFrame pyramid(gray.empty() ? input : gray);
+    storeLumaStats(gray.empty() ? input : gray, frame.timestampNs, update.renderMode);
+    if (variants & VARIANT_SPLIT_EDGES) {
+        storeSplitEdges(gray, roi, update);
+    }
+
+    cv::Mat edges;
+    cv::Mat packedEdges;     // set instead of edges by fastPackedEdges
+    bool edgesValid = false;  // edges is an edge map, not a fallback picture
+    if (variants & kEdgeMapVariants) {
+        const cv::Mat& source = gray.empty() ? input : gray;
+        ScopedStageTimer timer(Stage::CANNY);
+        try {
+            fastPackedEdges(source, variants, update.renderMode, packedEdges, update.processedBitmapWidth);
+            if (packedEdges.empty()) {
+                if (update.renderMode == COLOR_EDGES) {
+                    frameChroma = chromaForLuma(frame.chroma, roi, source.size());
+                }
+                if (!frame.luma10.empty() && !filtered) {
+                    frameLuma10 = luma10ForGray(frame.luma10, roi, source.size());
+                }
+                edges = pipelineEdges(source, &update);
+            }
+            edgesValid = !packedEdges.empty() || !edges.empty();  // neither: cut short at the frame's deadline
+            LOGD("✅ [STEP 3C] Edge detection on luma completed: %dx%d", edges.cols, edges.rows);
+        } catch (const cv::Exception& e) {
+            LOGE_RATELIMITED("❌ [STEP 3C] detectEdges() failed: %s", e.what());
+            packedEdges = cv::Mat();
+            edges = gray.empty() ? pool.copyOf(input) : gray; // Fallback to grayscale
+        }
+    }
+    if (edgesValid && packedEdges.empty()) {
+        edges = filterEdgeComponents(edges, roi, frame.luma.size(), update);
+    }
+
+    // The shader samples the same Y plane copy; only the VU plane is extra
+    cv::Mat chroma;
+    if (variants & VARIANT_YUV) {
+        chroma = pool.copyOf(frame.chroma);
+    }
+
+    // Step 3: Variants (single-channel frames upload as GL_LUMINANCE)
+    update.raw = bgr;
+    update.grayscale = (variants & VARIANT_GRAY) ? gray : cv::Mat();
+    if (!packedEdges.empty()) {
+        update.processed = packedEdges;
+    } else if (variants & VARIANT_EDGES) {
+        update.processed = storedEdges(edges, edgesValid, update.renderMode, update.processedBitmapWidth);
+        storeEdgeChanges(edges, update);
+    }
+    update.processedRoi = roi;
+    update.processedFrameSize = frame.luma.size();
+    if (edgesValid) {
+        storeEdgePoints(edges, packedEdges, update.processedBitmapWidth, update);
+    }
+    if ((variants & VARIANT_CONTOURS) && edgesValid && edges.type() == CV_8UC1) {
+        storeContours(edges, roi, frame.luma.size(), update);
+    }
+    if ((variants & VARIANT_LINES) && edgesValid && edges.type() == CV_8UC1) {
+        storeLines(edges, roi, frame.luma.size(), update);
+    }
+    if ((variants & VARIANT_DOCUMENT) && edgesValid && edges.type() == CV_8UC1) {
+        storeDocument(edges, roi, frame.luma.size(), update);
+    }
+    if ((variants & VARIANT_CHAMFER) && edgesValid && edges.type() == CV_8UC1) {
+        storeChamfer(edges, roi, frame.luma.size(), update);
+    }
+    if (variants & VARIANT_FEATURES) {
+        // FAST only reads the luma, so the caller's plane is fine here
+        storeFeatures(gray.empty() ? input : gray, roi, frame.luma.size(), update);
+    }
+    if (variants & VARIANT_FLOW) {
+        // The pyramid is a copy, so the tracker keeps nothing of the caller's plane
+        storeFlow(gray.empty() ? input : gray, roi, frame.luma.size(), update);
+    }
+    if (variants & VARIANT_MOTION) {
+        storeMotion(gray.empty() ? input : gray, update);
+    }
+    if (variants & VARIANT_SEGMENTS) {
+        // The hand-off copies, so the caller's plane is fine here
+        storeSegments(gray.empty() ? input : gray, roi, frame.luma.size(), update);
+    }
+    if (variants & VARIANT_MARKERS) {
+        // Straight on the Y plane: ArucoDetector thresholds one channel
+        storeMarkers(gray.empty() ? input : gray, roi, frame.luma.size(), update);
+    }
+    if (variants & VARIANT_CODES) {
+        // Only a candidate region is copied, and only when a scan is due
+        storeCodes(gray.empty() ? input : gray, roi, frame.luma.size(), update);
+    }
+    if (variants & VARIANT_FACES) {
+        // The reduction to the detector's width is the only full-frame pass
+        storeFaces(gray.empty() ? input : gray, roi, frame.luma.size(), update);
+    }
+    if (variants & VARIANT_MOSAIC) {
+        // Reduced to the mosaic's frame width before anything else reads it
+        storeMosaic(gray.empty() ? input : gray, update);
+    }
+    if (variants & VARIANT_TRACK_OBJECT) {
+        // The whole Y plane: the tracker reduces it to its own width first
+        storeTrackedObject(frame.luma, update);
+    }
+    if (variants & VARIANT_PEOPLE) {
+        // After the edges, whose derivatives it may take over
+        storePeople(gray.empty() ? input : gray, roi, frame.luma.size(), update);
+    }
+    if (variants & VARIANT_TEXT_REGIONS) {
+        storeTextRegions(gray.empty() ? input : gray, roi, frame.luma.size(), update);
+    }
+    if (variants & VARIANT_ODOMETRY) {
+        storeOdometry(gray.empty() ? input : gray, roi, frame.luma.size(), update);
+    }
+    if (variants & VARIANT_STABILIZE) {
+        storeStabilization(gray.empty() ? input : gray, roi, frame.luma.size(), update);
+    }
+    if (variants & VARIANT_YUV) {
+        update.yuvLuma = luma;
+        update.yuvChroma = chroma;
+    }
+    update.rotation = rotation;
+    LOGD("✅ [STEP 3] Luma variants 0x%x built", variants);
+}
+
+// Variants this frame's layout can provide: without a directly sampled chroma
+// plane (or on the legacy path) the YUV layer becomes a CPU BGR one
+static unsigned effectiveVariants(const IngestFrame& frame, unsigned variants, bool fromLuma) {
+    if ((variants & VARIANT_YUV) && (!fromLuma || frame.chroma.empty())) {
+        variants = (variants & ~VARIANT_YUV) | VARIANT_RAW;
+    }
+    if (frameHistoryDepth.load(std::memory_order_relaxed) > 0) {
+        variants |= VARIANT_GRAY;  // what the history keeps of every frame
+    }
+    return variants;
+}
+
+// NV21 -> BGR -> gray of the legacy path as one banded pass (band_executor.h):
+// each stripe's BGR is written out for the raw variant and turned into gray
+// while it is still in L2, instead of the whole BGR frame being read back by
+// a second sweep. Same pixels as the two cvtColor calls. One executor per
+// processing thread, since the chroma plane is set per frame.
+static void convertFused(const IngestFrame& frame, cv::Mat& bgr, cv::Mat& gray) {
+    struct FusedConversion {
+        BandExecutor executor;
+        Nv21ToBgrStage* nv21 = new Nv21ToBgrStage;
+        FusedConversion() {
+            executor.addStage(std::unique_ptr<BandStage>(nv21));
+            executor.addStage(std::unique_ptr<BandStage>(new BgrToGrayStage));
+        }
+    };
+    static thread_local FusedConversion fused;
+    fused.nv21->setChroma(frame.chroma);
+    bgr = framePool().acquire(frame.luma.rows, frame.luma.cols, CV_8UC3);
+    gray = framePool().acquire(frame.luma.rows, frame.luma.cols, CV_8UC1);
+    fused.executor.run(frame.luma, {&bgr, &gray});
+}
+
+// Whether the legacy path's gray comes out of the conversion (convertFused):
+// NV21 frames whose gray is wanted for the whole frame and not made by OpenCL
+static bool fuseGrayIntoConversion(const IngestFrame& frame, unsigned variants) {
+    return bandFusion.load(std::memory_order_relaxed) && !frame.chroma.empty() &&
+           !hasProcessingRoi.load(std::memory_order_relaxed) &&
+           ((variants & (kLumaVariants | VARIANT_SHARED_EDGES)) || lumaStats.load(std::memory_order_relaxed)) &&
+           edgeBackend.load(std::memory_order_relaxed) != EDGE_BACKEND_OPENCL;
+}
+
+// Step 2: BGR for the legacy path, whose stages all read it. On the luma path
+// only the raw variant needs color, and only for display, so it is converted
+// to RGBA in one pass and uploaded as-is instead of going NV21 -> BGR here and
+// BGR -> RGBA on the GL thread. gray is the legacy path's full-frame gray when
+// the conversion fused it in, empty otherwise. False when the conversion
+// failed and the frame is dropped.
+static bool convertForVariants(const IngestFrame& frame, unsigned variants, bool fromLuma, cv::Mat& bgr,
+                               cv::Mat& gray) {
+    if (fromLuma && !(variants & VARIANT_RAW)) {
+        return true;
+    }
+    try {
+        ScopedStageTimer timer(Stage::YUV_TO_BGR);
+        if (!fromLuma && fuseGrayIntoConversion(frame, variants)) {
+            convertFused(frame, bgr, gray);
+            LOGD("✅ [STEP 2] Fused conversion: BGR and gray %dx%d", bgr.cols, bgr.rows);
+            return true;
+        }
+        if (fromLuma && frame.convertToRgba) {
+            bgr = framePool().acquire(frame.luma.rows, frame.luma.cols, CV_8UC4);
+            if (frame.convertToRgba(bgr)) {
+                LOGD("✅ [STEP 2] cvtColor success: RGBA size = %dx%d", bgr.cols, bgr.rows);
+                return true;
+            }
+        }
+        bgr = framePool().acquire(frame.luma.rows, frame.luma.cols, CV_8UC3);
+        if (!frame.convertToBgr(bgr)) {
+            return false;
+        }
+        LOGD("✅ [STEP 2] cvtColor success: BGR size = %dx%d", bgr.cols, bgr.rows);
+    } catch (const cv::Exception& e) {
+        LOGE_RATELIMITED("❌ [STEP 2] OpenCV YUV to BGR failed: %s", e.what());
+        return false;
+    }
+    return true;
+}
+
+static void setProcessingRoi(int x, int y, int width, int height) {
+    {
+        std::lock_guard<std::mutex> lock(roiMutex);
+        processingRoi = (width > 0 && height > 0) ? cv::Rect(x, y, width, height) : cv::Rect();
+        hasProcessingRoi.store(!processingRoi.empty());
+    }
+    incrementalEdgeDetector().reset();  // same-sized ROIs elsewhere in the frame
+    pointTracker().reset();
+    motionDetector().reset();
+    documentDetector().reset();
+    LOGI("🔄 Processing ROI: %d,%d %dx%d", x, y, width, height);
+}
+
+static void setProcessingScale(int divisor) {
+    if (divisor < 1 || divisor > 8) {
+        LOGE("❌ Unsupported processing scale divisor: %d", divisor);
+        return;
+    }
+    processingTargetWidth.store(0);
+    processingTargetHeight.store(0);
+    processingDivisor.store(divisor);
+    LOGI("🔄 Processing scale: 1/%d", divisor);
+}
+
+// Settings Java changed in the control block (control_block.h), applied at
+// the default pipeline's frame boundary through the same paths as the JNI
+// setters; only the fields that differ from the version applied before
+static void applyControlBlock() {
+    pollControlBlock([](const ControlValues& previous, const ControlValues& next) {
+        if (next.renderMode != previous.renderMode) {
+            if (next.renderMode >= 0 && next.renderMode < kRenderModeCount) {
+                switchRenderMode(defaultPipeline, static_cast<RenderMode>(next.renderMode));
+            } else {
+                LOGE("❌ Control block: invalid render mode %d", next.renderMode);
+            }
+        }
+        const bool adaptive = (next.flags & kControlAdaptiveThresholds) != 0;
+        if (adaptive != ((previous.flags & kControlAdaptiveThresholds) != 0)) {
+            setAdaptiveThresholds(adaptive);
+        }
+        const bool blur = (next.flags & kControlEdgePreBlur) != 0;
+        if (blur != ((previous.flags & kControlEdgePreBlur) != 0)) {
+            setEdgePreBlur(blur);
+            incrementalEdgeDetector().reset();
+        }
+        if (next.cannyLow != previous.cannyLow || next.cannyHigh != previous.cannyHigh) {
+            setFixedCannyThresholds(next.cannyLow, next.cannyHigh);
+        }
+        if (next.roiX != previous.roiX || next.roiY != previous.roiY || next.roiWidth != previous.roiWidth ||
+            next.roiHeight != previous.roiHeight) {
+            setProcessingRoi(next.roiX, next.roiY, next.roiWidth, next.roiHeight);
+        }
+        if (next.scaleDivisor != previous.scaleDivisor) {
+            setProcessingScale(next.scaleDivisor);
+        }
+        if (next.roiBackgroundDim != previous.roiBackgroundDim) {
+            roiBackgroundDim.store(std::max(0.0f, std::min(1.0f, next.roiBackgroundDim)));
+        }
+        // orientation: the renderer polls it itself, on the GL thread
+    });
+}
+
+// Default pipeline's frame boundary: one degradation step when the memory
+// budget refused anything since the last frame. Every step reapplies the
+// lower ones (resident textures come back after a quiet minute, see
+// residencyUnderPressure) and trims the idle pool buffers it freed.
+static void applyMemoryBudget() {
+    if (!memoryBudget().takePressure()) {
+        return;
+    }
+    int level = memoryDegradation.load(std::memory_order_relaxed);
+    if (level < kMaxMemoryDegradation) {
+        memoryDegradation.store(++level, std::memory_order_relaxed);
+        LOGW("⚠️ Over the memory budget (%lld of %lld bytes): degradation level %d",
+             static_cast<long long>(memoryBudget().used()), static_cast<long long>(memoryBudget().budget()), level);
+    }
+    if (level >= 2 && residentModes.load(std::memory_order_relaxed) != 0) {
+        residencyPressureMicros.store(monotonicMicros(), std::memory_order_relaxed);
+        setModeResidencyGL(residentModes.load(std::memory_order_relaxed), 0);
+    }
+    framePool().trim();
+}
+
+// The stats block (control_block.h) of a frame the default pipeline just
+// published; stages as for recordTelemetry
+static void writeStatsBlock(const PublishedFrame& update, const cv::Size& size, const FrameStageTimes& stages) {
+    int low = 0;
+    int high = 0;
+    currentCannyThresholds(low, high);
+    LumaStats luma;
+    const bool hasLuma = lumaStats.load(std::memory_order_relaxed) && latestLumaStats(luma);
+    const MetricsRegistry& registry = metrics();
+    const int64_t now = bootTimeNanos();
+    StatsBlock& stats = statsBlock();
+    StatsBlockWrite write;
+    stats.renderMode.store(update.renderMode, std::memory_order_relaxed);
+    stats.sequence.store(static_cast<int64_t>(defaultPipeline.publishedSequence.load(std::memory_order_relaxed)),
+                         std::memory_order_relaxed);
+    stats.captureTimestampNs.store(update.captureTimestampNs, std::memory_order_relaxed);
+    stats.publishTimestampNs.store(now, std::memory_order_relaxed);
+    stats.framesProcessed.store(static_cast<int64_t>(registry.counter(Counter::FRAMES_PROCESSED)),
+                                std::memory_order_relaxed);
+    stats.framesDropped.store(static_cast<int64_t>(registry.counter(Counter::FRAMES_DROPPED)),
+                              std::memory_order_relaxed);
+    stats.framesStale.store(static_cast<int64_t>(registry.counter(Counter::FRAMES_STALE)), std::memory_order_relaxed);
+    stats.frameMicros.store(static_cast<int32_t>(stages.micros[static_cast<int>(Stage::FRAME_TOTAL)]),
+                            std::memory_order_relaxed);
+    stats.captureToPublishMicros.store(
+            update.captureTimestampNs > 0 ? static_cast<int32_t>((now - update.captureTimestampNs) / 1000) : 0,
+            std::memory_order_relaxed);
+    stats.cannyLow.store(low, std::memory_order_relaxed);
+    stats.cannyHigh.store(high, std::memory_order_relaxed);
+    stats.cannyBackend.store(static_cast<int32_t>(activeCannyBackend()), std::memory_order_relaxed);
+    stats.width.store(size.width, std::memory_order_relaxed);
+    stats.height.store(size.height, std::memory_order_relaxed);
+    stats.lumaMedian.store(hasLuma ? luma.median : -1, std::memory_order_relaxed);
+}
+
+// Appends the telemetry record of a frame the default pipeline just published,
+// fills the stats block and feeds the capture capacity estimate; stages: what the threads that worked on it
+// recorded (FrameStageTimes)
+static void recordTelemetry(const PipelineContext& pipeline, const PublishedFrame& update, const cv::Size& size,
+                            const FrameStageTimes& stages) {
+    if (&pipeline != &defaultPipeline) {
+        return;
+    }
+    writeStatsBlock(update, size, stages);
+    captureCapacity().onFrame(update.captureTimestampNs, stages.micros[static_cast<int>(Stage::FRAME_TOTAL)],
+                              size.width, size.height);
+    if (!frameTelemetryActive()) {
+        return;
+    }
+    TelemetryRecord record;
+    std::memset(&record, 0, sizeof(record));
+    record.captureTimestampNs = update.captureTimestampNs;
+    record.publishTimestampNs = bootTimeNanos();
+    record.renderMode = update.renderMode;
+    record.width = static_cast<uint16_t>(size.width);
+    record.height = static_cast<uint16_t>(size.height);
+    int low = 0;
+    int high = 0;
+    currentCannyThresholds(low, high);
+    record.cannyLow = static_cast<int16_t>(low);
+    record.cannyHigh = static_cast<int16_t>(high);
+    LumaStats luma;
+    if (lumaStats.load(std::memory_order_relaxed) && latestLumaStats(luma)) {
+        record.lumaMedian = static_cast<int16_t>(luma.median);
+        record.lumaMean = luma.mean;
+        record.lumaSharpness = luma.sharpness;
+    } else {
+        record.lumaMedian = -1;
+    }
+    const MetricsRegistry& registry = metrics();
+    record.framesProcessed = static_cast<uint32_t>(registry.counter(Counter::FRAMES_PROCESSED));
+    record.framesDropped = static_cast<uint32_t>(registry.counter(Counter::FRAMES_DROPPED));
+    record.framesStale = static_cast<uint32_t>(registry.counter(Counter::FRAMES_STALE));
+    record.framesGovernorSkipped = static_cast<uint32_t>(registry.counter(Counter::FRAMES_GOVERNOR_SKIPPED));
+    // Every stage: the file header announces stageCount = Stage::COUNT
+    static_assert(sizeof(stages.micros) <= sizeof(record.stageMicros), "every stage has a record slot");
+    std::copy(std::begin(stages.micros), std::end(stages.micros), record.stageMicros);
+    appendTelemetry(record);
+}
+
+// VARIANT_SHARED_EDGES: the whole frame through the Vulkan passes, from the
+// camera buffer when the frame carries one; false when they failed
+static bool storeSharedEdges(const IngestFrame& frame, const cv::Mat& bgr, const cv::Mat& fusedGray, bool fromLuma,
+                             PublishedFrame& update) {
+    ScopedStageTimer timer(Stage::CANNY);
+    int low = 0;
+    int high = 0;
+    currentCannyThresholds(low, high);
+    if (frame.hardwareBuffer) {
+        update.sharedEdges = vulkanDetectEdges(frame.hardwareBuffer, low / 255.0f, high / 255.0f);
+    }
+    if (!update.sharedEdges) {
+        cv::Mat luma = frame.luma;
+        if (!fromLuma && !fusedGray.empty()) {
+            luma = fusedGray;
+        } else if (!fromLuma) {
+            luma = framePool().acquire(bgr.rows, bgr.cols, CV_8UC1);
+            cv::cvtColor(bgr, luma, cv::COLOR_BGR2GRAY);
+        }
+        update.sharedEdges = vulkanDetectEdges(luma, low / 255.0f, high / 255.0f);
+    }
+    return update.sharedEdges != nullptr;
+}
+
+// With hardwareFrames, the variant frameForRenderMode shows on its own for the
+// frame's mode is also written into an AHardwareBuffer, which the renderer
+// samples instead of converting and uploading it. Composed, ROI and bitmap
+// layers keep the upload path.
+static void storeHardwareFrame(PublishedFrame& update) {
+    if (!hardwareFrames.load(std::memory_order_relaxed)) {
+        return;
+    }
+    cv::Mat source;
+    switch (update.renderMode) {
+        case RAW_CAMERA:
+            source = update.raw;  // empty with the YUV or external raw layer
+            break;
+        case GRAYSCALE:
+            source = update.processedRoi.empty() ? update.grayscale : cv::Mat();
+            break;
+        case EDGE_DETECTION:
+        case MULTISCALE_EDGES:
+        case COLOR_EDGES:
+            source = update.processedRoi.empty() && update.processedBitmapWidth == 0 ? update.processed : cv::Mat();
+            break;
+        default:
+            break;
+    }
+    if (source.empty()) {
+        return;
+    }
+    update.hardwareFrame = writeHardwareFrame(source);
+    if (update.hardwareFrame) {
+        update.hardwareFrameSource = source;
+    }
+}
+
+// The pipeline whose frames are the right view of DEPTH (a second camera's,
+// from nativeCreatePipeline); null = none
+static std::atomic<PipelineContext*> stereoRightPipeline{nullptr};
+
+// Every frame of the right view's pipeline, whatever its own mode
+static void offerStereoView(const PipelineContext& pipeline, const cv::Mat& luma, int64_t timestampNs) {
+    if (stereoRightPipeline.load(std::memory_order_relaxed) != &pipeline) {
+        return;
+    }
+    try {
+        stereoDepth().offerRight(luma, timestampNs);
+    } catch (const cv::Exception& e) {
+        LOGE_RATELIMITED("❌ Stereo right view failed: %s", e.what());
+    }
+}
+
+// DEPTH: the frame's whole luma is the left view. Without a right view close
+// enough in time the last disparity stays published.
+static void storeDepth(const IngestFrame& frame, PublishedFrame& update) {
+    ScopedStageTimer timer(Stage::STEREO_DEPTH);
+    StereoDepth& depth = stereoDepth();
+    const cv::Size size = depth.reducedSize(frame.luma.size());
+    if (size.empty()) {
+        return;
+    }
+    cv::Mat rgba = framePool().acquire(size.height, size.width, CV_8UC4);
+    try {
+        if (depth.compute(frame.luma, frame.timestampNs, rgba)) {
+            update.depth = rgba;
+            update.hasDepth = true;
+        }
+    } catch (const cv::Exception& e) {
+        LOGE_RATELIMITED("❌ Stereo depth failed: %s", e.what());
+    }
+}
+
+// Step 3 on either path
+// fusedGray: the legacy path's gray from convertForVariants, or empty
+static void buildFrameVariants(const IngestFrame& frame, const cv::Mat& bgr, const cv::Mat& fusedGray, bool fromLuma,
+                               int rotation, unsigned variants, PublishedFrame& update) {
+    if (variants & VARIANT_SHARED_EDGES) {
+        variants &= ~VARIANT_SHARED_EDGES;
+        if (!storeSharedEdges(frame, bgr, fusedGray, fromLuma, update)) {
+            variants |= VARIANT_EDGES;  // CPU Canny for this frame
+        }
+    }
+    if (variants & VARIANT_DEPTH) {
+        storeDepth(frame, update);
+    }
+    if (fromLuma) {
+        storeVariantsFromLuma(frame, bgr, rotation, variants, update);
+    } else {
+        storeVariantsFromBgr(bgr, fusedGray, rotation, variants, frame.timestampNs, update);
+    }
+    storeHardwareFrame(update);
+}
+
+// The configured extra output sizes of the whole Y plane (scaled_outputs.h),
+// made once here for every fan-out consumer; only while one listens
+static void storeScaledLuma(const PipelineContext& pipeline, const IngestFrame& frame, PublishedFrame& update) {
+    if (&pipeline != &defaultPipeline || !scaledOutputs().active() || !frameFanout().hasConsumers()) {
+        return;
+    }
+    ScopedStageTimer timer(Stage::DOWNSCALE);
+    try {
+        update.scaledLuma = scaledOutputs().produce(frame.luma, framePool());
+    } catch (const cv::Exception& e) {
+        LOGE_RATELIMITED("❌ Scaled luma outputs failed: %s", e.what());
+    }
+}
+
+// Pipeline-owned packed NV21 frame as an IngestFrame; the converter holds its
+// own reference to the buffer
+static IngestFrame nv21IngestFrame(const cv::Mat& yuv, int width, int height, int64_t timestampNs) {
+    IngestFrame frame;
+    frame.timestampNs = timestampNs;
+    frame.luma = yuv.rowRange(0, height);
+    frame.chroma = cv::Mat(height / 2, width / 2, CV_8UC2, const_cast<uchar*>(yuv.ptr(height)), width);
+    frame.convertToBgr = [yuv](cv::Mat& bgr) {
+        cv::cvtColor(yuv, bgr, cv::COLOR_YUV2BGR_NV21);
+        return true;
+    };
+    frame.convertToRgba = [yuv](cv::Mat& rgba) {
+        cv::cvtColor(yuv, rgba, cv::COLOR_YUV2RGBA_NV21);
+        return true;
+    };
+    return frame;
+}
+
+// What a frozen frame is published again for (freeze_frame.h): the
+// thresholds and pre-blur Canny reads, the mode and any new control block
+// version, which covers ROI and scale
+static uint64_t frozenSettingsKey(RenderMode mode) {
+    int low = 0;
+    int high = 0;
+    currentCannyThresholds(low, high);
+    const uint64_t version = controlBlock().version.load(std::memory_order_acquire);
+    return version << 32 | static_cast<uint64_t>(mode) << 24 | static_cast<uint64_t>(edgePreBlurEnabled()) << 16 |
+           static_cast<uint64_t>(high & 0xff) << 8 | static_cast<uint64_t>(low & 0xff);
+}
+
+// Freeze-frame tuning on the default pipeline: false drops the camera frame;
+// true with held set processes the held NV21 frame (of size, at rotation)
+// instead of the camera's
+static bool admitFrozen(const cv::Mat& luma, const cv::Mat& vu, RenderMode mode, cv::Mat& held, cv::Size& size,
+                        int& rotation) {
+    return freezeFrame().admit(luma, vu, frozenSettingsKey(mode), held, size, rotation) != FreezeFrame::DROP;
+}
+
+static void storeFrameVariants(PipelineContext& pipeline, const IngestFrame& camera, int rotation) {
+    applyThreadPolicy();  // whichever thread processes: the worker or a synchronous caller
+    profileThread(ProfileRole::PROCESSING);
+    noteIngestGeometry(pipeline, camera.luma.size());
+    offerStereoView(pipeline, camera.luma, camera.timestampNs);
+    if (&pipeline == &defaultPipeline) {
+        framePacing().onIngest(camera.timestampNs);
+        applyControlBlock();
+        applyMemoryBudget();
+    }
+    const RenderMode mode = watchdogMode(pipeline, beginFrameRenderMode(pipeline));
+    const uint32_t modes = modesToBuild(pipeline, mode);
+    unsigned variants = variantsForModes(modes);
+    if (variants == 0 || isStale(camera.timestampNs) || governorSkips() ||
+        halfRateSkips(pipeline, camera.luma, camera.timestampNs)) {
+        return;
+    }
+    const CaptureMetadataGate::Decision capture = captureDecision(pipeline, camera.timestampNs, variants);
+    if (capture == CaptureMetadataGate::SKIP) {
+        return;  // the last published edges stay on screen
+    }
+    IngestFrame heldFrame;
+    if (&pipeline == &defaultPipeline) {
+        cv::Mat held;
+        cv::Size size;
+        if (!admitFrozen(camera.luma, camera.chroma, mode, held, size, rotation)) {
+            return;  // frozen, and nothing changed since the held frame was published
+        }
+        if (!held.empty()) {
+            heldFrame = nv21IngestFrame(held, size.width, size.height, camera.timestampNs);
+        }
+    }
+    const IngestFrame& frame = heldFrame.luma.empty() ? camera : heldFrame;
+    commitHalfRateReference(pipeline, !heldFrame.luma.empty(), camera.timestampNs);
+    UnsettledCaptureScope unsettled(capture == CaptureMetadataGate::CHEAP);
+    StallWatchdog* watchdog = &pipeline == &defaultPipeline ? &stallWatchdog() : nullptr;
+    if (watchdog) {
+        watchdog->frameStarted();
+    }
+    threadFrameStages().clear();
+    ScopedFrameArena arena;  // the frame's cv::Mat temporaries, rewound on return
+    ScopedFrameDeadline deadline(frameDeadlineNs(frame.timestampNs));
+    ForegroundWork foreground;
+    PublishedFrame update;
+    {
+        ScopedStageTimer timer(Stage::FRAME_TOTAL);
+        GovernorSample governorSample;
+        PerformanceHintScope hint(HintChannel::PROCESSING);
+        metrics().increment(Counter::FRAMES_PROCESSED);
+
+        const bool fromLuma = lumaFastPath.load(std::memory_order_relaxed);
+        variants = effectiveVariants(frame, variants, fromLuma);
+        cv::Mat bgr;
+        cv::Mat fusedGray;
+        update.renderMode = mode;
+        update.modesBuilt = modes;
+        {
+            PoolTurn turn;  // steps 2-3 are what runs on OpenCV's pool
+            if (watchdog) {
+                watchdog->stageEntered(Stage::YUV_TO_BGR);
+            }
+            if (!convertForVariants(frame, variants, fromLuma, bgr, fusedGray)) {
+                if (watchdog) {
+                    watchdog->frameFailed();
+                }
+                return;
+            }
+            buildFrameVariants(frame, bgr, fusedGray, fromLuma, rotation, variants, update);
+            storeScaledLuma(pipeline, frame, update);
+        }
+        update.captureTimestampNs = frame.timestampNs;
+        // Step 4
+        publishFrame(pipeline, update);
+        if (watchdog) {
+            watchdog->framePublished();
+        }
+    }
+    recordTelemetry(pipeline, update, frame.luma.size(), threadFrameStages());
+}
+
+// One frame moving through the pipelined worker (nativeSetPipelinedProcessing):
+// the worker thread runs steps 1-2, then one thread runs step 3 and another
+// step 4, so frame k + 1 converts while frame k is in Canny
+struct FrameJob {
+    PipelineContext* pipeline = &defaultPipeline;  // the worker feeds the default pipeline
+    PendingFrame input;        // keeps the NV21 buffer referenced until step 3 is done
+    unsigned variants = 0;
+    bool fromLuma = true;
+    bool unsettled = false;    // CHEAP capture metadata decision, applied in step 3
+    cv::Mat bgr;
+    cv::Mat fusedGray;         // see convertForVariants
+    PublishedFrame update;     // update.renderMode: the mode snapshot taken in step 1
+    cv::Size size;             // camera frame, for telemetry
+    FrameStageTimes stages;    // accumulated across the three threads
+};
+
+static StagePipeline<FrameJob> framePipeline;
+
+// Step 3: gray, edges and the analysis variants
+static bool processJob(FrameJob& job) {
+    applyThreadPolicy();
+    profileThread(ProfileRole::PROCESSING);
+    const PendingFrame& input = job.input;
+    if (isStale(input.timestampNs)) {
+        stallWatchdog().frameDropped();
+        return false;  // waited too long behind the previous frame
+    }
+    threadFrameStages().clear();
+    {
+        ScopedStageTimer timer(Stage::FRAME_TOTAL);  // per frame, excluding conversion
+        GovernorSample governorSample;  // step 3 is what bounds the pipelined frame rate
+        PerformanceHintScope hint(HintChannel::PROCESSING);
+        metrics().increment(Counter::FRAMES_PROCESSED);
+        ScopedFrameArena arena;
+        ScopedFrameDeadline deadline(frameDeadlineNs(input.timestampNs));
+        ForegroundWork foreground;
+        PoolTurn turn;
+        UnsettledCaptureScope unsettled(job.unsettled);
+        buildFrameVariants(nv21IngestFrame(input.nv21, input.width, input.height, input.timestampNs), job.bgr,
+                           job.fusedGray, job.fromLuma, input.rotation, job.variants, job.update);
+        job.update.captureTimestampNs = input.timestampNs;
+        job.input = PendingFrame();
+    }
+    job.stages.add(threadFrameStages());
+    return true;
+}
+
+// Step 4
+static bool publishJob(FrameJob& job) {
+    profileThread(ProfileRole::PROCESSING);
+    threadFrameStages().clear();
+    publishFrame(*job.pipeline, job.update);
+    stallWatchdog().framePublished();
+    job.stages.add(threadFrameStages());
+    recordTelemetry(*job.pipeline, job.update, job.size, job.stages);
+    return true;
+}
+
+// Steps 1-2 on the worker thread, then into the pipeline (or straight
+// through when it stopped meanwhile)
+static void convertAndSubmit(const PendingFrame& frame) {
+    applyThreadPolicy();
+    profileThread(ProfileRole::PROCESSING);
+    FrameJob job;
+    noteIngestGeometry(*job.pipeline, cv::Size(frame.width, frame.height));
+    offerStereoView(*job.pipeline, frame.nv21.rowRange(0, frame.height), frame.timestampNs);
+    applyControlBlock();
+    applyMemoryBudget();
+    job.update.renderMode = watchdogMode(*job.pipeline, beginFrameRenderMode(*job.pipeline));
+    captureFrame(frame.nv21.data, frame.width, frame.height, frame.rotation, job.update.renderMode,
+                 frame.timestampNs);
+    burstSelector().offer(frame.nv21, frame.width, frame.height, frame.rotation, frame.timestampNs);
+    job.update.modesBuilt = modesToBuild(*job.pipeline, static_cast<RenderMode>(job.update.renderMode));
+    job.variants = variantsForModes(job.update.modesBuilt);
+    if (job.variants == 0 || isStale(frame.timestampNs) || governorSkips() ||
+        halfRateSkips(*job.pipeline, frame.nv21.rowRange(0, frame.height), frame.timestampNs)) {
+        return;
+    }
+    const CaptureMetadataGate::Decision capture = captureDecision(*job.pipeline, frame.timestampNs, job.variants);
+    if (capture == CaptureMetadataGate::SKIP) {
+        return;
+    }
+    job.input = frame;
+    cv::Mat held;
+    cv::Size size;
+    const cv::Mat vu(frame.height / 2, frame.width / 2, CV_8UC2, const_cast<uchar*>(frame.nv21.ptr(frame.height)),
+                     frame.width);
+    if (!admitFrozen(frame.nv21.rowRange(0, frame.height), vu, static_cast<RenderMode>(job.update.renderMode), held,
+                     size, job.input.rotation)) {
+        return;
+    }
+    if (!held.empty()) {
+        job.input.nv21 = held;
+        job.input.width = size.width;
+        job.input.height = size.height;
+    }
+    job.unsettled = capture == CaptureMetadataGate::CHEAP;
+    commitHalfRateReference(*job.pipeline, !held.empty(), frame.timestampNs);
+    stallWatchdog().frameStarted();
+    stallWatchdog().stageEntered(Stage::YUV_TO_BGR);
+    threadFrameStages().clear();
+    job.size = cv::Size(frame.width, frame.height);
+    job.fromLuma = lumaFastPath.load(std::memory_order_relaxed);
+    const PendingFrame& input = job.input;
+    const IngestFrame ingest = nv21IngestFrame(input.nv21, input.width, input.height, input.timestampNs);
+    job.variants = effectiveVariants(ingest, job.variants, job.fromLuma);
+    if (!convertForVariants(ingest, job.variants, job.fromLuma, job.bgr, job.fusedGray)) {
+        stallWatchdog().frameFailed();
+        return;
+    }
+    job.stages = threadFrameStages();
+    if (!framePipeline.submit(job) && processJob(job)) {
+        publishJob(job);
+    }
+}
+
+// Common frame processing logic
+void processFrameInternal(jbyte* frameData, jint width, jint height, jint rotation = 0, int64_t timestampNs = 0) {
+    ScopedTrace trace("processFrameInternal");
+    LOGD("🔄 [STEP 1] Processing frame with size: %dx%d, rotation: %d°", width, height, rotation);
+
+    if (!frameData) {
+        LOGE_RATELIMITED("❌ [STEP 1] frameData is null — skipping");
+        return;
+    }
+    LOGD("✅ [STEP 1] frameData obtained successfully");
+
+    int yuvHeight = height + height / 2;
+    cv::Mat yuv(yuvHeight, width, CV_8UC1, reinterpret_cast<unsigned char*>(frameData));
+    timestampNs = captureTimestamp(timestampNs);
+    captureFrame(yuv.data, width, height, rotation, static_cast<int>(activeRenderMode(defaultPipeline)), timestampNs);
+    burstSelector().offer(yuv, width, height, rotation, timestampNs);
+    storeFrameVariants(defaultPipeline, nv21IngestFrame(yuv, width, height, timestampNs), rotation);
+}
+
+// While the worker is stuck in a frame and the stall watchdog passes frames
+// through, the ingesting thread publishes each frame's luma itself, so the
+// display keeps moving. Not a heartbeat: the watchdog still sees the hang.
+static void passThroughWhileHung(PipelineContext& pipeline, const cv::Mat& luma, int64_t timestampNs) {
+    StallWatchdog& watchdog = stallWatchdog();
+    if (&pipeline != &defaultPipeline || watchdog.level() != StallWatchdog::PASSTHROUGH || !watchdog.hung()) {
+        return;
+    }
+    PublishedFrame update;
+    update.renderMode = GRAYSCALE;
+    update.grayscale = framePool().acquire(luma.rows, luma.cols, CV_8UC1);
+    luma.copyTo(update.grayscale);
+    update.captureTimestampNs = timestampNs;
+    publishFrame(pipeline, update);
+}
+
+// Plane-based ingest (native camera, YUV_420_888 from Java): converts straight
+// from the image planes, honouring row and pixel strides, so no packed NV21 copy
+// is ever built.
+void processYuvPlanes(const YuvPlanes& planes, int rotation, PipelineContext* target) {
+    if (!planes.y || !planes.u || !planes.v) {
+        LOGE_RATELIMITED("❌ [STEP 1] YUV planes missing — skipping");
+        return;
+    }
+
+    PipelineContext& pipeline = target ? *target : defaultPipeline;
+    if (pipeline.worker.isRunning()) {
+        // The planes go back to their producer on return, so queue a packed copy
+        PendingFrame pending;
+        pending.nv21 = framePool().acquire(planes.height + planes.height / 2, planes.width, CV_8UC1);
+        pending.width = planes.width;
+        pending.height = planes.height;
+        pending.rotation = rotation;
+        pending.timestampNs = captureTimestamp(planes.timestampNs);
+        {
+            ScopedStageTimer timer(Stage::INGEST_COPY);
+            packYuvPlanesToNv21(planes, pending.nv21);
+        }
+        passThroughWhileHung(pipeline, pending.nv21.rowRange(0, planes.height), pending.timestampNs);
+        if (!pipeline.worker.submit(std::move(pending))) {
+            metrics().increment(Counter::FRAMES_DROPPED);
+        }
+        return;
+    }
+
+    IngestFrame frame;
+    frame.timestampNs = captureTimestamp(planes.timestampNs);
+    frame.luma = cv::Mat(planes.height, planes.width, CV_8UC1,
+                         const_cast<uint8_t*>(planes.y), planes.yRowStride);
+    if (planes.uvPixelStride == 2 && planes.u == planes.v + 1) {
+        // Semi-planar VU: the V plane pointer already is an NV21 chroma view
+        frame.chroma = cv::Mat(planes.height / 2, planes.width / 2, CV_8UC2,
+                               const_cast<uint8_t*>(planes.v), planes.uvRowStride);
+    }
+    frame.hardwareBuffer = planes.hardwareBuffer;
+    frame.convertToBgr = [&planes](cv::Mat& bgr) {
+        if (!convertYuvPlanesToBgr(planes, bgr)) {
+            LOGE_RATELIMITED("❌ [STEP 2] Unsupported chroma pixel stride: %d", planes.uvPixelStride);
+            return false;
+        }
+        return true;
+    };
+    frame.convertToRgba = [&planes](cv::Mat& rgba) {
+        return convertYuvPlanesToRgba(planes, rgba);
+    };
+    storeFrameVariants(pipeline, frame, rotation);
+}
+
+// P010 ingest: the words cannot be viewed as 8-bit planes, so the frame is
+// unpacked into a pooled NV21 buffer either way. Processed inline on the CPU
+// backend it also keeps the 10-bit luma for Canny; a frame queued for the
+// worker travels as plain NV21.
+void processP010Planes(const P010Planes& planes, int rotation, PipelineContext* target) {
+    if (!planes.y || !planes.uv) {
+        LOGE_RATELIMITED("❌ [STEP 1] P010 planes missing — skipping");
+        return;
+    }
+
+    PipelineContext& pipeline = target ? *target : defaultPipeline;
+    FramePool& pool = framePool();
+    const bool queued = pipeline.worker.isRunning();
+    cv::Mat nv21 = pool.acquire(planes.height + planes.height / 2, planes.width, CV_8UC1);
+    cv::Mat luma10;
+    if (!queued && edgeBackend.load(std::memory_order_relaxed) == EDGE_BACKEND_CPU) {
+        luma10 = pool.acquire(planes.height, planes.width, CV_16SC1);
+    }
+    bool unpacked;
+    {
+        ScopedStageTimer timer(Stage::INGEST_COPY);
+        if (luma10.empty()) {
+            unpacked = packP010PlanesToNv21(planes, nv21);
+        } else {
+            cv::Mat luma = nv21.rowRange(0, planes.height);
+            cv::Mat vu(planes.height / 2, planes.width / 2, CV_8UC2, nv21.ptr(planes.height), nv21.step);
+            unpacked = unpackP010Planes(planes, luma, &luma10, vu);
+        }
+    }
+    if (!unpacked) {
+        LOGE_RATELIMITED("❌ [STEP 1] Unsupported P010 frame %dx%d — skipping", planes.width, planes.height);
+        return;
+    }
+
+    const int64_t timestampNs = captureTimestamp(planes.timestampNs);
+    if (queued) {
+        PendingFrame pending;
+        pending.nv21 = nv21;
+        pending.width = planes.width;
+        pending.height = planes.height;
+        pending.rotation = rotation;
+        pending.timestampNs = timestampNs;
+        passThroughWhileHung(pipeline, nv21.rowRange(0, planes.height), timestampNs);
+        if (!pipeline.worker.submit(std::move(pending))) {
+            metrics().increment(Counter::FRAMES_DROPPED);
+        }
+        return;
+    }
+    IngestFrame frame = nv21IngestFrame(nv21, planes.width, planes.height, timestampNs);
+    frame.luma10 = luma10;
+    storeFrameVariants(pipeline, frame, rotation);
+}
+
+// Bayer ingest: the binned quarter-size frame is built in a pooled NV21
+// buffer, which the worker can queue as it is
+void processRawPlanes(const RawPlanes& planes, int rotation, PipelineContext* target) {
+    if (!planes.data) {
+        LOGE_RATELIMITED("❌ [STEP 1] RAW plane missing — skipping");
+        return;
+    }
+
+    PipelineContext& pipeline = target ? *target : defaultPipeline;
+    const cv::Size size = binnedSize(planes);
+    cv::Mat nv21 = framePool().acquire(size.height + size.height / 2, size.width, CV_8UC1);
+    bool binned;
+    {
+        ScopedStageTimer timer(Stage::INGEST_COPY);
+        binned = binRawPlanesToNv21(planes, nv21);
+    }
+    if (!binned) {
+        LOGE_RATELIMITED("❌ [STEP 1] Unsupported RAW frame %dx%d — skipping", planes.width, planes.height);
+        return;
+    }
+
+    PendingFrame pending;
+    pending.nv21 = nv21;
+    pending.width = size.width;
+    pending.height = size.height;
+    pending.rotation = rotation;
+    pending.timestampNs = captureTimestamp(planes.timestampNs);
+    if (pipeline.worker.isRunning()) {
+        passThroughWhileHung(pipeline, nv21.rowRange(0, size.height), pending.timestampNs);
+        if (!pipeline.worker.submit(std::move(pending))) {
+            metrics().increment(Counter::FRAMES_DROPPED);
+        }
+        return;
+    }
+    storeFrameVariants(pipeline, nv21IngestFrame(nv21, size.width, size.height, pending.timestampNs), rotation);
+}
+
+bool ingestWantsHardwareBuffers() {
+    return edgeBackend.load(std::memory_order_relaxed) == EDGE_BACKEND_VULKAN && vulkanEdgesImportCamera();
+}
+
+// Hands a pipeline-owned NV21 frame to the worker, or processes it inline when
+// the worker is not running
+static void dispatchFrame(PendingFrame&& frame) {
+    if (defaultPipeline.worker.isRunning()) {
+        passThroughWhileHung(defaultPipeline, frame.nv21.rowRange(0, frame.height), frame.timestampNs);
+        if (!defaultPipeline.worker.submit(std::move(frame))) {
+            metrics().increment(Counter::FRAMES_DROPPED);
+            LOGD("⚠️ Worker busy, dropped oldest pending frame");
+        }
+        return;
+    }
+    processFrameInternal(reinterpret_cast<jbyte*>(frame.nv21.data), frame.width, frame.height, frame.rotation,
+                         frame.timestampNs);
+}
+
+// Shown until a frame for the mode is published; read-only once built, so
+// every GL thread shares it. Built at its first draw or by nativeWarmup.
+static const cv::Mat& renderFallbackFrame() {
+    static const cv::Mat fallback = [] {
+        // Make it clearly visible for debugging - blue frame
+        cv::Mat frame(480, 640, CV_8UC3, cv::Scalar(255, 0, 0)); // Blue in BGR
+        LOGI("✅ [RENDER] Created blue fallback frame: 640x480");
+        return frame;
+    }();
+    return fallback;
+}
+
+// Warm-up before the first camera frame: kWarmupFramesPerMode synthetic
+// frames through every render mode on a private pipeline, so OpenCV's lazy
+// initialization, the backends' one-off setup (AUTO calibration, G-API
+// compilation) and the first touch of every pooled buffer the modes use
+// happen now. Nothing is displayed, streamed or counted: the detectors start
+// over and the stage metrics are cleared afterwards. Returns milliseconds.
+static const int kWarmupFramesPerMode = 3;
+
+static double warmupPipeline(int width, int height) {
+    const int64_t start = bootTimeNanos();
+    SyntheticConfig config;
+    config.width = width;
+    config.height = height;
+    cv::Mat scenes[2];  // two positions of the drifting scene, so flow and motion see movement
+    SyntheticFrameSource::renderFrame(config, 0, scenes[0]);
+    SyntheticFrameSource::renderFrame(config, 8, scenes[1]);
+    renderFallbackFrame();
+
+    PipelineContext warm;
+    noteIngestGeometry(warm, cv::Size(width, height));
+    warmingUp = true;
+    int frames = 0;
+    for (int mode = 0; mode < kRenderModeCount; mode++) {
+        switchRenderMode(warm, static_cast<RenderMode>(mode));  // pre-acquires the mode's buffers
+        for (int i = 0; i < kWarmupFramesPerMode; i++) {
+            // The ingest copy lands in a pooled buffer, as camera frames do
+            cv::Mat nv21 = framePool().acquire(height + height / 2, width, CV_8UC1);
+            scenes[frames++ & 1].copyTo(nv21);
+            storeFrameVariants(warm, nv21IngestFrame(nv21, width, height, bootTimeNanos()), 0);
+        }
+    }
+    warmingUp = false;
+    pointTracker().reset();
+    motionDetector().reset();
+    documentDetector().reset();
+    metrics().reset();
+    const double millis = (bootTimeNanos() - start) / 1e6;
+    LOGI("✅ Warm-up: %d frames at %dx%d through %d modes in %.1f ms, pool %zu buffers / %zu KiB", frames, width,
+         height, kRenderModeCount, millis, framePool().bufferCount(), framePool().bytesHeld() / 1024);
+    return millis;
+}
+
+// Copies a Java byte[] straight into a pooled buffer (one copy, no pinning)
+static void submitByteArray(JNIEnv* env, jbyteArray frameData_, jint width, jint height, jint rotation,
+                            int64_t timestampNs) {
+    jsize size = width * (height + height / 2);
+    if (env->GetArrayLength(frameData_) < size) {
+        LOGE_RATELIMITED("❌ Frame array too small for %dx%d NV21", width, height);
+        return;
+    }
+
+    PendingFrame frame;
+    frame.nv21 = framePool().acquire(height + height / 2, width, CV_8UC1);
+    frame.width = width;
+    frame.height = height;
+    frame.rotation = rotation;
+    frame.timestampNs = captureTimestamp(timestampNs);
+    {
+        ScopedStageTimer timer(Stage::INGEST_COPY);
+        env->GetByteArrayRegion(frameData_, 0, size, reinterpret_cast<jbyte*>(frame.nv21.data));
+    }
+    dispatchFrame(std::move(frame));
+}
+
+// Original JNI function (backward compatibility)
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeProcessFrame(JNIEnv *env, jclass clazz,
+                                                                   jbyteArray frameData_,
+                                                                   jint width, jint height) {
+    if (defaultPipeline.worker.isRunning()) {
+        submitByteArray(env, frameData_, width, height, 0, 0);
+        return;
+    }
+    jbyte* frameData = env->GetByteArrayElements(frameData_, nullptr);
+    processFrameInternal(frameData, width, height, 0); // No rotation
+    env->ReleaseByteArrayElements(frameData_, frameData, JNI_ABORT);
+}
+
+static void processByteArray(JNIEnv* env, jbyteArray frameData_, jint width, jint height, jint rotation,
+                             int64_t timestampNs) {
+    if (defaultPipeline.worker.isRunning()) {
+        submitByteArray(env, frameData_, width, height, rotation, timestampNs);
+        return;
+    }
+    jbyte* frameData = env->GetByteArrayElements(frameData_, nullptr);
+    processFrameInternal(frameData, width, height, rotation, timestampNs);
+    env->ReleaseByteArrayElements(frameData_, frameData, JNI_ABORT);
+}
+
+// New JNI function with rotation support
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeProcessFrameWithRotation(JNIEnv *env, jclass clazz,
+                                                                               jbyteArray frameData_,
+                                                                               jint width, jint height, jint rotation) {
+    processByteArray(env, frameData_, width, height, rotation, 0);
+}
+
+// Same with the camera's sensor timestamp (Image.getTimestamp(), ns), which
+// latency metrics and the latency budget are measured from
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeProcessFrameWithTimestamp(JNIEnv *env, jclass clazz,
+                                                                                jbyteArray frameData_,
+                                                                                jint width, jint height, jint rotation,
+                                                                                jlong timestampNs) {
+    processByteArray(env, frameData_, width, height, rotation, timestampNs);
+}
+
+// Zero-copy ingest: the NV21 data lives in a direct ByteBuffer, so the address is
+// wrapped as-is instead of going through GetByteArrayElements (which may copy).
+// Buffers from nativeAllocateFrameBuffers are referenced while their frame is
+// processed, by the worker or synchronously; with the worker running, any
+// other direct buffer is copied into the pool first.
+static void processDirectBuffer(JNIEnv* env, jobject frameBuffer, jint width, jint height, jint rotation,
+                                int64_t timestampNs) {
+    auto* frameData = static_cast<jbyte*>(env->GetDirectBufferAddress(frameBuffer));
+    if (!frameData) {
+        LOGE_RATELIMITED("❌ nativeProcessFrameDirect: buffer is not a direct ByteBuffer");
+        return;
+    }
+
+    jlong capacity = env->GetDirectBufferCapacity(frameBuffer);
+    jlong required = static_cast<jlong>(width) * (height + height / 2);
+    if (capacity < required) {
+        LOGE_RATELIMITED("❌ nativeProcessFrameDirect: buffer too small (%lld < %lld bytes)",
+             static_cast<long long>(capacity), static_cast<long long>(required));
+        return;
+    }
+
+    PendingFrame frame;
+    frame.width = width;
+    frame.height = height;
+    frame.rotation = rotation;
+    frame.timestampNs = captureTimestamp(timestampNs);
+    {
+        std::lock_guard<std::mutex> lock(ingestBufferMutex);
+        for (const cv::Mat& buffer : ingestBuffers) {
+            if (buffer.data == reinterpret_cast<uchar*>(frameData)) {
+                // Reference keeps the buffer marked busy (and allocated) until the frame is done
+                frame.nv21 = buffer.colRange(0, static_cast<int>(required)).reshape(1, height + height / 2);
+                break;
+            }
+        }
+    }
+
+    if (!defaultPipeline.worker.isRunning()) {
+        processFrameInternal(frameData, width, height, rotation, timestampNs);
+        return;  // frame.nv21, if any, is dropped only now
+    }
+
+    if (frame.nv21.empty()) {
+        ScopedStageTimer timer(Stage::INGEST_COPY);
+        cv::Mat view(height + height / 2, width, CV_8UC1, frameData);
+        frame.nv21 = framePool().copyOf(view);
+    }
+    dispatchFrame(std::move(frame));
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeProcessFrameDirect(JNIEnv *env, jclass clazz,
+                                                                         jobject frameBuffer,
+                                                                         jint width, jint height, jint rotation) {
+    processDirectBuffer(env, frameBuffer, width, height, rotation, 0);
+}
+
+// Direct buffer ingest with the sensor timestamp (ns, CLOCK_BOOTTIME)
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeProcessFrameDirectWithTimestamp(JNIEnv *env, jclass clazz,
+                                                                                      jobject frameBuffer,
+                                                                                      jint width, jint height,
+                                                                                      jint rotation, jlong timestampNs) {
+    processDirectBuffer(env, frameBuffer, width, height, rotation, timestampNs);
+}
+
+// Stride-aware YUV_420_888 ingest: Java passes the three Image planes as direct
+// buffers together with their strides, so it no longer has to repack to NV21.
+static void processPlaneBuffers(JNIEnv* env, jobject yBuffer, jobject uBuffer, jobject vBuffer,
+                                jint yRowStride, jint uvRowStride, jint uvPixelStride,
+                                jint width, jint height, jint rotation, int64_t timestampNs) {
+    YuvPlanes planes;
+    planes.timestampNs = timestampNs;
+    planes.y = static_cast<const uint8_t*>(env->GetDirectBufferAddress(yBuffer));
+    planes.u = static_cast<const uint8_t*>(env->GetDirectBufferAddress(uBuffer));
+    planes.v = static_cast<const uint8_t*>(env->GetDirectBufferAddress(vBuffer));
+    planes.yRowStride = yRowStride;
+    planes.uvRowStride = uvRowStride;
+    planes.uvPixelStride = uvPixelStride;
+    planes.width = width;
+    planes.height = height;
+
+    if (!planes.y || !planes.u || !planes.v) {
+        LOGE_RATELIMITED("❌ nativeProcessYuvPlanes: planes must be direct ByteBuffers");
+        return;
+    }
+
+    // The last row of each plane may be shorter than its stride
+    jlong yRequired = static_cast<jlong>(yRowStride) * (height - 1) + width;
+    jlong uvRequired = static_cast<jlong>(uvRowStride) * (height / 2 - 1) +
+                       static_cast<jlong>(uvPixelStride) * (width / 2 - 1) + 1;
+    if (env->GetDirectBufferCapacity(yBuffer) < yRequired ||
+        env->GetDirectBufferCapacity(uBuffer) < uvRequired ||
+        env->GetDirectBufferCapacity(vBuffer) < uvRequired) {
+        LOGE_RATELIMITED("❌ nativeProcessYuvPlanes: plane buffers smaller than strides imply");
+        return;
+    }
+
+    processYuvPlanes(planes, rotation);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeProcessYuvPlanes(JNIEnv *env, jclass clazz,
+                                                                       jobject yBuffer, jobject uBuffer, jobject vBuffer,
+                                                                       jint yRowStride, jint uvRowStride, jint uvPixelStride,
+                                                                       jint width, jint height, jint rotation) {
+    processPlaneBuffers(env, yBuffer, uBuffer, vBuffer, yRowStride, uvRowStride, uvPixelStride,
+                        width, height, rotation, 0);
+}
+
+// Plane ingest with the sensor timestamp (Image.getTimestamp(), ns)
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeProcessYuvPlanesWithTimestamp(JNIEnv *env, jclass clazz,
+                                                                                    jobject yBuffer, jobject uBuffer,
+                                                                                    jobject vBuffer, jint yRowStride,
+                                                                                    jint uvRowStride, jint uvPixelStride,
+                                                                                    jint width, jint height, jint rotation,
+                                                                                    jlong timestampNs) {
+    processPlaneBuffers(env, yBuffer, uBuffer, vBuffer, yRowStride, uvRowStride, uvPixelStride,
+                        width, height, rotation, timestampNs);
+}
+
+// 10-bit HDR ingest (ImageFormat.YCBCR_P010): the Image's Y and UV planes as
+// direct buffers with their row strides in bytes, pixel stride 2 bytes
+// (processP010Planes)
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeProcessP010(JNIEnv *env, jclass clazz, jobject yBuffer,
+                                                                  jobject uvBuffer, jint yRowStride, jint uvRowStride,
+                                                                  jint width, jint height, jint rotation,
+                                                                  jlong timestampNs) {
+    P010Planes planes;
+    planes.timestampNs = timestampNs;
+    planes.y = static_cast<const uint16_t*>(env->GetDirectBufferAddress(yBuffer));
+    planes.uv = static_cast<const uint16_t*>(env->GetDirectBufferAddress(uvBuffer));
+    planes.yRowStride = yRowStride;
+    planes.uvRowStride = uvRowStride;
+    planes.width = width;
+    planes.height = height;
+    if (!planes.y || !planes.uv) {
+        LOGE_RATELIMITED("❌ nativeProcessP010: planes must be direct ByteBuffers");
+        return;
+    }
+    if (width <= 0 || height <= 0 || (width | height) & 1 || yRowStride < 2 * width || uvRowStride < 2 * width ||
+        (yRowStride | uvRowStride) & 1) {
+        LOGE_RATELIMITED("❌ nativeProcessP010: invalid geometry %dx%d, strides %d/%d", width, height, yRowStride,
+                         uvRowStride);
+        return;
+    }
+    // The last row of each plane may be shorter than its stride
+    const jlong yRequired = static_cast<jlong>(yRowStride) * (height - 1) + 2 * width;
+    const jlong uvRequired = static_cast<jlong>(uvRowStride) * (height / 2 - 1) + 2 * width;
+    if (env->GetDirectBufferCapacity(yBuffer) < yRequired || env->GetDirectBufferCapacity(uvBuffer) < uvRequired) {
+        LOGE_RATELIMITED("❌ nativeProcessP010: plane buffers smaller than strides imply");
+        return;
+    }
+    processP010Planes(planes, rotation);
+}
+
+// Bayer ingest (ImageFormat.RAW_SENSOR or RAW10, processRawPlanes): the
+// Image's single plane as a direct buffer with its row stride in bytes.
+// format: 0 = RAW16, 1 = RAW10; whiteLevel: the RAW16 samples' largest value
+// (SENSOR_INFO_WHITE_LEVEL), ignored for RAW10.
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeProcessRaw(JNIEnv *env, jclass clazz, jobject buffer,
+                                                                 jint format, jint rowStride, jint width, jint height,
+                                                                 jint whiteLevel, jint rotation, jlong timestampNs) {
+    RawPlanes planes;
+    planes.timestampNs = timestampNs;
+    planes.data = static_cast<const uint8_t*>(env->GetDirectBufferAddress(buffer));
+    planes.rowStride = rowStride;
+    planes.width = width;
+    planes.height = height;
+    planes.whiteLevel = whiteLevel;
+    if (!planes.data) {
+        LOGE_RATELIMITED("❌ nativeProcessRaw: the plane must be a direct ByteBuffer");
+        return;
+    }
+    if (format != RawPlanes::RAW16 && format != RawPlanes::RAW10) {
+        LOGE_RATELIMITED("❌ nativeProcessRaw: unknown format %d", format);
+        return;
+    }
+    planes.format = static_cast<RawPlanes::Format>(format);
+    const jlong rowBytes = format == RawPlanes::RAW10 ? static_cast<jlong>(width) / 4 * 5 : 2LL * width;
+    if (width < 4 || height < 4 || rowStride < rowBytes || (format == RawPlanes::RAW16 && whiteLevel <= 0)) {
+        LOGE_RATELIMITED("❌ nativeProcessRaw: invalid geometry %dx%d, stride %d, white level %d", width, height,
+                         rowStride, whiteLevel);
+        return;
+    }
+    // The last row may be shorter than its stride
+    if (env->GetDirectBufferCapacity(buffer) < static_cast<jlong>(rowStride) * (height - 1) + rowBytes) {
+        LOGE_RATELIMITED("❌ nativeProcessRaw: plane buffer smaller than the stride implies");
+        return;
+    }
+    processRawPlanes(planes, rotation);
+}
+
+// Offline edge detection over a recorded burst (batch_processor.h): count =
+// offsets.length NV21 frames of width x height in one direct buffer, frame i
+// at offsets[i]; edge map i (downscaled, CV_8UC1, tightly packed) goes to
+// output at i * nativeBatchOutputFrameBytes(). One JNI crossing per burst,
+// frames run in parallel, and no live preview state is read or written.
+// Returns the number of frames processed, or -1 when a range is out of bounds.
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeProcessBatch(JNIEnv *env, jclass clazz, jobject input,
+                                                                   jlongArray offsets, jint width, jint height,
+                                                                   jint downscale, jint lowThreshold,
+                                                                   jint highThreshold, jboolean preBlur,
+                                                                   jobject output) {
+    BatchParams params;
+    params.width = width;
+    params.height = height;
+    params.downscale = downscale;
+    params.lowThreshold = lowThreshold;
+    params.highThreshold = highThreshold;
+    params.preBlur = preBlur == JNI_TRUE;
+    const size_t outputFrameBytes = batchOutputFrameBytes(params);
+    auto* in = static_cast<uint8_t*>(input ? env->GetDirectBufferAddress(input) : nullptr);
+    auto* out = static_cast<uint8_t*>(output ? env->GetDirectBufferAddress(output) : nullptr);
+    if (!in || !out || !offsets || outputFrameBytes == 0 || lowThreshold < 0 || highThreshold < lowThreshold) {
+        LOGE("❌ nativeProcessBatch: direct buffers and valid geometry/thresholds required");
+        return -1;
+    }
+    const jsize count = env->GetArrayLength(offsets);
+    const int64_t inputCapacity = env->GetDirectBufferCapacity(input);
+    const int64_t outputCapacity = env->GetDirectBufferCapacity(output);
+    const int64_t inputFrameBytes = static_cast<int64_t>(width) * (height + height / 2);
+    if (static_cast<int64_t>(outputFrameBytes) * count > outputCapacity) {
+        LOGE("❌ nativeProcessBatch: output holds %lld bytes, %d frames need %lld", static_cast<long long>(outputCapacity),
+             count, static_cast<long long>(outputFrameBytes) * count);
+        return -1;
+    }
+    std::vector<int64_t> frameOffsets(static_cast<size_t>(count));
+    env->GetLongArrayRegion(offsets, 0, count, reinterpret_cast<jlong*>(frameOffsets.data()));
+    for (jsize i = 0; i < count; i++) {
+        if (frameOffsets[i] < 0 || frameOffsets[i] + inputFrameBytes > inputCapacity) {
+            LOGE("❌ nativeProcessBatch: frame %d at %lld overruns the %lld-byte input", i,
+                 static_cast<long long>(frameOffsets[i]), static_cast<long long>(inputCapacity));
+            return -1;
+        }
+    }
+    return processEdgeBatch(in, frameOffsets.data(), count, params, out);
+}
+
+// Bytes one edge map takes in nativeProcessBatch's output (0 = invalid geometry)
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeBatchOutputFrameBytes(JNIEnv *env, jclass clazz, jint width,
+                                                                            jint height, jint downscale) {
+    BatchParams params;
+    params.width = width;
+    params.height = height;
+    params.downscale = downscale;
+    return static_cast<jint>(batchOutputFrameBytes(params));
+}
+
+// Asynchronous edge requests (async_edge_queue.h). The callback object and its
+// method are resolved once at start; the queue thread attaches to the VM once
+// when it starts and detaches when it exits.
+static jobject asyncCallback = nullptr;        // global ref, owned while the queue runs
+static jmethodID asyncCallbackMethod = nullptr;
+static thread_local JNIEnv* asyncEnv = nullptr;
+
+static void completeAsyncRequest(const AsyncEdgeResult& result) {
+    auto output = static_cast<jobject>(result.tag);
+    if (asyncEnv) {
+        asyncEnv->CallVoidMethod(asyncCallback, asyncCallbackMethod, static_cast<jlong>(result.id),
+                                 result.ok ? output : nullptr, result.width, result.height,
+                                 static_cast<jlong>(result.timestampNs));
+        if (asyncEnv->ExceptionCheck()) {
+            asyncEnv->ExceptionDescribe();
+            asyncEnv->ExceptionClear();
+        }
+        asyncEnv->DeleteGlobalRef(output);
+    }
+}
+
+static void stopAsyncProcessing(JNIEnv* env) {
+    asyncEdgeQueue().stop();
+    if (asyncCallback) {
+        env->DeleteGlobalRef(asyncCallback);
+        asyncCallback = nullptr;
+    }
+}
+
+// Starts the request thread; callback implements
+// onFrameProcessed(long requestId, ByteBuffer edges, int width, int height, long timestampNs),
+// called once per accepted request with the caller's output buffer holding
+// the CV_8UC1 edge map (edges null when the request failed or was cancelled
+// by nativeStopAsyncProcessing). Returns false if the callback lacks the method.
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeStartAsyncProcessing(JNIEnv *env, jclass clazz,
+                                                                           jobject callback, jint downscale,
+                                                                           jint lowThreshold, jint highThreshold,
+                                                                           jboolean preBlur) {
+    if (!callback || downscale < 1 || lowThreshold < 0 || highThreshold < lowThreshold) {
+        LOGE("❌ nativeStartAsyncProcessing: callback and valid scale/thresholds required");
+        return JNI_FALSE;
+    }
+    stopAsyncProcessing(env);
+    jclass callbackClass = env->GetObjectClass(callback);
+    asyncCallbackMethod = env->GetMethodID(callbackClass, "onFrameProcessed", "(JLjava/nio/ByteBuffer;IIJ)V");
+    env->DeleteLocalRef(callbackClass);
+    if (!asyncCallbackMethod) {
+        env->ExceptionClear();
+        LOGE("❌ nativeStartAsyncProcessing: callback has no onFrameProcessed(long, ByteBuffer, int, int, long)");
+        return JNI_FALSE;
+    }
+    asyncCallback = env->NewGlobalRef(callback);
+
+    BatchParams params;
+    params.downscale = downscale;
+    params.lowThreshold = lowThreshold;
+    params.highThreshold = highThreshold;
+    params.preBlur = preBlur == JNI_TRUE;
+    AsyncEdgeQueue::Callbacks callbacks;
+    callbacks.threadStart = [] {
+        if (jniCache().vm->AttachCurrentThread(&asyncEnv, nullptr) != JNI_OK) {
+            asyncEnv = nullptr;
+            LOGE("❌ Could not attach the async edge thread; completions are dropped");
+        }
+    };
+    callbacks.complete = completeAsyncRequest;
+    callbacks.threadExit = [] {
+        if (asyncEnv) {
+            jniCache().vm->DetachCurrentThread();
+            asyncEnv = nullptr;
+        }
+    };
+    asyncEdgeQueue().start(params, std::move(callbacks));
+    return JNI_TRUE;
+}
+
+// Answers every request still queued with a null result, then ends the thread
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeStopAsyncProcessing(JNIEnv *env, jclass clazz) {
+    stopAsyncProcessing(env);
+}
+
+// Copies the Y plane (a direct buffer: YUV_420_888 plane 0 or the start of an
+// NV21 frame) and returns at once, so the Image can go back to its reader.
+// The edge map is written to output, which must stay untouched until the
+// callback returns it. Returns the request id, or 0 when the queue is not
+// running or already holds AsyncEdgeQueue::kMaxQueued requests.
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSubmitFrameAsync(JNIEnv *env, jclass clazz, jobject yBuffer,
+                                                                       jint yRowStride, jint width, jint height,
+                                                                       jlong timestampNs, jobject output) {
+    auto* y = static_cast<uint8_t*>(yBuffer ? env->GetDirectBufferAddress(yBuffer) : nullptr);
+    auto* out = static_cast<uint8_t*>(output ? env->GetDirectBufferAddress(output) : nullptr);
+    if (!y || !out || width <= 0 || height <= 0 || yRowStride < width ||
+        env->GetDirectBufferCapacity(yBuffer) < static_cast<jlong>(yRowStride) * (height - 1) + width) {
+        LOGE_RATELIMITED("❌ nativeSubmitFrameAsync: direct buffers and a Y plane of %dx%d (stride %d) required",
+                         width, height, yRowStride);
+        return 0;
+    }
+    jobject outputRef = env->NewGlobalRef(output);
+    const uint64_t id = asyncEdgeQueue().submit(y, yRowStride, width, height, captureTimestamp(timestampNs), out,
+                                                static_cast<size_t>(env->GetDirectBufferCapacity(output)), outputRef);
+    if (id == 0) {
+        env->DeleteGlobalRef(outputRef);
+        metrics().increment(Counter::FRAMES_DROPPED);
+    }
+    return static_cast<jlong>(id);
+}
+
+// Allocates a fixed set of native-owned direct buffers that Java fills and recycles
+// between frames. Any previously allocated set is replaced, so Java must drop its
+// references to old buffers before calling this again. Returns null, keeping the
+// old set, while a frame in one of them is still being processed.
+extern "C"
+JNIEXPORT jobjectArray JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeAllocateFrameBuffers(JNIEnv *env, jclass clazz,
+                                                                           jint count, jint capacity) {
+    if (count <= 0 || capacity <= 0) {
+        LOGE("❌ nativeAllocateFrameBuffers: invalid count=%d capacity=%d", count, capacity);
+        return nullptr;
+    }
+
+    jobjectArray buffers = env->NewObjectArray(count, jniCache().byteBufferClass, nullptr);
+    if (!buffers) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(ingestBufferMutex);
+    if (ingestBuffersInFlight()) {
+        LOGW("⚠️ nativeAllocateFrameBuffers: a frame buffer is still in flight, set kept");
+        env->DeleteLocalRef(buffers);
+        return nullptr;
+    }
+    ingestBuffers.clear();
+    ingestBuffers.reserve(count);
+    for (int i = 0; i < count; i++) {
+        ingestBuffers.emplace_back(1, capacity, CV_8UC1); // cv::fastMalloc gives SIMD-aligned storage
+        jobject buffer = env->NewDirectByteBuffer(ingestBuffers.back().data, capacity);
+        env->SetObjectArrayElement(buffers, i, buffer);
+        env->DeleteLocalRef(buffer);
+    }
+
+    LOGI("✅ Allocated %d direct frame buffers of %d bytes", count, capacity);
+    return buffers;
+}
+
+// Returns the index of a direct buffer the pipeline no longer references (safe
+// for Java to refill), or -1 if every buffer is still in flight.
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeAcquireFreeFrameBuffer(JNIEnv *env, jclass clazz) {
+    std::lock_guard<std::mutex> lock(ingestBufferMutex);
+    for (size_t i = 0; i < ingestBuffers.size(); i++) {
+        if (CV_XADD(&ingestBuffers[i].u->refcount, 0) == 1) {
+            return static_cast<jint>(i);
+        }
+    }
+    return -1;
+}
+
+// Frees the buffers created by nativeAllocateFrameBuffers. Returns false, freeing
+// nothing, while a frame in one of them is still being processed; Java retries
+// once nativeAcquireFreeFrameBuffer finds them all idle.
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeReleaseFrameBuffers(JNIEnv *env, jclass clazz) {
+    std::lock_guard<std::mutex> lock(ingestBufferMutex);
+    if (ingestBuffersInFlight()) {
+        LOGW("⚠️ nativeReleaseFrameBuffers: a frame buffer is still in flight, not released");
+        return JNI_FALSE;
+    }
+    ingestBuffers.clear();
+    LOGI("✅ Direct frame buffers released");
+    return JNI_TRUE;
+}
+
+// Every running worker is a stream competing for OpenCV's pool (PoolTurn)
+static void startPipelineWorker(PipelineContext& pipeline, ProcessingWorker::Handler handler) {
+    if (pipeline.worker.isRunning()) {
+        return;
+    }
+    pipeline.worker.start(std::move(handler));
+    addProcessingStream();
+}
+
+static void stopPipelineWorker(PipelineContext& pipeline) {
+    if (!pipeline.worker.isRunning()) {
+        return;
+    }
+    pipeline.worker.stop();
+    removeProcessingStream();
+}
+
+// Moves processing off the caller's thread: ingest calls enqueue and return
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeStartProcessingWorker(JNIEnv *env, jclass clazz) {
+    startPipelineWorker(defaultPipeline, [](const PendingFrame& frame) {
+        if (activeRenderMode(defaultPipeline) == EDGE_DETECTION &&
+            gapiStreamingPipeline().offer(frame.nv21.rowRange(0, frame.height), frame.timestampNs, frame.rotation)) {
+            return;  // published by publishGapiStreamResult
+        }
+        if (framePipeline.isRunning()) {
+            convertAndSubmit(frame);
+            return;
+        }
+        processFrameInternal(reinterpret_cast<jbyte*>(frame.nv21.data), frame.width, frame.height, frame.rotation,
+                         frame.timestampNs);
+    });
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeStopProcessingWorker(JNIEnv *env, jclass clazz) {
+    stopPipelineWorker(defaultPipeline);
+}
+
+// A worker thread of its own for a pipeline from nativeCreatePipeline, so
+// each camera stream converts and processes in parallel with the others
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeStartPipelineWorker(JNIEnv *env, jclass clazz, jlong handle) {
+    PipelineContext& pipeline = pipelineFor(handle);
+    if (&pipeline == &defaultPipeline) {
+        Java_com_example_edge_nativebridge_NativeBridge_nativeStartProcessingWorker(env, clazz);
+        return;
+    }
+    startPipelineWorker(pipeline, [&pipeline](const PendingFrame& frame) {
+        storeFrameVariants(pipeline, nv21IngestFrame(frame.nv21, frame.width, frame.height, frame.timestampNs),
+                           frame.rotation);
+    });
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeStopPipelineWorker(JNIEnv *env, jclass clazz, jlong handle) {
+    stopPipelineWorker(pipelineFor(handle));
+}
+
+// Opt-in post-mortem capture: every frame entering processing is copied into
+// an mmap'ed ring file at path holding the last `frames` NV21 frames of up to
+// maxWidth x maxHeight (see frame_capture.h for the layout). Cheap enough to
+// leave on: one memcpy per frame, no syscalls.
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeStartFrameCapture(JNIEnv *env, jclass clazz, jstring path,
+                                                                         jint frames, jint maxWidth, jint maxHeight) {
+    if (!path) {
+        return JNI_FALSE;
+    }
+    const char* chars = env->GetStringUTFChars(path, nullptr);
+    if (!chars) {
+        return JNI_FALSE;
+    }
+    bool started = startFrameCapture(chars, frames, maxWidth, maxHeight);
+    env->ReleaseStringUTFChars(path, chars);
+    return started ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeStopFrameCapture(JNIEnv *env, jclass clazz) {
+    stopFrameCapture();
+}
+
+// Per-frame telemetry of the default pipeline (stage timings, Canny
+// thresholds, luma statistics, drop counters) as 192-byte binary records in
+// an mmap'ed ring file at path holding the last `records` frames (see
+// frame_telemetry.h; decode with tools/telemetry_dump.cpp)
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeStartTelemetry(JNIEnv *env, jclass clazz, jstring path,
+                                                                      jint records) {
+    if (!path) {
+        return JNI_FALSE;
+    }
+    const char* chars = env->GetStringUTFChars(path, nullptr);
+    if (!chars) {
+        return JNI_FALSE;
+    }
+    bool started = startFrameTelemetry(chars, records);
+    env->ReleaseStringUTFChars(path, chars);
+    return started ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeStopTelemetry(JNIEnv *env, jclass clazz) {
+    stopFrameTelemetry();
+}
+
+// Session report (session_report.h): start measures the session from now;
+// finish writes its report, device and backends included, to path for the
+// app to upload, and reports whether it did. Decode with
+// tools/session_report_dump.cpp.
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeStartSessionReport(JNIEnv *env, jclass clazz) {
+    sessionRecorder().start();
+}
+
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeFinishSessionReport(JNIEnv *env, jclass clazz, jstring path) {
+    if (!path) {
+        return JNI_FALSE;
+    }
+    const char* chars = env->GetStringUTFChars(path, nullptr);
+    if (!chars) {
+        return JNI_FALSE;
+    }
+    const std::string file(chars);
+    env->ReleaseStringUTFChars(path, chars);
+    const int backend = edgeBackend.load(std::memory_order_relaxed);
+    const SessionRecorder::Backends backends = {
+            {"edge_backend", kEdgeBackendNames[backend]},
+            {"canny", cannyBackendName(activeCannyBackend())},
+            {"kernels", isaLevelName(edgeKernels().level)},
+            {"gapi", gapiPipeline.load(std::memory_order_relaxed) ? "on" : "off"},
+            {"incremental_edges", incrementalEdges.load(std::memory_order_relaxed) ? "on" : "off"},
+            {"hardware_frames", hardwareFrames.load(std::memory_order_relaxed) ? "on" : "off"},
+            {"render_mode", std::to_string(activeRenderMode(defaultPipeline))},
+    };
+    return sessionRecorder().finish(file, backends) ? JNI_TRUE : JNI_FALSE;
+}
+
+// Capture burst (burst_selector.h): every ingested frame is scored for
+// sharpness (metric: 0 = gradient energy, 1 = edge density) and only the
+// best keep (1..8) so far are held, as NV21 copies. Finish returns how many
+// winners there are; they stay readable, best first (rank 0), until the next
+// start or release.
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeStartBurst(JNIEnv *env, jclass clazz, jint keep, jint metric) {
+    if (metric != static_cast<int>(BurstMetric::GRADIENT_ENERGY) &&
+        metric != static_cast<int>(BurstMetric::EDGE_DENSITY)) {
+        LOGE("❌ Unknown burst metric: %d", metric);
+        return JNI_FALSE;
+    }
+    return burstSelector().start(keep, static_cast<BurstMetric>(metric)) ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeFinishBurst(JNIEnv *env, jclass clazz) {
+    return static_cast<jint>(burstSelector().finish());
+}
+
+// [score, width, height, rotation, arrival index] of a winner, null past the last
+extern "C"
+JNIEXPORT jfloatArray JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetBurstInfo(JNIEnv *env, jclass clazz, jint rank) {
+    BurstFrame frame;
+    if (!burstSelector().winner(rank, frame)) {
+        return nullptr;
+    }
+    const jfloat values[5] = {frame.score, static_cast<jfloat>(frame.width), static_cast<jfloat>(frame.height),
+                              static_cast<jfloat>(frame.rotation), static_cast<jfloat>(frame.index)};
+    jfloatArray result = env->NewFloatArray(5);
+    if (result) {
+        env->SetFloatArrayRegion(result, 0, 5, values);
+    }
+    return result;
+}
+
+// Copies a winner's NV21 frame (width * height * 3 / 2 bytes) into a direct
+// buffer. Returns its capture timestamp (CLOCK_BOOTTIME ns); 0 past the last
+// winner, -1 when the buffer is too small.
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeTakeBurstFrame(JNIEnv *env, jclass clazz, jint rank,
+                                                                    jobject buffer) {
+    BurstFrame frame;
+    if (!burstSelector().winner(rank, frame)) {
+        return 0;
+    }
+    auto* out = static_cast<uint8_t*>(buffer ? env->GetDirectBufferAddress(buffer) : nullptr);
+    if (!out || env->GetDirectBufferCapacity(buffer) < static_cast<jlong>(frame.nv21.total())) {
+        return -1;
+    }
+    cv::Mat packed(frame.nv21.size(), CV_8UC1, out);
+    frame.nv21.copyTo(packed);
+    return static_cast<jlong>(frame.timestampNs);
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeReleaseBurst(JNIEnv *env, jclass clazz) {
+    burstSelector().release();
+}
+
+// Pins the processing thread and OpenCV's parallel_for_ pool to the big CPU
+// cluster (cpufreq max frequency above the slowest one) and sets the OpenCV
+// thread count, caller included: 0 = one per big core when pinning, OpenCV's
+// default otherwise. Takes effect on the next processed frame.
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetThreadPolicy(JNIEnv *env, jclass clazz,
+                                                                       jboolean pinToBigCores, jint openCvThreads) {
+    ThreadPolicy policy;
+    policy.pinToBigCores = pinToBigCores == JNI_TRUE;
+    policy.openCvThreads = std::max(0, static_cast<int>(openCvThreads));
+    setThreadPolicy(policy);
+    LOGI("🔄 Thread policy requested: %s, %d OpenCV threads (0 = auto)",
+         policy.pinToBigCores ? "big cores" : "any core", policy.openCvThreads);
+}
+
+// [big cores, little cores, clusters, current OpenCV threads, pinned (0/1)]
+extern "C"
+JNIEXPORT jintArray JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetThreadTopology(JNIEnv *env, jclass clazz) {
+    const CpuTopology& topology = cpuTopology();
+    const jint values[5] = {
+        static_cast<jint>(topology.bigCores.size()),
+        static_cast<jint>(topology.littleCores.size()),
+        static_cast<jint>(topology.clusters),
+        static_cast<jint>(cv::getNumThreads()),
+        threadPolicy().pinToBigCores ? 1 : 0,
+    };
+    jintArray result = env->NewIntArray(5);
+    if (result) {
+        env->SetIntArrayRegion(result, 0, 5, values);
+    }
+    return result;
+}
+
+// [parallel loops, chunks, chunks stolen, chunks run on little cores, threads]
+// of the work-stealing pool behind cv::parallel_for_
+extern "C"
+JNIEXPORT jlongArray JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetParallelPoolStats(JNIEnv *env, jclass clazz) {
+    const WorkStealingPool::Stats stats = workStealingPool().stats();
+    const jlong values[5] = {
+        static_cast<jlong>(stats.loops),
+        static_cast<jlong>(stats.chunks),
+        static_cast<jlong>(stats.steals),
+        static_cast<jlong>(stats.littleChunks),
+        stats.threads,
+    };
+    jlongArray result = env->NewLongArray(5);
+    if (result) {
+        env->SetLongArrayRegion(result, 0, 5, values);
+    }
+    return result;
+}
+
+// Splits the processing worker into a three-thread pipeline: conversion
+// (steps 1-2) on the worker, gray/Canny/analysis (step 3) and publish (step 4)
+// on threads of their own, linked by two-deep SPSC rings. Throughput then
+// follows the slowest step instead of their sum, for up to two frames of
+// extra latency. Only frames that go through the worker are pipelined.
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetPipelinedProcessing(JNIEnv *env, jclass clazz,
+                                                                              jboolean enabled) {
+    if (enabled) {
+        framePipeline.start({processJob, publishJob});
+    } else {
+        framePipeline.stop();
+    }
+    LOGI("🔄 Pipelined processing %s", enabled ? "enabled" : "disabled");
+}
+
+// ADPF hint sessions (performance_hint.h) for the processing threads and the
+// GL thread, each reporting its per-frame work against 1/targetFps. Returns
+// false where APerformanceHint is unavailable (below API 33).
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetPerformanceHints(JNIEnv *env, jclass clazz,
+                                                                           jboolean enabled, jfloat targetFps) {
+    setPerformanceHints(enabled == JNI_TRUE, targetFps);
+    const bool available = performanceHintsAvailable();
+    LOGI("🔄 Performance hints %s (target %.1f fps%s)", enabled ? "enabled" : "disabled", targetFps,
+         available ? "" : ", unavailable on this device");
+    return available ? JNI_TRUE : JNI_FALSE;
+}
+
+// Quality governor (quality_governor.h): steps down through the configured
+// levels when frames stop fitting 1/targetFps or the device heats up, and back
+// up with sustained headroom
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetQualityGovernor(JNIEnv *env, jclass clazz,
+                                                                          jboolean enabled, jfloat targetFps) {
+    qualityGovernor().setEnabled(enabled == JNI_TRUE, targetFps);
+    incrementalEdgeDetector().reset();  // the processing size may change
+    LOGI("🔄 Quality governor %s (target %.1f fps)", enabled ? "enabled" : "disabled", targetFps);
+}
+
+// Half-rate processing (motion_compensation.h): every other frame runs the
+// edge pipeline; the ones between only move the last edges by the global
+// motion phase correlation measures against it
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetHalfRateProcessing(JNIEnv *env, jclass clazz,
+                                                                             jboolean enabled) {
+    motionCompensator().setEnabled(enabled == JNI_TRUE);
+}
+
+// Capture capacity feedback (capture_capacity.h): recommends the AE fps range
+// (within minFps..maxFps) and stream size processing keeps up with. The
+// native camera applies it itself; other camera controllers poll
+// nativeGetCaptureRecommendation.
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetCaptureCapacity(JNIEnv *env, jclass clazz, jboolean enabled,
+                                                                          jint minFps, jint maxFps) {
+    CaptureCapacity::Params params = captureCapacity().params();
+    params.minFps = minFps;
+    params.maxFps = maxFps;
+    captureCapacity().setParams(params);
+    captureCapacity().setEnabled(enabled == JNI_TRUE);
+}
+
+// [minFps, maxFps, width, height, generation]; zeros before the first
+// recommendation. Apply when the generation changes: a new size can go to
+// the running pipeline as is, nothing needs restarting.
+extern "C"
+JNIEXPORT jintArray JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetCaptureRecommendation(JNIEnv *env, jclass clazz) {
+    const CaptureRecommendation recommendation = captureCapacity().recommendation();
+    const jint values[5] = {recommendation.minFps, recommendation.maxFps, recommendation.width, recommendation.height,
+                            static_cast<jint>(recommendation.generation)};
+    jintArray result = env->NewIntArray(5);
+    if (result) {
+        env->SetIntArrayRegion(result, 0, 5, values);
+    }
+    return result;
+}
+
+// A Java camera controller is about to switch the default pipeline's frames
+// to width x height: buffers and textures for them are allocated now, so the
+// first frame of the new size draws without a hitch (prepareIngestSize)
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativePrepareFrameSize(JNIEnv *env, jclass clazz, jint width,
+                                                                        jint height) {
+    prepareIngestSize(nullptr, width, height);
+}
+
+// Extra luma outputs of the default pipeline as [width, height] pairs (at
+// most ScaledOutputs::kMaxSizes); null or empty turns them off. Consumers
+// read them from their fan-out queue (nativeTakeScaledLuma).
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetScaledOutputs(JNIEnv *env, jclass clazz, jintArray sizes) {
+    const jsize length = sizes ? env->GetArrayLength(sizes) : 0;
+    std::vector<jint> raw(length);
+    if (length > 0) {
+        env->GetIntArrayRegion(sizes, 0, length, raw.data());
+    }
+    std::vector<cv::Size> outputs;
+    for (jsize i = 0; i + 1 < length; i += 2) {
+        outputs.emplace_back(raw[i], raw[i + 1]);
+    }
+    scaledOutputs().setSizes(outputs);
+}
+
+// Fan-out queues of Java consumers, by the id nativeSubscribeFrames returned
+static std::mutex javaQueueMutex;
+static std::vector<std::pair<jlong, std::shared_ptr<FrameQueue>>> javaQueues;
+static jlong nextJavaQueueId = 1;
+
+static std::shared_ptr<FrameQueue> javaQueue(jlong id) {
+    std::lock_guard<std::mutex> lock(javaQueueMutex);
+    for (const auto& entry : javaQueues) {
+        if (entry.first == id) {
+            return entry.second;
+        }
+    }
+    return nullptr;
+}
+
+// Subscribes a Java consumer to the default pipeline's published frames;
+// returns the queue id for the calls below
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSubscribeFrames(JNIEnv *env, jclass clazz, jstring name) {
+    std::string consumer = "java";
+    if (name) {
+        const char* chars = env->GetStringUTFChars(name, nullptr);
+        if (chars) {
+            consumer = chars;
+            env->ReleaseStringUTFChars(name, chars);
+        }
+    }
+    std::shared_ptr<FrameQueue> queue = frameFanout().subscribe(consumer);
+    std::lock_guard<std::mutex> lock(javaQueueMutex);
+    const jlong id = nextJavaQueueId++;
+    javaQueues.emplace_back(id, queue);
+    return id;
+}
+
+// Closes the queue, which also wakes a nativeTakeScaledLuma waiting on it
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeUnsubscribeFrames(JNIEnv *env, jclass clazz, jlong id) {
+    std::shared_ptr<FrameQueue> queue;
+    {
+        std::lock_guard<std::mutex> lock(javaQueueMutex);
+        for (auto it = javaQueues.begin(); it != javaQueues.end(); ++it) {
+            if (it->first == id) {
+                queue = it->second;
+                javaQueues.erase(it);
+                break;
+            }
+        }
+    }
+    frameFanout().unsubscribe(queue);
+}
+
+// Takes the newest frame from a consumer's queue (waiting for one when wait
+// is set) and copies its width x height scaled luma into a direct buffer,
+// rows packed. Returns the frame's sequence; 0 when the queue is closed or,
+// without waiting, empty; -1 when the frame has no output of that size or
+// the buffer is too small. The output is made once for all consumers, so
+// this is a plain copy.
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeTakeScaledLuma(JNIEnv *env, jclass clazz, jlong id, jint width,
+                                                                    jint height, jobject buffer, jboolean wait) {
+    std::shared_ptr<FrameQueue> queue = javaQueue(id);
+    if (!queue) {
+        return 0;
+    }
+    FrameHandle frame = wait ? queue->take() : queue->poll();
+    if (!frame) {
+        return 0;
+    }
+    const cv::Size size(width, height);
+    for (const ScaledLuma& output : frame->scaled) {
+        if (output.size != size) {
+            continue;
+        }
+        auto* out = static_cast<uint8_t*>(buffer ? env->GetDirectBufferAddress(buffer) : nullptr);
+        if (!out || env->GetDirectBufferCapacity(buffer) < static_cast<jlong>(output.luma.total())) {
+            return -1;
+        }
+        cv::Mat packed(size, CV_8UC1, out);
+        output.luma.copyTo(packed);
+        return static_cast<jlong>(frame->sequence);
+    }
+    return -1;
+}
+
+// Edge event consumers (edge_events.h), by the id nativeStartEdgeEvents
+// returned: a fan-out queue each, and the diff state of what it was handed
+struct EdgeEventConsumer {
+    explicit EdgeEventConsumer(int keyframeInterval) : encoder(keyframeInterval) {}
+
+    std::shared_ptr<FrameQueue> queue;
+    // The consumer's thread only
+    EdgeEventEncoder encoder;
+    cv::Rect roi;                  // of the last frame taken; a moved grid restarts the diff
+    std::vector<uint32_t> events;
+};
+static std::mutex edgeEventMutex;
+static std::vector<std::pair<jlong, std::shared_ptr<EdgeEventConsumer>>> edgeEventConsumers;
+static jlong nextEdgeEventId = 1;
+
+// Subscribes a diff-only consumer of the default pipeline's edge maps: each
+// frame it takes is turned into the edge pixels that appeared or vanished
+// since the one it took before, with a full keyframe every keyframeInterval
+// frames. Returns the id for the calls below.
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeStartEdgeEvents(JNIEnv *env, jclass clazz,
+                                                                      jint keyframeInterval) {
+    auto consumer = std::make_shared<EdgeEventConsumer>(keyframeInterval);
+    consumer->queue = frameFanout().subscribe("edge_events");
+    std::lock_guard<std::mutex> lock(edgeEventMutex);
+    const jlong id = nextEdgeEventId++;
+    edgeEventConsumers.emplace_back(id, consumer);
+    LOGI("✅ Edge events %lld started (keyframe every %d)", static_cast<long long>(id), keyframeInterval);
+    return id;
+}
+
+// Closes the consumer's queue, which also wakes a waiting nativeTakeEdgeEvents
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeStopEdgeEvents(JNIEnv *env, jclass clazz, jlong id) {
+    std::shared_ptr<EdgeEventConsumer> consumer;
+    {
+        std::lock_guard<std::mutex> lock(edgeEventMutex);
+        for (auto it = edgeEventConsumers.begin(); it != edgeEventConsumers.end(); ++it) {
+            if (it->first == id) {
+                consumer = it->second;
+                edgeEventConsumers.erase(it);
+                break;
+            }
+        }
+    }
+    if (consumer) {
+        frameFanout().unsubscribe(consumer->queue);
+    }
+}
+
+// Takes the newest frame with edges from the consumer's queue (waiting for
+// one when wait is set) and writes its events into a direct buffer, 4 bytes
+// each in native byte order: uint16 x with bit 15 set for an edge that
+// appeared, then uint16 y, in the edge map's grid. Returns the event count
+// (0 for an unchanged scene); -1 when the queue is closed or, without
+// waiting, empty; -2 when the buffer is too small, in which case the next
+// frame is a keyframe. info (int[6], may be null): keyframe (0/1), grid
+// width, grid height, ROI x, ROI y of the grid in the frame, sequence.
+// One thread per consumer.
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeTakeEdgeEvents(JNIEnv *env, jclass clazz, jlong id,
+                                                                     jobject buffer, jintArray info, jboolean wait) {
+    std::shared_ptr<EdgeEventConsumer> consumer;
+    {
+        std::lock_guard<std::mutex> lock(edgeEventMutex);
+        for (const auto& entry : edgeEventConsumers) {
+            if (entry.first == id) {
+                consumer = entry.second;
+            }
+        }
+    }
+    if (!consumer) {
+        return -1;
+    }
+    FrameHandle frame;
+    do {
+        frame = wait ? consumer->queue->take() : consumer->queue->poll();
+    } while (frame && frame->edges.empty() && wait);
+    if (!frame || frame->edges.empty() || frame->edges.type() != CV_8UC1) {
+        return -1;
+    }
+    // Already packed when the pipeline stores 1-bpp edges
+    const int width = frame->bitmapWidth > 0 ? frame->bitmapWidth : frame->edges.cols;
+    cv::Mat bits = frame->edges;
+    if (frame->bitmapWidth <= 0) {
+        bits = framePool().acquire(frame->edges.rows, packedEdgeRowBytes(width), CV_8UC1);
+        packEdges(frame->edges, bits);
+    }
+    if (frame->roi != consumer->roi) {
+        consumer->encoder.reset();
+        consumer->roi = frame->roi;
+    }
+    const bool keyframe = consumer->encoder.encode(bits, width, consumer->events);
+    const std::vector<uint32_t>& events = consumer->events;
+    const size_t bytes = events.size() * sizeof(uint32_t);
+    auto* out = static_cast<uint8_t*>(buffer ? env->GetDirectBufferAddress(buffer) : nullptr);
+    if (!out || env->GetDirectBufferCapacity(buffer) < static_cast<jlong>(bytes)) {
+        consumer->encoder.reset();  // the consumer lost this diff
+        return -2;
+    }
+    if (bytes > 0) {
+        std::memcpy(out, events.data(), bytes);
+    }
+    if (info && env->GetArrayLength(info) >= 6) {
+        const jint values[6] = {keyframe ? 1 : 0, width, frame->edges.rows, frame->roi.x, frame->roi.y,
+                                static_cast<jint>(frame->sequence)};
+        env->SetIntArrayRegion(info, 0, 6, values);
+    }
+    return static_cast<jint>(events.size());
+}
+
+// Replaces the governor's ladder with triples [scale divisor, edges (0 =
+// Canny, 1 = gradient only, 2 = Canny with bounded hysteresis), frames
+// skipped after each processed one], best level first. Returns false (ladder
+// unchanged) for an empty or malformed array.
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetQualityLevels(JNIEnv *env, jclass clazz, jintArray values) {
+    const jsize length = values ? env->GetArrayLength(values) : 0;
+    if (length == 0 || length % 3 != 0) {
+        LOGE("❌ Quality levels need [scale, gradient, skip] triples, got %d values", static_cast<int>(length));
+        return JNI_FALSE;
+    }
+    std::vector<jint> raw(length);
+    env->GetIntArrayRegion(values, 0, length, raw.data());
+    std::vector<QualityGovernor::Level> levels;
+    for (jsize i = 0; i < length; i += 3) {
+        if (raw[i] < 1 || raw[i] > 16 || raw[i + 1] < 0 || raw[i + 1] > 2 || raw[i + 2] < 0 || raw[i + 2] > 30) {
+            LOGE("❌ Quality level %d out of range: scale %d, edges %d, skip %d", static_cast<int>(i / 3), raw[i],
+                 raw[i + 1], raw[i + 2]);
+            return JNI_FALSE;
+        }
+        QualityGovernor::Level level;
+        level.scaleDivisor = raw[i];
+        level.gradientOnly = raw[i + 1] == 1;
+        level.boundedHysteresis = raw[i + 1] == 2;
+        level.frameSkip = raw[i + 2];
+        levels.push_back(level);
+    }
+    qualityGovernor().setLevels(levels);
+    LOGI("🔄 Quality ladder set: %zu levels", levels.size());
+    return JNI_TRUE;
+}
+
+// [level, level count, thermal status, smoothed processing us]
+extern "C"
+JNIEXPORT jintArray JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetQualityState(JNIEnv *env, jclass clazz) {
+    QualityGovernor& governor = qualityGovernor();
+    const jint values[4] = {
+        static_cast<jint>(governor.levelIndex()),
+        static_cast<jint>(governor.levelCount()),
+        static_cast<jint>(governor.thermalStatus()),
+        static_cast<jint>(std::min<int64_t>(governor.smoothedMicros(), INT32_MAX)),
+    };
+    jintArray result = env->NewIntArray(4);
+    if (result) {
+        env->SetIntArrayRegion(result, 0, 4, values);
+    }
+    return result;
+}
+
+// Drops frames that are already older than millis (capture to the start of
+// processing, or of step 3 when pipelined) instead of processing them late,
+// and stops the stages that check (frame_deadline.h) once a frame in them
+// gets that old; 0 processes every frame
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetLatencyBudget(JNIEnv *env, jclass clazz, jint millis) {
+    latencyBudgetNs.store(millis > 0 ? static_cast<int64_t>(millis) * 1000000 : 0, std::memory_order_relaxed);
+    LOGI("🔄 Latency budget: %d ms", std::max(0, static_cast<int>(millis)));
+}
+
+// Frames replaced in the worker slot before they could be processed
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetDroppedFrameCount(JNIEnv *env, jclass clazz) {
+    return static_cast<jlong>(defaultPipeline.worker.droppedCount());
+}
+
+// Publishes empty sets so all but the renderer's current slot drop their buffers
+static void dropPublishedFrames(PipelineContext& pipeline) {
+    std::lock_guard<std::mutex> lock(pipeline.publishMutex);
+    pipeline.lastPublished = PublishedFrame();
+    for (int i = 0; i < 2; i++) {
+        pipeline.publishedFrames.writeSlot() = PublishedFrame();
+        pipeline.publishedFrames.publish();
+    }
+}
+
+// Android ComponentCallbacks2 trim levels
+enum TrimLevel {
+    TRIM_RUNNING_MODERATE = 5,
+    TRIM_RUNNING_LOW = 10,
+    TRIM_RUNNING_CRITICAL = 15,
+    TRIM_UI_HIDDEN = 20,
+    TRIM_BACKGROUND = 40,
+    TRIM_MODERATE = 60,
+    TRIM_COMPLETE = 80
+};
+
+// Releases cached memory in tiers as the trim level rises, never anything a
+// running session needs: everything comes back lazily on the next frames
+// (cold buffers are reallocated, histories restart), so a backgrounded
+// session resumes without nativeCleanup's full restart. UI_HIDDEN alone
+// (the app paused) trims nothing: the pipeline stays warm so the first
+// frame after resume allocates nothing, and the renderer rebuilds its GL
+// state from what the lost context held (opengl_renderer.h). Returns the
+// tier applied (0 = none).
+//   1 (RUNNING_MODERATE): spare buffers - idle frame pool
+//     buffers, frame arena spares, cached undistortion maps
+//   2 (RUNNING_LOW, BACKGROUND): the above plus the tracker's, stabilizer's
+//     and denoiser's frame histories and, once the UI is hidden, the
+//     alternate-mode buffers: every published variant, the pre-warmed
+//     mode's included (in the foreground that would blank the view)
+//   3 (RUNNING_CRITICAL, MODERATE, COMPLETE): the above plus GL render
+//     targets, maps and unused second-stream textures (at the next draw)
+// Every tier also drops the mode residency budget to zero for a while.
+static int trimMemory(int level) {
+    int tier = 0;
+    if (level >= TRIM_MODERATE || level == TRIM_RUNNING_CRITICAL) {
+        tier = 3;
+    } else if (level >= TRIM_BACKGROUND || level == TRIM_RUNNING_LOW) {
+        tier = 2;
+    } else if (level == TRIM_RUNNING_MODERATE) {
+        tier = 1;
+    }
+    if (tier == 0) {
+        return 0;
+    }
+    const size_t poolBytes = framePool().bytesHeld();
+    if (residentModes.load(std::memory_order_relaxed) != 0) {
+        residencyPressureMicros.store(monotonicMicros(), std::memory_order_relaxed);
+        setModeResidencyGL(residentModes.load(std::memory_order_relaxed), 0);
+    }
+    if (tier >= 2) {
+        if (level >= TRIM_UI_HIDDEN) {
+            dropPublishedFrames(defaultPipeline);
+        }
+        pointTracker().reset();
+        videoStabilizer().reset();
+        temporalDenoiser().reset();
+        defaultPipeline.history.clear();
+    }
+    framePool().trim();  // after the drops above, so their buffers are idle
+    const size_t arenaBytes = trimFrameArenas();
+    lensUndistortion().releaseMaps();
+    stereoDepth().releaseMaps();
+    if (tier >= 3) {
+        trimGL();
+    }
+    LOGI("🔄 Memory trimmed (level %d, tier %d): frame pool %zu -> %zu bytes, %zu arena bytes", level, tier,
+         poolBytes, framePool().bytesHeld(), arenaBytes);
+    return tier;
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeCleanup(JNIEnv *env, jclass clazz) {
+    LOGI(">> JNI cleanup called");
+    stopProfiling();
+    syntheticFrameSource().stop();
+    framePacing().stop();
+    renderScheduler().stop();
+    stopPipelineWorker(defaultPipeline);
+    framePipeline.stop();
+    gapiStreamingPipeline().stop();
+    stopAsyncProcessing(env);
+    stopFrameCapture();
+    stopFrameTelemetry();
+    edgeStreamer().stop();
+    edgeArchiver().stop();
+    sharedEdgeOutput().stop();
+    updateEdgeReadback();
+    snapshotExporter().stop();
+    metricsServer().stop();
+    backendComparison().stop();
+
+    dropPublishedFrames(defaultPipeline);
+    defaultPipeline.history.clear();
+    pointTracker().reset();
+    dnnEdgeDetector().release();
+    framePool().clear();
+    releaseHardwareFrames();
+    setFrameListener(env, nullptr);
+
+    LOGI("✅ Native cleanup completed");
+}
+
+// Native memory budget in bytes (memory_budget.h), 0 = unlimited. Pooled
+// buffers, pyramid levels, GL storage and the edge model reserve against it;
+// refusals degrade the pipeline step by step (applyMemoryBudget). Setting it
+// lifts the degradation; a smaller budget than in use trims the idle buffers.
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetMemoryBudget(JNIEnv *env, jclass clazz, jlong bytes) {
+    memoryBudget().setBudget(bytes);
+    memoryDegradation.store(0, std::memory_order_relaxed);
+    framePool().trim();
+}
+
+// [budget, bytes in use, peak, frame pool, pyramids, GL storage, edge model,
+// refusals, degradation level]
+extern "C"
+JNIEXPORT jlongArray JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetMemoryBudgetStats(JNIEnv *env, jclass clazz) {
+    const MemoryBudget& budget = memoryBudget();
+    jlong values[9] = {budget.budget(), budget.used(), budget.peak(), budget.used(MemoryClient::FRAME_POOL),
+                       budget.used(MemoryClient::PYRAMIDS), budget.used(MemoryClient::TEXTURES),
+                       budget.used(MemoryClient::DNN), static_cast<jlong>(budget.refusalCount()),
+                       memoryDegradation.load(std::memory_order_relaxed)};
+    jlongArray result = env->NewLongArray(9);
+    if (result) {
+        env->SetLongArrayRegion(result, 0, 9, values);
+    }
+    return result;
+}
+
+// ComponentCallbacks2.onTrimMemory: releases cached memory tier by tier
+// (trimMemory); returns the tier applied, 0 for levels that need nothing
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeTrimMemory(JNIEnv *env, jclass clazz, jint level) {
+    return trimMemory(level);
+}
+
+// Registers a Runnable invoked (from the producing thread) after each new
+// frame is published; pass null to remove it. Lets GLRenderer switch to
+// RENDERMODE_WHEN_DIRTY and call requestRender() only when there is work.
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetFrameListener(JNIEnv *env, jclass clazz, jobject listener) {
+    setFrameListener(env, listener);
+}
+
+// Sequence number of the newest published frame (0 before the first one)
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetFrameSequence(JNIEnv *env, jclass clazz) {
+    return static_cast<jlong>(defaultPipeline.publishedSequence.load(std::memory_order_relaxed));
+}
+
+// FIXED: Add the missing setRenderModeNative function that GLRenderer calls
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_renderer_GLRenderer_setRenderModeNative(JNIEnv *env, jobject thiz, jint mode) {
+    if (mode < 0 || mode >= kRenderModeCount) {
+        LOGE("❌ Unknown render mode %d ignored", mode);
+        return;
+    }
+    switchRenderMode(defaultPipeline, static_cast<RenderMode>(mode));
+    LOGI("🔄 Render mode changed to: %d (%s)", mode,
+         mode == 0 ? "RAW_CAMERA" :
+         mode == 1 ? "EDGE_DETECTION" :
+         mode == 2 ? "GRAYSCALE" :
+         mode == 3 ? "DEFAULT" :
+         mode == 4 ? "INSET" :
+         mode == 5 ? "BORDER_FIX" :
+         mode == 6 ? "FEATURES" :
+         mode == 7 ? "TRACKING" :
+         mode == 8 ? "CONTOURS" :
+         mode == 9 ? "LINES" :
+         mode == 10 ? "MOTION" :
+         mode == 11 ? "DOCUMENT" :
+         mode == 12 ? "CHAMFER_MATCH" :
+         mode == 13 ? "MULTISCALE_EDGES" :
+         mode == 14 ? "SEGMENTS" :
+         mode == 15 ? "MARKERS" :
+         mode == 16 ? "CODES" :
+         mode == 17 ? "STABILIZE" :
+         mode == 18 ? "DEPTH" :
+         mode == 19 ? "FACES" :
+         mode == 20 ? "MOSAIC" :
+         mode == 21 ? "TRACK_OBJECT" :
+         mode == 22 ? "PEOPLE" :
+         mode == 23 ? "COLOR_EDGES" :
+         mode == 24 ? "TEXT_REGIONS" :
+         mode == 25 ? "ODOMETRY" :
+         mode == 26 ? "HEATMAP" :
+         mode == 27 ? "FOCUS_PEAK" : "UNKNOWN");
+}
+
+// Additional pipelines (PipelineContext): each has its own published frames
+// and render mode, is fed synchronously on the calling thread and drawn by
+// the surface bound with GLRenderer.setRenderPipelineNative. Returns the
+// handle for the calls below.
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeCreatePipeline(JNIEnv *env, jclass clazz) {
+    // Exceptions must not cross JNI: a failed allocation returns 0
+    auto* pipeline = new (std::nothrow) PipelineContext();
+    if (!pipeline) {
+        LOGE("❌ Pipeline allocation failed");
+        return 0;
+    }
+    LOGI("✅ Pipeline %p created", static_cast<void*>(pipeline));
+    return reinterpret_cast<jlong>(pipeline);
+}
+
+// Unbind every surface drawing the pipeline and stop its camera first; its
+// worker is stopped here
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeDestroyPipeline(JNIEnv *env, jclass clazz, jlong handle) {
+    if (!handle) {
+        return;  // the default pipeline lives as long as the library
+    }
+    auto* pipeline = reinterpret_cast<PipelineContext*>(handle);
+    PipelineContext* right = pipeline;
+    stereoRightPipeline.compare_exchange_strong(right, nullptr);
+    stopPipelineWorker(*pipeline);
+    delete pipeline;
+    LOGI("✅ Pipeline %p destroyed", reinterpret_cast<void*>(handle));
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetPipelineRenderMode(JNIEnv *env, jclass clazz, jlong handle,
+                                                                           jint mode) {
+    if (mode < 0 || mode >= kRenderModeCount) {
+        LOGE("❌ Unknown render mode %d ignored", mode);
+        return;
+    }
+    switchRenderMode(pipelineFor(handle), static_cast<RenderMode>(mode));
+}
+
+// NV21 frame (direct buffer) into a pipeline: queued for its worker when
+// that runs, otherwise processed before returning
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeProcessPipelineFrame(JNIEnv *env, jclass clazz, jlong handle,
+                                                                          jobject frameBuffer, jint width,
+                                                                          jint height, jint rotation,
+                                                                          jlong timestampNs) {
+    auto* frameData = static_cast<uchar*>(frameBuffer ? env->GetDirectBufferAddress(frameBuffer) : nullptr);
+    const jlong frameBytes = static_cast<jlong>(width) * (height + height / 2);
+    if (!frameData || width <= 0 || height <= 0 || env->GetDirectBufferCapacity(frameBuffer) < frameBytes) {
+        LOGE_RATELIMITED("❌ nativeProcessPipelineFrame: direct NV21 buffer of %dx%d required", width, height);
+        return;
+    }
+    cv::Mat yuv(height + height / 2, width, CV_8UC1, frameData);
+    PipelineContext& pipeline = pipelineFor(handle);
+    if (pipeline.worker.isRunning()) {
+        // The buffer is the caller's again on return: queue a pooled copy
+        PendingFrame pending;
+        pending.nv21 = framePool().copyOf(yuv);
+        pending.width = width;
+        pending.height = height;
+        pending.rotation = rotation;
+        pending.timestampNs = captureTimestamp(timestampNs);
+        if (!pipeline.worker.submit(std::move(pending))) {
+            metrics().increment(Counter::FRAMES_DROPPED);
+        }
+        return;
+    }
+    storeFrameVariants(pipeline, nv21IngestFrame(yuv, width, height, captureTimestamp(timestampNs)), rotation);
+}
+
+// Enables the one-pass luma statistics (luma_stats.h). While on, they also
+// drive the adaptive Canny thresholds instead of their own sampling.
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetLumaStats(JNIEnv *env, jclass clazz, jboolean enabled) {
+    lumaStats.store(enabled == JNI_TRUE);
+    useFedLumaMedian(enabled == JNI_TRUE);
+    LOGI("🔄 Luma statistics %s", enabled ? "enabled" : "disabled");
+}
+
+// Latest luma statistics without locking: [mean, variance, sharpness, median,
+// dark fraction, bright fraction, pixels, sequence, AF state, AE state, lens
+// moving] (the states -1 without a capture result); null before the first frame
+extern "C"
+JNIEXPORT jfloatArray JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetLumaStats(JNIEnv *env, jclass clazz) {
+    LumaStats stats;
+    if (!latestLumaStats(stats)) {
+        return nullptr;
+    }
+    const jfloat values[] = {stats.mean, stats.variance, stats.sharpness, static_cast<jfloat>(stats.median),
+                             stats.darkFraction, stats.brightFraction, static_cast<jfloat>(stats.pixels),
+                             static_cast<jfloat>(stats.sequence), static_cast<jfloat>(stats.afState),
+                             static_cast<jfloat>(stats.aeState), static_cast<jfloat>(stats.lensMoving)};
+    const jsize length = sizeof(values) / sizeof(values[0]);
+    jfloatArray result = env->NewFloatArray(length);
+    if (result) {
+        env->SetFloatArrayRegion(result, 0, length, values);
+    }
+    return result;
+}
+
+// CaptureResult of a Java camera frame (CONTROL_AF_STATE, CONTROL_AE_STATE,
+// LENS_STATE == MOVING) by its SENSOR_TIMESTAMP; -1 = state not reported.
+// The native camera notes its own.
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetCaptureMetadata(JNIEnv *env, jclass clazz, jlong timestampNs,
+                                                                          jint afState, jint aeState,
+                                                                          jboolean lensMoving) {
+    CaptureMetadata metadata;
+    metadata.timestampNs = timestampNs;
+    metadata.afState = afState;
+    metadata.aeState = aeState;
+    metadata.lensMoving = lensMoving == JNI_TRUE;
+    captureMetadataGate().note(metadata);
+}
+
+// What happens to frames captured while autofocus scans, exposure searches
+// or the lens moves, and settleFrames after: 0 = processed as usual, 1 =
+// dropped (the last edges stay on screen), 2 = FAST_EDGES instead of Canny
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetCaptureMetadataPolicy(JNIEnv *env, jclass clazz, jint policy,
+                                                                                jint settleFrames) {
+    if (policy < CaptureMetadataGate::OFF || policy > CaptureMetadataGate::CHEAPEN) {
+        LOGE("❌ Invalid capture metadata policy: %d", policy);
+        return;
+    }
+    CaptureMetadataGate::Params params;
+    params.policy = static_cast<CaptureMetadataGate::Policy>(policy);
+    params.settleFrames = settleFrames;
+    captureMetadataGate().setParams(params);
+}
+
+// {frames dropped, frames cheapened, frames without a matching capture result}
+extern "C"
+JNIEXPORT jlongArray JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetCaptureMetadataStats(JNIEnv *env, jclass clazz) {
+    CaptureMetadataGate& gate = captureMetadataGate();
+    jlong values[3] = {static_cast<jlong>(gate.skippedCount()), static_cast<jlong>(gate.cheapenedCount()),
+                       static_cast<jlong>(gate.unmatchedCount())};
+    jlongArray result = env->NewLongArray(3);
+    if (result) {
+        env->SetLongArrayRegion(result, 0, 3, values);
+    }
+    return result;
+}
+
+// Copies the latest 256-bin luma histogram into bins (int[256]); false before
+// the first frame or for a shorter array
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetLumaHistogram(JNIEnv *env, jclass clazz, jintArray bins) {
+    LumaStats stats;
+    if (!bins || env->GetArrayLength(bins) < 256 || !latestLumaStats(stats)) {
+        return JNI_FALSE;
+    }
+    env->SetIntArrayRegion(bins, 0, 256, reinterpret_cast<const jint*>(stats.histogram));
+    return JNI_TRUE;
+}
+
+// Corners of the quadrilateral DOCUMENT mode tracks, as 8 floats (u, v of
+// top-left, top-right, bottom-right, bottom-left in 0..1 full-frame units,
+// unrotated sensor orientation); null while none is tracked
+extern "C"
+JNIEXPORT jfloatArray JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetDocumentCorners(JNIEnv *env, jclass clazz) {
+    jfloat values[8];
+    {
+        std::lock_guard<std::mutex> lock(defaultPipeline.publishMutex);
+        const PublishedFrame& lastPublished = defaultPipeline.lastPublished;
+        if (lastPublished.document.rows != 5) {
+            return nullptr;
+        }
+        for (int i = 0; i < 4; i++) {
+            const cv::Point2f& corner = lastPublished.document.at<cv::Point2f>(i);
+            values[2 * i] = corner.x;
+            values[2 * i + 1] = corner.y;
+        }
+    }
+    jfloatArray result = env->NewFloatArray(8);
+    if (result) {
+        env->SetFloatArrayRegion(result, 0, 8, values);
+    }
+    return result;
+}
+
+static const int kStageMetricValues = static_cast<int>(Stage::COUNT) * 4 + static_cast<int>(Counter::COUNT);
+
+// The nativeGetStageMetrics layout into values[kStageMetricValues]
+static void fillStageMetrics(jfloat* values) {
+    const int stageCount = static_cast<int>(Stage::COUNT);
+    const int counterCount = static_cast<int>(Counter::COUNT);
+    MetricsRegistry& registry = metrics();
+    for (int i = 0; i < stageCount; i++) {
+        const LatencyHistogram& histogram = registry.histogram(static_cast<Stage>(i));
+        values[i * 4 + 0] = static_cast<jfloat>(histogram.count());
+        values[i * 4 + 1] = static_cast<jfloat>(histogram.percentileMicros(0.50) / 1000.0);
+        values[i * 4 + 2] = static_cast<jfloat>(histogram.percentileMicros(0.95) / 1000.0);
+        values[i * 4 + 3] = static_cast<jfloat>(histogram.percentileMicros(0.99) / 1000.0);
+    }
+    for (int i = 0; i < counterCount; i++) {
+        values[stageCount * 4 + i] = static_cast<jfloat>(registry.counter(static_cast<Counter>(i)));
+    }
+}
+
+// Stage latency snapshot for the debug overlay. Layout: for each Stage (in enum
+// order, names from nativeGetStageNames) 4 floats [count, p50 ms, p95 ms, p99 ms],
+// followed by one float per Counter. With reset=true the window restarts.
+extern "C"
+JNIEXPORT jfloatArray JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetStageMetrics(JNIEnv *env, jclass clazz, jboolean reset) {
+    jfloat values[kStageMetricValues];
+    fillStageMetrics(values);
+    if (reset) {
+        metrics().reset();
+    }
+
+    jfloatArray result = env->NewFloatArray(kStageMetricValues);
+    if (result) {
+        env->SetFloatArrayRegion(result, 0, kStageMetricValues, values);
+    }
+    return result;
+}
+
+// Native memory accounting (memory_accounting.h). Enable it before the camera
+// starts: buffers allocated earlier, the frame pool's included, are not counted.
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetMemoryAccounting(JNIEnv *env, jclass clazz, jboolean enabled) {
+    setMemoryAccounting(enabled == JNI_TRUE);
+    LOGI("🔄 Memory accounting %s", enabled == JNI_TRUE ? "enabled" : "disabled");
+}
+
+// Per-thread arenas for the processing thread's per-frame cv::Mat
+// temporaries (frame_arena.h); off by default
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetFrameArenas(JNIEnv *env, jclass clazz, jboolean enabled) {
+    setFrameArenas(enabled == JNI_TRUE);
+    LOGI("🔄 Frame arenas %s", enabled == JNI_TRUE ? "enabled" : "disabled");
+}
+
+// Frame arenas of all threads: [chunks, bytes reserved, retired chunks
+// (cumulative), oversized blocks sent to the heap (cumulative)]
+extern "C"
+JNIEXPORT jlongArray JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetFrameArenaStats(JNIEnv *env, jclass clazz) {
+    const FrameArenaStats stats = frameArenaStats();
+    const jlong values[4] = {static_cast<jlong>(stats.chunks), static_cast<jlong>(stats.bytesReserved),
+                             static_cast<jlong>(stats.retiredChunks), static_cast<jlong>(stats.heapFallbacks)};
+    jlongArray result = env->NewLongArray(4);
+    if (result) {
+        env->SetLongArrayRegion(result, 0, 4, values);
+    }
+    return result;
+}
+
+// Memory snapshot in bytes. Layout: [mat live, mat peak, mat allocations, mat
+// bytes allocated, GL live, GL peak, GL allocations, GL bytes allocated, frame
+// pool bytes held, frame pool buffers], then per Stage (enum order, names from
+// nativeGetStageNames) and a last group for allocations outside any stage, 4
+// longs [live, peak, allocations, bytes allocated]. Allocation counts are
+// cumulative (rates are deltas between calls); with resetPeaks=true the
+// high-water marks restart from the current live bytes.
+extern "C"
+JNIEXPORT jlongArray JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetMemoryStats(JNIEnv *env, jclass clazz, jboolean resetPeaks) {
+    const MemorySnapshot snapshot = memorySnapshot();
+    if (resetPeaks == JNI_TRUE) {
+        resetMemoryPeaks();
+    }
+    const int kHeaderValues = 10;
+    const int slots = static_cast<int>(Stage::COUNT) + 1;
+    jlong values[kHeaderValues + 4 * (static_cast<int>(Stage::COUNT) + 1)];
+    auto put = [&values](int at, const MemoryUsage& usage) {
+        values[at] = usage.liveBytes;
+        values[at + 1] = usage.peakBytes;
+        values[at + 2] = static_cast<jlong>(usage.allocations);
+        values[at + 3] = static_cast<jlong>(usage.allocatedBytes);
+    };
+    put(0, snapshot.mats);
+    put(4, snapshot.gl);
+    values[8] = static_cast<jlong>(framePool().bytesHeld());
+    values[9] = static_cast<jlong>(framePool().bufferCount());
+    for (int i = 0; i < slots; i++) {
+        put(kHeaderValues + 4 * i, snapshot.stages[i]);
+    }
+
+    const jsize count = static_cast<jsize>(sizeof(values) / sizeof(values[0]));
+    jlongArray result = env->NewLongArray(count);
+    if (result) {
+        env->SetLongArrayRegion(result, 0, count, values);
+    }
+    return result;
+}
+
+// Benchmark replay: feeds a ring capture (nativeStartFrameCapture) or a raw
+// file of width x height NV21 frames through processFrameInternal on the
+// calling thread, `loops` times, at max speed (pacing 0) or the recorded
+// timing (1). Blocks until done; call it off the UI thread. Metrics are reset
+// first, so the result is [frames, seconds, fps] followed by the run's
+// nativeGetStageMetrics layout; null if the file holds no frames.
+extern "C"
+JNIEXPORT jfloatArray JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeReplayFrames(JNIEnv *env, jclass clazz, jstring path,
+                                                                    jint width, jint height, jint rotation,
+                                                                    jint pacing, jint loops) {
+    const char* chars = path ? env->GetStringUTFChars(path, nullptr) : nullptr;
+    if (!chars) {
+        return nullptr;
+    }
+    FrameReplay replay;
+    bool loaded = replay.load(chars, width, height, rotation);
+    env->ReleaseStringUTFChars(path, chars);
+    if (!loaded) {
+        return nullptr;
+    }
+
+    auto sink = [](const ReplayFrame& frame) {
+        // Timestamp 0: latencies count from the replayed arrival, not the recording
+        processFrameInternal(reinterpret_cast<jbyte*>(const_cast<uint8_t*>(frame.nv21)), frame.width,
+                             frame.height, frame.rotation, 0);
+    };
+    ReplayPacing replayPacing = pacing == static_cast<jint>(ReplayPacing::ORIGINAL) ? ReplayPacing::ORIGINAL
+                                                                                    : ReplayPacing::MAX_SPEED;
+    metrics().reset();
+    ReplayReport report = replay.run(sink, replayPacing, std::max(1, static_cast<int>(loops)));
+    LOGI("✅ Replayed %d frames in %.2fs: %.1f fps, FRAME_TOTAL p50 %.2fms p95 %.2fms", report.frames,
+         report.seconds, report.framesPerSecond, metrics().histogram(Stage::FRAME_TOTAL).percentileMicros(0.50) / 1000.0,
+         metrics().histogram(Stage::FRAME_TOTAL).percentileMicros(0.95) / 1000.0);
+
+    jfloat values[3 + kStageMetricValues];
+    values[0] = static_cast<jfloat>(report.frames);
+    values[1] = static_cast<jfloat>(report.seconds);
+    values[2] = static_cast<jfloat>(report.framesPerSecond);
+    fillStageMetrics(values + 3);
+    jfloatArray result = env->NewFloatArray(3 + kStageMetricValues);
+    if (result) {
+        env->SetFloatArrayRegion(result, 0, 3 + kStageMetricValues, values);
+    }
+    return result;
+}
+
+// Field hotspot breakdown (cpu_profiler.h): for the next `seconds`, CPU time
+// of the processing, render and OpenCV pool threads and per-stage call
+// counts; the summary goes to logcat when the window ends. False while a
+// session runs or for a window outside 1-600 s.
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeStartProfiling(JNIEnv *env, jclass clazz, jint seconds) {
+    return startProfiling(seconds) ? JNI_TRUE : JNI_FALSE;
+}
+
+// Ends the session early; returns its summary
+extern "C"
+JNIEXPORT jstring JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeStopProfiling(JNIEnv *env, jclass clazz) {
+    stopProfiling();
+    return env->NewStringUTF(profileReport().c_str());
+}
+
+// Summary of the last finished session (empty while none has finished)
+extern "C"
+JNIEXPORT jstring JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetProfileReport(JNIEnv *env, jclass clazz) {
+    return env->NewStringUTF(profileReport().c_str());
+}
+
+// Caps the ISA level of the dispatched kernels (kernel_dispatch.h: 0 scalar,
+// 1 ARMv7 NEON, 2 ARMv8, 3 ARMv8.2 dotprod, 4 x86 SSE4.1, 5 AVX2) for A/B
+// runs on one device; returns the level now bound
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetKernelIsaLimit(JNIEnv *env, jclass clazz, jint level) {
+    const int limit = std::max(0, std::min(static_cast<int>(level), static_cast<int>(IsaLevel::AVX2)));
+    return static_cast<jint>(setKernelIsaLimit(static_cast<IsaLevel>(limit)));
+}
+
+// Frame-pacing analysis of the default pipeline (frame_pacing.h): interval
+// statistics at ingest, publish and present, with vsync counts from
+// AChoreographer for the presents. Starting clears the previous results.
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetFramePacing(JNIEnv *env, jclass clazz, jboolean enabled) {
+    if (enabled == JNI_TRUE) {
+        framePacing().start();
+    } else {
+        framePacing().stop();
+    }
+}
+
+// Vsync-aligned rendering (render_scheduler.h): the frame listener runs once
+// per vsync with a newer frame, as late before the vsync as the measured draw
+// allows, instead of on every publish; for a RENDERMODE_WHEN_DIRTY surface
+// whose listener calls requestRender(). False without AChoreographer.
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetVsyncRendering(JNIEnv *env, jclass clazz,
+                                                                       jboolean enabled) {
+    if (enabled != JNI_TRUE) {
+        renderScheduler().stop();
+        return JNI_TRUE;
+    }
+    return renderScheduler().start(&notifyFrameListener) ? JNI_TRUE : JNI_FALSE;
+}
+
+// Layout: [vsyncs, render requests, vsyncs without a new frame, vsync period
+// ms, estimated request-to-drawn ms]
+extern "C"
+JNIEXPORT jfloatArray JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetVsyncRenderStats(JNIEnv *env, jclass clazz) {
+    const RenderScheduler::Stats stats = renderScheduler().stats();
+    const jfloat values[] = {static_cast<jfloat>(stats.vsyncs), static_cast<jfloat>(stats.requests),
+                             static_cast<jfloat>(stats.skipped), static_cast<jfloat>(stats.periodMs),
+                             static_cast<jfloat>(stats.renderCostMs)};
+    const jsize count = static_cast<jsize>(sizeof(values) / sizeof(values[0]));
+    jfloatArray result = env->NewFloatArray(count);
+    if (result) {
+        env->SetFloatArrayRegion(result, 0, count, values);
+    }
+    return result;
+}
+
+// Layout: [vsync period ms, vsyncs seen], then for INGEST, PUBLISH and
+// PRESENT: [intervals, mean ms, stddev ms, max ms, janks, repeated presents,
+// missed vsyncs] (the last two PRESENT only). Results stay readable after
+// stopping; resetAfter clears them once read.
+extern "C"
+JNIEXPORT jfloatArray JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetFramePacing(JNIEnv *env, jclass clazz,
+                                                                      jboolean resetAfter) {
+    const int kStreams = static_cast<int>(PacingStream::COUNT);
+    const int kValuesPerStream = 7;
+    jfloat values[2 + kStreams * kValuesPerStream];
+    values[0] = static_cast<jfloat>(framePacing().vsyncPeriodMs());
+    values[1] = static_cast<jfloat>(framePacing().vsyncCount());
+    for (int i = 0; i < kStreams; i++) {
+        const PacingStats stats = framePacing().stats(static_cast<PacingStream>(i));
+        jfloat* out = values + 2 + i * kValuesPerStream;
+        out[0] = static_cast<jfloat>(stats.intervals);
+        out[1] = static_cast<jfloat>(stats.meanMs);
+        out[2] = static_cast<jfloat>(stats.stddevMs);
+        out[3] = static_cast<jfloat>(stats.maxMs);
+        out[4] = static_cast<jfloat>(stats.janks);
+        out[5] = static_cast<jfloat>(stats.repeats);
+        out[6] = static_cast<jfloat>(stats.missedVsyncs);
+    }
+    if (resetAfter == JNI_TRUE) {
+        framePacing().reset();
+    }
+    const jsize count = static_cast<jsize>(sizeof(values) / sizeof(values[0]));
+    jfloatArray result = env->NewFloatArray(count);
+    if (result) {
+        env->SetFloatArrayRegion(result, 0, count, values);
+    }
+    return result;
+}
+
+// Camera-free stress input: procedural NV21 frames (patterns: 1 moving scene,
+// 2 noise, 4 text) at width x height, rendered into pooled buffers on a
+// thread of their own at fps (<= 0: as fast as the pipeline takes them) and
+// dispatched like camera frames, to the worker when it runs and inline
+// otherwise. Resets the metrics, so nativeGetStageMetrics covers the run.
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeStartSyntheticSource(JNIEnv *env, jclass clazz, jint width,
+                                                                            jint height, jfloat fps,
+                                                                            jint patterns) {
+    SyntheticConfig config;
+    config.width = width;
+    config.height = height;
+    config.framesPerSecond = fps;
+    config.patterns = patterns & kSyntheticAll;
+    metrics().reset();
+    auto sink = [](const cv::Mat& nv21, int frameWidth, int frameHeight, int64_t timestampNs) {
+        PendingFrame frame;
+        frame.nv21 = nv21;
+        frame.width = frameWidth;
+        frame.height = frameHeight;
+        frame.timestampNs = timestampNs;
+        dispatchFrame(std::move(frame));
+    };
+    return syntheticFrameSource().start(config, sink) ? JNI_TRUE : JNI_FALSE;
+}
+
+// Process start-up off the main thread (app_startup.h): call from a
+// background thread in Application.onCreate, right after that thread's
+// System.loadLibrary. After OpenCV's one-off setup it builds what the first
+// frame would (the frame pool, metrics, the fallback frame) and, given the
+// size the camera will stream (0 x 0 = not known yet), the default
+// pipeline's buffers for its mode. The camera waits for it before streaming.
+// Returns milliseconds spent, or -1 for an invalid size.
+extern "C"
+JNIEXPORT jfloat JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeInit(JNIEnv *env, jclass clazz, jint width, jint height) {
+    if (width < 0 || height < 0 || width > 0xffff || height > 0xffff || (width | height) & 1) {
+        LOGE("❌ Start-up needs an even camera size or 0x0, got %dx%d", width, height);
+        return -1.0f;
+    }
+    return static_cast<jfloat>(appStartup().run([width, height] {
+        framePool();
+        metrics();
+        renderFallbackFrame();
+        if (width > 0 && height > 0) {
+            prepareIngestSize(nullptr, width, height);
+        }
+    }));
+}
+
+// [1 once start-up is done, its milliseconds, microseconds the camera
+// waited for it, waits that timed out]
+extern "C"
+JNIEXPORT jlongArray JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetStartupStats(JNIEnv *env, jclass clazz) {
+    AppStartup& startup = appStartup();
+    jlong values[4] = {startup.ready() ? 1 : 0, static_cast<jlong>(startup.runMillis()),
+                       static_cast<jlong>(startup.awaitedMicros()), static_cast<jlong>(startup.timeoutCount())};
+    jlongArray result = env->NewLongArray(4);
+    if (result) {
+        env->SetLongArrayRegion(result, 0, 4, values);
+    }
+    return result;
+}
+
+// Warm-up for width x height camera frames (warmupPipeline) plus a request
+// that every GL thread builds its programs at its next frame. Meant for a
+// background thread while the camera opens, before frames arrive. Returns
+// milliseconds spent, or -1 for an invalid size.
+extern "C"
+JNIEXPORT jfloat JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeWarmup(JNIEnv *env, jclass clazz, jint width, jint height) {
+    if (width < 64 || height < 64 || width > 0xffff || height > 0xffff || (width | height) & 1) {
+        LOGE("❌ Warm-up needs an even size of at least 64x64, got %dx%d", width, height);
+        return -1.0f;
+    }
+    warmupGL();
+    return static_cast<jfloat>(warmupPipeline(width, height));
+}
+
+// Stops the synthetic source: [frames, seconds, fps, late frames] followed by
+// the run's nativeGetStageMetrics layout. Generated fps below the requested
+// rate with late frames (inline processing), or FRAMES_DROPPED rising (worker),
+// marks the pipeline's saturation point.
+extern "C"
+JNIEXPORT jfloatArray JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeStopSyntheticSource(JNIEnv *env, jclass clazz) {
+    const SyntheticReport report = syntheticFrameSource().stop();
+    jfloat values[4 + kStageMetricValues];
+    values[0] = static_cast<jfloat>(report.frames);
+    values[1] = static_cast<jfloat>(report.seconds);
+    values[2] = static_cast<jfloat>(report.framesPerSecond);
+    values[3] = static_cast<jfloat>(report.lateFrames);
+    fillStageMetrics(values + 4);
+    jfloatArray result = env->NewFloatArray(4 + kStageMetricValues);
+    if (result) {
+        env->SetFloatArrayRegion(result, 0, 4 + kStageMetricValues, values);
+    }
+    return result;
+}
+
+// Set by nativeCancelVideoDecode; checked between decoded frames
+static std::atomic<bool> videoDecodeCancelled{false};
+
+// Decodes a video (an fd range from e.g. AssetFileDescriptor or
+// ParcelFileDescriptor; length <= 0: to the end) through AMediaCodec into the
+// pipeline of handle (0 = default) as fast as it processes, at most maxFrames
+// frames (<= 0: all). Each frame is processed on the decoder's reader thread
+// while the next one decodes, so stop that pipeline's worker first to process
+// every frame instead of only the newest. Blocking; returns what
+// nativeReplayFrames does, or null when the file has no decodable video track.
+extern "C"
+JNIEXPORT jfloatArray JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeProcessVideoFile(JNIEnv *env, jclass clazz, jint fd,
+                                                                        jlong offset, jlong length, jlong handle,
+                                                                        jint maxFrames) {
+    VideoFileSource source;
+    if (!source.open(fd, offset, length)) {
+        return nullptr;
+    }
+    PipelineContext* pipeline = &pipelineFor(handle);
+    const int rotation = source.rotation();
+    auto consumer = [pipeline, rotation](const YuvPlanes& planes) {
+        processYuvPlanes(planes, rotation, pipeline);
+    };
+    videoDecodeCancelled.store(false);
+    metrics().reset();
+    VideoDecodeReport report = source.run(consumer, maxFrames, &videoDecodeCancelled);
+
+    jfloat values[3 + kStageMetricValues];
+    values[0] = static_cast<jfloat>(report.frames);
+    values[1] = static_cast<jfloat>(report.seconds);
+    values[2] = static_cast<jfloat>(report.framesPerSecond);
+    fillStageMetrics(values + 3);
+    jfloatArray result = env->NewFloatArray(3 + kStageMetricValues);
+    if (result) {
+        env->SetFloatArrayRegion(result, 0, 3 + kStageMetricValues, values);
+    }
+    return result;
+}
+
+// Edge maps of every frame of a video on the batch path (batch_processor.h):
+// batches of batchFrames frames run across OpenCV's pool while the decoder
+// fills the next batch, and the maps (downscaled, CV_8UC1, tightly packed) are
+// appended to outputFd in frame order. No live preview state is touched.
+// Blocking; returns [maps written, map width, map height], or null on a
+// missing video track, invalid parameters or a write error.
+extern "C"
+JNIEXPORT jintArray JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeDecodeVideoEdges(JNIEnv *env, jclass clazz, jint fd,
+                                                                        jlong offset, jlong length, jint outputFd,
+                                                                        jint downscale, jint lowThreshold,
+                                                                        jint highThreshold, jboolean preBlur,
+                                                                        jint batchFrames) {
+    if (downscale < 1 || lowThreshold < 0 || highThreshold < lowThreshold || batchFrames < 1) {
+        LOGE("❌ nativeDecodeVideoEdges: valid scale, thresholds and batch size required");
+        return nullptr;
+    }
+    VideoFileSource source;
+    if (!source.open(fd, offset, length)) {
+        return nullptr;
+    }
+    BatchParams params;
+    params.downscale = downscale;
+    params.lowThreshold = lowThreshold;
+    params.highThreshold = highThreshold;
+    params.preBlur = preBlur == JNI_TRUE;
+    videoDecodeCancelled.store(false);
+    const int written = decodeVideoEdges(source, params, batchFrames, outputFd, &videoDecodeCancelled);
+    if (written < 0) {
+        return nullptr;
+    }
+    params.width = source.width() & ~1;
+    params.height = source.height() & ~1;
+    jint values[3] = {written, 0, 0};
+    batchOutputSize(params, values[1], values[2]);
+    jintArray result = env->NewIntArray(3);
+    if (result) {
+        env->SetIntArrayRegion(result, 0, 3, values);
+    }
+    return result;
+}
+
+// Ends a running nativeProcessVideoFile / nativeDecodeVideoEdges after the
+// current frame
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeCancelVideoDecode(JNIEnv *env, jclass clazz) {
+    videoDecodeCancelled.store(true);
+}
+
+extern "C"
+JNIEXPORT jobjectArray JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetStageNames(JNIEnv *env, jclass clazz) {
+    const int stageCount = static_cast<int>(Stage::COUNT);
+    jobjectArray names = env->NewObjectArray(stageCount, jniCache().stringClass, nullptr);
+    for (int i = 0; names && i < stageCount; i++) {
+        jstring name = env->NewStringUTF(stageName(static_cast<Stage>(i)));
+        env->SetObjectArrayElement(names, i, name);
+        env->DeleteLocalRef(name);
+    }
+    return names;
+}
+
+// Keeps a second render mode's variants up to date so switching to it shows a
+// current frame immediately (-1 disables pre-warming)
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetPrewarmMode(JNIEnv *env, jclass clazz, jint mode) {
+    prewarmMode.store(mode);
+    LOGI("🔄 Pre-warm mode set to: %d", mode);
+}
+
+// Keeps a snapshot of the view per render mode in modeMask (a bit per mode)
+// on every GL thread, within budgetKb in total, so switching to one shows a
+// recent frame before the new mode's first. refreshFrames > 0 also builds
+// one inactive resident mode every that many frames to keep its snapshot
+// current; 0 only snapshots modes while they are shown. A zero mask or
+// budget turns residency off.
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetModeResidency(JNIEnv *env, jclass clazz, jint modeMask,
+                                                                       jint budgetKb, jint refreshFrames) {
+    const uint32_t modes = static_cast<uint32_t>(modeMask) & ((1u << kRenderModeCount) - 1);
+    const int64_t budget = modes != 0 ? std::max(budgetKb, 0) * 1024LL : 0;
+    residentModes.store(modes, std::memory_order_relaxed);
+    residencyBudgetBytes.store(budget, std::memory_order_relaxed);
+    residentRefreshFrames.store(std::max(refreshFrames, 0), std::memory_order_relaxed);
+    residencyPressureMicros.store(0, std::memory_order_relaxed);
+    setModeResidencyGL(modes, budget);
+    LOGI("🔄 Mode residency: modes 0x%x, %lld KB, refresh every %d frames", modes,
+         static_cast<long long>(budget / 1024), refreshFrames);
+}
+
+// Toggles the luma fast path (false = original NV21 -> BGR -> GRAY pipeline)
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetLumaFastPath(JNIEnv *env, jclass clazz, jboolean enabled) {
+    lumaFastPath.store(enabled == JNI_TRUE);
+    LOGI("🔄 Luma fast path %s", enabled ? "enabled" : "disabled");
+}
+
+// Toggles the banded NV21 -> BGR -> gray conversion of the legacy path
+// (band_executor.h); off = the two full-frame cvtColor sweeps, for A/B runs
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetBandFusion(JNIEnv *env, jclass clazz, jboolean enabled) {
+    bandFusion.store(enabled == JNI_TRUE);
+    LOGI("🔄 Band fusion %s", enabled ? "enabled" : "disabled");
+}
+
+// Writes single-layer frames (RAW_CAMERA, GRAYSCALE, CPU EDGE_DETECTION
+// without an ROI) into AHardwareBuffers the renderer samples through
+// EGLImages, replacing its conversion and texture upload. False (and left
+// off) where the buffers cannot be locked; frames fall back to uploads
+// whenever a buffer cannot be written or wrapped.
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetHardwareBufferFrames(JNIEnv *env, jclass clazz,
+                                                                             jboolean enabled) {
+    const bool on = enabled == JNI_TRUE;
+    if (on && !hardwareFramesAvailable()) {
+        LOGW("⚠️ AHardwareBuffer locking unavailable, frames keep the upload path");
+        return JNI_FALSE;
+    }
+    if (hardwareFrames.exchange(on) && !on) {
+        releaseHardwareFrames();  // frames still on screen keep their buffers
+    }
+    LOGI("🔄 Hardware buffer frames %s", on ? "enabled" : "disabled");
+    return JNI_TRUE;
+}
+
+// Selects the EDGE_DETECTION backend (EdgeBackend: 0 = CPU Canny, 1 = GPU
+// passes, 2 = OpenCL through cv::UMat for every CPU-pipeline Canny and BGR
+// grayscale conversion, 3 = OpenCL kernels on the camera's GL texture, 4 =
+// Canny blended with the model loaded by nativeLoadEdgeModel, 5 = Vulkan
+// compute shaders; select it before starting the native camera so the reader
+// hands out GPU-sampleable buffers)
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetEdgeBackend(JNIEnv *env, jclass clazz, jint backend) {
+    if (backend < EDGE_BACKEND_CPU || backend > EDGE_BACKEND_SPLIT) {
+        LOGE("❌ Unknown edge backend: %d", backend);
+        return;
+    }
+    if (backend == EDGE_BACKEND_VULKAN && !vulkanEdgesAvailable()) {
+        LOGW("⚠️ Vulkan compute unavailable, keeping the current edge backend");
+        return;
+    }
+    if (backend == EDGE_BACKEND_OPENCL && !initOpenCLProcessing()) {
+        LOGW("⚠️ OpenCL unavailable, the OpenCL backend runs on the CPU");
+    }
+    if (backend == EDGE_BACKEND_DNN && !dnnEdgeDetector().ready()) {
+        LOGW("⚠️ No edge model loaded, the DNN backend runs plain Canny");
+    }
+    const int previous = edgeBackend.exchange(backend);
+    if (previous == EDGE_BACKEND_VULKAN && backend != EDGE_BACKEND_VULKAN) {
+        vulkanEdgesRelease();  // frames still on screen keep their buffers
+    }
+    if (backend == EDGE_BACKEND_SPLIT && previous != EDGE_BACKEND_SPLIT) {
+        splitBalancer().reset();  // costs measured under other loads do not carry over
+    }
+    LOGI("🔄 Edge backend: %s", kEdgeBackendNames[backend]);
+}
+
+// Edge backend the stall watchdog moved away from, -1 while at NORMAL
+static std::atomic<int> watchdogSavedBackend{-1};
+
+// Leaving NORMAL reroutes edges to the CPU (FAST_EDGES through
+// fastEdgesActive); coming back restores the backend unless the app picked
+// another one meanwhile
+static void onWatchdogLevel(int from, int to) {
+    if (from == StallWatchdog::NORMAL) {
+        watchdogSavedBackend.store(edgeBackend.exchange(EDGE_BACKEND_CPU));
+    } else if (to == StallWatchdog::NORMAL) {
+        const int saved = watchdogSavedBackend.exchange(-1);
+        int expected = EDGE_BACKEND_CPU;
+        if (saved >= 0) {
+            edgeBackend.compare_exchange_strong(expected, saved);
+        }
+    }
+    static const char* const kLevels[] = {"normal", "cheap", "passthrough"};
+    LOGW("⚠️ Stall watchdog: %s -> %s", kLevels[from], kLevels[to]);
+}
+
+// Rebuilt lazily at their next use, once the watchdog steps back up
+static void recreateEdgeResources() {
+    if (watchdogSavedBackend.load() == EDGE_BACKEND_VULKAN) {
+        vulkanEdgesRelease();
+    }
+    gapiEdgePipeline().reset();
+    incrementalEdgeDetector().reset();
+}
+
+// Starts the stall watchdog on the default pipeline: a frame in flight for
+// stallMs, failureLimit failed frames in a row, or stallMs of frames without
+// a publish each step the pipeline down one level (CPU FAST_EDGES, then
+// grayscale passthrough), and recoverMs of steady frames step it back up.
+// Calling it again while running only updates the values.
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeStartStallWatchdog(JNIEnv *env, jclass clazz, jint stallMs,
+                                                                          jint failureLimit, jint recoverMs) {
+    if (stallMs < 100 || stallMs > 10000 || failureLimit < 1 || recoverMs < stallMs) {
+        LOGE("❌ Invalid stall watchdog params: stall %d ms, %d failures, recovery %d ms", stallMs, failureLimit,
+             recoverMs);
+        return JNI_FALSE;
+    }
+    StallWatchdog::Params params;
+    params.stallMs = stallMs;
+    params.failureLimit = failureLimit;
+    params.recoverMs = recoverMs;
+    StallWatchdog::Hooks hooks;
+    hooks.levelChanged = onWatchdogLevel;
+    hooks.recreate = recreateEdgeResources;
+    stallWatchdog().start(params, hooks);
+    return JNI_TRUE;
+}
+
+// Stops the watchdog; a degraded pipeline goes straight back to NORMAL
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeStopStallWatchdog(JNIEnv *env, jclass clazz) {
+    const int level = stallWatchdog().level();
+    stallWatchdog().stop();
+    if (level != StallWatchdog::NORMAL) {
+        onWatchdogLevel(level, StallWatchdog::NORMAL);
+    }
+}
+
+// [level (0 normal, 1 cheap, 2 passthrough), stalls, recoveries, stage of
+// the last stall (Stage index, -1 none)]
+extern "C"
+JNIEXPORT jlongArray JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetStallWatchdog(JNIEnv *env, jclass clazz) {
+    const StallWatchdog& watchdog = stallWatchdog();
+    const Stage stage = watchdog.lastStallStage();
+    const jlong values[4] = {
+        watchdog.level(),
+        static_cast<jlong>(watchdog.stallCount()),
+        static_cast<jlong>(watchdog.recoveryCount()),
+        stage == Stage::COUNT ? -1 : static_cast<jlong>(stage),
+    };
+    jlongArray result = env->NewLongArray(4);
+    if (result) {
+        env->SetLongArrayRegion(result, 0, 4, values);
+    }
+    return result;
+}
+
+// Loads the learned edge model for the DNN backend (config may be null for
+// ONNX), warms it up and starts its inference thread. Blocks for the whole
+// load, so call it once at startup from a background thread.
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeLoadEdgeModel(JNIEnv *env, jclass clazz, jstring model,
+                                                                   jstring config, jint inputWidth,
+                                                                   jint inputHeight, jboolean openClFp16) {
+    if (!model || inputWidth <= 0 || inputHeight <= 0) {
+        LOGE("❌ Invalid edge model arguments");
+        return JNI_FALSE;
+    }
+    auto toString = [env](jstring value) {
+        std::string result;
+        if (value) {
+            const char* chars = env->GetStringUTFChars(value, nullptr);
+            if (chars) {
+                result = chars;
+                env->ReleaseStringUTFChars(value, chars);
+            }
+        }
+        return result;
+    };
+    DnnEdgeDetector::Options options;
+    options.inputSize = cv::Size(inputWidth, inputHeight);
+    options.preferOpenClFp16 = openClFp16 == JNI_TRUE;
+    return dnnEdgeDetector().load(toString(model), toString(config), options) ? JNI_TRUE : JNI_FALSE;
+}
+
+// Loads the edge model on the fastest engine that runs it: tflite (a
+// .tflite file, float or int8 quantized) on the TFLite GPU delegate when gpu
+// is set, then on the TFLite CPU, then model / config (may be null; ONNX,
+// Caffe...) through cv::dnn at inputWidth x inputHeight. Returns the engine
+// (0 cv::dnn, 1 TFLite CPU, 2 TFLite GPU) or -1 when none could load.
+// Blocks for the whole load, like nativeLoadEdgeModel.
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeLoadEdgeModelAccelerated(JNIEnv *env, jclass clazz,
+                                                                              jstring tflite, jstring model,
+                                                                              jstring config, jint inputWidth,
+                                                                              jint inputHeight, jboolean gpu) {
+    if ((!tflite && !model) || inputWidth <= 0 || inputHeight <= 0) {
+        LOGE("❌ Invalid edge model arguments");
+        return -1;
+    }
+    auto toString = [env](jstring value) {
+        std::string result;
+        if (value) {
+            const char* chars = env->GetStringUTFChars(value, nullptr);
+            if (chars) {
+                result = chars;
+                env->ReleaseStringUTFChars(value, chars);
+            }
+        }
+        return result;
+    };
+    DnnEdgeDetector::Options options;
+    options.inputSize = cv::Size(inputWidth, inputHeight);
+    options.tfliteModel = toString(tflite);
+    options.tfliteGpu = gpu == JNI_TRUE;
+    DnnEdgeDetector& detector = dnnEdgeDetector();
+    return detector.load(toString(model), toString(config), options) ? detector.engineKind() : -1;
+}
+
+// Probes the OpenCL runtime (once; cached afterwards), so the app can decide
+// at startup whether to offer the OpenCL edge backend
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeIsOpenClAvailable(JNIEnv *env, jclass clazz) {
+    return initOpenCLProcessing() ? JNI_TRUE : JNI_FALSE;
+}
+
+// Limits grayscale and Canny to a sensor-space rectangle (pixels, before
+// rotation); the renderer draws the result there over the raw feed. A zero
+// width or height processes the whole frame again.
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetProcessingRoi(JNIEnv *env, jclass clazz,
+                                                                        jint x, jint y, jint width, jint height) {
+    setProcessingRoi(x, y, width, height);
+}
+
+// Darkens the raw feed outside the processing ROI (0 = unchanged, 1 = black)
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetRoiBackgroundDim(JNIEnv *env, jclass clazz, jfloat dim) {
+    roiBackgroundDim.store(std::max(0.0f, std::min(1.0f, static_cast<float>(dim))));
+    LOGI("🔄 ROI background dim: %.2f", dim);
+}
+
+// Processes grayscale/edges at 1/divisor of the camera resolution (1 = full,
+// 2 = half, 4 = quarter); clears any explicit processing size
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetProcessingScale(JNIEnv *env, jclass clazz, jint divisor) {
+    setProcessingScale(divisor);
+}
+
+// The control block (control_block.h) as a direct buffer over native memory,
+// filled with the current settings on the first call; Java writes settings
+// there instead of calling the setters, and they apply at the next frame
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetControlBlock(JNIEnv *env, jclass clazz) {
+    ControlValues current;
+    current.renderMode = static_cast<int>(activeRenderMode(defaultPipeline));
+    current.flags = (adaptiveThresholdsEnabled() ? kControlAdaptiveThresholds : 0) |
+                    (edgePreBlurEnabled() ? kControlEdgePreBlur : 0);
+    currentCannyThresholds(current.cannyLow, current.cannyHigh);
+    {
+        std::lock_guard<std::mutex> lock(roiMutex);
+        current.roiX = processingRoi.x;
+        current.roiY = processingRoi.y;
+        current.roiWidth = processingRoi.width;
+        current.roiHeight = processingRoi.height;
+    }
+    current.scaleDivisor = processingDivisor.load();
+    current.roiBackgroundDim = roiBackgroundDim.load();
+    current.orientation = -1;  // the renderer keeps what setOrientationNative set
+    initControlBlock(current);
+    return env->NewDirectByteBuffer(&controlBlock(), sizeof(ControlBlock));
+}
+
+// The stats block (control_block.h) as a direct buffer: rewritten after every
+// frame the default pipeline publishes, read by Java without a JNI call
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetStatsBlock(JNIEnv *env, jclass clazz) {
+    return env->NewDirectByteBuffer(&statsBlock(), sizeof(StatsBlock));
+}
+
+// Processes grayscale/edges fitted into width x height (sensor orientation,
+// aspect kept, never upscaled); 0 x 0 falls back to the scale divisor
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetProcessingSize(JNIEnv *env, jclass clazz, jint width, jint height) {
+    if (width < 0 || height < 0) {
+        LOGE("❌ Invalid processing size: %dx%d", width, height);
+        return;
+    }
+    processingTargetWidth.store(width);
+    processingTargetHeight.store(height);
+    LOGI("🔄 Processing size: %dx%d", width, height);
+}
+
+// Canny thresholds follow the scene's median luma (true) or stay at 100/200
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetAdaptiveThresholds(JNIEnv *env, jclass clazz, jboolean enabled) {
+    setAdaptiveThresholds(enabled == JNI_TRUE);
+    LOGI("🔄 Adaptive Canny thresholds %s", enabled ? "enabled" : "disabled");
+}
+
+// 5x5 Gaussian pre-blur ahead of CPU Canny (fused into the in-house kernel's
+// gradient pass), so sensor noise does not turn into speckle
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetEdgePreBlur(JNIEnv *env, jclass clazz, jboolean enabled) {
+    setEdgePreBlur(enabled == JNI_TRUE);
+    incrementalEdgeDetector().reset();  // cached blocks were computed without it
+    LOGI("🔄 Edge pre-blur %s", enabled ? "enabled" : "disabled");
+}
+
+// Streams the default pipeline's edge maps to host:port over UDP (see
+// edge_stream.h for the datagram format): 1-bpp, XOR-delta against the
+// previous frame with a keyframe every keyframeInterval frames, run-length
+// coded. Compression and sends run on a dedicated thread behind a one-frame
+// mailbox, so a slow network drops frames instead of slowing processing.
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeStartEdgeStream(JNIEnv *env, jclass clazz, jstring host,
+                                                                       jint port, jint keyframeInterval) {
+    const char* chars = host ? env->GetStringUTFChars(host, nullptr) : nullptr;
+    if (!chars) {
+        return JNI_FALSE;
+    }
+    std::string target = chars;
+    env->ReleaseStringUTFChars(host, chars);
+    const bool started = edgeStreamer().start(target, port, keyframeInterval);
+    updateEdgeReadback();
+    return started ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeStopEdgeStream(JNIEnv *env, jclass clazz) {
+    edgeStreamer().stop();
+    updateEdgeReadback();
+}
+
+// [frames sent, frames replaced by a newer one before sending, frames dropped
+// on congestion, bytes sent]
+extern "C"
+JNIEXPORT jlongArray JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetEdgeStreamStats(JNIEnv *env, jclass clazz) {
+    const EdgeStreamStats stats = edgeStreamer().stats();
+    const jlong values[4] = {static_cast<jlong>(stats.framesSent), static_cast<jlong>(stats.framesReplaced),
+                             static_cast<jlong>(stats.framesCongested), static_cast<jlong>(stats.bytesSent)};
+    jlongArray result = env->NewLongArray(4);
+    if (result) {
+        env->SetLongArrayRegion(result, 0, 4, values);
+    }
+    return result;
+}
+
+// Alternates the CPU edge stage's frames between backends a and b
+// (BackendComparison::Backend: 1 cv::Canny, 2 kernel, 3 tiled, 4 gradient,
+// 5 OpenCL), each timed into its own histogram, comparing both edge maps
+// every sampleEvery-th frame (0 = never)
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeStartBackendComparison(JNIEnv *env, jclass clazz, jint a,
+                                                                             jint b, jint sampleEvery) {
+    return backendComparison().start(a, b, sampleEvery) ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeStopBackendComparison(JNIEnv *env, jclass clazz) {
+    backendComparison().stop();
+}
+
+// {backend A, backend B, frames A, frames B, mean us A, mean us B, median us
+// A, median us B, speedup of B (A's mean / B's), disagreement 0..1, frames
+// compared}; null while no comparison runs
+extern "C"
+JNIEXPORT jfloatArray JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetBackendComparison(JNIEnv *env, jclass clazz) {
+    const BackendComparison::Stats stats = backendComparison().stats();
+    if (stats.backendA == 0) {
+        return nullptr;
+    }
+    const jfloat values[11] = {static_cast<jfloat>(stats.backendA), static_cast<jfloat>(stats.backendB),
+                               static_cast<jfloat>(stats.frames[0]), static_cast<jfloat>(stats.frames[1]),
+                               static_cast<jfloat>(stats.meanMicros[0]), static_cast<jfloat>(stats.meanMicros[1]),
+                               static_cast<jfloat>(stats.medianMicros[0]), static_cast<jfloat>(stats.medianMicros[1]),
+                               static_cast<jfloat>(stats.speedup), static_cast<jfloat>(stats.disagreement),
+                               static_cast<jfloat>(stats.samples)};
+    jfloatArray result = env->NewFloatArray(11);
+    if (result) {
+        env->SetFloatArrayRegion(result, 0, 11, values);
+    }
+    return result;
+}
+
+// Serves the metrics in Prometheus text format on 127.0.0.1:port (GET
+// /metrics) from a thread of its own, for `adb forward tcp:<port> tcp:<port>`;
+// scrapes read the metrics without locking anything the frame path takes
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeStartMetricsServer(JNIEnv *env, jclass clazz, jint port) {
+    return metricsServer().start(port) ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeStopMetricsServer(JNIEnv *env, jclass clazz) {
+    metricsServer().stop();
+}
+
+// Scrapes answered since the process started
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetMetricsServerScrapes(JNIEnv *env, jclass clazz) {
+    return static_cast<jlong>(metricsServer().scrapeCount());
+}
+
+// Archives the default pipeline's edge maps to path (and path + ".idx"): 1-bpp
+// XOR deltas against a keyframe every keyframeInterval frames, zero-run
+// coded and appended by a background thread (layout in edge_archive.h), at
+// most one frame per minIntervalMs (0 = all)
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeStartEdgeArchive(JNIEnv *env, jclass clazz, jstring path,
+                                                                        jint keyframeInterval, jint minIntervalMs) {
+    const char* chars = path ? env->GetStringUTFChars(path, nullptr) : nullptr;
+    if (!chars) {
+        return JNI_FALSE;
+    }
+    std::string target = chars;
+    env->ReleaseStringUTFChars(path, chars);
+    const bool started = edgeArchiver().start(target, keyframeInterval, minIntervalMs);
+    updateEdgeReadback();
+    return started ? JNI_TRUE : JNI_FALSE;
+}
+
+// Writes what is still queued, then closes the files
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeStopEdgeArchive(JNIEnv *env, jclass clazz) {
+    edgeArchiver().stop();
+    updateEdgeReadback();
+}
+
+// [frames archived, keyframes, frames skipped by the interval, frames dropped
+// behind the writer, bytes at 8 bpp, bytes stored]
+extern "C"
+JNIEXPORT jlongArray JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetEdgeArchiveStats(JNIEnv *env, jclass clazz) {
+    const EdgeArchiveStats stats = edgeArchiver().stats();
+    const jlong values[6] = {static_cast<jlong>(stats.framesArchived), static_cast<jlong>(stats.keyframes),
+                             static_cast<jlong>(stats.framesSkipped), static_cast<jlong>(stats.framesDropped),
+                             static_cast<jlong>(stats.rawBytes), static_cast<jlong>(stats.storedBytes)};
+    jlongArray result = env->NewLongArray(6);
+    if (result) {
+        env->SetLongArrayRegion(result, 0, 6, values);
+    }
+    return result;
+}
+
+// Decodes frame `frame` of an archive into a direct buffer as the 1-bpp
+// bitmap nativeCopyPackedEdges produces. Returns width << 16 | height, or 0
+// when the frame is not in the archive or the buffer is too small.
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeReadArchivedEdges(JNIEnv *env, jclass clazz, jstring path,
+                                                                         jint frame, jobject output) {
+    const char* chars = path ? env->GetStringUTFChars(path, nullptr) : nullptr;
+    if (!chars || frame < 0) {
+        if (chars) {
+            env->ReleaseStringUTFChars(path, chars);
+        }
+        return 0;
+    }
+    std::string source = chars;
+    env->ReleaseStringUTFChars(path, chars);
+    cv::Mat bits;
+    int width = 0;
+    int64_t timestampNs = 0;
+    if (!readArchivedEdges(source, static_cast<uint32_t>(frame), bits, width, timestampNs)) {
+        return 0;
+    }
+    auto* destination = output ? static_cast<uchar*>(env->GetDirectBufferAddress(output)) : nullptr;
+    if (!destination || env->GetDirectBufferCapacity(output) < static_cast<jlong>(bits.total())) {
+        return 0;
+    }
+    std::memcpy(destination, bits.data, bits.total());
+    return (width << 16) | bits.rows;
+}
+
+// Publishes every edge map of the default pipeline into an ASharedMemory ring
+// of `slots` maps of up to maxWidth x maxHeight for other processes (API 26+;
+// layout and the lock-free read protocol in shared_edge_output.h). Returns an
+// fd of the read-only region for the consumer, owned by the caller (hand it
+// over as a ParcelFileDescriptor), or -1. Publishing never waits for readers.
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeStartSharedEdgeOutput(JNIEnv *env, jclass clazz, jint slots,
+                                                                             jint maxWidth, jint maxHeight) {
+    const int fd = sharedEdgeOutput().start(slots, maxWidth, maxHeight);
+    updateEdgeReadback();
+    return fd;
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeStopSharedEdgeOutput(JNIEnv *env, jclass clazz) {
+    sharedEdgeOutput().stop();
+    updateEdgeReadback();
+}
+
+// Stores the displayed CPU edge map at 1 bit per pixel (packed_edges.h)
+// instead of one byte; the renderer expands it in the shader. Applies from the
+// next processed frame; soft maps (filter graphs, learned edges) stay 8-bit.
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetPackedEdges(JNIEnv *env, jclass clazz, jboolean enabled) {
+    packedEdgeStorage.store(enabled == JNI_TRUE);
+    LOGI("🔄 Packed edge storage %s", enabled ? "enabled" : "disabled");
+}
+
+// Copies the newest edge map of the default pipeline into a direct buffer as
+// a 1-bpp bitmap (packing it here when it is stored 8-bit): height rows of
+// packedEdgeRowBytes(width) = (width + 31) / 32 * 4 bytes, least significant
+// bit first. Returns width << 16 | height, or 0 when there is no single-channel
+// edge map yet or the buffer is too small.
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeCopyPackedEdges(JNIEnv *env, jclass clazz, jobject output) {
+    cv::Mat processed;
+    int bitmapWidth = 0;
+    {
+        std::lock_guard<std::mutex> lock(defaultPipeline.publishMutex);
+        processed = defaultPipeline.lastPublished.processed;  // immutable once published
+        bitmapWidth = defaultPipeline.lastPublished.processedBitmapWidth;
+    }
+    if (processed.empty() || processed.type() != CV_8UC1) {
+        return 0;
+    }
+    const int width = bitmapWidth > 0 ? bitmapWidth : processed.cols;
+    const size_t rowBytes = static_cast<size_t>(packedEdgeRowBytes(width));
+    auto* destination = output ? static_cast<uchar*>(env->GetDirectBufferAddress(output)) : nullptr;
+    if (!destination || env->GetDirectBufferCapacity(output) < static_cast<jlong>(rowBytes * processed.rows)) {
+        return 0;
+    }
+    cv::Mat bits(processed.rows, static_cast<int>(rowBytes), CV_8UC1, destination);
+    if (bitmapWidth > 0) {
+        processed.copyTo(bits);
+    } else {
+        packEdges(processed, bits);
+    }
+    return (width << 16) | processed.rows;
+}
+
+// Writes a layer of the default pipeline's newest frame (0 raw, 1 grayscale,
+// 2 processed) into a caller-owned, reused Bitmap (RGBA_8888, RGB_565 or
+// ALPHA_8), scaled to the bitmap's size and, when upright, rotated by the
+// frame's rotation; one pass straight into the locked pixels (bitmap_writer.h),
+// the raw layer from the NV21 planes when no RGBA copy was kept (grayscale and
+// processed cover just the processing ROI when one is set). Returns the
+// frame's publish sequence, 0 when the layer is missing or the bitmap unusable.
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeCopyFrameToBitmap(JNIEnv *env, jclass clazz, jobject bitmap,
+                                                                         jint layer, jboolean upright) {
+    BitmapSource source;
+    uint64_t sequence = 0;
+    {
+        std::lock_guard<std::mutex> lock(defaultPipeline.publishMutex);
+        const PublishedFrame& latest = defaultPipeline.lastPublished;  // immutable once published
+        sequence = latest.sequence;
+        if (layer == 0) {
+            source.image = latest.raw;
+            if (source.image.empty()) {
+                source.image = latest.yuvLuma;
+                source.chroma = latest.yuvChroma;
+            }
+        } else if (layer == 1) {
+            source.image = latest.grayscale;
+        } else if (layer == 2) {
+            source.image = latest.processed;
+            source.packedWidth = latest.processedBitmapWidth;
+        }
+        source.rotation = upright == JNI_TRUE ? latest.rotation : 0;
+    }
+    if (source.image.empty() || !bitmap) {
+        return 0;
+    }
+    AndroidBitmapInfo info;
+    if (AndroidBitmap_getInfo(env, bitmap, &info) != ANDROID_BITMAP_RESULT_SUCCESS) {
+        LOGE("❌ AndroidBitmap_getInfo failed");
+        return 0;
+    }
+    void* pixels = nullptr;
+    if (AndroidBitmap_lockPixels(env, bitmap, &pixels) != ANDROID_BITMAP_RESULT_SUCCESS || !pixels) {
+        LOGE("❌ AndroidBitmap_lockPixels failed");
+        return 0;
+    }
+    const bool written = writeBitmap(source, static_cast<BitmapFormat>(info.format), pixels,
+                                     static_cast<int>(info.width), static_cast<int>(info.height),
+                                     static_cast<int>(info.stride));
+    AndroidBitmap_unlockPixels(env, bitmap);
+    return written ? static_cast<jlong>(sequence) : 0;
+}
+
+// Emits an EdgeRecord (canny_kernel.h) per CPU Canny edge pixel, up to
+// capacity per frame, next to the edge map; 0 turns it off. Recording runs
+// the in-house kernel on the whole frame, in place of G-API or incremental
+// edges; FAST_EDGES, filter graphs and the renderer backends have no records.
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetEdgeRecords(JNIEnv *env, jclass clazz, jint capacity) {
+    const int clamped = std::min(std::max(capacity, 0), kMaxEdgeRecords);
+    edgeRecordCapacity.store(clamped);
+    LOGI("🔄 Edge records %s (capacity %d)", clamped > 0 ? "enabled" : "disabled", clamped);
+}
+
+// Copies the newest frame's edge records into a direct buffer, 8 bytes each
+// in native byte order: x, y (uint16, on the record grid), direction (256
+// steps per turn), axis, offset (int8, 1/128 step along the axis), strength.
+// info (int[7], may be null) receives dropped, grid width, grid height and
+// the full-frame rectangle x, y, width, height the grid covers. Returns the
+// record count, -1 when there are none yet or the buffer is too small.
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetEdgeRecords(JNIEnv *env, jclass clazz, jobject output,
+                                                                      jintArray info) {
+    cv::Mat records;
+    jint values[7];
+    {
+        std::lock_guard<std::mutex> lock(defaultPipeline.publishMutex);
+        const PublishedFrame& latest = defaultPipeline.lastPublished;  // immutable once published
+        if (!latest.hasEdgeRecords) {
+            return -1;
+        }
+        records = latest.edgeRecords;
+        values[0] = latest.edgeRecordsDropped;
+        values[1] = latest.edgeRecordGrid.width;
+        values[2] = latest.edgeRecordGrid.height;
+        values[3] = latest.edgeRecordRoi.x;
+        values[4] = latest.edgeRecordRoi.y;
+        values[5] = latest.edgeRecordRoi.width;
+        values[6] = latest.edgeRecordRoi.height;
+    }
+    const size_t bytes = static_cast<size_t>(records.rows) * sizeof(EdgeRecord);
+    auto* destination = output ? static_cast<uchar*>(env->GetDirectBufferAddress(output)) : nullptr;
+    if (!destination || env->GetDirectBufferCapacity(output) < static_cast<jlong>(bytes)) {
+        return -1;
+    }
+    if (bytes > 0) {
+        std::memcpy(destination, records.data, bytes);
+    }
+    if (info && env->GetArrayLength(info) >= 7) {
+        env->SetIntArrayRegion(info, 0, 7, values);
+    }
+    return records.rows;
+}
+
+// Native storage behind the nativeSetEdgePoints view
+static cv::Mat edgePointView;
+static std::mutex edgePointViewMutex;
+
+// Compacts every CPU edge map into up to capacity (x, y) uint16 pairs (0 =
+// off) and returns a direct buffer of capacity * 4 bytes that
+// nativeGetEdgePoints fills, or null when off. The storage is replaced by the
+// next call, so Java must drop the previous buffer before calling again.
+extern "C"
+JNIEXPORT jobject JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetEdgePoints(JNIEnv *env, jclass clazz, jint capacity) {
+    const int clamped = std::min(std::max(capacity, 0), kMaxEdgePoints);
+    edgePointCapacity.store(clamped);
+    LOGI("🔄 Edge points %s (capacity %d)", clamped > 0 ? "enabled" : "disabled", clamped);
+    std::lock_guard<std::mutex> lock(edgePointViewMutex);
+    edgePointView = clamped > 0 ? cv::Mat(clamped, 1, CV_16UC2) : cv::Mat();
+    if (edgePointView.empty()) {
+        return nullptr;
+    }
+    return env->NewDirectByteBuffer(edgePointView.data, static_cast<jlong>(edgePointView.total() * 4));
+}
+
+// Copies the newest frame's edge points into the nativeSetEdgePoints buffer
+// (native byte order, x then y) and returns their count, -1 when there are
+// none yet. info (int[7], may be null): as for nativeGetEdgeRecords.
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetEdgePoints(JNIEnv *env, jclass clazz, jintArray info) {
+    cv::Mat points;
+    jint values[7];
+    {
+        std::lock_guard<std::mutex> lock(defaultPipeline.publishMutex);
+        const PublishedFrame& latest = defaultPipeline.lastPublished;  // immutable once published
+        if (!latest.hasEdgePoints) {
+            return -1;
+        }
+        points = latest.edgePoints;
+        values[0] = latest.edgePointsDropped;
+        values[1] = latest.edgePointGrid.width;
+        values[2] = latest.edgePointGrid.height;
+        values[3] = latest.edgePointRoi.x;
+        values[4] = latest.edgePointRoi.y;
+        values[5] = latest.edgePointRoi.width;
+        values[6] = latest.edgePointRoi.height;
+    }
+    std::lock_guard<std::mutex> lock(edgePointViewMutex);
+    // Published with an earlier, larger capacity: what fits, the rest dropped
+    const int count = std::min(points.rows, edgePointView.rows);
+    if (count > 0) {
+        std::memcpy(edgePointView.data, points.data, static_cast<size_t>(count) * 4);
+    }
+    values[0] += points.rows - count;
+    if (info && env->GetArrayLength(info) >= 7) {
+        env->SetIntArrayRegion(info, 0, 7, values);
+    }
+    return count;
+}
+
+// Writes the newest frame of the default pipeline to path (.png, .jpg, ...;
+// upright): the camera image for RAW_CAMERA, the grayscale variant for
+// GRAYSCALE, the edge map for any other mode. Only Mat headers are taken
+// here; conversion and encoding run on the snapshot thread, and a request
+// still waiting there is replaced by this one. Returns false when the frame
+// has nothing for that mode (poll nativeSnapshotsWritten for completion).
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeCaptureSnapshot(JNIEnv *env, jclass clazz,
+                                                                       jstring path, jint mode) {
+    if (!path || mode < 0 || mode >= kRenderModeCount) {
+        return JNI_FALSE;
+    }
+    SnapshotRequest request;
+    {
+        std::lock_guard<std::mutex> lock(defaultPipeline.publishMutex);
+        const PublishedFrame& latest = defaultPipeline.lastPublished;  // immutable once published
+        if (mode == RAW_CAMERA) {
+            if (!latest.raw.empty()) {
+                request.image = latest.raw;
+            } else {
+                request.image = latest.yuvLuma;
+                request.chroma = latest.yuvChroma;
+            }
+        } else if (mode == GRAYSCALE) {
+            request.image = latest.grayscale;
+        } else {
+            request.image = latest.processed;
+            request.bitmapWidth = latest.processedBitmapWidth;
+        }
+        request.rotation = latest.rotation;
+    }
+    if (request.image.empty()) {
+        LOGW("⚠️ No frame to snapshot for mode %d", mode);
+        return JNI_FALSE;
+    }
+    const char* chars = env->GetStringUTFChars(path, nullptr);
+    if (!chars) {
+        return JNI_FALSE;
+    }
+    request.path = chars;
+    env->ReleaseStringUTFChars(path, chars);
+    snapshotExporter().submit(std::move(request));
+    return JNI_TRUE;
+}
+
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSnapshotsWritten(JNIEnv *env, jclass clazz) {
+    return static_cast<jlong>(snapshotExporter().writtenCount());
+}
+
+// Thickens the displayed CPU edge map of one render mode (-1 = every mode)
+// with a size x size rectangle: op 0 dilates, 1 closes (dilate + erode, which
+// bridges gaps without widening); size 1 turns it off. Cost does not depend on
+// the size. Returns false for an unknown mode or op or a size outside 1..31.
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetEdgeMorphology(JNIEnv *env, jclass clazz,
+                                                                         jint mode, jint op, jint size) {
+    if (mode < -1 || mode >= kRenderModeCount || op < 0 || op > 1 || size < 1 || size > 31) {
+        LOGE("❌ Invalid edge morphology: mode %d, op %d, size %d", mode, op, size);
+        return JNI_FALSE;
+    }
+    const int setting = (op << 8) | size;
+    for (int i = 0; i < kRenderModeCount; i++) {
+        if (mode == -1 || mode == i) {
+            edgeMorphology[i].store(setting, std::memory_order_relaxed);
+        }
+    }
+    LOGI("🔄 Edge morphology for mode %d: %s %dx%d", mode, op ? "close" : "dilate", size, size);
+    return JNI_TRUE;
+}
+
+// Labels the CPU edge map's 8-connected components (parallel labeling) and
+// drops those with fewer than minPixels pixels or whose bounding box's longer
+// side is shorter than minLength pixels before display, export, contours and
+// the other edge consumers; 0 or 1 keeps any. With report on, the kept
+// components' boxes are published (nativeGetEdgeComponents). Binary maps only:
+// not filter graph or learned edges. Returns false for negative thresholds.
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetEdgeComponents(JNIEnv *env, jclass clazz,
+                                                                         jint minPixels, jint minLength,
+                                                                         jboolean report) {
+    if (minPixels < 0 || minLength < 0) {
+        LOGE("❌ Invalid edge component thresholds: %d pixels, %d px long", minPixels, minLength);
+        return JNI_FALSE;
+    }
+    EdgeComponents::Params params;
+    params.minPixels = minPixels;
+    params.minLength = minLength;
+    params.report = report == JNI_TRUE;
+    edgeComponents().setParams(params);
+    LOGI("🔄 Edge components: keep >= %d pixels and >= %d px long, boxes %s", minPixels, minLength,
+         params.report ? "reported" : "not reported");
+    return JNI_TRUE;
+}
+
+// Edge components kept in the newest frame, 5 floats each: the box as u0, v0,
+// u1, v1 in 0..1 full-frame units (unrotated sensor orientation) and its pixel
+// count, in raster order of their first pixel, at most 1024; null until a
+// frame has been labeled with reporting on. total[0], when given, receives how
+// many components were labeled, kept or not.
+extern "C"
+JNIEXPORT jfloatArray JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetEdgeComponents(JNIEnv *env, jclass clazz, jintArray total) {
+    cv::Mat components;
+    jint labeled = 0;
+    {
+        std::lock_guard<std::mutex> lock(defaultPipeline.publishMutex);
+        if (!defaultPipeline.lastPublished.hasEdgeComponents) {
+            return nullptr;
+        }
+        components = defaultPipeline.lastPublished.edgeComponents;  // immutable once published
+        labeled = defaultPipeline.lastPublished.edgeComponentsTotal;
+    }
+    if (total && env->GetArrayLength(total) > 0) {
+        env->SetIntArrayRegion(total, 0, 1, &labeled);
+    }
+    const jsize length = static_cast<jsize>(components.rows * kEdgeComponentValues);
+    jfloatArray result = env->NewFloatArray(length);
+    if (result && length > 0) {
+        env->SetFloatArrayRegion(result, 0, length, components.ptr<jfloat>());
+    }
+    return result;
+}
+
+// Replaces Canny in the processed variant with a filter graph, e.g.
+// "gray|blur:5|canny:80,160|dilate:3|colormap:jet" (see filter_graph.h); ""
+// restores plain Canny. Returns false and keeps the current graph on a parse error.
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetFilterGraph(JNIEnv *env, jclass clazz, jstring config) {
+    std::string text;
+    if (config) {
+        const char* chars = env->GetStringUTFChars(config, nullptr);
+        if (!chars) {
+            return JNI_FALSE;
+        }
+        text = chars;
+        env->ReleaseStringUTFChars(config, chars);
+    }
+    std::string error;
+    if (!filterGraph().configure(text, error)) {
+        LOGE("❌ Filter graph '%s' rejected: %s", text.c_str(), error.c_str());
+        return JNI_FALSE;
+    }
+    LOGI("🔄 Filter graph: '%s'", text.c_str());
+    return JNI_TRUE;
+}
+
+// Loads the stage plugins (edge_stage_plugin.h) in directory, the app's
+// native library dir at startup: every libedgestage_*.so, whose stages
+// filter graph configs can then name. Returns the stages registered.
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeLoadStagePlugins(JNIEnv *env, jclass clazz, jstring directory) {
+    if (!directory) {
+        return 0;
+    }
+    const char* chars = env->GetStringUTFChars(directory, nullptr);
+    if (!chars) {
+        return 0;
+    }
+    const std::string path = chars;
+    env->ReleaseStringUTFChars(directory, chars);
+    return loadStagePlugins(path, "libedgestage_");
+}
+
+// "name: description" of every plugin stage loaded
+extern "C"
+JNIEXPORT jobjectArray JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetStagePlugins(JNIEnv *env, jclass clazz) {
+    const std::vector<std::string> plugins = stagePluginDescriptions();
+    jobjectArray names = env->NewObjectArray(static_cast<jsize>(plugins.size()), jniCache().stringClass, nullptr);
+    for (size_t i = 0; names && i < plugins.size(); i++) {
+        jstring name = env->NewStringUTF(plugins[i].c_str());
+        env->SetObjectArrayElement(names, static_cast<jsize>(i), name);
+        env->DeleteLocalRef(name);
+    }
+    return names;
+}
+
+// UTF-8 copy of a Java string; false for null or when the VM is out of memory
+static bool copyJavaString(JNIEnv* env, jstring text, std::string& out) {
+    const char* chars = text ? env->GetStringUTFChars(text, nullptr) : nullptr;
+    if (!chars) {
+        return false;
+    }
+    out = chars;
+    env->ReleaseStringUTFChars(text, chars);
+    return true;
+}
+
+// Defines or replaces a render effect: a fragment shader the GL threads run
+// over each frame layer while it is in the chain (render_effects.h for what
+// it is given; u_Params comes from the control block). Returns false with a
+// log on a bad name or source; compile errors show up in the renderer's log.
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeDefineRenderEffect(JNIEnv *env, jclass clazz, jstring name,
+                                                                        jstring fragment) {
+    std::string effectName;
+    std::string source;
+    std::string error = "null name or source";
+    if (!copyJavaString(env, name, effectName) || !copyJavaString(env, fragment, source) ||
+        !renderEffects().define(effectName, source, error)) {
+        LOGE("❌ Render effect '%s' rejected: %s", effectName.c_str(), error.c_str());
+        return JNI_FALSE;
+    }
+    return JNI_TRUE;
+}
+
+// Render effects applied to every frame layer, in order, by name (null or
+// empty = none); false and the chain unchanged on an unknown name
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetRenderEffects(JNIEnv *env, jclass clazz,
+                                                                      jobjectArray names) {
+    std::vector<std::string> chain;
+    const jsize count = names ? env->GetArrayLength(names) : 0;
+    for (jsize i = 0; i < count; i++) {
+        auto name = static_cast<jstring>(env->GetObjectArrayElement(names, i));
+        std::string text;
+        const bool copied = copyJavaString(env, name, text);
+        env->DeleteLocalRef(name);
+        if (!copied) {
+            LOGE("❌ Render effect chain: null name at %d", static_cast<int>(i));
+            return JNI_FALSE;
+        }
+        chain.push_back(text);
+    }
+    std::string error;
+    if (!renderEffects().setChain(chain, error)) {
+        LOGE("❌ Render effect chain rejected: %s", error.c_str());
+        return JNI_FALSE;
+    }
+    return JNI_TRUE;
+}
+
+// Switches the processed variant to 5x5 Gaussian blur + Canny compiled as a
+// G-API graph (blur and Sobel on the Fluid backend); off = plain Canny
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetGapiPipeline(JNIEnv *env, jclass clazz, jboolean enabled) {
+    gapiPipeline.store(enabled == JNI_TRUE);
+    LOGI("🔄 G-API pipeline %s", enabled ? "enabled" : "disabled");
+}
+
+// GapiStreamingPipeline sink: the edges and the luma they came from
+static void publishGapiStreamResult(const GapiStreamingPipeline::Result& result) {
+    PublishedFrame update;
+    update.processed = result.edges;
+    update.grayscale = result.luma;
+    update.rotation = result.rotation;
+    update.captureTimestampNs = result.timestampNs;
+    update.renderMode = EDGE_DETECTION;
+    update.modesBuilt = (1u << EDGE_DETECTION) | (1u << GRAYSCALE);
+    publishFrame(defaultPipeline, update);
+    stallWatchdog().framePublished();
+}
+
+// Runs the blur -> Sobel graph under G-API's streaming executor: the
+// default pipeline's worker offers EDGE_DETECTION frames to it instead of
+// processing them, and its pulling thread publishes the edges. Frames of
+// other modes, and every frame when the graph fails to compile, take the
+// usual path. CAPTURE_TO_PUBLISH compares it with nativeSetFramePipeline.
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetGapiStreaming(JNIEnv *env, jclass clazz, jboolean enabled) {
+    if (enabled == JNI_TRUE) {
+        gapiStreamingPipeline().start(publishGapiStreamResult);
+    } else {
+        gapiStreamingPipeline().stop();
+    }
+    LOGI("🔄 G-API streaming %s", enabled ? "enabled" : "disabled");
+}
+
+// {offered, dropped, produced, compiles, mean offer-to-edges us, produced fps x1000}
+extern "C"
+JNIEXPORT jlongArray JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetGapiStreamingStats(JNIEnv *env, jclass clazz) {
+    const GapiStreamingPipeline::Stats stats = gapiStreamingPipeline().stats();
+    jlong values[6] = {static_cast<jlong>(stats.offered), static_cast<jlong>(stats.dropped),
+                       static_cast<jlong>(stats.produced), static_cast<jlong>(stats.compiles),
+                       static_cast<jlong>(stats.meanLatencyMicros),
+                       static_cast<jlong>(stats.framesPerSecond * 1000.0)};
+    jlongArray result = env->NewLongArray(6);
+    if (result) {
+        env->SetLongArrayRegion(result, 0, 6, values);
+    }
+    return result;
+}
+
+// Times the G-API/Fluid blur + Canny against the same steps as eager cv::
+// calls on a synthetic width x height frame. Returns {eager median ms,
+// G-API median ms, fraction of edge pixels that differ}; blocks the caller.
+extern "C"
+JNIEXPORT jfloatArray JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeBenchmarkGapiPipeline(JNIEnv *env, jclass clazz,
+                                                                             jint width, jint height, jint iterations) {
+    if (width <= 0 || height <= 0 || iterations <= 0) {
+        LOGE("❌ Invalid G-API benchmark: %dx%d x%d", width, height, iterations);
+        return nullptr;
+    }
+    GapiBenchmarkResult benchmark = benchmarkGapiPipeline(width, height, iterations);
+    jfloat values[3] = {static_cast<jfloat>(benchmark.eagerMillis), static_cast<jfloat>(benchmark.gapiMillis),
+                        static_cast<jfloat>(benchmark.differingFraction)};
+    jfloatArray result = env->NewFloatArray(3);
+    if (result) {
+        env->SetFloatArrayRegion(result, 0, 3, values);
+    }
+    return result;
+}
+
+// Re-runs Canny only on 32x32 blocks whose luma changed since the last frame
+// (plus a halo) and keeps the previous edges elsewhere
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetIncrementalEdges(JNIEnv *env, jclass clazz, jboolean enabled) {
+    incrementalEdgeDetector().reset();
+    incrementalEdges.store(enabled == JNI_TRUE);
+    LOGI("🔄 Incremental edges %s", enabled ? "enabled" : "disabled");
+}
+
+// MOTION mode model controls: MOG2 learning rate per learning frame (< 0 =
+// automatic), learn on every Nth frame only, and the model's downscale factor
+// relative to the processed luma
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetMotionParams(JNIEnv *env, jclass clazz, jfloat learningRate,
+                                                                     jint learnEvery, jint downscale) {
+    if (learningRate > 1.0f || learnEvery < 1 || downscale < 1 || downscale > 16) {
+        LOGE("❌ Invalid motion params: rate %.4f, every %d, downscale %d", learningRate, learnEvery, downscale);
+        return;
+    }
+    MotionDetector::Params params;
+    params.learningRate = learningRate;
+    params.learnEvery = learnEvery;
+    params.downscale = downscale;
+    motionDetector().setParams(params);
+    LOGI("🔄 Motion params: rate %.4f, every %d frames, 1/%d resolution", learningRate, learnEvery, downscale);
+}
+
+// CHAMFER_MATCH: matching resolution (1/downscale of the processed edge map,
+// 1..8), distance metric (ChamferMatcher::Metric: 0 = L1, 1 = 3x3 chamfer)
+// and the mean edge distance in edge-map pixels a present part stays under
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetChamferParams(JNIEnv *env, jclass clazz, jint downscale,
+                                                                      jint metric, jfloat acceptDistance) {
+    if (downscale < 1 || downscale > 8 || metric < 0 || metric > 1 || !(acceptDistance >= 0.0f)) {
+        LOGE("❌ Invalid chamfer params: downscale %d, metric %d, accept %.2f", downscale, metric, acceptDistance);
+        return;
+    }
+    ChamferMatcher::Params params;
+    params.downscale = downscale;
+    params.metric = static_cast<ChamferMatcher::Metric>(metric);
+    params.acceptDistance = acceptDistance;
+    chamferMatcher().setParams(params);
+    LOGI("🔄 Chamfer params: 1/%d resolution, %s distance, accept below %.2f px", downscale,
+         metric == 0 ? "L1" : "3x3 chamfer", acceptDistance);
+}
+
+// Adds (or replaces) the CHAMFER_MATCH template id: a binary edge map (8-bit,
+// nonzero = edge, rowStride bytes per row) at the resolution of the processed
+// edge map, e.g. cut from a frame's edges where the part sits. False when it
+// is empty, larger than 512 px per side or the 32-template table is full.
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeAddChamferTemplate(JNIEnv *env, jclass clazz, jint id,
+                                                                        jobject edges, jint width, jint height,
+                                                                        jint rowStride) {
+    auto* data = static_cast<uint8_t*>(edges ? env->GetDirectBufferAddress(edges) : nullptr);
+    if (!data || width <= 0 || height <= 0 || rowStride < width ||
+        env->GetDirectBufferCapacity(edges) < static_cast<jlong>(rowStride) * (height - 1) + width) {
+        LOGE("❌ Invalid chamfer template %d: %dx%d, stride %d", id, width, height, rowStride);
+        return JNI_FALSE;
+    }
+    const bool added = chamferMatcher().addTemplate(id, cv::Mat(height, width, CV_8UC1, data,
+                                                                static_cast<size_t>(rowStride)));
+    if (added) {
+        LOGI("✅ Chamfer template %d added (%dx%d)", id, width, height);
+    } else {
+        LOGW("⚠️ Chamfer template %d rejected (%dx%d)", id, width, height);
+    }
+    return added ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeClearChamferTemplates(JNIEnv *env, jclass clazz) {
+    chamferMatcher().clearTemplates();
+    LOGI("🔄 Chamfer templates cleared");
+}
+
+// Best placement of every CHAMFER_MATCH template in the newest frame, 7
+// floats each: id, mean edge distance (edge-map pixels), accepted (0/1) and
+// the box as u0, v0, u1, v1 in 0..1 full-frame units (unrotated sensor
+// orientation); null before the mode has run
+extern "C"
+JNIEXPORT jfloatArray JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetChamferMatches(JNIEnv *env, jclass clazz) {
+    cv::Mat matches;
+    {
+        std::lock_guard<std::mutex> lock(defaultPipeline.publishMutex);
+        if (!defaultPipeline.lastPublished.hasChamfer) {
+            return nullptr;
+        }
+        matches = defaultPipeline.lastPublished.chamferMatches;  // immutable once published
+    }
+    const jsize length = static_cast<jsize>(matches.rows * kChamferMatchValues);
+    jfloatArray result = env->NewFloatArray(length);
+    if (result && length > 0) {
+        env->SetFloatArrayRegion(result, 0, length, matches.ptr<jfloat>());
+    }
+    return result;
+}
+
+// Copies the newest CHAMFER_MATCH distance map (8-bit, quarter matcher pixels
+// saturating at 255, rows packed) into a direct buffer and returns
+// width << 16 | height; 0 when there is none, -1 when the buffer is too small
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeCopyEdgeDistance(JNIEnv *env, jclass clazz, jobject buffer) {
+    cv::Mat distance;
+    {
+        std::lock_guard<std::mutex> lock(defaultPipeline.publishMutex);
+        distance = defaultPipeline.lastPublished.edgeDistance;
+    }
+    if (distance.empty()) {
+        return 0;
+    }
+    auto* out = static_cast<uint8_t*>(buffer ? env->GetDirectBufferAddress(buffer) : nullptr);
+    if (!out || env->GetDirectBufferCapacity(buffer) < static_cast<jlong>(distance.total())) {
+        return -1;
+    }
+    cv::Mat packed(distance.size(), CV_8UC1, out);
+    distance.copyTo(packed);
+    return static_cast<jint>(distance.cols << 16 | distance.rows);
+}
+
+// Pyramid levels MULTISCALE_EDGES fuses: 2 (full and half resolution) or 3
+// (also quarter); more levels confirm coarser structure only
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetMultiscaleEdges(JNIEnv *env, jclass clazz, jint levels) {
+    if (levels < 2 || levels > 3) {
+        LOGE("❌ Invalid multi-scale level count: %d", levels);
+        return;
+    }
+    multiscaleLevels.store(levels, std::memory_order_relaxed);
+    LOGI("🔄 Multi-scale edges over %d pyramid levels", levels);
+}
+
+// MARKERS: the dictionary (cv::aruco::PredefinedDictionaryType, 0 =
+// DICT_4X4_50 ... 21 = DICT_ARUCO_MIP_36h12) and the frames between
+// full-frame searches; the frames in between only search around known markers
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetMarkerParams(JNIEnv *env, jclass clazz, jint dictionary,
+                                                                     jint fullSearchEvery) {
+    if (dictionary < cv::aruco::DICT_4X4_50 || dictionary > cv::aruco::DICT_ARUCO_MIP_36h12 || fullSearchEvery < 1) {
+        LOGE("❌ Invalid marker params: dictionary %d, full search every %d", dictionary, fullSearchEvery);
+        return;
+    }
+    MarkerDetector::Params params;
+    params.dictionary = dictionary;
+    params.fullSearchEvery = fullSearchEvery;
+    markerDetector().setParams(params);
+    LOGI("🔄 Marker params: dictionary %d, full search every %d frames", dictionary, fullSearchEvery);
+}
+
+// Copies the newest frame's markers into a direct buffer as packed 36-byte
+// records (int32 id, then the four corners' x, y as float32 in 0..1
+// full-frame units, clockwise from the marker's top-left; native byte order)
+// and returns how many were found, -1 before the mode has run. Only the
+// records that fit are written.
+extern "C"
+JNIEXPORT jint JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetMarkers(JNIEnv *env, jclass clazz, jobject buffer) {
+    cv::Mat markers;
+    {
+        std::lock_guard<std::mutex> lock(defaultPipeline.publishMutex);
+        if (!defaultPipeline.lastPublished.hasMarkers) {
+            return -1;
+        }
+        markers = defaultPipeline.lastPublished.markers;  // immutable once published
+    }
+    auto* out = static_cast<uint8_t*>(buffer ? env->GetDirectBufferAddress(buffer) : nullptr);
+    if (out && markers.rows > 0) {
+        const jlong fits = env->GetDirectBufferCapacity(buffer) / static_cast<jlong>(sizeof(MarkerRecord));
+        const int count = static_cast<int>(std::min<jlong>(markers.rows, fits));
+        std::memcpy(out, markers.data, static_cast<size_t>(count) * sizeof(MarkerRecord));
+    }
+    return markers.rows;
+}
+
+// STABILIZE: how much of the smoothed path each frame keeps (0..0.99, higher
+// is steadier but follows deliberate pans later) and the largest correction
+// as a share of the frame side, which is also the zoom that hides the borders
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetStabilizerParams(JNIEnv *env, jclass clazz, jfloat smoothing,
+                                                                         jfloat maxCorrection) {
+    if (!(smoothing >= 0.0f && smoothing <= 0.99f) || !(maxCorrection >= 0.0f && maxCorrection <= 0.25f)) {
+        LOGE("❌ Invalid stabilizer params: smoothing %.3f, max correction %.3f", smoothing, maxCorrection);
+        return;
+    }
+    VideoStabilizer::Params params;
+    params.smoothing = smoothing;
+    params.maxCorrection = maxCorrection;
+    videoStabilizer().setParams(params);
+    LOGI("🔄 Stabilizer params: smoothing %.3f, max correction %.3f", smoothing, maxCorrection);
+}
+
+// Temporal denoise of the processed luma for low light: history weight of a
+// still pixel (0..0.94) and the luma change (0..239) up to which it counts
+// as still; brighter changes fade out of the blend over 16 more levels
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetTemporalDenoise(JNIEnv *env, jclass clazz, jboolean enabled,
+                                                                        jfloat strength, jint motionThreshold) {
+    if (!(strength >= 0.0f && strength <= 0.94f) || motionThreshold < 0 || motionThreshold > 239) {
+        LOGE("❌ Invalid temporal denoise params: strength %.3f, motion threshold %d", strength, motionThreshold);
+        return JNI_FALSE;
+    }
+    TemporalDenoiser::Params params;
+    params.enabled = enabled;
+    params.strength = strength;
+    params.motionThreshold = motionThreshold;
+    temporalDenoiser().setParams(params);
+    LOGI("🔄 Temporal denoise %s: strength %.3f, motion threshold %d", enabled ? "on" : "off", strength,
+         motionThreshold);
+    return JNI_TRUE;
+}
+
+// Tiled CLAHE of the processed luma, for backlit scenes fixed Canny
+// thresholds miss: clip limit (1..40, relative to a flat histogram) and the
+// tiles per side (2..16)
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetClahe(JNIEnv *env, jclass clazz, jboolean enabled,
+                                                              jfloat clipLimit, jint tiles) {
+    if (!(clipLimit >= 1.0f && clipLimit <= 40.0f) || tiles < 2 || tiles > 16) {
+        LOGE("❌ Invalid CLAHE params: clip limit %.2f, %d tiles", clipLimit, tiles);
+        return JNI_FALSE;
+    }
+    claheClipLimit.store(clipLimit, std::memory_order_relaxed);
+    claheTiles.store(tiles, std::memory_order_relaxed);
+    claheEnabled.store(enabled, std::memory_order_relaxed);
+    LOGI("🔄 CLAHE %s: clip limit %.2f, %dx%d tiles", enabled ? "on" : "off", clipLimit, tiles, tiles);
+    return JNI_TRUE;
+}
+
+// DOCUMENT: whether the tracked quad is also shown straightened (an upright
+// inset in the top-right third), and the fixed size (width x height, upright)
+// the straightened region is read back at for nativeGetRectifiedDocument;
+// 0 x 0 turns the readback off. Needs an uploaded raw layer (not the OES
+// camera texture) and, for the readback, GLES3.
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetDocumentRectification(JNIEnv *env, jclass clazz,
+                                                                              jboolean inset, jint width,
+                                                                              jint height) {
+    if (width < 0 || height < 0 || width > 4096 || height > 4096 || (width == 0) != (height == 0)) {
+        LOGE("❌ Invalid rectified readback size %dx%d", width, height);
+        return JNI_FALSE;
+    }
+    documentInset.store(inset == JNI_TRUE, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(rectifiedMutex);
+        rectifiedReadbackSize = cv::Size(width, height);
+        rectifiedDocument = cv::Mat();
+        rectifiedSequence = 0;
+    }
+    setRectifiedReadbackConsumer(width > 0 ? &storeRectifiedDocument : nullptr);
+    LOGI("🔄 Document rectification: inset %s, readback %dx%d", inset ? "on" : "off", width, height);
+    return JNI_TRUE;
+}
+
+// Newest read-back rectified region as width x height luma bytes (top row
+// first) into a direct buffer; returns the publish sequence of the frame it
+// was cut from, 0 if none arrived yet (or the buffer is too small)
+extern "C"
+JNIEXPORT jlong JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetRectifiedDocument(JNIEnv *env, jclass clazz,
+                                                                          jobject buffer) {
+    cv::Mat luma;
+    uint64_t sequence = 0;
+    {
+        std::lock_guard<std::mutex> lock(rectifiedMutex);
+        luma = rectifiedDocument;  // pooled and never rewritten while referenced
+        sequence = rectifiedSequence;
+    }
+    auto* out = static_cast<uint8_t*>(buffer ? env->GetDirectBufferAddress(buffer) : nullptr);
+    if (!out || luma.empty() || env->GetDirectBufferCapacity(buffer) < static_cast<jlong>(luma.total())) {
+        return 0;
+    }
+    cv::Mat target(luma.rows, luma.cols, CV_8UC1, out);
+    luma.copyTo(target);
+    return static_cast<jlong>(sequence);
+}
+
+// Lens calibration from an OpenCV calibration file (camera_matrix,
+// distortion_coefficients, image_width, image_height; YAML, XML or JSON).
+// Maps are rebuilt lazily for each frame size that is undistorted next.
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeLoadLensCalibration(JNIEnv *env, jclass clazz, jstring path) {
+    const char* chars = path ? env->GetStringUTFChars(path, nullptr) : nullptr;
+    if (!chars) {
+        return JNI_FALSE;
+    }
+    const std::string file(chars);
+    env->ReleaseStringUTFChars(path, chars);
+    return lensUndistortion().loadCalibration(file) ? JNI_TRUE : JNI_FALSE;
+}
+
+// DEPTH: the stereo pair's calibration, M1, D1, M2, D2, R and T with
+// image_width and image_height (OpenCV's stereo_calib output; intrinsics are
+// scaled to the reduced size). False, keeping the current one, if the file
+// lacks any; without one the views are matched as already rectified.
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeLoadStereoCalibration(JNIEnv *env, jclass clazz, jstring path) {
+    const char* chars = path ? env->GetStringUTFChars(path, nullptr) : nullptr;
+    if (!chars) {
+        return JNI_FALSE;
+    }
+    const std::string file(chars);
+    env->ReleaseStringUTFChars(path, chars);
+    return stereoDepth().loadCalibration(file) ? JNI_TRUE : JNI_FALSE;
+}
+
+// DEPTH: the pipeline (nativeCreatePipeline handle, 0 = the default one) whose
+// frames are the right view; -1 = none, which also drops the stereo
+// calibration and the last right frame
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetStereoRightPipeline(JNIEnv *env, jclass clazz, jlong handle) {
+    if (handle == -1) {
+        stereoRightPipeline.store(nullptr, std::memory_order_relaxed);
+        stereoDepth().reset();
+        LOGI("🔄 Stereo right view: none");
+        return;
+    }
+    stereoRightPipeline.store(&pipelineFor(handle), std::memory_order_relaxed);
+    LOGI("🔄 Stereo right view: pipeline %p", static_cast<void*>(&pipelineFor(handle)));
+}
+
+// DEPTH: reduction per axis before matching (1..8), disparity search range in
+// reduced pixels (16..256, a multiple of 16), StereoBM block size (odd,
+// 5..51) and how far apart in time the views may be (ms). False for values
+// out of range.
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetStereoParams(JNIEnv *env, jclass clazz, jint downscale,
+                                                                     jint disparities, jint blockSize,
+                                                                     jint maxSkewMs) {
+    if (downscale < 1 || downscale > 8 || disparities < 16 || disparities > 256 || disparities % 16 != 0 ||
+        blockSize < 5 || blockSize > 51 || blockSize % 2 == 0 || maxSkewMs < 0) {
+        LOGE("❌ Invalid stereo params: downscale %d, %d disparities, block %d, skew %d ms", downscale, disparities,
+             blockSize, maxSkewMs);
+        return JNI_FALSE;
+    }
+    StereoDepth::Params params;
+    params.downscale = downscale;
+    params.disparities = disparities;
+    params.blockSize = blockSize;
+    params.maxSkewNs = static_cast<int64_t>(maxSkewMs) * 1000000;
+    stereoDepth().setParams(params);
+    LOGI("🔄 Stereo: 1/%d per axis, %d disparities, block %d, skew %d ms", downscale, disparities, blockSize,
+         maxSkewMs);
+    return JNI_TRUE;
+}
+
+// Where lens undistortion runs (LensUndistortion::Mode): 0 = off, 1 = the
+// renderer remaps single-layer pictures for display, 2 = the processed luma is
+// remapped before the pipeline so every result is undistorted. False for an
+// unknown mode; a mode without a calibration loaded changes nothing yet.
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetUndistortMode(JNIEnv *env, jclass clazz, jint mode) {
+    if (mode < static_cast<int>(LensUndistortion::Mode::OFF) || mode > static_cast<int>(LensUndistortion::Mode::CPU)) {
+        LOGE("❌ Unknown undistortion mode: %d", mode);
+        return JNI_FALSE;
+    }
+    lensUndistortion().setMode(static_cast<LensUndistortion::Mode>(mode));
+    if (mode != 0 && !lensUndistortion().calibrated()) {
+        LOGW("⚠️ Undistortion mode %d set without a lens calibration", mode);
+    }
+    LOGI("🔄 Undistortion: %s", mode == 0 ? "off" : mode == 1 ? "GPU" : "CPU");
+    return JNI_TRUE;
+}
+
+// CODES: frames between scans at most (K), the reduction the scan sees (1, 2
+// or 4) and the share of edge pixels a 32x32 cell of it needs to be scanned
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetCodeParams(JNIEnv *env, jclass clazz, jint everyFrames,
+                                                                   jint downscale, jfloat minEdgeDensity) {
+    if (everyFrames < 1 || (downscale != 1 && downscale != 2 && downscale != 4) ||
+        !(minEdgeDensity >= 0.0f && minEdgeDensity <= 1.0f)) {
+        LOGE("❌ Invalid code scan params: every %d frames, downscale %d, edge density %.3f", everyFrames, downscale,
+             minEdgeDensity);
+        return;
+    }
+    CodeScanner::Params params;
+    params.everyFrames = everyFrames;
+    params.downscale = downscale;
+    params.minEdgeDensity = minEdgeDensity;
+    codeScanner().setParams(params);
+    LOGI("🔄 Code scan params: every %d frames, downscale %d, edge density %.3f", everyFrames, downscale,
+         minEdgeDensity);
+}
+
+// Hands the APK's AssetManager over, so model, template and calibration
+// paths of the form "asset:<name>" are mapped from the APK (stored
+// uncompressed) instead of copied out to files. Call once before loading
+// any; the manager is kept referenced for the process's lifetime.
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetAssetManager(JNIEnv *env, jclass clazz, jobject manager) {
+    static jobject managerRef = nullptr;
+    if (!manager || managerRef) {
+        return;
+    }
+    managerRef = env->NewGlobalRef(manager);
+    setAssetManager(AAssetManager_fromJava(env, managerRef));
+    LOGI("✅ Asset manager set");
+}
+
+// FACES: loads the YuNet ONNX model (face_detection_yunet); blocks for the
+// load, so call it from a background thread
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeLoadFaceModel(JNIEnv *env, jclass clazz, jstring model) {
+    if (!model) {
+        LOGE("❌ Invalid face model path");
+        return JNI_FALSE;
+    }
+    const char* chars = env->GetStringUTFChars(model, nullptr);
+    if (!chars) {
+        return JNI_FALSE;
+    }
+    const std::string path = chars;
+    env->ReleaseStringUTFChars(model, chars);
+    return faceDetector().load(path) ? JNI_TRUE : JNI_FALSE;
+}
+
+// FACES: frames between detections at most (K), the reduced width YuNet and
+// the tracking see, YuNet's score threshold and the match a tracked face
+// needs to stay (TM_CCOEFF_NORMED)
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetFaceParams(JNIEnv *env, jclass clazz, jint everyFrames,
+                                                                   jint inputWidth, jfloat scoreThreshold,
+                                                                   jfloat minMatch) {
+    if (everyFrames < 1 || inputWidth < 64 || inputWidth > 1280 || !(scoreThreshold >= 0.0f && scoreThreshold <= 1.0f) ||
+        !(minMatch >= -1.0f && minMatch <= 1.0f)) {
+        LOGE("❌ Invalid face params: every %d frames, width %d, score %.2f, match %.2f", everyFrames, inputWidth,
+             scoreThreshold, minMatch);
+        return;
+    }
+    FaceDetector::Params params;
+    params.everyFrames = everyFrames;
+    params.inputWidth = inputWidth;
+    params.scoreThreshold = scoreThreshold;
+    params.minMatch = minMatch;
+    faceDetector().setParams(params);
+    LOGI("🔄 Face params: every %d frames, width %d, score %.2f, match %.2f", everyFrames, inputWidth,
+         scoreThreshold, minMatch);
+}
+
+// Faces of the newest published FACES frame: u0, v0, u1, v1, score per face
+// in 0..1 full-frame units (unrotated sensor orientation); null before the
+// mode produced a frame
+extern "C"
+JNIEXPORT jfloatArray JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetFaces(JNIEnv *env, jclass clazz) {
+    cv::Mat faces;
+    {
+        std::lock_guard<std::mutex> lock(defaultPipeline.publishMutex);
+        if (!defaultPipeline.lastPublished.hasFaces) {
+            return nullptr;
+        }
+        faces = defaultPipeline.lastPublished.faces;  // immutable once published
+    }
+    const jsize length = static_cast<jsize>(faces.rows * 5);
+    jfloatArray result = env->NewFloatArray(length);
+    if (result) {
+        for (int i = 0; i < faces.rows; i++) {
+            env->SetFloatArrayRegion(result, 5 * i, 5, faces.ptr<float>(i));
+        }
+    }
+    return result;
+}
+
+// MOSAIC: canvas size and tile size in mosaic pixels, and the width each
+// frame's luma is reduced to before registration; starts a new canvas
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetMosaicParams(JNIEnv *env, jclass clazz, jint canvasWidth,
+                                                                     jint canvasHeight, jint tileSize,
+                                                                     jint frameWidth) {
+    if (canvasWidth < 256 || canvasHeight < 256 || canvasWidth > 4096 || canvasHeight > 4096 || tileSize < 32 ||
+        tileSize > 512 || frameWidth < 64 || frameWidth > canvasWidth) {
+        LOGE("❌ Invalid mosaic params: %dx%d canvas, %d px tiles, frames %d px wide", canvasWidth, canvasHeight,
+             tileSize, frameWidth);
+        return;
+    }
+    MosaicBuilder::Params params;
+    params.canvasSize = cv::Size(canvasWidth, canvasHeight);
+    params.tileSize = tileSize;
+    params.frameWidth = frameWidth;
+    mosaicBuilder().setParams(params);
+}
+
+// MOSAIC: discards the canvas; the next frame starts a new one at its centre
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeResetMosaic(JNIEnv *env, jclass clazz) {
+    mosaicBuilder().reset();
+}
+
+// {frames registered, frames that failed to register, keyframes, tiles written}
+extern "C"
+JNIEXPORT jlongArray JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetMosaicStats(JNIEnv *env, jclass clazz) {
+    MosaicBuilder& builder = mosaicBuilder();
+    jlong values[4] = {static_cast<jlong>(builder.registeredCount()), static_cast<jlong>(builder.failedCount()),
+                       static_cast<jlong>(builder.keyframeCount()), static_cast<jlong>(builder.tilesWrittenCount())};
+    jlongArray result = env->NewLongArray(4);
+    if (result) {
+        env->SetLongArrayRegion(result, 0, 4, values);
+    }
+    return result;
+}
+
+// PEOPLE: frames between detections, the widest level searched, the number
+// of scales (each 1/1.25 of the one before) and the SVM margin a window needs
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetPeopleParams(JNIEnv *env, jclass clazz, jint everyFrames,
+                                                                     jint inputWidth, jint levels,
+                                                                     jfloat hitThreshold) {
+    if (everyFrames < 1 || inputWidth < 128 || inputWidth > 1920 || levels < 1 || levels > 8 ||
+        !(hitThreshold > -10.0f && hitThreshold < 10.0f)) {
+        LOGE("❌ Invalid people params: every %d frames, width %d, %d levels, threshold %.2f", everyFrames,
+             inputWidth, levels, hitThreshold);
+        return;
+    }
+    PeopleDetector::Params params;
+    params.everyFrames = everyFrames;
+    params.inputWidth = inputWidth;
+    params.levels = levels;
+    params.hitThreshold = hitThreshold;
+    peopleDetector().setParams(params);
+    LOGI("🔄 People params: every %d frames, width %d, %d levels, threshold %.2f", everyFrames, inputWidth, levels,
+         hitThreshold);
+}
+
+// People of the newest published PEOPLE frame: u0, v0, u1, v1, weight per
+// person in 0..1 full-frame units (unrotated sensor orientation); null
+// before the mode produced a frame
+extern "C"
+JNIEXPORT jfloatArray JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetPeople(JNIEnv *env, jclass clazz) {
+    cv::Mat people;
+    {
+        std::lock_guard<std::mutex> lock(defaultPipeline.publishMutex);
+        if (!defaultPipeline.lastPublished.hasPeople) {
+            return nullptr;
+        }
+        people = defaultPipeline.lastPublished.people;  // immutable once published
+    }
+    const jsize length = static_cast<jsize>(people.rows * 5);
+    jfloatArray result = env->NewFloatArray(length);
+    if (result) {
+        for (int i = 0; i < people.rows; i++) {
+            env->SetFloatArrayRegion(result, 5 * i, 5, people.ptr<float>(i));
+        }
+    }
+    return result;
+}
+
+// {detections run, detections that reused the edge stage's gradients}
+extern "C"
+JNIEXPORT jlongArray JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetPeopleStats(JNIEnv *env, jclass clazz) {
+    PeopleDetector& detector = peopleDetector();
+    jlong values[2] = {static_cast<jlong>(detector.detectionCount()),
+                       static_cast<jlong>(detector.reusedGradientCount())};
+    jlongArray result = env->NewLongArray(2);
+    if (result) {
+        env->SetLongArrayRegion(result, 0, 2, values);
+    }
+    return result;
+}
 
-// Helper function to rotate cv::Mat based on rotation angle
-cv::Mat rotateFrame(const cv::Mat& frame, int rotation) {
-    cv::Mat rotated;
+// TEXT_REGIONS: frames between detections, the width the luma is reduced
+// to, the edge density cell size and the share of edge pixels a cell needs
+// for MSER to search it, and MSER's largest region in reduced pixels
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetTextRegionParams(JNIEnv *env, jclass clazz,
+                                                                         jint everyFrames, jint inputWidth,
+                                                                         jint cellSize, jfloat minEdgeDensity,
+                                                                         jint maxArea) {
+    if (everyFrames < 1 || inputWidth < 160 || inputWidth > 1920 || cellSize < 4 || cellSize > 64 ||
+        !(minEdgeDensity >= 0.0f && minEdgeDensity <= 1.0f) || maxArea < 64) {
+        LOGE("❌ Invalid text region params: every %d frames, width %d, cells %d, density %.2f, max area %d",
+             everyFrames, inputWidth, cellSize, minEdgeDensity, maxArea);
+        return;
+    }
+    TextRegionDetector::Params params;
+    params.everyFrames = everyFrames;
+    params.inputWidth = inputWidth;
+    params.cellSize = cellSize;
+    params.minEdgeDensity = minEdgeDensity;
+    params.maxArea = maxArea;
+    textRegionDetector().setParams(params);
+    LOGI("🔄 Text region params: every %d frames, width %d, cells %d, density %.2f, max area %d", everyFrames,
+         inputWidth, cellSize, minEdgeDensity, maxArea);
+}
 
-    switch (rotation) {
-        case 0:
-            // No rotation needed
-            rotated = frame.clone();
-            break;
-        case 90:
-            cv::rotate(frame, rotated, cv::ROTATE_90_CLOCKWISE);
-            break;
-        case 180:
-            cv::rotate(frame, rotated, cv::ROTATE_180);
-            break;
-        case 270:
-            cv::rotate(frame, rotated, cv::ROTATE_90_COUNTERCLOCKWISE);
-            break;
-        default:
-            LOGE("❌ Unsupported rotation angle: %d, using original frame", rotation);
-            rotated = frame.clone();
-            break;
+// Text lines of the newest published TEXT_REGIONS frame: u0, v0, u1, v1 per
+// line in 0..1 full-frame units (unrotated sensor orientation), top to
+// bottom; null before the mode produced a frame
+extern "C"
+JNIEXPORT jfloatArray JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetTextRegions(JNIEnv *env, jclass clazz) {
+    cv::Mat regions;
+    {
+        std::lock_guard<std::mutex> lock(defaultPipeline.publishMutex);
+        if (!defaultPipeline.lastPublished.hasTextRegions) {
+            return nullptr;
+        }
+        regions = defaultPipeline.lastPublished.textRegions;  // immutable once published
+    }
+    const jsize length = static_cast<jsize>(regions.rows * 4);
+    jfloatArray result = env->NewFloatArray(length);
+    if (result) {
+        for (int i = 0; i < regions.rows; i++) {
+            env->SetFloatArrayRegion(result, 4 * i, 4, regions.ptr<float>(i));
+        }
     }
+    return result;
+}
 
-    LOGI("✅ Frame rotated by %d degrees: %dx%d -> %dx%d",
-         rotation, frame.cols, frame.rows, rotated.cols, rotated.rows);
-    return rotated;
+// {detections run, character candidates, reduced pixels MSER searched,
+// reduced pixels of the detected frames}: the last two give the share of
+// the frame the edge gate let through
+extern "C"
+JNIEXPORT jlongArray JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetTextRegionStats(JNIEnv *env, jclass clazz) {
+    TextRegionDetector& detector = textRegionDetector();
+    jlong values[4] = {static_cast<jlong>(detector.detectionCount()), static_cast<jlong>(detector.candidateCount()),
+                       static_cast<jlong>(detector.scannedPixelCount()),
+                       static_cast<jlong>(detector.framePixelCount())};
+    jlongArray result = env->NewLongArray(4);
+    if (result) {
+        env->SetLongArrayRegion(result, 0, 4, values);
+    }
+    return result;
 }
 
-// Common frame processing logic
-void processFrameInternal(jbyte* frameData, jint width, jint height, jint rotation = 0) {
-    LOGI("🔄 [STEP 1] Processing frame with size: %dx%d, rotation: %d°", width, height, rotation);
+// ODOMETRY: the reduced luma width, the distance (reduced pixels) a keypoint
+// may move between frames, the Hamming distance a match may have, frames
+// between pose estimates, and the horizontal field of view in degrees used
+// without a lens calibration
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetOdometryParams(JNIEnv *env, jclass clazz, jint frameWidth,
+                                                                       jint searchRadius, jint maxDistance,
+                                                                       jint poseEveryFrames, jfloat fieldOfView) {
+    if (frameWidth < 160 || frameWidth > 1280 || searchRadius < 4 || searchRadius > 128 || maxDistance < 1 ||
+        maxDistance > 256 || poseEveryFrames < 1 || !(fieldOfView >= 20.0f && fieldOfView <= 150.0f)) {
+        LOGE("❌ Invalid odometry params: width %d, radius %d, distance %d, every %d frames, fov %.1f", frameWidth,
+             searchRadius, maxDistance, poseEveryFrames, fieldOfView);
+        return;
+    }
+    VisualOdometry::Params params;
+    params.frameWidth = frameWidth;
+    params.searchRadius = searchRadius;
+    params.maxDistance = maxDistance;
+    params.poseEveryFrames = poseEveryFrames;
+    params.fieldOfView = fieldOfView;
+    visualOdometry().setParams(params);
+    LOGI("🔄 Odometry params: width %d, radius %d, distance %d, every %d frames, fov %.1f", frameWidth, searchRadius,
+         maxDistance, poseEveryFrames, fieldOfView);
+}
 
-    if (!frameData) {
-        LOGE("❌ [STEP 1] frameData is null — skipping");
+// Camera pose relative to the first ODOMETRY frame: the rotation taking
+// camera axes to the first frame's (9 values, row-major), the position in
+// estimate steps (3; monocular, so without scale), the newest estimate's
+// inliers and the estimates so far
+extern "C"
+JNIEXPORT jfloatArray JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetOdometryPose(JNIEnv *env, jclass clazz) {
+    const VisualOdometry::Pose pose = visualOdometry().pose();
+    jfloat values[14];
+    for (int i = 0; i < 9; i++) {
+        values[i] = static_cast<jfloat>(pose.rotation.val[i]);
+    }
+    for (int i = 0; i < 3; i++) {
+        values[9 + i] = static_cast<jfloat>(pose.position[i]);
+    }
+    values[12] = static_cast<jfloat>(pose.inliers);
+    values[13] = static_cast<jfloat>(pose.estimates);
+    jfloatArray result = env->NewFloatArray(14);
+    if (result) {
+        env->SetFloatArrayRegion(result, 0, 14, values);
+    }
+    return result;
+}
+
+// {matches, Hamming distances computed, pose estimates, estimates rejected}:
+// distances per match is what the search window saves over a full matcher
+extern "C"
+JNIEXPORT jlongArray JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetOdometryStats(JNIEnv *env, jclass clazz) {
+    VisualOdometry& odometry = visualOdometry();
+    jlong values[4] = {static_cast<jlong>(odometry.matchCount()), static_cast<jlong>(odometry.distanceCount()),
+                       static_cast<jlong>(odometry.estimateCount()), static_cast<jlong>(odometry.rejectedCount())};
+    jlongArray result = env->NewLongArray(4);
+    if (result) {
+        env->SetLongArrayRegion(result, 0, 4, values);
+    }
+    return result;
+}
+
+// HEATMAP: the share of its heat a pixel keeps per new edge frame (0..1
+// exclusive; 0.9 fades an edge to a tenth in about 22 frames) and the
+// colormap gain (heat 1 / gain is drawn at the top of the scale)
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetHeatmap(JNIEnv *env, jclass clazz, jfloat decay,
+                                                                jfloat gain) {
+    if (!(decay > 0.0f && decay < 1.0f) || !(gain > 0.0f && gain <= 100.0f)) {
+        LOGE("❌ Invalid heatmap params: decay %.3f, gain %.2f", decay, gain);
         return;
     }
-    LOGI("✅ [STEP 1] frameData obtained successfully");
+    heatmapDecay.store(decay, std::memory_order_relaxed);
+    heatmapGain.store(gain, std::memory_order_relaxed);
+    LOGI("🔄 Heatmap: decay %.3f, gain %.2f", decay, gain);
+}
 
-    // Step 1: Convert NV21 YUV to BGR
-    LOGI("🔄 [STEP 2] Starting YUV to BGR conversion...");
-    int yuvHeight = height + height / 2;
-    cv::Mat yuv(yuvHeight, width, CV_8UC1, reinterpret_cast<unsigned char*>(frameData));
-    cv::Mat bgr;
+// FOCUS_PEAK: pixels peak where their luma gradient reaches sensitivity
+// times the frame's typical edge response (0.25..20; higher peaks fewer),
+// painted in color (ARGB, alpha the opacity). The per-frame sharpness score
+// behind the threshold is nativeGetLumaStats' third value.
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetFocusPeaking(JNIEnv *env, jclass clazz, jfloat sensitivity,
+                                                                     jint color) {
+    if (!(sensitivity >= 0.25f && sensitivity <= 20.0f)) {
+        LOGE("❌ Invalid focus peaking sensitivity %.2f", sensitivity);
+        return;
+    }
+    focusPeakSensitivity.store(sensitivity, std::memory_order_relaxed);
+    focusPeakColor.store(static_cast<uint32_t>(color), std::memory_order_relaxed);
+    LOGI("🔄 Focus peaking: sensitivity %.2f, color 0x%08x", sensitivity, static_cast<uint32_t>(color));
+}
 
-    try {
-        cv::cvtColor(yuv, bgr, cv::COLOR_YUV2BGR_NV21);
-        LOGI("✅ [STEP 2] cvtColor success: BGR size = %dx%d", bgr.cols, bgr.rows);
-    } catch (const cv::Exception& e) {
-        LOGE("❌ [STEP 2] OpenCV YUV2BGR_NV21 failed: %s", e.what());
+// Freeze-frame tuning (freeze_frame.h): true holds the next camera frame and
+// republishes it only when a setting changes, false returns to the camera
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetFreezeFrame(JNIEnv *env, jclass clazz, jboolean frozen) {
+    freezeFrame().setFrozen(frozen == JNI_TRUE);
+}
+
+// [held frame publishes, camera frames dropped while frozen, gradient and
+// suppression runs, hysteresis-only runs, edges reused unchanged]
+extern "C"
+JNIEXPORT jlongArray JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetFreezeFrameStats(JNIEnv *env, jclass clazz) {
+    FreezeFrame& freeze = freezeFrame();
+    jlong values[5] = {static_cast<jlong>(freeze.publishCount()), static_cast<jlong>(freeze.dropCount()),
+                       static_cast<jlong>(freeze.maximaRunCount()), static_cast<jlong>(freeze.hysteresisRunCount()),
+                       static_cast<jlong>(freeze.reuseCount())};
+    jlongArray result = env->NewLongArray(5);
+    if (result) {
+        env->SetLongArrayRegion(result, 0, 5, values);
+    }
+    return result;
+}
+
+// TRACK_OBJECT: NanoTrack's backbone and neck/head and VitTrack's network
+// (ONNX files; the trackers read them by path); null leaves a model unset
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetObjectTrackerModels(JNIEnv *env, jclass clazz,
+                                                                            jstring nanoBackbone,
+                                                                            jstring nanoNeckhead, jstring vitNet) {
+    auto toString = [env](jstring value) {
+        std::string result;
+        if (value) {
+            const char* chars = env->GetStringUTFChars(value, nullptr);
+            if (chars) {
+                result = chars;
+                env->ReleaseStringUTFChars(value, chars);
+            }
+        }
+        return result;
+    };
+    objectTracker().setModels(toString(nanoBackbone), toString(nanoNeckhead), toString(vitNet));
+}
+
+// TRACK_OBJECT: tracker (0 = MIL, 1 = NanoTrack, 2 = VitTrack; applies to the
+// next selection), the reduced frame width it sees, its average budget per
+// frame, and whether edges are detected only in the box around the object
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetObjectTrackerParams(JNIEnv *env, jclass clazz, jint kind,
+                                                                            jint inputWidth, jint budgetMicros,
+                                                                            jboolean edgesInBox) {
+    if (kind < ObjectTracker::MIL || kind > ObjectTracker::VIT || inputWidth < 64 || inputWidth > 1280 ||
+        budgetMicros < 500) {
+        LOGE("❌ Invalid object tracker params: kind %d, width %d, budget %d us", kind, inputWidth, budgetMicros);
         return;
     }
+    ObjectTracker::Params params;
+    params.kind = static_cast<ObjectTracker::Kind>(kind);
+    params.inputWidth = inputWidth;
+    params.budgetMicros = budgetMicros;
+    objectTracker().setParams(params);
+    trackedRoiEdges.store(edgesInBox == JNI_TRUE);
+    if (edgesInBox != JNI_TRUE) {
+        hasTrackedRoi.store(false);
+    }
+    LOGI("🔄 Object tracker: kind %d, width %d, budget %d us, edges %s", kind, inputWidth, budgetMicros,
+         edgesInBox == JNI_TRUE ? "in the box" : "off");
+}
 
-    // Step 2: Apply rotation if needed
-    cv::Mat rotatedBgr = bgr;
-    if (rotation != 0) {
-        rotatedBgr = rotateFrame(bgr, rotation);
-        LOGI("✅ [STEP 2B] Frame rotated by %d degrees", rotation);
+// TRACK_OBJECT: follows the object in x, y, width, height (0..1 full-frame
+// units, unrotated sensor orientation) from the next frame. Loads NanoTrack's
+// or VitTrack's networks, so call it from a background thread.
+extern "C"
+JNIEXPORT jboolean JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSelectObject(JNIEnv *env, jclass clazz, jfloat x, jfloat y,
+                                                                  jfloat width, jfloat height) {
+    if (!(width > 0.0f && height > 0.0f && x >= 0.0f && y >= 0.0f && x + width <= 1.0f && y + height <= 1.0f)) {
+        LOGE("❌ Invalid object selection %.3f,%.3f %.3fx%.3f", x, y, width, height);
+        return JNI_FALSE;
     }
+    return objectTracker().select(cv::Rect2f(x, y, width, height)) ? JNI_TRUE : JNI_FALSE;
+}
 
-    // Step 3: Store raw frame and create all variants
-    std::lock_guard<std::mutex> lock(frameMutex);
+// TRACK_OBJECT: stops following the object
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeStopObjectTracking(JNIEnv *env, jclass clazz) {
+    objectTracker().stop();
+}
 
-    // Store raw camera data (rotated)
-    rawFrame = rotatedBgr.clone();
-    LOGI("✅ [STEP 3A] Raw frame stored: %dx%d", rawFrame.cols, rawFrame.rows);
+// The object's box in the newest published TRACK_OBJECT frame: x, y, width,
+// height in 0..1 full-frame units; null while nothing is followed
+extern "C"
+JNIEXPORT jfloatArray JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetTrackedObject(JNIEnv *env, jclass clazz) {
+    cv::Mat strip;
+    {
+        std::lock_guard<std::mutex> lock(defaultPipeline.publishMutex);
+        if (!defaultPipeline.lastPublished.hasTrackedObject) {
+            return nullptr;
+        }
+        strip = defaultPipeline.lastPublished.trackedObject;  // immutable once published
+    }
+    if (strip.rows < 5) {
+        return nullptr;
+    }
+    const cv::Point2f tl = strip.at<cv::Point2f>(0);
+    const cv::Point2f br = strip.at<cv::Point2f>(2);
+    const jfloat values[4] = {tl.x, tl.y, br.x - tl.x, br.y - tl.y};
+    jfloatArray result = env->NewFloatArray(4);
+    if (result) {
+        env->SetFloatArrayRegion(result, 0, 4, values);
+    }
+    return result;
+}
 
-    // Create grayscale version
-    try {
-        cv::cvtColor(rotatedBgr, grayscaleFrame, cv::COLOR_BGR2GRAY);
-        cv::cvtColor(grayscaleFrame, grayscaleFrame, cv::COLOR_GRAY2BGR); // Convert back to 3-channel for OpenGL
-        LOGI("✅ [STEP 3B] Grayscale frame created: %dx%d", grayscaleFrame.cols, grayscaleFrame.rows);
-    } catch (const cv::Exception& e) {
-        LOGE("❌ [STEP 3B] Grayscale conversion failed: %s", e.what());
-        grayscaleFrame = rotatedBgr.clone(); // Fallback to raw
+// {tracker updates, frames skipped to stay within the budget, objects lost}
+extern "C"
+JNIEXPORT jlongArray JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetObjectTrackerStats(JNIEnv *env, jclass clazz) {
+    ObjectTracker& tracker = objectTracker();
+    jlong values[3] = {static_cast<jlong>(tracker.updateCount()), static_cast<jlong>(tracker.skippedCount()),
+                       static_cast<jlong>(tracker.lostCount())};
+    jlongArray result = env->NewLongArray(3);
+    if (result) {
+        env->SetLongArrayRegion(result, 0, 3, values);
     }
+    return result;
+}
 
-    // Create edge detection version
-    try {
-        processFrame(rotatedBgr, processedFrame);  // Your existing OpenCV processing
-        LOGI("✅ [STEP 3C] Edge detection completed: %dx%d", processedFrame.cols, processedFrame.rows);
-    } catch (const std::exception& e) {
-        LOGE("❌ [STEP 3C] processFrame() crashed: %s", e.what());
-        processedFrame = rotatedBgr.clone(); // Fallback to raw
-    } catch (...) {
-        LOGE("❌ [STEP 3C] processFrame() crashed with unknown exception");
-        processedFrame = rotatedBgr.clone(); // Fallback to raw
+// Code payloads are arbitrary bytes, NewStringUTF wants modified UTF-8:
+// valid UTF-8 of up to three bytes passes, NUL becomes C0 80 and any other
+// byte is taken as Latin-1
+static std::string toModifiedUtf8(const std::string& text) {
+    std::string out;
+    out.reserve(text.size());
+    const auto* bytes = reinterpret_cast<const uint8_t*>(text.data());
+    for (size_t i = 0; i < text.size();) {
+        const uint8_t b = bytes[i];
+        const size_t length = b >= 0xE0 && b < 0xF0 ? 3 : b >= 0xC2 && b < 0xE0 ? 2 : 1;
+        bool valid = b != 0 && (b < 0x80 || length > 1) && i + length <= text.size();
+        for (size_t k = 1; valid && k < length; k++) {
+            valid = (bytes[i + k] & 0xC0) == 0x80;
+        }
+        if (valid) {
+            out.append(text, i, length);
+            i += length;
+        } else {
+            out.push_back(static_cast<char>(0xC0 | (b >> 6)));
+            out.push_back(static_cast<char>(0x80 | (b & 0x3F)));
+            i++;
+        }
     }
+    return out;
+}
+
+// Scan the last nativeGetCodes call returned; results are handed out once
+static std::atomic<uint64_t> codesReturned{0};
 
-    LOGI("✅ [STEP 4] All frame variants ready - processFrame complete");
+// Payloads of the newest finished code scan, or null when no scan finished
+// since the previous call (Java polls; decoding runs on its own thread).
+// corners, if not null, receives each code's four corners as x, y pairs in
+// 0..1 full-frame units, 8 floats per code, as far as it has room.
+extern "C"
+JNIEXPORT jobjectArray JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeGetCodes(JNIEnv *env, jclass clazz, jfloatArray corners) {
+    std::shared_ptr<const CodeScanResult> codes;
+    cv::Mat strips;
+    {
+        std::lock_guard<std::mutex> lock(defaultPipeline.publishMutex);
+        codes = defaultPipeline.lastPublished.codes;
+        strips = defaultPipeline.lastPublished.codeStrips;  // immutable once published
+    }
+    if (!codes || codesReturned.exchange(codes->scan) == codes->scan) {
+        return nullptr;
+    }
+    const int count = std::min(static_cast<int>(codes->texts.size()), strips.rows / 5);
+    if (corners) {
+        const int fits = std::min(count, static_cast<int>(env->GetArrayLength(corners) / 8));
+        for (int i = 0; i < fits; i++) {
+            float quad[8];
+            for (int j = 0; j < 4; j++) {
+                const cv::Point2f& corner = strips.at<cv::Point2f>(5 * i + j);
+                quad[2 * j] = corner.x;
+                quad[2 * j + 1] = corner.y;
+            }
+            env->SetFloatArrayRegion(corners, 8 * i, 8, quad);
+        }
+    }
+    jobjectArray texts = env->NewObjectArray(count, jniCache().stringClass, nullptr);
+    for (int i = 0; texts && i < count; i++) {
+        jstring text = env->NewStringUTF(toModifiedUtf8(codes->texts[static_cast<size_t>(i)]).c_str());
+        env->SetObjectArrayElement(texts, i, text);
+        env->DeleteLocalRef(text);
+    }
+    return texts;
 }
 
-// Original JNI function (backward compatibility)
+// SEGMENTS: LSD runs per second at most, the reduction it runs at (1, 2 or
+// 4) and the mean thumbnail difference in gray levels below which the scene
+// counts as static and the last segments are kept without a run
 extern "C"
 JNIEXPORT void JNICALL
-Java_com_example_edge_nativebridge_NativeBridge_nativeProcessFrame(JNIEnv *env, jclass clazz,
-                                                                   jbyteArray frameData_,
-                                                                   jint width, jint height) {
-    jbyte* frameData = env->GetByteArrayElements(frameData_, nullptr);
-    processFrameInternal(frameData, width, height, 0); // No rotation
-    env->ReleaseByteArrayElements(frameData_, frameData, JNI_ABORT);
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetSegmentParams(JNIEnv *env, jclass clazz, jfloat maxRate,
+                                                                      jint downscale, jfloat staticDifference) {
+    if (!(maxRate > 0.0f) || maxRate > 60.0f || (downscale != 1 && downscale != 2 && downscale != 4) ||
+        !(staticDifference >= 0.0f)) {
+        LOGE("❌ Invalid segment params: rate %.1f, downscale %d, static %.2f", maxRate, downscale,
+             staticDifference);
+        return;
+    }
+    SegmentDetector::Params params;
+    params.maxRate = maxRate;
+    params.downscale = downscale;
+    params.staticDifference = staticDifference;
+    segmentDetector().setParams(params);
+    LOGI("🔄 Segment params: %.1f runs/s, 1/%d resolution, static below %.2f", maxRate, downscale,
+         staticDifference);
 }
 
-// New JNI function with rotation support
+// Accuracy/speed trade-off of the LINES mode (LineDetector::Preset: 0 = quarter
+// resolution with frequent reuse, 1 = half resolution, 2 = full resolution)
 extern "C"
 JNIEXPORT void JNICALL
-Java_com_example_edge_nativebridge_NativeBridge_nativeProcessFrameWithRotation(JNIEnv *env, jclass clazz,
-                                                                               jbyteArray frameData_,
-                                                                               jint width, jint height, jint rotation) {
-    jbyte* frameData = env->GetByteArrayElements(frameData_, nullptr);
-    processFrameInternal(frameData, width, height, rotation);
-    env->ReleaseByteArrayElements(frameData_, frameData, JNI_ABORT);
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetLinePreset(JNIEnv *env, jclass clazz, jint preset) {
+    if (preset < static_cast<int>(LineDetector::Preset::FAST) ||
+        preset > static_cast<int>(LineDetector::Preset::ACCURATE)) {
+        LOGE("❌ Unknown line preset: %d", preset);
+        return;
+    }
+    lineDetector().setPreset(static_cast<LineDetector::Preset>(preset));
+    LOGI("🔄 Line preset: %s", preset == 0 ? "FAST" : preset == 1 ? "BALANCED" : "ACCURATE");
 }
 
+// FAST threshold and the grid that bounds how many keypoints each cell of the
+// frame may contribute (FEATURES mode)
 extern "C"
 JNIEXPORT void JNICALL
-Java_com_example_edge_nativebridge_NativeBridge_nativeCleanup(JNIEnv *env, jclass clazz) {
-    LOGI(">> JNI cleanup called");
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetFeatureParams(JNIEnv *env, jclass clazz, jint threshold,
+                                                                      jint gridCols, jint gridRows, jint perCell) {
+    if (threshold < 1 || threshold > 255 || gridCols < 1 || gridRows < 1 || perCell < 1 ||
+        gridCols * gridRows * perCell > 4096) {
+        LOGE("❌ Invalid feature params: threshold %d, grid %dx%d, %d per cell", threshold, gridCols, gridRows, perCell);
+        return;
+    }
+    GridFeatureDetector::Params params;
+    params.threshold = threshold;
+    params.gridCols = gridCols;
+    params.gridRows = gridRows;
+    params.perCell = perCell;
+    featureDetector().setParams(params);
+    LOGI("🔄 Feature params: threshold %d, grid %dx%d, %d per cell", threshold, gridCols, gridRows, perCell);
+}
 
-    std::lock_guard<std::mutex> lock(frameMutex);
-    rawFrame.release();
-    processedFrame.release();
-    grayscaleFrame.release();
+// Selects the CPU Canny implementation (CannyBackend: 0 = benchmark all and
+// keep the fastest, 1 = cv::Canny, 2 = in-house 8-bit kernel, 3 = its tiled mode,
+// 4 = FAST_EDGES, the thresholded Sobel magnitude without suppression or hysteresis,
+// 5 = the tiled kernel with bounded-time hysteresis)
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetCannyBackend(JNIEnv *env, jclass clazz, jint backend) {
+    if (backend < static_cast<int>(CannyBackend::AUTO) || backend > static_cast<int>(CannyBackend::BOUNDED)) {
+        LOGE("❌ Unknown Canny backend: %d", backend);
+        return;
+    }
+    setCannyBackend(static_cast<CannyBackend>(backend));
+    LOGI("🔄 Canny backend: %d", backend);
+}
 
-    LOGI("✅ Native cleanup completed");
+// The CPU edge paths the backend autotuner times: the three Canny
+// implementations (the tiled one at several band heights), G-API when it
+// does the same work (it always pre-blurs) and OpenCL when a device exists.
+// GLES and Vulkan run on the GL thread against camera textures and are not
+// candidates.
+static std::vector<TuneCandidate> autotuneCandidates() {
+    std::vector<TuneCandidate> candidates;
+    candidates.push_back({"opencv", [](const cv::Mat& gray, cv::Mat& edges) {
+        cannyWithBackend(CannyBackend::OPENCV, gray, edges);
+    }});
+    candidates.push_back({"kernel", [](const cv::Mat& gray, cv::Mat& edges) {
+        cannyWithBackend(CannyBackend::KERNEL, gray, edges);
+    }});
+    for (int rows : {0, 32, 64, 128}) {
+        candidates.push_back({"tiled:" + std::to_string(rows), [rows](const cv::Mat& gray, cv::Mat& edges) {
+            setCannyTiledBandRows(rows);
+            cannyWithBackend(CannyBackend::TILED, gray, edges);
+        }});
+    }
+    if (edgePreBlurEnabled()) {
+        candidates.push_back({"gapi", [](const cv::Mat& gray, cv::Mat& edges) {
+            CV_Assert(gapiEdgePipeline().run(gray, edges));
+        }});
+    }
+    if (initOpenCLProcessing()) {
+        candidates.push_back({"opencl", [](const cv::Mat& gray, cv::Mat& edges) {
+            CV_Assert(detectEdgesOcl(gray, edges));
+        }});
+    }
+    return candidates;
 }
 
-// FIXED: Add the missing setRenderModeNative function that GLRenderer calls
+// Switches the edge path to an autotuner winner (autotuneCandidates' names)
+static void applyAutotuneWinner(const std::string& winner) {
+    const bool gapi = winner == "gapi";
+    gapiPipeline.store(gapi);
+    if (winner == "opencl") {
+        int expected = EDGE_BACKEND_CPU;  // a backend the app picked stays
+        edgeBackend.compare_exchange_strong(expected, EDGE_BACKEND_OPENCL);
+    } else if (winner == "opencv") {
+        setCannyBackend(CannyBackend::OPENCV);
+    } else if (winner == "kernel") {
+        setCannyBackend(CannyBackend::KERNEL);
+    } else if (winner.compare(0, 6, "tiled:") == 0) {
+        setCannyTiledBandRows(std::atoi(winner.c_str() + 6));
+        setCannyBackend(CannyBackend::TILED);
+    }
+}
+
+// The fastest CPU edge path for this SoC, frame size, build and pre-blur
+// setting: loaded from the file at path when an earlier launch tuned it,
+// else timed now on synthetic width x height frames for about budgetMs and
+// stored there (pass a file in app storage and the app version as build).
+// The winner is applied before returning and its name returned; null if
+// nothing could run. Blocks for the tuning run, so call it off the UI thread.
+extern "C"
+JNIEXPORT jstring JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeAutotuneBackends(JNIEnv *env, jclass clazz, jstring path,
+                                                                        jstring build, jint width, jint height,
+                                                                        jint budgetMs) {
+    if (!path || !build || width < 16 || height < 16) {
+        LOGE("❌ Autotune needs a file, a build and a frame size, got %dx%d", width, height);
+        return nullptr;
+    }
+    const char* pathChars = env->GetStringUTFChars(path, nullptr);
+    if (!pathChars) {
+        return nullptr;
+    }
+    const std::string file(pathChars);
+    env->ReleaseStringUTFChars(path, pathChars);
+    const char* buildChars = env->GetStringUTFChars(build, nullptr);
+    if (!buildChars) {
+        return nullptr;
+    }
+    const std::string version(buildChars);
+    env->ReleaseStringUTFChars(build, buildChars);
+
+    const cv::Size size(width, height);
+    const std::string key = BackendAutotuner::key(size, version, edgePreBlurEnabled() ? "blur" : "noblur");
+    const int pinnedRows = cannyTiledBandRows();
+    const BackendAutotuner::Result result =
+            backendAutotuner().resolve(file, key, autotuneCandidates(), size, std::max(budgetMs, 1));
+    setCannyTiledBandRows(pinnedRows);  // the tiled candidates changed it
+    if (result.winner.empty()) {
+        LOGE("❌ No edge backend could be tuned");
+        return nullptr;
+    }
+    applyAutotuneWinner(result.winner);
+    if (result.fromCache) {
+        LOGI("✅ Edge backend %s (tuned on an earlier launch)", result.winner.c_str());
+    } else {
+        LOGI("✅ Edge backend %s tuned: %.0f us per frame", result.winner.c_str(), result.micros);
+    }
+    return env->NewStringUTF(result.winner.c_str());
+}
+
+// Routes RAW_CAMERA through the renderer's GL_TEXTURE_EXTERNAL_OES texture. The
+// camera must then target the SurfaceTexture attached with
+// GLRenderer.attachSurfaceTextureNative; frames ingested over JNI are only
+// processed for modes that need pixels on the CPU.
 extern "C"
 JNIEXPORT void JNICALL
-Java_com_example_edge_renderer_GLRenderer_setRenderModeNative(JNIEnv *env, jobject thiz, jint mode) {
-    currentRenderMode = static_cast<RenderMode>(mode);
-    LOGI("🔄 Render mode changed to: %d (%s)", mode,
-         mode == 0 ? "RAW_CAMERA" :
-         mode == 1 ? "EDGE_DETECTION" :
-         mode == 2 ? "GRAYSCALE" :
-         mode == 3 ? "DEFAULT" :
-         mode == 4 ? "INSET" :
-         mode == 5 ? "BORDER_FIX" : "UNKNOWN");
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetExternalPreview(JNIEnv *env, jclass clazz, jboolean enabled) {
+    externalPreview.store(enabled == JNI_TRUE);
+    LOGI("🔄 External OES preview %s", enabled ? "enabled" : "disabled");
+}
+
+// Toggles GPU YUV conversion for RAW_CAMERA (false = NV21 -> BGR on the CPU)
+extern "C"
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeSetGpuYuvConversion(JNIEnv *env, jclass clazz, jboolean enabled) {
+    gpuYuvRaw.store(enabled == JNI_TRUE);
+    LOGI("🔄 GPU YUV conversion %s", enabled ? "enabled" : "disabled");
 }
 
-// This function is called by your OpenGL renderer to get the right frame
-cv::Mat getLatestFrameForRender() {
-    static int debugCounter = 0;
-    static cv::Mat fallbackFrame;
+// Raw camera layer from a published set: the OES texture, the Y/VU planes for
+// the shader, or CPU-converted BGR, whichever the current settings produce.
+// image stays empty when none is available yet.
+static RenderFrame rawCameraLayer(const PublishedFrame& latest) {
+    RenderFrame layer;
+    if (externalPreview.load(std::memory_order_relaxed)) {
+        // The OES draw uses the SurfaceTexture transform; rotation is for the
+        // processed layers drawn over it
+        layer.useExternalTexture = true;
+        layer.rotation = latest.rotation;
+        return layer;
+    }
+    if ((rawLayerVariants() & VARIANT_YUV) && !latest.yuvLuma.empty()) {
+        layer.image = latest.yuvLuma;
+        layer.chroma = latest.yuvChroma;
+    } else if (!latest.raw.empty()) {
+        layer.image = latest.raw;
+    }
+    layer.rotation = latest.rotation;
+    layer.sequence = latest.sequence;
+    return layer;
+}
 
-    // Initialize fallback frame once
-    if (fallbackFrame.empty()) {
-        fallbackFrame = cv::Mat::zeros(480, 640, CV_8UC3);
-        // Make it clearly visible for debugging - blue frame
-        fallbackFrame.setTo(cv::Scalar(255, 0, 0)); // Blue in BGR
-        LOGI("✅ [RENDER] Created blue fallback frame: 640x480");
+// Lets the renderer sample the hardware buffer copy of a single-layer image
+static void attachHardwareFrame(const PublishedFrame& latest, RenderFrame& frame) {
+    if (latest.hardwareFrame && !frame.image.empty() && frame.image.data == latest.hardwareFrameSource.data &&
+        !frame.isYuv() && frame.composition == RenderFrame::Composition::SINGLE && frame.region.empty() &&
+        frame.bitmapWidth == 0) {
+        frame.hardwareFrame = latest.hardwareFrame;
+    }
+}
+
+// This function is called by your OpenGL renderer to get the right frame.
+// Only ever called from the GL thread (the triple buffer's single consumer).
+// Published variants are immutable pooled buffers, so the header is shared (the
+// refcount keeps the buffer out of the pool until the renderer drops it).
+// Places the processed layer of a frame (overlay, or image for single-layer
+// frames) at the ROI it was computed from
+static void applyProcessedRoi(const PublishedFrame& latest, RenderFrame& frame) {
+    frame.region = latest.processedRoi;
+    frame.regionFrameSize = latest.processedFrameSize;
+    frame.backgroundDim = roiBackgroundDim.load(std::memory_order_relaxed);
+}
+
+// Single-layer modes with a processing ROI: the processed frame drawn in place
+// over the raw feed. False while no raw layer is available, and for color
+// filter graph output (the overlay texture is single-channel).
+static bool regionOverRaw(const PublishedFrame& latest, const cv::Mat& processed, RenderFrame& layer,
+                          int bitmapWidth = 0) {
+    if (latest.processedRoi.empty() || processed.empty() || processed.channels() != 1) {
+        return false;
+    }
+    layer = rawCameraLayer(latest);
+    if (!layer.useExternalTexture && layer.image.empty()) {
+        return false;
     }
+    layer.overlay = processed;
+    layer.bitmapWidth = bitmapWidth;
+    layer.composition = RenderFrame::Composition::REGION;
+    applyProcessedRoi(latest, layer);
+    return true;
+}
+
+// FOCUS_PEAK's threshold in the shader's units (Sobel L1 of 0..1 luma). A
+// step of height h gives a Sobel response of 4h and a Laplacian of h, so
+// 4 * sqrt(variance of the Laplacian) is the frame's typical edge response.
+static float focusPeakThreshold() {
+    const float kFloor = 48.0f;      // 8-bit Sobel units: below this a flat scene's noise would peak
+    const float kCeiling = 1500.0f;  // of 2040
+    LumaStats stats;
+    const float typical = latestLumaStats(stats) ? 4.0f * std::sqrt(std::max(stats.sharpness, 0.0f)) : 0.0f;
+    const float threshold = focusPeakSensitivity.load(std::memory_order_relaxed) * typical;
+    return std::min(std::max(threshold, kFloor), kCeiling) / 255.0f;
+}
+
+// The processed layer's dirty rects, for a frame whose edge layer it is
+static void attachEdgeChanges(const PublishedFrame& latest, RenderFrame& layer) {
+    layer.edgeResult = latest.processedResult;
+    layer.changeBase = latest.processedBase;
+    layer.changedRects = latest.processedChanges;
+}
+
+static RenderFrame frameForRenderMode(PipelineContext& pipeline, RenderMode renderMode) {
+    static thread_local int debugCounter = 0;
+    const cv::Mat& fallbackFrame = renderFallbackFrame();
 
-    std::lock_guard<std::mutex> lock(frameMutex);
+    // Lock-free: swap in the newest published slot if there is one
+    pipeline.publishedFrames.update();
+    const PublishedFrame& latest = pipeline.publishedFrames.readSlot();
+    const cv::Mat& grayscaleFrame = latest.grayscale;
+    const cv::Mat& processedFrame = latest.processed;
 
     cv::Mat frameToReturn;
+    RenderFrame layer;
 
-    switch (currentRenderMode) {
+    switch (renderMode) {
         case RAW_CAMERA:
-            if (!rawFrame.empty()) {
-                frameToReturn = rawFrame.clone();
-                LOGI("✅ [RENDER] [%d] Returning RAW camera frame %dx%d", debugCounter++, frameToReturn.cols, frameToReturn.rows);
-            } else {
-                frameToReturn = fallbackFrame.clone();
-                LOGE("❌ [RENDER] [%d] Raw frame empty, using blue fallback", debugCounter++);
+            layer = rawCameraLayer(latest);
+            if (layer.useExternalTexture || !layer.image.empty()) {
+                attachHardwareFrame(latest, layer);
+                LOGV("✅ [RENDER] [%d] Returning RAW camera layer %dx%d", debugCounter++, layer.image.cols, layer.image.rows);
+                return layer;
             }
+            frameToReturn = fallbackFrame;
+            metrics().increment(Counter::FALLBACK_FRAMES);
+            LOGW_RATELIMITED("❌ [RENDER] [%d] Raw frame empty, using blue fallback", debugCounter++);
             break;
 
         case GRAYSCALE:
+            if (regionOverRaw(latest, grayscaleFrame, layer)) {
+                return layer;
+            }
             if (!grayscaleFrame.empty()) {
-                frameToReturn = grayscaleFrame.clone();
-                LOGI("✅ [RENDER] [%d] Returning GRAYSCALE frame %dx%d", debugCounter++, frameToReturn.cols, frameToReturn.rows);
+                frameToReturn = grayscaleFrame;
+                LOGV("✅ [RENDER] [%d] Returning GRAYSCALE frame %dx%d", debugCounter++, frameToReturn.cols, frameToReturn.rows);
             } else {
-                frameToReturn = fallbackFrame.clone();
-                LOGE("❌ [RENDER] [%d] Grayscale frame empty, using blue fallback", debugCounter++);
+                frameToReturn = fallbackFrame;
+                metrics().increment(Counter::FALLBACK_FRAMES);
+                LOGW_RATELIMITED("❌ [RENDER] [%d] Grayscale frame empty, using blue fallback", debugCounter++);
             }
             break;
 
-        case EDGE_DETECTION:
         case DEFAULT:
         case INSET:
+            // Raw feed with the edge frame as a second layer, composed on the GPU
+            // (color filter graph output is shown on its own instead)
+            layer = rawCameraLayer(latest);
+            if ((layer.useExternalTexture || !layer.image.empty()) && !processedFrame.empty() &&
+                processedFrame.channels() == 1) {
+                layer.overlay = processedFrame;
+                layer.bitmapWidth = latest.processedBitmapWidth;
+                attachEdgeChanges(latest, layer);
+                applyProcessedRoi(latest, layer);
+                layer.composition = renderMode == INSET ? RenderFrame::Composition::INSET
+                                                               : RenderFrame::Composition::OVERLAY;
+                LOGV("✅ [RENDER] [%d] Returning %s composition", debugCounter++,
+                     renderMode == INSET ? "INSET" : "DEFAULT");
+                return layer;
+            }
+            if (!processedFrame.empty()) {
+                frameToReturn = processedFrame;  // raw layer not ready yet: edges alone
+            } else {
+                frameToReturn = fallbackFrame;
+                metrics().increment(Counter::FALLBACK_FRAMES);
+                LOGW_RATELIMITED("❌ [RENDER] [%d] Composition layers empty, using blue fallback", debugCounter++);
+            }
+            break;
+
         case BORDER_FIX:
+            // Edge frame scaled to cover the whole viewport (cropped, no bars);
+            // with an ROI it is drawn over the letterboxed raw feed instead
+            if (regionOverRaw(latest, processedFrame, layer, latest.processedBitmapWidth)) {
+                return layer;
+            }
+            if (!processedFrame.empty()) {
+                layer.image = processedFrame;
+                layer.bitmapWidth = latest.processedBitmapWidth;
+                layer.rotation = latest.rotation;
+                layer.sequence = latest.sequence;
+                layer.composition = RenderFrame::Composition::FILL;
+                applyProcessedRoi(latest, layer);
+                return layer;
+            }
+            frameToReturn = fallbackFrame;
+            metrics().increment(Counter::FALLBACK_FRAMES);
+            LOGW_RATELIMITED("❌ [RENDER] [%d] Processed frame empty, using blue fallback", debugCounter++);
+            break;
+
+        case FEATURES:
+            // Raw feed with the keypoints drawn by the renderer as point sprites
+            layer = rawCameraLayer(latest);
+            if (layer.useExternalTexture || !layer.image.empty()) {
+                layer.markers = latest.features;
+                layer.markerStyle = RenderFrame::MarkerStyle::POINTS;
+                layer.markerFrameSize = latest.processedFrameSize;
+                LOGV("✅ [RENDER] [%d] Returning raw layer with %d keypoints", debugCounter++, latest.features.rows);
+                return layer;
+            }
+            frameToReturn = fallbackFrame;
+            metrics().increment(Counter::FALLBACK_FRAMES);
+            LOGW_RATELIMITED("❌ [RENDER] [%d] Raw frame empty, using blue fallback", debugCounter++);
+            break;
+
+        case CONTOURS:
+            // Line strips only (over the raw feed when there is an ROI); the
+            // edge raster never leaves the processing thread
+            if (!latest.processedRoi.empty()) {
+                layer = rawCameraLayer(latest);
+            }
+            layer.markers = latest.contourPoints;
+            layer.markerOffsets = latest.contourOffsets;
+            layer.markerStyle = RenderFrame::MarkerStyle::LINE_STRIPS;
+            layer.markerFrameSize = latest.processedFrameSize;
+            layer.rotation = latest.rotation;
+            layer.sequence = latest.sequence;
+            LOGV("✅ [RENDER] [%d] Returning %d contour strips", debugCounter++,
+                 std::max(0, latest.contourOffsets.rows - 1));
+            return layer;
+
+        case MOTION:
+            // Raw feed with the (low-resolution) motion mask blended over it
+            layer = rawCameraLayer(latest);
+            if ((layer.useExternalTexture || !layer.image.empty()) && !latest.motion.empty()) {
+                layer.overlay = latest.motion;
+                layer.composition = RenderFrame::Composition::OVERLAY;
+                applyProcessedRoi(latest, layer);
+                LOGV("✅ [RENDER] [%d] Returning raw layer with %dx%d motion mask", debugCounter++,
+                     latest.motion.cols, latest.motion.rows);
+                return layer;
+            }
+            if (layer.useExternalTexture || !layer.image.empty()) {
+                return layer;  // no mask yet
+            }
+            frameToReturn = fallbackFrame;
+            metrics().increment(Counter::FALLBACK_FRAMES);
+            LOGW_RATELIMITED("❌ [RENDER] [%d] Raw frame empty, using blue fallback", debugCounter++);
+            break;
+
+        case DOCUMENT:
+            // Raw feed with the quadrilateral drawn by the renderer as one closed strip
+            layer = rawCameraLayer(latest);
+            if (layer.useExternalTexture || !layer.image.empty()) {
+                static const cv::Mat kOutlineOffsets = (cv::Mat_<int>(2, 1) << 0, 5);
+                if (latest.document.rows == 5) {
+                    layer.markers = latest.document;
+                    layer.markerOffsets = kOutlineOffsets;
+                    layer.markerStyle = RenderFrame::MarkerStyle::LINE_STRIPS;
+                    layer.markerFrameSize = latest.processedFrameSize;
+                    // The renderer straightens it from the raw layer's texture
+                    layer.rectifiedInset = documentInset.load(std::memory_order_relaxed);
+                    layer.rectify = latest.documentHomography;
+                    layer.rectifiedSize = latest.documentSize;
+                    std::lock_guard<std::mutex> lock(rectifiedMutex);
+                    layer.rectifiedReadback = rectifiedReadbackSize;
+                }
+                LOGV("✅ [RENDER] [%d] Returning raw layer %s document", debugCounter++,
+                     latest.document.rows == 5 ? "with" : "without");
+                return layer;
+            }
+            frameToReturn = fallbackFrame;
+            metrics().increment(Counter::FALLBACK_FRAMES);
+            LOGW_RATELIMITED("❌ [RENDER] [%d] Raw frame empty, using blue fallback", debugCounter++);
+            break;
+
+        case CHAMFER_MATCH:
+            // Raw feed with the accepted template boxes as closed strips
+            layer = rawCameraLayer(latest);
+            if (layer.useExternalTexture || !layer.image.empty()) {
+                if (latest.chamferOffsets.rows > 1) {
+                    layer.markers = latest.chamferOutlines;
+                    layer.markerOffsets = latest.chamferOffsets;
+                    layer.markerStyle = RenderFrame::MarkerStyle::LINE_STRIPS;
+                    layer.markerFrameSize = latest.processedFrameSize;
+                }
+                LOGV("✅ [RENDER] [%d] Returning raw layer with %d template matches", debugCounter++,
+                     std::max(0, latest.chamferOffsets.rows - 1));
+                return layer;
+            }
+            frameToReturn = fallbackFrame;
+            metrics().increment(Counter::FALLBACK_FRAMES);
+            LOGW_RATELIMITED("❌ [RENDER] [%d] Raw frame empty, using blue fallback", debugCounter++);
+            break;
+
+        case MARKERS:
+            // Raw feed with each marker's outline as a closed strip
+            layer = rawCameraLayer(latest);
+            if (layer.useExternalTexture || !layer.image.empty()) {
+                if (latest.markerStripOffsets.rows > 1) {
+                    layer.markers = latest.markerStrips;
+                    layer.markerOffsets = latest.markerStripOffsets;
+                    layer.markerStyle = RenderFrame::MarkerStyle::LINE_STRIPS;
+                    layer.markerFrameSize = latest.processedFrameSize;
+                }
+                LOGV("✅ [RENDER] [%d] Returning raw layer with %d markers", debugCounter++, latest.markers.rows);
+                return layer;
+            }
+            frameToReturn = fallbackFrame;
+            metrics().increment(Counter::FALLBACK_FRAMES);
+            LOGW_RATELIMITED("❌ [RENDER] [%d] Raw frame empty, using blue fallback", debugCounter++);
+            break;
+
+        case DEPTH:
+            // Disparity of the whole frame, scaled up by the quad like any layer
+            if (!latest.depth.empty()) {
+                layer.image = latest.depth;
+                layer.rotation = latest.rotation;
+                layer.sequence = latest.sequence;
+                LOGV("✅ [RENDER] [%d] Returning %dx%d disparity", debugCounter++, latest.depth.cols, latest.depth.rows);
+                return layer;
+            }
+            frameToReturn = fallbackFrame;
+            metrics().increment(Counter::FALLBACK_FRAMES);
+            LOGW_RATELIMITED("❌ [RENDER] [%d] No disparity yet (right view missing?), using blue fallback",
+                             debugCounter++);
+            break;
+
+        case PEOPLE:
+            // The CPU edge map (whose gradients HOG may have reused) with the
+            // people boxes over it
+            if (!regionOverRaw(latest, processedFrame, layer, latest.processedBitmapWidth)) {
+                if (processedFrame.empty()) {
+                    frameToReturn = fallbackFrame;
+                    metrics().increment(Counter::FALLBACK_FRAMES);
+                    LOGW_RATELIMITED("❌ [RENDER] [%d] Processed frame empty, using blue fallback", debugCounter++);
+                    break;
+                }
+                layer.image = processedFrame;
+                layer.bitmapWidth = latest.processedBitmapWidth;
+                layer.rotation = latest.rotation;
+                layer.sequence = latest.sequence;
+                applyProcessedRoi(latest, layer);
+            }
+            if (latest.peopleStripOffsets.rows > 1) {
+                layer.markers = latest.peopleStrips;
+                layer.markerOffsets = latest.peopleStripOffsets;
+                layer.markerStyle = RenderFrame::MarkerStyle::LINE_STRIPS;
+                layer.markerFrameSize = latest.processedFrameSize;
+            }
+            LOGV("✅ [RENDER] [%d] Returning edges with %d people", debugCounter++, latest.people.rows);
+            return layer;
+
+        case TRACK_OBJECT:
+            // Raw feed with the object's box; with edges in the box, the edge
+            // map of the region around it drawn in place
+            if (!regionOverRaw(latest, processedFrame, layer, latest.processedBitmapWidth)) {
+                layer = rawCameraLayer(latest);
+            }
+            if (layer.useExternalTexture || !layer.image.empty()) {
+                if (latest.trackedObjectOffsets.rows > 1) {
+                    layer.markers = latest.trackedObject;
+                    layer.markerOffsets = latest.trackedObjectOffsets;
+                    layer.markerStyle = RenderFrame::MarkerStyle::LINE_STRIPS;
+                    layer.markerFrameSize = latest.processedFrameSize;
+                }
+                LOGV("✅ [RENDER] [%d] Returning raw layer with %s", debugCounter++,
+                     latest.trackedObject.empty() ? "no object" : "the tracked object");
+                return layer;
+            }
+            frameToReturn = fallbackFrame;
+            metrics().increment(Counter::FALLBACK_FRAMES);
+            LOGW_RATELIMITED("❌ [RENDER] [%d] Raw frame empty, using blue fallback", debugCounter++);
+            break;
+
+        case MOSAIC:
+            // The canvas, whose changed tiles the renderer uploads, with the
+            // current frame's outline over it
+            if (latest.mosaic) {
+                layer.mosaic = latest.mosaic;
+                layer.rotation = latest.rotation;
+                layer.sequence = latest.sequence;
+                if (latest.mosaicOutlineOffsets.rows > 1) {
+                    layer.markers = latest.mosaicOutline;
+                    layer.markerOffsets = latest.mosaicOutlineOffsets;
+                    layer.markerStyle = RenderFrame::MarkerStyle::LINE_STRIPS;
+                    layer.markerFrameSize = latest.mosaic->canvasSize;
+                }
+                LOGV("✅ [RENDER] [%d] Returning %dx%d mosaic", debugCounter++, latest.mosaic->canvasSize.width,
+                     latest.mosaic->canvasSize.height);
+                return layer;
+            }
+            frameToReturn = fallbackFrame;
+            metrics().increment(Counter::FALLBACK_FRAMES);
+            LOGW_RATELIMITED("❌ [RENDER] [%d] No mosaic yet, using blue fallback", debugCounter++);
+            break;
+
+        case STABILIZE:
+            // The edge map as EDGE_DETECTION shows it, plus the correction the
+            // renderer moves the quad by
+            if (regionOverRaw(latest, processedFrame, layer, latest.processedBitmapWidth)) {
+                layer.warped = latest.hasStabilization && !layer.useExternalTexture;
+                layer.warp = latest.stabilization;
+                return layer;
+            }
+            if (processedFrame.empty()) {
+                frameToReturn = fallbackFrame;
+                metrics().increment(Counter::FALLBACK_FRAMES);
+                LOGW_RATELIMITED("❌ [RENDER] [%d] Processed frame empty, using blue fallback", debugCounter++);
+                break;
+            }
+            layer.image = processedFrame;
+            layer.bitmapWidth = latest.processedBitmapWidth;
+            layer.rotation = latest.rotation;
+            layer.sequence = latest.sequence;
+            applyProcessedRoi(latest, layer);
+            layer.warped = latest.hasStabilization;
+            layer.warp = latest.stabilization;
+            LOGV("✅ [RENDER] [%d] Returning stabilized edges %dx%d", debugCounter++, processedFrame.cols,
+                 processedFrame.rows);
+            return layer;
+
+        case CODES:
+            // Raw feed with each decoded code's outline as a closed strip
+            layer = rawCameraLayer(latest);
+            if (layer.useExternalTexture || !layer.image.empty()) {
+                if (latest.codeStripOffsets.rows > 1) {
+                    layer.markers = latest.codeStrips;
+                    layer.markerOffsets = latest.codeStripOffsets;
+                    layer.markerStyle = RenderFrame::MarkerStyle::LINE_STRIPS;
+                    layer.markerFrameSize = latest.processedFrameSize;
+                }
+                LOGV("✅ [RENDER] [%d] Returning raw layer with %d codes", debugCounter++,
+                     latest.codeStrips.rows / 5);
+                return layer;
+            }
+            frameToReturn = fallbackFrame;
+            metrics().increment(Counter::FALLBACK_FRAMES);
+            LOGW_RATELIMITED("❌ [RENDER] [%d] Raw frame empty, using blue fallback", debugCounter++);
+            break;
+
+        case TEXT_REGIONS:
+            // Raw feed with each text line's box as a closed strip
+            layer = rawCameraLayer(latest);
+            if (layer.useExternalTexture || !layer.image.empty()) {
+                if (latest.textRegionStripOffsets.rows > 1) {
+                    layer.markers = latest.textRegionStrips;
+                    layer.markerOffsets = latest.textRegionStripOffsets;
+                    layer.markerStyle = RenderFrame::MarkerStyle::LINE_STRIPS;
+                    layer.markerFrameSize = latest.processedFrameSize;
+                }
+                LOGV("✅ [RENDER] [%d] Returning raw layer with %d text lines", debugCounter++,
+                     latest.textRegions.rows);
+                return layer;
+            }
+            frameToReturn = fallbackFrame;
+            metrics().increment(Counter::FALLBACK_FRAMES);
+            LOGW_RATELIMITED("❌ [RENDER] [%d] Raw frame empty, using blue fallback", debugCounter++);
+            break;
+
+        case FACES:
+            // Raw feed with each tracked face's box as a closed strip
+            layer = rawCameraLayer(latest);
+            if (layer.useExternalTexture || !layer.image.empty()) {
+                if (latest.faceStripOffsets.rows > 1) {
+                    layer.markers = latest.faceStrips;
+                    layer.markerOffsets = latest.faceStripOffsets;
+                    layer.markerStyle = RenderFrame::MarkerStyle::LINE_STRIPS;
+                    layer.markerFrameSize = latest.processedFrameSize;
+                }
+                LOGV("✅ [RENDER] [%d] Returning raw layer with %d faces", debugCounter++, latest.faces.rows);
+                return layer;
+            }
+            frameToReturn = fallbackFrame;
+            metrics().increment(Counter::FALLBACK_FRAMES);
+            LOGW_RATELIMITED("❌ [RENDER] [%d] Raw frame empty, using blue fallback", debugCounter++);
+            break;
+
+        case SEGMENTS:
+            // Raw feed with the newest LSD segments drawn by the renderer as lines
+            layer = rawCameraLayer(latest);
+            if (layer.useExternalTexture || !layer.image.empty()) {
+                layer.markers = latest.segments;
+                layer.markerStyle = RenderFrame::MarkerStyle::LINES;
+                layer.markerFrameSize = latest.processedFrameSize;
+                LOGV("✅ [RENDER] [%d] Returning raw layer with %d LSD segments", debugCounter++,
+                     latest.segments.rows / 2);
+                return layer;
+            }
+            frameToReturn = fallbackFrame;
+            metrics().increment(Counter::FALLBACK_FRAMES);
+            LOGW_RATELIMITED("❌ [RENDER] [%d] Raw frame empty, using blue fallback", debugCounter++);
+            break;
+
+        case LINES:
+            // Raw feed with the Hough segments drawn by the renderer as lines
+            layer = rawCameraLayer(latest);
+            if (layer.useExternalTexture || !layer.image.empty()) {
+                layer.markers = latest.lines;
+                layer.markerStyle = RenderFrame::MarkerStyle::LINES;
+                layer.markerFrameSize = latest.processedFrameSize;
+                LOGV("✅ [RENDER] [%d] Returning raw layer with %d segments", debugCounter++, latest.lines.rows / 2);
+                return layer;
+            }
+            frameToReturn = fallbackFrame;
+            metrics().increment(Counter::FALLBACK_FRAMES);
+            LOGW_RATELIMITED("❌ [RENDER] [%d] Raw frame empty, using blue fallback", debugCounter++);
+            break;
+
+        case HEATMAP:
+            // The edge map goes to the renderer's heat texture rather than
+            // the screen; nothing to accumulate is nothing to draw
+            if (!processedFrame.empty() && processedFrame.channels() == 1) {
+                layer.image = processedFrame;
+                layer.bitmapWidth = latest.processedBitmapWidth;
+                layer.rotation = latest.rotation;
+                layer.sequence = latest.sequence;
+                layer.heatmap = true;
+                layer.heatDecay = heatmapDecay.load(std::memory_order_relaxed);
+                layer.heatGain = heatmapGain.load(std::memory_order_relaxed);
+                layer.heatGeneration = heatmapGeneration.load(std::memory_order_relaxed);
+                applyProcessedRoi(latest, layer);
+                LOGV("✅ [RENDER] [%d] Returning edges %dx%d for the heatmap", debugCounter++, layer.image.cols,
+                     layer.image.rows);
+                return layer;
+            }
+            frameToReturn = fallbackFrame;
+            metrics().increment(Counter::FALLBACK_FRAMES);
+            LOGW_RATELIMITED("❌ [RENDER] [%d] Processed frame empty, using blue fallback", debugCounter++);
+            break;
+
+        case FOCUS_PEAK:
+            // The published planes are drawn and peaked by one shader; the
+            // threshold follows the frame's sharpness
+            if (!latest.yuvLuma.empty() || !latest.raw.empty()) {
+                layer.image = latest.yuvLuma.empty() ? latest.raw : latest.yuvLuma;
+                layer.chroma = latest.yuvLuma.empty() ? cv::Mat() : latest.yuvChroma;
+                layer.rotation = latest.rotation;
+                layer.sequence = latest.sequence;
+                layer.focusPeak = true;
+                layer.peakThreshold = focusPeakThreshold();
+                const uint32_t color = focusPeakColor.load(std::memory_order_relaxed);
+                layer.peakColor = cv::Vec4f((color >> 16 & 0xff) / 255.0f, (color >> 8 & 0xff) / 255.0f,
+                                            (color & 0xff) / 255.0f, (color >> 24) / 255.0f);
+                LOGV("✅ [RENDER] [%d] Returning %dx%d frame for focus peaking", debugCounter++, layer.image.cols,
+                     layer.image.rows);
+                return layer;
+            }
+            frameToReturn = fallbackFrame;
+            metrics().increment(Counter::FALLBACK_FRAMES);
+            LOGW_RATELIMITED("❌ [RENDER] [%d] Raw frame empty, using blue fallback", debugCounter++);
+            break;
+
+        case ODOMETRY:
+            // Raw feed with each ORB match drawn from its previous position
+            layer = rawCameraLayer(latest);
+            if (layer.useExternalTexture || !layer.image.empty()) {
+                layer.markers = latest.odometryMatches;
+                layer.markerStyle = RenderFrame::MarkerStyle::LINES;
+                layer.markerFrameSize = latest.processedFrameSize;
+                LOGV("✅ [RENDER] [%d] Returning raw layer with %d ORB matches", debugCounter++,
+                     latest.odometryMatches.rows / 2);
+                return layer;
+            }
+            frameToReturn = fallbackFrame;
+            metrics().increment(Counter::FALLBACK_FRAMES);
+            LOGW_RATELIMITED("❌ [RENDER] [%d] Raw frame empty, using blue fallback", debugCounter++);
+            break;
+
+        case TRACKING:
+            // Raw feed with the flow vectors drawn by the renderer as lines
+            layer = rawCameraLayer(latest);
+            if (layer.useExternalTexture || !layer.image.empty()) {
+                layer.markers = latest.flow;
+                layer.markerStyle = RenderFrame::MarkerStyle::LINES;
+                layer.markerFrameSize = latest.processedFrameSize;
+                LOGV("✅ [RENDER] [%d] Returning raw layer with %d flow vectors", debugCounter++, latest.flow.rows / 2);
+                return layer;
+            }
+            frameToReturn = fallbackFrame;
+            metrics().increment(Counter::FALLBACK_FRAMES);
+            LOGW_RATELIMITED("❌ [RENDER] [%d] Raw frame empty, using blue fallback", debugCounter++);
+            break;
+        case EDGE_DETECTION:
+            if (edgeBackend.load(std::memory_order_relaxed) == EDGE_BACKEND_CL_GL &&
+                externalPreview.load(std::memory_order_relaxed)) {
+                layer = rawCameraLayer(latest);
+                layer.detectEdgesOnGpu = true;
+                LOGV("✅ [RENDER] [%d] Returning camera texture for CL-GL edges", debugCounter++);
+                return layer;
+            }
+            if (edgeBackend.load(std::memory_order_relaxed) == EDGE_BACKEND_VULKAN && latest.sharedEdges) {
+                RenderFrame shared;
+                shared.sharedEdges = latest.sharedEdges;
+                shared.rotation = latest.rotation;
+                shared.sequence = latest.sequence;
+                LOGV("✅ [RENDER] [%d] Returning Vulkan edges %dx%d", debugCounter++, shared.sharedEdges->width,
+                     shared.sharedEdges->height);
+                return shared;
+            }
+            if (edgesInRenderer() && !grayscaleFrame.empty()) {
+                RenderFrame gpu;
+                gpu.image = grayscaleFrame;
+                gpu.rotation = latest.rotation;
+                gpu.sequence = latest.sequence;
+                gpu.detectEdgesOnGpu = true;
+                applyProcessedRoi(latest, gpu);
+                if (gpu.region.empty()) {
+                    gpu.splitEdges = latest.splitEdges;
+                }
+                LOGV("✅ [RENDER] [%d] Returning luma for GPU edges %dx%d", debugCounter++, gpu.image.cols, gpu.image.rows);
+                return gpu;
+            }
+            // fall through
         default:
+            if (regionOverRaw(latest, processedFrame, layer, latest.processedBitmapWidth)) {
+                return layer;
+            }
             if (!processedFrame.empty()) {
-                frameToReturn = processedFrame.clone();
-                LOGI("✅ [RENDER] [%d] Returning EDGE_DETECTION/DEFAULT frame %dx%d", debugCounter++, frameToReturn.cols, frameToReturn.rows);
+                frameToReturn = processedFrame;
+                LOGV("✅ [RENDER] [%d] Returning EDGE_DETECTION frame %dx%d", debugCounter++, frameToReturn.cols, frameToReturn.rows);
             } else {
-                frameToReturn = fallbackFrame.clone();
-                LOGE("❌ [RENDER] [%d] Processed frame empty, using blue fallback", debugCounter++);
+                frameToReturn = fallbackFrame;
+                metrics().increment(Counter::FALLBACK_FRAMES);
+                LOGW_RATELIMITED("❌ [RENDER] [%d] Processed frame empty, using blue fallback", debugCounter++);
             }
             break;
+
+    }
+
+    RenderFrame result;
+    result.image = frameToReturn;
+    bool isFallback = frameToReturn.data == fallbackFrame.data;
+    result.rotation = isFallback ? 0 : latest.rotation;
+    result.sequence = isFallback ? 0 : latest.sequence;
+    if (!isFallback) {
+        applyProcessedRoi(latest, result);
+    }
+    if (frameToReturn.data == processedFrame.data) {
+        result.bitmapWidth = latest.processedBitmapWidth;
+        attachEdgeChanges(latest, result);
+        // Half-rate processing: the edges follow the frames measured since
+        result.warped = &pipeline == &defaultPipeline &&
+                        motionCompensator().warpFor(latest.captureTimestampNs, result.warp);
+    }
+    attachHardwareFrame(latest, result);
+    return result;
+}
+
+RenderFrame getFrameForRender(PipelineContext* context, int mode) {
+    ScopedStageTimer timer(Stage::RENDER_FETCH);
+    PipelineContext& pipeline = context ? *context : defaultPipeline;
+    // One snapshot per drawn frame, so every layer agrees on the mode
+    const RenderMode renderMode = mode >= 0 && mode < kRenderModeCount ? static_cast<RenderMode>(mode)
+                                  : watchdogMode(pipeline, activeRenderMode(pipeline));
+    RenderFrame frame = frameForRenderMode(pipeline, renderMode);
+    frame.mode = renderMode;
+    frame.modesBuilt = pipeline.publishedFrames.readSlot().modesBuilt;
+    // GPU undistortion covers single-layer whole-frame pictures only; the
+    // CPU mode already published undistorted ones
+    frame.undistort = lensUndistortion().mode() == LensUndistortion::Mode::GPU && frame.region.empty() &&
+                      (frame.composition == RenderFrame::Composition::SINGLE ||
+                       frame.composition == RenderFrame::Composition::FILL);
+    // The OES camera texture carries its own timestamp, not this one
+    if (frame.sequence != 0 && !frame.useExternalTexture) {
+        frame.captureTimestampNs = pipeline.publishedFrames.readSlot().captureTimestampNs;
     }
+    return frame;
+}
+
+RenderFrame getLatestFrameForRender(PipelineContext* context) {
+    return getFrameForRender(context, -1);
+}
+
+// RegisterNatives tables (jni_registry.h): a JNI function added above needs
+// its entry here, with the signature of its Java declaration
+static const JNINativeMethod kNativeBridgeMethods[] = {
+        EDGE_NATIVE_BRIDGE_METHOD(nativeProcessFrame, "([BII)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeProcessFrameWithRotation, "([BIII)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeProcessFrameWithTimestamp, "([BIIIJ)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeProcessFrameDirect, "(Ljava/nio/ByteBuffer;III)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeProcessFrameDirectWithTimestamp, "(Ljava/nio/ByteBuffer;IIIJ)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeProcessYuvPlanes, "(Ljava/nio/ByteBuffer;Ljava/nio/ByteBuffer;Ljava/nio/ByteBuffer;IIIIII)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeProcessYuvPlanesWithTimestamp, "(Ljava/nio/ByteBuffer;Ljava/nio/ByteBuffer;Ljava/nio/ByteBuffer;IIIIIIJ)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeProcessP010, "(Ljava/nio/ByteBuffer;Ljava/nio/ByteBuffer;IIIIIJ)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeProcessRaw, "(Ljava/nio/ByteBuffer;IIIIIIJ)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeProcessBatch, "(Ljava/nio/ByteBuffer;[JIIIIIZLjava/nio/ByteBuffer;)I"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeBatchOutputFrameBytes, "(III)I"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeStartAsyncProcessing, "(Ljava/lang/Object;IIIZ)Z"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeStopAsyncProcessing, "()V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSubmitFrameAsync, "(Ljava/nio/ByteBuffer;IIIJLjava/nio/ByteBuffer;)J"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeAllocateFrameBuffers, "(II)[Ljava/nio/ByteBuffer;"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeAcquireFreeFrameBuffer, "()I"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeReleaseFrameBuffers, "()Z"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeStartProcessingWorker, "()V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeStopProcessingWorker, "()V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeStartPipelineWorker, "(J)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeStopPipelineWorker, "(J)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeStartFrameCapture, "(Ljava/lang/String;III)Z"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeStopFrameCapture, "()V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeStartTelemetry, "(Ljava/lang/String;I)Z"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeStopTelemetry, "()V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeStartSessionReport, "()V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeFinishSessionReport, "(Ljava/lang/String;)Z"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeStartBurst, "(II)Z"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeFinishBurst, "()I"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetBurstInfo, "(I)[F"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeTakeBurstFrame, "(ILjava/nio/ByteBuffer;)J"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeReleaseBurst, "()V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetThreadPolicy, "(ZI)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetParallelPoolStats, "()[J"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetThreadTopology, "()[I"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetPipelinedProcessing, "(Z)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetPerformanceHints, "(ZF)Z"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetQualityGovernor, "(ZF)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetHalfRateProcessing, "(Z)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetCaptureCapacity, "(ZII)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetCaptureRecommendation, "()[I"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativePrepareFrameSize, "(II)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetScaledOutputs, "([I)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSubscribeFrames, "(Ljava/lang/String;)J"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeUnsubscribeFrames, "(J)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeTakeScaledLuma, "(JIILjava/nio/ByteBuffer;Z)J"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeStartEdgeEvents, "(I)J"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeStopEdgeEvents, "(J)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeTakeEdgeEvents, "(JLjava/nio/ByteBuffer;[IZ)I"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetQualityLevels, "([I)Z"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetQualityState, "()[I"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetLatencyBudget, "(I)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetDroppedFrameCount, "()J"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeCleanup, "()V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeTrimMemory, "(I)I"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetMemoryBudget, "(J)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetMemoryBudgetStats, "()[J"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetFrameListener, "(Ljava/lang/Runnable;)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetFrameSequence, "()J"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeCreatePipeline, "()J"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeDestroyPipeline, "(J)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetPipelineRenderMode, "(JI)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeProcessPipelineFrame, "(JLjava/nio/ByteBuffer;IIIJ)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetLumaStats, "(Z)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetLumaStats, "()[F"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetCaptureMetadata, "(JIIZ)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetCaptureMetadataPolicy, "(II)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetCaptureMetadataStats, "()[J"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetLumaHistogram, "([I)Z"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetDocumentCorners, "()[F"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetChamferParams, "(IIF)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetMultiscaleEdges, "(I)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetSegmentParams, "(FIF)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetMarkerParams, "(II)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetMarkers, "(Ljava/nio/ByteBuffer;)I"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetAssetManager, "(Landroid/content/res/AssetManager;)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeLoadFaceModel, "(Ljava/lang/String;)Z"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetFaceParams, "(IIFF)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetFaces, "()[F"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetMosaicParams, "(IIII)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeResetMosaic, "()V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetMosaicStats, "()[J"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetObjectTrackerModels,
+                                  "(Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetObjectTrackerParams, "(IIIZ)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSelectObject, "(FFFF)Z"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeStopObjectTracking, "()V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetTrackedObject, "()[F"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetObjectTrackerStats, "()[J"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetPeopleParams, "(IIIF)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetPeople, "()[F"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetPeopleStats, "()[J"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetTextRegionParams, "(IIIFI)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetTextRegions, "()[F"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetTextRegionStats, "()[J"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetOdometryParams, "(IIIIF)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetOdometryPose, "()[F"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetOdometryStats, "()[J"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetHeatmap, "(FF)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetFocusPeaking, "(FI)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetFreezeFrame, "(Z)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetFreezeFrameStats, "()[J"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetCodeParams, "(IIF)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetCodes, "([F)[Ljava/lang/String;"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetStabilizerParams, "(FF)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetDocumentRectification, "(ZII)Z"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetRectifiedDocument, "(Ljava/nio/ByteBuffer;)J"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeLoadLensCalibration, "(Ljava/lang/String;)Z"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeLoadStereoCalibration, "(Ljava/lang/String;)Z"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetStereoRightPipeline, "(J)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetStereoParams, "(IIII)Z"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetUndistortMode, "(I)Z"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetTemporalDenoise, "(ZFI)Z"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetClahe, "(ZFI)Z"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeAddChamferTemplate, "(ILjava/nio/ByteBuffer;III)Z"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeClearChamferTemplates, "()V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetChamferMatches, "()[F"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeCopyEdgeDistance, "(Ljava/nio/ByteBuffer;)I"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetFrameHistory, "(IZ)Z"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetFrameHistory, "(J)[J"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeCopyHistoryLuma, "(JILjava/nio/ByteBuffer;)J"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetStageMetrics, "(Z)[F"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetMemoryAccounting, "(Z)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetMemoryStats, "(Z)[J"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetFrameArenas, "(Z)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetFrameArenaStats, "()[J"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeReplayFrames, "(Ljava/lang/String;IIIII)[F"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeStartProfiling, "(I)Z"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeStopProfiling, "()Ljava/lang/String;"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetProfileReport, "()Ljava/lang/String;"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetKernelIsaLimit, "(I)I"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetFramePacing, "(Z)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetFramePacing, "(Z)[F"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetVsyncRendering, "(Z)Z"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetVsyncRenderStats, "()[F"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeStartSyntheticSource, "(IIFI)Z"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeWarmup, "(II)F"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeInit, "(II)F"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetStartupStats, "()[J"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeStopSyntheticSource, "()[F"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeProcessVideoFile, "(IJJJI)[F"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeDecodeVideoEdges, "(IJJIIIIZI)[I"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeCancelVideoDecode, "()V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetStageNames, "()[Ljava/lang/String;"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetPrewarmMode, "(I)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetModeResidency, "(III)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetLumaFastPath, "(Z)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetBandFusion, "(Z)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetHardwareBufferFrames, "(Z)Z"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetEdgeBackend, "(I)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeStartStallWatchdog, "(III)Z"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeStopStallWatchdog, "()V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetStallWatchdog, "()[J"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeLoadEdgeModel, "(Ljava/lang/String;Ljava/lang/String;IIZ)Z"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeLoadEdgeModelAccelerated,
+                                  "(Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;IIZ)I"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeIsOpenClAvailable, "()Z"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetProcessingRoi, "(IIII)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetRoiBackgroundDim, "(F)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetProcessingScale, "(I)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetControlBlock, "()Ljava/nio/ByteBuffer;"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetStatsBlock, "()Ljava/nio/ByteBuffer;"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetProcessingSize, "(II)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetAdaptiveThresholds, "(Z)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetEdgePreBlur, "(Z)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeStartEdgeStream, "(Ljava/lang/String;II)Z"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeStopEdgeStream, "()V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetEdgeStreamStats, "()[J"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeStartMetricsServer, "(I)Z"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeStopMetricsServer, "()V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetMetricsServerScrapes, "()J"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeStartBackendComparison, "(III)Z"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeStopBackendComparison, "()V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetBackendComparison, "()[F"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeStartEdgeArchive, "(Ljava/lang/String;II)Z"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeStopEdgeArchive, "()V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetEdgeArchiveStats, "()[J"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeReadArchivedEdges, "(Ljava/lang/String;ILjava/nio/ByteBuffer;)I"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeStartSharedEdgeOutput, "(III)I"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeStopSharedEdgeOutput, "()V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetPackedEdges, "(Z)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeCopyPackedEdges, "(Ljava/nio/ByteBuffer;)I"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeCopyFrameToBitmap, "(Landroid/graphics/Bitmap;IZ)J"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetEdgeRecords, "(I)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetEdgeRecords, "(Ljava/nio/ByteBuffer;[I)I"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetEdgePoints, "(I)Ljava/nio/ByteBuffer;"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetEdgePoints, "([I)I"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeCaptureSnapshot, "(Ljava/lang/String;I)Z"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSnapshotsWritten, "()J"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetEdgeMorphology, "(III)Z"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetEdgeComponents, "(IIZ)Z"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetEdgeComponents, "([I)[F"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetFilterGraph, "(Ljava/lang/String;)Z"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeLoadStagePlugins, "(Ljava/lang/String;)I"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetStagePlugins, "()[Ljava/lang/String;"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeDefineRenderEffect, "(Ljava/lang/String;Ljava/lang/String;)Z"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetRenderEffects, "([Ljava/lang/String;)Z"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetGapiPipeline, "(Z)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeBenchmarkGapiPipeline, "(III)[F"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetGapiStreaming, "(Z)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeGetGapiStreamingStats, "()[J"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetIncrementalEdges, "(Z)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetMotionParams, "(FII)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetLinePreset, "(I)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetFeatureParams, "(IIII)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetCannyBackend, "(I)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeAutotuneBackends, "(Ljava/lang/String;Ljava/lang/String;III)Ljava/lang/String;"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetExternalPreview, "(Z)V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeSetGpuYuvConversion, "(Z)V"),
+};
+
+static const JNINativeMethod kRenderModeMethods[] = {
+        EDGE_GL_RENDERER_METHOD(setRenderModeNative, "(I)V"),
+};
 
-    return frameToReturn;
-}
\ No newline at end of file
+int registerNativeLibMethods(JNIEnv* env) {
+    return registerNativeMethods(env, kNativeBridgeClass, kNativeBridgeMethods)
+            + registerNativeMethods(env, kGlRendererClass, kRenderModeMethods);
+}
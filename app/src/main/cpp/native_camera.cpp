@@ -0,0 +1,526 @@
+#include "native_camera.h"
+#include "app_startup.h"
+#include "jni_registry.h"
+#include "frame_ingest.h"
+#include "thread_policy.h"
+#include "capture_capacity.h"
+#include "capture_metadata.h"
+#include <android/hardware_buffer.h>
+#include <jni.h>
+#include <dlfcn.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+
+#define LOG_TAG "NativeCamera"
+#include "logging.h"
+
+// Number of AImages the reader may hand out at once; 2 keeps one image in
+// flight in the pipeline while the camera fills the next.
+static const int kMaxReaderImages = 2;
+
+// Longest the stream waits for a start-up still running (app_startup.h);
+// past it the first frames pay for what is left, as without nativeInit
+static const int64_t kStartupWaitMs = 2000;
+
+// AImageReader_newWithUsage and AImage_getHardwareBuffer are API 26
+struct HardwareBufferReaderApi {
+    media_status_t (*newWithUsage)(int32_t, int32_t, int32_t, uint64_t, int32_t, AImageReader**) = nullptr;
+    media_status_t (*getHardwareBuffer)(const AImage*, AHardwareBuffer**) = nullptr;
+
+    bool available() const { return newWithUsage && getHardwareBuffer; }
+};
+
+static const HardwareBufferReaderApi& hardwareBufferReaderApi() {
+    static const HardwareBufferReaderApi api = [] {
+        HardwareBufferReaderApi loaded;
+        void* lib = dlopen("libmediandk.so", RTLD_NOW);
+        if (lib) {
+            loaded.newWithUsage = reinterpret_cast<media_status_t (*)(int32_t, int32_t, int32_t, uint64_t, int32_t,
+                                                                      AImageReader**)>(
+                    dlsym(lib, "AImageReader_newWithUsage"));
+            loaded.getHardwareBuffer = reinterpret_cast<media_status_t (*)(const AImage*, AHardwareBuffer**)>(
+                    dlsym(lib, "AImage_getHardwareBuffer"));
+        }
+        return loaded;
+    }();
+    return api;
+}
+
+NativeCamera::~NativeCamera() {
+    stop();
+}
+
+bool NativeCamera::selectCamera(bool frontFacing, const char* id) {
+    ACameraIdList* idList = nullptr;
+    if (ACameraManager_getCameraIdList(manager, &idList) != ACAMERA_OK || !idList) {
+        LOGE("❌ Failed to list cameras");
+        return false;
+    }
+
+    bool found = false;
+    uint8_t wantedFacing = frontFacing ? ACAMERA_LENS_FACING_FRONT : ACAMERA_LENS_FACING_BACK;
+    for (int i = 0; i < idList->numCameras && !found; i++) {
+        ACameraMetadata* characteristics = nullptr;
+        if (ACameraManager_getCameraCharacteristics(manager, idList->cameraIds[i], &characteristics) != ACAMERA_OK) {
+            continue;
+        }
+
+        ACameraMetadata_const_entry facing{};
+        const bool wanted = (id && id[0])
+                ? std::strcmp(idList->cameraIds[i], id) == 0
+                : ACameraMetadata_getConstEntry(characteristics, ACAMERA_LENS_FACING, &facing) == ACAMERA_OK &&
+                  facing.data.u8[0] == wantedFacing;
+        if (wanted) {
+            ACameraMetadata_const_entry orientation{};
+            if (ACameraMetadata_getConstEntry(characteristics, ACAMERA_SENSOR_ORIENTATION, &orientation) == ACAMERA_OK) {
+                sensorOrientation = orientation.data.i32[0];
+            }
+            fpsRanges.clear();
+            ACameraMetadata_const_entry ranges{};
+            if (ACameraMetadata_getConstEntry(characteristics, ACAMERA_CONTROL_AE_AVAILABLE_TARGET_FPS_RANGES,
+                                              &ranges) == ACAMERA_OK) {
+                for (uint32_t r = 0; r + 1 < ranges.count; r += 2) {
+                    fpsRanges.emplace_back(ranges.data.i32[r], ranges.data.i32[r + 1]);
+                }
+            }
+            yuvSizes.clear();
+            ACameraMetadata_const_entry streams{};
+            if (ACameraMetadata_getConstEntry(characteristics, ACAMERA_SCALER_AVAILABLE_STREAM_CONFIGURATIONS,
+                                              &streams) == ACAMERA_OK) {
+                // (format, width, height, input) quadruples
+                for (uint32_t c = 0; c + 3 < streams.count; c += 4) {
+                    if (streams.data.i32[c] == AIMAGE_FORMAT_YUV_420_888 &&
+                        streams.data.i32[c + 3] == ACAMERA_SCALER_AVAILABLE_STREAM_CONFIGURATIONS_OUTPUT) {
+                        yuvSizes.emplace_back(streams.data.i32[c + 1], streams.data.i32[c + 2]);
+                    }
+                }
+            }
+            strncpy(cameraId, idList->cameraIds[i], sizeof(cameraId) - 1);
+            found = true;
+        }
+        ACameraMetadata_free(characteristics);
+    }
+
+    ACameraManager_deleteCameraIdList(idList);
+    return found;
+}
+
+bool NativeCamera::start(int width, int height, bool frontFacing, const char* id, PipelineContext* destination) {
+    std::lock_guard<std::mutex> lock(lifecycleMutex);
+    if (session) {
+        LOGI("Camera already running");
+        return true;
+    }
+
+    manager = ACameraManager_create();
+    if (!manager || !selectCamera(frontFacing, id)) {
+        LOGE("❌ No %s camera available", (id && id[0]) ? id : frontFacing ? "front" : "back");
+        releaseLocked();
+        return false;
+    }
+    pipeline = destination;
+
+    deviceCallbacks.context = this;
+    deviceCallbacks.onDisconnected = onDisconnected;
+    deviceCallbacks.onError = onError;
+    if (ACameraManager_openCamera(manager, cameraId, &deviceCallbacks, &device) != ACAMERA_OK) {
+        LOGE("❌ Failed to open camera %s", cameraId);
+        device = nullptr;
+        releaseLocked();
+        return false;
+    }
+    fpsRange[0] = fpsRange[1] = 0;
+    // The device opens while start-up finishes; frames flow only after it
+    appStartup().await(kStartupWaitMs);
+    if (!openStreamLocked(width, height)) {
+        releaseLocked();
+        return false;
+    }
+
+    LOGI("✅ Native camera %s started at %dx%d (sensor orientation %d°, hardware buffers %d)",
+         cameraId, width, height, sensorOrientation, hardwareBuffers);
+    if (!destination) {
+        controllerStop.store(false);
+        controller = std::thread(&NativeCamera::followCapacity, this);
+    }
+    return true;
+}
+
+// Reader, output and repeating request on the open device
+bool NativeCamera::openStreamLocked(int width, int height) {
+    // Buffers the GPU can sample as well as the CPU read, for the Vulkan backend
+    hardwareBuffers = ingestWantsHardwareBuffers() && hardwareBufferReaderApi().available();
+    const media_status_t created = hardwareBuffers
+            ? hardwareBufferReaderApi().newWithUsage(width, height, AIMAGE_FORMAT_YUV_420_888,
+                                                     AHARDWAREBUFFER_USAGE_CPU_READ_OFTEN |
+                                                     AHARDWAREBUFFER_USAGE_GPU_SAMPLED_IMAGE,
+                                                     kMaxReaderImages, &reader)
+            : AImageReader_new(width, height, AIMAGE_FORMAT_YUV_420_888, kMaxReaderImages, &reader);
+    if (created != AMEDIA_OK) {
+        LOGE("❌ AImageReader_new failed for %dx%d", width, height);
+        reader = nullptr;
+        return false;
+    }
+    imageListener.context = this;
+    imageListener.onImageAvailable = onImageAvailable;
+    AImageReader_setImageListener(reader, &imageListener);
+    AImageReader_getWindow(reader, &readerWindow);
+
+    ACaptureSessionOutputContainer_create(&outputs);
+    ACaptureSessionOutput_create(readerWindow, &output);
+    ACaptureSessionOutputContainer_add(outputs, output);
+    ACameraOutputTarget_create(readerWindow, &target);
+    ACameraDevice_createCaptureRequest(device, TEMPLATE_PREVIEW, &request);
+    ACaptureRequest_addTarget(request, target);
+
+    sessionCallbacks.context = this;
+    sessionCallbacks.onClosed = onSessionClosed;
+    sessionCallbacks.onReady = onSessionReady;
+    sessionCallbacks.onActive = onSessionActive;
+    if (ACameraDevice_createCaptureSession(device, outputs, &sessionCallbacks, &session) != ACAMERA_OK) {
+        LOGE("❌ Failed to create capture session");
+        session = nullptr;
+        return false;
+    }
+    streamWidth = width;
+    streamHeight = height;
+    return applyFpsRangeLocked();
+}
+
+// (Re)issues the repeating request, with the AE range when one was set
+bool NativeCamera::applyFpsRangeLocked() {
+    if (fpsRange[1] > 0) {
+        ACaptureRequest_setEntry_i32(request, ACAMERA_CONTROL_AE_TARGET_FPS_RANGE, 2, fpsRange);
+    }
+    // Only the default pipeline's frames are gated by their capture state
+    captureCallbacks.context = this;
+    captureCallbacks.onCaptureCompleted = onCaptureCompleted;
+    if (ACameraCaptureSession_setRepeatingRequest(session, pipeline ? nullptr : &captureCallbacks, 1, &request,
+                                                  nullptr) != ACAMERA_OK) {
+        LOGE("❌ Failed to start repeating request");
+        return false;
+    }
+    return true;
+}
+
+void NativeCamera::closeStreamLocked() {
+    if (session) {
+        ACameraCaptureSession_stopRepeating(session);
+        ACameraCaptureSession_close(session);
+        session = nullptr;
+    }
+    if (request) {
+        ACaptureRequest_free(request);
+        request = nullptr;
+    }
+    if (target) {
+        ACameraOutputTarget_free(target);
+        target = nullptr;
+    }
+    if (outputs) {
+        ACaptureSessionOutputContainer_free(outputs);
+        outputs = nullptr;
+    }
+    if (output) {
+        ACaptureSessionOutput_free(output);
+        output = nullptr;
+    }
+    if (reader) {
+        // The reader owns its window; deleting it also stops further callbacks
+        AImageReader_delete(reader);
+        reader = nullptr;
+        readerWindow = nullptr;
+    }
+}
+
+bool NativeCamera::setFpsRange(int minFps, int maxFps) {
+    std::lock_guard<std::mutex> lock(lifecycleMutex);
+    if (!session) {
+        return false;
+    }
+    // Highest supported maximum not above maxFps, the narrowest such range
+    // (a fixed range keeps AE from capturing faster); the slowest otherwise
+    int best = -1;
+    for (size_t i = 0; i < fpsRanges.size(); i++) {
+        const std::pair<int, int>& range = fpsRanges[i];
+        if (range.second > maxFps || range.first > range.second) {
+            continue;
+        }
+        if (best < 0 || range.second > fpsRanges[best].second ||
+            (range.second == fpsRanges[best].second && range.first > fpsRanges[best].first)) {
+            best = static_cast<int>(i);
+        }
+    }
+    if (best < 0) {
+        for (size_t i = 0; i < fpsRanges.size(); i++) {
+            if (best < 0 || fpsRanges[i].second < fpsRanges[best].second) {
+                best = static_cast<int>(i);
+            }
+        }
+    }
+    const int range[2] = {best >= 0 ? fpsRanges[best].first : minFps, best >= 0 ? fpsRanges[best].second : maxFps};
+    if (range[0] == fpsRange[0] && range[1] == fpsRange[1]) {
+        return true;
+    }
+    fpsRange[0] = range[0];
+    fpsRange[1] = range[1];
+    LOGI("🔄 Camera %s AE target range %d-%d fps", cameraId, fpsRange[0], fpsRange[1]);
+    return applyFpsRangeLocked();
+}
+
+bool NativeCamera::resizeStream(int width, int height) {
+    std::lock_guard<std::mutex> lock(lifecycleMutex);
+    if (!session || width <= 0 || height <= 0) {
+        return false;
+    }
+    // Largest supported size within width x height, the current aspect first
+    const int64_t aspect = static_cast<int64_t>(streamWidth) * 1000 / std::max(1, streamHeight);
+    std::pair<int, int> chosen(0, 0);
+    bool chosenAspect = false;
+    for (const std::pair<int, int>& size : yuvSizes) {
+        if (size.first > width || size.second > height) {
+            continue;
+        }
+        const bool sameAspect = std::llabs(static_cast<int64_t>(size.first) * 1000 / size.second - aspect) <= 10;
+        const bool larger = static_cast<int64_t>(size.first) * size.second >
+                            static_cast<int64_t>(chosen.first) * chosen.second;
+        if ((sameAspect && !chosenAspect) || (sameAspect == chosenAspect && larger)) {
+            chosen = size;
+            chosenAspect = sameAspect;
+        }
+    }
+    if (chosen.first == 0) {
+        chosen = std::make_pair(width, height);  // no size list: ask for it as is
+    }
+    if (chosen.first == streamWidth && chosen.second == streamHeight) {
+        return true;
+    }
+    const int previousWidth = streamWidth;
+    const int previousHeight = streamHeight;
+    // Buffers and textures of the new size while the old stream still runs;
+    // the old size's go once its last frames are replaced
+    prepareIngestSize(pipeline, chosen.first, chosen.second);
+    closeStreamLocked();
+    if (!openStreamLocked(chosen.first, chosen.second)) {
+        LOGE("❌ Camera %s could not move to %dx%d; back to %dx%d", cameraId, chosen.first, chosen.second,
+             previousWidth, previousHeight);
+        closeStreamLocked();
+        return openStreamLocked(previousWidth, previousHeight);
+    }
+    LOGI("🔄 Camera %s stream resized %dx%d -> %dx%d", cameraId, previousWidth, previousHeight, chosen.first,
+         chosen.second);
+    return true;
+}
+
+void NativeCamera::followCapacity() {
+    setThreadTier(ThreadTier::ANALYTICS);  // reconfiguring is never urgent
+    uint32_t seen = captureCapacity().recommendation().generation;
+    while (!controllerStop.load()) {
+        CaptureRecommendation next;
+        if (!captureCapacity().waitForChange(seen, std::chrono::milliseconds(250), next)) {
+            continue;
+        }
+        seen = next.generation;
+        if (!captureCapacity().enabled() || next.maxFps <= 0) {
+            continue;
+        }
+        if (next.width > 0 && next.height > 0) {
+            resizeStream(next.width, next.height);
+        }
+        setFpsRange(next.minFps, next.maxFps);
+    }
+}
+
+void NativeCamera::stop() {
+    // Outside the lifecycle lock, which the controller takes to reconfigure
+    if (controller.joinable()) {
+        controllerStop.store(true);
+        controller.join();
+    }
+    std::lock_guard<std::mutex> lock(lifecycleMutex);
+    releaseLocked();
+}
+
+void NativeCamera::releaseLocked() {
+    closeStreamLocked();
+    if (device) {
+        ACameraDevice_close(device);
+        device = nullptr;
+    }
+    if (manager) {
+        ACameraManager_delete(manager);
+        manager = nullptr;
+    }
+    streamWidth = streamHeight = 0;
+}
+
+void NativeCamera::handleImage(AImage* image) {
+    int32_t planeCount = 0;
+    AImage_getNumberOfPlanes(image, &planeCount);
+    if (planeCount < 3) {
+        LOGE_RATELIMITED("❌ Unexpected plane count: %d", planeCount);
+        return;
+    }
+
+    YuvPlanes planes;
+    AImage_getWidth(image, &planes.width);
+    AImage_getHeight(image, &planes.height);
+
+    uint8_t* data[3] = {nullptr, nullptr, nullptr};
+    int length = 0;
+    for (int i = 0; i < 3; i++) {
+        AImage_getPlaneData(image, i, &data[i], &length);
+    }
+    planes.y = data[0];
+    planes.u = data[1];
+    planes.v = data[2];
+    AImage_getPlaneRowStride(image, 0, &planes.yRowStride);
+    AImage_getPlaneRowStride(image, 1, &planes.uvRowStride);
+    AImage_getPlanePixelStride(image, 1, &planes.uvPixelStride);
+    AImage_getTimestamp(image, &planes.timestampNs);
+    if (hardwareBuffers && hardwareBufferReaderApi().getHardwareBuffer(image, &planes.hardwareBuffer) != AMEDIA_OK) {
+        planes.hardwareBuffer = nullptr;
+    }
+
+    processYuvPlanes(planes, sensorOrientation, pipeline);
+}
+
+void NativeCamera::onImageAvailable(void* context, AImageReader* reader) {
+    setThreadTier(ThreadTier::INGEST);  // the image reader's callback thread
+    ForegroundWork foreground;
+    auto* camera = static_cast<NativeCamera*>(context);
+    AImage* image = nullptr;
+    if (AImageReader_acquireLatestImage(reader, &image) != AMEDIA_OK || !image) {
+        return;
+    }
+    camera->handleImage(image);
+    AImage_delete(image);
+}
+
+void NativeCamera::onCaptureCompleted(void* context, ACameraCaptureSession* session, ACaptureRequest* request,
+                                      const ACameraMetadata* result) {
+    CaptureMetadata metadata;
+    ACameraMetadata_const_entry entry;
+    if (ACameraMetadata_getConstEntry(result, ACAMERA_SENSOR_TIMESTAMP, &entry) != ACAMERA_OK || entry.count == 0) {
+        return;
+    }
+    metadata.timestampNs = entry.data.i64[0];
+    if (ACameraMetadata_getConstEntry(result, ACAMERA_CONTROL_AF_STATE, &entry) == ACAMERA_OK && entry.count > 0) {
+        metadata.afState = entry.data.u8[0];
+    }
+    if (ACameraMetadata_getConstEntry(result, ACAMERA_CONTROL_AE_STATE, &entry) == ACAMERA_OK && entry.count > 0) {
+        metadata.aeState = entry.data.u8[0];
+    }
+    if (ACameraMetadata_getConstEntry(result, ACAMERA_LENS_STATE, &entry) == ACAMERA_OK && entry.count > 0) {
+        metadata.lensMoving = entry.data.u8[0] == ACAMERA_LENS_STATE_MOVING;
+    }
+    captureMetadataGate().note(metadata);
+}
+
+void NativeCamera::onDisconnected(void* context, ACameraDevice* device) {
+    LOGE("❌ Camera disconnected");
+}
+
+void NativeCamera::onError(void* context, ACameraDevice* device, int error) {
+    LOGE("❌ Camera error: %d", error);
+}
+
+void NativeCamera::onSessionClosed(void* context, ACameraCaptureSession* session) {
+    LOGI("Capture session closed");
+}
+
+void NativeCamera::onSessionReady(void* context, ACameraCaptureSession* session) {
+    LOGI("Capture session ready");
+}
+
+void NativeCamera::onSessionActive(void* context, ACameraCaptureSession* session) {
+    LOGI("Capture session active");
+}
+
+// JNI exports
+static NativeCamera nativeCamera;
+
+// Extra streams, one camera per pipeline handle (nativeStartCameraStream)
+static std::mutex streamsMutex;
+static std::map<jlong, std::unique_ptr<NativeCamera>> cameraStreams;
+
+extern "C" {
+
+JNIEXPORT jboolean JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeStartCamera(JNIEnv*, jclass, jint width, jint height,
+                                                                  jboolean frontFacing) {
+    return nativeCamera.start(width, height, frontFacing == JNI_TRUE) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeStopCamera(JNIEnv*, jclass) {
+    nativeCamera.stop();
+    LOGI("✅ Native camera stopped");
+}
+
+// A camera feeding a pipeline from nativeCreatePipeline, alongside the main
+// one (front + back, or two physical cameras by id; null id = by facing).
+// Start the pipeline's worker first so the image callbacks only copy.
+// Whether two cameras can stream at once is up to the device.
+JNIEXPORT jboolean JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeStartCameraStream(JNIEnv* env, jclass, jlong pipeline,
+                                                                        jstring cameraId, jint width, jint height,
+                                                                        jboolean frontFacing) {
+    if (!pipeline) {
+        LOGE("❌ nativeStartCameraStream: the default pipeline uses nativeStartCamera");
+        return JNI_FALSE;
+    }
+    std::string id;
+    if (cameraId) {
+        const char* chars = env->GetStringUTFChars(cameraId, nullptr);
+        if (chars) {
+            id = chars;
+            env->ReleaseStringUTFChars(cameraId, chars);
+        }
+    }
+    std::lock_guard<std::mutex> lock(streamsMutex);
+    std::unique_ptr<NativeCamera>& camera = cameraStreams[pipeline];
+    if (!camera) {
+        camera.reset(new NativeCamera());
+    }
+    const bool started = camera->start(width, height, frontFacing == JNI_TRUE, id.c_str(),
+                                       reinterpret_cast<PipelineContext*>(pipeline));
+    if (!started) {
+        cameraStreams.erase(pipeline);
+    }
+    return started ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT void JNICALL
+Java_com_example_edge_nativebridge_NativeBridge_nativeStopCameraStream(JNIEnv*, jclass, jlong pipeline) {
+    std::unique_ptr<NativeCamera> camera;
+    {
+        std::lock_guard<std::mutex> lock(streamsMutex);
+        auto it = cameraStreams.find(pipeline);
+        if (it == cameraStreams.end()) {
+            return;
+        }
+        camera = std::move(it->second);
+        cameraStreams.erase(it);
+    }
+    camera->stop();
+    LOGI("✅ Camera stream stopped");
+}
+
+}
+
+// RegisterNatives table (jni_registry.h)
+static const JNINativeMethod kCameraMethods[] = {
+        EDGE_NATIVE_BRIDGE_METHOD(nativeStartCamera, "(IIZ)Z"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeStopCamera, "()V"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeStartCameraStream, "(JLjava/lang/String;IIZ)Z"),
+        EDGE_NATIVE_BRIDGE_METHOD(nativeStopCameraStream, "(J)V"),
+};
+
+int registerNativeCameraMethods(JNIEnv* env) {
+    return registerNativeMethods(env, kNativeBridgeClass, kCameraMethods);
+}
@@ -0,0 +1,92 @@
+#ifndef EDGE_NATIVE_CAMERA_H
+#define EDGE_NATIVE_CAMERA_H
+
+#include <camera/NdkCameraManager.h>
+#include <media/NdkImageReader.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+struct PipelineContext;
+
+// Camera capture owned entirely by native code: ACameraManager drives an
+// AImageReader whose YUV_420_888 planes are fed straight into processYuvPlanes,
+// bypassing Java frame delivery and the NV21 repack.
+class NativeCamera {
+public:
+    NativeCamera() = default;
+    ~NativeCamera();
+
+    // Opens the first camera with the requested facing (or the one named by
+    // id, e.g. one physical camera of a stereo rig) and starts a repeating
+    // preview request at the given size, feeding pipeline (null = the
+    // default one). Returns false if any step fails.
+    bool start(int width, int height, bool frontFacing, const char* id = nullptr,
+               PipelineContext* pipeline = nullptr);
+    void stop();
+
+    bool isRunning() const { return session != nullptr; }
+
+    // AE target fps range of the running stream (the supported range closest
+    // below maxFps), applied to the repeating request in place
+    bool setFpsRange(int minFps, int maxFps);
+
+    // Moves the running stream to the supported YUV size closest below
+    // width x height (aspect of the current one preferred): a new reader and
+    // session on the open device, the pipeline untouched; its buffers for the
+    // new size are allocated first (prepareIngestSize).
+    bool resizeStream(int width, int height);
+
+private:
+    static void onImageAvailable(void* context, AImageReader* reader);
+    static void onDisconnected(void* context, ACameraDevice* device);
+    static void onError(void* context, ACameraDevice* device, int error);
+    static void onSessionClosed(void* context, ACameraCaptureSession* session);
+    static void onSessionReady(void* context, ACameraCaptureSession* session);
+    static void onSessionActive(void* context, ACameraCaptureSession* session);
+    static void onCaptureCompleted(void* context, ACameraCaptureSession* session, ACaptureRequest* request,
+                                   const ACameraMetadata* result);
+
+    bool selectCamera(bool frontFacing, const char* id);
+    bool openStreamLocked(int width, int height);
+    void closeStreamLocked();
+    bool applyFpsRangeLocked();
+    void releaseLocked();
+    void followCapacity();  // controller thread (capture_capacity.h)
+    void handleImage(AImage* image);
+
+    ACameraManager* manager = nullptr;
+    ACameraDevice* device = nullptr;
+    AImageReader* reader = nullptr;
+    ANativeWindow* readerWindow = nullptr;
+    ACaptureSessionOutputContainer* outputs = nullptr;
+    ACaptureSessionOutput* output = nullptr;
+    ACameraOutputTarget* target = nullptr;
+    ACaptureRequest* request = nullptr;
+    ACameraCaptureSession* session = nullptr;
+
+    ACameraDevice_StateCallbacks deviceCallbacks{};
+    ACameraCaptureSession_stateCallbacks sessionCallbacks{};
+    ACameraCaptureSession_captureCallbacks captureCallbacks{};  // the default pipeline's focus and exposure state
+    AImageReader_ImageListener imageListener{};
+
+    char cameraId[32] = {0};
+    int sensorOrientation = 0;
+    std::vector<std::pair<int, int>> fpsRanges;   // ACAMERA_CONTROL_AE_AVAILABLE_TARGET_FPS_RANGES
+    std::vector<std::pair<int, int>> yuvSizes;    // YUV_420_888 output sizes
+    int streamWidth = 0;
+    int streamHeight = 0;
+    int fpsRange[2] = {0, 0};                     // applied AE range; 0 = the template's
+    bool hardwareBuffers = false;  // the reader's images carry GPU-sampleable AHardwareBuffers
+    PipelineContext* pipeline = nullptr;
+    std::mutex lifecycleMutex;
+
+    // The default camera follows captureCapacity() from its own thread: a
+    // resize deletes the reader, which must not happen on its callback thread
+    std::thread controller;
+    std::atomic<bool> controllerStop{false};
+};
+
+#endif // EDGE_NATIVE_CAMERA_H
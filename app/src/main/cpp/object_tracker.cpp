@@ -0,0 +1,185 @@
+#include "object_tracker.h"
+#include "mapped_asset.h"
+#include "metrics.h"
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+
+#define LOG_TAG "ObjectTracker"
+#include "logging.h"
+
+namespace {
+
+const int kMaxSkipFrames = 4;   // the box is held at most this long after a slow update
+const int kMinSide = 4;         // reduced-frame pixels a selection needs
+
+const char* kindName(ObjectTracker::Kind kind) {
+    switch (kind) {
+        case ObjectTracker::NANO: return "NanoTrack";
+        case ObjectTracker::VIT: return "VitTrack";
+        default: return "MIL";
+    }
+}
+
+}  // namespace
+
+void ObjectTracker::setParams(const Params& params) {
+    std::lock_guard<std::mutex> lock(mutex);
+    current = params;
+    current.inputWidth = std::min(std::max(params.inputWidth, 64), 1280);
+    current.budgetMicros = std::max<int64_t>(params.budgetMicros, 500);
+}
+
+void ObjectTracker::setModels(const std::string& nanoBackbone, const std::string& nanoNeckhead,
+                              const std::string& vitNet) {
+    std::lock_guard<std::mutex> lock(mutex);
+    backbone = nanoBackbone;
+    neckhead = nanoNeckhead;
+    vit = vitNet;
+}
+
+bool ObjectTracker::select(const cv::Rect2f& selection) {
+    Params params;
+    std::string backbonePath;
+    std::string neckheadPath;
+    std::string vitPath;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        params = current;
+        backbonePath = backbone;
+        neckheadPath = neckhead;
+        vitPath = vit;
+    }
+    const std::string& model = params.kind == VIT ? vitPath : params.kind == NANO ? backbonePath : std::string();
+    if (isAssetPath(model) || isAssetPath(params.kind == NANO ? neckheadPath : std::string())) {
+        LOGE("❌ %s reads its models by path; extract them from the APK first", kindName(params.kind));
+        return false;
+    }
+    cv::Ptr<cv::Tracker> created;
+    try {
+        if (params.kind == NANO) {
+            cv::TrackerNano::Params nano;
+            nano.backbone = backbonePath;
+            nano.neckhead = neckheadPath;
+            created = cv::TrackerNano::create(nano);
+        } else if (params.kind == VIT) {
+            cv::TrackerVit::Params vitParams;
+            vitParams.net = vitPath;
+            created = cv::TrackerVit::create(vitParams);
+        } else {
+            created = cv::TrackerMIL::create();
+        }
+    } catch (const cv::Exception& e) {
+        LOGE("❌ %s tracker failed to load: %s", kindName(params.kind), e.what());
+        return false;
+    }
+    if (!created) {
+        LOGE("❌ %s tracker failed to load", kindName(params.kind));
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    pending = created;
+    pendingBox = selection & cv::Rect2f(0.0f, 0.0f, 1.0f, 1.0f);
+    pendingKind = params.kind;
+    hasPending = true;
+    stopped = false;
+    LOGI("✅ %s tracking %.2f,%.2f %.2fx%.2f", kindName(params.kind), pendingBox.x, pendingBox.y,
+         pendingBox.width, pendingBox.height);
+    return true;
+}
+
+void ObjectTracker::stop() {
+    std::lock_guard<std::mutex> lock(mutex);
+    pending.release();
+    hasPending = false;
+    stopped = true;
+}
+
+bool ObjectTracker::update(const cv::Mat& frame, cv::Rect2f& found) {
+    cv::Ptr<cv::Tracker> next;
+    Params params;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopped) {
+            tracker.release();
+            stopped = false;
+        }
+        if (hasPending) {
+            next = pending;
+            pending.release();
+            hasPending = false;
+            box = pendingBox;
+            trackerKind = pendingKind;
+        }
+        params = current;
+    }
+    if ((!next && !tracker) || frame.empty()) {
+        return false;
+    }
+    if (!next && skipFrames > 0) {
+        // Paying off the last update's overrun
+        skipFrames--;
+        skipped.fetch_add(1, std::memory_order_relaxed);
+        found = box;
+        return true;
+    }
+
+    ScopedStageTimer timer(Stage::OBJECT_TRACK);
+    const int64_t start = monotonicMicros();
+    // A tracker keeps the scale it was initialized at
+    const int width = std::min(next ? params.inputWidth : trackerWidth, frame.cols);
+    const cv::Size size(width, std::max(1, frame.rows * width / frame.cols));
+    cv::resize(frame, reduced, size, 0, 0, cv::INTER_AREA);
+    // MIL reads one channel; the networks take three
+    const int channels = trackerKind == MIL ? 1 : 3;
+    if (reduced.channels() == channels) {
+        converted = reduced;
+    } else if (channels == 1) {
+        cv::cvtColor(reduced, converted, reduced.channels() == 4 ? cv::COLOR_RGBA2GRAY : cv::COLOR_BGR2GRAY);
+    } else {
+        cv::cvtColor(reduced, converted, reduced.channels() == 4 ? cv::COLOR_RGBA2BGR : cv::COLOR_GRAY2BGR);
+    }
+
+    try {
+        if (next) {
+            const cv::Rect selection(cvRound(box.x * size.width), cvRound(box.y * size.height),
+                                     cvRound(box.width * size.width), cvRound(box.height * size.height));
+            if (selection.width < kMinSide || selection.height < kMinSide) {
+                LOGW("⚠️ Selection %dx%d too small to track", selection.width, selection.height);
+                tracker.release();
+                return false;
+            }
+            next->init(converted, selection);
+            tracker = next;
+            trackerWidth = width;
+            skipFrames = 0;
+            found = box;
+            return true;
+        }
+        cv::Rect result;
+        if (!tracker->update(converted, result) || result.width <= 0 || result.height <= 0) {
+            lost.fetch_add(1, std::memory_order_relaxed);
+            tracker.release();
+            LOGI("🔄 %s lost the object", kindName(trackerKind));
+            return false;
+        }
+        box = cv::Rect2f(static_cast<float>(result.x) / size.width, static_cast<float>(result.y) / size.height,
+                         static_cast<float>(result.width) / size.width,
+                         static_cast<float>(result.height) / size.height) &
+              cv::Rect2f(0.0f, 0.0f, 1.0f, 1.0f);
+    } catch (const cv::Exception& e) {
+        LOGE_RATELIMITED("❌ %s tracking failed: %s", kindName(trackerKind), e.what());
+        lost.fetch_add(1, std::memory_order_relaxed);
+        tracker.release();
+        return false;
+    }
+    updates.fetch_add(1, std::memory_order_relaxed);
+    const int64_t elapsed = monotonicMicros() - start;
+    skipFrames = static_cast<int>(std::min<int64_t>(elapsed / params.budgetMicros, kMaxSkipFrames));
+    found = box;
+    return true;
+}
+
+ObjectTracker& objectTracker() {
+    static ObjectTracker tracker;
+    return tracker;
+}
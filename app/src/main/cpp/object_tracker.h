@@ -0,0 +1,87 @@
+#ifndef EDGE_OBJECT_TRACKER_H
+#define EDGE_OBJECT_TRACKER_H
+
+#include <opencv2/core.hpp>
+#include <opencv2/video/tracking.hpp>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+// One object the user selected, followed by a video-module tracker on a
+// reduced copy of the frame: TrackerMIL (no model), or NanoTrack / VitTrack
+// (TrackerNano, TrackerVit) with their small ONNX models. select() creates
+// the tracker on the calling thread, so a model load never stalls the
+// processing thread; the next update() initializes it on that frame.
+// Following an object is a fraction of what detecting it every frame costs,
+// and the cost is held to a budget: an update that runs over it makes the
+// tracker skip as many frames as it overran by, holding the box meanwhile,
+// so its average cost per frame stays within the budget on slow devices.
+class ObjectTracker {
+public:
+    enum Kind {
+        MIL = 0,    // online boosting on Haar features, CPU only
+        NANO = 1,   // NanoTrack: backbone + neck/head networks (~1.9 MB)
+        VIT = 2,    // VitTrack: one transformer network (~0.7 MB)
+    };
+
+    struct Params {
+        Kind kind = MIL;
+        int inputWidth = 320;         // reduced frame width the tracker sees
+        int64_t budgetMicros = 8000;  // per processed frame, on average
+    };
+
+    void setParams(const Params& params);
+
+    // NanoTrack's backbone and neck/head, and VitTrack's network; plain
+    // files, since the trackers read their models by path (not APK assets)
+    void setModels(const std::string& nanoBackbone, const std::string& nanoNeckhead, const std::string& vitNet);
+
+    // Any thread: starts following box (0..1 units of the frames update()
+    // receives) from the next frame, replacing any object followed so far.
+    // Creates the tracker, loading its networks for NANO and VIT, so call it
+    // off the UI thread; false when the tracker cannot be created.
+    bool select(const cv::Rect2f& box);
+
+    // Stops following the object
+    void stop();
+
+    // Processing thread, once per frame of the mode: frame is CV_8UC1,
+    // CV_8UC3 or CV_8UC4 (any channel order). box receives the object in
+    // 0..1 frame units; false when nothing is followed or the object was lost.
+    bool update(const cv::Mat& frame, cv::Rect2f& box);
+
+    uint64_t updateCount() const { return updates.load(std::memory_order_relaxed); }
+    uint64_t skippedCount() const { return skipped.load(std::memory_order_relaxed); }
+    uint64_t lostCount() const { return lost.load(std::memory_order_relaxed); }
+
+private:
+    std::mutex mutex;
+    Params current;
+    std::string backbone;
+    std::string neckhead;
+    std::string vit;
+    cv::Ptr<cv::Tracker> pending;   // created by select(), initialized by the next update()
+    cv::Rect2f pendingBox;
+    Kind pendingKind = MIL;
+    bool hasPending = false;
+    bool stopped = false;
+
+    // Processing thread
+    cv::Ptr<cv::Tracker> tracker;
+    Kind trackerKind = MIL;
+    int trackerWidth = 0;           // inputWidth the tracker was initialized at
+    cv::Rect2f box;                 // 0..1 frame units
+    int skipFrames = 0;
+    cv::Mat reduced;
+    cv::Mat converted;
+
+    std::atomic<uint64_t> updates{0};
+    std::atomic<uint64_t> skipped{0};
+    std::atomic<uint64_t> lost{0};
+};
+
+// Tracker used by the TRACK_OBJECT render mode
+ObjectTracker& objectTracker();
+
+#endif // EDGE_OBJECT_TRACKER_H
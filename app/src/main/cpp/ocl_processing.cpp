@@ -0,0 +1,76 @@
+#include "ocl_processing.h"
+#include "image_processor.h"
+#include <opencv2/imgproc.hpp>
+#include <opencv2/core/ocl.hpp>
+#include <mutex>
+
+#define LOG_TAG "OclProcessing"
+#include "logging.h"
+
+namespace {
+
+std::once_flag probeOnce;
+bool openclAvailable = false;
+
+void probeOpenCL() {
+    try {
+        if (!cv::ocl::haveOpenCL()) {
+            LOGW("OpenCL runtime not available, T-API path stays on the CPU");
+            return;
+        }
+        cv::ocl::setUseOpenCL(true);
+        // Creates the default context on first use
+        const cv::ocl::Device& device = cv::ocl::Device::getDefault();
+        if (!cv::ocl::useOpenCL() || !device.available()) {
+            LOGW("OpenCL present but unusable, T-API path stays on the CPU");
+            return;
+        }
+        LOGI("OpenCL device: %s (%s), %s, driver %s", device.name().c_str(), device.vendorName().c_str(),
+             device.OpenCLVersion().c_str(), device.driverVersion().c_str());
+        openclAvailable = true;
+    } catch (const cv::Exception& e) {
+        LOGE("❌ OpenCL initialization failed: %s", e.what());
+        cv::ocl::setUseOpenCL(false);
+    }
+}
+
+} // namespace
+
+bool initOpenCLProcessing() {
+    std::call_once(probeOnce, probeOpenCL);
+    return openclAvailable;
+}
+
+bool grayscaleOcl(const cv::Mat& bgr, cv::Mat& gray) {
+    if (!initOpenCLProcessing()) {
+        return false;
+    }
+    try {
+        // Views are released before returning, which syncs gray back
+        cv::UMat source = bgr.getUMat(cv::ACCESS_READ);
+        cv::UMat target = gray.getUMat(cv::ACCESS_WRITE);
+        cv::cvtColor(source, target, cv::COLOR_BGR2GRAY);
+    } catch (const cv::Exception& e) {
+        LOGE_RATELIMITED("❌ OpenCL cvtColor failed: %s", e.what());
+        return false;
+    }
+    return true;
+}
+
+bool detectEdgesOcl(const cv::Mat& gray, cv::Mat& edges) {
+    if (!initOpenCLProcessing()) {
+        return false;
+    }
+    int low, high;
+    currentCannyThresholds(low, high);
+    try {
+        cv::UMat source = gray.getUMat(cv::ACCESS_READ);
+        cv::UMat target = edges.getUMat(cv::ACCESS_WRITE);
+        cv::Canny(source, target, low, high);
+    } catch (const cv::Exception& e) {
+        LOGE_RATELIMITED("❌ OpenCL Canny failed: %s", e.what());
+        return false;
+    }
+    updateEdgeThresholds(gray);
+    return true;
+}
@@ -0,0 +1,22 @@
+#ifndef EDGE_OCL_PROCESSING_H
+#define EDGE_OCL_PROCESSING_H
+
+#include <opencv2/core.hpp>
+
+// Transparent API (cv::UMat) variants of the pipeline's grayscale and Canny
+// steps. OpenCV loads the OpenCL runtime itself, so nothing links against it;
+// on devices without one every call returns false and callers keep the CPU
+// path. Outputs are written through UMat views of the caller's (pooled) Mats,
+// which on unified-memory GPUs such as Adreno map instead of copying.
+
+// Probes OpenCL once (later calls return the cached answer) and logs the
+// device, like initCL() in the SDK's tutorial-4-opencl sample
+bool initOpenCLProcessing();
+
+// BGR -> gray; gray must already have the input's size and CV_8UC1
+bool grayscaleOcl(const cv::Mat& bgr, cv::Mat& gray);
+
+// Canny with detectEdges' thresholds; edges must already be gray-sized CV_8UC1
+bool detectEdgesOcl(const cv::Mat& gray, cv::Mat& edges);
+
+#endif // EDGE_OCL_PROCESSING_H
@@ -1,25 +1,427 @@
 #include "opengl_renderer.h"
+#include "jni_registry.h"
+#include "metrics.h"
+#include "render_frame.h"
+#include "pbo_uploader.h"
+#include "gpu_readback.h"
+#include "gpu_timer.h"
+#include "frame_pacing.h"
+#include "render_scheduler.h"
+#include "cpu_profiler.h"
+#include "memory_accounting.h"
+#include "image_processor.h"
+#include "shader_registry.h"
+#include "cl_gl_interop.h"
+#include "performance_hint.h"
+#include "video_recorder.h"
+#include "display_mirror.h"
+#include "packed_edges.h"
+#include "lens_undistortion.h"
+#include "tracing.h"
+#include "thread_policy.h"
+#include "control_block.h"
+#include "render_effects.h"
+#include "split_balancer.h"
+#include "mosaic_builder.h"
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
 #include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+#include <GLES3/gl31.h>
+#include <cstring>
+#include <dlfcn.h>
+#include <jni.h>
+#include <android/native_window_jni.h>
+#include <unistd.h>
 #include <opencv2/opencv.hpp>
-#include <android/log.h>
-#include <vector>
+#include <utility>
 #include <atomic>
 #include <algorithm>
+#include <cstdio>
 
 #define LOG_TAG "OpenGLRenderer"
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#include "logging.h"
+
+// A texture whose storage follows the size of the frames uploaded into it
+struct FrameTexture {
+    GLuint id = 0;
+    GLenum format = GL_RGBA;
+    int width = 0;
+    int height = 0;
+    uint64_t edgeResult = 0;  // incremental Canny result the pixels are (RenderFrame::edgeResult); 0 = other
+};
+
+// A registry program and its cached uniform locations (-1 where unused)
+struct ShaderProgram {
+    bool resolved = false;
+    GLuint id = 0;
+    GLint samplerLoc = -1;
+    GLint chromaLoc = -1;        // YUV program only
+    GLint singleChannelLoc = -1; // RGB program only
+    GLint texMatrixLoc = -1;     // external OES program only
+    GLint texelSizeLoc = -1;     // edge passes only
+    GLint tintLoc = -1;          // overlay programs only
+    GLint overlayLoc = -1;       // fused overlay programs only
+    GLint bitsSizeLoc = -1;      // packed edge program only
+    GLint rowBytesLoc = -1;
+    GLint scaleLoc = -1;
+    GLint originLoc = -1;        // marker program only
+    GLint axisULoc = -1;
+    GLint axisVLoc = -1;
+    GLint pointSizeLoc = -1;
+    GLint roundLoc = -1;
+    GLint mapLoc = -1;           // undistortion program only
+    GLint weightLoc = -1;        // heatmap programs only
+    GLint gainLoc = -1;
+    GLint floorLoc = -1;
+    GLint yuvLoc = -1;           // focus peaking program only
+    GLint thresholdLoc = -1;
+};
+
+// A frame wider or taller than GL_MAX_TEXTURE_SIZE (8K stills, 4K on GPUs
+// capped at 4096) as a grid of textures drawn as a grid of quads. Each tile
+// also stores a 1-texel apron of its neighbours' pixels, so linear filtering
+// at a seam reads the same texels one big texture would.
+struct TextureTile {
+    FrameTexture texture;
+    cv::Rect core;    // frame pixels the tile's quad covers
+    cv::Rect stored;  // frame pixels the texture holds: core plus the apron, clipped to the frame
+};
+
+struct TiledTexture {
+    GLenum format = GL_RGBA;
+    int width = 0;    // of the whole frame
+    int height = 0;
+    std::vector<TextureTile> tiles;
+};
+
+// Offscreen color buffer for one render-to-texture pass
+struct RenderTarget {
+    GLuint texture = 0;
+    GLuint fbo = 0;
+    int width = 0;
+    int height = 0;
+};
+
+// Attribute slots shared by every program (bound by the registry before linking)
+static const GLuint posLoc = kPositionAttrib;
+static const GLuint texLoc = kTexCoordAttrib;
+
+// Everything below that holds GL objects or upload state is thread_local:
+// every GLSurfaceView draws on its own GL thread with its own context, so
+// each surface gets its own textures, programs, targets and upload caches,
+// and draws the pipeline chosen with setRenderPipelineNative
+
+// Per-effect uniform locations for the registry's programs, resolved on first use
+static thread_local ShaderProgram programs[static_cast<int>(ShaderEffect::COUNT)];
+
+static thread_local FrameTexture colorTexture;   // RGBA frames (CPU-converted color)
+static thread_local FrameTexture lumaTexture;    // 8-bit single-channel frames (edges, grayscale, Y plane)
+static thread_local FrameTexture chromaTexture;  // Interleaved VU plane as LUMINANCE_ALPHA
+static thread_local FrameTexture splitTexture;   // CPU rows of split edge frames (RenderFrame::splitEdges)
+static thread_local TiledTexture tiledTexture;   // frames beyond maxTextureSize, RGBA or LUMINANCE
+static thread_local GLint maxTextureSize = 0;     // GL_MAX_TEXTURE_SIZE of this context
+static const int kMaxTileSize = 2048;             // texels per tile side, apron included
+// MOSAIC canvas, written tile by tile, and the tile revision each holds
+static thread_local FrameTexture mosaicTexture;
+static thread_local uint64_t mosaicGeneration = 0;
+static thread_local std::vector<uint64_t> mosaicRevisions;
+// HEATMAP accumulation: RGBA16F where the context renders to half floats,
+// RGBA8 otherwise; the sequence last added and the generation it belongs to
+static thread_local RenderTarget heatTarget;
+static thread_local bool heatHalfFloat = false;
+static thread_local uint64_t heatSequence = 0;
+static thread_local uint32_t heatGeneration = 0;
+static thread_local PboUploader pboUploader;     // GLES3 asynchronous uploads; inactive on ES2
+static thread_local GpuTimer gpuTimer;           // GPU_UPLOAD / GPU_DRAW; inactive without the extension
+static thread_local GpuReadback edgeReadback;    // GPU edges to CPU consumers (ES3); inactive on ES2
+// DOCUMENT mode's rectified region, upright at the requested size, read back for OCR
+static thread_local GpuReadback rectifiedReadback(GpuReadback::Channel::RECTIFIED);
+static thread_local RenderTarget rectifiedTarget;
+
+// GLES3: rects of a frame go up straight from its rows (uploadChangedRects)
+static thread_local bool unpackRowLength = false;
+
+// Lens undistortion map (lens_undistortion.h) as an RG32F texture, uploaded
+// once per map; float textures need ES3, so ES2 draws frames as captured
+static thread_local bool floatMapsSupported = false;
+static thread_local GLuint undistortMapTexture = 0;
+static thread_local std::shared_ptr<const LensUndistortion::Maps> uploadedUndistortMaps;
+
+// Zero-copy camera preview: the camera renders into this texture through a
+// SurfaceTexture created on the Java side (GL thread only)
+static thread_local GLuint externalTextureId = 0;
+struct ASurfaceTexture;
+static thread_local ASurfaceTexture* surfaceTexture = nullptr;
+static thread_local int externalWidth = 0, externalHeight = 0;
+
+// GPU edge backend (EDGE_DETECTION with EDGE_BACKEND_GPU)
+static thread_local RenderTarget blurTarget;
+static thread_local RenderTarget gradientTarget;
+static thread_local RenderTarget nmsTarget;
+// The same passes as ES 3.1 compute kernels (computeEdges): immutable RGBA8
+// images for the gradient and the ping-ponged hysteresis states
+static thread_local bool computeEdges = false;
+static const int kComputeHysteresisPasses = 3;
+static thread_local RenderTarget imageGradientTarget;
+static thread_local RenderTarget imageStateTargets[2];
+// Final edges of the default pipeline, unrotated, while edge readback is wanted
+static thread_local RenderTarget readbackTarget;
+static thread_local bool drawingDefaultPipeline = false;
+// CL-GL edges of the external camera texture: the OES frame drawn into
+// cameraTarget, OpenCL kernels write clEdgesTarget, which is then displayed
+static thread_local RenderTarget cameraTarget;
+static thread_local RenderTarget clEdgesTarget;
+
+// Frame textures and edge targets for the size frames are about to change
+// to (prepareFrameSizeGL), allocated a frame ahead beside the ones in use and
+// adopted by the first upload or edge pass at that size
+static thread_local std::vector<FrameTexture> spareTextures;
+static thread_local std::vector<RenderTarget> spareTargets;
+static thread_local int spareFramesLeft = 0;
+
+// Render effects (render_effects.h) as compiled on this thread, and the
+// ping-pong targets a frame layer goes through on its way to the surface
+struct EffectPass {
+    GLuint id = 0;
+    GLint samplerLoc = -1;
+    GLint texelSizeLoc = -1;
+    GLint paramsLoc = -1;
+};
+static thread_local std::vector<EffectPass> effectPasses;
+static thread_local bool effectsResolved = false;
+static thread_local uint32_t effectsGeneration = 0;  // of the chain effectPasses was built from
+static thread_local RenderTarget effectTargets[2];
+static thread_local GLfloat effectParams[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+// Where the frame layer draws: the surface (0), or effectTargets[0] while effects run
+static thread_local GLuint layerFramebuffer = 0;
+
+// AHardwareBuffers (Vulkan edges, CPU-written hardware frames) bound as
+// textures through EGLImages, one per buffer of the producers' rings (each
+// EGLImage holds its own buffer reference)
+struct BufferTexture {
+    AHardwareBuffer* buffer = nullptr;
+    EGLImageKHR image = EGL_NO_IMAGE_KHR;
+    GLuint texture = 0;
+};
+static const int kBufferTextures = 8;
+static thread_local BufferTexture bufferTextures[kBufferTextures];
+static thread_local int nextBufferTexture = 0;
+// The last frames drawn stay referenced so the producer does not rewrite a
+// buffer GL may still be sampling
+static thread_local std::shared_ptr<const SharedEdgeImage> recentSharedEdges[2];
+static thread_local std::shared_ptr<const HardwareFrame> recentHardwareFrames[2];
+
+// Identity of the frame currently held by the textures. The GL thread can draw
+// faster than frames are published; redraws of the same frame skip conversion,
+// upload and the offscreen edge passes.
+struct UploadedFrame {
+    bool valid = false;
+    uint64_t sequence = 0;
+    const uchar* image = nullptr;
+    const uchar* chroma = nullptr;
+    bool gpuEdges = false;
+};
+static thread_local UploadedFrame lastUpload;
+
+// Pipeline this surface draws (null = the default one)
+static thread_local PipelineContext* renderPipeline = nullptr;
+static thread_local uint64_t lastLatencySequence = 0;  // last frame CAPTURE_TO_DISPLAY was recorded for
+static thread_local uint64_t lastTracedSequence = 0;   // default pipeline's "frame" async sections ended up to here
+static thread_local bool copyPass = false;  // drawing the recording's or a mirror's copy of the frame
+static thread_local uint64_t presentedSequence = 0;  // frame of the bound pipeline drawn this renderGL
+
+// Overlay layer for DEFAULT (blended over the raw feed) and INSET (PiP quad)
+static thread_local FrameTexture overlayTexture;
+static thread_local TiledTexture tiledOverlay;    // overlays beyond maxTextureSize
+static thread_local uint64_t lastOverlaySequence = 0;
+static thread_local const uchar* lastOverlayData = nullptr;
+static const GLfloat kOverlayTint[4] = {0.2f, 1.0f, 0.4f, 1.0f};  // edge line color and opacity
+static const int kInsetMargin = 16;                               // px from the screen edges
+static const GLfloat kMarkerTint[4] = {1.0f, 0.85f, 0.1f, 1.0f};   // keypoint / flow vector color
+static const GLfloat kMarkerPointSize = 6.0f;                      // px
+static const GLfloat kMarkerLineWidth = 2.0f;                      // px, clamped by the driver
+static thread_local GLuint markerVbo = 0;
+static thread_local uint64_t lastMarkerSequence = 0;
+static thread_local const uchar* lastMarkerData = nullptr;
+
+// A second pipeline composited next to the first (null = none), and its share
+// of the state above: layer textures, edge pass targets and upload caches are
+// swapped in around its draw, so each stream keeps its uploads across redraws
+static thread_local PipelineContext* secondaryPipeline = nullptr;
+struct StreamBank {
+    FrameTexture color;
+    FrameTexture luma;
+    FrameTexture chroma;
+    FrameTexture overlay;
+    FrameTexture split;
+    TiledTexture tiled;
+    TiledTexture tiledOverlay;
+    RenderTarget blur;
+    RenderTarget gradient;
+    RenderTarget nms;
+    RenderTarget imageGradient;
+    RenderTarget imageStates[2];
+    UploadedFrame upload;
+    uint64_t overlaySequence = 0;
+    const uchar* overlayData = nullptr;
+    GLuint markerVbo = 0;
+    uint64_t markerSequence = 0;
+    const uchar* markerData = nullptr;
+    uint64_t latencySequence = 0;
+};
+static thread_local StreamBank secondaryBank;
+
+// Mode residency (setModeResidencyGL): a copy of the window per resident
+// render mode, drawn instead of a mode's frames until the first one built
+// for it arrives. Inactive modes the pipeline also built are redrawn into
+// their copies before the frame's own pass, with residentBank's textures so
+// the shown stream keeps its uploads.
+struct ModeSnapshot {
+    int mode = -1;
+    FrameTexture texture;   // GL_RGB, the window's size when taken
+    uint64_t sequence = 0;  // published frame it shows
+    uint64_t takenAt = 0;   // residencyFrame when taken; the least recent is evicted first
+};
+static std::atomic<uint32_t> residentModeMask{0};
+static std::atomic<int64_t> residencyBudget{0};
+static thread_local std::vector<ModeSnapshot> modeSnapshots;
+static thread_local StreamBank residentBank;
+static thread_local uint64_t residencyFrame = 0;  // renderGL calls
+static thread_local bool residentPass = false;    // drawing an inactive mode for its snapshot
+static thread_local bool residentDrawn = false;
+static thread_local int shownMode = -1;           // mode built and drawn this renderGL, -1 = none
+static const uint64_t kSnapshotFrames = 10;       // renderGL calls between two snapshots of a mode
 
-// External method to get processed OpenCV frame (thread-safe double buffer)
-cv::Mat getLatestFrameForRender();
+static bool isAlreadyUploaded(const RenderFrame& frame) {
+    return lastUpload.valid &&
+           lastUpload.sequence == frame.sequence &&
+           lastUpload.image == frame.image.data &&
+           lastUpload.chroma == frame.chroma.data &&
+           lastUpload.gpuEdges == frame.detectEdgesOnGpu;
+}
+
+static void rememberUpload(const RenderFrame& frame) {
+    lastUpload.valid = true;
+    lastUpload.sequence = frame.sequence;
+    lastUpload.image = frame.image.data;
+    lastUpload.chroma = frame.chroma.data;
+    lastUpload.gpuEdges = frame.detectEdgesOnGpu;
+}
+
+// ASurfaceTexture is API 28 while minSdk is 24, so it is resolved at runtime
+struct SurfaceTextureApi {
+    ASurfaceTexture* (*fromSurfaceTexture)(JNIEnv*, jobject) = nullptr;
+    void (*release)(ASurfaceTexture*) = nullptr;
+    int (*updateTexImage)(ASurfaceTexture*) = nullptr;
+    void (*getTransformMatrix)(ASurfaceTexture*, float[16]) = nullptr;
+
+    bool available() const { return fromSurfaceTexture && release && updateTexImage && getTransformMatrix; }
+};
+
+static const SurfaceTextureApi& surfaceTextureApi() {
+    static const SurfaceTextureApi api = [] {
+        SurfaceTextureApi loaded;
+        void* lib = dlopen("libandroid.so", RTLD_NOW | RTLD_NOLOAD);
+        if (!lib) {
+            lib = dlopen("libandroid.so", RTLD_NOW);
+        }
+        if (lib) {
+            loaded.fromSurfaceTexture = reinterpret_cast<ASurfaceTexture* (*)(JNIEnv*, jobject)>(
+                    dlsym(lib, "ASurfaceTexture_fromSurfaceTexture"));
+            loaded.release = reinterpret_cast<void (*)(ASurfaceTexture*)>(
+                    dlsym(lib, "ASurfaceTexture_release"));
+            loaded.updateTexImage = reinterpret_cast<int (*)(ASurfaceTexture*)>(
+                    dlsym(lib, "ASurfaceTexture_updateTexImage"));
+            loaded.getTransformMatrix = reinterpret_cast<void (*)(ASurfaceTexture*, float[16])>(
+                    dlsym(lib, "ASurfaceTexture_getTransformMatrix"));
+        }
+        if (!loaded.available()) {
+            LOGW("ASurfaceTexture unavailable (API < 28), zero-copy preview disabled");
+        }
+        return loaded;
+    }();
+    return api;
+}
+static thread_local int viewportWidth = 0, viewportHeight = 0;
+
+// Screen rectangle the current layer is drawn into (GL window coordinates).
+// fill = scale to cover the rectangle (cropping) instead of letterboxing.
+struct LayerArea {
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+    bool fill = false;
+};
+static thread_local LayerArea layerArea;
+
+// Part of the full frame the layer being drawn covers (processing ROI), in
+// normalized buffer coordinates; inactive = the texture is the whole frame
+struct LayerRegion {
+    bool active = false;
+    GLfloat u0 = 0.0f;
+    GLfloat v0 = 0.0f;
+    GLfloat u1 = 1.0f;
+    GLfloat v1 = 1.0f;
+    int frameWidth = 0;   // full frame size, used for letterboxing instead of the texture's
+    int frameHeight = 0;
+};
+static thread_local LayerRegion layerRegion;
+
+static void setLayerRegion(const RenderFrame& frame) {
+    layerRegion = LayerRegion();
+    const cv::Size& full = frame.regionFrameSize;
+    if (frame.region.empty() || full.width <= 0 || full.height <= 0) {
+        return;
+    }
+    layerRegion.active = true;
+    layerRegion.u0 = static_cast<GLfloat>(frame.region.x) / full.width;
+    layerRegion.v0 = static_cast<GLfloat>(frame.region.y) / full.height;
+    layerRegion.u1 = static_cast<GLfloat>(frame.region.x + frame.region.width) / full.width;
+    layerRegion.v1 = static_cast<GLfloat>(frame.region.y + frame.region.height) / full.height;
+    layerRegion.frameWidth = full.width;
+    layerRegion.frameHeight = full.height;
+}
+
+static void clearLayerRegion() {
+    layerRegion = LayerRegion();
+}
+
+// Stabilizing warp of the frame being drawn (RenderFrame::warp), in 0..1
+// full-frame buffer coordinates; inactive = drawn where it is
+struct LayerWarp {
+    bool active = false;
+    GLfloat m[6] = {1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f};
+
+    void apply(GLfloat& u, GLfloat& v) const {
+        const GLfloat x = u;
+        u = m[0] * x + m[1] * v + m[2];
+        v = m[3] * x + m[4] * v + m[5];
+    }
+};
+static thread_local LayerWarp layerWarp;
 
-static GLuint textureId = 0;
-static GLuint program = 0;
-static GLint posLoc = -1, texLoc = -1, samplerLoc = -1;
-static int texWidth = 1024, texHeight = 512;
+// Active for one pipeline frame's draws
+struct ScopedLayerWarp {
+    explicit ScopedLayerWarp(const RenderFrame& frame) {
+        layerWarp = LayerWarp();
+        layerWarp.active = frame.warped;
+        for (int i = 0; frame.warped && i < 6; i++) {
+            layerWarp.m[i] = frame.warp.val[i];
+        }
+    }
+    ~ScopedLayerWarp() { layerWarp = LayerWarp(); }
+};
 
-// Pre-allocated upload buffer
-static std::vector<uint8_t> pixelBuffer;
+static void setLayerArea(int x, int y, int width, int height, bool fill) {
+    layerArea.x = x;
+    layerArea.y = y;
+    layerArea.width = width;
+    layerArea.height = height;
+    layerArea.fill = fill;
+    glViewport(x, y, width, height);
+}
 
 // ORIENTATION FIX: Different vertex arrays for different orientations
 // Normal orientation (portrait, no rotation needed)
@@ -76,14 +478,17 @@ enum class Orientation {
     ROTATED_270 = 4
 };
 
-static Orientation currentOrientation = Orientation::FLIPPED_V; // Start with flipped (most common fix)
+static thread_local Orientation currentOrientation = Orientation::FLIPPED_V; // Start with flipped (most common fix)
+static thread_local int controlOrientation = -1;   // last orientation taken from the control block
 
 const char* vertexShaderSrc = R"(
 attribute vec2 a_Position;
 attribute vec2 a_TexCoord;
+uniform vec2 u_Scale;
 varying highp vec2 v_TexCoord;
 void main() {
-    gl_Position = vec4(a_Position, 0.0, 1.0);
+    // u_Scale letterboxes the quad to the frame's aspect ratio
+    gl_Position = vec4(a_Position * u_Scale, 0.0, 1.0);
     v_TexCoord = a_TexCoord;
 }
 )";
@@ -92,239 +497,3496 @@ const char* fragmentShaderSrc = R"(
 precision highp float;
 varying highp vec2 v_TexCoord;
 uniform sampler2D u_Texture;
+uniform bool u_SingleChannel;
 void main() {
-    gl_FragColor = texture2D(u_Texture, v_TexCoord);
+    vec4 color = texture2D(u_Texture, v_TexCoord);
+    // Single-channel frames are uploaded as one byte per pixel; broadcast it
+    gl_FragColor = u_SingleChannel ? vec4(color.rrr, 1.0) : color;
 }
 )";
 
-static void checkGLError(const char* operation) {
-    GLenum error = glGetError();
-    if (error != GL_NO_ERROR) {
-        LOGE("GL Error after %s: 0x%x", operation, error);
-    }
+// SurfaceTexture frames: the texture matrix from updateTexImage maps GL-origin
+// coordinates, so the top-origin quad coordinates are flipped first
+const char* externalVertexShaderSrc = R"(
+attribute vec2 a_Position;
+attribute vec2 a_TexCoord;
+uniform vec2 u_Scale;
+uniform mat4 u_TexMatrix;
+varying highp vec2 v_TexCoord;
+void main() {
+    gl_Position = vec4(a_Position * u_Scale, 0.0, 1.0);
+    v_TexCoord = (u_TexMatrix * vec4(a_TexCoord.x, 1.0 - a_TexCoord.y, 0.0, 1.0)).xy;
 }
+)";
 
-static GLuint compileShader(GLenum type, const char* src) {
-    GLuint s = glCreateShader(type);
-    glShaderSource(s, 1, &src, nullptr);
-    glCompileShader(s);
-    GLint ok = 0;
-    glGetShaderiv(s, GL_COMPILE_STATUS, &ok);
-    if (!ok) {
-        char buf[512];
-        glGetShaderInfoLog(s, 512, nullptr, buf);
-        LOGE("Shader compile error: %s", buf);
-        glDeleteShader(s);
-        return 0;
-    }
-    return s;
+const char* externalFragmentShaderSrc = R"(
+#extension GL_OES_EGL_image_external : require
+precision mediump float;
+varying highp vec2 v_TexCoord;
+uniform samplerExternalOES u_Texture;
+void main() {
+    gl_FragColor = texture2D(u_Texture, v_TexCoord);
 }
+)";
 
-// Helper function to get the right vertices for current orientation
-static const GLfloat* getCurrentVertices() {
-    switch (currentOrientation) {
-        case Orientation::NORMAL: return verticesNormal;
-        case Orientation::FLIPPED_V: return verticesFlippedV;
-        case Orientation::ROTATED_90: return verticesRotated90;
-        case Orientation::ROTATED_180: return verticesRotated180;
-        case Orientation::ROTATED_270: return verticesRotated270;
-        default: return verticesFlippedV;
-    }
+// GPU edge detector: blur -> Sobel -> non-maximum suppression render into
+// frame-sized targets, and the hysteresis pass draws straight to the screen.
+// Thresholds match the CPU path's cv::Canny(gray, edges, 100, 200) on an L1
+// gradient, in units of the normalized 0..1 input.
+const char* passVertexShaderSrc = R"(
+attribute vec2 a_Position;
+attribute vec2 a_TexCoord;
+varying highp vec2 v_TexCoord;
+void main() {
+    gl_Position = vec4(a_Position, 0.0, 1.0);
+    v_TexCoord = a_TexCoord;
 }
+)";
 
-void initGL() {
-    glDisable(GL_DITHER);
-    checkGLError("disable dither");
-
-    GLuint vs = compileShader(GL_VERTEX_SHADER, vertexShaderSrc);
-    GLuint fs = compileShader(GL_FRAGMENT_SHADER, fragmentShaderSrc);
+// 3x3 Gaussian [1 2 1] x [1 2 1] / 16
+const char* blurFragmentShaderSrc = R"(
+precision mediump float;
+varying highp vec2 v_TexCoord;
+uniform sampler2D u_Texture;
+uniform highp vec2 u_TexelSize;
+float px(float dx, float dy) {
+    return texture2D(u_Texture, v_TexCoord + vec2(dx, dy) * u_TexelSize).r;
+}
+void main() {
+    float c = (px(-1.0, -1.0) + 2.0 * px(0.0, -1.0) + px(1.0, -1.0)
+             + 2.0 * px(-1.0, 0.0) + 4.0 * px(0.0, 0.0) + 2.0 * px(1.0, 0.0)
+             + px(-1.0, 1.0) + 2.0 * px(0.0, 1.0) + px(1.0, 1.0)) / 16.0;
+    gl_FragColor = vec4(c, c, c, 1.0);
+}
+)";
 
-    if (vs == 0 || fs == 0) {
-        LOGE("Failed to compile shaders");
-        return;
+// Output: r = L1 magnitude / 4, g = direction sector / 3 (0 horizontal,
+// 1 and 3 diagonals, 2 vertical), quantized like cv::Canny
+const char* sobelFragmentShaderSrc = R"(
+precision mediump float;
+varying highp vec2 v_TexCoord;
+uniform sampler2D u_Texture;
+uniform highp vec2 u_TexelSize;
+float px(float dx, float dy) {
+    return texture2D(u_Texture, v_TexCoord + vec2(dx, dy) * u_TexelSize).r;
+}
+void main() {
+    float tl = px(-1.0, -1.0), t = px(0.0, -1.0), tr = px(1.0, -1.0);
+    float l = px(-1.0, 0.0), r = px(1.0, 0.0);
+    float bl = px(-1.0, 1.0), b = px(0.0, 1.0), br = px(1.0, 1.0);
+    float gx = (tr + 2.0 * r + br) - (tl + 2.0 * l + bl);
+    float gy = (bl + 2.0 * b + br) - (tl + 2.0 * t + tr);
+    float ax = abs(gx);
+    float ay = abs(gy);
+    float sector;
+    if (ay < ax * 0.4142) {
+        sector = 0.0;
+    } else if (ay > ax * 2.4142) {
+        sector = 2.0;
+    } else {
+        sector = gx * gy > 0.0 ? 1.0 : 3.0;
     }
+    gl_FragColor = vec4(min((ax + ay) / 4.0, 1.0), sector / 3.0, 0.0, 1.0);
+}
+)";
 
-    program = glCreateProgram();
-    glAttachShader(program, vs);
-    glAttachShader(program, fs);
-    glLinkProgram(program);
-
-    GLint linked = 0;
-    glGetProgramiv(program, GL_LINK_STATUS, &linked);
-    if (!linked) {
-        char buf[512];
-        glGetProgramInfoLog(program, 512, nullptr, buf);
-        LOGE("Program link error: %s", buf);
-        glDeleteProgram(program);
-        program = 0;
-        return;
+// Keeps local maxima along the gradient; r = 1 strong, 0.5 weak, 0 none
+const char* nmsFragmentShaderSrc = R"(
+precision mediump float;
+varying highp vec2 v_TexCoord;
+uniform sampler2D u_Texture;
+uniform highp vec2 u_TexelSize;
+const float kLow = 100.0 / 255.0;
+const float kHigh = 200.0 / 255.0;
+void main() {
+    vec4 g = texture2D(u_Texture, v_TexCoord);
+    float sector = floor(g.g * 3.0 + 0.5);
+    vec2 step = vec2(1.0, 0.0);
+    if (sector == 1.0) {
+        step = vec2(1.0, 1.0);
+    } else if (sector == 2.0) {
+        step = vec2(0.0, 1.0);
+    } else if (sector == 3.0) {
+        step = vec2(1.0, -1.0);
     }
-
-    glDeleteShader(vs);
-    glDeleteShader(fs);
-    glUseProgram(program);
-
-    // Cache locations
-    posLoc     = glGetAttribLocation(program, "a_Position");
-    texLoc     = glGetAttribLocation(program, "a_TexCoord");
-    samplerLoc = glGetUniformLocation(program, "u_Texture");
-
-    if (posLoc == -1 || texLoc == -1 || samplerLoc == -1) {
-        LOGE("Failed to get shader locations: pos=%d, tex=%d, sampler=%d",
-             posLoc, texLoc, samplerLoc);
-        return;
+    step *= u_TexelSize;
+    float a = texture2D(u_Texture, v_TexCoord + step).r;
+    float b = texture2D(u_Texture, v_TexCoord - step).r;
+    float m = g.r * 4.0;
+    float e = 0.0;
+    if (g.r > a && g.r >= b) {
+        e = m > kHigh ? 1.0 : (m > kLow ? 0.5 : 0.0);
     }
-
-    // Create texture
-    glGenTextures(1, &textureId);
-    glBindTexture(GL_TEXTURE_2D, textureId);
-    checkGLError("glBindTexture");
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    checkGLError("texture parameters");
-
-    // Initialize with empty texture
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, texWidth, texHeight, 0,
-                 GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
-    checkGLError("glTexImage2D");
-
-    // Pre-allocate buffer
-    pixelBuffer.resize(texWidth * texHeight * 4);
-    std::fill(pixelBuffer.begin(), pixelBuffer.end(), 0);
-
-    LOGI("initGL complete with orientation support");
+    gl_FragColor = vec4(e, e, e, 1.0);
 }
+)";
 
-void resizeGL(int width, int height) {
-    glViewport(0, 0, width, height);
-    checkGLError("glViewport");
+// Single-step hysteresis: weak pixels survive next to a strong one. Drawn
+// with the oriented display quad (vertexShaderSrc).
+const char* hysteresisFragmentShaderSrc = R"(
+precision mediump float;
+varying highp vec2 v_TexCoord;
+uniform sampler2D u_Texture;
+uniform highp vec2 u_TexelSize;
+float px(float dx, float dy) {
+    return texture2D(u_Texture, v_TexCoord + vec2(dx, dy) * u_TexelSize).r;
+}
+void main() {
+    float c = px(0.0, 0.0);
+    float e = 0.0;
+    if (c > 0.75) {
+        e = 1.0;
+    } else if (c > 0.25) {
+        float n = max(max(max(px(-1.0, -1.0), px(0.0, -1.0)), max(px(1.0, -1.0), px(-1.0, 0.0))),
+                      max(max(px(1.0, 0.0), px(-1.0, 1.0)), max(px(0.0, 1.0), px(1.0, 1.0))));
+        e = n > 0.75 ? 1.0 : 0.0;
+    }
+    gl_FragColor = vec4(e, e, e, 1.0);
 }
+)";
 
-// Main render function with orientation support
-void renderGL() {
-    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT);
+// ES 3.1 compute versions of the edge passes. Each 16x16 work group loads
+// its tile plus a halo into shared memory once, so every tap after that is a
+// shared-memory read instead of a texture fetch. Inputs are read with
+// texelFetch at clamped coordinates (the CLAMP_TO_EDGE of the fragment passes),
+// outputs use the fragment passes' encodings so the hysteresis fragment pass
+// still draws the result.
 
-    cv::Mat frame;
-    try {
-        frame = getLatestFrameForRender();
-        if (frame.empty()) {
-            return;
+// Blur and Sobel fused: a 20x20 luma tile is blurred into 18x18, whose
+// interior 16x16 gets the gradient (r = L1 magnitude / 4, g = sector / 3)
+const char* gradientComputeShaderSrc = R"(#version 310 es
+layout(local_size_x = 16, local_size_y = 16) in;
+uniform highp sampler2D u_Texture;
+layout(rgba8, binding = 0) writeonly uniform highp image2D u_Output;
+shared float lumaTile[400];
+shared float blurTile[324];
+void main() {
+    ivec2 size = textureSize(u_Texture, 0);
+    ivec2 origin = ivec2(gl_WorkGroupID.xy) * 16 - 2;
+    int invocation = int(gl_LocalInvocationIndex);
+    for (int i = invocation; i < 400; i += 256) {
+        ivec2 p = clamp(origin + ivec2(i % 20, i / 20), ivec2(0), size - 1);
+        lumaTile[i] = texelFetch(u_Texture, p, 0).r;
+    }
+    memoryBarrierShared();
+    barrier();
+    for (int i = invocation; i < 324; i += 256) {
+        ivec2 c = clamp(origin + 1 + ivec2(i % 18, i / 18), ivec2(0), size - 1);
+        float sum = 0.0;
+        for (int dy = -1; dy <= 1; dy++) {
+            for (int dx = -1; dx <= 1; dx++) {
+                ivec2 t = clamp(c + ivec2(dx, dy), ivec2(0), size - 1) - origin;
+                sum += float((2 - abs(dx)) * (2 - abs(dy))) * lumaTile[t.y * 20 + t.x];
+            }
         }
-    } catch (const std::exception& e) {
-        LOGE("Exception getting frame: %s", e.what());
-        return;
+        blurTile[i] = sum / 16.0;
     }
-
-    if (frame.data == nullptr || frame.cols <= 0 || frame.rows <= 0) {
-        LOGE("Invalid frame data");
+    memoryBarrierShared();
+    barrier();
+    ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    if (pixel.x >= size.x || pixel.y >= size.y) {
         return;
     }
+    float v[9];
+    for (int k = 0; k < 9; k++) {
+        ivec2 t = clamp(pixel + ivec2(k % 3 - 1, k / 3 - 1), ivec2(0), size - 1) - origin - 1;
+        v[k] = blurTile[t.y * 18 + t.x];
+    }
+    float gx = (v[2] + 2.0 * v[5] + v[8]) - (v[0] + 2.0 * v[3] + v[6]);
+    float gy = (v[6] + 2.0 * v[7] + v[8]) - (v[0] + 2.0 * v[1] + v[2]);
+    float ax = abs(gx);
+    float ay = abs(gy);
+    float sector;
+    if (ay < ax * 0.4142) {
+        sector = 0.0;
+    } else if (ay > ax * 2.4142) {
+        sector = 2.0;
+    } else {
+        sector = gx * gy > 0.0 ? 1.0 : 3.0;
+    }
+    imageStore(u_Output, pixel, vec4(min((ax + ay) / 4.0, 1.0), sector / 3.0, 0.0, 1.0));
+}
+)";
 
-    // Convert to RGBA
-    cv::Mat rgba;
-    try {
-        switch (frame.channels()) {
-            case 1:
-                cv::cvtColor(frame, rgba, cv::COLOR_GRAY2RGBA);
-                break;
-            case 3:
-                cv::cvtColor(frame, rgba, cv::COLOR_BGR2RGBA);
-                break;
-            case 4:
-                frame.copyTo(rgba);
-                break;
-            default:
-                LOGE("Unsupported frame channel count: %d", frame.channels());
-                return;
-        }
-    } catch (const cv::Exception& e) {
-        LOGE("OpenCV color conversion failed: %s", e.what());
+// Non-maximum suppression over an 18x18 gradient tile; r = 1 strong, 0.5 weak
+const char* nmsComputeShaderSrc = R"(#version 310 es
+layout(local_size_x = 16, local_size_y = 16) in;
+uniform highp sampler2D u_Texture;
+layout(rgba8, binding = 0) writeonly uniform highp image2D u_Output;
+const float kLow = 100.0 / 255.0;
+const float kHigh = 200.0 / 255.0;
+shared vec2 gradientTile[324];
+void main() {
+    ivec2 size = textureSize(u_Texture, 0);
+    ivec2 origin = ivec2(gl_WorkGroupID.xy) * 16 - 1;
+    int invocation = int(gl_LocalInvocationIndex);
+    for (int i = invocation; i < 324; i += 256) {
+        ivec2 p = clamp(origin + ivec2(i % 18, i / 18), ivec2(0), size - 1);
+        gradientTile[i] = texelFetch(u_Texture, p, 0).rg;
+    }
+    memoryBarrierShared();
+    barrier();
+    ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    if (pixel.x >= size.x || pixel.y >= size.y) {
         return;
     }
-
-    if (!rgba.isContinuous()) {
-        rgba = rgba.clone();
+    ivec2 c = pixel - origin;
+    vec2 g = gradientTile[c.y * 18 + c.x];
+    float sector = floor(g.g * 3.0 + 0.5);
+    ivec2 step = ivec2(1, 0);
+    if (sector == 1.0) {
+        step = ivec2(1, 1);
+    } else if (sector == 2.0) {
+        step = ivec2(0, 1);
+    } else if (sector == 3.0) {
+        step = ivec2(1, -1);
     }
-
-    if (rgba.cols != texWidth || rgba.rows != texHeight) {
-        cv::resize(rgba, rgba, cv::Size(texWidth, texHeight));
+    ivec2 ta = clamp(pixel + step, ivec2(0), size - 1) - origin;
+    ivec2 tb = clamp(pixel - step, ivec2(0), size - 1) - origin;
+    float a = gradientTile[ta.y * 18 + ta.x].r;
+    float b = gradientTile[tb.y * 18 + tb.x].r;
+    float m = g.r * 4.0;
+    float e = 0.0;
+    if (g.r > a && g.r >= b) {
+        e = m > kHigh ? 1.0 : (m > kLow ? 0.5 : 0.0);
     }
+    imageStore(u_Output, pixel, vec4(e, e, e, 1.0));
+}
+)";
 
-    // Upload texture
-    glBindTexture(GL_TEXTURE_2D, textureId);
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, rgba.cols, rgba.rows,
-                    GL_RGBA, GL_UNSIGNED_BYTE, rgba.data);
-    checkGLError("texture upload");
-
-    // Render with correct orientation
-    glUseProgram(program);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, textureId);
-    glUniform1i(samplerLoc, 0);
-
-    glEnableVertexAttribArray(posLoc);
-    glEnableVertexAttribArray(texLoc);
-
-    // Use vertices based on current orientation
-    const GLfloat* vertices = getCurrentVertices();
-    glVertexAttribPointer(posLoc, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), vertices);
-    glVertexAttribPointer(texLoc, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), vertices + 2);
+// Hysteresis propagation: weak pixels next to a strong one turn strong, up to
+// 8 steps inside the tile per dispatch (the halo is fixed for the dispatch).
+// Weak pixels stay weak (0.5) so later dispatches and the final fragment pass
+// can still promote them.
+const char* hysteresisComputeShaderSrc = R"(#version 310 es
+layout(local_size_x = 16, local_size_y = 16) in;
+uniform highp sampler2D u_Texture;
+layout(rgba8, binding = 0) writeonly uniform highp image2D u_Output;
+shared float stateTile[324];
+void main() {
+    ivec2 size = textureSize(u_Texture, 0);
+    ivec2 origin = ivec2(gl_WorkGroupID.xy) * 16 - 1;
+    int invocation = int(gl_LocalInvocationIndex);
+    for (int i = invocation; i < 324; i += 256) {
+        ivec2 p = clamp(origin + ivec2(i % 18, i / 18), ivec2(0), size - 1);
+        stateTile[i] = texelFetch(u_Texture, p, 0).r;
+    }
+    memoryBarrierShared();
+    barrier();
+    ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    bool inside = pixel.x < size.x && pixel.y < size.y;
+    ivec2 c = ivec2(gl_LocalInvocationID.xy) + 1;
+    int center = c.y * 18 + c.x;
+    float state = stateTile[center];
+    for (int iteration = 0; iteration < 8; iteration++) {
+        bool promote = false;
+        if (inside && state > 0.25 && state < 0.75) {
+            for (int k = 0; k < 9; k++) {
+                promote = promote || stateTile[center + (k / 3 - 1) * 18 + (k % 3 - 1)] > 0.75;
+            }
+        }
+        barrier();
+        if (promote) {
+            state = 1.0;
+            stateTile[center] = 1.0;
+        }
+        memoryBarrierShared();
+        barrier();
+    }
+    if (inside) {
+        imageStore(u_Output, pixel, vec4(state, state, state, 1.0));
+    }
+}
+)";
 
-    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
-    checkGLError("draw arrays");
+// Single-channel mask as tinted, alpha-blended lines
+const char* overlayFragmentShaderSrc = R"(
+precision mediump float;
+varying highp vec2 v_TexCoord;
+uniform sampler2D u_Texture;
+uniform vec4 u_Tint;
+void main() {
+    float mask = texture2D(u_Texture, v_TexCoord).r;
+    gl_FragColor = vec4(u_Tint.rgb, u_Tint.a * mask);
+}
+)";
 
-    glDisableVertexAttribArray(posLoc);
-    glDisableVertexAttribArray(texLoc);
+// 1-bpp edge bitmaps (packed_edges.h), uploaded as a GL_LUMINANCE texture of
+// u_RowBytes bytes per row. Each fragment samples the center of the byte
+// holding its pixel (so linear filtering returns that byte unblended) and
+// extracts the bit: opaque gray with u_SingleChannel, a tinted mask otherwise.
+const char* bitsFragmentShaderSrc = R"(
+precision highp float;
+varying highp vec2 v_TexCoord;
+uniform sampler2D u_Texture;
+uniform vec2 u_BitsSize;
+uniform float u_RowBytes;
+uniform bool u_SingleChannel;
+uniform vec4 u_Tint;
+void main() {
+    vec2 pixel = min(floor(v_TexCoord * u_BitsSize), u_BitsSize - 1.0);
+    float byteIndex = floor(pixel.x / 8.0);
+    float bit = pixel.x - byteIndex * 8.0;
+    vec2 uv = vec2((byteIndex + 0.5) / u_RowBytes, (pixel.y + 0.5) / u_BitsSize.y);
+    float value = floor(texture2D(u_Texture, uv).r * 255.0 + 0.5);
+    float mask = mod(floor(value / exp2(bit)), 2.0);
+    gl_FragColor = u_SingleChannel ? vec4(vec3(mask), 1.0) : vec4(u_Tint.rgb, u_Tint.a * mask);
 }
+)";
 
-// Function to set orientation from Java
-void setOrientation(int orientation) {
-    currentOrientation = static_cast<Orientation>(orientation);
-    LOGI("Orientation set to: %d", orientation);
+// Keypoints and flow vectors: a_Position is an (u, v) buffer coordinate,
+// placed with the same affine map as the frame quad (origin + u * axisU +
+// v * axisV) so markers follow rotation and orientation like the layers do
+const char* markerVertexShaderSrc = R"(
+attribute vec2 a_Position;
+uniform vec2 u_Scale;
+uniform vec2 u_Origin;
+uniform vec2 u_AxisU;
+uniform vec2 u_AxisV;
+uniform float u_PointSize;
+void main() {
+    vec2 p = u_Origin + a_Position.x * u_AxisU + a_Position.y * u_AxisV;
+    gl_Position = vec4(p * u_Scale, 0.0, 1.0);
+    gl_PointSize = u_PointSize;
 }
+)";
 
-void cleanupGL() {
-    if (textureId) {
-        glDeleteTextures(1, &textureId);
-        textureId = 0;
-    }
-    if (program) {
-        glDeleteProgram(program);
-        program = 0;
+// Solid tint; point sprites are cut to a disc
+const char* markerFragmentShaderSrc = R"(
+precision mediump float;
+uniform vec4 u_Tint;
+uniform bool u_Round;
+void main() {
+    if (u_Round && length(gl_PointCoord - vec2(0.5)) > 0.5) {
+        discard;
     }
-    pixelBuffer.clear();
-    pixelBuffer.shrink_to_fit();
-    LOGI("OpenGL cleanup complete");
+    gl_FragColor = u_Tint;
 }
+)";
 
-// JNI exports
-#include <jni.h>
-extern "C" {
-
-JNIEXPORT void JNICALL Java_com_example_edge_renderer_GLRenderer_initGLNative(JNIEnv*, jobject) {
-    initGL();
+// NV21 -> RGB with the BT.601 video-range matrix used by COLOR_YUV2BGR_NV21.
+// The VU plane is a LUMINANCE_ALPHA texture: V lands in .r, U in .a.
+const char* yuvFragmentShaderSrc = R"(
+precision mediump float;
+varying highp vec2 v_TexCoord;
+uniform sampler2D u_Texture;
+uniform sampler2D u_Chroma;
+void main() {
+    float y = 1.164 * (texture2D(u_Texture, v_TexCoord).r - 0.0625);
+    vec4 vu = texture2D(u_Chroma, v_TexCoord);
+    float v = vu.r - 0.5;
+    float u = vu.a - 0.5;
+    gl_FragColor = vec4(y + 1.596 * v,
+                        y - 0.813 * v - 0.391 * u,
+                        y + 2.018 * u,
+                        1.0);
 }
+)";
 
-JNIEXPORT void JNICALL Java_com_example_edge_renderer_GLRenderer_resizeGLNative(JNIEnv*, jobject, jint w, jint h) {
-    resizeGL(w, h);
+// Perspective rectification (DOCUMENT): each vertex carries the homogeneous
+// source coordinate of its corner, H * (s, t, 1). Interpolating it linearly
+// and dividing per fragment (texture2DProj) is exactly the projective map,
+// which interpolating divided 2D coordinates would not be.
+const char* rectifyVertexShaderSrc = R"(
+attribute vec2 a_Position;
+attribute vec3 a_TexCoord;
+uniform vec2 u_Scale;
+varying highp vec3 v_TexCoord;
+void main() {
+    gl_Position = vec4(a_Position * u_Scale, 0.0, 1.0);
+    v_TexCoord = a_TexCoord;
 }
+)";
 
-JNIEXPORT void JNICALL Java_com_example_edge_renderer_GLRenderer_renderFrameNative(JNIEnv*, jobject) {
-    renderGL();
+// Rectified output is luma, what a reader or OCR wants; from a color
+// texture it is the BT.601 weighting
+const char* rectifyFragmentShaderSrc = R"(
+precision highp float;
+varying highp vec3 v_TexCoord;
+uniform sampler2D u_Texture;
+uniform bool u_SingleChannel;
+void main() {
+    vec4 color = texture2DProj(u_Texture, v_TexCoord);
+    float luma = u_SingleChannel ? color.r : dot(color.rgb, vec3(0.299, 0.587, 0.114));
+    gl_FragColor = vec4(vec3(luma), 1.0);
 }
+)";
 
-// NEW: Set orientation from Java
-JNIEXPORT void JNICALL Java_com_example_edge_renderer_GLRenderer_setOrientationNative(JNIEnv*, jobject, jint orientation) {
-    setOrientation(orientation);
+// Lens undistortion as a remap: u_Map holds, per undistorted pixel, where it
+// lies in the captured frame (texture coordinates; outside 0..1 = not seen)
+const char* undistortFragmentShaderSrc = R"(
+precision highp float;
+varying highp vec2 v_TexCoord;
+uniform sampler2D u_Texture;
+uniform highp sampler2D u_Map;
+uniform bool u_SingleChannel;
+void main() {
+    vec2 source = texture2D(u_Map, v_TexCoord).rg;
+    vec4 color = texture2D(u_Texture, source);
+    if (any(lessThan(source, vec2(0.0))) || any(greaterThan(source, vec2(1.0)))) {
+        color = vec4(0.0, 0.0, 0.0, 1.0);
+    }
+    gl_FragColor = u_SingleChannel ? vec4(color.rrr, 1.0) : color;
 }
+)";
 
-JNIEXPORT void JNICALL Java_com_example_edge_renderer_GLRenderer_cleanupGLNative(JNIEnv*, jobject) {
-    cleanupGL();
+// HEATMAP accumulation, drawn 1:1 into the heat target with the blend
+// constant's alpha as the decay: u_Weight is 1 - decay, so heat stays in
+// 0..1 as the moving average of edge activity. u_RowBytes > 0 unpacks a
+// 1-bpp map like the EDGE_BITS program.
+const char* heatAccumulateFragmentShaderSrc = R"(
+precision highp float;
+varying highp vec2 v_TexCoord;
+uniform sampler2D u_Texture;
+uniform vec2 u_BitsSize;
+uniform float u_RowBytes;
+uniform float u_Weight;
+void main() {
+    float edge;
+    if (u_RowBytes > 0.0) {
+        vec2 pixel = min(floor(v_TexCoord * u_BitsSize), u_BitsSize - 1.0);
+        float byteIndex = floor(pixel.x / 8.0);
+        vec2 uv = vec2((byteIndex + 0.5) / u_RowBytes, (pixel.y + 0.5) / u_BitsSize.y);
+        float value = floor(texture2D(u_Texture, uv).r * 255.0 + 0.5);
+        edge = mod(floor(value / exp2(pixel.x - byteIndex * 8.0)), 2.0);
+    } else {
+        edge = texture2D(u_Texture, v_TexCoord).r;
+    }
+    gl_FragColor = vec4(vec3(edge * u_Weight), 1.0);
 }
+)";
 
-}
\ No newline at end of file
+// Heat through a black-violet-red-orange-yellow ramp. u_Floor is the heat
+// an RGBA8 target can no longer decay below (rounding keeps x * decay at x),
+// taken off so stale edges still fade to black there.
+const char* heatColormapFragmentShaderSrc = R"(
+precision highp float;
+varying highp vec2 v_TexCoord;
+uniform sampler2D u_Texture;
+uniform float u_Gain;
+uniform float u_Floor;
+vec3 colormap(float t) {
+    vec3 c = mix(vec3(0.0), vec3(0.34, 0.06, 0.43), smoothstep(0.0, 0.25, t));
+    c = mix(c, vec3(0.80, 0.18, 0.27), smoothstep(0.25, 0.5, t));
+    c = mix(c, vec3(0.98, 0.55, 0.04), smoothstep(0.5, 0.75, t));
+    return mix(c, vec3(0.99, 1.0, 0.64), smoothstep(0.75, 1.0, t));
+}
+void main() {
+    float heat = max(texture2D(u_Texture, v_TexCoord).r - u_Floor, 0.0);
+    gl_FragColor = vec4(colormap(clamp(heat * u_Gain, 0.0, 1.0)), 1.0);
+}
+)";
+
+// Focus peaking: the 3x3 Sobel L1 magnitude of luma (the Y plane, or
+// BT.601 luma of RGB) per fragment; from u_Threshold up the camera color
+// fades into u_Tint over a quarter of the threshold
+const char* focusPeakFragmentShaderSrc = R"(
+precision mediump float;
+varying highp vec2 v_TexCoord;
+uniform sampler2D u_Texture;
+uniform sampler2D u_Chroma;
+uniform bool u_Yuv;
+uniform highp vec2 u_TexelSize;
+uniform float u_Threshold;
+uniform vec4 u_Tint;
+float luma(float dx, float dy) {
+    vec4 c = texture2D(u_Texture, v_TexCoord + vec2(dx, dy) * u_TexelSize);
+    return u_Yuv ? c.r : dot(c.rgb, vec3(0.299, 0.587, 0.114));
+}
+vec3 cameraColor() {
+    vec4 c = texture2D(u_Texture, v_TexCoord);
+    if (!u_Yuv) {
+        return c.rgb;
+    }
+    float y = 1.164 * (c.r - 0.0625);
+    vec4 vu = texture2D(u_Chroma, v_TexCoord);
+    float v = vu.r - 0.5;
+    float u = vu.a - 0.5;
+    return vec3(y + 1.596 * v, y - 0.813 * v - 0.391 * u, y + 2.018 * u);
+}
+void main() {
+    float tl = luma(-1.0, -1.0), t = luma(0.0, -1.0), tr = luma(1.0, -1.0);
+    float l = luma(-1.0, 0.0), r = luma(1.0, 0.0);
+    float bl = luma(-1.0, 1.0), b = luma(0.0, 1.0), br = luma(1.0, 1.0);
+    float gx = (tr + 2.0 * r + br) - (tl + 2.0 * l + bl);
+    float gy = (bl + 2.0 * b + br) - (tl + 2.0 * t + tr);
+    float peak = smoothstep(u_Threshold, u_Threshold * 1.25, abs(gx) + abs(gy));
+    gl_FragColor = vec4(mix(cameraColor(), u_Tint.rgb, peak * u_Tint.a), 1.0);
+}
+)";
+
+// DEFAULT in one draw: the base layer's shader with the edge mask as a
+// second sampler, blended in the shader instead of by a second blended quad.
+// Both layers cover the whole frame in the same orientation, so they share
+// the texture coordinates.
+const char* rgbOverlayFragmentShaderSrc = R"(
+precision mediump float;
+varying highp vec2 v_TexCoord;
+uniform sampler2D u_Texture;
+uniform sampler2D u_Overlay;
+uniform bool u_SingleChannel;
+uniform vec4 u_Tint;
+void main() {
+    vec4 color = texture2D(u_Texture, v_TexCoord);
+    vec3 base = u_SingleChannel ? color.rrr : color.rgb;
+    float mask = texture2D(u_Overlay, v_TexCoord).r * u_Tint.a;
+    gl_FragColor = vec4(mix(base, u_Tint.rgb, mask), 1.0);
+}
+)";
+
+const char* yuvOverlayFragmentShaderSrc = R"(
+precision mediump float;
+varying highp vec2 v_TexCoord;
+uniform sampler2D u_Texture;
+uniform sampler2D u_Chroma;
+uniform sampler2D u_Overlay;
+uniform vec4 u_Tint;
+void main() {
+    float y = 1.164 * (texture2D(u_Texture, v_TexCoord).r - 0.0625);
+    vec4 vu = texture2D(u_Chroma, v_TexCoord);
+    float v = vu.r - 0.5;
+    float u = vu.a - 0.5;
+    vec3 base = vec3(y + 1.596 * v, y - 0.813 * v - 0.391 * u, y + 2.018 * u);
+    float mask = texture2D(u_Overlay, v_TexCoord).r * u_Tint.a;
+    gl_FragColor = vec4(mix(base, u_Tint.rgb, mask), 1.0);
+}
+)";
+
+static void checkGLError(const char* operation) {
+    GLenum error = glGetError();
+    if (error != GL_NO_ERROR) {
+        LOGE_RATELIMITED("GL Error after %s: 0x%x", operation, error);
+    }
+}
+
+// Program for an effect, built (or loaded from the binary cache) on first use;
+// nullptr if it cannot be built on this device
+static const ShaderProgram* program(ShaderEffect effect) {
+    ShaderProgram& entry = programs[static_cast<int>(effect)];
+    if (!entry.resolved) {
+        entry = ShaderProgram();
+        entry.resolved = true;
+        entry.id = shaderRegistry().program(effect);
+        if (entry.id) {
+            entry.samplerLoc = glGetUniformLocation(entry.id, "u_Texture");
+            entry.chromaLoc = glGetUniformLocation(entry.id, "u_Chroma");
+            entry.singleChannelLoc = glGetUniformLocation(entry.id, "u_SingleChannel");
+            entry.texMatrixLoc = glGetUniformLocation(entry.id, "u_TexMatrix");
+            entry.texelSizeLoc = glGetUniformLocation(entry.id, "u_TexelSize");
+            entry.tintLoc = glGetUniformLocation(entry.id, "u_Tint");
+            entry.overlayLoc = glGetUniformLocation(entry.id, "u_Overlay");
+            entry.bitsSizeLoc = glGetUniformLocation(entry.id, "u_BitsSize");
+            entry.rowBytesLoc = glGetUniformLocation(entry.id, "u_RowBytes");
+            entry.scaleLoc = glGetUniformLocation(entry.id, "u_Scale");
+            entry.originLoc = glGetUniformLocation(entry.id, "u_Origin");
+            entry.axisULoc = glGetUniformLocation(entry.id, "u_AxisU");
+            entry.axisVLoc = glGetUniformLocation(entry.id, "u_AxisV");
+            entry.pointSizeLoc = glGetUniformLocation(entry.id, "u_PointSize");
+            entry.roundLoc = glGetUniformLocation(entry.id, "u_Round");
+            entry.mapLoc = glGetUniformLocation(entry.id, "u_Map");
+            entry.weightLoc = glGetUniformLocation(entry.id, "u_Weight");
+            entry.gainLoc = glGetUniformLocation(entry.id, "u_Gain");
+            entry.floorLoc = glGetUniformLocation(entry.id, "u_Floor");
+            entry.yuvLoc = glGetUniformLocation(entry.id, "u_Yuv");
+            entry.thresholdLoc = glGetUniformLocation(entry.id, "u_Threshold");
+        }
+    }
+    return entry.id ? &entry : nullptr;
+}
+
+static void forgetPrograms() {
+    for (ShaderProgram& entry : programs) {
+        entry = ShaderProgram();
+    }
+    effectPasses.clear();
+    effectsResolved = false;
+}
+
+// Bumped by warmupGL; a GL thread builds every program once per newer value
+// (and again in each new context)
+static std::atomic<uint32_t> programWarmupGeneration{0};
+static thread_local uint32_t programsWarmedFor = 0;
+
+static void buildRequestedPrograms() {
+    const uint32_t generation = programWarmupGeneration.load(std::memory_order_acquire);
+    if (generation == programsWarmedFor) {
+        return;
+    }
+    programsWarmedFor = generation;
+    int built = 0;
+    int defined = 0;
+    for (int i = 0; i < static_cast<int>(ShaderEffect::COUNT); i++) {
+        const ShaderEffect effect = static_cast<ShaderEffect>(i);
+        if (!shaderRegistry().defined(effect)) {
+            continue;  // compute kernels on a context without ES 3.1
+        }
+        defined++;
+        if (program(effect)) {
+            built++;
+        }
+    }
+    LOGI("✅ Warm-up built %d of %d programs", built, defined);
+}
+
+void warmupGL() {
+    programWarmupGeneration.fetch_add(1, std::memory_order_acq_rel);
+}
+
+// Compute-only source, or none when the context cannot run the kernels
+static ShaderSource computeSource(const char* compute) {
+    ShaderSource source;
+    source.compute = computeEdges ? compute : nullptr;
+    return source;
+}
+
+// Source table for every effect; compiled lazily by the registry
+static void defineShaderEffects() {
+    ShaderRegistry& registry = shaderRegistry();
+    registry.define(ShaderEffect::RGB, {vertexShaderSrc, fragmentShaderSrc});
+    registry.define(ShaderEffect::YUV, {vertexShaderSrc, yuvFragmentShaderSrc});
+    registry.define(ShaderEffect::EXTERNAL_OES, {externalVertexShaderSrc, externalFragmentShaderSrc});
+    registry.define(ShaderEffect::OVERLAY, {vertexShaderSrc, overlayFragmentShaderSrc});
+    registry.define(ShaderEffect::EDGE_BLUR, {passVertexShaderSrc, blurFragmentShaderSrc});
+    registry.define(ShaderEffect::EDGE_SOBEL, {passVertexShaderSrc, sobelFragmentShaderSrc});
+    registry.define(ShaderEffect::EDGE_NMS, {passVertexShaderSrc, nmsFragmentShaderSrc});
+    registry.define(ShaderEffect::EDGE_HYSTERESIS, {vertexShaderSrc, hysteresisFragmentShaderSrc});
+    registry.define(ShaderEffect::MARKERS, {markerVertexShaderSrc, markerFragmentShaderSrc});
+    registry.define(ShaderEffect::EDGE_BITS, {vertexShaderSrc, bitsFragmentShaderSrc});
+    registry.define(ShaderEffect::RGB_OVERLAY, {vertexShaderSrc, rgbOverlayFragmentShaderSrc});
+    registry.define(ShaderEffect::YUV_OVERLAY, {vertexShaderSrc, yuvOverlayFragmentShaderSrc});
+    registry.define(ShaderEffect::UNDISTORT, {vertexShaderSrc, undistortFragmentShaderSrc});
+    registry.define(ShaderEffect::RECTIFY, {rectifyVertexShaderSrc, rectifyFragmentShaderSrc});
+    registry.define(ShaderEffect::HEAT_ACCUMULATE, {passVertexShaderSrc, heatAccumulateFragmentShaderSrc});
+    registry.define(ShaderEffect::HEAT_COLORMAP, {vertexShaderSrc, heatColormapFragmentShaderSrc});
+    registry.define(ShaderEffect::FOCUS_PEAK, {vertexShaderSrc, focusPeakFragmentShaderSrc});
+    registry.define(ShaderEffect::EDGE_GRADIENT_COMPUTE, computeSource(gradientComputeShaderSrc));
+    registry.define(ShaderEffect::EDGE_NMS_COMPUTE, computeSource(nmsComputeShaderSrc));
+    registry.define(ShaderEffect::EDGE_HYSTERESIS_COMPUTE, computeSource(hysteresisComputeShaderSrc));
+}
+
+// Storage of a level-0 8-bit texture, for accountGlMemory
+static int64_t textureBytes(GLenum format, int width, int height) {
+    const int64_t channels = format == GL_RGBA ? 4 : format == GL_RGB ? 3 : format == GL_LUMINANCE_ALPHA ? 2 : 1;
+    return channels * width * height;
+}
+
+static void deleteRenderTarget(RenderTarget& target) {
+    if (target.fbo) {
+        glDeleteFramebuffers(1, &target.fbo);
+    }
+    if (target.texture) {
+        glDeleteTextures(1, &target.texture);
+        accountGlMemory(-textureBytes(GL_RGBA, target.width, target.height));
+    }
+    target = RenderTarget();
+}
+
+static void deleteEdgeTargets() {
+    deleteRenderTarget(blurTarget);
+    deleteRenderTarget(gradientTarget);
+    deleteRenderTarget(nmsTarget);
+    deleteRenderTarget(imageGradientTarget);
+    deleteRenderTarget(imageStateTargets[0]);
+    deleteRenderTarget(imageStateTargets[1]);
+    deleteRenderTarget(cameraTarget);
+    deleteRenderTarget(clEdgesTarget);
+    deleteRenderTarget(readbackTarget);
+    deleteRenderTarget(rectifiedTarget);
+    deleteRenderTarget(effectTargets[0]);
+    deleteRenderTarget(effectTargets[1]);
+}
+
+static void swapStreamBank(StreamBank& bank) {
+    std::swap(colorTexture, bank.color);
+    std::swap(lumaTexture, bank.luma);
+    std::swap(chromaTexture, bank.chroma);
+    std::swap(overlayTexture, bank.overlay);
+    std::swap(splitTexture, bank.split);
+    std::swap(tiledTexture, bank.tiled);
+    std::swap(tiledOverlay, bank.tiledOverlay);
+    std::swap(blurTarget, bank.blur);
+    std::swap(gradientTarget, bank.gradient);
+    std::swap(nmsTarget, bank.nms);
+    std::swap(imageGradientTarget, bank.imageGradient);
+    std::swap(imageStateTargets, bank.imageStates);
+    std::swap(lastUpload, bank.upload);
+    std::swap(lastOverlaySequence, bank.overlaySequence);
+    std::swap(lastOverlayData, bank.overlayData);
+    std::swap(markerVbo, bank.markerVbo);
+    std::swap(lastMarkerSequence, bank.markerSequence);
+    std::swap(lastMarkerData, bank.markerData);
+    std::swap(lastLatencySequence, bank.latencySequence);
+}
+
+// (Re)creates an RGBA render target when the frame size changes. Filtering is
+// NEAREST so neighbour taps read exact texels.
+static bool createRenderTarget(RenderTarget& target, int width, int height);
+
+static bool ensureRenderTarget(RenderTarget& target, int width, int height) {
+    if (target.fbo && target.width == width && target.height == height) {
+        return true;
+    }
+    deleteRenderTarget(target);
+    return createRenderTarget(target, width, height);
+}
+
+static bool createRenderTarget(RenderTarget& target, int width, int height) {
+    glGenTextures(1, &target.texture);
+    glBindTexture(GL_TEXTURE_2D, target.texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    accountGlMemory(textureBytes(GL_RGBA, width, height));
+    target.width = width;   // what deleteRenderTarget releases from here on
+    target.height = height;
+
+    glGenFramebuffers(1, &target.fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, target.fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.texture, 0);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, layerFramebuffer);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        LOGE("Edge render target %dx%d incomplete: 0x%x", width, height, status);
+        deleteRenderTarget(target);
+        return false;
+    }
+    return true;
+}
+
+// (Re)creates an immutable RGBA8 texture the compute kernels store into
+// (glBindImageTexture needs glTexStorage2D storage); no framebuffer
+static bool ensureImageTarget(RenderTarget& target, int width, int height) {
+    if (target.texture && target.width == width && target.height == height) {
+        return true;
+    }
+    deleteRenderTarget(target);
+
+    glGenTextures(1, &target.texture);
+    glBindTexture(GL_TEXTURE_2D, target.texture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    GLenum error = glGetError();
+    if (error != GL_NO_ERROR) {
+        LOGE("Edge image %dx%d failed: 0x%x", width, height, error);
+        glDeleteTextures(1, &target.texture);
+        target = RenderTarget();
+        return false;
+    }
+    accountGlMemory(textureBytes(GL_RGBA, width, height));
+    target.width = width;
+    target.height = height;
+    return true;
+}
+
+// ensureRenderTarget for the GPU edge passes, taking a prepared spare of the
+// new size when there is one
+static bool ensureEdgeTarget(RenderTarget& target, int width, int height) {
+    if (!(target.fbo && target.width == width && target.height == height)) {
+        for (auto spare = spareTargets.begin(); spare != spareTargets.end(); ++spare) {
+            if (spare->width == width && spare->height == height) {
+                deleteRenderTarget(target);
+                target = *spare;
+                spareTargets.erase(spare);
+                return true;
+            }
+        }
+    }
+    return ensureRenderTarget(target, width, height);
+}
+
+// Creates a linear-filtered, edge-clamped texture; storage is allocated on first upload.
+// GLES2 allows NPOT textures with CLAMP_TO_EDGE and no mipmaps, so no padding is needed.
+static void createTexture(FrameTexture& tex, GLenum format) {
+    tex.format = format;
+    tex.width = 0;
+    tex.height = 0;
+    tex.edgeResult = 0;
+    glGenTextures(1, &tex.id);
+    glBindTexture(GL_TEXTURE_2D, tex.id);
+    checkGLError("glBindTexture");
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    checkGLError("texture parameters");
+}
+
+static void deleteTexture(FrameTexture& tex) {
+    if (tex.id) {
+        glDeleteTextures(1, &tex.id);
+        tex.id = 0;
+    }
+    accountGlMemory(-textureBytes(tex.format, tex.width, tex.height));
+    tex.width = 0;
+    tex.height = 0;
+}
+
+static void deleteTiledTexture(TiledTexture& tiled) {
+    for (TextureTile& tile : tiled.tiles) {
+        deleteTexture(tile.texture);
+    }
+    tiled = TiledTexture();
+}
+
+// A bank's textures (the secondary stream's, the resident snapshots'),
+// created when it is first drawn
+static void ensureStreamBank(StreamBank& bank) {
+    if (bank.color.id) {
+        return;
+    }
+    createTexture(bank.color, GL_RGBA);
+    createTexture(bank.luma, GL_LUMINANCE);
+    createTexture(bank.chroma, GL_LUMINANCE_ALPHA);
+    createTexture(bank.overlay, GL_LUMINANCE);
+    createTexture(bank.split, GL_LUMINANCE);
+}
+
+static void releaseStreamBank(StreamBank& bank) {
+    deleteTexture(bank.color);
+    deleteTexture(bank.luma);
+    deleteTexture(bank.chroma);
+    deleteTexture(bank.overlay);
+    deleteTexture(bank.split);
+    deleteTiledTexture(bank.tiled);
+    deleteTiledTexture(bank.tiledOverlay);
+    if (bank.markerVbo) {
+        glDeleteBuffers(1, &bank.markerVbo);
+    }
+    deleteRenderTarget(bank.blur);
+    deleteRenderTarget(bank.gradient);
+    deleteRenderTarget(bank.nms);
+    deleteRenderTarget(bank.imageGradient);
+    deleteRenderTarget(bank.imageStates[0]);
+    deleteRenderTarget(bank.imageStates[1]);
+    bank = StreamBank();
+}
+
+static int findSnapshot(int mode) {
+    for (size_t i = 0; i < modeSnapshots.size(); i++) {
+        if (modeSnapshots[i].mode == mode) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+static void deleteSnapshot(size_t index) {
+    deleteTexture(modeSnapshots[index].texture);
+    modeSnapshots.erase(modeSnapshots.begin() + static_cast<std::ptrdiff_t>(index));
+}
+
+static void releaseModeSnapshots() {
+    while (!modeSnapshots.empty()) {
+        deleteSnapshot(modeSnapshots.size() - 1);
+    }
+}
+
+// Drops the snapshots of modes no longer resident, then the least recent
+// ones until extra more bytes fit the budget; false if they cannot
+static bool fitResidencyBudget(int64_t extra) {
+    const uint32_t modes = residentModeMask.load(std::memory_order_relaxed);
+    const int64_t budget = residencyBudget.load(std::memory_order_relaxed);
+    int64_t held = 0;
+    for (size_t i = modeSnapshots.size(); i-- > 0;) {
+        const ModeSnapshot& snapshot = modeSnapshots[i];
+        if (modes >> snapshot.mode & 1) {
+            held += textureBytes(GL_RGB, snapshot.texture.width, snapshot.texture.height);
+        } else {
+            deleteSnapshot(i);
+        }
+    }
+    while (held + extra > budget && !modeSnapshots.empty()) {
+        size_t oldest = 0;
+        for (size_t i = 1; i < modeSnapshots.size(); i++) {
+            if (modeSnapshots[i].takenAt < modeSnapshots[oldest].takenAt) {
+                oldest = i;
+            }
+        }
+        held -= textureBytes(GL_RGB, modeSnapshots[oldest].texture.width, modeSnapshots[oldest].texture.height);
+        deleteSnapshot(oldest);
+    }
+    return held + extra <= budget;
+}
+
+// Once per renderGL: a zero budget releases everything residency holds
+static void applyResidencyBudget() {
+    residencyFrame++;
+    shownMode = -1;
+    if (residencyBudget.load(std::memory_order_relaxed) > 0) {
+        fitResidencyBudget(0);
+    } else if (!modeSnapshots.empty() || residentBank.color.id) {
+        releaseModeSnapshots();
+        releaseStreamBank(residentBank);
+        LOGI("Mode snapshots released");
+    }
+}
+
+// Copies the window, which holds the frame just drawn for mode, into the
+// mode's snapshot (glCopyTexImage2D: GLES2 has no blit)
+static void storeSnapshot(int mode, uint64_t sequence) {
+    if (!(residentModeMask.load(std::memory_order_relaxed) >> mode & 1) || viewportWidth <= 0 ||
+        viewportHeight <= 0) {
+        return;
+    }
+    int index = findSnapshot(mode);
+    if (index >= 0 && (modeSnapshots[index].texture.width != viewportWidth ||
+                       modeSnapshots[index].texture.height != viewportHeight)) {
+        deleteSnapshot(static_cast<size_t>(index));
+        index = -1;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (index < 0) {
+        if (!fitResidencyBudget(textureBytes(GL_RGB, viewportWidth, viewportHeight))) {
+            return;
+        }
+        ModeSnapshot snapshot;
+        snapshot.mode = mode;
+        createTexture(snapshot.texture, GL_RGB);
+        glCopyTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 0, 0, viewportWidth, viewportHeight, 0);
+        accountGlMemory(textureBytes(GL_RGB, viewportWidth, viewportHeight));
+        snapshot.texture.width = viewportWidth;
+        snapshot.texture.height = viewportHeight;
+        modeSnapshots.push_back(snapshot);
+        index = static_cast<int>(modeSnapshots.size()) - 1;
+    } else {
+        glBindTexture(GL_TEXTURE_2D, modeSnapshots[index].texture.id);
+        glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, viewportWidth, viewportHeight);
+    }
+    modeSnapshots[index].sequence = sequence;
+    modeSnapshots[index].takenAt = residencyFrame;
+    checkGLError("mode snapshot");
+}
+
+// After the window pass: the shown mode's snapshot, every kSnapshotFrames
+static void snapshotShownMode() {
+    if (shownMode < 0 || secondaryPipeline || residencyBudget.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+    const int snapshot = findSnapshot(shownMode);
+    if (snapshot < 0 || residencyFrame - modeSnapshots[snapshot].takenAt >= kSnapshotFrames) {
+        storeSnapshot(shownMode, presentedSequence);
+    }
+}
+
+// A snapshot stretched over the area; it already holds the view's orientation
+static void drawSnapshot(const ModeSnapshot& snapshot, int areaX, int areaY, int areaWidth, int areaHeight) {
+    const ShaderProgram* rgbProgram = program(ShaderEffect::RGB);
+    if (!rgbProgram) {
+        return;
+    }
+    ScopedStageTimer drawTimer(Stage::RENDER_DRAW);
+    glViewport(areaX, areaY, areaWidth, areaHeight);
+    glUseProgram(rgbProgram->id);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, snapshot.texture.id);
+    glUniform1i(rgbProgram->samplerLoc, 0);
+    glUniform1i(rgbProgram->singleChannelLoc, 0);
+    glUniform2f(rgbProgram->scaleLoc, 1.0f, 1.0f);
+    glEnableVertexAttribArray(posLoc);
+    glEnableVertexAttribArray(texLoc);
+    glVertexAttribPointer(posLoc, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), verticesNormal);
+    glVertexAttribPointer(texLoc, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), verticesNormal + 2);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glDisableVertexAttribArray(posLoc);
+    glDisableVertexAttribArray(texLoc);
+    checkGLError("draw mode snapshot");
+}
+
+void setModeResidencyGL(uint32_t modes, int64_t budgetBytes) {
+    residentModeMask.store(modes, std::memory_order_relaxed);
+    residencyBudget.store(std::max<int64_t>(budgetBytes, 0), std::memory_order_relaxed);
+}
+
+// Swaps in a prepared spare of the format and size for tex, deleting the old
+// storage; false when there is none
+static bool adoptSpareTexture(FrameTexture& tex, int width, int height) {
+    for (auto spare = spareTextures.begin(); spare != spareTextures.end(); ++spare) {
+        if (spare->format == tex.format && spare->width == width && spare->height == height) {
+            deleteTexture(tex);
+            tex = *spare;
+            spareTextures.erase(spare);
+            LOGI("Texture 0x%x switched to prepared %dx%d", tex.format, width, height);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Uploads a continuous 8-bit frame, reallocating the texture only when the size changes
+static void uploadTexture(FrameTexture& tex, const cv::Mat& pixels) {
+    ScopedGpuTimer gpuTime(gpuTimer, Stage::GPU_UPLOAD);
+    tex.edgeResult = 0;  // the caller tags an edge frame afterwards
+    glBindTexture(GL_TEXTURE_2D, tex.id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if ((tex.width != pixels.cols || tex.height != pixels.rows) && adoptSpareTexture(tex, pixels.cols, pixels.rows)) {
+        glBindTexture(GL_TEXTURE_2D, tex.id);  // storage ready: uploaded like any frame below
+    } else if (tex.width != pixels.cols || tex.height != pixels.rows) {
+        glTexImage2D(GL_TEXTURE_2D, 0, tex.format, pixels.cols, pixels.rows, 0,
+                     tex.format, GL_UNSIGNED_BYTE, pixels.data);
+        checkGLError("glTexImage2D");
+        accountGlMemory(textureBytes(tex.format, pixels.cols, pixels.rows) -
+                        textureBytes(tex.format, tex.width, tex.height));
+        tex.width = pixels.cols;
+        tex.height = pixels.rows;
+        LOGI("Texture 0x%x reallocated to %dx%d", tex.format, tex.width, tex.height);
+        return;
+    }
+    if (pboUploader.upload(tex.id, tex.format, pixels.cols, pixels.rows,
+                           pixels.data, pixels.total() * pixels.elemSize())) {
+        checkGLError("PBO texture upload");
+        return;
+    }
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, pixels.cols, pixels.rows,
+                    tex.format, GL_UNSIGNED_BYTE, pixels.data);
+    checkGLError("texture upload");
+}
+
+// True when a width x height frame needs a TiledTexture on this context
+static bool exceedsTextureSize(int width, int height) {
+    return maxTextureSize > 0 && (width > maxTextureSize || height > maxTextureSize);
+}
+
+// (Re)builds the tile grid for a width x height frame, allocating every
+// tile's storage; a grid of the same format and size is kept as it is
+static void ensureTiledTexture(TiledTexture& tiled, GLenum format, int width, int height) {
+    if (tiled.format == format && tiled.width == width && tiled.height == height && !tiled.tiles.empty()) {
+        return;
+    }
+    deleteTiledTexture(tiled);
+    tiled.format = format;
+    tiled.width = width;
+    tiled.height = height;
+    const int core = std::min(kMaxTileSize, static_cast<int>(maxTextureSize)) - 2;
+    const cv::Rect frame(0, 0, width, height);
+    for (int y = 0; y < height; y += core) {
+        for (int x = 0; x < width; x += core) {
+            TextureTile tile;
+            tile.core = cv::Rect(x, y, std::min(core, width - x), std::min(core, height - y));
+            tile.stored = cv::Rect(x - 1, y - 1, tile.core.width + 2, tile.core.height + 2) & frame;
+            createTexture(tile.texture, format);
+            glTexImage2D(GL_TEXTURE_2D, 0, format, tile.stored.width, tile.stored.height, 0, format,
+                         GL_UNSIGNED_BYTE, nullptr);
+            accountGlMemory(textureBytes(format, tile.stored.width, tile.stored.height));
+            tile.texture.width = tile.stored.width;
+            tile.texture.height = tile.stored.height;
+            tiled.tiles.push_back(tile);
+        }
+    }
+    checkGLError("tiled texture allocation");
+    LOGI("Tiled texture 0x%x for %dx%d: %zu tiles of up to %d px (GL_MAX_TEXTURE_SIZE %d)", format, width, height,
+         tiled.tiles.size(), core, maxTextureSize);
+}
+
+// Uploads a frame into its tile grid one tile at a time. convert produces
+// each tile's contiguous pixels from its part of the frame: a color
+// conversion, or a copy (GLES2 has no GL_UNPACK_ROW_LENGTH). With the PBO
+// ring the driver's DMA of one tile proceeds while the next is converted,
+// instead of one conversion of the whole frame followed by one upload.
+template <typename Convert>
+static void uploadTiledTexture(TiledTexture& tiled, GLenum format, const cv::Mat& pixels, Convert convert) {
+    static thread_local cv::Mat tilePixels;
+    ensureTiledTexture(tiled, format, pixels.cols, pixels.rows);
+    ScopedGpuTimer gpuTime(gpuTimer, Stage::GPU_UPLOAD);
+    for (TextureTile& tile : tiled.tiles) {
+        convert(pixels(tile.stored), tilePixels);
+        if (pboUploader.upload(tile.texture.id, format, tilePixels.cols, tilePixels.rows, tilePixels.data,
+                               tilePixels.total() * tilePixels.elemSize())) {
+            continue;
+        }
+        glBindTexture(GL_TEXTURE_2D, tile.texture.id);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, tilePixels.cols, tilePixels.rows, format, GL_UNSIGNED_BYTE,
+                        tilePixels.data);
+    }
+    checkGLError("tiled texture upload");
+}
+
+static void uploadTiledTexture(TiledTexture& tiled, const cv::Mat& pixels) {
+    uploadTiledTexture(tiled, pixels.channels() == 1 ? GL_LUMINANCE : GL_RGBA, pixels,
+                       [](const cv::Mat& part, cv::Mat& out) { part.copyTo(out); });
+}
+
+// Helper function to get the right vertices for current orientation
+static const GLfloat* getCurrentVertices() {
+    switch (currentOrientation) {
+        case Orientation::NORMAL: return verticesNormal;
+        case Orientation::FLIPPED_V: return verticesFlippedV;
+        case Orientation::ROTATED_90: return verticesRotated90;
+        case Orientation::ROTATED_180: return verticesRotated180;
+        case Orientation::ROTATED_270: return verticesRotated270;
+        default: return verticesFlippedV;
+    }
+}
+
+// Buffer coordinate of upright-frame coordinate (u, v) for a frame rotated
+// clockwise by frameRotation degrees
+static void uprightToBuffer(int frameRotation, GLfloat u, GLfloat v, GLfloat* buffer) {
+    switch (frameRotation) {
+        case 90:  buffer[0] = v;        buffer[1] = 1.0f - u; break;
+        case 180: buffer[0] = 1.0f - u; buffer[1] = 1.0f - v; break;
+        case 270: buffer[0] = 1.0f - v; buffer[1] = u;        break;
+        default:  buffer[0] = u;        buffer[1] = v;        break;
+    }
+}
+
+// Oriented quad for a sensor-native frame: the orientation table maps screen
+// corners to upright-frame coordinates, which are then mapped back into the
+// buffer for the frame's own rotation. This replaces any CPU-side cv::rotate.
+static void buildFrameQuad(int frameRotation, GLfloat* quad) {
+    const GLfloat* vertices = getCurrentVertices();
+    for (int i = 0; i < 16; i += 4) {
+        quad[i] = vertices[i];
+        quad[i + 1] = vertices[i + 1];
+        uprightToBuffer(frameRotation, vertices[i + 2], vertices[i + 3], quad + i + 2);
+    }
+}
+
+// Position on a full-frame quad of buffer coordinate (u, v). The quad is a
+// rectangle with a 0/1 texture coordinate at every corner, so this is affine.
+static void quadPosition(const GLfloat* quad, GLfloat u, GLfloat v, GLfloat& x, GLfloat& y) {
+    const GLfloat* origin = quad;
+    const GLfloat* alongU = quad;
+    const GLfloat* alongV = quad;
+    for (int i = 0; i < 16; i += 4) {
+        bool uOne = quad[i + 2] > 0.5f;
+        bool vOne = quad[i + 3] > 0.5f;
+        if (!uOne && !vOne) origin = quad + i;
+        if (uOne && !vOne) alongU = quad + i;
+        if (!uOne && vOne) alongV = quad + i;
+    }
+    x = origin[0] + u * (alongU[0] - origin[0]) + v * (alongV[0] - origin[0]);
+    y = origin[1] + u * (alongU[1] - origin[1]) + v * (alongV[1] - origin[1]);
+}
+
+// Part of an oriented quad (texture coordinates 0/1 at the corners) that
+// covers one tile: positions on the quad, which is affine as in
+// mapQuadToRegion, and texture coordinates into the tile's stored pixels
+static void tileQuad(const GLfloat* quad, const TiledTexture& tiled, const TextureTile& tile, GLfloat* out) {
+    for (int i = 0; i < 16; i += 4) {
+        const int x = quad[i + 2] > 0.5f ? tile.core.x + tile.core.width : tile.core.x;
+        const int y = quad[i + 3] > 0.5f ? tile.core.y + tile.core.height : tile.core.y;
+        quadPosition(quad, static_cast<GLfloat>(x) / tiled.width, static_cast<GLfloat>(y) / tiled.height, out[i],
+                     out[i + 1]);
+        out[i + 2] = static_cast<GLfloat>(x - tile.stored.x) / tile.stored.width;
+        out[i + 3] = static_cast<GLfloat>(y - tile.stored.y) / tile.stored.height;
+    }
+}
+
+// Shrinks a full-frame quad onto the active layer region; the texture
+// coordinates stay 0..1 because the region texture only holds the ROI
+static void mapQuadToRegion(GLfloat* quad) {
+    GLfloat full[16];
+    std::copy(quad, quad + 16, full);
+    for (int i = 0; i < 16; i += 4) {
+        GLfloat u = layerRegion.u0 + full[i + 2] * (layerRegion.u1 - layerRegion.u0);
+        GLfloat v = layerRegion.v0 + full[i + 3] * (layerRegion.v1 - layerRegion.v0);
+        quadPosition(full, u, v, quad[i], quad[i + 1]);
+    }
+}
+
+// Moves the vertices of an oriented quad by the layer warp: each vertex keeps
+// its texture coordinate and goes where the warp sends its full-frame
+// buffer position on the unmoved quad, so the GPU does the resampling
+static void warpQuad(int frameRotation, GLfloat* quad) {
+    GLfloat full[16];
+    buildFrameQuad(frameRotation, full);
+    for (int i = 0; i < 16; i += 4) {
+        GLfloat u = quad[i + 2];
+        GLfloat v = quad[i + 3];
+        if (layerRegion.active) {
+            u = layerRegion.u0 + u * (layerRegion.u1 - layerRegion.u0);
+            v = layerRegion.v0 + v * (layerRegion.v1 - layerRegion.v0);
+        }
+        layerWarp.apply(u, v);
+        quadPosition(full, u, v, quad[i], quad[i + 1]);
+    }
+}
+
+// Window rectangle of a letterboxed quad (rotations are multiples of 90
+// degrees, so it stays axis-aligned), clamped to the layer area
+static cv::Rect quadWindowRect(const GLfloat* quad, GLfloat scaleX, GLfloat scaleY) {
+    GLfloat minX = 1.0f, maxX = -1.0f, minY = 1.0f, maxY = -1.0f;
+    for (int i = 0; i < 16; i += 4) {
+        minX = std::min(minX, quad[i] * scaleX);
+        maxX = std::max(maxX, quad[i] * scaleX);
+        minY = std::min(minY, quad[i + 1] * scaleY);
+        maxY = std::max(maxY, quad[i + 1] * scaleY);
+    }
+    auto toWindow = [](GLfloat ndc, int origin, int extent) {
+        return origin + static_cast<int>((std::max(-1.0f, std::min(1.0f, ndc)) + 1.0f) * 0.5f * extent);
+    };
+    const int left = toWindow(minX, layerArea.x, layerArea.width);
+    const int bottom = toWindow(minY, layerArea.y, layerArea.height);
+    return cv::Rect(left, bottom, toWindow(maxX, layerArea.x, layerArea.width) - left,
+                    toWindow(maxY, layerArea.y, layerArea.height) - bottom);
+}
+
+// Quad scale that fits a frame into the layer area without distorting it
+// (letterboxed, or cropped to cover the area when it is a fill layer)
+static void letterboxScale(int frameWidth, int frameHeight, int frameRotation, GLfloat& sx, GLfloat& sy) {
+    sx = 1.0f;
+    sy = 1.0f;
+    if (layerArea.width <= 0 || layerArea.height <= 0 || frameWidth <= 0 || frameHeight <= 0) {
+        return;
+    }
+    // 90/270 frame rotations and orientations each swap the frame's axes on screen
+    bool swapAxes = frameRotation == 90 || frameRotation == 270;
+    if (currentOrientation == Orientation::ROTATED_90 ||
+        currentOrientation == Orientation::ROTATED_270) {
+        swapAxes = !swapAxes;
+    }
+    if (swapAxes) {
+        std::swap(frameWidth, frameHeight);
+    }
+    float frameAspect = static_cast<float>(frameWidth) / frameHeight;
+    float viewAspect = static_cast<float>(layerArea.width) / layerArea.height;
+    if (layerArea.fill) {
+        // The quad overflows the area on one axis and the viewport clips it
+        if (frameAspect > viewAspect) {
+            sx = frameAspect / viewAspect;  // crop left and right
+        } else {
+            sy = viewAspect / frameAspect;  // crop top and bottom
+        }
+    } else if (frameAspect > viewAspect) {
+        sy = viewAspect / frameAspect;  // bars top and bottom
+    } else {
+        sx = frameAspect / viewAspect;  // bars left and right
+    }
+}
+
+// ES 3.1 with room for the kernels' 16x16 work groups (the spec minimum is 128
+// invocations)
+static bool contextSupportsComputeEdges() {
+    const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+    int major = 0;
+    int minor = 0;
+    if (!version || sscanf(version, "OpenGL ES %d.%d", &major, &minor) != 2 ||
+        (major < 3 || (major == 3 && minor < 1))) {
+        return false;
+    }
+    GLint invocations = 0;
+    GLint sizeX = 0;
+    GLint sizeY = 0;
+    glGetIntegerv(GL_MAX_COMPUTE_WORK_GROUP_INVOCATIONS, &invocations);
+    glGetIntegeri_v(GL_MAX_COMPUTE_WORK_GROUP_SIZE, 0, &sizeX);
+    glGetIntegeri_v(GL_MAX_COMPUTE_WORK_GROUP_SIZE, 1, &sizeY);
+    return invocations >= 256 && sizeX >= 16 && sizeY >= 16;
+}
+
+// Timer results tagged with a row count: the GPU part of a split frame
+static void onTaggedGpuTime(Stage stage, int64_t tag, uint64_t elapsedNs) {
+    splitBalancer().reportGpu(static_cast<int>(tag), static_cast<int64_t>(elapsedNs));
+}
+
+// What the last context of this thread held, kept across a lost context so
+// initGL rebuilds it up front instead of at the first frames after resume
+struct ResumeState {
+    bool valid = false;
+    uint64_t programs = 0;  // bit per ShaderEffect with a built program
+    FrameTexture textures[5];
+    RenderTarget targets[3];
+    int64_t initMicros = 0;  // set by initGL until the first pipeline frame is drawn
+};
+static thread_local ResumeState resumeState;
+
+// Before the context's objects go; also from initGL, when the old context
+// was lost without cleanupGL and its sizes are still here
+static void recordResumeState() {
+    if (resumeState.valid) {
+        return;
+    }
+    FrameTexture* const textures[] = {&colorTexture, &lumaTexture, &chromaTexture, &overlayTexture, &splitTexture};
+    RenderTarget* const targets[] = {&blurTarget, &gradientTarget, &nmsTarget};
+    resumeState.programs = 0;
+    for (int i = 0; i < static_cast<int>(ShaderEffect::COUNT); i++) {
+        if (programs[i].id) {
+            resumeState.programs |= uint64_t(1) << i;
+        }
+    }
+    for (int i = 0; i < 5; i++) {
+        resumeState.textures[i] = *textures[i];
+    }
+    for (int i = 0; i < 3; i++) {
+        resumeState.targets[i] = *targets[i];
+    }
+    resumeState.valid = resumeState.programs != 0;
+}
+
+// After the textures are created: one pass of program loads and allocations
+static void restoreResumeState() {
+    if (!resumeState.valid) {
+        return;
+    }
+    resumeState.valid = false;
+    FrameTexture* const frameTextures[] = {&colorTexture, &lumaTexture, &chromaTexture, &overlayTexture,
+                                           &splitTexture};
+    RenderTarget* const edgeTargets[] = {&blurTarget, &gradientTarget, &nmsTarget};
+    int built = 0;
+    for (int i = 0; i < static_cast<int>(ShaderEffect::COUNT); i++) {
+        if ((resumeState.programs >> i & 1) && program(static_cast<ShaderEffect>(i))) {
+            built++;
+        }
+    }
+    int textures = 0;
+    for (int i = 0; i < 5; i++) {
+        FrameTexture& tex = *frameTextures[i];
+        const FrameTexture& was = resumeState.textures[i];
+        if (!tex.id || was.width == 0 || was.height == 0) {
+            continue;
+        }
+        glBindTexture(GL_TEXTURE_2D, tex.id);
+        glTexImage2D(GL_TEXTURE_2D, 0, tex.format, was.width, was.height, 0, tex.format, GL_UNSIGNED_BYTE, nullptr);
+        accountGlMemory(textureBytes(tex.format, was.width, was.height));
+        tex.width = was.width;
+        tex.height = was.height;
+        textures++;
+    }
+    int targets = 0;
+    for (int i = 0; i < 3; i++) {
+        RenderTarget& target = *edgeTargets[i];
+        const RenderTarget& was = resumeState.targets[i];
+        target = RenderTarget();  // the ids were the lost context's
+        if (!computeEdges && was.fbo && ensureRenderTarget(target, was.width, was.height)) {
+            targets++;
+        }
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    checkGLError("restore resume state");
+    LOGI("Resume state restored: %d programs, %d textures, %d edge targets", built, textures, targets);
+}
+
+void initGL() {
+    resumeState.initMicros = monotonicMicros();
+    recordResumeState();
+    lastUpload = UploadedFrame();
+    lastOverlayData = nullptr;
+    markerVbo = 0;  // a new context has no buffers
+    lastMarkerData = nullptr;
+    secondaryBank = StreamBank();
+    modeSnapshots.clear();  // their textures went with the old context
+    residentBank = StreamBank();
+    glDisable(GL_DITHER);
+    checkGLError("disable dither");
+
+    // Programs are built lazily per effect; the binary cache makes this cheap
+    // after the first launch. The RGB program is needed right away.
+    computeEdges = contextSupportsComputeEdges();
+    LOGI("GPU edge passes: %s", computeEdges ? "ES 3.1 compute kernels" : "fragment passes");
+    defineShaderEffects();
+    shaderRegistry().onContextCreated();
+    forgetPrograms();
+    if (!program(ShaderEffect::RGB)) {
+        LOGE("Failed to build the RGB program");
+        return;
+    }
+    programsWarmedFor = 0;  // a warm-up requested earlier covers this context too
+    buildRequestedPrograms();
+
+    // Create textures: RGBA for color frames, LUMINANCE for single-channel ones.
+    // Both are sized to the incoming frames on upload.
+    createTexture(colorTexture, GL_RGBA);
+    createTexture(lumaTexture, GL_LUMINANCE);
+    createTexture(chromaTexture, GL_LUMINANCE_ALPHA);
+    createTexture(overlayTexture, GL_LUMINANCE);
+    createTexture(splitTexture, GL_LUMINANCE);
+    tiledTexture = TiledTexture();   // the lost context's tiles; rebuilt on the next oversized frame
+    tiledOverlay = TiledTexture();
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+    LOGI("GL_MAX_TEXTURE_SIZE %d: larger frames are drawn as tiles", maxTextureSize);
+    mosaicTexture = FrameTexture();  // created on the first MOSAIC frame
+    mosaicRevisions.clear();
+    heatTarget = RenderTarget();     // and the heat on the first HEATMAP frame
+    heatSequence = 0;
+    undistortMapTexture = 0;  // a new context has no map either
+    uploadedUndistortMaps.reset();
+    floatMapsSupported = PboUploader::contextSupportsGles3();
+    unpackRowLength = PboUploader::contextSupportsGles3();
+    restoreResumeState();
+
+    // GLES3 backend: stream uploads through PBOs; ES2 keeps client-memory uploads
+    if (PboUploader::contextSupportsGles3() && pboUploader.init()) {
+        LOGI("Using GLES3 PBO upload path");
+    } else {
+        LOGI("Using GLES2 direct upload path");
+    }
+    if (gpuTimer.init()) {
+        gpuTimer.setListener(onTaggedGpuTime);
+    }
+    edgeReadback.init();
+    rectifiedReadback.init();
+
+    LOGI("initGL complete with orientation support");
+}
+
+void resizeGL(int width, int height) {
+    if (width != viewportWidth || height != viewportHeight) {
+        releaseModeSnapshots();  // stretched to the new shape they would look wrong
+    }
+    viewportWidth = width;
+    viewportHeight = height;
+    glViewport(0, 0, width, height);
+    checkGLError("glViewport");
+}
+
+// Packs ROI views so their rows are contiguous; GLES2 has no GL_UNPACK_ROW_LENGTH
+static const cv::Mat& contiguous(const cv::Mat& pixels, cv::Mat& scratch) {
+    if (pixels.isContinuous()) {
+        return pixels;
+    }
+    pixels.copyTo(scratch);
+    return scratch;
+}
+
+// Draws the oriented, letterboxed quad with the given program and bound
+// textures; with tiled, one quad per tile, each with its own texture bound
+// to unit 0
+static void drawFrameQuad(const ShaderProgram& shader, int frameWidth, int frameHeight, int frameRotation,
+                          const TiledTexture* tiled = nullptr) {
+    if (layerRegion.active) {
+        // Letterbox as the full frame, then draw only the region's part of it
+        frameWidth = layerRegion.frameWidth;
+        frameHeight = layerRegion.frameHeight;
+    }
+    GLfloat scaleX, scaleY;
+    letterboxScale(frameWidth, frameHeight, frameRotation, scaleX, scaleY);
+    glUniform2f(shader.scaleLoc, scaleX, scaleY);
+
+    glEnableVertexAttribArray(posLoc);
+    glEnableVertexAttribArray(texLoc);
+
+    // Use vertices based on current orientation and the frame's sensor rotation
+    GLfloat vertices[16];
+    buildFrameQuad(frameRotation, vertices);
+    if (layerWarp.active) {
+        // Clipped to where the unmoved frame would be, so the zoomed, shifted
+        // quad never spills into the letterbox bars
+        const cv::Rect clip = quadWindowRect(vertices, scaleX, scaleY);
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(clip.x, clip.y, clip.width, clip.height);
+        warpQuad(frameRotation, vertices);
+    } else if (layerRegion.active) {
+        mapQuadToRegion(vertices);
+    }
+    if (tiled) {
+        ScopedGpuTimer gpuTime(gpuTimer, Stage::GPU_DRAW);
+        GLfloat tileVertices[16];
+        glVertexAttribPointer(posLoc, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), tileVertices);
+        glVertexAttribPointer(texLoc, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), tileVertices + 2);
+        for (const TextureTile& tile : tiled->tiles) {
+            tileQuad(vertices, *tiled, tile, tileVertices);
+            glBindTexture(GL_TEXTURE_2D, tile.texture.id);
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        }
+    } else {
+        glVertexAttribPointer(posLoc, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), vertices);
+        glVertexAttribPointer(texLoc, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), vertices + 2);
+        ScopedGpuTimer gpuTime(gpuTimer, Stage::GPU_DRAW);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    }
+    checkGLError("draw arrays");
+    if (layerWarp.active) {
+        glDisable(GL_SCISSOR_TEST);
+    }
+
+    glDisableVertexAttribArray(posLoc);
+    glDisableVertexAttribArray(texLoc);
+}
+
+// An edge frame into a texture that holds the detector result it was changed
+// from: only its changed rects go up, one glTexSubImage2D each (strided by
+// GL_UNPACK_ROW_LENGTH on GLES3, packed first on GLES2), so the bytes follow
+// what moved in the scene rather than the resolution. False when the texture
+// holds anything else; the caller uploads the whole frame then.
+static bool uploadChangedRects(FrameTexture& tex, const cv::Mat& pixels, const RenderFrame& frame) {
+    if (frame.edgeResult == 0 || frame.changeBase == 0 || tex.edgeResult != frame.changeBase ||
+        pixels.type() != CV_8UC1 || tex.format != GL_LUMINANCE || tex.width != pixels.cols ||
+        tex.height != pixels.rows) {
+        return false;
+    }
+    static thread_local cv::Mat packed;
+    ScopedGpuTimer gpuTime(gpuTimer, Stage::GPU_UPLOAD);
+    glBindTexture(GL_TEXTURE_2D, tex.id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if (unpackRowLength) {
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(pixels.step[0]));
+    }
+    const cv::Rect bounds(0, 0, pixels.cols, pixels.rows);
+    for (int i = 0; i < frame.changedRects.rows; i++) {
+        const cv::Vec4i& r = frame.changedRects.at<cv::Vec4i>(i);
+        const cv::Rect rect = cv::Rect(r[0], r[1], r[2], r[3]) & bounds;
+        if (rect.empty()) {
+            continue;
+        }
+        const uchar* data = unpackRowLength ? pixels.ptr(rect.y) + rect.x : contiguous(pixels(rect), packed).data;
+        glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x, rect.y, rect.width, rect.height, GL_LUMINANCE, GL_UNSIGNED_BYTE,
+                        data);
+    }
+    if (unpackRowLength) {
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    }
+    checkGLError("changed rect upload");
+    tex.edgeResult = frame.edgeResult;
+    metrics().increment(Counter::PARTIAL_UPLOADS);
+    return true;
+}
+
+// The overlay layer into overlayTexture, once per published overlay; with
+// expand set a 1-bpp bitmap goes up unpacked to 8 bits
+static void uploadOverlayLayer(const RenderFrame& latest, bool expand) {
+    static thread_local cv::Mat packed;
+    static thread_local cv::Mat expanded;
+    if (lastOverlaySequence == latest.sequence && lastOverlayData == latest.overlay.data) {
+        return;
+    }
+    ScopedStageTimer timer(Stage::RENDER_UPLOAD);
+    const int width = latest.bitmapWidth > 0 ? latest.bitmapWidth : latest.overlay.cols;
+    if (exceedsTextureSize(width, latest.overlay.rows)) {
+        if (latest.bitmapWidth > 0) {
+            unpackEdges(latest.overlay, latest.bitmapWidth, expanded);
+        }
+        uploadTiledTexture(tiledOverlay, latest.bitmapWidth > 0 ? expanded : latest.overlay);
+    } else if (latest.bitmapWidth > 0 && expand) {
+        unpackEdges(latest.overlay, latest.bitmapWidth, expanded);
+        uploadTexture(overlayTexture, expanded);
+    } else if (!uploadChangedRects(overlayTexture, latest.overlay, latest)) {
+        uploadTexture(overlayTexture, contiguous(latest.overlay, packed));
+        overlayTexture.edgeResult = latest.edgeResult;
+    }
+    lastOverlaySequence = latest.sequence;
+    lastOverlayData = latest.overlay.data;
+}
+
+// Set by the base layer's draw when it blended the overlay in as well
+static thread_local bool overlayFused = false;
+
+// The fused variant of a base layer program for this frame, or null when the
+// overlay needs its own draw (packed bits, an ROI, another composition, tiles)
+static const ShaderProgram* fusedOverlayProgram(const RenderFrame& latest, ShaderEffect effect) {
+    if (latest.composition != RenderFrame::Composition::OVERLAY || latest.overlay.empty() ||
+        latest.overlay.type() != CV_8UC1 || latest.bitmapWidth > 0 || !latest.region.empty() ||
+        exceedsTextureSize(latest.overlay.cols, latest.overlay.rows)) {
+        return nullptr;
+    }
+    return program(effect);
+}
+
+// Binds the overlay as the fused program's second (third, with chroma) texture
+static void bindFusedOverlay(const RenderFrame& latest, const ShaderProgram& fused, int unit) {
+    uploadOverlayLayer(latest, false);
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_2D, overlayTexture.id);
+    glUniform1i(fused.overlayLoc, unit);
+    glUniform4fv(fused.tintLoc, 1, kOverlayTint);
+    glActiveTexture(GL_TEXTURE0);
+    overlayFused = true;
+}
+
+static void uploadYuvPlanes(const RenderFrame& frame) {
+    static thread_local cv::Mat packedLuma;
+    static thread_local cv::Mat packedChroma;
+    ScopedStageTimer timer(Stage::RENDER_UPLOAD);
+    uploadTexture(lumaTexture, contiguous(frame.image, packedLuma));
+    uploadTexture(chromaTexture, contiguous(frame.chroma, packedChroma));
+}
+
+// Raw camera frames: Y and VU planes go up as-is and the shader does the conversion
+static void renderYuvFrame(const RenderFrame& frame, bool upload) {
+    if (upload) {
+        uploadYuvPlanes(frame);
+    }
+
+    const ShaderProgram* fused = fusedOverlayProgram(frame, ShaderEffect::YUV_OVERLAY);
+    const ShaderProgram& yuvProgram = fused ? *fused : *program(ShaderEffect::YUV);
+    ScopedStageTimer drawTimer(Stage::RENDER_DRAW);
+    glUseProgram(yuvProgram.id);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, lumaTexture.id);
+    glUniform1i(yuvProgram.samplerLoc, 0);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, chromaTexture.id);
+    glUniform1i(yuvProgram.chromaLoc, 1);
+    glActiveTexture(GL_TEXTURE0);
+    if (fused) {
+        bindFusedOverlay(frame, yuvProgram, 2);
+    }
+
+    drawFrameQuad(yuvProgram, frame.image.cols, frame.image.rows, frame.rotation);
+}
+
+// Creates the OES texture the Java SurfaceTexture is constructed around
+static GLuint createExternalTexture() {
+    if (externalTextureId == 0) {
+        glGenTextures(1, &externalTextureId);
+        glBindTexture(GL_TEXTURE_EXTERNAL_OES, externalTextureId);
+        glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        checkGLError("external texture");
+        LOGI("External OES texture created: %u", externalTextureId);
+    }
+    return externalTextureId;
+}
+
+static void releaseSurfaceTexture() {
+    if (surfaceTexture) {
+        surfaceTextureApi().release(surfaceTexture);
+        surfaceTexture = nullptr;
+    }
+}
+
+// Latches the newest camera buffer into the OES texture
+static bool latchExternalFrame(GLfloat* texMatrix) {
+    ScopedStageTimer timer(Stage::RENDER_UPLOAD);
+    int status = surfaceTextureApi().updateTexImage(surfaceTexture);
+    if (status != 0) {
+        LOGE_RATELIMITED("ASurfaceTexture_updateTexImage failed: %d", status);
+        return false;
+    }
+    surfaceTextureApi().getTransformMatrix(surfaceTexture, texMatrix);
+    return true;
+}
+
+// Latches the newest camera buffer and draws it; no pixel ever touches the CPU
+static bool renderExternalFrame() {
+    const ShaderProgram* externalProgram = surfaceTexture ? program(ShaderEffect::EXTERNAL_OES) : nullptr;
+    if (!externalProgram) {
+        return false;
+    }
+    GLfloat texMatrix[16];
+    if (!latchExternalFrame(texMatrix)) {
+        return false;
+    }
+
+    ScopedStageTimer drawTimer(Stage::RENDER_DRAW);
+    glUseProgram(externalProgram->id);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_EXTERNAL_OES, externalTextureId);
+    glUniform1i(externalProgram->samplerLoc, 0);
+    glUniformMatrix4fv(externalProgram->texMatrixLoc, 1, GL_FALSE, texMatrix);
+
+    drawFrameQuad(*externalProgram, externalWidth, externalHeight, 0);
+    return true;
+}
+
+// Runs one offscreen edge pass over the whole frame
+static void runEdgePass(const ShaderProgram& pass, GLuint input, const RenderTarget& output) {
+    glBindFramebuffer(GL_FRAMEBUFFER, output.fbo);
+    glViewport(0, 0, output.width, output.height);
+    glUseProgram(pass.id);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, input);
+    glUniform1i(pass.samplerLoc, 0);
+    glUniform2f(pass.texelSizeLoc, 1.0f / output.width, 1.0f / output.height);
+
+    glEnableVertexAttribArray(posLoc);
+    glEnableVertexAttribArray(texLoc);
+    // Unrotated, unflipped: targets keep the frame's own texel layout
+    glVertexAttribPointer(posLoc, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), verticesNormal);
+    glVertexAttribPointer(texLoc, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), verticesNormal + 2);
+    {
+        ScopedGpuTimer gpuTime(gpuTimer, Stage::GPU_DRAW);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    }
+    glDisableVertexAttribArray(posLoc);
+    glDisableVertexAttribArray(texLoc);
+}
+
+// One compute kernel over the whole frame, 16x16 pixels per work group
+static void runComputePass(const ShaderProgram& pass, GLuint input, const RenderTarget& output) {
+    glUseProgram(pass.id);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, input);
+    glUniform1i(pass.samplerLoc, 0);
+    glBindImageTexture(0, output.texture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RGBA8);
+    {
+        ScopedGpuTimer gpuTime(gpuTimer, Stage::GPU_DRAW);
+        glDispatchCompute((output.width + 15) / 16, (output.height + 15) / 16, 1);
+    }
+    // The next kernel (or the hysteresis draw) samples what this one stored
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+}
+
+// The compute kernels, when the context runs them and all three built
+static bool computeEdgePrograms(const ShaderProgram*& gradient, const ShaderProgram*& nms,
+                                const ShaderProgram*& hysteresis) {
+    if (!computeEdges) {
+        return false;
+    }
+    gradient = program(ShaderEffect::EDGE_GRADIENT_COMPUTE);
+    nms = program(ShaderEffect::EDGE_NMS_COMPUTE);
+    hysteresis = program(ShaderEffect::EDGE_HYSTERESIS_COMPUTE);
+    return gradient && nms && hysteresis;
+}
+
+// The hysteresis pass once more, unrotated into readbackTarget, whose pixels
+// reach the readback consumer a couple of renders later
+static void queueEdgeReadback(const ShaderProgram& hysteresis, const RenderTarget& states, const RenderFrame& frame) {
+    if (!ensureRenderTarget(readbackTarget, states.width, states.height)) {
+        return;
+    }
+    ScopedTrace trace("edge_readback");
+    glUseProgram(hysteresis.id);
+    glUniform2f(hysteresis.scaleLoc, 1.0f, 1.0f);  // shares the letterboxing vertex shader
+    runEdgePass(hysteresis, states.texture, readbackTarget);
+    ReadbackFrame readback;
+    readback.rotation = frame.rotation;
+    readback.sequence = frame.sequence;
+    readback.captureTimestampNs = frame.captureTimestampNs;
+    edgeReadback.queue(readbackTarget.fbo, readbackTarget.width, readbackTarget.height, readback);
+}
+
+// Makes the layer region rows [y0, y1) of a width x height frame
+static void setLayerRows(int width, int height, int y0, int y1) {
+    layerRegion = LayerRegion();
+    layerRegion.active = true;
+    layerRegion.v0 = static_cast<GLfloat>(y0) / height;
+    layerRegion.v1 = static_cast<GLfloat>(y1) / height;
+    layerRegion.frameWidth = width;
+    layerRegion.frameHeight = height;
+}
+
+// EDGE_DETECTION on the GPU: the luma frame goes up once, the blur, Sobel and
+// NMS passes run offscreen (as tiled compute kernels on ES 3.1, which also
+// propagate hysteresis a few steps) and the hysteresis pass writes the
+// visible image. A split frame (RenderFrame::splitEdges) only sends the rows
+// below the CPU's part through the passes, times them for the split
+// balancer, and draws the CPU's rows over the top afterwards.
+static bool renderGpuEdgeFrame(const RenderFrame& frame, bool upload) {
+    const ShaderProgram* blurProgram = program(ShaderEffect::EDGE_BLUR);
+    const ShaderProgram* sobelProgram = program(ShaderEffect::EDGE_SOBEL);
+    const ShaderProgram* nmsProgram = program(ShaderEffect::EDGE_NMS);
+    const ShaderProgram* hysteresisProgram = program(ShaderEffect::EDGE_HYSTERESIS);
+    const ShaderProgram* gradientKernel = nullptr;
+    const ShaderProgram* nmsKernel = nullptr;
+    const ShaderProgram* hysteresisKernel = nullptr;
+    const bool compute = computeEdgePrograms(gradientKernel, nmsKernel, hysteresisKernel);
+    if (!hysteresisProgram || (!compute && (!blurProgram || !sobelProgram || !nmsProgram))) {
+        return false;
+    }
+    static thread_local cv::Mat packed;
+    const int cpuRows = (!layerRegion.active && frame.splitEdges.cols == frame.image.cols &&
+                         frame.splitEdges.rows < frame.image.rows) ? frame.splitEdges.rows : 0;
+    const int gpuFrom = std::max(cpuRows - SplitBalancer::kHaloRows, 0);
+    const cv::Mat gpuRows = frame.image.rowRange(gpuFrom, frame.image.rows);
+    const int width = gpuRows.cols;
+    const int height = gpuRows.rows;
+    if (compute) {
+        if (!ensureImageTarget(imageGradientTarget, width, height) ||
+            !ensureImageTarget(imageStateTargets[0], width, height) ||
+            !ensureImageTarget(imageStateTargets[1], width, height)) {
+            return false;
+        }
+    } else if (!ensureEdgeTarget(blurTarget, width, height) ||
+               !ensureEdgeTarget(gradientTarget, width, height) ||
+               !ensureEdgeTarget(nmsTarget, width, height)) {
+        return false;
+    }
+    // Holds the NMS (or propagated) states across redraws of the same frame
+    const RenderTarget& states = compute ? imageStateTargets[kComputeHysteresisPasses % 2] : nmsTarget;
+
+    ScopedStageTimer drawTimer(Stage::RENDER_DRAW);
+    if (upload) {
+        // One query over the upload and the passes (the ones inside are skipped)
+        ScopedGpuTimer splitTime(gpuTimer, Stage::GPU_DRAW, cpuRows > 0 ? height : 0);
+        {
+            ScopedStageTimer timer(Stage::RENDER_UPLOAD);
+            uploadTexture(lumaTexture, contiguous(gpuRows, packed));
+        }
+        // The states target keeps the result, so unchanged frames only redo the last pass
+        if (compute) {
+            runComputePass(*gradientKernel, lumaTexture.id, imageGradientTarget);
+            runComputePass(*nmsKernel, imageGradientTarget.texture, imageStateTargets[0]);
+            for (int i = 0; i < kComputeHysteresisPasses; i++) {
+                runComputePass(*hysteresisKernel, imageStateTargets[i % 2].texture, imageStateTargets[(i + 1) % 2]);
+            }
+        } else {
+            runEdgePass(*blurProgram, lumaTexture.id, blurTarget);
+            runEdgePass(*sobelProgram, blurTarget.texture, gradientTarget);
+            runEdgePass(*nmsProgram, gradientTarget.texture, nmsTarget);
+        }
+        checkGLError("edge passes");
+        if (drawingDefaultPipeline && edgeReadback.isActive() && edgeReadbackWanted() && cpuRows == 0) {
+            queueEdgeReadback(*hysteresisProgram, states, frame);
+        }
+        if (cpuRows > 0) {
+            ScopedStageTimer timer(Stage::RENDER_UPLOAD);
+            uploadTexture(splitTexture, contiguous(frame.splitEdges, packed));
+        }
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, layerFramebuffer);
+    glViewport(layerArea.x, layerArea.y, layerArea.width, layerArea.height);
+    if (cpuRows > 0) {
+        setLayerRows(frame.image.cols, frame.image.rows, gpuFrom, frame.image.rows);
+    }
+    glUseProgram(hysteresisProgram->id);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, states.texture);
+    glUniform1i(hysteresisProgram->samplerLoc, 0);
+    glUniform2f(hysteresisProgram->texelSizeLoc, 1.0f / width, 1.0f / height);
+    drawFrameQuad(*hysteresisProgram, width, height, frame.rotation);
+    if (cpuRows > 0) {
+        // Opaque over the GPU part's halo rows
+        const ShaderProgram& rgbProgram = *program(ShaderEffect::RGB);
+        setLayerRows(frame.image.cols, frame.image.rows, 0, cpuRows);
+        glUseProgram(rgbProgram.id);
+        glBindTexture(GL_TEXTURE_2D, splitTexture.id);
+        glUniform1i(rgbProgram.samplerLoc, 0);
+        glUniform1i(rgbProgram.singleChannelLoc, 1);
+        drawFrameQuad(rgbProgram, splitTexture.width, splitTexture.height, frame.rotation);
+        clearLayerRegion();
+    }
+    return true;
+}
+
+// Edges of the external camera texture without any upload or readback: the
+// OES frame is drawn into an RGBA target (top row first, like uploaded
+// frames), the CL-GL kernels write the edge texture, and that is displayed
+// like the raw OES layer. False when CL-GL sharing is unavailable.
+static bool renderClGlEdgeFrame() {
+    const ShaderProgram* externalProgram = surfaceTexture ? program(ShaderEffect::EXTERNAL_OES) : nullptr;
+    const int width = externalWidth;
+    const int height = externalHeight;
+    if (!externalProgram || width <= 0 || height <= 0 || !clGlInteropInit() ||
+        !ensureRenderTarget(cameraTarget, width, height) || !ensureRenderTarget(clEdgesTarget, width, height)) {
+        return false;
+    }
+    GLfloat texMatrix[16];
+    if (!latchExternalFrame(texMatrix)) {
+        return false;
+    }
+
+    ScopedStageTimer drawTimer(Stage::RENDER_DRAW);
+    glBindFramebuffer(GL_FRAMEBUFFER, cameraTarget.fbo);
+    glViewport(0, 0, width, height);
+    glUseProgram(externalProgram->id);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_EXTERNAL_OES, externalTextureId);
+    glUniform1i(externalProgram->samplerLoc, 0);
+    glUniformMatrix4fv(externalProgram->texMatrixLoc, 1, GL_FALSE, texMatrix);
+    glUniform2f(externalProgram->scaleLoc, 1.0f, 1.0f);
+    glEnableVertexAttribArray(posLoc);
+    glEnableVertexAttribArray(texLoc);
+    glVertexAttribPointer(posLoc, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), verticesNormal);
+    glVertexAttribPointer(texLoc, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), verticesNormal + 2);
+    {
+        ScopedGpuTimer gpuTime(gpuTimer, Stage::GPU_DRAW);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    }
+    glDisableVertexAttribArray(posLoc);
+    glDisableVertexAttribArray(texLoc);
+    glBindFramebuffer(GL_FRAMEBUFFER, layerFramebuffer);
+    glViewport(layerArea.x, layerArea.y, layerArea.width, layerArea.height);
+
+    int low, high;
+    currentCannyThresholds(low, high);
+    // On failure the plain camera frame in cameraTarget is shown instead
+    bool edges = clGlDetectEdges(cameraTarget.texture, clEdgesTarget.texture, width, height,
+                                 low / 255.0f, high / 255.0f);
+
+    const ShaderProgram& rgbProgram = *program(ShaderEffect::RGB);
+    glUseProgram(rgbProgram.id);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, edges ? clEdgesTarget.texture : cameraTarget.texture);
+    glUniform1i(rgbProgram.samplerLoc, 0);
+    glUniform1i(rgbProgram.singleChannelLoc, 0);
+    drawFrameQuad(rgbProgram, width, height, 0);
+    return true;
+}
+
+struct EglImageApi {
+    PFNEGLGETNATIVECLIENTBUFFERANDROIDPROC getNativeClientBuffer = nullptr;
+    PFNEGLCREATEIMAGEKHRPROC createImage = nullptr;
+    PFNEGLDESTROYIMAGEKHRPROC destroyImage = nullptr;
+    PFNGLEGLIMAGETARGETTEXTURE2DOESPROC targetTexture = nullptr;
+    // EGL_ANDROID_native_fence_sync, for handing sampled buffers back to the CPU
+    PFNEGLCREATESYNCKHRPROC createSync = nullptr;
+    PFNEGLDESTROYSYNCKHRPROC destroySync = nullptr;
+    PFNEGLDUPNATIVEFENCEFDANDROIDPROC dupNativeFence = nullptr;
+
+    bool available() const { return getNativeClientBuffer && createImage && destroyImage && targetTexture; }
+    bool fences() const { return createSync && destroySync && dupNativeFence; }
+};
+
+static const EglImageApi& eglImageApi() {
+    static const EglImageApi api = [] {
+        EglImageApi loaded;
+        loaded.getNativeClientBuffer = reinterpret_cast<PFNEGLGETNATIVECLIENTBUFFERANDROIDPROC>(
+                eglGetProcAddress("eglGetNativeClientBufferANDROID"));
+        loaded.createImage = reinterpret_cast<PFNEGLCREATEIMAGEKHRPROC>(eglGetProcAddress("eglCreateImageKHR"));
+        loaded.destroyImage = reinterpret_cast<PFNEGLDESTROYIMAGEKHRPROC>(eglGetProcAddress("eglDestroyImageKHR"));
+        loaded.targetTexture = reinterpret_cast<PFNGLEGLIMAGETARGETTEXTURE2DOESPROC>(
+                eglGetProcAddress("glEGLImageTargetTexture2DOES"));
+        const char* extensions = eglQueryString(eglGetCurrentDisplay(), EGL_EXTENSIONS);
+        if (extensions && strstr(extensions, "EGL_ANDROID_native_fence_sync")) {
+            loaded.createSync = reinterpret_cast<PFNEGLCREATESYNCKHRPROC>(eglGetProcAddress("eglCreateSyncKHR"));
+            loaded.destroySync = reinterpret_cast<PFNEGLDESTROYSYNCKHRPROC>(eglGetProcAddress("eglDestroySyncKHR"));
+            loaded.dupNativeFence = reinterpret_cast<PFNEGLDUPNATIVEFENCEFDANDROIDPROC>(
+                    eglGetProcAddress("eglDupNativeFenceFDANDROID"));
+        }
+        if (!loaded.available()) {
+            LOGW("⚠️ EGL_ANDROID_get_native_client_buffer unavailable, no AHardwareBuffer display");
+        }
+        return loaded;
+    }();
+    return api;
+}
+
+static void releaseBufferTexture(BufferTexture& entry) {
+    if (entry.texture) {
+        glDeleteTextures(1, &entry.texture);
+    }
+    if (entry.image != EGL_NO_IMAGE_KHR) {
+        eglImageApi().destroyImage(eglGetCurrentDisplay(), entry.image);
+    }
+    entry = BufferTexture();
+}
+
+static void releaseBufferTextures() {
+    for (BufferTexture& entry : bufferTextures) {
+        releaseBufferTexture(entry);
+    }
+    for (auto& recent : recentSharedEdges) {
+        recent.reset();
+    }
+    for (auto& recent : recentHardwareFrames) {
+        recent.reset();
+    }
+    nextBufferTexture = 0;
+}
+
+// Texture of buffer, wrapping it on first sight; 0 when EGL cannot
+static GLuint bufferTexture(AHardwareBuffer* buffer) {
+    for (const BufferTexture& entry : bufferTextures) {
+        if (entry.buffer == buffer) {
+            return entry.texture;
+        }
+    }
+    const EglImageApi& api = eglImageApi();
+    if (!api.available()) {
+        return 0;
+    }
+    BufferTexture& entry = bufferTextures[nextBufferTexture];
+    nextBufferTexture = (nextBufferTexture + 1) % kBufferTextures;
+    releaseBufferTexture(entry);
+    const EGLint attributes[] = {EGL_IMAGE_PRESERVED_KHR, EGL_TRUE, EGL_NONE};
+    entry.image = api.createImage(eglGetCurrentDisplay(), EGL_NO_CONTEXT, EGL_NATIVE_BUFFER_ANDROID,
+                                  api.getNativeClientBuffer(buffer), attributes);
+    if (entry.image == EGL_NO_IMAGE_KHR) {
+        LOGE_RATELIMITED("❌ eglCreateImageKHR failed for a hardware buffer: 0x%x", eglGetError());
+        return 0;
+    }
+    entry.buffer = buffer;
+    glGenTextures(1, &entry.texture);
+    glBindTexture(GL_TEXTURE_2D, entry.texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    api.targetTexture(GL_TEXTURE_2D, static_cast<GLeglImageOES>(entry.image));
+    checkGLError("shared edge texture");
+    return entry.texture;
+}
+
+// Vulkan edges: no upload, the buffer is sampled in place (the producer
+// waited for its GPU work before publishing it)
+static bool renderSharedEdgeFrame(const std::shared_ptr<const SharedEdgeImage>& edges, int rotation) {
+    const GLuint texture = bufferTexture(edges->buffer);
+    if (!texture) {
+        return false;
+    }
+    recentSharedEdges[1] = std::move(recentSharedEdges[0]);
+    recentSharedEdges[0] = edges;
+
+    ScopedStageTimer drawTimer(Stage::RENDER_DRAW);
+    const ShaderProgram& rgbProgram = *program(ShaderEffect::RGB);
+    glUseProgram(rgbProgram.id);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glUniform1i(rgbProgram.samplerLoc, 0);
+    glUniform1i(rgbProgram.singleChannelLoc, 0);
+    drawFrameQuad(rgbProgram, edges->width, edges->height, rotation);
+    return true;
+}
+
+// Native fence after the draws queued so far, left on frame for its next CPU
+// write to wait on (replacing an older one: GL completes in order). Without
+// the extension the producers' rings rely on recentHardwareFrames alone.
+static void fenceHardwareFrame(const HardwareFrame& frame) {
+    const EglImageApi& api = eglImageApi();
+    if (!api.fences()) {
+        return;
+    }
+    const EGLDisplay display = eglGetCurrentDisplay();
+    const EGLint attributes[] = {EGL_SYNC_NATIVE_FENCE_FD_ANDROID, EGL_NO_NATIVE_FENCE_FD_ANDROID, EGL_NONE};
+    EGLSyncKHR sync = api.createSync(display, EGL_SYNC_NATIVE_FENCE_ANDROID, attributes);
+    if (sync == EGL_NO_SYNC_KHR) {
+        return;
+    }
+    glFlush();  // the fence fd only exists once the sync is submitted
+    const int fence = api.dupNativeFence(display, sync);
+    api.destroySync(display, sync);
+    if (fence == EGL_NO_NATIVE_FENCE_FD_ANDROID) {
+        return;
+    }
+    const int previous = frame.readFence.exchange(fence);
+    if (previous >= 0) {
+        close(previous);
+    }
+}
+
+// A frame the processing thread already wrote into a hardware buffer: sampled
+// in place, with no conversion or upload. False when EGL cannot wrap it.
+static bool renderHardwareFrame(const std::shared_ptr<const HardwareFrame>& frame, int rotation) {
+    const GLuint texture = bufferTexture(frame->buffer);
+    if (!texture) {
+        return false;
+    }
+    recentHardwareFrames[1] = std::move(recentHardwareFrames[0]);
+    recentHardwareFrames[0] = frame;
+
+    ScopedStageTimer drawTimer(Stage::RENDER_DRAW);
+    const ShaderProgram& rgbProgram = *program(ShaderEffect::RGB);
+    glUseProgram(rgbProgram.id);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glUniform1i(rgbProgram.samplerLoc, 0);
+    glUniform1i(rgbProgram.singleChannelLoc, frame->singleChannel ? 1 : 0);
+    drawFrameQuad(rgbProgram, frame->width, frame->height, rotation);
+    fenceHardwareFrame(*frame);
+    metrics().increment(Counter::FRAMES_ZERO_COPY);
+    return true;
+}
+
+// CPU side of the texture path: the frame as 8-bit RGBA or single-channel
+// pixels into rgba, converted where needed
+static bool convertFrame(const RenderFrame& latest, cv::Mat& rgba) {
+    static thread_local cv::Mat cpuEdges;
+    const cv::Mat& frame = latest.image;
+    try {
+        ScopedStageTimer timer(Stage::RENDER_CONVERT);
+        if (latest.bitmapWidth > 0) {
+            // No packed edge program: expand the bitmap here instead
+            unpackEdges(frame, latest.bitmapWidth, cpuEdges);
+            rgba = cpuEdges;
+        } else if (latest.detectEdgesOnGpu) {
+            // No usable GPU passes: run the CPU detector on the luma instead
+            detectEdges(frame, cpuEdges);
+            rgba = cpuEdges;
+        } else if (latest.isYuv()) {
+            // No YUV program on this device: convert the planes here instead
+            cv::cvtColorTwoPlane(frame, latest.chroma, rgba, cv::COLOR_YUV2RGBA_NV21);
+        } else {
+            switch (frame.channels()) {
+                case 1:
+                    rgba = frame;
+                    break;
+                case 3:
+                    cv::cvtColor(frame, rgba, cv::COLOR_BGR2RGBA);
+                    break;
+                case 4:
+                    rgba = frame;
+                    break;
+                default:
+                    LOGE_RATELIMITED("Unsupported frame channel count: %d", frame.channels());
+                    return false;
+            }
+        }
+    } catch (const cv::Exception& e) {
+        LOGE_RATELIMITED("OpenCV color conversion failed: %s", e.what());
+        return false;
+    }
+    return true;
+}
+
+// Uploads at native resolution (scaling happens in the vertex stage)
+static bool convertAndUpload(const RenderFrame& latest, FrameTexture& texture) {
+    static thread_local cv::Mat rgba;
+    static thread_local cv::Mat packed;
+    if (!convertFrame(latest, rgba)) {
+        return false;
+    }
+    ScopedStageTimer timer(Stage::RENDER_UPLOAD);
+    uploadTexture(texture, contiguous(rgba, packed));
+    return true;
+}
+
+// The same into tiledTexture for frames beyond maxTextureSize. BGR frames
+// are converted tile by tile as they go up; the others are converted whole
+// first (NV21 and packed bits do not split on arbitrary tile bounds).
+static bool convertAndUploadTiles(const RenderFrame& latest) {
+    static thread_local cv::Mat rgba;
+    const cv::Mat& frame = latest.image;
+    if (!latest.isYuv() && latest.bitmapWidth == 0 && !latest.detectEdgesOnGpu && frame.channels() == 3) {
+        ScopedStageTimer timer(Stage::RENDER_UPLOAD);
+        try {
+            uploadTiledTexture(tiledTexture, GL_RGBA, frame, [](const cv::Mat& part, cv::Mat& out) {
+                cv::cvtColor(part, out, cv::COLOR_BGR2RGBA);
+            });
+        } catch (const cv::Exception& e) {
+            LOGE_RATELIMITED("OpenCV color conversion failed: %s", e.what());
+            return false;
+        }
+        return true;
+    }
+    if (!convertFrame(latest, rgba)) {
+        return false;
+    }
+    ScopedStageTimer timer(Stage::RENDER_UPLOAD);
+    uploadTiledTexture(tiledTexture, rgba);
+    return true;
+}
+
+static void releaseUndistortMap() {
+    if (undistortMapTexture) {
+        glDeleteTextures(1, &undistortMapTexture);
+        accountGlMemory(-static_cast<int64_t>(uploadedUndistortMaps->gpu.total() *
+                                              uploadedUndistortMaps->gpu.elemSize()));
+        undistortMapTexture = 0;
+    }
+    uploadedUndistortMaps.reset();
+}
+
+// Undistortion map of a width x height layer, uploaded when it is not the one
+// the texture holds; 0 when undistortion cannot run for this frame
+static GLuint undistortMap(const RenderFrame& latest, int width, int height) {
+    if (!latest.undistort || !floatMapsSupported) {
+        return 0;
+    }
+    std::shared_ptr<const LensUndistortion::Maps> maps = lensUndistortion().gpuMaps(cv::Size(width, height));
+    if (!maps) {
+        return 0;
+    }
+    if (maps == uploadedUndistortMaps) {
+        return undistortMapTexture;
+    }
+    releaseUndistortMap();
+    ScopedStageTimer timer(Stage::RENDER_UPLOAD);
+    glGenTextures(1, &undistortMapTexture);
+    glBindTexture(GL_TEXTURE_2D, undistortMapTexture);
+    // RG32F is not filterable in ES3; one map texel per frame pixel needs no filtering
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RG32F, width, height, 0, GL_RG, GL_FLOAT, maps->gpu.data);
+    GLenum error = glGetError();
+    if (error != GL_NO_ERROR) {
+        LOGE("Undistortion map %dx%d upload failed: 0x%x", width, height, error);
+        glDeleteTextures(1, &undistortMapTexture);
+        undistortMapTexture = 0;
+        floatMapsSupported = false;  // not retried every frame
+        return 0;
+    }
+    accountGlMemory(static_cast<int64_t>(maps->gpu.total() * maps->gpu.elemSize()));
+    uploadedUndistortMaps = maps;
+    return undistortMapTexture;
+}
+
+// A packed edge texture (EDGE_BITS) drawn at its logical size: opaque gray, or
+// the overlay tint with blending when opaque is false
+static void drawBitmapQuad(const ShaderProgram& bitsProgram, const FrameTexture& texture, int bitmapWidth,
+                           bool opaque, int rotation) {
+    glUseProgram(bitsProgram.id);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture.id);
+    glUniform1i(bitsProgram.samplerLoc, 0);
+    glUniform2f(bitsProgram.bitsSizeLoc, static_cast<GLfloat>(bitmapWidth), static_cast<GLfloat>(texture.height));
+    glUniform1f(bitsProgram.rowBytesLoc, static_cast<GLfloat>(texture.width));
+    glUniform1i(bitsProgram.singleChannelLoc, opaque ? 1 : 0);
+    if (!opaque) {
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glUniform4fv(bitsProgram.tintLoc, 1, kOverlayTint);
+    }
+    drawFrameQuad(bitsProgram, bitmapWidth, texture.height, rotation);
+}
+
+static void releaseHeatTarget() {
+    if (heatTarget.fbo) {
+        glDeleteFramebuffers(1, &heatTarget.fbo);
+    }
+    if (heatTarget.texture) {
+        glDeleteTextures(1, &heatTarget.texture);
+        accountGlMemory(-(heatHalfFloat ? 2 : 1) * textureBytes(GL_RGBA, heatTarget.width, heatTarget.height));
+    }
+    heatTarget = RenderTarget();
+    heatSequence = 0;
+}
+
+// (Re)creates the heat target, cleared, when the edge map size changes.
+// RGBA16F is color-renderable only with EXT_color_buffer_(half_)float, so an
+// incomplete half-float framebuffer falls back to RGBA8.
+static bool ensureHeatTarget(int width, int height) {
+    if (heatTarget.fbo && heatTarget.width == width && heatTarget.height == height) {
+        return true;
+    }
+    releaseHeatTarget();
+    for (int attempt = floatMapsSupported ? 0 : 1; attempt < 2; attempt++) {
+        const bool halfFloat = attempt == 0;
+        glGenTextures(1, &heatTarget.texture);
+        glBindTexture(GL_TEXTURE_2D, heatTarget.texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, halfFloat ? GL_RGBA16F : GL_RGBA, width, height, 0, GL_RGBA,
+                     halfFloat ? GL_HALF_FLOAT : GL_UNSIGNED_BYTE, nullptr);
+        glGenFramebuffers(1, &heatTarget.fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, heatTarget.fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, heatTarget.texture, 0);
+        const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        if (glGetError() == GL_NO_ERROR && status == GL_FRAMEBUFFER_COMPLETE) {
+            glClear(GL_COLOR_BUFFER_BIT);
+            glBindFramebuffer(GL_FRAMEBUFFER, layerFramebuffer);
+            heatHalfFloat = halfFloat;
+            heatTarget.width = width;
+            heatTarget.height = height;
+            accountGlMemory((halfFloat ? 2 : 1) * textureBytes(GL_RGBA, width, height));
+            LOGI("Heat target %dx%d %s", width, height, halfFloat ? "RGBA16F" : "RGBA8");
+            return true;
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, layerFramebuffer);
+        glDeleteFramebuffers(1, &heatTarget.fbo);
+        glDeleteTextures(1, &heatTarget.texture);
+        heatTarget = RenderTarget();
+    }
+    LOGE_RATELIMITED("Heat target %dx%d unavailable", width, height);
+    return false;
+}
+
+// HEATMAP: each new edge frame goes up like any single-channel frame and is
+// drawn once into the heat target with (GL_ONE, GL_CONSTANT_ALPHA) blending,
+// the constant's alpha being the decay, so adding the frame and decaying the
+// heat already there is one draw over the frame; no float pixel is touched on
+// the CPU. The heat is then drawn through the colormap like any layer, and
+// redraws of the same sequence only redo that draw.
+static bool renderHeatmapFrame(const RenderFrame& latest) {
+    const ShaderProgram* accumulate = program(ShaderEffect::HEAT_ACCUMULATE);
+    const ShaderProgram* colormap = program(ShaderEffect::HEAT_COLORMAP);
+    const int width = latest.bitmapWidth > 0 ? latest.bitmapWidth : latest.image.cols;
+    const int height = latest.image.rows;
+    if (!accumulate || !colormap || latest.image.empty() || exceedsTextureSize(width, height) ||
+        !ensureHeatTarget(width, height)) {
+        return false;
+    }
+    if (heatGeneration != latest.heatGeneration) {
+        glBindFramebuffer(GL_FRAMEBUFFER, heatTarget.fbo);
+        glClear(GL_COLOR_BUFFER_BIT);
+        heatGeneration = latest.heatGeneration;
+        heatSequence = 0;
+    }
+
+    ScopedStageTimer drawTimer(Stage::RENDER_DRAW);
+    if (latest.sequence != heatSequence) {
+        heatSequence = latest.sequence;
+        if (!isAlreadyUploaded(latest)) {
+            static thread_local cv::Mat packed;
+            ScopedStageTimer timer(Stage::RENDER_UPLOAD);
+            uploadTexture(lumaTexture, contiguous(latest.image, packed));
+            rememberUpload(latest);
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, heatTarget.fbo);
+        glViewport(0, 0, heatTarget.width, heatTarget.height);
+        glUseProgram(accumulate->id);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, lumaTexture.id);
+        glUniform1i(accumulate->samplerLoc, 0);
+        glUniform2f(accumulate->bitsSizeLoc, static_cast<GLfloat>(width), static_cast<GLfloat>(height));
+        glUniform1f(accumulate->rowBytesLoc, latest.bitmapWidth > 0 ? static_cast<GLfloat>(lumaTexture.width) : 0.0f);
+        glUniform1f(accumulate->weightLoc, 1.0f - latest.heatDecay);
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_CONSTANT_ALPHA);
+        glBlendColor(0.0f, 0.0f, 0.0f, latest.heatDecay);
+        glEnableVertexAttribArray(posLoc);
+        glEnableVertexAttribArray(texLoc);
+        // Unrotated, like the edge pass targets
+        glVertexAttribPointer(posLoc, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), verticesNormal);
+        glVertexAttribPointer(texLoc, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), verticesNormal + 2);
+        {
+            ScopedGpuTimer gpuTime(gpuTimer, Stage::GPU_DRAW);
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        }
+        glDisableVertexAttribArray(posLoc);
+        glDisableVertexAttribArray(texLoc);
+        glDisable(GL_BLEND);
+        checkGLError("heat accumulation");
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, layerFramebuffer);
+    glViewport(layerArea.x, layerArea.y, layerArea.width, layerArea.height);
+    glUseProgram(colormap->id);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, heatTarget.texture);
+    glUniform1i(colormap->samplerLoc, 0);
+    glUniform1f(colormap->gainLoc, latest.heatGain);
+    glUniform1f(colormap->floorLoc, heatHalfFloat ? 0.0f : 0.5f / (255.0f * (1.0f - latest.heatDecay)));
+    drawFrameQuad(*colormap, heatTarget.width, heatTarget.height, latest.rotation);
+    return true;
+}
+
+// FOCUS_PEAK: the camera frame and its peaking in one draw, from the planes
+// the raw layer uploads anyway (Y + VU, or RGBA where the frame has no YUV)
+static bool renderFocusPeakFrame(const RenderFrame& latest, bool upload) {
+    const ShaderProgram* peak = program(ShaderEffect::FOCUS_PEAK);
+    const bool yuv = latest.isYuv();
+    if (!peak || (!yuv && latest.image.channels() == 1)) {
+        return false;
+    }
+    if (upload) {
+        if (yuv) {
+            uploadYuvPlanes(latest);
+        } else if (!convertAndUpload(latest, colorTexture)) {
+            return false;
+        }
+    }
+    const FrameTexture& texture = yuv ? lumaTexture : colorTexture;
+    ScopedStageTimer drawTimer(Stage::RENDER_DRAW);
+    glUseProgram(peak->id);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture.id);
+    glUniform1i(peak->samplerLoc, 0);
+    if (yuv) {
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, chromaTexture.id);
+        glUniform1i(peak->chromaLoc, 1);
+        glActiveTexture(GL_TEXTURE0);
+    }
+    glUniform1i(peak->yuvLoc, yuv ? 1 : 0);
+    glUniform2f(peak->texelSizeLoc, 1.0f / texture.width, 1.0f / texture.height);
+    glUniform1f(peak->thresholdLoc, latest.peakThreshold);
+    glUniform4f(peak->tintLoc, latest.peakColor[0], latest.peakColor[1], latest.peakColor[2], latest.peakColor[3]);
+    drawFrameQuad(*peak, latest.image.cols, latest.image.rows, latest.rotation);
+    return true;
+}
+
+// Draws the main layer of a frame into the current layer area; false if
+// nothing could be drawn
+// MOSAIC: tiles whose revision differs from the one uploaded go into the
+// canvas texture with glTexSubImage2D; the rest of the canvas stays as it
+// is, so a frame uploads what it changed rather than the whole mosaic. A new
+// generation (or a new context) starts from a cleared texture.
+static bool renderMosaicFrame(const RenderFrame& latest) {
+    const MosaicView& view = *latest.mosaic;
+    if (view.canvasSize.empty() || view.tiles.empty()) {
+        return false;
+    }
+    if (!mosaicTexture.id) {
+        createTexture(mosaicTexture, GL_LUMINANCE);
+    }
+    glBindTexture(GL_TEXTURE_2D, mosaicTexture.id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    {
+        ScopedStageTimer timer(Stage::RENDER_UPLOAD);
+        ScopedGpuTimer gpuTime(gpuTimer, Stage::GPU_UPLOAD);
+        if (mosaicTexture.width != view.canvasSize.width || mosaicTexture.height != view.canvasSize.height ||
+            mosaicGeneration != view.generation) {
+            const cv::Mat cleared = cv::Mat::zeros(view.canvasSize, CV_8UC1);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, cleared.cols, cleared.rows, 0, GL_LUMINANCE,
+                         GL_UNSIGNED_BYTE, cleared.data);
+            checkGLError("mosaic glTexImage2D");
+            accountGlMemory(textureBytes(GL_LUMINANCE, cleared.cols, cleared.rows) -
+                            textureBytes(GL_LUMINANCE, mosaicTexture.width, mosaicTexture.height));
+            mosaicTexture.width = cleared.cols;
+            mosaicTexture.height = cleared.rows;
+            mosaicGeneration = view.generation;
+            mosaicRevisions.assign(view.tiles.size(), 0);
+        }
+        for (size_t i = 0; i < view.tiles.size(); i++) {
+            const std::shared_ptr<const MosaicTile>& tile = view.tiles[i];
+            if (!tile || tile->revision == mosaicRevisions[i]) {
+                continue;
+            }
+            const int x = static_cast<int>(i % static_cast<size_t>(view.columns)) * view.tileSize;
+            const int y = static_cast<int>(i / static_cast<size_t>(view.columns)) * view.tileSize;
+            glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, tile->pixels.cols, tile->pixels.rows, GL_LUMINANCE,
+                            GL_UNSIGNED_BYTE, tile->pixels.data);
+            mosaicRevisions[i] = tile->revision;
+        }
+        checkGLError("mosaic tile upload");
+    }
+
+    const ShaderProgram& rgbProgram = *program(ShaderEffect::RGB);
+    ScopedStageTimer drawTimer(Stage::RENDER_DRAW);
+    glUseProgram(rgbProgram.id);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, mosaicTexture.id);
+    glUniform1i(rgbProgram.samplerLoc, 0);
+    glUniform1i(rgbProgram.singleChannelLoc, 1);
+    drawFrameQuad(rgbProgram, mosaicTexture.width, mosaicTexture.height, latest.rotation);
+    return true;
+}
+
+static bool drawFrameLayer(RenderFrame& latest) {
+    if (latest.useExternalTexture) {
+        if (latest.detectEdgesOnGpu && renderClGlEdgeFrame()) {
+            return true;
+        }
+        return renderExternalFrame();
+    }
+    if (latest.sharedEdges) {
+        return renderSharedEdgeFrame(latest.sharedEdges, latest.rotation);
+    }
+    if (latest.hardwareFrame && renderHardwareFrame(latest.hardwareFrame, latest.rotation)) {
+        return true;
+    }
+    if (latest.mosaic) {
+        return renderMosaicFrame(latest);
+    }
+    if (latest.heatmap && renderHeatmapFrame(latest)) {
+        return true;
+    }
+
+    const cv::Mat& frame = latest.image;
+    if (frame.data == nullptr || frame.cols <= 0 || frame.rows <= 0) {
+        LOGE_RATELIMITED("Invalid frame data");
+        return false;
+    }
+
+    bool reused = isAlreadyUploaded(latest);
+    if (reused) {
+        metrics().increment(Counter::FRAMES_REUSED);
+    }
+
+    // Beyond GL_MAX_TEXTURE_SIZE only the tiled RGB path below can show the
+    // frame: the YUV, GPU edge and packed bit paths each want one texture
+    if (exceedsTextureSize(latest.bitmapWidth > 0 ? latest.bitmapWidth : frame.cols, frame.rows)) {
+        if (!reused && !convertAndUploadTiles(latest)) {
+            return false;
+        }
+        rememberUpload(latest);
+        const ShaderProgram& rgbProgram = *program(ShaderEffect::RGB);
+        ScopedStageTimer drawTimer(Stage::RENDER_DRAW);
+        glUseProgram(rgbProgram.id);
+        glActiveTexture(GL_TEXTURE0);
+        glUniform1i(rgbProgram.samplerLoc, 0);
+        glUniform1i(rgbProgram.singleChannelLoc, tiledTexture.format == GL_LUMINANCE ? 1 : 0);
+        drawFrameQuad(rgbProgram, tiledTexture.width, tiledTexture.height, latest.rotation, &tiledTexture);
+        return true;
+    }
+
+    if (latest.focusPeak && renderFocusPeakFrame(latest, !reused)) {
+        rememberUpload(latest);
+        return true;
+    }
+
+    if (latest.isYuv() && program(ShaderEffect::YUV)) {
+        renderYuvFrame(latest, !reused);
+        rememberUpload(latest);
+        return true;
+    }
+
+    if (latest.detectEdgesOnGpu) {
+        if (renderGpuEdgeFrame(latest, !reused)) {
+            rememberUpload(latest);
+            return true;
+        }
+        // The luma texture may not hold edges yet; let the CPU fallback rebuild it
+        reused = false;
+    }
+
+    if (latest.bitmapWidth > 0 && latest.overlay.empty()) {
+        const ShaderProgram* bitsProgram = program(ShaderEffect::EDGE_BITS);
+        if (bitsProgram) {
+            if (!reused) {
+                static thread_local cv::Mat packed;
+                ScopedStageTimer timer(Stage::RENDER_UPLOAD);
+                uploadTexture(lumaTexture, contiguous(frame, packed));
+            }
+            rememberUpload(latest);
+            ScopedStageTimer drawTimer(Stage::RENDER_DRAW);
+            drawBitmapQuad(*bitsProgram, lumaTexture, latest.bitmapWidth, true, latest.rotation);
+            return true;
+        }
+    }
+
+    // Single-channel frames (edges, grayscale) are uploaded as-is; color frames
+    // are converted to RGBA (render-thread scratch, reused across frames)
+    bool singleChannel = !latest.isYuv() && frame.channels() == 1;
+    FrameTexture& texture = singleChannel ? lumaTexture : colorTexture;
+    if (!reused && !(singleChannel && latest.overlay.empty() && uploadChangedRects(texture, frame, latest))) {
+        if (!convertAndUpload(latest, texture)) {
+            return false;
+        }
+        texture.edgeResult = singleChannel && latest.overlay.empty() ? latest.edgeResult : 0;
+    }
+    rememberUpload(latest);
+
+    // initGL refuses to continue without the RGB program, so it is always here.
+    // An undistorted layer samples through the map instead.
+    const GLuint map = undistortMap(latest, texture.width, texture.height);
+    const ShaderProgram* undistort = map ? program(ShaderEffect::UNDISTORT) : nullptr;
+    const ShaderProgram* fused = undistort ? nullptr : fusedOverlayProgram(latest, ShaderEffect::RGB_OVERLAY);
+    const ShaderProgram& rgbProgram = undistort ? *undistort : fused ? *fused : *program(ShaderEffect::RGB);
+    ScopedStageTimer drawTimer(Stage::RENDER_DRAW);
+
+    // Render with correct orientation
+    glUseProgram(rgbProgram.id);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture.id);
+    glUniform1i(rgbProgram.samplerLoc, 0);
+    glUniform1i(rgbProgram.singleChannelLoc, singleChannel ? 1 : 0);
+    if (fused) {
+        bindFusedOverlay(latest, rgbProgram, 1);
+    }
+    if (undistort) {
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, map);
+        glUniform1i(rgbProgram.mapLoc, 1);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    drawFrameQuad(rgbProgram, texture.width, texture.height, latest.rotation);
+    return true;
+}
+
+// Darkens the background outside the processing ROI: any quad drawn with
+// (GL_ZERO, GL_CONSTANT_COLOR) blending just scales what is already there, so
+// the four scissored bands around the region are multiplied by 1 - dim
+static void dimOutsideRegion(const RenderFrame& latest) {
+    if (latest.backgroundDim <= 0.0f || !layerRegion.active) {
+        return;
+    }
+    GLfloat scaleX, scaleY;
+    letterboxScale(layerRegion.frameWidth, layerRegion.frameHeight, latest.rotation, scaleX, scaleY);
+    GLfloat quad[16];
+    buildFrameQuad(latest.rotation, quad);
+    mapQuadToRegion(quad);
+
+    // Region bounds in window pixels (rotations are multiples of 90 degrees,
+    // so the region stays an axis-aligned rectangle on screen)
+    GLfloat minX = 1.0f, maxX = -1.0f, minY = 1.0f, maxY = -1.0f;
+    for (int i = 0; i < 16; i += 4) {
+        minX = std::min(minX, quad[i] * scaleX);
+        maxX = std::max(maxX, quad[i] * scaleX);
+        minY = std::min(minY, quad[i + 1] * scaleY);
+        maxY = std::max(maxY, quad[i + 1] * scaleY);
+    }
+    auto toWindow = [](GLfloat ndc, int origin, int extent) {
+        return origin + static_cast<int>((std::max(-1.0f, std::min(1.0f, ndc)) + 1.0f) * 0.5f * extent);
+    };
+    const int ax = layerArea.x, ay = layerArea.y, aw = layerArea.width, ah = layerArea.height;
+    const int left = toWindow(minX, ax, aw), right = toWindow(maxX, ax, aw);
+    const int bottom = toWindow(minY, ay, ah), top = toWindow(maxY, ay, ah);
+    const int bands[4][4] = {
+            {ax, ay, aw, bottom - ay},                 // below
+            {ax, top, aw, ay + ah - top},              // above
+            {ax, bottom, left - ax, top - bottom},     // left
+            {right, bottom, ax + aw - right, top - bottom}, // right
+    };
+
+    const ShaderProgram& rgbProgram = *program(ShaderEffect::RGB);
+    GLfloat keep = 1.0f - std::min(1.0f, latest.backgroundDim);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ZERO, GL_CONSTANT_COLOR);
+    glBlendColor(keep, keep, keep, 1.0f);
+    glUseProgram(rgbProgram.id);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, colorTexture.id);
+    glUniform1i(rgbProgram.samplerLoc, 0);
+    glUniform2f(rgbProgram.scaleLoc, 1.0f, 1.0f);
+    glEnableVertexAttribArray(posLoc);
+    glEnableVertexAttribArray(texLoc);
+    glVertexAttribPointer(posLoc, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), verticesNormal);
+    glVertexAttribPointer(texLoc, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), verticesNormal + 2);
+    glEnable(GL_SCISSOR_TEST);
+    {
+        ScopedGpuTimer gpuTime(gpuTimer, Stage::GPU_DRAW);
+        for (const auto& band : bands) {
+            if (band[2] > 0 && band[3] > 0) {
+                glScissor(band[0], band[1], band[2], band[3]);
+                glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+            }
+        }
+    }
+    glDisable(GL_SCISSOR_TEST);
+    glDisableVertexAttribArray(posLoc);
+    glDisableVertexAttribArray(texLoc);
+    glDisable(GL_BLEND);
+}
+
+// Second layer for DEFAULT/INSET: the edge frame drawn as tinted lines, alpha
+// blended over whatever is already in the layer area. REGION draws it opaque
+// instead, as the processed picture inside the ROI.
+static void drawOverlayLayer(const RenderFrame& latest) {
+    const bool opaque = latest.composition == RenderFrame::Composition::REGION;
+    const bool tiled = exceedsTextureSize(latest.bitmapWidth > 0 ? latest.bitmapWidth : latest.overlay.cols,
+                                          latest.overlay.rows);
+    const ShaderProgram* bitsProgram =
+            latest.bitmapWidth > 0 && !tiled ? program(ShaderEffect::EDGE_BITS) : nullptr;
+    const ShaderProgram* overlayProgram = program(opaque ? ShaderEffect::RGB : ShaderEffect::OVERLAY);
+    if (!overlayProgram && !bitsProgram) {
+        return;
+    }
+    uploadOverlayLayer(latest, !bitsProgram);  // no packed edge program: unpacked
+
+    ScopedStageTimer drawTimer(Stage::RENDER_DRAW);
+    if (bitsProgram) {
+        setLayerRegion(latest);
+        drawBitmapQuad(*bitsProgram, overlayTexture, latest.bitmapWidth, opaque, latest.rotation);
+        clearLayerRegion();
+        glDisable(GL_BLEND);
+        return;
+    }
+    glUseProgram(overlayProgram->id);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, overlayTexture.id);
+    glUniform1i(overlayProgram->samplerLoc, 0);
+    if (opaque) {
+        glUniform1i(overlayProgram->singleChannelLoc, 1);
+    } else {
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glUniform4fv(overlayProgram->tintLoc, 1, kOverlayTint);
+    }
+    setLayerRegion(latest);
+    if (tiled) {
+        drawFrameQuad(*overlayProgram, tiledOverlay.width, tiledOverlay.height, latest.rotation, &tiledOverlay);
+    } else {
+        drawFrameQuad(*overlayProgram, overlayTexture.width, overlayTexture.height, latest.rotation);
+    }
+    clearLayerRegion();
+    glDisable(GL_BLEND);
+}
+
+// Keypoints, flow vector pairs or contour strips on top of the layers. The
+// published CV_32FC2 rows are the vertex data as-is, streamed into a VBO only
+// when a new set arrives; the frame-to-screen mapping is three uniforms, so
+// nothing is transformed or drawn on the CPU.
+static void drawMarkers(const RenderFrame& latest) {
+    const ShaderProgram* markerProgram = program(ShaderEffect::MARKERS);
+    if (!markerProgram || latest.markers.empty() || latest.markers.type() != CV_32FC2 ||
+        !latest.markers.isContinuous()) {
+        return;
+    }
+    const int count = static_cast<int>(latest.markers.total());
+    if (!markerVbo) {
+        glGenBuffers(1, &markerVbo);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, markerVbo);
+    if (lastMarkerSequence != latest.sequence || lastMarkerData != latest.markers.data) {
+        ScopedStageTimer timer(Stage::RENDER_UPLOAD);
+        glBufferData(GL_ARRAY_BUFFER, count * 2 * sizeof(GLfloat), latest.markers.data, GL_STREAM_DRAW);
+        lastMarkerSequence = latest.sequence;
+        lastMarkerData = latest.markers.data;
+    }
+
+    ScopedStageTimer drawTimer(Stage::RENDER_DRAW);
+    GLfloat quad[16];
+    buildFrameQuad(latest.rotation, quad);
+    // The warp is affine, so moving the origin and both axes moves every marker
+    GLfloat corners[6] = {0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f};
+    for (int i = 0; layerWarp.active && i < 6; i += 2) {
+        layerWarp.apply(corners[i], corners[i + 1]);
+    }
+    GLfloat ox, oy, ux, uy, vx, vy;
+    quadPosition(quad, corners[0], corners[1], ox, oy);
+    quadPosition(quad, corners[2], corners[3], ux, uy);
+    quadPosition(quad, corners[4], corners[5], vx, vy);
+    GLfloat scaleX, scaleY;
+    letterboxScale(latest.markerFrameSize.width, latest.markerFrameSize.height, latest.rotation, scaleX, scaleY);
+
+    const bool points = latest.markerStyle == RenderFrame::MarkerStyle::POINTS;
+    glUseProgram(markerProgram->id);
+    glUniform2f(markerProgram->scaleLoc, scaleX, scaleY);
+    glUniform2f(markerProgram->originLoc, ox, oy);
+    glUniform2f(markerProgram->axisULoc, ux - ox, uy - oy);
+    glUniform2f(markerProgram->axisVLoc, vx - ox, vy - oy);
+    glUniform1f(markerProgram->pointSizeLoc, kMarkerPointSize);
+    glUniform1i(markerProgram->roundLoc, points ? 1 : 0);
+    glUniform4fv(markerProgram->tintLoc, 1, kMarkerTint);
+    glEnableVertexAttribArray(posLoc);
+    glVertexAttribPointer(posLoc, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+    if (!points) {
+        glLineWidth(kMarkerLineWidth);
+    }
+    switch (latest.markerStyle) {
+        case RenderFrame::MarkerStyle::POINTS:
+            glDrawArrays(GL_POINTS, 0, count);
+            break;
+        case RenderFrame::MarkerStyle::LINES:
+            glDrawArrays(GL_LINES, 0, count & ~1);
+            break;
+        case RenderFrame::MarkerStyle::LINE_STRIPS: {
+            const cv::Mat& offsets = latest.markerOffsets;
+            if (offsets.type() != CV_32SC1 || !offsets.isContinuous()) {
+                break;
+            }
+            const int* starts = offsets.ptr<int>();
+            for (int i = 0; i + 1 < static_cast<int>(offsets.total()); i++) {
+                const int first = starts[i];
+                const int last = std::min(starts[i + 1], count);
+                if (last - first >= 2) {
+                    glDrawArrays(GL_LINE_STRIP, first, last - first);
+                }
+            }
+            break;
+        }
+    }
+    glDisableVertexAttribArray(posLoc);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    checkGLError("drawMarkers");
+}
+
+// Texture drawFrameLayer left latest's image in, or null when the image was
+// not uploaded (camera texture, hardware buffers)
+static const FrameTexture* uploadedImageTexture(const RenderFrame& latest, bool& singleChannel) {
+    if (latest.useExternalTexture || latest.sharedEdges || latest.hardwareFrame || latest.image.empty()) {
+        return nullptr;
+    }
+    // The YUV program samples the Y plane from lumaTexture; without it the
+    // planes were converted to RGBA
+    singleChannel = latest.isYuv() ? program(ShaderEffect::YUV) != nullptr : latest.image.channels() == 1;
+    const FrameTexture& texture = singleChannel ? lumaTexture : colorTexture;
+    if (texture.width != latest.image.cols || texture.height != latest.image.rows) {
+        return nullptr;
+    }
+    return &texture;
+}
+
+// Draws the 4 corners of quad (x, y, s, t each) with the rectify program,
+// each corner sampling at rectify * (s, t, 1)
+static void drawRectifiedQuad(const ShaderProgram& rectify, const RenderFrame& latest, const GLfloat* quad) {
+    GLfloat vertices[20];
+    for (int i = 0; i < 4; i++) {
+        const GLfloat s = quad[4 * i + 2];
+        const GLfloat t = quad[4 * i + 3];
+        vertices[5 * i] = quad[4 * i];
+        vertices[5 * i + 1] = quad[4 * i + 1];
+        for (int row = 0; row < 3; row++) {
+            vertices[5 * i + 2 + row] = latest.rectify(row, 0) * s + latest.rectify(row, 1) * t + latest.rectify(row, 2);
+        }
+    }
+    glEnableVertexAttribArray(posLoc);
+    glEnableVertexAttribArray(texLoc);
+    glVertexAttribPointer(posLoc, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), vertices);
+    glVertexAttribPointer(texLoc, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(GLfloat), vertices + 2);
+    {
+        ScopedGpuTimer gpuTime(gpuTimer, Stage::GPU_DRAW);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    }
+    checkGLError("rectified draw");
+    glDisableVertexAttribArray(posLoc);
+    glDisableVertexAttribArray(texLoc);
+}
+
+// The tracked quad of a DOCUMENT frame, straightened from the texture the raw
+// layer was just drawn from: upright in the top-right third of the area, and
+// for readback upright into rectifiedTarget at the requested size
+static void drawRectifiedDocument(const RenderFrame& latest, int areaX, int areaY, int areaWidth, int areaHeight) {
+    bool singleChannel = false;
+    const FrameTexture* texture = uploadedImageTexture(latest, singleChannel);
+    const ShaderProgram* rectify = texture ? program(ShaderEffect::RECTIFY) : nullptr;
+    if (!rectify || latest.rectifiedSize.empty()) {
+        return;
+    }
+    ScopedStageTimer drawTimer(Stage::RENDER_DRAW);
+    glUseProgram(rectify->id);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture->id);
+    glUniform1i(rectify->samplerLoc, 0);
+    glUniform1i(rectify->singleChannelLoc, singleChannel ? 1 : 0);
+
+    if (latest.rectifiedInset) {
+        const int insetWidth = areaWidth / 3;
+        const int insetHeight = areaHeight / 3;
+        const int x = areaX + areaWidth - insetWidth - kInsetMargin;
+        const int y = areaY + areaHeight - insetHeight - kInsetMargin;
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(x, y, insetWidth, insetHeight);
+        glClear(GL_COLOR_BUFFER_BIT);
+        glDisable(GL_SCISSOR_TEST);
+        setLayerArea(x, y, insetWidth, insetHeight, false);
+        // Oriented like the camera frame it was cut from
+        GLfloat scaleX, scaleY;
+        letterboxScale(latest.rectifiedSize.width, latest.rectifiedSize.height, latest.rotation, scaleX, scaleY);
+        glUniform2f(rectify->scaleLoc, scaleX, scaleY);
+        GLfloat quad[16];
+        buildFrameQuad(latest.rotation, quad);
+        drawRectifiedQuad(*rectify, latest, quad);
+        setLayerArea(areaX, areaY, areaWidth, areaHeight, false);
+    }
+
+    if (latest.rectifiedReadback.empty() || !drawingDefaultPipeline || copyPass ||
+        !rectifiedReadback.isActive() || !rectifiedReadbackWanted() ||
+        !ensureRenderTarget(rectifiedTarget, latest.rectifiedReadback.width, latest.rectifiedReadback.height)) {
+        return;
+    }
+    ScopedTrace trace("rectified_readback");
+    glBindFramebuffer(GL_FRAMEBUFFER, rectifiedTarget.fbo);
+    glViewport(0, 0, rectifiedTarget.width, rectifiedTarget.height);
+    glUniform2f(rectify->scaleLoc, 1.0f, 1.0f);
+    // Upright and top row first, like the runEdgePass targets
+    GLfloat quad[16];
+    for (int i = 0; i < 16; i += 4) {
+        quad[i] = verticesNormal[i];
+        quad[i + 1] = verticesNormal[i + 1];
+        uprightToBuffer(latest.rotation, verticesNormal[i + 2], verticesNormal[i + 3], quad + i + 2);
+    }
+    drawRectifiedQuad(*rectify, latest, quad);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    setLayerArea(areaX, areaY, areaWidth, areaHeight, false);
+    ReadbackFrame readback;
+    readback.rotation = 0;  // already upright
+    readback.sequence = latest.sequence;
+    readback.captureTimestampNs = latest.captureTimestampNs;
+    rectifiedReadback.queue(rectifiedTarget.fbo, rectifiedTarget.width, rectifiedTarget.height, readback);
+}
+
+// One pipeline's frame into a screen rectangle. Multi-layer modes are pure
+// draw-call compositions: every layer keeps its own texture.
+// Declarations every effect's fragment shader starts with (render_effects.h)
+static const char* kEffectPreamble = R"(precision mediump float;
+varying highp vec2 v_TexCoord;
+uniform sampler2D u_Texture;
+uniform highp vec2 u_TexelSize;
+uniform vec4 u_Params;
+)";
+
+// This thread's programs for the current effect chain, rebuilt when it
+// changed; effects that fail to build are left out
+static void resolveEffectPasses() {
+    const uint32_t generation = renderEffects().generation();
+    if (effectsResolved && generation == effectsGeneration) {
+        return;
+    }
+    effectsResolved = true;
+    effectsGeneration = generation;
+    effectPasses.clear();
+    for (const auto& effect : renderEffects().chain()) {
+        EffectPass pass;
+        pass.id = shaderRegistry().program("fx_" + effect->name, passVertexShaderSrc,
+                                           kEffectPreamble + effect->fragment);
+        if (!pass.id) {
+            LOGE_RATELIMITED("Render effect '%s' does not build, skipped", effect->name.c_str());
+            continue;
+        }
+        pass.samplerLoc = glGetUniformLocation(pass.id, "u_Texture");
+        pass.texelSizeLoc = glGetUniformLocation(pass.id, "u_TexelSize");
+        pass.paramsLoc = glGetUniformLocation(pass.id, "u_Params");
+        effectPasses.push_back(pass);
+    }
+    if (effectPasses.empty()) {
+        deleteRenderTarget(effectTargets[0]);
+        deleteRenderTarget(effectTargets[1]);
+    }
+}
+
+// Redirects the frame layer into effectTargets[0], drawn as if the layer's
+// area were the whole target; false (nothing changed) without effects
+static bool beginLayerEffects(int areaWidth, int areaHeight, bool fill) {
+    resolveEffectPasses();
+    if (effectPasses.empty() || !ensureRenderTarget(effectTargets[0], areaWidth, areaHeight) ||
+        (effectPasses.size() > 1 && !ensureRenderTarget(effectTargets[1], areaWidth, areaHeight))) {
+        return false;
+    }
+    layerFramebuffer = effectTargets[0].fbo;
+    glBindFramebuffer(GL_FRAMEBUFFER, layerFramebuffer);
+    glClear(GL_COLOR_BUFFER_BIT);  // composeSurface's black
+    setLayerArea(0, 0, areaWidth, areaHeight, fill);
+    return true;
+}
+
+// Runs the effect chain over the layer drawn since beginLayerEffects,
+// ping-ponging between the targets; the last pass draws into the layer's
+// area of the surface. Without a layer only the surface is rebound.
+static void finishLayerEffects(int areaX, int areaY, int areaWidth, int areaHeight, bool drawn) {
+    const bool fill = layerArea.fill;
+    layerFramebuffer = 0;
+    if (!drawn) {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        setLayerArea(areaX, areaY, areaWidth, areaHeight, fill);
+        return;
+    }
+    readEffectParams(effectParams);  // keeps the last ones while Java writes
+    ScopedStageTimer drawTimer(Stage::RENDER_DRAW);
+    glEnableVertexAttribArray(posLoc);
+    glEnableVertexAttribArray(texLoc);
+    glVertexAttribPointer(posLoc, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), verticesNormal);
+    glVertexAttribPointer(texLoc, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(GLfloat), verticesNormal + 2);
+    int input = 0;
+    for (size_t i = 0; i < effectPasses.size(); i++) {
+        const EffectPass& pass = effectPasses[i];
+        if (i + 1 == effectPasses.size()) {
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            setLayerArea(areaX, areaY, areaWidth, areaHeight, fill);
+        } else {
+            glBindFramebuffer(GL_FRAMEBUFFER, effectTargets[1 - input].fbo);
+            glViewport(0, 0, areaWidth, areaHeight);
+        }
+        glUseProgram(pass.id);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, effectTargets[input].texture);
+        glUniform1i(pass.samplerLoc, 0);
+        glUniform2f(pass.texelSizeLoc, 1.0f / areaWidth, 1.0f / areaHeight);
+        glUniform4fv(pass.paramsLoc, 1, effectParams);
+        {
+            ScopedGpuTimer gpuTime(gpuTimer, Stage::GPU_DRAW);
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        }
+        input = 1 - input;
+    }
+    glDisableVertexAttribArray(posLoc);
+    glDisableVertexAttribArray(texLoc);
+    checkGLError("render effects");
+}
+
+// The pipeline's frame for mode (-1 = its active one); false if none
+static bool fetchPipelineFrame(PipelineContext* pipeline, int mode, RenderFrame& latest) {
+    try {
+        latest = mode >= 0 ? getFrameForRender(pipeline, mode) : getLatestFrameForRender(pipeline);
+        return true;
+    } catch (const std::exception& e) {
+        LOGE_RATELIMITED("Exception getting frame: %s", e.what());
+        return false;
+    }
+}
+
+static void drawFetchedFrame(PipelineContext* pipeline, RenderFrame& latest, int areaX, int areaY,
+                             int areaWidth, int areaHeight) {
+    drawingDefaultPipeline = pipeline == nullptr && !residentPass;
+    // Just switched: the mode's snapshot until a frame is built for it
+    if (pipeline == renderPipeline && !secondaryPipeline && !residentPass && latest.mode >= 0 &&
+        !(latest.modesBuilt >> latest.mode & 1)) {
+        const int snapshot = findSnapshot(latest.mode);
+        if (snapshot >= 0) {
+            drawSnapshot(modeSnapshots[snapshot], areaX, areaY, areaWidth, areaHeight);
+            return;
+        }
+    }
+    if (!latest.useExternalTexture && !latest.sharedEdges && !latest.mosaic && latest.image.empty() &&
+        latest.markers.empty()) {
+        return;
+    }
+
+    setLayerArea(areaX, areaY, areaWidth, areaHeight,
+                 latest.composition == RenderFrame::Composition::FILL);
+    ScopedLayerWarp warp(latest);
+    // Single-layer frames are the processed picture itself, placed at its ROI
+    bool processedImage = latest.composition == RenderFrame::Composition::SINGLE ||
+                          latest.composition == RenderFrame::Composition::FILL;
+    if (processedImage) {
+        setLayerRegion(latest);
+    }
+    // Marker-only frames (CONTOURS without an ROI) go straight to the marker pass
+    bool markersOnly = !latest.useExternalTexture && !latest.sharedEdges && !latest.mosaic && latest.image.empty();
+    overlayFused = false;
+    const bool effects = !markersOnly && beginLayerEffects(areaWidth, areaHeight, layerArea.fill);
+    bool drawn = markersOnly || drawFrameLayer(latest);
+    clearLayerRegion();
+    if (effects) {
+        finishLayerEffects(areaX, areaY, areaWidth, areaHeight, drawn);
+    }
+    if (!drawn) {
+        return;
+    }
+
+    if (!latest.overlay.empty() && !overlayFused) {
+        if (latest.composition == RenderFrame::Composition::INSET) {
+            // Picture-in-picture: a third of the area in its top-right corner
+            int insetWidth = areaWidth / 3;
+            int insetHeight = areaHeight / 3;
+            int x = areaX + areaWidth - insetWidth - kInsetMargin;
+            int y = areaY + areaHeight - insetHeight - kInsetMargin;
+            glEnable(GL_SCISSOR_TEST);
+            glScissor(x, y, insetWidth, insetHeight);
+            glClear(GL_COLOR_BUFFER_BIT);
+            glDisable(GL_SCISSOR_TEST);
+            setLayerArea(x, y, insetWidth, insetHeight, false);
+        } else {
+            setLayerRegion(latest);
+            dimOutsideRegion(latest);
+            clearLayerRegion();
+        }
+        drawOverlayLayer(latest);
+        setLayerArea(areaX, areaY, areaWidth, areaHeight, false);
+    }
+    if (!latest.markers.empty()) {
+        drawMarkers(latest);
+    }
+    if (latest.rectifiedInset || !latest.rectifiedReadback.empty()) {
+        drawRectifiedDocument(latest, areaX, areaY, areaWidth, areaHeight);
+    }
+    if (residentPass) {
+        residentDrawn = true;
+        return;
+    }
+    if (copyPass) {
+        return;  // the frame was counted when drawn to the window
+    }
+    metrics().increment(Counter::FRAMES_RENDERED);
+    if (pipeline == renderPipeline) {
+        presentedSequence = latest.sequence;
+        if (latest.mode >= 0 && (latest.modesBuilt >> latest.mode & 1)) {
+            shownMode = latest.mode;
+        }
+    }
+
+    // Capture to display, once per frame: the draw is queued here and the
+    // swap follows, so this is short of true glass-to-glass by the display
+    // pipeline (roughly one vsync)
+    if (latest.captureTimestampNs > 0 && latest.sequence != lastLatencySequence) {
+        lastLatencySequence = latest.sequence;
+        metrics().recordStage(Stage::CAPTURE_TO_DISPLAY, (bootTimeNanos() - latest.captureTimestampNs) / 1000);
+    }
+    // Close the default pipeline's publish-to-draw sections (publishFrame
+    // opens them), those of frames superseded before a draw included
+    if (!pipeline && latest.sequence > lastTracedSequence) {
+        const uint64_t first = std::max(lastTracedSequence + 1, latest.sequence > 8 ? latest.sequence - 8 : 1);
+        for (uint64_t sequence = first; sequence <= latest.sequence; sequence++) {
+            traceAsyncEnd("frame", static_cast<int32_t>(sequence));
+        }
+        lastTracedSequence = latest.sequence;
+    }
+}
+
+static void drawPipelineFrame(PipelineContext* pipeline, int areaX, int areaY, int areaWidth, int areaHeight) {
+    RenderFrame latest;
+    if (fetchPipelineFrame(pipeline, -1, latest)) {
+        drawFetchedFrame(pipeline, latest, areaX, areaY, areaWidth, areaHeight);
+    }
+}
+
+// Redraws an inactive resident mode the shown frame was also built for into
+// its snapshot, at most every kSnapshotFrames; true if it drew into the window
+static bool refreshResidentSnapshot(const RenderFrame& shown) {
+    const uint32_t active = shown.mode >= 0 ? 1u << shown.mode : 0;
+    const uint32_t inactive = residentModeMask.load(std::memory_order_relaxed) & shown.modesBuilt & ~active;
+    if (inactive == 0 || residencyBudget.load(std::memory_order_relaxed) == 0) {
+        return false;
+    }
+    for (int mode = 0; mode < 32; mode++) {
+        const int snapshot = findSnapshot(mode);
+        if (!(inactive >> mode & 1) ||
+            (snapshot >= 0 && (modeSnapshots[snapshot].sequence == shown.sequence ||
+                               residencyFrame - modeSnapshots[snapshot].takenAt < kSnapshotFrames))) {
+            continue;
+        }
+        RenderFrame frame;
+        if (!fetchPipelineFrame(renderPipeline, mode, frame) || !(frame.modesBuilt >> mode & 1)) {
+            return false;
+        }
+        ScopedTrace trace("resident_pass");
+        ensureStreamBank(residentBank);
+        swapStreamBank(residentBank);
+        residentPass = true;
+        residentDrawn = false;
+        drawFetchedFrame(renderPipeline, frame, 0, 0, viewportWidth, viewportHeight);
+        residentPass = false;
+        swapStreamBank(residentBank);
+        if (residentDrawn) {
+            storeSnapshot(mode, frame.sequence);
+        }
+        return true;
+    }
+    return false;
+}
+
+// Everything one surface shows, drawn into a surfaceWidth x surfaceHeight
+// surface. With a second pipeline bound both streams are composited in this
+// one pass: side by side on a landscape surface, stacked on a portrait one,
+// the bound pipeline first.
+static void composeSurface(int surfaceWidth, int surfaceHeight) {
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    if (!secondaryPipeline) {
+        RenderFrame latest;
+        if (!fetchPipelineFrame(renderPipeline, -1, latest)) {
+            return;
+        }
+        if (!copyPass && refreshResidentSnapshot(latest)) {
+            glClear(GL_COLOR_BUFFER_BIT);
+        }
+        drawFetchedFrame(renderPipeline, latest, 0, 0, surfaceWidth, surfaceHeight);
+        return;
+    }
+    ensureStreamBank(secondaryBank);
+    const bool sideBySide = surfaceWidth >= surfaceHeight;
+    const int width = sideBySide ? surfaceWidth / 2 : surfaceWidth;
+    const int height = sideBySide ? surfaceHeight : surfaceHeight / 2;
+    drawPipelineFrame(renderPipeline, 0, sideBySide ? 0 : height, width, height);  // GL y points up
+    swapStreamBank(secondaryBank);
+    drawPipelineFrame(secondaryPipeline, sideBySide ? width : 0, 0, width, height);
+    swapStreamBank(secondaryBank);
+    setLayerArea(0, 0, surfaceWidth, surfaceHeight, false);
+}
+
+static void releaseSpares() {
+    for (FrameTexture& spare : spareTextures) {
+        deleteTexture(spare);
+    }
+    for (RenderTarget& spare : spareTargets) {
+        deleteRenderTarget(spare);
+    }
+    spareTextures.clear();
+    spareTargets.clear();
+    spareFramesLeft = 0;
+}
+
+// Bumped by trimGL; a GL thread releases what it can rebuild once per newer
+// value: every render target (edge passes, CL-GL images, readbacks), the
+// undistortion map and, with no second pipeline bound, the second stream's
+// textures. Each comes back at its next use.
+static std::atomic<uint32_t> trimGeneration{0};
+static thread_local uint32_t trimmedFor = 0;
+
+static void releaseTrimmedResources() {
+    const uint32_t generation = trimGeneration.load(std::memory_order_acquire);
+    if (generation == trimmedFor) {
+        return;
+    }
+    trimmedFor = generation;
+    clGlInteropRelease();  // its CL images wrap the edge targets
+    deleteEdgeTargets();
+    releaseSpares();
+    releaseUndistortMap();
+    if (!secondaryPipeline) {
+        releaseStreamBank(secondaryBank);
+    }
+    releaseModeSnapshots();
+    releaseStreamBank(residentBank);
+    LOGI("GL resources trimmed");
+}
+
+void trimGL() {
+    trimGeneration.fetch_add(1, std::memory_order_acq_rel);
+}
+
+// Bumped by prepareFrameSizeGL; sizes packed 16 bits each: from width,
+// from height, to width, to height
+static std::atomic<uint32_t> frameSizeGeneration{0};
+static std::atomic<uint64_t> preparedFrameSizes{0};
+static thread_local uint32_t preparedFor = 0;
+static const int kSpareFrames = 300;  // frames a spare waits for its size
+
+static void prepareSpares() {
+    const uint32_t generation = frameSizeGeneration.load(std::memory_order_acquire);
+    if (generation == preparedFor) {
+        if (spareFramesLeft > 0 && --spareFramesLeft == 0) {
+            releaseSpares();  // the switch never came
+        }
+        return;
+    }
+    preparedFor = generation;
+    releaseSpares();
+    const uint64_t sizes = preparedFrameSizes.load(std::memory_order_relaxed);
+    const int fromWidth = static_cast<int>(sizes >> 48 & 0xffff);
+    const int fromHeight = static_cast<int>(sizes >> 32 & 0xffff);
+    const int toWidth = static_cast<int>(sizes >> 16 & 0xffff);
+    const int toHeight = static_cast<int>(sizes & 0xffff);
+    if (fromWidth == 0 || fromHeight == 0) {
+        return;
+    }
+    // Each texture keeps its ratio to the camera frame (full size, half-size
+    // chroma, a processing size)
+    auto scaled = [](int size, int from, int to) { return std::max(1, (size * to + from / 2) / from); };
+    for (FrameTexture* tex : {&colorTexture, &lumaTexture, &chromaTexture, &overlayTexture}) {
+        if (!tex->id || tex->width == 0) {
+            continue;
+        }
+        FrameTexture spare;
+        createTexture(spare, tex->format);
+        spare.width = scaled(tex->width, fromWidth, toWidth);
+        spare.height = scaled(tex->height, fromHeight, toHeight);
+        glTexImage2D(GL_TEXTURE_2D, 0, spare.format, spare.width, spare.height, 0, spare.format, GL_UNSIGNED_BYTE,
+                     nullptr);
+        accountGlMemory(textureBytes(spare.format, spare.width, spare.height));
+        spareTextures.push_back(spare);
+    }
+    for (const RenderTarget* target : {&blurTarget, &gradientTarget, &nmsTarget}) {
+        RenderTarget spare;
+        if (target->fbo && createRenderTarget(spare, scaled(target->width, fromWidth, toWidth),
+                                              scaled(target->height, fromHeight, toHeight))) {
+            spareTargets.push_back(spare);
+        }
+    }
+    spareFramesLeft = kSpareFrames;
+    LOGI("Prepared %zu textures and %zu edge targets for %dx%d frames", spareTextures.size(), spareTargets.size(),
+         toWidth, toHeight);
+}
+
+void prepareFrameSizeGL(int fromWidth, int fromHeight, int toWidth, int toHeight) {
+    preparedFrameSizes.store(static_cast<uint64_t>(fromWidth & 0xffff) << 48 |
+                             static_cast<uint64_t>(fromHeight & 0xffff) << 32 |
+                             static_cast<uint64_t>(toWidth & 0xffff) << 16 | static_cast<uint64_t>(toHeight & 0xffff),
+                             std::memory_order_relaxed);
+    frameSizeGeneration.fetch_add(1, std::memory_order_acq_rel);
+}
+
+// Main render function with orientation support. While recording, the same
+// composition is drawn a second time into the encoder's surface, and once
+// more into each display mirror's; textures and upload caches are shared, so
+// every further pass costs draw calls only.
+// Orientation written into the control block (control_block.h) since the
+// last frame; setOrientationNative keeps working for values it never saw
+static void pollControlOrientation() {
+    const int orientation = controlBlock().orientation.load(std::memory_order_acquire);
+    if (orientation == controlOrientation) {
+        return;
+    }
+    controlOrientation = orientation;
+    if (orientation >= static_cast<int>(Orientation::NORMAL) && orientation <= static_cast<int>(Orientation::ROTATED_270)) {
+        currentOrientation = static_cast<Orientation>(orientation);
+        LOGI("Orientation set to: %d (control block)", orientation);
+    }
+}
+
+void renderGL() {
+    setThreadTier(ThreadTier::RENDER);  // GLSurfaceView's thread, started by Java at normal priority
+    ForegroundWork foreground;
+    buildRequestedPrograms();  // before the frame's timers
+    releaseTrimmedResources();
+    applyResidencyBudget();
+    prepareSpares();
+    pollControlOrientation();
+    ScopedStageTimer totalTimer(Stage::RENDER_TOTAL);
+    PerformanceHintScope hint(HintChannel::RENDER);
+    profileThread(ProfileRole::RENDER);
+    gpuTimer.beginFrame();
+    presentedSequence = 0;
+    edgeReadback.poll();  // before this frame's passes queue more GPU work
+    rectifiedReadback.poll();
+    composeSurface(viewportWidth, viewportHeight);
+    snapshotShownMode();
+    framePacing().onPresent(bootTimeNanos(), presentedSequence);  // the swap follows
+    if (resumeState.initMicros != 0 && presentedSequence != 0) {
+        const int64_t elapsed = monotonicMicros() - resumeState.initMicros;
+        resumeState.initMicros = 0;
+        metrics().recordStage(Stage::GL_RESUME, elapsed);
+        LOGI("First frame %.1f ms after initGL", elapsed / 1000.0);
+    }
+
+    int encoderWidth = 0, encoderHeight = 0;
+    if (videoRecorder().beginFrame(encoderWidth, encoderHeight)) {
+        ScopedTrace trace("encoder_pass");
+        copyPass = true;
+        composeSurface(encoderWidth, encoderHeight);
+        copyPass = false;
+        videoRecorder().endFrame(bootTimeNanos());
+    }
+    displayMirrors().present([](int width, int height, int orientation) {
+        ScopedTrace trace("mirror_pass");
+        const Orientation windowOrientation = currentOrientation;
+        if (orientation >= static_cast<int>(Orientation::NORMAL) &&
+            orientation <= static_cast<int>(Orientation::ROTATED_270)) {
+            currentOrientation = static_cast<Orientation>(orientation);
+        }
+        copyPass = true;
+        composeSurface(width, height);
+        copyPass = false;
+        currentOrientation = windowOrientation;
+    });
+    gpuTimer.endFrame();
+    renderScheduler().onRendered(monotonicNanos());  // GLSurfaceView swaps on return
+}
+
+// Function to set orientation from Java
+void setOrientation(int orientation) {
+    currentOrientation = static_cast<Orientation>(orientation);
+    LOGI("Orientation set to: %d", orientation);
+}
+
+void cleanupGL() {
+    recordResumeState();
+    lastUpload = UploadedFrame();
+    lastOverlayData = nullptr;
+    deleteTexture(colorTexture);
+    deleteTexture(lumaTexture);
+    deleteTexture(chromaTexture);
+    deleteTexture(overlayTexture);
+    deleteTexture(splitTexture);
+    deleteTiledTexture(tiledTexture);
+    deleteTiledTexture(tiledOverlay);
+    deleteTexture(mosaicTexture);
+    mosaicRevisions.clear();
+    releaseHeatTarget();
+    releaseSpares();
+    releaseUndistortMap();
+    if (markerVbo) {
+        glDeleteBuffers(1, &markerVbo);
+        markerVbo = 0;
+    }
+    lastMarkerSequence = 0;
+    lastMarkerData = nullptr;
+    releaseStreamBank(secondaryBank);
+    releaseModeSnapshots();
+    releaseStreamBank(residentBank);
+    videoRecorder().stop();  // its surface belongs to this context
+    displayMirrors().release();  // likewise
+    pboUploader.release();
+    gpuTimer.release();
+    edgeReadback.release();
+    rectifiedReadback.release();
+    clGlInteropRelease();   // its CL images wrap the edge targets deleted below
+    releaseBufferTextures();
+    releaseSurfaceTexture();
+    if (externalTextureId) {
+        glDeleteTextures(1, &externalTextureId);
+        externalTextureId = 0;
+    }
+    deleteEdgeTargets();
+    shaderRegistry().release();
+    forgetPrograms();
+    LOGI("OpenGL cleanup complete");
+}
+
+// JNI exports
+extern "C" {
+
+JNIEXPORT void JNICALL Java_com_example_edge_renderer_GLRenderer_initGLNative(JNIEnv*, jobject) {
+    initGL();
+}
+
+// Binds this surface to a pipeline handle from nativeCreatePipeline (0 = the
+// default pipeline). Call on the GL thread (queueEvent); the handle must
+// outlive the binding.
+JNIEXPORT void JNICALL Java_com_example_edge_renderer_GLRenderer_setRenderPipelineNative(JNIEnv*, jobject,
+                                                                                       jlong pipeline) {
+    renderPipeline = reinterpret_cast<PipelineContext*>(pipeline);
+    lastUpload = UploadedFrame();  // sequences of different pipelines are unrelated
+}
+
+// Composites a second pipeline next to the bound one in the same pass (0 =
+// none). Call on the GL thread; the handle must outlive the binding.
+JNIEXPORT void JNICALL Java_com_example_edge_renderer_GLRenderer_setSecondaryRenderPipelineNative(JNIEnv*, jobject,
+                                                                                                jlong pipeline) {
+    secondaryPipeline = reinterpret_cast<PipelineContext*>(pipeline);
+    secondaryBank.upload = UploadedFrame();
+}
+
+// Records what this surface shows to fd (an MP4, e.g. from
+// ParcelFileDescriptor.detachFd; duplicated, the caller keeps its copy) with
+// the hardware encoder. Call on the GL thread; needs API 26.
+JNIEXPORT jboolean JNICALL Java_com_example_edge_renderer_GLRenderer_startRecordingNative(
+        JNIEnv*, jobject, jint fd, jint width, jint height, jint bitrate, jint frameRate, jboolean hevc) {
+    RecorderConfig config;
+    config.width = width;
+    config.height = height;
+    config.bitrate = bitrate > 0 ? bitrate : config.bitrate;
+    config.frameRate = frameRate > 0 ? frameRate : config.frameRate;
+    config.hevc = hevc == JNI_TRUE;
+    return videoRecorder().start(fd, config) ? JNI_TRUE : JNI_FALSE;
+}
+
+// Finalizes the recording (GL thread)
+JNIEXPORT void JNICALL Java_com_example_edge_renderer_GLRenderer_stopRecordingNative(JNIEnv*, jobject) {
+    videoRecorder().stop();
+}
+
+// Mirrors what this surface shows onto surface (e.g. a Presentation's
+// SurfaceView on an external display) through this GL thread's context, so
+// no frame is converted or uploaded again. orientation: as
+// setOrientationNative, -1 = this surface's. Returns the mirror's id, 0 on
+// failure. Call on the GL thread.
+JNIEXPORT jint JNICALL Java_com_example_edge_renderer_GLRenderer_attachMirrorNative(JNIEnv* env, jobject,
+                                                                                  jobject surface, jint orientation) {
+    ANativeWindow* window = surface ? ANativeWindow_fromSurface(env, surface) : nullptr;
+    if (!window) {
+        LOGE("❌ Mirror surface has no native window");
+        return 0;
+    }
+    const int id = displayMirrors().attach(window, orientation);
+    ANativeWindow_release(window);  // the mirror holds its own reference
+    return static_cast<jint>(id);
+}
+
+// GL thread
+JNIEXPORT void JNICALL Java_com_example_edge_renderer_GLRenderer_setMirrorOrientationNative(JNIEnv*, jobject, jint id,
+                                                                                          jint orientation) {
+    displayMirrors().setOrientation(id, orientation);
+}
+
+// Call on the GL thread before the mirror's surface is destroyed
+// (SurfaceHolder.Callback.surfaceDestroyed, Presentation dismissal)
+JNIEXPORT void JNICALL Java_com_example_edge_renderer_GLRenderer_detachMirrorNative(JNIEnv*, jobject, jint id) {
+    displayMirrors().detach(id);
+}
+
+JNIEXPORT void JNICALL Java_com_example_edge_renderer_GLRenderer_resizeGLNative(JNIEnv*, jobject, jint w, jint h) {
+    resizeGL(w, h);
+}
+
+JNIEXPORT void JNICALL Java_com_example_edge_renderer_GLRenderer_renderFrameNative(JNIEnv*, jobject) {
+    renderGL();
+}
+
+// NEW: Set orientation from Java
+JNIEXPORT void JNICALL Java_com_example_edge_renderer_GLRenderer_setOrientationNative(JNIEnv*, jobject, jint orientation) {
+    setOrientation(orientation);
+}
+
+JNIEXPORT void JNICALL Java_com_example_edge_renderer_GLRenderer_cleanupGLNative(JNIEnv*, jobject) {
+    cleanupGL();
+}
+
+// Zero-copy preview: returns the GL_TEXTURE_EXTERNAL_OES name to build the
+// SurfaceTexture around (GL thread)
+JNIEXPORT jint JNICALL Java_com_example_edge_renderer_GLRenderer_createExternalTextureNative(JNIEnv*, jobject) {
+    return static_cast<jint>(createExternalTexture());
+}
+
+// Takes the SurfaceTexture the camera renders into; width/height are its
+// default buffer size, used for letterboxing (GL thread)
+JNIEXPORT void JNICALL Java_com_example_edge_renderer_GLRenderer_attachSurfaceTextureNative(
+        JNIEnv* env, jobject, jobject texture, jint width, jint height) {
+    releaseSurfaceTexture();
+    if (texture && surfaceTextureApi().available()) {
+        surfaceTexture = surfaceTextureApi().fromSurfaceTexture(env, texture);
+    }
+    externalWidth = width;
+    externalHeight = height;
+    LOGI("SurfaceTexture %s (%dx%d)", surfaceTexture ? "attached" : "detached", width, height);
+}
+
+JNIEXPORT void JNICALL Java_com_example_edge_renderer_GLRenderer_detachSurfaceTextureNative(JNIEnv*, jobject) {
+    releaseSurfaceTexture();
+}
+
+// Directory for linked program binaries (Context.getCodeCacheDir()); call
+// before initGL so the first frame can load from the cache
+JNIEXPORT void JNICALL Java_com_example_edge_renderer_GLRenderer_setShaderCacheDirNative(
+        JNIEnv* env, jobject, jstring dir) {
+    if (!dir) {
+        shaderRegistry().setCacheDirectory(std::string());
+        return;
+    }
+    const char* path = env->GetStringUTFChars(dir, nullptr);
+    if (path) {
+        shaderRegistry().setCacheDirectory(path);
+        env->ReleaseStringUTFChars(dir, path);
+    }
+}
+
+}
+// RegisterNatives table (jni_registry.h)
+static const JNINativeMethod kRendererMethods[] = {
+        EDGE_GL_RENDERER_METHOD(initGLNative, "()V"),
+        EDGE_GL_RENDERER_METHOD(setRenderPipelineNative, "(J)V"),
+        EDGE_GL_RENDERER_METHOD(setSecondaryRenderPipelineNative, "(J)V"),
+        EDGE_GL_RENDERER_METHOD(startRecordingNative, "(IIIIIZ)Z"),
+        EDGE_GL_RENDERER_METHOD(stopRecordingNative, "()V"),
+        EDGE_GL_RENDERER_METHOD(attachMirrorNative, "(Landroid/view/Surface;I)I"),
+        EDGE_GL_RENDERER_METHOD(setMirrorOrientationNative, "(II)V"),
+        EDGE_GL_RENDERER_METHOD(detachMirrorNative, "(I)V"),
+        EDGE_GL_RENDERER_METHOD(resizeGLNative, "(II)V"),
+        EDGE_GL_RENDERER_METHOD(renderFrameNative, "()V"),
+        EDGE_GL_RENDERER_METHOD(setOrientationNative, "(I)V"),
+        EDGE_GL_RENDERER_METHOD(cleanupGLNative, "()V"),
+        EDGE_GL_RENDERER_METHOD(createExternalTextureNative, "()I"),
+        EDGE_GL_RENDERER_METHOD(attachSurfaceTextureNative, "(Landroid/graphics/SurfaceTexture;II)V"),
+        EDGE_GL_RENDERER_METHOD(detachSurfaceTextureNative, "()V"),
+        EDGE_GL_RENDERER_METHOD(setShaderCacheDirNative, "(Ljava/lang/String;)V"),
+};
+
+int registerRendererMethods(JNIEnv* env) {
+    return registerNativeMethods(env, kGlRendererClass, kRendererMethods);
+}
@@ -1,11 +1,16 @@
 #ifndef EDGE_OPENGL_RENDERER_H
 #define EDGE_OPENGL_RENDERER_H
 
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-// Called once when surface is created
+// Called once when surface is created. After a lost context (the app was
+// paused) it rebuilds the programs, frame textures and edge targets the old
+// context had, at their sizes, so the first frame after resume allocates and
+// links nothing (Stage::GL_RESUME times it).
 void initGL();
 
 // Called when surface is resized
@@ -14,6 +19,30 @@ void resizeGL(int width, int height);
 // Called every frame to draw
 void renderGL();
 
+// Any thread: every GL thread builds all its programs (from the binary cache
+// when it can) at its next initGL or renderGL, instead of at each effect's
+// first use
+void warmupGL();
+
+// Any thread: every GL thread releases the GPU memory it can rebuild on
+// demand (render targets, maps, an unused second stream) at its next
+// renderGL (memory trimming)
+void trimGL();
+
+// Any thread: every GL thread keeps a copy of the view for each render mode
+// in modes (a bit per mode) while their total fits in budgetBytes, taken
+// every few frames of that mode. Switching to a mode whose frames are not
+// built yet shows its copy meanwhile. 0 bytes releases them all (memory
+// pressure).
+void setModeResidencyGL(uint32_t modes, int64_t budgetBytes);
+
+// Any thread: frames are about to change from fromWidth x fromHeight to
+// toWidth x toHeight. Every GL thread allocates its frame textures and edge
+// targets for the new size at its next renderGL, beside the ones in use, and
+// switches to them at the first frame of that size (the old ones are deleted
+// then); spares no frame claimed are dropped after a few seconds.
+void prepareFrameSizeGL(int fromWidth, int fromHeight, int toWidth, int toHeight);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,83 @@
+#include "optical_flow.h"
+#include "metrics.h"
+#include "pyramid_cache.h"
+#include <opencv2/video/tracking.hpp>
+#include <algorithm>
+
+void PointTracker::setParams(const Params& params) {
+    std::lock_guard<std::mutex> lock(mutex);
+    // Pyramids built for another window or depth cannot be reused
+    if (params.windowSize != current.windowSize || params.maxLevel != current.maxLevel) {
+        previousPyramid.clear();
+        previousPoints.clear();
+    }
+    current = params;
+}
+
+int PointTracker::capacity() {
+    return seeder.capacity();
+}
+
+void PointTracker::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    previousPyramid.clear();
+    previousPoints.clear();
+}
+
+void PointTracker::seed(const cv::Mat& luma) {
+    seedPoints.create(std::max(1, seeder.capacity()), 1, CV_32FC2);
+    int count = seeder.detect(luma, seedPoints);
+    const cv::Point2f* points = seedPoints.ptr<cv::Point2f>();
+    previousPoints.assign(points, points + count);
+    metrics().increment(Counter::TRACKING_RESEEDS);
+}
+
+int PointTracker::track(const cv::Mat& luma, cv::Mat& vectors) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const cv::Size window(current.windowSize, current.windowSize);
+    // Built once per frame, or taken from the frame's shared pyramid; the same
+    // levels serve as the next frame's previous
+    PyramidCache& pyramids = pyramidCache();
+    int levels = 0;
+    if (pyramids.covers(luma) && current.windowSize <= PyramidCache::kBorder) {
+        levels = pyramids.flowPyramid(current.maxLevel, window, currentPyramid);
+    } else {
+        levels = cv::buildOpticalFlowPyramid(luma, currentPyramid, window, current.maxLevel);
+    }
+
+    int pairs = 0;
+    if (luma.size() == previousSize && !previousPyramid.empty() && !previousPoints.empty()) {
+        cv::calcOpticalFlowPyrLK(previousPyramid, currentPyramid, previousPoints, nextPoints, status, errors,
+                                 window, levels,
+                                 cv::TermCriteria(cv::TermCriteria::COUNT | cv::TermCriteria::EPS, 20, 0.03));
+        const cv::Rect2f bounds(0.0f, 0.0f, static_cast<float>(luma.cols), static_cast<float>(luma.rows));
+        const int limit = vectors.rows / 2;
+        size_t kept = 0;
+        for (size_t i = 0; i < nextPoints.size(); i++) {
+            if (!status[i] || !bounds.contains(nextPoints[i])) {
+                continue;
+            }
+            if (pairs < limit) {
+                vectors.at<cv::Vec2f>(2 * pairs) = cv::Vec2f(previousPoints[i].x, previousPoints[i].y);
+                vectors.at<cv::Vec2f>(2 * pairs + 1) = cv::Vec2f(nextPoints[i].x, nextPoints[i].y);
+                pairs++;
+            }
+            previousPoints[kept++] = nextPoints[i];
+        }
+        previousPoints.resize(kept);
+    } else {
+        previousPoints.clear();
+    }
+
+    if (static_cast<int>(previousPoints.size()) < current.minTracked) {
+        seed(luma);
+    }
+    std::swap(previousPyramid, currentPyramid);
+    previousSize = luma.size();
+    return pairs;
+}
+
+PointTracker& pointTracker() {
+    static PointTracker tracker;
+    return tracker;
+}
@@ -0,0 +1,57 @@
+#ifndef EDGE_OPTICAL_FLOW_H
+#define EDGE_OPTICAL_FLOW_H
+
+#include "feature_detector.h"
+#include <opencv2/core.hpp>
+#include <mutex>
+#include <vector>
+
+// Sparse Lucas-Kanade tracking between consecutive luma frames. Each frame's
+// pyramid comes from the frame's PyramidCache (pyramid_cache.h), or from
+// buildOpticalFlowPyramid outside one, and is kept as the next frame's
+// "previous" pyramid; calcOpticalFlowPyrLK on raw Mats would build both
+// pyramids again on every call. Points are only re-seeded (from a
+// grid-bucketed FAST detector of its own) when fewer than minTracked survive.
+class PointTracker {
+public:
+    struct Params {
+        int windowSize = 21;   // LK search window, px per side
+        int maxLevel = 3;      // pyramid levels above the base
+        int minTracked = 48;   // re-seed below this many points
+    };
+
+    void setParams(const Params& params);
+
+    // Most vectors track() can return
+    int capacity();
+
+    // Tracks the current points into luma and writes each surviving one as
+    // a (from, to) pair of pixel positions: rows 2i and 2i + 1 of vectors
+    // (CV_32FC2, at least 2 * capacity() rows). Returns the number of pairs,
+    // 0 on the first frame and after a size change.
+    int track(const cv::Mat& luma, cv::Mat& vectors);
+
+    // Drops the previous frame, e.g. when the ROI moved
+    void reset();
+
+private:
+    void seed(const cv::Mat& luma);
+
+    std::mutex mutex;
+    Params current;
+    GridFeatureDetector seeder;
+    std::vector<cv::Mat> previousPyramid;
+    std::vector<cv::Mat> currentPyramid;
+    std::vector<cv::Point2f> previousPoints;
+    // Scratch reused across frames
+    std::vector<cv::Point2f> nextPoints;
+    std::vector<uchar> status;
+    std::vector<float> errors;
+    cv::Mat seedPoints;
+    cv::Size previousSize;
+};
+
+// Tracker used by the TRACKING render mode
+PointTracker& pointTracker();
+
+#endif // EDGE_OPTICAL_FLOW_H
@@ -0,0 +1,111 @@
+#include "packed_edges.h"
+#include "kernel_dispatch.h"
+#include <cstring>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define EDGE_PACKED_NEON 1
+#endif
+
+namespace {
+
+#ifdef EDGE_PACKED_NEON
+const uint8_t kBitWeights[8] = {1, 2, 4, 8, 16, 32, 64, 128};
+#endif
+
+void putCount(std::vector<uint8_t>& out, size_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+bool getCount(const uint8_t*& in, const uint8_t* end, size_t& value) {
+    value = 0;
+    for (int shift = 0; in < end && shift < 64; shift += 7) {
+        const uint8_t byte = *in++;
+        value |= static_cast<size_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void unpackRow(const uchar* in, int width, uchar* out) {
+    int x = 0;
+#ifdef EDGE_PACKED_NEON
+    const uint8x8_t weights = vld1_u8(kBitWeights);
+    for (; x + 16 <= width; x += 16) {
+        uint8x8_t first = vtst_u8(vdup_n_u8(in[x >> 3]), weights);
+        uint8x8_t second = vtst_u8(vdup_n_u8(in[(x >> 3) + 1]), weights);
+        vst1q_u8(out + x, vcombine_u8(first, second));
+    }
+#endif
+    for (; x < width; x++) {
+        out[x] = (in[x >> 3] >> (x & 7)) & 1 ? 255 : 0;
+    }
+}
+
+} // namespace
+
+int packedEdgeRowBytes(int width) {
+    return (width + 31) / 32 * 4;
+}
+
+void packEdges(const cv::Mat& edges, cv::Mat& bits) {
+    CV_Assert(edges.type() == CV_8UC1);
+    const int rowBytes = packedEdgeRowBytes(edges.cols);
+    bits.create(edges.rows, rowBytes, CV_8UC1);
+    const PackRowFn packRow = edgeKernels().packRow;  // kernel_dispatch.h
+    for (int y = 0; y < edges.rows; y++) {
+        packRow(edges.ptr<uchar>(y), edges.cols, bits.ptr<uchar>(y), rowBytes);
+    }
+}
+
+void unpackEdges(const cv::Mat& bits, int width, cv::Mat& edges) {
+    CV_Assert(bits.type() == CV_8UC1 && bits.cols >= packedEdgeRowBytes(width));
+    edges.create(bits.rows, width, CV_8UC1);
+    for (int y = 0; y < bits.rows; y++) {
+        unpackRow(bits.ptr<uchar>(y), width, edges.ptr<uchar>(y));
+    }
+}
+
+void encodeZeroRuns(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+    out.clear();
+    size_t i = 0;
+    while (i < size) {
+        size_t literal = i;
+        while (literal < size && data[literal] == 0) {
+            literal++;
+        }
+        size_t end = literal;
+        while (end < size && !(data[end] == 0 && (end + 1 == size || data[end + 1] == 0))) {
+            end++;
+        }
+        putCount(out, literal - i);
+        putCount(out, end - literal);
+        out.insert(out.end(), data + literal, data + end);
+        i = end;
+    }
+}
+
+bool decodeZeroRuns(const uint8_t* in, size_t inSize, uint8_t* data, size_t size) {
+    const uint8_t* end = in + inSize;
+    size_t i = 0;
+    while (in < end) {
+        size_t zeros = 0;
+        size_t literals = 0;
+        if (!getCount(in, end, zeros) || !getCount(in, end, literals) || zeros > size - i ||
+            literals > size - i - zeros || literals > static_cast<size_t>(end - in)) {
+            return false;
+        }
+        std::memset(data + i, 0, zeros);
+        i += zeros;
+        std::memcpy(data + i, in, literals);
+        i += literals;
+        in += literals;
+    }
+    return i == size;
+}
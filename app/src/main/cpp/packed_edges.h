@@ -0,0 +1,34 @@
+#ifndef EDGE_PACKED_EDGES_H
+#define EDGE_PACKED_EDGES_H
+
+#include <opencv2/core.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Binary edge maps at one bit per pixel: a CV_8UC1 Mat of packedEdgeRowBytes
+// (width) bytes per row, pixel x in bit (x & 7) of byte x >> 3 (least
+// significant bit first), rows padded to 4 bytes so they upload with the
+// default GL_UNPACK_ALIGNMENT. A set bit is any nonzero input pixel, which is
+// lossless for Canny's 0/255 output and 8x smaller than the 8-bit map. The
+// width is not recoverable from the bitmap, so it travels next to it.
+int packedEdgeRowBytes(int width);
+
+// bits: allocated here unless it already has the packed geometry (so a
+// pooled buffer can be passed in)
+void packEdges(const cv::Mat& edges, cv::Mat& bits);
+
+// Back to 0/255 CV_8UC1 of the given width
+void unpackEdges(const cv::Mat& bits, int width, cv::Mat& edges);
+
+// Byte coder for bitmaps that are mostly zero (sparse maps, and above all
+// XOR deltas of consecutive ones): repeated (zero count, literal count,
+// literal bytes) with LEB128 counts. A literal run only ends at two zero
+// bytes in a row, so isolated zeros cost one byte instead of two counts.
+void encodeZeroRuns(const uint8_t* data, size_t size, std::vector<uint8_t>& out);
+
+// Inverse of encodeZeroRuns into exactly size bytes; false when the input is
+// malformed or does not decode to that size
+bool decodeZeroRuns(const uint8_t* in, size_t inSize, uint8_t* data, size_t size);
+
+#endif // EDGE_PACKED_EDGES_H
@@ -0,0 +1,111 @@
+#include "pbo_uploader.h"
+#include "memory_accounting.h"
+#include "tracing.h"
+#include <cstdio>
+#include <cstring>
+
+#define LOG_TAG "PboUploader"
+#include "logging.h"
+
+// Upper bound for waiting on a slot still in flight before falling back
+static const GLuint64 kFenceTimeoutNs = 5 * 1000 * 1000;
+
+bool PboUploader::contextSupportsGles3() {
+    const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+    int major = 0;
+    int minor = 0;
+    // Format is "OpenGL ES <major>.<minor> <vendor info>"
+    if (!version || sscanf(version, "OpenGL ES %d.%d", &major, &minor) != 2) {
+        return false;
+    }
+    return major >= 3;
+}
+
+bool PboUploader::init() {
+    // Called on surface creation: any previous ring died with the old context
+    active = false;
+    GLuint buffers[kRingSize];
+    glGenBuffers(kRingSize, buffers);
+    if (glGetError() != GL_NO_ERROR) {
+        LOGE("glGenBuffers failed, staying on client-memory uploads");
+        return false;
+    }
+    for (int i = 0; i < kRingSize; i++) {
+        slots[i].buffer = buffers[i];
+        slots[i].capacity = 0;
+        slots[i].fence = nullptr;
+    }
+    next = 0;
+    active = true;
+    LOGI("PBO upload ring ready (%d slots)", kRingSize);
+    return true;
+}
+
+void PboUploader::release() {
+    for (Slot& slot : slots) {
+        if (slot.fence) {
+            glDeleteSync(slot.fence);
+            slot.fence = nullptr;
+        }
+        if (slot.buffer) {
+            glDeleteBuffers(1, &slot.buffer);
+            slot.buffer = 0;
+        }
+        accountGlMemory(-static_cast<int64_t>(slot.capacity));
+        slot.capacity = 0;
+    }
+    next = 0;
+    active = false;
+}
+
+bool PboUploader::upload(GLuint texture, GLenum format, int width, int height,
+                         const void* pixels, size_t bytes) {
+    if (!active) {
+        return false;
+    }
+    Slot& slot = slots[next];
+    next = (next + 1) % kRingSize;
+
+    // The ring is deep enough that this normally returns immediately
+    if (slot.fence) {
+        ScopedTrace trace("pbo_fence_wait");
+        GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, kFenceTimeoutNs);
+        if (status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED) {
+            LOGW_RATELIMITED("PBO slot still in flight (0x%x), uploading directly", status);
+            return false;
+        }
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+    if (slot.capacity < bytes) {
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+        accountGlMemory(static_cast<int64_t>(bytes) - static_cast<int64_t>(slot.capacity));
+        slot.capacity = bytes;
+    }
+
+    void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes,
+                                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT |
+                                    GL_MAP_UNSYNCHRONIZED_BIT);
+    if (!mapped) {
+        LOGE_RATELIMITED("glMapBufferRange failed (0x%x)", glGetError());
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return false;
+    }
+    memcpy(mapped, pixels, bytes);
+    if (!glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER)) {
+        // Contents were lost (e.g. display mode change); let the caller retry directly
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        return false;
+    }
+
+    // Sources from the bound PBO: the data pointer is an offset
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    return true;
+}
@@ -0,0 +1,42 @@
+#ifndef EDGE_PBO_UPLOADER_H
+#define EDGE_PBO_UPLOADER_H
+
+#include <GLES3/gl3.h>
+#include <cstddef>
+
+// GLES3 texture streaming through a ring of pixel unpack buffers. Each upload
+// copies into a mapped PBO and issues glTexSubImage2D from it, so the driver's
+// DMA of frame N overlaps rendering of frame N-1 instead of blocking the GL
+// thread. A fence per slot keeps unsynchronized mapping from touching a buffer
+// the GPU is still reading. GL thread only.
+class PboUploader {
+public:
+    // True when the current context is OpenGL ES 3.0 or newer
+    static bool contextSupportsGles3();
+
+    // Allocates the ring; returns false (and stays inactive) on failure
+    bool init();
+    void release();
+    bool isActive() const { return active; }
+
+    // Uploads a tightly packed 8-bit image into the bound-size texture
+    // (storage must already match width x height). Returns false if the
+    // caller should fall back to a client-memory upload.
+    bool upload(GLuint texture, GLenum format, int width, int height,
+                const void* pixels, size_t bytes);
+
+private:
+    static const int kRingSize = 4;  // two planes per frame, double buffered
+
+    struct Slot {
+        GLuint buffer = 0;
+        size_t capacity = 0;
+        GLsync fence = nullptr;
+    };
+
+    Slot slots[kRingSize];
+    int next = 0;
+    bool active = false;
+};
+
+#endif //EDGE_PBO_UPLOADER_H
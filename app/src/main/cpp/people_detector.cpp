@@ -0,0 +1,207 @@
+#include "people_detector.h"
+#include "metrics.h"
+#include <opencv2/imgproc.hpp>
+#include <opencv2/objdetect.hpp>
+#include <algorithm>
+#include <cmath>
+
+#define LOG_TAG "PeopleDetector"
+#include "logging.h"
+
+namespace {
+
+const cv::Size kWinStride(8, 8);
+const cv::Size kPadding(8, 8);
+const int kGroupThreshold = 1;       // a person needs two overlapping windows
+const double kGroupEps = 0.2;
+const float kSobelGain = 0.25f;      // 3x3 Sobel against HOG's [-1, 0, 1]: the smoothing row sums to 4
+
+}  // namespace
+
+// A HOGDescriptor whose gradient step takes derivatives the pipeline already
+// has for one image. detect() reaches computeGradient() through the virtual
+// call in its cache, so only the step is replaced, never the detector.
+class GradientReusingHog : public cv::HOGDescriptor {
+public:
+    // gradX / gradY stand for the gradients of source until cleared;
+    // detect() on any other image differentiates it as usual
+    void share(const cv::Mat& image, const cv::Mat& x, const cv::Mat& y) {
+        source = image;
+        gradX = x;
+        gradY = y;
+    }
+
+    void computeGradient(cv::InputArray img, cv::InputOutputArray grad, cv::InputOutputArray angleOfs,
+                         cv::Size paddingTL, cv::Size paddingBR) const override {
+        const cv::Mat image = img.getMat();
+        if (source.empty() || image.data != source.data || image.size() != source.size()) {
+            cv::HOGDescriptor::computeGradient(img, grad, angleOfs, paddingTL, paddingBR);
+            return;
+        }
+        // The padded border reflects the derivatives, as HOG reflects pixels
+        cv::Mat dx;
+        cv::Mat dy;
+        cv::copyMakeBorder(gradX, dx, paddingTL.height, paddingBR.height, paddingTL.width, paddingBR.width,
+                           cv::BORDER_REFLECT_101);
+        cv::copyMakeBorder(gradY, dy, paddingTL.height, paddingBR.height, paddingTL.width, paddingBR.width,
+                           cv::BORDER_REFLECT_101);
+        grad.create(dx.size(), CV_32FC2);
+        angleOfs.create(dx.size(), CV_8UC2);
+        cv::Mat gradients = grad.getMat();
+        cv::Mat angles = angleOfs.getMat();
+
+        // Magnitude split between the two nearest orientation bins, as
+        // HOGDescriptor::computeGradient does
+        const float angleScale = static_cast<float>(nbins / (signedGradient ? 2.0 * CV_PI : CV_PI));
+        cv::Mat fx(1, dx.cols, CV_32F);
+        cv::Mat fy(1, dx.cols, CV_32F);
+        cv::Mat magnitude;
+        cv::Mat angle;
+        for (int y = 0; y < dx.rows; y++) {
+            dx.row(y).convertTo(fx, CV_32F, kSobelGain);
+            dy.row(y).convertTo(fy, CV_32F, kSobelGain);
+            cv::cartToPolar(fx, fy, magnitude, angle, false);
+            const float* m = magnitude.ptr<float>();
+            const float* a = angle.ptr<float>();
+            float* g = gradients.ptr<float>(y);
+            uchar* q = angles.ptr<uchar>(y);
+            for (int x = 0; x < dx.cols; x++) {
+                float position = a[x] * angleScale - 0.5f;
+                int bin = cvFloor(position);
+                position -= bin;
+                g[2 * x] = m[x] * (1.0f - position);
+                g[2 * x + 1] = m[x] * position;
+                if (bin < 0) {
+                    bin += nbins;
+                } else if (bin >= nbins) {
+                    bin -= nbins;
+                }
+                q[2 * x] = static_cast<uchar>(bin);
+                q[2 * x + 1] = static_cast<uchar>(bin + 1 < nbins ? bin + 1 : 0);
+            }
+        }
+    }
+
+private:
+    cv::Mat source;
+    cv::Mat gradX;
+    cv::Mat gradY;
+};
+
+PeopleDetector::PeopleDetector() : hog(new GradientReusingHog()) {
+    hog->gammaCorrection = false;  // the shared derivatives are of the plain luma
+    hog->setSVMDetector(cv::HOGDescriptor::getDefaultPeopleDetector());
+}
+
+PeopleDetector::~PeopleDetector() = default;
+
+void PeopleDetector::setParams(const Params& params) {
+    std::lock_guard<std::mutex> lock(mutex);
+    current = params;
+    current.everyFrames = std::max(1, params.everyFrames);
+    current.inputWidth = std::min(std::max(params.inputWidth, 128), 1920);
+    current.levels = std::min(std::max(params.levels, 1), 8);
+    current.scaleStep = std::min(std::max(params.scaleStep, 1.05f), 2.0f);
+}
+
+void PeopleDetector::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    result.clear();
+    sinceDetection = -1;
+}
+
+bool PeopleDetector::update(const cv::Mat& luma, const cv::Mat& gradX, const cv::Mat& gradY,
+                            std::vector<Person>& people) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (sinceDetection >= 0 && ++sinceDetection < current.everyFrames) {
+        people = result;
+        return false;
+    }
+    sinceDetection = 0;
+    result.clear();
+    if (luma.empty()) {
+        people = result;
+        return false;
+    }
+    ScopedStageTimer timer(Stage::PEOPLE);
+
+    // Widest first; a level narrower or shorter than the window ends the search
+    const cv::Size window = hog->winSize;
+    const double base = std::min(1.0, static_cast<double>(current.inputWidth) / luma.cols);
+    std::vector<cv::Size> sizes;
+    for (int i = 0; i < current.levels; i++) {
+        const double scale = base / std::pow(static_cast<double>(current.scaleStep), i);
+        const cv::Size size(cvRound(luma.cols * scale), cvRound(luma.rows * scale));
+        if (size.width < window.width || size.height < window.height) {
+            break;
+        }
+        sizes.push_back(size);
+    }
+    const bool reuse = !sizes.empty() && sizes[0] == luma.size() && gradX.size() == luma.size() &&
+                       gradY.size() == luma.size() && gradX.type() == CV_16SC1 && gradY.type() == CV_16SC1;
+    if (reuse) {
+        hog->share(luma, gradX, gradY);
+        reusedGradients.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::vector<std::vector<cv::Rect>> found(sizes.size());
+    std::vector<std::vector<double>> weights(sizes.size());
+    const GradientReusingHog& detector = *hog;
+    try {
+        cv::parallel_for_(cv::Range(0, static_cast<int>(sizes.size())), [&](const cv::Range& range) {
+            for (int i = range.start; i < range.end; i++) {
+                cv::Mat level = luma;
+                if (sizes[static_cast<size_t>(i)] != luma.size()) {
+                    cv::resize(luma, level, sizes[static_cast<size_t>(i)], 0, 0, cv::INTER_AREA);
+                }
+                std::vector<cv::Point> hits;
+                detector.detect(level, hits, weights[static_cast<size_t>(i)], current.hitThreshold, kWinStride,
+                                kPadding);
+                const double sx = static_cast<double>(luma.cols) / level.cols;
+                const double sy = static_cast<double>(luma.rows) / level.rows;
+                for (const cv::Point& hit : hits) {
+                    found[static_cast<size_t>(i)].emplace_back(cvRound(hit.x * sx), cvRound(hit.y * sy),
+                                                               cvRound(window.width * sx),
+                                                               cvRound(window.height * sy));
+                }
+            }
+        });
+    } catch (const cv::Exception& e) {
+        LOGE_RATELIMITED("❌ HOG detection failed: %s", e.what());
+        found.clear();
+        weights.clear();
+    }
+    hog->share(cv::Mat(), cv::Mat(), cv::Mat());
+
+    std::vector<cv::Rect> rects;
+    std::vector<double> scores;
+    for (size_t i = 0; i < found.size(); i++) {
+        rects.insert(rects.end(), found[i].begin(), found[i].end());
+        scores.insert(scores.end(), weights[i].begin(), weights[i].end());
+    }
+    hog->groupRectangles(rects, scores, kGroupThreshold, kGroupEps);
+
+    std::vector<size_t> order(rects.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&scores](size_t a, size_t b) { return scores[a] > scores[b]; });
+    const cv::Rect2f unit(0.0f, 0.0f, 1.0f, 1.0f);
+    for (size_t i = 0; i < order.size() && result.size() < static_cast<size_t>(kMaxPeople); i++) {
+        const cv::Rect& rect = rects[order[i]];
+        Person person;
+        person.box = cv::Rect2f(static_cast<float>(rect.x) / luma.cols, static_cast<float>(rect.y) / luma.rows,
+                                static_cast<float>(rect.width) / luma.cols,
+                                static_cast<float>(rect.height) / luma.rows) & unit;
+        person.weight = static_cast<float>(scores[order[i]]);
+        result.push_back(person);
+    }
+    detections.fetch_add(1, std::memory_order_relaxed);
+    people = result;
+    return true;
+}
+
+PeopleDetector& peopleDetector() {
+    static PeopleDetector detector;
+    return detector;
+}
@@ -0,0 +1,72 @@
+#ifndef EDGE_PEOPLE_DETECTOR_H
+#define EDGE_PEOPLE_DETECTOR_H
+
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class GradientReusingHog;
+
+// Pedestrians by cv::HOGDescriptor and its default people SVM (64x128
+// windows), at a reduced resolution and only every few frames; the boxes
+// are held in between. The scale search is our own: each level is resized
+// from the luma and searched in parallel (cv::parallel_for_ across levels),
+// and the detections are grouped once at the end. When the widest level is
+// the luma itself and the edge stage kept its Sobel derivatives of it (the
+// G-API graph does), HOG's gradient step takes those instead of
+// differentiating the frame again; other levels compute their own. Both
+// paths skip HOG's gamma correction, so every level sees the same kind of
+// gradient.
+class PeopleDetector {
+public:
+    struct Params {
+        int everyFrames = 3;          // frames between detections
+        int inputWidth = 480;         // widest level searched; a wider luma is reduced
+        int levels = 4;               // scales searched, each 1/scaleStep of the one before
+        float scaleStep = 1.25f;
+        double hitThreshold = 0.0;    // SVM margin a window needs
+    };
+
+    struct Person {
+        cv::Rect2f box;       // 0..1 units of the luma
+        float weight = 0.0f;  // SVM margin of the grouped detection
+    };
+
+    static const int kMaxPeople = 16;
+
+    PeopleDetector();
+    ~PeopleDetector();
+
+    void setParams(const Params& params);
+
+    // Processing thread, once per frame of the mode, on luma (CV_8UC1).
+    // gradX / gradY are CV_16SC1 3x3 Sobel derivatives of that luma (or of
+    // its blurred copy, as Canny's are) when the edge stage kept them, empty
+    // otherwise. people receives the newest detection; true when this frame
+    // ran one.
+    bool update(const cv::Mat& luma, const cv::Mat& gradX, const cv::Mat& gradY, std::vector<Person>& people);
+
+    // Drops the held detection; the next frame detects
+    void reset();
+
+    uint64_t detectionCount() const { return detections.load(std::memory_order_relaxed); }
+    uint64_t reusedGradientCount() const { return reusedGradients.load(std::memory_order_relaxed); }
+
+private:
+    std::mutex mutex;
+    Params current;
+    std::unique_ptr<GradientReusingHog> hog;
+    std::vector<Person> result;
+    int sinceDetection = -1;   // frames since the held detection; -1 = none yet
+
+    std::atomic<uint64_t> detections{0};
+    std::atomic<uint64_t> reusedGradients{0};
+};
+
+// Detector used by the PEOPLE render mode
+PeopleDetector& peopleDetector();
+
+#endif // EDGE_PEOPLE_DETECTOR_H
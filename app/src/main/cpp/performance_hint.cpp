@@ -0,0 +1,156 @@
+#include "performance_hint.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <dlfcn.h>
+#include <mutex>
+#include <sys/types.h>
+#include <unistd.h>
+#include <vector>
+
+#define LOG_TAG "PerformanceHint"
+#include "logging.h"
+
+namespace {
+
+struct APerformanceHintManager;
+struct APerformanceHintSession;
+
+struct HintApi {
+    APerformanceHintManager* (*getManager)() = nullptr;
+    APerformanceHintSession* (*createSession)(APerformanceHintManager*, const int32_t*, size_t, int64_t) = nullptr;
+    int (*updateTarget)(APerformanceHintSession*, int64_t) = nullptr;
+    int (*reportActual)(APerformanceHintSession*, int64_t) = nullptr;
+    void (*closeSession)(APerformanceHintSession*) = nullptr;
+    int (*setThreads)(APerformanceHintSession*, const pid_t*, size_t) = nullptr;  // API 34
+    APerformanceHintManager* manager = nullptr;
+};
+
+// A thread pool never grows past this; more threads would mean a leak of tids
+const size_t kMaxThreads = 8;
+
+const HintApi& hintApi() {
+    static const HintApi api = [] {
+        HintApi loaded;
+        void* library = dlopen("libandroid.so", RTLD_NOW);
+        if (!library) {
+            return loaded;
+        }
+        loaded.getManager = reinterpret_cast<decltype(loaded.getManager)>(dlsym(library, "APerformanceHint_getManager"));
+        loaded.createSession = reinterpret_cast<decltype(loaded.createSession)>(
+                dlsym(library, "APerformanceHint_createSession"));
+        loaded.updateTarget = reinterpret_cast<decltype(loaded.updateTarget)>(
+                dlsym(library, "APerformanceHint_updateTargetWorkDuration"));
+        loaded.reportActual = reinterpret_cast<decltype(loaded.reportActual)>(
+                dlsym(library, "APerformanceHint_reportActualWorkDuration"));
+        loaded.closeSession = reinterpret_cast<decltype(loaded.closeSession)>(
+                dlsym(library, "APerformanceHint_closeSession"));
+        loaded.setThreads = reinterpret_cast<decltype(loaded.setThreads)>(dlsym(library, "APerformanceHint_setThreads"));
+        if (loaded.getManager && loaded.createSession && loaded.updateTarget && loaded.reportActual &&
+            loaded.closeSession) {
+            loaded.manager = loaded.getManager();
+        }
+        LOGI("🔄 Performance hints %s", loaded.manager ? "available" : "unavailable (API < 33)");
+        return loaded;
+    }();
+    return api;
+}
+
+struct Channel {
+    std::mutex mutex;
+    APerformanceHintSession* session = nullptr;
+    std::vector<int32_t> threads;
+    bool failed = false;  // createSession refused these threads; retried on the next retarget
+};
+
+Channel channels[static_cast<int>(HintChannel::COUNT)];
+std::atomic<bool> enabled{false};
+std::atomic<int64_t> targetNanos{0};
+
+int64_t steadyNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// channel.mutex held
+void closeChannel(Channel& channel) {
+    if (channel.session) {
+        hintApi().closeSession(channel.session);
+        channel.session = nullptr;
+    }
+    channel.threads.clear();
+    channel.failed = false;
+}
+
+// channel.mutex held; (re)creates the session for channel.threads
+void openSession(Channel& channel) {
+    const HintApi& api = hintApi();
+    if (channel.session && api.setThreads) {
+        if (api.setThreads(channel.session, channel.threads.data(), channel.threads.size()) == 0) {
+            return;
+        }
+    }
+    if (channel.session) {
+        api.closeSession(channel.session);
+    }
+    channel.session = api.createSession(api.manager, channel.threads.data(), channel.threads.size(),
+                                        targetNanos.load(std::memory_order_relaxed));
+    channel.failed = channel.session == nullptr;
+    if (channel.failed) {
+        LOGW("⚠️ Performance hint session refused for %zu threads", channel.threads.size());
+    }
+}
+
+}  // namespace
+
+bool performanceHintsAvailable() {
+    return hintApi().manager != nullptr;
+}
+
+void setPerformanceHints(bool on, float targetFps) {
+    const bool active = on && targetFps > 0.0f && performanceHintsAvailable();
+    const int64_t target = active ? static_cast<int64_t>(1e9 / targetFps) : 0;
+    targetNanos.store(target, std::memory_order_relaxed);
+    enabled.store(active, std::memory_order_relaxed);
+    for (Channel& channel : channels) {
+        std::lock_guard<std::mutex> lock(channel.mutex);
+        if (!active) {
+            closeChannel(channel);
+        } else if (channel.session) {
+            hintApi().updateTarget(channel.session, target);
+        } else {
+            channel.failed = false;  // threads are added again as they report
+        }
+    }
+}
+
+void reportWorkDuration(HintChannel which, int64_t nanos) {
+    if (!enabled.load(std::memory_order_relaxed) || nanos <= 0) {
+        return;
+    }
+    static thread_local int32_t tid = static_cast<int32_t>(gettid());
+    Channel& channel = channels[static_cast<int>(which)];
+    std::lock_guard<std::mutex> lock(channel.mutex);
+    if (!enabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+    if (std::find(channel.threads.begin(), channel.threads.end(), tid) == channel.threads.end()) {
+        if (channel.failed || channel.threads.size() >= kMaxThreads) {
+            return;
+        }
+        channel.threads.push_back(tid);
+        openSession(channel);
+    }
+    if (channel.session) {
+        hintApi().reportActual(channel.session, nanos);
+    }
+}
+
+PerformanceHintScope::PerformanceHintScope(HintChannel channel)
+    : channel(channel), start(enabled.load(std::memory_order_relaxed) ? steadyNanos() : 0) {}
+
+PerformanceHintScope::~PerformanceHintScope() {
+    if (start != 0) {
+        reportWorkDuration(channel, steadyNanos() - start);
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef EDGE_PERFORMANCE_HINT_H
+#define EDGE_PERFORMANCE_HINT_H
+
+#include <cstdint>
+
+// Android Dynamic Performance Framework (APerformanceHint, API 33+): the
+// threads of each channel share a hint session, and every frame reports its
+// actual work duration against the target frame period, so the OS raises
+// clocks before deadlines are missed instead of after. Resolved at runtime
+// (minSdk is 24); everything is a no-op without it.
+//
+// Processing and rendering get a session each: their durations are
+// unrelated, and one session fed both would read as alternating over- and
+// under-runs.
+enum class HintChannel : int {
+    PROCESSING = 0,  // processing worker / synchronous ingest / pipeline step 3
+    RENDER = 1,      // GL thread
+    COUNT
+};
+
+// Starts (or retargets) the sessions; fps <= 0 or enabled=false closes them
+void setPerformanceHints(bool enabled, float targetFps);
+
+// True when the platform provides APerformanceHint
+bool performanceHintsAvailable();
+
+// Reports one frame of work done on the calling thread; the thread joins the
+// channel's session the first time it reports
+void reportWorkDuration(HintChannel channel, int64_t nanos);
+
+// Reports the lifetime of the enclosing scope
+class PerformanceHintScope {
+public:
+    explicit PerformanceHintScope(HintChannel channel);
+    ~PerformanceHintScope();
+
+    PerformanceHintScope(const PerformanceHintScope&) = delete;
+    PerformanceHintScope& operator=(const PerformanceHintScope&) = delete;
+
+private:
+    HintChannel channel;
+    int64_t start;
+};
+
+#endif // EDGE_PERFORMANCE_HINT_H
@@ -0,0 +1,80 @@
+#include "processing_worker.h"
+#include "thread_policy.h"
+
+#define LOG_TAG "ProcessingWorker"
+#include "logging.h"
+
+ProcessingWorker::~ProcessingWorker() {
+    stop();
+}
+
+void ProcessingWorker::start(Handler frameHandler) {
+    if (isRunning()) {
+        return;
+    }
+    handler = std::move(frameHandler);
+    stopping = false;
+    hasPending = false;
+    running.store(true, std::memory_order_release);
+    thread = std::thread(&ProcessingWorker::run, this);
+    LOGI("✅ Processing worker started");
+}
+
+void ProcessingWorker::stop() {
+    if (!isRunning()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeup.notify_one();
+    thread.join();
+    running.store(false, std::memory_order_release);
+
+    pending = PendingFrame();
+    hasPending = false;
+    LOGI("✅ Processing worker stopped (processed=%llu, dropped=%llu)",
+         static_cast<unsigned long long>(processedCount()),
+         static_cast<unsigned long long>(droppedCount()));
+}
+
+bool ProcessingWorker::submit(PendingFrame&& frame) {
+    bool replaced;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        replaced = hasPending;
+        pending = std::move(frame);
+        hasPending = true;
+    }
+    wakeup.notify_one();
+
+    if (replaced) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+    return !replaced;
+}
+
+void ProcessingWorker::run() {
+    setThreadTier(ThreadTier::PROCESSING);  // not whatever the starting thread ran at
+    for (;;) {
+        PendingFrame frame;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeup.wait(lock, [this] { return hasPending || stopping; });
+            if (stopping) {
+                return;
+            }
+            frame = std::move(pending);
+            pending = PendingFrame();
+            hasPending = false;
+        }
+
+        try {
+            handler(frame);
+        } catch (const std::exception& e) {
+            LOGE_RATELIMITED("❌ Frame handler threw: %s", e.what());
+        }
+        processed.fetch_add(1, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef EDGE_PROCESSING_WORKER_H
+#define EDGE_PROCESSING_WORKER_H
+
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// A frame owned by the pipeline: NV21 data in a buffer the worker holds a
+// reference to (pooled copy or a native-owned direct buffer).
+struct PendingFrame {
+    cv::Mat nv21;   // (height + height/2) x width, CV_8UC1
+    int width = 0;
+    int height = 0;
+    int rotation = 0;
+    int64_t timestampNs = 0;  // capture time on CLOCK_BOOTTIME (see bootTimeNanos)
+};
+
+// Dedicated processing thread with a single-entry input slot. submit() never
+// blocks on processing: a frame that arrives while the previous one is still
+// waiting replaces it (drop-oldest) and is counted as dropped.
+class ProcessingWorker {
+public:
+    using Handler = std::function<void(const PendingFrame&)>;
+
+    ~ProcessingWorker();
+
+    void start(Handler handler);
+    void stop();
+    bool isRunning() const { return running.load(std::memory_order_acquire); }
+
+    // Returns false if an unprocessed frame had to be dropped to make room
+    bool submit(PendingFrame&& frame);
+
+    uint64_t droppedCount() const { return dropped.load(std::memory_order_relaxed); }
+    uint64_t processedCount() const { return processed.load(std::memory_order_relaxed); }
+
+private:
+    void run();
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    PendingFrame pending;
+    bool hasPending = false;
+    bool stopping = false;
+    Handler handler;
+
+    std::atomic<bool> running{false};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> processed{0};
+};
+
+#endif // EDGE_PROCESSING_WORKER_H
@@ -0,0 +1,103 @@
+#include "pyramid_cache.h"
+#include "frame_pool.h"
+#include "tracing.h"
+#include <opencv2/imgproc.hpp>
+
+namespace {
+
+// The margin OpenCV's own pyramid builder fills; BORDER_ISOLATED keeps
+// copyMakeBorder from reading past the ROI into the margin it writes
+const int kPyramidBorder = cv::BORDER_REFLECT_101;
+
+// A CV_8UC1 buffer of size plus the margin on every side, and its ROI
+cv::Mat borderedLevel(const cv::Size& size, cv::Mat& buffer) {
+    const int border = PyramidCache::kBorder;
+    buffer = framePool().acquire(size.height + 2 * border, size.width + 2 * border, CV_8UC1, MemoryClient::PYRAMIDS);
+    return buffer(cv::Rect(border, border, size.width, size.height));
+}
+
+void fillBorder(const cv::Mat& level, cv::Mat& buffer) {
+    const int border = PyramidCache::kBorder;
+    cv::copyMakeBorder(level, buffer, border, border, border, border, kPyramidBorder | cv::BORDER_ISOLATED);
+}
+
+} // namespace
+
+void PyramidCache::begin(const cv::Mat& luma) {
+    end();
+    base = luma;
+    levels.push_back(luma);
+}
+
+void PyramidCache::end() {
+    base.release();
+    borderedBase.release();
+    levels.clear();
+}
+
+bool PyramidCache::covers(const cv::Mat& luma) const {
+    return !base.empty() && luma.data == base.data && luma.size() == base.size() && luma.step == base.step;
+}
+
+cv::Mat PyramidCache::level(int index) {
+    if (index < 0 || index >= kMaxLevels || levels.empty()) {
+        return cv::Mat();
+    }
+    while (static_cast<int>(levels.size()) <= index) {
+        const cv::Mat& below = levels.back();
+        const cv::Size size((below.cols + 1) / 2, (below.rows + 1) / 2);
+        if (size.width < kMinSide || size.height < kMinSide) {
+            return cv::Mat();
+        }
+        ScopedTrace trace("pyramid_level");
+        cv::Mat buffer;
+        cv::Mat next = borderedLevel(size, buffer);
+        // next already has the output geometry, so pyrDown writes into the ROI
+        cv::pyrDown(below, next, size);
+        fillBorder(next, buffer);
+        levels.push_back(next);
+    }
+    return levels[static_cast<size_t>(index)];
+}
+
+int PyramidCache::flowPyramid(int maxLevel, const cv::Size& window, std::vector<cv::Mat>& pyramid) {
+    pyramid.clear();
+    if (base.empty()) {
+        return -1;
+    }
+    if (borderedBase.empty()) {
+        cv::Mat bordered = borderedLevel(base.size(), borderedBase);
+        base.copyTo(bordered);
+        fillBorder(bordered, borderedBase);
+    }
+    const int border = kBorder;
+    pyramid.push_back(borderedBase(cv::Rect(border, border, base.cols, base.rows)));
+    for (int index = 1; index <= maxLevel; index++) {
+        cv::Mat next = level(index);
+        if (next.empty() || next.cols <= window.width || next.rows <= window.height) {
+            break;
+        }
+        pyramid.push_back(next);
+    }
+    return static_cast<int>(pyramid.size()) - 1;
+}
+
+int PyramidCache::levelAtLeast(const cv::Size& size) {
+    // From the sizes pyrDown produces, so levels that are not needed stay unbuilt
+    int chosen = 0;
+    cv::Size next = base.size();
+    for (int index = 1; index < kMaxLevels; index++) {
+        next = cv::Size((next.width + 1) / 2, (next.height + 1) / 2);
+        if (next.width < kMinSide || next.height < kMinSide || next.width < size.width ||
+            next.height < size.height) {
+            break;
+        }
+        chosen = index;
+    }
+    return chosen;
+}
+
+PyramidCache& pyramidCache() {
+    static thread_local PyramidCache cache;
+    return cache;
+}
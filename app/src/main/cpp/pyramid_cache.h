@@ -0,0 +1,63 @@
+#ifndef EDGE_PYRAMID_CACHE_H
+#define EDGE_PYRAMID_CACHE_H
+
+#include <opencv2/core.hpp>
+#include <vector>
+
+// Gaussian pyramid of the luma a processing thread is working on, built at
+// most once per frame and shared by its consumers (multi-scale edges, the
+// Lucas-Kanade tracker, DNN input prep) instead of each down-sampling its own
+// copy. Level 0 is the luma as given; every next level is cv::pyrDown (5x5
+// Gaussian, half size, SIMD in OpenCV) of the one below, built on first use.
+// Levels above 0 live in pooled buffers with a reflected margin of kBorder
+// pixels, the layout calcOpticalFlowPyrLK reads without copying. One cache
+// per thread, so pipelines processing side by side never share one.
+class PyramidCache {
+public:
+    static const int kMaxLevels = 6;   // the base and five halvings
+    static const int kBorder = 32;     // margin around each level: the widest LK window it serves
+    static const int kMinSide = 16;    // no level gets smaller than this on either axis
+
+    // Starts a frame on luma (CV_8UC1), dropping the previous frame's levels.
+    // luma must stay valid until end().
+    void begin(const cv::Mat& luma);
+    // Releases every level; consumers that keep one (the tracker's previous
+    // frame) hold their own reference
+    void end();
+
+    // luma is the base of the frame in progress
+    bool covers(const cv::Mat& luma) const;
+
+    // Level index (0 = the base), empty past the smallest one
+    cv::Mat level(int index);
+
+    // Levels 0..maxLevel as calcOpticalFlowPyrLK expects them, stopping below
+    // the first level not larger than window (as buildOpticalFlowPyramid
+    // does). Level 0 is copied into a bordered buffer once per frame for it.
+    // Returns the highest level in pyramid.
+    int flowPyramid(int maxLevel, const cv::Size& window, std::vector<cv::Mat>& pyramid);
+
+    // The smallest level that is at least size on both axes (the base when
+    // none is), e.g. the cheapest input that still covers a network's
+    int levelAtLeast(const cv::Size& size);
+
+private:
+    cv::Mat base;
+    cv::Mat borderedBase;         // base inside a kBorder margin, for flowPyramid
+    std::vector<cv::Mat> levels;  // [0] = base; the rest are ROIs of bordered buffers
+};
+
+// This thread's cache
+PyramidCache& pyramidCache();
+
+// begin() on construction, end() on destruction
+class ScopedPyramidFrame {
+public:
+    explicit ScopedPyramidFrame(const cv::Mat& luma) { pyramidCache().begin(luma); }
+    ~ScopedPyramidFrame() { pyramidCache().end(); }
+
+    ScopedPyramidFrame(const ScopedPyramidFrame&) = delete;
+    ScopedPyramidFrame& operator=(const ScopedPyramidFrame&) = delete;
+};
+
+#endif // EDGE_PYRAMID_CACHE_H
@@ -0,0 +1,180 @@
+#include "quality_governor.h"
+#include "metrics.h"
+#include <algorithm>
+#include <dlfcn.h>
+
+#define LOG_TAG "QualityGovernor"
+#include "logging.h"
+
+namespace {
+
+const double kSmoothing = 0.1;            // weight of the newest frame in the EMA
+const double kStepDownRatio = 0.95;       // of the frame interval
+const double kStepUpRatio = 0.6;          // headroom needed before trying a better level
+const int kSettleFrames = 30;             // after a change, before the EMA is trusted again
+const int kHeadroomFrames = 90;           // ~3 s at 30 fps
+const int kMaxHeadroomFrames = 1800;
+const int64_t kFlapWindowMicros = 5000000;  // stepping down this soon after stepping up doubles the wait
+const int64_t kThermalPollMicros = 1000000;
+
+// AThermal is API 30 and minSdk is 24, so it is looked up at runtime
+// (ATHERMAL_STATUS_* values: 0 none, 1 light, 2 moderate, 3 severe, ...)
+struct AThermalManager;
+using AcquireFn = AThermalManager* (*)();
+using StatusFn = int (*)(AThermalManager*);
+
+int packLevel(const QualityGovernor::Level& level) {
+    return (std::min(level.scaleDivisor, 255) & 0xff) | (level.gradientOnly ? 0x100 : 0) |
+           ((std::min(level.frameSkip, 255) & 0xff) << 9) | (level.boundedHysteresis ? 0x20000 : 0);
+}
+
+}  // namespace
+
+QualityGovernor::QualityGovernor() {
+    levels = {
+        {1, false, 0},
+        {1, false, 0, true},
+        {2, false, 0, true},
+        {4, false, 0, true},
+        {4, true, 0},
+        {4, true, 1},
+        {4, true, 2},
+    };
+    packedLevel.store(packLevel(levels[0]));
+    headroomRequired = kHeadroomFrames;
+}
+
+void QualityGovernor::setEnabled(bool enabled, float fps) {
+    std::lock_guard<std::mutex> lock(mutex);
+    targetFps = fps > 0.0f ? fps : 30.0f;
+    averageMicros = 0.0;
+    settleFrames = kSettleFrames;
+    headroomFrames = 0;
+    headroomRequired = kHeadroomFrames;
+    active.store(enabled, std::memory_order_relaxed);
+    setIndex(0);
+}
+
+void QualityGovernor::setLevels(const std::vector<Level>& newLevels) {
+    if (newLevels.empty()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    levels = newLevels;
+    settleFrames = kSettleFrames;
+    setIndex(0);
+}
+
+int QualityGovernor::levelCount() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return static_cast<int>(levels.size());
+}
+
+QualityGovernor::Level QualityGovernor::current() const {
+    Level level;
+    if (!active.load(std::memory_order_relaxed)) {
+        return level;
+    }
+    const int packed = packedLevel.load(std::memory_order_relaxed);
+    level.scaleDivisor = std::max(1, packed & 0xff);
+    level.gradientOnly = (packed & 0x100) != 0;
+    level.frameSkip = (packed >> 9) & 0xff;
+    level.boundedHysteresis = (packed & 0x20000) != 0;
+    return level;
+}
+
+bool QualityGovernor::shouldSkip() {
+    const int skip = current().frameSkip;
+    if (skip <= 0) {
+        return false;
+    }
+    return skipCounter.fetch_add(1, std::memory_order_relaxed) % static_cast<uint32_t>(skip + 1) != 0;
+}
+
+// mutex held
+void QualityGovernor::setIndex(int index) {
+    currentIndex.store(index, std::memory_order_relaxed);
+    packedLevel.store(packLevel(active.load(std::memory_order_relaxed) ? levels[index] : levels[0]),
+                      std::memory_order_relaxed);
+}
+
+int deviceThermalStatus() {
+    struct ThermalApi {
+        AThermalManager* manager = nullptr;
+        StatusFn status = nullptr;
+    };
+    static const ThermalApi api = [] {
+        ThermalApi loaded;
+        void* library = dlopen("libandroid.so", RTLD_NOW);
+        auto acquire = library ? reinterpret_cast<AcquireFn>(dlsym(library, "AThermal_acquireManager")) : nullptr;
+        loaded.status = library ? reinterpret_cast<StatusFn>(dlsym(library, "AThermal_getCurrentThermalStatus")) : nullptr;
+        loaded.manager = (acquire && loaded.status) ? acquire() : nullptr;
+        LOGI("🔄 Thermal status %s", loaded.manager ? "available" : "unavailable (API < 30)");
+        return loaded;
+    }();
+    return api.manager ? std::max(0, api.status(api.manager)) : 0;
+}
+
+void QualityGovernor::onFrame(int64_t processingMicros) {
+    if (!active.load(std::memory_order_relaxed)) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    const int64_t now = monotonicMicros();
+    if (now >= nextThermalPollMicros) {
+        nextThermalPollMicros = now + kThermalPollMicros;
+        thermal.store(deviceThermalStatus(), std::memory_order_relaxed);
+    }
+    averageMicros = averageMicros <= 0.0 ? processingMicros
+                                         : averageMicros + kSmoothing * (processingMicros - averageMicros);
+    smoothed.store(static_cast<int64_t>(averageMicros), std::memory_order_relaxed);
+
+    const int last = static_cast<int>(levels.size()) - 1;
+    int index = currentIndex.load(std::memory_order_relaxed);
+    // Moderate heat and above rule out the best levels outright
+    const int thermalFloor = std::min(last, std::max(0, thermal.load(std::memory_order_relaxed) - 1));
+    if (index < thermalFloor) {
+        LOGI("🔄 Thermal status %d: quality level %d -> %d", thermal.load(), index, thermalFloor);
+        setIndex(thermalFloor);
+        settleFrames = kSettleFrames;
+        headroomFrames = 0;
+        return;
+    }
+    if (settleFrames > 0) {
+        settleFrames--;
+        return;
+    }
+
+    const double budget = 1000000.0 / targetFps;
+    if (averageMicros > kStepDownRatio * budget && index < last) {
+        if (now - lastStepUpMicros < kFlapWindowMicros) {
+            headroomRequired = std::min(headroomRequired * 2, kMaxHeadroomFrames);
+        }
+        LOGI("🔄 %.1f ms per frame over the %.1f fps target: quality level %d -> %d",
+             averageMicros / 1000.0, targetFps, index, index + 1);
+        setIndex(index + 1);
+        settleFrames = kSettleFrames;
+        headroomFrames = 0;
+        return;
+    }
+    if (averageMicros < kStepUpRatio * budget && index > thermalFloor) {
+        if (++headroomFrames >= headroomRequired) {
+            if (now - lastStepUpMicros > 10 * kFlapWindowMicros) {
+                headroomRequired = kHeadroomFrames;  // the last step up held: back to the normal wait
+            }
+            LOGI("🔄 Headroom at %.1f ms per frame: quality level %d -> %d", averageMicros / 1000.0, index,
+                 index - 1);
+            setIndex(index - 1);
+            settleFrames = kSettleFrames;
+            headroomFrames = 0;
+            lastStepUpMicros = now;
+        }
+    } else {
+        headroomFrames = 0;
+    }
+}
+
+QualityGovernor& qualityGovernor() {
+    static QualityGovernor governor;
+    return governor;
+}
@@ -0,0 +1,74 @@
+#ifndef EDGE_QUALITY_GOVERNOR_H
+#define EDGE_QUALITY_GOVERNOR_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Trades quality for frame rate. Each processed frame reports its processing
+// time; when the smoothed time no longer fits the target frame interval, or
+// the device reports thermal stress (AThermal, API 30+), the governor steps
+// down one configured level, and it steps back up after a sustained stretch
+// of headroom. Level 0 is the configured quality; later levels are cheaper.
+class QualityGovernor {
+public:
+    struct Level {
+        int scaleDivisor = 1;       // extra processing downscale on top of the configured size
+        bool gradientOnly = false;  // thresholded Sobel magnitude instead of Canny
+        int frameSkip = 0;          // frames skipped after every processed one
+        bool boundedHysteresis = false;  // Canny with fixed-cost hysteresis (CannyBackend::BOUNDED)
+    };
+
+    // Default ladder: bounded hysteresis first, which caps the worst frames
+    // at no resolution cost, then with 1/2 and 1/4 scale, then gradient only,
+    // then skipping one and two frames in three
+    QualityGovernor();
+
+    void setEnabled(bool enabled, float targetFps);
+    bool enabled() const { return active.load(std::memory_order_relaxed); }
+
+    // Replaces the ladder (at least one level) and restarts at level 0
+    void setLevels(const std::vector<Level>& levels);
+
+    // Level to apply to the next frame; level 0 while disabled. Lock-free.
+    Level current() const;
+
+    // True for frames the current level skips; call once per arriving frame
+    bool shouldSkip();
+
+    // Processing time of one frame (microseconds); may change the level
+    void onFrame(int64_t processingMicros);
+
+    int levelIndex() const { return currentIndex.load(std::memory_order_relaxed); }
+    int levelCount();
+    int thermalStatus() const { return thermal.load(std::memory_order_relaxed); }
+    int64_t smoothedMicros() const { return smoothed.load(std::memory_order_relaxed); }
+
+private:
+    void setIndex(int index);
+
+    std::mutex mutex;
+    std::vector<Level> levels;
+    float targetFps = 30.0f;
+    double averageMicros = 0.0;     // EMA of processing time
+    int settleFrames = 0;           // frames to wait before the next decision
+    int headroomFrames = 0;         // consecutive frames well inside the budget
+    int headroomRequired = 0;       // grows when stepping up did not hold
+    int64_t lastStepUpMicros = 0;
+    int64_t nextThermalPollMicros = 0;
+
+    std::atomic<bool> active{false};
+    std::atomic<int> currentIndex{0};
+    std::atomic<int> packedLevel{0};    // current() without the mutex
+    std::atomic<int> thermal{0};        // AThermalStatus, 0 (none) when unavailable
+    std::atomic<int64_t> smoothed{0};
+    std::atomic<uint32_t> skipCounter{0};
+};
+
+QualityGovernor& qualityGovernor();
+
+// AThermal_getCurrentThermalStatus (ATHERMAL_STATUS_*), 0 (none) below API 30
+int deviceThermalStatus();
+
+#endif // EDGE_QUALITY_GOVERNOR_H
@@ -0,0 +1,104 @@
+#include "render_effects.h"
+#include <algorithm>
+
+#define LOG_TAG "RenderEffects"
+#include "logging.h"
+
+namespace {
+
+const size_t kMaxNameLength = 32;
+
+// Names end up in program cache file names
+bool validName(const std::string& name) {
+    if (name.empty() || name.size() > kMaxNameLength) {
+        return false;
+    }
+    return std::all_of(name.begin(), name.end(), [](char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+    });
+}
+
+}  // namespace
+
+bool RenderEffects::define(const std::string& name, const std::string& fragment, std::string& error) {
+    if (!validName(name)) {
+        error = "effect names are 1-32 characters of [A-Za-z0-9_]";
+        return false;
+    }
+    if (fragment.find("gl_FragColor") == std::string::npos) {
+        error = "the fragment shader never writes gl_FragColor";
+        return false;
+    }
+    auto effect = std::make_shared<RenderEffect>();
+    effect->name = name;
+    effect->fragment = fragment;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto existing = std::find_if(effects.begin(), effects.end(),
+                                 [&name](const std::shared_ptr<const RenderEffect>& e) { return e->name == name; });
+    if (existing != effects.end()) {
+        *existing = effect;
+    } else if (static_cast<int>(effects.size()) == kMaxEffects) {
+        error = "no room for more than " + std::to_string(kMaxEffects) + " effects";
+        return false;
+    } else {
+        effects.push_back(effect);
+    }
+    rebuildChainLocked();
+    LOGI("🔄 Render effect '%s' defined", name.c_str());
+    return true;
+}
+
+bool RenderEffects::remove(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto existing = std::find_if(effects.begin(), effects.end(),
+                                 [&name](const std::shared_ptr<const RenderEffect>& e) { return e->name == name; });
+    if (existing == effects.end()) {
+        return false;
+    }
+    effects.erase(existing);
+    chainNames.erase(std::remove(chainNames.begin(), chainNames.end(), name), chainNames.end());
+    rebuildChainLocked();
+    return true;
+}
+
+bool RenderEffects::setChain(const std::vector<std::string>& names, std::string& error) {
+    if (static_cast<int>(names.size()) > kMaxChain) {
+        error = "at most " + std::to_string(kMaxChain) + " effects in the chain";
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const std::string& name : names) {
+        if (std::none_of(effects.begin(), effects.end(),
+                         [&name](const std::shared_ptr<const RenderEffect>& e) { return e->name == name; })) {
+            error = "unknown effect '" + name + "'";
+            return false;
+        }
+    }
+    chainNames = names;
+    rebuildChainLocked();
+    LOGI("🔄 Render effect chain of %zu", names.size());
+    return true;
+}
+
+RenderEffects::Chain RenderEffects::chain() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return active;
+}
+
+void RenderEffects::rebuildChainLocked() {
+    active.clear();
+    for (const std::string& name : chainNames) {
+        for (const auto& effect : effects) {
+            if (effect->name == name) {
+                active.push_back(effect);
+            }
+        }
+    }
+    changes.fetch_add(1, std::memory_order_acq_rel);
+}
+
+RenderEffects& renderEffects() {
+    static RenderEffects instance;
+    return instance;
+}
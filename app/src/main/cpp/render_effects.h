@@ -0,0 +1,68 @@
+#ifndef EDGE_RENDER_EFFECTS_H
+#define EDGE_RENDER_EFFECTS_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// A fragment shader defined at runtime and run over the drawn frame layer.
+// GLSL ES 1.00 after a preamble the renderer puts in front of it (so no
+// #extension or #version lines), which declares mediump precision and
+//   varying highp vec2 v_TexCoord;   // 0..1 over the layer's screen area
+//   uniform sampler2D u_Texture;     // the layer so far (RGBA)
+//   uniform highp vec2 u_TexelSize;  // 1 / area size
+//   uniform vec4 u_Params;           // ControlBlock::effectParams, shared by every effect
+// Its main() writes gl_FragColor, e.g. a threshold:
+//   void main() {
+//       float v = step(u_Params.x, texture2D(u_Texture, v_TexCoord).g);
+//       gl_FragColor = vec4(v, v, v, 1.0);
+//   }
+struct RenderEffect {
+    std::string name;
+    std::string fragment;
+};
+
+// The chain of render effects every GL thread applies to each pipeline
+// frame's layer, in order, through two ping-pong render targets of the
+// layer's area, the last pass drawing back to the surface. Overlays and
+// markers are drawn on top afterwards, unaffected. Effects are compiled
+// through the shader registry's program cache on each GL thread; one that
+// fails to compile is skipped there (and logged). Cheap visual looks
+// (colormaps, thresholds, vignettes) then need no CPU render mode.
+class RenderEffects {
+public:
+    static const int kMaxEffects = 16;
+    static const int kMaxChain = 4;
+
+    // Defines or replaces the effect called name ([A-Za-z0-9_], up to 32
+    // characters); error says why not. Compilation happens on the GL threads.
+    bool define(const std::string& name, const std::string& fragment, std::string& error);
+    bool remove(const std::string& name);
+
+    // Effects applied from the next frame, by name; empty turns them off.
+    // Unknown names are an error and leave the chain as it was.
+    bool setChain(const std::vector<std::string>& names, std::string& error);
+
+    using Chain = std::vector<std::shared_ptr<const RenderEffect>>;
+
+    // Bumped by every change of the chain or of an effect in it; one relaxed
+    // load for the GL threads to see whether to fetch the chain again
+    uint32_t generation() const { return changes.load(std::memory_order_acquire); }
+    Chain chain();
+
+private:
+    void rebuildChainLocked();
+
+    std::mutex mutex;
+    std::vector<std::shared_ptr<const RenderEffect>> effects;
+    std::vector<std::string> chainNames;
+    Chain active;
+    std::atomic<uint32_t> changes{0};
+};
+
+RenderEffects& renderEffects();
+
+#endif // EDGE_RENDER_EFFECTS_H
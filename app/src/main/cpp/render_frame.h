@@ -0,0 +1,181 @@
+#ifndef EDGE_RENDER_FRAME_H
+#define EDGE_RENDER_FRAME_H
+
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+struct AHardwareBuffer;
+struct MosaicView;
+
+// An edge image GL samples without any upload (the Vulkan backend): an RGBA8
+// AHardwareBuffer, immutable while referenced. Dropping the last reference
+// hands the buffer back to its producer's ring.
+struct SharedEdgeImage {
+    AHardwareBuffer* buffer = nullptr;
+    int width = 0;
+    int height = 0;
+    uint64_t id = 0;  // unique per written frame (the buffer itself is reused)
+};
+
+// A processed frame the CPU wrote straight into an AHardwareBuffer
+// (hardware_frames.h), sampled as an EGLImage instead of being uploaded: RGBA8,
+// or R8 broadcast like an uploaded single-channel frame. Immutable while
+// referenced; dropping the last reference hands it back to the ring.
+struct HardwareFrame {
+    AHardwareBuffer* buffer = nullptr;
+    int width = 0;
+    int height = 0;
+    int stride = 0;              // pixels per row of the CPU mapping
+    bool singleChannel = false;  // R8
+    uint64_t id = 0;             // unique per written frame (the buffer itself is reused)
+    // Native fence fd of the last draw sampling the buffer (-1 = none), left by
+    // the renderer; the next CPU write waits on it before touching the pixels
+    mutable std::atomic<int> readFence{-1};
+};
+
+// What the pipeline hands to the GL thread for one draw. Mats are headers over
+// immutable published buffers and stay valid until the next fetch.
+struct RenderFrame {
+    // 8-bit image (gray, BGR or RGBA). When chroma is set this is the Y plane
+    // of a YUV frame instead, and the renderer converts to RGB in the shader.
+    cv::Mat image;
+    // Interleaved VU plane (NV21 order, CV_8UC2) at half resolution, or empty
+    cv::Mat chroma;
+    // Clockwise degrees that make the sensor-native buffers upright (0/90/180/270)
+    int rotation = 0;
+    // Publish sequence of the set this came from (0 = fallback/none); the
+    // renderer skips re-uploading a frame it has already uploaded
+    uint64_t sequence = 0;
+    // Capture time of the published frame (CLOCK_BOOTTIME ns), 0 = unknown
+    int64_t captureTimestampNs = 0;
+    // No CPU pixels: draw the camera's SurfaceTexture (GL_TEXTURE_EXTERNAL_OES)
+    bool useExternalTexture = false;
+    // image is luma; the renderer runs its multi-pass edge detector on it. With
+    // useExternalTexture: edges of the camera texture through OpenCL (CL-GL
+    // interop), or the plain camera frame where that is unavailable.
+    bool detectEdgesOnGpu = false;
+    // With detectEdgesOnGpu, the split edge backend: the CPU's edge map of
+    // image's top splitEdges.rows rows (CV_8UC1, image's width). The GPU
+    // passes only run on the rows below (plus a halo) and the renderer draws
+    // both parts; empty = the GPU does the whole frame.
+    cv::Mat splitEdges;
+    // Set: draw this image (Vulkan compute edges) instead of image
+    std::shared_ptr<const SharedEdgeImage> sharedEdges;
+    // Set: image already sits in this buffer; drawn from it without an upload
+    // (image is the fallback when EGL cannot wrap the buffer)
+    std::shared_ptr<const HardwareFrame> hardwareFrame;
+    // Set: draw this mosaic (mosaic_builder.h) instead of image. The renderer
+    // keeps the canvas in a texture of its own and uploads only the tiles
+    // whose revision it has not uploaded yet.
+    std::shared_ptr<const MosaicView> mosaic;
+
+    // How the layers are put on screen
+    enum class Composition {
+        SINGLE,   // image letterboxed into the viewport
+        OVERLAY,  // overlay blended on top of image (DEFAULT)
+        INSET,    // overlay in a picture-in-picture quad over image (INSET)
+        FILL,     // image scaled to cover the viewport, edges cropped (BORDER_FIX)
+        REGION    // overlay drawn opaque over image inside region (processing ROI)
+    };
+    Composition composition = Composition::SINGLE;
+    // Second layer for OVERLAY/INSET/REGION: CV_8UC1 processed frame, same
+    // orientation as image
+    cv::Mat overlay;
+    // > 0: the edge layer (overlay when there is one, image otherwise) is a
+    // 1-bpp bitmap of this many pixels per row (packed_edges.h), expanded in
+    // the shader
+    int bitmapWidth = 0;
+    // Incremental Canny (incremental_edges.h): the edge layer is detector
+    // result edgeResult, which differs from result changeBase only inside
+    // changedRects (CV_32SC4 x, y, width, height; may have 0 rows). A
+    // texture still holding changeBase takes just those rects; 0 = untracked,
+    // uploaded whole.
+    uint64_t edgeResult = 0;
+    uint64_t changeBase = 0;
+    cv::Mat changedRects;
+
+    // Processing ROI: the processed layer (overlay, or image for SINGLE/FILL)
+    // only covers this rectangle of a regionFrameSize frame; empty = all of it
+    cv::Rect region;
+    cv::Size regionFrameSize;
+    // How much the background outside region is darkened (0 = not at all, 1 = black)
+    float backgroundDim = 0.0f;
+
+    // Points drawn on top of everything else: CV_32FC2 (u, v) in 0..1 units of
+    // a markerFrameSize sensor-native frame; LINES takes them in pairs and
+    // LINE_STRIPS as the runs markerOffsets delimits. A frame may carry
+    // markers alone (no image), drawn over black.
+    enum class MarkerStyle { POINTS, LINES, LINE_STRIPS };
+    cv::Mat markers;
+    // LINE_STRIPS: CV_32SC1 first vertex of every strip, then the vertex count
+    cv::Mat markerOffsets;
+    MarkerStyle markerStyle = MarkerStyle::POINTS;
+    cv::Size markerFrameSize;
+
+    // Set: the layers and markers are drawn moved by warp, an affine map of
+    // 0..1 buffer coordinates of the full frame (STABILIZE). It is applied to
+    // the vertices of the frame quad and clipped to the unmoved frame's
+    // rectangle; the pixels are never resampled on the CPU. Not used with
+    // the OES camera texture, whose transform is the SurfaceTexture's.
+    bool warped = false;
+    cv::Matx23f warp = cv::Matx23f(1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f);
+
+    // DOCUMENT: a perspective-rectified view of the tracked quad. rectify
+    // maps 0..1 coordinates of the rectified picture (sensor orientation,
+    // rectifiedSize pixels) to 0..1 buffer coordinates of image; the renderer
+    // applies it per fragment through projective texture coordinates rather
+    // than a CPU warpPerspective. rectifiedInset shows it upright in a corner
+    // of the view, and a non-empty rectifiedReadback also renders it upright
+    // at that size for the rectified readback consumer (gpu_readback.h).
+    bool rectifiedInset = false;
+    cv::Matx33f rectify;
+    cv::Size rectifiedSize;
+    cv::Size rectifiedReadback;
+
+    // Set: image is drawn lens-undistorted by the renderer, through the
+    // precomputed map of its size (lens_undistortion.h). Only whole-frame,
+    // single-layer pictures, which the map covers; where float textures are
+    // unavailable the frame is drawn as captured.
+    bool undistort = false;
+
+    // HEATMAP: image is an edge map (8-bit, or the bitmapWidth 1-bpp form)
+    // the renderer adds into a heat texture of its own once per sequence, in
+    // one blended draw that also scales the heat already there by heatDecay;
+    // the heat times heatGain is drawn through a colormap. A new
+    // heatGeneration starts from a cleared texture.
+    bool heatmap = false;
+    float heatDecay = 0.9f;
+    float heatGain = 1.0f;
+    uint32_t heatGeneration = 0;
+
+    // FOCUS_PEAK: image (a Y plane with chroma, or RGBA) is drawn with the
+    // pixels whose 3x3 Sobel L1 magnitude of luma reaches peakThreshold
+    // (normalized 0..1 input, 8 at most) painted in peakColor (RGBA, alpha
+    // the opacity), in the same draw; no CPU pass sees the pixels
+    bool focusPeak = false;
+    float peakThreshold = 0.25f;
+    cv::Vec4f peakColor = cv::Vec4f(1.0f, 0.1f, 0.1f, 1.0f);
+
+    // Render mode this was chosen for (-1 = unknown), and a bit per mode the
+    // published frame behind it was built for. Right after a switch the mode
+    // is not among them yet, and the renderer shows the mode's resident
+    // snapshot instead (setModeResidencyGL).
+    int mode = -1;
+    uint32_t modesBuilt = 0;
+
+    bool isYuv() const { return !chroma.empty(); }
+};
+
+struct PipelineContext;
+
+// Latest frame of a pipeline (null = the default one) for its active render
+// mode. GL thread only, and one surface per pipeline: each pipeline's
+// published frames have a single reader.
+RenderFrame getLatestFrameForRender(PipelineContext* pipeline);
+// The same for the given render mode instead of the active one (resident
+// snapshots of inactive modes)
+RenderFrame getFrameForRender(PipelineContext* pipeline, int mode);
+
+#endif //EDGE_RENDER_FRAME_H
@@ -0,0 +1,196 @@
+#include "render_scheduler.h"
+#include "frame_pacing.h"
+#include "metrics.h"
+#include "thread_policy.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <ctime>
+
+#define LOG_TAG "RenderScheduler"
+#include "logging.h"
+
+namespace {
+
+const int64_t kDefaultPeriodNs = 16666667;
+const int64_t kMaxVsyncGapNs = 50000000;   // longer gaps are pauses, not the period
+const int64_t kMarginNs = 2000000;         // composition latching and wake-up jitter
+const int64_t kMinCostNs = 1000000;
+
+// EWMA with weight 1/8, in integer ns
+int64_t smooth(int64_t average, int64_t sample) {
+    return average + (sample - average) / 8;
+}
+
+void sleepUntil(int64_t deadlineNs) {
+    timespec deadline;
+    deadline.tv_sec = static_cast<time_t>(deadlineNs / 1000000000);
+    deadline.tv_nsec = static_cast<long>(deadlineNs % 1000000000);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR) {
+    }
+}
+
+} // namespace
+
+RenderScheduler::~RenderScheduler() {
+    stop();
+}
+
+bool RenderScheduler::start(Request renderRequest) {
+    if (!renderRequest || !choreographerApi().available()) {
+        LOGW("⚠️ AChoreographer unavailable; rendering on every publish");
+        return false;
+    }
+    if (running.exchange(true, std::memory_order_acq_rel)) {
+        return true;
+    }
+    request = renderRequest;
+    stopping.store(false, std::memory_order_release);
+    requestedSequence = publishedSequence.load(std::memory_order_acquire);
+    requestedRedraws = redraws.load(std::memory_order_acquire);
+    lastVsyncNs = 0;
+    requestedAtNs.store(0, std::memory_order_relaxed);
+    vsyncs.store(0, std::memory_order_relaxed);
+    requests.store(0, std::memory_order_relaxed);
+    skipped.store(0, std::memory_order_relaxed);
+    thread = std::thread(&RenderScheduler::loop, this);
+    LOGI("✅ Vsync-aligned rendering started");
+    return true;
+}
+
+void RenderScheduler::stop() {
+    if (!running.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
+    stopping.store(true, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (looper) {
+            ALooper_wake(looper);
+        }
+    }
+    if (thread.joinable()) {
+        thread.join();
+    }
+    LOGI("🔄 Vsync-aligned rendering stopped (%llu requests, %llu idle vsyncs)",
+         static_cast<unsigned long long>(requests.load()), static_cast<unsigned long long>(skipped.load()));
+}
+
+void RenderScheduler::onPublish(uint64_t sequence) {
+    publishedSequence.store(sequence, std::memory_order_release);
+}
+
+void RenderScheduler::onRedraw() {
+    redraws.fetch_add(1, std::memory_order_release);
+}
+
+void RenderScheduler::onRendered(int64_t nowNs) {
+    const int64_t requestedAt = requestedAtNs.exchange(0, std::memory_order_acq_rel);
+    if (requestedAt <= 0 || nowNs <= requestedAt) {
+        return;  // a draw the scheduler did not ask for (resize, expose)
+    }
+    const int64_t cost = nowNs - requestedAt;
+    const DrawCost previous = drawCost.load();
+    drawCost.store(DrawCost{smooth(previous.meanNs, cost),
+                            smooth(previous.deviationNs, std::abs(cost - previous.meanNs))});
+}
+
+RenderScheduler::Stats RenderScheduler::stats() const {
+    Stats result;
+    result.vsyncs = vsyncs.load(std::memory_order_relaxed);
+    result.requests = requests.load(std::memory_order_relaxed);
+    result.skipped = skipped.load(std::memory_order_relaxed);
+    const int64_t period = periodNs.load(std::memory_order_relaxed);
+    result.periodMs = (period > 0 ? period : kDefaultPeriodNs) / 1e6;
+    const DrawCost measured = drawCost.load();
+    const int64_t cost = measured.meanNs + 2 * measured.deviationNs;
+    result.renderCostMs = std::max(cost, kMinCostNs) / 1e6;
+    return result;
+}
+
+void RenderScheduler::loop() {
+    setThreadTier(ThreadTier::RENDER);
+    ALooper* threadLooper = ALooper_prepare(ALOOPER_PREPARE_ALLOW_NON_CALLBACKS);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        looper = threadLooper;
+    }
+    if (postVsyncCallback()) {
+        while (!stopping.load(std::memory_order_acquire)) {
+            ALooper_pollOnce(-1, nullptr, nullptr, nullptr);
+        }
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    looper = nullptr;
+}
+
+bool RenderScheduler::postVsyncCallback() {
+    const ChoreographerApi& api = choreographerApi();
+    AChoreographer* choreographer = api.getInstance();  // of this thread's looper
+    if (!choreographer) {
+        LOGW("⚠️ No AChoreographer for the render scheduler thread");
+        return false;
+    }
+    if (api.postFrameCallback64) {
+        api.postFrameCallback64(choreographer, &RenderScheduler::onVsync, this);
+    } else {
+        api.postFrameCallback(choreographer, &RenderScheduler::onVsync32, this);
+    }
+    return true;
+}
+
+void RenderScheduler::onVsync(int64_t frameTimeNanos, void* data) {
+    auto* self = static_cast<RenderScheduler*>(data);
+    if (self->stopping.load(std::memory_order_acquire)) {
+        return;
+    }
+    // Posted first so a late request never costs the next callback
+    self->postVsyncCallback();
+    self->handleVsync(frameTimeNanos);
+}
+
+void RenderScheduler::onVsync32(long frameTimeNanos, void* data) {
+    onVsync(static_cast<int64_t>(frameTimeNanos), data);
+}
+
+void RenderScheduler::handleVsync(int64_t frameTimeNanos) {
+    vsyncs.fetch_add(1, std::memory_order_relaxed);
+    const int64_t gap = frameTimeNanos - lastVsyncNs;
+    if (lastVsyncNs > 0 && gap > 0 && gap < kMaxVsyncGapNs) {
+        const int64_t period = periodNs.load(std::memory_order_relaxed);
+        periodNs.store(period > 0 ? smooth(period, gap) : gap, std::memory_order_relaxed);
+    }
+    lastVsyncNs = frameTimeNanos;
+
+    if (publishedSequence.load(std::memory_order_acquire) == requestedSequence &&
+        redraws.load(std::memory_order_acquire) == requestedRedraws) {
+        skipped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // As late before the next vsync as the draw allows, so it takes the
+    // newest frame published in the meantime
+    const int64_t smoothedPeriod = periodNs.load(std::memory_order_relaxed);
+    const int64_t period = smoothedPeriod > 0 ? smoothedPeriod : kDefaultPeriodNs;
+    const DrawCost measured = drawCost.load();
+    const int64_t cost = std::min(std::max(measured.meanNs + 2 * measured.deviationNs, kMinCostNs), period);
+    const int64_t wakeNs = frameTimeNanos + period - cost - kMarginNs;
+    if (wakeNs > monotonicNanos()) {
+        ScopedTrace trace("render_scheduler_wait");
+        sleepUntil(wakeNs);
+    }
+    if (stopping.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    requestedSequence = publishedSequence.load(std::memory_order_acquire);
+    requestedRedraws = redraws.load(std::memory_order_acquire);
+    requestedAtNs.store(monotonicNanos(), std::memory_order_release);
+    requests.fetch_add(1, std::memory_order_relaxed);
+    request();
+}
+
+RenderScheduler& renderScheduler() {
+    static RenderScheduler scheduler;
+    return scheduler;
+}
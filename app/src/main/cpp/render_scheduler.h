@@ -0,0 +1,81 @@
+#ifndef EDGE_RENDER_SCHEDULER_H
+#define EDGE_RENDER_SCHEDULER_H
+
+#include "seqlock.h"
+#include <android/looper.h>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+// Vsync-aligned render requests for a RENDERMODE_WHEN_DIRTY surface. Instead
+// of a request per publish, a looper thread following AChoreographer
+// callbacks requests one render per vsync that has a newer published frame
+// (or a redraw asked for), timed as late before the next vsync as the
+// measured request-to-drawn cost allows: the draw picks up the newest frame,
+// and vsyncs without one cost no redraw. Times are CLOCK_MONOTONIC, like the choreographer's.
+class RenderScheduler {
+public:
+    using Request = void (*)();   // e.g. runs the Java frame listener (requestRender)
+
+    struct Stats {
+        uint64_t vsyncs = 0;
+        uint64_t requests = 0;
+        uint64_t skipped = 0;       // vsyncs with no newer frame
+        double periodMs = 0.0;
+        double renderCostMs = 0.0;  // the estimate requests are timed with
+    };
+
+    ~RenderScheduler();
+
+    // False (and not running) without AChoreographer
+    bool start(Request request);
+    void stop();
+    bool isRunning() const { return running.load(std::memory_order_acquire); }
+
+    // A frame of the scheduled pipeline was published (any thread)
+    void onPublish(uint64_t sequence);
+    // The published frame is to be drawn again, e.g. moved by a new warp
+    void onRedraw();
+    // The surface finished drawing (GL thread, end of renderGL)
+    void onRendered(int64_t nowNs);
+
+    Stats stats() const;
+
+private:
+    static void onVsync(int64_t frameTimeNanos, void* data);
+    static void onVsync32(long frameTimeNanos, void* data);
+    void handleVsync(int64_t frameTimeNanos);
+    bool postVsyncCallback();
+    void loop();
+
+    std::mutex mutex;                       // guards looper
+    ALooper* looper = nullptr;
+    std::thread thread;
+    Request request = nullptr;
+    std::atomic<bool> running{false};
+    std::atomic<bool> stopping{false};
+
+    std::atomic<uint64_t> publishedSequence{0};
+    std::atomic<uint64_t> redraws{0};
+    uint64_t requestedSequence = 0;         // looper thread only
+    uint64_t requestedRedraws = 0;          // looper thread only
+    int64_t lastVsyncNs = 0;                // looper thread only
+    std::atomic<int64_t> periodNs{0};       // smoothed vsync period
+    std::atomic<int64_t> requestedAtNs{0};  // outstanding request (0 = none)
+    // Request-to-drawn cost, written by the GL thread and read by the looper
+    // thread as one pair
+    struct DrawCost {
+        int64_t meanNs;
+        int64_t deviationNs;
+    };
+    Seqlock<DrawCost> drawCost{DrawCost{4000000, 0}};  // until draws are measured
+
+    std::atomic<uint64_t> vsyncs{0};
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> skipped{0};
+};
+
+RenderScheduler& renderScheduler();
+
+#endif // EDGE_RENDER_SCHEDULER_H
@@ -0,0 +1,95 @@
+#include "scaled_outputs.h"
+#include "frame_pool.h"
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+
+#define LOG_TAG "ScaledOutputs"
+#include "logging.h"
+
+namespace {
+
+// Whether target averages from source in whole blocks
+bool dividesEvenly(const cv::Size& source, const cv::Size& target) {
+    return source.width % target.width == 0 && source.height % target.height == 0;
+}
+
+}  // namespace
+
+void ScaledOutputs::setSizes(const std::vector<cv::Size>& sizes) {
+    std::vector<cv::Size> accepted;
+    for (const cv::Size& size : sizes) {
+        if (size.width <= 0 || size.height <= 0) {
+            LOGW("⚠️ Ignoring scaled output size %dx%d", size.width, size.height);
+            continue;
+        }
+        if (std::find(accepted.begin(), accepted.end(), size) != accepted.end()) {
+            continue;
+        }
+        if (static_cast<int>(accepted.size()) == kMaxSizes) {
+            LOGW("⚠️ Only %d scaled output sizes, dropping %dx%d", kMaxSizes, size.width, size.height);
+            continue;
+        }
+        accepted.push_back(size);
+    }
+    std::vector<int> largestFirst(accepted.size());
+    for (size_t i = 0; i < accepted.size(); i++) {
+        largestFirst[i] = static_cast<int>(i);
+    }
+    std::stable_sort(largestFirst.begin(), largestFirst.end(),
+                     [&accepted](int a, int b) { return accepted[a].area() > accepted[b].area(); });
+
+    std::lock_guard<std::mutex> lock(mutex);
+    configured = accepted;
+    order = largestFirst;
+    count.store(static_cast<int>(configured.size()), std::memory_order_relaxed);
+    LOGI("🔄 %zu scaled luma output(s) configured", configured.size());
+}
+
+std::vector<cv::Size> ScaledOutputs::sizes() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return configured;
+}
+
+std::vector<ScaledLuma> ScaledOutputs::produce(const cv::Mat& luma, FramePool& pool) {
+    if (luma.empty() || luma.type() != CV_8UC1) {
+        return std::vector<ScaledLuma>();
+    }
+    std::vector<cv::Size> targets;
+    std::vector<int> sequence;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        targets = configured;
+        sequence = order;
+    }
+    std::vector<ScaledLuma> outputs(targets.size());
+    for (int index : sequence) {
+        const cv::Size size = targets[index];
+        if (size.width > luma.cols || size.height > luma.rows) {
+            continue;
+        }
+        // The smallest output made so far that this one divides, else the frame
+        const cv::Mat* source = &luma;
+        for (const ScaledLuma& made : outputs) {
+            if (!made.luma.empty() && made.size.area() < source->size().area() && dividesEvenly(made.size, size)) {
+                source = &made.luma;
+            }
+        }
+        ScaledLuma& output = outputs[index];
+        output.size = size;
+        if (size == source->size()) {
+            output.luma = pool.copyOf(*source);  // the frame's own size: detached from the caller's plane
+            continue;
+        }
+        output.luma = pool.acquire(size.height, size.width, CV_8UC1);
+        cv::resize(*source, output.luma, size, 0, 0, cv::INTER_AREA);
+    }
+    outputs.erase(std::remove_if(outputs.begin(), outputs.end(),
+                                 [](const ScaledLuma& output) { return output.luma.empty(); }),
+                  outputs.end());
+    return outputs;
+}
+
+ScaledOutputs& scaledOutputs() {
+    static ScaledOutputs outputs;
+    return outputs;
+}
@@ -0,0 +1,46 @@
+#ifndef EDGE_SCALED_OUTPUTS_H
+#define EDGE_SCALED_OUTPUTS_H
+
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include "frame_fanout.h"
+
+class FramePool;
+
+// Extra luma outputs of the default pipeline at fixed sizes (a 320x240 stream
+// for analytics next to the full-resolution display), made once per frame
+// from the ingested Y plane and carried to every consumer on the fan-out
+// handle, so no consumer downsamples on its own.
+//
+// Each size is an INTER_AREA downscale of the whole frame, stretched to the
+// size (pick sizes of the stream's aspect). Sizes are made largest first, and
+// a size an exact integer fraction of one already made is averaged from that
+// one instead of the full frame: equal blocks make the result the same, and
+// the pass reads a fraction of the pixels. Sizes larger than the frame are
+// skipped.
+class ScaledOutputs {
+public:
+    static const int kMaxSizes = 4;
+
+    // Replaces the configured sizes; an empty list turns the outputs off
+    void setSizes(const std::vector<cv::Size>& sizes);
+    std::vector<cv::Size> sizes();
+
+    // Whether any size is configured; one relaxed load
+    bool active() const { return count.load(std::memory_order_relaxed) > 0; }
+
+    // The configured sizes of luma in pooled buffers, in configuration order
+    std::vector<ScaledLuma> produce(const cv::Mat& luma, FramePool& pool);
+
+private:
+    std::mutex mutex;
+    std::vector<cv::Size> configured;
+    std::vector<int> order;  // indices into configured, largest area first
+    std::atomic<int> count{0};
+};
+
+ScaledOutputs& scaledOutputs();
+
+#endif // EDGE_SCALED_OUTPUTS_H
@@ -0,0 +1,160 @@
+#include "segment_detector.h"
+#include "metrics.h"
+#include "pyramid_cache.h"
+#include "thread_policy.h"
+#include <algorithm>
+
+#define LOG_TAG "SegmentDetector"
+#include "logging.h"
+
+namespace {
+
+const int kThumbnailDivisor = 8;  // static-scene test on 1/8 of the LSD input per axis
+
+float squaredLength(const cv::Vec4f& s) {
+    return (s[2] - s[0]) * (s[2] - s[0]) + (s[3] - s[1]) * (s[3] - s[1]);
+}
+
+}  // namespace
+
+SegmentDetector::~SegmentDetector() {
+    stopThread();
+}
+
+void SegmentDetector::setParams(const Params& params) {
+    std::lock_guard<std::mutex> lock(mutex);
+    current = params;
+    current.downscale = params.downscale >= 4 ? 4 : params.downscale >= 2 ? 2 : 1;
+    current.maxRate = std::max(params.maxRate, 0.1f);
+    lastRunNs = 0;
+}
+
+void SegmentDetector::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    segments.clear();
+    resultSize = cv::Size();
+    referenceThumbnail.release();
+    lastRunNs = 0;
+    generation++;
+}
+
+void SegmentDetector::submit(const cv::Mat& luma) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (busy || hasPending) {
+        return;
+    }
+    const int64_t now = monotonicNanos();
+    if (lastRunNs > 0 && now - lastRunNs < static_cast<int64_t>(1e9f / current.maxRate)) {
+        return;
+    }
+
+    // The frame's pyramid already holds the reduced luma, Gaussian-filtered
+    const int downscale = current.downscale;
+    PyramidCache& pyramids = pyramidCache();
+    cv::Mat level = pyramids.covers(luma) ? pyramids.level(downscale == 4 ? 2 : downscale == 2 ? 1 : 0) : cv::Mat();
+    if (level.empty()) {
+        if (downscale == 1) {
+            level = luma;
+        } else {
+            cv::resize(luma, reduced, cv::Size(std::max(1, luma.cols / downscale), std::max(1, luma.rows / downscale)),
+                       0, 0, cv::INTER_AREA);
+            level = reduced;
+        }
+    }
+
+    cv::resize(level, thumbnail, cv::Size(std::max(1, level.cols / kThumbnailDivisor),
+                                          std::max(1, level.rows / kThumbnailDivisor)),
+               0, 0, cv::INTER_AREA);
+    lastRunNs = now;
+    if (!referenceThumbnail.empty() && referenceThumbnail.size() == thumbnail.size() &&
+        cv::norm(thumbnail, referenceThumbnail, cv::NORM_L1) < current.staticDifference * thumbnail.total()) {
+        metrics().increment(Counter::SEGMENT_RUNS_REUSED);
+        return;  // nothing moved: the current segments still hold
+    }
+    thumbnail.copyTo(referenceThumbnail);
+    level.copyTo(pending);
+    hasPending = true;
+    if (!thread.joinable()) {
+        stopping = false;
+        thread = std::thread(&SegmentDetector::run, this);
+    }
+    wakeup.notify_one();
+}
+
+int SegmentDetector::latest(const cv::Size& lumaSize, cv::Mat& lines) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (segments.empty() || resultSize.empty()) {
+        return 0;
+    }
+    const float scaleX = static_cast<float>(lumaSize.width) / resultSize.width;
+    const float scaleY = static_cast<float>(lumaSize.height) / resultSize.height;
+    const int count = std::min({static_cast<int>(segments.size()), lines.rows / 2, kMaxSegments});
+    for (int i = 0; i < count; i++) {
+        const cv::Vec4f& s = segments[static_cast<size_t>(i)];
+        lines.at<cv::Vec2f>(2 * i) = cv::Vec2f(s[0] * scaleX, s[1] * scaleY);
+        lines.at<cv::Vec2f>(2 * i + 1) = cv::Vec2f(s[2] * scaleX, s[3] * scaleY);
+    }
+    return count;
+}
+
+void SegmentDetector::stopThread() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeup.notify_one();
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void SegmentDetector::run() {
+    setThreadTier(ThreadTier::ANALYTICS);
+    cv::Mat frame;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wakeup.wait(lock, [this] { return stopping || hasPending; });
+        if (stopping) {
+            return;
+        }
+        std::swap(frame, pending);
+        hasPending = false;
+        busy = true;
+        const uint64_t startedGeneration = generation;
+        lock.unlock();
+
+        bool detected = false;
+        yieldToForeground();
+        try {
+            ScopedStageTimer timer(Stage::SEGMENTS);
+            if (!lsd) {
+                // The input is already reduced and filtered, so no further scaling
+                lsd = cv::createLineSegmentDetector(cv::LSD_REFINE_STD, 1.0);
+            }
+            lsd->detect(frame, found);
+            if (found.size() > static_cast<size_t>(kMaxSegments)) {
+                // The longest ones carry the structure
+                std::nth_element(found.begin(), found.begin() + kMaxSegments, found.end(),
+                                 [](const cv::Vec4f& a, const cv::Vec4f& b) {
+                                     return squaredLength(a) > squaredLength(b);
+                                 });
+                found.resize(static_cast<size_t>(kMaxSegments));
+            }
+            detected = true;
+        } catch (const cv::Exception& e) {
+            LOGE_RATELIMITED("❌ Line segment detection failed: %s", e.what());
+        }
+
+        lock.lock();
+        busy = false;
+        if (detected && startedGeneration == generation) {
+            segments.swap(found);
+            resultSize = frame.size();
+        }
+    }
+}
+
+SegmentDetector& segmentDetector() {
+    static SegmentDetector detector;
+    return detector;
+}
@@ -0,0 +1,76 @@
+#ifndef EDGE_SEGMENT_DETECTOR_H
+#define EDGE_SEGMENT_DETECTOR_H
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Line segments of the luma with LSD (cv::createLineSegmentDetector), which
+// finds cleaner structure than Canny + Hough but costs several frames per
+// run. It works on a thread of its own: the processing thread offers every
+// frame, a reduced copy (a level of the frame's pyramid, pyramid_cache.h) is
+// handed over at most maxRate times a second while the thread is idle, and
+// every frame in between shows the newest result. While the scene is static
+// (a small thumbnail barely differs from the one the current segments were
+// found on) no run starts at all and the segments are reused as they are.
+class SegmentDetector {
+public:
+    struct Params {
+        float maxRate = 8.0f;          // LSD runs per second at most
+        int downscale = 2;             // 1, 2 or 4: LSD sees 1/downscale of the luma per axis
+        float staticDifference = 2.0f; // mean thumbnail difference (gray levels) below which nothing moved
+    };
+
+    static const int kMaxSegments = 1024;
+
+    ~SegmentDetector();
+
+    void setParams(const Params& params);
+
+    // Offers the processed luma (CV_8UC1); copied to the thread when it is
+    // idle, a run is due and the scene moved. Starts the thread on first use.
+    void submit(const cv::Mat& luma);
+
+    // Writes the newest segments as pairs of (x, y) pixel positions of a luma
+    // of lumaSize: rows 2i and 2i + 1 of lines (CV_32FC2, at least
+    // 2 * kMaxSegments rows). Returns the number of segments, 0 before the
+    // first run.
+    int latest(const cv::Size& lumaSize, cv::Mat& lines);
+
+    // Drops the segments and the reference thumbnail, e.g. when the mode is
+    // entered again
+    void reset();
+
+private:
+    void run();
+    void stopThread();
+
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    std::thread thread;
+    bool stopping = false;
+    bool hasPending = false;
+    bool busy = false;
+    Params current;
+    int64_t lastRunNs = 0;
+    cv::Mat pending;              // owned reduced luma for the thread
+    cv::Mat reduced;              // processing-thread scratch
+    cv::Mat thumbnail;
+    cv::Mat referenceThumbnail;   // of the frame the newest run was started on
+
+    cv::Ptr<cv::LineSegmentDetector> lsd;  // thread only
+    std::vector<cv::Vec4f> found;          // thread only
+
+    std::vector<cv::Vec4f> segments;  // newest result, in pixels of resultSize
+    cv::Size resultSize;
+    uint64_t generation = 0;          // bumped by reset(); a run started before it is discarded
+};
+
+// Detector used by the SEGMENTS render mode
+SegmentDetector& segmentDetector();
+
+#endif // EDGE_SEGMENT_DETECTOR_H
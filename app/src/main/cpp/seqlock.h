@@ -0,0 +1,82 @@
+#ifndef EDGE_SEQLOCK_H
+#define EDGE_SEQLOCK_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// A small block of values (stats, a config struct) with one writer and any
+// number of readers that never block it: the writer makes the sequence odd,
+// stores, makes it even again; a reader copies and retries when the sequence
+// was odd or moved meanwhile. Readers always get one consistent write, never
+// a mix of two, where separate atomics could be read half old, half new.
+// The value is kept in atomic words, so the racing copy is well defined
+// (and clean under ThreadSanitizer). Writers are serialized by the
+// caller.
+template <typename T>
+class Seqlock {
+    static_assert(std::is_trivially_copyable<T>::value, "Seqlock values are copied as raw words");
+
+public:
+    Seqlock() { store(T()); }
+    explicit Seqlock(const T& value) { store(value); }
+
+    void store(const T& value) {
+        uint64_t staged[kWords] = {};
+        std::memcpy(staged, &value, sizeof(T));
+        const uint32_t begin = sequence.load(std::memory_order_relaxed);
+        sequence.store(begin + 1, std::memory_order_relaxed);
+        // Release per word rather than a fence: a reader that sees any new
+        // word then sees the odd sequence too
+        for (size_t i = 0; i < kWords; i++) {
+            words[i].store(staged[i], std::memory_order_release);
+        }
+        sequence.store(begin + 2, std::memory_order_release);
+    }
+
+    T load() const {
+        uint64_t copied[kWords];
+        uint32_t begin;
+        do {
+            begin = sequence.load(std::memory_order_acquire);
+            for (size_t i = 0; i < kWords; i++) {
+                copied[i] = words[i].load(std::memory_order_acquire);
+            }
+        } while ((begin & 1) || sequence.load(std::memory_order_relaxed) != begin);
+        T value;
+        std::memcpy(&value, copied, sizeof(T));
+        return value;
+    }
+
+private:
+    static const size_t kWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    std::atomic<uint32_t> sequence{0};
+    std::atomic<uint64_t> words[kWords];
+};
+
+// Writer side of a seqlock whose sequence word lives elsewhere, e.g. in a
+// region shared with another process (shared_edge_output.h): the sequence is
+// odd from construction to destruction, and every store in between is
+// ordered inside that window.
+class SeqlockWriteScope {
+public:
+    explicit SeqlockWriteScope(std::atomic<uint32_t>& sequence)
+        : sequence(sequence), begin(sequence.load(std::memory_order_relaxed)) {
+        sequence.store(begin + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    ~SeqlockWriteScope() { sequence.store(begin + 2, std::memory_order_release); }
+
+    SeqlockWriteScope(const SeqlockWriteScope&) = delete;
+    SeqlockWriteScope& operator=(const SeqlockWriteScope&) = delete;
+
+private:
+    std::atomic<uint32_t>& sequence;
+    const uint32_t begin;
+};
+
+#endif // EDGE_SEQLOCK_H
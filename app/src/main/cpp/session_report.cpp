@@ -0,0 +1,248 @@
+#include "session_report.h"
+#include "backend_autotuner.h"
+#include "memory_accounting.h"
+#include "memory_budget.h"
+#include "quality_governor.h"
+#include "thread_policy.h"
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#ifdef __ANDROID__
+#include <sys/system_properties.h>
+#endif
+
+#define LOG_TAG "SessionReport"
+#include "logging.h"
+
+namespace {
+
+const int64_t kThermalPollMicros = 1000000;
+// Per kind of transition; a flapping governor must not grow the report
+const size_t kMaxTransitions = 256;
+
+// Protobuf wire format for the fields the schema uses: varints (wire type
+// 0) and length-delimited strings, messages and packed varints (2)
+class ProtoWriter {
+public:
+    void varint(uint32_t field, uint64_t value) {
+        key(field, 0);
+        raw(value);
+    }
+    void string(uint32_t field, const std::string& value) {
+        key(field, 2);
+        raw(value.size());
+        bytes += value;
+    }
+    void message(uint32_t field, const ProtoWriter& nested) { string(field, nested.bytes); }
+    void packed(uint32_t field, const std::vector<uint64_t>& values) {
+        ProtoWriter body;
+        for (uint64_t value : values) {
+            body.raw(value);
+        }
+        string(field, body.bytes);
+    }
+    const std::string& data() const { return bytes; }
+
+private:
+    void key(uint32_t field, int wireType) { raw(static_cast<uint64_t>(field) << 3 | wireType); }
+    void raw(uint64_t value) {
+        while (value >= 0x80) {
+            bytes.push_back(static_cast<char>(value | 0x80));
+            value >>= 7;
+        }
+        bytes.push_back(static_cast<char>(value));
+    }
+
+    std::string bytes;
+};
+
+std::string property(const char* name) {
+#ifdef __ANDROID__
+    char value[PROP_VALUE_MAX] = {};
+    return __system_property_get(name, value) > 0 ? std::string(value) : std::string();
+#else
+    (void) name;
+    return std::string();
+#endif
+}
+
+int64_t unixMillis() {
+    timeval now;
+    gettimeofday(&now, nullptr);
+    return static_cast<int64_t>(now.tv_sec) * 1000 + now.tv_usec / 1000;
+}
+
+void writeEntry(ProtoWriter& report, uint32_t field, const std::string& name, uint64_t value) {
+    ProtoWriter entry;
+    entry.string(1, name);
+    entry.varint(2, value);
+    report.message(field, entry);
+}
+
+} // namespace
+
+void SessionRecorder::start() {
+    std::lock_guard<std::mutex> lock(mutex);
+    MetricsRegistry& registry = metrics();
+    for (int i = 0; i < static_cast<int>(Counter::COUNT); i++) {
+        startCounters[i] = registry.counter(static_cast<Counter>(i));
+    }
+    for (int i = 0; i < static_cast<int>(Stage::COUNT); i++) {
+        for (int bucket = 0; bucket <= LatencyHistogram::kBucketCount; bucket++) {
+            startBuckets[i][bucket] = registry.histogram(static_cast<Stage>(i)).bucketCount(bucket);
+        }
+    }
+    startMicros = monotonicMicros();
+    startUnixMs = unixMillis();
+    thermal.clear();
+    governor.clear();
+    const int status = deviceThermalStatus();
+    const int level = qualityGovernor().levelIndex();
+    thermalStatus.store(status, std::memory_order_relaxed);
+    governorLevel.store(level, std::memory_order_relaxed);
+    noteLocked(thermal, status);
+    noteLocked(governor, level);
+    nextThermalPollMicros.store(startMicros + kThermalPollMicros, std::memory_order_relaxed);
+    if (running.exchange(true, std::memory_order_relaxed)) {
+        LOGW("⚠️ Session restarted; the previous one is not reported");
+    }
+    LOGI("🔄 Session report started");
+}
+
+void SessionRecorder::noteLocked(std::vector<Transition>& transitions, int value) {
+    if (transitions.size() < kMaxTransitions) {
+        const uint64_t atMs = static_cast<uint64_t>(std::max<int64_t>(0, monotonicMicros() - startMicros) / 1000);
+        transitions.push_back({atMs, static_cast<uint32_t>(std::max(0, value))});
+    }
+}
+
+void SessionRecorder::onFrame() {
+    if (!running.load(std::memory_order_relaxed)) {
+        return;
+    }
+    const int level = qualityGovernor().levelIndex();
+    if (level != governorLevel.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (running.load(std::memory_order_relaxed) && governorLevel.exchange(level) != level) {
+            noteLocked(governor, level);
+        }
+    }
+    // One caller per second pays for the status query
+    const int64_t now = monotonicMicros();
+    int64_t due = nextThermalPollMicros.load(std::memory_order_relaxed);
+    if (now < due || !nextThermalPollMicros.compare_exchange_strong(due, now + kThermalPollMicros)) {
+        return;
+    }
+    const int status = deviceThermalStatus();
+    if (status != thermalStatus.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (running.load(std::memory_order_relaxed) && thermalStatus.exchange(status) != status) {
+            noteLocked(thermal, status);
+        }
+    }
+}
+
+bool SessionRecorder::finish(const std::string& path, const Backends& backends) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!running.exchange(false, std::memory_order_relaxed)) {
+        LOGW("⚠️ No session to report");
+        return false;
+    }
+    ProtoWriter report;
+    report.varint(1, 1);
+    report.string(2, property("ro.product.model"));
+    report.string(3, property("ro.product.manufacturer"));
+    report.string(4, BackendAutotuner::socName());
+    report.varint(5, static_cast<uint64_t>(std::max(0, std::atoi(property("ro.build.version.sdk").c_str()))));
+    report.string(6, property("ro.build.fingerprint"));
+    const CpuTopology& topology = cpuTopology();
+    report.varint(7, topology.bigCores.size());
+    report.varint(8, topology.littleCores.size());
+    report.varint(9, static_cast<uint64_t>(startUnixMs));
+    report.varint(10, static_cast<uint64_t>((monotonicMicros() - startMicros) / 1000));
+    for (const auto& backend : backends) {
+        ProtoWriter entry;
+        entry.string(1, backend.first);
+        entry.string(2, backend.second);
+        report.message(11, entry);
+    }
+
+    MetricsRegistry& registry = metrics();
+    for (int i = 0; i < static_cast<int>(Counter::COUNT); i++) {
+        const uint64_t delta = registry.counter(static_cast<Counter>(i)) - startCounters[i];
+        if (delta > 0) {
+            writeEntry(report, 12, counterName(static_cast<Counter>(i)), delta);
+        }
+    }
+    std::vector<uint64_t> buckets(LatencyHistogram::kBucketCount + 1);
+    for (int i = 0; i < static_cast<int>(Stage::COUNT); i++) {
+        const LatencyHistogram& histogram = registry.histogram(static_cast<Stage>(i));
+        uint64_t count = 0;
+        for (int bucket = 0; bucket <= LatencyHistogram::kBucketCount; bucket++) {
+            // 32-bit buckets: a wrapped one still subtracts right
+            buckets[bucket] = static_cast<uint32_t>(histogram.bucketCount(bucket) - startBuckets[i][bucket]);
+            count += buckets[bucket];
+        }
+        if (count == 0) {
+            continue;
+        }
+        // Trailing empty buckets are left out; a reader pads with zeros
+        while (buckets.back() == 0) {
+            buckets.pop_back();
+        }
+        ProtoWriter stage;
+        stage.string(1, stageName(static_cast<Stage>(i)));
+        stage.varint(2, count);
+        stage.packed(3, buckets);
+        report.message(13, stage);
+        buckets.assign(LatencyHistogram::kBucketCount + 1, 0);
+    }
+    auto writeTransitions = [&report](uint32_t field, const std::vector<Transition>& transitions) {
+        for (const Transition& transition : transitions) {
+            ProtoWriter entry;
+            entry.varint(1, transition.atMs);
+            entry.varint(2, transition.value);
+            report.message(field, entry);
+        }
+    };
+    writeTransitions(14, thermal);
+    writeTransitions(15, governor);
+
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        writeEntry(report, 16, "max_rss", static_cast<uint64_t>(usage.ru_maxrss) * 1024);
+    }
+    writeEntry(report, 16, "budget", static_cast<uint64_t>(std::max<int64_t>(0, memoryBudget().peak())));
+    if (memoryAccountingEnabled()) {
+        const MemorySnapshot memory = memorySnapshot();
+        writeEntry(report, 16, "mats", static_cast<uint64_t>(std::max<int64_t>(0, memory.mats.peakBytes)));
+        writeEntry(report, 16, "gl", static_cast<uint64_t>(std::max<int64_t>(0, memory.gl.peakBytes)));
+    }
+    report.varint(17, static_cast<uint64_t>(std::lround(LatencyHistogram::bucketUpperMicros(0))));
+    report.varint(18, static_cast<uint64_t>(std::lround(
+            1000.0 * LatencyHistogram::bucketUpperMicros(1) / LatencyHistogram::bucketUpperMicros(0))));
+
+    const std::string temporary = path + ".tmp";
+    FILE* file = std::fopen(temporary.c_str(), "wb");
+    if (!file) {
+        LOGE("❌ Cannot create %s", temporary.c_str());
+        return false;
+    }
+    const std::string& data = report.data();
+    const bool written = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+    if (std::fclose(file) != 0 || !written || std::rename(temporary.c_str(), path.c_str()) != 0) {
+        LOGE("❌ Cannot write session report %s", path.c_str());
+        std::remove(temporary.c_str());
+        return false;
+    }
+    LOGI("✅ Session report: %zu bytes to %s", data.size(), path.c_str());
+    return true;
+}
+
+SessionRecorder& sessionRecorder() {
+    static SessionRecorder recorder;
+    return recorder;
+}
@@ -0,0 +1,92 @@
+#ifndef EDGE_SESSION_REPORT_H
+#define EDGE_SESSION_REPORT_H
+
+#include "metrics.h"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// One compact report per camera session, for analysis across a fleet of
+// devices rather than one logcat: the session's share of the metrics
+// registry (metrics.h), the thermal and quality governor transitions seen
+// while it ran, memory high-water marks, the device and the backends in use.
+// It is written once, at finish, in the protobuf wire format, so the fleet
+// side reads it with any protobuf library against the schema below (or
+// tools/session_report_dump.cpp, JSON) and fields added later never break
+// older readers. A report is a few KB.
+//
+//   message SessionReport {
+//     uint32 version = 1;                 // 1
+//     string model = 2;                   // ro.product.model
+//     string manufacturer = 3;            // ro.product.manufacturer
+//     string soc = 4;                     // ro.soc.model, else ro.board.platform or ro.hardware
+//     uint32 sdk = 5;                     // ro.build.version.sdk
+//     string build = 6;                   // ro.build.fingerprint
+//     uint32 big_cores = 7;
+//     uint32 little_cores = 8;
+//     int64 start_unix_ms = 9;
+//     uint64 duration_ms = 10;
+//     repeated Entry backends = 11;
+//     repeated Counter counters = 12;     // increments during the session, nonzero only
+//     repeated Stage stages = 13;         // stages with samples during the session
+//     repeated Transition thermal = 14;   // AThermal status; the first is the status at start
+//     repeated Transition governor = 15;  // quality governor level; likewise
+//     repeated Memory memory = 16;        // high-water marks of the process
+//     uint32 histogram_first_us = 17;     // upper bound of stage bucket 0
+//     uint32 histogram_growth_permille = 18;  // bound of bucket i: first * (growth / 1000)^i
+//   }
+//   message Entry { string name = 1; string value = 2; }
+//   message Counter { string name = 1; uint64 value = 2; }
+//   message Stage { string name = 1; uint64 count = 2; repeated uint64 buckets = 3 [packed = true]; }
+//   message Transition { uint64 at_ms = 1; uint32 value = 2; }  // ms into the session
+//   message Memory { string name = 1; int64 peak_bytes = 2; }
+//
+// Stage buckets are LatencyHistogram's, the last one the overflow, so
+// reports of many sessions merge by adding buckets.
+class SessionRecorder {
+public:
+    using Backends = std::vector<std::pair<std::string, std::string>>;
+
+    // Starts measuring from now; a session still running is restarted and
+    // its report dropped
+    void start();
+    bool active() const { return running.load(std::memory_order_relaxed); }
+
+    // Once per processed frame: notes governor level changes, and thermal
+    // status changes polled at most once a second. Lock-free unless one
+    // changed.
+    void onFrame();
+
+    // Writes the running session's report to path (a temporary file renamed
+    // into place) and ends the session; false when none is running or the
+    // file cannot be written
+    bool finish(const std::string& path, const Backends& backends);
+
+private:
+    struct Transition {
+        uint64_t atMs;
+        uint32_t value;
+    };
+
+    void noteLocked(std::vector<Transition>& transitions, int value);
+
+    std::atomic<bool> running{false};
+    std::atomic<int> governorLevel{-1};
+    std::atomic<int> thermalStatus{-1};
+    std::atomic<int64_t> nextThermalPollMicros{0};
+
+    std::mutex mutex;
+    int64_t startMicros = 0;
+    int64_t startUnixMs = 0;
+    uint64_t startCounters[static_cast<int>(Counter::COUNT)] = {};
+    uint64_t startBuckets[static_cast<int>(Stage::COUNT)][LatencyHistogram::kBucketCount + 1] = {};
+    std::vector<Transition> thermal;
+    std::vector<Transition> governor;
+};
+
+SessionRecorder& sessionRecorder();
+
+#endif // EDGE_SESSION_REPORT_H
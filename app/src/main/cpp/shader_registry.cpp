@@ -0,0 +1,318 @@
+#include "shader_registry.h"
+#include <GLES2/gl2ext.h>
+#include <GLES3/gl31.h>
+#include <EGL/egl.h>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#define LOG_TAG "ShaderRegistry"
+#include "logging.h"
+
+// Blob layout: magic, binary format, payload length, payload
+static const uint32_t kBinaryMagic = 0x53474445;  // "EDGS"
+
+std::mutex ShaderRegistry::directoryMutex;
+std::string ShaderRegistry::cacheDirectory;
+
+static uint64_t fnv1a(uint64_t hash, const char* text) {
+    for (; text && *text; ++text) {
+        hash ^= static_cast<unsigned char>(*text);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static GLuint compileShader(GLenum type, const char* src) {
+    GLuint s = glCreateShader(type);
+    glShaderSource(s, 1, &src, nullptr);
+    glCompileShader(s);
+    GLint ok = 0;
+    glGetShaderiv(s, GL_COMPILE_STATUS, &ok);
+    if (!ok) {
+        char buf[512];
+        glGetShaderInfoLog(s, 512, nullptr, buf);
+        LOGE("Shader compile error: %s", buf);
+        glDeleteShader(s);
+        return 0;
+    }
+    return s;
+}
+
+// The program if it linked; deleted (0) otherwise
+static GLuint checkLinked(GLuint id) {
+    GLint linked = 0;
+    glGetProgramiv(id, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        char buf[512];
+        glGetProgramInfoLog(id, 512, nullptr, buf);
+        LOGE("Program link error: %s", buf);
+        glDeleteProgram(id);
+        return 0;
+    }
+    return id;
+}
+
+// Compute-only program (ES 3.1 contexts); 0 on failure
+static GLuint buildComputeFromSource(const char* compute) {
+    GLuint cs = compileShader(GL_COMPUTE_SHADER, compute);
+    if (cs == 0) {
+        LOGE("Failed to compile compute shader");
+        return 0;
+    }
+    GLuint id = glCreateProgram();
+    glAttachShader(id, cs);
+    glLinkProgram(id);
+    glDeleteShader(cs);
+    return checkLinked(id);
+}
+
+// Compiles and links a program with the shared attribute bindings; 0 on failure
+static GLuint buildFromSource(const ShaderSource& source) {
+    if (source.compute) {
+        return buildComputeFromSource(source.compute);
+    }
+    GLuint vs = compileShader(GL_VERTEX_SHADER, source.vertex);
+    GLuint fs = compileShader(GL_FRAGMENT_SHADER, source.fragment);
+    if (vs == 0 || fs == 0) {
+        LOGE("Failed to compile shaders");
+        if (vs) glDeleteShader(vs);
+        if (fs) glDeleteShader(fs);
+        return 0;
+    }
+
+    GLuint id = glCreateProgram();
+    glAttachShader(id, vs);
+    glAttachShader(id, fs);
+    glBindAttribLocation(id, kPositionAttrib, "a_Position");
+    glBindAttribLocation(id, kTexCoordAttrib, "a_TexCoord");
+    glLinkProgram(id);
+    glDeleteShader(vs);
+    glDeleteShader(fs);
+    return checkLinked(id);
+}
+
+void ShaderRegistry::define(ShaderEffect effect, const ShaderSource& source) {
+    entries[static_cast<int>(effect)].source = source;
+}
+
+bool ShaderRegistry::defined(ShaderEffect effect) const {
+    const ShaderSource& source = entries[static_cast<int>(effect)].source;
+    return source.compute || (source.vertex && source.fragment);
+}
+
+void ShaderRegistry::setCacheDirectory(const std::string& directory) {
+    std::lock_guard<std::mutex> lock(directoryMutex);
+    cacheDirectory = directory;
+}
+
+void ShaderRegistry::onContextCreated() {
+    for (Entry& entry : entries) {
+        entry.id = 0;
+        entry.attempted = false;
+    }
+    for (auto& entry : named) {
+        entry.second.id = 0;
+        entry.second.attempted = false;
+    }
+    resolveBinaryApi();
+}
+
+void ShaderRegistry::release() {
+    for (Entry& entry : entries) {
+        if (entry.id) {
+            glDeleteProgram(entry.id);
+        }
+        entry.id = 0;
+        entry.attempted = false;
+    }
+    for (auto& entry : named) {
+        if (entry.second.id) {
+            glDeleteProgram(entry.second.id);
+        }
+    }
+    named.clear();
+}
+
+void ShaderRegistry::resolveBinaryApi() {
+    getProgramBinary = nullptr;
+    programBinary = nullptr;
+
+    const char* extensions = reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+    if (extensions && strstr(extensions, "GL_OES_get_program_binary")) {
+        getProgramBinary = reinterpret_cast<PFNGLGETPROGRAMBINARYOESPROC>(
+                eglGetProcAddress("glGetProgramBinaryOES"));
+        programBinary = reinterpret_cast<PFNGLPROGRAMBINARYOESPROC>(
+                eglGetProcAddress("glProgramBinaryOES"));
+    } else {
+        // ES 3.0 contexts have the same entry points in core
+        const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+        int major = 0;
+        if (version && sscanf(version, "OpenGL ES %d", &major) == 1 && major >= 3) {
+            getProgramBinary = reinterpret_cast<PFNGLGETPROGRAMBINARYOESPROC>(
+                    eglGetProcAddress("glGetProgramBinary"));
+            programBinary = reinterpret_cast<PFNGLPROGRAMBINARYOESPROC>(
+                    eglGetProcAddress("glProgramBinary"));
+        }
+    }
+
+    GLint formats = 0;
+    if (getProgramBinary && programBinary) {
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS_OES, &formats);
+    }
+    if (formats <= 0) {
+        getProgramBinary = nullptr;
+        programBinary = nullptr;
+    }
+
+    // Blobs are only valid for the driver build that produced them
+    driverSignature.clear();
+    const GLenum parts[] = {GL_VENDOR, GL_RENDERER, GL_VERSION};
+    for (GLenum part : parts) {
+        const char* value = reinterpret_cast<const char*>(glGetString(part));
+        driverSignature += value ? value : "";
+        driverSignature += '|';
+    }
+    LOGI("Program binary cache %s (%d formats)", programBinary ? "available" : "unsupported", formats);
+}
+
+std::string ShaderRegistry::cachePath(const std::string& label, const ShaderSource& source) const {
+    std::string directory;
+    {
+        std::lock_guard<std::mutex> lock(directoryMutex);
+        directory = cacheDirectory;
+    }
+    if (directory.empty() || !programBinary) {
+        return std::string();
+    }
+    uint64_t hash = 14695981039346656037ull;
+    hash = fnv1a(hash, source.vertex);
+    hash = fnv1a(hash, "\n--\n");
+    hash = fnv1a(hash, source.fragment);
+    hash = fnv1a(hash, "\n--\n");
+    hash = fnv1a(hash, source.compute);
+    hash = fnv1a(hash, driverSignature.c_str());
+    char name[48];
+    snprintf(name, sizeof(name), "_%016llx.bin", static_cast<unsigned long long>(hash));
+    return directory + "/shader_" + label + name;
+}
+
+GLuint ShaderRegistry::loadBinary(const std::string& label, const std::string& path) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) {
+        return 0;
+    }
+    uint32_t header[3] = {0, 0, 0};
+    std::vector<char> blob;
+    bool ok = fread(header, sizeof(header), 1, file) == 1 && header[0] == kBinaryMagic && header[2] > 0;
+    if (ok) {
+        blob.resize(header[2]);
+        ok = fread(blob.data(), 1, blob.size(), file) == blob.size();
+    }
+    fclose(file);
+
+    GLuint id = 0;
+    if (ok) {
+        id = glCreateProgram();
+        programBinary(id, static_cast<GLenum>(header[1]), blob.data(), static_cast<GLint>(blob.size()));
+        GLint linked = 0;
+        glGetProgramiv(id, GL_LINK_STATUS, &linked);
+        if (!linked) {
+            glDeleteProgram(id);
+            id = 0;
+        }
+    }
+    if (id == 0) {
+        // Stale or corrupt (e.g. after a driver update): rebuild from source
+        LOGW("Discarding program binary for effect %s", label.c_str());
+        remove(path.c_str());
+    }
+    return id;
+}
+
+void ShaderRegistry::storeBinary(GLuint id, const std::string& path) {
+    GLint length = 0;
+    glGetProgramiv(id, GL_PROGRAM_BINARY_LENGTH_OES, &length);
+    if (length <= 0) {
+        return;
+    }
+    std::vector<char> blob(static_cast<size_t>(length));
+    GLenum format = 0;
+    GLsizei written = 0;
+    getProgramBinary(id, length, &written, &format, blob.data());
+    if (written <= 0) {
+        return;
+    }
+
+    // Write a temporary file and rename it so a crash never leaves half a blob
+    std::string temporary = path + ".tmp";
+    FILE* file = fopen(temporary.c_str(), "wb");
+    if (!file) {
+        LOGW_RATELIMITED("Cannot write program binary to %s", temporary.c_str());
+        return;
+    }
+    uint32_t header[3] = {kBinaryMagic, static_cast<uint32_t>(format), static_cast<uint32_t>(written)};
+    bool ok = fwrite(header, sizeof(header), 1, file) == 1 &&
+              fwrite(blob.data(), 1, static_cast<size_t>(written), file) == static_cast<size_t>(written);
+    ok = fclose(file) == 0 && ok;
+    if (!ok || rename(temporary.c_str(), path.c_str()) != 0) {
+        remove(temporary.c_str());
+    }
+}
+
+GLuint ShaderRegistry::program(ShaderEffect effect) {
+    Entry& entry = entries[static_cast<int>(effect)];
+    if (entry.attempted) {
+        return entry.id;
+    }
+    entry.attempted = true;
+    if (!defined(effect)) {
+        LOGE("No shader source defined for effect %d", static_cast<int>(effect));
+        return 0;
+    }
+
+    entry.id = build(std::to_string(static_cast<int>(effect)), entry.source);
+    return entry.id;
+}
+
+GLuint ShaderRegistry::program(const std::string& name, const std::string& vertex, const std::string& fragment) {
+    NamedEntry& entry = named[name];
+    if (entry.attempted && entry.vertex == vertex && entry.fragment == fragment) {
+        return entry.id;
+    }
+    if (entry.id) {
+        glDeleteProgram(entry.id);  // redefined
+    }
+    entry.vertex = vertex;
+    entry.fragment = fragment;
+    entry.attempted = true;
+    ShaderSource source;
+    source.vertex = entry.vertex.c_str();
+    source.fragment = entry.fragment.c_str();
+    entry.id = build(name, source);
+    return entry.id;
+}
+
+// From the binary cache when it has the program, else from source (and into the cache)
+GLuint ShaderRegistry::build(const std::string& label, const ShaderSource& source) {
+    std::string path = cachePath(label, source);
+    if (!path.empty()) {
+        GLuint id = loadBinary(label, path);
+        if (id) {
+            LOGI("Effect %s loaded from program binary", label.c_str());
+            return id;
+        }
+    }
+
+    GLuint id = buildFromSource(source);
+    if (id && !path.empty()) {
+        storeBinary(id, path);
+    }
+    LOGI("Effect %s built from source: %s", label.c_str(), id ? "ok" : "failed");
+    return id;
+}
+
+ShaderRegistry& shaderRegistry() {
+    static thread_local ShaderRegistry registry;
+    return registry;
+}
@@ -0,0 +1,107 @@
+#ifndef EDGE_SHADER_REGISTRY_H
+#define EDGE_SHADER_REGISTRY_H
+
+#include <GLES2/gl2.h>
+#include <map>
+#include <mutex>
+#include <string>
+
+// Every GPU effect the renderer can draw with
+enum class ShaderEffect : int {
+    RGB = 0,          // RGBA / single-channel textures
+    YUV,              // Y + VU planes -> RGB
+    EXTERNAL_OES,     // SurfaceTexture camera preview
+    OVERLAY,          // tinted edge mask (DEFAULT / INSET)
+    EDGE_BLUR,        // GPU edge passes
+    EDGE_SOBEL,
+    EDGE_NMS,
+    EDGE_HYSTERESIS,
+    MARKERS,          // keypoint sprites / flow vectors
+    EDGE_BITS,        // 1-bpp packed edge bitmap expanded per fragment
+    RGB_OVERLAY,      // RGB / YUV with the tinted edge mask blended in the same draw (DEFAULT)
+    YUV_OVERLAY,
+    UNDISTORT,        // RGB sampled through the lens undistortion map (ES3 float texture)
+    RECTIFY,          // perspective-rectified luma through projective texture coordinates (DOCUMENT)
+    HEAT_ACCUMULATE,  // edge map weighted into the decaying heat texture (HEATMAP)
+    HEAT_COLORMAP,    // heat texture through the colormap
+    FOCUS_PEAK,       // YUV or RGB frame with strong luma gradients painted over (FOCUS_PEAK)
+    EDGE_GRADIENT_COMPUTE,    // ES 3.1 tiled edge kernels (compute-only programs)
+    EDGE_NMS_COMPUTE,
+    EDGE_HYSTERESIS_COMPUTE,
+    COUNT
+};
+
+// Attribute slots bound before linking, shared by every program
+static const GLuint kPositionAttrib = 0;
+static const GLuint kTexCoordAttrib = 1;
+
+struct ShaderSource {
+    const char* vertex = nullptr;
+    const char* fragment = nullptr;
+    const char* compute = nullptr;   // set instead of vertex + fragment (ES 3.1)
+};
+
+// Lazily built programs keyed by effect. Linked binaries are persisted to the
+// app cache (GL_OES_get_program_binary, or core glGetProgramBinary on ES3) and
+// reloaded on the next surface creation or launch; a binary the driver rejects
+// is deleted and the program is rebuilt from source. GL thread only, except
+// setCacheDirectory; each GL thread (surface) gets its own registry.
+class ShaderRegistry {
+public:
+    void define(ShaderEffect effect, const ShaderSource& source);
+    bool defined(ShaderEffect effect) const;
+
+    // Directory for binary blobs (e.g. Context.getCodeCacheDir()); empty disables
+    void setCacheDirectory(const std::string& directory);
+
+    // Program for the effect, building it on first use; 0 if it cannot be built
+    // (the failure is remembered until the next context)
+    GLuint program(ShaderEffect effect);
+
+    // Program defined at runtime (render effects, render_effects.h) under a
+    // name of [A-Za-z0-9_]: built and cached like an effect's, and rebuilt
+    // when the source given for the name changes; 0 if it cannot be built
+    GLuint program(const std::string& name, const std::string& vertex, const std::string& fragment);
+
+    // New GL context: handles from the previous one are gone, forget them
+    void onContextCreated();
+    // Deletes every program in the current context
+    void release();
+
+private:
+    struct Entry {
+        ShaderSource source;
+        GLuint id = 0;
+        bool attempted = false;
+    };
+
+    // Sources of a runtime program, owned by the registry
+    struct NamedEntry {
+        std::string vertex;
+        std::string fragment;
+        GLuint id = 0;
+        bool attempted = false;
+    };
+
+    GLuint build(const std::string& label, const ShaderSource& source);
+    GLuint loadBinary(const std::string& label, const std::string& path);
+    void storeBinary(GLuint id, const std::string& path);
+    std::string cachePath(const std::string& label, const ShaderSource& source) const;
+    void resolveBinaryApi();
+
+    Entry entries[static_cast<int>(ShaderEffect::COUNT)];
+    std::map<std::string, NamedEntry> named;
+
+    // Shared by the registries of every GL thread
+    static std::mutex directoryMutex;
+    static std::string cacheDirectory;
+
+    // Binary entry points for the current context (null when unsupported)
+    void (*getProgramBinary)(GLuint, GLsizei, GLsizei*, GLenum*, void*) = nullptr;
+    void (*programBinary)(GLuint, GLenum, const void*, GLint) = nullptr;
+    std::string driverSignature;
+};
+
+ShaderRegistry& shaderRegistry();
+
+#endif //EDGE_SHADER_REGISTRY_H
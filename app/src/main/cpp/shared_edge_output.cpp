@@ -0,0 +1,161 @@
+#include "shared_edge_output.h"
+#include "packed_edges.h"
+#include "seqlock.h"
+#include <cerrno>
+#include <cstring>
+#include <dlfcn.h>
+#include <new>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define LOG_TAG "SharedEdgeOutput"
+#include "logging.h"
+
+namespace {
+
+const uint32_t kSharedVersion = 1;
+const size_t kSlotAlignment = 64;  // slot headers on their own cache line
+
+// ASharedMemory is API 26; minSdk is 24
+struct SharedMemoryApi {
+    int (*create)(const char*, size_t) = nullptr;
+    int (*setProt)(int, int) = nullptr;
+};
+
+const SharedMemoryApi& sharedMemoryApi() {
+    static const SharedMemoryApi api = [] {
+        SharedMemoryApi loaded;
+        void* library = dlopen("libandroid.so", RTLD_NOW);
+        if (library) {
+            loaded.create = reinterpret_cast<decltype(loaded.create)>(dlsym(library, "ASharedMemory_create"));
+            loaded.setProt = reinterpret_cast<decltype(loaded.setProt)>(dlsym(library, "ASharedMemory_setProt"));
+        }
+        return loaded;
+    }();
+    return api;
+}
+
+} // namespace
+
+SharedEdgeOutput::~SharedEdgeOutput() {
+    stop();
+}
+
+int SharedEdgeOutput::start(int slots, int maxWidth, int maxHeight) {
+    std::lock_guard<std::mutex> lock(mutex);
+    active.store(false);
+    unmap();
+    if (slots < 2 || maxWidth <= 0 || maxHeight <= 0) {
+        return -1;
+    }
+    const SharedMemoryApi& api = sharedMemoryApi();
+    if (!api.create || !api.setProt) {
+        LOGE("❌ ASharedMemory unavailable (API < 26)");
+        return -1;
+    }
+
+    const size_t bitmapBytes = static_cast<size_t>(maxWidth) * maxHeight;
+    const size_t slot = (sizeof(SharedSlotHeader) + bitmapBytes + kSlotAlignment - 1) / kSlotAlignment *
+                        kSlotAlignment;
+    const size_t total = kSharedHeaderBytes + slot * static_cast<size_t>(slots);
+    int fd = api.create("edge-maps", total);
+    if (fd < 0) {
+        LOGE("❌ ASharedMemory_create(%zu) failed: %s", total, strerror(errno));
+        return -1;
+    }
+    void* mapped = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) {
+        LOGE("❌ mmap of the shared edge ring failed: %s", strerror(errno));
+        close(fd);
+        return -1;
+    }
+    // Later mappings, the consumer's included, are read-only; this one stays writable
+    api.setProt(fd, PROT_READ);
+    int consumerFd = dup(fd);
+    if (consumerFd < 0) {
+        LOGE("❌ dup of the shared edge ring fd failed: %s", strerror(errno));
+        munmap(mapped, total);
+        close(fd);
+        return -1;
+    }
+
+    mapping = static_cast<uint8_t*>(mapped);
+    mappingBytes = total;
+    regionFd = fd;
+    slotCount = static_cast<uint32_t>(slots);
+    slotBytes = static_cast<uint32_t>(slot);
+    nextSequence = 1;
+
+    // The region is zero-filled, so every slot's seq starts at 0 (even, empty)
+    auto* header = new (mapping) SharedRingHeader();
+    header->version = kSharedVersion;
+    header->slotCount = slotCount;
+    header->slotBytes = slotBytes;
+    header->maxWidth = static_cast<uint32_t>(maxWidth);
+    header->maxHeight = static_cast<uint32_t>(maxHeight);
+    header->latest.store(0, std::memory_order_relaxed);
+    for (uint32_t i = 0; i < slotCount; i++) {
+        new (mapping + kSharedHeaderBytes + static_cast<size_t>(i) * slotBytes) SharedSlotHeader();
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(header->magic, "EDGESHM", 8);  // last: a consumer checks it before anything else
+    active.store(true, std::memory_order_release);
+    LOGI("✅ Shared edge output: %d slots of %dx%d (%zu KB)", slots, maxWidth, maxHeight, total >> 10);
+    return consumerFd;
+}
+
+void SharedEdgeOutput::stop() {
+    std::lock_guard<std::mutex> lock(mutex);
+    active.store(false);
+    unmap();
+}
+
+void SharedEdgeOutput::unmap() {
+    if (mapping) {
+        munmap(mapping, mappingBytes);
+        mapping = nullptr;
+    }
+    mappingBytes = 0;
+    if (regionFd >= 0) {
+        close(regionFd);  // consumers keep the region alive through their own fds
+        regionFd = -1;
+    }
+}
+
+void SharedEdgeOutput::publish(const cv::Mat& edges, int bitmapWidth, int rotation, int64_t timestampNs) {
+    if (!active.load(std::memory_order_acquire) || edges.empty() || edges.type() != CV_8UC1) {
+        return;
+    }
+    const bool packed = bitmapWidth > 0;
+    const uint32_t width = static_cast<uint32_t>(packed ? bitmapWidth : edges.cols);
+    const size_t rowBytes = packed ? static_cast<size_t>(packedEdgeRowBytes(bitmapWidth)) : static_cast<size_t>(edges.cols);
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!mapping || sizeof(SharedSlotHeader) + rowBytes * edges.rows > slotBytes) {
+        LOGW_RATELIMITED("⚠️ %ux%d edge map exceeds the shared slot, not published", width, edges.rows);
+        return;
+    }
+    const uint64_t sequence = nextSequence++;
+    uint8_t* slotBase = mapping + kSharedHeaderBytes + (sequence - 1) % slotCount * slotBytes;
+    auto* slot = reinterpret_cast<SharedSlotHeader*>(slotBase);
+
+    {
+        SeqlockWriteScope write(slot->seq);  // readers see odd before any new byte
+        slot->format = packed ? kSharedFormatBits : kSharedFormatGray8;
+        slot->width = width;
+        slot->height = static_cast<uint32_t>(edges.rows);
+        slot->rowBytes = static_cast<uint32_t>(rowBytes);
+        slot->rotation = static_cast<uint32_t>(rotation);
+        slot->frameSequence = sequence;
+        slot->timestampNs = timestampNs;
+        uint8_t* pixels = slotBase + sizeof(SharedSlotHeader);
+        for (int y = 0; y < edges.rows; y++) {
+            std::memcpy(pixels + rowBytes * y, edges.ptr(y), rowBytes);
+        }
+    }
+    reinterpret_cast<SharedRingHeader*>(mapping)->latest.store(sequence, std::memory_order_release);
+}
+
+SharedEdgeOutput& sharedEdgeOutput() {
+    static SharedEdgeOutput output;
+    return output;
+}
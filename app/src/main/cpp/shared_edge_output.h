@@ -0,0 +1,90 @@
+#ifndef EDGE_SHARED_EDGE_OUTPUT_H
+#define EDGE_SHARED_EDGE_OUTPUT_H
+
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+// Region layout (little-endian, one ASharedMemory fd): a kSharedHeaderBytes
+// SharedRingHeader, then slotCount slots of slotBytes each, a SharedSlotHeader
+// followed by the bitmap. The consumer maps the fd read-only and reads a frame
+// in place, without copying and without any lock shared with the producer:
+//
+//   do {
+//       latest = header->latest.load(acquire);          // 0: nothing yet
+//       slot = slot (latest - 1) % slotCount;
+//       begin = slot->seq.load(acquire);                 // odd: being written
+//       ...read slot->frameSequence, the geometry and the pixels...
+//       atomic_thread_fence(acquire);
+//   } while ((begin & 1) || slot->seq.load(relaxed) != begin || frameSequence != latest);
+//
+// The producer never waits for the consumer: it writes the slot after the
+// newest round-robin, so a reader has slotCount - 1 frame intervals to finish
+// before its slot is reused (and the retry tells it when that happened).
+struct SharedRingHeader {
+    char magic[8];                 // "EDGESHM\0"
+    uint32_t version;              // 1
+    uint32_t slotCount;
+    uint32_t slotBytes;
+    uint32_t maxWidth;
+    uint32_t maxHeight;
+    uint32_t reserved;
+    std::atomic<uint64_t> latest;  // frameSequence of the newest complete slot
+};
+
+struct SharedSlotHeader {
+    std::atomic<uint32_t> seq;     // seqlock: odd while the slot is written
+    uint32_t format;               // kSharedFormatGray8 or kSharedFormatBits
+    uint32_t width;
+    uint32_t height;
+    uint32_t rowBytes;             // bitmap rows are this far apart
+    uint32_t rotation;             // clockwise degrees to upright
+    uint64_t frameSequence;        // 1-based, one per written frame
+    int64_t timestampNs;           // capture time on CLOCK_BOOTTIME
+};
+
+const uint32_t kSharedFormatGray8 = 0;  // one byte per pixel, 0 or 255
+const uint32_t kSharedFormatBits = 1;   // 1 bpp, least significant bit first (packed_edges.h)
+const size_t kSharedHeaderBytes = 4096;
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2,
+              "seqlock words are shared with other processes");
+
+// Publishes the edge maps of the default pipeline to other processes through
+// an ASharedMemory ring (API 26+). Writing a frame is one copy into the
+// region on the publishing thread.
+class SharedEdgeOutput {
+public:
+    ~SharedEdgeOutput();
+
+    // Creates the region for slotCount frames of up to maxWidth x maxHeight
+    // 8-bit maps (slotCount >= 2). Returns a new fd of it for the consumer
+    // (the caller owns it, e.g. ParcelFileDescriptor.adoptFd for Binder), or
+    // -1 when shared memory is unavailable. The region can only be mapped
+    // read-only from then on; the producer keeps its own writable mapping.
+    int start(int slotCount, int maxWidth, int maxHeight);
+    void stop();
+    bool isRunning() const { return active.load(std::memory_order_acquire); }
+
+    // edges: 8-bit map, or a 1-bpp bitmap when bitmapWidth > 0; maps larger
+    // than the slots are skipped
+    void publish(const cv::Mat& edges, int bitmapWidth, int rotation, int64_t timestampNs);
+
+private:
+    void unmap();
+
+    std::mutex mutex;                  // publish vs start/stop; uncontended per frame
+    std::atomic<bool> active{false};   // cheap check before taking the mutex
+    uint8_t* mapping = nullptr;
+    size_t mappingBytes = 0;
+    int regionFd = -1;
+    uint32_t slotCount = 0;
+    uint32_t slotBytes = 0;
+    uint64_t nextSequence = 1;
+};
+
+SharedEdgeOutput& sharedEdgeOutput();
+
+#endif // EDGE_SHARED_EDGE_OUTPUT_H
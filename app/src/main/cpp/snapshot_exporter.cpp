@@ -0,0 +1,117 @@
+#include "snapshot_exporter.h"
+#include "image_rotate.h"
+#include "packed_edges.h"
+#include "thread_policy.h"
+#include "yuv_convert.h"
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <vector>
+
+#define LOG_TAG "SnapshotExporter"
+#include "logging.h"
+
+namespace {
+
+const int kJpegQuality = 92;
+
+} // namespace
+
+SnapshotExporter::~SnapshotExporter() {
+    stop();
+}
+
+void SnapshotExporter::submit(SnapshotRequest&& request) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (hasPending) {
+            coalesced.fetch_add(1, std::memory_order_relaxed);
+            LOGD("Snapshot for %s replaced by %s", pending.path.c_str(), request.path.c_str());
+        }
+        pending = std::move(request);
+        hasPending = true;
+        if (!thread.joinable()) {
+            stopping = false;
+            thread = std::thread(&SnapshotExporter::run, this);
+        }
+    }
+    wakeup.notify_one();
+}
+
+void SnapshotExporter::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeup.notify_one();
+    if (thread.joinable()) {
+        thread.join();
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    pending = SnapshotRequest();
+    hasPending = false;
+}
+
+void SnapshotExporter::run() {
+    // Below the processing and GL threads: an encode only ever uses idle time
+    setThreadTier(ThreadTier::ANALYTICS);
+    while (true) {
+        SnapshotRequest request;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeup.wait(lock, [this] { return hasPending || stopping; });
+            if (stopping) {
+                return;  // a waiting request is abandoned, like one replaced
+            }
+            request = std::move(pending);
+            pending = SnapshotRequest();
+            hasPending = false;
+        }
+        yieldToForeground();
+        if (encode(request)) {
+            written.fetch_add(1, std::memory_order_relaxed);
+            LOGI("✅ Snapshot written: %s", request.path.c_str());
+        } else {
+            failed.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+bool SnapshotExporter::encode(const SnapshotRequest& request) {
+    try {
+        cv::Mat upright;
+        if (request.chroma.empty() ||
+            !convertNv21ToBgrRotated(request.image, request.chroma, request.rotation, upright)) {
+            cv::Mat image;
+            if (request.bitmapWidth > 0) {
+                unpackEdges(request.image, request.bitmapWidth, image);
+            } else if (!request.chroma.empty()) {
+                cv::cvtColorTwoPlane(request.image, request.chroma, image, cv::COLOR_YUV2BGR_NV21);
+            } else if (request.image.channels() == 4) {
+                // The luma path's raw layer is published in the renderer's RGBA
+                cv::cvtColor(request.image, image, cv::COLOR_RGBA2BGR);
+            } else {
+                image = request.image;
+            }
+            // Gray and edge snapshots turn as one channel, never widened to BGR
+            if (request.rotation == 0) {
+                upright = image;
+            } else {
+                rotateImage(image, request.rotation, upright);
+            }
+        }
+        const std::vector<int> params = {cv::IMWRITE_JPEG_QUALITY, kJpegQuality};
+        if (!cv::imwrite(request.path, upright, params)) {
+            LOGE("❌ Snapshot could not be encoded to %s", request.path.c_str());
+            return false;
+        }
+        return true;
+    } catch (const cv::Exception& e) {
+        LOGE("❌ Snapshot to %s failed: %s", request.path.c_str(), e.what());
+        return false;
+    }
+}
+
+SnapshotExporter& snapshotExporter() {
+    static SnapshotExporter exporter;
+    return exporter;
+}
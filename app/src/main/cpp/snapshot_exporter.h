@@ -0,0 +1,57 @@
+#ifndef EDGE_SNAPSHOT_EXPORTER_H
+#define EDGE_SNAPSHOT_EXPORTER_H
+
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// One frame to write out. The Mats reference published (immutable, pooled)
+// buffers, so taking a snapshot copies no pixels on the caller's thread.
+struct SnapshotRequest {
+    std::string path;       // format from the extension (.png, .jpg, ...)
+    cv::Mat image;          // BGR, RGBA, gray, an edge map, or the Y plane when chroma is set
+    cv::Mat chroma;         // interleaved VU (NV21) for a Y plane, else empty
+    int bitmapWidth = 0;    // image is a 1-bpp edge bitmap this wide (packed_edges.h)
+    int rotation = 0;       // clockwise degrees to upright, applied before encoding
+};
+
+// Snapshot encoding off the live path: a background thread at low priority
+// converts, rotates and cv::imwrite()s the frame, so neither processing nor
+// the renderer waits on an encode. Requests coalesce: one waiting while
+// another encodes is replaced by the next, so a burst of taps costs one
+// encode after the current one, of the newest frame.
+class SnapshotExporter {
+public:
+    ~SnapshotExporter();
+
+    // Starts the thread on first use
+    void submit(SnapshotRequest&& request);
+    void stop();
+
+    uint64_t writtenCount() const { return written.load(std::memory_order_relaxed); }
+    uint64_t coalescedCount() const { return coalesced.load(std::memory_order_relaxed); }
+    uint64_t failedCount() const { return failed.load(std::memory_order_relaxed); }
+
+private:
+    void run();
+    bool encode(const SnapshotRequest& request);
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    SnapshotRequest pending;
+    bool hasPending = false;
+    bool stopping = false;
+
+    std::atomic<uint64_t> written{0};
+    std::atomic<uint64_t> coalesced{0};
+    std::atomic<uint64_t> failed{0};
+};
+
+SnapshotExporter& snapshotExporter();
+
+#endif // EDGE_SNAPSHOT_EXPORTER_H
@@ -0,0 +1,66 @@
+#include "split_balancer.h"
+#include <algorithm>
+#include <cmath>
+
+#define LOG_TAG "SplitBalancer"
+#include "logging.h"
+
+namespace {
+
+// Weight of the newest sample; the GPU's arrive a few frames late anyway
+const double kSmoothing = 0.2;
+
+void smooth(double& average, double sample) {
+    average = average > 0.0 ? average + kSmoothing * (sample - average) : sample;
+}
+
+}  // namespace
+
+int SplitBalancer::cpuRows(int height) const {
+    return height * cpuSteps.load(std::memory_order_relaxed) / kSteps;
+}
+
+void SplitBalancer::reportCpu(int rows, int64_t ns) {
+    if (rows <= 0 || ns <= 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    smooth(cpuNsPerRow, static_cast<double>(ns) / rows);
+    rebalanceLocked();
+}
+
+void SplitBalancer::reportGpu(int rows, int64_t ns) {
+    if (rows <= 0 || ns <= 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    smooth(gpuNsPerRow, static_cast<double>(ns) / rows);
+    rebalanceLocked();
+}
+
+void SplitBalancer::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    cpuNsPerRow = 0.0;
+    gpuNsPerRow = 0.0;
+    cpuSteps.store(kSteps / 2, std::memory_order_relaxed);
+}
+
+void SplitBalancer::rebalanceLocked() {
+    if (cpuNsPerRow <= 0.0 || gpuNsPerRow <= 0.0) {
+        return;
+    }
+    // Both finish together when share * cpu = (1 - share) * gpu
+    const double share = gpuNsPerRow / (cpuNsPerRow + gpuNsPerRow);
+    const int target = std::min(std::max(static_cast<int>(std::lround(share * kSteps)), 1), kSteps - 1);
+    const int current = cpuSteps.load(std::memory_order_relaxed);
+    if (target != current) {
+        const int next = current + (target > current ? 1 : -1);
+        cpuSteps.store(next, std::memory_order_relaxed);
+        LOGD("Split %d/%d to the CPU (%.0f vs %.0f ns per row)", next, kSteps, cpuNsPerRow, gpuNsPerRow);
+    }
+}
+
+SplitBalancer& splitBalancer() {
+    static SplitBalancer instance;
+    return instance;
+}
@@ -0,0 +1,51 @@
+#ifndef EDGE_SPLIT_BALANCER_H
+#define EDGE_SPLIT_BALANCER_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+// Where the split edge backend (EDGE_BACKEND_SPLIT) divides each frame: the
+// top rows go through the CPU's tiled Canny on the processing thread, the
+// rest through the renderer's GPU edge passes, and the renderer draws both.
+//
+// Each side reports how long its part of a frame took and how many rows it
+// was: the CPU its wall time, the GPU the timer query around its upload and
+// passes (which lands a few frames late). Their smoothed costs per row give
+// the share at which both would finish together; every report moves the
+// split one step towards it. Steps are 1/kSteps of the height, so the GPU's
+// targets are only reallocated when the split actually moves, and each side
+// keeps at least one step so it keeps being measured. Without GPU timer
+// queries (GL_EXT_disjoint_timer_query) there are no GPU reports and the
+// split stays where it starts, half way.
+class SplitBalancer {
+public:
+    static const int kSteps = 32;
+
+    // Rows past the split each side's passes also run on: blur, Sobel, NMS
+    // and hysteresis each read one row further, and those rows' results,
+    // clamped at the partial frame's border, are thrown away
+    static const int kHaloRows = 4;
+
+    // Rows [0, cpuRows) of a frame height rows tall go to the CPU
+    int cpuRows(int height) const;
+    int step() const { return cpuSteps.load(std::memory_order_relaxed); }
+
+    void reportCpu(int rows, int64_t ns);
+    void reportGpu(int rows, int64_t ns);
+
+    // Forgets the costs and starts again from the middle (backend switched on)
+    void reset();
+
+private:
+    void rebalanceLocked();
+
+    std::mutex mutex;
+    double cpuNsPerRow = 0.0;  // EMAs
+    double gpuNsPerRow = 0.0;
+    std::atomic<int> cpuSteps{kSteps / 2};
+};
+
+SplitBalancer& splitBalancer();
+
+#endif // EDGE_SPLIT_BALANCER_H
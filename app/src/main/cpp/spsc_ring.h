@@ -0,0 +1,57 @@
+#ifndef EDGE_SPSC_RING_H
+#define EDGE_SPSC_RING_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+// Bounded single-producer / single-consumer ring. Jobs move through it with
+// one acquire/release pair per side and no lock; the head and tail sit a
+// cache line apart.
+template <typename T, size_t N>
+class SpscRing {
+public:
+    // Producer side; false (value untouched) when full
+    bool tryPush(T& value) {
+        const size_t tail = tailIndex.load(std::memory_order_relaxed);
+        if (tail - headIndex.load(std::memory_order_acquire) == N) {
+            return false;
+        }
+        slots[tail % N] = std::move(value);
+        tailIndex.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side; false when empty
+    bool tryPop(T& value) {
+        const size_t head = headIndex.load(std::memory_order_relaxed);
+        if (tailIndex.load(std::memory_order_acquire) == head) {
+            return false;
+        }
+        value = std::move(slots[head % N]);
+        slots[head % N] = T();  // drop the buffers the moved-from job may still reference
+        headIndex.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool full() const {
+        return tailIndex.load(std::memory_order_acquire) - headIndex.load(std::memory_order_acquire) == N;
+    }
+
+    bool empty() const {
+        return tailIndex.load(std::memory_order_acquire) == headIndex.load(std::memory_order_acquire);
+    }
+
+private:
+    // Padding rather than alignas: rings are heap-allocated, and C++14 new
+    // ignores extended alignment
+    std::array<T, N> slots;
+    char padHead[64];
+    std::atomic<size_t> headIndex{0};  // next slot to pop (consumer owned)
+    char padTail[64];
+    std::atomic<size_t> tailIndex{0};  // next slot to fill (producer owned)
+    char padEnd[64];
+};
+
+#endif // EDGE_SPSC_RING_H
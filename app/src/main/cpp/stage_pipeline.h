@@ -0,0 +1,142 @@
+#ifndef EDGE_STAGE_PIPELINE_H
+#define EDGE_STAGE_PIPELINE_H
+
+#include "spsc_ring.h"
+#include "thread_policy.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Fixed chain of stages, one thread each, linked by SPSC rings, so frame k + 1
+// runs stage i while frame k runs stage i + 1: throughput follows the slowest
+// stage instead of the sum of all of them. submit() and every stage but the
+// last push into a ring of kDepth jobs and wait while it is full, which pushes
+// back to whatever drop policy sits in front of the pipeline. A stage returns
+// false to drop its job. Rings are lock-free; a thread only takes its ring's
+// mutex to sleep when there is nothing to do and to be woken.
+template <typename Job>
+class StagePipeline {
+public:
+    using Stage = std::function<bool(Job&)>;
+    static const size_t kDepth = 2;
+
+    ~StagePipeline() { stop(); }
+
+    void start(std::vector<Stage> newStages) {
+        std::lock_guard<std::mutex> lock(controlMutex);
+        if (running.load(std::memory_order_acquire) || newStages.empty()) {
+            return;
+        }
+        stages = std::move(newStages);
+        links.clear();
+        for (size_t i = 0; i < stages.size(); i++) {
+            links.emplace_back(new Link());
+        }
+        stopping.store(false, std::memory_order_release);
+        for (size_t i = 0; i < stages.size(); i++) {
+            threads.emplace_back(&StagePipeline::run, this, i);
+        }
+        running.store(true, std::memory_order_release);
+    }
+
+    // Jobs still in flight are dropped
+    void stop() {
+        std::lock_guard<std::mutex> lock(controlMutex);
+        if (!running.load(std::memory_order_acquire)) {
+            return;
+        }
+        stopping.store(true, std::memory_order_release);
+        for (std::unique_ptr<Link>& link : links) {
+            wake(*link);
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        threads.clear();
+        links.clear();
+        running.store(false, std::memory_order_release);
+    }
+
+    bool isRunning() const { return running.load(std::memory_order_acquire); }
+
+    // Hands a job to the first stage, waiting while its ring is full. One
+    // producer thread only. False (job untouched) when the pipeline is not
+    // running or stops meanwhile.
+    bool submit(Job& job) {
+        if (!isRunning()) {
+            return false;
+        }
+        return push(*links[0], job);
+    }
+
+private:
+    struct Link {
+        SpscRing<Job, kDepth> ring;
+        std::mutex mutex;
+        std::condition_variable filled;   // consumer waits for a job
+        std::condition_variable drained;  // producer waits for a free slot
+    };
+
+    void wake(Link& link) {
+        { std::lock_guard<std::mutex> lock(link.mutex); }
+        link.filled.notify_all();
+        link.drained.notify_all();
+    }
+
+    bool push(Link& link, Job& job) {
+        while (!link.ring.tryPush(job)) {
+            std::unique_lock<std::mutex> lock(link.mutex);
+            if (stopping.load(std::memory_order_acquire)) {
+                return false;
+            }
+            link.drained.wait(lock, [&] {
+                return stopping.load(std::memory_order_acquire) || !link.ring.full();
+            });
+        }
+        { std::lock_guard<std::mutex> lock(link.mutex); }
+        link.filled.notify_one();
+        return true;
+    }
+
+    void run(size_t index) {
+        setThreadTier(ThreadTier::PROCESSING);
+        Link& input = *links[index];
+        Job job;
+        while (true) {
+            if (!input.ring.tryPop(job)) {
+                std::unique_lock<std::mutex> lock(input.mutex);
+                input.filled.wait(lock, [&] {
+                    return stopping.load(std::memory_order_acquire) || !input.ring.empty();
+                });
+                if (stopping.load(std::memory_order_acquire)) {
+                    return;
+                }
+                continue;
+            }
+            { std::lock_guard<std::mutex> lock(input.mutex); }
+            input.drained.notify_one();
+            if (stopping.load(std::memory_order_acquire)) {
+                return;
+            }
+            if (stages[index](job) && index + 1 < stages.size()) {
+                push(*links[index + 1], job);
+            }
+            job = Job();
+        }
+    }
+
+    std::mutex controlMutex;
+    std::vector<Stage> stages;
+    std::vector<std::unique_ptr<Link>> links;  // links[i] feeds stage i
+    std::vector<std::thread> threads;
+    std::atomic<bool> stopping{false};
+    std::atomic<bool> running{false};
+};
+
+#endif // EDGE_STAGE_PIPELINE_H
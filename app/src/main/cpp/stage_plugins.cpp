@@ -0,0 +1,206 @@
+#include "stage_plugins.h"
+#include "edge_stage_plugin.h"
+#include "filter_graph.h"
+#include <dirent.h>
+#include <dlfcn.h>
+#include <algorithm>
+#include <cstdlib>
+#include <mutex>
+
+#define LOG_TAG "StagePlugins"
+#include "logging.h"
+
+static_assert(EDGE_PIXEL_U8C1 == CV_8UC1 && EDGE_PIXEL_U8C3 == CV_8UC3 && EDGE_PIXEL_U8C4 == CV_8UC4,
+              "EDGE_PIXEL_* are OpenCV type codes");
+
+namespace {
+
+const size_t kScratchAlignment = 64;
+
+// Members up to process are required in every ABI version
+const size_t kRequiredApiSize = offsetof(EdgeStageApi, process) + sizeof(EdgeStageApi::process);
+
+bool pluginPixelType(int type) {
+    return type == EDGE_PIXEL_U8C1 || type == EDGE_PIXEL_U8C3 || type == EDGE_PIXEL_U8C4;
+}
+
+EdgeImage borrow(const cv::Mat& mat) {
+    EdgeImage image;
+    image.data = mat.data;
+    image.width = mat.cols;
+    image.height = mat.rows;
+    image.stride = static_cast<int32_t>(mat.step);
+    image.type = mat.type();
+    return image;
+}
+
+// A plugin stage instance behind the FilterStage interface: the graph plans
+// its buffers like a built-in stage's, and its scratch is allocated in
+// prepare(), once per geometry
+class PluginStage : public FilterStage {
+public:
+    PluginStage(const EdgeStageApi* api, void* instance) : api(api), instance(instance) {}
+
+    ~PluginStage() override {
+        api->destroy(instance);
+        std::free(scratch);
+    }
+
+    int outputType(int inputType) const override {
+        if (!pluginPixelType(inputType)) {
+            return -1;
+        }
+        const int type = api->outputType(instance, inputType);
+        return pluginPixelType(type) ? type : -1;
+    }
+
+    bool inPlace() const override { return (api->flags & EDGE_STAGE_IN_PLACE) != 0; }
+
+    void prepare(const cv::Size& size, int inputType) override {
+        const size_t bytes = api->scratchBytes ? api->scratchBytes(instance, size.width, size.height, inputType) : 0;
+        if (bytes == scratchSize) {
+            return;
+        }
+        std::free(scratch);
+        scratch = nullptr;
+        scratchSize = 0;
+        if (bytes > 0) {
+            const size_t rounded = (bytes + kScratchAlignment - 1) / kScratchAlignment * kScratchAlignment;
+            if (posix_memalign(&scratch, kScratchAlignment, rounded) != 0) {
+                scratch = nullptr;
+                CV_Error(cv::Error::StsNoMem, std::string("no scratch for stage ") + api->name);
+            }
+            scratchSize = bytes;
+        }
+        LOGI("Stage %s at %dx%d: %zu scratch bytes", api->name, size.width, size.height, bytes);
+    }
+
+    void run(const cv::Mat& input, cv::Mat& output) override {
+        const EdgeImage in = borrow(input);
+        EdgeImage out = borrow(output);
+        const int32_t status = api->process(instance, &in, &out, scratch, scratchSize);
+        if (status != 0) {
+            // The pipeline falls back as for any failed OpenCV call
+            CV_Error(cv::Error::StsError, std::string("stage ") + api->name + " failed with " + std::to_string(status));
+        }
+    }
+
+private:
+    const EdgeStageApi* api;
+    void* instance;
+    void* scratch = nullptr;
+    size_t scratchSize = 0;
+};
+
+std::mutex pluginMutex;
+std::vector<std::string> descriptions;
+
+bool validApi(const EdgeStageApi* api, const std::string& path) {
+    if (!api) {
+        LOGE("❌ %s: null stage table", path.c_str());
+        return false;
+    }
+    if (api->abiVersion != EDGE_STAGE_PLUGIN_ABI_VERSION) {
+        LOGE("❌ %s: stage built for ABI %u, host has %u", path.c_str(), api->abiVersion,
+             EDGE_STAGE_PLUGIN_ABI_VERSION);
+        return false;
+    }
+    if (api->structSize < kRequiredApiSize || !api->name || !*api->name || !api->create || !api->destroy ||
+        !api->outputType || !api->process) {
+        LOGE("❌ %s: incomplete stage table%s%s", path.c_str(), api->name ? " for " : "",
+             api->name ? api->name : "");
+        return false;
+    }
+    return true;
+}
+
+void registerPluginStage(const EdgeStageApi* api) {
+    registerFilterStage(api->name, [api](const std::vector<std::string>& args) -> std::unique_ptr<FilterStage> {
+        std::vector<const char*> argv;
+        argv.reserve(args.size());
+        for (const std::string& arg : args) {
+            argv.push_back(arg.c_str());
+        }
+        void* instance = api->create(argv.data(), static_cast<int32_t>(argv.size()));
+        if (!instance) {
+            return nullptr;
+        }
+        return std::unique_ptr<FilterStage>(new PluginStage(api, instance));
+    });
+}
+
+}  // namespace
+
+int loadStagePlugin(const std::string& path) {
+    // RTLD_LOCAL: each plugin's symbols stay its own
+    void* library = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!library) {
+        LOGE("❌ Cannot load stage plugin %s: %s", path.c_str(), dlerror());
+        return 0;
+    }
+    auto entry = reinterpret_cast<EdgeStagePluginEntry>(dlsym(library, EDGE_STAGE_PLUGIN_ENTRY));
+    if (!entry) {
+        LOGE("❌ %s exports no %s", path.c_str(), EDGE_STAGE_PLUGIN_ENTRY);
+        dlclose(library);
+        return 0;
+    }
+    int32_t count = 0;
+    const EdgeStageApi* const* stages = entry(EDGE_STAGE_PLUGIN_ABI_VERSION, &count);
+    if (!stages || count <= 0) {
+        LOGW("⚠️ %s describes no stages", path.c_str());
+        dlclose(library);
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(pluginMutex);
+    int registered = 0;
+    for (int32_t i = 0; i < count; i++) {
+        const EdgeStageApi* api = stages[i];
+        if (!validApi(api, path)) {
+            continue;
+        }
+        if (filterStageRegistered(api->name)) {
+            LOGE("❌ %s: stage name '%s' is taken", path.c_str(), api->name);
+            continue;
+        }
+        registerPluginStage(api);
+        descriptions.push_back(std::string(api->name) + ": " + (api->description ? api->description : ""));
+        LOGI("✅ Stage plugin '%s' from %s", api->name, path.c_str());
+        registered++;
+    }
+    if (registered == 0) {
+        dlclose(library);
+    }
+    // Otherwise the library stays loaded: factories and graphs call into it
+    return registered;
+}
+
+int loadStagePlugins(const std::string& directory, const std::string& prefix) {
+    DIR* dir = opendir(directory.c_str());
+    if (!dir) {
+        LOGW("⚠️ No stage plugin directory %s", directory.c_str());
+        return 0;
+    }
+    std::vector<std::string> paths;
+    while (dirent* entry = readdir(dir)) {
+        const std::string name = entry->d_name;
+        const std::string suffix = ".so";
+        if (name.compare(0, prefix.size(), prefix) == 0 && name.size() > prefix.size() + suffix.size() &&
+            name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0) {
+            paths.push_back(directory + "/" + name);
+        }
+    }
+    closedir(dir);
+    std::sort(paths.begin(), paths.end());  // a stable order for name clashes
+    int registered = 0;
+    for (const std::string& path : paths) {
+        registered += loadStagePlugin(path);
+    }
+    LOGI("🔄 %d plugin stage(s) from %zu librar%s in %s", registered, paths.size(), paths.size() == 1 ? "y" : "ies",
+         directory.c_str());
+    return registered;
+}
+
+std::vector<std::string> stagePluginDescriptions() {
+    std::lock_guard<std::mutex> lock(pluginMutex);
+    return descriptions;
+}
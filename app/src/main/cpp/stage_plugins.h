@@ -0,0 +1,20 @@
+#ifndef EDGE_STAGE_PLUGINS_H
+#define EDGE_STAGE_PLUGINS_H
+
+#include <string>
+#include <vector>
+
+// Loads one stage plugin (edge_stage_plugin.h) and registers its stages with
+// the filter graph; returns how many were registered. A plugin built for
+// another ABI version, a stage whose name is taken or whose table is
+// incomplete is refused with an error log. Plugins are never unloaded.
+int loadStagePlugin(const std::string& path);
+
+// Every lib*.so in directory whose name starts with prefix (the app's native
+// library dir, "libedgestage_"); returns the stages registered
+int loadStagePlugins(const std::string& directory, const std::string& prefix);
+
+// "name: description" of every plugin stage registered so far
+std::vector<std::string> stagePluginDescriptions();
+
+#endif // EDGE_STAGE_PLUGINS_H
@@ -0,0 +1,192 @@
+#include "stall_watchdog.h"
+#include "thread_policy.h"
+#include <algorithm>
+
+#define LOG_TAG "StallWatchdog"
+#include "logging.h"
+
+namespace {
+
+// Checks per stall interval
+const int kChecksPerStall = 4;
+// Failed recoveries double the healthy stretch up to this many times recoverMs
+const int kMaxRecoverFactor = 8;
+
+const char* levelName(int level) {
+    static const char* const kNames[] = {"normal", "cheap", "passthrough"};
+    return kNames[level];
+}
+
+} // namespace
+
+StallWatchdog::~StallWatchdog() {
+    stop();
+}
+
+void StallWatchdog::start(const Params& params, Hooks next) {
+    std::lock_guard<std::mutex> lock(mutex);
+    current = params;
+    stallMicros.store(static_cast<int64_t>(params.stallMs) * 1000, std::memory_order_relaxed);
+    if (isRunning()) {
+        return;
+    }
+    hooks = std::move(next);
+    stopping = false;
+    const int64_t now = monotonicMicros();
+    requiredHealthyMicros = static_cast<int64_t>(params.recoverMs) * 1000;
+    levelSinceMicros = now;
+    lastStepUpMicros = 0;
+    recreatePending = false;
+    currentLevel.store(NORMAL, std::memory_order_relaxed);
+    inFlightSince.store(0, std::memory_order_relaxed);
+    lastStartMicros.store(0, std::memory_order_relaxed);
+    lastPublishMicros.store(now, std::memory_order_relaxed);  // no stall before the first frame
+    failuresInRow.store(0, std::memory_order_relaxed);
+    running.store(true, std::memory_order_release);
+    thread = std::thread(&StallWatchdog::run, this);
+    LOGI("✅ Stall watchdog started: stall %d ms, %d failures, recovery %d ms", params.stallMs, params.failureLimit,
+         params.recoverMs);
+}
+
+void StallWatchdog::stop() {
+    if (!isRunning()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeup.notify_one();
+    thread.join();
+    running.store(false, std::memory_order_release);
+    currentLevel.store(NORMAL, std::memory_order_relaxed);
+    LOGI("✅ Stall watchdog stopped (stalls=%llu, recoveries=%llu)", static_cast<unsigned long long>(stallCount()),
+         static_cast<unsigned long long>(recoveryCount()));
+}
+
+void StallWatchdog::frameStarted() {
+    if (!isRunning()) {
+        return;
+    }
+    const int64_t now = monotonicMicros();
+    lastStartMicros.store(now, std::memory_order_relaxed);
+    // Pipelined frames overlap; the oldest one in flight is the one that matters
+    int64_t idle = 0;
+    inFlightSince.compare_exchange_strong(idle, now, std::memory_order_relaxed);
+    activeStage.store(static_cast<int>(Stage::FRAME_TOTAL), std::memory_order_relaxed);
+}
+
+void StallWatchdog::stageEntered(Stage stage) {
+    activeStage.store(static_cast<int>(stage), std::memory_order_relaxed);
+}
+
+void StallWatchdog::frameFailed() {
+    if (!isRunning()) {
+        return;
+    }
+    failuresInRow.fetch_add(1, std::memory_order_relaxed);
+    inFlightSince.store(0, std::memory_order_relaxed);
+}
+
+void StallWatchdog::frameDropped() {
+    inFlightSince.store(0, std::memory_order_relaxed);
+}
+
+void StallWatchdog::framePublished() {
+    if (!isRunning()) {
+        return;
+    }
+    lastPublishMicros.store(monotonicMicros(), std::memory_order_relaxed);
+    published.fetch_add(1, std::memory_order_relaxed);
+    failuresInRow.store(0, std::memory_order_relaxed);
+    inFlightSince.store(0, std::memory_order_relaxed);
+}
+
+bool StallWatchdog::hung() const {
+    const int64_t since = inFlightSince.load(std::memory_order_relaxed);
+    return since != 0 && monotonicMicros() - since > stallMicros.load(std::memory_order_relaxed);
+}
+
+void StallWatchdog::setLevel(int level) {
+    const int previous = currentLevel.exchange(level, std::memory_order_relaxed);
+    levelSinceMicros = monotonicMicros();
+    if (hooks.levelChanged) {
+        hooks.levelChanged(previous, level);
+    }
+}
+
+void StallWatchdog::check(int64_t now, const Params& params) {
+    const int64_t stall = stallMicros.load(std::memory_order_relaxed);
+    const int level = currentLevel.load(std::memory_order_relaxed);
+    // Only time spent at the current level counts, so one stall steps once
+    const int64_t since = inFlightSince.load(std::memory_order_relaxed);
+    const int64_t lastPublish = std::max(lastPublishMicros.load(std::memory_order_relaxed), levelSinceMicros);
+    const bool frameHung = since != 0 && now - std::max(since, levelSinceMicros) > stall;
+    const bool failing = failuresInRow.load(std::memory_order_relaxed) >= params.failureLimit;
+    const bool noProgress = now - lastStartMicros.load(std::memory_order_relaxed) < stall && now - lastPublish > stall;
+
+    if (frameHung || failing || noProgress) {
+        if (level == PASSTHROUGH) {
+            return;  // nothing cheaper left; ingest keeps the display moving
+        }
+        failuresInRow.store(0, std::memory_order_relaxed);
+        stalls.fetch_add(1, std::memory_order_relaxed);
+        metrics().increment(Counter::PIPELINE_STALLS);
+        const Stage stage = static_cast<Stage>(activeStage.load(std::memory_order_relaxed));
+        stallStage.store(static_cast<int>(stage), std::memory_order_relaxed);
+        if (lastStepUpMicros != 0 && now - lastStepUpMicros < requiredHealthyMicros) {
+            requiredHealthyMicros = std::min(requiredHealthyMicros * 2,
+                                             static_cast<int64_t>(params.recoverMs) * 1000 * kMaxRecoverFactor);
+        }
+        LOGW("⚠️ Pipeline stalled (%s) in %s, stepping down to %s",
+             frameHung ? "frame hung" : failing ? "frames failing" : "nothing published",
+             stage == Stage::COUNT ? "no stage" : stageName(stage), levelName(level + 1));
+        if (level == NORMAL) {
+            recreatePending = true;
+            publishedAtDegrade = published.load(std::memory_order_relaxed);
+        }
+        setLevel(level + 1);
+        return;
+    }
+
+    // A frame made it through at the degraded level, so none is still inside
+    // the resources of the backend that stalled
+    if (recreatePending && published.load(std::memory_order_relaxed) > publishedAtDegrade) {
+        recreatePending = false;
+        if (hooks.recreate) {
+            hooks.recreate();
+        }
+        LOGI("🔄 Backend resources recreated after the stall");
+    }
+
+    if (level != NORMAL && !recreatePending && now - lastPublish < stall &&
+        now - levelSinceMicros >= requiredHealthyMicros) {
+        recoveries.fetch_add(1, std::memory_order_relaxed);
+        metrics().increment(Counter::PIPELINE_RECOVERIES);
+        lastStepUpMicros = now;
+        LOGI("✅ Pipeline healthy for %lld ms, stepping up to %s",
+             static_cast<long long>(requiredHealthyMicros / 1000), levelName(level - 1));
+        setLevel(level - 1);
+    }
+}
+
+void StallWatchdog::run() {
+    setThreadTier(ThreadTier::ANALYTICS);
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping) {
+        const int64_t interval = std::max<int64_t>(stallMicros.load(std::memory_order_relaxed) / kChecksPerStall, 10000);
+        wakeup.wait_for(lock, std::chrono::microseconds(interval), [this] { return stopping; });
+        if (stopping) {
+            break;
+        }
+        const Params params = current;
+        lock.unlock();  // hooks may take the pipeline's locks
+        check(monotonicMicros(), params);
+        lock.lock();
+    }
+}
+
+StallWatchdog& stallWatchdog() {
+    static StallWatchdog watchdog;
+    return watchdog;
+}
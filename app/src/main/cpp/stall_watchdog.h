@@ -0,0 +1,104 @@
+#ifndef EDGE_STALL_WATCHDOG_H
+#define EDGE_STALL_WATCHDOG_H
+
+#include "metrics.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Keeps the preview moving when processing hangs or keeps failing. The
+// processing thread reports heartbeats (a frame started, the stage it is in,
+// the frame failed, the frame was published); a thread of its own checks
+// them a few times per stall interval. A stall is a frame in flight for
+// longer than stallMs, failureLimit failed frames in a row, or frames
+// starting for stallMs without one being published. Each stall steps one
+// level down:
+//   CHEAP        edges on the CPU with FAST_EDGES, away from the backend in use
+//   PASSTHROUGH  only the grayscale luma is processed and drawn, whatever the
+//                mode; while a frame is hung, ingest publishes it directly
+// and recoverMs of steady publishing steps one level back up (twice as long
+// after each step up that did not hold, like the quality governor). The
+// resources of the backend that was running are recreated on this thread
+// once a frame has been published at the degraded level, so the frame that
+// stalled is no longer in them.
+class StallWatchdog {
+public:
+    enum Level : int {
+        NORMAL = 0,
+        CHEAP = 1,
+        PASSTHROUGH = 2,
+    };
+
+    struct Params {
+        int stallMs = 750;
+        int failureLimit = 5;
+        int recoverMs = 3000;
+    };
+
+    struct Hooks {
+        std::function<void(int from, int to)> levelChanged;  // on the watchdog thread
+        std::function<void()> recreate;                      // backend resources, on the watchdog thread
+    };
+
+    ~StallWatchdog();
+
+    // Starts the thread at NORMAL; a running watchdog only takes the params
+    void start(const Params& params, Hooks hooks);
+    // Joins the thread and returns to NORMAL (levelChanged is not called)
+    void stop();
+    bool isRunning() const { return running.load(std::memory_order_acquire); }
+
+    // Heartbeats, lock-free; no-ops while stopped
+    void frameStarted();
+    void stageEntered(Stage stage);
+    void frameFailed();
+    void frameDropped();  // left on purpose (e.g. stale); neither success nor failure
+    void framePublished();
+
+    int level() const { return currentLevel.load(std::memory_order_relaxed); }
+    // A frame has been in flight for longer than stallMs
+    bool hung() const;
+
+    uint64_t stallCount() const { return stalls.load(std::memory_order_relaxed); }
+    uint64_t recoveryCount() const { return recoveries.load(std::memory_order_relaxed); }
+    // Stage the frame was in at the last stall, Stage::COUNT if none yet
+    Stage lastStallStage() const { return static_cast<Stage>(stallStage.load(std::memory_order_relaxed)); }
+
+private:
+    void run();
+    void check(int64_t now, const Params& params);
+    void setLevel(int level);
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    bool stopping = false;
+    Params current;
+    Hooks hooks;
+    int64_t requiredHealthyMicros = 0;  // recoverMs, doubled by failed recoveries
+    int64_t levelSinceMicros = 0;
+    int64_t lastStepUpMicros = 0;
+    bool recreatePending = false;
+    uint64_t publishedAtDegrade = 0;
+
+    std::atomic<bool> running{false};
+    std::atomic<int> currentLevel{NORMAL};
+    std::atomic<int64_t> stallMicros{750000};
+    std::atomic<int64_t> inFlightSince{0};   // monotonicMicros, 0 = no frame in flight
+    std::atomic<int64_t> lastStartMicros{0};
+    std::atomic<int64_t> lastPublishMicros{0};
+    std::atomic<uint64_t> published{0};
+    std::atomic<int> failuresInRow{0};
+    std::atomic<int> activeStage{static_cast<int>(Stage::COUNT)};
+    std::atomic<int> stallStage{static_cast<int>(Stage::COUNT)};
+    std::atomic<uint64_t> stalls{0};
+    std::atomic<uint64_t> recoveries{0};
+};
+
+// Watches the default pipeline
+StallWatchdog& stallWatchdog();
+
+#endif // EDGE_STALL_WATCHDOG_H
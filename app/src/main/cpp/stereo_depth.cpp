@@ -0,0 +1,217 @@
+#include "stereo_depth.h"
+#include "mapped_asset.h"
+#include <opencv2/imgproc.hpp>
+#include <cstdlib>
+
+#define LOG_TAG "StereoDepth"
+#include "logging.h"
+
+namespace {
+
+cv::Size reduce(const cv::Size& full, int downscale) {
+    return cv::Size(full.width / downscale, full.height / downscale);
+}
+
+// One camera's intrinsics from a stereo calibration file; false if missing
+bool readCamera(cv::FileStorage& file, const char* matrixKey, const char* distortionKey, const cv::Size& size,
+                LensCalibration& camera) {
+    cv::Mat cameraMatrix;
+    cv::Mat distortion;
+    file[matrixKey] >> cameraMatrix;
+    file[distortionKey] >> distortion;
+    if (cameraMatrix.total() != 9 || distortion.total() < 4 || distortion.total() > 8) {
+        return false;
+    }
+    cv::Mat intrinsics;
+    cameraMatrix.reshape(1, 3).convertTo(intrinsics, CV_64F);
+    camera.cameraMatrix = cv::Matx33d(intrinsics);
+    distortion.reshape(1, 1).convertTo(camera.distortion, CV_64F);
+    camera.size = size;
+    return true;
+}
+
+}  // namespace
+
+void StereoDepth::setParams(const Params& params) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (params.disparities != current.disparities || params.blockSize != current.blockSize) {
+        matcher.release();
+    }
+    current = params;
+}
+
+StereoDepth::Params StereoDepth::params() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return current;
+}
+
+void StereoDepth::setCalibration(const StereoCalibration& next) {
+    std::lock_guard<std::mutex> lock(mutex);
+    calibration = next;
+    hasCalibration = true;
+    mapSize = cv::Size();
+    LOGI("Stereo calibration set: %dx%d, baseline %.1f", next.left.size.width, next.left.size.height,
+         cv::norm(next.translation));
+}
+
+bool StereoDepth::loadCalibration(const std::string& path) {
+    StereoCalibration loaded;
+    try {
+        cv::FileStorage file;
+        if (!openMappedStorage(path, file)) {
+            LOGE("❌ Cannot open stereo calibration %s", path.c_str());
+            return false;
+        }
+        cv::Size size;
+        file["image_width"] >> size.width;
+        file["image_height"] >> size.height;
+        cv::Mat rotation;
+        cv::Mat translation;
+        file["R"] >> rotation;
+        file["T"] >> translation;
+        if (size.width <= 0 || size.height <= 0 || rotation.total() != 9 || translation.total() != 3 ||
+            !readCamera(file, "M1", "D1", size, loaded.left) || !readCamera(file, "M2", "D2", size, loaded.right)) {
+            LOGE("❌ Stereo calibration %s lacks M1, D1, M2, D2, R, T or the image size", path.c_str());
+            return false;
+        }
+        cv::Mat values;
+        rotation.reshape(1, 3).convertTo(values, CV_64F);
+        loaded.rotation = cv::Matx33d(values);
+        translation.reshape(1, 3).convertTo(values, CV_64F);
+        loaded.translation = cv::Vec3d(values.at<double>(0), values.at<double>(1), values.at<double>(2));
+    } catch (const cv::Exception& e) {
+        LOGE("❌ Reading stereo calibration %s failed: %s", path.c_str(), e.what());
+        return false;
+    }
+    setCalibration(loaded);
+    return true;
+}
+
+bool StereoDepth::calibrated() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return hasCalibration;
+}
+
+cv::Size StereoDepth::reducedSize(const cv::Size& full) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return reduce(full, current.downscale);
+}
+
+void StereoDepth::offerRight(const cv::Mat& luma, int64_t timestampNs) {
+    const cv::Size reduced = reducedSize(luma.size());
+    std::lock_guard<std::mutex> lock(rightMutex);
+    cv::resize(luma, rightReduced, reduced, 0, 0, cv::INTER_AREA);
+    rightTimestampNs = timestampNs;
+}
+
+bool StereoDepth::ensureMapsLocked(const cv::Size& reduced) {
+    if (!hasCalibration) {
+        return false;
+    }
+    if (mapSize == reduced) {
+        return true;
+    }
+    const cv::Matx33d leftK = scaledCameraMatrix(calibration.left, reduced);
+    const cv::Matx33d rightK = scaledCameraMatrix(calibration.right, reduced);
+    cv::Mat leftRotation;
+    cv::Mat rightRotation;
+    cv::Mat leftProjection;
+    cv::Mat rightProjection;
+    cv::Mat disparityToDepth;
+    // alpha 0: the rectified views only show pixels both cameras saw
+    cv::stereoRectify(leftK, calibration.left.distortion, rightK, calibration.right.distortion, reduced,
+                      calibration.rotation, calibration.translation, leftRotation, rightRotation, leftProjection,
+                      rightProjection, disparityToDepth, cv::CALIB_ZERO_DISPARITY, 0);
+    cv::initUndistortRectifyMap(leftK, calibration.left.distortion, leftRotation, leftProjection, reduced, CV_16SC2,
+                                leftXy, leftFraction);
+    cv::initUndistortRectifyMap(rightK, calibration.right.distortion, rightRotation, rightProjection, reduced,
+                                CV_16SC2, rightXy, rightFraction);
+    mapSize = reduced;
+    LOGI("Stereo rectification maps built for %dx%d", reduced.width, reduced.height);
+    return true;
+}
+
+bool StereoDepth::compute(const cv::Mat& luma, int64_t timestampNs, cv::Mat& rgba) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const cv::Size reduced = reduce(luma.size(), current.downscale);
+    CV_Assert(rgba.size() == reduced && rgba.type() == CV_8UC4);
+    {
+        std::lock_guard<std::mutex> rightLock(rightMutex);
+        if (rightReduced.size() != reduced || std::llabs(rightTimestampNs - timestampNs) > current.maxSkewNs) {
+            return false;
+        }
+        rightReduced.copyTo(rightView);
+    }
+    cv::resize(luma, leftReduced, reduced, 0, 0, cv::INTER_AREA);
+    const cv::Mat* left = &leftReduced;
+    const cv::Mat* right = &rightView;
+    if (ensureMapsLocked(reduced)) {
+        cv::remap(leftReduced, leftRectified, leftXy, leftFraction, cv::INTER_LINEAR, cv::BORDER_CONSTANT);
+        cv::remap(rightView, rightRectified, rightXy, rightFraction, cv::INTER_LINEAR, cv::BORDER_CONSTANT);
+        left = &leftRectified;
+        right = &rightRectified;
+    }
+
+    if (!matcher) {
+        matcher = cv::StereoBM::create(current.disparities, current.blockSize);
+        matcher->setUniquenessRatio(10);  // drop ambiguous matches rather than show noise
+    }
+    matcher->compute(*left, *right, disparity);  // CV_16S, 4 fractional bits; no match = -16
+
+    if (colormap.empty()) {
+        cv::Mat ramp(1, 256, CV_8UC1);
+        for (int i = 0; i < 256; i++) {
+            ramp.at<uchar>(i) = static_cast<uchar>(i);
+        }
+        cv::Mat bgr;
+        cv::applyColorMap(ramp, bgr, cv::COLORMAP_JET);
+        cv::cvtColor(bgr, colormap, cv::COLOR_BGR2RGBA);
+        colormap.at<cv::Vec4b>(0) = cv::Vec4b(0, 0, 0, 255);
+    }
+    // Negative (no match) saturates to 0, which the colormap shows black
+    disparity.convertTo(scaled, CV_8U, 255.0 / (current.disparities * 16));
+    const uint32_t* table = colormap.ptr<uint32_t>();
+    for (int y = 0; y < reduced.height; y++) {
+        const uchar* in = scaled.ptr<uchar>(y);
+        uint32_t* out = rgba.ptr<uint32_t>(y);
+        for (int x = 0; x < reduced.width; x++) {
+            out[x] = table[in[x]];
+        }
+    }
+    return true;
+}
+
+void StereoDepth::reset() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        hasCalibration = false;
+        mapSize = cv::Size();
+        leftXy.release();
+        leftFraction.release();
+        rightXy.release();
+        rightFraction.release();
+    }
+    std::lock_guard<std::mutex> lock(rightMutex);
+    rightReduced.release();
+    rightTimestampNs = 0;
+}
+
+void StereoDepth::releaseMaps() {
+    std::lock_guard<std::mutex> lock(mutex);
+    mapSize = cv::Size();
+    leftXy.release();
+    leftFraction.release();
+    rightXy.release();
+    rightFraction.release();
+    leftReduced.release();
+    leftRectified.release();
+    rightView.release();
+    rightRectified.release();
+    disparity.release();
+    scaled.release();
+}
+
+StereoDepth& stereoDepth() {
+    static StereoDepth depth;
+    return depth;
+}
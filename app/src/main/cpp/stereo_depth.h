@@ -0,0 +1,89 @@
+#ifndef EDGE_STEREO_DEPTH_H
+#define EDGE_STEREO_DEPTH_H
+
+#include "lens_undistortion.h"
+#include <opencv2/calib3d.hpp>
+#include <opencv2/core.hpp>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+// Two cameras of a stereo pair: each one's intrinsics and distortion, and the
+// right camera's pose relative to the left (OpenCV's stereoCalibrate R, T)
+struct StereoCalibration {
+    LensCalibration left;
+    LensCalibration right;   // same size as left
+    cv::Matx33d rotation = cv::Matx33d::eye();
+    cv::Vec3d translation;
+};
+
+// Disparity of a stereo pair with cv::StereoBM at reduced resolution,
+// colormapped for display (DEPTH render mode). The left view is the frame
+// the DEPTH pipeline is processing, the right view the newest frame offered
+// from the pipeline of the second camera. Block matching only keeps up on a
+// phone because of two things built in here: both views are area-reduced by
+// Params::downscale per axis first (2 = a quarter of the pixels), and they
+// are rectified through fixed-point cv::remap maps built once per
+// calibration and reduced size (stereoRectify, initUndistortRectifyMap),
+// never per frame. Without a calibration the views are taken as already
+// rectified. StereoBM matches parallel row stripes on OpenCV's pool.
+class StereoDepth {
+public:
+    struct Params {
+        int downscale = 2;       // per axis, 1..8
+        int disparities = 64;    // search range in reduced pixels, a multiple of 16
+        int blockSize = 15;      // odd, 5..51
+        int64_t maxSkewNs = 20000000;  // right view at most this far from the left in time
+    };
+
+    void setParams(const Params& params);
+    Params params();
+
+    // Replaces the calibration (maps are rebuilt for the next frame); reset()
+    // goes back to views taken as rectified
+    void setCalibration(const StereoCalibration& calibration);
+    // Reads M1, D1, M2, D2, R, T, image_width and image_height from an OpenCV
+    // file or APK asset (the stereo_calib sample's names); false, keeping the
+    // current calibration, if any is missing
+    bool loadCalibration(const std::string& path);
+    bool calibrated();
+
+    // The right view's newest frame (CV_8UC1), reduced and kept until the next
+    void offerRight(const cv::Mat& luma, int64_t timestampNs);
+
+    // Disparity of luma (the left view) against the newest right view, as
+    // RGBA through a jet colormap (black = no match) into rgba, allocated at
+    // reducedSize(luma.size()) by the caller. False when there is no right
+    // view of the same size within maxSkewNs of timestampNs.
+    bool compute(const cv::Mat& luma, int64_t timestampNs, cv::Mat& rgba);
+
+    cv::Size reducedSize(const cv::Size& full);
+
+    // Drops the right view, the maps and the calibration
+    void reset();
+    // Drops the maps and scratch (memory trimming); rebuilt when next needed
+    void releaseMaps();
+
+private:
+    bool ensureMapsLocked(const cv::Size& reduced);
+
+    std::mutex mutex;  // everything but the right view
+    Params current;
+    StereoCalibration calibration;
+    bool hasCalibration = false;
+    cv::Size mapSize;  // empty = maps not built for the current calibration
+    cv::Mat leftXy, leftFraction, rightXy, rightFraction;
+    cv::Ptr<cv::StereoBM> matcher;
+    cv::Mat colormap;  // 256 RGBA entries (CV_8UC4), entry 0 black
+    // Scratch reused across frames
+    cv::Mat leftReduced, leftRectified, rightView, rightRectified, disparity, scaled;
+
+    std::mutex rightMutex;
+    cv::Mat rightReduced;
+    int64_t rightTimestampNs = 0;
+};
+
+// Depth shared by the DEPTH pipeline (left) and the right camera's pipeline
+StereoDepth& stereoDepth();
+
+#endif // EDGE_STEREO_DEPTH_H
@@ -0,0 +1,211 @@
+#include "synthetic_source.h"
+#include "frame_pool.h"
+#include "metrics.h"
+#include "thread_policy.h"
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+#define LOG_TAG "SyntheticSource"
+#include "logging.h"
+
+namespace {
+
+const int kMinSide = 64;
+const double kNoiseSigma = 4.0;
+
+int64_t steadyNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+SyntheticFrameSource::~SyntheticFrameSource() {
+    stop();
+}
+
+bool SyntheticFrameSource::start(const SyntheticConfig& requested, Sink frameSink) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (requested.width < kMinSide || requested.height < kMinSide || (requested.width | requested.height) & 1 ||
+        !frameSink) {
+        LOGE("❌ Synthetic source needs an even size of at least %dx%d, got %dx%d", kMinSide, kMinSide,
+             requested.width, requested.height);
+        return false;
+    }
+    if (thread.joinable()) {
+        stopping.store(true, std::memory_order_release);
+        thread.join();
+    }
+    config = requested;
+    sink = std::move(frameSink);
+    buildAssets(config, assets);
+    frames.store(0, std::memory_order_relaxed);
+    late.store(0, std::memory_order_relaxed);
+    startNs.store(steadyNanos(), std::memory_order_relaxed);
+    endNs.store(0, std::memory_order_relaxed);
+    stopping.store(false, std::memory_order_release);
+    running.store(true, std::memory_order_release);
+    thread = std::thread(&SyntheticFrameSource::run, this);
+    LOGI("✅ Synthetic source: %dx%d at %.1f fps (0 = max), patterns 0x%x", config.width, config.height,
+         std::max(0.0, config.framesPerSecond), config.patterns);
+    return true;
+}
+
+SyntheticReport SyntheticFrameSource::stop() {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping.store(true, std::memory_order_release);
+    if (thread.joinable()) {
+        thread.join();
+        const SyntheticReport result = report();
+        LOGI("✅ Synthetic source stopped: %llu frames in %.2fs (%.1f fps, %llu late)",
+             static_cast<unsigned long long>(result.frames), result.seconds, result.framesPerSecond,
+             static_cast<unsigned long long>(result.lateFrames));
+        // Release the assets and the last frame's sink captures
+        sink = Sink();
+        assets = Assets();
+    }
+    return report();
+}
+
+SyntheticReport SyntheticFrameSource::report() const {
+    SyntheticReport result;
+    result.frames = frames.load(std::memory_order_relaxed);
+    result.lateFrames = late.load(std::memory_order_relaxed);
+    const int64_t begin = startNs.load(std::memory_order_relaxed);
+    const int64_t end = endNs.load(std::memory_order_relaxed);
+    if (begin > 0) {
+        result.seconds = ((end > 0 ? end : steadyNanos()) - begin) / 1e9;
+    }
+    result.framesPerSecond = result.seconds > 0.0 ? result.frames / result.seconds : 0.0;
+    return result;
+}
+
+void SyntheticFrameSource::run() {
+    setThreadTier(ThreadTier::INGEST);
+    const int64_t intervalNs =
+            config.framesPerSecond > 0 ? static_cast<int64_t>(1e9 / config.framesPerSecond) : 0;
+    auto due = std::chrono::steady_clock::now();
+    uint64_t index = 0;
+    while (!stopping.load(std::memory_order_acquire)) {
+        if (intervalNs > 0) {
+            std::this_thread::sleep_until(due);
+            const auto now = std::chrono::steady_clock::now();
+            if (now - due > std::chrono::nanoseconds(intervalNs)) {
+                // Behind by more than a frame: count it and resume from now
+                // instead of bursting to catch up, as a sensor would
+                late.fetch_add(1, std::memory_order_relaxed);
+                due = now;
+            }
+            due += std::chrono::nanoseconds(intervalNs);
+        }
+        cv::Mat nv21 = framePool().acquire(config.height + config.height / 2, config.width, CV_8UC1);
+        render(config, assets, index++, nv21);
+        sink(nv21, config.width, config.height, bootTimeNanos());
+        frames.fetch_add(1, std::memory_order_relaxed);
+    }
+    endNs.store(steadyNanos(), std::memory_order_relaxed);
+    running.store(false, std::memory_order_release);
+}
+
+void SyntheticFrameSource::renderFrame(const SyntheticConfig& config, uint64_t index, cv::Mat& nv21) {
+    Assets assets;
+    buildAssets(config, assets);
+    nv21.create(config.height + config.height / 2, config.width, CV_8UC1);
+    render(config, assets, index, nv21);
+}
+
+void SyntheticFrameSource::buildAssets(const SyntheticConfig& config, Assets& assets) {
+    const int width = config.width;
+    const int height = config.height;
+    cv::RNG rng(config.seed);
+
+    // Smooth texture with hard-edged blocks: gradients for Canny, corners for
+    // the feature detector, large regions for contours and lines
+    assets.scene.create(height + 2 * kDrift, width + 2 * kDrift, CV_8UC1);
+    rng.fill(assets.scene, cv::RNG::UNIFORM, 0, 256);
+    cv::GaussianBlur(assets.scene, assets.scene, cv::Size(0, 0), std::max(2.0, width / 160.0));
+    cv::normalize(assets.scene, assets.scene, 50, 190, cv::NORM_MINMAX);
+    for (int i = 0; i < 48; i++) {
+        const cv::Point corner(rng.uniform(0, assets.scene.cols), rng.uniform(0, assets.scene.rows));
+        const cv::Size size(rng.uniform(16, std::max(17, width / 5)), rng.uniform(16, std::max(17, height / 5)));
+        cv::rectangle(assets.scene, cv::Rect(corner, size), cv::Scalar(rng.uniform(0, 256)), cv::FILLED);
+    }
+    cv::rectangle(assets.scene, cv::Rect(kDrift + width / 3, kDrift + height / 4, width / 3, height / 2),
+                  cv::Scalar(235), cv::FILLED);
+
+    if (config.patterns & kSyntheticNoise) {
+        assets.noise.create(2 * height, 2 * width, CV_16SC1);
+        rng.fill(assets.noise, cv::RNG::NORMAL, 0, kNoiseSigma);
+    } else {
+        assets.noise.release();
+    }
+
+    // Colour bars: gives the BGR path real chroma to convert
+    assets.chroma.create(height / 2, width / 2, CV_8UC2);
+    for (int x = 0; x < assets.chroma.cols; x++) {
+        const double phase = 2.0 * CV_PI * x / assets.chroma.cols;
+        const cv::Vec2b vu(cv::saturate_cast<uchar>(128 + 48 * std::sin(phase)),
+                           cv::saturate_cast<uchar>(128 + 48 * std::cos(phase)));
+        assets.chroma.col(x).setTo(cv::Scalar(vu[0], vu[1]));
+    }
+}
+
+void SyntheticFrameSource::render(const SyntheticConfig& config, const Assets& assets, uint64_t index,
+                                  cv::Mat& nv21) {
+    const int width = config.width;
+    const int height = config.height;
+    cv::Mat luma = nv21.rowRange(0, height);
+    const bool moving = (config.patterns & kSyntheticMoving) != 0;
+
+    // Lissajous drift of the window: every offset stays inside the scene
+    const double t = static_cast<double>(index);
+    const int dx = moving ? static_cast<int>(std::lround(kDrift * std::sin(t * 0.031))) : 0;
+    const int dy = moving ? static_cast<int>(std::lround(kDrift * std::sin(t * 0.023 + 1.0))) : 0;
+    assets.scene(cv::Rect(kDrift + dx, kDrift + dy, width, height)).copyTo(luma);
+
+    if (moving) {
+        // Independent motion on top of the global drift
+        const int radius = std::max(8, height / 12);
+        const int span = width + 2 * radius;
+        const int x = static_cast<int>((index * static_cast<uint64_t>(std::max(2, width / 120))) % span) - radius;
+        const int y = height / 2 + static_cast<int>(std::lround(height / 4 * std::sin(t * 0.05)));
+        cv::circle(luma, cv::Point(x, y), radius, cv::Scalar(20), cv::FILLED);
+        const int bar = static_cast<int>((index * 3) % static_cast<uint64_t>(height));
+        cv::rectangle(luma, cv::Rect(0, bar, width / 6, std::max(4, height / 60)), cv::Scalar(250), cv::FILLED);
+    }
+
+    if (config.patterns & kSyntheticText) {
+        char text[64];
+        std::snprintf(text, sizeof(text), "frame %06llu  %.3fs", static_cast<unsigned long long>(index),
+                      config.framesPerSecond > 0 ? t / config.framesPerSecond : 0.0);
+        const double scale = height / 480.0;
+        const int thickness = std::max(1, static_cast<int>(std::lround(2 * scale)));
+        int baseline = 0;
+        const cv::Size size = cv::getTextSize(text, cv::FONT_HERSHEY_SIMPLEX, scale, thickness, &baseline);
+        const cv::Point origin(height / 40, height / 40 + size.height);
+        cv::rectangle(luma, cv::Rect(origin.x - 4, origin.y - size.height - 4, size.width + 8,
+                                     size.height + baseline + 8) & cv::Rect(0, 0, width, height),
+                      cv::Scalar(16), cv::FILLED);
+        cv::putText(luma, text, origin, cv::FONT_HERSHEY_SIMPLEX, scale, cv::Scalar(240), thickness, cv::LINE_8);
+    }
+
+    if (!assets.noise.empty()) {
+        // A different window of the noise field every frame, so it does not
+        // repeat with the frame index's low bits
+        const uint64_t hash = (index + 1) * 0x9e3779b97f4a7c15ULL;
+        const int nx = static_cast<int>((hash >> 16) % static_cast<uint64_t>(width));
+        const int ny = static_cast<int>((hash >> 40) % static_cast<uint64_t>(height));
+        cv::add(luma, assets.noise(cv::Rect(nx, ny, width, height)), luma, cv::noArray(), CV_8U);
+    }
+
+    cv::Mat chroma(height / 2, width / 2, CV_8UC2, nv21.ptr(height), nv21.step[0]);
+    assets.chroma.copyTo(chroma);
+}
+
+SyntheticFrameSource& syntheticFrameSource() {
+    static SyntheticFrameSource source;
+    return source;
+}
@@ -0,0 +1,89 @@
+#ifndef EDGE_SYNTHETIC_SOURCE_H
+#define EDGE_SYNTHETIC_SOURCE_H
+
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Content of generated frames, combinable
+enum SyntheticPattern : int {
+    kSyntheticMoving = 1,   // a drifting textured scene plus shapes crossing it
+    kSyntheticNoise = 2,    // per-frame sensor-like noise
+    kSyntheticText = 4,     // frame number and timestamp, for edge-dense glyphs
+    kSyntheticAll = 7,
+};
+
+struct SyntheticConfig {
+    int width = 1280;
+    int height = 720;
+    double framesPerSecond = 30.0;   // <= 0: as fast as the sink returns
+    int patterns = kSyntheticAll;
+    uint64_t seed = 0x5eed;
+};
+
+struct SyntheticReport {
+    uint64_t frames = 0;       // frames handed to the sink
+    uint64_t lateFrames = 0;   // produced more than one interval after they were due
+    double seconds = 0.0;      // since start
+    double framesPerSecond = 0.0;
+};
+
+// Camera-free frame source for stress tests: a thread renders procedural
+// NV21 frames straight into pooled buffers (frame_pool.h) at a fixed rate,
+// or back to back, and hands each to the sink on that thread. The scene,
+// noise field and chroma are rendered once at start, so a frame costs a
+// windowed copy, an add and a few shapes, which stays well above sensor
+// rates; when the sink cannot keep up the achieved rate shows where the
+// pipeline saturates. Deterministic for a given config.
+class SyntheticFrameSource {
+public:
+    // nv21: (height + height / 2) x width, CV_8UC1, pooled; the sink may keep
+    // the Mat (e.g. queue it as a PendingFrame)
+    using Sink = std::function<void(const cv::Mat& nv21, int width, int height, int64_t timestampNs)>;
+
+    ~SyntheticFrameSource();
+
+    // Replaces a running source. False on an invalid size (even, >= 64x64).
+    bool start(const SyntheticConfig& config, Sink sink);
+    // Joins the thread; returns the final report of the run
+    SyntheticReport stop();
+    bool isRunning() const { return running.load(std::memory_order_acquire); }
+
+    SyntheticReport report() const;
+
+    // Renders frame `index` of config into nv21 (allocated if needed) without
+    // a thread or pacing, for tools that drive the pipeline themselves
+    static void renderFrame(const SyntheticConfig& config, uint64_t index, cv::Mat& nv21);
+
+private:
+    struct Assets {
+        cv::Mat scene;    // luma, (height + 2 * kDrift) x (width + 2 * kDrift)
+        cv::Mat noise;    // CV_16SC1, twice the frame size, windowed per frame
+        cv::Mat chroma;   // interleaved VU for one frame
+    };
+
+    static const int kDrift = 64;  // pixels the scene window travels
+
+    static void buildAssets(const SyntheticConfig& config, Assets& assets);
+    static void render(const SyntheticConfig& config, const Assets& assets, uint64_t index, cv::Mat& nv21);
+    void run();
+
+    SyntheticConfig config;
+    Sink sink;
+    Assets assets;
+    std::thread thread;
+    std::mutex mutex;   // start/stop
+    std::atomic<bool> running{false};
+    std::atomic<bool> stopping{false};
+    std::atomic<uint64_t> frames{0};
+    std::atomic<uint64_t> late{0};
+    std::atomic<int64_t> startNs{0};
+    std::atomic<int64_t> endNs{0};
+};
+
+SyntheticFrameSource& syntheticFrameSource();
+
+#endif // EDGE_SYNTHETIC_SOURCE_H
@@ -0,0 +1,59 @@
+#include "temporal_denoise.h"
+#include "frame_pool.h"
+#include "kernel_dispatch.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const float kMaxStrength = 0.94f;  // 120 / 128: the history is always refreshed a little
+const int kMaxMotionThreshold = 239;  // plus the kernel's 16-level ramp stays within a byte
+
+}  // namespace
+
+void TemporalDenoiser::setParams(const Params& params) {
+    std::lock_guard<std::mutex> lock(mutex);
+    current = params;
+    current.strength = std::min(std::max(params.strength, 0.0f), kMaxStrength);
+    current.motionThreshold = std::min(std::max(params.motionThreshold, 0), kMaxMotionThreshold);
+    if (!current.enabled) {
+        history.release();
+    }
+}
+
+TemporalDenoiser::Params TemporalDenoiser::params() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return current;
+}
+
+void TemporalDenoiser::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    history.release();
+}
+
+cv::Mat TemporalDenoiser::filter(const cv::Mat& luma, const cv::Rect& roi) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!current.enabled || luma.empty() || luma.type() != CV_8UC1) {
+        return cv::Mat();
+    }
+    if (history.size() != luma.size() || historyRoi != roi) {
+        history = framePool().copyOf(luma);
+        historyRoi = roi;
+        return history;
+    }
+
+    const int strength = static_cast<int>(std::lround(current.strength * 128.0f));
+    const EdgeKernels& kernels = edgeKernels();
+    cv::Mat filtered = framePool().acquire(luma.rows, luma.cols, CV_8UC1);
+    for (int y = 0; y < luma.rows; y++) {
+        kernels.temporalBlendRow(luma.ptr<uint8_t>(y), history.ptr<uint8_t>(y), luma.cols, strength,
+                                 current.motionThreshold, filtered.ptr<uint8_t>(y));
+    }
+    history = filtered;
+    return filtered;
+}
+
+TemporalDenoiser& temporalDenoiser() {
+    static TemporalDenoiser denoiser;
+    return denoiser;
+}
@@ -0,0 +1,44 @@
+#ifndef EDGE_TEMPORAL_DENOISE_H
+#define EDGE_TEMPORAL_DENOISE_H
+
+#include <opencv2/core.hpp>
+#include <mutex>
+
+// Recursive (IIR) temporal denoise of the processed luma, for low light where
+// Canny otherwise fires on sensor noise. Each pixel is blended with the
+// previous filtered frame, weighted by how little it changed: still areas
+// average over several frames, moving ones pass through unfiltered. One pass
+// of the temporalBlendRow kernel (kernel_dispatch.h) per frame, far cheaper
+// than the photo module's spatial non-local means. The filtered frame is a
+// frame pool buffer, published as is and kept as the next frame's history,
+// so the filter holds no buffer of its own.
+class TemporalDenoiser {
+public:
+    struct Params {
+        bool enabled = false;
+        float strength = 0.6f;    // 0..0.94: history weight of an unchanged pixel
+        int motionThreshold = 12; // luma change (0..239) up to which a pixel counts as still
+    };
+
+    void setParams(const Params& params);
+    Params params();
+
+    // luma (CV_8UC1) filtered into a pooled buffer; empty when disabled. The
+    // first frame, and the first after a size or ROI change or reset(), only
+    // starts the history and comes back unfiltered (a pooled copy).
+    cv::Mat filter(const cv::Mat& luma, const cv::Rect& roi);
+
+    // Drops the history
+    void reset();
+
+private:
+    std::mutex mutex;
+    Params current;
+    cv::Mat history;       // last filtered frame (pooled, also published)
+    cv::Rect historyRoi;   // ROI it was taken from, empty = whole frame
+};
+
+// Denoiser of the processing pipeline
+TemporalDenoiser& temporalDenoiser();
+
+#endif // EDGE_TEMPORAL_DENOISE_H
@@ -0,0 +1,202 @@
+#include "text_region_detector.h"
+#include "gradient_edges.h"
+#include "metrics.h"
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+
+#define LOG_TAG "TextRegionDetector"
+#include "logging.h"
+
+namespace {
+
+const int kMinCharacterHeight = 6;    // reduced pixels; below this OCR reads nothing anyway
+const float kMinCharacterAspect = 0.1f;   // width over height: an 'l' or 'i'
+const float kMaxCharacterAspect = 1.5f;   // a 'W' or 'm'; wider boxes are words MSER merged, or not text
+const int kMinCharacters = 2;         // a lone glyph-shaped blob is too often a window or a bolt
+
+// A line being chained: its box, the character that ends it and the mean
+// character height
+struct Line {
+    cv::Rect bounds;
+    cv::Rect last;
+    float height = 0.0f;
+    int characters = 0;
+};
+
+// Whether character continues line: rows overlapping by half the shorter,
+// heights within a factor of two and a gap of at most maxGap heights
+bool continues(const Line& line, const cv::Rect& character, float maxGap, int& gap) {
+    const float ratio = character.height / line.height;
+    if (ratio < 0.5f || ratio > 2.0f) {
+        return false;
+    }
+    const int top = std::max(line.last.y, character.y);
+    const int bottom = std::min(line.last.y + line.last.height, character.y + character.height);
+    if (2 * (bottom - top) < std::min(line.last.height, character.height)) {
+        return false;
+    }
+    gap = character.x - (line.last.x + line.last.width);
+    return gap >= -line.last.width && gap <= maxGap * line.height;
+}
+
+}  // namespace
+
+void TextRegionDetector::setParams(const Params& params) {
+    std::lock_guard<std::mutex> lock(mutex);
+    current = params;
+    current.everyFrames = std::max(1, params.everyFrames);
+    current.inputWidth = std::min(std::max(params.inputWidth, 160), 1920);
+    current.cellSize = std::min(std::max(params.cellSize, 4), 64);
+    current.edgeThreshold = std::min(std::max(params.edgeThreshold, 1), 1020);
+    current.minEdgeDensity = std::min(std::max(params.minEdgeDensity, 0.0f), 1.0f);
+    current.delta = std::min(std::max(params.delta, 1), 32);
+    current.minArea = std::max(params.minArea, 4);
+    current.maxArea = std::max(params.maxArea, current.minArea + 1);
+    current.lineGap = std::min(std::max(params.lineGap, 0.0f), 8.0f);
+    mser.release();  // recreated with the new bounds
+}
+
+void TextRegionDetector::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    result.clear();
+    sinceDetection = -1;
+}
+
+bool TextRegionDetector::update(const cv::Mat& luma, std::vector<TextRegion>& regions) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (sinceDetection >= 0 && ++sinceDetection < current.everyFrames) {
+        regions = result;
+        return false;
+    }
+    sinceDetection = 0;
+    result.clear();
+    if (luma.empty()) {
+        regions = result;
+        return false;
+    }
+    ScopedStageTimer timer(Stage::TEXT_REGIONS);
+    if (!mser) {
+        mser = cv::MSER::create(current.delta, current.minArea, current.maxArea);
+    }
+
+    cv::Mat image = luma;
+    if (luma.cols > current.inputWidth) {
+        const int height = std::max(1, cvRound(static_cast<double>(luma.rows) * current.inputWidth / luma.cols));
+        cv::resize(luma, reduced, cv::Size(current.inputWidth, height), 0, 0, cv::INTER_AREA);
+        image = reduced;
+    }
+
+    // Edge density per cell, the cells dense enough grown by one so the
+    // strokes at a text block's rim stay inside it
+    gradientEdgesU8(image, edges, current.edgeThreshold);
+    const cv::Size cells(std::max(1, image.cols / current.cellSize), std::max(1, image.rows / current.cellSize));
+    cv::resize(edges, density, cells, 0, 0, cv::INTER_AREA);
+    cv::threshold(density, gate, current.minEdgeDensity * 255.0f, 255, cv::THRESH_BINARY);
+    cv::dilate(gate, gate, cv::Mat());
+    cv::Mat labels;
+    cv::Mat blocks;
+    cv::Mat centroids;
+    const int blockCount = cv::connectedComponentsWithStats(gate, labels, blocks, centroids, 8, CV_32S);
+
+    // Character-shaped MSER boxes of every block, in reduced pixels. MSER
+    // keeps its buffers between calls, so the blocks are searched in turn.
+    const double cellWidth = static_cast<double>(image.cols) / cells.width;
+    const double cellHeight = static_cast<double>(image.rows) / cells.height;
+    const cv::Rect frame(0, 0, image.cols, image.rows);
+    std::vector<cv::Rect> characters;
+    std::vector<std::vector<cv::Point>> points;
+    std::vector<cv::Rect> boxes;
+    uint64_t scanned = 0;
+    for (int i = 1; i < blockCount; i++) {
+        const int* block = blocks.ptr<int>(i);
+        const int x0 = cvFloor(block[cv::CC_STAT_LEFT] * cellWidth);
+        const int y0 = cvFloor(block[cv::CC_STAT_TOP] * cellHeight);
+        const int x1 = cvCeil((block[cv::CC_STAT_LEFT] + block[cv::CC_STAT_WIDTH]) * cellWidth);
+        const int y1 = cvCeil((block[cv::CC_STAT_TOP] + block[cv::CC_STAT_HEIGHT]) * cellHeight);
+        const cv::Rect area = cv::Rect(x0, y0, x1 - x0, y1 - y0) & frame;
+        if (area.height < kMinCharacterHeight || area.width < kMinCharacterHeight) {
+            continue;
+        }
+        scanned += static_cast<uint64_t>(area.area());
+        try {
+            mser->detectRegions(image(area), points, boxes);
+        } catch (const cv::Exception& e) {
+            LOGE_RATELIMITED("❌ MSER failed on a %dx%d block: %s", area.width, area.height, e.what());
+            continue;
+        }
+        for (const cv::Rect& box : boxes) {
+            const float aspect = static_cast<float>(box.width) / box.height;
+            if (box.height >= kMinCharacterHeight && aspect >= kMinCharacterAspect && aspect <= kMaxCharacterAspect) {
+                characters.push_back(box + area.tl());
+            }
+        }
+    }
+
+    // Left to right, each character continues the line it is closest to or
+    // starts one. MSER nests regions, so a box mostly over the line's last
+    // character widens the line without counting as another.
+    std::sort(characters.begin(), characters.end(),
+              [](const cv::Rect& a, const cv::Rect& b) { return a.x < b.x; });
+    std::vector<Line> lines;
+    for (const cv::Rect& character : characters) {
+        Line* best = nullptr;
+        int bestGap = 0;
+        for (Line& line : lines) {
+            int gap = 0;
+            if (continues(line, character, current.lineGap, gap) && (!best || gap < bestGap)) {
+                best = &line;
+                bestGap = gap;
+            }
+        }
+        if (!best) {
+            Line line;
+            line.bounds = character;
+            line.last = character;
+            line.height = static_cast<float>(character.height);
+            line.characters = 1;
+            lines.push_back(line);
+            continue;
+        }
+        best->bounds |= character;
+        if (2 * bestGap >= -character.width) {
+            best->characters++;
+            best->height += (character.height - best->height) / best->characters;
+        }
+        if (character.x + character.width > best->last.x + best->last.width) {
+            best->last = character;
+        }
+    }
+
+    // The lines with most characters, then in reading order
+    lines.erase(std::remove_if(lines.begin(), lines.end(), [](const Line& line) {
+        return line.characters < kMinCharacters || line.bounds.width < line.bounds.height;
+    }), lines.end());
+    std::sort(lines.begin(), lines.end(), [](const Line& a, const Line& b) { return a.characters > b.characters; });
+    if (lines.size() > static_cast<size_t>(kMaxRegions)) {
+        lines.resize(static_cast<size_t>(kMaxRegions));
+    }
+    std::sort(lines.begin(), lines.end(), [](const Line& a, const Line& b) {
+        return a.bounds.y != b.bounds.y ? a.bounds.y < b.bounds.y : a.bounds.x < b.bounds.x;
+    });
+    for (const Line& line : lines) {
+        TextRegion region;
+        region.box = cv::Rect2f(static_cast<float>(line.bounds.x) / image.cols,
+                                static_cast<float>(line.bounds.y) / image.rows,
+                                static_cast<float>(line.bounds.width) / image.cols,
+                                static_cast<float>(line.bounds.height) / image.rows);
+        region.characters = line.characters;
+        result.push_back(region);
+    }
+
+    detections.fetch_add(1, std::memory_order_relaxed);
+    candidates.fetch_add(characters.size(), std::memory_order_relaxed);
+    scannedPixels.fetch_add(scanned, std::memory_order_relaxed);
+    framePixels.fetch_add(static_cast<uint64_t>(image.total()), std::memory_order_relaxed);
+    regions = result;
+    return true;
+}
+
+TextRegionDetector& textRegionDetector() {
+    static TextRegionDetector detector;
+    return detector;
+}
@@ -0,0 +1,77 @@
+#ifndef EDGE_TEXT_REGION_DETECTOR_H
+#define EDGE_TEXT_REGION_DETECTOR_H
+
+#include <opencv2/core.hpp>
+#include <opencv2/features2d.hpp>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Candidate text lines for an OCR stage that reads small crops rather than
+// whole frames. The luma is reduced to inputWidth and its thresholded Sobel
+// magnitude (gradientEdgesU8) averaged over cellSize cells; only the
+// connected areas of cells dense enough in edges are handed to cv::MSER, so
+// sky, walls and blurred background never reach it. The MSER boxes shaped
+// like characters are chained left to right into line boxes: similar
+// height, overlapping rows and a gap under lineGap character heights. A
+// detection runs every few frames and its lines are held in between.
+class TextRegionDetector {
+public:
+    struct Params {
+        int everyFrames = 2;          // frames between detections
+        int inputWidth = 640;         // a wider luma is reduced to this
+        int cellSize = 16;            // edge density cells, in reduced pixels
+        int edgeThreshold = 96;       // L1 Sobel magnitude counted as an edge
+        float minEdgeDensity = 0.12f; // share of edge pixels that admits a cell
+        int delta = 5;                // MSER stability step
+        int minArea = 20;             // MSER region area bounds, in reduced pixels
+        int maxArea = 4000;
+        float lineGap = 1.2f;         // widest gap within a line, in character heights
+    };
+
+    struct TextRegion {
+        cv::Rect2f box;       // 0..1 units of the luma
+        int characters = 0;   // MSER boxes chained into the line
+    };
+
+    static const int kMaxRegions = 32;
+
+    void setParams(const Params& params);
+
+    // Processing thread, once per frame of the mode, on luma (CV_8UC1).
+    // regions receives the newest detection's lines, top to bottom; true
+    // when this frame ran one.
+    bool update(const cv::Mat& luma, std::vector<TextRegion>& regions);
+
+    // Drops the held lines; the next frame detects
+    void reset();
+
+    uint64_t detectionCount() const { return detections.load(std::memory_order_relaxed); }
+    uint64_t candidateCount() const { return candidates.load(std::memory_order_relaxed); }
+    // Reduced pixels MSER searched and reduced pixels detections covered:
+    // their ratio is the share the edge gate let through
+    uint64_t scannedPixelCount() const { return scannedPixels.load(std::memory_order_relaxed); }
+    uint64_t framePixelCount() const { return framePixels.load(std::memory_order_relaxed); }
+
+private:
+    std::mutex mutex;
+    Params current;
+    cv::Ptr<cv::MSER> mser;      // detectRegions keeps its buffers: one search at a time
+    cv::Mat reduced;
+    cv::Mat edges;
+    cv::Mat density;
+    cv::Mat gate;
+    std::vector<TextRegion> result;
+    int sinceDetection = -1;     // frames since the held detection; -1 = none yet
+
+    std::atomic<uint64_t> detections{0};
+    std::atomic<uint64_t> candidates{0};
+    std::atomic<uint64_t> scannedPixels{0};
+    std::atomic<uint64_t> framePixels{0};
+};
+
+// Detector used by the TEXT_REGIONS render mode
+TextRegionDetector& textRegionDetector();
+
+#endif // EDGE_TEXT_REGION_DETECTOR_H
@@ -0,0 +1,287 @@
+#include "thread_policy.h"
+#include "work_stealing_pool.h"
+#include <opencv2/core.hpp>
+#include <opencv2/core/utility.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <sched.h>
+#include <sys/resource.h>
+#include <thread>
+#include <unistd.h>
+
+#define LOG_TAG "ThreadPolicy"
+#include "logging.h"
+
+namespace {
+
+// How long pinning waits for every pool thread to pick up a stripe
+const std::chrono::milliseconds kPoolRendezvous(20);
+
+// Per tier: SCHED_FIFO priority asked for (0 = none) and the nice value used
+// otherwise (ANDROID_PRIORITY_VIDEO, _URGENT_DISPLAY, _NORMAL, _LOWEST)
+struct TierPolicy {
+    int fifoPriority;
+    int nice;
+    const char* name;
+};
+const TierPolicy kTiers[] = {
+        {2, -10, "ingest"},
+        {1, -8, "render"},
+        {0, 0, "processing"},
+        {0, 19, "analytics"},
+};
+
+// Longest a yield point holds analytics back, and how often it looks again
+const std::chrono::milliseconds kMaxForegroundYield(33);
+const std::chrono::milliseconds kForegroundPoll(1);
+
+std::mutex policyMutex;
+ThreadPolicy currentPolicy;
+std::atomic<unsigned> policyGeneration{0};   // bumped by setThreadPolicy
+unsigned poolGeneration = 0;                 // policyMutex; last generation applied to the pool
+thread_local unsigned threadGeneration = 0;  // last generation applied to this thread
+thread_local ThreadTier threadTier = ThreadTier::PROCESSING;
+thread_local bool threadTierSet = false;
+std::atomic<int> foregroundWork{0};
+
+std::atomic<int> processingStreams{0};
+std::mutex turnMutex;
+std::condition_variable turnChanged;
+uint64_t nextTicket = 0;   // turnMutex
+uint64_t servingTicket = 0;
+
+long maxFrequency(int cpu) {
+    char path[96];
+    std::snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpufreq/cpuinfo_max_freq", cpu);
+    FILE* file = std::fopen(path, "r");
+    if (!file) {
+        return -1;
+    }
+    long khz = -1;
+    if (std::fscanf(file, "%ld", &khz) != 1) {
+        khz = -1;
+    }
+    std::fclose(file);
+    return khz;
+}
+
+CpuTopology detectTopology() {
+    CpuTopology topology;
+    const int cpus = static_cast<int>(sysconf(_SC_NPROCESSORS_CONF));
+    std::vector<long> frequencies(std::max(cpus, 0));
+    long slowest = -1;
+    std::vector<long> distinct;
+    for (int cpu = 0; cpu < cpus; cpu++) {
+        frequencies[cpu] = maxFrequency(cpu);
+        if (frequencies[cpu] <= 0) {
+            continue;
+        }
+        if (std::find(distinct.begin(), distinct.end(), frequencies[cpu]) == distinct.end()) {
+            distinct.push_back(frequencies[cpu]);
+        }
+        slowest = slowest < 0 ? frequencies[cpu] : std::min(slowest, frequencies[cpu]);
+    }
+    topology.clusters = static_cast<int>(distinct.size());
+    for (int cpu = 0; cpu < cpus; cpu++) {
+        // Cores without cpufreq (offline at probe time) are left out; with no
+        // readable core at all everything counts as big
+        if (slowest < 0 || (frequencies[cpu] > 0 && (topology.clusters == 1 || frequencies[cpu] > slowest))) {
+            topology.bigCores.push_back(cpu);
+        } else if (frequencies[cpu] > 0) {
+            topology.littleCores.push_back(cpu);
+        }
+    }
+    LOGI("✅ CPU topology: %d clusters, %zu big and %zu little cores", topology.clusters,
+         topology.bigCores.size(), topology.littleCores.size());
+    return topology;
+}
+
+}  // namespace
+
+bool pinCurrentThread(const std::vector<int>& cpus) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (cpus.empty()) {
+        const int count = static_cast<int>(sysconf(_SC_NPROCESSORS_CONF));
+        for (int cpu = 0; cpu < count && cpu < CPU_SETSIZE; cpu++) {
+            CPU_SET(cpu, &set);
+        }
+    } else {
+        for (int cpu : cpus) {
+            if (cpu < CPU_SETSIZE) {
+                CPU_SET(cpu, &set);
+            }
+        }
+    }
+    // pid 0 is the calling thread on Linux
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+namespace {
+
+// Each stripe pins the thread running it and waits until all stripes are
+// running, so every pool thread gets exactly one
+class PinPoolThreads : public cv::ParallelLoopBody {
+public:
+    PinPoolThreads(const std::vector<int>& cpus, int stripes, std::atomic<int>& arrived, std::atomic<int>& failed)
+        : cpus(cpus), stripes(stripes), arrived(arrived), failed(failed) {}
+
+    void operator()(const cv::Range& range) const override {
+        if (!pinCurrentThread(cpus)) {
+            failed.fetch_add(1, std::memory_order_relaxed);
+        }
+        arrived.fetch_add(range.end - range.start, std::memory_order_acq_rel);
+        const auto deadline = std::chrono::steady_clock::now() + kPoolRendezvous;
+        while (arrived.load(std::memory_order_acquire) < stripes && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::yield();
+        }
+    }
+
+private:
+    const std::vector<int>& cpus;
+    const int stripes;
+    std::atomic<int>& arrived;
+    std::atomic<int>& failed;
+};
+
+}  // namespace
+
+const CpuTopology& cpuTopology() {
+    static const CpuTopology topology = detectTopology();
+    return topology;
+}
+
+void setThreadPolicy(const ThreadPolicy& policy) {
+    std::lock_guard<std::mutex> lock(policyMutex);
+    currentPolicy = policy;
+    policyGeneration.fetch_add(1, std::memory_order_release);
+}
+
+ThreadPolicy threadPolicy() {
+    std::lock_guard<std::mutex> lock(policyMutex);
+    return currentPolicy;
+}
+
+void applyThreadPolicy() {
+    const unsigned generation = policyGeneration.load(std::memory_order_acquire);
+    if (generation == threadGeneration) {
+        return;
+    }
+    threadGeneration = generation;
+
+    std::lock_guard<std::mutex> lock(policyMutex);
+    const CpuTopology& topology = cpuTopology();
+    const ThreadPolicy policy = currentPolicy;
+    const std::vector<int> none;
+    const std::vector<int>& cpus = policy.pinToBigCores ? topology.bigCores : none;
+    if (!pinCurrentThread(cpus)) {
+        LOGW("⚠️ Could not set processing thread affinity (cpuset restrictions?)");
+    }
+    if (poolGeneration == generation) {
+        return;  // another processing thread already set up the pool
+    }
+    poolGeneration = generation;
+
+    int threads = policy.openCvThreads;
+    if (threads <= 0) {
+        threads = policy.pinToBigCores ? static_cast<int>(std::max<size_t>(topology.bigCores.size(), 1)) : -1;
+    }
+    cv::setNumThreads(threads);  // -1 restores OpenCV's default
+    const int stripes = cv::getNumThreads();
+    if (workStealingPoolInstalled()) {
+        workStealingPool().setAffinity(cpus);  // the pool pins its own workers
+    } else if (stripes > 1) {
+        std::atomic<int> arrived{0};
+        std::atomic<int> failed{0};
+        cv::parallel_for_(cv::Range(0, stripes), PinPoolThreads(cpus, stripes, arrived, failed), stripes);
+        if (failed.load() > 0) {
+            LOGW("⚠️ %d OpenCV pool threads kept their affinity", failed.load());
+        }
+    }
+    LOGI("🔄 Thread policy: %s, %d OpenCV threads", policy.pinToBigCores ? "big cores" : "any core", stripes);
+}
+
+void setThreadTier(ThreadTier tier) {
+    if (threadTierSet && threadTier == tier) {
+        return;
+    }
+    threadTierSet = true;
+    threadTier = tier;
+    const TierPolicy& policy = kTiers[static_cast<int>(tier)];
+    const pid_t tid = gettid();
+    sched_param param = {};
+    param.sched_priority = policy.fifoPriority;
+    // pid 0 is the calling thread on Linux
+    if (policy.fifoPriority > 0 && sched_setscheduler(0, SCHED_FIFO, &param) == 0) {
+        LOGI("🔄 Thread %d: %s tier, SCHED_FIFO %d", tid, policy.name, policy.fifoPriority);
+        return;
+    }
+    param.sched_priority = 0;
+    const bool idle = tier == ThreadTier::ANALYTICS && sched_setscheduler(0, SCHED_IDLE, &param) == 0;
+    if (!idle) {
+        sched_setscheduler(0, SCHED_OTHER, &param);  // back from an earlier tier's class
+    }
+    // Under SCHED_IDLE the nice value is ignored, but it still applies if the
+    // class is ever reset
+    if (setpriority(PRIO_PROCESS, static_cast<id_t>(tid), policy.nice) != 0) {
+        LOGW("⚠️ Thread %d: could not set nice %d for the %s tier", tid, policy.nice, policy.name);
+        return;
+    }
+    LOGI("🔄 Thread %d: %s tier, %s nice %d", tid, policy.name, idle ? "SCHED_IDLE," : "SCHED_OTHER", policy.nice);
+}
+
+ThreadTier currentThreadTier() {
+    return threadTier;
+}
+
+ForegroundWork::ForegroundWork() {
+    foregroundWork.fetch_add(1, std::memory_order_relaxed);
+}
+
+ForegroundWork::~ForegroundWork() {
+    foregroundWork.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void yieldToForeground() {
+    if (threadTier != ThreadTier::ANALYTICS) {
+        return;
+    }
+    const auto deadline = std::chrono::steady_clock::now() + kMaxForegroundYield;
+    while (foregroundWork.load(std::memory_order_relaxed) > 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(kForegroundPoll);
+    }
+}
+
+void addProcessingStream() {
+    processingStreams.fetch_add(1, std::memory_order_relaxed);
+}
+
+void removeProcessingStream() {
+    processingStreams.fetch_sub(1, std::memory_order_relaxed);
+}
+
+PoolTurn::PoolTurn() {
+    if (processingStreams.load(std::memory_order_relaxed) < 2) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(turnMutex);
+    const uint64_t ticket = nextTicket++;
+    turnChanged.wait(lock, [ticket] { return servingTicket == ticket; });
+    held = true;
+}
+
+PoolTurn::~PoolTurn() {
+    if (!held) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(turnMutex);
+        servingTicket++;
+    }
+    turnChanged.notify_all();
+}
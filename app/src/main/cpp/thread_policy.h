@@ -0,0 +1,90 @@
+#ifndef EDGE_THREAD_POLICY_H
+#define EDGE_THREAD_POLICY_H
+
+#include <vector>
+
+// CPU clusters as the kernel reports them: cores grouped by
+// cpufreq/cpuinfo_max_freq. Everything faster than the slowest group counts as
+// big (prime and big clusters alike); on a homogeneous SoC every core is big.
+struct CpuTopology {
+    std::vector<int> bigCores;
+    std::vector<int> littleCores;
+    int clusters = 0;            // distinct maximum frequencies
+};
+
+// Read from sysfs on first use
+const CpuTopology& cpuTopology();
+
+// Restricts the calling thread to cpus (all configured cores when empty)
+bool pinCurrentThread(const std::vector<int>& cpus);
+
+// Where the processing thread and OpenCV's parallel_for_ pool run
+struct ThreadPolicy {
+    bool pinToBigCores = false;
+    // OpenCV threads (the caller included): 0 = one per big core when pinning,
+    // the OpenCV default otherwise
+    int openCvThreads = 0;
+};
+
+void setThreadPolicy(const ThreadPolicy& policy);
+ThreadPolicy threadPolicy();
+
+// Called by processing threads before each frame: applies a changed policy to
+// the calling thread and, once per change, to OpenCV's pool. A relaxed load
+// and a compare when nothing changed.
+void applyThreadPolicy();
+
+// Scheduling tiers, most urgent first. Ingest and render ask for SCHED_FIFO
+// and, where that is refused (apps lack CAP_SYS_NICE on most builds), get the
+// negative nice values Android gives video and display threads; processing
+// stays at normal priority; analytics run SCHED_IDLE (nice 19 where that is
+// refused), so they only ever get cores nothing else wants.
+enum class ThreadTier {
+    INGEST,      // camera callbacks and frame sources
+    RENDER,      // the GL thread and the vsync loops driving it
+    PROCESSING,  // the processing worker, pipeline stages, pool workers
+    ANALYTICS    // background analysis: DNN, code scanning, segments, archive, snapshots
+};
+
+// Moves the calling thread to tier; a thread-local compare when it is already
+// there. Threads never placed count as PROCESSING.
+void setThreadTier(ThreadTier tier);
+ThreadTier currentThreadTier();
+
+// Marks foreground work (ingest, a frame being processed, a draw) in flight
+// for yieldToForeground()
+class ForegroundWork {
+public:
+    ForegroundWork();
+    ~ForegroundWork();
+    ForegroundWork(const ForegroundWork&) = delete;
+    ForegroundWork& operator=(const ForegroundWork&) = delete;
+};
+
+// Cooperative yield point between the chunks of a long analytics task: waits
+// while foreground work is in flight, at most about a frame so a saturated
+// pipeline still lets analytics crawl forward. Returns at once on any other
+// tier.
+void yieldToForeground();
+
+// Several streams processing at once (one worker per camera) share OpenCV's
+// single pool, and parallel_for_ runs a caller that finds it busy serially,
+// so whichever stream got there first would keep the whole pool. While more
+// than one stream is registered, each frame's pool-heavy steps run under a
+// PoolTurn: FIFO tickets, so waiting streams alternate and each frame still
+// gets every pool thread. With one stream a turn is a relaxed load.
+void addProcessingStream();
+void removeProcessingStream();
+
+class PoolTurn {
+public:
+    PoolTurn();
+    ~PoolTurn();
+    PoolTurn(const PoolTurn&) = delete;
+    PoolTurn& operator=(const PoolTurn&) = delete;
+
+private:
+    bool held = false;
+};
+
+#endif // EDGE_THREAD_POLICY_H
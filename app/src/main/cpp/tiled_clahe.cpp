@@ -0,0 +1,176 @@
+#include "tiled_clahe.h"
+#include <opencv2/core/utility.hpp>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+const int kBandRows = 32;
+const int kWeightBits = 8;  // bilinear weights in 1/256
+const int kWeightOne = 1 << kWeightBits;
+
+// Tile t of a side of length n split in count: [start, end)
+inline int tileStart(int t, int n, int count) {
+    return static_cast<int>(static_cast<int64_t>(t) * n / count);
+}
+
+// Left (or top) tile whose centre is at or before each pixel, and the weight
+// of the next one, clamped at the outer half tiles
+void interpolationTable(int n, int count, std::vector<int>& tile, std::vector<int>& weight) {
+    tile.resize(static_cast<size_t>(n));
+    weight.resize(static_cast<size_t>(n));
+    const float scale = static_cast<float>(count) / n;
+    for (int i = 0; i < n; i++) {
+        const float position = (i + 0.5f) * scale - 0.5f;
+        int t = static_cast<int>(position < 0.0f ? -1.0f : position);
+        int w = static_cast<int>((position - t) * kWeightOne + 0.5f);
+        if (t < 0) {
+            t = 0;
+            w = 0;
+        } else if (t >= count - 1) {
+            t = count - 1;
+            w = 0;
+        }
+        tile[static_cast<size_t>(i)] = t;
+        weight[static_cast<size_t>(i)] = w;
+    }
+}
+
+// One clipped, equalized LUT per tile
+class TileLutBody : public cv::ParallelLoopBody {
+public:
+    TileLutBody(const cv::Mat& gray, int tiles, int step, double clipLimit, uint8_t* luts)
+        : gray(gray), tiles(tiles), step(step), clipLimit(clipLimit), luts(luts) {}
+
+    void operator()(const cv::Range& range) const override {
+        int histogram[256];
+        for (int index = range.start; index < range.end; index++) {
+            const int ty = index / tiles;
+            const int tx = index % tiles;
+            const int y0 = tileStart(ty, gray.rows, tiles);
+            const int y1 = tileStart(ty + 1, gray.rows, tiles);
+            const int x0 = tileStart(tx, gray.cols, tiles);
+            const int x1 = tileStart(tx + 1, gray.cols, tiles);
+
+            std::memset(histogram, 0, sizeof(histogram));
+            int samples = 0;
+            for (int y = y0; y < y1; y += step) {
+                const uint8_t* row = gray.ptr<uint8_t>(y);
+                for (int x = x0; x < x1; x += step) {
+                    histogram[row[x]]++;
+                }
+                samples += (x1 - x0 + step - 1) / step;
+            }
+            uint8_t* lut = luts + 256 * index;
+            if (samples == 0) {
+                for (int v = 0; v < 256; v++) {
+                    lut[v] = static_cast<uint8_t>(v);
+                }
+                continue;
+            }
+
+            // Clip and hand the excess back evenly, the remainder spread
+            // across the range like OpenCV does
+            if (clipLimit > 0.0) {
+                const int limit = std::max(1, static_cast<int>(clipLimit * samples / 256));
+                int excess = 0;
+                for (int v = 0; v < 256; v++) {
+                    if (histogram[v] > limit) {
+                        excess += histogram[v] - limit;
+                        histogram[v] = limit;
+                    }
+                }
+                const int share = excess / 256;
+                const int residual = excess - share * 256;
+                for (int v = 0; v < 256; v++) {
+                    histogram[v] += share;
+                }
+                if (residual > 0) {
+                    const int residualStep = std::max(256 / residual, 1);
+                    for (int v = 0, left = residual; v < 256 && left > 0; v += residualStep, left--) {
+                        histogram[v]++;
+                    }
+                }
+            }
+
+            const float scale = 255.0f / samples;
+            int sum = 0;
+            for (int v = 0; v < 256; v++) {
+                sum += histogram[v];
+                lut[v] = cv::saturate_cast<uint8_t>(sum * scale);
+            }
+        }
+    }
+
+private:
+    const cv::Mat& gray;
+    const int tiles;
+    const int step;
+    const double clipLimit;
+    uint8_t* luts;
+};
+
+// The four nearest LUTs blended per pixel, bands of kBandRows rows
+class InterpolateBody : public cv::ParallelLoopBody {
+public:
+    InterpolateBody(const cv::Mat& gray, cv::Mat& dst, int tiles, const uint8_t* luts, const std::vector<int>& colTile,
+                    const std::vector<int>& colWeight, const std::vector<int>& rowTile,
+                    const std::vector<int>& rowWeight)
+        : gray(gray), dst(dst), tiles(tiles), luts(luts), colTile(colTile), colWeight(colWeight), rowTile(rowTile),
+          rowWeight(rowWeight) {}
+
+    void operator()(const cv::Range& range) const override {
+        const int width = gray.cols;
+        const int y1 = std::min(gray.rows, range.end * kBandRows);
+        for (int y = range.start * kBandRows; y < y1; y++) {
+            const int ty = rowTile[static_cast<size_t>(y)];
+            const int wy = rowWeight[static_cast<size_t>(y)];
+            const uint8_t* top = luts + 256 * tiles * ty;
+            const uint8_t* bottom = wy ? top + 256 * tiles : top;
+            const uint8_t* in = gray.ptr<uint8_t>(y);
+            uint8_t* out = dst.ptr<uint8_t>(y);
+            for (int x = 0; x < width; x++) {
+                const int v = in[x];
+                const int t = 256 * colTile[static_cast<size_t>(x)] + v;
+                const int wx = colWeight[static_cast<size_t>(x)];
+                const int t1 = wx ? t + 256 : t;
+                const int upper = top[t] * (kWeightOne - wx) + top[t1] * wx;
+                const int lower = bottom[t] * (kWeightOne - wx) + bottom[t1] * wx;
+                out[x] = static_cast<uint8_t>(
+                    (upper * (kWeightOne - wy) + lower * wy + (1 << (2 * kWeightBits - 1))) >> (2 * kWeightBits));
+            }
+        }
+    }
+
+private:
+    const cv::Mat& gray;
+    cv::Mat& dst;
+    const int tiles;
+    const uint8_t* luts;
+    const std::vector<int>& colTile;
+    const std::vector<int>& colWeight;
+    const std::vector<int>& rowTile;
+    const std::vector<int>& rowWeight;
+};
+
+} // namespace
+
+void tiledClahe(const cv::Mat& gray, cv::Mat& dst, double clipLimit, int tiles, int sampleStep) {
+    CV_Assert(gray.type() == CV_8UC1 && !gray.empty());
+    tiles = std::min(std::max(tiles, 2), std::min(16, std::min(gray.cols, gray.rows)));
+    sampleStep = std::max(sampleStep, 1);
+
+    // Scratch kept per calling thread; a frame size change only resizes it
+    static thread_local std::vector<uint8_t> luts;
+    static thread_local std::vector<int> colTile, colWeight, rowTile, rowWeight;
+    luts.resize(static_cast<size_t>(256 * tiles * tiles));
+    cv::parallel_for_(cv::Range(0, tiles * tiles), TileLutBody(gray, tiles, sampleStep, clipLimit, luts.data()));
+
+    interpolationTable(gray.cols, tiles, colTile, colWeight);
+    interpolationTable(gray.rows, tiles, rowTile, rowWeight);
+    dst.create(gray.size(), CV_8UC1);
+    const int bands = (gray.rows + kBandRows - 1) / kBandRows;
+    cv::parallel_for_(cv::Range(0, bands),
+                      InterpolateBody(gray, dst, tiles, luts.data(), colTile, colWeight, rowTile, rowWeight));
+}
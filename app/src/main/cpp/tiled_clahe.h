@@ -0,0 +1,16 @@
+#ifndef EDGE_TILED_CLAHE_H
+#define EDGE_TILED_CLAHE_H
+
+#include <opencv2/core.hpp>
+
+// Contrast-limited adaptive histogram equalization of an 8-bit luma, so
+// backlit and dim regions still reach fixed Canny thresholds. Same model as
+// cv::createCLAHE (per-tile clipped histograms, bilinear blend of the four
+// nearest tiles' LUTs), built for the per-frame budget: histograms sample
+// every sampleStep-th row and column, tiles are counted in parallel, and the
+// interpolation is a single fused pass over row bands on OpenCV's pool that
+// reads each source pixel once. tiles x tiles grid (2..16); clipLimit as in
+// OpenCV, relative to a flat histogram. dst may be gray.
+void tiledClahe(const cv::Mat& gray, cv::Mat& dst, double clipLimit, int tiles, int sampleStep = 2);
+
+#endif // EDGE_TILED_CLAHE_H
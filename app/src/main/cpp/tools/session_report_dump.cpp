@@ -0,0 +1,208 @@
+// Host-side decoder for session reports (session_report.h): prints each file
+// given as one JSON object per line, stage histograms with their p50, p95 and
+// p99 in microseconds, for loading many sessions into an analysis tool. Not
+// part of the app build:
+//
+//   c++ -std=c++14 -O2 -o session_report_dump app/src/main/cpp/tools/session_report_dump.cpp
+//   adb exec-out run-as com.example.edge cat files/session.pb > session.pb
+//   ./session_report_dump session.pb > sessions.jsonl
+
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+// One field of a message: a varint, or the bytes of a length-delimited value
+struct Field {
+    uint32_t number = 0;
+    uint64_t value = 0;
+    std::string bytes;
+    bool delimited = false;
+};
+
+bool readVarint(const std::string& data, size_t& at, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && at < data.size(); shift += 7) {
+        const uint8_t byte = static_cast<uint8_t>(data[at++]);
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Fields of one message; false on a malformed or unsupported wire type
+bool parse(const std::string& data, std::vector<Field>& fields) {
+    fields.clear();
+    size_t at = 0;
+    while (at < data.size()) {
+        uint64_t key;
+        Field field;
+        if (!readVarint(data, at, key)) {
+            return false;
+        }
+        field.number = static_cast<uint32_t>(key >> 3);
+        if ((key & 7) == 0) {
+            if (!readVarint(data, at, field.value)) {
+                return false;
+            }
+        } else if ((key & 7) == 2) {
+            uint64_t length;
+            if (!readVarint(data, at, length) || length > data.size() - at) {
+                return false;
+            }
+            field.bytes = data.substr(at, static_cast<size_t>(length));
+            field.delimited = true;
+            at += static_cast<size_t>(length);
+        } else {
+            return false;
+        }
+        fields.push_back(field);
+    }
+    return true;
+}
+
+std::string quoted(const std::string& text) {
+    std::string out = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        } else {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+// Upper bound of the bucket holding quantile of buckets
+double percentile(const std::vector<uint64_t>& buckets, uint64_t count, double quantile, double first,
+                  double growth) {
+    const double target = quantile * static_cast<double>(count);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); i++) {
+        seen += buckets[i];
+        if (static_cast<double>(seen) >= target) {
+            return first * std::pow(growth, static_cast<double>(i));
+        }
+    }
+    return first * std::pow(growth, static_cast<double>(buckets.size()));
+}
+
+bool dump(const char* path) {
+    FILE* file = std::fopen(path, "rb");
+    if (!file) {
+        std::perror(path);
+        return false;
+    }
+    std::string data;
+    char chunk[4096];
+    size_t read;
+    while ((read = std::fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        data.append(chunk, read);
+    }
+    std::fclose(file);
+
+    std::vector<Field> fields;
+    std::vector<Field> nested;
+    if (!parse(data, fields)) {
+        std::fprintf(stderr, "%s: not a session report\n", path);
+        return false;
+    }
+    double first = 10.0;
+    double growth = 1.25;
+    for (const Field& field : fields) {
+        if (field.number == 17 && !field.delimited) {
+            first = static_cast<double>(field.value);
+        } else if (field.number == 18 && !field.delimited) {
+            growth = static_cast<double>(field.value) / 1000.0;
+        }
+    }
+
+    static const char* const kScalars[] = {nullptr, "version", "model", "manufacturer", "soc", "sdk", "build",
+                                           "big_cores", "little_cores", "start_unix_ms", "duration_ms"};
+    std::string json = "{\"file\":" + quoted(path);
+    std::string backends, counters, stages, thermal, governor, memory;
+    auto append = [](std::string& list, const std::string& item) { list += (list.empty() ? "" : ",") + item; };
+    for (const Field& field : fields) {
+        if (field.number >= 1 && field.number <= 10) {
+            json += std::string(",\"") + kScalars[field.number] + "\":" +
+                    (field.delimited ? quoted(field.bytes) : std::to_string(field.value));
+            continue;
+        }
+        if (!field.delimited || !parse(field.bytes, nested)) {
+            continue;  // a field of a later version
+        }
+        std::string name, text;
+        uint64_t at = 0;     // field 1 of a transition
+        uint64_t value = 0;  // field 2 as a varint
+        std::vector<uint64_t> buckets;
+        for (const Field& part : nested) {
+            if (part.number == 1) {
+                name = part.bytes;
+                at = part.value;
+            } else if (part.number == 2) {
+                text = part.bytes;
+                value = part.value;
+            } else if (part.number == 3 && part.delimited) {
+                size_t offset = 0;
+                uint64_t bucket;
+                while (offset < part.bytes.size() && readVarint(part.bytes, offset, bucket)) {
+                    buckets.push_back(bucket);
+                }
+            }
+        }
+        char numbers[96];
+        switch (field.number) {
+            case 11:
+                append(backends, quoted(name) + ":" + quoted(text));
+                break;
+            case 12:
+                append(counters, quoted(name) + ":" + std::to_string(value));
+                break;
+            case 13:
+                std::snprintf(numbers, sizeof(numbers), ",\"p50_us\":%.0f,\"p95_us\":%.0f,\"p99_us\":%.0f",
+                              percentile(buckets, value, 0.5, first, growth),
+                              percentile(buckets, value, 0.95, first, growth),
+                              percentile(buckets, value, 0.99, first, growth));
+                append(stages, quoted(name) + ":{\"count\":" + std::to_string(value) + numbers + "}");
+                break;
+            case 14:
+            case 15:
+                append(field.number == 14 ? thermal : governor,
+                       "[" + std::to_string(at) + "," + std::to_string(value) + "]");
+                break;
+            case 16:
+                append(memory, quoted(name) + ":" + std::to_string(value));
+                break;
+            default:
+                break;
+        }
+    }
+    json += ",\"backends\":{" + backends + "},\"counters\":{" + counters + "},\"stages\":{" + stages +
+            "},\"thermal\":[" + thermal + "],\"governor\":[" + governor + "],\"memory_peak_bytes\":{" + memory + "}}";
+    std::printf("%s\n", json.c_str());
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <report file>...\n", argv[0]);
+        return 2;
+    }
+    int failed = 0;
+    for (int i = 1; i < argc; i++) {
+        failed += dump(argv[i]) ? 0 : 1;
+    }
+    return failed ? 1 : 0;
+}
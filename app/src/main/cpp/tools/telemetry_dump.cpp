@@ -0,0 +1,71 @@
+// Host-side decoder for the frame telemetry ring (frame_telemetry.h): prints
+// the records oldest first as CSV, one column per stage named in the file.
+// Not part of the app build:
+//
+//   c++ -std=c++14 -O2 -o telemetry_dump app/src/main/cpp/tools/telemetry_dump.cpp
+//   adb exec-out run-as com.example.edge cat files/frames.tlm > frames.tlm
+//   ./telemetry_dump frames.tlm > frames.csv
+
+#include "../frame_telemetry.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        std::fprintf(stderr, "usage: %s <telemetry file>\n", argv[0]);
+        return 2;
+    }
+    FILE* file = std::fopen(argv[1], "rb");
+    if (!file) {
+        std::perror(argv[1]);
+        return 1;
+    }
+    TelemetryFileHeader header;
+    if (std::fread(&header, sizeof(header), 1, file) != 1 || std::memcmp(header.magic, "EDGETLM", 8) != 0) {
+        std::fprintf(stderr, "%s: not a telemetry file\n", argv[1]);
+        std::fclose(file);
+        return 1;
+    }
+    if (header.version != kTelemetryVersion || header.recordBytes != sizeof(TelemetryRecord) ||
+        header.stageCount > static_cast<uint32_t>(kTelemetryMaxStages)) {
+        std::fprintf(stderr, "%s: unsupported version %u (record %u bytes)\n", argv[1], header.version,
+                     header.recordBytes);
+        std::fclose(file);
+        return 1;
+    }
+
+    std::vector<TelemetryRecord> records(header.recordCount);
+    std::fseek(file, static_cast<long>(kTelemetryHeaderBytes), SEEK_SET);
+    const size_t read = std::fread(records.data(), sizeof(TelemetryRecord), records.size(), file);
+    std::fclose(file);
+    records.resize(read);
+    records.erase(std::remove_if(records.begin(), records.end(),
+                                 [](const TelemetryRecord& r) { return r.sequence == 0; }),
+                  records.end());
+    std::sort(records.begin(), records.end(),
+              [](const TelemetryRecord& a, const TelemetryRecord& b) { return a.sequence < b.sequence; });
+
+    std::printf("sequence,capture_ns,publish_ns,latency_us,mode,width,height,canny_low,canny_high,"
+                "luma_median,luma_mean,sharpness,processed,dropped,stale,governor_skipped");
+    for (uint32_t i = 0; i < header.stageCount; i++) {
+        char name[kTelemetryStageNameBytes + 1] = {};
+        std::memcpy(name, header.stageNames[i], kTelemetryStageNameBytes);
+        std::printf(",%s_us", name);
+    }
+    std::printf("\n");
+    for (const TelemetryRecord& r : records) {
+        const int64_t latencyUs = r.captureTimestampNs > 0 ? (r.publishTimestampNs - r.captureTimestampNs) / 1000 : -1;
+        std::printf("%" PRIu64 ",%" PRId64 ",%" PRId64 ",%" PRId64 ",%d,%u,%u,%d,%d,%d,%.2f,%.2f,%u,%u,%u,%u",
+                    r.sequence, r.captureTimestampNs, r.publishTimestampNs, latencyUs, r.renderMode, r.width,
+                    r.height, r.cannyLow, r.cannyHigh, r.lumaMedian, r.lumaMean, r.lumaSharpness,
+                    r.framesProcessed, r.framesDropped, r.framesStale, r.framesGovernorSkipped);
+        for (uint32_t i = 0; i < header.stageCount; i++) {
+            std::printf(",%u", r.stageMicros[i]);
+        }
+        std::printf("\n");
+    }
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include "tracing.h"
+
+#ifdef __ANDROID__
+#include <dlfcn.h>
+
+namespace {
+
+// minSdk is 24: sections are API 23, async sections and counters API 29
+struct TraceApi {
+    bool (*isEnabled)() = nullptr;
+    void (*beginSection)(const char*) = nullptr;
+    void (*endSection)() = nullptr;
+    void (*beginAsyncSection)(const char*, int32_t) = nullptr;
+    void (*endAsyncSection)(const char*, int32_t) = nullptr;
+    void (*setCounter)(const char*, int64_t) = nullptr;
+};
+
+const TraceApi& traceApi() {
+    static const TraceApi api = [] {
+        TraceApi loaded;
+        void* library = dlopen("libandroid.so", RTLD_NOW);
+        if (!library) {
+            return loaded;
+        }
+        loaded.isEnabled = reinterpret_cast<decltype(loaded.isEnabled)>(dlsym(library, "ATrace_isEnabled"));
+        loaded.beginSection = reinterpret_cast<decltype(loaded.beginSection)>(dlsym(library, "ATrace_beginSection"));
+        loaded.endSection = reinterpret_cast<decltype(loaded.endSection)>(dlsym(library, "ATrace_endSection"));
+        loaded.beginAsyncSection = reinterpret_cast<decltype(loaded.beginAsyncSection)>(
+                dlsym(library, "ATrace_beginAsyncSection"));
+        loaded.endAsyncSection = reinterpret_cast<decltype(loaded.endAsyncSection)>(
+                dlsym(library, "ATrace_endAsyncSection"));
+        loaded.setCounter = reinterpret_cast<decltype(loaded.setCounter)>(dlsym(library, "ATrace_setCounter"));
+        if (!loaded.beginSection || !loaded.endSection) {
+            loaded.isEnabled = nullptr;  // never report enabled without the calls to honour it
+        }
+        return loaded;
+    }();
+    return api;
+}
+
+} // namespace
+
+bool traceEnabled() {
+    const TraceApi& api = traceApi();
+    return api.isEnabled && api.isEnabled();
+}
+
+void traceBegin(const char* name) {
+    const TraceApi& api = traceApi();
+    if (api.beginSection) {
+        api.beginSection(name);
+    }
+}
+
+void traceEnd() {
+    const TraceApi& api = traceApi();
+    if (api.endSection) {
+        api.endSection();
+    }
+}
+
+void traceAsyncBegin(const char* name, int32_t cookie) {
+    const TraceApi& api = traceApi();
+    if (api.beginAsyncSection && traceEnabled()) {
+        api.beginAsyncSection(name, cookie);
+    }
+}
+
+void traceAsyncEnd(const char* name, int32_t cookie) {
+    const TraceApi& api = traceApi();
+    if (api.endAsyncSection && traceEnabled()) {
+        api.endAsyncSection(name, cookie);
+    }
+}
+
+void traceCounter(const char* name, int64_t value) {
+    const TraceApi& api = traceApi();
+    if (api.setCounter && traceEnabled()) {
+        api.setCounter(name, value);
+    }
+}
+
+#else
+
+bool traceEnabled() { return false; }
+void traceBegin(const char*) {}
+void traceEnd() {}
+void traceAsyncBegin(const char*, int32_t) {}
+void traceAsyncEnd(const char*, int32_t) {}
+void traceCounter(const char*, int64_t) {}
+
+#endif
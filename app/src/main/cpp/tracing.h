@@ -0,0 +1,43 @@
+#ifndef EDGE_TRACING_H
+#define EDGE_TRACING_H
+
+#include <cstdint>
+
+// ATrace sections for Perfetto/systrace captures (category "app"). The NDK
+// calls are resolved at runtime (async sections and counters are API 29), and
+// everything short-circuits on ATrace_isEnabled, so with no capture running a
+// section costs one call that reads a flag. No-ops on host builds.
+bool traceEnabled();
+void traceBegin(const char* name);
+void traceEnd();
+
+// Sections that start and end on different threads; cookie tells overlapping
+// ones of the same name apart
+void traceAsyncBegin(const char* name, int32_t cookie);
+void traceAsyncEnd(const char* name, int32_t cookie);
+
+void traceCounter(const char* name, int64_t value);
+
+// Section for the enclosing scope. Decides once whether to trace, so begin
+// and end stay paired when a capture starts or stops inside the scope.
+class ScopedTrace {
+public:
+    explicit ScopedTrace(const char* name) : active(traceEnabled()) {
+        if (active) {
+            traceBegin(name);
+        }
+    }
+    ~ScopedTrace() {
+        if (active) {
+            traceEnd();
+        }
+    }
+
+    ScopedTrace(const ScopedTrace&) = delete;
+    ScopedTrace& operator=(const ScopedTrace&) = delete;
+
+private:
+    bool active;
+};
+
+#endif // EDGE_TRACING_H
@@ -0,0 +1,49 @@
+#ifndef EDGE_TRIPLE_BUFFER_H
+#define EDGE_TRIPLE_BUFFER_H
+
+#include <atomic>
+
+// Single-producer / single-consumer triple buffer. The producer fills its private
+// back slot and publishes it with one atomic exchange; the consumer takes the
+// newest published slot with another exchange. Neither side ever blocks or copies,
+// and the consumer always sees the most recent complete value.
+template <typename T>
+class TripleBuffer {
+public:
+    // Producer side: slot to fill before publish()
+    T& writeSlot() { return slots[backIndex]; }
+
+    void publish() {
+        unsigned previous = middle.exchange(backIndex | kFreshBit, std::memory_order_acq_rel);
+        backIndex = previous & kIndexMask;
+    }
+
+    // Consumer side: swaps in the newest published slot. Returns false (and keeps
+    // the current slot) when nothing was published since the last call.
+    bool update() {
+        if ((middle.load(std::memory_order_relaxed) & kFreshBit) == 0) {
+            return false;
+        }
+        unsigned previous = middle.exchange(frontIndex, std::memory_order_acq_rel);
+        frontIndex = previous & kIndexMask;
+        return true;
+    }
+
+    const T& readSlot() const { return slots[frontIndex]; }
+
+private:
+    static const unsigned kIndexMask = 0x3;
+    static const unsigned kFreshBit = 0x4;
+
+    // Padding rather than alignas, as in SpscRing: pipeline contexts other
+    // than the default one live on the heap
+    T slots[3];
+    unsigned backIndex = 0;              // owned by the producer
+    char padMiddle[64];
+    std::atomic<unsigned> middle{1};     // shared, on its own cache line
+    char padFront[64];
+    unsigned frontIndex = 2;             // owned by the consumer
+    char padEnd[64];
+};
+
+#endif // EDGE_TRIPLE_BUFFER_H
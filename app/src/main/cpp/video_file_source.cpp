@@ -0,0 +1,426 @@
+#include "video_file_source.h"
+#include "metrics.h"
+#include <media/NdkImage.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#define LOG_TAG "VideoFileSource"
+#include "logging.h"
+
+namespace {
+
+// Images the reader may hand out at once, and images rendered but not yet
+// consumed: one in the consumer, one being filled by the decoder
+const int kReaderImages = 2;
+const int kMaxInFlight = 2;
+const int64_t kDequeueTimeoutUs = 10000;
+// A rendered frame the reader never announces (a decoder dropping it) is
+// written off after this long instead of stalling the run
+const std::chrono::milliseconds kFlightTimeout(1000);
+
+// MediaCodecInfo.CodecCapabilities color formats of buffer output
+const int32_t kColorFormatYuv420Planar = 19;      // I420
+const int32_t kColorFormatYuv420SemiPlanar = 21;  // NV12
+
+bool writeAll(int fd, const uint8_t* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOGE("❌ Edge map write failed: %s", strerror(errno));
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+} // namespace
+
+VideoFileSource::~VideoFileSource() {
+    close();
+}
+
+bool VideoFileSource::open(int fd, int64_t offset, int64_t length) {
+    close();
+    if (length <= 0) {
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size <= offset) {
+            LOGE("❌ Cannot size video fd %d: %s", fd, strerror(errno));
+            return false;
+        }
+        length = info.st_size - offset;
+    }
+    extractor = AMediaExtractor_new();
+    if (!extractor || AMediaExtractor_setDataSourceFd(extractor, fd, offset, length) != AMEDIA_OK) {
+        LOGE("❌ AMediaExtractor cannot read fd %d", fd);
+        close();
+        return false;
+    }
+    const size_t tracks = AMediaExtractor_getTrackCount(extractor);
+    for (size_t i = 0; i < tracks && !trackFormat; i++) {
+        AMediaFormat* format = AMediaExtractor_getTrackFormat(extractor, i);
+        const char* mime = nullptr;
+        if (format && AMediaFormat_getString(format, AMEDIAFORMAT_KEY_MIME, &mime) && mime &&
+            std::strncmp(mime, "video/", 6) == 0) {
+            AMediaExtractor_selectTrack(extractor, i);
+            trackFormat = format;
+        } else if (format) {
+            AMediaFormat_delete(format);
+        }
+    }
+    if (!trackFormat || !AMediaFormat_getInt32(trackFormat, AMEDIAFORMAT_KEY_WIDTH, &frameWidth) ||
+        !AMediaFormat_getInt32(trackFormat, AMEDIAFORMAT_KEY_HEIGHT, &frameHeight) ||
+        frameWidth <= 0 || frameHeight <= 0) {
+        LOGE("❌ No decodable video track in fd %d", fd);
+        close();
+        return false;
+    }
+    frameRotation = 0;
+    AMediaFormat_getInt32(trackFormat, "rotation-degrees", &frameRotation);
+    LOGI("✅ Video track: %dx%d, rotation %d", frameWidth, frameHeight, frameRotation);
+    return true;
+}
+
+void VideoFileSource::close() {
+    stopDecoder();
+    if (trackFormat) {
+        AMediaFormat_delete(trackFormat);
+        trackFormat = nullptr;
+    }
+    if (extractor) {
+        AMediaExtractor_delete(extractor);
+        extractor = nullptr;
+    }
+    frameWidth = 0;
+    frameHeight = 0;
+}
+
+bool VideoFileSource::startDecoder(bool toReader) {
+    const char* mime = nullptr;
+    AMediaFormat_getString(trackFormat, AMEDIAFORMAT_KEY_MIME, &mime);
+    codec = mime ? AMediaCodec_createDecoderByType(mime) : nullptr;
+    if (!codec) {
+        LOGE("❌ No decoder for %s", mime ? mime : "(no mime)");
+        return false;
+    }
+    ANativeWindow* window = nullptr;
+    if (toReader) {
+        if (AImageReader_new(frameWidth, frameHeight, AIMAGE_FORMAT_YUV_420_888, kReaderImages, &reader) !=
+            AMEDIA_OK) {
+            reader = nullptr;
+            stopDecoder();
+            return false;
+        }
+        imageListener.context = this;
+        imageListener.onImageAvailable = &VideoFileSource::onImageAvailable;
+        AImageReader_setImageListener(reader, &imageListener);
+        AImageReader_getWindow(reader, &window);
+    }
+    if (AMediaCodec_configure(codec, trackFormat, window, nullptr, 0) != AMEDIA_OK ||
+        AMediaCodec_start(codec) != AMEDIA_OK) {
+        LOGW("⚠️ Decoder rejected %s output", toReader ? "ImageReader" : "buffer");
+        stopDecoder();
+        return false;
+    }
+    colorFormat = 0;
+    outputWidth = frameWidth;
+    outputHeight = frameHeight;
+    stride = 0;
+    sliceHeight = 0;
+    return true;
+}
+
+void VideoFileSource::stopDecoder() {
+    if (codec) {
+        AMediaCodec_stop(codec);
+        AMediaCodec_delete(codec);
+        codec = nullptr;
+    }
+    if (reader) {
+        AImageReader_delete(reader);
+        reader = nullptr;
+    }
+}
+
+VideoDecodeReport VideoFileSource::run(const Consumer& consumer, int maxFrames, const std::atomic<bool>* cancel) {
+    VideoDecodeReport report;
+    if (!extractor || !trackFormat) {
+        return report;
+    }
+    AMediaExtractor_seekTo(extractor, 0, AMEDIAEXTRACTOR_SEEK_CLOSEST_SYNC);
+    {
+        std::lock_guard<std::mutex> lock(flightMutex);
+        activeConsumer = &consumer;
+        inFlight = 0;
+        delivered = 0;
+    }
+    if (!startDecoder(true) && !startDecoder(false)) {
+        activeConsumer = nullptr;
+        return report;
+    }
+    const bool toReader = reader != nullptr;
+    LOGI("🔄 Decoding video to %s", toReader ? "an ImageReader" : "output buffers");
+
+    const int64_t start = monotonicMicros();
+    bool inputDone = false;
+    bool outputDone = false;
+    int frames = 0;
+    while (!outputDone && !(cancel && cancel->load(std::memory_order_relaxed))) {
+        if (!inputDone) {
+            ssize_t index = AMediaCodec_dequeueInputBuffer(codec, 0);
+            if (index >= 0) {
+                size_t capacity = 0;
+                uint8_t* buffer = AMediaCodec_getInputBuffer(codec, static_cast<size_t>(index), &capacity);
+                ssize_t size = buffer ? AMediaExtractor_readSampleData(extractor, buffer, capacity) : -1;
+                if (size < 0) {
+                    AMediaCodec_queueInputBuffer(codec, static_cast<size_t>(index), 0, 0, 0,
+                                                 AMEDIACODEC_BUFFER_FLAG_END_OF_STREAM);
+                    inputDone = true;
+                } else {
+                    AMediaCodec_queueInputBuffer(codec, static_cast<size_t>(index), 0, static_cast<size_t>(size),
+                                                 static_cast<uint64_t>(AMediaExtractor_getSampleTime(extractor)), 0);
+                    AMediaExtractor_advance(extractor);
+                }
+            }
+        }
+
+        AMediaCodecBufferInfo info;
+        ssize_t index = AMediaCodec_dequeueOutputBuffer(codec, &info, kDequeueTimeoutUs);
+        if (index == AMEDIACODEC_INFO_OUTPUT_FORMAT_CHANGED) {
+            AMediaFormat* format = AMediaCodec_getOutputFormat(codec);
+            AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_COLOR_FORMAT, &colorFormat);
+            AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_STRIDE, &stride);
+            AMediaFormat_getInt32(format, "slice-height", &sliceHeight);
+            int32_t right = 0;
+            int32_t bottom = 0;
+            if (AMediaFormat_getInt32(format, "crop-right", &right) &&
+                AMediaFormat_getInt32(format, "crop-bottom", &bottom)) {
+                outputWidth = right + 1;
+                outputHeight = bottom + 1;
+            } else {
+                AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_WIDTH, &outputWidth);
+                AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_HEIGHT, &outputHeight);
+            }
+            AMediaFormat_delete(format);
+            continue;
+        }
+        if (index < 0) {
+            continue;  // try again later, or output buffers changed
+        }
+        const bool end = (info.flags & AMEDIACODEC_BUFFER_FLAG_END_OF_STREAM) != 0;
+        const bool frame = info.size > 0 || (toReader && !end);
+        if (frame && toReader) {
+            {
+                std::unique_lock<std::mutex> lock(flightMutex);
+                if (!flightChanged.wait_for(lock, kFlightTimeout, [this] { return inFlight < kMaxInFlight; })) {
+                    LOGW_RATELIMITED("⚠️ Decoded frame never reached the reader, skipping it");
+                    inFlight--;
+                }
+                inFlight++;
+            }
+            AMediaCodec_releaseOutputBuffer(codec, static_cast<size_t>(index), true);
+        } else if (frame) {
+            size_t size = 0;
+            uint8_t* data = AMediaCodec_getOutputBuffer(codec, static_cast<size_t>(index), &size);
+            YuvPlanes planes;
+            if (data && static_cast<size_t>(info.offset) + info.size <= size &&
+                bufferPlanes(data + info.offset, static_cast<size_t>(info.size), planes)) {
+                consumer(planes);
+                std::lock_guard<std::mutex> lock(flightMutex);
+                delivered++;
+            } else {
+                LOGE_RATELIMITED("❌ Unsupported decoder output: color format %d", colorFormat);
+            }
+            AMediaCodec_releaseOutputBuffer(codec, static_cast<size_t>(index), false);
+        } else {
+            AMediaCodec_releaseOutputBuffer(codec, static_cast<size_t>(index), false);
+        }
+        frames += frame ? 1 : 0;
+        outputDone = end || (maxFrames > 0 && frames >= maxFrames);
+    }
+
+    {
+        // Frames still on their way through the reader
+        std::unique_lock<std::mutex> lock(flightMutex);
+        flightChanged.wait_for(lock, kFlightTimeout, [this] { return inFlight <= 0; });
+        activeConsumer = nullptr;
+        report.frames = delivered;
+    }
+    stopDecoder();
+    report.seconds = static_cast<double>(monotonicMicros() - start) / 1e6;
+    report.framesPerSecond = report.seconds > 0.0 ? report.frames / report.seconds : 0.0;
+    LOGI("✅ Decoded %d frames in %.2fs (%.1f fps)", report.frames, report.seconds, report.framesPerSecond);
+    return report;
+}
+
+void VideoFileSource::onImageAvailable(void* context, AImageReader* reader) {
+    auto* source = static_cast<VideoFileSource*>(context);
+    AImage* image = nullptr;
+    if (AImageReader_acquireNextImage(reader, &image) != AMEDIA_OK || !image) {
+        return;
+    }
+    source->handleImage(image);
+    AImage_delete(image);
+    {
+        std::lock_guard<std::mutex> lock(source->flightMutex);
+        source->inFlight = std::max(0, source->inFlight - 1);
+    }
+    source->flightChanged.notify_one();
+}
+
+void VideoFileSource::handleImage(AImage* image) {
+    int32_t planeCount = 0;
+    AImage_getNumberOfPlanes(image, &planeCount);
+    if (planeCount < 3 || !activeConsumer) {
+        return;
+    }
+    uint8_t* data[3] = {nullptr, nullptr, nullptr};
+    int length = 0;
+    for (int i = 0; i < 3; i++) {
+        AImage_getPlaneData(image, i, &data[i], &length);
+    }
+    YuvPlanes planes;
+    AImage_getWidth(image, &planes.width);
+    AImage_getHeight(image, &planes.height);
+    AImage_getPlaneRowStride(image, 0, &planes.yRowStride);
+    AImage_getPlaneRowStride(image, 1, &planes.uvRowStride);
+    AImage_getPlanePixelStride(image, 1, &planes.uvPixelStride);
+
+    // Decoders pad to their macroblock size (1080 -> 1088): keep the visible part
+    AImageCropRect crop;
+    int left = 0;
+    int top = 0;
+    if (AImage_getCropRect(image, &crop) == AMEDIA_OK && crop.right > crop.left && crop.bottom > crop.top) {
+        left = crop.left & ~1;
+        top = crop.top & ~1;
+        planes.width = std::min(planes.width - left, crop.right - left) & ~1;
+        planes.height = std::min(planes.height - top, crop.bottom - top) & ~1;
+    }
+    const size_t chromaOffset = static_cast<size_t>(top / 2) * planes.uvRowStride +
+                                static_cast<size_t>(left / 2) * planes.uvPixelStride;
+    planes.y = data[0] + static_cast<size_t>(top) * planes.yRowStride + left;
+    planes.u = data[1] + chromaOffset;
+    planes.v = data[2] + chromaOffset;
+    planes.timestampNs = 0;  // presentation time is not CLOCK_BOOTTIME: latency counts from decode
+
+    (*activeConsumer)(planes);
+    std::lock_guard<std::mutex> lock(flightMutex);
+    delivered++;
+}
+
+bool VideoFileSource::bufferPlanes(const uint8_t* data, size_t size, YuvPlanes& planes) const {
+    const int rowStride = stride > 0 ? stride : outputWidth;
+    const int rows = sliceHeight > 0 ? sliceHeight : outputHeight;
+    const size_t lumaBytes = static_cast<size_t>(rowStride) * rows;
+    planes.width = outputWidth & ~1;
+    planes.height = outputHeight & ~1;
+    planes.y = data;
+    planes.yRowStride = rowStride;
+    planes.timestampNs = 0;
+    if (colorFormat == kColorFormatYuv420SemiPlanar) {
+        planes.u = data + lumaBytes;
+        planes.v = planes.u + 1;
+        planes.uvRowStride = rowStride;
+        planes.uvPixelStride = 2;
+        return lumaBytes + static_cast<size_t>(rowStride) * (planes.height / 2) <= size;
+    }
+    if (colorFormat == kColorFormatYuv420Planar) {
+        const size_t chromaBytes = static_cast<size_t>(rowStride / 2) * (rows / 2);
+        planes.u = data + lumaBytes;
+        planes.v = planes.u + chromaBytes;
+        planes.uvRowStride = rowStride / 2;
+        planes.uvPixelStride = 1;
+        return lumaBytes + chromaBytes + static_cast<size_t>(rowStride / 2) * (planes.height / 2) <= size;
+    }
+    return false;
+}
+
+namespace {
+
+// Luma of up to batchFrames frames, tightly packed, and their edge maps
+struct EdgeBatch {
+    std::vector<uint8_t> luma;
+    std::vector<int64_t> offsets;
+    std::vector<uint8_t> edges;
+    int count = 0;
+};
+
+} // namespace
+
+int decodeVideoEdges(VideoFileSource& source, BatchParams params, int batchFrames, int outputFd,
+                     const std::atomic<bool>* cancel) {
+    params.width = source.width() & ~1;
+    params.height = source.height() & ~1;
+    const size_t edgeBytes = batchOutputFrameBytes(params);
+    if (edgeBytes == 0 || batchFrames <= 0 || outputFd < 0) {
+        return -1;
+    }
+    const size_t lumaBytes = static_cast<size_t>(params.width) * params.height;
+    EdgeBatch batches[2];
+    for (EdgeBatch& batch : batches) {
+        batch.luma.resize(lumaBytes * batchFrames);
+        batch.edges.resize(edgeBytes * batchFrames);
+        batch.offsets.resize(static_cast<size_t>(batchFrames));
+        for (int i = 0; i < batchFrames; i++) {
+            batch.offsets[i] = static_cast<int64_t>(lumaBytes) * i;
+        }
+    }
+
+    std::atomic<bool> failed{false};
+    std::atomic<int> written{0};
+    auto processBatch = [&](EdgeBatch* batch) {
+        if (failed.load() || batch->count == 0) {
+            return;
+        }
+        int done = processEdgeBatch(batch->luma.data(), batch->offsets.data(), batch->count, params,
+                                    batch->edges.data());
+        if (done != batch->count || !writeAll(outputFd, batch->edges.data(), edgeBytes * done)) {
+            failed.store(true);
+            return;
+        }
+        written.fetch_add(done);
+    };
+
+    // Batch k runs on its own thread while the consumer fills batch k + 1;
+    // joining before each hand-off keeps both buffers exclusive and the output
+    // in frame order
+    std::thread running;
+    int filling = 0;
+    auto consumer = [&](const YuvPlanes& planes) {
+        if (planes.width != params.width || planes.height != params.height) {
+            LOGW_RATELIMITED("⚠️ %dx%d frame in a %dx%d video, skipped", planes.width, planes.height,
+                             params.width, params.height);
+            return;
+        }
+        EdgeBatch& batch = batches[filling];
+        uint8_t* destination = batch.luma.data() + lumaBytes * batch.count;
+        for (int y = 0; y < planes.height; y++) {
+            std::memcpy(destination + static_cast<size_t>(y) * planes.width,
+                        planes.y + static_cast<size_t>(y) * planes.yRowStride, static_cast<size_t>(planes.width));
+        }
+        if (++batch.count == batchFrames) {
+            if (running.joinable()) {
+                running.join();
+            }
+            running = std::thread(processBatch, &batch);
+            filling ^= 1;
+            batches[filling].count = 0;
+        }
+    };
+    source.run(consumer, 0, cancel);
+    if (running.joinable()) {
+        running.join();
+    }
+    processBatch(&batches[filling]);  // the partial last batch
+    return failed.load() ? -1 : written.load();
+}
@@ -0,0 +1,91 @@
+#ifndef EDGE_VIDEO_FILE_SOURCE_H
+#define EDGE_VIDEO_FILE_SOURCE_H
+
+#include "batch_processor.h"
+#include "frame_ingest.h"
+#include <media/NdkImageReader.h>
+#include <media/NdkMediaCodec.h>
+#include <media/NdkMediaExtractor.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+struct VideoDecodeReport {
+    int frames = 0;          // frames handed to the consumer
+    double seconds = 0.0;    // wall time of the run
+    double framesPerSecond = 0.0;
+};
+
+// Recorded video as a frame source: AMediaExtractor feeds the first video
+// track to a hardware AMediaCodec decoder that renders into an AImageReader,
+// so decoded frames reach the consumer as YUV_420_888 planes of the decoder's
+// own buffers (no copy). Ingest is double-buffered: the decoder fills the
+// next image while the consumer still holds the current one, and waits when
+// both are taken, so no frame is dropped and decode overlaps processing.
+// Decoders without ImageReader output fall back to their output buffers
+// (NV12/I420, consumed on the decoding thread, without the overlap).
+class VideoFileSource {
+public:
+    // Called once per frame, in presentation order, on the reader's thread;
+    // the planes are only valid for the duration of the call
+    using Consumer = std::function<void(const YuvPlanes&)>;
+
+    ~VideoFileSource();
+
+    // Opens [offset, offset + length) of fd (length <= 0: to the end) and
+    // selects its first video track. The fd stays owned by the caller.
+    bool open(int fd, int64_t offset, int64_t length);
+    void close();
+
+    int width() const { return frameWidth; }
+    int height() const { return frameHeight; }
+    int rotation() const { return frameRotation; }  // container rotation, clockwise degrees
+
+    // Decodes up to maxFrames frames (<= 0: all) on the calling thread, as
+    // fast as consumer returns; cancel (may be null) stops between frames
+    VideoDecodeReport run(const Consumer& consumer, int maxFrames, const std::atomic<bool>* cancel);
+
+private:
+    static void onImageAvailable(void* context, AImageReader* reader);
+    void handleImage(AImage* image);
+    bool startDecoder(bool toReader);
+    void stopDecoder();
+    // Buffer output: builds planes from the codec's output format
+    bool bufferPlanes(const uint8_t* data, size_t size, YuvPlanes& planes) const;
+
+    AMediaExtractor* extractor = nullptr;
+    AMediaFormat* trackFormat = nullptr;    // owned; the selected track
+    AMediaCodec* codec = nullptr;
+    AImageReader* reader = nullptr;
+    AImageReader_ImageListener imageListener{};
+    int frameWidth = 0;
+    int frameHeight = 0;
+    int frameRotation = 0;
+
+    // Buffer output geometry (AMEDIACODEC_INFO_OUTPUT_FORMAT_CHANGED)
+    int colorFormat = 0;
+    int outputWidth = 0;     // visible part (crop rectangle)
+    int outputHeight = 0;
+    int stride = 0;
+    int sliceHeight = 0;
+
+    // Images rendered to the reader and not yet consumed
+    const Consumer* activeConsumer = nullptr;
+    std::mutex flightMutex;
+    std::condition_variable flightChanged;
+    int inFlight = 0;
+    int delivered = 0;
+};
+
+// Offline variant on the batch API (batch_processor.h): decodes every frame of
+// source, gathers their luma into batches of batchFrames and runs
+// processEdgeBatch on a second thread over one batch while the decoder fills
+// the next. Edge maps are appended to outputFd in frame order, each
+// batchOutputFrameBytes(params) bytes (params.width/height are taken from the
+// source). Returns the number of maps written, or -1 on a write or OpenCV error.
+int decodeVideoEdges(VideoFileSource& source, BatchParams params, int batchFrames, int outputFd,
+                     const std::atomic<bool>* cancel);
+
+#endif // EDGE_VIDEO_FILE_SOURCE_H
@@ -0,0 +1,244 @@
+#include "video_recorder.h"
+#include "tracing.h"
+#include <media/NdkMediaCodec.h>
+#include <media/NdkMediaFormat.h>
+#include <media/NdkMediaMuxer.h>
+#include <android/native_window.h>
+#include <chrono>
+#include <dlfcn.h>
+#include <unistd.h>
+
+#define LOG_TAG "VideoRecorder"
+#include "logging.h"
+
+namespace {
+
+// MediaCodecInfo.CodecCapabilities.COLOR_FormatSurface
+const int32_t kColorFormatSurface = 0x7F000789;
+const int32_t kKeyFrameIntervalSeconds = 1;
+const int64_t kDrainTimeoutUs = 10000;
+// How long stop() waits for the end-of-stream buffer before giving up
+const auto kEndOfStreamTimeout = std::chrono::seconds(2);
+
+// EGL_ANDROID_recordable
+const EGLint kEglRecordableAndroid = 0x3142;
+
+struct EncoderSurfaceApi {
+    media_status_t (*createInputSurface)(AMediaCodec*, ANativeWindow**) = nullptr;
+    media_status_t (*signalEndOfInputStream)(AMediaCodec*) = nullptr;
+    EGLBoolean (*presentationTime)(EGLDisplay, EGLSurface, int64_t) = nullptr;  // EGL_ANDROID_presentation_time
+
+    bool available() const { return createInputSurface && signalEndOfInputStream; }
+};
+
+const EncoderSurfaceApi& encoderSurfaceApi() {
+    static const EncoderSurfaceApi api = [] {
+        EncoderSurfaceApi loaded;
+        void* library = dlopen("libmediandk.so", RTLD_NOW);
+        if (library) {
+            loaded.createInputSurface = reinterpret_cast<decltype(loaded.createInputSurface)>(
+                    dlsym(library, "AMediaCodec_createInputSurface"));
+            loaded.signalEndOfInputStream = reinterpret_cast<decltype(loaded.signalEndOfInputStream)>(
+                    dlsym(library, "AMediaCodec_signalEndOfInputStream"));
+        }
+        loaded.presentationTime = reinterpret_cast<decltype(loaded.presentationTime)>(
+                eglGetProcAddress("eglPresentationTimeANDROID"));
+        if (!loaded.available()) {
+            LOGW("⚠️ Encoder input surfaces unavailable (API < 26), recording disabled");
+        }
+        return loaded;
+    }();
+    return api;
+}
+
+} // namespace
+
+EGLConfig currentConfig(EGLDisplay display, EGLContext context) {
+    EGLint id = 0;
+    if (!eglQueryContext(display, context, EGL_CONFIG_ID, &id)) {
+        return nullptr;
+    }
+    const EGLint attributes[] = {EGL_CONFIG_ID, id, EGL_NONE};
+    EGLConfig config = nullptr;
+    EGLint count = 0;
+    if (!eglChooseConfig(display, attributes, &config, 1, &count) || count < 1) {
+        return nullptr;
+    }
+    return config;
+}
+
+VideoRecorder::~VideoRecorder() {
+    stop();
+}
+
+bool VideoRecorder::start(int outputFd, const RecorderConfig& config) {
+    stop();
+    const EncoderSurfaceApi& api = encoderSurfaceApi();
+    if (!api.available() || outputFd < 0 || config.width <= 0 || config.height <= 0) {
+        return false;
+    }
+    display = eglGetCurrentDisplay();
+    context = eglGetCurrentContext();
+    EGLConfig eglConfig = context != EGL_NO_CONTEXT ? currentConfig(display, context) : nullptr;
+    if (!eglConfig) {
+        LOGE("❌ Recording needs the GL thread with its context current");
+        return false;
+    }
+    EGLint recordable = 0;
+    if (!eglGetConfigAttrib(display, eglConfig, kEglRecordableAndroid, &recordable) || !recordable) {
+        LOGW("⚠️ EGL config is not EGL_RECORDABLE_ANDROID; the encoder surface may be refused");
+    }
+
+    // Encoders want even dimensions (most want multiples of 16)
+    width = config.width & ~1;
+    height = config.height & ~1;
+    const char* mime = config.hevc ? "video/hevc" : "video/avc";
+    codec = AMediaCodec_createEncoderByType(mime);
+    if (!codec) {
+        LOGE("❌ No %s encoder", mime);
+        return false;
+    }
+    AMediaFormat* format = AMediaFormat_new();
+    AMediaFormat_setString(format, AMEDIAFORMAT_KEY_MIME, mime);
+    AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_WIDTH, width);
+    AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_HEIGHT, height);
+    AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_BIT_RATE, config.bitrate);
+    AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_FRAME_RATE, config.frameRate);
+    AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_I_FRAME_INTERVAL, kKeyFrameIntervalSeconds);
+    AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_COLOR_FORMAT, kColorFormatSurface);
+    media_status_t status = AMediaCodec_configure(codec, format, nullptr, nullptr,
+                                                  AMEDIACODEC_CONFIGURE_FLAG_ENCODE);
+    AMediaFormat_delete(format);
+    if (status != AMEDIA_OK || api.createInputSurface(codec, &window) != AMEDIA_OK || !window) {
+        LOGE("❌ Encoder setup failed for %dx%d %s (%d)", width, height, mime, status);
+        stop();
+        return false;
+    }
+
+    const EGLint surfaceAttributes[] = {EGL_NONE};
+    surface = eglCreateWindowSurface(display, eglConfig, window, surfaceAttributes);
+    if (surface == EGL_NO_SURFACE) {
+        LOGE("❌ eglCreateWindowSurface failed for the encoder: 0x%x", eglGetError());
+        stop();
+        return false;
+    }
+    fd = dup(outputFd);
+    muxer = fd >= 0 ? AMediaMuxer_new(fd, AMEDIAMUXER_OUTPUT_FORMAT_MPEG_4) : nullptr;
+    if (!muxer || AMediaCodec_start(codec) != AMEDIA_OK) {
+        LOGE("❌ Could not start the encoder or muxer");
+        stop();
+        return false;
+    }
+    ending.store(false);
+    drainThread = std::thread(&VideoRecorder::drain, this);
+    LOGI("✅ Recording %dx%d %s at %d bps", width, height, mime, config.bitrate);
+    return true;
+}
+
+void VideoRecorder::stop() {
+    if (drainThread.joinable()) {
+        ending.store(true);
+        encoderSurfaceApi().signalEndOfInputStream(codec);
+        drainThread.join();
+        AMediaCodec_stop(codec);
+        LOGI("✅ Recording finished");
+    }
+    if (surface != EGL_NO_SURFACE) {
+        eglDestroySurface(display, surface);
+        surface = EGL_NO_SURFACE;
+    }
+    if (window) {
+        ANativeWindow_release(window);
+        window = nullptr;
+    }
+    if (codec) {
+        AMediaCodec_delete(codec);
+        codec = nullptr;
+    }
+    if (muxer) {
+        AMediaMuxer_delete(muxer);
+        muxer = nullptr;
+    }
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+}
+
+bool VideoRecorder::beginFrame(int& frameWidth, int& frameHeight) {
+    if (surface == EGL_NO_SURFACE) {
+        return false;
+    }
+    savedDraw = eglGetCurrentSurface(EGL_DRAW);
+    savedRead = eglGetCurrentSurface(EGL_READ);
+    if (!eglMakeCurrent(display, surface, surface, context)) {
+        LOGE_RATELIMITED("eglMakeCurrent(encoder) failed: 0x%x", eglGetError());
+        return false;
+    }
+    frameWidth = width;
+    frameHeight = height;
+    return true;
+}
+
+void VideoRecorder::endFrame(int64_t timestampNs) {
+    if (encoderSurfaceApi().presentationTime) {
+        encoderSurfaceApi().presentationTime(display, surface, timestampNs);
+    }
+    // Blocks only if the encoder has no free input buffer
+    {
+        ScopedTrace trace("encoder_swap");
+        eglSwapBuffers(display, surface);
+    }
+    if (!eglMakeCurrent(display, savedDraw, savedRead, context)) {
+        LOGE_RATELIMITED("eglMakeCurrent(window) failed: 0x%x", eglGetError());
+    }
+}
+
+// Encoded buffers go to the muxer once the encoder has reported its output
+// format (which carries the codec config); it ends at end-of-stream
+void VideoRecorder::drain() {
+    ssize_t track = -1;
+    auto deadline = std::chrono::steady_clock::time_point::max();
+    while (true) {
+        if (deadline == std::chrono::steady_clock::time_point::max() && ending.load()) {
+            deadline = std::chrono::steady_clock::now() + kEndOfStreamTimeout;
+        }
+        if (std::chrono::steady_clock::now() > deadline) {
+            LOGW("⚠️ Encoder did not signal end of stream; the recording may be truncated");
+            break;
+        }
+        AMediaCodecBufferInfo info;
+        ssize_t index = AMediaCodec_dequeueOutputBuffer(codec, &info, kDrainTimeoutUs);
+        if (index == AMEDIACODEC_INFO_OUTPUT_FORMAT_CHANGED) {
+            AMediaFormat* format = AMediaCodec_getOutputFormat(codec);
+            track = AMediaMuxer_addTrack(muxer, format);
+            AMediaFormat_delete(format);
+            if (track < 0 || AMediaMuxer_start(muxer) != AMEDIA_OK) {
+                LOGE("❌ Muxer rejected the encoder output format");
+                track = -1;
+            }
+            continue;
+        }
+        if (index < 0) {
+            continue;  // try again later / output buffers changed
+        }
+        size_t capacity = 0;
+        uint8_t* data = AMediaCodec_getOutputBuffer(codec, index, &capacity);
+        bool config = (info.flags & AMEDIACODEC_BUFFER_FLAG_CODEC_CONFIG) != 0;
+        if (data && track >= 0 && !config && info.size > 0) {
+            AMediaMuxer_writeSampleData(muxer, static_cast<size_t>(track), data + info.offset, &info);
+        }
+        AMediaCodec_releaseOutputBuffer(codec, index, false);
+        if (info.flags & AMEDIACODEC_BUFFER_FLAG_END_OF_STREAM) {
+            break;
+        }
+    }
+    if (track >= 0) {
+        AMediaMuxer_stop(muxer);
+    }
+}
+
+VideoRecorder& videoRecorder() {
+    static thread_local VideoRecorder recorder;
+    return recorder;
+}
@@ -0,0 +1,75 @@
+#ifndef EDGE_VIDEO_RECORDER_H
+#define EDGE_VIDEO_RECORDER_H
+
+#include <EGL/egl.h>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+struct AMediaCodec;
+struct AMediaMuxer;
+struct ANativeWindow;
+
+struct RecorderConfig {
+    int width = 1280;
+    int height = 720;
+    int bitrate = 8000000;   // bits per second
+    int frameRate = 30;
+    bool hevc = false;       // H.264 otherwise
+};
+
+// Hardware-encoded recording of what the renderer draws. The AMediaCodec
+// encoder's input surface becomes an EGL window surface of the GL thread's
+// own context, so the renderer draws each frame a second time straight into
+// it: no readback and no CPU pixel copies. Encoded output is drained into an
+// MP4 (AMediaMuxer) on a thread of its own.
+//
+// The input surface calls are API 26 and resolved at runtime (minSdk is 24);
+// start() fails without them. GL thread only, with the context current.
+class VideoRecorder {
+public:
+    ~VideoRecorder();
+
+    // fd: a writable file, duplicated here; false if the encoder or its
+    // surface cannot be set up
+    bool start(int fd, const RecorderConfig& config);
+
+    // Ends the stream and finalizes the file; blocks until the encoder drained
+    void stop();
+
+    bool isRecording() const { return surface != EGL_NO_SURFACE; }
+
+    // Makes the encoder surface current for the second draw; false (nothing
+    // changed) when not recording
+    bool beginFrame(int& width, int& height);
+
+    // Stamps and submits the frame, then restores the window surface
+    void endFrame(int64_t timestampNs);
+
+private:
+    void drain();
+
+    AMediaCodec* codec = nullptr;
+    AMediaMuxer* muxer = nullptr;
+    ANativeWindow* window = nullptr;
+    EGLDisplay display = EGL_NO_DISPLAY;
+    EGLContext context = EGL_NO_CONTEXT;
+    EGLSurface surface = EGL_NO_SURFACE;
+    EGLSurface savedDraw = EGL_NO_SURFACE;
+    EGLSurface savedRead = EGL_NO_SURFACE;
+    int fd = -1;
+    int width = 0;
+    int height = 0;
+
+    std::thread drainThread;
+    std::atomic<bool> ending{false};
+};
+
+// The calling GL thread's recorder (renderer state is per GL thread)
+VideoRecorder& videoRecorder();
+
+// The config of context, which a window surface must match to be made
+// current with it (the encoder's, a display mirror's); null if unknown
+EGLConfig currentConfig(EGLDisplay display, EGLContext context);
+
+#endif // EDGE_VIDEO_RECORDER_H
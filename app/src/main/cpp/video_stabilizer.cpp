@@ -0,0 +1,86 @@
+#include "video_stabilizer.h"
+#include <opencv2/calib3d.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const int kMinPairs = 12;           // fewer tracked points do not make a trustworthy fit
+const double kMaxRotation = 0.1;    // rad, about 6 degrees of correction at most
+const double kMaxLogScale = 0.05;   // about 5 % of zoom correction at most
+const double kRansacThreshold = 2.0; // px: moving objects and bad tracks fall outside
+
+double clamp(double value, double limit) {
+    return std::max(-limit, std::min(limit, value));
+}
+
+}  // namespace
+
+void VideoStabilizer::setParams(const Params& params) {
+    std::lock_guard<std::mutex> lock(mutex);
+    current = params;
+    current.smoothing = std::min(std::max(params.smoothing, 0.0f), 0.99f);
+    current.maxCorrection = std::min(std::max(params.maxCorrection, 0.0f), 0.25f);
+}
+
+void VideoStabilizer::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    tracker.reset();
+    trajectorySize = cv::Size();
+}
+
+cv::Matx23f VideoStabilizer::update(const cv::Mat& luma) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (luma.size() != trajectorySize) {
+        tracker.reset();
+        trajectory = cv::Vec4d();
+        smoothed = cv::Vec4d();
+        trajectorySize = luma.size();
+    }
+
+    vectors.create(std::max(1, 2 * tracker.capacity()), 1, CV_32FC2);
+    const int pairs = tracker.track(luma, vectors);
+    if (pairs >= kMinPairs) {
+        from.resize(static_cast<size_t>(pairs));
+        to.resize(static_cast<size_t>(pairs));
+        for (int i = 0; i < pairs; i++) {
+            from[static_cast<size_t>(i)] = vectors.at<cv::Point2f>(2 * i);
+            to[static_cast<size_t>(i)] = vectors.at<cv::Point2f>(2 * i + 1);
+        }
+        const cv::Mat motion = cv::estimateAffinePartial2D(from, to, inliers, cv::RANSAC, kRansacThreshold);
+        if (!motion.empty()) {
+            const double a = motion.at<double>(0, 0);
+            const double b = motion.at<double>(1, 0);
+            trajectory += cv::Vec4d(motion.at<double>(0, 2), motion.at<double>(1, 2), std::atan2(b, a),
+                                    std::log(std::hypot(a, b)));
+        }
+    }
+
+    // The view follows the smoothed path; what separates the two is shake
+    const double keep = current.smoothing;
+    smoothed = keep * smoothed + (1.0 - keep) * trajectory;
+    const double margin = current.maxCorrection;
+    cv::Vec4d correction = smoothed - trajectory;
+    correction[0] = clamp(correction[0], margin * luma.cols);
+    correction[1] = clamp(correction[1], margin * luma.rows);
+    correction[2] = clamp(correction[2], kMaxRotation);
+    correction[3] = clamp(correction[3], kMaxLogScale);
+    smoothed = trajectory + correction;  // a clamped path must not drift away and lag behind
+
+    // Rotation and scale about the frame centre, the zoom hiding the borders
+    // the shift uncovers, then the shift
+    const double scale = std::exp(correction[3]) * (1.0 + 2.0 * margin);
+    const double cosine = scale * std::cos(correction[2]);
+    const double sine = scale * std::sin(correction[2]);
+    const double cx = 0.5 * luma.cols;
+    const double cy = 0.5 * luma.rows;
+    return cv::Matx23f(static_cast<float>(cosine), static_cast<float>(-sine),
+                       static_cast<float>(cx - cosine * cx + sine * cy + correction[0]),
+                       static_cast<float>(sine), static_cast<float>(cosine),
+                       static_cast<float>(cy - sine * cx - cosine * cy + correction[1]));
+}
+
+VideoStabilizer& videoStabilizer() {
+    static VideoStabilizer stabilizer;
+    return stabilizer;
+}
@@ -0,0 +1,54 @@
+#ifndef EDGE_VIDEO_STABILIZER_H
+#define EDGE_VIDEO_STABILIZER_H
+
+#include "optical_flow.h"
+#include <opencv2/core.hpp>
+#include <mutex>
+#include <vector>
+
+// Handheld shake removal. Sparse points are tracked from frame to frame
+// (a PointTracker of its own), each frame's motion is fitted as a similarity
+// (cv::estimateAffinePartial2D: shift, rotation, uniform scale, RANSAC) and
+// summed into the camera's trajectory, and an exponential moving average of
+// that trajectory is the path the view follows. The result is only the 2x3
+// correction taking this frame onto the smoothed path; the renderer applies
+// it to the vertices of the frame quad, so no pixel is warped on the CPU.
+// The correction is clamped to maxCorrection and includes a zoom of the same
+// amount, so the moved frame keeps covering the view.
+class VideoStabilizer {
+public:
+    struct Params {
+        float smoothing = 0.9f;      // 0..1: share of the smoothed path kept per frame; higher is steadier
+        float maxCorrection = 0.08f; // largest shift, as a share of the frame side; also the zoom margin
+    };
+
+    void setParams(const Params& params);
+
+    // Tracks luma (CV_8UC1) against the previous frame and returns the
+    // correction in its pixels. Identity on the first frame and after reset();
+    // a frame with too few tracked points counts as not moving.
+    cv::Matx23f update(const cv::Mat& luma);
+
+    // Starts a new trajectory at the next frame
+    void reset();
+
+private:
+    std::mutex mutex;
+    Params current;
+    PointTracker tracker;
+    // Camera trajectory and its smoothed version: x, y (px), angle (rad),
+    // log of the scale
+    cv::Vec4d trajectory;
+    cv::Vec4d smoothed;
+    cv::Size trajectorySize;
+    // Scratch reused across frames
+    cv::Mat vectors;
+    std::vector<cv::Point2f> from;
+    std::vector<cv::Point2f> to;
+    std::vector<uchar> inliers;
+};
+
+// Stabilizer used by the STABILIZE render mode
+VideoStabilizer& videoStabilizer();
+
+#endif // EDGE_VIDEO_STABILIZER_H
@@ -0,0 +1,334 @@
+#include "visual_odometry.h"
+#include "kernel_dispatch.h"
+#include "lens_undistortion.h"
+#include "metrics.h"
+#include <opencv2/calib3d.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+
+#define LOG_TAG "VisualOdometry"
+#include "logging.h"
+
+namespace {
+
+const int kDescriptorBytes = 32;          // ORB's 256 bits, what hammingDistances takes
+const int kOrbLevels = 3;                 // frame-to-frame motion needs little scale range
+const float kRatioTest = 0.8f;            // best distance against the second best in the window
+const float kMinParallax = 1.0f;          // median reduced pixels moved since the keyframe
+const double kRansacProbability = 0.999;
+const double kRansacThreshold = 1.0;      // reduced pixels
+const int kRansacIterations = 500;
+
+}  // namespace
+
+VisualOdometry::VisualOdometry() {
+    orb = cv::ORB::create(2 * current.gridCols * current.gridRows * current.perCell, 1.2f, kOrbLevels);
+}
+
+void VisualOdometry::setParams(const Params& params) {
+    std::lock_guard<std::mutex> lock(mutex);
+    current = params;
+    current.frameWidth = std::min(std::max(params.frameWidth, 160), 1280);
+    current.gridCols = std::min(std::max(params.gridCols, 1), 32);
+    current.gridRows = std::min(std::max(params.gridRows, 1), 32);
+    current.perCell = std::min(std::max(params.perCell, 1), kMaxFeatures / (current.gridCols * current.gridRows));
+    current.perCell = std::max(current.perCell, 1);
+    current.searchRadius = std::min(std::max(params.searchRadius, 4), 128);
+    current.maxDistance = std::min(std::max(params.maxDistance, 1), 8 * kDescriptorBytes);
+    current.poseEveryFrames = std::max(1, params.poseEveryFrames);
+    current.minInliers = std::max(params.minInliers, 8);
+    current.fieldOfView = std::min(std::max(params.fieldOfView, 20.0f), 150.0f);
+    // Twice the grid's budget: dense cells give up their surplus to the cap
+    orb->setMaxFeatures(2 * std::min(current.gridCols * current.gridRows * current.perCell, kMaxFeatures));
+    resetLocked();
+}
+
+VisualOdometry::Pose VisualOdometry::pose() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return estimate;
+}
+
+void VisualOdometry::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    resetLocked();
+}
+
+void VisualOdometry::resetLocked() {
+    estimate = Pose();
+    hasPrevious = false;
+    sinceKeyframe = 0;
+    previousPoints.clear();
+    previousOrigins.clear();
+    previousFromKeyframe.clear();
+    previousDescriptors.release();
+}
+
+// Grid-bucketed ORB keypoints of image and their descriptors into points /
+// descriptors; compute() drops keypoints too near the border to describe
+void VisualOdometry::detectLocked(const cv::Mat& image) {
+    orb->detect(image, keypoints);
+    order.resize(keypoints.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = static_cast<int>(i);
+    }
+    std::sort(order.begin(), order.end(), [this](int a, int b) {
+        return keypoints[static_cast<size_t>(a)].response > keypoints[static_cast<size_t>(b)].response;
+    });
+    cellCounts.assign(static_cast<size_t>(current.gridCols * current.gridRows), 0);
+    const float cellWidth = static_cast<float>(image.cols) / current.gridCols;
+    const float cellHeight = static_cast<float>(image.rows) / current.gridRows;
+    kept.clear();
+    for (int index : order) {
+        const cv::Point2f& pt = keypoints[static_cast<size_t>(index)].pt;
+        const int cx = std::min(current.gridCols - 1, static_cast<int>(pt.x / cellWidth));
+        const int cy = std::min(current.gridRows - 1, static_cast<int>(pt.y / cellHeight));
+        int& cell = cellCounts[static_cast<size_t>(cy * current.gridCols + cx)];
+        if (cell < current.perCell) {
+            cell++;
+            kept.push_back(keypoints[static_cast<size_t>(index)]);
+        }
+    }
+    orb->compute(image, kept, descriptors);
+    points.resize(kept.size());
+    for (size_t i = 0; i < kept.size(); i++) {
+        points[i] = kept[i].pt;
+    }
+}
+
+// Bin index of the previous frame's keypoints, bins searchRadius wide so a
+// window never spans more than 3x3 of them
+void VisualOdometry::indexLocked() {
+    const int size = current.searchRadius;
+    binColumns = 1;
+    binRows = 1;
+    for (const cv::Point2f& pt : previousPoints) {
+        binColumns = std::max(binColumns, static_cast<int>(pt.x) / size + 1);
+        binRows = std::max(binRows, static_cast<int>(pt.y) / size + 1);
+    }
+    auto binOf = [this, size](const cv::Point2f& pt) {
+        return static_cast<size_t>((static_cast<int>(pt.y) / size) * binColumns + static_cast<int>(pt.x) / size);
+    };
+    binStarts.assign(static_cast<size_t>(binColumns * binRows + 1), 0);
+    for (const cv::Point2f& pt : previousPoints) {
+        binStarts[binOf(pt) + 1]++;
+    }
+    for (size_t b = 1; b < binStarts.size(); b++) {
+        binStarts[b] += binStarts[b - 1];
+    }
+    binEntries.resize(previousPoints.size());
+    std::vector<int> fill(binStarts.begin(), binStarts.end() - 1);
+    for (size_t i = 0; i < previousPoints.size(); i++) {
+        binEntries[static_cast<size_t>(fill[binOf(previousPoints[i])]++)] = static_cast<int32_t>(i);
+    }
+}
+
+// previousOf[i]: the previous keypoint matched to keypoint i, -1 = none.
+// Each keypoint takes its nearest descriptor within the window when it
+// passes the ratio test; a previous keypoint claimed twice keeps the
+// closer claim.
+void VisualOdometry::matchLocked(std::vector<int>& previousOf) {
+    const EdgeKernels& kernels = edgeKernels();
+    const int radius = current.searchRadius;
+    const float radiusSquared = static_cast<float>(radius * radius);
+    previousOf.assign(points.size(), -1);
+    std::vector<int> owner(previousPoints.size(), -1);
+    std::vector<int> ownerDistance(previousPoints.size(), 0);
+    uint64_t evaluated = 0;
+    for (size_t i = 0; i < points.size(); i++) {
+        const cv::Point2f& pt = points[i];
+        const int bx0 = std::max(0, static_cast<int>(pt.x) / radius - 1);
+        const int by0 = std::max(0, static_cast<int>(pt.y) / radius - 1);
+        const int bx1 = std::min(binColumns - 1, static_cast<int>(pt.x) / radius + 1);
+        const int by1 = std::min(binRows - 1, static_cast<int>(pt.y) / radius + 1);
+        candidates.clear();
+        for (int by = by0; by <= by1; by++) {
+            for (int bx = bx0; bx <= bx1; bx++) {
+                const int bin = by * binColumns + bx;
+                for (int k = binStarts[static_cast<size_t>(bin)]; k < binStarts[static_cast<size_t>(bin) + 1]; k++) {
+                    const int32_t j = binEntries[static_cast<size_t>(k)];
+                    const cv::Point2f d = previousPoints[static_cast<size_t>(j)] - pt;
+                    if (d.x * d.x + d.y * d.y <= radiusSquared) {
+                        candidates.push_back(j);
+                    }
+                }
+            }
+        }
+        if (candidates.empty()) {
+            continue;
+        }
+        candidateDistances.resize(candidates.size());
+        kernels.hammingDistances(descriptors.ptr(static_cast<int>(i)), previousDescriptors.data,
+                                 previousDescriptors.step, candidates.data(), static_cast<int>(candidates.size()),
+                                 candidateDistances.data());
+        evaluated += candidates.size();
+        int best = -1;
+        int bestDistance = 8 * kDescriptorBytes + 1;
+        int secondDistance = 8 * kDescriptorBytes + 1;
+        for (size_t k = 0; k < candidates.size(); k++) {
+            const int distance = candidateDistances[k];
+            if (distance < bestDistance) {
+                secondDistance = bestDistance;
+                bestDistance = distance;
+                best = candidates[k];
+            } else if (distance < secondDistance) {
+                secondDistance = distance;
+            }
+        }
+        if (bestDistance > current.maxDistance || bestDistance >= kRatioTest * secondDistance) {
+            continue;
+        }
+        const size_t j = static_cast<size_t>(best);
+        if (owner[j] >= 0) {
+            if (ownerDistance[j] <= bestDistance) {
+                continue;
+            }
+            previousOf[static_cast<size_t>(owner[j])] = -1;
+        }
+        owner[j] = static_cast<int>(i);
+        ownerDistance[j] = bestDistance;
+        previousOf[i] = best;
+    }
+    distances.fetch_add(evaluated, std::memory_order_relaxed);
+}
+
+// Relative pose of the current frame against the keyframe from the
+// keypoints tracked since then; on success (or when too few are left to
+// ever succeed) the current frame becomes the keyframe
+void VisualOdometry::estimateLocked(const cv::Size& size) {
+    std::vector<cv::Point2f> from;
+    std::vector<cv::Point2f> to;
+    std::vector<float> moved;
+    for (size_t i = 0; i < points.size(); i++) {
+        if (fromKeyframe[i]) {
+            from.push_back(origins[i]);
+            to.push_back(points[i]);
+            moved.push_back(static_cast<float>(cv::norm(points[i] - origins[i])));
+        }
+    }
+    bool promote = static_cast<int>(from.size()) < current.minInliers;
+    if (!promote) {
+        // Too little parallax for the essential matrix: keep the keyframe
+        // and let the baseline grow
+        std::nth_element(moved.begin(), moved.begin() + moved.size() / 2, moved.end());
+        if (moved[moved.size() / 2] < kMinParallax) {
+            return;
+        }
+        cv::Matx33d camera;
+        LensCalibration calibration;
+        if (lensUndistortion().currentCalibration(calibration)) {
+            camera = scaledCameraMatrix(calibration, size);
+        } else {
+            const double focal = 0.5 * size.width / std::tan(0.5 * current.fieldOfView * CV_PI / 180.0);
+            camera = cv::Matx33d(focal, 0.0, 0.5 * (size.width - 1), 0.0, focal, 0.5 * (size.height - 1), 0.0, 0.0,
+                                 1.0);
+        }
+        try {
+            cv::Mat inliers;
+            const cv::Mat essential = cv::findEssentialMat(from, to, camera, cv::RANSAC, kRansacProbability,
+                                                           kRansacThreshold, kRansacIterations, inliers);
+            int count = 0;
+            cv::Mat rotation;
+            cv::Mat translation;
+            if (essential.rows >= 3) {
+                // Several solutions come stacked; the first is RANSAC's best
+                count = cv::recoverPose(essential.rowRange(0, 3), from, to, camera, rotation, translation, inliers);
+            }
+            if (count >= current.minInliers) {
+                // recoverPose maps keyframe camera coordinates to the
+                // current frame's: X' = R X + t
+                const cv::Matx33d step(rotation);
+                const cv::Vec3d direction(translation);
+                estimate.rotation = estimate.rotation * step.t();
+                estimate.position -= estimate.rotation * direction;
+                estimate.inliers = count;
+                estimate.estimates++;
+                estimates.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                rejected.fetch_add(1, std::memory_order_relaxed);
+            }
+        } catch (const cv::Exception& e) {
+            LOGE_RATELIMITED("❌ Pose estimate failed: %s", e.what());
+            rejected.fetch_add(1, std::memory_order_relaxed);
+        }
+        promote = true;
+    }
+    if (promote) {
+        origins = points;
+        fromKeyframe.assign(points.size(), 1);
+        sinceKeyframe = 0;
+    }
+}
+
+int VisualOdometry::update(const cv::Mat& luma, cv::Mat& matches) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (luma.empty()) {
+        return 0;
+    }
+    ScopedStageTimer timer(Stage::ODOMETRY);
+    cv::Mat image = luma;
+    if (luma.cols > current.frameWidth) {
+        const int height = std::max(1, cvRound(static_cast<double>(luma.rows) * current.frameWidth / luma.cols));
+        cv::resize(luma, reduced, cv::Size(current.frameWidth, height), 0, 0, cv::INTER_AREA);
+        image = reduced;
+    }
+    try {
+        detectLocked(image);
+    } catch (const cv::Exception& e) {
+        LOGE_RATELIMITED("❌ ORB failed: %s", e.what());
+        points.clear();
+        descriptors.release();
+    }
+
+    std::vector<int> previousOf;
+    if (hasPrevious && !previousPoints.empty() && !points.empty()) {
+        matchLocked(previousOf);
+    } else {
+        previousOf.assign(points.size(), -1);
+    }
+    origins.resize(points.size());
+    fromKeyframe.resize(points.size());
+    const float scale = static_cast<float>(luma.cols) / image.cols;
+    const int capacity = std::min(matches.rows / 2, kMaxFeatures);
+    int count = 0;
+    for (size_t i = 0; i < points.size(); i++) {
+        const int j = previousOf[i];
+        if (!hasPrevious) {
+            origins[i] = points[i];     // the first frame is the keyframe
+            fromKeyframe[i] = 1;
+        } else if (j < 0) {
+            origins[i] = points[i];
+            fromKeyframe[i] = 0;        // new since the keyframe
+        } else {
+            origins[i] = previousOrigins[static_cast<size_t>(j)];
+            fromKeyframe[i] = previousFromKeyframe[static_cast<size_t>(j)];
+            if (count < capacity) {
+                // Back to pixel centres of the luma
+                const cv::Point2f& from = previousPoints[static_cast<size_t>(j)];
+                matches.at<cv::Point2f>(2 * count) = cv::Point2f((from.x + 0.5f) * scale - 0.5f,
+                                                                 (from.y + 0.5f) * scale - 0.5f);
+                matches.at<cv::Point2f>(2 * count + 1) = cv::Point2f((points[i].x + 0.5f) * scale - 0.5f,
+                                                                     (points[i].y + 0.5f) * scale - 0.5f);
+                count++;
+            }
+        }
+    }
+    matched.fetch_add(static_cast<uint64_t>(count), std::memory_order_relaxed);
+
+    if (hasPrevious && ++sinceKeyframe >= current.poseEveryFrames) {
+        estimateLocked(image.size());
+    }
+
+    std::swap(previousPoints, points);
+    std::swap(previousOrigins, origins);
+    std::swap(previousFromKeyframe, fromKeyframe);
+    cv::swap(previousDescriptors, descriptors);
+    hasPrevious = true;
+    indexLocked();
+    return count;
+}
+
+VisualOdometry& visualOdometry() {
+    static VisualOdometry odometry;
+    return odometry;
+}
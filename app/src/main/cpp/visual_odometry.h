@@ -0,0 +1,123 @@
+#ifndef EDGE_VISUAL_ODOMETRY_H
+#define EDGE_VISUAL_ODOMETRY_H
+
+#include <opencv2/core.hpp>
+#include <opencv2/features2d.hpp>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Monocular frame-to-frame visual odometry. Each frame is reduced to
+// frameWidth and ORB keypoints are bucketed into a grid (the strongest
+// perCell per cell) before their descriptors are computed. Every keypoint
+// is matched only against the previous frame's keypoints within
+// searchRadius, found through a bin index of that frame, by the dispatched
+// SIMD Hamming kernel (kernel_dispatch.h hammingDistances): a few dozen
+// distances per keypoint where BFMatcher computes them all. Matches carry
+// each keypoint's position in the keyframe along, so every poseEveryFrames
+// frames cv::findEssentialMat and cv::recoverPose see the motion since the
+// keyframe rather than a single frame's parallax, and the keyframe moves to
+// the current frame. Intrinsics come from the lens calibration when one is
+// loaded (lens_undistortion.h), otherwise from fieldOfView; either way the
+// luma is taken to be the whole frame. Monocular translation has no scale:
+// each estimate advances the position by one unit along its direction.
+class VisualOdometry {
+public:
+    struct Params {
+        int frameWidth = 480;      // reduced luma width features are detected at
+        int gridCols = 8;
+        int gridRows = 6;
+        int perCell = 8;           // keypoints kept per grid cell
+        int searchRadius = 24;     // reduced pixels a keypoint may move between frames
+        int maxDistance = 64;      // Hamming distance a match may have (of 256 bits)
+        int poseEveryFrames = 5;   // frames between pose estimates
+        int minInliers = 20;       // essential matrix inliers an estimate needs
+        float fieldOfView = 66.0f; // horizontal, degrees; without a lens calibration
+    };
+
+    // Camera relative to the first frame (or the last reset): rotation
+    // takes camera axes to those of the first frame, position is in
+    // estimate steps
+    struct Pose {
+        cv::Matx33d rotation = cv::Matx33d::eye();
+        cv::Vec3d position;
+        int inliers = 0;           // of the newest estimate
+        uint64_t estimates = 0;    // since the reset; 0 = rotation and position are the origin
+    };
+
+    // Cap on gridCols * gridRows * perCell, and so on the matches per frame
+    static const int kMaxFeatures = 1024;
+
+    VisualOdometry();
+
+    void setParams(const Params& params);
+
+    // Processing thread, once per frame of the mode, on luma (CV_8UC1).
+    // Writes the frame's matches as (previous, current) pixel pairs of luma
+    // into the first rows of matches (CV_32FC2, at least 2 * kMaxFeatures
+    // rows) and returns how many pairs were written
+    int update(const cv::Mat& luma, cv::Mat& matches);
+
+    Pose pose();
+
+    // Forgets the previous frame and the pose; the next frame is the origin
+    void reset();
+
+    uint64_t matchCount() const { return matched.load(std::memory_order_relaxed); }
+    uint64_t distanceCount() const { return distances.load(std::memory_order_relaxed); }
+    uint64_t estimateCount() const { return estimates.load(std::memory_order_relaxed); }
+    uint64_t rejectedCount() const { return rejected.load(std::memory_order_relaxed); }
+
+private:
+    void resetLocked();
+    void detectLocked(const cv::Mat& image);
+    void matchLocked(std::vector<int>& previousOf);
+    void indexLocked();
+    void estimateLocked(const cv::Size& size);
+
+    std::mutex mutex;
+    Params current;
+    cv::Ptr<cv::ORB> orb;
+    Pose estimate;
+
+    // The current frame's keypoints, and the previous frame's as matched
+    // against: position, descriptor row, position in the keyframe and
+    // whether it was seen there
+    std::vector<cv::Point2f> points;
+    cv::Mat descriptors;
+    std::vector<cv::Point2f> origins;
+    std::vector<uint8_t> fromKeyframe;
+    std::vector<cv::Point2f> previousPoints;
+    cv::Mat previousDescriptors;
+    std::vector<cv::Point2f> previousOrigins;
+    std::vector<uint8_t> previousFromKeyframe;
+    bool hasPrevious = false;
+    int sinceKeyframe = 0;
+
+    // Bins of searchRadius over the previous frame: bin b holds
+    // binEntries[binStarts[b] .. binStarts[b + 1])
+    int binColumns = 0;
+    int binRows = 0;
+    std::vector<int> binStarts;
+    std::vector<int32_t> binEntries;
+
+    // Processing-thread scratch
+    cv::Mat reduced;
+    std::vector<cv::KeyPoint> keypoints;
+    std::vector<cv::KeyPoint> kept;
+    std::vector<int> order;
+    std::vector<int> cellCounts;
+    std::vector<int32_t> candidates;
+    std::vector<uint16_t> candidateDistances;
+
+    std::atomic<uint64_t> matched{0};
+    std::atomic<uint64_t> distances{0};
+    std::atomic<uint64_t> estimates{0};
+    std::atomic<uint64_t> rejected{0};
+};
+
+// Odometry used by the ODOMETRY render mode
+VisualOdometry& visualOdometry();
+
+#endif // EDGE_VISUAL_ODOMETRY_H
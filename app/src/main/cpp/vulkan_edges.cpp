@@ -0,0 +1,1270 @@
+#include "vulkan_edges.h"
+#include "hardware_frames.h"
+#include "render_frame.h"
+
+#if defined(EDGE_VULKAN_COMPUTE)
+#define VK_NO_PROTOTYPES
+#define VK_USE_PLATFORM_ANDROID_KHR
+#include <vulkan/vulkan.h>
+#include <android/hardware_buffer.h>
+#include <dlfcn.h>
+#include <cstring>
+#include <mutex>
+#include <vector>
+#endif
+
+#define LOG_TAG "VulkanEdges"
+#include "logging.h"
+
+#if defined(EDGE_VULKAN_COMPUTE)
+
+namespace {
+
+const uint32_t kLocalSize = 16;             // local_size_x/y of shaders/edge_*.comp
+const int kHysteresisIterations = 6;        // growth steps before the resolve dispatch
+const size_t kMaxSharedSlots = 6;           // output buffers; the renderer holds up to ~5 at once
+const uint64_t kFenceTimeoutNs = 500000000; // a frame the GPU has not finished by then is dropped
+
+// SPIR-V words generated by glslc -mfmt=num at build time
+const uint32_t kBlurSpv[] = {
+#include "edge_blur.spv.inc"
+};
+const uint32_t kSobelSpv[] = {
+#include "edge_sobel.spv.inc"
+};
+const uint32_t kNmsSpv[] = {
+#include "edge_nms.spv.inc"
+};
+const uint32_t kHysteresisSpv[] = {
+#include "edge_hysteresis.spv.inc"
+};
+
+// The shaders' push_constant block
+struct PushConstants {
+    int32_t width;
+    int32_t height;
+    float low;
+    float high;
+    int32_t resolve;
+};
+
+#define EDGE_VK_INSTANCE_FUNCTIONS(X) \
+    X(vkDestroyInstance) \
+    X(vkEnumeratePhysicalDevices) \
+    X(vkGetPhysicalDeviceProperties) \
+    X(vkGetPhysicalDeviceQueueFamilyProperties) \
+    X(vkGetPhysicalDeviceMemoryProperties) \
+    X(vkGetPhysicalDeviceFeatures2) \
+    X(vkEnumerateDeviceExtensionProperties) \
+    X(vkCreateDevice) \
+    X(vkGetDeviceProcAddr)
+
+#define EDGE_VK_DEVICE_FUNCTIONS(X) \
+    X(vkDestroyDevice) \
+    X(vkGetDeviceQueue) \
+    X(vkDeviceWaitIdle) \
+    X(vkQueueSubmit) \
+    X(vkCreateCommandPool) \
+    X(vkDestroyCommandPool) \
+    X(vkAllocateCommandBuffers) \
+    X(vkResetCommandBuffer) \
+    X(vkBeginCommandBuffer) \
+    X(vkEndCommandBuffer) \
+    X(vkCreateFence) \
+    X(vkDestroyFence) \
+    X(vkResetFences) \
+    X(vkWaitForFences) \
+    X(vkCreateImage) \
+    X(vkDestroyImage) \
+    X(vkCreateImageView) \
+    X(vkDestroyImageView) \
+    X(vkGetImageMemoryRequirements) \
+    X(vkBindImageMemory) \
+    X(vkCreateBuffer) \
+    X(vkDestroyBuffer) \
+    X(vkGetBufferMemoryRequirements) \
+    X(vkBindBufferMemory) \
+    X(vkAllocateMemory) \
+    X(vkFreeMemory) \
+    X(vkMapMemory) \
+    X(vkCreateSampler) \
+    X(vkDestroySampler) \
+    X(vkCreateSamplerYcbcrConversion) \
+    X(vkDestroySamplerYcbcrConversion) \
+    X(vkCreateShaderModule) \
+    X(vkDestroyShaderModule) \
+    X(vkCreateDescriptorSetLayout) \
+    X(vkDestroyDescriptorSetLayout) \
+    X(vkCreatePipelineLayout) \
+    X(vkDestroyPipelineLayout) \
+    X(vkCreateComputePipelines) \
+    X(vkDestroyPipeline) \
+    X(vkCreateDescriptorPool) \
+    X(vkDestroyDescriptorPool) \
+    X(vkAllocateDescriptorSets) \
+    X(vkUpdateDescriptorSets) \
+    X(vkCmdPipelineBarrier) \
+    X(vkCmdBindPipeline) \
+    X(vkCmdBindDescriptorSets) \
+    X(vkCmdPushConstants) \
+    X(vkCmdDispatch) \
+    X(vkCmdCopyImage) \
+    X(vkCmdCopyBufferToImage) \
+    X(vkGetAndroidHardwareBufferPropertiesANDROID)
+
+#define EDGE_VK_DECLARE(name) PFN_##name name = nullptr;
+
+struct VulkanApi {
+    PFN_vkGetInstanceProcAddr vkGetInstanceProcAddr = nullptr;
+    PFN_vkEnumerateInstanceVersion vkEnumerateInstanceVersion = nullptr;
+    PFN_vkCreateInstance vkCreateInstance = nullptr;
+    EDGE_VK_INSTANCE_FUNCTIONS(EDGE_VK_DECLARE)
+    EDGE_VK_DEVICE_FUNCTIONS(EDGE_VK_DECLARE)
+};
+
+#undef EDGE_VK_DECLARE
+
+struct Image {
+    VkImage image = VK_NULL_HANDLE;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkImageView view = VK_NULL_HANDLE;
+};
+
+// One output buffer of the ring; free while only the ring references image
+struct SharedSlot {
+    std::shared_ptr<SharedEdgeImage> image;
+    Image target;  // the buffer imported as a transfer destination
+};
+
+VkImageMemoryBarrier imageBarrier(VkImage image, VkAccessFlags srcAccess, VkAccessFlags dstAccess,
+                                  VkImageLayout from, VkImageLayout to,
+                                  uint32_t srcQueue = VK_QUEUE_FAMILY_IGNORED,
+                                  uint32_t dstQueue = VK_QUEUE_FAMILY_IGNORED) {
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask = srcAccess;
+    barrier.dstAccessMask = dstAccess;
+    barrier.oldLayout = from;
+    barrier.newLayout = to;
+    barrier.srcQueueFamilyIndex = srcQueue;
+    barrier.dstQueueFamilyIndex = dstQueue;
+    barrier.image = image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.layerCount = 1;
+    return barrier;
+}
+
+class VulkanEdgeContext {
+public:
+    ~VulkanEdgeContext() { destroy(); }
+
+    bool init();
+    bool cameraImport() const { return ycbcrSupported; }
+    std::shared_ptr<const SharedEdgeImage> detectLuma(const cv::Mat& luma, float low, float high);
+    std::shared_ptr<const SharedEdgeImage> detectCamera(AHardwareBuffer* camera, float low, float high);
+
+private:
+    bool selectDevice();
+    bool createDevice();
+    bool createPipelines();
+    VkPipeline createPipeline(const uint32_t* code, size_t bytes, VkPipelineLayout layout);
+    bool createSetLayout(bool withSampler, const VkSampler* immutableSampler, VkDescriptorSetLayout& layout);
+    bool createPipelineLayout(VkDescriptorSetLayout setLayout, VkPipelineLayout& layout);
+    int memoryType(uint32_t typeBits, VkMemoryPropertyFlags flags) const;
+    bool createImage(VkFormat format, VkImageUsageFlags usage, int width, int height, Image& out,
+                     const VkComponentMapping* swizzle = nullptr);
+    bool importBuffer(AHardwareBuffer* buffer, VkFormat format, uint64_t externalFormat, VkImageUsageFlags usage,
+                      int width, int height, VkSamplerYcbcrConversion conversion, Image& out);
+    void destroyImage(Image& image);
+    bool ensureTargets(int width, int height);
+    bool ensureLumaInput(int width, int height);
+    bool ensureCameraPipeline(const VkAndroidHardwareBufferFormatPropertiesANDROID& format);
+    void destroyCameraPipeline();
+    SharedSlot* acquireSlot(int width, int height);
+    void destroySlot(SharedSlot& slot);
+    void writeStorage(VkDescriptorSet set, uint32_t binding, VkImageView view);
+    void writeSampled(VkDescriptorSet set, VkImageView view);
+    void dispatch(VkPipeline pipeline, VkPipelineLayout layout, VkDescriptorSet set, const PushConstants& push);
+    void computeBarrier();
+    void recordEdgePasses(VkPipeline blur, VkPipelineLayout blurLayout, VkDescriptorSet blurSet,
+                          SharedSlot& slot, float low, float high);
+    bool begin();
+    bool submitAndWait();
+    void destroy();
+
+    VulkanApi vk;
+    void* library = nullptr;
+    VkInstance instance = VK_NULL_HANDLE;
+    VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+    VkPhysicalDeviceMemoryProperties memoryProperties{};
+    uint32_t queueFamily = 0;
+    bool ycbcrSupported = false;
+    VkDevice device = VK_NULL_HANDLE;
+    VkQueue queue = VK_NULL_HANDLE;
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    VkCommandBuffer cmd = VK_NULL_HANDLE;
+    VkFence fence = VK_NULL_HANDLE;
+
+    // binding 0 source, 1 target, 2 RGBA edges (sobel, nms, hysteresis)
+    VkDescriptorSetLayout storageSetLayout = VK_NULL_HANDLE;
+    VkPipelineLayout storageLayout = VK_NULL_HANDLE;
+    // binding 0 sampled input, 1 blurred output
+    VkSampler lumaSampler = VK_NULL_HANDLE;
+    VkDescriptorSetLayout lumaSetLayout = VK_NULL_HANDLE;
+    VkPipelineLayout lumaLayout = VK_NULL_HANDLE;
+    VkPipeline lumaBlurPipeline = VK_NULL_HANDLE;
+    VkPipeline sobelPipeline = VK_NULL_HANDLE;
+    VkPipeline nmsPipeline = VK_NULL_HANDLE;
+    VkPipeline hysteresisPipeline = VK_NULL_HANDLE;
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    VkDescriptorSet lumaBlurSet = VK_NULL_HANDLE;
+    VkDescriptorSet sobelSet = VK_NULL_HANDLE;
+    VkDescriptorSet nmsSet = VK_NULL_HANDLE;
+    VkDescriptorSet hysteresisSets[2] = {VK_NULL_HANDLE, VK_NULL_HANDLE};  // state 0 -> 1, state 1 -> 0
+
+    // Camera input: the Y'CbCr sampler is immutable in its set layout, so the
+    // blur pipeline is built per camera buffer format
+    uint64_t cameraExternalFormat = 0;
+    VkFormat cameraFormat = VK_FORMAT_UNDEFINED;
+    bool cameraPipelineBuilt = false;
+    VkSamplerYcbcrConversion cameraConversion = VK_NULL_HANDLE;
+    VkSampler cameraSampler = VK_NULL_HANDLE;
+    VkDescriptorSetLayout cameraSetLayout = VK_NULL_HANDLE;
+    VkPipelineLayout cameraLayout = VK_NULL_HANDLE;
+    VkPipeline cameraBlurPipeline = VK_NULL_HANDLE;
+    VkDescriptorPool cameraPool = VK_NULL_HANDLE;
+    VkDescriptorSet cameraBlurSet = VK_NULL_HANDLE;
+
+    int width = 0;
+    int height = 0;
+    Image blur;           // R32F
+    Image gradient;       // R32UI magnitude | sector << 16
+    Image states[2];      // R32UI 0 none, 1 weak, 2 strong
+    Image edges;          // RGBA8 resolve, copied into the slot
+
+    int lumaWidth = 0;
+    int lumaHeight = 0;
+    Image lumaImage;      // R8, sampled as .g through the swizzle
+    VkBuffer staging = VK_NULL_HANDLE;
+    VkDeviceMemory stagingMemory = VK_NULL_HANDLE;
+    uint8_t* stagingData = nullptr;
+
+    std::vector<SharedSlot> slots;
+    uint64_t nextId = 1;
+};
+
+bool VulkanEdgeContext::init() {
+    if (!hardwareBufferApi().available()) {
+        LOGI("AHardwareBuffer unavailable (API < 26), no Vulkan edges");
+        return false;
+    }
+    library = dlopen("libvulkan.so", RTLD_NOW | RTLD_LOCAL);
+    if (!library) {
+        LOGI("libvulkan.so unavailable, no Vulkan edges");
+        return false;
+    }
+    vk.vkGetInstanceProcAddr = reinterpret_cast<PFN_vkGetInstanceProcAddr>(dlsym(library, "vkGetInstanceProcAddr"));
+    if (!vk.vkGetInstanceProcAddr) {
+        return false;
+    }
+    vk.vkEnumerateInstanceVersion = reinterpret_cast<PFN_vkEnumerateInstanceVersion>(
+            vk.vkGetInstanceProcAddr(VK_NULL_HANDLE, "vkEnumerateInstanceVersion"));
+    vk.vkCreateInstance = reinterpret_cast<PFN_vkCreateInstance>(
+            vk.vkGetInstanceProcAddr(VK_NULL_HANDLE, "vkCreateInstance"));
+    uint32_t version = VK_API_VERSION_1_0;
+    if (vk.vkEnumerateInstanceVersion) {
+        vk.vkEnumerateInstanceVersion(&version);
+    }
+    if (!vk.vkCreateInstance || version < VK_API_VERSION_1_1) {
+        LOGI("Vulkan instance below 1.1, no Vulkan edges");
+        return false;
+    }
+
+    VkApplicationInfo app{};
+    app.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+    app.pApplicationName = "edge";
+    app.apiVersion = VK_API_VERSION_1_1;
+    VkInstanceCreateInfo instanceInfo{};
+    instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+    instanceInfo.pApplicationInfo = &app;
+    if (vk.vkCreateInstance(&instanceInfo, nullptr, &instance) != VK_SUCCESS) {
+        LOGW("⚠️ vkCreateInstance failed");
+        return false;
+    }
+#define EDGE_VK_LOAD(name) \
+    vk.name = reinterpret_cast<PFN_##name>(vk.vkGetInstanceProcAddr(instance, #name)); \
+    if (!vk.name) { LOGW("⚠️ Missing %s", #name); return false; }
+    EDGE_VK_INSTANCE_FUNCTIONS(EDGE_VK_LOAD)
+#undef EDGE_VK_LOAD
+
+    if (!selectDevice() || !createDevice() || !createPipelines()) {
+        return false;
+    }
+    VkPhysicalDeviceProperties properties;
+    vk.vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    LOGI("✅ Vulkan edges on %s (camera import %d)", properties.deviceName, ycbcrSupported);
+    return true;
+}
+
+// First device with Vulkan 1.1, a compute queue and AHardwareBuffer import
+bool VulkanEdgeContext::selectDevice() {
+    uint32_t count = 0;
+    vk.vkEnumeratePhysicalDevices(instance, &count, nullptr);
+    std::vector<VkPhysicalDevice> devices(count);
+    vk.vkEnumeratePhysicalDevices(instance, &count, devices.data());
+    for (VkPhysicalDevice candidate : devices) {
+        VkPhysicalDeviceProperties properties;
+        vk.vkGetPhysicalDeviceProperties(candidate, &properties);
+        if (properties.apiVersion < VK_API_VERSION_1_1) {
+            continue;
+        }
+        uint32_t extensionCount = 0;
+        vk.vkEnumerateDeviceExtensionProperties(candidate, nullptr, &extensionCount, nullptr);
+        std::vector<VkExtensionProperties> extensions(extensionCount);
+        vk.vkEnumerateDeviceExtensionProperties(candidate, nullptr, &extensionCount, extensions.data());
+        bool hardwareBuffers = false;
+        bool foreignQueue = false;
+        for (const VkExtensionProperties& extension : extensions) {
+            hardwareBuffers |= std::strcmp(extension.extensionName,
+                                           VK_ANDROID_EXTERNAL_MEMORY_ANDROID_HARDWARE_BUFFER_EXTENSION_NAME) == 0;
+            foreignQueue |= std::strcmp(extension.extensionName, VK_EXT_QUEUE_FAMILY_FOREIGN_EXTENSION_NAME) == 0;
+        }
+        if (!hardwareBuffers || !foreignQueue) {
+            continue;
+        }
+        uint32_t familyCount = 0;
+        vk.vkGetPhysicalDeviceQueueFamilyProperties(candidate, &familyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> families(familyCount);
+        vk.vkGetPhysicalDeviceQueueFamilyProperties(candidate, &familyCount, families.data());
+        for (uint32_t i = 0; i < familyCount; i++) {
+            if (families[i].queueFlags & VK_QUEUE_COMPUTE_BIT) {
+                physicalDevice = candidate;
+                queueFamily = i;
+                vk.vkGetPhysicalDeviceMemoryProperties(candidate, &memoryProperties);
+                return true;
+            }
+        }
+    }
+    LOGI("No Vulkan 1.1 device with AHardwareBuffer import, no Vulkan edges");
+    return false;
+}
+
+bool VulkanEdgeContext::createDevice() {
+    VkPhysicalDeviceSamplerYcbcrConversionFeatures ycbcr{};
+    ycbcr.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SAMPLER_YCBCR_CONVERSION_FEATURES;
+    VkPhysicalDeviceFeatures2 features{};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &ycbcr;
+    vk.vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+    ycbcrSupported = ycbcr.samplerYcbcrConversion == VK_TRUE;
+    // Only what the passes need
+    VkPhysicalDeviceFeatures2 enabled{};
+    enabled.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    enabled.pNext = &ycbcr;
+
+    const float priority = 1.0f;
+    VkDeviceQueueCreateInfo queueInfo{};
+    queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queueInfo.queueFamilyIndex = queueFamily;
+    queueInfo.queueCount = 1;
+    queueInfo.pQueuePriorities = &priority;
+    // Their dependencies (external memory, dedicated allocation, Y'CbCr
+    // conversion) are core in 1.1
+    const char* extensions[] = {
+            VK_ANDROID_EXTERNAL_MEMORY_ANDROID_HARDWARE_BUFFER_EXTENSION_NAME,
+            VK_EXT_QUEUE_FAMILY_FOREIGN_EXTENSION_NAME,
+    };
+    VkDeviceCreateInfo deviceInfo{};
+    deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    deviceInfo.pNext = &enabled;
+    deviceInfo.queueCreateInfoCount = 1;
+    deviceInfo.pQueueCreateInfos = &queueInfo;
+    deviceInfo.enabledExtensionCount = 2;
+    deviceInfo.ppEnabledExtensionNames = extensions;
+    if (vk.vkCreateDevice(physicalDevice, &deviceInfo, nullptr, &device) != VK_SUCCESS) {
+        LOGW("⚠️ vkCreateDevice failed");
+        return false;
+    }
+#define EDGE_VK_LOAD(name) \
+    vk.name = reinterpret_cast<PFN_##name>(vk.vkGetDeviceProcAddr(device, #name)); \
+    if (!vk.name) { LOGW("⚠️ Missing %s", #name); return false; }
+    EDGE_VK_DEVICE_FUNCTIONS(EDGE_VK_LOAD)
+#undef EDGE_VK_LOAD
+    vk.vkGetDeviceQueue(device, queueFamily, 0, &queue);
+
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    poolInfo.queueFamilyIndex = queueFamily;
+    if (vk.vkCreateCommandPool(device, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
+        return false;
+    }
+    VkCommandBufferAllocateInfo cmdInfo{};
+    cmdInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    cmdInfo.commandPool = commandPool;
+    cmdInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    cmdInfo.commandBufferCount = 1;
+    VkFenceCreateInfo fenceInfo{};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    return vk.vkAllocateCommandBuffers(device, &cmdInfo, &cmd) == VK_SUCCESS &&
+           vk.vkCreateFence(device, &fenceInfo, nullptr, &fence) == VK_SUCCESS;
+}
+
+bool VulkanEdgeContext::createSetLayout(bool withSampler, const VkSampler* immutableSampler,
+                                        VkDescriptorSetLayout& layout) {
+    VkDescriptorSetLayoutBinding bindings[3] = {};
+    for (uint32_t i = 0; i < 3; i++) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+    if (withSampler) {
+        bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        bindings[0].pImmutableSamplers = immutableSampler;
+    }
+    VkDescriptorSetLayoutCreateInfo info{};
+    info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    info.bindingCount = withSampler ? 2 : 3;
+    info.pBindings = bindings;
+    return vk.vkCreateDescriptorSetLayout(device, &info, nullptr, &layout) == VK_SUCCESS;
+}
+
+bool VulkanEdgeContext::createPipelineLayout(VkDescriptorSetLayout setLayout, VkPipelineLayout& layout) {
+    VkPushConstantRange range{};
+    range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    range.size = sizeof(PushConstants);
+    VkPipelineLayoutCreateInfo info{};
+    info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    info.setLayoutCount = 1;
+    info.pSetLayouts = &setLayout;
+    info.pushConstantRangeCount = 1;
+    info.pPushConstantRanges = &range;
+    return vk.vkCreatePipelineLayout(device, &info, nullptr, &layout) == VK_SUCCESS;
+}
+
+VkPipeline VulkanEdgeContext::createPipeline(const uint32_t* code, size_t bytes, VkPipelineLayout layout) {
+    VkShaderModuleCreateInfo moduleInfo{};
+    moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    moduleInfo.codeSize = bytes;
+    moduleInfo.pCode = code;
+    VkShaderModule module = VK_NULL_HANDLE;
+    if (vk.vkCreateShaderModule(device, &moduleInfo, nullptr, &module) != VK_SUCCESS) {
+        return VK_NULL_HANDLE;
+    }
+    VkComputePipelineCreateInfo info{};
+    info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    info.stage.module = module;
+    info.stage.pName = "main";
+    info.layout = layout;
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    if (vk.vkCreateComputePipelines(device, VK_NULL_HANDLE, 1, &info, nullptr, &pipeline) != VK_SUCCESS) {
+        pipeline = VK_NULL_HANDLE;
+    }
+    vk.vkDestroyShaderModule(device, module, nullptr);
+    return pipeline;
+}
+
+bool VulkanEdgeContext::createPipelines() {
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_NEAREST;
+    samplerInfo.minFilter = VK_FILTER_NEAREST;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    if (vk.vkCreateSampler(device, &samplerInfo, nullptr, &lumaSampler) != VK_SUCCESS ||
+        !createSetLayout(false, nullptr, storageSetLayout) || !createPipelineLayout(storageSetLayout, storageLayout) ||
+        !createSetLayout(true, &lumaSampler, lumaSetLayout) || !createPipelineLayout(lumaSetLayout, lumaLayout)) {
+        return false;
+    }
+    lumaBlurPipeline = createPipeline(kBlurSpv, sizeof(kBlurSpv), lumaLayout);
+    sobelPipeline = createPipeline(kSobelSpv, sizeof(kSobelSpv), storageLayout);
+    nmsPipeline = createPipeline(kNmsSpv, sizeof(kNmsSpv), storageLayout);
+    hysteresisPipeline = createPipeline(kHysteresisSpv, sizeof(kHysteresisSpv), storageLayout);
+    if (!lumaBlurPipeline || !sobelPipeline || !nmsPipeline || !hysteresisPipeline) {
+        LOGW("⚠️ Vulkan edge pipelines failed to build");
+        return false;
+    }
+
+    VkDescriptorPoolSize sizes[2] = {};
+    sizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    sizes[0].descriptorCount = 1;
+    sizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    sizes[1].descriptorCount = 1 + 4 * 3;
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = 5;
+    poolInfo.poolSizeCount = 2;
+    poolInfo.pPoolSizes = sizes;
+    if (vk.vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS) {
+        return false;
+    }
+    VkDescriptorSetLayout layouts[5] = {lumaSetLayout, storageSetLayout, storageSetLayout, storageSetLayout,
+                                        storageSetLayout};
+    VkDescriptorSet sets[5];
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = descriptorPool;
+    allocInfo.descriptorSetCount = 5;
+    allocInfo.pSetLayouts = layouts;
+    if (vk.vkAllocateDescriptorSets(device, &allocInfo, sets) != VK_SUCCESS) {
+        return false;
+    }
+    lumaBlurSet = sets[0];
+    sobelSet = sets[1];
+    nmsSet = sets[2];
+    hysteresisSets[0] = sets[3];
+    hysteresisSets[1] = sets[4];
+    return true;
+}
+
+int VulkanEdgeContext::memoryType(uint32_t typeBits, VkMemoryPropertyFlags flags) const {
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+        if ((typeBits & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & flags) == flags) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+bool VulkanEdgeContext::createImage(VkFormat format, VkImageUsageFlags usage, int imageWidth, int imageHeight,
+                                    Image& out, const VkComponentMapping* swizzle) {
+    VkImageCreateInfo info{};
+    info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    info.imageType = VK_IMAGE_TYPE_2D;
+    info.format = format;
+    info.extent = {static_cast<uint32_t>(imageWidth), static_cast<uint32_t>(imageHeight), 1};
+    info.mipLevels = 1;
+    info.arrayLayers = 1;
+    info.samples = VK_SAMPLE_COUNT_1_BIT;
+    info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    info.usage = usage;
+    info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    if (vk.vkCreateImage(device, &info, nullptr, &out.image) != VK_SUCCESS) {
+        return false;
+    }
+    VkMemoryRequirements requirements;
+    vk.vkGetImageMemoryRequirements(device, out.image, &requirements);
+    const int type = memoryType(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = requirements.size;
+    allocInfo.memoryTypeIndex = static_cast<uint32_t>(type);
+    if (type < 0 || vk.vkAllocateMemory(device, &allocInfo, nullptr, &out.memory) != VK_SUCCESS ||
+        vk.vkBindImageMemory(device, out.image, out.memory, 0) != VK_SUCCESS) {
+        return false;
+    }
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.image = out.image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = format;
+    if (swizzle) {
+        viewInfo.components = *swizzle;
+    }
+    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewInfo.subresourceRange.levelCount = 1;
+    viewInfo.subresourceRange.layerCount = 1;
+    return vk.vkCreateImageView(device, &viewInfo, nullptr, &out.view) == VK_SUCCESS;
+}
+
+// Binds buffer's memory to a new image; a view is only made for sampled
+// images (with the Y'CbCr conversion when one is given)
+bool VulkanEdgeContext::importBuffer(AHardwareBuffer* buffer, VkFormat format, uint64_t externalFormat,
+                                     VkImageUsageFlags usage, int imageWidth, int imageHeight,
+                                     VkSamplerYcbcrConversion conversion, Image& out) {
+    VkAndroidHardwareBufferPropertiesANDROID properties{};
+    properties.sType = VK_STRUCTURE_TYPE_ANDROID_HARDWARE_BUFFER_PROPERTIES_ANDROID;
+    if (vk.vkGetAndroidHardwareBufferPropertiesANDROID(device, buffer, &properties) != VK_SUCCESS) {
+        return false;
+    }
+    VkExternalFormatANDROID external{};
+    external.sType = VK_STRUCTURE_TYPE_EXTERNAL_FORMAT_ANDROID;
+    external.externalFormat = externalFormat;
+    VkExternalMemoryImageCreateInfo externalInfo{};
+    externalInfo.sType = VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_IMAGE_CREATE_INFO;
+    externalInfo.pNext = externalFormat != 0 ? &external : nullptr;
+    externalInfo.handleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_ANDROID_HARDWARE_BUFFER_BIT_ANDROID;
+    VkImageCreateInfo info{};
+    info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    info.pNext = &externalInfo;
+    info.imageType = VK_IMAGE_TYPE_2D;
+    info.format = format;
+    info.extent = {static_cast<uint32_t>(imageWidth), static_cast<uint32_t>(imageHeight), 1};
+    info.mipLevels = 1;
+    info.arrayLayers = 1;
+    info.samples = VK_SAMPLE_COUNT_1_BIT;
+    info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    info.usage = usage;
+    info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    if (vk.vkCreateImage(device, &info, nullptr, &out.image) != VK_SUCCESS) {
+        return false;
+    }
+    VkImportAndroidHardwareBufferInfoANDROID importInfo{};
+    importInfo.sType = VK_STRUCTURE_TYPE_IMPORT_ANDROID_HARDWARE_BUFFER_INFO_ANDROID;
+    importInfo.buffer = buffer;
+    VkMemoryDedicatedAllocateInfo dedicated{};
+    dedicated.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+    dedicated.pNext = &importInfo;
+    dedicated.image = out.image;
+    const int type = memoryType(properties.memoryTypeBits, 0);
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.pNext = &dedicated;
+    allocInfo.allocationSize = properties.allocationSize;
+    allocInfo.memoryTypeIndex = static_cast<uint32_t>(type);
+    if (type < 0 || vk.vkAllocateMemory(device, &allocInfo, nullptr, &out.memory) != VK_SUCCESS ||
+        vk.vkBindImageMemory(device, out.image, out.memory, 0) != VK_SUCCESS) {
+        return false;
+    }
+    if (!(usage & VK_IMAGE_USAGE_SAMPLED_BIT)) {
+        return true;
+    }
+    VkSamplerYcbcrConversionInfo conversionInfo{};
+    conversionInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_YCBCR_CONVERSION_INFO;
+    conversionInfo.conversion = conversion;
+    VkImageViewCreateInfo viewInfo{};
+    viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    viewInfo.pNext = conversion != VK_NULL_HANDLE ? &conversionInfo : nullptr;
+    viewInfo.image = out.image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = format;
+    viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    viewInfo.subresourceRange.levelCount = 1;
+    viewInfo.subresourceRange.layerCount = 1;
+    return vk.vkCreateImageView(device, &viewInfo, nullptr, &out.view) == VK_SUCCESS;
+}
+
+void VulkanEdgeContext::destroyImage(Image& image) {
+    if (image.view) {
+        vk.vkDestroyImageView(device, image.view, nullptr);
+    }
+    if (image.image) {
+        vk.vkDestroyImage(device, image.image, nullptr);
+    }
+    if (image.memory) {
+        vk.vkFreeMemory(device, image.memory, nullptr);
+    }
+    image = Image();
+}
+
+void VulkanEdgeContext::writeStorage(VkDescriptorSet set, uint32_t binding, VkImageView view) {
+    VkDescriptorImageInfo image{};
+    image.imageView = view;
+    image.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = set;
+    write.dstBinding = binding;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    write.pImageInfo = &image;
+    vk.vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+}
+
+void VulkanEdgeContext::writeSampled(VkDescriptorSet set, VkImageView view) {
+    VkDescriptorImageInfo image{};
+    image.imageView = view;  // the sampler is immutable in the layout
+    image.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    VkWriteDescriptorSet write{};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = set;
+    write.dstBinding = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.pImageInfo = &image;
+    vk.vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+}
+
+// The pass images at the frame's size; the previous frame is complete, so
+// they can go at once
+bool VulkanEdgeContext::ensureTargets(int frameWidth, int frameHeight) {
+    if (frameWidth == width && frameHeight == height) {
+        return true;
+    }
+    destroyImage(blur);
+    destroyImage(gradient);
+    destroyImage(states[0]);
+    destroyImage(states[1]);
+    destroyImage(edges);
+    width = 0;
+    height = 0;
+    const VkImageUsageFlags storage = VK_IMAGE_USAGE_STORAGE_BIT;
+    if (!createImage(VK_FORMAT_R32_SFLOAT, storage, frameWidth, frameHeight, blur) ||
+        !createImage(VK_FORMAT_R32_UINT, storage, frameWidth, frameHeight, gradient) ||
+        !createImage(VK_FORMAT_R32_UINT, storage, frameWidth, frameHeight, states[0]) ||
+        !createImage(VK_FORMAT_R32_UINT, storage, frameWidth, frameHeight, states[1]) ||
+        !createImage(VK_FORMAT_R8G8B8A8_UNORM, storage | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, frameWidth, frameHeight,
+                     edges)) {
+        LOGE_RATELIMITED("❌ Vulkan edge targets failed for %dx%d", frameWidth, frameHeight);
+        return false;
+    }
+    writeStorage(lumaBlurSet, 1, blur.view);
+    if (cameraBlurSet) {
+        writeStorage(cameraBlurSet, 1, blur.view);
+    }
+    writeStorage(sobelSet, 0, blur.view);
+    writeStorage(sobelSet, 1, gradient.view);
+    writeStorage(sobelSet, 2, edges.view);
+    writeStorage(nmsSet, 0, gradient.view);
+    writeStorage(nmsSet, 1, states[0].view);
+    writeStorage(nmsSet, 2, edges.view);
+    for (int i = 0; i < 2; i++) {
+        writeStorage(hysteresisSets[i], 0, states[i].view);
+        writeStorage(hysteresisSets[i], 1, states[1 - i].view);
+        writeStorage(hysteresisSets[i], 2, edges.view);
+    }
+    width = frameWidth;
+    height = frameHeight;
+    LOGI("🔄 Vulkan edge targets %dx%d", width, height);
+    return true;
+}
+
+bool VulkanEdgeContext::ensureLumaInput(int frameWidth, int frameHeight) {
+    if (frameWidth == lumaWidth && frameHeight == lumaHeight) {
+        return true;
+    }
+    destroyImage(lumaImage);
+    if (staging) {
+        vk.vkDestroyBuffer(device, staging, nullptr);
+        staging = VK_NULL_HANDLE;
+    }
+    if (stagingMemory) {
+        vk.vkFreeMemory(device, stagingMemory, nullptr);  // unmaps it
+        stagingMemory = VK_NULL_HANDLE;
+        stagingData = nullptr;
+    }
+    lumaWidth = 0;
+    lumaHeight = 0;
+    // R8 replicated into .g, which the blur reads for camera buffers too
+    const VkComponentMapping swizzle = {VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_R,
+                                        VK_COMPONENT_SWIZZLE_ONE};
+    if (!createImage(VK_FORMAT_R8_UNORM, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, frameWidth,
+                     frameHeight, lumaImage, &swizzle)) {
+        return false;
+    }
+    VkBufferCreateInfo bufferInfo{};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = static_cast<VkDeviceSize>(frameWidth) * frameHeight;
+    bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    if (vk.vkCreateBuffer(device, &bufferInfo, nullptr, &staging) != VK_SUCCESS) {
+        return false;
+    }
+    VkMemoryRequirements requirements;
+    vk.vkGetBufferMemoryRequirements(device, staging, &requirements);
+    const int type = memoryType(requirements.memoryTypeBits,
+                                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = requirements.size;
+    allocInfo.memoryTypeIndex = static_cast<uint32_t>(type);
+    void* mapped = nullptr;
+    if (type < 0 || vk.vkAllocateMemory(device, &allocInfo, nullptr, &stagingMemory) != VK_SUCCESS ||
+        vk.vkBindBufferMemory(device, staging, stagingMemory, 0) != VK_SUCCESS ||
+        vk.vkMapMemory(device, stagingMemory, 0, VK_WHOLE_SIZE, 0, &mapped) != VK_SUCCESS) {
+        return false;
+    }
+    stagingData = static_cast<uint8_t*>(mapped);
+    writeSampled(lumaBlurSet, lumaImage.view);
+    lumaWidth = frameWidth;
+    lumaHeight = frameHeight;
+    return true;
+}
+
+// Y'CbCr sampler, set layout and blur pipeline for the camera's buffer format
+bool VulkanEdgeContext::ensureCameraPipeline(const VkAndroidHardwareBufferFormatPropertiesANDROID& format) {
+    const uint64_t externalFormat = format.format == VK_FORMAT_UNDEFINED ? format.externalFormat : 0;
+    if (cameraPipelineBuilt && externalFormat == cameraExternalFormat && format.format == cameraFormat) {
+        return true;
+    }
+    destroyCameraPipeline();
+    VkExternalFormatANDROID external{};
+    external.sType = VK_STRUCTURE_TYPE_EXTERNAL_FORMAT_ANDROID;
+    external.externalFormat = externalFormat;
+    VkSamplerYcbcrConversionCreateInfo conversionInfo{};
+    conversionInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_YCBCR_CONVERSION_CREATE_INFO;
+    conversionInfo.pNext = &external;
+    conversionInfo.format = format.format;
+    // No color conversion: luma stays in .g exactly as the CPU sees the Y plane
+    conversionInfo.ycbcrModel = VK_SAMPLER_YCBCR_MODEL_CONVERSION_RGB_IDENTITY;
+    conversionInfo.ycbcrRange = VK_SAMPLER_YCBCR_RANGE_ITU_FULL;
+    conversionInfo.components = format.samplerYcbcrConversionComponents;
+    conversionInfo.xChromaOffset = format.suggestedXChromaOffset;
+    conversionInfo.yChromaOffset = format.suggestedYChromaOffset;
+    conversionInfo.chromaFilter = VK_FILTER_NEAREST;
+    if (vk.vkCreateSamplerYcbcrConversion(device, &conversionInfo, nullptr, &cameraConversion) != VK_SUCCESS) {
+        LOGW("⚠️ Y'CbCr conversion unsupported for the camera format");
+        return false;
+    }
+    VkSamplerYcbcrConversionInfo samplerConversion{};
+    samplerConversion.sType = VK_STRUCTURE_TYPE_SAMPLER_YCBCR_CONVERSION_INFO;
+    samplerConversion.conversion = cameraConversion;
+    VkSamplerCreateInfo samplerInfo{};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.pNext = &samplerConversion;
+    samplerInfo.magFilter = VK_FILTER_NEAREST;
+    samplerInfo.minFilter = VK_FILTER_NEAREST;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    if (vk.vkCreateSampler(device, &samplerInfo, nullptr, &cameraSampler) != VK_SUCCESS ||
+        !createSetLayout(true, &cameraSampler, cameraSetLayout) ||
+        !createPipelineLayout(cameraSetLayout, cameraLayout)) {
+        return false;
+    }
+    cameraBlurPipeline = createPipeline(kBlurSpv, sizeof(kBlurSpv), cameraLayout);
+    // A multi-planar format may take up to three sampler descriptors
+    VkDescriptorPoolSize sizes[2] = {};
+    sizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    sizes[0].descriptorCount = 3;
+    sizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    sizes[1].descriptorCount = 1;
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = 1;
+    poolInfo.poolSizeCount = 2;
+    poolInfo.pPoolSizes = sizes;
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &cameraSetLayout;
+    if (!cameraBlurPipeline || vk.vkCreateDescriptorPool(device, &poolInfo, nullptr, &cameraPool) != VK_SUCCESS) {
+        return false;
+    }
+    allocInfo.descriptorPool = cameraPool;
+    if (vk.vkAllocateDescriptorSets(device, &allocInfo, &cameraBlurSet) != VK_SUCCESS) {
+        cameraBlurSet = VK_NULL_HANDLE;
+        return false;
+    }
+    if (blur.view) {
+        writeStorage(cameraBlurSet, 1, blur.view);
+    }
+    cameraExternalFormat = externalFormat;
+    cameraFormat = format.format;
+    cameraPipelineBuilt = true;
+    LOGI("✅ Vulkan camera import for format %d / external 0x%llx", format.format,
+         static_cast<unsigned long long>(format.externalFormat));
+    return true;
+}
+
+void VulkanEdgeContext::destroyCameraPipeline() {
+    if (cameraPool) {
+        vk.vkDestroyDescriptorPool(device, cameraPool, nullptr);  // frees cameraBlurSet
+    }
+    if (cameraBlurPipeline) {
+        vk.vkDestroyPipeline(device, cameraBlurPipeline, nullptr);
+    }
+    if (cameraLayout) {
+        vk.vkDestroyPipelineLayout(device, cameraLayout, nullptr);
+    }
+    if (cameraSetLayout) {
+        vk.vkDestroyDescriptorSetLayout(device, cameraSetLayout, nullptr);
+    }
+    if (cameraSampler) {
+        vk.vkDestroySampler(device, cameraSampler, nullptr);
+    }
+    if (cameraConversion) {
+        vk.vkDestroySamplerYcbcrConversion(device, cameraConversion, nullptr);
+    }
+    cameraPool = VK_NULL_HANDLE;
+    cameraBlurSet = VK_NULL_HANDLE;
+    cameraBlurPipeline = VK_NULL_HANDLE;
+    cameraLayout = VK_NULL_HANDLE;
+    cameraSetLayout = VK_NULL_HANDLE;
+    cameraSampler = VK_NULL_HANDLE;
+    cameraConversion = VK_NULL_HANDLE;
+    cameraPipelineBuilt = false;
+}
+
+// A ring slot nobody else references, grown up to kMaxSharedSlots; slots of
+// another size are dropped once free
+SharedSlot* VulkanEdgeContext::acquireSlot(int frameWidth, int frameHeight) {
+    for (size_t i = 0; i < slots.size();) {
+        SharedSlot& slot = slots[i];
+        if (slot.image.use_count() == 1 && (slot.image->width != frameWidth || slot.image->height != frameHeight)) {
+            destroySlot(slot);
+            slots.erase(slots.begin() + static_cast<std::ptrdiff_t>(i));
+        } else {
+            i++;
+        }
+    }
+    for (SharedSlot& slot : slots) {
+        if (slot.image.use_count() == 1) {
+            return &slot;
+        }
+    }
+    if (slots.size() >= kMaxSharedSlots) {
+        return nullptr;
+    }
+
+    const HardwareBufferApi& ahb = hardwareBufferApi();
+    AHardwareBuffer_Desc desc{};
+    desc.width = static_cast<uint32_t>(frameWidth);
+    desc.height = static_cast<uint32_t>(frameHeight);
+    desc.layers = 1;
+    desc.format = AHARDWAREBUFFER_FORMAT_R8G8B8A8_UNORM;
+    desc.usage = AHARDWAREBUFFER_USAGE_GPU_SAMPLED_IMAGE | AHARDWAREBUFFER_USAGE_GPU_COLOR_OUTPUT;
+    AHardwareBuffer* buffer = nullptr;
+    if (ahb.allocate(&desc, &buffer) != 0 || !buffer) {
+        LOGE_RATELIMITED("❌ AHardwareBuffer_allocate failed for %dx%d", frameWidth, frameHeight);
+        return nullptr;
+    }
+    SharedSlot slot;
+    // The renderer's EGLImage (and the imported memory) hold their own
+    // references, so the last SharedEdgeImage reference drops the allocation's
+    slot.image.reset(new SharedEdgeImage(), [](SharedEdgeImage* image) {
+        hardwareBufferApi().release(image->buffer);
+        delete image;
+    });
+    slot.image->buffer = buffer;
+    slot.image->width = frameWidth;
+    slot.image->height = frameHeight;
+    if (!importBuffer(buffer, VK_FORMAT_R8G8B8A8_UNORM, 0, VK_IMAGE_USAGE_TRANSFER_DST_BIT, frameWidth, frameHeight,
+                      VK_NULL_HANDLE, slot.target)) {
+        LOGE_RATELIMITED("❌ Importing the output AHardwareBuffer failed");
+        destroyImage(slot.target);
+        return nullptr;
+    }
+    slots.push_back(slot);
+    return &slots.back();
+}
+
+void VulkanEdgeContext::destroySlot(SharedSlot& slot) {
+    destroyImage(slot.target);
+    slot.image.reset();
+}
+
+void VulkanEdgeContext::dispatch(VkPipeline pipeline, VkPipelineLayout layout, VkDescriptorSet set,
+                                 const PushConstants& push) {
+    vk.vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+    vk.vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, layout, 0, 1, &set, 0, nullptr);
+    vk.vkCmdPushConstants(cmd, layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push), &push);
+    vk.vkCmdDispatch(cmd, (static_cast<uint32_t>(width) + kLocalSize - 1) / kLocalSize,
+                     (static_cast<uint32_t>(height) + kLocalSize - 1) / kLocalSize, 1);
+}
+
+// Every pass reads what the one before wrote
+void VulkanEdgeContext::computeBarrier() {
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    vk.vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+                            1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+// Blur from the bound input through the resolve, then the copy into the slot
+// and its release to the foreign (GL) side
+void VulkanEdgeContext::recordEdgePasses(VkPipeline blurPipeline, VkPipelineLayout blurLayout,
+                                         VkDescriptorSet blurSet, SharedSlot& slot, float low, float high) {
+    // Every pass image is fully rewritten, so nothing of the last frame is kept
+    const VkAccessFlags shaderAccess = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    VkImageMemoryBarrier targets[5] = {
+            imageBarrier(blur.image, 0, shaderAccess, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL),
+            imageBarrier(gradient.image, 0, shaderAccess, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL),
+            imageBarrier(states[0].image, 0, shaderAccess, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL),
+            imageBarrier(states[1].image, 0, shaderAccess, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL),
+            imageBarrier(edges.image, 0, shaderAccess, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL),
+    };
+    vk.vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0,
+                            nullptr, 0, nullptr, 5, targets);
+
+    PushConstants push{width, height, low, high, 0};
+    dispatch(blurPipeline, blurLayout, blurSet, push);
+    computeBarrier();
+    dispatch(sobelPipeline, storageLayout, sobelSet, push);
+    computeBarrier();
+    dispatch(nmsPipeline, storageLayout, nmsSet, push);
+    computeBarrier();
+    for (int i = 0; i < kHysteresisIterations; i++) {
+        dispatch(hysteresisPipeline, storageLayout, hysteresisSets[i & 1], push);
+        computeBarrier();
+    }
+    push.resolve = 1;
+    dispatch(hysteresisPipeline, storageLayout, hysteresisSets[kHysteresisIterations & 1], push);
+
+    VkImageMemoryBarrier toCopy[2] = {
+            imageBarrier(edges.image, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+                         VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL),
+            imageBarrier(slot.target.image, 0, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED,
+                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL),
+    };
+    vk.vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0,
+                            nullptr, 0, nullptr, 2, toCopy);
+    VkImageCopy region{};
+    region.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.srcSubresource.layerCount = 1;
+    region.dstSubresource = region.srcSubresource;
+    region.extent = {static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1};
+    vk.vkCmdCopyImage(cmd, edges.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot.target.image,
+                      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+    VkImageMemoryBarrier release = imageBarrier(slot.target.image, VK_ACCESS_TRANSFER_WRITE_BIT, 0,
+                                                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL,
+                                                queueFamily, VK_QUEUE_FAMILY_FOREIGN_EXT);
+    vk.vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0,
+                            nullptr, 0, nullptr, 1, &release);
+}
+
+bool VulkanEdgeContext::begin() {
+    VkCommandBufferBeginInfo info{};
+    info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    return vk.vkResetCommandBuffer(cmd, 0) == VK_SUCCESS && vk.vkBeginCommandBuffer(cmd, &info) == VK_SUCCESS;
+}
+
+// The fence wait is the GL synchronization: the image is complete before
+// any GL command can sample it
+bool VulkanEdgeContext::submitAndWait() {
+    if (vk.vkEndCommandBuffer(cmd) != VK_SUCCESS || vk.vkResetFences(device, 1, &fence) != VK_SUCCESS) {
+        return false;
+    }
+    VkSubmitInfo submit{};
+    submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit.commandBufferCount = 1;
+    submit.pCommandBuffers = &cmd;
+    if (vk.vkQueueSubmit(queue, 1, &submit, fence) != VK_SUCCESS) {
+        LOGE_RATELIMITED("❌ vkQueueSubmit failed");
+        return false;
+    }
+    const VkResult waited = vk.vkWaitForFences(device, 1, &fence, VK_TRUE, kFenceTimeoutNs);
+    if (waited != VK_SUCCESS) {
+        LOGE_RATELIMITED("❌ Vulkan edge frame did not finish (%d)", waited);
+        vk.vkDeviceWaitIdle(device);  // nothing may still write the slot or read the staging buffer
+        return false;
+    }
+    return true;
+}
+
+std::shared_ptr<const SharedEdgeImage> VulkanEdgeContext::detectLuma(const cv::Mat& luma, float low, float high) {
+    if (luma.empty() || luma.type() != CV_8UC1 || !ensureTargets(luma.cols, luma.rows) ||
+        !ensureLumaInput(luma.cols, luma.rows)) {
+        return nullptr;
+    }
+    SharedSlot* slot = acquireSlot(width, height);
+    if (!slot) {
+        LOGW_RATELIMITED("⚠️ Every Vulkan edge buffer is still in use");
+        return nullptr;
+    }
+    for (int y = 0; y < luma.rows; y++) {
+        std::memcpy(stagingData + static_cast<size_t>(y) * luma.cols, luma.ptr(y), static_cast<size_t>(luma.cols));
+    }
+    if (!begin()) {
+        return nullptr;
+    }
+    VkImageMemoryBarrier toUpload = imageBarrier(lumaImage.image, 0, VK_ACCESS_TRANSFER_WRITE_BIT,
+                                                 VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    vk.vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr,
+                            0, nullptr, 1, &toUpload);
+    VkBufferImageCopy region{};
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent = {static_cast<uint32_t>(luma.cols), static_cast<uint32_t>(luma.rows), 1};
+    vk.vkCmdCopyBufferToImage(cmd, staging, lumaImage.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+    VkImageMemoryBarrier toSample = imageBarrier(lumaImage.image, VK_ACCESS_TRANSFER_WRITE_BIT,
+                                                 VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                                 VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    vk.vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0,
+                            nullptr, 0, nullptr, 1, &toSample);
+    recordEdgePasses(lumaBlurPipeline, lumaLayout, lumaBlurSet, *slot, low, high);
+    if (!submitAndWait()) {
+        return nullptr;
+    }
+    slot->image->id = nextId++;
+    return slot->image;
+}
+
+std::shared_ptr<const SharedEdgeImage> VulkanEdgeContext::detectCamera(AHardwareBuffer* camera, float low,
+                                                                       float high) {
+    if (!camera || !ycbcrSupported) {
+        return nullptr;
+    }
+    VkAndroidHardwareBufferFormatPropertiesANDROID format{};
+    format.sType = VK_STRUCTURE_TYPE_ANDROID_HARDWARE_BUFFER_FORMAT_PROPERTIES_ANDROID;
+    VkAndroidHardwareBufferPropertiesANDROID properties{};
+    properties.sType = VK_STRUCTURE_TYPE_ANDROID_HARDWARE_BUFFER_PROPERTIES_ANDROID;
+    properties.pNext = &format;
+    if (vk.vkGetAndroidHardwareBufferPropertiesANDROID(device, camera, &properties) != VK_SUCCESS ||
+        !ensureCameraPipeline(format)) {
+        return nullptr;
+    }
+    AHardwareBuffer_Desc desc{};
+    hardwareBufferApi().describe(camera, &desc);
+    const int frameWidth = static_cast<int>(desc.width);
+    const int frameHeight = static_cast<int>(desc.height);
+    if (!ensureTargets(frameWidth, frameHeight)) {
+        return nullptr;
+    }
+    SharedSlot* slot = acquireSlot(width, height);
+    if (!slot) {
+        LOGW_RATELIMITED("⚠️ Every Vulkan edge buffer is still in use");
+        return nullptr;
+    }
+    // The camera cycles through a handful of buffers; importing one is cheap
+    // next to the passes, so it is imported per frame and dropped after it
+    Image input;
+    if (!importBuffer(camera, cameraFormat, cameraExternalFormat, VK_IMAGE_USAGE_SAMPLED_BIT, frameWidth,
+                      frameHeight, cameraConversion, input)) {
+        LOGE_RATELIMITED("❌ Importing the camera AHardwareBuffer failed");
+        destroyImage(input);
+        return nullptr;
+    }
+    writeSampled(cameraBlurSet, input.view);
+    bool done = false;
+    if (begin()) {
+        VkImageMemoryBarrier acquire = imageBarrier(input.image, 0, VK_ACCESS_SHADER_READ_BIT,
+                                                    VK_IMAGE_LAYOUT_UNDEFINED,
+                                                    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                                                    VK_QUEUE_FAMILY_FOREIGN_EXT, queueFamily);
+        vk.vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0,
+                                nullptr, 0, nullptr, 1, &acquire);
+        recordEdgePasses(cameraBlurPipeline, cameraLayout, cameraBlurSet, *slot, low, high);
+        done = submitAndWait();
+    }
+    destroyImage(input);
+    if (!done) {
+        return nullptr;
+    }
+    slot->image->id = nextId++;
+    return slot->image;
+}
+
+void VulkanEdgeContext::destroy() {
+    if (device) {
+        vk.vkDeviceWaitIdle(device);
+        for (SharedSlot& slot : slots) {
+            destroySlot(slot);  // frames the renderer still holds keep their buffer
+        }
+        slots.clear();
+        destroyCameraPipeline();
+        destroyImage(blur);
+        destroyImage(gradient);
+        destroyImage(states[0]);
+        destroyImage(states[1]);
+        destroyImage(edges);
+        destroyImage(lumaImage);
+        if (staging) {
+            vk.vkDestroyBuffer(device, staging, nullptr);
+        }
+        if (stagingMemory) {
+            vk.vkFreeMemory(device, stagingMemory, nullptr);
+        }
+        VkPipeline pipelines[] = {lumaBlurPipeline, sobelPipeline, nmsPipeline, hysteresisPipeline};
+        for (VkPipeline pipeline : pipelines) {
+            if (pipeline) {
+                vk.vkDestroyPipeline(device, pipeline, nullptr);
+            }
+        }
+        if (descriptorPool) {
+            vk.vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+        }
+        if (lumaLayout) {
+            vk.vkDestroyPipelineLayout(device, lumaLayout, nullptr);
+        }
+        if (storageLayout) {
+            vk.vkDestroyPipelineLayout(device, storageLayout, nullptr);
+        }
+        if (lumaSetLayout) {
+            vk.vkDestroyDescriptorSetLayout(device, lumaSetLayout, nullptr);
+        }
+        if (storageSetLayout) {
+            vk.vkDestroyDescriptorSetLayout(device, storageSetLayout, nullptr);
+        }
+        if (lumaSampler) {
+            vk.vkDestroySampler(device, lumaSampler, nullptr);
+        }
+        if (fence) {
+            vk.vkDestroyFence(device, fence, nullptr);
+        }
+        if (commandPool) {
+            vk.vkDestroyCommandPool(device, commandPool, nullptr);
+        }
+        vk.vkDestroyDevice(device, nullptr);
+        device = VK_NULL_HANDLE;
+    }
+    if (instance) {
+        vk.vkDestroyInstance(instance, nullptr);
+        instance = VK_NULL_HANDLE;
+    }
+    if (library) {
+        dlclose(library);
+        library = nullptr;
+    }
+}
+
+std::mutex contextMutex;
+VulkanEdgeContext* context = nullptr;  // guarded by contextMutex
+bool initTried = false;
+
+// Caller holds contextMutex
+VulkanEdgeContext* readyContext() {
+    if (!initTried) {
+        initTried = true;
+        std::unique_ptr<VulkanEdgeContext> created(new VulkanEdgeContext());
+        if (created->init()) {
+            context = created.release();
+        }
+    }
+    return context;
+}
+
+} // namespace
+
+bool vulkanEdgesAvailable() {
+    std::lock_guard<std::mutex> lock(contextMutex);
+    return readyContext() != nullptr;
+}
+
+bool vulkanEdgesImportCamera() {
+    std::lock_guard<std::mutex> lock(contextMutex);
+    VulkanEdgeContext* ready = readyContext();
+    return ready && ready->cameraImport();
+}
+
+std::shared_ptr<const SharedEdgeImage> vulkanDetectEdges(const cv::Mat& luma, float low, float high) {
+    std::lock_guard<std::mutex> lock(contextMutex);
+    VulkanEdgeContext* ready = readyContext();
+    return ready ? ready->detectLuma(luma, low, high) : nullptr;
+}
+
+std::shared_ptr<const SharedEdgeImage> vulkanDetectEdges(AHardwareBuffer* camera, float low, float high) {
+    std::lock_guard<std::mutex> lock(contextMutex);
+    VulkanEdgeContext* ready = readyContext();
+    return ready ? ready->detectCamera(camera, low, high) : nullptr;
+}
+
+void vulkanEdgesRelease() {
+    std::lock_guard<std::mutex> lock(contextMutex);
+    delete context;
+    context = nullptr;
+    initTried = false;
+}
+
+#else  // !EDGE_VULKAN_COMPUTE
+
+bool vulkanEdgesAvailable() {
+    return false;
+}
+
+bool vulkanEdgesImportCamera() {
+    return false;
+}
+
+std::shared_ptr<const SharedEdgeImage> vulkanDetectEdges(const cv::Mat&, float, float) {
+    LOGW_RATELIMITED("⚠️ Built without Vulkan compute (no glslc)");
+    return nullptr;
+}
+
+std::shared_ptr<const SharedEdgeImage> vulkanDetectEdges(AHardwareBuffer*, float, float) {
+    return nullptr;
+}
+
+void vulkanEdgesRelease() {
+}
+
+#endif // EDGE_VULKAN_COMPUTE
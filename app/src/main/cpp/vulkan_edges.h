@@ -0,0 +1,40 @@
+#ifndef EDGE_VULKAN_EDGES_H
+#define EDGE_VULKAN_EDGES_H
+
+#include <opencv2/core.hpp>
+#include <memory>
+
+struct AHardwareBuffer;
+struct SharedEdgeImage;
+
+// Vulkan 1.1 compute edge detector with its own instance and device: blur,
+// Sobel, non-max suppression and iterated hysteresis (shaders/edge_*.comp)
+// as compute dispatches separated by explicit barriers. The input is the
+// camera's AHardwareBuffer, imported through
+// VK_ANDROID_external_memory_android_hardware_buffer and sampled with a
+// Y'CbCr conversion, or an uploaded luma plane. The result lands in an RGBA
+// AHardwareBuffer of a small ring that GL samples as an EGLImage; its queue
+// ownership is released to VK_QUEUE_FAMILY_FOREIGN_EXT after every frame.
+//
+// Only built when CMake finds glslc (the NDK's shader-tools), which defines
+// EDGE_VULKAN_COMPUTE; otherwise vulkanEdgesAvailable() is false and every
+// detection fails. Calls may come from any thread and are serialized.
+
+// Creates the context and pipelines on first use; false without a Vulkan 1.1
+// device carrying the extensions (the result is remembered until release)
+bool vulkanEdgesAvailable();
+
+// Whether camera AHardwareBuffers can be imported (samplerYcbcrConversion)
+bool vulkanEdgesImportCamera();
+
+// Edges of an 8-bit luma plane, or of the camera buffer's luma; thresholds are
+// in units of the normalized 0..1 luma gradient. Blocks until the GPU is done,
+// so GL can sample the result as soon as it is returned. Null on failure or
+// while every ring slot is still referenced by the renderer.
+std::shared_ptr<const SharedEdgeImage> vulkanDetectEdges(const cv::Mat& luma, float low, float high);
+std::shared_ptr<const SharedEdgeImage> vulkanDetectEdges(AHardwareBuffer* camera, float low, float high);
+
+// Drops the device and every ring slot the renderer no longer holds
+void vulkanEdgesRelease();
+
+#endif // EDGE_VULKAN_EDGES_H
@@ -0,0 +1,324 @@
+#include "work_stealing_pool.h"
+#include "thread_policy.h"
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <unistd.h>
+
+#define LOG_TAG "WorkStealingPool"
+#include "logging.h"
+
+namespace {
+
+// Chunks dealt per thread when a loop has more tasks than threads: enough
+// for a fast core to take over a slow one's share, few enough to keep the
+// per-chunk deque traffic negligible
+const int kChunksPerThread = 4;
+
+// How long an idle worker keeps looking for chunks before it sleeps; back
+// to back loops (every band stage of a frame) then skip the futex wake-up
+const std::chrono::microseconds kIdleSpin(50);
+
+thread_local int threadIndex = 0;       // slot of the calling thread (0 = any caller)
+thread_local bool insideChunk = false;  // nested loops run serially
+thread_local unsigned threadAffinity = 0;
+
+std::atomic<bool> installed{false};
+
+int defaultThreads() {
+    return std::max(1, static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN)));
+}
+
+}  // namespace
+
+struct WorkStealingPool::Job {
+    FN_parallel_for_body_cb_t body;
+    void* data;
+    std::atomic<int> remaining{0};
+    std::mutex mutex;
+    std::condition_variable done;
+    std::exception_ptr error;  // mutex; first exception a chunk threw
+};
+
+WorkStealingPool::WorkStealingPool() {
+    startWorkers(defaultThreads());
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    stopWorkers();
+}
+
+void WorkStealingPool::startWorkers(int threads) {
+    const CpuTopology& topology = cpuTopology();
+    // Big cores first: slot 0 (the caller) and the first workers land there
+    std::vector<int> order = topology.bigCores;
+    order.insert(order.end(), topology.littleCores.begin(), topology.littleCores.end());
+
+    slots.clear();
+    for (int i = 0; i < threads; i++) {
+        auto slot = std::make_unique<Slot>();
+        if (!order.empty()) {
+            const int cpu = order[i % order.size()];
+            slot->little = std::find(topology.littleCores.begin(), topology.littleCores.end(), cpu) !=
+                           topology.littleCores.end();
+            slot->cluster = slot->little ? topology.littleCores : topology.bigCores;
+        }
+        slots.push_back(std::move(slot));
+    }
+    for (int i = 1; i < threads; i++) {
+        workers.emplace_back(&WorkStealingPool::workerLoop, this, i);
+    }
+    LOGI("✅ Work-stealing pool: %d threads (%zu big, %zu little cores)", threads, topology.bigCores.size(),
+         topology.littleCores.size());
+}
+
+void WorkStealingPool::stopWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping = true;
+        wakeGeneration++;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+    std::lock_guard<std::mutex> lock(wakeMutex);
+    stopping = false;
+}
+
+void WorkStealingPool::parallel_for(int tasks, FN_parallel_for_body_cb_t body, void* data) {
+    if (tasks <= 0) {
+        return;
+    }
+    if (insideChunk || currentThreadTier() == ThreadTier::ANALYTICS) {
+        // Nested, or from a background thread that must not take workers
+        // from the foreground: serially on the caller, at its priority
+        body(0, tasks, data);
+        return;
+    }
+    std::shared_lock<std::shared_timed_mutex> config(configMutex);
+    const int threads = static_cast<int>(slots.size());
+    if (tasks == 1 || threads == 1) {
+        insideChunk = true;
+        body(0, tasks, data);
+        insideChunk = false;
+        return;
+    }
+
+    Job job;
+    job.body = body;
+    job.data = data;
+    const int count = tasks <= threads ? tasks : std::min(tasks, threads * kChunksPerThread);
+    job.remaining.store(count, std::memory_order_relaxed);
+    for (int c = 0; c < count; c++) {
+        const int owner = c % threads;
+        const Chunk chunk{&job, static_cast<int>(static_cast<int64_t>(tasks) * c / count),
+                          static_cast<int>(static_cast<int64_t>(tasks) * (c + 1) / count), owner};
+        std::lock_guard<std::mutex> lock(slots[owner]->mutex);
+        slots[owner]->chunks.push_back(chunk);
+    }
+    pendingChunks.fetch_add(count, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        wakeGeneration++;
+    }
+    wake.notify_all();
+    loops.fetch_add(1, std::memory_order_relaxed);
+    chunks.fetch_add(count, std::memory_order_relaxed);
+
+    // The caller works too, until nothing is left to take; then it waits for
+    // the chunks still running elsewhere
+    Chunk chunk{};
+    while (job.remaining.load(std::memory_order_acquire) > 0 && (popOwn(0, chunk) || steal(0, chunk))) {
+        execute(chunk, 0);
+    }
+    std::unique_lock<std::mutex> lock(job.mutex);
+    job.done.wait(lock, [&job] { return job.remaining.load(std::memory_order_acquire) == 0; });
+    if (job.error) {
+        std::rethrow_exception(job.error);
+    }
+}
+
+bool WorkStealingPool::popOwn(int index, Chunk& chunk) {
+    Slot& slot = *slots[index];
+    std::lock_guard<std::mutex> lock(slot.mutex);
+    if (slot.chunks.empty()) {
+        return false;
+    }
+    chunk = slot.chunks.back();
+    slot.chunks.pop_back();
+    pendingChunks.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool WorkStealingPool::steal(int thief, Chunk& chunk) {
+    const int threads = static_cast<int>(slots.size());
+    const bool little = slots[thief]->little && !pinnedTogether.load(std::memory_order_relaxed);
+    // Victims on the thief's own cluster first, then the rest
+    for (int pass = 0; pass < 2; pass++) {
+        for (int step = 1; step < threads; step++) {
+            Slot& victim = *slots[(thief + step) % threads];
+            if ((victim.little == slots[thief]->little) != (pass == 0)) {
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (victim.chunks.empty() || (little && victim.chunks.size() < 2)) {
+                continue;
+            }
+            chunk = victim.chunks.front();
+            victim.chunks.pop_front();
+            pendingChunks.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::execute(const Chunk& chunk, int runner) {
+    Job& job = *chunk.job;
+    if (runner != chunk.dealtTo) {
+        steals.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (slots[runner]->little) {
+        littleChunks.fetch_add(1, std::memory_order_relaxed);
+    }
+    std::exception_ptr error;
+    insideChunk = true;
+    try {
+        job.body(chunk.start, chunk.end, job.data);
+    } catch (...) {
+        error = std::current_exception();
+    }
+    insideChunk = false;
+    // Under the job's mutex: the caller returns, and the job goes away, as
+    // soon as it sees the last chunk done
+    std::lock_guard<std::mutex> lock(job.mutex);
+    if (error && !job.error) {
+        job.error = error;
+    }
+    if (job.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        job.done.notify_all();
+    }
+}
+
+void WorkStealingPool::workerLoop(int index) {
+    threadIndex = index;
+    setThreadTier(ThreadTier::PROCESSING);
+    uint64_t seen = 0;
+    while (true) {
+        if (threadAffinity != affinityGeneration.load(std::memory_order_acquire)) {
+            applyAffinity(index);
+        }
+        Chunk chunk{};
+        if (popOwn(index, chunk) || steal(index, chunk)) {
+            execute(chunk, index);
+            continue;
+        }
+        if (pendingChunks.load(std::memory_order_acquire) <= 0) {
+            const auto until = std::chrono::steady_clock::now() + kIdleSpin;
+            while (pendingChunks.load(std::memory_order_acquire) <= 0 && std::chrono::steady_clock::now() < until) {
+                std::this_thread::yield();
+            }
+            if (pendingChunks.load(std::memory_order_acquire) > 0) {
+                continue;
+            }
+        }
+        // Nothing left this thread may take (a little core leaves the tail
+        // chunks alone): sleep until the next loop is dealt
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        if (stopping) {
+            return;
+        }
+        // Chunks dealt before this generation are in the deques already
+        if (seen == wakeGeneration) {
+            wake.wait(lock, [this, seen] { return stopping || wakeGeneration != seen; });
+        }
+        seen = wakeGeneration;
+        if (stopping) {
+            return;
+        }
+    }
+}
+
+void WorkStealingPool::applyAffinity(int index) {
+    std::vector<int> cpus;
+    {
+        std::lock_guard<std::mutex> lock(affinityMutex);
+        threadAffinity = affinityGeneration.load(std::memory_order_relaxed);
+        cpus = affinity.empty() ? slots[index]->cluster : affinity;
+    }
+    if (!pinCurrentThread(cpus)) {
+        LOGW("⚠️ Pool worker %d kept its affinity (cpuset restrictions?)", index);
+    }
+}
+
+void WorkStealingPool::setAffinity(const std::vector<int>& cpus) {
+    {
+        std::lock_guard<std::mutex> lock(affinityMutex);
+        affinity = cpus;
+        pinnedTogether.store(!cpus.empty(), std::memory_order_relaxed);
+        affinityGeneration.fetch_add(1, std::memory_order_release);
+    }
+    std::lock_guard<std::mutex> lock(wakeMutex);
+    wakeGeneration++;
+    wake.notify_all();
+}
+
+int WorkStealingPool::getThreadNum() const {
+    return threadIndex;
+}
+
+int WorkStealingPool::getNumThreads() const {
+    std::shared_lock<std::shared_timed_mutex> config(configMutex);
+    return static_cast<int>(slots.size());
+}
+
+int WorkStealingPool::setNumThreads(int threads) {
+    if (threads <= 0) {
+        threads = defaultThreads();
+    }
+    std::unique_lock<std::shared_timed_mutex> config(configMutex);
+    const int previous = static_cast<int>(slots.size());
+    if (threads != previous) {
+        stopWorkers();
+        startWorkers(threads);
+    }
+    return previous;
+}
+
+WorkStealingPool::Stats WorkStealingPool::stats() const {
+    Stats stats;
+    stats.loops = loops.load(std::memory_order_relaxed);
+    stats.chunks = chunks.load(std::memory_order_relaxed);
+    stats.steals = steals.load(std::memory_order_relaxed);
+    stats.littleChunks = littleChunks.load(std::memory_order_relaxed);
+    stats.threads = getNumThreads();
+    return stats;
+}
+
+namespace {
+
+std::shared_ptr<WorkStealingPool>& poolInstance() {
+    // Shared with OpenCV once installed; whichever lets go last stops it
+    static std::shared_ptr<WorkStealingPool> pool = std::make_shared<WorkStealingPool>();
+    return pool;
+}
+
+}  // namespace
+
+void installWorkStealingPool() {
+    if (installed.exchange(true)) {
+        return;
+    }
+    cv::parallel::setParallelForBackend(poolInstance());
+    LOGI("✅ OpenCV parallel_for_ backend: %s", poolInstance()->getName());
+}
+
+bool workStealingPoolInstalled() {
+    return installed.load(std::memory_order_relaxed);
+}
+
+WorkStealingPool& workStealingPool() {
+    return *poolInstance();
+}
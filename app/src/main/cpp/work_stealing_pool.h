@@ -0,0 +1,129 @@
+#ifndef EDGE_WORK_STEALING_POOL_H
+#define EDGE_WORK_STEALING_POOL_H
+
+#include <opencv2/core.hpp>
+#include <opencv2/core/parallel/parallel_backend.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+// The one thread pool of the process: registered as OpenCV's parallel_for_
+// backend, so our tiled stages and OpenCV's own parallel loops share it
+// instead of oversubscribing the cores with two pools, and usable directly
+// through run().
+//
+// Every thread (the calling thread is slot 0) owns a deque of chunks. A loop
+// is cut into a few chunks per thread and dealt round-robin, big-core
+// threads first; owners pop their newest chunk, idle threads steal the
+// oldest from the others, same cluster first. So a chunk stuck on a little
+// core or a preempted thread only delays that chunk, where OpenCV's default
+// pool splits evenly and waits for the slowest core. Little-core threads
+// never steal a victim's last chunk, the one most likely to be the tail.
+// Workers are pinned to their cluster (cpuTopology()), not to single cores,
+// so the scheduler can still move them within it.
+//
+// A loop with no more tasks than threads gets exactly one chunk per thread
+// (the pool-wide rendezvous of thread_policy.cpp and cpu_profiler.cpp rely
+// on it). Loops started from inside a chunk, or from an ANALYTICS-tier thread
+// (thread_policy.h), run serially on the caller.
+class WorkStealingPool : public cv::parallel::ParallelForAPI {
+public:
+    struct Stats {
+        uint64_t loops = 0;
+        uint64_t chunks = 0;
+        uint64_t steals = 0;           // chunks run by a thread other than the one dealt them
+        uint64_t littleChunks = 0;     // chunks run on little-core workers
+        int threads = 0;               // caller included
+    };
+
+    WorkStealingPool();
+    ~WorkStealingPool() override;
+
+    // ParallelForAPI
+    void parallel_for(int tasks, FN_parallel_for_body_cb_t body, void* data) override;
+    int getThreadNum() const override;
+    int getNumThreads() const override;
+    int setNumThreads(int threads) override;  // <= 0 = one per online core; returns the previous count
+    const char* getName() const override { return "edge-work-stealing"; }
+
+    // Direct use: fn(cv::Range) over [range.start, range.end), blocking until
+    // every chunk ran; the first exception a chunk throws is rethrown here
+    template <typename Fn>
+    void run(const cv::Range& range, const Fn& fn) {
+        struct Call {
+            const Fn& fn;
+            int offset;
+            static void CV_API_CALL body(int start, int end, void* data) {
+                const Call& call = *static_cast<const Call*>(data);
+                call.fn(cv::Range(call.offset + start, call.offset + end));
+            }
+        } call{fn, range.start};
+        parallel_for(range.end - range.start, &Call::body, &call);
+    }
+
+    // Restricts every worker to cpus (their own cluster when empty); applied
+    // by each worker before its next chunk
+    void setAffinity(const std::vector<int>& cpus);
+
+    Stats stats() const;
+
+private:
+    struct Job;
+    struct Chunk {
+        Job* job;
+        int start;
+        int end;
+        int dealtTo;
+    };
+    struct Slot {
+        std::mutex mutex;
+        std::deque<Chunk> chunks;
+        std::vector<int> cluster;  // cpus of the cluster this slot was placed on
+        bool little = false;
+    };
+
+    void startWorkers(int threads);
+    void stopWorkers();
+    void workerLoop(int index);
+    bool popOwn(int index, Chunk& chunk);
+    bool steal(int thief, Chunk& chunk);
+    void execute(const Chunk& chunk, int runner);
+    void applyAffinity(int index);
+
+    // Shared by loops, exclusive while the workers are replaced
+    mutable std::shared_timed_mutex configMutex;
+    std::vector<std::unique_ptr<Slot>> slots;
+    std::vector<std::thread> workers;
+
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    uint64_t wakeGeneration = 0;  // wakeMutex
+    bool stopping = false;        // wakeMutex
+    std::atomic<int> pendingChunks{0};
+
+    std::mutex affinityMutex;
+    std::vector<int> affinity;  // empty = every worker keeps to its cluster
+    std::atomic<unsigned> affinityGeneration{1};
+    std::atomic<bool> pinnedTogether{false};  // affinity set: no worker counts as little
+
+    std::atomic<uint64_t> loops{0};
+    std::atomic<uint64_t> chunks{0};
+    std::atomic<uint64_t> steals{0};
+    std::atomic<uint64_t> littleChunks{0};
+};
+
+// Registers the pool as OpenCV's parallel_for_ backend; once, before any
+// other OpenCV call (JNI_OnLoad). Without it workStealingPool() still works
+// standalone.
+void installWorkStealingPool();
+bool workStealingPoolInstalled();
+
+WorkStealingPool& workStealingPool();
+
+#endif // EDGE_WORK_STEALING_POOL_H
@@ -0,0 +1,271 @@
+#include "yuv_convert.h"
+#include "kernel_dispatch.h"
+#include <opencv2/imgproc.hpp>
+#include <opencv2/core/utility.hpp>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+class PlanarToBgrBody : public cv::ParallelLoopBody {
+public:
+    PlanarToBgrBody(const YuvPlanes& planes, cv::Mat& bgr) : planes(planes), bgr(bgr) {}
+
+    // Each range covers chroma rows, i.e. pairs of output rows
+    void operator()(const cv::Range& range) const override {
+        const EdgeKernels& kernels = edgeKernels();  // kernel_dispatch.h; chroma pixel stride 1
+        for (int cy = range.start; cy < range.end; cy++) {
+            const uint8_t* uRow = planes.u + cy * planes.uvRowStride;
+            const uint8_t* vRow = planes.v + cy * planes.uvRowStride;
+            for (int dy = 0; dy < 2; dy++) {
+                int y = cy * 2 + dy;
+                if (y >= planes.height) {
+                    break;
+                }
+                kernels.planarToBgrRow(planes.y + y * planes.yRowStride, uRow, vRow, planes.width,
+                                       bgr.ptr<uint8_t>(y));
+            }
+        }
+    }
+
+private:
+    const YuvPlanes& planes;
+    cv::Mat& bgr;
+};
+
+const int kTileSize = 64;  // even, so every tile starts on a chroma sample
+
+// Each range covers bands of kTileSize source rows
+class RotatedNv21ToBgrBody : public cv::ParallelLoopBody {
+public:
+    RotatedNv21ToBgrBody(const cv::Mat& luma, const cv::Mat& chroma, int rotation, cv::Mat& bgr)
+        : luma(luma), chroma(chroma), rotation(rotation), bgr(bgr) {}
+
+    void operator()(const cv::Range& range) const override {
+        const EdgeKernels& kernels = edgeKernels();
+        uint8_t tile[kTileSize][kTileSize * 3];
+        uint8_t u[kTileSize / 2];
+        uint8_t v[kTileSize / 2];
+        const int width = luma.cols;
+        const int height = luma.rows;
+        for (int band = range.start; band < range.end; band++) {
+            const int y0 = band * kTileSize;
+            const int rows = std::min(kTileSize, height - y0);
+            for (int x0 = 0; x0 < width; x0 += kTileSize) {
+                const int cols = std::min(kTileSize, width - x0);
+                for (int r = 0; r < rows; r++) {
+                    // The planar row kernel takes U and V on their own; the
+                    // tile's VU pairs are split once per chroma row
+                    if (r % 2 == 0) {
+                        const uint8_t* vu = chroma.ptr<uint8_t>((y0 + r) / 2) + x0;
+                        for (int c = 0; c < (cols + 1) / 2; c++) {
+                            v[c] = vu[2 * c];
+                            u[c] = vu[2 * c + 1];
+                        }
+                    }
+                    kernels.planarToBgrRow(luma.ptr<uint8_t>(y0 + r) + x0, u, v, cols, tile[r]);
+                }
+                storeTile(tile, x0, y0, cols, rows);
+            }
+        }
+    }
+
+private:
+    // Source pixel (x0 + c, y0 + r) to its place in the rotated image; the
+    // inner loops walk along destination rows
+    void storeTile(const uint8_t (*tile)[kTileSize * 3], int x0, int y0, int cols, int rows) const {
+        const int width = luma.cols;
+        const int height = luma.rows;
+        switch (rotation) {
+            case 90:   // dst(x, height - 1 - y)
+                for (int c = 0; c < cols; c++) {
+                    uint8_t* out = bgr.ptr<uint8_t>(x0 + c) + (height - 1 - y0) * 3;
+                    for (int r = 0; r < rows; r++, out -= 3) {
+                        memcpy(out, &tile[r][c * 3], 3);
+                    }
+                }
+                break;
+            case 180:  // dst(height - 1 - y, width - 1 - x)
+                for (int r = 0; r < rows; r++) {
+                    uint8_t* out = bgr.ptr<uint8_t>(height - 1 - y0 - r) + (width - 1 - x0) * 3;
+                    for (int c = 0; c < cols; c++, out -= 3) {
+                        memcpy(out, &tile[r][c * 3], 3);
+                    }
+                }
+                break;
+            case 270:  // dst(width - 1 - x, y)
+                for (int c = 0; c < cols; c++) {
+                    uint8_t* out = bgr.ptr<uint8_t>(width - 1 - x0 - c) + y0 * 3;
+                    for (int r = 0; r < rows; r++, out += 3) {
+                        memcpy(out, &tile[r][c * 3], 3);
+                    }
+                }
+                break;
+            default:
+                for (int r = 0; r < rows; r++) {
+                    memcpy(bgr.ptr<uint8_t>(y0 + r) + x0 * 3, tile[r], static_cast<size_t>(cols) * 3);
+                }
+                break;
+        }
+    }
+
+    const cv::Mat& luma;
+    const cv::Mat& chroma;
+    int rotation;
+    cv::Mat& bgr;
+};
+
+} // namespace
+
+bool convertNv21ToBgrRotated(const cv::Mat& luma, const cv::Mat& chroma, int rotation, cv::Mat& bgr) {
+    if (rotation != 0 && rotation != 90 && rotation != 180 && rotation != 270) {
+        return false;
+    }
+    if (luma.empty() || luma.type() != CV_8UC1 || chroma.type() != CV_8UC2 ||
+        chroma.rows < (luma.rows + 1) / 2 || chroma.cols < (luma.cols + 1) / 2) {
+        return false;
+    }
+    const bool quarterTurn = rotation == 90 || rotation == 270;
+    bgr.create(quarterTurn ? luma.cols : luma.rows, quarterTurn ? luma.rows : luma.cols, CV_8UC3);
+    cv::parallel_for_(cv::Range(0, (luma.rows + kTileSize - 1) / kTileSize),
+                      RotatedNv21ToBgrBody(luma, chroma, rotation, bgr));
+    return true;
+}
+
+bool convertYuvPlanesToBgr(const YuvPlanes& planes, cv::Mat& bgr) {
+    if (!planes.y || !planes.u || !planes.v || planes.width <= 0 || planes.height <= 0) {
+        return false;
+    }
+
+    cv::Mat yMat(planes.height, planes.width, CV_8UC1,
+                 const_cast<uint8_t*>(planes.y), planes.yRowStride);
+
+    if (planes.uvPixelStride == 2) {
+        // Semi-planar: the chroma plane starting first decides NV21 (VU) vs NV12 (UV)
+        bool vuOrder = planes.v < planes.u;
+        const uint8_t* uvStart = vuOrder ? planes.v : planes.u;
+        cv::Mat uvMat(planes.height / 2, planes.width / 2, CV_8UC2,
+                      const_cast<uint8_t*>(uvStart), planes.uvRowStride);
+        cv::cvtColorTwoPlane(yMat, uvMat, bgr,
+                             vuOrder ? cv::COLOR_YUV2BGR_NV21 : cv::COLOR_YUV2BGR_NV12);
+        return true;
+    }
+
+    if (planes.uvPixelStride == 1) {
+        // Planar I420 (U first) or YV12 (V first): the kernel reads each plane
+        // through its own pointer, so the order in memory does not matter
+        bgr.create(planes.height, planes.width, CV_8UC3);
+        cv::parallel_for_(cv::Range(0, (planes.height + 1) / 2), PlanarToBgrBody(planes, bgr));
+        return true;
+    }
+
+    return false;
+}
+
+bool convertYuvPlanesToRgba(const YuvPlanes& planes, cv::Mat& rgba) {
+    if (!planes.y || !planes.u || !planes.v || planes.width <= 0 || planes.height <= 0 ||
+        planes.uvPixelStride != 2) {
+        return false;
+    }
+    cv::Mat yMat(planes.height, planes.width, CV_8UC1,
+                 const_cast<uint8_t*>(planes.y), planes.yRowStride);
+    bool vuOrder = planes.v < planes.u;
+    const uint8_t* uvStart = vuOrder ? planes.v : planes.u;
+    cv::Mat uvMat(planes.height / 2, planes.width / 2, CV_8UC2,
+                  const_cast<uint8_t*>(uvStart), planes.uvRowStride);
+    cv::cvtColorTwoPlane(yMat, uvMat, rgba,
+                         vuOrder ? cv::COLOR_YUV2RGBA_NV21 : cv::COLOR_YUV2RGBA_NV12);
+    return true;
+}
+
+void packYuvPlanesToNv21(const YuvPlanes& planes, cv::Mat& nv21) {
+    const int width = planes.width;
+    const int height = planes.height;
+    for (int y = 0; y < height; y++) {
+        memcpy(nv21.ptr<uint8_t>(y), planes.y + y * planes.yRowStride, width);
+    }
+
+    bool alreadyVu = planes.uvPixelStride == 2 && planes.v + 1 == planes.u;
+    for (int cy = 0; cy < height / 2; cy++) {
+        uint8_t* dst = nv21.ptr<uint8_t>(height + cy);
+        if (alreadyVu) {
+            // NV21 in memory: one row copy (the final U byte sits in the U plane)
+            memcpy(dst, planes.v + cy * planes.uvRowStride, width);
+            continue;
+        }
+        const uint8_t* uRow = planes.u + cy * planes.uvRowStride;
+        const uint8_t* vRow = planes.v + cy * planes.uvRowStride;
+        for (int cx = 0; cx < width / 2; cx++) {
+            dst[2 * cx] = vRow[cx * planes.uvPixelStride];
+            dst[2 * cx + 1] = uRow[cx * planes.uvPixelStride];
+        }
+    }
+}
+
+bool unpackP010Planes(const P010Planes& planes, cv::Mat& luma, cv::Mat* luma10, cv::Mat& vu) {
+    if (!planes.y || !planes.uv || planes.width <= 0 || planes.height <= 0 || (planes.width | planes.height) & 1) {
+        return false;
+    }
+    const cv::Size size(planes.width, planes.height);
+    if (luma.type() != CV_8UC1 || luma.size() != size || vu.type() != CV_8UC2 || vu.size() != size / 2 ||
+        (luma10 && (luma10->type() != CV_16SC1 || luma10->size() != size))) {
+        return false;
+    }
+    const EdgeKernels& kernels = edgeKernels();
+    const uint8_t* yBase = reinterpret_cast<const uint8_t*>(planes.y);
+    const uint8_t* uvBase = reinterpret_cast<const uint8_t*>(planes.uv);
+    // Each range covers chroma rows, i.e. pairs of luma rows
+    cv::parallel_for_(cv::Range(0, planes.height / 2), [&](const cv::Range& range) {
+        for (int cy = range.start; cy < range.end; cy++) {
+            for (int y = 2 * cy; y < 2 * cy + 2; y++) {
+                kernels.p010LumaRow(reinterpret_cast<const uint16_t*>(yBase + y * planes.yRowStride), planes.width,
+                                    luma.ptr<uint8_t>(y), luma10 ? luma10->ptr<int16_t>(y) : nullptr);
+            }
+            kernels.p010ChromaRow(reinterpret_cast<const uint16_t*>(uvBase + cy * planes.uvRowStride),
+                                  planes.width / 2, vu.ptr<uint8_t>(cy));
+        }
+    });
+    return true;
+}
+
+bool packP010PlanesToNv21(const P010Planes& planes, cv::Mat& nv21) {
+    if (nv21.type() != CV_8UC1 || nv21.rows < planes.height + planes.height / 2 || nv21.cols != planes.width) {
+        return false;
+    }
+    cv::Mat luma = nv21.rowRange(0, planes.height);  // the VU rows follow
+    cv::Mat vu(planes.height / 2, planes.width / 2, CV_8UC2, nv21.ptr<uint8_t>(planes.height), nv21.step);
+    return unpackP010Planes(planes, luma, nullptr, vu);
+}
+
+cv::Size binnedSize(const RawPlanes& planes) {
+    return cv::Size((planes.width / 2) & ~1, (planes.height / 2) & ~1);
+}
+
+bool binRawPlanesToNv21(const RawPlanes& planes, cv::Mat& nv21) {
+    const cv::Size size = binnedSize(planes);
+    if (!planes.data || size.width <= 0 || size.height <= 0 ||
+        (planes.format == RawPlanes::RAW10 && planes.width % 4 != 0) || nv21.type() != CV_8UC1 ||
+        nv21.rows < size.height + size.height / 2 || nv21.cols != size.width) {
+        return false;
+    }
+    // The quad sum of samples up to whiteLevel has bits(whiteLevel) + 2 bits
+    int shift = 2;
+    for (int white = std::max(planes.whiteLevel, 1); white > 255; white >>= 1) {
+        shift++;
+    }
+    const EdgeKernels& kernels = edgeKernels();
+    cv::parallel_for_(cv::Range(0, size.height), [&](const cv::Range& range) {
+        for (int y = range.start; y < range.end; y++) {
+            const uint8_t* r0 = planes.data + static_cast<size_t>(2 * y) * planes.rowStride;
+            const uint8_t* r1 = r0 + planes.rowStride;
+            if (planes.format == RawPlanes::RAW10) {
+                kernels.bayerBinRowRaw10(r0, r1, size.width, nv21.ptr<uint8_t>(y));
+            } else {
+                kernels.bayerBinRow16(reinterpret_cast<const uint16_t*>(r0), reinterpret_cast<const uint16_t*>(r1),
+                                      size.width, shift, nv21.ptr<uint8_t>(y));
+            }
+        }
+    });
+    nv21.rowRange(size.height, size.height + size.height / 2).setTo(128);
+    return true;
+}
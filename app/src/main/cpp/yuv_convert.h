@@ -0,0 +1,50 @@
+#ifndef EDGE_YUV_CONVERT_H
+#define EDGE_YUV_CONVERT_H
+
+#include <opencv2/core.hpp>
+#include "frame_ingest.h"
+
+// Converts a stride-aware YUV_420_888 frame to BGR without repacking it first.
+// Semi-planar layouts (NV21/NV12, pixel stride 2) go through cv::cvtColorTwoPlane;
+// fully planar I420/YV12 (pixel stride 1) use a row-parallel fixed-point kernel.
+// Returns false for layouts it cannot interpret.
+bool convertYuvPlanesToBgr(const YuvPlanes& planes, cv::Mat& bgr);
+
+// Display conversion: semi-planar frames straight to RGBA, the format the
+// renderer uploads, so the GL thread has no BGR to convert. False for layouts
+// without a one-pass RGBA path (planar I420/YV12); those go through
+// convertYuvPlanesToBgr instead.
+bool convertYuvPlanesToRgba(const YuvPlanes& planes, cv::Mat& rgba);
+
+// NV21 (Y plane plus interleaved VU at half resolution) straight to an
+// upright BGR image, rotated clockwise by 0, 90, 180 or 270 degrees, in one
+// pass: 64x64 tiles are converted row by row into a tile buffer that stays in
+// L1 and written to their rotated place from there, so no full-frame
+// unrotated BGR copy is made. Same pixels as cvtColorTwoPlane followed by
+// cv::rotate. Returns false for other rotations or mismatched planes.
+bool convertNv21ToBgrRotated(const cv::Mat& luma, const cv::Mat& chroma, int rotation, cv::Mat& bgr);
+
+// Packs the planes into a tight NV21 buffer ((height + height/2) x width, CV_8UC1,
+// already allocated by the caller). Used when a frame must outlive the producer's
+// buffers, e.g. when it is queued for the processing worker.
+void packYuvPlanesToNv21(const YuvPlanes& planes, cv::Mat& nv21);
+
+// Unpacks a P010 frame into the pipeline's planes, rows in parallel: its
+// 8-bit Y plane into luma (CV_8UC1), its 10-bit samples into luma10 (CV_16SC1,
+// 0..1023) unless that is null, and its 8-bit VU plane into vu (CV_8UC2, half
+// size). All are allocated by the caller. False for planes it cannot read.
+bool unpackP010Planes(const P010Planes& planes, cv::Mat& luma, cv::Mat* luma10, cv::Mat& vu);
+
+// unpackP010Planes into a tight NV21 buffer, as packYuvPlanesToNv21 lays it out
+bool packP010PlanesToNv21(const P010Planes& planes, cv::Mat& nv21);
+
+// Bins a Bayer frame's 2x2 quads into the Y plane of a tight NV21 buffer of
+// binnedSize(planes), rows in parallel, its VU plane set to neutral. RAW16
+// sums are scaled so four samples at whiteLevel come out as 255. False for
+// planes it cannot read.
+bool binRawPlanesToNv21(const RawPlanes& planes, cv::Mat& nv21);
+
+// Size of the binned frame: half the mosaic's, rounded down to even
+cv::Size binnedSize(const RawPlanes& planes);
+
+#endif // EDGE_YUV_CONVERT_H